@@ -1,6 +1,8 @@
 // Copyright © 2023 Apple Inc.
 
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include "mlx/mlx.h"
 #include "time_utils.h"
 
@@ -22,6 +24,131 @@ void time_add_op() {
   }
 }
 
+// The measured peaks of a device, in bytes and floating point operations
+// per second
+struct Roofline {
+  double copy_bw;
+  double read_bw;
+  double write_bw;
+  std::vector<std::pair<Dtype, double>> flops;
+
+  double peak_flops(Dtype t) const {
+    for (auto& [dtype, f] : flops) {
+      if (dtype == t) {
+        return f;
+      }
+    }
+    return flops[0].second;
+  }
+
+  // The best achievable time in seconds of a kernel which moves bytes and
+  // does flops
+  double bound(double bytes, double f, Dtype t) const {
+    return std::max(bytes / copy_bw, f / peak_flops(t));
+  }
+};
+
+double seconds(TimeStats stats) {
+  return stats.median * 1e-3;
+}
+
+Roofline measure_roofline(Device d) {
+  Roofline r;
+  // Large enough to stream from memory rather than the caches
+  int n = 1 << 26;
+  double nbytes = n * 4.0;
+  auto a = random::uniform({n});
+  eval(a);
+  r.copy_bw = 2 * nbytes / seconds(time_stats([&]() { return copy(a, d); }));
+  r.read_bw = nbytes / seconds(time_stats([&]() { return sum(a, d); }));
+  r.write_bw =
+      nbytes / seconds(time_stats([&]() { return full({n}, 1.0f, d); }));
+
+  int m = d == Device::cpu ? 1024 : 4096;
+  for (auto t : {float32, float16, bfloat16}) {
+    auto x = astype(random::uniform({m, m}), t);
+    auto y = astype(random::uniform({m, m}), t);
+    eval(x, y);
+    double flops = 2.0 * m * m * m;
+    auto secs = seconds(time_stats([&]() { return matmul(x, y, d); }, 2, 10));
+    r.flops.emplace_back(t, flops / secs);
+  }
+  return r;
+}
+
+// Time common primitives and report how close they get to the roofline
+void time_roofline(Device d) {
+  set_default_device(d);
+  auto r = measure_roofline(d);
+  std::cout << std::fixed << std::setprecision(1) << "Peaks for " << d
+            << ": copy " << r.copy_bw * 1e-9 << " GB/s, read "
+            << r.read_bw * 1e-9 << " GB/s, write " << r.write_bw * 1e-9
+            << " GB/s";
+  for (auto& [t, f] : r.flops) {
+    std::cout << ", " << t << " " << f * 1e-9 << " GFLOP/s";
+  }
+  std::cout << std::endl;
+
+  auto report = [&](const std::string& name,
+                    Dtype t,
+                    double bytes,
+                    double flops,
+                    auto fn) {
+    auto secs = seconds(time_stats(fn, 2, 20));
+    std::cout << "  " << std::left << std::setw(28) << name << std::right
+              << std::setprecision(4) << std::setw(10) << secs * 1e3
+              << " msec " << std::setprecision(1) << std::setw(8)
+              << bytes / secs * 1e-9 << " GB/s " << std::setw(6)
+              << 100 * r.bound(bytes, flops, t) / secs << "% of roofline"
+              << std::endl;
+  };
+
+  int n = 1 << 24;
+  for (auto t : {float32, float16}) {
+    auto a = astype(random::uniform({n}), t);
+    auto b = astype(random::uniform({n}), t);
+    eval(a, b);
+    double bytes = n * size_of(t);
+    std::ostringstream dtype;
+    dtype << t;
+    report("add " + dtype.str(), t, 3 * bytes, n, [&]() { return a + b; });
+    report("add scalar " + dtype.str(), t, 2 * bytes, n, [&]() {
+      return a + 2.0;
+    });
+    report("exp " + dtype.str(), t, 2 * bytes, n, [&]() { return exp(a); });
+    auto cond = a < b;
+    eval(cond);
+    report("where " + dtype.str(), t, 3 * bytes + n, 0, [&]() {
+      return where(cond, a, b);
+    });
+    report("sum " + dtype.str(), t, bytes, n, [&]() { return sum(a); });
+    auto x = reshape(a, {4096, n / 4096});
+    report("softmax " + dtype.str(), t, 2 * bytes, 4.0 * n, [&]() {
+      return softmax(x, -1);
+    });
+  }
+
+  for (auto t : {float32, float16}) {
+    for (auto [M, N, K] : std::vector<std::tuple<int, int, int>>{
+             {1, 4096, 4096}, {32, 4096, 4096}, {1024, 1024, 1024}}) {
+      auto x = astype(random::uniform({M, K}), t);
+      auto w = astype(random::uniform({K, N}), t);
+      eval(x, w);
+      std::ostringstream name;
+      name << "matmul " << M << "x" << N << "x" << K << " " << t;
+      double bytes = (double(M) * K + double(K) * N + double(M) * N) *
+          size_of(t);
+      report(name.str(), t, bytes, 2.0 * M * N * K, [&]() {
+        return matmul(x, w);
+      });
+    }
+  }
+}
+
 int main() {
   time_add_op();
+  time_roofline(Device::cpu);
+  if (metal::is_available()) {
+    time_roofline(Device::gpu);
+  }
 }
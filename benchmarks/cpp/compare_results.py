@@ -0,0 +1,65 @@
+# Copyright © 2024 Apple Inc.
+
+"""Compare two JSON results of the benchmark suite.
+
+Prints the change of the median time of every benchmark found in both files
+and exits with a non-zero status if any of them got slower than the
+threshold.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    results = {}
+    for r in data["results"]:
+        key = (r["device"], r["family"], r["name"], r["dtype"])
+        results[key] = r
+    return data.get("version", "?"), results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline", help="The results to compare against.")
+    parser.add_argument("current", help="The new results.")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.1,
+        help="The relative slowdown of the median reported as a regression.",
+    )
+    args = parser.parse_args()
+
+    base_version, base = load(args.baseline)
+    version, current = load(args.current)
+    print(f"Comparing {version} against {base_version}")
+
+    regressions = 0
+    for key in sorted(base.keys() & current.keys()):
+        before = base[key]["median_ms"]
+        after = current[key]["median_ms"]
+        change = (after - before) / before if before > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = " REGRESSION"
+            regressions += 1
+        device, family, name, dtype = key
+        print(
+            f"{device:4} {family:10} {name:36} {dtype:10} "
+            f"{before:10.4f} -> {after:10.4f} ms ({change:+.1%}){flag}"
+        )
+
+    for key in sorted(base.keys() - current.keys()):
+        print(f"Missing from {args.current}: {' '.join(key)}")
+
+    if regressions > 0:
+        print(f"{regressions} regression(s) past {args.threshold:.0%}")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,53 @@
+// Copyright © 2024 Apple Inc.
+
+#include <iostream>
+
+#include "mlx/mlx.h"
+#include "time_utils.h"
+
+using namespace mlx::core;
+
+// Build a chain of n unary ops on x
+array build_chain(const array& x, int n) {
+  auto y = x;
+  for (int i = 0; i < n; ++i) {
+    y = abs(y);
+  }
+  return y;
+}
+
+void time_graph_construction_and_destruction() {
+  auto x = array({1.0f});
+  eval(x);
+  for (int n : {1000, 10000, 100000}) {
+    int num_iters = 10;
+    double build = 0;
+    double destroy = 0;
+    for (int i = 0; i < num_iters; ++i) {
+      auto start = time_now();
+      auto y = std::make_unique<array>(build_chain(x, n));
+      auto mid = time_now();
+      y.reset();
+      auto end = time_now();
+      build += milliseconds(mid - start);
+      destroy += milliseconds(end - mid);
+    }
+    double per_node = 1e6 / (static_cast<double>(num_iters) * n);
+    std::cout << "Chain of " << n << " ops: build " << build * per_node
+              << " nsec/node, destroy " << destroy * per_node << " nsec/node"
+              << std::endl;
+  }
+}
+
+void time_graph_eval() {
+  auto x = array({1.0f});
+  eval(x);
+  auto chain = [&x]() { return build_chain(x, 1000); };
+  TIME(chain);
+}
+
+int main() {
+  std::cout << "Benchmarks for " << default_device() << std::endl;
+  time_graph_construction_and_destruction();
+  time_graph_eval();
+}
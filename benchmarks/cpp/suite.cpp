@@ -0,0 +1,491 @@
+// Copyright © 2024 Apple Inc.
+
+// Times the primitive families on each device and dtype and reports the
+// median and p99 time with the achieved bandwidth or FLOP rate. The results
+// can be saved as JSON and compared between versions with
+// compare_results.py:
+//
+//   suite --device gpu --json before.json
+//   suite --device gpu --json after.json
+//   python compare_results.py before.json after.json
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include "mlx/mlx.h"
+#include "time_utils.h"
+
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
+using namespace mlx::core;
+
+namespace {
+
+struct Benchmark {
+  std::string family;
+  std::string name;
+  Dtype dtype;
+  // Builds the graph to time from inputs made once by setup
+  std::function<std::function<array()>()> setup;
+  // The bytes moved and floating point operations of one evaluation, used
+  // to report the rates
+  double bytes;
+  double flops;
+};
+
+struct Result {
+  std::string family;
+  std::string name;
+  std::string dtype;
+  std::string device;
+  TimeStats stats;
+  double gbps;
+  double gflops;
+};
+
+std::string dtype_name(Dtype t) {
+  std::ostringstream os;
+  os << t;
+  return os.str();
+}
+
+std::string shape_name(const std::vector<int>& shape) {
+  std::ostringstream os;
+  for (int i = 0; i < shape.size(); i++) {
+    os << (i > 0 ? "x" : "") << shape[i];
+  }
+  return os.str();
+}
+
+double numel(const std::vector<int>& shape) {
+  double n = 1;
+  for (auto s : shape) {
+    n *= s;
+  }
+  return n;
+}
+
+std::vector<Benchmark> make_benchmarks() {
+  std::vector<Benchmark> bms;
+  std::vector<Dtype> float_types = {float32, float16, bfloat16};
+  std::vector<std::vector<int>> shapes = {{1 << 10}, {1 << 20}, {1024, 4096}};
+
+  // Elementwise ops
+  for (auto t : float_types) {
+    for (auto& shape : shapes) {
+      auto name = shape_name(shape);
+      double n = numel(shape) * size_of(t);
+      auto unary = [&](std::string op, std::function<array(array)> f) {
+        bms.push_back(
+            {"unary",
+             op + "_" + name,
+             t,
+             [shape, t, f]() {
+               auto a = astype(random::normal(shape), t);
+               eval(a);
+               return [a, f]() { return f(a); };
+             },
+             2 * n,
+             0});
+      };
+      unary("exp", [](array a) { return exp(a); });
+      unary("abs", [](array a) { return abs(a); });
+      unary("sigmoid", [](array a) { return sigmoid(a); });
+      unary("astype", [](array a) { return astype(a, float32); });
+
+      auto binary = [&](std::string op,
+                        std::function<array(array, array)> f) {
+        bms.push_back(
+            {"binary",
+             op + "_" + name,
+             t,
+             [shape, t, f]() {
+               auto a = astype(random::normal(shape), t);
+               auto b = astype(random::normal(shape), t);
+               eval(a, b);
+               return [a, b, f]() { return f(a, b); };
+             },
+             3 * n,
+             numel(shape)});
+      };
+      binary("add", [](array a, array b) { return add(a, b); });
+      binary("multiply", [](array a, array b) { return multiply(a, b); });
+      binary("maximum", [](array a, array b) { return maximum(a, b); });
+    }
+  }
+
+  // Copies of transposed and broadcast inputs
+  for (auto t : float_types) {
+    std::vector<int> shape = {1024, 4096};
+    double n = numel(shape) * size_of(t);
+    bms.push_back(
+        {"copy",
+         "transpose_" + shape_name(shape),
+         t,
+         [shape, t]() {
+           auto a = astype(random::normal(shape), t);
+           eval(a);
+           return [a]() { return copy(transpose(a)); };
+         },
+         2 * n,
+         0});
+    bms.push_back(
+        {"copy",
+         "broadcast_" + shape_name(shape),
+         t,
+         [shape, t]() {
+           auto a = astype(random::normal({shape[1]}), t);
+           eval(a);
+           return [a, shape]() { return copy(broadcast_to(a, shape)); };
+         },
+         n,
+         0});
+  }
+
+  // Reductions along the contiguous and the strided axis
+  for (auto t : float_types) {
+    std::vector<int> shape = {4096, 4096};
+    double n = numel(shape) * size_of(t);
+    for (int axis : {1, 0}) {
+      bms.push_back(
+          {"reduce",
+           "sum_axis" + std::to_string(axis) + "_" + shape_name(shape),
+           t,
+           [shape, t, axis]() {
+             auto a = astype(random::normal(shape), t);
+             eval(a);
+             return [a, axis]() { return sum(a, axis); };
+           },
+           n,
+           numel(shape)});
+    }
+    bms.push_back(
+        {"reduce",
+         "softmax_" + shape_name(shape),
+         t,
+         [shape, t]() {
+           auto a = astype(random::normal(shape), t);
+           eval(a);
+           return [a]() { return softmax(a, -1); };
+         },
+         2 * n,
+         0});
+    bms.push_back(
+        {"scan",
+         "cumsum_" + shape_name(shape),
+         t,
+         [shape, t]() {
+           auto a = astype(random::normal(shape), t);
+           eval(a);
+           return [a]() { return cumsum(a, -1); };
+         },
+         2 * n,
+         numel(shape)});
+  }
+
+  // Matrix multiplication, including the matrix-vector products of decoding
+  for (auto t : float_types) {
+    for (auto [M, N, K] : std::vector<std::tuple<int, int, int>>{
+             {1, 4096, 4096}, {512, 512, 512}, {2048, 2048, 2048}}) {
+      bms.push_back(
+          {"matmul",
+           std::to_string(M) + "x" + std::to_string(N) + "x" +
+               std::to_string(K),
+           t,
+           [M = M, N = N, K = K, t]() {
+             auto a = astype(random::normal({M, K}), t);
+             auto b = astype(random::normal({K, N}), t);
+             eval(a, b);
+             return [a, b]() { return matmul(a, b); };
+           },
+           (double(M) * K + double(K) * N + double(M) * N) * size_of(t),
+           2.0 * M * N * K});
+    }
+  }
+
+  // Quantized matrix multiplication
+  for (auto t : {float16, bfloat16}) {
+    for (int M : {1, 512}) {
+      int N = 4096;
+      int K = 4096;
+      bms.push_back(
+          {"quantized",
+           "qmm_4bit_" + std::to_string(M) + "x" + std::to_string(N) + "x" +
+               std::to_string(K),
+           t,
+           [M, N, K, t]() {
+             auto x = astype(random::normal({M, K}), t);
+             auto w = astype(random::normal({N, K}), t);
+             auto [wq, scales, biases] = quantize(w);
+             eval(x, wq, scales, biases);
+             return [x, wq = wq, scales = scales, biases = biases]() {
+               return quantized_matmul(x, wq, scales, biases);
+             };
+           },
+           double(N) * K / 2 + (double(M) * K + double(M) * N) * size_of(t),
+           2.0 * M * N * K});
+    }
+  }
+
+  // Convolutions
+  for (auto t : float_types) {
+    int N = 4;
+    int H = 64;
+    int C = 128;
+    int O = 128;
+    bms.push_back(
+        {"conv",
+         "conv2d_3x3_" + shape_name({N, H, H, C}),
+         t,
+         [=]() {
+           auto x = astype(random::normal({N, H, H, C}), t);
+           auto w = astype(random::normal({O, 3, 3, C}), t);
+           eval(x, w);
+           return [x, w]() { return conv2d(x, w, {1, 1}, {1, 1}); };
+         },
+         (2.0 * N * H * H * C + 9.0 * O * C) * size_of(t),
+         2.0 * N * H * H * O * 9 * C});
+  }
+
+  // Indexing
+  for (auto t : float_types) {
+    int V = 32000;
+    int D = 4096;
+    int I = 512;
+    bms.push_back(
+        {"indexing",
+         "take_" + std::to_string(I) + "_of_" + shape_name({V, D}),
+         t,
+         [=]() {
+           auto table = astype(random::normal({V, D}), t);
+           auto idx = random::randint(0, V, {I}, uint32);
+           eval(table, idx);
+           return [table, idx]() { return take(table, idx, 0); };
+         },
+         2.0 * I * D * size_of(t),
+         0});
+    bms.push_back(
+        {"indexing",
+         "scatter_add_" + std::to_string(I) + "_into_" + shape_name({V, D}),
+         t,
+         [=]() {
+           auto table = astype(zeros({V, D}), t);
+           auto idx = random::randint(0, V, {I}, uint32);
+           auto updates = astype(random::normal({I, 1, D}), t);
+           eval(table, idx, updates);
+           return [table, idx, updates]() {
+             return scatter_add(table, idx, updates, 0);
+           };
+         },
+         3.0 * I * D * size_of(t),
+         double(I) * D});
+  }
+
+  // Sorting and selection
+  for (auto t : {float32, int32}) {
+    std::vector<int> shape = {512, 4096};
+    double n = numel(shape) * size_of(t);
+    bms.push_back(
+        {"sort",
+         "sort_" + shape_name(shape),
+         t,
+         [shape, t]() {
+           auto a = astype(random::normal(shape) * 1000, t);
+           eval(a);
+           return [a]() { return sort(a, -1); };
+         },
+         2 * n,
+         0});
+    bms.push_back(
+        {"sort",
+         "argpartition_" + shape_name(shape),
+         t,
+         [shape, t]() {
+           auto a = astype(random::normal(shape) * 1000, t);
+           eval(a);
+           return [a]() { return argpartition(a, 32, -1); };
+         },
+         2 * n,
+         0});
+  }
+
+  // FFT
+  for (int n : {1024, 4096}) {
+    std::vector<int> shape = {256, n};
+    bms.push_back(
+        {"fft",
+         "fft_" + shape_name(shape),
+         complex64,
+         [shape]() {
+           auto a = astype(random::normal(shape), complex64);
+           eval(a);
+           return [a]() { return fft::fft(a); };
+         },
+         2 * numel(shape) * size_of(complex64),
+         5 * numel(shape) * std::log2(shape[1])});
+  }
+
+  // Fused transformer ops
+  for (auto t : float_types) {
+    std::vector<int> shape = {32, 4096};
+    double n = numel(shape) * size_of(t);
+    bms.push_back(
+        {"fast",
+         "rms_norm_" + shape_name(shape),
+         t,
+         [shape, t]() {
+           auto x = astype(random::normal(shape), t);
+           auto w = astype(random::normal({shape[1]}), t);
+           eval(x, w);
+           return [x, w]() { return fast::rms_norm(x, w, 1e-5); };
+         },
+         2 * n,
+         0});
+    std::vector<int> rope_shape = {1, 32, 256, 128};
+    bms.push_back(
+        {"fast",
+         "rope_" + shape_name(rope_shape),
+         t,
+         [rope_shape, t]() {
+           auto x = astype(random::normal(rope_shape), t);
+           eval(x);
+           return [x]() { return fast::rope(x, 128, false, 10000, 1.0, 0); };
+         },
+         2 * numel(rope_shape) * size_of(t),
+         0});
+    for (int L : {1, 512}) {
+      int S = 2048;
+      bms.push_back(
+          {"fast",
+           "sdpa_q" + std::to_string(L) + "_k" + std::to_string(S),
+           t,
+           [L, S, t]() {
+             auto q = astype(random::normal({1, 32, L, 128}), t);
+             auto k = astype(random::normal({1, 32, S, 128}), t);
+             auto v = astype(random::normal({1, 32, S, 128}), t);
+             eval(q, k, v);
+             return [q, k, v]() {
+               return fast::scaled_dot_product_attention(q, k, v, 0.088f);
+             };
+           },
+           (2.0 * L + 2.0 * S) * 32 * 128 * size_of(t),
+           4.0 * 32 * L * S * 128});
+    }
+  }
+
+  return bms;
+}
+
+void write_json(const std::string& path, const std::vector<Result>& results) {
+  std::ofstream os(path);
+  if (!os) {
+    throw std::runtime_error("Cannot open " + path + " for writing.");
+  }
+  os << "{\"version\": \"" << TOSTRING(_VERSION_) << "\", \"results\": [";
+  for (int i = 0; i < results.size(); i++) {
+    auto& r = results[i];
+    os << (i > 0 ? ",\n" : "\n") << "{\"family\": \"" << r.family
+       << "\", \"name\": \"" << r.name << "\", \"dtype\": \"" << r.dtype
+       << "\", \"device\": \"" << r.device
+       << "\", \"median_ms\": " << r.stats.median
+       << ", \"p99_ms\": " << r.stats.p99 << ", \"min_ms\": " << r.stats.min
+       << ", \"mean_ms\": " << r.stats.mean
+       << ", \"iters\": " << r.stats.iters << ", \"gbps\": " << r.gbps
+       << ", \"gflops\": " << r.gflops << "}";
+  }
+  os << "\n]}\n";
+}
+
+void usage() {
+  std::cout
+      << "Usage: suite [--device cpu|gpu|all] [--filter text] [--json path]\n"
+      << "             [--warmup n] [--iters n]\n"
+      << "Runs the benchmarks whose family or name contains the filter.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<Device> devices = {default_device()};
+  std::string filter;
+  std::string json;
+  int warmup = 5;
+  int iters = 50;
+  for (int i = 1; i < argc; i++) {
+    auto arg = std::string(argv[i]);
+    if (arg == "--help" || i + 1 == argc) {
+      usage();
+      return arg == "--help" ? 0 : 1;
+    }
+    std::string value = argv[++i];
+    if (arg == "--device") {
+      if (value == "all") {
+        devices = {Device::cpu};
+        if (metal::is_available()) {
+          devices.push_back(Device::gpu);
+        }
+      } else {
+        devices = {value == "gpu" ? Device::gpu : Device::cpu};
+      }
+    } else if (arg == "--filter") {
+      filter = value;
+    } else if (arg == "--json") {
+      json = value;
+    } else if (arg == "--warmup") {
+      warmup = std::stoi(value);
+    } else if (arg == "--iters") {
+      iters = std::stoi(value);
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  std::vector<Result> results;
+  std::cout << std::left << std::setw(12) << "family" << std::setw(36)
+            << "name" << std::setw(10) << "dtype" << std::setw(6) << "dev"
+            << std::right << std::setw(12) << "median ms" << std::setw(12)
+            << "p99 ms" << std::setw(10) << "GB/s" << std::setw(10)
+            << "GFLOP/s" << std::endl;
+  for (auto& device : devices) {
+    set_default_device(device);
+    std::string dev = device == Device::cpu ? "cpu" : "gpu";
+    for (auto& bm : make_benchmarks()) {
+      if (!filter.empty() && bm.family.find(filter) == std::string::npos &&
+          bm.name.find(filter) == std::string::npos) {
+        continue;
+      }
+      // Skip the benchmarks a device doesn't support
+      TimeStats stats;
+      try {
+        stats = time_stats(bm.setup(), warmup, iters);
+      } catch (const std::exception&) {
+        continue;
+      }
+      double seconds = stats.median * 1e-3;
+      Result r{
+          bm.family,
+          bm.name,
+          dtype_name(bm.dtype),
+          dev,
+          stats,
+          bm.bytes / seconds * 1e-9,
+          bm.flops / seconds * 1e-9};
+      std::cout << std::left << std::setw(12) << r.family << std::setw(36)
+                << r.name << std::setw(10) << r.dtype << std::setw(6) << dev
+                << std::right << std::fixed << std::setprecision(4)
+                << std::setw(12) << stats.median << std::setw(12) << stats.p99
+                << std::setprecision(1) << std::setw(10) << r.gbps
+                << std::setw(10) << r.gflops << std::endl;
+      results.push_back(std::move(r));
+    }
+  }
+
+  if (!json.empty()) {
+    write_json(json, results);
+  }
+  return 0;
+}
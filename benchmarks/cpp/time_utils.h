@@ -2,9 +2,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <vector>
 
 #include "mlx/mlx.h"
 
@@ -37,3 +39,33 @@ double time_fn(F fn, Args&&... args) {
   auto end = time_now();
   return milliseconds(end - start) / static_cast<double>(num_iters);
 }
+
+struct TimeStats {
+  double median;
+  double p99;
+  double min;
+  double mean;
+  int iters;
+};
+
+// Times each evaluation of fn separately, all in milliseconds
+template <typename F>
+TimeStats time_stats(F fn, int warmup = 5, int num_iters = 100) {
+  for (int i = 0; i < warmup; ++i) {
+    eval(fn());
+  }
+
+  std::vector<double> times(num_iters);
+  double total = 0;
+  for (int i = 0; i < num_iters; i++) {
+    auto start = time_now();
+    eval(fn());
+    auto end = time_now();
+    times[i] = milliseconds(end - start);
+    total += times[i];
+  }
+  std::sort(times.begin(), times.end());
+  int p99 = std::min(num_iters - 1, (99 * num_iters + 99) / 100 - 1);
+  return {
+      times[num_iters / 2], times[p99], times[0], total / num_iters, num_iters};
+}
@@ -0,0 +1,250 @@
+// Copyright © 2024 Apple Inc.
+
+// Prefill throughput and decode latency of a Llama style decoder built from
+// the fast ops and quantized_matmul with random weights. Each configuration
+// reports the prompt tokens per second, the time per generated token and the
+// peak memory.
+//
+//   transformer [--layers n] [--tokens n] [--device cpu|gpu]
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "mlx/mlx.h"
+#include "time_utils.h"
+
+using namespace mlx::core;
+
+namespace {
+
+struct Config {
+  int vocab = 32000;
+  int dims = 2048;
+  int hidden = 5632;
+  int layers = 8;
+  int heads = 32;
+  int kv_heads = 8;
+  int head_dim = 64;
+  float rope_base = 10000;
+  // 0 keeps the weights in float16
+  int bits = 0;
+  int group_size = 64;
+};
+
+struct Linear {
+  array w;
+  std::optional<array> scales;
+  std::optional<array> biases;
+  int bits;
+  int group_size;
+
+  Linear(int in, int out, const Config& c)
+      : w(astype(random::normal({out, in}) * (1.0 / std::sqrt(in)), float16)),
+        bits(c.bits),
+        group_size(c.group_size) {
+    if (bits > 0) {
+      auto [wq, s, b] = quantize(w, group_size, bits);
+      w = wq;
+      scales = s;
+      biases = b;
+    }
+  }
+
+  array operator()(const array& x) const {
+    if (bits > 0) {
+      return quantized_matmul(x, w, *scales, *biases, true, group_size, bits);
+    }
+    return matmul(x, transpose(w));
+  }
+
+  std::vector<array> arrays() const {
+    if (bits > 0) {
+      return {w, *scales, *biases};
+    }
+    return {w};
+  }
+};
+
+struct Layer {
+  array attn_norm;
+  array mlp_norm;
+  Linear wq, wk, wv, wo, gate, up, down;
+
+  explicit Layer(const Config& c)
+      : attn_norm(ones({c.dims}, float16)),
+        mlp_norm(ones({c.dims}, float16)),
+        wq(c.dims, c.heads * c.head_dim, c),
+        wk(c.dims, c.kv_heads * c.head_dim, c),
+        wv(c.dims, c.kv_heads * c.head_dim, c),
+        wo(c.heads * c.head_dim, c.dims, c),
+        gate(c.dims, c.hidden, c),
+        up(c.dims, c.hidden, c),
+        down(c.hidden, c.dims, c) {}
+};
+
+// Keys and values of every layer preallocated for max_tokens
+struct Cache {
+  std::vector<array> keys;
+  std::vector<array> values;
+  int offset = 0;
+
+  Cache(const Config& c, int max_tokens) {
+    for (int i = 0; i < c.layers; i++) {
+      keys.push_back(zeros({1, c.kv_heads, max_tokens, c.head_dim}, float16));
+      values.push_back(
+          zeros({1, c.kv_heads, max_tokens, c.head_dim}, float16));
+    }
+  }
+};
+
+class Model {
+ public:
+  explicit Model(const Config& c)
+      : c_(c),
+        embed_(astype(random::normal({c.vocab, c.dims}) * 0.02, float16)),
+        norm_(ones({c.dims}, float16)),
+        head_(c.dims, c.vocab, c) {
+    std::vector<array> weights = {embed_, norm_};
+    for (int i = 0; i < c.layers; i++) {
+      layers_.emplace_back(c);
+      auto& l = layers_.back();
+      weights.push_back(l.attn_norm);
+      weights.push_back(l.mlp_norm);
+      for (auto* lin : {&l.wq, &l.wk, &l.wv, &l.wo, &l.gate, &l.up, &l.down}) {
+        auto arrays = lin->arrays();
+        weights.insert(weights.end(), arrays.begin(), arrays.end());
+      }
+      // Keep the memory of the unquantized weights from piling up
+      eval(weights);
+    }
+    auto arrays = head_.arrays();
+    weights.insert(weights.end(), arrays.begin(), arrays.end());
+    eval(weights);
+  }
+
+  // Returns the logits of the last token and updates the cache
+  array operator()(const array& tokens, Cache& cache) const {
+    int L = tokens.shape(1);
+    int offset = cache.offset;
+    auto x = take(embed_, tokens, 0);
+    float scale = 1.0 / std::sqrt(c_.head_dim);
+    for (int i = 0; i < c_.layers; i++) {
+      auto& l = layers_[i];
+      auto h = fast::rms_norm(x, l.attn_norm, 1e-5);
+      auto heads = [&](const array& y, int n) {
+        return transpose(reshape(y, {1, L, n, c_.head_dim}), {0, 2, 1, 3});
+      };
+      auto q = heads(l.wq(h), c_.heads);
+      auto k = heads(l.wk(h), c_.kv_heads);
+      auto v = heads(l.wv(h), c_.kv_heads);
+      q = fast::rope(q, c_.head_dim, false, c_.rope_base, 1.0, offset);
+      k = fast::rope(k, c_.head_dim, false, c_.rope_base, 1.0, offset);
+
+      std::vector<int> start = {0, 0, offset, 0};
+      std::vector<int> stop = {1, c_.kv_heads, offset + L, c_.head_dim};
+      cache.keys[i] = slice_update(cache.keys[i], k, start, stop);
+      cache.values[i] = slice_update(cache.values[i], v, start, stop);
+      start[2] = 0;
+      auto keys = slice(cache.keys[i], start, stop);
+      auto values = slice(cache.values[i], start, stop);
+      auto o = L > 1
+          ? fast::scaled_dot_product_attention(q, keys, values, scale, "causal")
+          : fast::scaled_dot_product_attention(q, keys, values, scale);
+      o = reshape(transpose(o, {0, 2, 1, 3}), {1, L, c_.heads * c_.head_dim});
+      x = x + l.wo(o);
+
+      h = fast::rms_norm(x, l.mlp_norm, 1e-5);
+      auto g = l.gate(h);
+      x = x + l.down(g * sigmoid(g) * l.up(h));
+    }
+    cache.offset += L;
+    x = slice(x, {0, L - 1, 0}, {1, L, c_.dims});
+    return head_(fast::rms_norm(x, norm_, 1e-5));
+  }
+
+ private:
+  Config c_;
+  array embed_;
+  array norm_;
+  Linear head_;
+  std::vector<Layer> layers_;
+};
+
+void run(const Config& c, const std::vector<int>& contexts, int tokens) {
+  metal::clear_cache();
+  metal::reset_peak_memory();
+  Model model(c);
+  std::string weights = c.bits > 0 ? std::to_string(c.bits) + "-bit" : "fp16";
+
+  for (int context : contexts) {
+    auto prompt = random::randint(0, c.vocab, {1, context}, uint32);
+    eval(prompt);
+
+    // Warm up the kernels of both phases
+    {
+      Cache cache(c, context + tokens);
+      auto y = argmax(model(prompt, cache), -1);
+      eval(model(y, cache));
+    }
+
+    metal::reset_peak_memory();
+    Cache cache(c, context + tokens);
+    auto start = time_now();
+    auto y = argmax(model(prompt, cache), -1);
+    eval(y);
+    auto prefill = milliseconds(time_now() - start);
+
+    // The next token is built while the current one is computed
+    start = time_now();
+    auto next = argmax(model(y, cache), -1);
+    async_eval({next});
+    for (int i = 1; i < tokens; i++) {
+      y = next;
+      next = argmax(model(y, cache), -1);
+      async_eval({next});
+      eval(y);
+    }
+    eval(next);
+    auto decode = milliseconds(time_now() - start) / tokens;
+
+    std::cout << std::left << std::setw(8) << weights << std::right
+              << std::setw(9) << context << std::fixed << std::setprecision(1)
+              << std::setw(18) << context / (prefill * 1e-3)
+              << std::setprecision(2) << std::setw(16) << decode
+              << std::setw(14) << 1e3 / decode << std::setprecision(1)
+              << std::setw(14) << metal::get_peak_memory() / 1e6 << std::endl;
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Config c;
+  int tokens = 64;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    std::string value = argv[i + 1];
+    if (arg == "--layers") {
+      c.layers = std::stoi(value);
+    } else if (arg == "--tokens") {
+      tokens = std::stoi(value);
+    } else if (arg == "--device") {
+      set_default_device(value == "gpu" ? Device::gpu : Device::cpu);
+    }
+  }
+
+  std::cout << "Benchmarks for " << default_device() << " with " << c.layers
+            << " layers of " << c.dims << " dims" << std::endl;
+  std::cout << std::left << std::setw(8) << "weights" << std::right
+            << std::setw(9) << "context" << std::setw(18) << "prefill tok/s"
+            << std::setw(16) << "decode ms/tok" << std::setw(14)
+            << "decode tok/s" << std::setw(14) << "peak MB" << std::endl;
+  std::vector<int> contexts = {128, 512, 2048};
+  for (int bits : {0, 8, 4}) {
+    c.bits = bits;
+    run(c, contexts, tokens);
+  }
+}
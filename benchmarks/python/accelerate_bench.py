@@ -0,0 +1,82 @@
+# Copyright © 2024 Apple Inc.
+
+"""
+Times the CPU ops that have Accelerate fast paths.
+
+To compare against the default CPU backend, save the timings from a build
+that uses ``backend/common`` (e.g. a Linux or non-Accelerate build) and pass
+them to a run on the Accelerate build:
+
+    python accelerate_bench.py --save common.json    # default backend build
+    python accelerate_bench.py --compare common.json # Accelerate build
+"""
+
+import argparse
+import json
+
+import mlx.core as mx
+from time_utils import measure_runtime
+
+N = 1 << 20
+
+
+def unary_cases():
+    ops = {
+        "exp": mx.exp,
+        "log": mx.log,
+        "sin": mx.sin,
+        "tanh": mx.tanh,
+        "sqrt": mx.sqrt,
+        "rsqrt": mx.rsqrt,
+    }
+    for dtype in [mx.float32, mx.float16, mx.bfloat16]:
+        x = mx.random.uniform(0.1, 2.0, (N,)).astype(dtype)
+        for name, op in ops.items():
+            yield f"{name} {dtype}", op, x
+
+
+def strided_cases():
+    x = mx.random.normal((2 * N,))[::2]
+    ops = {"abs": mx.abs, "negative": mx.negative, "square": mx.square}
+    for name, op in ops.items():
+        yield f"{name} strided", op, x
+
+
+def scan_reduce_cases():
+    x = mx.random.normal((N // 1024, 1024))
+    yield "cumsum", lambda x: mx.cumsum(x, axis=-1), x
+    yield "cumsum reverse", lambda x: mx.cumsum(x, axis=-1, reverse=True), x
+    yield "argmax", lambda x: mx.argmax(x, axis=-1), x
+    yield "argmin", lambda x: mx.argmin(x, axis=-1), x
+
+
+def run(cases):
+    timings = {}
+    for name, op, x in cases:
+        mx.eval(x)
+        timings[name] = measure_runtime(lambda x: mx.eval(op(x)), x=x)
+    return timings
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser("Accelerate CPU op benchmarks.")
+    parser.add_argument("--save", help="Write the timings to this JSON file.")
+    parser.add_argument("--compare", help="JSON timings of a baseline run.")
+    args = parser.parse_args()
+
+    mx.set_default_device(mx.cpu)
+    timings = run([*unary_cases(), *strided_cases(), *scan_reduce_cases()])
+
+    baseline = {}
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+    for name, msec in timings.items():
+        line = f"{name:<24} {msec:8.3f} ms"
+        if name in baseline:
+            line += f"  {baseline[name] / msec:6.2f}x"
+        print(line)
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(timings, f, indent=2)
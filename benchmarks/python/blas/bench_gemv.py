@@ -195,6 +195,51 @@ def bench_with_out_len(ax, out_vec_len, in_vector_lens, dtype, transpose):
     ax.legend()
 
 
+def bench_decode(dtype):
+    """Bandwidth of x @ w.T and addmm(b, x, w.T) for a few rows of x, as in
+    decoding, counting the bytes of w, x, b and the output once."""
+    mx_dtype = getattr(mx, dtype)
+    print(f"{'op':>6} {'rows':>4} {'K':>6} {'N':>6} {'time (ms)':>10} {'GB/s':>8}")
+    for K, N in [(4096, 4096), (4096, 11008), (11008, 4096)]:
+        w = mx.random.normal((N, K)).astype(mx_dtype)
+        b = mx.random.normal((N,)).astype(mx_dtype)
+        for rows in (1, 2, 4, 8):
+            x = mx.random.normal((rows, K)).astype(mx_dtype)
+            mx.eval(w, b, x)
+            ops = {
+                "gemv": lambda: x @ w.T,
+                "addmm": lambda: mx.addmm(b, x, w.T),
+            }
+            for name, f in ops.items():
+                for _ in range(N_warmup):
+                    mx.eval([f() for _ in range(N_iter_func)])
+                s = time.perf_counter_ns()
+                for _ in range(N_iter_bench):
+                    mx.eval([f() for _ in range(N_iter_func)])
+                e = time.perf_counter_ns()
+                t = (e - s) * 1e-9 / (N_iter_bench * N_iter_func)
+                n_bytes = (N * K + rows * K + rows * N) * w.itemsize
+                if name == "addmm":
+                    n_bytes += N * w.itemsize
+                print(
+                    f"{name:>6} {rows:>4} {K:>6} {N:>6} {t * 1e3:>10.4f} "
+                    f"{n_bytes / t / 1e9:>8.1f}"
+                )
+
+
+parser = argparse.ArgumentParser(description="Benchmark the gemv kernels")
+parser.add_argument(
+    "--decode",
+    action="store_true",
+    help="Print the bandwidth of gemv and addmm with 1 to 8 rows instead of plots",
+)
+parser.add_argument("--dtype", default="bfloat16", help="Dtype with --decode")
+args = parser.parse_args()
+
+if args.decode:
+    bench_decode(args.dtype)
+    raise SystemExit
+
 for transpose in (False, True):
     for dtype in ("float32", "float16"):
         fig, axs = plt.subplots(
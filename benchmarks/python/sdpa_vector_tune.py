@@ -0,0 +1,73 @@
+# Copyright © 2024 Apple Inc.
+
+"""
+Sweeps the tile size of the decoding attention kernels to tune the target
+number of threadgroups of the device in
+mlx/backend/metal/scaled_dot_product_attention.cpp.
+
+For each number of heads and keys the fastest tile size is reported along
+with the threadgroups it launches. The smallest count at which the largest
+tiles stop losing to smaller ones is the target for the device class.
+"""
+
+import argparse
+import os
+import time
+
+import mlx.core as mx
+
+TILE_SIZES = [64, 128, 256, 512]
+
+
+def time_decoding(q, k, v, scale, iters):
+    for _ in range(5):
+        mx.eval(mx.fast.scaled_dot_product_attention(q, k, v, scale=scale))
+    tic = time.perf_counter()
+    for _ in range(iters):
+        mx.eval(mx.fast.scaled_dot_product_attention(q, k, v, scale=scale))
+    return 1e3 * (time.perf_counter() - tic) / iters
+
+
+def tune(head_dim, heads, lengths, dtype, iters):
+    scale = head_dim**-0.5
+    print(f"architecture: {mx.metal.device_info()['architecture']}")
+    tiles = "  ".join(f"{t:>8}" for t in TILE_SIZES)
+    print(f"heads  keys  best_tile  threadgroups  {tiles}")
+    for n_heads in heads:
+        for n_keys in lengths:
+            q = mx.random.normal((1, n_heads, 1, head_dim)).astype(dtype)
+            k = mx.random.normal((1, n_heads, n_keys, head_dim)).astype(dtype)
+            v = mx.random.normal((1, n_heads, n_keys, head_dim)).astype(dtype)
+            mx.eval(q, k, v)
+            times = []
+            for tile_size in TILE_SIZES:
+                os.environ["MLX_SDPA_TILE_SIZE"] = str(tile_size)
+                times.append(time_decoding(q, k, v, scale, iters))
+            del os.environ["MLX_SDPA_TILE_SIZE"]
+            best = TILE_SIZES[times.index(min(times))]
+            groups = n_heads * ((n_keys + best - 1) // best)
+            print(
+                f"{n_heads:>5} {n_keys:>5} {best:>10} {groups:>13}  "
+                + "  ".join(f"{t:8.4f}" for t in times)
+            )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser("Tune the decoding attention tiles.")
+    parser.add_argument("--head-dim", type=int, default=128)
+    parser.add_argument("--heads", type=int, nargs="+", default=[8, 32])
+    parser.add_argument(
+        "--lengths", type=int, nargs="+", default=[1024, 4096, 16384, 32768]
+    )
+    parser.add_argument("--dtype", choices=["float16", "float32"], default="float16")
+    parser.add_argument("--iters", type=int, default=50)
+    args = parser.parse_args()
+
+    mx.set_default_device(mx.gpu)
+    tune(
+        args.head_dim,
+        args.heads,
+        args.lengths,
+        getattr(mx, args.dtype),
+        args.iters,
+    )
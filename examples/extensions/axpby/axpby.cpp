@@ -1,6 +1,7 @@
 // Copyright © 2023-2024 Apple Inc.
 
 #include <cassert>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 
@@ -368,4 +369,16 @@ bool Axpby::is_equivalent(const Primitive& other) const {
   return alpha_ == r_other.alpha_ && beta_ == r_other.beta_;
 }
 
+/** Source of the call operator computing one element, the scaling factors
+ * are baked in so each pair of them gets its own fused kernel */
+std::string Axpby::elementwise_source() const {
+  std::ostringstream os;
+  os << std::setprecision(9) << "template <typename T>" << std::endl
+     << "T operator()(T x, T y) {" << std::endl
+     << "  return static_cast<T>(" << std::scientific << alpha_
+     << "f) * x + static_cast<T>(" << beta_ << "f) * y;" << std::endl
+     << "}";
+  return os.str();
+}
+
 } // namespace mlx::core
@@ -78,6 +78,10 @@ class Axpby : public Primitive {
   /** Equivalence check **/
   bool is_equivalent(const Primitive& other) const override;
 
+  /** The scalar op, which lets compile fuse the primitive with its
+   * elementwise neighbors */
+  std::string elementwise_source() const override;
+
  private:
   float alpha_;
   float beta_;
@@ -1,33 +1,238 @@
 // Copyright © 2023 Apple Inc.
 
+#include <unistd.h>
+#include <algorithm>
 #include <cstdlib>
+#include <limits>
 #include <sstream>
 
 #include "mlx/allocator.h"
+#include "mlx/memory.h"
+#include "mlx/memory_impl.h"
 #include "mlx/scheduler.h"
+#include "mlx/threadpool.h"
 
 namespace mlx::core::allocator {
 
+namespace {
+
+// The error of a failed allocation, with the memory report when tracking
+std::string allocation_error(const char* caller, size_t size) {
+  std::ostringstream msg;
+  msg << "[" << caller << "] Unable to allocate " << size << " bytes.";
+  if (memory::is_tracking()) {
+    msg << "\n" << memory::report();
+  }
+  return msg.str();
+}
+
+} // namespace
+
 Buffer malloc(size_t size) {
   auto buffer = allocator().malloc(size, /* allow_swap */ true);
   if (size && !buffer.ptr()) {
-    std::ostringstream msg;
-    msg << "[malloc] Unable to allocate " << size << " bytes.";
-    throw std::runtime_error(msg.str());
+    throw std::runtime_error(allocation_error("malloc", size));
   }
+  memory::detail::on_malloc(buffer, size);
   return buffer;
 }
 
 void free(Buffer buffer) {
+  if (memory::is_tracking()) {
+    return memory::detail::tracked_free(buffer);
+  }
   return allocator().free(buffer);
 }
 
-Buffer CommonAllocator::malloc(size_t size, bool) {
-  return Buffer{std::malloc(size)};
+namespace {
+
+// Round up to a size class. Small sizes are multiples of 16 bytes and larger
+// ones have four classes between consecutive powers of two, which bounds the
+// wasted space to a quarter of the requested size.
+size_t size_class(size_t size) {
+  if (size <= 256) {
+    return std::max<size_t>(16, (size + 15) & ~size_t(15));
+  }
+  size_t step = size_t(1) << (63 - __builtin_clzll(size - 1));
+  step >>= 2;
+  return (size + step - 1) & ~(step - 1);
+}
+
+size_t physical_memory() {
+  auto pages = sysconf(_SC_PHYS_PAGES);
+  auto page_size = sysconf(_SC_PAGESIZE);
+  if (pages <= 0 || page_size <= 0) {
+    return std::numeric_limits<size_t>::max();
+  }
+  return static_cast<size_t>(pages) * static_cast<size_t>(page_size);
+}
+
+// Fresh blocks at least this large are first touched by the CPU threads
+constexpr size_t first_touch_bytes = 1 << 22;
+
+// Write a byte to every page of a fresh block in as many contiguous chunks
+// as the CPU pool has threads. With pinned threads a chunk is touched by the
+// thread which processes it in kernels split the same way, so the OS places
+// its pages on that thread's NUMA node.
+void first_touch(char* ptr, size_t size) {
+  if (size < first_touch_bytes || ThreadPool::in_worker()) {
+    return;
+  }
+  auto& pool = cpu_thread_pool();
+  if (!pool.pinned()) {
+    return;
+  }
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t n = pool.size();
+  size_t chunk = (size + n - 1) / n;
+  pool.parallel_for(n, [&](int i) {
+    size_t end = std::min(size, (i + 1) * chunk);
+    for (size_t j = i * chunk; j < end; j += page_size) {
+      ptr[j] = 0;
+    }
+  });
+}
+
+} // namespace
+
+CommonAllocator::CommonAllocator() : max_cache_size_(physical_memory()) {}
+
+size_t CommonAllocator::set_cache_limit(size_t limit) {
+  std::unique_lock lk(mutex_);
+  std::swap(limit, max_cache_size_);
+  if (cache_memory_ > max_cache_size_) {
+    evictions_ += release_cached_blocks(cache_memory_ - max_cache_size_);
+  }
+  return limit;
+}
+
+Buffer CommonAllocator::malloc(size_t requested_size, bool) {
+  size_t size = size_class(requested_size);
+
+  Block* block = nullptr;
+  {
+    std::unique_lock lk(mutex_);
+    if (auto it = bins_.find(size); it != bins_.end() && !it->second.empty()) {
+      // Reuse the most recently freed block of this size
+      block = it->second.back();
+      it->second.pop_back();
+      remove_from_list(block);
+      cache_memory_ -= size;
+      active_memory_ += size;
+      peak_memory_ = std::max(peak_memory_, active_memory_);
+      hits_++;
+      wasted_bytes_ += size - requested_size;
+    } else {
+      misses_++;
+    }
+  }
+
+  if (!block) {
+    block = static_cast<Block*>(std::malloc(size + header_size));
+    if (!block) {
+      return Buffer{nullptr};
+    }
+    block->size = size;
+    first_touch(reinterpret_cast<char*>(block) + header_size, size);
+    std::unique_lock lk(mutex_);
+    active_memory_ += size;
+    peak_memory_ = std::max(peak_memory_, active_memory_);
+  }
+
+  return Buffer{reinterpret_cast<char*>(block) + header_size};
 }
 
 void CommonAllocator::free(Buffer buffer) {
-  std::free(buffer.raw_ptr());
+  if (!buffer.ptr()) {
+    return;
+  }
+  auto block = reinterpret_cast<Block*>(
+      static_cast<char*>(buffer.ptr()) - header_size);
+  std::unique_lock lk(mutex_);
+  active_memory_ -= block->size;
+  if (block->size > max_cache_size_) {
+    lk.unlock();
+    std::free(block);
+    return;
+  }
+
+  // Add to the head of the list and the back of its bin
+  block->prev = nullptr;
+  block->next = head_;
+  if (head_) {
+    head_->prev = block;
+  } else {
+    tail_ = block;
+  }
+  head_ = block;
+  bins_[block->size].push_back(block);
+  cache_memory_ += block->size;
+
+  if (cache_memory_ > max_cache_size_) {
+    evictions_ += release_cached_blocks(cache_memory_ - max_cache_size_);
+  }
+}
+
+void CommonAllocator::clear_cache() {
+  std::unique_lock lk(mutex_);
+  release_cached_blocks(cache_memory_);
+}
+
+std::unordered_map<std::string, size_t> CommonAllocator::get_cache_stats() {
+  std::unique_lock lk(mutex_);
+  return {
+      {"hits", hits_},
+      {"misses", misses_},
+      {"wasted_bytes", wasted_bytes_},
+      {"evictions", evictions_},
+  };
+}
+
+void CommonAllocator::reset_cache_stats() {
+  std::unique_lock lk(mutex_);
+  hits_ = 0;
+  misses_ = 0;
+  wasted_bytes_ = 0;
+  evictions_ = 0;
+}
+
+size_t CommonAllocator::release_cached_blocks(size_t min_bytes_to_free) {
+  size_t total_bytes_freed = 0;
+  size_t n_released = 0;
+  while (tail_ && total_bytes_freed < min_bytes_to_free) {
+    // The least recently freed block is also the oldest one in its bin
+    Block* block = tail_;
+    remove_from_list(block);
+    auto& bin = bins_[block->size];
+    bin.pop_front();
+    if (bin.empty()) {
+      bins_.erase(block->size);
+    }
+    total_bytes_freed += block->size;
+    n_released++;
+    std::free(block);
+  }
+  cache_memory_ -= total_bytes_freed;
+  return n_released;
+}
+
+void CommonAllocator::remove_from_list(Block* block) {
+  if (block->prev) {
+    block->prev->next = block->next;
+  } else {
+    head_ = block->next;
+  }
+  if (block->next) {
+    block->next->prev = block->prev;
+  } else {
+    tail_ = block->prev;
+  }
+}
+
+CommonAllocator& common_allocator() {
+  // Never destroyed so buffers freed during static destruction are safe
+  static CommonAllocator* allocator_ = new CommonAllocator;
+  return *allocator_;
 }
 
 Buffer malloc_or_wait(size_t size) {
@@ -44,11 +249,10 @@ Buffer malloc_or_wait(size_t size) {
   }
 
   if (size && !buffer.ptr()) {
-    std::ostringstream msg;
-    msg << "[malloc_or_wait] Unable to allocate " << size << " bytes.";
-    throw std::runtime_error(msg.str());
+    throw std::runtime_error(allocation_error("malloc_or_wait", size));
   }
 
+  memory::detail::on_malloc(buffer, size);
   return buffer;
 }
 
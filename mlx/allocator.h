@@ -3,6 +3,10 @@
 #pragma once
 
 #include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 namespace mlx::core::allocator {
 
@@ -36,6 +40,13 @@ void free(Buffer buffer);
 // if allocation fails
 Buffer malloc_or_wait(size_t size);
 
+// Wrap memory owned elsewhere, e.g. a memory mapped file, in a buffer without
+// copying it. Returns a null buffer if the backend can't use the memory
+// directly. The buffer must be released with release_external and not free.
+Buffer make_external(void* ptr, size_t size);
+
+void release_external(Buffer buffer);
+
 class Allocator {
   /** Abstract base class for a memory allocator. */
  public:
@@ -53,14 +64,72 @@ class Allocator {
 Allocator& allocator();
 
 class CommonAllocator : public Allocator {
-  /** A general CPU allocator. */
+  /** A general CPU allocator.
+   *
+   * Sizes are rounded up to a size class and freed buffers are kept in a
+   * cache binned by size class so they can be reused by later allocations
+   * without going back to the system allocator. The least recently freed
+   * buffers are released when the cache grows past its limit.
+   * */
  public:
   virtual Buffer malloc(size_t size, bool allow_swap = false) override;
   virtual void free(Buffer buffer) override;
+  size_t get_active_memory() {
+    return active_memory_;
+  };
+  size_t get_peak_memory() {
+    return peak_memory_;
+  };
+  void reset_peak_memory() {
+    std::unique_lock lk(mutex_);
+    peak_memory_ = 0;
+  };
+  size_t get_cache_memory() {
+    return cache_memory_;
+  };
+  size_t set_cache_limit(size_t limit);
+  void clear_cache();
+  std::unordered_map<std::string, size_t> get_cache_stats();
+  void reset_cache_stats();
 
  private:
-  CommonAllocator() = default;
-  friend Allocator& allocator();
+  // Stored in front of every allocation
+  struct Block {
+    size_t size;
+    // Links in the list of cached blocks, most recently freed first
+    Block* prev;
+    Block* next;
+  };
+  static constexpr size_t header_size = 32;
+  static_assert(sizeof(Block) <= header_size);
+
+  // Release the least recently freed blocks, returns the number released
+  size_t release_cached_blocks(size_t min_bytes_to_free);
+  void remove_from_list(Block* block);
+
+  std::unordered_map<size_t, std::deque<Block*>> bins_;
+  Block* head_{nullptr};
+  Block* tail_{nullptr};
+
+  // Allocation stats
+  size_t active_memory_{0};
+  size_t peak_memory_{0};
+  size_t cache_memory_{0};
+  size_t max_cache_size_;
+
+  // Cache stats
+  size_t hits_{0};
+  size_t misses_{0};
+  size_t wasted_bytes_{0};
+  size_t evictions_{0};
+
+  std::mutex mutex_;
+
+  CommonAllocator();
+  friend CommonAllocator& common_allocator();
 };
 
+/** The CPU allocator, used by allocator() when there is no GPU backend. */
+CommonAllocator& common_allocator();
+
 } // namespace mlx::core::allocator
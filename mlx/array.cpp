@@ -17,10 +17,78 @@ bool in_tracing() {
   return detail::InTracing::in_tracing();
 }
 
+// Building a graph allocates a description per array and as many are freed
+// once it is evaluated, so the freed blocks are kept for the next ones. The
+// list is trivially destructible so that descriptions freed after the thread
+// locals are destroyed (e.g. by static arrays) go back to the heap.
+struct FreeList {
+  static constexpr int capacity = 256;
+  void* blocks[capacity];
+  int size;
+  bool closed;
+};
+
+template <size_t N>
+FreeList& free_list() {
+  thread_local FreeList list{};
+  return list;
+}
+
+template <size_t N>
+struct FreeListCloser {
+  ~FreeListCloser() {
+    auto& list = free_list<N>();
+    while (list.size > 0) {
+      ::operator delete(list.blocks[--list.size]);
+    }
+    list.closed = true;
+  }
+};
+
+template <typename T>
+struct PoolAllocator {
+  using value_type = T;
+
+  PoolAllocator() = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    auto& list = free_list<sizeof(T)>();
+    if (n == 1 && list.size > 0) {
+      return static_cast<T*>(list.blocks[--list.size]);
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    auto& list = free_list<sizeof(T)>();
+    if (n == 1 && !list.closed && list.size < FreeList::capacity) {
+      // Drains the list when the thread exits
+      thread_local FreeListCloser<sizeof(T)> closer;
+      (void)closer;
+      list.blocks[list.size++] = p;
+    } else {
+      ::operator delete(p);
+    }
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const {
+    return false;
+  }
+};
+
 } // namespace
 
 array::array(const std::complex<float>& val, Dtype dtype /* = complex64 */)
-    : array_desc_(std::make_shared<ArrayDesc>(std::vector<int>{}, dtype)) {
+    : array_desc_(ArrayDesc::make(std::vector<int>{}, dtype)) {
   auto cval = static_cast<complex64_t>(val);
   init(&cval);
 }
@@ -30,7 +98,7 @@ array::array(
     Dtype dtype,
     std::shared_ptr<Primitive> primitive,
     std::vector<array> inputs)
-    : array_desc_(std::make_shared<ArrayDesc>(
+    : array_desc_(ArrayDesc::make(
           std::move(shape),
           dtype,
           std::move(primitive),
@@ -55,14 +123,14 @@ std::vector<array> array::make_arrays(
 }
 
 array::array(std::initializer_list<float> data)
-    : array_desc_(std::make_shared<ArrayDesc>(
+    : array_desc_(ArrayDesc::make(
           std::vector<int>{static_cast<int>(data.size())},
           float32)) {
   init(data.begin());
 }
 
 array::array(std::initializer_list<int> data, Dtype dtype)
-    : array_desc_(std::make_shared<ArrayDesc>(
+    : array_desc_(ArrayDesc::make(
           std::vector<int>{static_cast<int>(data.size())},
           dtype)) {
   init(data.begin());
@@ -74,7 +142,7 @@ array::array(
     std::vector<int> shape,
     Dtype dtype,
     deleter_t deleter)
-    : array_desc_(std::make_shared<ArrayDesc>(std::move(shape), dtype)) {
+    : array_desc_(ArrayDesc::make(std::move(shape), dtype)) {
   set_data(data, deleter);
 }
 
@@ -95,6 +163,11 @@ void array::eval() {
   // Ensure the array is ready to be read
   if (status() == Status::scheduled) {
     event().wait();
+    // A cancelled evaluation leaves the array unscheduled
+    if (status() == Status::unscheduled) {
+      throw std::runtime_error(
+          "[eval] The evaluation of the array was cancelled.");
+    }
     set_status(Status::available);
   } else if (status() == Status::unscheduled) {
     mlx::core::eval({*this});
@@ -229,33 +302,93 @@ array::ArrayDesc::ArrayDesc(
   init();
 }
 
+std::shared_ptr<array::ArrayDesc> array::ArrayDesc::make(
+    std::vector<int> shape,
+    Dtype dtype) {
+  return std::allocate_shared<ArrayDesc>(
+      PoolAllocator<ArrayDesc>{}, std::move(shape), dtype);
+}
+
+std::shared_ptr<array::ArrayDesc> array::ArrayDesc::make(
+    std::vector<int> shape,
+    Dtype dtype,
+    std::shared_ptr<Primitive> primitive,
+    std::vector<array> inputs) {
+  return std::allocate_shared<ArrayDesc>(
+      PoolAllocator<ArrayDesc>{},
+      std::move(shape),
+      dtype,
+      std::move(primitive),
+      std::move(inputs));
+}
+
 array::ArrayDesc::~ArrayDesc() {
   // When an array description is destroyed it will delete a bunch of arrays
   // that may also destroy their corresponding descriptions and so on and so
   // forth.
   //
   // This calls recursively the destructor and can result in stack overflow, we
-  // instead put them in a vector and destroy them one at a time resulting in a
-  // max stack depth of 2.
-  std::vector<std::shared_ptr<ArrayDesc>> for_deletion;
-
-  for (array& a : inputs) {
-    if (a.array_desc_.use_count() == 1) {
-      for_deletion.push_back(std::move(a.array_desc_));
+  // instead put them in a stack and destroy them one at a time resulting in a
+  // max stack depth of 2. The stack is kept per thread so tearing down a graph
+  // doesn't allocate once it has grown. It is trivially destructible so that
+  // descriptions destroyed after the thread locals fall back to a local one.
+  using Pending = std::vector<std::shared_ptr<ArrayDesc>>;
+  struct Stack {
+    Pending* pending;
+    bool draining;
+    bool closed;
+  };
+  thread_local Stack stack{};
+  struct StackCloser {
+    ~StackCloser() {
+      delete stack.pending;
+      stack.pending = nullptr;
+      stack.closed = true;
     }
-  }
+  };
 
-  while (!for_deletion.empty()) {
-    // top is going to be deleted at the end of the block *after* the arrays
-    // with inputs have been moved into the vector
-    auto top = std::move(for_deletion.back());
-    for_deletion.pop_back();
-
-    for (array& a : top->inputs) {
+  auto collect = [](std::vector<array>& arrays, Pending& pending) {
+    for (array& a : arrays) {
       if (a.array_desc_.use_count() == 1) {
-        for_deletion.push_back(std::move(a.array_desc_));
+        pending.push_back(std::move(a.array_desc_));
       }
     }
+  };
+
+  // The descriptions destroyed while draining are collected by the
+  // outermost destructor
+  if (stack.draining) {
+    collect(inputs, *stack.pending);
+    return;
+  }
+
+  Pending local;
+  if (stack.closed) {
+    stack.pending = &local;
+  } else if (stack.pending == nullptr) {
+    thread_local StackCloser closer;
+    (void)closer;
+    stack.pending = new Pending();
+  }
+  auto& pending = *stack.pending;
+  collect(inputs, pending);
+  if (pending.empty()) {
+    return;
+  }
+
+  stack.draining = true;
+  while (!pending.empty()) {
+    // top is destroyed at the end of the block *after* its inputs have been
+    // moved onto the stack
+    auto top = std::move(pending.back());
+    pending.pop_back();
+  }
+  stack.draining = false;
+
+  // Don't hold on to the memory of a very wide graph
+  constexpr size_t max_capacity = 1 << 14;
+  if (pending.capacity() > max_capacity) {
+    Pending().swap(pending);
   }
 }
 
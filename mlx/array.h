@@ -2,6 +2,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -200,6 +201,12 @@ class array {
     return reinterpret_cast<std::uintptr_t>(array_desc_.get());
   }
 
+  /** The number of handles, i.e. copies of this array object, to the
+   * array. */
+  long use_count() const {
+    return array_desc_.use_count();
+  }
+
   /** A unique identifier for an arrays primitive. */
   std::uintptr_t primitive_id() const {
     return reinterpret_cast<std::uintptr_t>(array_desc_->primitive.get());
@@ -208,6 +215,9 @@ class array {
   struct Data {
     allocator::Buffer buffer;
     deleter_t d;
+    // The memory is owned outside of MLX, e.g. by a NumPy array, and must
+    // never be reused for the output of an operation
+    bool external{false};
     Data(allocator::Buffer buffer, deleter_t d = allocator::free)
         : buffer(buffer), d(d) {}
     // Not copyable
@@ -253,7 +263,18 @@ class array {
 
   /** True indicates the arrays buffer is safe to reuse */
   bool is_donatable() const {
-    return array_desc_.use_count() == 1 && (array_desc_->data.use_count() == 1);
+    return array_desc_.use_count() == 1 &&
+        (array_desc_->data.use_count() == 1 ||
+         array_desc_->planned_donation) &&
+        !(array_desc_->data && array_desc_->data->external);
+  }
+
+  /** Allow the last user of the array to reuse its buffer even if the
+   * buffer is still referenced elsewhere, e.g. by GPU work not yet completed.
+   * Only valid when none of the other references can read the buffer after
+   * the last user of the array, which compile checks from the graph. */
+  void set_planned_donation(bool planned) {
+    array_desc_->planned_donation = planned;
   }
 
   /** The array's siblings. */
@@ -350,6 +371,23 @@ class array {
   // Check if the array is a tracer array
   bool is_tracer() const;
 
+  /** Mark the array and its siblings as visited by the graph traversal with
+   * the given epoch. Returns false if they were visited by it already.
+   *
+   * Graphs evaluated from several threads can share arrays, e.g. weights.
+   * A traversal on another thread can then overwrite the mark, in which case
+   * the array is visited again, which is harmless for evaluated arrays. */
+  bool visit(uint64_t epoch) const {
+    if (array_desc_->visit_epoch.exchange(epoch, std::memory_order_relaxed) ==
+        epoch) {
+      return false;
+    }
+    for (auto& s : siblings()) {
+      s.array_desc_->visit_epoch.store(epoch, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
   void set_data(allocator::Buffer buffer, deleter_t d = allocator::free);
 
   void set_data(
@@ -404,6 +442,12 @@ class array {
     // and should not be detached from the graph
     bool is_tracer{false};
 
+    // The buffer can be donated even if shared, see set_planned_donation
+    bool planned_donation{false};
+
+    // The last graph traversal which visited the array, see visit
+    std::atomic<uint64_t> visit_epoch{0};
+
     // This is a shared pointer so that *different* arrays
     // can share the underlying data buffer.
     std::shared_ptr<Data> data;
@@ -436,6 +480,15 @@ class array {
 
     ~ArrayDesc();
 
+    // Allocate the description from a per thread pool of recycled blocks
+    static std::shared_ptr<ArrayDesc> make(std::vector<int> shape, Dtype dtype);
+
+    static std::shared_ptr<ArrayDesc> make(
+        std::vector<int> shape,
+        Dtype dtype,
+        std::shared_ptr<Primitive> primitive,
+        std::vector<array> inputs);
+
    private:
     // Initialize size, strides, and other metadata
     void init();
@@ -450,7 +503,7 @@ class array {
 
 template <typename T>
 array::array(T val, Dtype dtype /* = TypeToDtype<T>() */)
-    : array_desc_(std::make_shared<ArrayDesc>(std::vector<int>{}, dtype)) {
+    : array_desc_(ArrayDesc::make(std::vector<int>{}, dtype)) {
   init(&val);
 }
 
@@ -459,7 +512,7 @@ array::array(
   It data,
   std::vector<int> shape,
   Dtype dtype /* = TypeToDtype<typename std::iterator_traits<It>::value_type>() */) :
-    array_desc_(std::make_shared<ArrayDesc>(std::move(shape), dtype)) {
+    array_desc_(ArrayDesc::make(std::move(shape), dtype)) {
   init(data);
 }
 
@@ -467,7 +520,7 @@ template <typename T>
 array::array(
     std::initializer_list<T> data,
     Dtype dtype /* = TypeToDtype<T>() */)
-    : array_desc_(std::make_shared<ArrayDesc>(
+    : array_desc_(ArrayDesc::make(
           std::vector<int>{static_cast<int>(data.size())},
           dtype)) {
   init(data.begin());
@@ -478,7 +531,7 @@ array::array(
     std::initializer_list<T> data,
     std::vector<int> shape,
     Dtype dtype /* = TypeToDtype<T>() */)
-    : array_desc_(std::make_shared<ArrayDesc>(std::move(shape), dtype)) {
+    : array_desc_(ArrayDesc::make(std::move(shape), dtype)) {
   if (data.size() != size()) {
     throw std::invalid_argument(
         "Data size and provided shape mismatch in array construction.");
@@ -1,5 +1,6 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -28,18 +29,20 @@ namespace mlx::core {
 // Use the default implementation for the following primitives
 DEFAULT(Arange)
 DEFAULT(ArgPartition)
-DEFAULT(ArgReduce)
 DEFAULT(ArgSort)
 DEFAULT(AsStrided)
 DEFAULT(BlockMaskedMM)
 DEFAULT(Broadcast)
+DEFAULT_MULTI(CacheAppend)
 DEFAULT(Ceil)
 DEFAULT(Concatenate)
 DEFAULT(Conjugate)
 DEFAULT(Copy)
 DEFAULT_MULTI(CustomVJP)
 DEFAULT_MULTI(Depends)
+DEFAULT(Dequantize)
 DEFAULT_MULTI(DivMod)
+DEFAULT_MULTI(MatmulVJP)
 DEFAULT(NumberOfElements)
 DEFAULT(Equal)
 DEFAULT(Erf)
@@ -48,9 +51,14 @@ DEFAULT(FFT)
 DEFAULT(Floor)
 DEFAULT(Gather)
 DEFAULT(GatherMM)
+DEFAULT(SampledMM)
+DEFAULT(SparseMM)
+DEFAULT(Sparse24Matmul)
+DEFAULT(Fp8Matmul)
 DEFAULT(GatherQMM)
 DEFAULT(Greater)
 DEFAULT(GreaterEqual)
+DEFAULT(Hadamard)
 DEFAULT(Less)
 DEFAULT(LessEqual)
 DEFAULT(Load)
@@ -58,17 +66,23 @@ DEFAULT(LogicalNot)
 DEFAULT(LogicalAnd)
 DEFAULT(LogicalOr)
 DEFAULT(LogAddExp)
+DEFAULT(LogSumExp)
 DEFAULT(Maximum)
 DEFAULT(Minimum)
 DEFAULT(NotEqual)
 DEFAULT(Pad)
 DEFAULT(Partition)
 DEFAULT_MULTI(QRF)
+DEFAULT_MULTI(Quantize)
 DEFAULT(RandomBits)
+DEFAULT(RandomNormal)
+DEFAULT(RandomDropout)
 DEFAULT(Reshape)
 DEFAULT(Remainder)
 DEFAULT(Round)
 DEFAULT(Scatter)
+DEFAULT(SegmentedReduce)
+DEFAULT(SegmentedScan)
 DEFAULT(Select)
 DEFAULT(Sigmoid)
 DEFAULT(Sign)
@@ -81,6 +95,84 @@ DEFAULT_MULTI(SVD)
 DEFAULT(Transpose)
 DEFAULT(Inverse)
 DEFAULT(Cholesky)
+DEFAULT_MULTI(Eigh)
+DEFAULT(Solve)
+DEFAULT(SolveTriangular)
+
+namespace {
+
+// Number of half precision elements converted to float32 at a time
+constexpr int half_block_size = 2048;
+
+// Run a float32 kernel on float16 or bfloat16 data by converting blocks of
+// the input through float32 buffers. The default implementation also computes
+// these types in float32 so the results match up to rounding of the kernel.
+template <typename T, typename Op>
+void unary_through_float(const array& in, array& out, Op op) {
+  float in_buf[half_block_size];
+  float out_buf[half_block_size];
+  const T* src = in.data<T>();
+  T* dst = out.data<T>();
+  size_t size = in.data_size();
+  for (size_t start = 0; start < size; start += half_block_size) {
+    int n = std::min<size_t>(half_block_size, size - start);
+    for (int i = 0; i < n; i++) {
+      in_buf[i] = static_cast<float>(src[start + i]);
+    }
+    op(out_buf, in_buf, n);
+    for (int i = 0; i < n; i++) {
+      dst[start + i] = static_cast<T>(out_buf[i]);
+    }
+  }
+}
+
+// Apply a vForce style kernel op(out, in, n) to a contiguous floating point
+// input. Returns false if the default implementation should be used.
+template <typename Op>
+bool vforce_unary(const array& in, array& out, Op op) {
+  if (!in.flags().contiguous) {
+    return false;
+  }
+  switch (out.dtype()) {
+    case float32:
+      set_unary_output_data(in, out);
+      op(out.data<float>(), in.data<float>(), in.data_size());
+      return true;
+    case float16:
+      set_unary_output_data(in, out);
+      unary_through_float<float16_t>(in, out, op);
+      return true;
+    case bfloat16:
+      set_unary_output_data(in, out);
+      unary_through_float<bfloat16_t>(in, out, op);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// If the elements of x in row major order are evenly spaced in memory return
+// the spacing so x can be passed to vDSP as a strided vector, otherwise 0.
+vDSP_Stride vdsp_stride(const array& x) {
+  vDSP_Stride stride = 1;
+  size_t span = 0;
+  bool innermost = true;
+  for (int i = x.ndim() - 1; i >= 0; i--) {
+    if (x.shape(i) == 1) {
+      continue;
+    }
+    if (innermost) {
+      stride = x.strides()[i];
+      innermost = false;
+    } else if (x.strides()[i] != span) {
+      return 0;
+    }
+    span = x.strides()[i] * x.shape(i);
+  }
+  return stride;
+}
+
+} // namespace
 
 void Abs::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
@@ -91,6 +183,9 @@ void Abs::eval_cpu(const std::vector<array>& inputs, array& out) {
   } else if (in.dtype() == int32 && in.flags().contiguous) {
     set_unary_output_data(in, out);
     vDSP_vabsi(in.data<int>(), 1, out.data<int>(), 1, in.data_size());
+  } else if (auto stride = vdsp_stride(in); in.dtype() == float32 && stride) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+    vDSP_vabs(in.data<float>(), stride, out.data<float>(), 1, out.size());
   } else {
     eval(inputs, out);
   }
@@ -139,11 +234,8 @@ void Add::eval_cpu(const std::vector<array>& inputs, array& out) {
 void ArcCos::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvacosf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvacosf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -151,11 +243,8 @@ void ArcCos::eval_cpu(const std::vector<array>& inputs, array& out) {
 void ArcCosh::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvacoshf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvacoshf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -163,11 +252,8 @@ void ArcCosh::eval_cpu(const std::vector<array>& inputs, array& out) {
 void ArcSin::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvasinf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvasinf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -175,11 +261,8 @@ void ArcSin::eval_cpu(const std::vector<array>& inputs, array& out) {
 void ArcSinh::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvasinhf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvasinhf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -187,11 +270,8 @@ void ArcSinh::eval_cpu(const std::vector<array>& inputs, array& out) {
 void ArcTan::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvatanf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvatanf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -219,10 +299,46 @@ void ArcTan2::eval_cpu(const std::vector<array>& inputs, array& out) {
 void ArcTanh::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvatanhf(out.data<float>(), in.data<float>(), &size);
+  auto op = [](float* o, const float* i, int n) { vvatanhf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
+    eval(inputs, out);
+  }
+}
+
+void ArgReduce::eval_cpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+  auto& in = inputs[0];
+  if (in.dtype() == float32 && in.flags().row_contiguous &&
+      axis_ == static_cast<int>(in.ndim()) - 1) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+    int axis_size = in.shape(axis_);
+    const float* row = in.data<float>();
+    uint32_t* dst = out.data<uint32_t>();
+    for (size_t i = 0; i < out.size(); i++, row += axis_size) {
+      // vDSP does not define how NaNs are handled so rows that contain
+      // them (detected by a NaN sum) use the same scan as the default
+      float sum;
+      vDSP_sve(row, 1, &sum, axis_size);
+      if (std::isnan(sum)) {
+        uint32_t ind = 0;
+        for (int j = 1; j < axis_size; j++) {
+          bool better = (reduce_type_ == ArgReduce::ArgMin)
+              ? row[j] < row[ind]
+              : row[j] > row[ind];
+          ind = better ? j : ind;
+        }
+        dst[i] = ind;
+        continue;
+      }
+      float v;
+      vDSP_Length ind;
+      if (reduce_type_ == ArgReduce::ArgMin) {
+        vDSP_minvi(row, 1, &v, &ind, axis_size);
+      } else {
+        vDSP_maxvi(row, 1, &v, &ind, axis_size);
+      }
+      dst[i] = ind;
+    }
   } else {
     eval(inputs, out);
   }
@@ -260,11 +376,8 @@ void AsType::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Cos::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvcosf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvcosf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -272,11 +385,8 @@ void Cos::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Cosh::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvcoshf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvcoshf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -322,10 +432,9 @@ void Divide::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Exp::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    auto size = in.data_size();
-    vvexpf(out.data<float>(), in.data<float>(), reinterpret_cast<int*>(&size));
+  auto op = [](float* o, const float* i, int n) { vvexpf(o, i, &n); };
+  if (vforce_unary(in, out, op)) {
+    return;
   } else if (issubdtype(out.dtype(), inexact)) {
     unary_fp(in, out, [](auto x) { return std::exp(x); });
   } else {
@@ -338,12 +447,8 @@ void Exp::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Expm1::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    auto size = in.data_size();
-    vvexpm1f(
-        out.data<float>(), in.data<float>(), reinterpret_cast<int*>(&size));
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvexpm1f(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -363,24 +468,25 @@ void Full::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Log::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    auto size = in.data_size();
-    switch (base_) {
-      case Base::e:
-        vvlogf(
-            out.data<float>(), in.data<float>(), reinterpret_cast<int*>(&size));
-        break;
-      case Base::two:
-        vvlog2f(
-            out.data<float>(), in.data<float>(), reinterpret_cast<int*>(&size));
-        break;
-      case Base::ten:
-        vvlog10f(
-            out.data<float>(), in.data<float>(), reinterpret_cast<int*>(&size));
-        break;
-    }
-  } else {
+  bool done = false;
+  switch (base_) {
+    case Base::e:
+      done = vforce_unary(in, out, [](float* o, const float* i, int n) {
+        vvlogf(o, i, &n);
+      });
+      break;
+    case Base::two:
+      done = vforce_unary(in, out, [](float* o, const float* i, int n) {
+        vvlog2f(o, i, &n);
+      });
+      break;
+    case Base::ten:
+      done = vforce_unary(in, out, [](float* o, const float* i, int n) {
+        vvlog10f(o, i, &n);
+      });
+      break;
+  }
+  if (!done) {
     eval(inputs, out);
   }
 }
@@ -388,11 +494,9 @@ void Log::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Log1p::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    auto size = in.data_size();
-    vvlog1pf(
-        out.data<float>(), in.data<float>(), reinterpret_cast<int*>(&size));
+  auto op = [](float* o, const float* i, int n) { vvlog1pf(o, i, &n); };
+  if (vforce_unary(in, out, op)) {
+    return;
   } else if (issubdtype(out.dtype(), inexact)) {
     unary_fp(in, out, [](auto x) { return std::log1p(x); });
   } else {
@@ -433,6 +537,9 @@ void Negative::eval_cpu(const std::vector<array>& inputs, array& out) {
   if (in.dtype() == float32 && in.flags().contiguous) {
     set_unary_output_data(in, out);
     vDSP_vneg(in.data<float>(), 1, out.data<float>(), 1, in.data_size());
+  } else if (auto stride = vdsp_stride(in); in.dtype() == float32 && stride) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+    vDSP_vneg(in.data<float>(), stride, out.data<float>(), 1, out.size());
   } else {
     unary(in, out, [](auto x) { return -x; });
   }
@@ -462,7 +569,7 @@ void Scan::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
   if (reduce_type_ == Scan::Sum && out.dtype() == float32 &&
-      in.flags().row_contiguous && in.strides()[axis_] == 1 && !inclusive_) {
+      in.flags().row_contiguous && in.strides()[axis_] == 1) {
     out.set_data(allocator::malloc_or_wait(out.nbytes()));
     int stride = in.shape(axis_);
     int count = in.size() / stride;
@@ -472,6 +579,9 @@ void Scan::eval_cpu(const std::vector<array>& inputs, array& out) {
     if (!reverse_) {
       for (int i = 0; i < count; i++) {
         vDSP_vrsum(input - 1, 1, &s, output, 1, stride);
+        if (inclusive_) {
+          vDSP_vadd(output, 1, input, 1, output, 1, stride);
+        }
         input += stride;
         output += stride;
       }
@@ -480,6 +590,9 @@ void Scan::eval_cpu(const std::vector<array>& inputs, array& out) {
         input += stride - 1;
         output += stride - 1;
         vDSP_vrsum(input + 1, -1, &s, output, -1, stride);
+        if (inclusive_) {
+          vDSP_vadd(output, -1, input, -1, output, -1, stride);
+        }
         input++;
         output++;
       }
@@ -492,11 +605,8 @@ void Scan::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Sin::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvsinf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvsinf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -504,11 +614,8 @@ void Sin::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Sinh::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvsinhf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvsinhf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -520,6 +627,9 @@ void Square::eval_cpu(const std::vector<array>& inputs, array& out) {
     set_unary_output_data(in, out);
     auto size = in.data_size();
     vDSP_vsq(in.data<float>(), 1, out.data<float>(), 1, size);
+  } else if (auto stride = vdsp_stride(in); in.dtype() == float32 && stride) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+    vDSP_vsq(in.data<float>(), stride, out.data<float>(), 1, out.size());
   } else {
     unary(in, out, [](auto x) { return x * x; });
   }
@@ -528,15 +638,17 @@ void Square::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Sqrt::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   auto& in = inputs[0];
-  if (in.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    if (recip_) {
-      vvrsqrtf(out.data<float>(), in.data<float>(), &size);
-    } else {
-      vvsqrtf(out.data<float>(), in.data<float>(), &size);
-    }
+  bool done;
+  if (recip_) {
+    done = vforce_unary(in, out, [](float* o, const float* i, int n) {
+      vvrsqrtf(o, i, &n);
+    });
   } else {
+    done = vforce_unary(in, out, [](float* o, const float* i, int n) {
+      vvsqrtf(o, i, &n);
+    });
+  }
+  if (!done) {
     eval(inputs, out);
   }
 }
@@ -584,11 +696,8 @@ void Subtract::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Tan::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvtanf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvtanf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -596,11 +705,8 @@ void Tan::eval_cpu(const std::vector<array>& inputs, array& out) {
 void Tanh::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
-  if (out.dtype() == float32 && in.flags().contiguous) {
-    set_unary_output_data(in, out);
-    int size = in.data_size();
-    vvtanhf(out.data<float>(), in.data<float>(), &size);
-  } else {
+  auto op = [](float* o, const float* i, int n) { vvtanhf(o, i, &n); };
+  if (!vforce_unary(in, out, op)) {
     eval(inputs, out);
   }
 }
@@ -1,66 +1,257 @@
-// Copyright © 2023 Apple Inc.
+// Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
+#include <vector>
 
-#include <simd/vector.h>
+#include <vecLib/cblas_new.h>
 
+#include "mlx/backend/common/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
 
 namespace {
 
-void _qmm_t_4_64(
-    float* result,
-    const float* x,
+// Output columns computed per tile. Each tile dequantizes the part of w it
+// needs into a float32 buffer and multiplies it with cblas_sgemm. It is a
+// multiple of every supported group size.
+constexpr int QMM_BLAS_NC = 128;
+
+// Fewer rows of x than this are left to the default implementation which
+// does not materialize the dequantized weights.
+constexpr int QMM_BLAS_MIN_M = 8;
+
+// Dequantizes rows [row0, row0 + rows) and columns [col0, col0 + cols) of
+// w, which is quantized along its last axis of size total_cols, into out
+// with leading dimension cols. col0 and cols must be multiples of
+// group_size.
+template <typename T, int bits, int group_size>
+void dequantize_block(
     const uint32_t* w,
-    const float* scales,
-    const float* biases,
-    int M,
-    int N,
-    int K) {
-  constexpr int bits = 4;
-  constexpr int group_size = 64;
-  constexpr int bitmask = (1 << bits) - 1;
+    const T* scales,
+    const T* biases,
+    float* out,
+    int row0,
+    int rows,
+    int col0,
+    int cols,
+    int total_cols) {
+  constexpr uint32_t bitmask = (1 << bits) - 1;
   constexpr int pack_factor = 32 / bits;
   constexpr int packs_in_group = group_size / pack_factor;
+  const int row_words = total_cols / pack_factor;
+  const int row_groups = total_cols / group_size;
 
-  for (int m = 0; m < M; m++) {
-    const uint32_t* w_local = w;
-    const float* scales_local = scales;
-    const float* biases_local = biases;
-
-    for (int n = 0; n < N; n++) {
-      const simd_float16* x_local = (simd_float16*)x;
-      simd_float16 sum = 0;
-      for (int k = 0; k < K; k += group_size) {
-        float scale = *scales_local++;
-        float bias = *biases_local++;
-
-        for (int kw = 0; kw < packs_in_group; kw += 2) {
-          // TODO: vectorize this properly
-          simd_uint16 wi;
-          for (int e = 0; e < 2; e++) {
-            uint32_t wii = *w_local++;
-            for (int p = 0; p < 8; p++) {
-              wi[e * 8 + p] = wii & bitmask;
-              wii >>= bits;
-            }
-          }
-          simd_float16 wf = simd_float(wi);
-          wf *= scale;
-          wf += bias;
-
-          sum += (*x_local) * wf;
-          x_local++;
+  for (int i = 0; i < rows; i++) {
+    const uint32_t* w_local =
+        w + (row0 + i) * size_t(row_words) + col0 / pack_factor;
+    const T* scales_local =
+        scales + (row0 + i) * size_t(row_groups) + col0 / group_size;
+    const T* biases_local =
+        biases + (row0 + i) * size_t(row_groups) + col0 / group_size;
+    float* out_row = out + i * size_t(cols);
+    for (int g = 0; g < cols / group_size; g++) {
+      float scale = static_cast<float>(scales_local[g]);
+      float bias = static_cast<float>(biases_local[g]);
+      float* q = out_row + g * group_size;
+      for (int j = 0; j < packs_in_group; j++) {
+        uint32_t wi = w_local[g * packs_in_group + j];
+        for (int p = 0; p < pack_factor; p++) {
+          q[j * pack_factor + p] =
+              scale * static_cast<float>((wi >> (p * bits)) & bitmask) + bias;
         }
       }
+    }
+  }
+}
+
+// Computes x @ w.T (transpose) or x @ w with cblas_sgemm on QMM_BLAS_NC
+// wide column tiles of the output split across the CPU thread pool.
+template <typename T, int bits, int group_size>
+void _qmm_blas(
+    T* result,
+    const T* x,
+    const uint32_t* w,
+    const T* scales,
+    const T* biases,
+    int M,
+    int N,
+    int K,
+    bool transpose) {
+  const float* x_f;
+  std::vector<float> x_buf;
+  if constexpr (std::is_same_v<T, float>) {
+    x_f = x;
+  } else {
+    x_buf.resize(size_t(M) * K);
+    for (size_t i = 0; i < x_buf.size(); i++) {
+      x_buf[i] = static_cast<float>(x[i]);
+    }
+    x_f = x_buf.data();
+  }
+
+  const int n_tiles = (N + QMM_BLAS_NC - 1) / QMM_BLAS_NC;
+
+  auto compute_tiles = [&](size_t begin, size_t end) {
+    std::vector<float> w_tile(size_t(QMM_BLAS_NC) * K);
+    std::vector<float> out_tile;
+    if constexpr (!std::is_same_v<T, float>) {
+      out_tile.resize(size_t(M) * QMM_BLAS_NC);
+    }
+    for (size_t tile = begin; tile < end; tile++) {
+      int n0 = tile * QMM_BLAS_NC;
+      int nc = std::min(QMM_BLAS_NC, N - n0);
+
+      // w is N x K quantized along K when transposed and K x N quantized
+      // along N otherwise
+      if (transpose) {
+        dequantize_block<T, bits, group_size>(
+            w, scales, biases, w_tile.data(), n0, nc, 0, K, K);
+      } else {
+        dequantize_block<T, bits, group_size>(
+            w, scales, biases, w_tile.data(), 0, K, n0, nc, N);
+      }
 
-      *result = simd_reduce_add(sum);
-      result++;
+      float* c;
+      int ldc;
+      if constexpr (std::is_same_v<T, float>) {
+        c = result + n0;
+        ldc = N;
+      } else {
+        c = out_tile.data();
+        ldc = nc;
+      }
+      cblas_sgemm(
+          CblasRowMajor,
+          CblasNoTrans,
+          transpose ? CblasTrans : CblasNoTrans,
+          M,
+          nc,
+          K,
+          1.0f,
+          x_f,
+          K,
+          w_tile.data(),
+          transpose ? K : nc,
+          0.0f,
+          c,
+          ldc);
+
+      if constexpr (!std::is_same_v<T, float>) {
+        for (int i = 0; i < M; i++) {
+          T* result_row = result + i * size_t(N) + n0;
+          for (int j = 0; j < nc; j++) {
+            result_row[j] = static_cast<T>(c[i * nc + j]);
+          }
+        }
+      }
     }
+  };
 
-    x += K;
+  parallel_for(
+      n_tiles,
+      compute_tiles,
+      std::max<size_t>(
+          1, min_elements_per_thread / (size_t(QMM_BLAS_NC) * M * K)));
+}
+
+template <typename T, int bits>
+bool _qmm_blas_dispatch_group(
+    array& out,
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size,
+    bool transpose) {
+  int K = x.shape(-1);
+  int M = x.size() / K;
+  int N = out.shape(-1);
+  auto run = [&](auto kernel) {
+    kernel(
+        out.data<T>(),
+        x.data<T>(),
+        w.data<uint32_t>(),
+        scales.data<T>(),
+        biases.data<T>(),
+        M,
+        N,
+        K,
+        transpose);
+    return true;
+  };
+  switch (group_size) {
+    case 32:
+      return run(_qmm_blas<T, bits, 32>);
+    case 64:
+      return run(_qmm_blas<T, bits, 64>);
+    case 128:
+      return run(_qmm_blas<T, bits, 128>);
+    default:
+      return false;
+  }
+}
+
+template <typename T>
+bool _qmm_blas_dispatch_typed(
+    array& out,
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size,
+    int bits,
+    bool transpose) {
+  switch (bits) {
+    case 2:
+      return _qmm_blas_dispatch_group<T, 2>(
+          out, x, w, scales, biases, group_size, transpose);
+    case 4:
+      return _qmm_blas_dispatch_group<T, 4>(
+          out, x, w, scales, biases, group_size, transpose);
+    case 8:
+      return _qmm_blas_dispatch_group<T, 8>(
+          out, x, w, scales, biases, group_size, transpose);
+    default:
+      return false;
+  }
+}
+
+// Returns false, without touching out, for the configurations that are left
+// to the default implementation.
+bool _qmm_blas_dispatch(
+    array& out,
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size,
+    int bits,
+    bool transpose) {
+  bool supported = (bits == 2 || bits == 4 || bits == 8) &&
+      (group_size == 32 || group_size == 64 || group_size == 128);
+  if (!supported || x.size() / x.shape(-1) < QMM_BLAS_MIN_M ||
+      !x.flags().row_contiguous || !w.flags().row_contiguous ||
+      !scales.flags().row_contiguous || !biases.flags().row_contiguous) {
+    return false;
+  }
+  switch (x.dtype()) {
+    case float32:
+      out.set_data(allocator::malloc_or_wait(out.nbytes()));
+      return _qmm_blas_dispatch_typed<float>(
+          out, x, w, scales, biases, group_size, bits, transpose);
+    case float16:
+      out.set_data(allocator::malloc_or_wait(out.nbytes()));
+      return _qmm_blas_dispatch_typed<float16_t>(
+          out, x, w, scales, biases, group_size, bits, transpose);
+    case bfloat16:
+      out.set_data(allocator::malloc_or_wait(out.nbytes()));
+      return _qmm_blas_dispatch_typed<bfloat16_t>(
+          out, x, w, scales, biases, group_size, bits, transpose);
+    default:
+      return false;
   }
 }
 
@@ -74,26 +265,8 @@ void QuantizedMatmul::eval_cpu(const std::vector<array>& inputs, array& out) {
   auto& scales = inputs[2];
   auto& biases = inputs[3];
 
-  bool condition =
-      (transpose_ && x.flags().row_contiguous && w.flags().row_contiguous &&
-       scales.flags().row_contiguous && biases.flags().row_contiguous &&
-       x.dtype() == float32 && bits_ == 4 && group_size_ == 64);
-
-  if (condition) {
-    out.set_data(allocator::malloc_or_wait(out.nbytes()));
-    int K = x.shape(-1);
-    int M = x.size() / K;
-    int N = out.shape(-1);
-    _qmm_t_4_64(
-        out.data<float>(),
-        x.data<float>(),
-        w.data<uint32_t>(),
-        scales.data<float>(),
-        biases.data<float>(),
-        M,
-        N,
-        K);
-  } else {
+  if (!_qmm_blas_dispatch(
+          out, x, w, scales, biases, group_size_, bits_, transpose_)) {
     eval(inputs, out);
   }
 }
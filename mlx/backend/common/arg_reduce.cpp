@@ -1,7 +1,11 @@
 // Copyright © 2023 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
 
+#include "mlx/backend/common/convert.h"
+#include "mlx/backend/common/ops.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/primitives.h"
 #include "utils.h"
 
@@ -9,24 +13,124 @@ namespace mlx::core {
 
 namespace {
 
-template <typename InT, typename OpT>
-void arg_reduce(const array& in, array& out, const OpT& op, int axis) {
+// Elements of a contiguous row processed at a time and the lanes of the
+// running extreme, independent so the loop over them vectorizes
+constexpr int ARG_REDUCE_CHUNK = 256;
+constexpr int ARG_REDUCE_LANES = 8;
+
+template <bool Max, typename T>
+inline T pick(T a, T b) {
+  if constexpr (Max) {
+    return std::max(a, b);
+  } else {
+    return std::min(a, b);
+  }
+}
+
+/* Index of the first maximum (or minimum) of a contiguous row. Matches the
+ * strided loop: NaNs are skipped unless the row starts with one. The extreme
+ * is found first with integer lanes, floats compared through their ordered
+ * integer keys, and the row is then searched for its first occurrence.
+ * */
+template <bool Max, typename T>
+uint32_t arg_reduce_contiguous(const T* x, int n) {
+  using namespace detail;
+  if constexpr (std::is_same_v<T, float> || is_half_v<T>) {
+    if (std::isnan(static_cast<float>(x[0]))) {
+      return 0;
+    }
+    constexpr int32_t skip = Max ? INT32_MIN : INT32_MAX;
+    float buf[ARG_REDUCE_CHUNK];
+    int32_t lanes[ARG_REDUCE_LANES];
+    std::fill_n(lanes, ARG_REDUCE_LANES, skip);
+    auto key = [](float v) {
+      int32_t k = float_key(v);
+      int32_t nan = bit_mask((float_bits(v) & 0x7fffffff) > 0x7f800000);
+      return (k & ~nan) | (skip & nan);
+    };
+    for (int start = 0; start < n; start += ARG_REDUCE_CHUNK) {
+      int len = std::min(ARG_REDUCE_CHUNK, n - start);
+      const float* v = load_chunk(x + start, len, buf);
+      int i = 0;
+      for (; i + ARG_REDUCE_LANES <= len; i += ARG_REDUCE_LANES) {
+        for (int l = 0; l < ARG_REDUCE_LANES; l++) {
+          lanes[l] = pick<Max>(lanes[l], key(v[i + l]));
+        }
+      }
+      for (; i < len; i++) {
+        lanes[0] = pick<Max>(lanes[0], key(v[i]));
+      }
+    }
+    int32_t best = lanes[0];
+    for (int l = 1; l < ARG_REDUCE_LANES; l++) {
+      best = pick<Max>(best, lanes[l]);
+    }
+    float target = from_float_key(best);
+    for (int start = 0; start < n; start += ARG_REDUCE_CHUNK) {
+      int len = std::min(ARG_REDUCE_CHUNK, n - start);
+      const float* v = load_chunk(x + start, len, buf);
+      auto it = std::find(v, v + len, target);
+      if (it != v + len) {
+        return start + (it - v);
+      }
+    }
+    return 0;
+  } else {
+    T lanes[ARG_REDUCE_LANES];
+    std::fill_n(lanes, ARG_REDUCE_LANES, x[0]);
+    int i = 0;
+    for (; i + ARG_REDUCE_LANES <= n; i += ARG_REDUCE_LANES) {
+      for (int l = 0; l < ARG_REDUCE_LANES; l++) {
+        lanes[l] = pick<Max>(lanes[l], x[i + l]);
+      }
+    }
+    for (; i < n; i++) {
+      lanes[0] = pick<Max>(lanes[0], x[i]);
+    }
+    T best = lanes[0];
+    for (int l = 1; l < ARG_REDUCE_LANES; l++) {
+      best = pick<Max>(best, lanes[l]);
+    }
+    return std::find(x, x + n, best) - x;
+  }
+}
+
+template <typename InT, bool Max>
+void arg_reduce(const array& in, array& out, int axis) {
   auto axis_size = in.shape()[axis];
   auto axis_stride = in.strides()[axis];
   std::vector<size_t> strides = in.strides();
   std::vector<int> shape = in.shape();
   strides.erase(strides.begin() + axis);
   shape.erase(shape.begin() + axis);
-  for (uint32_t i = 0; i < out.size(); ++i) {
-    auto loc = elem_to_loc(i, shape, strides);
-    auto in_ptr = in.data<InT>() + loc;
-    uint32_t ind_v = 0;
-    InT v = (*in_ptr);
-    for (uint32_t j = 0; j < axis_size; ++j, in_ptr += axis_stride) {
-      op(j, (*in_ptr), &ind_v, &v);
-    }
-    out.data<uint32_t>()[i] = ind_v;
-  }
+  const InT* in_data = in.data<InT>();
+  uint32_t* out_data = out.data<uint32_t>();
+
+  // Rows are independent so they are split across threads
+  size_t grain = std::max<size_t>(1, min_elements_per_thread / axis_size);
+  parallel_for(
+      out.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          auto in_ptr = in_data + elem_to_loc(i, shape, strides);
+          if constexpr (std::is_arithmetic_v<InT> || is_half_v<InT>) {
+            if (axis_stride == 1) {
+              out_data[i] = arg_reduce_contiguous<Max>(in_ptr, axis_size);
+              continue;
+            }
+          }
+          uint32_t ind_v = 0;
+          InT v = (*in_ptr);
+          for (uint32_t j = 0; j < axis_size; ++j, in_ptr += axis_stride) {
+            if (Max ? (*in_ptr > v) : (*in_ptr < v)) {
+              v = *in_ptr;
+              ind_v = j;
+            }
+          }
+          out_data[i] = ind_v;
+        }
+      },
+      grain);
 }
 
 template <typename InT>
@@ -36,26 +140,12 @@ void arg_reduce_dispatch(
     ArgReduce::ReduceType rtype,
     int axis) {
   switch (rtype) {
-    case ArgReduce::ArgMin: {
-      auto op = [](auto ind_x, auto x, auto ind_y, auto y) {
-        if (x < (*y)) {
-          (*y) = x;
-          (*ind_y) = ind_x;
-        }
-      };
-      arg_reduce<InT>(in, out, op, axis);
+    case ArgReduce::ArgMin:
+      arg_reduce<InT, false>(in, out, axis);
       break;
-    }
-    case ArgReduce::ArgMax: {
-      auto op = [](auto ind_x, auto x, auto ind_y, auto y) {
-        if (x > (*y)) {
-          (*y) = x;
-          (*ind_y) = ind_x;
-        }
-      };
-      arg_reduce<InT>(in, out, op, axis);
+    case ArgReduce::ArgMax:
+      arg_reduce<InT, true>(in, out, axis);
       break;
-    }
   }
 }
 
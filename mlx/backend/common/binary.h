@@ -5,6 +5,8 @@
 
 #include "mlx/allocator.h"
 #include "mlx/array.h"
+#include "mlx/backend/common/convert.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/utils.h"
 
 namespace mlx::core {
@@ -136,6 +138,11 @@ struct UseDefaultBinaryOp {
   }
 };
 
+// Half precision ops computing in float run on blocks converted in bulk
+template <typename T, typename U, typename Op>
+constexpr bool is_half_op = is_half_v<T> && std::is_same_v<T, U> &&
+    computes_in_float<Op, float, float>();
+
 template <typename T, typename U, typename Op>
 struct DefaultVectorScalar {
   Op op;
@@ -143,6 +150,10 @@ struct DefaultVectorScalar {
   DefaultVectorScalar(Op op_) : op(op_) {}
 
   void operator()(const T* a, const T* b, U* dst, int size) {
+    if constexpr (is_half_op<T, U, Op>) {
+      half_binary(a, b, dst, size, 1, 0, op);
+      return;
+    }
     T scalar = *b;
     while (size-- > 0) {
       *dst = op(*a, scalar);
@@ -171,6 +182,10 @@ struct DefaultScalarVector {
   DefaultScalarVector(Op op_) : op(op_) {}
 
   void operator()(const T* a, const T* b, U* dst, int size) {
+    if constexpr (is_half_op<T, U, Op>) {
+      half_binary(a, b, dst, size, 0, 1, op);
+      return;
+    }
     T scalar = *a;
     while (size-- > 0) {
       *dst = op(scalar, *b);
@@ -199,6 +214,10 @@ struct DefaultVectorVector {
   DefaultVectorVector(Op op_) : op(op_) {}
 
   void operator()(const T* a, const T* b, U* dst, int size) {
+    if constexpr (is_half_op<T, U, Op>) {
+      half_binary(a, b, dst, size, 1, 1, op);
+      return;
+    }
     while (size-- > 0) {
       *dst = op(*a, *b);
       dst++;
@@ -348,7 +367,7 @@ void binary_op_dims4(const array& a, const array& b, array& out, Op op) {
 }
 
 template <typename T, typename U, typename Op>
-void binary_op_dispatch_dims(
+void binary_op_dispatch_dims_serial(
     const array& a,
     const array& b,
     array& out,
@@ -380,6 +399,41 @@ void binary_op_dispatch_dims(
 
 template <typename T, typename U, typename Op>
 void binary_op_dispatch_dims(
+    const array& a,
+    const array& b,
+    array& out,
+    Op op) {
+  // Split the output into rows of the last dimension, each thread finds the
+  // start of its rows in the inputs and walks them with the inner stride.
+  size_t inner = out.shape().back();
+  size_t n_rows = out.size() / inner;
+  parallel_for(
+      n_rows,
+      [&a, &b, &out, &op, inner, n_rows](size_t start, size_t end) {
+        if (start == 0 && end == n_rows) {
+          binary_op_dispatch_dims_serial<T, U>(a, b, out, op);
+          return;
+        }
+        const T* a_ptr = a.data<T>();
+        const T* b_ptr = b.data<T>();
+        U* dst = out.data<U>() + start * inner;
+        auto a_inner = a.strides().back();
+        auto b_inner = b.strides().back();
+        for (size_t r = start; r < end; r++) {
+          size_t a_idx = elem_to_loc(r * inner, a.shape(), a.strides());
+          size_t b_idx = elem_to_loc(r * inner, b.shape(), b.strides());
+          for (size_t i = 0; i < inner; i++) {
+            *dst++ = op(a_ptr[a_idx], b_ptr[b_idx]);
+            a_idx += a_inner;
+            b_idx += b_inner;
+          }
+        }
+      },
+      std::max<size_t>(min_elements_per_thread / inner, 1));
+}
+
+template <typename T, typename U, typename Op>
+void binary_op_dispatch_dims_serial(
     const array& a,
     const array& b,
     array& out,
@@ -407,6 +461,36 @@ void binary_op_dispatch_dims(
   }
 }
 
+template <typename T, typename U, typename Op>
+void binary_op_dispatch_dims(
+    const array& a,
+    const array& b,
+    array& out,
+    Op op,
+    int dim,
+    int stride) {
+  // Split the output into the contiguous blocks handled by the vectorized op
+  size_t n_blocks = out.size() / stride;
+  parallel_for(
+      n_blocks,
+      [&a, &b, &out, &op, dim, stride, n_blocks](size_t start, size_t end) {
+        if (start == 0 && end == n_blocks) {
+          binary_op_dispatch_dims_serial<T, U>(a, b, out, op, dim, stride);
+          return;
+        }
+        const T* a_ptr = a.data<T>();
+        const T* b_ptr = b.data<T>();
+        U* dst = out.data<U>() + start * stride;
+        for (size_t i = start * stride; i < end * stride; i += stride) {
+          int a_idx = elem_to_loc(i, a.shape(), a.strides());
+          int b_idx = elem_to_loc(i, b.shape(), b.strides());
+          op(a_ptr + a_idx, b_ptr + b_idx, dst, stride);
+          dst += stride;
+        }
+      },
+      std::max<size_t>(min_elements_per_thread / stride, 1));
+}
+
 template <
     typename T,
     typename U,
@@ -433,19 +517,34 @@ void binary_op(
 
   // The full computation is scalar vector so delegate to the op
   if (bopt == BinaryOpType::ScalarVector) {
-    opsv(a.data<T>(), b.data<T>(), out.data<U>(), b.data_size());
+    const T* a_ptr = a.data<T>();
+    const T* b_ptr = b.data<T>();
+    U* dst = out.data<U>();
+    parallel_for(b.data_size(), [&](size_t start, size_t end) {
+      opsv(a_ptr, b_ptr + start, dst + start, end - start);
+    });
     return;
   }
 
   // The full computation is vector scalar so delegate to the op
   if (bopt == BinaryOpType::VectorScalar) {
-    opvs(a.data<T>(), b.data<T>(), out.data<U>(), a.data_size());
+    const T* a_ptr = a.data<T>();
+    const T* b_ptr = b.data<T>();
+    U* dst = out.data<U>();
+    parallel_for(a.data_size(), [&](size_t start, size_t end) {
+      opvs(a_ptr + start, b_ptr, dst + start, end - start);
+    });
     return;
   }
 
   // The full computation is vector vector so delegate to the op
   if (bopt == BinaryOpType::VectorVector) {
-    opvv(a.data<T>(), b.data<T>(), out.data<U>(), out.size());
+    const T* a_ptr = a.data<T>();
+    const T* b_ptr = b.data<T>();
+    U* dst = out.data<U>();
+    parallel_for(out.size(), [&](size_t start, size_t end) {
+      opvv(a_ptr + start, b_ptr + start, dst + start, end - start);
+    });
     return;
   }
 
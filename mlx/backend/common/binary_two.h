@@ -268,34 +268,42 @@ void binary_op(
 
   // The full computation is scalar vector so delegate to the op
   if (bopt == BinaryOpType::ScalarVector) {
-    opsv(
-        a.data<T>(),
-        b.data<T>(),
-        out_a.data<U>(),
-        out_b.data<U>(),
-        b.data_size());
+    const T* a_ptr = a.data<T>();
+    const T* b_ptr = b.data<T>();
+    U* dst_a = out_a.data<U>();
+    U* dst_b = out_b.data<U>();
+    parallel_for(b.data_size(), [&](size_t start, size_t end) {
+      opsv(a_ptr, b_ptr + start, dst_a + start, dst_b + start, end - start);
+    });
     return;
   }
 
   // The full computation is vector scalar so delegate to the op
   if (bopt == BinaryOpType::VectorScalar) {
-    opvs(
-        a.data<T>(),
-        b.data<T>(),
-        out_a.data<U>(),
-        out_b.data<U>(),
-        a.data_size());
+    const T* a_ptr = a.data<T>();
+    const T* b_ptr = b.data<T>();
+    U* dst_a = out_a.data<U>();
+    U* dst_b = out_b.data<U>();
+    parallel_for(a.data_size(), [&](size_t start, size_t end) {
+      opvs(a_ptr + start, b_ptr, dst_a + start, dst_b + start, end - start);
+    });
     return;
   }
 
   // The full computation is vector vector so delegate to the op
   if (bopt == BinaryOpType::VectorVector) {
-    opvv(
-        a.data<T>(),
-        b.data<T>(),
-        out_a.data<U>(),
-        out_b.data<U>(),
-        out_a.size());
+    const T* a_ptr = a.data<T>();
+    const T* b_ptr = b.data<T>();
+    U* dst_a = out_a.data<U>();
+    U* dst_b = out_b.data<U>();
+    parallel_for(out_a.size(), [&](size_t start, size_t end) {
+      opvv(
+          a_ptr + start,
+          b_ptr + start,
+          dst_a + start,
+          dst_b + start,
+          end - start);
+    });
     return;
   }
 
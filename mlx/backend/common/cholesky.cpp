@@ -1,7 +1,10 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <cmath>
+
 #include "mlx/allocator.h"
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/linalg.h"
 #include "mlx/primitives.h"
 
@@ -40,6 +43,40 @@ int spotrf_wrapper(char uplo, float* matrix, int N) {
   return info;
 }
 
+// Unrolled Cholesky factorization of a tiny row-major N x N matrix in place.
+// Only the lower (or upper) triangle is read and the other one is zeroed like
+// the LAPACK path.
+template <int N>
+void small_cholesky(float* a, bool upper) {
+  // Work on the lower triangle, reading the upper one transposed
+  float L[N][N] = {};
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j <= i; j++) {
+      L[i][j] = upper ? a[j * N + i] : a[i * N + j];
+    }
+  }
+  for (int j = 0; j < N; j++) {
+    float d = L[j][j];
+    for (int k = 0; k < j; k++) {
+      d -= L[j][k] * L[j][k];
+    }
+    d = std::sqrt(d);
+    L[j][j] = d;
+    for (int i = j + 1; i < N; i++) {
+      float v = L[i][j];
+      for (int k = 0; k < j; k++) {
+        v -= L[i][k] * L[j][k];
+      }
+      L[i][j] = v / d;
+    }
+  }
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j < N; j++) {
+      a[i * N + j] = upper ? L[j][i] : L[i][j];
+    }
+  }
+}
+
 } // namespace
 
 void cholesky_impl(const array& a, array& factor, bool upper) {
@@ -61,34 +98,60 @@ void cholesky_impl(const array& a, array& factor, bool upper) {
 
   const int N = a.shape(-1);
   const size_t num_matrices = a.size() / (N * N);
+  size_t grain =
+      std::max<size_t>(1, min_elements_per_thread / (size_t(N) * N * N));
+
+  auto small_factor = [&](auto factor_one) {
+    parallel_for(
+        num_matrices,
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; i++) {
+            factor_one(factor.data<float>() + N * N * i, upper);
+          }
+        },
+        grain);
+  };
+  switch (N) {
+    case 1:
+      return small_factor(small_cholesky<1>);
+    case 2:
+      return small_factor(small_cholesky<2>);
+    case 3:
+      return small_factor(small_cholesky<3>);
+    case 4:
+      return small_factor(small_cholesky<4>);
+  }
 
-  float* matrix = factor.data<float>();
-
-  for (int i = 0; i < num_matrices; i++) {
-    // Compute Cholesky factorization.
-    int info = spotrf_wrapper(uplo, matrix, N);
-
-    // TODO: We do nothing when the matrix is not positive semi-definite
-    // because throwing an error would result in a crash. If we figure out how
-    // to catch errors from the implementation we should throw.
-    if (info < 0) {
-      std::stringstream msg;
-      msg << "[cholesky] Cholesky decomposition failed with error code "
-          << info;
-      throw std::runtime_error(msg.str());
-    }
+  auto factor_range = [&](size_t begin, size_t end) {
+    float* matrix = factor.data<float>() + N * N * begin;
+    for (size_t i = begin; i < end; i++) {
+      // Compute Cholesky factorization.
+      int info = spotrf_wrapper(uplo, matrix, N);
+
+      // TODO: We do nothing when the matrix is not positive semi-definite
+      // because throwing an error would result in a crash. If we figure out
+      // how to catch errors from the implementation we should throw.
+      if (info < 0) {
+        std::stringstream msg;
+        msg << "[cholesky] Cholesky decomposition failed with error code "
+            << info;
+        throw std::runtime_error(msg.str());
+      }
 
-    // Zero out the upper/lower triangle while advancing the pointer to the
-    // next matrix at the same time.
-    for (int row = 0; row < N; row++) {
-      if (upper) {
-        std::fill(matrix, matrix + row, 0);
-      } else {
-        std::fill(matrix + row + 1, matrix + N, 0);
+      // Zero out the upper/lower triangle while advancing the pointer to the
+      // next matrix at the same time.
+      for (int row = 0; row < N; row++) {
+        if (upper) {
+          std::fill(matrix, matrix + row, 0);
+        } else {
+          std::fill(matrix + row + 1, matrix + N, 0);
+        }
+        matrix += N;
       }
-      matrix += N;
     }
-  }
+  };
+
+  parallel_for(num_matrices, factor_range, grain);
 }
 
 void Cholesky::eval(const std::vector<array>& inputs, array& output) {
@@ -1,6 +1,7 @@
 // Copyright © 2024 Apple Inc.
 #include <cassert>
 
+#include "mlx/backend/common/slicing.h"
 #include "mlx/backend/common/utils.h"
 #include "mlx/primitives.h"
 
@@ -198,6 +199,19 @@ void Reshape::shared_buffer_reshape(
   out.copy_shared_buffer(in, out_strides, flags, in.data_size());
 }
 
+bool CacheAppend::reuse_cache(const array& cache, array& out) {
+  if (cache.shape() == out.shape() && cache.flags().row_contiguous &&
+      cache.is_donatable()) {
+    out.move_shared_buffer(cache);
+    return true;
+  }
+  return false;
+}
+
+void CacheAppend::set_filled_view(const array& out, array& view) {
+  shared_buffer_slice(out, out.strides(), 0, view);
+}
+
 void Split::eval(
     const std::vector<array>& inputs,
     std::vector<array>& outputs) {
@@ -98,7 +98,7 @@ std::string build_lib_name(
     // name and type of output
     os << namer.get_name(a) << kindof(a.dtype()) << a.itemsize();
     // computation performed
-    a.primitive().print(os);
+    print_op(os, a.primitive());
     // name of inputs to the function
     for (auto& inp : a.inputs()) {
       os << namer.get_name(inp);
@@ -126,6 +126,37 @@ std::string build_lib_name(
   return os.str();
 }
 
+namespace {
+
+std::string custom_op_name(const std::string& source) {
+  std::ostringstream name;
+  name << "CustomOp_" << std::hash<std::string>{}(source);
+  return name.str();
+}
+
+} // namespace
+
+void print_op(std::ostream& os, Primitive& p) {
+  if (auto source = p.elementwise_source(); !source.empty()) {
+    os << custom_op_name(source);
+  } else {
+    p.print(os);
+  }
+}
+
+void print_custom_ops(std::ostream& os, const std::vector<array>& tape) {
+  std::unordered_set<std::string> seen;
+  for (auto& a : tape) {
+    auto source = a.primitive().elementwise_source();
+    if (source.empty() || !seen.insert(source).second) {
+      continue;
+    }
+    os << "struct " << custom_op_name(source) << " {" << std::endl
+       << source << std::endl
+       << "};" << std::endl;
+  }
+}
+
 bool compiled_check_contiguity(
     const std::vector<array>& inputs,
     const std::vector<int>& shape) {
@@ -154,6 +185,24 @@ bool compiled_check_contiguity(
   return contiguous;
 }
 
+std::vector<int> compiled_reduction_shape(const std::vector<array>& inputs) {
+  std::vector<int> shape;
+  for (auto& x : inputs) {
+    shape = broadcast_shapes(shape, x.shape());
+  }
+  return shape;
+}
+
+std::vector<size_t> compiled_reduction_strides(
+    const array& x,
+    const std::vector<int>& shape) {
+  std::vector<size_t> strides(shape.size() - x.ndim(), 0);
+  for (int i = 0; i < x.ndim(); i++) {
+    strides.push_back(x.shape(i) == 1 ? 0 : x.strides()[i]);
+  }
+  return strides;
+}
+
 void compiled_allocate_outputs(
     const std::vector<array>& inputs,
     std::vector<array>& outputs,
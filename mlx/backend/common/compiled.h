@@ -49,6 +49,14 @@ void print_complex_constant(std::ostream& os, const array& x) {
 
 void print_constant(std::ostream& os, const array& x);
 
+// Write the name of the functor computing a fused primitive. Elementwise
+// primitives from outside of MLX get a functor named after their source.
+void print_op(std::ostream& os, Primitive& p);
+
+// Write the functors of the elementwise primitives from outside of MLX in
+// the tape, once each
+void print_custom_ops(std::ostream& os, const std::vector<array>& tape);
+
 inline bool is_scalar(const array& x) {
   return x.ndim() == 0;
 }
@@ -58,6 +66,21 @@ bool compiled_check_contiguity(
     const std::vector<array>& inputs,
     const std::vector<int>& shape);
 
+// The Reduce that ends the tape of a fused reduction or nullptr if the tape
+// is only elementwise
+inline const Reduce* compiled_reduction(const std::vector<array>& tape) {
+  auto& p = tape.back().primitive();
+  return typeid(p) == typeid(Reduce) ? static_cast<const Reduce*>(&p)
+                                     : nullptr;
+}
+
+// The shape of the array a fused reduction reduces, ie the inputs broadcast
+// together, and the strides of an input broadcast to it
+std::vector<int> compiled_reduction_shape(const std::vector<array>& inputs);
+std::vector<size_t> compiled_reduction_strides(
+    const array& x,
+    const std::vector<int>& shape);
+
 // Allocate space for the outputs possibly with input donation
 void compiled_allocate_outputs(
     const std::vector<array>& inputs,
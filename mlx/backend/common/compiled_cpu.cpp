@@ -1,13 +1,25 @@
 // Copyright © 2023-2024 Apple Inc.
 
 #include <dlfcn.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
-#include <list>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include "mlx/backend/common/compiled.h"
 #include "mlx/backend/common/compiled_preamble.h"
+#include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
+#include "mlx/compile.h"
+#include "mlx/compile_impl.h"
 #include "mlx/device.h"
 #include "mlx/graph_utils.h"
+#include "mlx/threadpool.h"
 
 namespace mlx::core {
 
@@ -19,93 +31,150 @@ bool compile_available_for_device(const Device& device) {
 }
 } // namespace detail
 
-std::string get_temp_file(const std::string& name) {
-  return std::filesystem::temp_directory_path().append(name);
+// Errno is never read so math functions can be inlined and vectorized
+constexpr const char* build_flags =
+    "-std=c++17 -O3 -fno-math-errno -Wall -fPIC -shared";
+
+// Compiled kernels are cached on disk in this directory and shared by all
+// processes. MLX_CPU_KERNEL_CACHE overrides the default location.
+const std::filesystem::path& kernel_cache_dir() {
+  static std::filesystem::path dir = []() {
+    std::filesystem::path path;
+    if (const char* buff_str = std::getenv("MLX_CPU_KERNEL_CACHE")) {
+      path = buff_str;
+    } else if (const char* buff_str = std::getenv("XDG_CACHE_HOME")) {
+      path = std::filesystem::path(buff_str) / "mlx" / "cpu_kernels";
+    } else if (const char* buff_str = std::getenv("HOME")) {
+      path = std::filesystem::path(buff_str) / ".cache" / "mlx" / "cpu_kernels";
+    } else {
+      path = std::filesystem::temp_directory_path() / "mlx_cpu_kernels";
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) {
+      path = std::filesystem::temp_directory_path();
+    }
+    return path;
+  }();
+  return dir;
 }
 
-// Return a pointer to a compiled function
-void* compile(
-    const std::string& kernel_name,
-    const std::string& source_code = "") {
-  struct DLib {
-    DLib(const std::string& libname) {
-      lib = dlopen(libname.c_str(), RTLD_NOW);
-      if (!lib) {
-        std::ostringstream msg;
-        msg << "Could not load C++ shared library " << dlerror();
-        throw std::runtime_error(msg.str());
-      }
-    }
+// A 64 bit FNV-1a hash which, unlike std::hash, is the same in every process
+uint64_t content_hash(const std::string& s) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (unsigned char c : s) {
+    h = (h ^ c) * 0x100000001b3ull;
+  }
+  return h;
+}
 
-    ~DLib() {
-      dlclose(lib);
+struct DLib {
+  DLib(const std::string& libname) {
+    lib = dlopen(libname.c_str(), RTLD_NOW);
+    if (!lib) {
+      std::ostringstream msg;
+      msg << "Could not load C++ shared library " << dlerror();
+      throw std::runtime_error(msg.str());
     }
-    void* lib;
-  };
-  // Statics to cache compiled libraries and functions
-  static std::list<DLib> libs;
-  static std::unordered_map<std::string, void*> kernels;
-  if (auto it = kernels.find(kernel_name); it != kernels.end()) {
-    return it->second;
-  }
-  if (source_code.empty()) {
-    return nullptr;
   }
 
-  std::string kernel_file_name;
+  ~DLib() {
+    dlclose(lib);
+  }
+  void* lib;
+};
+
+// Loaded libraries by file name, their functions by kernel name and the
+// kernels that are being built in the background
+struct KernelCache {
+  std::mutex mtx;
+  std::unordered_map<std::string, std::unique_ptr<DLib>> libs;
+  std::unordered_map<std::string, void*> kernels;
+  std::unordered_set<std::string> pending;
+  std::unordered_map<std::string, std::string> errors;
+
+  static KernelCache& get() {
+    static KernelCache cache;
+    return cache;
+  }
+};
+
+// New kernels are built by a few background threads so that they compile in
+// parallel and never block a stream
+ThreadPool& compile_pool() {
+  static ThreadPool pool(
+      std::clamp(int(std::thread::hardware_concurrency()) / 2, 1, 4) + 1);
+  return pool;
+}
 
+std::string get_kernel_file_name(const std::string& kernel_name) {
   // Deal with long kernel names. Maximum length for files on macOS is 255
-  // characters. Clip file name with a little extra room and append a 16
-  // character hash.
-  constexpr int max_file_name_length = 245;
-  if (kernel_name.size() > max_file_name_length) {
-    std::ostringstream file_name;
-    file_name
-        << std::string_view(kernel_name).substr(0, max_file_name_length - 16);
-    auto file_id = std::hash<std::string>{}(kernel_name);
-    file_name << "_" << std::hex << std::setw(16) << file_id << std::dec;
-    kernel_file_name = file_name.str();
-  } else {
-    kernel_file_name = kernel_name;
-  }
-
-  std::ostringstream shared_lib_name;
-  shared_lib_name << "lib" << kernel_file_name << ".so";
-  auto shared_lib_path = get_temp_file(shared_lib_name.str());
-  bool lib_exists = false;
-  {
-    std::ifstream f(shared_lib_path.c_str());
-    lib_exists = f.good();
-  }
-
-  if (!lib_exists) {
-    // Open source file and write source code to it
-    std::ostringstream source_file_name;
-    source_file_name << kernel_file_name << ".cpp";
-    auto source_file_path = get_temp_file(source_file_name.str());
-
-    std::ofstream source_file(source_file_path);
-    source_file << source_code;
-    source_file.close();
-
-    std::ostringstream build_command;
-    build_command << "g++ -std=c++17 -O2 -Wall -fPIC -shared "
-                  << source_file_path << " -o " << shared_lib_path;
-    std::string build_command_str = build_command.str();
-    auto return_code = system(build_command_str.c_str());
-    if (return_code) {
-      std::ostringstream msg;
-      msg << "[Compile::eval_cpu] Failed to compile function " << kernel_name
-          << " with error code " << return_code << "." << std::endl;
-      throw std::runtime_error(msg.str());
-    }
+  // characters. Clip file name with room for the source hash and the
+  // temporary build suffix and append a 16 character hash.
+  constexpr int max_file_name_length = 200;
+  if (kernel_name.size() <= max_file_name_length) {
+    return kernel_name;
   }
+  std::ostringstream file_name;
+  file_name << std::string_view(kernel_name).substr(
+      0, max_file_name_length - 16);
+  auto file_id = content_hash(kernel_name);
+  file_name << "_" << std::hex << std::setw(16) << std::setfill('0')
+            << file_id;
+  return file_name.str();
+}
 
-  // load library
-  libs.emplace_back(shared_lib_path);
+// Build the library under names unique to this process and move it in place
+// atomically so concurrent processes never load a partial file
+void build_shared_lib(
+    const std::string& kernel_name,
+    const std::string& kernel_file_name,
+    const std::filesystem::path& shared_lib_path,
+    const std::string& source_code) {
+  static std::atomic<int> build_count{0};
+  std::ostringstream unique_suffix;
+  unique_suffix << "." << getpid() << "." << build_count++;
+  auto source_file_path =
+      kernel_cache_dir() / (kernel_file_name + unique_suffix.str() + ".cpp");
+  auto tmp_lib_path = shared_lib_path;
+  tmp_lib_path += unique_suffix.str();
+
+  std::ofstream source_file(source_file_path);
+  source_file << source_code;
+  source_file.close();
+
+  std::ostringstream build_command;
+  build_command << "g++ " << build_flags << " " << source_file_path << " -o "
+                << tmp_lib_path;
+  std::string build_command_str = build_command.str();
+  auto return_code = system(build_command_str.c_str());
+  std::error_code ec;
+  std::filesystem::remove(source_file_path, ec);
+  if (return_code) {
+    std::filesystem::remove(tmp_lib_path, ec);
+    std::ostringstream msg;
+    msg << "[Compile::eval_cpu] Failed to compile function " << kernel_name
+        << " with error code " << return_code << "." << std::endl;
+    throw std::runtime_error(msg.str());
+  }
+  std::filesystem::rename(tmp_lib_path, shared_lib_path);
+}
 
-  // Load function
-  void* fun = dlsym(libs.back().lib, kernel_name.c_str());
+// Load the function from the library, the cache must be locked
+void* load_kernel(
+    KernelCache& cache,
+    const std::string& kernel_name,
+    const std::string& shared_lib_name,
+    const std::filesystem::path& shared_lib_path) {
+  auto lib = cache.libs.find(shared_lib_name);
+  if (lib == cache.libs.end()) {
+    lib = cache.libs
+              .emplace(
+                  shared_lib_name,
+                  std::make_unique<DLib>(shared_lib_path.string()))
+              .first;
+  }
+  void* fun = dlsym(lib->second->lib, kernel_name.c_str());
   if (!fun) {
     std::ostringstream msg;
     msg << "[Compile::eval_cpu] Failed to load compiled function "
@@ -113,10 +182,98 @@ void* compile(
         << dlerror();
     throw std::runtime_error(msg.str());
   }
-  kernels.insert({kernel_name, fun});
+  cache.kernels.insert({kernel_name, fun});
   return fun;
 }
 
+// Return a pointer to a compiled function. Kernels which are not built yet
+// are compiled in the background and nullptr is returned until they are
+// ready. The source is only generated when the kernel is not loaded.
+void* compile(
+    const std::string& kernel_name,
+    const std::function<std::string()>& source_builder) {
+  auto& cache = KernelCache::get();
+  std::lock_guard<std::mutex> lock(cache.mtx);
+  if (auto it = cache.kernels.find(kernel_name); it != cache.kernels.end()) {
+    return it->second;
+  }
+  if (cache.pending.find(kernel_name) != cache.pending.end()) {
+    return nullptr;
+  }
+  if (auto it = cache.errors.find(kernel_name); it != cache.errors.end()) {
+    auto msg = std::move(it->second);
+    cache.errors.erase(it);
+    throw std::runtime_error(msg);
+  }
+
+  auto source_code = source_builder();
+  auto kernel_file_name = get_kernel_file_name(kernel_name);
+
+  // The libraries are addressed by the hash of their source and flags so a
+  // change in either never loads a stale library
+  std::ostringstream lib_name;
+  lib_name << "lib" << kernel_file_name << "_" << std::hex << std::setw(16)
+           << std::setfill('0') << content_hash(build_flags + source_code)
+           << ".so";
+  auto shared_lib_name = lib_name.str();
+  auto shared_lib_path = kernel_cache_dir() / shared_lib_name;
+
+  if (cache.libs.find(shared_lib_name) != cache.libs.end() ||
+      std::filesystem::exists(shared_lib_path)) {
+    return load_kernel(cache, kernel_name, shared_lib_name, shared_lib_path);
+  }
+
+  cache.pending.insert(kernel_name);
+  detail::count_generated_kernel();
+  compile_pool().enqueue([kernel_name,
+                          kernel_file_name,
+                          shared_lib_name,
+                          shared_lib_path,
+                          source_code = std::move(source_code)]() {
+    std::string error;
+    try {
+      build_shared_lib(
+          kernel_name, kernel_file_name, shared_lib_path, source_code);
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+    auto& cache = KernelCache::get();
+    std::lock_guard<std::mutex> lock(cache.mtx);
+    cache.pending.erase(kernel_name);
+    if (error.empty()) {
+      try {
+        load_kernel(cache, kernel_name, shared_lib_name, shared_lib_path);
+      } catch (const std::exception& e) {
+        error = e.what();
+      }
+    }
+    if (!error.empty()) {
+      cache.errors.insert({kernel_name, error});
+    }
+  });
+  return nullptr;
+}
+
+void preload_cpu_kernels() {
+  auto& cache = KernelCache::get();
+  std::lock_guard<std::mutex> lock(cache.mtx);
+  std::error_code ec;
+  for (auto& entry :
+       std::filesystem::directory_iterator(kernel_cache_dir(), ec)) {
+    auto name = entry.path().filename().string();
+    if (entry.path().extension() != ".so" || name.rfind("lib", 0) != 0 ||
+        cache.libs.find(name) != cache.libs.end()) {
+      continue;
+    }
+    // Skip libraries that fail to load, they are rebuilt when needed
+    try {
+      cache.libs.emplace(
+          name, std::make_unique<DLib>(entry.path().string()));
+    } catch (const std::runtime_error&) {
+    }
+  }
+}
+
 inline void build_kernel(
     std::ostream& os,
     const std::string& kernel_name,
@@ -166,19 +323,61 @@ inline void build_kernel(
     os << "  " << tstr << "* " << namer.get_name(x) << " = (" << tstr
        << "*)args[" << cnt++ << "];" << std::endl;
   }
-  // Add output strides and shape to extract the indices.
+  // Add output strides and shape to extract the indices. The first axis is
+  // given by the range so the shape is only needed for the inner ones.
   if (!contiguous) {
-    os << "  const int* shape = (int*)args[" << cnt++ << "];" << std::endl;
-  } else {
-    os << "  const size_t size = (size_t)args[" << cnt++ << "];" << std::endl;
+    if (ndim > 1) {
+      os << "  const int* shape = (int*)args[" << cnt << "];" << std::endl;
+    }
+    cnt++;
   }
 
+  // The range of elements, or of the first axis when strided, that this
+  // call computes so that calls can be split across threads
+  os << "  const size_t begin = (size_t)args[" << cnt++ << "];" << std::endl;
+  os << "  const size_t end = (size_t)args[" << cnt++ << "];" << std::endl;
+
+  // Tell the compiler the iterations are independent so the innermost loop
+  // is vectorized. Outputs may share a buffer with an input but always at
+  // the same index.
+  auto vectorize_hint = [&os]() {
+    os << "#if defined(__clang__)" << std::endl
+       << "#pragma clang loop vectorize(enable) interleave(enable)" << std::endl
+       << "#elif defined(__GNUC__)" << std::endl
+       << "#pragma GCC ivdep" << std::endl
+       << "#endif" << std::endl;
+  };
+
   if (contiguous) {
-    os << "  for (size_t i = 0; i < size; ++i) {" << std::endl;
-  } else {
+    vectorize_hint();
+    os << "  for (size_t i = begin; i < end; ++i) {" << std::endl;
+  } else if (ndim > 0) {
+    // Move the pointers to the start of the range
+    for (auto& x : inputs) {
+      if (is_constant(x) || is_scalar(x)) {
+        continue;
+      }
+      auto& xname = namer.get_name(x);
+      os << "  " << xname << " += begin * " << xname << "_strides[0];"
+         << std::endl;
+    }
+    os << "  size_t out_offset = begin;" << std::endl;
+    for (int d = 1; d < ndim; ++d) {
+      os << "  out_offset *= shape[" << d << "];" << std::endl;
+    }
+    for (auto& x : outputs) {
+      os << "  " << namer.get_name(x) << " += out_offset;" << std::endl;
+    }
     for (int d = 0; d < ndim; ++d) {
-      os << "  for (int i" << d << " = 0; i" << d << " < shape[" << d
-         << "]; ++i" << d << ") {" << std::endl;
+      if (d == ndim - 1) {
+        vectorize_hint();
+      }
+      if (d == 0) {
+        os << "  for (size_t i0 = begin; i0 < end; ++i0) {" << std::endl;
+      } else {
+        os << "  for (int i" << d << " = 0; i" << d << " < shape[" << d
+           << "]; ++i" << d << ") {" << std::endl;
+      }
     }
   }
 
@@ -210,7 +409,7 @@ inline void build_kernel(
       os << "static_cast<" << get_type_string(x.dtype()) << ">(tmp_"
          << namer.get_name(x.inputs()[0]) << ");" << std::endl;
     } else {
-      x.primitive().print(os);
+      print_op(os, x.primitive());
       os << "()(";
       for (int i = 0; i < x.inputs().size() - 1; i++) {
         os << "tmp_" << namer.get_name(x.inputs()[i]) << ", ";
@@ -256,6 +455,362 @@ inline void build_kernel(
   os << "}" << std::endl;
 }
 
+// Build a kernel that computes the elementwise tape for each element of a
+// row and reduces it right away. Each call reduces the rows in [begin, end).
+inline void build_reduce_kernel(
+    std::ostream& os,
+    const std::string& kernel_name,
+    const std::vector<array>& inputs,
+    const std::vector<array>& outputs,
+    const std::vector<array>& tape,
+    const std::unordered_set<uintptr_t>& constant_ids,
+    bool contiguous) {
+  auto is_constant = [&constant_ids](const array& x) {
+    return constant_ids.find(x.id()) != constant_ids.end();
+  };
+  auto is_strided = [&](const array& x) {
+    return !contiguous && !is_constant(x) && !is_scalar(x);
+  };
+
+  NodeNamer namer;
+  auto& out = outputs[0];
+  auto& reduced = tape.back().inputs()[0];
+  auto reduce_type = compiled_reduction(tape)->reduce_type();
+  auto out_type = get_type_string(out.dtype());
+
+  // Half precision sums accumulate in float as in the unfused reduction
+  auto acc_type = out_type;
+  if (reduce_type == Reduce::Sum &&
+      (out.dtype() == float16 || out.dtype() == bfloat16)) {
+    acc_type = "float";
+  }
+
+  os << "void " << kernel_name << "(void** args) {" << std::endl;
+  int cnt = 0;
+  for (auto& x : inputs) {
+    auto& xname = namer.get_name(x);
+    if (is_constant(x)) {
+      continue;
+    }
+    auto tstr = get_type_string(x.dtype());
+    os << "  " << tstr << "* " << xname << " = (" << tstr << "*)args[" << cnt++
+       << "];" << std::endl;
+    if (is_strided(x)) {
+      os << "  const size_t* " << xname << "_strides = (size_t*)args[" << cnt++
+         << "];" << std::endl;
+    }
+  }
+  os << "  " << out_type << "* " << namer.get_name(out) << " = (" << out_type
+     << "*)args[" << cnt++ << "];" << std::endl;
+  if (!contiguous) {
+    os << "  const int* shape = (int*)args[" << cnt++ << "];" << std::endl
+       << "  const int ndim = (size_t)args[" << cnt++ << "];" << std::endl;
+  }
+  os << "  const size_t row_size = (size_t)args[" << cnt++ << "];" << std::endl
+     << "  const size_t begin = (size_t)args[" << cnt++ << "];" << std::endl
+     << "  const size_t end = (size_t)args[" << cnt++ << "];" << std::endl;
+
+  os << "  for (size_t row = begin; row < end; ++row) {" << std::endl
+     << "  " << acc_type << " acc = static_cast<" << acc_type << ">(";
+  switch (reduce_type) {
+    case Reduce::Sum:
+      os << "0";
+      break;
+    case Reduce::Prod:
+      os << "1";
+      break;
+    case Reduce::Max:
+    case Reduce::Min:
+      if (issubdtype(out.dtype(), floating)) {
+        os << (reduce_type == Reduce::Max ? "-" : "")
+           << "std::numeric_limits<float>::infinity()";
+      } else {
+        os << "std::numeric_limits<" << out_type << ">::"
+           << (reduce_type == Reduce::Max ? "min" : "max") << "()";
+      }
+      break;
+    default:
+      throw std::runtime_error("[compile] Unsupported fused reduction.");
+  }
+  os << ");" << std::endl;
+  os << "  for (size_t r = 0; r < row_size; ++r) {" << std::endl
+     << "  size_t index = row * row_size + r;" << std::endl;
+
+  // Locate the strided inputs from the coordinates of the element
+  if (!contiguous) {
+    for (auto& x : inputs) {
+      if (is_strided(x)) {
+        os << "  size_t loc_" << namer.get_name(x) << " = 0;" << std::endl;
+      }
+    }
+    os << "  for (int d = ndim - 1; d >= 0; --d) {" << std::endl
+       << "  size_t c = index % shape[d];" << std::endl
+       << "  index /= shape[d];" << std::endl;
+    for (auto& x : inputs) {
+      if (is_strided(x)) {
+        auto& xname = namer.get_name(x);
+        os << "  loc_" << xname << " += c * " << xname << "_strides[d];"
+           << std::endl;
+      }
+    }
+    os << "  }" << std::endl;
+  }
+
+  // Read the inputs in tmps
+  for (auto& x : inputs) {
+    auto& xname = namer.get_name(x);
+    os << "  " << get_type_string(x.dtype()) << " tmp_" << xname << " = ";
+    if (is_constant(x)) {
+      print_constant(os, x);
+    } else if (is_scalar(x)) {
+      os << xname << "[0]";
+    } else if (contiguous) {
+      os << xname << "[index]";
+    } else {
+      os << xname << "[loc_" << xname << "]";
+    }
+    os << ";" << std::endl;
+  }
+
+  // The elementwise computation, all but the final reduction
+  for (int i = 0; i < tape.size() - 1; ++i) {
+    auto& x = tape[i];
+    os << "  " << get_type_string(x.dtype()) << " tmp_" << namer.get_name(x)
+       << " = ";
+    if (is_static_cast(x.primitive())) {
+      os << "static_cast<" << get_type_string(x.dtype()) << ">(tmp_"
+         << namer.get_name(x.inputs()[0]) << ");" << std::endl;
+    } else {
+      print_op(os, x.primitive());
+      os << "()(";
+      for (int i = 0; i < x.inputs().size() - 1; i++) {
+        os << "tmp_" << namer.get_name(x.inputs()[i]) << ", ";
+      }
+      os << "tmp_" << namer.get_name(x.inputs().back()) << ");" << std::endl;
+    }
+  }
+
+  // Accumulate and write the row
+  os << "  " << acc_type << " val = static_cast<" << out_type << ">(tmp_"
+     << namer.get_name(reduced) << ");" << std::endl;
+  switch (reduce_type) {
+    case Reduce::Sum:
+      os << "  acc = acc + val;" << std::endl;
+      break;
+    case Reduce::Prod:
+      os << "  acc = acc * val;" << std::endl;
+      break;
+    case Reduce::Max:
+      os << "  acc = (acc > val) ? acc : val;" << std::endl;
+      break;
+    default:
+      os << "  acc = (acc < val) ? acc : val;" << std::endl;
+      break;
+  }
+  os << "  }" << std::endl
+     << "  " << namer.get_name(out) << "[row] = static_cast<" << out_type
+     << ">(acc);" << std::endl
+     << "  }" << std::endl
+     << "}" << std::endl;
+}
+
+// Evaluate the tape one primitive at a time while the fused kernel is being
+// built. The elementwise primitives are computed at the given shape from
+// inputs broadcast to it and a final reduction at the output shape.
+void eval_unfused(
+    const Stream& stream,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    const std::vector<array>& inputs_,
+    const std::vector<array>& outputs_,
+    const std::vector<array>& tape_,
+    const std::unordered_set<uintptr_t>& constant_ids_,
+    const std::vector<int>& shape) {
+  // Inputs are donated to the outputs as in the fused kernel, so donating
+  // the arguments of a compiled function doesn't depend on the kernel being
+  // ready. Whether they can be is checked before they are referenced here.
+  // Like the fused kernel, reductions don't reuse their inputs.
+  bool reduction = compiled_reduction(tape_) != nullptr;
+  std::vector<bool> donatable(inputs.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    auto& in = inputs[i];
+    donatable[i] = !reduction && in.is_donatable() &&
+        in.flags().row_contiguous &&
+        constant_ids_.find(inputs_[i].id()) == constant_ids_.end();
+  }
+
+  std::unordered_map<uintptr_t, array> values;
+  for (int i = 0; i < inputs.size(); i++) {
+    auto x = inputs[i];
+    if (x.shape() != shape) {
+      array bx(shape, x.dtype(), nullptr, {});
+      Broadcast(stream, shape).eval_cpu({x}, bx);
+      x = bx;
+    }
+    values.insert({inputs_[i].id(), x});
+  }
+
+  for (auto& t : tape_) {
+    std::vector<array> t_inputs;
+    for (auto& in : t.inputs()) {
+      t_inputs.push_back(values.at(in.id()));
+    }
+    if (is_static_cast(t.primitive()) && t_inputs[0].dtype() == t.dtype()) {
+      values.insert({t.id(), t_inputs[0]});
+      continue;
+    }
+    auto t_outputs = t.outputs();
+    std::vector<array> t_values;
+    bool reduce = typeid(t.primitive()) == typeid(Reduce);
+    for (auto& o : t_outputs) {
+      t_values.push_back(
+          array(reduce ? outputs[0].shape() : shape, o.dtype(), nullptr, {}));
+    }
+    t.primitive().eval_cpu(t_inputs, t_values);
+    for (int i = 0; i < t_outputs.size(); i++) {
+      values.insert({t_outputs[i].id(), t_values[i]});
+    }
+  }
+
+  // Outputs are never views of the inputs, compile relies on it to reuse
+  // the buffers of intermediates
+  auto is_input_buffer = [&inputs](const array& x) {
+    for (auto& in : inputs) {
+      if (in.buffer().ptr() == x.buffer().ptr()) {
+        return true;
+      }
+    }
+    return false;
+  };
+  // An input is not donated if an output is a view of it
+  for (int i = 0; i < inputs.size(); i++) {
+    for (auto& o : outputs_) {
+      auto& x = values.at(o.id());
+      donatable[i] =
+          donatable[i] && x.buffer().ptr() != inputs[i].buffer().ptr();
+    }
+  }
+  std::vector<int> donor(outputs.size(), -1);
+  for (int o = 0; o < outputs.size(); o++) {
+    for (int i = 0; i < inputs.size(); i++) {
+      if (donatable[i] && inputs[i].shape() == outputs[o].shape() &&
+          inputs[i].dtype() == outputs[o].dtype()) {
+        donatable[i] = false;
+        donor[o] = i;
+        break;
+      }
+    }
+  }
+
+  for (int i = 0; i < outputs.size(); i++) {
+    auto& x = values.at(outputs_[i].id());
+    if (donor[i] >= 0) {
+      outputs[i].copy_shared_buffer(inputs[donor[i]]);
+      copy_inplace(x, outputs[i], CopyType::General);
+    } else if (x.flags().row_contiguous && !is_input_buffer(x)) {
+      outputs[i].copy_shared_buffer(x);
+    } else {
+      copy(x, outputs[i], CopyType::General);
+    }
+  }
+}
+
+// Evaluate a fused reduction over the trailing axes of its elementwise input
+void eval_reduction(
+    const Stream& stream,
+    const std::string& kernel_lib,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    const std::vector<array>& inputs_,
+    const std::vector<array>& outputs_,
+    const std::vector<array>& tape_,
+    const std::unordered_set<uintptr_t>& constant_ids_) {
+  auto& out = outputs[0];
+  auto shape = compiled_reduction_shape(inputs);
+  size_t n_rows = out.size();
+  size_t row_size = 1;
+  for (auto ax : compiled_reduction(tape_)->axes()) {
+    row_size *= shape[ax];
+  }
+
+  // Row contiguous inputs are read with the flat index of the element
+  bool contiguous = true;
+  for (int i = 0; i < inputs.size(); i++) {
+    auto& x = inputs[i];
+    if (constant_ids_.find(inputs_[i].id()) != constant_ids_.end() ||
+        is_scalar(x)) {
+      continue;
+    }
+    contiguous &= x.flags().row_contiguous && x.shape() == shape;
+  }
+
+  auto kernel_name =
+      kernel_lib + (contiguous ? "_reduce_contiguous" : "_reduce_strided");
+  auto fn_ptr = compile(kernel_name, [&]() {
+    std::ostringstream kernel;
+    kernel << get_kernel_preamble() << std::endl;
+    print_custom_ops(kernel, tape_);
+    kernel << "extern \"C\"  {" << std::endl;
+    build_reduce_kernel(
+        kernel,
+        kernel_name,
+        inputs_,
+        outputs_,
+        tape_,
+        constant_ids_,
+        contiguous);
+    kernel << "}" << std::endl;
+    return kernel.str();
+  });
+
+  if (fn_ptr == nullptr) {
+    eval_unfused(
+        stream,
+        inputs,
+        outputs,
+        inputs_,
+        outputs_,
+        tape_,
+        constant_ids_,
+        shape);
+    return;
+  }
+
+  std::vector<void*> args;
+  std::vector<std::vector<size_t>> strides;
+  for (int i = 0; i < inputs.size(); i++) {
+    if (constant_ids_.find(inputs_[i].id()) != constant_ids_.end()) {
+      continue;
+    }
+    auto& x = inputs[i];
+    args.push_back((void*)x.data<void>());
+    if (!contiguous && !is_scalar(x)) {
+      strides.push_back(compiled_reduction_strides(x, shape));
+      args.push_back(strides.back().data());
+    }
+  }
+
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  args.push_back(out.data<void>());
+  if (!contiguous) {
+    args.push_back((void*)shape.data());
+    args.push_back((void*)shape.size());
+  }
+  args.push_back((void*)row_size);
+
+  auto fun = (void (*)(void**))fn_ptr;
+  parallel_for(
+      n_rows,
+      [&](size_t begin, size_t end) {
+        auto range_args = args;
+        range_args.push_back((void*)begin);
+        range_args.push_back((void*)end);
+        fun(range_args.data());
+      },
+      std::max<size_t>(
+          1, min_elements_per_thread / std::max<size_t>(row_size, 1)));
+}
+
 void Compiled::eval_cpu(
     const std::vector<array>& inputs,
     std::vector<array>& outputs) {
@@ -263,10 +818,64 @@ void Compiled::eval_cpu(
     kernel_lib_ = build_lib_name(inputs_, outputs_, tape_, constant_ids_);
   }
 
+  if (compiled_reduction(tape_)) {
+    eval_reduction(
+        stream(),
+        kernel_lib_,
+        inputs,
+        outputs,
+        inputs_,
+        outputs_,
+        tape_,
+        constant_ids_);
+    return;
+  }
+
   // Figure out which kernel we are using
   auto& shape = outputs[0].shape();
   bool contiguous = compiled_check_contiguity(inputs, shape);
 
+  // Get the kernel name from the lib
+  int ndim = shape.size();
+  auto kernel_name = kernel_lib_ + (contiguous ? "_contiguous" : "_strided_");
+  if (!contiguous) {
+    kernel_name += std::to_string(shape.size());
+  }
+
+  // Get the function, it is compiled in the background if it doesn't exist
+  auto fn_ptr = compile(kernel_name, [&]() {
+    std::ostringstream kernel;
+    kernel << get_kernel_preamble() << std::endl;
+    print_custom_ops(kernel, tape_);
+    kernel << "extern \"C\"  {" << std::endl;
+    build_kernel(
+        kernel,
+        kernel_name,
+        inputs_,
+        outputs_,
+        tape_,
+        constant_ids_,
+        contiguous,
+        ndim);
+    // Close extern "C"
+    kernel << "}" << std::endl;
+    return kernel.str();
+  });
+
+  // Run the primitives one by one until the kernel is ready
+  if (fn_ptr == nullptr) {
+    eval_unfused(
+        stream(),
+        inputs,
+        outputs,
+        inputs_,
+        outputs_,
+        tape_,
+        constant_ids_,
+        shape);
+    return;
+  }
+
   // Handle all broadcasting and collect function input arguments
   std::vector<void*> args;
   std::vector<std::vector<size_t>> strides;
@@ -307,37 +916,6 @@ void Compiled::eval_cpu(
     args.push_back(strides.back().data());
   }
 
-  // Get the kernel name from the lib
-  int ndim = shape.size();
-  auto kernel_name = kernel_lib_ + (contiguous ? "_contiguous" : "_strided_");
-  if (!contiguous) {
-    kernel_name += std::to_string(shape.size());
-  }
-
-  // Get the function
-  auto fn_ptr = compile(kernel_name);
-
-  // If it doesn't exist, compile it
-  if (fn_ptr == nullptr) {
-    std::ostringstream kernel;
-    kernel << get_kernel_preamble() << std::endl;
-    kernel << "extern \"C\"  {" << std::endl;
-    build_kernel(
-        kernel,
-        kernel_name,
-        inputs_,
-        outputs_,
-        tape_,
-        constant_ids_,
-        contiguous,
-        ndim);
-    // Close extern "C"
-    kernel << "}" << std::endl;
-
-    // Compile and get function pointer
-    fn_ptr = compile(kernel_name, kernel.str());
-  }
-
   compiled_allocate_outputs(
       inputs, outputs, inputs_, constant_ids_, contiguous, false);
 
@@ -346,11 +924,22 @@ void Compiled::eval_cpu(
   }
   if (!contiguous) {
     args.push_back((void*)outputs[0].shape().data());
-  } else {
-    args.push_back((void*)outputs[0].data_size());
   }
+
+  // Split the elements, or the first axis when strided, across threads
+  size_t size = contiguous ? outputs[0].data_size() : (ndim > 0 ? shape[0] : 1);
+  size_t inner_size = size == 0 ? 1 : outputs[0].size() / size;
   auto fun = (void (*)(void**))fn_ptr;
-  fun(args.data());
+  parallel_for(
+      size,
+      [&](size_t begin, size_t end) {
+        auto range_args = args;
+        range_args.push_back((void*)begin);
+        range_args.push_back((void*)end);
+        fun(range_args.data());
+      },
+      std::max<size_t>(
+          1, min_elements_per_thread / std::max<size_t>(inner_size, 1)));
 }
 
 } // namespace mlx::core
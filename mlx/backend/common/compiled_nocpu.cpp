@@ -1,6 +1,7 @@
 // Copyright © 2023-2024 Apple Inc.
 
 #include "mlx/backend/common/compiled.h"
+#include "mlx/compile.h"
 
 namespace mlx::core {
 
@@ -13,6 +14,8 @@ bool compile_available_for_device(const Device& device) {
 }
 } // namespace detail
 
+void preload_cpu_kernels() {}
+
 void Compiled::eval_cpu(
     const std::vector<array>& inputs,
     std::vector<array>& outputs) {
@@ -0,0 +1,207 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#if defined(MLX_USE_F16C) || defined(__F16C__) || defined(__AVX2__) || \
+    defined(__AVX512BF16__)
+#include <immintrin.h>
+#endif
+#if defined(MLX_USE_F16C) && !defined(__F16C__)
+#include <cpuid.h>
+#endif
+
+#include "mlx/types/half_types.h"
+
+namespace mlx::core {
+
+// The F16C conversions are built for the CPUs that have them and picked at
+// run time, unless the whole build already targets F16C
+#if defined(__F16C__)
+#define MLX_F16C_TARGET
+inline bool cpu_has_f16c() {
+  return true;
+}
+#elif defined(MLX_USE_F16C)
+#define MLX_F16C_TARGET __attribute__((target("avx,f16c")))
+inline bool cpu_has_f16c() {
+  static const bool has_f16c = []() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+      return false;
+    }
+    // The conversions use the AVX registers which the OS must also save
+    if (!(ecx & bit_F16C) || !(ecx & bit_AVX) || !(ecx & bit_OSXSAVE)) {
+      return false;
+    }
+    unsigned int xcr0, xcr0_high;
+    __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+    return (xcr0 & 6) == 6;
+  }();
+  return has_f16c;
+}
+#endif
+
+#if defined(MLX_F16C_TARGET)
+// Convert the leading multiple of 8 values and return how many were done
+MLX_F16C_TARGET inline size_t f16c_to_float(
+    const float16_t* src,
+    float* dst,
+    size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  return i;
+}
+
+MLX_F16C_TARGET inline size_t f16c_from_float(
+    const float* src,
+    float16_t* dst,
+    size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto h =
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+  }
+  return i;
+}
+#endif
+
+template <typename T>
+constexpr bool is_half_v =
+    std::is_same_v<T, float16_t> || std::is_same_v<T, bfloat16_t>;
+
+// Whether op can be applied to floats and returns a float
+template <typename Op, typename... Args>
+constexpr bool computes_in_float() {
+  if constexpr (std::is_invocable_v<Op, Args...>) {
+    return std::is_same_v<std::invoke_result_t<Op, Args...>, float>;
+  } else {
+    return false;
+  }
+}
+
+// Number of elements converted to float at a time by the half precision
+// kernels, small enough for the buffers to stay on the stack and in L1
+constexpr int half_block = 256;
+
+// Converts n values with the vector conversion instructions of the CPU when
+// it has them. On ARM the half types are native and the compiler vectorizes
+// the scalar loop.
+template <typename SrcT, typename DstT>
+void convert(const SrcT* src, DstT* dst, size_t n) {
+  size_t i = 0;
+#if defined(MLX_F16C_TARGET)
+  if constexpr (
+      std::is_same_v<SrcT, float16_t> && std::is_same_v<DstT, float>) {
+    if (cpu_has_f16c()) {
+      i = f16c_to_float(src, dst, n);
+    }
+  }
+  if constexpr (
+      std::is_same_v<SrcT, float> && std::is_same_v<DstT, float16_t>) {
+    if (cpu_has_f16c()) {
+      i = f16c_from_float(src, dst, n);
+    }
+  }
+#endif
+#if defined(__AVX2__)
+  if constexpr (
+      std::is_same_v<SrcT, bfloat16_t> && std::is_same_v<DstT, float>) {
+    for (; i + 8 <= n; i += 8) {
+      auto h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      auto f = _mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16);
+      _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(f));
+    }
+  }
+#endif
+#if defined(__AVX512BF16__)
+  if constexpr (
+      std::is_same_v<SrcT, float> && std::is_same_v<DstT, bfloat16_t>) {
+    for (; i + 16 <= n; i += 16) {
+      auto h = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(dst + i), reinterpret_cast<__m256i&>(h));
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = static_cast<DstT>(src[i]);
+  }
+}
+
+// Returns a pointer to n elements of x as floats, converting them into buf
+// unless they already are
+template <typename T>
+inline const float* load_chunk(const T* x, int n, float* buf) {
+  if constexpr (std::is_same_v<T, float>) {
+    return x;
+  } else {
+    convert(x, buf, n);
+    return buf;
+  }
+}
+
+// Applies op to n elements of a half precision vector. Blocks of the input
+// are converted to float in bulk and op runs on floats, which rounds once
+// per op like the scalar half operators do.
+template <typename T, typename Op>
+void half_unary(const T* a, T* dst, size_t n, Op& op) {
+  float x[half_block];
+  while (n > 0) {
+    int m = std::min(n, static_cast<size_t>(half_block));
+    convert(a, x, m);
+    for (int i = 0; i < m; i++) {
+      x[i] = op(x[i]);
+    }
+    convert(x, dst, m);
+    a += m;
+    dst += m;
+    n -= m;
+  }
+}
+
+// Applies op to n pairs of elements of two half precision vectors. A stride
+// of 0 broadcasts the first element of a or b.
+template <typename T, typename Op>
+void half_binary(
+    const T* a,
+    const T* b,
+    T* dst,
+    size_t n,
+    int a_stride,
+    int b_stride,
+    Op& op) {
+  float x[half_block];
+  float y[half_block];
+  float a_scalar = a_stride ? 0.0f : static_cast<float>(*a);
+  float b_scalar = b_stride ? 0.0f : static_cast<float>(*b);
+  while (n > 0) {
+    int m = std::min(n, static_cast<size_t>(half_block));
+    if (a_stride) {
+      convert(a, x, m);
+      a += m;
+    } else {
+      std::fill_n(x, m, a_scalar);
+    }
+    if (b_stride) {
+      convert(b, y, m);
+      b += m;
+    } else {
+      std::fill_n(y, m, b_scalar);
+    }
+    for (int i = 0; i < m; i++) {
+      x[i] = op(x[i], y[i]);
+    }
+    convert(x, dst, m);
+    dst += m;
+    n -= m;
+  }
+}
+
+} // namespace mlx::core
@@ -1,9 +1,12 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
 #include <numeric>
 
 #include "mlx/allocator.h"
+#include "mlx/backend/common/convert.h"
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
 
 namespace mlx::core {
 
@@ -13,126 +16,204 @@ template <typename SrcT, typename DstT>
 void copy_single(const array& src, array& dst) {
   auto val = static_cast<DstT>(src.data<SrcT>()[0]);
   auto dst_ptr = dst.data<DstT>();
-  for (int i = 0; i < dst.size(); ++i) {
-    dst_ptr[i] = val;
-  }
+  parallel_for(dst.size(), [&](size_t begin, size_t end) {
+    std::fill(dst_ptr + begin, dst_ptr + end, val);
+  });
 }
 
 template <typename SrcT, typename DstT>
 void copy_vector(const array& src, array& dst) {
   auto src_ptr = src.data<SrcT>();
   auto dst_ptr = dst.data<DstT>();
-  std::copy(src_ptr, src_ptr + src.data_size(), dst_ptr);
+  parallel_for(src.data_size(), [&](size_t begin, size_t end) {
+    if constexpr (is_half_v<SrcT> || is_half_v<DstT>) {
+      convert(src_ptr + begin, dst_ptr + begin, end - begin);
+    } else {
+      std::copy(src_ptr + begin, src_ptr + end, dst_ptr + begin);
+    }
+  });
 }
 
-template <typename SrcT, typename DstT, typename stride_t>
-void copy_general_dim1(
-    const array& src,
-    array& dst,
-    const std::vector<int>& data_shape,
-    const std::vector<stride_t>& i_strides,
-    int64_t i_offset) {
-  const SrcT* src_ptr = src.data<SrcT>();
-  DstT* dst_ptr = dst.data<DstT>();
-  stride_t src_idx = i_offset;
-  stride_t dst_idx = 0;
-  for (int i = 0; i < data_shape[0]; ++i) {
-    dst_ptr[dst_idx++] = static_cast<DstT>(src_ptr[src_idx]);
-    src_idx += i_strides[0];
+// Side of the square tiles used when a copy transposes the two innermost
+// axes so that the strided side of every tile stays in cache
+constexpr int copy_tile = 32;
+
+// Walks row major indices into shape keeping the matching offsets in the
+// source and the destination
+struct CopyIterator {
+  CopyIterator(
+      const std::vector<int>& shape,
+      const std::vector<int64_t>& i_strides,
+      const std::vector<int64_t>& o_strides,
+      size_t index)
+      : shape(shape),
+        i_strides(i_strides),
+        o_strides(o_strides),
+        pos(shape.size(), 0) {
+    for (int i = shape.size() - 1; i >= 0; i--) {
+      pos[i] = index % shape[i];
+      index /= shape[i];
+      i_loc += pos[i] * i_strides[i];
+      o_loc += pos[i] * o_strides[i];
+    }
   }
-}
 
-template <typename SrcT, typename DstT>
-inline void copy_general_dim1(const array& src, array& dst) {
-  return copy_general_dim1<SrcT, DstT, size_t>(
-      src, dst, src.shape(), src.strides(), 0);
-}
-
-template <typename SrcT, typename DstT, typename stride_t>
-void copy_general_dim2(
-    const array& src,
-    array& dst,
-    const std::vector<int>& data_shape,
-    const std::vector<stride_t>& i_strides,
-    int64_t i_offset) {
-  const SrcT* src_ptr = src.data<SrcT>();
-  DstT* dst_ptr = dst.data<DstT>();
-  stride_t src_idx = i_offset;
-  stride_t dst_idx = 0;
-  for (int i = 0; i < data_shape[0]; ++i) {
-    for (int j = 0; j < data_shape[1]; ++j) {
-      dst_ptr[dst_idx++] = static_cast<DstT>(src_ptr[src_idx]);
-      src_idx += i_strides[1];
+  void step() {
+    for (int i = shape.size() - 1; i >= 0; i--) {
+      i_loc += i_strides[i];
+      o_loc += o_strides[i];
+      if (++pos[i] < shape[i]) {
+        return;
+      }
+      i_loc -= i_strides[i] * shape[i];
+      o_loc -= o_strides[i] * shape[i];
+      pos[i] = 0;
     }
-    src_idx += i_strides[0] - i_strides[1] * data_shape[1];
   }
-}
+
+  const std::vector<int>& shape;
+  const std::vector<int64_t>& i_strides;
+  const std::vector<int64_t>& o_strides;
+  std::vector<int> pos;
+  int64_t i_loc{0};
+  int64_t o_loc{0};
+};
 
 template <typename SrcT, typename DstT>
-inline void copy_general_dim2(const array& src, array& dst) {
-  return copy_general_dim2<SrcT, DstT, size_t>(
-      src, dst, src.shape(), src.strides(), 0);
+void copy_row(
+    const SrcT* src,
+    DstT* dst,
+    int n,
+    int64_t i_stride,
+    int64_t o_stride) {
+  if (i_stride == 1 && o_stride == 1) {
+    for (int i = 0; i < n; i++) {
+      dst[i] = static_cast<DstT>(src[i]);
+    }
+  } else if (i_stride == 0 && o_stride == 1) {
+    std::fill_n(dst, n, static_cast<DstT>(*src));
+  } else {
+    for (int i = 0; i < n; i++) {
+      dst[i * o_stride] = static_cast<DstT>(src[i * i_stride]);
+    }
+  }
 }
 
-template <typename SrcT, typename DstT, typename stride_t>
-void copy_general_dim3(
-    const array& src,
-    array& dst,
-    const std::vector<int>& data_shape,
-    const std::vector<stride_t>& i_strides,
-    int64_t i_offset) {
-  const SrcT* src_ptr = src.data<SrcT>();
-  DstT* dst_ptr = dst.data<DstT>();
-  stride_t src_idx = i_offset;
-  stride_t dst_idx = 0;
-  for (int i = 0; i < data_shape[0]; ++i) {
-    for (int j = 0; j < data_shape[1]; ++j) {
-      for (int k = 0; k < data_shape[2]; ++k) {
-        dst_ptr[dst_idx++] = static_cast<DstT>(src_ptr[src_idx]);
-        src_idx += i_strides[2];
+// Copies n_rows (at most copy_tile) rows of n_cols one tile at a time
+template <typename SrcT, typename DstT>
+void copy_tiled_rows(
+    const SrcT* src,
+    DstT* dst,
+    int n_rows,
+    int n_cols,
+    int64_t i_row_stride,
+    int64_t i_col_stride,
+    int64_t o_row_stride,
+    int64_t o_col_stride) {
+  for (int c0 = 0; c0 < n_cols; c0 += copy_tile) {
+    int c1 = std::min(n_cols, c0 + copy_tile);
+    for (int r = 0; r < n_rows; r++) {
+      const SrcT* s = src + r * i_row_stride;
+      DstT* d = dst + r * o_row_stride;
+      for (int c = c0; c < c1; c++) {
+        d[c * o_col_stride] = static_cast<DstT>(s[c * i_col_stride]);
       }
-      src_idx += i_strides[1] - i_strides[2] * data_shape[2];
     }
-    src_idx += i_strides[0] - i_strides[1] * data_shape[1];
   }
 }
 
+/* Copies the virtual array with data_shape and i_strides in src to the one
+ * with o_strides in dst. Size one axes are dropped and axes contiguous in
+ * both arrays are merged. What is left is copied one innermost row at a
+ * time or, when the two innermost axes are transposed between the source
+ * and the destination, in square tiles. Rows and bands of tiles are split
+ * across the CPU thread pool.
+ * */
 template <typename SrcT, typename DstT>
-inline void copy_general_dim3(const array& src, array& dst) {
-  return copy_general_dim3<SrcT, DstT, size_t>(
-      src, dst, src.shape(), src.strides(), 0);
-}
-
-template <typename SrcT, typename DstT, typename stride_t>
-void copy_general_dim4(
-    const array& src,
-    array& dst,
+void copy_strided(
+    const SrcT* src,
+    DstT* dst,
     const std::vector<int>& data_shape,
-    const std::vector<stride_t>& i_strides,
-    int64_t i_offset) {
-  const SrcT* src_ptr = src.data<SrcT>();
-  DstT* dst_ptr = dst.data<DstT>();
-  stride_t src_idx = i_offset;
-  stride_t dst_idx = 0;
-  for (int i = 0; i < data_shape[0]; ++i) {
-    for (int j = 0; j < data_shape[1]; ++j) {
-      for (int k = 0; k < data_shape[2]; ++k) {
-        for (int ii = 0; ii < data_shape[3]; ++ii) {
-          dst_ptr[dst_idx++] = static_cast<DstT>(src_ptr[src_idx]);
-          src_idx += i_strides[3];
-        }
-        src_idx += i_strides[2] - i_strides[3] * data_shape[3];
-      }
-      src_idx += i_strides[1] - i_strides[2] * data_shape[2];
+    const std::vector<int64_t>& i_strides,
+    const std::vector<int64_t>& o_strides) {
+  std::vector<int> shape;
+  std::vector<int64_t> is;
+  std::vector<int64_t> os;
+  for (int i = 0; i < data_shape.size(); i++) {
+    if (data_shape[i] == 0) {
+      return;
+    }
+    if (data_shape[i] > 1) {
+      shape.push_back(data_shape[i]);
+      is.push_back(i_strides[i]);
+      os.push_back(o_strides[i]);
     }
-    src_idx += i_strides[0] - i_strides[1] * data_shape[1];
   }
-}
+  if (shape.empty()) {
+    *dst = static_cast<DstT>(*src);
+    return;
+  }
+  auto [cshape, cstrides] = collapse_contiguous_dims(
+      shape, std::vector<std::vector<int64_t>>{std::move(is), std::move(os)});
+  is = std::move(cstrides[0]);
+  os = std::move(cstrides[1]);
+  int ndim = cshape.size();
+
+  if (ndim == 1) {
+    parallel_for(cshape[0], [&](size_t begin, size_t end) {
+      copy_row(
+          src + begin * is[0], dst + begin * os[0], end - begin, is[0], os[0]);
+    });
+    return;
+  }
 
-template <typename SrcT, typename DstT>
-inline void copy_general_dim4(const array& src, array& dst) {
-  return copy_general_dim4<SrcT, DstT, size_t>(
-      src, dst, src.shape(), src.strides(), 0);
+  int n_cols = cshape[ndim - 1];
+  int n_rows = cshape[ndim - 2];
+  auto transposed = [n = ndim](const auto& a, const auto& b) {
+    return a[n - 1] != 1 && a[n - 2] == 1 && b[n - 1] == 1;
+  };
+  bool tiled = n_rows >= copy_tile && n_cols >= copy_tile &&
+      (transposed(is, os) || transposed(os, is));
+
+  // Every task copies one row or one band of copy_tile rows
+  int inner_dims = tiled ? 2 : 1;
+  std::vector<int> outer_shape(cshape.begin(), cshape.end() - inner_dims);
+  std::vector<int64_t> outer_is(is.begin(), is.end() - inner_dims);
+  std::vector<int64_t> outer_os(os.begin(), os.end() - inner_dims);
+  size_t n_outer = std::accumulate(
+      outer_shape.begin(), outer_shape.end(), size_t(1), std::multiplies<>());
+  int n_bands = tiled ? (n_rows + copy_tile - 1) / copy_tile : 1;
+  size_t task_size = tiled ? size_t(copy_tile) * n_cols : n_cols;
+
+  parallel_for(
+      n_outer * n_bands,
+      [&](size_t begin, size_t end) {
+        CopyIterator it(outer_shape, outer_is, outer_os, begin / n_bands);
+        for (size_t task = begin; task < end; task++) {
+          const SrcT* s = src + it.i_loc;
+          DstT* d = dst + it.o_loc;
+          if (tiled) {
+            int band = task % n_bands;
+            int r0 = band * copy_tile;
+            copy_tiled_rows(
+                s + r0 * is[ndim - 2],
+                d + r0 * os[ndim - 2],
+                std::min(copy_tile, n_rows - r0),
+                n_cols,
+                is[ndim - 2],
+                is[ndim - 1],
+                os[ndim - 2],
+                os[ndim - 1]);
+            if (band == n_bands - 1) {
+              it.step();
+            }
+          } else {
+            copy_row(s, d, n_cols, is[ndim - 1], os[ndim - 1]);
+            it.step();
+          }
+        }
+      },
+      std::max<size_t>(1, min_elements_per_thread / task_size));
 }
 
 template <typename SrcT, typename DstT, typename stride_t>
@@ -142,31 +223,19 @@ void copy_general(
     const std::vector<int>& data_shape,
     const std::vector<stride_t>& i_strides,
     int64_t i_offset) {
-  switch (src.ndim()) {
-    case 1:
-      copy_general_dim1<SrcT, DstT, stride_t>(
-          src, dst, data_shape, i_strides, i_offset);
-      return;
-    case 2:
-      copy_general_dim2<SrcT, DstT, stride_t>(
-          src, dst, data_shape, i_strides, i_offset);
-      return;
-    case 3:
-      copy_general_dim3<SrcT, DstT, stride_t>(
-          src, dst, data_shape, i_strides, i_offset);
-      return;
-    case 4:
-      copy_general_dim4<SrcT, DstT, stride_t>(
-          src, dst, data_shape, i_strides, i_offset);
-      return;
-  }
-
-  auto src_ptr = src.data<SrcT>() + i_offset;
-  auto dst_ptr = dst.data<DstT>();
-  for (size_t i = 0; i < dst.size(); ++i) {
-    stride_t src_elem = elem_to_loc(i, data_shape, i_strides);
-    dst_ptr[i] = static_cast<DstT>(src_ptr[src_elem]);
+  // The destination is row contiguous
+  std::vector<int64_t> o_strides(data_shape.size());
+  int64_t size = 1;
+  for (int i = data_shape.size() - 1; i >= 0; i--) {
+    o_strides[i] = size;
+    size *= data_shape[i];
   }
+  copy_strided(
+      src.data<SrcT>() + i_offset,
+      dst.data<DstT>(),
+      data_shape,
+      std::vector<int64_t>(i_strides.begin(), i_strides.end()),
+      o_strides);
 }
 
 template <typename SrcT, typename DstT>
@@ -188,41 +257,6 @@ inline void copy_general(
       src, dst, data_shape, i_strides, i_offset);
 }
 
-template <typename SrcT, typename DstT, typename stride_t, int D>
-inline void copy_general_general_dims(
-    const array& src,
-    array& dst,
-    const std::vector<int>& data_shape,
-    const std::vector<stride_t>& i_strides,
-    const std::vector<stride_t>& o_strides,
-    stride_t i_offset,
-    stride_t o_offset) {
-  if constexpr (D > 1) {
-    int axis = src.ndim() - D;
-    auto stride_src = i_strides[axis];
-    auto stride_dst = o_strides[axis];
-    auto N = data_shape[axis];
-    for (int i = 0; i < N; i++) {
-      copy_general_general_dims<SrcT, DstT, stride_t, D - 1>(
-          src, dst, data_shape, i_strides, o_strides, i_offset, o_offset);
-      i_offset += stride_src;
-      o_offset += stride_dst;
-    }
-  } else {
-    int axis = src.ndim() - 1;
-    auto stride_src = i_strides[axis];
-    auto stride_dst = o_strides[axis];
-    auto N = data_shape[axis];
-    const SrcT* src_ptr = src.data<SrcT>() + i_offset;
-    DstT* dst_ptr = dst.data<DstT>() + o_offset;
-    for (int i = 0; i < N; i++) {
-      *dst_ptr = static_cast<DstT>(*src_ptr);
-      src_ptr += stride_src;
-      dst_ptr += stride_dst;
-    }
-  }
-}
-
 template <typename SrcT, typename DstT, typename stride_t>
 void copy_general_general(
     const array& src,
@@ -232,37 +266,12 @@ void copy_general_general(
     const std::vector<stride_t>& o_strides,
     stride_t i_offset,
     stride_t o_offset) {
-  switch (src.ndim()) {
-    case 1:
-      copy_general_general_dims<SrcT, DstT, stride_t, 1>(
-          src, dst, data_shape, i_strides, o_strides, i_offset, o_offset);
-      return;
-    case 2:
-      copy_general_general_dims<SrcT, DstT, stride_t, 2>(
-          src, dst, data_shape, i_strides, o_strides, i_offset, o_offset);
-      return;
-    case 3:
-      copy_general_general_dims<SrcT, DstT, stride_t, 3>(
-          src, dst, data_shape, i_strides, o_strides, i_offset, o_offset);
-      return;
-    case 4:
-      copy_general_general_dims<SrcT, DstT, stride_t, 4>(
-          src, dst, data_shape, i_strides, o_strides, i_offset, o_offset);
-      return;
-    case 5:
-      copy_general_general_dims<SrcT, DstT, stride_t, 5>(
-          src, dst, data_shape, i_strides, o_strides, i_offset, o_offset);
-      return;
-  }
-
-  int size = std::accumulate(
-      data_shape.end() - 5, data_shape.end(), 1, std::multiplies<int>());
-  for (int i = 0; i < src.size(); i += size) {
-    stride_t src_offset = i_offset + elem_to_loc(i, data_shape, i_strides);
-    stride_t dst_offset = o_offset + elem_to_loc(i, dst.shape(), o_strides);
-    copy_general_general_dims<SrcT, DstT, stride_t, 5>(
-        src, dst, data_shape, i_strides, o_strides, src_offset, dst_offset);
-  }
+  copy_strided(
+      src.data<SrcT>() + i_offset,
+      dst.data<DstT>() + o_offset,
+      data_shape,
+      std::vector<int64_t>(i_strides.begin(), i_strides.end()),
+      std::vector<int64_t>(o_strides.begin(), o_strides.end()));
 }
 
 template <typename SrcT, typename DstT>
@@ -394,6 +403,10 @@ void copy(const array& src, array& dst, CopyType ctype) {
     case CopyType::Vector:
       if (src.is_donatable() && src.itemsize() == dst.itemsize()) {
         dst.copy_shared_buffer(src);
+        // The buffer already holds the data if the types match
+        if (src.dtype() == dst.dtype()) {
+          return;
+        }
       } else {
         auto size = src.data_size();
         dst.set_data(
@@ -1,14 +1,11 @@
 // Copyright © 2023-2024 Apple Inc.
 
-#ifdef ACCELERATE_NEW_LAPACK
-#include <Accelerate/Accelerate.h>
-#else
-#include <cblas.h>
-#endif
 #include <cstring>
+#include <type_traits>
 
 #include "mlx/array.h"
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/gemm.h"
 #include "mlx/backend/common/utils.h"
 #include "mlx/primitives.h"
 
@@ -43,8 +40,14 @@ DEFAULT(AsStrided)
 DEFAULT(Broadcast)
 DEFAULT(BlockMaskedMM)
 DEFAULT(GatherMM)
+DEFAULT(SampledMM)
+DEFAULT(SparseMM)
+DEFAULT(Sparse24Matmul)
+DEFAULT(Fp8Matmul)
 DEFAULT(GatherQMM)
 DEFAULT_MULTI(DivMod)
+DEFAULT_MULTI(MatmulVJP)
+DEFAULT_MULTI(CacheAppend)
 DEFAULT(Ceil)
 DEFAULT(Concatenate)
 DEFAULT(Conjugate)
@@ -54,6 +57,7 @@ DEFAULT(Cos)
 DEFAULT(Cosh)
 DEFAULT_MULTI(CustomVJP)
 DEFAULT_MULTI(Depends)
+DEFAULT(Dequantize)
 DEFAULT(Divide)
 DEFAULT(NumberOfElements)
 DEFAULT(Remainder)
@@ -68,6 +72,7 @@ DEFAULT(Full)
 DEFAULT(Gather)
 DEFAULT(Greater)
 DEFAULT(GreaterEqual)
+DEFAULT(Hadamard)
 DEFAULT(Less)
 DEFAULT(LessEqual)
 DEFAULT(Load)
@@ -77,6 +82,7 @@ DEFAULT(LogicalNot)
 DEFAULT(LogicalAnd)
 DEFAULT(LogicalOr)
 DEFAULT(LogAddExp)
+DEFAULT(LogSumExp)
 DEFAULT(Maximum)
 DEFAULT(Minimum)
 DEFAULT(Multiply)
@@ -86,13 +92,18 @@ DEFAULT(Pad)
 DEFAULT(Partition)
 DEFAULT(Power)
 DEFAULT_MULTI(QRF)
+DEFAULT_MULTI(Quantize)
 DEFAULT(QuantizedMatmul)
 DEFAULT(RandomBits)
+DEFAULT(RandomNormal)
+DEFAULT(RandomDropout)
 DEFAULT(Reduce)
 DEFAULT(Reshape)
 DEFAULT(Round)
 DEFAULT(Scan)
 DEFAULT(Scatter)
+DEFAULT(SegmentedReduce)
+DEFAULT(SegmentedScan)
 DEFAULT(Select)
 DEFAULT(Sigmoid)
 DEFAULT(Sign)
@@ -113,6 +124,9 @@ DEFAULT(Tanh)
 DEFAULT(Transpose)
 DEFAULT(Inverse)
 DEFAULT(Cholesky)
+DEFAULT_MULTI(Eigh)
+DEFAULT(Solve)
+DEFAULT(SolveTriangular)
 
 namespace {
 
@@ -146,45 +160,57 @@ inline void matmul_common_general(
     return;
   }
   if (K == 0) {
-    std::memset(static_cast<void*>(out.data<float>()), 0, out.nbytes());
+    std::memset(out.data<void>(), 0, out.nbytes());
     return;
   }
 
-  for (int i = 0; i < (a.size() / (M * K)); ++i) {
-    cblas_sgemm(
-        CblasRowMajor,
-        a_transposed ? CblasTrans : CblasNoTrans, // transA
-        b_transposed ? CblasTrans : CblasNoTrans, // transB
-        M,
-        N,
-        K,
-        alpha, // alpha
-        a.data<float>() + elem_to_loc(M * K * i, a.shape(), a.strides()),
-        lda,
-        b.data<float>() + elem_to_loc(K * N * i, b.shape(), b.strides()),
-        ldb,
-        beta, // beta
-        out.data<float>() + M * N * i,
-        out.shape(-1) // ldc
-    );
+  auto batched_gemm = [&](auto* out_ptr) {
+    using T = std::remove_pointer_t<decltype(out_ptr)>;
+    for (int i = 0; i < (a.size() / (M * K)); ++i) {
+      gemm<T>(
+          a_transposed,
+          b_transposed,
+          M,
+          N,
+          K,
+          alpha,
+          a.data<T>() + elem_to_loc(M * K * i, a.shape(), a.strides()),
+          lda,
+          b.data<T>() + elem_to_loc(K * N * i, b.shape(), b.strides()),
+          ldb,
+          beta,
+          out_ptr + M * N * i,
+          out.shape(-1) // ldc
+      );
+    }
+  };
+  switch (out.dtype()) {
+    case float32:
+      return batched_gemm(out.data<float>());
+    case float16:
+      return batched_gemm(out.data<float16_t>());
+    case bfloat16:
+      return batched_gemm(out.data<bfloat16_t>());
+    default:
+      break;
   }
 }
 
 } // namespace
 
 void Matmul::eval_cpu(const std::vector<array>& inputs, array& out) {
-  if (out.dtype() != float32) {
+  if (!issubdtype(out.dtype(), floating)) {
     throw std::runtime_error(
-        "[Matmul::eval_cpu] Currently only supports float32.");
+        "[Matmul::eval_cpu] Currently only supports floating point types.");
   }
   out.set_data(allocator::malloc_or_wait(out.nbytes()));
   return matmul_common_general(inputs[0], inputs[1], out);
 }
 
 void AddMM::eval_cpu(const std::vector<array>& inputs, array& out) {
-  if (out.dtype() != float32) {
+  if (!issubdtype(out.dtype(), floating)) {
     throw std::runtime_error(
-        "[AddMM::eval_cpu] Currently only supports float32.");
+        "[AddMM::eval_cpu] Currently only supports floating point types.");
   }
 
   // Fill output with C
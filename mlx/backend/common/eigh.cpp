@@ -0,0 +1,167 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/allocator.h"
+#include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
+#include "mlx/primitives.h"
+
+#ifdef ACCELERATE_NEW_LAPACK
+#include <Accelerate/Accelerate.h>
+#else
+#include <lapack.h>
+#endif
+
+namespace mlx::core {
+
+namespace {
+
+// Delegate to the symmetric eigensolver taking into account differences in
+// LAPACK implementations (how to pass the 'jobz' and 'uplo' strings to
+// fortran).
+int ssyevd_wrapper(
+    char jobz,
+    char uplo,
+    float* matrix,
+    float* w,
+    int N,
+    float* work,
+    int lwork,
+    int* iwork,
+    int liwork) {
+  int info;
+
+#ifdef LAPACK_FORTRAN_STRLEN_END
+  ssyevd_(
+      /* jobz = */ &jobz,
+      /* uplo = */ &uplo,
+      /* n = */ &N,
+      /* a = */ matrix,
+      /* lda = */ &N,
+      /* w = */ w,
+      /* work = */ work,
+      /* lwork = */ &lwork,
+      /* iwork = */ iwork,
+      /* liwork = */ &liwork,
+      /* info = */ &info,
+      /* jobz_len = */ static_cast<size_t>(1),
+      /* uplo_len = */ static_cast<size_t>(1));
+#else
+  ssyevd_(
+      /* jobz = */ &jobz,
+      /* uplo = */ &uplo,
+      /* n = */ &N,
+      /* a = */ matrix,
+      /* lda = */ &N,
+      /* w = */ w,
+      /* work = */ work,
+      /* lwork = */ &lwork,
+      /* iwork = */ iwork,
+      /* liwork = */ &liwork,
+      /* info = */ &info);
+#endif
+
+  return info;
+}
+
+} // namespace
+
+void eigh_impl(
+    const array& a,
+    array& w,
+    array* v,
+    char uplo,
+    bool compute_eigenvectors) {
+  // LAPACK sees the transpose of the row-major input so the lower triangle
+  // for us is the upper triangle for LAPACK. The eigenvectors come back as
+  // the columns of a column-major matrix and are transposed to row-major.
+  char lapack_uplo = (uplo == 'L') ? 'U' : 'L';
+  char jobz = compute_eigenvectors ? 'V' : 'N';
+
+  const int N = a.shape(-1);
+  const size_t num_matrices = N > 0 ? a.size() / (size_t(N) * N) : 0;
+
+  // The decomposition is computed in place on a contiguous copy
+  array in(a.shape(), float32, nullptr, {});
+  copy(a, in, a.flags().row_contiguous ? CopyType::Vector : CopyType::General);
+  w.set_data(allocator::malloc_or_wait(w.nbytes()));
+  if (num_matrices == 0) {
+    if (v) {
+      v->set_data(allocator::malloc_or_wait(v->nbytes()));
+    }
+    return;
+  }
+
+  // Query the workspace sizes
+  float optimal_work;
+  int optimal_iwork;
+  ssyevd_wrapper(
+      jobz,
+      lapack_uplo,
+      nullptr,
+      nullptr,
+      N,
+      &optimal_work,
+      -1,
+      &optimal_iwork,
+      -1);
+  int lwork = optimal_work;
+  int liwork = optimal_iwork;
+
+  size_t grain =
+      std::max<size_t>(1, min_elements_per_thread / (size_t(N) * N * N));
+  parallel_for(
+      num_matrices,
+      [&](size_t begin, size_t end) {
+        auto work =
+            array::Data{allocator::malloc_or_wait(sizeof(float) * lwork)};
+        auto iwork =
+            array::Data{allocator::malloc_or_wait(sizeof(int) * liwork)};
+        for (size_t i = begin; i < end; i++) {
+          int info = ssyevd_wrapper(
+              jobz,
+              lapack_uplo,
+              in.data<float>() + size_t(N) * N * i,
+              w.data<float>() + size_t(N) * i,
+              N,
+              static_cast<float*>(work.buffer.raw_ptr()),
+              lwork,
+              static_cast<int*>(iwork.buffer.raw_ptr()),
+              liwork);
+          if (info != 0) {
+            std::stringstream msg;
+            msg << "[eigh] Eigendecomposition failed with error code " << info;
+            throw std::runtime_error(msg.str());
+          }
+        }
+      },
+      grain);
+
+  if (v) {
+    v->set_data(allocator::malloc_or_wait(v->nbytes()));
+    float* src = in.data<float>();
+    float* dst = v->data<float>();
+    for (size_t i = 0; i < num_matrices; i++) {
+      for (int r = 0; r < N; r++) {
+        for (int c = 0; c < N; c++) {
+          dst[r * N + c] = src[c * N + r];
+        }
+      }
+      src += size_t(N) * N;
+      dst += size_t(N) * N;
+    }
+  }
+}
+
+void Eigh::eval(const std::vector<array>& inputs, std::vector<array>& outputs) {
+  if (inputs[0].dtype() != float32) {
+    throw std::runtime_error("[Eigh::eval] only supports float32.");
+  }
+  eigh_impl(
+      inputs[0],
+      outputs[0],
+      compute_eigenvectors_ ? &outputs[1] : nullptr,
+      uplo_,
+      compute_eigenvectors_);
+}
+
+} // namespace mlx::core
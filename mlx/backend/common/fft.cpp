@@ -5,6 +5,7 @@
 #include "mlx/3rdparty/pocketfft.h"
 #include "mlx/allocator.h"
 #include "mlx/primitives.h"
+#include "mlx/threadpool.h"
 
 namespace mlx::core {
 
@@ -38,6 +39,11 @@ void FFT::eval(const std::vector<array>& inputs, array& out) {
         });
     scale /= nelem;
   }
+
+  // pocketfft splits the transforms along the non-FFT axes across its own
+  // workers and only uses as many as the batch can keep busy.
+  size_t nthreads = ThreadPool::in_worker() ? 1 : cpu_threads();
+
   if (in.dtype() == complex64 && out.dtype() == complex64) {
     auto in_ptr =
         reinterpret_cast<const std::complex<float>*>(in.data<complex64_t>());
@@ -51,7 +57,8 @@ void FFT::eval(const std::vector<array>& inputs, array& out) {
         !inverse_,
         in_ptr,
         out_ptr,
-        scale);
+        scale,
+        nthreads);
   } else if (in.dtype() == float32 && out.dtype() == complex64) {
     auto in_ptr = in.data<float>();
     auto out_ptr =
@@ -64,7 +71,8 @@ void FFT::eval(const std::vector<array>& inputs, array& out) {
         !inverse_,
         in_ptr,
         out_ptr,
-        scale);
+        scale,
+        nthreads);
   } else if (in.dtype() == complex64 && out.dtype() == float32) {
     auto in_ptr =
         reinterpret_cast<const std::complex<float>*>(in.data<complex64_t>());
@@ -77,7 +85,8 @@ void FFT::eval(const std::vector<array>& inputs, array& out) {
         !inverse_,
         in_ptr,
         out_ptr,
-        scale);
+        scale,
+        nthreads);
   } else {
     throw std::runtime_error(
         "[FFT] Received unexpected input and output type combination.");
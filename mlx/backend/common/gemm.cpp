@@ -0,0 +1,234 @@
+// Copyright © 2024 Apple Inc.
+
+#ifdef ACCELERATE_NEW_LAPACK
+#include <Accelerate/Accelerate.h>
+#else
+#include <cblas.h>
+#endif
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "mlx/backend/common/gemm.h"
+#include "mlx/threadpool.h"
+#include "mlx/types/half_types.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Register tile of the micro kernel
+constexpr size_t MR = 4;
+constexpr size_t NR = 16;
+
+// Cache blocks. Every task computes an MC x NC tile of c and packs KC deep
+// panels of a and b for it.
+constexpr size_t MC = 64;
+constexpr size_t NC = 128;
+constexpr size_t KC = 256;
+
+// Products smaller than this many flops run on the calling thread
+constexpr size_t min_parallel_flops = 1 << 21;
+
+// Packs rows [m0, m0 + mc) and columns [k0, k0 + kc) of op(a) in panels of MR
+// rows stored column by column, padding the last panel with zeros.
+template <typename T>
+void pack_a(
+    const T* a,
+    size_t lda,
+    bool transpose,
+    size_t m0,
+    size_t mc,
+    size_t k0,
+    size_t kc,
+    float* dst) {
+  for (size_t ip = 0; ip < mc; ip += MR) {
+    size_t rows = std::min(MR, mc - ip);
+    for (size_t k = 0; k < kc; k++) {
+      for (size_t i = 0; i < MR; i++) {
+        size_t m = m0 + ip + i;
+        dst[i] = i >= rows ? 0.0f
+            : transpose    ? static_cast<float>(a[(k0 + k) * lda + m])
+                           : static_cast<float>(a[m * lda + k0 + k]);
+      }
+      dst += MR;
+    }
+  }
+}
+
+// Packs rows [k0, k0 + kc) and columns [n0, n0 + nc) of op(b) in panels of NR
+// columns stored row by row, padding the last panel with zeros.
+template <typename T>
+void pack_b(
+    const T* b,
+    size_t ldb,
+    bool transpose,
+    size_t k0,
+    size_t kc,
+    size_t n0,
+    size_t nc,
+    float* dst) {
+  for (size_t jp = 0; jp < nc; jp += NR) {
+    size_t cols = std::min(NR, nc - jp);
+    for (size_t k = 0; k < kc; k++) {
+      for (size_t j = 0; j < NR; j++) {
+        size_t n = n0 + jp + j;
+        dst[j] = j >= cols ? 0.0f
+            : transpose    ? static_cast<float>(b[n * ldb + k0 + k])
+                           : static_cast<float>(b[(k0 + k) * ldb + n]);
+      }
+      dst += NR;
+    }
+  }
+}
+
+// Accumulates the product of an MR x kc panel of a and a kc x NR panel of b
+// into c. The accumulators fit in registers and the inner loop vectorizes.
+inline void
+micro_kernel(size_t kc, const float* a, const float* b, float* c, size_t ldc) {
+  float acc[MR][NR] = {};
+  for (size_t k = 0; k < kc; k++) {
+    for (size_t i = 0; i < MR; i++) {
+      for (size_t j = 0; j < NR; j++) {
+        acc[i][j] += a[i] * b[j];
+      }
+    }
+    a += MR;
+    b += NR;
+  }
+  for (size_t i = 0; i < MR; i++) {
+    for (size_t j = 0; j < NR; j++) {
+      c[i * ldc + j] += acc[i][j];
+    }
+  }
+}
+
+template <typename T>
+void packed_gemm(
+    bool transpose_a,
+    bool transpose_b,
+    size_t M,
+    size_t N,
+    size_t K,
+    float alpha,
+    const T* a,
+    size_t lda,
+    const T* b,
+    size_t ldb,
+    float beta,
+    T* c,
+    size_t ldc) {
+  size_t m_tiles = (M + MC - 1) / MC;
+  size_t n_tiles = (N + NC - 1) / NC;
+
+  auto compute_tile = [&](int tile) {
+    size_t m0 = (tile / n_tiles) * MC;
+    size_t n0 = (tile % n_tiles) * NC;
+    size_t mc = std::min(MC, M - m0);
+    size_t nc = std::min(NC, N - n0);
+
+    std::vector<float> a_packed(MC * KC);
+    std::vector<float> b_packed(KC * NC);
+    std::vector<float> acc(MC * NC, 0.0f);
+    for (size_t k0 = 0; k0 < K; k0 += KC) {
+      size_t kc = std::min(KC, K - k0);
+      pack_a(a, lda, transpose_a, m0, mc, k0, kc, a_packed.data());
+      pack_b(b, ldb, transpose_b, k0, kc, n0, nc, b_packed.data());
+      for (size_t ip = 0; ip < mc; ip += MR) {
+        for (size_t jp = 0; jp < nc; jp += NR) {
+          micro_kernel(
+              kc,
+              a_packed.data() + ip * kc,
+              b_packed.data() + jp * kc,
+              acc.data() + ip * NC + jp,
+              NC);
+        }
+      }
+    }
+
+    for (size_t i = 0; i < mc; i++) {
+      T* c_row = c + (m0 + i) * ldc + n0;
+      const float* acc_row = acc.data() + i * NC;
+      if (beta == 0.0f) {
+        for (size_t j = 0; j < nc; j++) {
+          c_row[j] = static_cast<T>(alpha * acc_row[j]);
+        }
+      } else {
+        for (size_t j = 0; j < nc; j++) {
+          c_row[j] = static_cast<T>(
+              alpha * acc_row[j] + beta * static_cast<float>(c_row[j]));
+        }
+      }
+    }
+  };
+
+  int n_tasks = m_tiles * n_tiles;
+  if (n_tasks > 1 && 2 * M * N * K >= min_parallel_flops) {
+    cpu_thread_pool().parallel_for(n_tasks, compute_tile);
+  } else {
+    for (int t = 0; t < n_tasks; t++) {
+      compute_tile(t);
+    }
+  }
+}
+
+} // namespace
+
+template <typename T>
+void gemm(
+    bool transpose_a,
+    bool transpose_b,
+    size_t M,
+    size_t N,
+    size_t K,
+    float alpha,
+    const T* a,
+    size_t lda,
+    const T* b,
+    size_t ldb,
+    float beta,
+    T* c,
+    size_t ldc) {
+  if constexpr (std::is_same_v<T, float>) {
+    cblas_sgemm(
+        CblasRowMajor,
+        transpose_a ? CblasTrans : CblasNoTrans,
+        transpose_b ? CblasTrans : CblasNoTrans,
+        M,
+        N,
+        K,
+        alpha,
+        a,
+        lda,
+        b,
+        ldb,
+        beta,
+        c,
+        ldc);
+  } else {
+    packed_gemm(
+        transpose_a, transpose_b, M, N, K, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+}
+
+#define instantiate_gemm(T)   \
+  template void gemm<T>(      \
+      bool,                   \
+      bool,                   \
+      size_t,                 \
+      size_t,                 \
+      size_t,                 \
+      float,                  \
+      const T*,               \
+      size_t,                 \
+      const T*,               \
+      size_t,                 \
+      float,                  \
+      T*,                     \
+      size_t);
+
+instantiate_gemm(float)
+instantiate_gemm(float16_t)
+instantiate_gemm(bfloat16_t)
+
+} // namespace mlx::core
@@ -0,0 +1,32 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <cstddef>
+
+namespace mlx::core {
+
+/* Computes c = alpha * op(a) @ op(b) + beta * c for row major matrices where
+ * op(x) is x or its transpose. c is not read when beta is 0.
+ *
+ * float is computed with BLAS. float16_t and bfloat16_t, which BLAS doesn't
+ * support, use a built-in blocked and packed GEMM which is split across the
+ * CPU thread pool and accumulates in float32.
+ * */
+template <typename T>
+void gemm(
+    bool transpose_a,
+    bool transpose_b,
+    size_t M,
+    size_t N,
+    size_t K,
+    float alpha,
+    const T* a,
+    size_t lda,
+    const T* b,
+    size_t ldb,
+    float beta,
+    T* c,
+    size_t ldc);
+
+} // namespace mlx::core
@@ -0,0 +1,78 @@
+// Copyright © 2024 Apple Inc.
+
+#include <cassert>
+#include <vector>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// In-place butterflies over each row of length n. A row is transformed in a
+// float32 buffer and scaled when it is written back.
+template <typename T>
+void hadamard(const array& in, array& out, float scale) {
+  size_t n = in.shape(-1);
+  size_t rows = n > 0 ? in.size() / n : 0;
+  const T* in_ptr = in.data<T>();
+  T* out_ptr = out.data<T>();
+
+  size_t grain = std::max<size_t>(1, min_elements_per_thread / n);
+  parallel_for(
+      rows,
+      [&](size_t begin, size_t end) {
+        std::vector<float> x(n);
+        for (size_t r = begin; r < end; r++) {
+          const T* src = in_ptr + r * n;
+          for (size_t i = 0; i < n; i++) {
+            x[i] = static_cast<float>(src[i]);
+          }
+          for (size_t h = 1; h < n; h *= 2) {
+            for (size_t j = 0; j < n; j += 2 * h) {
+              for (size_t k = j; k < j + h; k++) {
+                float a = x[k];
+                float b = x[k + h];
+                x[k] = a + b;
+                x[k + h] = a - b;
+              }
+            }
+          }
+          T* dst = out_ptr + r * n;
+          for (size_t i = 0; i < n; i++) {
+            dst[i] = static_cast<T>(x[i] * scale);
+          }
+        }
+      },
+      grain);
+}
+
+} // namespace
+
+void Hadamard::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+  auto& in = inputs[0];
+  array in_copy = in;
+  if (!in.flags().row_contiguous) {
+    in_copy = array(in.shape(), in.dtype(), nullptr, {});
+    copy(in, in_copy, CopyType::General);
+  }
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  switch (out.dtype()) {
+    case float32:
+      return hadamard<float>(in_copy, out, scale_);
+    case float16:
+      return hadamard<float16_t>(in_copy, out, scale_);
+    case bfloat16:
+      return hadamard<bfloat16_t>(in_copy, out, scale_);
+    default:
+      throw std::runtime_error(
+          "[Hadamard::eval] Only supports floating point types.");
+  }
+}
+
+} // namespace mlx::core
@@ -8,6 +8,7 @@
 #include "mlx/primitives.h"
 
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/utils.h"
 
 namespace mlx::core {
@@ -79,31 +80,50 @@ void gather(
   size_t ind_size = slice_size == 0 ? 0 : out.size() / slice_size;
   const T* src_ptr = src.data<T>();
   T* dst_ptr = out.data<T>();
-  size_t out_idx = 0;
 
-  for (int idx = 0; idx < ind_size; idx++) {
-    size_t src_idx = 0;
-    for (int ii = 0; ii < inds.size(); ++ii) {
-      auto ax = axes[ii];
-      auto idx_loc = elem_to_loc(idx, inds[ii]);
-      auto idx_val =
-          offset_neg_idx(inds[ii].data<IdxT>()[idx_loc], src.shape(ax));
-      src_idx += (idx_val * src.strides()[ax]);
-    }
-
-    if (slice_size == 1) {
-      dst_ptr[out_idx++] = src_ptr[src_idx];
-    } else if (can_copy) {
-      std::copy(
-          src_ptr + src_idx, src_ptr + src_idx + slice_size, dst_ptr + out_idx);
-      out_idx += slice_size;
-    } else {
-      for (int jj = 0; jj < slice_size; jj++) {
-        auto src_offset = elem_to_loc(jj, slice_sizes, src.strides());
-        dst_ptr[out_idx++] = src_ptr[src_idx + src_offset];
-      }
+  // Slices that are not contiguous are copied one row (the last axis of the
+  // slice) at a time from precomputed row offsets
+  std::vector<int64_t> row_offsets;
+  int row_size = slice_sizes.empty() ? 1 : slice_sizes.back();
+  int64_t row_stride = src.ndim() == 0 ? 1 : src.strides().back();
+  if (!can_copy && slice_size > 1) {
+    row_offsets.resize(slice_size / row_size);
+    for (int r = 0; r < row_offsets.size(); r++) {
+      row_offsets[r] = elem_to_loc(r * row_size, slice_sizes, src.strides());
     }
   }
+
+  parallel_for(
+      ind_size,
+      [&](size_t begin, size_t end) {
+        for (size_t idx = begin; idx < end; idx++) {
+          size_t src_idx = 0;
+          for (int ii = 0; ii < inds.size(); ++ii) {
+            auto ax = axes[ii];
+            auto idx_loc = elem_to_loc(idx, inds[ii]);
+            auto idx_val =
+                offset_neg_idx(inds[ii].data<IdxT>()[idx_loc], src.shape(ax));
+            src_idx += (idx_val * src.strides()[ax]);
+          }
+
+          const T* s = src_ptr + src_idx;
+          T* d = dst_ptr + idx * slice_size;
+          if (slice_size == 1) {
+            *d = *s;
+          } else if (can_copy) {
+            std::copy(s, s + slice_size, d);
+          } else {
+            for (auto offset : row_offsets) {
+              for (int jj = 0; jj < row_size; jj++) {
+                d[jj] = s[offset + jj * row_stride];
+              }
+              d += row_size;
+            }
+          }
+        }
+      },
+      std::max<size_t>(
+          1, min_elements_per_thread / std::max<size_t>(slice_size, 1)));
 }
 
 template <typename IdxT>
@@ -205,6 +225,20 @@ void Gather::eval(const std::vector<array>& inputs, array& out) {
   }
 }
 
+/* Applies the updates with op. The updates are split across threads
+ * without locks when the slices of different indices cannot overlap, which
+ * is the case when the slices have size one along the indexed axes:
+ *
+ * - Large slices are split by rows so each thread applies every update to
+ *   its rows of the output.
+ * - Sorted indices are split into runs of equal offsets and every run is
+ *   applied by one thread.
+ * - Otherwise the output is segmented into one range per thread and each
+ *   thread applies the updates that start in its range.
+ *
+ * Either way the updates to an output element are applied in their original
+ * order so duplicate indices give the same result as a serial scatter.
+ * */
 template <typename InT, typename IdxT, typename OpT>
 void scatter(
     const array& updates,
@@ -222,8 +256,30 @@ void scatter(
   for (auto us : update_shape) {
     update_size *= us;
   }
+  if (n_updates == 0 || update_size == 0) {
+    return;
+  }
+
+  // Read the updates in row major order
+  array upd = updates;
+  if (!upd.flags().row_contiguous) {
+    upd = array(updates.shape(), updates.dtype(), nullptr, {});
+    copy(updates, upd, CopyType::General);
+  }
+  const InT* upd_ptr = upd.data<InT>();
+  InT* out_ptr = out.data<InT>();
 
-  for (int i = 0; i < n_updates; ++i) {
+  // The output is row contiguous so every row (the last axis) of an update
+  // slice is contiguous in it
+  int row_size = update_shape.empty() ? 1 : update_shape.back();
+  size_t n_rows = update_size / row_size;
+  std::vector<int64_t> row_offsets(n_rows);
+  for (size_t r = 0; r < n_rows; r++) {
+    row_offsets[r] = elem_to_loc(r * row_size, update_shape, out.strides());
+  }
+
+  std::vector<int64_t> offsets(n_updates);
+  for (size_t i = 0; i < n_updates; ++i) {
     size_t out_offset = 0;
     for (int j = 0; j < nind; ++j) {
       auto ax = axes[j];
@@ -232,13 +288,75 @@ void scatter(
           offset_neg_idx(inds[j].data<IdxT>()[idx_loc], out.shape(ax));
       out_offset += (idx_val * out.strides()[ax]);
     }
-    for (int j = 0; j < update_size; ++j) {
-      auto update_loc = elem_to_loc(i * update_size + j, updates);
-      auto out_loc = elem_to_loc(j, update_shape, out.strides());
-      op(updates.data<InT>()[update_loc],
-         out.data<InT>() + out_offset + out_loc);
+    offsets[i] = out_offset;
+  }
+
+  auto apply = [&](size_t i, size_t r0, size_t r1) {
+    const InT* u = upd_ptr + i * update_size + r0 * row_size;
+    for (size_t r = r0; r < r1; r++, u += row_size) {
+      InT* o = out_ptr + offsets[i] + row_offsets[r];
+      for (int c = 0; c < row_size; c++) {
+        op(u[c], o + c);
+      }
+    }
+  };
+
+  bool disjoint = true;
+  for (auto ax : axes) {
+    disjoint &= update_shape[ax] == 1;
+  }
+  if (!disjoint || n_updates * update_size < min_elements_per_thread) {
+    for (size_t i = 0; i < n_updates; i++) {
+      apply(i, 0, n_rows);
     }
+    return;
   }
+
+  if (n_rows >= cpu_threads()) {
+    parallel_for(
+        n_rows,
+        [&](size_t begin, size_t end) {
+          for (size_t i = 0; i < n_updates; i++) {
+            apply(i, begin, end);
+          }
+        },
+        std::max<size_t>(1, min_elements_per_thread / (n_updates * row_size)));
+    return;
+  }
+
+  if (std::is_sorted(offsets.begin(), offsets.end())) {
+    parallel_for(
+        n_updates,
+        [&](size_t begin, size_t end) {
+          // Move both ends to the start of a run so that each run of equal
+          // offsets is applied by exactly one thread
+          while (begin > 0 && begin < n_updates &&
+                 offsets[begin] == offsets[begin - 1]) {
+            begin++;
+          }
+          while (end < n_updates && offsets[end] == offsets[end - 1]) {
+            end++;
+          }
+          for (size_t i = begin; i < end; i++) {
+            apply(i, 0, n_rows);
+          }
+        },
+        std::max<size_t>(1, min_elements_per_thread / update_size));
+    return;
+  }
+
+  // Every thread owns a range of the output and applies, in order, the
+  // updates whose slice starts in it
+  parallel_for(
+      out.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = 0; i < n_updates; i++) {
+          if (offsets[i] >= begin && offsets[i] < end) {
+            apply(i, 0, n_rows);
+          }
+        }
+      },
+      std::max<size_t>(1, out.size() / cpu_threads()));
 }
 
 template <typename InT, typename IdxT>
@@ -2,6 +2,7 @@
 
 #include "mlx/allocator.h"
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/primitives.h"
 
 #ifdef ACCELERATE_NEW_LAPACK
@@ -12,6 +13,107 @@
 
 namespace mlx::core {
 
+namespace {
+
+// Closed form inverses of row-major N x N matrices for the tiny sizes where
+// the LAPACK call overhead dominates. Return false if the matrix is singular.
+bool inverse_2x2(float* a) {
+  float det = a[0] * a[3] - a[1] * a[2];
+  if (det == 0) {
+    return false;
+  }
+  float inv_det = 1.0f / det;
+  float a0 = a[0];
+  a[0] = a[3] * inv_det;
+  a[1] = -a[1] * inv_det;
+  a[2] = -a[2] * inv_det;
+  a[3] = a0 * inv_det;
+  return true;
+}
+
+bool inverse_3x3(float* a) {
+  float c[9] = {
+      a[4] * a[8] - a[5] * a[7],
+      a[2] * a[7] - a[1] * a[8],
+      a[1] * a[5] - a[2] * a[4],
+      a[5] * a[6] - a[3] * a[8],
+      a[0] * a[8] - a[2] * a[6],
+      a[2] * a[3] - a[0] * a[5],
+      a[3] * a[7] - a[4] * a[6],
+      a[1] * a[6] - a[0] * a[7],
+      a[0] * a[4] - a[1] * a[3]};
+  float det = a[0] * c[0] + a[1] * c[3] + a[2] * c[6];
+  if (det == 0) {
+    return false;
+  }
+  float inv_det = 1.0f / det;
+  for (int i = 0; i < 9; i++) {
+    a[i] = c[i] * inv_det;
+  }
+  return true;
+}
+
+bool inverse_4x4(float* a) {
+  // 2x2 minors of the top two and bottom two rows
+  float s0 = a[0] * a[5] - a[4] * a[1];
+  float s1 = a[0] * a[6] - a[4] * a[2];
+  float s2 = a[0] * a[7] - a[4] * a[3];
+  float s3 = a[1] * a[6] - a[5] * a[2];
+  float s4 = a[1] * a[7] - a[5] * a[3];
+  float s5 = a[2] * a[7] - a[6] * a[3];
+  float c5 = a[10] * a[15] - a[14] * a[11];
+  float c4 = a[9] * a[15] - a[13] * a[11];
+  float c3 = a[9] * a[14] - a[13] * a[10];
+  float c2 = a[8] * a[15] - a[12] * a[11];
+  float c1 = a[8] * a[14] - a[12] * a[10];
+  float c0 = a[8] * a[13] - a[12] * a[9];
+
+  float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  if (det == 0) {
+    return false;
+  }
+  float inv_det = 1.0f / det;
+
+  float b[16] = {
+      a[5] * c5 - a[6] * c4 + a[7] * c3,
+      -a[1] * c5 + a[2] * c4 - a[3] * c3,
+      a[13] * s5 - a[14] * s4 + a[15] * s3,
+      -a[9] * s5 + a[10] * s4 - a[11] * s3,
+      -a[4] * c5 + a[6] * c2 - a[7] * c1,
+      a[0] * c5 - a[2] * c2 + a[3] * c1,
+      -a[12] * s5 + a[14] * s2 - a[15] * s1,
+      a[8] * s5 - a[10] * s2 + a[11] * s1,
+      a[4] * c4 - a[5] * c2 + a[7] * c0,
+      -a[0] * c4 + a[1] * c2 - a[3] * c0,
+      a[12] * s4 - a[13] * s2 + a[15] * s0,
+      -a[8] * s4 + a[9] * s2 - a[11] * s0,
+      -a[4] * c3 + a[5] * c1 - a[6] * c0,
+      a[0] * c3 - a[1] * c1 + a[2] * c0,
+      -a[12] * s3 + a[13] * s1 - a[14] * s0,
+      a[8] * s3 - a[9] * s1 + a[10] * s0};
+  for (int i = 0; i < 16; i++) {
+    a[i] = b[i] * inv_det;
+  }
+  return true;
+}
+
+template <typename F>
+void small_inverse(float* data, int N, size_t num_matrices, F inverse) {
+  parallel_for(
+      num_matrices,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          if (!inverse(data + N * N * i)) {
+            throw std::runtime_error(
+                "inverse_impl: the matrix is singular and cannot be inverted");
+          }
+        }
+      },
+      std::max<size_t>(1, min_elements_per_thread / (N * N * N)));
+}
+
+} // namespace
+
 void inverse_impl(const array& a, array& inv) {
   // Lapack uses the column-major convention. We take advantage of the following
   // identity to avoid transposing (see
@@ -23,66 +125,89 @@ void inverse_impl(const array& a, array& inv) {
 
   const int N = a.shape(-1);
   const size_t num_matrices = a.size() / (N * N);
+  if (num_matrices == 0) {
+    return;
+  }
+
+  switch (N) {
+    case 2:
+      return small_inverse(inv.data<float>(), N, num_matrices, inverse_2x2);
+    case 3:
+      return small_inverse(inv.data<float>(), N, num_matrices, inverse_3x3);
+    case 4:
+      return small_inverse(inv.data<float>(), N, num_matrices, inverse_4x4);
+  }
 
   int info;
-  auto ipiv = array::Data{allocator::malloc_or_wait(sizeof(int) * N)};
-
-  for (int i = 0; i < num_matrices; i++) {
-    // Compute LU factorization.
-    sgetrf_(
-        /* m = */ &N,
-        /* n = */ &N,
-        /* a = */ inv.data<float>() + N * N * i,
-        /* lda = */ &N,
-        /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
-        /* info = */ &info);
-
-    if (info != 0) {
-      std::stringstream ss;
-      ss << "inverse_impl: LU factorization failed with error code " << info;
-      throw std::runtime_error(ss.str());
-    }
+  static const int lwork_query = -1;
+  float workspace_size = 0;
+
+  // Compute workspace size.
+  sgetri_(
+      /* m = */ &N,
+      /* a = */ nullptr,
+      /* lda = */ &N,
+      /* ipiv = */ nullptr,
+      /* work = */ &workspace_size,
+      /* lwork = */ &lwork_query,
+      /* info = */ &info);
+
+  if (info != 0) {
+    std::stringstream ss;
+    ss << "inverse_impl: LU workspace calculation failed with error code "
+       << info;
+    throw std::runtime_error(ss.str());
+  }
 
-    static const int lwork_query = -1;
-    float workspace_size = 0;
-
-    // Compute workspace size.
-    sgetri_(
-        /* m = */ &N,
-        /* a = */ nullptr,
-        /* lda = */ &N,
-        /* ipiv = */ nullptr,
-        /* work = */ &workspace_size,
-        /* lwork = */ &lwork_query,
-        /* info = */ &info);
-
-    if (info != 0) {
-      std::stringstream ss;
-      ss << "inverse_impl: LU workspace calculation failed with error code "
-         << info;
-      throw std::runtime_error(ss.str());
-    }
+  const int lwork = workspace_size;
 
-    const int lwork = workspace_size;
+  // Each range of matrices gets its own pivots and workspace so the batch can
+  // be split across the CPU threads.
+  auto invert = [&](size_t begin, size_t end) {
+    int info;
+    auto ipiv = array::Data{allocator::malloc_or_wait(sizeof(int) * N)};
     auto scratch =
         array::Data{allocator::malloc_or_wait(sizeof(float) * lwork)};
 
-    // Compute inverse.
-    sgetri_(
-        /* m = */ &N,
-        /* a = */ inv.data<float>() + N * N * i,
-        /* lda = */ &N,
-        /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
-        /* work = */ static_cast<float*>(scratch.buffer.raw_ptr()),
-        /* lwork = */ &lwork,
-        /* info = */ &info);
-
-    if (info != 0) {
-      std::stringstream ss;
-      ss << "inverse_impl: inversion failed with error code " << info;
-      throw std::runtime_error(ss.str());
+    for (size_t i = begin; i < end; i++) {
+      // Compute LU factorization.
+      sgetrf_(
+          /* m = */ &N,
+          /* n = */ &N,
+          /* a = */ inv.data<float>() + N * N * i,
+          /* lda = */ &N,
+          /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
+          /* info = */ &info);
+
+      if (info != 0) {
+        std::stringstream ss;
+        ss << "inverse_impl: LU factorization failed with error code "
+           << info;
+        throw std::runtime_error(ss.str());
+      }
+
+      // Compute inverse.
+      sgetri_(
+          /* m = */ &N,
+          /* a = */ inv.data<float>() + N * N * i,
+          /* lda = */ &N,
+          /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
+          /* work = */ static_cast<float*>(scratch.buffer.raw_ptr()),
+          /* lwork = */ &lwork,
+          /* info = */ &info);
+
+      if (info != 0) {
+        std::stringstream ss;
+        ss << "inverse_impl: inversion failed with error code " << info;
+        throw std::runtime_error(ss.str());
+      }
     }
-  }
+  };
+
+  parallel_for(
+      num_matrices,
+      invert,
+      std::max<size_t>(1, min_elements_per_thread / (size_t(N) * N * N)));
 }
 
 void Inverse::eval(const std::vector<array>& inputs, array& output) {
@@ -12,43 +12,91 @@ namespace mlx::core {
 
 namespace {
 
-template <const uint8_t scalar_size>
-void swap_endianness(uint8_t* data_bytes, size_t N) {
-  struct Elem {
-    uint8_t bytes[scalar_size];
+// Byte swaps every scalar in place. The builtins compile to byte shuffles
+// which the compiler vectorizes.
+void swap_endianness(char* data, size_t n_bytes, size_t scalar_size) {
+  auto swap = [data, n_bytes](auto bswap) {
+    using T = decltype(bswap(0));
+    T* elems = reinterpret_cast<T*>(data);
+    for (size_t i = 0; i < n_bytes / sizeof(T); i++) {
+      elems[i] = bswap(elems[i]);
+    }
   };
+  switch (scalar_size) {
+    case 2:
+      swap([](uint16_t x) { return __builtin_bswap16(x); });
+      break;
+    case 4:
+      swap([](uint32_t x) { return __builtin_bswap32(x); });
+      break;
+    case 8:
+      swap([](uint64_t x) { return __builtin_bswap64(x); });
+      break;
+  }
+}
 
-  Elem* data = reinterpret_cast<Elem*>(data_bytes);
+// Point the array at its data inside a memory mapped file. Returns false if
+// the mapping can't be used directly.
+bool set_mapped_data(
+    array& out,
+    const std::shared_ptr<io::MappedFile>& file,
+    size_t offset) {
+  if (offset % out.itemsize() != 0) {
+    return false;
+  }
+  auto buffer = file->buffer();
+  if (!buffer.ptr()) {
+    return false;
+  }
 
-  for (size_t i = 0; i < N; i++) {
-    for (size_t j = 0; j < (scalar_size / 2); j++) {
-      std::swap(data[i].bytes[j], data[i].bytes[scalar_size - j - 1]);
-    }
+  // The whole mapping as one array which keeps the file mapped for as long
+  // as any array uses it
+  array mapped(buffer, {1}, uint8, [file](allocator::Buffer) {});
+
+  std::vector<size_t> strides(out.ndim(), 1);
+  for (int i = out.ndim() - 1; i > 0; i--) {
+    strides[i - 1] = strides[i] * out.shape(i);
   }
+  auto flags = out.flags();
+  flags.contiguous = true;
+  flags.row_contiguous = true;
+  auto max_dim = std::max_element(out.shape().begin(), out.shape().end());
+  flags.col_contiguous = out.size() <= 1 || out.size() == *max_dim;
+  out.copy_shared_buffer(
+      mapped, strides, flags, out.size(), offset / out.itemsize());
+  return true;
 }
 
 } // namespace
 
 void Load::eval(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 0);
-  out.set_data(allocator::malloc_or_wait(out.nbytes()));
 
-  reader_->seek(offset_, std::ios_base::beg);
-  reader_->read(out.data<char>(), out.nbytes());
-
-  if (swap_endianness_) {
-    switch (out.itemsize()) {
-      case 2:
-        swap_endianness<2>(out.data<uint8_t>(), out.data_size());
-        break;
-      case 4:
-        swap_endianness<4>(out.data<uint8_t>(), out.data_size());
-        break;
-      case 8:
-        swap_endianness<8>(out.data<uint8_t>(), out.data_size());
-        break;
+  if (auto file = reader_->mapped_file()) {
+    if (offset_ + out.nbytes() > file->size()) {
+      throw std::runtime_error(
+          "[Load::eval] Reading past the end of " + reader_->label());
+    }
+    if (!swap_endianness_ && set_mapped_data(out, file, offset_)) {
+      return;
     }
   }
+
+  // Swap each chunk right after it is read while it's still in cache
+  size_t itemsize = out.itemsize();
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  if (swap_endianness_ && itemsize > 1) {
+    io::parallel_read(
+        *reader_,
+        out.data<char>(),
+        out.nbytes(),
+        offset_,
+        [itemsize](char* data, size_t n) {
+          swap_endianness(data, n, itemsize);
+        });
+  } else {
+    io::parallel_read(*reader_, out.data<char>(), out.nbytes(), offset_);
+  }
 }
 
 } // namespace mlx::core
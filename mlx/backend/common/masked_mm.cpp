@@ -1,15 +1,10 @@
 // Copyright © 2024 Apple Inc.
 
-#ifdef ACCELERATE_NEW_LAPACK
-#include <Accelerate/Accelerate.h>
-#else
-#include <cblas.h>
-#endif
-
 #include <cstring>
 
 #include "mlx/array.h"
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/gemm.h"
 #include "mlx/backend/common/utils.h"
 #include "mlx/primitives.h"
 
@@ -56,15 +51,11 @@ inline void mask_matrix(
   }
 }
 
-} // namespace
-
-void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
-  if (out.dtype() != float32) {
-    throw std::runtime_error(
-        "[BlockMaskedMM::eval] Currently only supports float32.");
-  }
-  out.set_data(allocator::malloc_or_wait(out.nbytes()));
-
+template <typename T>
+void block_masked_mm(
+    const std::vector<array>& inputs,
+    array& out,
+    int block_size) {
   auto& a_pre = inputs[0];
   auto& b_pre = inputs[1];
 
@@ -110,12 +101,12 @@ void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
   }
 
   if (K == 0) {
-    std::memset(static_cast<void*>(out.data<float>()), 0, out.nbytes());
+    std::memset(out.data<void>(), 0, out.nbytes());
     return;
   }
 
   auto mask_array = [](const array& mask,
-                       float* data,
+                       T* data,
                        int block_size,
                        int batch_idx,
                        int X,
@@ -145,7 +136,7 @@ void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
     } else {
       return mask_matrix(
           data,
-          mask.data<float>(),
+          mask.data<T>(),
           block_size,
           X,
           Y,
@@ -159,11 +150,11 @@ void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
 
   for (int i = 0; i < (out.size() / (M * size_t(N))); ++i) {
     // Adjust pointer
-    float* ai =
-        a.data<float>() + elem_to_loc(M * K * i, a.shape(), a.strides());
-    float* bi =
-        b.data<float>() + elem_to_loc(K * N * i, b.shape(), b.strides());
-    float* ci = out.data<float>() + M * N * i;
+    T* ai = a.template data<T>() +
+        elem_to_loc(M * K * i, a.shape(), a.strides());
+    T* bi = b.template data<T>() +
+        elem_to_loc(K * N * i, b.shape(), b.strides());
+    T* ci = out.data<T>() + M * N * i;
 
     // Zero out blocks in a and b if needed
     if (has_op_mask) {
@@ -171,7 +162,7 @@ void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
       mask_array(
           a_mask,
           ai,
-          block_size_,
+          block_size,
           i,
           M,
           K,
@@ -182,7 +173,7 @@ void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
       mask_array(
           b_mask,
           bi,
-          block_size_,
+          block_size,
           i,
           K,
           N,
@@ -191,37 +182,31 @@ void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
     }
 
     // Do matmul
-    cblas_sgemm(
-        CblasRowMajor,
-        a_transposed ? CblasTrans : CblasNoTrans, // transA
-        b_transposed ? CblasTrans : CblasNoTrans, // transB
+    gemm<T>(
+        a_transposed,
+        b_transposed,
         M,
         N,
         K,
-        1.0, // alpha
+        1.0f, // alpha
         ai,
         lda,
         bi,
         ldb,
-        0.0, // beta
+        0.0f, // beta
         ci,
         out.shape(-1) // ldc
     );
 
     // Zero out blocks in out
     if (has_out_mask) {
-      mask_array(inputs[2], ci, block_size_, i, M, N, N, 1);
+      mask_array(inputs[2], ci, block_size, i, M, N, N, 1);
     }
   }
 }
 
-void GatherMM::eval(const std::vector<array>& inputs, array& out) {
-  if (out.dtype() != float32) {
-    throw std::runtime_error(
-        "[GatherMM::eval] Currently only supports float32.");
-  }
-  out.set_data(allocator::malloc_or_wait(out.nbytes()));
-
+template <typename T>
+void gather_mm(const std::vector<array>& inputs, array& out) {
   auto& a_pre = inputs[0];
   auto& b_pre = inputs[1];
 
@@ -252,7 +237,7 @@ void GatherMM::eval(const std::vector<array>& inputs, array& out) {
   }
 
   if (K == 0) {
-    std::memset(static_cast<void*>(out.data<float>()), 0, out.nbytes());
+    std::memset(out.data<void>(), 0, out.nbytes());
     return;
   }
 
@@ -283,23 +268,57 @@ void GatherMM::eval(const std::vector<array>& inputs, array& out) {
     uint32_t indx_A = lhs_indices_ptr[elem_to_loc(i, lhs_indices)];
     uint32_t indx_B = rhs_indices_ptr[elem_to_loc(i, rhs_indices)];
 
-    cblas_sgemm(
-        CblasRowMajor,
-        a_transposed ? CblasTrans : CblasNoTrans, // transA
-        b_transposed ? CblasTrans : CblasNoTrans, // transB
+    gemm<T>(
+        a_transposed,
+        b_transposed,
         M,
         N,
         K,
         1.0f, // alpha
-        a.data<float>() + elem_to_loc(indx_A, batch_shape_A, batch_strides_A),
+        a.template data<T>() +
+            elem_to_loc(indx_A, batch_shape_A, batch_strides_A),
         lda,
-        b.data<float>() + elem_to_loc(indx_B, batch_shape_B, batch_strides_B),
+        b.template data<T>() +
+            elem_to_loc(indx_B, batch_shape_B, batch_strides_B),
         ldb,
         0.0f, // beta
-        out.data<float>() + matrix_stride_out * i,
+        out.data<T>() + matrix_stride_out * i,
         out.shape(-1) // ldc
     );
   }
 }
 
+} // namespace
+
+void BlockMaskedMM::eval(const std::vector<array>& inputs, array& out) {
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  switch (out.dtype()) {
+    case float32:
+      return block_masked_mm<float>(inputs, out, block_size_);
+    case float16:
+      return block_masked_mm<float16_t>(inputs, out, block_size_);
+    case bfloat16:
+      return block_masked_mm<bfloat16_t>(inputs, out, block_size_);
+    default:
+      throw std::runtime_error(
+          "[BlockMaskedMM::eval] Currently only supports floating point "
+          "types.");
+  }
+}
+
+void GatherMM::eval(const std::vector<array>& inputs, array& out) {
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  switch (out.dtype()) {
+    case float32:
+      return gather_mm<float>(inputs, out);
+    case float16:
+      return gather_mm<float16_t>(inputs, out);
+    case bfloat16:
+      return gather_mm<bfloat16_t>(inputs, out);
+    default:
+      throw std::runtime_error(
+          "[GatherMM::eval] Currently only supports floating point types.");
+  }
+}
+
 } // namespace mlx::core
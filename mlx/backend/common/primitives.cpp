@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <numeric>
 #include <sstream>
 
@@ -11,6 +12,7 @@
 #include "mlx/backend/common/copy.h"
 #include "mlx/backend/common/ops.h"
 #include "mlx/backend/common/slicing.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/threefry.h"
 #include "mlx/backend/common/unary.h"
 #include "mlx/backend/common/utils.h"
@@ -313,6 +315,13 @@ void LogicalNot::eval(const std::vector<array>& inputs, array& out) {
   unary(in, out, detail::LogicalNot());
 }
 
+void MatmulVJP::eval(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  Matmul(stream()).eval_cpu({inputs[0], inputs[1]}, outputs[0]);
+  Matmul(stream()).eval_cpu({inputs[2], inputs[0]}, outputs[1]);
+}
+
 void Negative::eval(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   auto& in = inputs[0];
@@ -350,51 +359,222 @@ void Pad::eval(const std::vector<array>& inputs, array& out) {
   copy_inplace(in, out_slice, CopyType::GeneralGeneral);
 }
 
-void RandomBits::eval(const std::vector<array>& inputs, array& out) {
-  assert(inputs.size() == 1);
+namespace {
+
+// Writes the random bits of every key to its slice of out. The counters of
+// all the keys are hashed in bulk across the CPU pool.
+void random_bits(const array& keys, array& out) {
   // keys has shape (N1, ..., NK, 2)
   // out has shape (N1, ..., NK, M1, M2, ...)
-  auto& keys = inputs[0];
   size_t num_keys = keys.size() / 2;
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
 
   size_t elems_per_key = out.size() / num_keys;
   size_t bytes_per_key = out.itemsize() * elems_per_key;
-  out.set_data(allocator::malloc_or_wait(out.nbytes()));
 
-  auto kptr = inputs[0].data<uint32_t>();
+  auto kptr = keys.data<uint32_t>();
   auto cptr = out.data<char>();
   size_t out_skip = (bytes_per_key + 4 - 1) / 4;
   auto half_size = out_skip / 2;
   bool even = out_skip % 2 == 0;
-  for (int i = 0; i < num_keys; ++i, cptr += bytes_per_key) {
-    auto ptr = reinterpret_cast<uint32_t*>(cptr);
-    // Get ith key
-    auto kidx = 2 * i;
-    auto k1_elem = elem_to_loc(kidx, keys.shape(), keys.strides());
-    auto k2_elem = elem_to_loc(kidx + 1, keys.shape(), keys.strides());
-    auto key = std::make_pair(kptr[k1_elem], kptr[k2_elem]);
-
-    std::pair<uintptr_t, uintptr_t> count{0, half_size + !even};
-    for (; count.first + 1 < half_size; count.first++, count.second++) {
-      std::tie(ptr[count.first], ptr[count.second]) =
-          random::threefry2x32_hash(key, count);
+  // The last counter writes a partial word when the bytes of a key are not
+  // a multiple of four
+  size_t full_size = (bytes_per_key % 4 > 0 && half_size > 0) ? half_size - 1
+                                                              : half_size;
+
+  auto get_key = [&](size_t i) {
+    auto k1_elem = elem_to_loc(2 * i, keys.shape(), keys.strides());
+    auto k2_elem = elem_to_loc(2 * i + 1, keys.shape(), keys.strides());
+    return std::make_pair(kptr[k1_elem], kptr[k2_elem]);
+  };
+
+  parallel_for(num_keys * full_size, [&](size_t begin, size_t end) {
+    while (begin < end) {
+      size_t i = begin / full_size;
+      size_t j = begin % full_size;
+      size_t n = std::min(end - begin, full_size - j);
+      auto ptr = reinterpret_cast<uint32_t*>(cptr + i * bytes_per_key);
+      std::pair<uint32_t, uint32_t> count(j, j + half_size + !even);
+      random::threefry2x32_hash(
+          get_key(i), count, ptr + count.first, ptr + count.second, n);
+      begin += n;
     }
-    if (count.first < half_size) {
-      auto rb = random::threefry2x32_hash(key, count);
-      ptr[count.first++] = rb.first;
-      if (bytes_per_key % 4 > 0) {
+  });
+
+  if (full_size == half_size && even) {
+    return;
+  }
+  parallel_for(num_keys, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto key = get_key(i);
+      auto key_ptr = cptr + i * bytes_per_key;
+      if (full_size < half_size) {
+        std::pair<uint32_t, uint32_t> count(
+            full_size, full_size + half_size + !even);
+        auto rb = random::threefry2x32_hash(key, count);
+        std::copy(
+            reinterpret_cast<char*>(&rb.first),
+            reinterpret_cast<char*>(&rb.first) + 4,
+            key_ptr + 4 * count.first);
         std::copy(
             reinterpret_cast<char*>(&rb.second),
             reinterpret_cast<char*>(&rb.second) + bytes_per_key % 4,
-            cptr + 4 * count.second);
-      } else {
-        ptr[count.second] = rb.second;
+            key_ptr + 4 * count.second);
+      }
+      if (!even) {
+        std::pair<uint32_t, uint32_t> count(half_size, 0);
+        auto rb = random::threefry2x32_hash(key, count);
+        std::copy(
+            reinterpret_cast<char*>(&rb.first),
+            reinterpret_cast<char*>(&rb.first) +
+                std::min<size_t>(4, bytes_per_key - 4 * half_size),
+            key_ptr + 4 * half_size);
       }
     }
-    if (!even) {
-      count.second = 0;
-      ptr[half_size] = random::threefry2x32_hash(key, count).first;
+  });
+}
+
+// The representable value next to x in the direction of zero
+template <typename T>
+T toward_zero(T x) {
+  using U = std::conditional_t<sizeof(T) == 2, uint16_t, uint32_t>;
+  U bits;
+  std::memcpy(&bits, &x, sizeof(T));
+  bits -= 1;
+  std::memcpy(&x, &bits, sizeof(T));
+  return x;
+}
+
+// Maps the bits in out to normal samples in place. Every step is evaluated
+// in T exactly as random::normal used to compose it from uniform bits
+// (scale to [0, 1), clip below one, map to (-1, 1) and apply erfinv) so the
+// samples do not change.
+template <typename T, typename B>
+void normal_from_bits(array& out, float loc, float scale) {
+  float maxval = std::numeric_limits<B>::max();
+  T lo = toward_zero(static_cast<T>(-1.0f));
+  T range = static_cast<T>(static_cast<T>(1.0f) - lo);
+  T upper = toward_zero(static_cast<T>(1.0f));
+  T sqrt2 = static_cast<T>(std::sqrt(2.0));
+  T t_scale = static_cast<T>(scale);
+  T t_loc = static_cast<T>(loc);
+  bool has_scale = scale != 1.0;
+  bool has_loc = loc != 0.0;
+
+  auto bits = reinterpret_cast<const B*>(out.data<T>());
+  auto ptr = out.data<T>();
+  parallel_for(out.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      T x = static_cast<T>(static_cast<float>(bits[i]) / maxval);
+      x = x < upper ? x : upper;
+      x = static_cast<T>(range * x);
+      x = static_cast<T>(x + lo);
+      x = static_cast<T>(detail::fast_erfinv(static_cast<float>(x)));
+      x = static_cast<T>(sqrt2 * x);
+      if (has_scale) {
+        x = static_cast<T>(t_scale * x);
+      }
+      if (has_loc) {
+        x = static_cast<T>(t_loc + x);
+      }
+      ptr[i] = x;
+    }
+  });
+}
+
+// Keeps the element i when the i-th word of the bits is below the threshold.
+// The pair of elements 2j and 2j + 1 is hashed with the counter (j, j).
+template <typename T>
+void dropout(
+    const array& in,
+    std::pair<uint32_t, uint32_t> key,
+    uint32_t threshold,
+    float scale,
+    array& out) {
+  constexpr size_t block = 256;
+  auto in_ptr = in.data<T>();
+  auto out_ptr = out.data<T>();
+  size_t size = out.size();
+  size_t n_pairs = (size + 1) / 2;
+  parallel_for(n_pairs, [&](size_t begin, size_t end) {
+    uint32_t bits[2][block];
+    for (size_t j = begin; j < end; j += block) {
+      size_t n = std::min(block, end - j);
+      std::pair<uint32_t, uint32_t> count(j, j);
+      random::threefry2x32_hash(key, count, bits[0], bits[1], n);
+      for (size_t k = 0; k < n; k++) {
+        for (int w = 0; w < 2 && 2 * (j + k) + w < size; w++) {
+          size_t i = 2 * (j + k) + w;
+          out_ptr[i] = bits[w][k] < threshold
+              ? static_cast<T>(static_cast<float>(in_ptr[i]) * scale)
+              : static_cast<T>(0);
+        }
+      }
     }
+  });
+}
+
+} // namespace
+
+void RandomBits::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+  random_bits(inputs[0], out);
+}
+
+void RandomNormal::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+  random_bits(inputs[0], out);
+  switch (out.dtype()) {
+    case float32:
+      normal_from_bits<float, uint32_t>(out, loc_, scale_);
+      break;
+    case float16:
+      normal_from_bits<float16_t, uint16_t>(out, loc_, scale_);
+      break;
+    case bfloat16:
+      normal_from_bits<bfloat16_t, uint16_t>(out, loc_, scale_);
+      break;
+    default:
+      throw std::runtime_error(
+          "[RandomNormal::eval] Only floating point types are supported.");
+  }
+}
+
+void RandomDropout::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto in = inputs[0];
+  auto& keys = inputs[1];
+  if (!in.flags().row_contiguous) {
+    array in_copy(in.shape(), in.dtype(), nullptr, {});
+    copy(in, in_copy, CopyType::General);
+    in = in_copy;
+  }
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  auto kptr = keys.data<uint32_t>();
+  std::pair<uint32_t, uint32_t> key(
+      kptr[elem_to_loc(0, keys.shape(), keys.strides())],
+      kptr[elem_to_loc(1, keys.shape(), keys.strides())]);
+  double keep = 1.0 - p_;
+  uint32_t threshold = std::min(
+      keep * 4294967296.0, double(std::numeric_limits<uint32_t>::max()));
+  float scale = 1.0 / keep;
+  switch (out.dtype()) {
+    case float32:
+      dropout<float>(in, key, threshold, scale, out);
+      break;
+    case float16:
+      dropout<float16_t>(in, key, threshold, scale, out);
+      break;
+    case bfloat16:
+      dropout<bfloat16_t>(in, key, threshold, scale, out);
+      break;
+    default:
+      throw std::runtime_error(
+          "[RandomDropout::eval] Only floating point types are supported.");
   }
 }
 
@@ -500,6 +680,56 @@ void Slice::eval(const std::vector<array>& inputs, array& out) {
   }
 }
 
+void CacheAppend::eval(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 2);
+  auto& cache = inputs[0];
+  auto& upd = inputs[1];
+  auto& out = outputs[0];
+
+  if (!reuse_cache(cache, out)) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+    // Only the filled part of the cache is copied
+    if (offset_ > 0 && cache.size() > 0) {
+      auto shape = cache.shape();
+      shape[axis_] = offset_;
+      std::vector<int64_t> i_strides{
+          cache.strides().begin(), cache.strides().end()};
+      std::vector<int64_t> o_strides{
+          out.strides().begin(), out.strides().end()};
+      copy_inplace<int64_t>(
+          cache,
+          out,
+          shape,
+          i_strides,
+          o_strides,
+          0,
+          0,
+          CopyType::GeneralGeneral);
+    }
+  }
+
+  if (upd.size() > 0) {
+    std::vector<int64_t> upd_strides{
+        upd.strides().begin(), upd.strides().end()};
+    std::vector<int64_t> out_strides{
+        out.strides().begin(), out.strides().end()};
+    copy_inplace<int64_t>(
+        upd,
+        out,
+        upd.shape(),
+        upd_strides,
+        out_strides,
+        0,
+        offset_ * out.strides()[axis_],
+        CopyType::GeneralGeneral);
+  }
+
+  set_filled_view(out, outputs[1]);
+}
+
 void SliceUpdate::eval(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 2);
   if (out.size() == 0) {
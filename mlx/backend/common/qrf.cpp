@@ -2,6 +2,7 @@
 
 #include "mlx/allocator.h"
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/primitives.h"
 
 #ifdef ACCELERATE_NEW_LAPACK
@@ -76,22 +77,31 @@ void qrf_impl(const array& a, array& q, array& r) {
 
   // Update workspace size
   lwork = optimal_work;
-  auto work = allocator::malloc_or_wait(sizeof(T) * lwork);
 
-  // Loop over matrices
-  for (int i = 0; i < num_matrices; ++i) {
-    // Solve
-    lpack<T>::xgeqrf(
-        &M,
-        &N,
-        in.data<float>() + M * N * i,
-        &lda,
-        static_cast<T*>(tau.raw_ptr()) + num_reflectors * i,
-        static_cast<T*>(work.raw_ptr()),
-        &lwork,
-        &info);
-  }
-  allocator::free(work);
+  // Matrices are split across the CPU threads, each range with its own
+  // workspace
+  size_t grain =
+      std::max<size_t>(1, min_elements_per_thread / (size_t(M) * N * N));
+
+  parallel_for(
+      num_matrices,
+      [&](size_t begin, size_t end) {
+        int info;
+        auto work = array::Data{allocator::malloc_or_wait(sizeof(T) * lwork)};
+        for (size_t i = begin; i < end; ++i) {
+          // Solve
+          lpack<T>::xgeqrf(
+              &M,
+              &N,
+              in.data<float>() + M * N * i,
+              &lda,
+              static_cast<T*>(tau.raw_ptr()) + num_reflectors * i,
+              static_cast<T*>(work.buffer.raw_ptr()),
+              &lwork,
+              &info);
+        }
+      },
+      grain);
 
   r.set_data(allocator::malloc_or_wait(r.nbytes()));
   copy_inplace(in, r, CopyType::General);
@@ -118,28 +128,32 @@ void qrf_impl(const array& a, array& q, array& r) {
       &lwork,
       &info);
   lwork = optimal_work;
-  work = allocator::malloc_or_wait(sizeof(T) * lwork);
 
-  // Loop over matrices
-  for (int i = 0; i < num_matrices; ++i) {
-    // Compute Q
-    lpack<T>::xorgqr(
-        &M,
-        &N,
-        &num_reflectors,
-        in.data<float>() + M * N * i,
-        &lda,
-        static_cast<T*>(tau.raw_ptr()) + num_reflectors * i,
-        static_cast<T*>(work.raw_ptr()),
-        &lwork,
-        &info);
-  }
+  parallel_for(
+      num_matrices,
+      [&](size_t begin, size_t end) {
+        int info;
+        auto work = array::Data{allocator::malloc_or_wait(sizeof(T) * lwork)};
+        for (size_t i = begin; i < end; ++i) {
+          // Compute Q
+          lpack<T>::xorgqr(
+              &M,
+              &N,
+              &num_reflectors,
+              in.data<float>() + M * N * i,
+              &lda,
+              static_cast<T*>(tau.raw_ptr()) + num_reflectors * i,
+              static_cast<T*>(work.buffer.raw_ptr()),
+              &lwork,
+              &info);
+        }
+      },
+      grain);
 
   q.set_data(allocator::malloc_or_wait(q.nbytes()));
   copy_inplace(in, q, CopyType::General);
 
   // Cleanup
-  allocator::free(work);
   allocator::free(tau);
 }
 
@@ -1,7 +1,14 @@
 // Copyright © 2023 Apple Inc.
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
 
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/metal/copy.h"
 #include "mlx/primitives.h"
 
@@ -9,6 +16,96 @@ namespace mlx::core {
 
 namespace {
 
+// Columns of w dequantized at once by _qmm. It is a multiple of every
+// supported group size.
+constexpr int QMM_NC = 128;
+
+// Rows of x accumulated at once by _qmm
+constexpr int QMM_MC = 32;
+
+// Rows of w dequantized at once by _qmm_t when x has more than one row
+constexpr int QMM_T_NC = 16;
+
+// Number of independent accumulators used in dot products so that the
+// compiler can vectorize them without reassociating float additions.
+constexpr int DOT_LANES = 8;
+
+// Returns x as float32, converting it into buf unless it already is.
+template <typename T>
+const float* to_float(const T* x, size_t size, std::vector<float>& buf) {
+  if constexpr (std::is_same_v<T, float>) {
+    return x;
+  } else {
+    buf.resize(size);
+    for (size_t i = 0; i < size; i++) {
+      buf[i] = static_cast<float>(x[i]);
+    }
+    return buf.data();
+  }
+}
+
+// Unpacks the group_size values stored in the first group_size * bits / 32
+// words of w. Every shift amount is a compile time constant so the loop is
+// lowered to vector shifts and masks.
+//
+// 3 and 6 bit values are stored in packs of 3 bytes holding 8 and 4 values
+// respectively, which are read byte by byte.
+template <int bits, int group_size>
+inline void unpack_group(const uint32_t* w, float* q) {
+  constexpr uint32_t bitmask = (1 << bits) - 1;
+  if constexpr (32 % bits == 0) {
+    constexpr int pack_factor = 32 / bits;
+    constexpr int packs_in_group = group_size / pack_factor;
+    for (int j = 0; j < packs_in_group; j++) {
+      uint32_t wi = w[j];
+      for (int p = 0; p < pack_factor; p++) {
+        q[j * pack_factor + p] =
+            static_cast<float>((wi >> (p * bits)) & bitmask);
+      }
+    }
+  } else {
+    constexpr int pack_factor = 24 / bits;
+    constexpr int packs_in_group = group_size / pack_factor;
+    const uint8_t* w_bytes = reinterpret_cast<const uint8_t*>(w);
+    for (int j = 0; j < packs_in_group; j++) {
+      uint32_t wi = w_bytes[3 * j] | (w_bytes[3 * j + 1] << 8) |
+          (w_bytes[3 * j + 2] << 16);
+      for (int p = 0; p < pack_factor; p++) {
+        q[j * pack_factor + p] =
+            static_cast<float>((wi >> (p * bits)) & bitmask);
+      }
+    }
+  }
+}
+
+// Dot product of a and b where size is a multiple of DOT_LANES
+inline float dot(const float* a, const float* b, int size) {
+  float acc[DOT_LANES] = {};
+  for (int i = 0; i < size; i += DOT_LANES) {
+    for (int j = 0; j < DOT_LANES; j++) {
+      acc[j] += a[i + j] * b[i + j];
+    }
+  }
+  for (int w = DOT_LANES / 2; w > 0; w /= 2) {
+    for (int j = 0; j < w; j++) {
+      acc[j] += acc[j + w];
+    }
+  }
+  return acc[0];
+}
+
+// Number of tasks of task_size multiply-adds to give each thread at least
+// min_elements_per_thread of work.
+inline size_t task_grain(size_t task_size) {
+  return std::max<size_t>(
+      1, min_elements_per_thread / std::max<size_t>(task_size, 1));
+}
+
+// Computes x @ w where w is K x N quantized along N.
+//
+// The output is split in QMM_MC x QMM_NC tiles across the CPU thread pool.
+// Each tile dequantizes its columns of w one row at a time and accumulates
+// in float32.
 template <typename T, int bits, int group_size>
 void _qmm(
     T* result,
@@ -19,43 +116,75 @@ void _qmm(
     int M,
     int N,
     int K) {
-  constexpr int bitmask = (1 << bits) - 1;
-  constexpr int pack_factor = 32 / bits;
-  constexpr int packs_in_group = group_size / pack_factor;
+  constexpr int words_in_group = group_size * bits / 32;
   const int Ng = N / group_size;
-  const int Nw = N / pack_factor;
-
-  for (int m = 0; m < M; m++) {
-    const uint32_t* w_local = w;
-    const T* scales_local = scales;
-    const T* biases_local = biases;
-
-    std::fill(result, result + N, 0);
-
-    for (int k = 0; k < K; k++) {
-      T* result_local = result;
-      T xi = *x++;
-
-      for (int n = 0; n < N; n += group_size) {
-        T scale = *scales_local++;
-        T bias = *biases_local++;
-        for (int ng = 0; ng < packs_in_group; ng++) {
-          uint32_t wi = *w_local++;
-
-#pragma clang loop unroll(full)
-          for (int p = 0; p < pack_factor; p++) {
-            (*result_local++) +=
-                xi * (scale * static_cast<T>(wi & bitmask) + bias);
-            wi >>= bits;
+  const int Nw = N * bits / 32;
+
+  std::vector<float> x_buf;
+  const float* x_f = to_float(x, size_t(M) * K, x_buf);
+
+  const int m_tiles = (M + QMM_MC - 1) / QMM_MC;
+  const int n_tiles = (N + QMM_NC - 1) / QMM_NC;
+
+  auto compute_tiles = [&](size_t begin, size_t end) {
+    float w_row[QMM_NC];
+    float acc[QMM_MC * QMM_NC];
+    for (size_t tile = begin; tile < end; tile++) {
+      int m0 = (tile / n_tiles) * QMM_MC;
+      int n0 = (tile % n_tiles) * QMM_NC;
+      int mc = std::min(QMM_MC, M - m0);
+      int nc = std::min(QMM_NC, N - n0);
+      int groups = nc / group_size;
+
+      std::fill(acc, acc + mc * QMM_NC, 0.0f);
+      for (int k = 0; k < K; k++) {
+        const uint32_t* w_local = w + k * Nw + n0 * bits / 32;
+        const T* scales_local = scales + k * Ng + n0 / group_size;
+        const T* biases_local = biases + k * Ng + n0 / group_size;
+        for (int g = 0; g < groups; g++) {
+          float* q = w_row + g * group_size;
+          unpack_group<bits, group_size>(w_local + g * words_in_group, q);
+          float scale = static_cast<float>(scales_local[g]);
+          float bias = static_cast<float>(biases_local[g]);
+          for (int j = 0; j < group_size; j++) {
+            q[j] = scale * q[j] + bias;
           }
         }
+        for (int i = 0; i < mc; i++) {
+          float xi = x_f[(m0 + i) * size_t(K) + k];
+          float* acc_row = acc + i * QMM_NC;
+          for (int j = 0; j < nc; j++) {
+            acc_row[j] += xi * w_row[j];
+          }
+        }
+      }
+
+      for (int i = 0; i < mc; i++) {
+        T* result_row = result + (m0 + i) * size_t(N) + n0;
+        for (int j = 0; j < nc; j++) {
+          result_row[j] = static_cast<T>(acc[i * QMM_NC + j]);
+        }
       }
     }
+  };
 
-    result += N;
-  }
+  parallel_for(
+      size_t(m_tiles) * n_tiles,
+      compute_tiles,
+      task_grain(size_t(QMM_MC) * QMM_NC * K));
 }
 
+// Computes x @ w.T where w is N x K quantized along K.
+//
+// With a single row of x, as when decoding, every row of w is used exactly
+// once. The rows are then unpacked and dotted with x group by group and the
+// biases are applied once per group using
+//
+//   sum(x * (scale * q + bias)) = scale * sum(x * q) + bias * sum(x).
+//
+// Otherwise QMM_T_NC rows of w at a time are dequantized and reused for
+// every row of x. Both are split over the rows of w across the CPU thread
+// pool and accumulate in float32.
 template <typename T, int bits, int group_size>
 void _qmm_t(
     T* result,
@@ -66,40 +195,114 @@ void _qmm_t(
     int M,
     int N,
     int K) {
-  constexpr int bitmask = (1 << bits) - 1;
-  constexpr int pack_factor = 32 / bits;
-  constexpr int packs_in_group = group_size / pack_factor;
+  constexpr int words_in_group = group_size * bits / 32;
   const int Kg = K / group_size;
-  const int Kw = K / pack_factor;
-
-  for (int m = 0; m < M; m++) {
-    const uint32_t* w_local = w;
-    const T* scales_local = scales;
-    const T* biases_local = biases;
-
-    for (int n = 0; n < N; n++) {
-      const T* x_local = x;
-      T sum = 0;
-      for (int k = 0; k < K; k += group_size) {
-        T scale = *scales_local++;
-        T bias = *biases_local++;
-
-        for (int kw = 0; kw < packs_in_group; kw++) {
-          uint32_t wi = *w_local++;
-
-#pragma clang loop unroll(full)
-          for (int p = 0; p < pack_factor; p++) {
-            sum += (*x_local++) * (scale * static_cast<T>(wi & bitmask) + bias);
-            wi >>= bits;
+  const int Kw = K * bits / 32;
+
+  std::vector<float> x_buf;
+  const float* x_f = to_float(x, size_t(M) * K, x_buf);
+
+  if (M == 1) {
+    std::vector<float> x_sums(Kg);
+    for (int g = 0; g < Kg; g++) {
+      float sum = 0;
+      for (int k = 0; k < group_size; k++) {
+        sum += x_f[g * group_size + k];
+      }
+      x_sums[g] = sum;
+    }
+
+    auto compute_rows = [&](size_t begin, size_t end) {
+      float q[group_size];
+      for (size_t n = begin; n < end; n++) {
+        const uint32_t* w_local = w + n * Kw;
+        const T* scales_local = scales + n * Kg;
+        const T* biases_local = biases + n * Kg;
+        float sum = 0;
+        for (int g = 0; g < Kg; g++) {
+          unpack_group<bits, group_size>(w_local + g * words_in_group, q);
+          sum += static_cast<float>(scales_local[g]) *
+                  dot(x_f + g * group_size, q, group_size) +
+              static_cast<float>(biases_local[g]) * x_sums[g];
+        }
+        result[n] = static_cast<T>(sum);
+      }
+    };
+
+    parallel_for(N, compute_rows, task_grain(K));
+    return;
+  }
+
+  const int n_tiles = (N + QMM_T_NC - 1) / QMM_T_NC;
+
+  auto compute_tiles = [&](size_t begin, size_t end) {
+    std::vector<float> w_tile(QMM_T_NC * size_t(K));
+    for (size_t tile = begin; tile < end; tile++) {
+      int n0 = tile * QMM_T_NC;
+      int nc = std::min(QMM_T_NC, N - n0);
+
+      for (int j = 0; j < nc; j++) {
+        const uint32_t* w_local = w + (n0 + j) * size_t(Kw);
+        const T* scales_local = scales + (n0 + j) * size_t(Kg);
+        const T* biases_local = biases + (n0 + j) * size_t(Kg);
+        for (int g = 0; g < Kg; g++) {
+          float* q = w_tile.data() + j * size_t(K) + g * group_size;
+          unpack_group<bits, group_size>(w_local + g * words_in_group, q);
+          float scale = static_cast<float>(scales_local[g]);
+          float bias = static_cast<float>(biases_local[g]);
+          for (int k = 0; k < group_size; k++) {
+            q[k] = scale * q[k] + bias;
           }
         }
       }
-      *result = sum;
-      result++;
+
+      for (int m = 0; m < M; m++) {
+        const float* x_row = x_f + m * size_t(K);
+        T* result_row = result + m * size_t(N) + n0;
+        for (int j = 0; j < nc; j++) {
+          result_row[j] =
+              static_cast<T>(dot(x_row, w_tile.data() + j * size_t(K), K));
+        }
+      }
     }
+  };
+
+  parallel_for(n_tiles, compute_tiles, task_grain(size_t(QMM_T_NC) * M * K));
+}
 
-    x += K;
+template <typename T, int bits>
+void _qmm_dispatch_group(
+    T* result,
+    const T* x,
+    const uint32_t* w,
+    const T* scales,
+    const T* biases,
+    int M,
+    int N,
+    int K,
+    int group_size,
+    bool transposed_w) {
+  auto run = [&](auto qmm_t, auto qmm) {
+    if (transposed_w) {
+      qmm_t(result, x, w, scales, biases, M, N, K);
+    } else {
+      qmm(result, x, w, scales, biases, M, N, K);
+    }
+  };
+  switch (group_size) {
+    case 32:
+      return run(_qmm_t<T, bits, 32>, _qmm<T, bits, 32>);
+    case 64:
+      return run(_qmm_t<T, bits, 64>, _qmm<T, bits, 64>);
+    case 128:
+      return run(_qmm_t<T, bits, 128>, _qmm<T, bits, 128>);
   }
+  std::ostringstream msg;
+  msg << "Quantization type not supported. Provided bits=" << bits
+      << " and group_size=" << group_size
+      << ". The supported options are bits in "
+      << "{2, 3, 4, 6, 8} and group_size in {32, 64, 128}.";
+  throw std::invalid_argument(msg.str());
 }
 
 template <typename T>
@@ -116,78 +319,27 @@ void _qmm_dispatch_typed(
     int bits,
     bool transposed_w) {
   switch (bits) {
-    case 2: {
-      switch (group_size) {
-        case 32:
-          if (transposed_w) {
-            return _qmm_t<T, 2, 32>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 2, 32>(result, x, w, scales, biases, M, N, K);
-          }
-        case 64:
-          if (transposed_w) {
-            return _qmm_t<T, 2, 64>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 2, 64>(result, x, w, scales, biases, M, N, K);
-          }
-        case 128:
-          if (transposed_w) {
-            return _qmm_t<T, 2, 128>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 2, 128>(result, x, w, scales, biases, M, N, K);
-          }
-      }
-    }
-    case 4: {
-      switch (group_size) {
-        case 32:
-          if (transposed_w) {
-            return _qmm_t<T, 4, 32>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 4, 32>(result, x, w, scales, biases, M, N, K);
-          }
-        case 64:
-          if (transposed_w) {
-            return _qmm_t<T, 4, 64>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 4, 64>(result, x, w, scales, biases, M, N, K);
-          }
-        case 128:
-          if (transposed_w) {
-            return _qmm_t<T, 4, 128>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 4, 128>(result, x, w, scales, biases, M, N, K);
-          }
-      }
-    }
-    case 8: {
-      switch (group_size) {
-        case 32:
-          if (transposed_w) {
-            return _qmm_t<T, 8, 32>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 8, 32>(result, x, w, scales, biases, M, N, K);
-          }
-        case 64:
-          if (transposed_w) {
-            return _qmm_t<T, 8, 64>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 8, 64>(result, x, w, scales, biases, M, N, K);
-          }
-        case 128:
-          if (transposed_w) {
-            return _qmm_t<T, 8, 128>(result, x, w, scales, biases, M, N, K);
-          } else {
-            return _qmm<T, 8, 128>(result, x, w, scales, biases, M, N, K);
-          }
-      }
-    }
+    case 2:
+      return _qmm_dispatch_group<T, 2>(
+          result, x, w, scales, biases, M, N, K, group_size, transposed_w);
+    case 3:
+      return _qmm_dispatch_group<T, 3>(
+          result, x, w, scales, biases, M, N, K, group_size, transposed_w);
+    case 4:
+      return _qmm_dispatch_group<T, 4>(
+          result, x, w, scales, biases, M, N, K, group_size, transposed_w);
+    case 6:
+      return _qmm_dispatch_group<T, 6>(
+          result, x, w, scales, biases, M, N, K, group_size, transposed_w);
+    case 8:
+      return _qmm_dispatch_group<T, 8>(
+          result, x, w, scales, biases, M, N, K, group_size, transposed_w);
   }
   std::ostringstream msg;
   msg << "Quantization type not supported. Provided bits=" << bits
       << " and group_size=" << group_size
       << ". The supported options are bits in "
-      << "{2, 4, 8} and group_size in {64, 128}.";
+      << "{2, 3, 4, 6, 8} and group_size in {32, 64, 128}.";
   throw std::invalid_argument(msg.str());
 }
 
@@ -328,6 +480,235 @@ void _bs_qmm_dispatch(
   }
 }
 
+[[noreturn]] void _unsupported_quantization(int bits, int group_size) {
+  std::ostringstream msg;
+  msg << "Quantization type not supported. Provided bits=" << bits
+      << " and group_size=" << group_size
+      << ". The supported options are bits in "
+      << "{2, 3, 4, 6, 8} and group_size in {32, 64, 128}.";
+  throw std::invalid_argument(msg.str());
+}
+
+// Calls fn with the bits and the group size as std::integral_constants so
+// that the kernels can be instantiated for every supported quantization.
+template <typename F>
+void _quantization_dispatch(int bits, int group_size, F&& fn) {
+  auto with_group_size = [&](auto b) {
+    switch (group_size) {
+      case 32:
+        return fn(b, std::integral_constant<int, 32>{});
+      case 64:
+        return fn(b, std::integral_constant<int, 64>{});
+      case 128:
+        return fn(b, std::integral_constant<int, 128>{});
+    }
+    _unsupported_quantization(bits, group_size);
+  };
+  switch (bits) {
+    case 2:
+      return with_group_size(std::integral_constant<int, 2>{});
+    case 3:
+      return with_group_size(std::integral_constant<int, 3>{});
+    case 4:
+      return with_group_size(std::integral_constant<int, 4>{});
+    case 6:
+      return with_group_size(std::integral_constant<int, 6>{});
+    case 8:
+      return with_group_size(std::integral_constant<int, 8>{});
+  }
+  _unsupported_quantization(bits, group_size);
+}
+
+// Quantizes each group of w in one pass. The scale and bias of a group map
+// its largest magnitude edge exactly to a quantized value, and are rounded
+// to T before the values are quantized with them.
+//
+// The values are written as a little endian bit stream, which is the layout
+// of the uint32 packs and of the 3 byte packs of 3 and 6 bits.
+template <typename T, int bits, int group_size>
+void _quantize(
+    const T* w,
+    uint8_t* out,
+    T* scales,
+    T* biases,
+    size_t n_groups) {
+  constexpr float n_bins = (1 << bits) - 1;
+  constexpr float eps = 1e-7;
+  constexpr int pack_factor = (32 % bits == 0) ? 32 / bits : 24 / bits;
+  constexpr int bytes_per_pack = (32 % bits == 0) ? 4 : 3;
+  constexpr int packs_in_group = group_size / pack_factor;
+
+  parallel_for(
+      n_groups,
+      [&](size_t begin, size_t end) {
+        float q[group_size];
+        for (size_t g = begin; g < end; g++) {
+          const T* wg = w + g * group_size;
+          float w_min = static_cast<float>(wg[0]);
+          float w_max = w_min;
+          for (int i = 0; i < group_size; i++) {
+            q[i] = static_cast<float>(wg[i]);
+            w_min = std::min(w_min, q[i]);
+            w_max = std::max(w_max, q[i]);
+          }
+
+          bool side = std::abs(w_min) > std::abs(w_max);
+          float scale = std::max((w_max - w_min) / n_bins, eps);
+          scale = side ? scale : -scale;
+          float edge = side ? w_min : w_max;
+          float q0 = std::rint(edge / scale);
+          scale = (q0 != 0) ? edge / q0 : scale;
+          float bias = (q0 != 0) ? edge : 0;
+          scales[g] = static_cast<T>(scale);
+          biases[g] = static_cast<T>(bias);
+          scale = static_cast<float>(scales[g]);
+          bias = static_cast<float>(biases[g]);
+
+          uint8_t* og = out + g * packs_in_group * bytes_per_pack;
+          for (int j = 0; j < packs_in_group; j++) {
+            uint32_t pack = 0;
+            for (int p = 0; p < pack_factor; p++) {
+              float v = std::rint((q[j * pack_factor + p] - bias) / scale);
+              v = std::min(std::max(v, 0.0f), n_bins);
+              pack |= static_cast<uint32_t>(v) << (p * bits);
+            }
+            for (int b = 0; b < bytes_per_pack; b++) {
+              og[j * bytes_per_pack + b] = (pack >> (8 * b)) & 0xff;
+            }
+          }
+        }
+      },
+      task_grain(group_size));
+}
+
+template <typename T, int bits, int group_size>
+void _dequantize(
+    const uint32_t* w,
+    const T* scales,
+    const T* biases,
+    T* out,
+    size_t n_groups) {
+  constexpr int words_in_group = group_size * bits / 32;
+  parallel_for(
+      n_groups,
+      [&](size_t begin, size_t end) {
+        float q[group_size];
+        for (size_t g = begin; g < end; g++) {
+          unpack_group<bits, group_size>(w + g * words_in_group, q);
+          float scale = static_cast<float>(scales[g]);
+          float bias = static_cast<float>(biases[g]);
+          T* og = out + g * group_size;
+          for (int i = 0; i < group_size; i++) {
+            og[i] = static_cast<T>(scale * q[i] + bias);
+          }
+        }
+      },
+      task_grain(group_size));
+}
+
+template <typename T>
+void _quantize_typed(
+    const array& w,
+    array& wq,
+    array& scales,
+    array& biases,
+    int group_size,
+    int bits) {
+  _quantization_dispatch(bits, group_size, [&](auto b, auto gs) {
+    _quantize<T, decltype(b)::value, decltype(gs)::value>(
+        w.data<T>(),
+        reinterpret_cast<uint8_t*>(wq.data<uint32_t>()),
+        scales.data<T>(),
+        biases.data<T>(),
+        scales.size());
+  });
+}
+
+template <typename T>
+void _dequantize_typed(
+    const array& w,
+    const array& scales,
+    const array& biases,
+    array& out,
+    int group_size,
+    int bits) {
+  _quantization_dispatch(bits, group_size, [&](auto b, auto gs) {
+    _dequantize<T, decltype(b)::value, decltype(gs)::value>(
+        w.data<uint32_t>(),
+        scales.data<T>(),
+        biases.data<T>(),
+        out.data<T>(),
+        scales.size());
+  });
+}
+
+// The value of every 8-bit float code, see from_fp8. e4m3 has no infinities
+// and its only NaNs are 0x7F and 0xFF.
+std::array<float, 256> fp8_table(bool e5m2) {
+  const int mant_bits = e5m2 ? 2 : 3;
+  const int bias = e5m2 ? 15 : 7;
+  std::array<float, 256> table;
+  for (int c = 0; c < 256; c++) {
+    int mag = c & 0x7F;
+    int e = mag >> mant_bits;
+    int m = mag & ((1 << mant_bits) - 1);
+    float v;
+    if (e5m2 && e == 31) {
+      v = m == 0 ? std::numeric_limits<float>::infinity()
+                 : std::numeric_limits<float>::quiet_NaN();
+    } else if (!e5m2 && mag == 0x7F) {
+      v = std::numeric_limits<float>::quiet_NaN();
+    } else if (e == 0) {
+      v = std::ldexp(static_cast<float>(m), 1 - bias - mant_bits);
+    } else {
+      v = std::ldexp(
+          static_cast<float>(m + (1 << mant_bits)), e - bias - mant_bits);
+    }
+    table[c] = (c & 0x80) ? -v : v;
+  }
+  return table;
+}
+
+// Computes x @ w.T where w is N x K in fp8. Every thread owns a range of the
+// rows of w and decodes each of them once for all the rows of x.
+template <typename T>
+void _fp8_matmul(const array& x, const array& w, bool e5m2, array& out) {
+  int N = w.shape(0);
+  int K = w.shape(1);
+  if (out.size() == 0) {
+    return;
+  }
+  int M = out.size() / N;
+  const int K_main = K - K % DOT_LANES;
+  const auto table = fp8_table(e5m2);
+
+  std::vector<float> x_buf;
+  const float* x_ptr = to_float(x.data<T>(), x.size(), x_buf);
+  const uint8_t* w_ptr = w.data<uint8_t>();
+  T* out_ptr = out.data<T>();
+
+  parallel_for(
+      N,
+      [&](size_t begin, size_t end) {
+        std::vector<float> w_row(K);
+        for (size_t n = begin; n < end; n++) {
+          const uint8_t* wn = w_ptr + n * K;
+          for (int k = 0; k < K; k++) {
+            w_row[k] = table[wn[k]];
+          }
+          for (int m = 0; m < M; m++) {
+            const float* xm = x_ptr + size_t(m) * K;
+            float acc = dot(xm, w_row.data(), K_main);
+            for (int k = K_main; k < K; k++) {
+              acc += xm[k] * w_row[k];
+            }
+            out_ptr[size_t(m) * N + n] = static_cast<T>(acc);
+          }
+        }
+      },
+      task_grain(size_t(M) * K));
+}
+
 } // namespace
 
 void QuantizedMatmul::eval(const std::vector<array>& inputs, array& out) {
@@ -398,4 +779,105 @@ void GatherQMM::eval(const std::vector<array>& inputs, array& out) {
       transpose_);
 }
 
+void Fp8Matmul::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+
+  auto ensure_row_contiguous = [](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy(arr, arr_copy, CopyType::General);
+      return arr_copy;
+    }
+  };
+
+  auto x = ensure_row_contiguous(inputs[0]);
+  auto w = ensure_row_contiguous(inputs[1]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  bool e5m2 = format_ == "e5m2";
+  switch (out.dtype()) {
+    case float32:
+      return _fp8_matmul<float>(x, w, e5m2, out);
+    case float16:
+      return _fp8_matmul<float16_t>(x, w, e5m2, out);
+    case bfloat16:
+      return _fp8_matmul<bfloat16_t>(x, w, e5m2, out);
+    default:
+      throw std::runtime_error(
+          "[Fp8Matmul::eval] Only supports floating point types.");
+  }
+}
+
+void Quantize::eval(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+
+  auto& w_pre = inputs[0];
+  auto w = w_pre;
+  if (!w_pre.flags().row_contiguous) {
+    w = array(w_pre.shape(), w_pre.dtype(), nullptr, {});
+    copy(w_pre, w, CopyType::General);
+  }
+
+  auto& wq = outputs[0];
+  auto& scales = outputs[1];
+  auto& biases = outputs[2];
+  wq.set_data(allocator::malloc_or_wait(wq.nbytes()));
+  scales.set_data(allocator::malloc_or_wait(scales.nbytes()));
+  biases.set_data(allocator::malloc_or_wait(biases.nbytes()));
+
+  switch (w.dtype()) {
+    case float32:
+      _quantize_typed<float>(w, wq, scales, biases, group_size_, bits_);
+      break;
+    case float16:
+      _quantize_typed<float16_t>(w, wq, scales, biases, group_size_, bits_);
+      break;
+    case bfloat16:
+      _quantize_typed<bfloat16_t>(w, wq, scales, biases, group_size_, bits_);
+      break;
+    default:
+      throw std::invalid_argument(
+          "[quantize] only floating types are supported");
+  }
+}
+
+void Dequantize::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 3);
+
+  auto ensure_row_contiguous = [](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy(arr, arr_copy, CopyType::General);
+      return arr_copy;
+    }
+  };
+
+  auto w = ensure_row_contiguous(inputs[0]);
+  auto scales = ensure_row_contiguous(inputs[1]);
+  auto biases = ensure_row_contiguous(inputs[2]);
+
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  switch (out.dtype()) {
+    case float32:
+      _dequantize_typed<float>(w, scales, biases, out, group_size_, bits_);
+      break;
+    case float16:
+      _dequantize_typed<float16_t>(w, scales, biases, out, group_size_, bits_);
+      break;
+    case bfloat16:
+      _dequantize_typed<bfloat16_t>(
+          w, scales, biases, out, group_size_, bits_);
+      break;
+    default:
+      throw std::invalid_argument(
+          "[dequantize] only floating types are supported");
+  }
+}
+
 } // namespace mlx::core
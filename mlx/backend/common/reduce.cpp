@@ -107,6 +107,10 @@ void reduce_dispatch_out(
       if (out.dtype() == int32) {
         // special case since the input type can be bool
         reduction_op<InT, int32_t>(in, out, axes, 0, op);
+      } else if constexpr (
+          std::is_same_v<InT, float16_t> || std::is_same_v<InT, bfloat16_t>) {
+        // accumulate in float32 to avoid losing precision on long sums
+        reduction_op<InT, InT, float>(in, out, axes, 0, op);
       } else {
         reduction_op<InT, InT>(in, out, axes, 0, op);
       }
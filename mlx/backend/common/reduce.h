@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/utils.h"
 
 namespace mlx::core {
@@ -80,18 +81,52 @@ struct DefaultStridedReduce {
   }
 };
 
-template <typename T, typename U, typename Op>
+template <typename T, typename U, typename Op, typename AccT = U>
 struct DefaultContiguousReduce {
   Op op;
+  U init;
+
+  // Number of independent accumulators, they are combined pairwise at the
+  // end which lets the compiler vectorize the main loop and keeps the rounding
+  // error of long sums down.
+  static constexpr int N = 8;
 
-  DefaultContiguousReduce(Op op_) : op(op_) {}
+  DefaultContiguousReduce(Op op_, U init_) : op(op_), init(init_) {}
 
   void operator()(const T* x, U* accumulator, int size) {
+    if constexpr (std::is_default_constructible_v<AccT>) {
+      if (size >= 2 * N) {
+        accumulate(x, accumulator, size);
+        return;
+      }
+    }
     while (size-- > 0) {
       op(accumulator, *x);
       x++;
     }
   }
+
+  void accumulate(const T* x, U* accumulator, int size) {
+    AccT acc[N];
+    for (int j = 0; j < N; j++) {
+      acc[j] = static_cast<AccT>(init);
+    }
+    for (; size >= N; size -= N, x += N) {
+      for (int j = 0; j < N; j++) {
+        op(&acc[j], x[j]);
+      }
+    }
+    while (size-- > 0) {
+      op(acc, *x);
+      x++;
+    }
+    for (int w = N / 2; w > 0; w /= 2) {
+      for (int j = 0; j < w; j++) {
+        op(&acc[j], acc[j + w]);
+      }
+    }
+    op(accumulator, static_cast<U>(acc[0]));
+  }
 };
 
 template <typename T, typename U, typename OpS, typename OpC, typename Op>
@@ -108,22 +143,61 @@ void reduction_op(
 
   if (plan.type == ContiguousAllReduce) {
     U* out_ptr = out.data<U>();
+    const T* x_ptr = x.data<T>();
+    size_t size = x.size();
     *out_ptr = init;
-    opc(x.data<T>(), out_ptr, x.size());
+
+    // Each thread reduces a chunk into a partial result which are then
+    // combined in order
+    size_t n_chunks =
+        std::min<size_t>(cpu_threads(), size / min_elements_per_thread);
+    if (n_chunks <= 1) {
+      opc(x_ptr, out_ptr, size);
+      return;
+    }
+    size_t chunk = (size + n_chunks - 1) / n_chunks;
+    // Wrapped so that vector<bool> isn't a bitset
+    struct Partial {
+      U val;
+    };
+    std::vector<Partial> partials(n_chunks, Partial{init});
+    cpu_thread_pool().parallel_for(n_chunks, [&](int i) {
+      size_t begin = i * chunk;
+      size_t end = std::min(size, begin + chunk);
+      if (begin < end) {
+        opc(x_ptr + begin, &partials[i].val, end - begin);
+      }
+    });
+    for (int i = 0; i < n_chunks; i++) {
+      op(out_ptr, partials[i].val);
+    }
     return;
   }
 
   std::vector<int> shape;
   std::vector<size_t> strides;
 
+  // The reductions below are split across threads along the output, every
+  // output (or block of outputs for the strided versions) is independent.
+  auto grain = [&x, &out](size_t outputs_per_item) {
+    size_t reduced = x.size() / std::max<size_t>(out.size(), 1);
+    size_t per_item = std::max<size_t>(reduced * outputs_per_item, 1);
+    return std::max<size_t>(min_elements_per_thread / per_item, 1);
+  };
+
   if (plan.type == ContiguousReduce && plan.shape.size() == 1) {
     int reduction_size = plan.shape[0];
     const T* x_ptr = x.data<T>();
     U* out_ptr = out.data<U>();
-    for (int i = 0; i < out.size(); i++, out_ptr++, x_ptr += reduction_size) {
-      *out_ptr = init;
-      opc(x_ptr, out_ptr, reduction_size);
-    }
+    parallel_for(
+        out.size(),
+        [&](size_t start, size_t end) {
+          for (size_t i = start; i < end; i++) {
+            out_ptr[i] = init;
+            opc(x_ptr + i * reduction_size, out_ptr + i, reduction_size);
+          }
+        },
+        grain(1));
     return;
   }
 
@@ -137,22 +211,33 @@ void reduction_op(
     // ContiguousReduce) should hold extra performance boost.
     std::tie(shape, strides) = shapes_without_reduction_axes(x, axes);
     if (plan.shape.size() == 0) {
-      for (int i = 0; i < out.size(); i++, out_ptr++) {
-        int offset = elem_to_loc(i, shape, strides);
-        *out_ptr = init;
-        opc(x_ptr + offset, out_ptr, reduction_size);
-      }
+      parallel_for(
+          out.size(),
+          [&](size_t start, size_t end) {
+            for (size_t i = start; i < end; i++) {
+              int offset = elem_to_loc(i, shape, strides);
+              out_ptr[i] = init;
+              opc(x_ptr + offset, out_ptr + i, reduction_size);
+            }
+          },
+          grain(1));
     } else {
-      for (int i = 0; i < out.size(); i++, out_ptr++) {
-        int offset = elem_to_loc(i, shape, strides);
-        *out_ptr = init;
-        nd_loop(
-            [&](int extra_offset) {
-              opc(x_ptr + offset + extra_offset, out_ptr, reduction_size);
-            },
-            plan.shape,
-            plan.strides);
-      }
+      parallel_for(
+          out.size(),
+          [&](size_t start, size_t end) {
+            for (size_t i = start; i < end; i++) {
+              int offset = elem_to_loc(i, shape, strides);
+              U* acc = out_ptr + i;
+              *acc = init;
+              nd_loop(
+                  [&](int extra_offset) {
+                    opc(x_ptr + offset + extra_offset, acc, reduction_size);
+                  },
+                  plan.shape,
+                  plan.strides);
+            }
+          },
+          grain(1));
     }
     return;
   }
@@ -164,12 +249,19 @@ void reduction_op(
     plan.strides.pop_back();
     const T* x_ptr = x.data<T>();
     U* out_ptr = out.data<U>();
-    for (int i = 0; i < out.size(); i += reduction_stride) {
-      std::fill_n(out_ptr, reduction_stride, init);
-      ops(x_ptr, out_ptr, reduction_size, reduction_stride);
-      x_ptr += reduction_stride * reduction_size;
-      out_ptr += reduction_stride;
-    }
+    parallel_for(
+        out.size() / reduction_stride,
+        [&](size_t start, size_t end) {
+          for (size_t i = start; i < end; i++) {
+            U* acc = out_ptr + i * reduction_stride;
+            std::fill_n(acc, reduction_stride, init);
+            ops(x_ptr + i * reduction_stride * reduction_size,
+                acc,
+                reduction_size,
+                reduction_stride);
+          }
+        },
+        grain(reduction_stride));
     return;
   }
 
@@ -183,27 +275,37 @@ void reduction_op(
     U* out_ptr = out.data<U>();
     std::tie(shape, strides) = shapes_without_reduction_axes(x, axes);
     if (plan.shape.size() == 0) {
-      for (int i = 0; i < out.size(); i += reduction_stride) {
-        int offset = elem_to_loc(i, shape, strides);
-        std::fill_n(out_ptr, reduction_stride, init);
-        ops(x_ptr + offset, out_ptr, reduction_size, reduction_stride);
-        out_ptr += reduction_stride;
-      }
+      parallel_for(
+          out.size() / reduction_stride,
+          [&](size_t start, size_t end) {
+            for (size_t i = start; i < end; i++) {
+              int offset = elem_to_loc(i * reduction_stride, shape, strides);
+              U* acc = out_ptr + i * reduction_stride;
+              std::fill_n(acc, reduction_stride, init);
+              ops(x_ptr + offset, acc, reduction_size, reduction_stride);
+            }
+          },
+          grain(reduction_stride));
     } else {
-      for (int i = 0; i < out.size(); i += reduction_stride) {
-        int offset = elem_to_loc(i, shape, strides);
-        std::fill_n(out_ptr, reduction_stride, init);
-        nd_loop(
-            [&](int extra_offset) {
-              ops(x_ptr + offset + extra_offset,
-                  out_ptr,
-                  reduction_size,
-                  reduction_stride);
-            },
-            plan.shape,
-            plan.strides);
-        out_ptr += reduction_stride;
-      }
+      parallel_for(
+          out.size() / reduction_stride,
+          [&](size_t start, size_t end) {
+            for (size_t i = start; i < end; i++) {
+              int offset = elem_to_loc(i * reduction_stride, shape, strides);
+              U* acc = out_ptr + i * reduction_stride;
+              std::fill_n(acc, reduction_stride, init);
+              nd_loop(
+                  [&](int extra_offset) {
+                    ops(x_ptr + offset + extra_offset,
+                        acc,
+                        reduction_size,
+                        reduction_stride);
+                  },
+                  plan.shape,
+                  plan.strides);
+            }
+          },
+          grain(reduction_stride));
     }
     return;
   }
@@ -212,19 +314,28 @@ void reduction_op(
     const T* x_ptr = x.data<T>();
     U* out_ptr = out.data<U>();
     std::tie(shape, strides) = shapes_without_reduction_axes(x, axes);
-    for (int i = 0; i < out.size(); i++, out_ptr++) {
-      int offset = elem_to_loc(i, shape, strides);
-      U val = init;
-      nd_loop(
-          [&](int extra_offset) { op(&val, *(x_ptr + offset + extra_offset)); },
-          plan.shape,
-          plan.strides);
-      *out_ptr = val;
-    }
+    parallel_for(
+        out.size(),
+        [&](size_t start, size_t end) {
+          for (size_t i = start; i < end; i++) {
+            int offset = elem_to_loc(i, shape, strides);
+            U val = init;
+            nd_loop(
+                [&](int extra_offset) {
+                  op(&val, *(x_ptr + offset + extra_offset));
+                },
+                plan.shape,
+                plan.strides);
+            out_ptr[i] = val;
+          }
+        },
+        grain(1));
   }
 }
 
-template <typename T, typename U, typename Op>
+// AccT is the type used to accumulate contiguous reductions, e.g. float for
+// sums of float16 or bfloat16 inputs.
+template <typename T, typename U, typename AccT = U, typename Op>
 void reduction_op(
     const array& x,
     array& out,
@@ -232,7 +343,7 @@ void reduction_op(
     U init,
     Op op) {
   DefaultStridedReduce<T, U, Op> ops(op);
-  DefaultContiguousReduce<T, U, Op> opc(op);
+  DefaultContiguousReduce<T, U, Op, AccT> opc(op, init);
   reduction_op<T, U>(x, out, axes, init, ops, opc, op);
 }
 
@@ -1,8 +1,11 @@
 // Copyright © 2023 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
 
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/utils.h"
 #include "mlx/primitives.h"
 
@@ -10,6 +13,95 @@ namespace mlx::core {
 
 namespace {
 
+// Contiguous rows at least this long are scanned in blocks across the CPU
+// thread pool when there are fewer rows than threads
+constexpr int min_blocked_scan_size = 1 << 16;
+
+// Number of short contiguous rows scanned at once, one per lane, so the
+// dependency chains of the scans are independent and can be vectorized
+constexpr int scan_lanes = 8;
+
+// Columns of a strided scan given to each task
+constexpr int strided_scan_block = 1024;
+
+/* Scans n elements of a contiguous row. The accumulator starts from carry
+ * when there is one. Otherwise an inclusive scan starts from the first
+ * element and an exclusive one from init.
+ * */
+template <typename T, typename U, typename Op>
+void scan_row(
+    Op op,
+    U init,
+    const T* input,
+    U* output,
+    int n,
+    bool reverse,
+    bool inclusive,
+    const U* carry = nullptr) {
+  if (n == 0) {
+    return;
+  }
+  int step = reverse ? -1 : 1;
+  if (reverse) {
+    input += n - 1;
+    output += n - 1;
+  }
+  U acc = carry != nullptr ? *carry : init;
+  int i = 0;
+  if (inclusive) {
+    if (carry == nullptr) {
+      acc = static_cast<U>(*input);
+      *output = acc;
+      input += step;
+      output += step;
+      i++;
+    }
+    for (; i < n; i++) {
+      acc = op(acc, static_cast<U>(*input));
+      *output = acc;
+      input += step;
+      output += step;
+    }
+  } else {
+    for (; i < n; i++) {
+      *output = acc;
+      acc = op(acc, static_cast<U>(*input));
+      input += step;
+      output += step;
+    }
+  }
+}
+
+// Scans scan_lanes consecutive contiguous rows of size n at once
+template <typename T, typename U, typename Op>
+void scan_rows_lanes(
+    Op op,
+    U init,
+    const T* input,
+    U* output,
+    int n,
+    bool reverse,
+    bool inclusive) {
+  U acc[scan_lanes];
+  for (int i = 0; i < n; i++) {
+    size_t j = reverse ? n - 1 - i : i;
+    if (inclusive) {
+      for (int l = 0; l < scan_lanes; l++) {
+        U x = static_cast<U>(input[l * size_t(n) + j]);
+        acc[l] = i == 0 ? x : op(acc[l], x);
+        output[l * size_t(n) + j] = acc[l];
+      }
+    } else {
+      for (int l = 0; l < scan_lanes; l++) {
+        U x = static_cast<U>(input[l * size_t(n) + j]);
+        U prev = i == 0 ? init : acc[l];
+        output[l * size_t(n) + j] = prev;
+        acc[l] = op(prev, x);
+      }
+    }
+  }
+}
+
 template <typename T, typename U, typename Op>
 struct DefaultContiguousScan {
   Op op;
@@ -24,59 +116,97 @@ struct DefaultContiguousScan {
       int stride,
       bool reverse,
       bool inclusive) {
-    if (!reverse) {
-      if (inclusive) {
-        for (int i = 0; i < count; i++) {
-          *output = *input;
-          for (int j = 1; j < stride; j++) {
-            input++;
-            output++;
-            op(output, output - 1, input);
-          }
-          output++;
-          input++;
-        }
-      } else {
-        for (int i = 0; i < count; i++) {
-          *output = init;
-          for (int j = 1; j < stride; j++) {
-            op(output + 1, output, input);
-            input++;
-            output++;
-          }
-          output++;
-          input++;
-        }
+    if (count < cpu_threads() && stride >= min_blocked_scan_size) {
+      for (int i = 0; i < count; i++) {
+        blocked_scan(input, output, stride, reverse, inclusive);
+        input += stride;
+        output += stride;
       }
-    } else {
-      if (inclusive) {
-        for (int i = 0; i < count; i++) {
-          output += stride - 1;
-          input += stride - 1;
-          *output = *input;
-          for (int j = 1; j < stride; j++) {
-            input--;
-            output--;
-            op(output, output + 1, input);
+      return;
+    }
+
+    parallel_for(
+        count,
+        [&](size_t begin, size_t end) {
+          size_t i = begin;
+          for (; i + scan_lanes <= end; i += scan_lanes) {
+            scan_rows_lanes(
+                op,
+                init,
+                input + i * stride,
+                output + i * stride,
+                stride,
+                reverse,
+                inclusive);
           }
-          output += stride;
-          input += stride;
-        }
-      } else {
-        for (int i = 0; i < count; i++) {
-          output += stride - 1;
-          input += stride - 1;
-          *output = init;
-          for (int j = 1; j < stride; j++) {
-            op(output - 1, output, input);
-            input--;
-            output--;
+          for (; i < end; i++) {
+            scan_row(
+                op,
+                init,
+                input + i * stride,
+                output + i * stride,
+                stride,
+                reverse,
+                inclusive);
           }
-          output += stride;
-          input += stride;
-        }
+        },
+        std::max<size_t>(1, min_elements_per_thread / std::max(stride, 1)));
+  }
+
+  /* Scans a single long row in two passes. The row is split in one block
+   * per thread, the first pass reduces each block, the totals are scanned
+   * serially and the second pass scans each block starting from the total
+   * of the blocks before it.
+   * */
+  void blocked_scan(
+      const T* input,
+      U* output,
+      int size,
+      bool reverse,
+      bool inclusive) {
+    int n_blocks = cpu_threads();
+    int block = (size + n_blocks - 1) / n_blocks;
+    n_blocks = (size + block - 1) / block;
+
+    // Blocks are numbered in scan order, so from the end when reversed
+    auto block_range = [&](int b) {
+      int start = b * block;
+      int n = std::min(block, size - start);
+      return std::make_pair(reverse ? size - start - n : start, n);
+    };
+
+    // Not std::vector since the threads write to neighbouring bools
+    auto totals = std::make_unique<U[]>(n_blocks);
+    cpu_thread_pool().parallel_for(n_blocks - 1, [&](int b) {
+      auto [start, n] = block_range(b);
+      const T* x = input + start;
+      U acc = static_cast<U>(x[0]);
+      for (int i = 1; i < n; i++) {
+        acc = op(acc, static_cast<U>(x[i]));
       }
+      totals[b] = acc;
+    });
+
+    // carries[b] is the scan of every block before b
+    auto carries = std::make_unique<U[]>(n_blocks);
+    carries[0] = init;
+    for (int b = 1; b < n_blocks; b++) {
+      carries[b] = (b == 1 && inclusive) ? totals[0]
+                                          : op(carries[b - 1], totals[b - 1]);
     }
+
+    cpu_thread_pool().parallel_for(n_blocks, [&](int b) {
+      auto [start, n] = block_range(b);
+      scan_row(
+          op,
+          init,
+          input + start,
+          output + start,
+          n,
+          reverse,
+          inclusive,
+          (b == 0 && inclusive) ? nullptr : &carries[b]);
+    });
   }
 };
 
@@ -95,66 +225,59 @@ struct DefaultStridedScan {
       int stride,
       bool reverse,
       bool inclusive) {
-    // TODO: Vectorize the following naive implementation
-    if (!reverse) {
-      if (inclusive) {
-        for (int i = 0; i < count; i++) {
-          std::copy(input, input + stride, output);
-          output += stride;
-          input += stride;
-          for (int j = 1; j < size; j++) {
-            for (int k = 0; k < stride; k++) {
-              op(output, output - stride, input);
-              output++;
-              input++;
-            }
+    // Every task scans a block of contiguous columns so the inner loop
+    // over the columns vectorizes
+    int n_col_blocks = (stride + strided_scan_block - 1) / strided_scan_block;
+    parallel_for(
+        size_t(count) * n_col_blocks,
+        [&](size_t begin, size_t end) {
+          for (size_t task = begin; task < end; task++) {
+            size_t i = task / n_col_blocks;
+            int k0 = (task % n_col_blocks) * strided_scan_block;
+            int n_cols = std::min(strided_scan_block, stride - k0);
+            scan_columns(
+                input + i * size * stride + k0,
+                output + i * size * stride + k0,
+                size,
+                stride,
+                n_cols,
+                reverse,
+                inclusive);
           }
-        }
-      } else {
-        for (int i = 0; i < count; i++) {
-          std::fill(output, output + stride, init);
-          output += stride;
-          input += stride;
-          for (int j = 1; j < size; j++) {
-            for (int k = 0; k < stride; k++) {
-              op(output, output - stride, input - stride);
-              output++;
-              input++;
-            }
-          }
-        }
+        },
+        std::max<size_t>(
+            1,
+            min_elements_per_thread /
+                std::max<size_t>(size_t(size) * strided_scan_block, 1)));
+  }
+
+  void scan_columns(
+      const T* input,
+      U* output,
+      int size,
+      int stride,
+      int n_cols,
+      bool reverse,
+      bool inclusive) {
+    long step = reverse ? -long(stride) : long(stride);
+    if (reverse) {
+      input += (size - 1) * size_t(stride);
+      output += (size - 1) * size_t(stride);
+    }
+    if (inclusive) {
+      for (int k = 0; k < n_cols; k++) {
+        output[k] = static_cast<U>(input[k]);
       }
     } else {
-      if (inclusive) {
-        for (int i = 0; i < count; i++) {
-          output += (size - 1) * stride;
-          input += (size - 1) * stride;
-          std::copy(input, input + stride, output);
-          for (int j = 1; j < size; j++) {
-            for (int k = 0; k < stride; k++) {
-              output--;
-              input--;
-              op(output, output + stride, input);
-            }
-          }
-          output += size * stride;
-          input += size * stride;
-        }
-      } else {
-        for (int i = 0; i < count; i++) {
-          output += (size - 1) * stride;
-          input += (size - 1) * stride;
-          std::fill(output, output + stride, init);
-          for (int j = 1; j < size; j++) {
-            for (int k = 0; k < stride; k++) {
-              output--;
-              input--;
-              op(output, output + stride, input + stride);
-            }
-          }
-          output += size * stride;
-          input += size * stride;
-        }
+      std::fill(output, output + n_cols, init);
+    }
+    for (int j = 1; j < size; j++) {
+      const T* x = inclusive ? input + step : input;
+      U* prev = output;
+      input += step;
+      output += step;
+      for (int k = 0; k < n_cols; k++) {
+        output[k] = op(prev[k], static_cast<U>(x[k]));
       }
     }
   }
@@ -205,7 +328,7 @@ void scan_dispatch(
     bool inclusive) {
   switch (rtype) {
     case Scan::Sum: {
-      auto op = [](U* o, const U* y, const T* x) { *o = *y + *x; };
+      auto op = [](U y, U x) { return static_cast<U>(y + x); };
       auto init = static_cast<U>(0);
       auto opcs = DefaultContiguousScan<T, U, decltype(op)>(op, init);
       auto opss = DefaultStridedScan<T, U, decltype(op)>(op, init);
@@ -213,7 +336,7 @@ void scan_dispatch(
       break;
     }
     case Scan::Prod: {
-      auto op = [](U* o, const U* y, const T* x) { *o = *y * (*x); };
+      auto op = [](U y, U x) { return static_cast<U>(y * x); };
       auto init = static_cast<U>(1);
       auto opcs = DefaultContiguousScan<T, U, decltype(op)>(op, init);
       auto opss = DefaultStridedScan<T, U, decltype(op)>(op, init);
@@ -221,7 +344,7 @@ void scan_dispatch(
       break;
     }
     case Scan::Min: {
-      auto op = [](U* o, const U* y, const T* x) { *o = (*x < *y) ? *x : *y; };
+      auto op = [](U y, U x) { return (x < y) ? x : y; };
       auto init = (issubdtype(input.dtype(), floating))
           ? static_cast<U>(std::numeric_limits<float>::infinity())
           : std::numeric_limits<U>::max();
@@ -231,7 +354,7 @@ void scan_dispatch(
       break;
     }
     case Scan::Max: {
-      auto op = [](U* o, const U* y, const T* x) { *o = (*x < *y) ? *y : *x; };
+      auto op = [](U y, U x) { return (x < y) ? y : x; };
       auto init = (issubdtype(input.dtype(), floating))
           ? static_cast<U>(-std::numeric_limits<float>::infinity())
           : std::numeric_limits<U>::min();
@@ -0,0 +1,257 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Half precision types are accumulated in float32
+template <typename T>
+struct SegmentAcc {
+  using type = T;
+};
+
+template <>
+struct SegmentAcc<float16_t> {
+  using type = float;
+};
+
+template <>
+struct SegmentAcc<bfloat16_t> {
+  using type = float;
+};
+
+array ensure_row_contiguous(const array& x) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy(x, x_copy, CopyType::General);
+  return x_copy;
+}
+
+// The rows of segment b clamped to the n_rows of the input
+std::pair<int, int> segment_bounds(const int* offsets, int b, int n_rows) {
+  int start = std::clamp(offsets[b], 0, n_rows);
+  int end = std::clamp(offsets[b + 1], start, n_rows);
+  return {start, end};
+}
+
+// Each task reduces the rows of one segment so no two tasks write the same
+// output
+template <typename T, typename Op>
+void segmented_reduce(
+    const array& in,
+    const array& offsets,
+    array& out,
+    Op op,
+    typename SegmentAcc<T>::type init) {
+  using U = typename SegmentAcc<T>::type;
+  int n_rows = in.shape(0);
+  int n_segments = offsets.size() - 1;
+  size_t row_size = n_segments > 0 ? out.size() / n_segments : 0;
+  const T* in_ptr = in.data<T>();
+  const int* off_ptr = offsets.data<int>();
+  T* out_ptr = out.data<T>();
+
+  size_t avg_rows = std::max<size_t>(n_rows / std::max(n_segments, 1), 1);
+  size_t grain = std::max<size_t>(
+      1, min_elements_per_thread / std::max<size_t>(avg_rows * row_size, 1));
+  parallel_for(
+      n_segments,
+      [&](size_t begin, size_t end) {
+        std::vector<U> acc(row_size);
+        for (size_t b = begin; b < end; b++) {
+          auto [r0, r1] = segment_bounds(off_ptr, b, n_rows);
+          std::fill(acc.begin(), acc.end(), init);
+          for (int r = r0; r < r1; r++) {
+            const T* x = in_ptr + r * row_size;
+            for (size_t j = 0; j < row_size; j++) {
+              acc[j] = op(acc[j], static_cast<U>(x[j]));
+            }
+          }
+          T* y = out_ptr + b * row_size;
+          for (size_t j = 0; j < row_size; j++) {
+            y[j] = static_cast<T>(acc[j]);
+          }
+        }
+      },
+      grain);
+}
+
+template <typename T>
+void segmented_reduce_dispatch(
+    SegmentedReduce::ReduceType rtype,
+    const array& in,
+    const array& offsets,
+    array& out) {
+  using U = typename SegmentAcc<T>::type;
+  switch (rtype) {
+    case SegmentedReduce::Sum:
+      segmented_reduce<T>(
+          in, offsets, out, [](U a, U b) { return a + b; }, U(0));
+      break;
+    case SegmentedReduce::Max: {
+      auto init = std::numeric_limits<U>::has_infinity
+          ? -std::numeric_limits<U>::infinity()
+          : std::numeric_limits<U>::lowest();
+      segmented_reduce<T>(
+          in, offsets, out, [](U a, U b) { return b > a ? b : a; }, init);
+      break;
+    }
+    case SegmentedReduce::Min: {
+      auto init = std::numeric_limits<U>::has_infinity
+          ? std::numeric_limits<U>::infinity()
+          : std::numeric_limits<U>::max();
+      segmented_reduce<T>(
+          in, offsets, out, [](U a, U b) { return b < a ? b : a; }, init);
+      break;
+    }
+  }
+}
+
+template <typename T>
+void segmented_cumsum(
+    const array& in,
+    const array& offsets,
+    array& out,
+    bool reverse,
+    bool inclusive) {
+  using U = typename SegmentAcc<T>::type;
+  int n_rows = in.shape(0);
+  int n_segments = offsets.size() - 1;
+  size_t row_size = n_rows > 0 ? in.size() / n_rows : 0;
+  const T* in_ptr = in.data<T>();
+  const int* off_ptr = offsets.data<int>();
+  T* out_ptr = out.data<T>();
+
+  // Rows outside of every segment are zero
+  std::fill(out_ptr, out_ptr + out.size(), T(0));
+
+  size_t avg_rows = std::max<size_t>(n_rows / std::max(n_segments, 1), 1);
+  size_t grain = std::max<size_t>(
+      1, min_elements_per_thread / std::max<size_t>(avg_rows * row_size, 1));
+  parallel_for(
+      n_segments,
+      [&](size_t begin, size_t end) {
+        std::vector<U> acc(row_size);
+        for (size_t b = begin; b < end; b++) {
+          auto [r0, r1] = segment_bounds(off_ptr, b, n_rows);
+          std::fill(acc.begin(), acc.end(), U(0));
+          for (int i = 0; i < r1 - r0; i++) {
+            int r = reverse ? r1 - 1 - i : r0 + i;
+            const T* x = in_ptr + r * row_size;
+            T* y = out_ptr + r * row_size;
+            for (size_t j = 0; j < row_size; j++) {
+              if (inclusive) {
+                acc[j] += static_cast<U>(x[j]);
+                y[j] = static_cast<T>(acc[j]);
+              } else {
+                y[j] = static_cast<T>(acc[j]);
+                acc[j] += static_cast<U>(x[j]);
+              }
+            }
+          }
+        }
+      },
+      grain);
+}
+
+} // namespace
+
+void SegmentedReduce::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto in = ensure_row_contiguous(inputs[0]);
+  auto offsets = ensure_row_contiguous(inputs[1]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  switch (out.dtype()) {
+    case bool_:
+      return segmented_reduce_dispatch<bool>(reduce_type_, in, offsets, out);
+    case uint8:
+      return segmented_reduce_dispatch<uint8_t>(
+          reduce_type_, in, offsets, out);
+    case uint16:
+      return segmented_reduce_dispatch<uint16_t>(
+          reduce_type_, in, offsets, out);
+    case uint32:
+      return segmented_reduce_dispatch<uint32_t>(
+          reduce_type_, in, offsets, out);
+    case uint64:
+      return segmented_reduce_dispatch<uint64_t>(
+          reduce_type_, in, offsets, out);
+    case int8:
+      return segmented_reduce_dispatch<int8_t>(reduce_type_, in, offsets, out);
+    case int16:
+      return segmented_reduce_dispatch<int16_t>(
+          reduce_type_, in, offsets, out);
+    case int32:
+      return segmented_reduce_dispatch<int32_t>(
+          reduce_type_, in, offsets, out);
+    case int64:
+      return segmented_reduce_dispatch<int64_t>(
+          reduce_type_, in, offsets, out);
+    case float16:
+      return segmented_reduce_dispatch<float16_t>(
+          reduce_type_, in, offsets, out);
+    case bfloat16:
+      return segmented_reduce_dispatch<bfloat16_t>(
+          reduce_type_, in, offsets, out);
+    case float32:
+      return segmented_reduce_dispatch<float>(reduce_type_, in, offsets, out);
+    default:
+      throw std::runtime_error(
+          "[SegmentedReduce::eval] Complex types are not supported.");
+  }
+}
+
+void SegmentedScan::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto in = ensure_row_contiguous(inputs[0]);
+  auto offsets = ensure_row_contiguous(inputs[1]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  switch (out.dtype()) {
+    case uint8:
+      return segmented_cumsum<uint8_t>(in, offsets, out, reverse_, inclusive_);
+    case uint16:
+      return segmented_cumsum<uint16_t>(
+          in, offsets, out, reverse_, inclusive_);
+    case uint32:
+      return segmented_cumsum<uint32_t>(
+          in, offsets, out, reverse_, inclusive_);
+    case uint64:
+      return segmented_cumsum<uint64_t>(
+          in, offsets, out, reverse_, inclusive_);
+    case int8:
+      return segmented_cumsum<int8_t>(in, offsets, out, reverse_, inclusive_);
+    case int16:
+      return segmented_cumsum<int16_t>(in, offsets, out, reverse_, inclusive_);
+    case int32:
+      return segmented_cumsum<int32_t>(in, offsets, out, reverse_, inclusive_);
+    case int64:
+      return segmented_cumsum<int64_t>(in, offsets, out, reverse_, inclusive_);
+    case float16:
+      return segmented_cumsum<float16_t>(
+          in, offsets, out, reverse_, inclusive_);
+    case bfloat16:
+      return segmented_cumsum<bfloat16_t>(
+          in, offsets, out, reverse_, inclusive_);
+    case float32:
+      return segmented_cumsum<float>(in, offsets, out, reverse_, inclusive_);
+    default:
+      throw std::runtime_error(
+          "[SegmentedScan::eval] Boolean and complex types are not supported.");
+  }
+}
+
+} // namespace mlx::core
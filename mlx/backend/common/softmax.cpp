@@ -1,61 +1,186 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
 
+#include "mlx/backend/common/convert.h"
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/ops.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
 
 namespace {
 
-template <typename T, typename AccT>
-void softmax(const array& in, array& out) {
-  const T* in_ptr = in.data<T>();
-  T* out_ptr = out.data<T>();
-  int N = in.shape().back();
-  int M = in.data_size() / N;
-  const T* current_in_ptr;
-  T* current_out_ptr;
-
-  for (int i = 0; i < M; i++, in_ptr += N, out_ptr += N) {
-    // Find the maximum
-    current_in_ptr = in_ptr;
-    AccT maximum = *current_in_ptr;
-    for (int j = 0; j < N; j++, current_in_ptr++) {
-      maximum = (maximum < *current_in_ptr) ? static_cast<AccT>(*current_in_ptr)
-                                            : maximum;
+// Elements of a row processed at a time. A chunk is converted to float once
+// and stays in L1 while its max and exponentials are computed.
+constexpr int SOFTMAX_CHUNK = 256;
+constexpr int SOFTMAX_LANES = 8;
+
+using detail::fast_exp;
+using detail::float_key;
+using detail::from_float_key;
+
+/* Computes the max of a row and the sum of exp(x - max) reading the row once.
+ * Every chunk updates the running max and rescales the running sum when the
+ * max grows (the online softmax), so only one exponential per element is
+ * needed.
+ *
+ * When exps is given the exponentials are also written there relative to
+ * the running max at their chunk, which is saved in chunk_maxes.
+ * */
+template <typename T>
+void online_max_sum(
+    const T* x,
+    int n,
+    float& maxval,
+    float& normalizer,
+    float* exps = nullptr,
+    float* chunk_maxes = nullptr) {
+  constexpr float neg_inf = -std::numeric_limits<float>::infinity();
+  float buf[SOFTMAX_CHUNK];
+  maxval = neg_inf;
+  normalizer = 0;
+  for (int start = 0, c = 0; start < n; start += SOFTMAX_CHUNK, c++) {
+    int len = std::min(SOFTMAX_CHUNK, n - start);
+    const float* v = load_chunk(x + start, len, buf);
+
+    // The max is taken over integer keys ordered like the floats since
+    // float compares do not vectorize without -fno-trapping-math
+    int32_t lanes[SOFTMAX_LANES];
+    std::fill_n(lanes, SOFTMAX_LANES, float_key(neg_inf));
+    int i = 0;
+    for (; i + SOFTMAX_LANES <= len; i += SOFTMAX_LANES) {
+      for (int l = 0; l < SOFTMAX_LANES; l++) {
+        lanes[l] = std::max(lanes[l], float_key(v[i + l]));
+      }
+    }
+    for (; i < len; i++) {
+      lanes[0] = std::max(lanes[0], float_key(v[i]));
+    }
+    float chunk_max =
+        from_float_key(*std::max_element(lanes, lanes + SOFTMAX_LANES));
+
+    if (maxval < chunk_max) {
+      normalizer *= fast_exp(maxval - chunk_max);
+      maxval = chunk_max;
+    }
+    if (exps != nullptr) {
+      chunk_maxes[c] = maxval;
+    }
+    // Until a finite value is seen every exponential so far is exp(-inf)
+    if (maxval == neg_inf) {
+      if (exps != nullptr) {
+        std::fill_n(exps + start, len, 0.0f);
+      }
+      continue;
     }
 
-    // Compute the normalizer and the exponentials
-    AccT normalizer = 0;
-    current_out_ptr = out_ptr;
-    current_in_ptr = in_ptr;
-    for (int j = 0; j < N; j++, current_out_ptr++, current_in_ptr++) {
-      AccT expv = std::exp(*current_in_ptr - maximum);
-      normalizer += expv;
-      if constexpr (std::is_same<T, AccT>::value) {
-        *current_out_ptr = expv;
+    float sums[SOFTMAX_LANES] = {0};
+    i = 0;
+    if (exps != nullptr) {
+      float* e = exps + start;
+      for (; i + SOFTMAX_LANES <= len; i += SOFTMAX_LANES) {
+        for (int l = 0; l < SOFTMAX_LANES; l++) {
+          e[i + l] = fast_exp(v[i + l] - maxval);
+          sums[l] += e[i + l];
+        }
+      }
+    } else {
+      for (; i + SOFTMAX_LANES <= len; i += SOFTMAX_LANES) {
+        for (int l = 0; l < SOFTMAX_LANES; l++) {
+          sums[l] += fast_exp(v[i + l] - maxval);
+        }
       }
     }
-    normalizer = 1 / normalizer;
-
-    // Normalize
-    current_in_ptr = in_ptr;
-    current_out_ptr = out_ptr;
-    for (int j = 0; j < N; j++, current_out_ptr++) {
-      if constexpr (std::is_same<T, AccT>::value) {
-        *current_out_ptr *= normalizer;
-      } else {
-        auto v = std::exp(*current_in_ptr - maximum);
-        *current_out_ptr = static_cast<T>(v * normalizer);
-        current_in_ptr++;
+    for (; i < len; i++) {
+      float e = fast_exp(v[i] - maxval);
+      if (exps != nullptr) {
+        exps[start + i] = e;
       }
+      sums[0] += e;
     }
+    for (int l = 0; l < SOFTMAX_LANES; l++) {
+      normalizer += sums[l];
+    }
+  }
+  // Without finite values the result is NaN as with separate passes
+  if (maxval == neg_inf) {
+    normalizer = std::numeric_limits<float>::quiet_NaN();
   }
 }
 
+template <typename T>
+void softmax(const array& in, array& out) {
+  const T* in_ptr = in.data<T>();
+  T* out_ptr = out.data<T>();
+  int N = in.shape().back();
+  int M = in.data_size() / N;
+
+  parallel_for(
+      M,
+      [&](size_t begin, size_t end) {
+        float buf[SOFTMAX_CHUNK];
+        std::vector<float> chunk_maxes((N + SOFTMAX_CHUNK - 1) / SOFTMAX_CHUNK);
+        for (size_t row = begin; row < end; row++) {
+          const T* x = in_ptr + row * N;
+          T* y = out_ptr + row * N;
+          float maxval, normalizer;
+
+          // Float outputs keep the exponentials from the first pass and only
+          // rescale them, otherwise they are recomputed from the input
+          if constexpr (std::is_same_v<T, float>) {
+            online_max_sum(x, N, maxval, normalizer, y, chunk_maxes.data());
+            normalizer = 1 / normalizer;
+            for (int start = 0, c = 0; start < N; start += SOFTMAX_CHUNK, c++) {
+              int len = std::min(SOFTMAX_CHUNK, N - start);
+              float scale = fast_exp(chunk_maxes[c] - maxval) * normalizer;
+              for (int i = 0; i < len; i++) {
+                y[start + i] *= scale;
+              }
+            }
+          } else {
+            online_max_sum(x, N, maxval, normalizer);
+            normalizer = 1 / normalizer;
+            for (int start = 0; start < N; start += SOFTMAX_CHUNK) {
+              int len = std::min(SOFTMAX_CHUNK, N - start);
+              const float* v = load_chunk(x + start, len, buf);
+              for (int i = 0; i < len; i++) {
+                y[start + i] =
+                    static_cast<T>(fast_exp(v[i] - maxval) * normalizer);
+              }
+            }
+          }
+        }
+      },
+      std::max(1, int(min_elements_per_thread) / std::max(N, 1)));
+}
+
+template <typename T>
+void logsumexp(const array& in, array& out) {
+  const T* in_ptr = in.data<T>();
+  T* out_ptr = out.data<T>();
+  int N = in.shape().back();
+  int M = in.size() / N;
+
+  parallel_for(
+      M,
+      [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+          float maxval, normalizer;
+          online_max_sum(in_ptr + row * N, N, maxval, normalizer);
+          out_ptr[row] = static_cast<T>(
+              std::isinf(maxval) ? maxval : maxval + std::log(normalizer));
+        }
+      },
+      std::max(1, int(min_elements_per_thread) / std::max(N, 1)));
+}
+
 } // namespace
 
 void Softmax::eval(const std::vector<array>& inputs, array& out) {
@@ -87,6 +212,8 @@ void Softmax::eval(const std::vector<array>& inputs, array& out) {
         in.flags());
   }
 
+  // Half precision inputs are always accumulated in float on the CPU so
+  // precise_ does not change the kernel
   switch (in.dtype()) {
     case bool_:
     case uint8:
@@ -101,21 +228,13 @@ void Softmax::eval(const std::vector<array>& inputs, array& out) {
           "Softmax is defined only for floating point types");
       break;
     case float32:
-      softmax<float, float>(in, out);
+      softmax<float>(in, out);
       break;
     case float16:
-      if (precise_) {
-        softmax<float16_t, float>(in, out);
-      } else {
-        softmax<float16_t, float16_t>(in, out);
-      }
+      softmax<float16_t>(in, out);
       break;
     case bfloat16:
-      if (precise_) {
-        softmax<bfloat16_t, float>(in, out);
-      } else {
-        softmax<bfloat16_t, bfloat16_t>(in, out);
-      }
+      softmax<bfloat16_t>(in, out);
       break;
     case complex64:
       throw std::invalid_argument(
@@ -124,4 +243,32 @@ void Softmax::eval(const std::vector<array>& inputs, array& out) {
   }
 }
 
+void LogSumExp::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+
+  // Make sure that the rows are contiguous
+  auto in = inputs[0];
+  if (!in.flags().row_contiguous) {
+    array in_copy(in.shape(), in.dtype(), nullptr, {});
+    copy(in, in_copy, CopyType::General);
+    in = in_copy;
+  }
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  switch (in.dtype()) {
+    case float32:
+      logsumexp<float>(in, out);
+      break;
+    case float16:
+      logsumexp<float16_t>(in, out);
+      break;
+    case bfloat16:
+      logsumexp<bfloat16_t>(in, out);
+      break;
+    default:
+      throw std::invalid_argument(
+          "[LogSumExp] Only defined for floating point types");
+  }
+}
+
 } // namespace mlx::core
@@ -0,0 +1,141 @@
+// Copyright © 2024 Apple Inc.
+
+#include <cassert>
+#include <cstring>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
+#include "mlx/primitives.h"
+
+#ifdef ACCELERATE_NEW_LAPACK
+#include <Accelerate/Accelerate.h>
+#else
+#include <lapack.h>
+#endif
+
+namespace mlx::core {
+
+namespace {
+
+array ensure_row_contiguous(const array& x) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy(x, x_copy, CopyType::General);
+  return x_copy;
+}
+
+// Delegate to the LU solve taking into account differences in LAPACK
+// implementations (basically how to pass the 'trans' string to fortran).
+int sgetrs_wrapper(
+    char trans,
+    int N,
+    int K,
+    float* lu,
+    int* ipiv,
+    float* rhs) {
+  int info;
+
+#ifdef LAPACK_FORTRAN_STRLEN_END
+  sgetrs_(
+      /* trans = */ &trans,
+      /* n = */ &N,
+      /* nrhs = */ &K,
+      /* a = */ lu,
+      /* lda = */ &N,
+      /* ipiv = */ ipiv,
+      /* b = */ rhs,
+      /* ldb = */ &N,
+      /* info = */ &info,
+      /* trans_len = */ static_cast<size_t>(1));
+#else
+  sgetrs_(
+      /* trans = */ &trans,
+      /* n = */ &N,
+      /* nrhs = */ &K,
+      /* a = */ lu,
+      /* lda = */ &N,
+      /* ipiv = */ ipiv,
+      /* b = */ rhs,
+      /* ldb = */ &N,
+      /* info = */ &info);
+#endif
+
+  return info;
+}
+
+} // namespace
+
+void Solve::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  if (inputs[0].dtype() != float32) {
+    throw std::runtime_error("[Solve::eval] only supports float32.");
+  }
+  auto a = ensure_row_contiguous(inputs[0]);
+  auto b = ensure_row_contiguous(inputs[1]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  const int N = a.shape(-1);
+  const int K = out.shape(-1);
+  if (N == 0 || K == 0) {
+    return;
+  }
+  const size_t num_matrices = out.size() / (size_t(N) * K);
+
+  // LAPACK sees the transpose of the row-major a, so its LU factorization
+  // is followed by a transposed solve. The right hand side is transposed to
+  // column-major and back in a workspace.
+  size_t grain = std::max<size_t>(
+      1, min_elements_per_thread / (size_t(N) * N * (N + K)));
+  parallel_for(
+      num_matrices,
+      [&](size_t begin, size_t end) {
+        auto lu = array::Data{allocator::malloc_or_wait(sizeof(float) * N * N)};
+        auto rhs =
+            array::Data{allocator::malloc_or_wait(sizeof(float) * N * K)};
+        auto ipiv = array::Data{allocator::malloc_or_wait(sizeof(int) * N)};
+        float* lu_ptr = static_cast<float*>(lu.buffer.raw_ptr());
+        float* rhs_ptr = static_cast<float*>(rhs.buffer.raw_ptr());
+        int* ipiv_ptr = static_cast<int*>(ipiv.buffer.raw_ptr());
+        for (size_t i = begin; i < end; i++) {
+          const float* a_i = a.data<float>() + size_t(N) * N * i;
+          const float* b_i = b.data<float>() + size_t(N) * K * i;
+          float* x_i = out.data<float>() + size_t(N) * K * i;
+          std::memcpy(lu_ptr, a_i, sizeof(float) * N * N);
+          for (int r = 0; r < N; r++) {
+            for (int c = 0; c < K; c++) {
+              rhs_ptr[c * N + r] = b_i[r * K + c];
+            }
+          }
+
+          int info;
+          sgetrf_(
+              /* m = */ &N,
+              /* n = */ &N,
+              /* a = */ lu_ptr,
+              /* lda = */ &N,
+              /* ipiv = */ ipiv_ptr,
+              /* info = */ &info);
+          if (info == 0) {
+            info = sgetrs_wrapper('T', N, K, lu_ptr, ipiv_ptr, rhs_ptr);
+          }
+          if (info != 0) {
+            std::stringstream msg;
+            msg << "[linalg::solve] LU solve failed with error code " << info
+                << (info > 0 ? ", the matrix is singular." : ".");
+            throw std::runtime_error(msg.str());
+          }
+
+          for (int r = 0; r < N; r++) {
+            for (int c = 0; c < K; c++) {
+              x_i[r * K + c] = rhs_ptr[c * N + r];
+            }
+          }
+        }
+      },
+      grain);
+}
+
+} // namespace mlx::core
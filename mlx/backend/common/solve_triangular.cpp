@@ -0,0 +1,72 @@
+// Copyright © 2024 Apple Inc.
+
+#ifdef ACCELERATE_NEW_LAPACK
+#include <Accelerate/Accelerate.h>
+#else
+#include <cblas.h>
+#endif
+#include <cassert>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+array ensure_row_contiguous(const array& x) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy(x, x_copy, CopyType::General);
+  return x_copy;
+}
+
+} // namespace
+
+void SolveTriangular::eval(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  if (inputs[0].dtype() != float32) {
+    throw std::runtime_error("[SolveTriangular::eval] only supports float32.");
+  }
+  auto a = ensure_row_contiguous(inputs[0]);
+
+  // The solve happens in place in the output
+  auto& b = inputs[1];
+  copy(b, out, b.flags().row_contiguous ? CopyType::Vector : CopyType::General);
+
+  const int N = a.shape(-1);
+  const int K = out.shape(-1);
+  if (N == 0 || K == 0) {
+    return;
+  }
+  const size_t num_matrices = out.size() / (size_t(N) * K);
+  size_t grain = std::max<size_t>(
+      1, min_elements_per_thread / (size_t(N) * N * K / 2 + 1));
+  parallel_for(
+      num_matrices,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          // Only the requested triangle of a is read
+          cblas_strsm(
+              CblasRowMajor,
+              CblasLeft,
+              upper_ ? CblasUpper : CblasLower,
+              CblasNoTrans,
+              CblasNonUnit,
+              /* M = */ N,
+              /* N = */ K,
+              /* alpha = */ 1.0f,
+              /* A = */ a.data<float>() + size_t(N) * N * i,
+              /* lda = */ N,
+              /* B = */ out.data<float>() + size_t(N) * K * i,
+              /* ldb = */ K);
+        }
+      },
+      grain);
+}
+
+} // namespace mlx::core
@@ -3,9 +3,13 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 #include <numeric>
+#include <type_traits>
 
 #include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/utils.h"
 
 #include "mlx/primitives.h"
@@ -103,6 +107,235 @@ struct StridedIterator {
   T* ptr_;
 };
 
+// Rows at least this long are radix sorted when the type has a radix key
+constexpr int min_radix_sort_size = 128;
+
+// Partitions where at most this many elements fall on one side of kth select
+// that side with a heap instead of std::nth_element, as for topk with small k
+constexpr int max_heap_select_size = 32;
+
+template <size_t N>
+struct UIntOfSize;
+template <>
+struct UIntOfSize<1> {
+  using type = uint8_t;
+};
+template <>
+struct UIntOfSize<2> {
+  using type = uint16_t;
+};
+template <>
+struct UIntOfSize<4> {
+  using type = uint32_t;
+};
+template <>
+struct UIntOfSize<8> {
+  using type = uint64_t;
+};
+
+template <typename T>
+constexpr bool is_float_v = std::is_floating_point_v<T> ||
+    std::is_same_v<T, float16_t> || std::is_same_v<T, bfloat16_t>;
+
+// Maps T to an unsigned integer key with the same ordering, with NaNs mapped
+// to the largest key so they are sorted last and both zeros mapped to the
+// same key so they keep their order like with less().
+template <typename T, typename = void>
+struct RadixKey {
+  static constexpr bool enabled = false;
+  using type = uint8_t;
+};
+
+template <typename T>
+struct RadixKey<T, std::enable_if_t<std::is_integral_v<T>>> {
+  static constexpr bool enabled = true;
+  using type = typename UIntOfSize<sizeof(T)>::type;
+  static constexpr type sign =
+      std::is_signed_v<T> ? type(type(1) << (8 * sizeof(T) - 1)) : type(0);
+
+  static type encode(T x) {
+    return static_cast<type>(x) ^ sign;
+  }
+  static T decode(type k) {
+    return static_cast<T>(type(k ^ sign));
+  }
+};
+
+template <typename T>
+struct RadixKey<T, std::enable_if_t<is_float_v<T>>> {
+  static constexpr bool enabled = true;
+  using type = typename UIntOfSize<sizeof(T)>::type;
+  static constexpr type sign = type(1) << (8 * sizeof(T) - 1);
+
+  static type encode(T x) {
+    if (std::isnan(static_cast<float>(x))) {
+      return ~type(0);
+    }
+    if (static_cast<float>(x) == 0) {
+      return sign;
+    }
+    return encode_exact(x);
+  }
+  // Keeps the sign of zero so that decode gives back x
+  static type encode_exact(T x) {
+    type bits;
+    std::memcpy(&bits, &x, sizeof(T));
+    return (bits & sign) ? type(~bits) : type(bits | sign);
+  }
+  static T decode(type k) {
+    type bits = (k & sign) ? type(k & ~sign) : type(~k);
+    T x;
+    std::memcpy(&x, &bits, sizeof(T));
+    return x;
+  }
+};
+
+// Orders NaNs after every other value like the radix keys
+template <typename T>
+bool less(const T& a, const T& b) {
+  if constexpr (is_float_v<T>) {
+    return a < b ||
+        (std::isnan(static_cast<float>(b)) &&
+         !std::isnan(static_cast<float>(a)));
+  } else {
+    return a < b;
+  }
+}
+
+/* Stable LSD radix sort of n keys, 8 bits per pass, moving idx along with
+ * the keys when it isn't null. keys_tmp and idx_tmp are scratch space of the
+ * same size. Passes where every key has the same digit are skipped. The
+ * sorted keys and indices end up in keys and idx.
+ * */
+template <typename K, typename IdxT>
+void radix_sort(K* keys, IdxT* idx, K* keys_tmp, IdxT* idx_tmp, int n) {
+  if (n <= 0) {
+    return;
+  }
+  K* src_keys = keys;
+  IdxT* src_idx = idx;
+  for (int shift = 0; shift < 8 * int(sizeof(K)); shift += 8) {
+    int counts[256] = {};
+    for (int i = 0; i < n; i++) {
+      counts[(src_keys[i] >> shift) & 0xFF]++;
+    }
+    if (counts[(src_keys[0] >> shift) & 0xFF] == n) {
+      continue;
+    }
+    for (int d = 0, offset = 0; d < 256; d++) {
+      int count = counts[d];
+      counts[d] = offset;
+      offset += count;
+    }
+    for (int i = 0; i < n; i++) {
+      int pos = counts[(src_keys[i] >> shift) & 0xFF]++;
+      keys_tmp[pos] = src_keys[i];
+      if (idx != nullptr) {
+        idx_tmp[pos] = src_idx[i];
+      }
+    }
+    std::swap(src_keys, keys_tmp);
+    std::swap(src_idx, idx_tmp);
+  }
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + n, keys);
+    if (idx != nullptr) {
+      std::copy(src_idx, src_idx + n, idx);
+    }
+  }
+}
+
+/* Partitions [first, last) around kth with less_fn. When few elements fall
+ * before or after kth they are selected with a heap, otherwise this is
+ * std::nth_element.
+ * */
+template <typename T, typename Compare>
+void select(T* first, T* last, int kth, Compare less_fn) {
+  int n = last - first;
+  if (kth + 1 <= max_heap_select_size) {
+    std::partial_sort(first, first + kth + 1, last, less_fn);
+  } else if (n - kth <= max_heap_select_size) {
+    // Select the largest elements from the back
+    std::partial_sort(
+        std::make_reverse_iterator(last),
+        std::make_reverse_iterator(first + kth),
+        std::make_reverse_iterator(first),
+        [&less_fn](const T& a, const T& b) { return less_fn(b, a); });
+  } else {
+    std::nth_element(first, first + kth, last, less_fn);
+  }
+}
+
+// The rows along an axis which are sorted independently, located in the
+// input and in the output which may have different strides
+struct SortRows {
+  size_t n_rows;
+  std::vector<int> shape;
+  std::vector<size_t> in_strides;
+  std::vector<size_t> out_strides;
+  size_t in_axis_stride;
+  size_t out_axis_stride;
+  int axis_size;
+
+  SortRows(const array& in, const array& out, int axis)
+      : n_rows(in.size() / in.shape(axis)),
+        shape(in.shape()),
+        in_strides(in.strides()),
+        out_strides(out.strides()),
+        in_axis_stride(in.strides()[axis]),
+        out_axis_stride(out.strides()[axis]),
+        axis_size(in.shape(axis)) {
+    shape.erase(shape.begin() + axis);
+    in_strides.erase(in_strides.begin() + axis);
+    out_strides.erase(out_strides.begin() + axis);
+  }
+
+  // Call f(in_loc, out_loc, scratch) for every row on the CPU thread pool
+  // where scratch is a Scratch made once per thread.
+  template <typename Scratch, typename F>
+  void for_each(F&& f) const {
+    parallel_for(
+        n_rows,
+        [&](size_t begin, size_t end) {
+          Scratch scratch(axis_size);
+          for (size_t i = begin; i < end; i++) {
+            f(elem_to_loc(i, shape, in_strides),
+              elem_to_loc(i, shape, out_strides),
+              scratch);
+          }
+        },
+        std::max<size_t>(1, min_elements_per_thread / std::max(axis_size, 1)));
+  }
+};
+
+// Per thread buffers holding a row of values, its keys and its indices. The
+// values are kept in raw storage since not every T is default constructible.
+template <typename T, typename IdxT>
+struct RowScratch {
+  using K = typename RadixKey<T>::type;
+  std::vector<char> vals_storage;
+  std::vector<IdxT> idx;
+  std::vector<IdxT> idx_tmp;
+  std::vector<K> keys;
+  std::vector<K> keys_tmp;
+
+  explicit RowScratch(int size) : vals_storage(size * sizeof(T)), idx(size) {
+    if (use_radix(size)) {
+      idx_tmp.resize(size);
+      keys.resize(size);
+      keys_tmp.resize(size);
+    }
+  }
+
+  T* vals() {
+    return reinterpret_cast<T*>(vals_storage.data());
+  }
+
+  static bool use_radix(int size) {
+    return RadixKey<T>::enabled && size >= min_radix_sort_size;
+  }
+};
+
 template <typename T, typename IdxT = uint32_t>
 void sort(const array& in, array& out, int axis) {
   // Copy input to output
@@ -111,27 +344,55 @@ void sort(const array& in, array& out, int axis) {
 
   // Get axis, shape and stride info
   axis = axis < 0 ? axis + in.ndim() : axis;
-  size_t n_rows = in.size() / in.shape(axis);
-
-  auto remaining_shape = in.shape();
-  remaining_shape.erase(remaining_shape.begin() + axis);
-
-  auto remaining_strides = in.strides();
-  remaining_strides.erase(remaining_strides.begin() + axis);
+  SortRows rows(out, out, axis);
+  size_t axis_stride = rows.out_axis_stride;
+  int axis_size = rows.axis_size;
 
-  size_t axis_stride = in.strides()[axis];
-  int axis_size = in.shape(axis);
-
-  // Perform sorting in place
-  for (int i = 0; i < n_rows; i++) {
-    size_t loc = elem_to_loc(i, remaining_shape, remaining_strides);
+  // Perform sorting in place, in a contiguous copy for strided rows
+  rows.for_each<RowScratch<T, IdxT>>([&](size_t, size_t loc, auto& scratch) {
     T* data_ptr = out.data<T>() + loc;
-
-    StridedIterator st(data_ptr, axis_stride, 0);
-    StridedIterator ed(data_ptr, axis_stride, axis_size);
-
-    std::stable_sort(st, ed);
-  }
+    T* row = axis_stride == 1 ? data_ptr : scratch.vals();
+    if (axis_stride != 1) {
+      for (int j = 0; j < axis_size; j++) {
+        row[j] = data_ptr[j * axis_stride];
+      }
+    }
+
+    if constexpr (RadixKey<T>::enabled) {
+      if (scratch.use_radix(axis_size)) {
+        auto& keys = scratch.keys;
+        for (int j = 0; j < axis_size; j++) {
+          keys[j] = RadixKey<T>::encode(row[j]);
+        }
+        radix_sort<typename RadixKey<T>::type, IdxT>(
+            keys.data(), nullptr, scratch.keys_tmp.data(), nullptr, axis_size);
+        if constexpr (is_float_v<T>) {
+          // The zeros are sorted together in their input order, put their
+          // signs back before decoding
+          auto zero = std::lower_bound(
+              keys.begin(), keys.begin() + axis_size, RadixKey<T>::sign);
+          for (int j = 0; j < axis_size; j++) {
+            if (static_cast<float>(row[j]) == 0) {
+              *zero++ = RadixKey<T>::encode_exact(row[j]);
+            }
+          }
+        }
+        for (int j = 0; j < axis_size; j++) {
+          row[j] = RadixKey<T>::decode(keys[j]);
+        }
+      } else {
+        std::stable_sort(row, row + axis_size, less<T>);
+      }
+    } else {
+      std::stable_sort(row, row + axis_size, less<T>);
+    }
+
+    if (axis_stride != 1) {
+      for (int j = 0; j < axis_size; j++) {
+        data_ptr[j * axis_stride] = row[j];
+      }
+    }
+  });
 }
 
 template <typename T, typename IdxT = uint32_t>
@@ -141,39 +402,53 @@ void argsort(const array& in, array& out, int axis) {
 
   // Get axis, shape and stride info
   axis = axis < 0 ? axis + in.ndim() : axis;
-  size_t n_rows = in.size() / in.shape(axis);
-
-  auto remaining_shape = in.shape();
-  remaining_shape.erase(remaining_shape.begin() + axis);
-
-  auto remaining_strides = in.strides();
-  remaining_strides.erase(remaining_strides.begin() + axis);
-
-  size_t axis_stride = in.strides()[axis];
-  int axis_size = in.shape(axis);
+  SortRows rows(in, out, axis);
+  size_t in_axis_stride = rows.in_axis_stride;
+  size_t out_axis_stride = rows.out_axis_stride;
+  int axis_size = rows.axis_size;
 
   // Perform sorting
-  for (int i = 0; i < n_rows; i++) {
-    size_t loc = elem_to_loc(i, remaining_shape, remaining_strides);
-    const T* data_ptr = in.data<T>() + loc;
-    IdxT* idx_ptr = out.data<IdxT>() + loc;
-
-    StridedIterator st_(idx_ptr, axis_stride, 0);
-    StridedIterator ed_(idx_ptr, axis_stride, axis_size);
-
-    // Initialize with iota
-    std::iota(st_, ed_, IdxT(0));
-
-    // Sort according to vals
-    StridedIterator st(idx_ptr, axis_stride, 0);
-    StridedIterator ed(idx_ptr, axis_stride, axis_size);
-
-    std::stable_sort(st, ed, [data_ptr, axis_stride](IdxT a, IdxT b) {
-      auto v1 = data_ptr[a * axis_stride];
-      auto v2 = data_ptr[b * axis_stride];
-      return v1 < v2 || (v1 == v2 && a < b);
-    });
-  }
+  rows.for_each<RowScratch<T, IdxT>>(
+      [&](size_t in_loc, size_t out_loc, auto& scratch) {
+        const T* data_ptr = in.data<T>() + in_loc;
+        IdxT* idx_ptr = out.data<IdxT>() + out_loc;
+        IdxT* idx = scratch.idx.data();
+
+        // Initialize with iota
+        std::iota(idx, idx + axis_size, IdxT(0));
+
+        // Sort according to vals. Both paths are stable so equal values keep
+        // the order of their indices.
+        bool sorted = false;
+        if constexpr (RadixKey<T>::enabled) {
+          if (scratch.use_radix(axis_size)) {
+            auto& keys = scratch.keys;
+            for (int j = 0; j < axis_size; j++) {
+              keys[j] = RadixKey<T>::encode(data_ptr[j * in_axis_stride]);
+            }
+            radix_sort(
+                keys.data(),
+                idx,
+                scratch.keys_tmp.data(),
+                scratch.idx_tmp.data(),
+                axis_size);
+            sorted = true;
+          }
+        }
+        if (!sorted) {
+          T* vals = scratch.vals();
+          for (int j = 0; j < axis_size; j++) {
+            vals[j] = data_ptr[j * in_axis_stride];
+          }
+          std::stable_sort(idx, idx + axis_size, [vals](IdxT a, IdxT b) {
+            return less(vals[a], vals[b]);
+          });
+        }
+
+        for (int j = 0; j < axis_size; j++) {
+          idx_ptr[j * out_axis_stride] = idx[j];
+        }
+      });
 }
 
 template <typename T, typename IdxT = uint32_t>
@@ -184,30 +459,30 @@ void partition(const array& in, array& out, int axis, int kth) {
 
   // Get axis, shape and stride info
   axis = axis < 0 ? axis + in.ndim() : axis;
-  size_t n_rows = in.size() / in.shape(axis);
-
-  auto remaining_shape = in.shape();
-  remaining_shape.erase(remaining_shape.begin() + axis);
-
-  auto remaining_strides = in.strides();
-  remaining_strides.erase(remaining_strides.begin() + axis);
-
-  size_t axis_stride = in.strides()[axis];
-  int axis_size = in.shape(axis);
+  SortRows rows(out, out, axis);
+  size_t axis_stride = rows.out_axis_stride;
+  int axis_size = rows.axis_size;
 
   kth = kth < 0 ? kth + axis_size : kth;
 
-  // Perform partition in place
-  for (int i = 0; i < n_rows; i++) {
-    size_t loc = elem_to_loc(i, remaining_shape, remaining_strides);
+  // Perform partition in place, in a contiguous copy for strided rows
+  rows.for_each<RowScratch<T, IdxT>>([&](size_t, size_t loc, auto& scratch) {
     T* data_ptr = out.data<T>() + loc;
-
-    StridedIterator st(data_ptr, axis_stride, 0);
-    StridedIterator md(data_ptr, axis_stride, kth);
-    StridedIterator ed(data_ptr, axis_stride, axis_size);
-
-    std::nth_element(st, md, ed);
-  }
+    T* row = axis_stride == 1 ? data_ptr : scratch.vals();
+    if (axis_stride != 1) {
+      for (int j = 0; j < axis_size; j++) {
+        row[j] = data_ptr[j * axis_stride];
+      }
+    }
+
+    select(row, row + axis_size, kth, less<T>);
+
+    if (axis_stride != 1) {
+      for (int j = 0; j < axis_size; j++) {
+        data_ptr[j * axis_stride] = row[j];
+      }
+    }
+  });
 }
 
 template <typename T, typename IdxT = uint32_t>
@@ -217,42 +492,36 @@ void argpartition(const array& in, array& out, int axis, int kth) {
 
   // Get axis, shape and stride info
   axis = axis < 0 ? axis + in.ndim() : axis;
-  size_t n_rows = in.size() / in.shape(axis);
-
-  auto remaining_shape = in.shape();
-  remaining_shape.erase(remaining_shape.begin() + axis);
-
-  auto remaining_strides = in.strides();
-  remaining_strides.erase(remaining_strides.begin() + axis);
-
-  size_t axis_stride = in.strides()[axis];
-  int axis_size = in.shape(axis);
+  SortRows rows(in, out, axis);
+  size_t in_axis_stride = rows.in_axis_stride;
+  size_t out_axis_stride = rows.out_axis_stride;
+  int axis_size = rows.axis_size;
 
   kth = kth < 0 ? kth + axis_size : kth;
 
   // Perform partition
-  for (int i = 0; i < n_rows; i++) {
-    size_t loc = elem_to_loc(i, remaining_shape, remaining_strides);
-    const T* data_ptr = in.data<T>() + loc;
-    IdxT* idx_ptr = out.data<IdxT>() + loc;
-
-    StridedIterator st_(idx_ptr, axis_stride, 0);
-    StridedIterator ed_(idx_ptr, axis_stride, axis_size);
-
-    // Initialize with iota
-    std::iota(st_, ed_, IdxT(0));
-
-    // Sort according to vals
-    StridedIterator st(idx_ptr, axis_stride, 0);
-    StridedIterator md(idx_ptr, axis_stride, kth);
-    StridedIterator ed(idx_ptr, axis_stride, axis_size);
-
-    std::nth_element(st, md, ed, [data_ptr, axis_stride](IdxT a, IdxT b) {
-      auto v1 = data_ptr[a * axis_stride];
-      auto v2 = data_ptr[b * axis_stride];
-      return v1 < v2 || (v1 == v2 && a < b);
-    });
-  }
+  rows.for_each<RowScratch<T, IdxT>>(
+      [&](size_t in_loc, size_t out_loc, auto& scratch) {
+        const T* data_ptr = in.data<T>() + in_loc;
+        IdxT* idx_ptr = out.data<IdxT>() + out_loc;
+        T* vals = scratch.vals();
+        IdxT* idx = scratch.idx.data();
+
+        // Initialize with iota
+        std::iota(idx, idx + axis_size, IdxT(0));
+        for (int j = 0; j < axis_size; j++) {
+          vals[j] = data_ptr[j * in_axis_stride];
+        }
+
+        // Partition according to vals
+        select(idx, idx + axis_size, kth, [vals](IdxT a, IdxT b) {
+          return less(vals[a], vals[b]) || (!less(vals[b], vals[a]) && a < b);
+        });
+
+        for (int j = 0; j < axis_size; j++) {
+          idx_ptr[j * out_axis_stride] = idx[j];
+        }
+      });
 }
 
 } // namespace
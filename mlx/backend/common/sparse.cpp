@@ -0,0 +1,206 @@
+// Copyright © 2024 Apple Inc.
+
+#include <vector>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/common/copy.h"
+#include "mlx/backend/common/threading.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// The kernels index the inputs as row contiguous
+array ensure_row_contiguous(const array& x) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy(x, x_copy, CopyType::General);
+  return x_copy;
+}
+
+// Every thread owns a range of the output columns and goes through all the
+// nonzeros so no two threads write the same element. The sums are kept in
+// float32.
+template <typename T>
+void sparse_mm(
+    const array& rows,
+    const array& cols,
+    const array& values,
+    const array& b,
+    array& out) {
+  size_t nnz = values.size();
+  size_t M = out.shape(0);
+  size_t N = out.shape(1);
+  const int32_t* r = rows.data<int32_t>();
+  const int32_t* c = cols.data<int32_t>();
+  const T* v = values.data<T>();
+  const T* b_ptr = b.data<T>();
+  T* out_ptr = out.data<T>();
+
+  size_t grain =
+      std::max<size_t>(1, min_elements_per_thread / std::max<size_t>(nnz, 1));
+  parallel_for(
+      N,
+      [&](size_t begin, size_t end) {
+        size_t width = end - begin;
+        std::vector<float> acc(M * width, 0.0f);
+        for (size_t i = 0; i < nnz; i++) {
+          float vi = static_cast<float>(v[i]);
+          const T* b_row = b_ptr + size_t(c[i]) * N + begin;
+          float* acc_row = acc.data() + size_t(r[i]) * width;
+          for (size_t j = 0; j < width; j++) {
+            acc_row[j] += vi * static_cast<float>(b_row[j]);
+          }
+        }
+        for (size_t m = 0; m < M; m++) {
+          for (size_t j = 0; j < width; j++) {
+            out_ptr[m * N + begin + j] = static_cast<T>(acc[m * width + j]);
+          }
+        }
+      },
+      grain);
+}
+
+template <typename T>
+void sampled_mm(
+    const array& rows,
+    const array& cols,
+    const array& a,
+    const array& b,
+    array& out) {
+  size_t nnz = out.size();
+  size_t K = a.shape(1);
+  const int32_t* r = rows.data<int32_t>();
+  const int32_t* c = cols.data<int32_t>();
+  const T* a_ptr = a.data<T>();
+  const T* b_ptr = b.data<T>();
+  T* out_ptr = out.data<T>();
+
+  size_t grain =
+      std::max<size_t>(1, min_elements_per_thread / std::max<size_t>(K, 1));
+  parallel_for(
+      nnz,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          const T* a_row = a_ptr + size_t(r[i]) * K;
+          const T* b_row = b_ptr + size_t(c[i]) * K;
+          float acc = 0.0f;
+          for (size_t k = 0; k < K; k++) {
+            acc += static_cast<float>(a_row[k]) * static_cast<float>(b_row[k]);
+          }
+          out_ptr[i] = static_cast<T>(acc);
+        }
+      },
+      grain);
+}
+
+// Every thread owns a range of the output columns, i.e. rows of the weights,
+// and reads each row's kept values once for all the rows of x
+template <typename T>
+void sparse_2_4_matmul(
+    const array& x,
+    const array& values,
+    const array& metadata,
+    array& out) {
+  size_t N = values.shape(0);
+  size_t K = values.shape(1) * 2;
+  size_t M = x.size() / K;
+  const T* x_ptr = x.data<T>();
+  const T* v_ptr = values.data<T>();
+  const uint32_t* m_ptr = metadata.data<uint32_t>();
+  T* out_ptr = out.data<T>();
+
+  size_t grain =
+      std::max<size_t>(1, min_elements_per_thread / std::max<size_t>(M * K, 1));
+  parallel_for(
+      N,
+      [&](size_t begin, size_t end) {
+        std::vector<float> acc(M);
+        for (size_t n = begin; n < end; n++) {
+          std::fill(acc.begin(), acc.end(), 0.0f);
+          const T* v = v_ptr + n * K / 2;
+          const uint32_t* meta = m_ptr + n * K / 32;
+          for (size_t g = 0; g < K / 4; g++) {
+            uint32_t nibble = (meta[g / 8] >> (4 * (g % 8))) & 0xf;
+            size_t k0 = 4 * g + (nibble & 3);
+            size_t k1 = 4 * g + (nibble >> 2);
+            float v0 = static_cast<float>(v[2 * g]);
+            float v1 = static_cast<float>(v[2 * g + 1]);
+            for (size_t m = 0; m < M; m++) {
+              acc[m] += v0 * static_cast<float>(x_ptr[m * K + k0]) +
+                  v1 * static_cast<float>(x_ptr[m * K + k1]);
+            }
+          }
+          for (size_t m = 0; m < M; m++) {
+            out_ptr[m * N + n] = static_cast<T>(acc[m]);
+          }
+        }
+      },
+      grain);
+}
+
+} // namespace
+
+void SparseMM::eval(const std::vector<array>& inputs, array& out) {
+  auto rows = ensure_row_contiguous(inputs[0]);
+  auto cols = ensure_row_contiguous(inputs[1]);
+  auto values = ensure_row_contiguous(inputs[2]);
+  auto b = ensure_row_contiguous(inputs[3]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  switch (out.dtype()) {
+    case float32:
+      return sparse_mm<float>(rows, cols, values, b, out);
+    case float16:
+      return sparse_mm<float16_t>(rows, cols, values, b, out);
+    case bfloat16:
+      return sparse_mm<bfloat16_t>(rows, cols, values, b, out);
+    default:
+      throw std::runtime_error(
+          "[SparseMM::eval] Only supports floating point types.");
+  }
+}
+
+void SampledMM::eval(const std::vector<array>& inputs, array& out) {
+  auto rows = ensure_row_contiguous(inputs[0]);
+  auto cols = ensure_row_contiguous(inputs[1]);
+  auto a = ensure_row_contiguous(inputs[2]);
+  auto b = ensure_row_contiguous(inputs[3]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  switch (out.dtype()) {
+    case float32:
+      return sampled_mm<float>(rows, cols, a, b, out);
+    case float16:
+      return sampled_mm<float16_t>(rows, cols, a, b, out);
+    case bfloat16:
+      return sampled_mm<bfloat16_t>(rows, cols, a, b, out);
+    default:
+      throw std::runtime_error(
+          "[SampledMM::eval] Only supports floating point types.");
+  }
+}
+
+void Sparse24Matmul::eval(const std::vector<array>& inputs, array& out) {
+  auto x = ensure_row_contiguous(inputs[0]);
+  auto values = ensure_row_contiguous(inputs[1]);
+  auto metadata = ensure_row_contiguous(inputs[2]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  switch (out.dtype()) {
+    case float32:
+      return sparse_2_4_matmul<float>(x, values, metadata, out);
+    case float16:
+      return sparse_2_4_matmul<float16_t>(x, values, metadata, out);
+    case bfloat16:
+      return sparse_2_4_matmul<bfloat16_t>(x, values, metadata, out);
+    default:
+      throw std::runtime_error(
+          "[Sparse24Matmul::eval] Only supports floating point types.");
+  }
+}
+
+} // namespace mlx::core
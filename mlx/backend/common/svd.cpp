@@ -3,6 +3,7 @@
 #include "mlx/allocator.h"
 #include "mlx/backend/common/copy.h"
 #include "mlx/backend/common/lapack_helper.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
@@ -43,9 +44,8 @@ void svd_impl(const array& a, array& u, array& s, array& vt) {
   static constexpr auto job_vt = "V";
   static constexpr auto range = "A";
 
-  // Will contain the number of singular values after the call has returned.
-  int ns = 0;
   float workspace_dimension = 0;
+  int ns = 0;
 
   // Will contain the indices of eigenvectors that failed to converge (not used
   // here but required by lapack).
@@ -91,50 +91,65 @@ void svd_impl(const array& a, array& u, array& s, array& vt) {
   }
 
   const int lwork = workspace_dimension;
-  auto scratch = array::Data{allocator::malloc_or_wait(sizeof(float) * lwork)};
-
-  // Loop over matrices.
-  for (int i = 0; i < num_matrices; i++) {
-    MLX_LAPACK_FUNC(sgesvdx)
-    (
-        /* jobu = */ job_u,
-        /* jobvt = */ job_vt,
-        /* range = */ range,
-        // M and N are swapped since lapack expects column-major.
-        /* m = */ &N,
-        /* n = */ &M,
-        /* a = */ in.data<float>() + M * N * i,
-        /* lda = */ &lda,
-        /* vl = */ &ignored_float,
-        /* vu = */ &ignored_float,
-        /* il = */ &ignored_int,
-        /* iu = */ &ignored_int,
-        /* ns = */ &ns,
-        /* s = */ s.data<float>() + K * i,
-        // According to the identity above, lapack will write Vᵀᵀ as U.
-        /* u = */ vt.data<float>() + N * N * i,
-        /* ldu = */ &ldu,
-        // According to the identity above, lapack will write Uᵀ as Vᵀ.
-        /* vt = */ u.data<float>() + M * M * i,
-        /* ldvt = */ &ldvt,
-        /* work = */ static_cast<float*>(scratch.buffer.raw_ptr()),
-        /* lwork = */ &lwork,
-        /* iwork = */ static_cast<int*>(iwork.buffer.raw_ptr()),
-        /* info = */ &info);
-
-    if (info != 0) {
-      std::stringstream ss;
-      ss << "svd_impl: sgesvdx_ failed with code " << info;
-      throw std::runtime_error(ss.str());
-    }
 
-    if (ns != K) {
-      std::stringstream ss;
-      ss << "svd_impl: expected " << K << " singular values, but " << ns
-         << " were computed.";
-      throw std::runtime_error(ss.str());
+  // Each range of matrices gets its own workspace so the batch can be split
+  // across the CPU threads.
+  auto decompose = [&](size_t begin, size_t end) {
+    // Will contain the number of singular values after the call has returned.
+    int ns = 0;
+    int info;
+    auto scratch =
+        array::Data{allocator::malloc_or_wait(sizeof(float) * lwork)};
+    auto iwork = array::Data{allocator::malloc_or_wait(sizeof(int) * 12 * K)};
+
+    for (size_t i = begin; i < end; i++) {
+      MLX_LAPACK_FUNC(sgesvdx)
+      (
+          /* jobu = */ job_u,
+          /* jobvt = */ job_vt,
+          /* range = */ range,
+          // M and N are swapped since lapack expects column-major.
+          /* m = */ &N,
+          /* n = */ &M,
+          /* a = */ in.data<float>() + M * N * i,
+          /* lda = */ &lda,
+          /* vl = */ &ignored_float,
+          /* vu = */ &ignored_float,
+          /* il = */ &ignored_int,
+          /* iu = */ &ignored_int,
+          /* ns = */ &ns,
+          /* s = */ s.data<float>() + K * i,
+          // According to the identity above, lapack will write Vᵀᵀ as U.
+          /* u = */ vt.data<float>() + N * N * i,
+          /* ldu = */ &ldu,
+          // According to the identity above, lapack will write Uᵀ as Vᵀ.
+          /* vt = */ u.data<float>() + M * M * i,
+          /* ldvt = */ &ldvt,
+          /* work = */ static_cast<float*>(scratch.buffer.raw_ptr()),
+          /* lwork = */ &lwork,
+          /* iwork = */ static_cast<int*>(iwork.buffer.raw_ptr()),
+          /* info = */ &info);
+
+      if (info != 0) {
+        std::stringstream ss;
+        ss << "svd_impl: sgesvdx_ failed with code " << info;
+        throw std::runtime_error(ss.str());
+      }
+
+      if (ns != K) {
+        std::stringstream ss;
+        ss << "svd_impl: expected " << K << " singular values, but " << ns
+           << " were computed.";
+        throw std::runtime_error(ss.str());
+      }
     }
-  }
+  };
+
+  parallel_for(
+      num_matrices,
+      decompose,
+      std::max<size_t>(
+          1, min_elements_per_thread / (size_t(M) * N * std::max(M, N))));
 }
 
 void SVD::eval(const std::vector<array>& inputs, std::vector<array>& outputs) {
@@ -4,6 +4,7 @@
 #include "mlx/allocator.h"
 #include "mlx/array.h"
 #include "mlx/backend/common/ops.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/utils.h"
 namespace mlx::core {
 
@@ -12,6 +13,7 @@ namespace {
 // TODO: Add support for more combinations of input types.
 enum class TernaryOpType {
   ScalarScalarScalar,
+  VectorVectorVector,
   General,
 };
 
@@ -20,6 +22,10 @@ get_ternary_op_type(const array& a, const array& b, const array& c) {
   TernaryOpType topt;
   if (a.data_size() == 1 && b.data_size() == 1 && c.data_size() == 1) {
     topt = TernaryOpType::ScalarScalarScalar;
+  } else if (
+      a.flags().row_contiguous && b.flags().row_contiguous &&
+      c.flags().row_contiguous) {
+    topt = TernaryOpType::VectorVectorVector;
   } else {
     topt = TernaryOpType::General;
   }
@@ -38,6 +44,7 @@ void set_ternary_op_output_data(
       out.set_data(
           allocator::malloc_or_wait(out.itemsize()), 1, b.strides(), b.flags());
       break;
+    case TernaryOpType::VectorVectorVector:
     case TernaryOpType::General:
       out.set_data(allocator::malloc_or_wait(out.nbytes()));
       break;
@@ -169,7 +176,7 @@ void ternary_op_dims4(
 }
 
 template <typename T1, typename T2, typename T3, typename U, typename Op>
-void ternary_op_dispatch_dims(
+void ternary_op_dispatch_dims_serial(
     const array& a,
     const array& b,
     const array& c,
@@ -202,6 +209,46 @@ void ternary_op_dispatch_dims(
   }
 }
 
+template <typename T1, typename T2, typename T3, typename U, typename Op>
+void ternary_op_dispatch_dims(
+    const array& a,
+    const array& b,
+    const array& c,
+    array& out,
+    Op op) {
+  // Split the output into rows of the last dimension, each thread finds the
+  // start of its rows in the inputs and walks them with the inner stride.
+  size_t inner = out.shape().back();
+  size_t n_rows = out.size() / inner;
+  parallel_for(
+      n_rows,
+      [&a, &b, &c, &out, &op, inner, n_rows](size_t start, size_t end) {
+        if (start == 0 && end == n_rows) {
+          ternary_op_dispatch_dims_serial<T1, T2, T3, U>(a, b, c, out, op);
+          return;
+        }
+        const T1* a_ptr = a.data<T1>();
+        const T2* b_ptr = b.data<T2>();
+        const T3* c_ptr = c.data<T3>();
+        U* dst = out.data<U>() + start * inner;
+        auto a_inner = a.strides().back();
+        auto b_inner = b.strides().back();
+        auto c_inner = c.strides().back();
+        for (size_t r = start; r < end; r++) {
+          size_t a_idx = elem_to_loc(r * inner, a.shape(), a.strides());
+          size_t b_idx = elem_to_loc(r * inner, b.shape(), b.strides());
+          size_t c_idx = elem_to_loc(r * inner, c.shape(), c.strides());
+          for (size_t i = 0; i < inner; i++) {
+            *dst++ = op(a_ptr[a_idx], b_ptr[b_idx], c_ptr[c_idx]);
+            a_idx += a_inner;
+            b_idx += b_inner;
+            c_idx += c_inner;
+          }
+        }
+      },
+      std::max<size_t>(min_elements_per_thread / inner, 1));
+}
+
 template <typename T1, typename T2, typename T3, typename U, typename Op>
 void ternary_op(
     const array& a,
@@ -218,6 +265,19 @@ void ternary_op(
     return;
   }
 
+  if (topt == TernaryOpType::VectorVectorVector) {
+    const T1* a_ptr = a.data<T1>();
+    const T2* b_ptr = b.data<T2>();
+    const T3* c_ptr = c.data<T3>();
+    U* dst = out.data<U>();
+    parallel_for(out.size(), [&](size_t start, size_t end) {
+      for (size_t i = start; i < end; i++) {
+        dst[i] = op(a_ptr[i], b_ptr[i], c_ptr[i]);
+      }
+    });
+    return;
+  }
+
   ternary_op_dispatch_dims<T1, T2, T3, U>(a, b, c, out, op);
 }
 
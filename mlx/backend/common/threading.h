@@ -0,0 +1,36 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <algorithm>
+
+#include "mlx/threadpool.h"
+
+namespace mlx::core {
+
+// Kernels smaller than this many elements per thread run inline on the
+// stream's thread since splitting them costs more than it saves.
+constexpr size_t min_elements_per_thread = 1 << 15;
+
+/* Split [0, size) into at most cpu_threads() contiguous ranges of at least
+ * grain elements and call f(begin, end) for each range on the CPU pool.
+ * */
+template <typename F>
+void parallel_for(size_t size, F&& f, size_t grain = min_elements_per_thread) {
+  size_t n_chunks =
+      std::min<size_t>(cpu_threads(), size / std::max<size_t>(grain, 1));
+  if (n_chunks <= 1) {
+    f(size_t(0), size);
+    return;
+  }
+  size_t chunk = (size + n_chunks - 1) / n_chunks;
+  cpu_thread_pool().parallel_for(n_chunks, [&f, chunk, size](int i) {
+    size_t begin = i * chunk;
+    size_t end = std::min(size, begin + chunk);
+    if (begin < end) {
+      f(begin, end);
+    }
+  });
+}
+
+} // namespace mlx::core
@@ -4,12 +4,16 @@
 
 namespace mlx::core::random {
 
+namespace {
+
+constexpr static uint32_t rotations[2][4] = {
+    {13, 15, 26, 6}, {17, 29, 16, 24}};
+
+} // namespace
+
 std::pair<uint32_t, uint32_t> threefry2x32_hash(
     const std::pair<uint32_t, uint32_t>& key,
     std::pair<uint32_t, uint32_t> count) {
-  constexpr static uint32_t rotations[2][4] = {
-      {13, 15, 26, 6}, {17, 29, 16, 24}};
-
   uint32_t ks[3] = {key.first, key.second, key.first ^ key.second ^ 0x1BD11BDA};
 
   count.first += ks[0];
@@ -28,4 +32,29 @@ std::pair<uint32_t, uint32_t> threefry2x32_hash(
   return count;
 }
 
+void threefry2x32_hash(
+    const std::pair<uint32_t, uint32_t>& key,
+    std::pair<uint32_t, uint32_t> count,
+    uint32_t* out_first,
+    uint32_t* out_second,
+    size_t n) {
+  uint32_t ks[3] = {key.first, key.second, key.first ^ key.second ^ 0x1BD11BDA};
+
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x = count.first + uint32_t(i) + ks[0];
+    uint32_t y = count.second + uint32_t(i) + ks[1];
+    for (int r = 0; r < 5; ++r) {
+      for (auto rot : rotations[r % 2]) {
+        x += y;
+        y = (y << rot) | (y >> (32 - rot));
+        y ^= x;
+      }
+      x += ks[(r + 1) % 3];
+      y += ks[(r + 2) % 3] + r + 1;
+    }
+    out_first[i] = x;
+    out_second[i] = y;
+  }
+}
+
 } // namespace mlx::core::random
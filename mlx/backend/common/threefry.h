@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 
@@ -18,4 +19,16 @@ std::pair<uint32_t, uint32_t> threefry2x32_hash(
     const std::pair<uint32_t, uint32_t>& key,
     std::pair<uint32_t, uint32_t> count);
 
+/** Applies the Threefry 2x32 hash function to the n counters
+ * (count.first + i, count.second + i) and writes the two halves of the
+ * i-th result to out_first[i] and out_second[i]. The rounds vectorize
+ * across consecutive counters.
+ */
+void threefry2x32_hash(
+    const std::pair<uint32_t, uint32_t>& key,
+    std::pair<uint32_t, uint32_t> count,
+    uint32_t* out_first,
+    uint32_t* out_second,
+    size_t n);
+
 } // namespace mlx::core::random
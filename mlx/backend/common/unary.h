@@ -4,6 +4,8 @@
 
 #include "mlx/allocator.h"
 #include "mlx/array.h"
+#include "mlx/backend/common/convert.h"
+#include "mlx/backend/common/threading.h"
 #include "mlx/backend/common/utils.h"
 #include "mlx/utils.h"
 
@@ -30,17 +32,25 @@ void unary_op(const array& a, array& out, Op op) {
   if (a.flags().contiguous) {
     set_unary_output_data(a, out);
     T* dst = out.data<T>();
-    for (size_t i = 0; i < a.data_size(); ++i) {
-      dst[i] = op(a_ptr[i]);
-    }
+    parallel_for(a.data_size(), [a_ptr, dst, &op](size_t start, size_t end) {
+      if constexpr (is_half_v<T> && computes_in_float<Op, float>()) {
+        half_unary(a_ptr + start, dst + start, end - start, op);
+        return;
+      }
+      for (size_t i = start; i < end; ++i) {
+        dst[i] = op(a_ptr[i]);
+      }
+    });
   } else {
     out.set_data(allocator::malloc_or_wait(out.nbytes()));
     T* dst = out.data<T>();
-    for (size_t i = 0; i < out.size(); ++i) {
-      // TODO this is super inefficient, need to fix.
-      int a_idx = elem_to_loc(i, a.shape(), a.strides());
-      dst[i] = op(a_ptr[a_idx]);
-    }
+    parallel_for(out.size(), [a_ptr, dst, &a, &op](size_t start, size_t end) {
+      for (size_t i = start; i < end; ++i) {
+        // TODO this is super inefficient, need to fix.
+        int a_idx = elem_to_loc(i, a.shape(), a.strides());
+        dst[i] = op(a_ptr[a_idx]);
+      }
+    });
   }
 }
 
@@ -2,10 +2,12 @@
 #include "mlx/backend/metal/allocator.h"
 #include "mlx/backend/metal/metal.h"
 #include "mlx/backend/metal/metal_impl.h"
+#include "mlx/transforms.h"
 
 #include <mach/vm_page_size.h>
 #include <unistd.h>
 #include <cstdlib>
+#include <limits>
 
 namespace mlx::core {
 
@@ -19,52 +21,97 @@ void* Buffer::raw_ptr() {
   return static_cast<MTL::Buffer*>(ptr_)->contents();
 }
 
+Buffer make_external(void* ptr, size_t size) {
+  // Metal can only wrap whole pages
+  if (reinterpret_cast<uintptr_t>(ptr) % vm_page_size != 0 ||
+      size % vm_page_size != 0) {
+    return Buffer{nullptr};
+  }
+  auto pool = metal::new_scoped_memory_pool();
+  auto buf =
+      metal::device(mlx::core::Device::gpu)
+          .mtl_device()
+          ->newBuffer(ptr, size, MTL::ResourceStorageModeShared, nullptr);
+  return Buffer{static_cast<void*>(buf)};
+}
+
+void release_external(Buffer buffer) {
+  auto pool = metal::new_scoped_memory_pool();
+  auto buf = static_cast<MTL::Buffer*>(buffer.ptr());
+  metal::allocator().evict(buf);
+  buf->release();
+}
+
 } // namespace allocator
 
 namespace metal {
 
 namespace {
 
-BufferCache::BufferCache(MTL::Device* device)
-    : device_(device), head_(nullptr), tail_(nullptr), pool_size_(0) {}
+// Buffers smaller than this are sub-allocated from heaps of slab_size bytes
+constexpr size_t small_size = 1 << 20;
+constexpr size_t slab_size = 1 << 24;
+
+BufferCache::BufferCache(MTL::Device* device) : device_(device) {}
 
 BufferCache::~BufferCache() {
   auto thread_pool = metal::new_scoped_memory_pool();
   clear();
 }
 
-void BufferCache::clear() {
-  for (auto& [size, holder] : buffer_pool_) {
-    if (holder->buf)
-      holder->buf->release();
-    delete holder;
+size_t BufferCache::clear() {
+  size_t n_released = 0;
+  for (auto& bucket : buckets_) {
+    std::lock_guard<std::mutex> lk(bucket.mtx);
+    for (auto& e : bucket.entries) {
+      pool_size_ -= e.buf->length();
+      e.buf->release();
+    }
+    n_released += bucket.entries.size();
+    bucket.entries.clear();
+    bucket.by_size.clear();
   }
-  buffer_pool_.clear();
-  pool_size_ = 0;
-  head_ = nullptr;
-  tail_ = nullptr;
+  return n_released;
 }
 
-MTL::Buffer* BufferCache::reuse_from_cache(size_t size) {
-  // Find the closest buffer in pool
-  MTL::Buffer* pbuf = nullptr;
+void BufferCache::reset_stats() {
+  hits_ = 0;
+  misses_ = 0;
+  wasted_bytes_ = 0;
+  evictions_ = 0;
+}
 
-  auto it = buffer_pool_.lower_bound(size);
+MTL::Buffer*
+BufferCache::take_from_bucket(Bucket& bucket, size_t size, size_t max_size) {
+  std::lock_guard<std::mutex> lk(bucket.mtx);
+  auto it = bucket.by_size.lower_bound(size);
+  if (it == bucket.by_size.end() || it->first >= max_size) {
+    return nullptr;
+  }
+  auto buf = it->second->buf;
+  bucket.entries.erase(it->second);
+  bucket.by_size.erase(it);
+  return buf;
+}
 
-  // Make sure we use most of the available memory
-  while (!pbuf && it != buffer_pool_.end() &&
-         it->first < std::min(2 * size, size + 2 * vm_page_size)) {
-    // Collect from the cache
-    pbuf = it->second->buf;
+MTL::Buffer* BufferCache::reuse_from_cache(size_t size) {
+  // Only use buffers with a bounded amount of slack so large requests don't
+  // take much larger buffers
+  size_t max_size = std::min(2 * size, size + 2 * vm_page_size);
 
-    // Remove from cache
-    remove_from_list(it->second);
-    delete it->second;
-    it = buffer_pool_.erase(it);
+  // The buffers in range are in at most two buckets
+  MTL::Buffer* pbuf = nullptr;
+  for (int b = bucket_index(size); !pbuf && b <= bucket_index(max_size - 1);
+       b++) {
+    pbuf = take_from_bucket(buckets_[b], size, max_size);
   }
 
   if (pbuf) {
     pool_size_ -= pbuf->length();
+    hits_++;
+    wasted_bytes_ += pbuf->length() - size;
+  } else {
+    misses_++;
   }
 
   return pbuf;
@@ -73,97 +120,163 @@ MTL::Buffer* BufferCache::reuse_from_cache(size_t size) {
 void BufferCache::recycle_to_cache(MTL::Buffer* buf) {
   // Add to cache
   if (buf) {
-    BufferHolder* bh = new BufferHolder(buf);
-    add_at_head(bh);
+    auto& bucket = buckets_[bucket_index(buf->length())];
+    std::lock_guard<std::mutex> lk(bucket.mtx);
+    bucket.entries.push_back({buf, tick_++});
+    bucket.by_size.insert({buf->length(), std::prev(bucket.entries.end())});
     pool_size_ += buf->length();
-    buffer_pool_.insert({buf->length(), bh});
+  }
+}
+
+MTL::Buffer* BufferCache::take_oldest() {
+  // Find the bucket whose oldest buffer is the oldest overall
+  while (true) {
+    Bucket* oldest = nullptr;
+    uint64_t oldest_tick = std::numeric_limits<uint64_t>::max();
+    for (auto& bucket : buckets_) {
+      std::lock_guard<std::mutex> lk(bucket.mtx);
+      if (!bucket.entries.empty() &&
+          bucket.entries.front().tick < oldest_tick) {
+        oldest = &bucket;
+        oldest_tick = bucket.entries.front().tick;
+      }
+    }
+    if (!oldest) {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lk(oldest->mtx);
+    // The buffer may have been reused in the mean time
+    if (oldest->entries.empty()) {
+      continue;
+    }
+    auto entry = oldest->entries.begin();
+    auto range = oldest->by_size.equal_range(entry->buf->length());
+    for (auto it = range.first; it != range.second; it++) {
+      if (it->second == entry) {
+        oldest->by_size.erase(it);
+        break;
+      }
+    }
+    auto buf = entry->buf;
+    oldest->entries.erase(entry);
+    return buf;
   }
 }
 
 void BufferCache::release_cached_buffers(size_t min_bytes_to_free) {
   if (min_bytes_to_free >= 0.9 * pool_size_) {
-    clear();
+    evictions_ += clear();
   } else {
     size_t total_bytes_freed = 0;
 
-    while (tail_ && (total_bytes_freed < min_bytes_to_free)) {
-      if (tail_->buf) {
-        total_bytes_freed += tail_->buf->length();
-        tail_->buf->release();
-        tail_->buf = nullptr;
+    while (total_bytes_freed < min_bytes_to_free) {
+      auto buf = take_oldest();
+      if (!buf) {
+        break;
       }
-      remove_from_list(tail_);
+      total_bytes_freed += buf->length();
+      pool_size_ -= buf->length();
+      evictions_++;
+      buf->release();
     }
-    pool_size_ -= total_bytes_freed;
   }
 }
 
-void BufferCache::add_at_head(BufferCache::BufferHolder* to_add) {
-  if (!to_add)
-    return;
+HeapSlabs::HeapSlabs(MTL::Device* device) : device_(device) {}
 
-  if (!head_) {
-    head_ = to_add;
-    tail_ = to_add;
-  } else {
-    head_->prev = to_add;
-    to_add->next = head_;
-    head_ = to_add;
+HeapSlabs::~HeapSlabs() {
+  auto thread_pool = metal::new_scoped_memory_pool();
+  for (auto heap : heaps_) {
+    heap->release();
   }
 }
 
-void BufferCache::remove_from_list(BufferCache::BufferHolder* to_remove) {
-  if (!to_remove) {
-    return;
+MTL::Buffer* HeapSlabs::malloc(
+    size_t size,
+    MTL::ResourceOptions resource_options) {
+  if (size >= small_size) {
+    return nullptr;
+  }
+  auto sa = device_->heapBufferSizeAndAlign(size, resource_options);
+  std::lock_guard<std::mutex> lk(mtx_);
+  // The most recent slabs are the most likely to have room
+  for (auto it = heaps_.rbegin(); it != heaps_.rend(); it++) {
+    auto heap = *it;
+    if (heap->maxAvailableSize(sa.align) >= sa.size) {
+      if (auto buf = heap->newBuffer(size, resource_options)) {
+        return buf;
+      }
+    }
   }
 
-  // If in the middle
-  if (to_remove->prev && to_remove->next) {
-    to_remove->prev->next = to_remove->next;
-    to_remove->next->prev = to_remove->prev;
-  } else if (to_remove->prev && to_remove == tail_) { // If tail
-    tail_ = to_remove->prev;
-    tail_->next = nullptr;
-  } else if (to_remove == head_ && to_remove->next) { // If head
-    head_ = to_remove->next;
-    head_->prev = nullptr;
-  } else if (to_remove == head_ && to_remove == tail_) { // If only element
-    head_ = nullptr;
-    tail_ = nullptr;
+  auto desc = MTL::HeapDescriptor::alloc()->init();
+  desc->setType(MTL::HeapTypeAutomatic);
+  desc->setResourceOptions(resource_options);
+  desc->setSize(slab_size);
+  auto heap = device_->newHeap(desc);
+  desc->release();
+  if (!heap) {
+    return nullptr;
   }
+  heaps_.push_back(heap);
+  return heap->newBuffer(size, resource_options);
+}
 
-  to_remove->prev = nullptr;
-  to_remove->next = nullptr;
+void HeapSlabs::release_empty() {
+  std::lock_guard<std::mutex> lk(mtx_);
+  std::vector<MTL::Heap*> heaps;
+  for (int i = 0; i < heaps_.size(); i++) {
+    if (i + 1 < heaps_.size() && heaps_[i]->usedSize() == 0) {
+      heaps_[i]->release();
+    } else {
+      heaps.push_back(heaps_[i]);
+    }
+  }
+  heaps_ = std::move(heaps);
 }
 
 } // namespace
 
 MetalAllocator::MetalAllocator()
     : device_(device(mlx::core::Device::gpu).mtl_device()),
-      buffer_cache_(device_) {
+      heaps_(device_),
+      buffer_cache_(device_),
+      residency_set_(device_) {
+  if (auto wired_set = residency_set_.mtl_residency_set()) {
+    device(mlx::core::Device::gpu).set_residency_set(wired_set);
+  }
   auto memsize = std::get<size_t>(device_info()["memory_size"]);
-  block_limit_ =
-      std::min(1.5 * device_->recommendedMaxWorkingSetSize(), 0.95 * memsize);
+  block_limit_ = static_cast<size_t>(
+      std::min(1.5 * device_->recommendedMaxWorkingSetSize(), 0.95 * memsize));
   gc_limit_ = std::min(
       static_cast<size_t>(0.95 * device_->recommendedMaxWorkingSetSize()),
-      block_limit_);
-  max_pool_size_ = block_limit_;
+      block_limit_.load());
+  max_pool_size_ = block_limit_.load();
 }
 
 size_t MetalAllocator::set_cache_limit(size_t limit) {
-  std::swap(limit, max_pool_size_);
-  return limit;
+  return max_pool_size_.exchange(limit);
 };
 
 size_t MetalAllocator::set_memory_limit(size_t limit, bool relaxed) {
-  std::swap(limit, block_limit_);
+  limit = block_limit_.exchange(limit);
   relaxed_ = relaxed;
   gc_limit_ = std::min(
-      block_limit_,
+      block_limit_.load(),
       static_cast<size_t>(0.95 * device_->recommendedMaxWorkingSetSize()));
   return limit;
 };
 
+size_t MetalAllocator::set_wired_limit(size_t limit) {
+  if (limit > device_->recommendedMaxWorkingSetSize()) {
+    throw std::invalid_argument(
+        "[metal::set_wired_limit] Setting a wired limit larger than "
+        "the maximum working set size is not allowed.");
+  }
+  return residency_set_.resize(limit);
+}
+
 Buffer MetalAllocator::malloc(size_t size, bool allow_swap /* = false */) {
   // Metal doesn't like empty buffers
   if (size == 0) {
@@ -179,13 +292,13 @@ Buffer MetalAllocator::malloc(size_t size, bool allow_swap /* = false */) {
     throw std::runtime_error(msg.str());
   }
 
-  // Align up memory
-  if (size > vm_page_size) {
+  // Align up memory, small buffers come from heaps which take care of their
+  // alignment
+  if (size >= small_size) {
     size = vm_page_size * ((size + vm_page_size - 1) / vm_page_size);
   }
 
   // Try the cache
-  std::unique_lock lk(mutex_);
   MTL::Buffer* buf = buffer_cache_.reuse_from_cache(size);
   if (!buf) {
     size_t mem_required = get_active_memory() + get_cache_memory() + size;
@@ -200,42 +313,61 @@ Buffer MetalAllocator::malloc(size_t size, bool allow_swap /* = false */) {
     // If we have a lot of memory pressure or are over the maximum cache size,
     // try to reclaim memory from the cache
     if (mem_required >= gc_limit_) {
+      std::lock_guard<std::mutex> lk(gc_mutex_);
       buffer_cache_.release_cached_buffers(mem_required - gc_limit_);
+      heaps_.release_empty();
     }
 
     // Allocate new buffer if needed
     size_t res_opt = MTL::ResourceStorageModeShared;
     res_opt |= MTL::ResourceHazardTrackingModeTracked;
-    lk.unlock();
-    buf = device_->newBuffer(size, res_opt);
-    lk.lock();
+    buf = heaps_.malloc(size, res_opt);
+    if (!buf) {
+      buf = device_->newBuffer(size, res_opt);
+    }
   }
 
-  active_memory_ += buf->length();
-  peak_memory_ = std::max(peak_memory_, active_memory_);
+  size_t active_memory = (active_memory_ += buf->length());
+  size_t peak_memory = peak_memory_;
+  while (active_memory > peak_memory &&
+         !peak_memory_.compare_exchange_weak(peak_memory, active_memory)) {
+  }
 
   // Maintain the cache below the requested limit
   if (get_cache_memory() >= max_pool_size_) {
     auto thread_pool = metal::new_scoped_memory_pool();
-    buffer_cache_.release_cached_buffers(get_cache_memory() - max_pool_size_);
+    std::lock_guard<std::mutex> lk(gc_mutex_);
+    if (get_cache_memory() >= max_pool_size_) {
+      buffer_cache_.release_cached_buffers(
+          get_cache_memory() - max_pool_size_);
+    }
   }
 
   return Buffer{static_cast<void*>(buf)};
 }
 
 void MetalAllocator::clear_cache() {
-  std::unique_lock lk(mutex_);
+  std::lock_guard<std::mutex> lk(gc_mutex_);
   buffer_cache_.clear();
+  heaps_.release_empty();
+}
+
+std::unordered_map<std::string, size_t> MetalAllocator::get_cache_stats() {
+  return {
+      {"hits", buffer_cache_.hits()},
+      {"misses", buffer_cache_.misses()},
+      {"wasted_bytes", buffer_cache_.wasted_bytes()},
+      {"evictions", buffer_cache_.evictions()},
+  };
 }
 
 void MetalAllocator::free(Buffer buffer) {
   auto buf = static_cast<MTL::Buffer*>(buffer.ptr());
-  std::unique_lock lk(mutex_);
+  residency_set_.erase(buf);
   active_memory_ -= buf->length();
   if (get_cache_memory() < max_pool_size_) {
     buffer_cache_.recycle_to_cache(buf);
   } else {
-    lk.unlock();
     auto thread_pool = metal::new_scoped_memory_pool();
     buf->release();
   }
@@ -252,6 +384,9 @@ size_t set_cache_limit(size_t limit) {
 size_t set_memory_limit(size_t limit, bool relaxed /* = true */) {
   return allocator().set_memory_limit(limit, relaxed);
 }
+size_t get_memory_limit() {
+  return allocator().get_memory_limit();
+}
 size_t get_active_memory() {
   return allocator().get_active_memory();
 }
@@ -267,6 +402,26 @@ size_t get_cache_memory() {
 void clear_cache() {
   return allocator().clear_cache();
 }
+std::unordered_map<std::string, size_t> get_cache_stats() {
+  return allocator().get_cache_stats();
+}
+void reset_cache_stats() {
+  allocator().reset_cache_stats();
+}
+size_t set_wired_limit(size_t limit) {
+  return allocator().set_wired_limit(limit);
+}
+size_t get_wired_memory() {
+  return allocator().get_wired_memory();
+}
+void make_resident(const std::vector<array>& arrays) {
+  eval(arrays);
+  std::vector<MTL::Buffer*> buffers;
+  for (auto& a : arrays) {
+    buffers.push_back(static_cast<MTL::Buffer*>(a.buffer().ptr()));
+  }
+  allocator().make_resident(buffers);
+}
 
 } // namespace metal
 
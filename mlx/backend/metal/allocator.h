@@ -2,12 +2,18 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <list>
 #include <map>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "mlx/allocator.h"
 #include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/resident.h"
 
 namespace mlx::core::metal {
 
@@ -26,27 +32,84 @@ class BufferCache {
   size_t cache_size() {
     return pool_size_;
   }
-  void clear();
+  // Release every cached buffer, returns the number released
+  size_t clear();
+
+  // Cache statistics
+  size_t hits() {
+    return hits_;
+  }
+  size_t misses() {
+    return misses_;
+  }
+  size_t wasted_bytes() {
+    return wasted_bytes_;
+  }
+  size_t evictions() {
+    return evictions_;
+  }
+  void reset_stats();
 
  private:
-  struct BufferHolder {
-   public:
-    BufferHolder(MTL::Buffer* buf_) : buf(buf_), prev(nullptr), next(nullptr) {}
+  // Buffers are binned by the power of two below their size. Each bin has
+  // its own lock so streams allocating different sizes don't contend.
+  static constexpr int n_buckets = 64;
 
-    BufferHolder* prev;
-    BufferHolder* next;
+  struct Entry {
     MTL::Buffer* buf;
+    // When the buffer was recycled, used to release the oldest ones first
+    uint64_t tick;
+  };
+
+  struct Bucket {
+    std::mutex mtx;
+    // Oldest first
+    std::list<Entry> entries;
+    std::multimap<size_t, std::list<Entry>::iterator> by_size;
   };
 
-  void add_at_head(BufferHolder* to_add);
-  void remove_from_list(BufferHolder* to_remove);
+  static int bucket_index(size_t size) {
+    return 63 - __builtin_clzll(size);
+  }
+
+  // Remove and return a buffer of at least size and less than max_size
+  // bytes from the bucket
+  MTL::Buffer* take_from_bucket(Bucket& bucket, size_t size, size_t max_size);
+
+  // Remove and return the oldest buffer in the whole cache
+  MTL::Buffer* take_oldest();
 
   MTL::Device* device_;
 
-  std::multimap<size_t, BufferHolder*> buffer_pool_;
-  BufferHolder* head_;
-  BufferHolder* tail_;
-  size_t pool_size_;
+  std::array<Bucket, n_buckets> buckets_;
+  std::atomic<uint64_t> tick_{0};
+  std::atomic<size_t> pool_size_{0};
+
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+  std::atomic<size_t> wasted_bytes_{0};
+  std::atomic<size_t> evictions_{0};
+};
+
+// Heaps of a fixed size (slabs) which small buffers are sub-allocated from.
+// This avoids the driver overhead of a separate allocation per buffer and
+// rounding every buffer up to a page.
+class HeapSlabs {
+ public:
+  HeapSlabs(MTL::Device* device);
+  ~HeapSlabs();
+
+  // Returns nullptr if the size is too large for a slab
+  MTL::Buffer* malloc(size_t size, MTL::ResourceOptions resource_options);
+
+  // Release the slabs with no buffers in them, keeping the most recent one
+  void release_empty();
+
+ private:
+  MTL::Device* device_;
+  std::mutex mtx_;
+  // Most recently created last
+  std::vector<MTL::Heap*> heaps_;
 };
 
 } // namespace
@@ -63,33 +126,58 @@ class MetalAllocator : public allocator::Allocator {
     return peak_memory_;
   };
   void reset_peak_memory() {
-    std::unique_lock lk(mutex_);
     peak_memory_ = 0;
   };
   size_t get_cache_memory() {
     return buffer_cache_.cache_size();
   };
+
   size_t set_cache_limit(size_t limit);
   size_t set_memory_limit(size_t limit, bool relaxed);
+  size_t get_memory_limit() {
+    return block_limit_;
+  };
   void clear_cache();
+  std::unordered_map<std::string, size_t> get_cache_stats();
+  void reset_cache_stats() {
+    buffer_cache_.reset_stats();
+  };
+  size_t set_wired_limit(size_t limit);
+  size_t get_wired_memory() {
+    return residency_set_.wired_size();
+  };
+  void make_resident(const std::vector<MTL::Buffer*>& buffers) {
+    residency_set_.insert(buffers);
+  };
+  // Removes a buffer not released through free from the residency set
+  void evict(MTL::Buffer* buffer) {
+    residency_set_.erase(buffer);
+  };
 
  private:
   MTL::Device* device_;
   MetalAllocator();
   friend MetalAllocator& allocator();
 
+  // Slabs for small buffers, they must outlive the cached buffers
+  HeapSlabs heaps_;
+
   // Caching allocator
   BufferCache buffer_cache_;
 
+  // Buffers made resident with make_resident
+  ResidencySet residency_set_;
+
   // Allocation stats
-  size_t block_limit_;
-  size_t gc_limit_;
-  size_t active_memory_{0};
-  size_t peak_memory_{0};
-  size_t max_pool_size_;
-  bool relaxed_{true};
-
-  std::mutex mutex_;
+  std::atomic<size_t> block_limit_;
+  std::atomic<size_t> gc_limit_;
+  std::atomic<size_t> active_memory_{0};
+  std::atomic<size_t> peak_memory_{0};
+  std::atomic<size_t> max_pool_size_;
+  std::atomic<bool> relaxed_{true};
+
+  // Serializes reclaiming memory from the cache
+  std::mutex gc_mutex_;
 };
 
 MetalAllocator& allocator();
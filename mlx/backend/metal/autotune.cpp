@@ -0,0 +1,166 @@
+// Copyright © 2024 Apple Inc.
+
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/metal/autotune.h"
+#include "mlx/backend/metal/metal_impl.h"
+
+namespace mlx::core::metal {
+
+namespace {
+
+constexpr int tuning_runs = 3;
+
+struct Autotuner {
+  std::mutex mtx;
+  bool loaded{false};
+  bool enabled{false};
+  std::string path;
+  // The name of the winning candidate of each class
+  std::unordered_map<std::string, std::string> winners;
+  MTL::CommandQueue* queue{nullptr};
+
+  void load(Device& d) {
+    if (loaded) {
+      return;
+    }
+    loaded = true;
+    if (const char* buff_str = std::getenv("MLX_METAL_AUTOTUNE")) {
+      enabled = std::string(buff_str) == "1";
+    }
+    path = cache_file_path(d.mtl_device(), ".tune");
+    if (path.empty()) {
+      return;
+    }
+    // One "key winner" per line, later lines override earlier ones
+    std::ifstream is(path);
+    std::string key, winner;
+    while (is >> key >> winner) {
+      winners[key] = winner;
+    }
+  }
+
+  void store(const std::string& key, const std::string& winner) {
+    winners[key] = winner;
+    if (!path.empty()) {
+      std::ofstream os(path, std::ios::app);
+      os << key << " " << winner << "\n";
+    }
+  }
+
+  // GPU seconds of the fastest of a few runs of the candidate
+  double time(
+      Device& d,
+      MTL::Buffer* scratch,
+      int candidate,
+      const EncodeCandidateCommands& encode) {
+    if (queue == nullptr) {
+      queue = d.mtl_device()->newCommandQueue();
+    }
+    double best = std::numeric_limits<double>::infinity();
+    // The first run warms up the pipeline
+    for (int i = 0; i <= tuning_runs; i++) {
+      auto pool = new_scoped_memory_pool();
+      auto cbuf = queue->commandBuffer();
+      encode(cbuf, scratch, candidate);
+      cbuf->commit();
+      cbuf->waitUntilCompleted();
+      if (cbuf->status() != MTL::CommandBufferStatusCompleted) {
+        return std::numeric_limits<double>::infinity();
+      }
+      if (i > 0) {
+        best = std::min(best, cbuf->GPUEndTime() - cbuf->GPUStartTime());
+      }
+    }
+    return best;
+  }
+};
+
+Autotuner& autotuner() {
+  static Autotuner autotuner_;
+  return autotuner_;
+}
+
+} // namespace
+
+int autotune(
+    Device& d,
+    const std::string& key,
+    const std::vector<std::string>& candidates,
+    int default_candidate,
+    size_t scratch_bytes,
+    const EncodeCandidate& encode) {
+  return autotune_commands(
+      d,
+      key,
+      candidates,
+      default_candidate,
+      scratch_bytes,
+      [&encode](MTL::CommandBuffer* cbuf, MTL::Buffer* scratch, int i) {
+        auto enc = cbuf->computeCommandEncoder();
+        encode(enc, scratch, i);
+        enc->endEncoding();
+      });
+}
+
+int autotune_commands(
+    Device& d,
+    const std::string& key,
+    const std::vector<std::string>& candidates,
+    int default_candidate,
+    size_t scratch_bytes,
+    const EncodeCandidateCommands& encode) {
+  auto& tuner = autotuner();
+  std::lock_guard<std::mutex> lk(tuner.mtx);
+  tuner.load(d);
+
+  if (auto it = tuner.winners.find(key); it != tuner.winners.end()) {
+    for (int i = 0; i < candidates.size(); i++) {
+      if (candidates[i] == it->second) {
+        return i;
+      }
+    }
+    // The candidates changed since the class was tuned
+  }
+  if (!tuner.enabled) {
+    return default_candidate;
+  }
+
+  auto scratch = allocator::malloc_or_wait(scratch_bytes);
+  int best = default_candidate;
+  double best_time = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < candidates.size(); i++) {
+    double t;
+    try {
+      t = tuner.time(d, static_cast<MTL::Buffer*>(scratch.ptr()), i, encode);
+    } catch (const std::exception&) {
+      // E.g. a kernel which can't be built for these inputs
+      continue;
+    }
+    if (t < best_time) {
+      best = i;
+      best_time = t;
+    }
+  }
+  allocator::free(scratch);
+  tuner.store(key, candidates[best]);
+  return best;
+}
+
+void set_tuning_array(
+    MTL::ComputeCommandEncoder* enc,
+    const array& a,
+    int idx) {
+  auto buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
+  auto offset = a.data<char>() -
+      static_cast<char*>(const_cast<MTL::Buffer*>(buf)->contents());
+  enc->setBuffer(buf, offset, idx);
+}
+
+} // namespace mlx::core::metal
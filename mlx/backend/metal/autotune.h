@@ -0,0 +1,56 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "mlx/array.h"
+#include "mlx/backend/metal/device.h"
+
+namespace mlx::core::metal {
+
+// Encodes the kernel of a candidate configuration. The outputs are written
+// to the scratch buffer rather than the real ones.
+using EncodeCandidate = std::function<
+    void(MTL::ComputeCommandEncoder* enc, MTL::Buffer* scratch, int candidate)>;
+
+// Returns the index of the candidate configuration to dispatch for the class
+// of problems named by key.
+//
+// The winner of each class is kept per device in a file of the kernel cache
+// directory. A class without a winner uses default_candidate unless
+// MLX_METAL_AUTOTUNE=1, in which case every candidate is encoded on a queue
+// of its own, timed on the GPU and the fastest one is stored. The inputs the
+// candidates read may still be being computed, so only the time they take is
+// meaningful.
+int autotune(
+    Device& d,
+    const std::string& key,
+    const std::vector<std::string>& candidates,
+    int default_candidate,
+    size_t scratch_bytes,
+    const EncodeCandidate& encode);
+
+// Encodes the commands of a candidate configuration into a command buffer,
+// for candidates which aren't a single compute pass, e.g. MPS kernels
+using EncodeCandidateCommands = std::function<
+    void(MTL::CommandBuffer* cbuf, MTL::Buffer* scratch, int candidate)>;
+
+// Same as autotune for candidates encoded with EncodeCandidateCommands
+int autotune_commands(
+    Device& d,
+    const std::string& key,
+    const std::vector<std::string>& candidates,
+    int default_candidate,
+    size_t scratch_bytes,
+    const EncodeCandidateCommands& encode);
+
+// Binds the buffer of a at idx for the encoders of autotune
+void set_tuning_array(
+    MTL::ComputeCommandEncoder* enc,
+    const array& a,
+    int idx);
+
+} // namespace mlx::core::metal
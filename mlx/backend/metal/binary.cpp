@@ -3,6 +3,7 @@
 #include "mlx/backend/common/binary.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
+#include "mlx/backend/metal/kernels/defines.h"
 #include "mlx/backend/metal/utils.h"
 #include "mlx/primitives.h"
 
@@ -40,6 +41,10 @@ void binary_op_gpu_inplace(
   auto& strides_a = strides[0];
   auto& strides_b = strides[1];
   auto& strides_out = strides[2];
+  bool n_writes = bopt != BinaryOpType::General &&
+      out.data_size() >= ELEMWISE_N_WRITES_MIN_SIZE;
+  bool large = out.data_size() > INT32_MAX || a.data_size() > INT32_MAX ||
+      b.data_size() > INT32_MAX;
 
   std::string kernel_name;
   {
@@ -64,8 +69,14 @@ void binary_op_gpu_inplace(
         } else {
           kname << "n";
         }
+        if (large) {
+          kname << "large";
+        }
         break;
     }
+    if (n_writes) {
+      kname << "n";
+    }
     kname << op << type_to_name(a);
     kernel_name = kname.str();
   }
@@ -109,6 +120,10 @@ void binary_op_gpu_inplace(
     size_t dim0 = ndim > 0 ? shape[ndim - 1] : 1;
     size_t dim1 = ndim > 1 ? shape[ndim - 2] : 1;
     size_t rest = out.size() / (dim0 * dim1);
+    if (ndim > 3) {
+      // A thread per ELEMWISE_N_WRITES elements of the inner dim
+      dim0 = (dim0 + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
     NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
     if (thread_group_size != 1024) {
       throw std::runtime_error("[Metal::binary] Must use 1024 sized block");
@@ -119,6 +134,10 @@ void binary_op_gpu_inplace(
   } else {
     // Launch a 1D grid of threads
     size_t nthreads = out.data_size();
+    if (n_writes) {
+      compute_encoder->setBytes(&nthreads, sizeof(size_t), 4);
+      nthreads = (nthreads + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
     MTL::Size grid_dims = MTL::Size(nthreads, 1, 1);
     NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
     if (thread_group_size > nthreads) {
@@ -168,6 +187,10 @@ void binary_op_gpu_inplace(
   auto& strides_a = strides[0];
   auto& strides_b = strides[1];
   auto& strides_out = strides[2];
+  bool n_writes = bopt != BinaryOpType::General &&
+      out.data_size() >= ELEMWISE_N_WRITES_MIN_SIZE;
+  bool large = out.data_size() > INT32_MAX || a.data_size() > INT32_MAX ||
+      b.data_size() > INT32_MAX;
 
   std::string kernel_name;
   {
@@ -192,8 +215,14 @@ void binary_op_gpu_inplace(
         } else {
           kname << "n";
         }
+        if (large) {
+          kname << "large";
+        }
         break;
     }
+    if (n_writes) {
+      kname << "n";
+    }
     kname << op << type_to_name(a);
     kernel_name = kname.str();
   }
@@ -229,6 +258,10 @@ void binary_op_gpu_inplace(
     size_t dim0 = ndim > 0 ? shape[ndim - 1] : 1;
     size_t dim1 = ndim > 1 ? shape[ndim - 2] : 1;
     size_t rest = out.size() / (dim0 * dim1);
+    if (ndim > 3) {
+      // A thread per ELEMWISE_N_WRITES elements of the inner dim
+      dim0 = (dim0 + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
     NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
     if (thread_group_size != 1024) {
       throw std::runtime_error("[Metal::binary] Must use 1024 sized block");
@@ -238,8 +271,11 @@ void binary_op_gpu_inplace(
     compute_encoder.dispatchThreads(grid_dims, group_dims);
   } else {
     // Launch a 1D grid of threads
-    size_t nthreads =
-        bopt == BinaryOpType::General ? out.size() : out.data_size();
+    size_t nthreads = out.data_size();
+    if (n_writes) {
+      compute_encoder->setBytes(&nthreads, sizeof(size_t), 3);
+      nthreads = (nthreads + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
     MTL::Size grid_dims = MTL::Size(nthreads, 1, 1);
     NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
     if (thread_group_size > nthreads) {
@@ -0,0 +1,398 @@
+// Copyright © 2024 Apple Inc.
+
+#include <atomic>
+#include <mutex>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/metal/capture.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/metal_impl.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core::metal {
+
+CaptureRecorder::CaptureRecorder(const std::vector<array>& inputs) {
+  for (auto& in : inputs) {
+    input_buffers_.insert(in.buffer().ptr());
+  }
+}
+
+void CaptureRecorder::set_pipeline(MTL::ComputePipelineState* kernel) {
+  CapturedCommand cmd{CapturedCommand::Type::pipeline};
+  cmd.kernel = kernel;
+  commands.push_back(std::move(cmd));
+}
+
+void CaptureRecorder::set_bytes(
+    const void* bytes,
+    NS::UInteger length,
+    NS::UInteger index) {
+  CapturedCommand cmd{CapturedCommand::Type::bytes, index};
+  auto begin = static_cast<const char*>(bytes);
+  cmd.bytes.assign(begin, begin + length);
+  commands.push_back(std::move(cmd));
+}
+
+void CaptureRecorder::set_threadgroup_memory(
+    NS::UInteger length,
+    NS::UInteger index) {
+  CapturedCommand cmd{CapturedCommand::Type::threadgroup_memory, index};
+  cmd.length = length;
+  commands.push_back(std::move(cmd));
+}
+
+void CaptureRecorder::set_buffer(
+    const array& a,
+    int64_t offset,
+    int index,
+    const std::pair<int64_t, int64_t>& range,
+    bool is_output) {
+  CapturedCommand cmd{CapturedCommand::Type::buffer, NS::UInteger(index)};
+  cmd.buffer = a.buffer().ptr();
+  cmd.offset = offset;
+  cmd.range = range;
+  cmd.is_output = is_output;
+  if (is_output) {
+    written_buffers_.insert(cmd.buffer);
+  } else if (
+      input_buffers_.find(cmd.buffer) == input_buffers_.end() &&
+      written_buffers_.find(cmd.buffer) == written_buffers_.end()) {
+    host_data.insert({cmd.buffer, a.data_shared_ptr()});
+  }
+  commands.push_back(std::move(cmd));
+}
+
+void CaptureRecorder::dispatch(
+    MTL::Size grid_dims,
+    MTL::Size group_dims,
+    bool threads) {
+  CapturedCommand cmd{
+      threads ? CapturedCommand::Type::dispatch_threads
+              : CapturedCommand::Type::dispatch_threadgroups};
+  cmd.grid_dims = grid_dims;
+  cmd.group_dims = group_dims;
+  commands.push_back(std::move(cmd));
+}
+
+namespace {
+
+// Keep a few input layouts per primitive, e.g. for inputs that are only
+// sometimes donated
+constexpr int max_captures_per_primitive = 4;
+
+// How to set up an output before replaying the commands
+struct CapturedOutput {
+  // Share the buffer of an input at offset elements from its data, otherwise
+  // allocate a new buffer of nbytes
+  int input{-1};
+  size_t offset{0};
+  size_t nbytes{0};
+  size_t data_size;
+  std::vector<size_t> strides;
+  array::Flags flags;
+};
+
+struct CapturedEval {
+  std::vector<int64_t> signature;
+  bool valid{false};
+  std::vector<CapturedCommand> commands;
+  std::vector<CapturedOutput> outputs;
+
+  // Temporaries hold host data or are allocated on each replay with nbytes
+  std::vector<std::pair<std::shared_ptr<array::Data>, size_t>> temporaries;
+};
+
+struct Capture {
+  std::weak_ptr<Primitive> primitive;
+  std::vector<std::shared_ptr<CapturedEval>> evals;
+};
+
+std::mutex captures_mtx;
+std::atomic<bool> has_captures{false};
+
+std::unordered_map<const Primitive*, std::shared_ptr<Capture>>& captures() {
+  static std::unordered_map<const Primitive*, std::shared_ptr<Capture>>
+      captures_;
+  return captures_;
+}
+
+std::shared_ptr<Capture> find_capture(const Primitive& p) {
+  if (!has_captures) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lk(captures_mtx);
+  auto it = captures().find(&p);
+  if (it == captures().end() || it->second->primitive.expired()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+// Everything eval_gpu may base its choice of kernels, launch sizes and
+// allocations on
+std::vector<int64_t> signature(const std::vector<array>& inputs) {
+  std::vector<int64_t> sig;
+  for (int i = 0; i < inputs.size(); i++) {
+    auto& in = inputs[i];
+    sig.push_back(static_cast<int64_t>(in.dtype().val));
+    sig.push_back(in.ndim());
+    sig.insert(sig.end(), in.shape().begin(), in.shape().end());
+    sig.insert(sig.end(), in.strides().begin(), in.strides().end());
+    sig.push_back(in.data_size());
+    sig.push_back(
+        in.flags().contiguous | (in.flags().row_contiguous << 1) |
+        (in.flags().col_contiguous << 2) | (in.is_donatable() << 3));
+    int shared = -1;
+    for (int j = 0; j < i && in.buffer().ptr() != nullptr; j++) {
+      if (inputs[j].buffer().ptr() == in.buffer().ptr()) {
+        shared = j;
+        break;
+      }
+    }
+    sig.push_back(shared);
+    if (shared >= 0) {
+      sig.push_back(in.data<char>() - inputs[shared].data<char>());
+    }
+  }
+  return sig;
+}
+
+int64_t data_offset(const array& a) {
+  auto buf = static_cast<MTL::Buffer*>(const_cast<void*>(a.buffer().ptr()));
+  return a.data<char>() - static_cast<char*>(buf->contents());
+}
+
+// Turns a recording into commands that can be replayed with other inputs
+// and outputs. Returns false if the evaluation did anything a replay can't
+// reproduce.
+bool resolve(
+    CapturedEval& c,
+    CaptureRecorder& rec,
+    const std::vector<array>& inputs,
+    const std::vector<array>& outputs) {
+  if (!rec.valid) {
+    return false;
+  }
+
+  auto find_input = [&](const void* buf) {
+    for (int i = 0; i < inputs.size(); i++) {
+      if (buf != nullptr && inputs[i].buffer().ptr() == buf) {
+        return i;
+      }
+    }
+    return -1;
+  };
+  auto is_written = [&](const void* buf) {
+    for (auto& cmd : rec.commands) {
+      if (cmd.type == CapturedCommand::Type::buffer && cmd.buffer == buf &&
+          cmd.is_output) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Outputs are either views of an input or own a buffer a kernel wrote
+  std::unordered_map<const void*, int> output_buffers;
+  for (int i = 0; i < outputs.size(); i++) {
+    auto& out = outputs[i];
+    auto buf = out.buffer().ptr();
+    CapturedOutput co{-1, 0, 0, out.data_size(), out.strides(), out.flags()};
+    if (auto j = find_input(buf); j >= 0) {
+      auto diff = out.data<char>() - inputs[j].data<char>();
+      if (diff < 0 || diff % out.itemsize() != 0) {
+        return false;
+      }
+      co.input = j;
+      co.offset = diff / out.itemsize();
+    } else {
+      if (buf == nullptr || data_offset(out) != 0 || !is_written(buf) ||
+          output_buffers.find(buf) != output_buffers.end()) {
+        return false;
+      }
+      co.nbytes = static_cast<const MTL::Buffer*>(buf)->length();
+      output_buffers.insert({buf, i});
+    }
+    c.outputs.push_back(std::move(co));
+  }
+
+  std::unordered_map<const void*, int> temporaries;
+  for (auto& cmd : rec.commands) {
+    if (cmd.type != CapturedCommand::Type::buffer) {
+      c.commands.push_back(std::move(cmd));
+      continue;
+    }
+    int64_t base = 0;
+    if (auto j = find_input(cmd.buffer); j >= 0) {
+      cmd.source = CapturedCommand::Source::input;
+      cmd.source_index = j;
+      base = data_offset(inputs[j]);
+    } else if (auto it = output_buffers.find(cmd.buffer);
+               it != output_buffers.end()) {
+      cmd.source = CapturedCommand::Source::output;
+      cmd.source_index = it->second;
+    } else {
+      auto [t, inserted] = temporaries.insert(
+          {cmd.buffer, static_cast<int>(c.temporaries.size())});
+      if (inserted) {
+        auto data = rec.host_data.find(cmd.buffer);
+        if (data != rec.host_data.end()) {
+          c.temporaries.emplace_back(data->second, 0);
+        } else {
+          c.temporaries.emplace_back(
+              nullptr, static_cast<const MTL::Buffer*>(cmd.buffer)->length());
+        }
+      }
+      // Host data must not change between replays
+      if (cmd.is_output && c.temporaries[t->second].first) {
+        return false;
+      }
+      cmd.source = CapturedCommand::Source::temporary;
+      cmd.source_index = t->second;
+    }
+    cmd.offset -= base;
+    cmd.range.first -= base;
+    cmd.range.second -= base;
+    cmd.buffer = nullptr;
+    c.commands.push_back(std::move(cmd));
+  }
+  return true;
+}
+
+void replay(
+    const CapturedEval& c,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    const Stream& s) {
+  for (int i = 0; i < outputs.size(); i++) {
+    auto& co = c.outputs[i];
+    if (co.input >= 0) {
+      outputs[i].copy_shared_buffer(
+          inputs[co.input], co.strides, co.flags, co.data_size, co.offset);
+    } else {
+      outputs[i].set_data(
+          allocator::malloc_or_wait(co.nbytes),
+          co.data_size,
+          co.strides,
+          co.flags);
+    }
+  }
+
+  std::vector<std::shared_ptr<array::Data>> temporaries;
+  for (auto& [data, nbytes] : c.temporaries) {
+    temporaries.push_back(
+        data ? data
+             : std::make_shared<array::Data>(
+                   allocator::malloc_or_wait(nbytes)));
+  }
+
+  auto& d = device(s.device);
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  for (auto& cmd : c.commands) {
+    switch (cmd.type) {
+      case CapturedCommand::Type::pipeline:
+        compute_encoder->setComputePipelineState(cmd.kernel);
+        break;
+      case CapturedCommand::Type::bytes:
+        compute_encoder->setBytes(
+            cmd.bytes.data(), cmd.bytes.size(), cmd.index);
+        break;
+      case CapturedCommand::Type::threadgroup_memory:
+        compute_encoder->setThreadgroupMemoryLength(cmd.length, cmd.index);
+        break;
+      case CapturedCommand::Type::buffer: {
+        const void* buf = nullptr;
+        int64_t base = 0;
+        switch (cmd.source) {
+          case CapturedCommand::Source::input:
+            buf = inputs[cmd.source_index].buffer().ptr();
+            base = data_offset(inputs[cmd.source_index]);
+            break;
+          case CapturedCommand::Source::output:
+            buf = outputs[cmd.source_index].buffer().ptr();
+            break;
+          case CapturedCommand::Source::temporary:
+            buf = temporaries[cmd.source_index]->buffer.ptr();
+            break;
+        }
+        compute_encoder.set_buffer(
+            static_cast<const MTL::Buffer*>(buf),
+            base + cmd.offset,
+            cmd.index,
+            {base + cmd.range.first, base + cmd.range.second},
+            cmd.is_output);
+        break;
+      }
+      case CapturedCommand::Type::dispatch_threadgroups:
+        compute_encoder.dispatchThreadgroups(cmd.grid_dims, cmd.group_dims);
+        break;
+      case CapturedCommand::Type::dispatch_threads:
+        compute_encoder.dispatchThreads(cmd.grid_dims, cmd.group_dims);
+        break;
+    }
+  }
+
+  if (!temporaries.empty()) {
+    d.get_command_buffer(s.index)->addCompletedHandler(
+        [temporaries = std::move(temporaries)](MTL::CommandBuffer*) mutable {
+          temporaries.clear();
+        });
+  }
+}
+
+} // namespace
+
+void capture_primitive(std::shared_ptr<Primitive> p) {
+  std::lock_guard<std::mutex> lk(captures_mtx);
+  auto& caps = captures();
+  for (auto it = caps.begin(); it != caps.end();) {
+    if (it->second->primitive.expired()) {
+      it = caps.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (caps.find(p.get()) == caps.end()) {
+    auto c = std::make_shared<Capture>();
+    c->primitive = p;
+    caps.insert({p.get(), std::move(c)});
+  }
+  has_captures = true;
+}
+
+void eval_gpu(array& arr, std::vector<array>& outputs) {
+  auto& p = arr.primitive();
+  auto capture = find_capture(p);
+  if (!capture) {
+    p.eval_gpu(arr.inputs(), outputs);
+    return;
+  }
+
+  auto sig = signature(arr.inputs());
+  for (auto& c : capture->evals) {
+    if (c->signature == sig) {
+      if (c->valid) {
+        replay(*c, arr.inputs(), outputs, p.stream());
+      } else {
+        p.eval_gpu(arr.inputs(), outputs);
+      }
+      return;
+    }
+  }
+
+  auto& d = device(p.stream().device);
+  CaptureRecorder rec(arr.inputs());
+  d.set_recorder(p.stream().index, &rec);
+  p.eval_gpu(arr.inputs(), outputs);
+  d.set_recorder(p.stream().index, nullptr);
+
+  auto c = std::make_shared<CapturedEval>();
+  c->signature = std::move(sig);
+  c->valid = resolve(*c, rec, arr.inputs(), outputs);
+  if (capture->evals.size() == max_captures_per_primitive) {
+    capture->evals.erase(capture->evals.begin());
+  }
+  capture->evals.push_back(std::move(c));
+}
+
+} // namespace mlx::core::metal
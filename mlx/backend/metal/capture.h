@@ -0,0 +1,88 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <Metal/Metal.hpp>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "mlx/array.h"
+
+namespace mlx::core::metal {
+
+// A command issued to the compute encoder while evaluating a primitive.
+// Buffers are recorded by the Metal buffer they bind and resolved to the
+// input, output or temporary of the evaluation they belong to once it is
+// done.
+struct CapturedCommand {
+  enum class Type {
+    pipeline,
+    bytes,
+    buffer,
+    threadgroup_memory,
+    dispatch_threadgroups,
+    dispatch_threads,
+  };
+  enum class Source { input, output, temporary };
+
+  Type type;
+  NS::UInteger index{0};
+
+  // pipeline
+  MTL::ComputePipelineState* kernel{nullptr};
+
+  // bytes or threadgroup_memory
+  std::vector<char> bytes;
+  NS::UInteger length{0};
+
+  // buffer, the offset and range are in bytes from the start of the buffer
+  // while recording and from the data of the source once resolved
+  const void* buffer{nullptr};
+  Source source{Source::temporary};
+  int source_index{0};
+  int64_t offset{0};
+  std::pair<int64_t, int64_t> range{0, 0};
+  bool is_output{false};
+
+  // dispatch
+  MTL::Size grid_dims;
+  MTL::Size group_dims;
+};
+
+// Records what a primitive encodes while it is evaluated. It is set on the
+// stream's CommandEncoder with Device::set_recorder.
+struct CaptureRecorder {
+  explicit CaptureRecorder(const std::vector<array>& inputs);
+
+  void set_pipeline(MTL::ComputePipelineState* kernel);
+  void set_bytes(const void* bytes, NS::UInteger length, NS::UInteger index);
+  void set_threadgroup_memory(NS::UInteger length, NS::UInteger index);
+  void set_buffer(
+      const array& a,
+      int64_t offset,
+      int index,
+      const std::pair<int64_t, int64_t>& range,
+      bool is_output);
+  void dispatch(MTL::Size grid_dims, MTL::Size group_dims, bool threads);
+
+  bool valid{true};
+  std::vector<CapturedCommand> commands;
+
+  // Buffers read before anything wrote them hold data filled in on the host
+  // which has to be kept for replays
+  std::unordered_map<const void*, std::shared_ptr<array::Data>> host_data;
+
+ private:
+  std::unordered_set<const void*> input_buffers_;
+  std::unordered_set<const void*> written_buffers_;
+};
+
+// Evaluates the primitive of arr on the GPU. Primitives registered with
+// capture_primitive have the work they encode recorded the first time they
+// are evaluated with a given input layout, and replayed with the new buffers
+// afterwards instead of running eval_gpu.
+void eval_gpu(array& arr, std::vector<array>& outputs);
+
+} // namespace mlx::core::metal
@@ -7,12 +7,17 @@
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/jit/includes.h"
 #include "mlx/backend/metal/utils.h"
+#include "mlx/compile_impl.h"
 #include "mlx/graph_utils.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
 
 namespace mlx::core {
 
+// Strided inputs of up to this many collapsed dims get a kernel which reads
+// the indices from the grid, the others compute them from the flat index
+constexpr int max_static_ndim = 3;
+
 inline void build_kernel(
     std::ostream& os,
     const std::string& kernel_name,
@@ -143,7 +148,7 @@ inline void build_kernel(
     } else {
       os << "  " << get_type_string(x.dtype()) << " tmp_" << xname << " = "
          << xname << "[elem_to_loc(index, output_shape, in_strides + "
-         << nc_in_count * ndim << ", ndim)];" << std::endl;
+         << nc_in_count << " * ndim, ndim)];" << std::endl;
       nc_in_count++;
     }
   }
@@ -156,7 +161,7 @@ inline void build_kernel(
       os << "static_cast<" << get_type_string(x.dtype()) << ">(tmp_"
          << namer.get_name(x.inputs()[0]) << ");" << std::endl;
     } else {
-      x.primitive().print(os);
+      print_op(os, x.primitive());
       os << "()(";
       for (int i = 0; i < x.inputs().size() - 1; i++) {
         os << "tmp_" << namer.get_name(x.inputs()[i]) << ", ";
@@ -184,60 +189,273 @@ inline void build_kernel(
   }
 }
 
-void Compiled::eval_gpu(
+// Build a kernel where each threadgroup computes the elementwise tape for the
+// elements of one row and reduces them without writing them out
+inline void build_reduce_kernel(
+    std::ostream& os,
+    const std::string& kernel_name,
     const std::vector<array>& inputs,
-    std::vector<array>& outputs) {
-  // Make the name for the kernel library
-  if (kernel_lib_.empty()) {
-    kernel_lib_ = build_lib_name(inputs_, outputs_, tape_, constant_ids_);
+    const std::vector<array>& outputs,
+    const std::vector<array>& tape,
+    const std::unordered_set<uintptr_t>& constant_ids,
+    bool contiguous) {
+  auto is_constant = [&constant_ids](const array& x) {
+    return constant_ids.find(x.id()) != constant_ids.end();
+  };
+  auto is_strided = [&](const array& x) {
+    return !contiguous && !is_constant(x) && !is_scalar(x);
+  };
+
+  NodeNamer namer;
+  auto& out = outputs[0];
+  auto& reduced = tape.back().inputs()[0];
+  auto out_type = get_type_string(out.dtype());
+  std::ostringstream op;
+  tape.back().primitive().print(op);
+  auto op_type = op.str() + "<" + out_type + ">";
+  int cnt = 0;
+
+  os << "[[host_name(\"" << kernel_name << "\")]]" << std::endl
+     << "[[kernel]] void " << kernel_name << "(" << std::endl;
+  for (auto& x : inputs) {
+    auto& xname = namer.get_name(x);
+    if (is_constant(x)) {
+      continue;
+    }
+    os << "    device const " << get_type_string(x.dtype()) << "* " << xname
+       << " [[buffer(" << cnt++ << ")]]," << std::endl;
   }
+  if (!contiguous) {
+    os << "    constant const size_t* in_strides [[buffer(" << cnt++
+       << ")]]," << std::endl;
+  }
+  os << "    device " << out_type << "* " << namer.get_name(out)
+     << " [[buffer(" << cnt++ << ")]]," << std::endl;
+  if (!contiguous) {
+    os << "    constant const int* shape [[buffer(" << cnt++ << ")]],"
+       << std::endl
+       << "    constant const int& ndim [[buffer(" << cnt++ << ")]],"
+       << std::endl;
+  }
+  os << "    constant const size_t& row_size [[buffer(" << cnt++ << ")]],"
+     << std::endl
+     << "    uint gid [[threadgroup_position_in_grid]]," << std::endl
+     << "    uint lid [[thread_position_in_threadgroup]]," << std::endl
+     << "    uint lsize [[threads_per_threadgroup]]," << std::endl
+     << "    uint simd_lane_id [[thread_index_in_simdgroup]]," << std::endl
+     << "    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {"
+     << std::endl;
 
-  // Get the kernel if someone else built it already
-  auto& s = stream();
+  os << "  threadgroup " << out_type << " local_vals[simd_size];" << std::endl
+     << "  " << op_type << " op;" << std::endl
+     << "  " << out_type << " total = " << op_type << "::init;" << std::endl
+     << "  for (size_t r = lid; r < row_size; r += lsize) {" << std::endl
+     << "  size_t index = size_t(gid) * row_size + r;" << std::endl;
+
+  // Locate the strided inputs from the coordinates of the element
+  if (!contiguous) {
+    for (auto& x : inputs) {
+      if (is_strided(x)) {
+        os << "  size_t loc_" << namer.get_name(x) << " = 0;" << std::endl;
+      }
+    }
+    os << "  for (int d = ndim - 1; d >= 0; --d) {" << std::endl
+       << "  size_t c = index % shape[d];" << std::endl
+       << "  index /= shape[d];" << std::endl;
+    int nc_in_count = 0;
+    for (auto& x : inputs) {
+      if (is_strided(x)) {
+        os << "  loc_" << namer.get_name(x) << " += c * in_strides["
+           << nc_in_count++ << " * ndim + d];" << std::endl;
+      }
+    }
+    os << "  }" << std::endl;
+  }
+
+  // Read the inputs in tmps
+  for (auto& x : inputs) {
+    auto& xname = namer.get_name(x);
+    auto type_str = get_type_string(x.dtype());
+    os << "  auto tmp_" << xname << " = static_cast<" << type_str << ">(";
+    if (is_constant(x)) {
+      print_constant(os, x);
+    } else if (is_scalar(x)) {
+      os << xname << "[0]";
+    } else if (contiguous) {
+      os << xname << "[index]";
+    } else {
+      os << xname << "[loc_" << xname << "]";
+    }
+    os << ");" << std::endl;
+  }
+
+  // The elementwise computation, all but the final reduction
+  for (int i = 0; i < tape.size() - 1; ++i) {
+    auto& x = tape[i];
+    os << "  " << get_type_string(x.dtype()) << " tmp_" << namer.get_name(x)
+       << " = ";
+    if (is_static_cast(x.primitive())) {
+      os << "static_cast<" << get_type_string(x.dtype()) << ">(tmp_"
+         << namer.get_name(x.inputs()[0]) << ");" << std::endl;
+    } else {
+      print_op(os, x.primitive());
+      os << "()(";
+      for (int i = 0; i < x.inputs().size() - 1; i++) {
+        os << "tmp_" << namer.get_name(x.inputs()[i]) << ", ";
+      }
+      os << "tmp_" << namer.get_name(x.inputs().back()) << ");" << std::endl;
+    }
+  }
+  os << "  total = op(total, static_cast<" << out_type << ">(tmp_"
+     << namer.get_name(reduced) << "));" << std::endl
+     << "  }" << std::endl;
+
+  // Reduce the simdgroups and then the threadgroup
+  os << "  total = op.simd_reduce(total);" << std::endl
+     << "  if (simd_group_id == 0) {" << std::endl
+     << "    local_vals[simd_lane_id] = " << op_type << "::init;" << std::endl
+     << "  }" << std::endl
+     << "  threadgroup_barrier(mem_flags::mem_threadgroup);" << std::endl
+     << "  if (simd_lane_id == 0) {" << std::endl
+     << "    local_vals[simd_group_id] = total;" << std::endl
+     << "  }" << std::endl
+     << "  threadgroup_barrier(mem_flags::mem_threadgroup);" << std::endl
+     << "  if (simd_group_id == 0) {" << std::endl
+     << "    total = op.simd_reduce(local_vals[simd_lane_id]);" << std::endl
+     << "    if (simd_lane_id == 0) {" << std::endl
+     << "      " << namer.get_name(out) << "[gid] = total;" << std::endl
+     << "    }" << std::endl
+     << "  }" << std::endl
+     << "}" << std::endl;
+
+  if (cnt > 31) {
+    std::ostringstream msg;
+    msg << "[compile] Too many inputs fused in the Metal Compiled primitive "
+        << "which exhausted the available argument buffers for the kernel. "
+        << "The name of the kernel is '" << kernel_name << "'";
+    throw std::runtime_error(msg.str());
+  }
+}
+
+// Evaluate a fused reduction over the trailing axes of its elementwise input
+void eval_reduction_gpu(
+    const Stream& s,
+    const std::string& kernel_lib,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    const std::vector<array>& inputs_,
+    const std::vector<array>& outputs_,
+    const std::vector<array>& tape_,
+    const std::unordered_set<uintptr_t>& constant_ids_) {
   auto& d = metal::device(s.device);
-  auto lib = d.get_library(kernel_lib_);
+  auto& out = outputs[0];
+  auto shape = compiled_reduction_shape(inputs);
+  size_t n_rows = out.size();
+  size_t row_size = 1;
+  for (auto ax : compiled_reduction(tape_)->axes()) {
+    row_size *= shape[ax];
+  }
 
-  // If not we have to build it ourselves
+  // Row contiguous inputs are read with the flat index of the element
+  bool contiguous = true;
+  for (int i = 0; i < inputs.size(); i++) {
+    auto& x = inputs[i];
+    if (constant_ids_.find(inputs_[i].id()) != constant_ids_.end() ||
+        is_scalar(x)) {
+      continue;
+    }
+    contiguous &= x.flags().row_contiguous && x.shape() == shape;
+  }
+
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  if (n_rows == 0) {
+    return;
+  }
+
+  // Only the variant in use is built
+  auto kernel_name =
+      kernel_lib + (contiguous ? "_reduce_contiguous" : "_reduce_strided");
+  auto lib = d.get_library(kernel_name);
   if (lib == nullptr) {
     std::ostringstream kernel;
     kernel << metal::utils() << metal::unary_ops() << metal::binary_ops()
-           << metal::ternary_ops();
-    build_kernel(
+           << metal::ternary_ops() << metal::reduce_utils();
+    print_custom_ops(kernel, tape_);
+    build_reduce_kernel(
         kernel,
-        kernel_lib_ + "_contiguous",
+        kernel_name,
         inputs_,
         outputs_,
         tape_,
         constant_ids_,
-        /* contiguous = */ true,
-        /* ndim = */ 0,
-        /* dynamic_dims = */ false);
-    for (int i = 1; i < 8; i++) {
-      build_kernel(
-          kernel,
-          kernel_lib_ + "_strided_" + std::to_string(i),
-          inputs_,
-          outputs_,
-          tape_,
-          constant_ids_,
-          /* contiguous = */ false,
-          /* ndim = */ i,
-          /* dynamic_dims = */ false);
+        contiguous);
+    lib = d.get_library(kernel_name, kernel.str());
+    detail::count_generated_kernel();
+  }
+  auto kernel = d.get_kernel(kernel_name, lib);
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+
+  int cnt = 0;
+  std::vector<size_t> in_strides;
+  for (int i = 0; i < inputs.size(); i++) {
+    if (constant_ids_.find(inputs_[i].id()) != constant_ids_.end()) {
+      continue;
     }
-    build_kernel(
-        kernel,
-        kernel_lib_ + "_strided_dynamic",
+    auto& x = inputs[i];
+    compute_encoder.set_input_array(x, cnt++);
+    if (!contiguous && !is_scalar(x)) {
+      auto x_strides = compiled_reduction_strides(x, shape);
+      in_strides.insert(in_strides.end(), x_strides.begin(), x_strides.end());
+    }
+  }
+  if (!contiguous) {
+    // Keep the buffer valid when every input is a scalar
+    in_strides.push_back(0);
+    compute_encoder->setBytes(
+        in_strides.data(), in_strides.size() * sizeof(size_t), cnt++);
+  }
+  compute_encoder.set_output_array(out, cnt++);
+  if (!contiguous) {
+    int ndim = shape.size();
+    compute_encoder->setBytes(shape.data(), ndim * sizeof(int), cnt++);
+    compute_encoder->setBytes(&ndim, sizeof(int), cnt++);
+  }
+  compute_encoder->setBytes(&row_size, sizeof(size_t), cnt++);
+
+  size_t simds_needed = (row_size + 31) / 32;
+  size_t threadgroup_size = std::min(
+      32 * std::max<size_t>(simds_needed, 1),
+      static_cast<size_t>(kernel->maxTotalThreadsPerThreadgroup()));
+  MTL::Size grid_dims(n_rows * threadgroup_size, 1, 1);
+  MTL::Size group_dims(threadgroup_size, 1, 1);
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+}
+
+void Compiled::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  // Make the name for the kernel library
+  if (kernel_lib_.empty()) {
+    kernel_lib_ = build_lib_name(inputs_, outputs_, tape_, constant_ids_);
+  }
+
+  if (compiled_reduction(tape_)) {
+    eval_reduction_gpu(
+        stream(),
+        kernel_lib_,
+        inputs,
+        outputs,
         inputs_,
         outputs_,
         tape_,
-        constant_ids_,
-        /* contiguous = */ false,
-        /* ndim = */ 0,
-        /* dynamic_dims = */ true);
-
-    lib = d.get_library(kernel_lib_, kernel.str());
+        constant_ids_);
+    return;
   }
 
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
   // Figure out which kernel we are using
   auto& output_shape = outputs[0].shape();
   bool contiguous = compiled_check_contiguity(inputs, output_shape);
@@ -288,9 +506,10 @@ void Compiled::eval_gpu(
         collapse_contiguous_dims(output_shape, initial_strides);
   }
 
-  // Get the kernel from the lib
+  // With the dims collapsed and broadcasts as zero strides a few variants
+  // cover every stride pattern, and only the ones in use are built
   int ndim = shape.size();
-  bool dynamic = ndim >= 8;
+  bool dynamic = ndim > max_static_ndim;
   auto kernel_name = kernel_lib_ + (contiguous ? "_contiguous" : "_strided_");
   if (!contiguous) {
     if (dynamic) {
@@ -299,6 +518,25 @@ void Compiled::eval_gpu(
       kernel_name += std::to_string(shape.size());
     }
   }
+  auto lib = d.get_library(kernel_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel;
+    kernel << metal::utils() << metal::unary_ops() << metal::binary_ops()
+           << metal::ternary_ops();
+    print_custom_ops(kernel, tape_);
+    build_kernel(
+        kernel,
+        kernel_name,
+        inputs_,
+        outputs_,
+        tape_,
+        constant_ids_,
+        contiguous,
+        dynamic ? 0 : ndim,
+        dynamic);
+    lib = d.get_library(kernel_name, kernel.str());
+    detail::count_generated_kernel();
+  }
   auto kernel = d.get_kernel(kernel_name, lib);
   auto& compute_encoder = d.get_command_encoder(s.index);
   compute_encoder->setComputePipelineState(kernel);
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cassert>
 #include <numeric>
+#include <optional>
 #include <sstream>
 
 #include "mlx/backend/metal/copy.h"
@@ -11,7 +12,9 @@
 #include "mlx/backend/metal/kernels/defines.h"
 #include "mlx/backend/metal/kernels/steel/conv/params.h"
 #include "mlx/backend/metal/matmul.h"
+#include "mlx/backend/metal/prepack.h"
 #include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
 
@@ -21,6 +24,65 @@ namespace mlx::core {
 
 namespace {
 
+// Bias and activation applied to the output of the convolution
+struct ConvEpilogue {
+  std::optional<array> bias;
+  int activation{0};
+
+  bool empty() const {
+    return !bias && activation == 0;
+  }
+};
+
+// Appends the epilogue function constants to a kernel name to hash the
+// specialized pipeline
+std::string conv_epilogue_hash_name(
+    const std::string& kernel_name,
+    bool has_bias,
+    int activation) {
+  std::ostringstream hash_name;
+  hash_name << kernel_name << "_bias_" << (has_bias ? 't' : 'n') << "_act_"
+            << activation;
+  return hash_name.str();
+}
+
+// Applies the epilogue in place for the paths that do not fuse it
+void conv_epilogue_gpu(
+    const Stream& s,
+    metal::Device& d,
+    array& out,
+    const ConvEpilogue& epilogue) {
+  if (epilogue.empty()) {
+    return;
+  }
+
+  std::string kname = "conv_epilogue_" + type_to_name(out);
+
+  bool has_bias = epilogue.bias.has_value();
+  int activation = epilogue.activation;
+  metal::MTLFCList func_consts = {
+      {&has_bias, MTL::DataType::DataTypeBool, 500},
+      {&activation, MTL::DataType::DataTypeInt, 501},
+  };
+  auto hash_name = conv_epilogue_hash_name(kname, has_bias, activation);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel = d.get_kernel(kname, "mlx", hash_name, func_consts);
+  compute_encoder->setComputePipelineState(kernel);
+
+  int O = out.shape(-1);
+  compute_encoder.set_output_array(out, 0);
+  if (has_bias) {
+    compute_encoder.set_input_array(*epilogue.bias, 1);
+  }
+  compute_encoder->setBytes(&O, sizeof(int), 2);
+
+  int tgp_x = std::min(O, 256);
+  MTL::Size group_dims = MTL::Size(tgp_x, 256 / tgp_x, 1);
+  MTL::Size grid_dims = MTL::Size(O, out.size() / O, 1);
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+}
+
 template <int N>
 void explicit_gemm_conv_ND_gpu(
     const Stream& s,
@@ -142,20 +204,23 @@ void explicit_gemm_conv_group_ND_gpu(
 
   // Transpose kernel weights so that we can slice them by contiguous chunks
   // of channel groups.
-  array wt_view(
-      {wt.shape(0), C_per_group, kernel_size}, wt.dtype(), nullptr, {});
-  wt_view.copy_shared_buffer(
-      wt,
-      {wt.strides(0), 1, static_cast<size_t>(C_per_group)},
-      wt.flags(),
-      wt.size());
-
-  // Materialize
-  auto wt_transpose = array(wt_view.shape(), wt_view.dtype(), nullptr, {});
-  copy_gpu(wt_view, wt_transpose, CopyType::General, s);
+  auto wt_transpose = prepack_cache().get(wt, "group_transpose", s, [&]() {
+    array wt_view(
+        {wt.shape(0), C_per_group, kernel_size}, wt.dtype(), nullptr, {});
+    wt_view.copy_shared_buffer(
+        wt,
+        {wt.strides(0), 1, static_cast<size_t>(C_per_group)},
+        wt.flags(),
+        wt.size());
+
+    // Materialize
+    array transposed(wt_view.shape(), wt_view.dtype(), nullptr, {});
+    copy_gpu(wt_view, transposed, CopyType::General, s);
+    return transposed;
+  });
 
   // Perform gemm
-  std::vector<array> copies = {in_unfolded, wt_view, wt_transpose};
+  std::vector<array> copies = {in_unfolded, wt_transpose};
   return steel_matmul_conv_groups(
       s,
       d,
@@ -174,47 +239,6 @@ void explicit_gemm_conv_group_ND_gpu(
       /*copies = */ copies);
 }
 
-void conv_1D_gpu(
-    const Stream& s,
-    metal::Device& d,
-    const array& in,
-    const array& wt,
-    array out,
-    const std::vector<int>& padding,
-    const std::vector<int>& wt_strides,
-    const std::vector<int>& wt_dilation,
-    const std::vector<int>& in_dilation,
-    int groups,
-    bool flip) {
-  // Make conv params
-  MLXConvParams<1> conv_params{
-      /* const int  N = */ in.shape(0),
-      /* const int  C = */ in.shape(2),
-      /* const int  O = */ wt.shape(0),
-      /* const int iS[NDIM] = */ {in.shape(1)},
-      /* const int wS[NDIM] = */ {wt.shape(1)},
-      /* const int oS[NDIM] = */ {out.shape(1)},
-      /* const int str[NDIM] = */ {wt_strides[0]},
-      /* const int pad[NDIM] = */ {padding[0]},
-      /* const int kdil[NDIM] = */ {wt_dilation[0]},
-      /* const int idil[NDIM] = */ {in_dilation[0]},
-      /* const size_t in_strides[NDIM + 2] = */
-      {in.strides()[0], in.strides()[1], in.strides()[2]},
-      /* const size_t wt_strides[NDIM + 2] = */
-      {wt.strides()[0], wt.strides()[1], wt.strides()[2]},
-      /* const size_t out_strides[NDIM + 2] = */
-      {out.strides()[0], out.strides()[1], out.strides()[2]},
-      /* const int groups = */ groups,
-      /* const bool flip = */ flip};
-
-  // Direct to explicit gemm conv
-  if (groups > 1) {
-    return explicit_gemm_conv_group_ND_gpu(s, d, in, wt, out, conv_params);
-  } else {
-    return explicit_gemm_conv_ND_gpu(s, d, in, wt, out, conv_params);
-  }
-}
-
 void slow_conv_2D_gpu(
     const Stream& s,
     metal::Device& d,
@@ -251,13 +275,58 @@ void slow_conv_2D_gpu(
   compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
 }
 
+void depthwise_conv_2D_gpu(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    const array& wt,
+    array out,
+    const MLXConvParams<2>& conv_params,
+    const ConvEpilogue& epilogue) {
+  std::ostringstream kname;
+  kname << "depthwise_conv_2d_" << type_to_name(out);
+
+  bool has_bias = epilogue.bias.has_value();
+  int activation = epilogue.activation;
+  metal::MTLFCList func_consts = {
+      {&has_bias, MTL::DataType::DataTypeBool, 500},
+      {&activation, MTL::DataType::DataTypeInt, 501},
+  };
+  auto hash_name = conv_epilogue_hash_name(kname.str(), has_bias, activation);
+
+  // Encode and dispatch kernel
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel = d.get_kernel(kname.str(), "mlx", hash_name, func_consts);
+  compute_encoder->setComputePipelineState(kernel);
+
+  compute_encoder.set_input_array(in, 0);
+  compute_encoder.set_input_array(wt, 1);
+  compute_encoder.set_output_array(out, 2);
+
+  compute_encoder->setBytes(&conv_params, sizeof(MLXConvParams<2>), 3);
+  if (has_bias) {
+    compute_encoder.set_input_array(*epilogue.bias, 4);
+  }
+
+  int tgp_x = std::min(conv_params.C, 64);
+  tgp_x = 32 * ((tgp_x + 32 - 1) / 32);
+  int tgp_y = std::min(256 / tgp_x, conv_params.oS[1]);
+
+  MTL::Size group_dims = MTL::Size(tgp_x, tgp_y, 1);
+  MTL::Size grid_dims = MTL::Size(
+      conv_params.C, conv_params.oS[1], conv_params.N * conv_params.oS[0]);
+
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+}
+
 void implicit_gemm_conv_2D_gpu(
     const Stream& s,
     metal::Device& d,
     const array& in,
     const array& wt,
     array out,
-    const MLXConvParams<2>& conv_params) {
+    const MLXConvParams<2>& conv_params,
+    const ConvEpilogue& epilogue) {
   const int groups = conv_params.groups;
   const int C_per_group = conv_params.C / conv_params.groups;
   const int O_per_group = conv_params.O / conv_params.groups;
@@ -334,11 +403,21 @@ void implicit_gemm_conv_2D_gpu(
                                      : "l")
         << "_filter_" << (small_filter ? 's' : 'l');
 
+  bool has_bias = epilogue.bias.has_value();
+  int activation = epilogue.activation;
+  metal::MTLFCList func_consts = {
+      {&has_bias, MTL::DataType::DataTypeBool, 500},
+      {&activation, MTL::DataType::DataTypeInt, 501},
+  };
+  auto hash_name = conv_epilogue_hash_name(kname.str(), has_bias, activation);
+
   // Encode and dispatch kernel
   auto& compute_encoder = d.get_command_encoder(s.index);
   auto kernel = get_steel_conv_kernel(
       d,
       kname.str(),
+      hash_name,
+      func_consts,
       out,
       bm,
       bn,
@@ -365,6 +444,9 @@ void implicit_gemm_conv_2D_gpu(
   // Encode params
   compute_encoder->setBytes(&conv_params, sizeof(MLXConvParams<2>), 3);
   compute_encoder->setBytes(&gemm_params, sizeof(ImplicitGemmConv2DParams), 4);
+  if (has_bias) {
+    compute_encoder.set_input_array(*epilogue.bias, 5);
+  }
 
   // Launch kernel
   compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
@@ -376,7 +458,8 @@ void implicit_gemm_conv_2D_general_gpu(
     const array& in,
     const array& wt,
     array out,
-    const MLXConvParams<2>& conv_params) {
+    const MLXConvParams<2>& conv_params,
+    const ConvEpilogue& epilogue) {
   // Deduce implicit gemm size
   int implicit_M = conv_params.N * conv_params.oS[0] * conv_params.oS[1];
   int implicit_N = conv_params.O;
@@ -497,10 +580,18 @@ void implicit_gemm_conv_2D_general_gpu(
   kname << "implicit_gemm_conv_2d_general_" << type_to_name(out) << "_bm" << bm
         << "_bn" << bn << "_bk" << bk << "_wm" << wm << "_wn" << wn;
 
+  bool has_bias = epilogue.bias.has_value();
+  int activation = epilogue.activation;
+  metal::MTLFCList func_consts = {
+      {&has_bias, MTL::DataType::DataTypeBool, 500},
+      {&activation, MTL::DataType::DataTypeInt, 501},
+  };
+  auto hash_name = conv_epilogue_hash_name(kname.str(), has_bias, activation);
+
   // Encode and dispatch kernel
   auto& compute_encoder = d.get_command_encoder(s.index);
-  auto kernel =
-      get_steel_conv_general_kernel(d, kname.str(), out, bm, bn, bk, wm, wn);
+  auto kernel = get_steel_conv_general_kernel(
+      d, kname.str(), hash_name, func_consts, out, bm, bn, bk, wm, wn);
   compute_encoder->setComputePipelineState(kernel);
 
   // Deduce grid launch dimensions
@@ -526,11 +617,17 @@ void implicit_gemm_conv_2D_general_gpu(
       base_h.data(), sizeof(Conv2DGeneralBaseInfo) * base_h.size(), 6);
   compute_encoder->setBytes(
       base_w.data(), sizeof(Conv2DGeneralBaseInfo) * base_w.size(), 7);
+  if (has_bias) {
+    compute_encoder.set_input_array(*epilogue.bias, 8);
+  }
 
   // Launch kernel
   compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
 }
 
+// Winograd F(m x m, r x r) conv for stride 1 with r x r filters. The padding
+// is read as zeros by the input transform and the epilogue is applied by the
+// output transform.
 void winograd_conv_2D_gpu(
     const Stream& s,
     metal::Device& d,
@@ -538,102 +635,55 @@ void winograd_conv_2D_gpu(
     const array& wt,
     array out,
     const MLXConvParams<2>& conv_params,
-    std::vector<array>& copies_w) {
-  std::vector<int> padded_shape = {
-      conv_params.N,
-      conv_params.iS[0] + 2 * conv_params.pad[0],
-      conv_params.iS[1] + 2 * conv_params.pad[1],
-      conv_params.C};
-
-  padded_shape[1] = 6 * ((padded_shape[1] - 2 + 5) / 6) + 2;
-  padded_shape[2] = 6 * ((padded_shape[2] - 2 + 5) / 6) + 2;
-
-  array in_padded(padded_shape, in.dtype(), nullptr, {});
-
-  // Fill with zeros
-  array zero_arr = array(0, in.dtype());
-  copy_gpu(zero_arr, in_padded, CopyType::Scalar, s);
-  copies_w.push_back(zero_arr);
-
-  // Pick input slice from padded
-  size_t data_offset = conv_params.pad[0] * in_padded.strides()[1] +
-      conv_params.pad[1] * in_padded.strides()[2];
-  array in_padded_slice(in.shape(), in_padded.dtype(), nullptr, {});
-  in_padded_slice.copy_shared_buffer(
-      in_padded,
-      in_padded.strides(),
-      in_padded.flags(),
-      in_padded_slice.size(),
-      data_offset);
-
-  // Copy input values into the slice
-  copy_gpu_inplace(in, in_padded_slice, CopyType::GeneralGeneral, s);
-
-  copies_w.push_back(in_padded_slice);
-  copies_w.push_back(in_padded);
-  copies_w.push_back(zero_arr);
-
-  MLXConvParams<2> conv_params_updated{
-      /* const int  N = */ in_padded.shape(0),
-      /* const int  C = */ in_padded.shape(3),
-      /* const int  O = */ wt.shape(0),
-      /* const int iS[NDIM] = */ {in_padded.shape(1), in_padded.shape(2)},
-      /* const int wS[NDIM] = */ {wt.shape(1), wt.shape(2)},
-      /* const int oS[NDIM] = */ {out.shape(1), out.shape(2)},
-      /* const int str[NDIM] = */ {1, 1},
-      /* const int pad[NDIM] = */ {0, 0},
-      /* const int kdil[NDIM] = */ {1, 1},
-      /* const int idil[NDIM] = */ {1, 1},
-      /* const size_t in_strides[NDIM + 2] = */
-      {in_padded.strides()[0],
-       in_padded.strides()[1],
-       in_padded.strides()[2],
-       in_padded.strides()[3]},
-      /* const size_t wt_strides[NDIM + 2] = */
-      {wt.strides()[0], wt.strides()[1], wt.strides()[2], wt.strides()[3]},
-      /* const size_t out_strides[NDIM + 2] = */
-      {out.strides()[0], out.strides()[1], out.strides()[2], out.strides()[3]},
-      /* const int groups = */ 1,
-      /* const bool flip = */ false,
-  };
+    std::vector<array>& copies_w,
+    const ConvEpilogue& epilogue,
+    int m) {
+  int r = conv_params.wS[0];
+  int a = m + r - 1;
 
   int O_c = conv_params.O;
   int C_c = conv_params.C;
 
   int N_tiles_n = conv_params.N;
-  int N_tiles_h = (conv_params.oS[0] + 5) / 6;
-  int N_tiles_w = (conv_params.oS[1] + 5) / 6;
+  int N_tiles_h = (conv_params.oS[0] + m - 1) / m;
+  int N_tiles_w = (conv_params.oS[1] + m - 1) / m;
   int N_tiles = N_tiles_n * N_tiles_h * N_tiles_w;
 
+  std::ostringstream tile_name;
+  tile_name << "_m" << m << "_r" << r;
+
   // Do filter transform
-  std::vector<int> filt_wg_shape = {8 * 8, conv_params.C, conv_params.O};
-  array filt_wg(filt_wg_shape, wt.dtype(), nullptr, {});
-  filt_wg.set_data(allocator::malloc_or_wait(filt_wg.nbytes()));
+  auto filt_wg =
+      prepack_cache().get(wt, "winograd" + tile_name.str(), s, [&]() {
+        std::vector<int> filt_wg_shape = {a * a, conv_params.C, conv_params.O};
+        array filt_wg(filt_wg_shape, wt.dtype(), nullptr, {});
+        filt_wg.set_data(allocator::malloc_or_wait(filt_wg.nbytes()));
+
+        int bc = 32;
+        int bo = 4;
+        std::ostringstream kname;
+        kname << "winograd_conv_2d_weight_transform_" << type_to_name(out)
+              << tile_name.str() << "_bc" << bc;
+        auto& compute_encoder = d.get_command_encoder(s.index);
+        auto kernel = d.get_kernel(kname.str());
+        compute_encoder->setComputePipelineState(kernel);
+
+        compute_encoder.set_input_array(wt, 0);
+        compute_encoder.set_output_array(filt_wg, 1);
+
+        compute_encoder->setBytes(&C_c, sizeof(int), 2);
+        compute_encoder->setBytes(&O_c, sizeof(int), 3);
+
+        MTL::Size group_dims = MTL::Size(32, bo, 1);
+        MTL::Size grid_dims = MTL::Size(O_c / bo, 1, 1);
+
+        compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+        return filt_wg;
+      });
   copies_w.push_back(filt_wg);
-  {
-    int bc = 32;
-    int bo = 4;
-    std::ostringstream kname;
-    kname << "winograd_conv_2d_weight_transform_" << type_to_name(out) << "_bc"
-          << bc;
-    auto& compute_encoder = d.get_command_encoder(s.index);
-    auto kernel = d.get_kernel(kname.str());
-    compute_encoder->setComputePipelineState(kernel);
-
-    compute_encoder.set_input_array(wt, 0);
-    compute_encoder.set_output_array(filt_wg, 1);
-
-    compute_encoder->setBytes(&C_c, sizeof(int), 2);
-    compute_encoder->setBytes(&O_c, sizeof(int), 3);
-
-    MTL::Size group_dims = MTL::Size(32, bo, 1);
-    MTL::Size grid_dims = MTL::Size(O_c / bo, 1, 1);
-
-    compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
-  }
 
   // Do input transform
-  std::vector<int> inp_wg_shape = {8 * 8, N_tiles, conv_params.C};
+  std::vector<int> inp_wg_shape = {a * a, N_tiles, conv_params.C};
   array inp_wg(inp_wg_shape, in.dtype(), nullptr, {});
   inp_wg.set_data(allocator::malloc_or_wait(inp_wg.nbytes()));
   copies_w.push_back(inp_wg);
@@ -642,17 +692,16 @@ void winograd_conv_2D_gpu(
     int wm = 2;
     int wn = 2;
     std::ostringstream kname;
-    kname << "winograd_conv_2d_input_transform_" << type_to_name(out) << "_bc"
-          << bc;
+    kname << "winograd_conv_2d_input_transform_" << type_to_name(out)
+          << tile_name.str() << "_bc" << bc;
     auto& compute_encoder = d.get_command_encoder(s.index);
     auto kernel = d.get_kernel(kname.str());
     compute_encoder->setComputePipelineState(kernel);
 
-    compute_encoder.set_input_array(in_padded, 0);
+    compute_encoder.set_input_array(in, 0);
     compute_encoder.set_output_array(inp_wg, 1);
 
-    compute_encoder->setBytes(
-        &conv_params_updated, sizeof(MLXConvParams<2>), 2);
+    compute_encoder->setBytes(&conv_params, sizeof(MLXConvParams<2>), 2);
 
     MTL::Size group_dims = MTL::Size(32, wn, wm);
     MTL::Size grid_dims = MTL::Size(N_tiles_w, N_tiles_h, N_tiles_n);
@@ -661,7 +710,7 @@ void winograd_conv_2D_gpu(
   }
 
   // Do batched gemm
-  std::vector<int> out_wg_shape = {8 * 8, N_tiles, conv_params.O};
+  std::vector<int> out_wg_shape = {a * a, N_tiles, conv_params.O};
   array out_wg(out_wg_shape, in.dtype(), nullptr, {});
   out_wg.set_data(allocator::malloc_or_wait(out_wg.nbytes()));
   copies_w.push_back(out_wg);
@@ -676,7 +725,7 @@ void winograd_conv_2D_gpu(
         /*M = */ N_tiles,
         /*N = */ conv_params.O,
         /*K = */ conv_params.C,
-        /*batch_size_out = */ 8 * 8,
+        /*batch_size_out = */ a * a,
         /*a_cols = */ conv_params.C,
         /*b_cols = */ conv_params.O,
         /*a_transposed = */ false,
@@ -690,17 +739,29 @@ void winograd_conv_2D_gpu(
     int wm = 2;
     int wn = 2;
     std::ostringstream kname;
-    kname << "winograd_conv_2d_output_transform_" << type_to_name(out) << "_bo"
-          << bc;
+    kname << "winograd_conv_2d_output_transform_" << type_to_name(out)
+          << tile_name.str() << "_bo" << bc;
+
+    bool has_bias = epilogue.bias.has_value();
+    int activation = epilogue.activation;
+    metal::MTLFCList func_consts = {
+        {&has_bias, MTL::DataType::DataTypeBool, 500},
+        {&activation, MTL::DataType::DataTypeInt, 501},
+    };
+    auto hash_name =
+        conv_epilogue_hash_name(kname.str(), has_bias, activation);
+
     auto& compute_encoder = d.get_command_encoder(s.index);
-    auto kernel = d.get_kernel(kname.str());
+    auto kernel = d.get_kernel(kname.str(), "mlx", hash_name, func_consts);
     compute_encoder->setComputePipelineState(kernel);
 
     compute_encoder.set_input_array(out_wg, 0);
     compute_encoder.set_output_array(out, 1);
 
-    compute_encoder->setBytes(
-        &conv_params_updated, sizeof(MLXConvParams<2>), 2);
+    compute_encoder->setBytes(&conv_params, sizeof(MLXConvParams<2>), 2);
+    if (has_bias) {
+      compute_encoder.set_input_array(*epilogue.bias, 3);
+    }
 
     MTL::Size group_dims = MTL::Size(32, wn, wm);
     MTL::Size grid_dims = MTL::Size(N_tiles_w, N_tiles_h, N_tiles_n);
@@ -709,40 +770,57 @@ void winograd_conv_2D_gpu(
   }
 }
 
-void conv_2D_gpu(
+// Output tile size of the Winograd conv expected to be fastest, or 0 when
+// the implicit gemm is. The cost of a tile size is the multiply-adds of its
+// batched gemm, which pads the output up to whole tiles, plus the transform
+// traffic weighted as a few multiply-adds per transformed element.
+int winograd_tile_size(const MLXConvParams<2>& conv_params, Dtype dtype) {
+  constexpr double transform_cost = 8.0;
+  int r = conv_params.wS[0];
+  auto cost = [&](int m) {
+    int a = m + r - 1;
+    double tiles = double(conv_params.N) *
+        ((conv_params.oS[0] + m - 1) / m) * ((conv_params.oS[1] + m - 1) / m);
+    double gemm = double(conv_params.C) * conv_params.O;
+    return a * a * tiles *
+        (gemm + transform_cost * (conv_params.C + conv_params.O));
+  };
+
+  // F(6x6, 3x3) loses too much accuracy in bfloat16
+  std::vector<int> tile_sizes;
+  if (r == 3) {
+    tile_sizes = {4};
+    if (dtype != bfloat16) {
+      tile_sizes.push_back(6);
+    }
+  } else if (r == 5) {
+    tile_sizes = {2};
+  }
+
+  double best_cost = double(conv_params.N) * conv_params.oS[0] *
+      conv_params.oS[1] * r * r * conv_params.C * conv_params.O;
+  int best = 0;
+  for (int m : tile_sizes) {
+    double c = cost(m);
+    if (c < best_cost) {
+      best_cost = c;
+      best = m;
+    }
+  }
+  return best;
+}
+
+void dispatch_conv_2D_gpu(
     const Stream& s,
     metal::Device& d,
     const array& in,
     const array& wt,
     array out,
-    const std::vector<int>& padding,
-    const std::vector<int>& wt_strides,
-    const std::vector<int>& wt_dilation,
-    const std::vector<int>& in_dilation,
-    const int groups,
-    bool flip,
-    std::vector<array>& copies) {
-  // Make conv params
-  MLXConvParams<2> conv_params{
-      /* const int  N = */ in.shape(0),
-      /* const int  C = */ in.shape(3),
-      /* const int  O = */ wt.shape(0),
-      /* const int iS[NDIM] = */ {in.shape(1), in.shape(2)},
-      /* const int wS[NDIM] = */ {wt.shape(1), wt.shape(2)},
-      /* const int oS[NDIM] = */ {out.shape(1), out.shape(2)},
-      /* const int str[NDIM] = */ {wt_strides[0], wt_strides[1]},
-      /* const int pad[NDIM] = */ {padding[0], padding[1]},
-      /* const int kdil[NDIM] = */ {wt_dilation[0], wt_dilation[1]},
-      /* const int idil[NDIM] = */ {in_dilation[0], in_dilation[1]},
-      /* const size_t in_strides[NDIM + 2] = */
-      {in.strides(0), in.strides(1), in.strides(2), in.strides(3)},
-      /* const size_t wt_strides[NDIM + 2] = */
-      {wt.strides(0), wt.strides(1), wt.strides(2), wt.strides(3)},
-      /* const size_t out_strides[NDIM + 2] = */
-      {out.strides(0), out.strides(1), out.strides(2), out.strides(3)},
-      /* const int groups = */ groups,
-      /* const bool flip = */ flip,
-  };
+    const MLXConvParams<2>& conv_params,
+    std::vector<array>& copies,
+    const ConvEpilogue& epilogue) {
+  const int groups = conv_params.groups;
+  const bool flip = conv_params.flip;
 
   bool is_stride_one = conv_params.str[0] == 1 && conv_params.str[1] == 1;
   bool is_kdil_one = conv_params.kdil[0] == 1 && conv_params.kdil[1] == 1;
@@ -756,38 +834,136 @@ void conv_2D_gpu(
     const int C_per_group = conv_params.C / groups;
     const int O_per_group = conv_params.O / groups;
 
+    // Direct to depthwise conv
+    if (is_idil_one && C_per_group == 1 && O_per_group == 1) {
+      return depthwise_conv_2D_gpu(s, d, in, wt, out, conv_params, epilogue);
+    }
+
     if (is_idil_one && (C_per_group <= 4 || C_per_group % 16 == 0) &&
         (O_per_group <= 16 || O_per_group % 16 == 0)) {
-      return implicit_gemm_conv_2D_gpu(s, d, in, wt, out, conv_params);
+      return implicit_gemm_conv_2D_gpu(
+          s, d, in, wt, out, conv_params, epilogue);
     } else {
-      return explicit_gemm_conv_group_ND_gpu(s, d, in, wt, out, conv_params);
+      explicit_gemm_conv_group_ND_gpu(s, d, in, wt, out, conv_params);
+      return conv_epilogue_gpu(s, d, out, epilogue);
     }
   }
 
   // Direct to winograd conv
   if (!flip && is_stride_one && is_kdil_one && is_idil_one &&
-      conv_params.wS[0] == 3 && conv_params.wS[1] == 3 &&
+      conv_params.wS[0] == conv_params.wS[1] &&
+      (conv_params.wS[0] == 3 || conv_params.wS[0] == 5) &&
       conv_params.C % 32 == 0 && conv_params.O % 32 == 0 &&
       (channels_large || (channels_med && inp_large))) {
-    return winograd_conv_2D_gpu(s, d, in, wt, out, conv_params, copies);
+    int m = winograd_tile_size(conv_params, out.dtype());
+    if (m > 0) {
+      return winograd_conv_2D_gpu(
+          s, d, in, wt, out, conv_params, copies, epilogue, m);
+    }
   }
 
   // Direct to implicit gemm conv
   if (is_idil_one && (conv_params.C <= 4 || conv_params.C % 16 == 0) &&
       (conv_params.O <= 16 || conv_params.O % 16 == 0)) {
-    return implicit_gemm_conv_2D_gpu(s, d, in, wt, out, conv_params);
+    return implicit_gemm_conv_2D_gpu(s, d, in, wt, out, conv_params, epilogue);
   }
 
-  else if (conv_params.C % 16 == 0 && conv_params.O % 16 == 0) {
-    return implicit_gemm_conv_2D_general_gpu(s, d, in, wt, out, conv_params);
+  // The general implicit gemm conv only visits the filter taps that land on
+  // input pixels so it also runs transposed convs (input dilation) directly
+  else if (
+      (conv_params.C % 16 == 0 && conv_params.O % 16 == 0) || !is_idil_one) {
+    return implicit_gemm_conv_2D_general_gpu(
+        s, d, in, wt, out, conv_params, epilogue);
   }
 
   // Direct to explicit gemm conv
   else {
-    return explicit_gemm_conv_ND_gpu(s, d, in, wt, out, conv_params);
+    explicit_gemm_conv_ND_gpu(s, d, in, wt, out, conv_params);
+    return conv_epilogue_gpu(s, d, out, epilogue);
   }
 }
 
+void conv_1D_gpu(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    const array& wt,
+    array out,
+    const std::vector<int>& padding,
+    const std::vector<int>& wt_strides,
+    const std::vector<int>& wt_dilation,
+    const std::vector<int>& in_dilation,
+    int groups,
+    bool flip,
+    std::vector<array>& copies,
+    const ConvEpilogue& epilogue) {
+  // Run the 1D conv as a 2D conv with a unit height so that it goes through
+  // the implicit gemm kernels instead of unfolding the input
+  MLXConvParams<2> conv_params{
+      /* const int  N = */ in.shape(0),
+      /* const int  C = */ in.shape(2),
+      /* const int  O = */ wt.shape(0),
+      /* const int iS[NDIM] = */ {1, in.shape(1)},
+      /* const int wS[NDIM] = */ {1, wt.shape(1)},
+      /* const int oS[NDIM] = */ {1, out.shape(1)},
+      /* const int str[NDIM] = */ {1, wt_strides[0]},
+      /* const int pad[NDIM] = */ {0, padding[0]},
+      /* const int kdil[NDIM] = */ {1, wt_dilation[0]},
+      /* const int idil[NDIM] = */ {1, in_dilation[0]},
+      /* const size_t in_strides[NDIM + 2] = */
+      {in.strides(0), in.strides(0), in.strides(1), in.strides(2)},
+      /* const size_t wt_strides[NDIM + 2] = */
+      {wt.strides(0), wt.strides(0), wt.strides(1), wt.strides(2)},
+      /* const size_t out_strides[NDIM + 2] = */
+      {out.strides(0), out.strides(0), out.strides(1), out.strides(2)},
+      /* const int groups = */ groups,
+      /* const bool flip = */ flip,
+  };
+
+  return dispatch_conv_2D_gpu(
+      s, d, in, wt, out, conv_params, copies, epilogue);
+}
+
+void conv_2D_gpu(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    const array& wt,
+    array out,
+    const std::vector<int>& padding,
+    const std::vector<int>& wt_strides,
+    const std::vector<int>& wt_dilation,
+    const std::vector<int>& in_dilation,
+    const int groups,
+    bool flip,
+    std::vector<array>& copies,
+    const ConvEpilogue& epilogue) {
+  // Make conv params
+  MLXConvParams<2> conv_params{
+      /* const int  N = */ in.shape(0),
+      /* const int  C = */ in.shape(3),
+      /* const int  O = */ wt.shape(0),
+      /* const int iS[NDIM] = */ {in.shape(1), in.shape(2)},
+      /* const int wS[NDIM] = */ {wt.shape(1), wt.shape(2)},
+      /* const int oS[NDIM] = */ {out.shape(1), out.shape(2)},
+      /* const int str[NDIM] = */ {wt_strides[0], wt_strides[1]},
+      /* const int pad[NDIM] = */ {padding[0], padding[1]},
+      /* const int kdil[NDIM] = */ {wt_dilation[0], wt_dilation[1]},
+      /* const int idil[NDIM] = */ {in_dilation[0], in_dilation[1]},
+      /* const size_t in_strides[NDIM + 2] = */
+      {in.strides(0), in.strides(1), in.strides(2), in.strides(3)},
+      /* const size_t wt_strides[NDIM + 2] = */
+      {wt.strides(0), wt.strides(1), wt.strides(2), wt.strides(3)},
+      /* const size_t out_strides[NDIM + 2] = */
+      {out.strides(0), out.strides(1), out.strides(2), out.strides(3)},
+      /* const int groups = */ groups,
+      /* const bool flip = */ flip,
+  };
+
+  return dispatch_conv_2D_gpu(
+      s, d, in, wt, out, conv_params, copies, epilogue);
+}
+
 void conv_3D_gpu(
     const Stream& s,
     metal::Device& d,
@@ -799,7 +975,8 @@ void conv_3D_gpu(
     const std::vector<int>& wt_dilation,
     const std::vector<int>& in_dilation,
     bool flip,
-    std::vector<array>& copies) {
+    std::vector<array>& copies,
+    const ConvEpilogue& epilogue) {
   // Make conv params
   MLXConvParams<3> conv_params{
       /* const int  N = */ in.shape(0),
@@ -835,12 +1012,238 @@ void conv_3D_gpu(
       /* const int groups = */ 1,
       /* const bool flip = */ flip,
   };
-  return explicit_gemm_conv_ND_gpu(s, d, in, wt, out, conv_params);
+
+  // A filter with unit depth that neither strides nor pads over depth maps
+  // every input slice to one output slice, so fold depth into the batch and
+  // use the 2D implicit gemm kernels
+  if (conv_params.wS[0] == 1 && conv_params.str[0] == 1 &&
+      conv_params.pad[0] == 0 && conv_params.idil[0] == 1) {
+    MLXConvParams<2> conv_params_2d{
+        /* const int  N = */ conv_params.N * conv_params.iS[0],
+        /* const int  C = */ conv_params.C,
+        /* const int  O = */ conv_params.O,
+        /* const int iS[NDIM] = */ {conv_params.iS[1], conv_params.iS[2]},
+        /* const int wS[NDIM] = */ {conv_params.wS[1], conv_params.wS[2]},
+        /* const int oS[NDIM] = */ {conv_params.oS[1], conv_params.oS[2]},
+        /* const int str[NDIM] = */ {conv_params.str[1], conv_params.str[2]},
+        /* const int pad[NDIM] = */ {conv_params.pad[1], conv_params.pad[2]},
+        /* const int kdil[NDIM] = */
+        {conv_params.kdil[1], conv_params.kdil[2]},
+        /* const int idil[NDIM] = */
+        {conv_params.idil[1], conv_params.idil[2]},
+        /* const size_t in_strides[NDIM + 2] = */
+        {in.strides(1), in.strides(2), in.strides(3), in.strides(4)},
+        /* const size_t wt_strides[NDIM + 2] = */
+        {wt.strides(0), wt.strides(2), wt.strides(3), wt.strides(4)},
+        /* const size_t out_strides[NDIM + 2] = */
+        {out.strides(1), out.strides(2), out.strides(3), out.strides(4)},
+        /* const int groups = */ 1,
+        /* const bool flip = */ flip,
+    };
+    return dispatch_conv_2D_gpu(
+        s, d, in, wt, out, conv_params_2d, copies, epilogue);
+  }
+
+  explicit_gemm_conv_ND_gpu(s, d, in, wt, out, conv_params);
+  conv_epilogue_gpu(s, d, out, epilogue);
+}
+
+template <int N>
+void implicit_gemm_conv_wgrad_gpu(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    const array& cotan,
+    array& out,
+    const MLXConvParams<N>& conv_params,
+    std::vector<array>& copies) {
+  // Deduce implicit gemm size
+  int implicit_M = conv_params.O;
+  int implicit_N = out.size() / conv_params.O;
+  int implicit_K = cotan.size() / conv_params.O;
+
+  // Determine block and warp tiles
+  int bm = (implicit_M >= 64 && implicit_N >= 64) ? 64 : 32;
+  int bn = bm;
+  int bk = 16;
+  int wm = 2, wn = 2;
+
+  int tm = (implicit_M + bm - 1) / bm;
+  int tn = (implicit_N + bn - 1) / bn;
+
+  // The gradient has few tiles compared to the reduction over the batch and
+  // output positions, so split the reduction until the device is full
+  // keeping at least min_k_iterations blocks per partition
+  constexpr int min_k_iterations = 16;
+  constexpr int max_partitions = 32;
+  int k_iterations = (implicit_K + bk - 1) / bk;
+  int target = steel_gemm_target_threadgroups(d);
+  int partitions = (target + tm * tn - 1) / (tm * tn);
+  partitions = std::min(partitions, max_partitions);
+  partitions = std::min(partitions, k_iterations / min_k_iterations);
+  partitions = std::max(partitions, 1);
+  int partition_size = bk * ((k_iterations + partitions - 1) / partitions);
+  partitions = (implicit_K + partition_size - 1) / partition_size;
+
+  array C_split({partitions, implicit_M, implicit_N}, float32, nullptr, {});
+  C_split.set_data(allocator::malloc_or_wait(C_split.nbytes()));
+  copies.push_back(C_split);
+
+  ImplicitGemmConvWeightGradParams gemm_params{
+      /* const int M = */ implicit_M,
+      /* const int N = */ implicit_N,
+      /* const int K = */ implicit_K,
+      /* const int tiles_n = */ tn,
+      /* const int tiles_m = */ tm,
+      /* const int split_k_partitions = */ partitions,
+      /* const int split_k_partition_size = */ partition_size};
+
+  // Determine kernel
+  std::ostringstream kname;
+  kname << "implicit_gemm_conv_wgrad_" << N << "d_" << type_to_name(in)
+        << "_bm" << bm << "_bn" << bn << "_bk" << bk << "_wm" << wm << "_wn"
+        << wn;
+
+  // Encode and dispatch kernel
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel = get_steel_conv_wgrad_kernel(
+      d, kname.str(), in, N, bm, bn, bk, wm, wn);
+  compute_encoder->setComputePipelineState(kernel);
+
+  compute_encoder.set_input_array(cotan, 0);
+  compute_encoder.set_input_array(in, 1);
+  compute_encoder.set_output_array(C_split, 2);
+
+  compute_encoder->setBytes(&conv_params, sizeof(MLXConvParams<N>), 3);
+  compute_encoder->setBytes(
+      &gemm_params, sizeof(ImplicitGemmConvWeightGradParams), 4);
+
+  MTL::Size group_dims = MTL::Size(32, wn, wm);
+  MTL::Size grid_dims = MTL::Size(tn, tm, partitions);
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+
+  // Sum the partial gradients
+  auto accum_name =
+      "steel_gemm_splitk_accum_" + type_to_name(out) + "_float32";
+  auto accum_kernel = get_steel_gemm_splitk_accum_kernel(
+      d, accum_name, C_split, out, false);
+  compute_encoder->setComputePipelineState(accum_kernel);
+
+  int partition_stride = implicit_M * implicit_N;
+  compute_encoder.set_input_array(C_split, 0);
+  compute_encoder.set_output_array(out, 1);
+  compute_encoder->setBytes(&partitions, sizeof(int), 2);
+  compute_encoder->setBytes(&partition_stride, sizeof(int), 3);
+  compute_encoder->setBytes(&implicit_N, sizeof(int), 4);
+
+  MTL::Size accum_grid_dims = MTL::Size(implicit_N, implicit_M, 1);
+  MTL::Size accum_group_dims =
+      MTL::Size(std::min(1024, implicit_N * implicit_M), 1, 1);
+  compute_encoder.dispatchThreads(accum_grid_dims, accum_group_dims);
+}
+
+void conv_wgrad_2D_gpu(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    const array& cotan,
+    array& out,
+    const std::vector<int>& padding,
+    const std::vector<int>& wt_strides,
+    const std::vector<int>& wt_dilation,
+    std::vector<array>& copies) {
+  // 1D convs are 2D convs with a unit height
+  bool is_1d = in.ndim() == 3;
+  int h = is_1d ? 0 : 1;
+  int w = h + 1;
+  MLXConvParams<2> conv_params{
+      /* const int  N = */ in.shape(0),
+      /* const int  C = */ in.shape(-1),
+      /* const int  O = */ out.shape(0),
+      /* const int iS[NDIM] = */ {is_1d ? 1 : in.shape(h), in.shape(w)},
+      /* const int wS[NDIM] = */ {is_1d ? 1 : out.shape(h), out.shape(w)},
+      /* const int oS[NDIM] = */ {is_1d ? 1 : cotan.shape(h), cotan.shape(w)},
+      /* const int str[NDIM] = */
+      {is_1d ? 1 : wt_strides[0], wt_strides[w - 1]},
+      /* const int pad[NDIM] = */ {is_1d ? 0 : padding[0], padding[w - 1]},
+      /* const int kdil[NDIM] = */
+      {is_1d ? 1 : wt_dilation[0], wt_dilation[w - 1]},
+      /* const int idil[NDIM] = */ {1, 1},
+      /* const size_t in_strides[NDIM + 2] = */
+      {in.strides(0), in.strides(h), in.strides(w), in.strides(w + 1)},
+      /* const size_t wt_strides[NDIM + 2] = */
+      {out.strides(0), out.strides(h), out.strides(w), out.strides(w + 1)},
+      /* const size_t out_strides[NDIM + 2] = */
+      {cotan.strides(0),
+       cotan.strides(h),
+       cotan.strides(w),
+       cotan.strides(w + 1)},
+      /* const int groups = */ 1,
+      /* const bool flip = */ false,
+  };
+
+  implicit_gemm_conv_wgrad_gpu(s, d, in, cotan, out, conv_params, copies);
+}
+
+void conv_wgrad_3D_gpu(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    const array& cotan,
+    array& out,
+    const std::vector<int>& padding,
+    const std::vector<int>& wt_strides,
+    const std::vector<int>& wt_dilation,
+    std::vector<array>& copies) {
+  MLXConvParams<3> conv_params{
+      /* const int  N = */ in.shape(0),
+      /* const int  C = */ in.shape(4),
+      /* const int  O = */ out.shape(0),
+      /* const int iS[NDIM] = */ {in.shape(1), in.shape(2), in.shape(3)},
+      /* const int wS[NDIM] = */ {out.shape(1), out.shape(2), out.shape(3)},
+      /* const int oS[NDIM] = */
+      {cotan.shape(1), cotan.shape(2), cotan.shape(3)},
+      /* const int str[NDIM] = */ {wt_strides[0], wt_strides[1], wt_strides[2]},
+      /* const int pad[NDIM] = */ {padding[0], padding[1], padding[2]},
+      /* const int kdil[NDIM] = */
+      {wt_dilation[0], wt_dilation[1], wt_dilation[2]},
+      /* const int idil[NDIM] = */ {1, 1, 1},
+      /* const size_t in_strides[NDIM + 2] = */
+      {in.strides(0),
+       in.strides(1),
+       in.strides(2),
+       in.strides(3),
+       in.strides(4)},
+      /* const size_t wt_strides[NDIM + 2] = */
+      {out.strides(0),
+       out.strides(1),
+       out.strides(2),
+       out.strides(3),
+       out.strides(4)},
+      /* const size_t out_strides[NDIM + 2] = */
+      {cotan.strides(0),
+       cotan.strides(1),
+       cotan.strides(2),
+       cotan.strides(3),
+       cotan.strides(4)},
+      /* const int groups = */ 1,
+      /* const bool flip = */ false,
+  };
+
+  implicit_gemm_conv_wgrad_gpu(s, d, in, cotan, out, conv_params, copies);
 }
 
 } // namespace
 
 void Convolution::eval_gpu(const std::vector<array>& inputs, array& out) {
+  eval_gpu(inputs, out, std::nullopt, 0);
+}
+
+void Convolution::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out,
+    const std::optional<array>& bias,
+    int activation) {
   out.set_data(allocator::malloc_or_wait(out.nbytes()));
   auto& s = stream();
   auto& d = metal::device(s.device);
@@ -856,10 +1259,19 @@ void Convolution::eval_gpu(const std::vector<array>& inputs, array& out) {
     in = arr_copy;
   }
   if (!wt.flags().row_contiguous) {
-    array arr_copy(wt.shape(), wt.dtype(), nullptr, {});
-    copy_gpu(wt, arr_copy, CopyType::General, s);
+    wt = prepack_cache().get(wt, "row_contiguous", s, [&]() {
+      array arr_copy(wt.shape(), wt.dtype(), nullptr, {});
+      copy_gpu(wt, arr_copy, CopyType::General, s);
+      return arr_copy;
+    });
+    copies.push_back(wt);
+  }
+  ConvEpilogue epilogue{bias, activation};
+  if (bias && !bias->flags().row_contiguous) {
+    array arr_copy(bias->shape(), bias->dtype(), nullptr, {});
+    copy_gpu(*bias, arr_copy, CopyType::General, s);
     copies.push_back(arr_copy);
-    wt = arr_copy;
+    epilogue.bias = arr_copy;
   }
 
   // 3D conv
@@ -875,7 +1287,8 @@ void Convolution::eval_gpu(const std::vector<array>& inputs, array& out) {
         kernel_dilation_,
         input_dilation_,
         flip_,
-        copies);
+        copies,
+        epilogue);
   }
   // 2D conv
   else if (out.ndim() == 4) {
@@ -891,7 +1304,8 @@ void Convolution::eval_gpu(const std::vector<array>& inputs, array& out) {
         input_dilation_,
         groups_,
         flip_,
-        copies);
+        copies,
+        epilogue);
   }
   // 1D conv
   else if (out.ndim() == 3) {
@@ -906,12 +1320,14 @@ void Convolution::eval_gpu(const std::vector<array>& inputs, array& out) {
         kernel_dilation_,
         input_dilation_,
         groups_,
-        flip_);
+        flip_,
+        copies,
+        epilogue);
   }
   // Throw error
   else {
     throw std::invalid_argument(
-        "[Convolution::eval_gpu] Only supports 1D or 2D convolutions.");
+        "[Convolution::eval_gpu] Only supports 1D, 2D or 3D convolutions.");
   }
 
   // Clear copies
@@ -922,4 +1338,78 @@ void Convolution::eval_gpu(const std::vector<array>& inputs, array& out) {
   }
 }
 
+void fast::ConvolutionWeightGrad::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  // Return 0s if there is nothing to reduce
+  if (inputs[0].size() == 0 || inputs[1].size() == 0) {
+    array zero = array(0, out.dtype());
+    copy_gpu(zero, out, CopyType::Scalar, s);
+    auto command_buffer = d.get_command_buffer(s.index);
+    command_buffer->addCompletedHandler([zero](MTL::CommandBuffer*) {});
+    return;
+  }
+
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  // Ensure contiguity
+  std::vector<array> copies;
+  auto in = inputs[0];
+  auto cotan = inputs[1];
+  if (!in.flags().row_contiguous) {
+    array arr_copy(in.shape(), in.dtype(), nullptr, {});
+    copy_gpu(in, arr_copy, CopyType::General, s);
+    copies.push_back(arr_copy);
+    in = arr_copy;
+  }
+  if (!cotan.flags().row_contiguous) {
+    array arr_copy(cotan.shape(), cotan.dtype(), nullptr, {});
+    copy_gpu(cotan, arr_copy, CopyType::General, s);
+    copies.push_back(arr_copy);
+    cotan = arr_copy;
+  }
+
+  if (out.ndim() == 5) {
+    conv_wgrad_3D_gpu(
+        s,
+        d,
+        in,
+        cotan,
+        out,
+        padding_,
+        kernel_strides_,
+        kernel_dilation_,
+        copies);
+  } else {
+    conv_wgrad_2D_gpu(
+        s,
+        d,
+        in,
+        cotan,
+        out,
+        padding_,
+        kernel_strides_,
+        kernel_dilation_,
+        copies);
+  }
+
+  auto command_buffer = d.get_command_buffer(s.index);
+  command_buffer->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void fast::ConvolutionEpilogue::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  auto& conv = static_cast<Convolution&>(*conv_);
+  std::optional<array> bias;
+  if (has_bias_) {
+    bias = inputs[2];
+  }
+  conv.eval_gpu({inputs[0], inputs[1]}, out, bias, activation_);
+}
+
 } // namespace mlx::core
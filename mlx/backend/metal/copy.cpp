@@ -5,6 +5,8 @@
 #include "mlx/backend/metal/copy.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/profiler.h"
 #include "mlx/backend/metal/utils.h"
 #include "mlx/primitives.h"
 
@@ -12,6 +14,44 @@ namespace mlx::core {
 
 constexpr int MAX_COPY_SPECIALIZED_DIMS = 5;
 
+// Smaller copies are not worth the synchronization with the copy queue
+constexpr size_t MIN_COPY_QUEUE_BYTES = 1 << 20;
+
+namespace {
+
+// Copies the input on the stream's copy queue, instead of with a kernel
+// after the stream's pending work, if its data does not depend on that work.
+// It is the case for data filled in on the host, e.g. by a Load evaluated on
+// the stream, and for data from other streams which the copy waits for.
+bool try_copy_queue(const array& in, array& out, const Stream& s) {
+  if (in.dtype() != out.dtype() ||
+      in.data_size() * in.itemsize() < MIN_COPY_QUEUE_BYTES ||
+      metal::is_profiling()) {
+    return false;
+  }
+  auto& e = in.event();
+  MTL::Event* wait_event = nullptr;
+  if (!in.has_primitive()) {
+    // Evaluated earlier, the data is ready if its event was signaled
+    if (e.valid() && !e.is_signaled()) {
+      return false;
+    }
+  } else if (e.valid() && e.stream().device == Device::cpu) {
+    // The copy queue can only wait for Metal events
+    if (!e.is_signaled()) {
+      return false;
+    }
+  } else if (e.valid() && e.stream() != s) {
+    wait_event = static_cast<MTL::Event*>(e.raw_event().get());
+  } else if (typeid(in.primitive()) != typeid(Load)) {
+    return false;
+  }
+  metal::device(s.device).copy_async(s.index, in, out, wait_event, e.value());
+  return true;
+}
+
+} // namespace
+
 void copy_gpu(const array& in, array& out, CopyType ctype, const Stream& s) {
   if (ctype == CopyType::Vector) {
     // If the input is donateable, we are doing a vector copy and the types
@@ -29,6 +69,9 @@ void copy_gpu(const array& in, array& out, CopyType ctype, const Stream& s) {
           in.data_size(),
           in.strides(),
           in.flags());
+      if (try_copy_queue(in, out, s)) {
+        return;
+      }
     }
   } else {
     out.set_data(allocator::malloc_or_wait(out.nbytes()));
@@ -86,6 +129,10 @@ void copy_gpu_inplace(
         shape.size() <= MAX_COPY_SPECIALIZED_DIMS) {
       kname << shape.size();
     }
+    if ((ctype == CopyType::General || ctype == CopyType::GeneralGeneral) &&
+        (in.data_size() > INT32_MAX || out.data_size() > INT32_MAX)) {
+      kname << "large";
+    }
     kname << "_copy";
     kname << type_to_name(in) << type_to_name(out);
     kernel_name = kname.str();
@@ -127,6 +174,10 @@ void copy_gpu_inplace(
     for (auto& s : shape)
       data_size *= s;
     int rest = data_size / (dim0 * dim1);
+    if (ndim > 3) {
+      // A thread per ELEMWISE_N_WRITES elements of the inner dim
+      dim0 = (dim0 + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
 
     // NB assuming thread_group_size is a power of 2 larger than 32 x 32
     NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
@@ -0,0 +1,123 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
+
+namespace mlx::core::fast {
+
+namespace {
+
+// Must match cross_entropy_n_reads in the kernels
+constexpr int cross_entropy_n_reads = 4;
+
+} // namespace
+
+void CrossEntropy::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  copies.reserve(inputs.size());
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  const array& logits = check_input(inputs[0]);
+  const array& targets = check_input(inputs[1]);
+  auto& loss = outputs[0];
+  auto& lse = outputs[1];
+  loss.set_data(allocator::malloc_or_wait(loss.nbytes()));
+  lse.set_data(allocator::malloc_or_wait(lse.nbytes()));
+
+  int axis_size = logits.shape(-1);
+  size_t n_rows = loss.size();
+  if (n_rows > 0) {
+    auto kernel = d.get_kernel("cross_entropy_" + type_to_name(logits));
+    size_t simd_size = 32;
+    size_t n_threads = (axis_size + cross_entropy_n_reads - 1) /
+        cross_entropy_n_reads;
+    n_threads = (n_threads + simd_size - 1) / simd_size * simd_size;
+    n_threads =
+        std::min<size_t>(n_threads, kernel->maxTotalThreadsPerThreadgroup());
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(logits, 0);
+    compute_encoder.set_input_array(targets, 1);
+    compute_encoder.set_output_array(loss, 2);
+    compute_encoder.set_output_array(lse, 3);
+    compute_encoder->setBytes(&axis_size, sizeof(int), 4);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(n_rows, 1, 1), MTL::Size(n_threads, 1, 1));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void CrossEntropyVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  copies.reserve(inputs.size());
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  const array& logits = check_input(inputs[0]);
+  const array& targets = check_input(inputs[1]);
+  const array& lse = check_input(inputs[2]);
+  const array& cotan = check_input(inputs[3]);
+  auto& dlogits = outputs[0];
+
+  // The gradient may overwrite the logits when they are not needed anymore
+  if (logits.is_donatable()) {
+    dlogits.move_shared_buffer(logits);
+  } else {
+    dlogits.set_data(allocator::malloc_or_wait(dlogits.nbytes()));
+  }
+
+  int axis_size = logits.shape(-1);
+  size_t n_rows = lse.size();
+  if (n_rows > 0 && axis_size > 0) {
+    auto kernel = d.get_kernel("cross_entropy_vjp_" + type_to_name(logits));
+    size_t n_cols =
+        (axis_size + cross_entropy_n_reads - 1) / cross_entropy_n_reads;
+    size_t group_cols =
+        std::min<size_t>(n_cols, kernel->maxTotalThreadsPerThreadgroup());
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(
+        logits.data_shared_ptr() == nullptr ? dlogits : logits, 0);
+    compute_encoder.set_input_array(targets, 1);
+    compute_encoder.set_input_array(lse, 2);
+    compute_encoder.set_input_array(cotan, 3);
+    compute_encoder.set_output_array(dlogits, 4);
+    compute_encoder->setBytes(&axis_size, sizeof(int), 5);
+    compute_encoder.dispatchThreads(
+        MTL::Size(n_cols, n_rows, 1), MTL::Size(group_cols, 1, 1));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace mlx::core::fast
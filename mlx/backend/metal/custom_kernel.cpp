@@ -0,0 +1,90 @@
+// Copyright © 2024 Apple Inc.
+
+#include <sstream>
+
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/jit/includes.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
+
+namespace mlx::core::fast {
+
+void CustomKernel::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+
+  std::vector<array> copies;
+  for (auto& out : outputs) {
+    if (init_value_) {
+      copies.emplace_back(init_value_.value(), out.dtype());
+      copy_gpu(copies.back(), out, CopyType::Scalar, s);
+    } else {
+      out.set_data(allocator::malloc_or_wait(out.nbytes()));
+    }
+  }
+
+  std::vector<array> checked_inputs;
+  for (auto& in : inputs) {
+    if (!ensure_row_contiguous_ || in.flags().row_contiguous) {
+      checked_inputs.push_back(in);
+    } else {
+      copies.emplace_back(
+          in.shape(), in.dtype(), nullptr, std::vector<array>{});
+      copy_gpu(in, copies.back(), CopyType::General, s);
+      checked_inputs.push_back(copies.back());
+    }
+  }
+
+  auto& d = metal::device(s.device);
+  auto lib = d.get_library(lib_name_);
+  if (lib == nullptr) {
+    lib = d.get_library(lib_name_, metal::utils() + source_);
+  }
+  auto kernel = d.get_kernel(name_, lib, lib_name_);
+
+  auto [tx, ty, tz] = threadgroup_;
+  if (tx * ty * tz > kernel->maxTotalThreadsPerThreadgroup()) {
+    std::ostringstream msg;
+    msg << "[metal_kernel] The threadgroup size " << tx * ty * tz
+        << " is larger than the maximum of " << name_ << " which is "
+        << kernel->maxTotalThreadsPerThreadgroup() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  int index = 0;
+  for (int i = 0; i < checked_inputs.size(); i++) {
+    auto& in = checked_inputs[i];
+    compute_encoder.set_input_array(in, index++);
+    if (in.ndim() > 0) {
+      auto [shape, strides, ndim] = shape_infos_[i];
+      if (shape) {
+        set_vector_bytes(compute_encoder, in.shape(), index++);
+      }
+      if (strides) {
+        set_vector_bytes(compute_encoder, in.strides(), index++);
+      }
+      if (ndim) {
+        int n = in.ndim();
+        compute_encoder->setBytes(&n, sizeof(int), index++);
+      }
+    }
+  }
+  for (auto& out : outputs) {
+    compute_encoder.set_output_array(out, index++);
+  }
+
+  auto [gx, gy, gz] = grid_;
+  compute_encoder.dispatchThreads(MTL::Size(gx, gy, gz), MTL::Size(tx, ty, tz));
+
+  if (!copies.empty()) {
+    d.get_command_buffer(s.index)->addCompletedHandler(
+        [copies = std::move(copies)](MTL::CommandBuffer*) mutable {
+          copies.clear();
+        });
+  }
+}
+
+} // namespace mlx::core::fast
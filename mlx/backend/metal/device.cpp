@@ -1,16 +1,20 @@
 // Copyright © 2023-2024 Apple Inc.
 
 #include <dlfcn.h>
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <sstream>
 
 #include <sys/sysctl.h>
+#include <unistd.h>
 
 #define NS_PRIVATE_IMPLEMENTATION
 #define CA_PRIVATE_IMPLEMENTATION
 #define MTL_PRIVATE_IMPLEMENTATION
 
+#include "mlx/backend/metal/capture.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/metal.h"
 #include "mlx/backend/metal/metal_impl.h"
@@ -25,8 +29,6 @@ namespace {
 
 // TODO nicer way to set this or possibly expose as an environment variable
 constexpr int MAX_BUFFERS_PER_QUEUE = 12;
-constexpr int MAX_DISPATCHES_PER_ENCODER = 2;
-
 constexpr const char* default_mtllib_path = METAL_PATH;
 
 constexpr auto get_metal_version() {
@@ -124,46 +126,228 @@ MTL::Library* load_library(
   }
 }
 
+
+// The bytes of the buffer of a that a kernel may access, starting offset
+// bytes after its data pointer
+std::pair<int64_t, int64_t> buffer_range(const array& a, int64_t offset) {
+  auto buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
+  int64_t begin = a.data<char>() -
+      static_cast<char*>(const_cast<MTL::Buffer*>(buf)->contents());
+  int64_t extent = a.size() > 0;
+  for (int i = 0; extent > 0 && i < a.ndim(); i++) {
+    extent += (a.shape(i) - 1) * static_cast<int64_t>(a.strides()[i]);
+  }
+  extent = std::max<int64_t>(extent, a.data_size()) * a.itemsize();
+  begin += std::min<int64_t>(offset, 0);
+  return {begin, begin + extent + std::abs(offset)};
+}
+
+bool overlaps(
+    const CommandEncoder::Ranges& ranges,
+    const std::pair<int64_t, int64_t>& range) {
+  for (auto& [b, e] : ranges) {
+    if (b < range.second && range.first < e) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Writes the source of a library compiled at run time to the directory in
+// MLX_METAL_JIT_DUMP, if set, to be precompiled by a later build with
+// MLX_METAL_JIT_PRECOMPILE. The first line names the library.
+void dump_jit_source(const std::string& name, const std::string& source) {
+  static const char* dir = std::getenv("MLX_METAL_JIT_DUMP");
+  if (dir == nullptr || dir[0] == '\0') {
+    return;
+  }
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  auto file = std::to_string(std::hash<std::string>{}(name)) + ".metal";
+  std::ofstream os(fs::path(dir) / file);
+  os << "// mlx_jit_library: " << name << "\n" << source;
+}
+
 } // namespace
 
+// The on-disk caches, e.g. the binary archive of compiled pipelines, are
+// kept one per GPU and OS build and shared by all processes.
+// MLX_METAL_KERNEL_CACHE overrides the default directory and setting it to
+// an empty string disables the caches.
+std::string cache_file_path(MTL::Device* device, const std::string& ext) {
+  fs::path dir;
+  if (const char* buff_str = std::getenv("MLX_METAL_KERNEL_CACHE")) {
+    if (buff_str[0] == '\0') {
+      return "";
+    }
+    dir = buff_str;
+  } else if (const char* buff_str = std::getenv("XDG_CACHE_HOME")) {
+    dir = fs::path(buff_str) / "mlx" / "metal_kernels";
+  } else if (const char* buff_str = std::getenv("HOME")) {
+    dir = fs::path(buff_str) / ".cache" / "mlx" / "metal_kernels";
+  } else {
+    return "";
+  }
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec) {
+    return "";
+  }
+
+  char os_version[64] = {0};
+  size_t size = sizeof(os_version) - 1;
+  sysctlbyname("kern.osversion", os_version, &size, nullptr, 0);
+  std::string name = device->name()->utf8String();
+  name += std::string("-") + os_version + ext;
+  std::replace(name.begin(), name.end(), ' ', '_');
+  return dir / name;
+}
+
+void CommandEncoder::maybe_barrier(
+    MTL::Resource* r,
+    const std::pair<int64_t, int64_t>& range,
+    bool is_output) {
+  bool hazard = false;
+  if (auto it = outputs.find(r); it != outputs.end()) {
+    hazard = overlaps(it->second, range);
+  }
+  if (!hazard && is_output) {
+    if (auto it = inputs.find(r); it != inputs.end()) {
+      hazard = overlaps(it->second, range);
+    }
+  }
+  if (hazard) {
+    enc->memoryBarrier(&r, 1);
+    outputs.erase(r);
+    inputs.erase(r);
+  }
+}
+
+void CommandEncoder::setComputePipelineState(
+    MTL::ComputePipelineState* kernel) {
+  if (recorder) {
+    recorder->set_pipeline(kernel);
+  }
+  enc->setComputePipelineState(kernel);
+}
+
+void CommandEncoder::setBytes(
+    const void* bytes,
+    NS::UInteger length,
+    NS::UInteger index) {
+  if (recorder) {
+    recorder->set_bytes(bytes, length, index);
+  }
+  enc->setBytes(bytes, length, index);
+}
+
+void CommandEncoder::setThreadgroupMemoryLength(
+    NS::UInteger length,
+    NS::UInteger index) {
+  if (recorder) {
+    recorder->set_threadgroup_memory(length, index);
+  }
+  enc->setThreadgroupMemoryLength(length, index);
+}
+
+void CommandEncoder::memoryBarrier(
+    const MTL::Resource* const resources[],
+    NS::UInteger count) {
+  // Not recorded, replays insert the same barriers from the buffer ranges
+  enc->memoryBarrier(resources, count);
+}
+
+void CommandEncoder::set_buffer(
+    const MTL::Buffer* buf,
+    int64_t offset,
+    int idx,
+    const std::pair<int64_t, int64_t>& range,
+    bool is_output) {
+  auto r_buf = static_cast<MTL::Resource*>(const_cast<MTL::Buffer*>(buf));
+  maybe_barrier(r_buf, range, is_output);
+  auto& next = is_output ? next_outputs : next_inputs;
+  next.emplace_back(r_buf, range.first, range.second);
+  enc->setBuffer(buf, offset, idx);
+}
+
+void CommandEncoder::set_input_array(const array& a, int idx, int64_t offset) {
+  auto a_buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
+  auto base_offset = a.data<char>() -
+      static_cast<char*>(const_cast<MTL::Buffer*>(a_buf)->contents());
+  auto range = buffer_range(a, offset);
+  if (recorder) {
+    recorder->set_buffer(a, base_offset + offset, idx, range, false);
+  }
+  set_buffer(a_buf, base_offset + offset, idx, range, false);
+}
+
+void CommandEncoder::set_output_array(array& a, int idx, int64_t offset) {
+  auto a_buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
+  auto base_offset = a.data<char>() -
+      static_cast<char*>(const_cast<MTL::Buffer*>(a_buf)->contents());
+  auto range = buffer_range(a, offset);
+  if (recorder) {
+    recorder->set_buffer(a, base_offset + offset, idx, range, true);
+  }
+  set_buffer(a_buf, base_offset + offset, idx, range, true);
+}
+
+void CommandEncoder::record_accesses() {
+  for (auto& [r, b, e] : next_inputs) {
+    inputs[r].emplace_back(b, e);
+  }
+  auto& outs = concurrent ? concurrent_outputs : outputs;
+  for (auto& [r, b, e] : next_outputs) {
+    outs[r].emplace_back(b, e);
+  }
+  next_inputs.clear();
+  next_outputs.clear();
+}
+
 void CommandEncoder::dispatchThreadgroups(
     MTL::Size grid_dims,
     MTL::Size group_dims) {
-  num_dispatches++;
+  if (recorder) {
+    recorder->dispatch(grid_dims, group_dims, false);
+  }
   enc->dispatchThreadgroups(grid_dims, group_dims);
-  maybe_split();
+  record_accesses();
 }
 
 void CommandEncoder::dispatchThreads(
     MTL::Size grid_dims,
     MTL::Size group_dims) {
-  num_dispatches++;
-  enc->dispatchThreads(grid_dims, group_dims);
-  maybe_split();
-}
-
-void CommandEncoder::maybe_split() {
-  if (num_dispatches > MAX_DISPATCHES_PER_ENCODER && !concurrent) {
-    enc->endEncoding();
-    enc->release();
-    num_dispatches = 0;
-    outputs.clear();
-    enc = cbuf->computeCommandEncoder(MTL::DispatchTypeConcurrent);
-    enc->retain();
+  if (recorder) {
+    recorder->dispatch(grid_dims, group_dims, true);
   }
+  enc->dispatchThreads(grid_dims, group_dims);
+  record_accesses();
 }
 
 Device::Device() {
   auto pool = new_scoped_memory_pool();
   device_ = load_device();
-  library_map_ = {{"mlx", load_library(device_)}};
+  auto arch = std::string(device_->architecture()->name()->utf8String());
+  if (!arch.empty()) {
+    arch_class_ = arch.back();
+  }
+  register_kernel_families_();
+  load_binary_archive_();
 }
 
 Device::~Device() {
   auto pool = new_scoped_memory_pool();
+  save_kernel_cache();
+  if (archive_) {
+    archive_->release();
+  }
   for (auto& q : queue_map_) {
     q.second->release();
   }
+  for (auto& [_, cq] : copy_queue_map_) {
+    cq.queue->release();
+    cq.event->release();
+  }
   for (auto& b : buffer_map_) {
     b.second.second->release();
   }
@@ -176,7 +360,7 @@ Device::~Device() {
   device_->release();
 }
 
-void Device::new_queue(int index) {
+void Device::new_queue(int index, StreamPriority priority) {
   auto thread_pool = metal::new_scoped_memory_pool();
 
   // Multiple threads can ask the device for queues
@@ -188,7 +372,29 @@ void Device::new_queue(int index) {
     throw std::runtime_error(
         "[metal::Device] Failed to make new command queue.");
   }
+  if (residency_set_) {
+    q->addResidencySet(residency_set_);
+  }
   queue_map_.insert({index, q});
+  queue_priority_map_.insert({index, priority});
+}
+
+StreamPriority Device::get_queue_priority(int index) {
+  auto it = queue_priority_map_.find(index);
+  return it == queue_priority_map_.end() ? StreamPriority::normal
+                                         : it->second;
+}
+
+void Device::set_residency_set(const MTL::ResidencySet* residency_set) {
+  const std::lock_guard<std::mutex> lock(mtx_);
+  if (residency_set_) {
+    throw std::runtime_error(
+        "[metal::Device] The residency set can only be set once.");
+  }
+  residency_set_ = residency_set;
+  for (auto& [_, q] : queue_map_) {
+    q->addResidencySet(residency_set_);
+  }
 }
 
 int Device::get_command_buffer_ops(int index) {
@@ -232,10 +438,91 @@ void Device::commit_command_buffer(int index) {
   buffer_map_.erase(bit);
 }
 
+void Device::discard_command_buffer(int index) {
+  end_encoding(index);
+  if (auto bit = buffer_map_.find(index); bit != buffer_map_.end()) {
+    bit->second.second->release();
+    buffer_map_.erase(bit);
+  }
+}
+
 void Device::end_encoding(int index) {
+  if (auto eit = encoder_map_.find(index);
+      eit != encoder_map_.end() && eit->second->recorder) {
+    // Work encoded outside of the compute encoder can't be recorded
+    eit->second->recorder->valid = false;
+  }
   encoder_map_.erase(index);
 }
 
+void Device::copy_async(
+    int index,
+    const array& in,
+    array& out,
+    MTL::Event* wait_event,
+    uint64_t wait_value) {
+  auto cit = copy_queue_map_.find(index);
+  if (cit == copy_queue_map_.end()) {
+    const std::lock_guard<std::mutex> lock(mtx_);
+    auto q = device_->newCommandQueue(MAX_BUFFERS_PER_QUEUE);
+    auto e = device_->newSharedEvent();
+    if (!q || !e) {
+      throw std::runtime_error(
+          "[metal::Device] Failed to make new copy queue.");
+    }
+    cit = copy_queue_map_.insert({index, {q, e}}).first;
+  }
+  auto& cq = cit->second;
+
+  auto cb = cq.queue->commandBufferWithUnretainedReferences();
+  if (!cb) {
+    throw std::runtime_error(
+        "[metal::Device] Unable to create new command buffer");
+  }
+  if (wait_event) {
+    cb->encodeWait(wait_event, wait_value);
+  }
+  auto in_buf = static_cast<const MTL::Buffer*>(in.buffer().ptr());
+  auto out_buf = static_cast<MTL::Buffer*>(out.buffer().ptr());
+  auto blit = cb->blitCommandEncoder();
+  blit->copyFromBuffer(
+      in_buf,
+      in.data<char>() - static_cast<char*>(in_buf->contents()),
+      out_buf,
+      out.data<char>() - static_cast<char*>(out_buf->contents()),
+      in.data_size() * in.itemsize());
+  blit->endEncoding();
+  cb->encodeSignalEvent(cq.event, ++cq.value);
+  // Keep the buffers until the copy is done since the command buffer does
+  // not retain them
+  cb->addCompletedHandler(
+      [in_data = in.data_shared_ptr(),
+       out_data = out.data_shared_ptr()](MTL::CommandBuffer*) {});
+  cb->commit();
+
+  end_encoding(index);
+  get_command_buffer(index)->encodeWait(cq.event, cq.value);
+}
+
+CommandEncoder& Device::new_command_encoder(
+    int index,
+    MTL::ComputePassDescriptor* desc) {
+  end_encoding(index);
+  auto cb = get_command_buffer(index);
+  auto eit =
+      encoder_map_.emplace(index, std::make_unique<CommandEncoder>(cb, desc))
+          .first;
+  return *(eit->second);
+}
+
+void Device::set_recorder(int index, CaptureRecorder* recorder) {
+  if (recorder) {
+    get_command_encoder(index).recorder = recorder;
+  } else if (auto eit = encoder_map_.find(index); eit != encoder_map_.end()) {
+    eit->second->recorder = nullptr;
+  }
+}
+
 CommandEncoder& Device::get_command_encoder(int index) {
   auto eit = encoder_map_.find(index);
   if (eit == encoder_map_.end()) {
@@ -249,32 +536,197 @@ CommandEncoder& Device::get_command_encoder(int index) {
 void Device::register_library(
     const std::string& lib_name,
     const std::string& lib_path) {
-  if (auto it = library_map_.find(lib_name); it == library_map_.end()) {
-    auto new_lib = load_library(device_, lib_name, lib_path.c_str());
-    library_map_.insert({lib_name, new_lib});
+  if (library_map_.find(lib_name) == library_map_.end()) {
+    library_paths_.insert({lib_name, lib_path});
   }
 }
 
 void Device::register_library(
     const std::string& lib_name,
     const std::function<std::string(const std::string&)>& lib_path_func) {
-  if (auto it = library_map_.find(lib_name); it == library_map_.end()) {
-    std::string new_lib_path = lib_path_func(lib_name);
-    auto new_lib = load_library(device_, lib_name, new_lib_path.c_str());
-    library_map_.insert({lib_name, new_lib});
+  if (library_map_.find(lib_name) == library_map_.end()) {
+    library_paths_.insert({lib_name, lib_path_func(lib_name)});
+  }
+}
+
+void Device::register_kernel_families_() {
+  // The families are next to this binary or in the directory of the default
+  // metallib, e.g. the build directory
+  std::vector<fs::path> dirs = {
+      fs::path(default_mtllib_path).parent_path(),
+      fs::path(get_colocated_mtllib_path("mlx")).parent_path()};
+  for (auto& dir : dirs) {
+    std::error_code ec;
+    for (auto& entry : fs::directory_iterator(dir, ec)) {
+      auto name = entry.path().stem().string();
+      if (entry.path().extension() == ".metallib" &&
+          name.rfind("mlx_", 0) == 0) {
+        // The colocated library wins since it is registered last
+        library_paths_[name] = entry.path().string();
+        families_.insert(name);
+      }
+    }
+  }
+  if (families_.empty()) {
+    // A single library, e.g. from a Swift package resource bundle
+    library_paths_.insert({"mlx", default_mtllib_path});
+    return;
+  }
+  std::string signature;
+  for (auto& family : families_) {
+    std::error_code ec;
+    auto size = fs::file_size(library_paths_[family], ec);
+    signature += family + ":" + std::to_string(size) + ";";
+  }
+
+  // The family of each kernel from an earlier process, ignored if the
+  // families changed since
+  index_path_ = cache_file_path(device_, ".kernels");
+  std::ifstream is(index_path_);
+  std::string line;
+  if (index_path_.empty() || !std::getline(is, line) || line != signature) {
+    index_signature_ = std::move(signature);
+    index_dirty_ = true;
+    return;
+  }
+  index_signature_ = std::move(signature);
+  std::string kernel, family;
+  while (is >> kernel >> family) {
+    kernel_families_.insert({kernel, family});
+  }
+}
+
+MTL::Library* Device::get_kernel_library_(const std::string& kernel) {
+  if (families_.empty()) {
+    return get_library_cache_("mlx");
+  }
+  std::lock_guard<std::mutex> lk(library_mtx_);
+  if (auto it = kernel_families_.find(kernel); it != kernel_families_.end()) {
+    return get_library_cache_(it->second);
+  }
+
+  // Load the families one at a time until one has the kernel
+  for (auto& family : families_) {
+    if (indexed_families_.find(family) != indexed_families_.end()) {
+      continue;
+    }
+    auto lib = get_library_cache_(family);
+    indexed_families_.insert(family);
+    auto pool = new_scoped_memory_pool();
+    auto names = lib->functionNames();
+    for (NS::UInteger i = 0; i < names->count(); i++) {
+      auto name = static_cast<NS::String*>(names->object(i))->utf8String();
+      if (kernel_families_.insert({name, family}).second) {
+        index_dirty_ = true;
+      }
+    }
+    if (auto it = kernel_families_.find(kernel);
+        it != kernel_families_.end()) {
+      return get_library_cache_(it->second);
+    }
+  }
+  std::ostringstream msg;
+  msg << "[metal::Device] No kernel library has the function " << kernel
+      << ".";
+  throw std::runtime_error(msg.str());
+}
+
+void Device::load_binary_archive_() {
+  archive_path_ = cache_file_path(device_, ".bin");
+  if (archive_path_.empty()) {
+    return;
+  }
+  auto desc = MTL::BinaryArchiveDescriptor::alloc()->init();
+  NS::Error* error = nullptr;
+  if (fs::exists(archive_path_)) {
+    desc->setUrl(NS::URL::fileURLWithPath(
+        NS::String::string(archive_path_.c_str(), NS::UTF8StringEncoding)));
+    archive_ = device_->newBinaryArchive(desc, &error);
+  }
+  if (!archive_) {
+    // Missing or unreadable, start with an empty archive
+    desc->setUrl(nullptr);
+    error = nullptr;
+    archive_ = device_->newBinaryArchive(desc, &error);
+  }
+  desc->release();
+}
+
+void Device::save_kernel_cache() {
+  save_kernel_index_();
+  if (!archive_ || !archive_dirty_) {
+    return;
+  }
+  auto pool = new_scoped_memory_pool();
+
+  // Write to a temporary file and rename it so that processes sharing the
+  // cache never see a partially written archive
+  auto tmp_path = archive_path_ + "." + std::to_string(getpid()) + ".tmp";
+  NS::Error* error = nullptr;
+  std::error_code ec;
+  if (archive_->serializeToURL(
+          NS::URL::fileURLWithPath(
+              NS::String::string(tmp_path.c_str(), NS::UTF8StringEncoding)),
+          &error)) {
+    fs::rename(tmp_path, archive_path_, ec);
+  } else {
+    fs::remove(tmp_path, ec);
   }
+  archive_dirty_ = false;
+}
+
+void Device::save_kernel_index_() {
+  std::lock_guard<std::mutex> lk(library_mtx_);
+  if (index_path_.empty() || !index_dirty_) {
+    return;
+  }
+  auto tmp_path = index_path_ + "." + std::to_string(getpid()) + ".tmp";
+  {
+    std::ofstream os(tmp_path);
+    os << index_signature_ << "\n";
+    for (auto& [kernel, family] : kernel_families_) {
+      os << kernel << " " << family << "\n";
+    }
+  }
+  std::error_code ec;
+  fs::rename(tmp_path, index_path_, ec);
+  index_dirty_ = false;
+}
+
+MTL::ComputePipelineState* Device::new_pipeline_state_(
+    MTL::ComputePipelineDescriptor* desc,
+    NS::Error** error) {
+  if (archive_) {
+    desc->setBinaryArchives(NS::Array::array(archive_));
+    auto kernel = device_->newComputePipelineState(
+        desc, MTL::PipelineOptionFailOnBinaryArchiveMiss, nullptr, error);
+    if (kernel) {
+      return kernel;
+    }
+
+    // Compile the pipeline into the archive, the pipeline state below is
+    // then loaded from it
+    *error = nullptr;
+    if (archive_->addComputePipelineFunctions(desc, error)) {
+      archive_dirty_ = true;
+    }
+    *error = nullptr;
+  }
+  return device_->newComputePipelineState(
+      desc, MTL::PipelineOptionNone, nullptr, error);
 }
 
 MTL::Library* Device::get_library_cache_(const std::string& lib_name) {
   // Search for cached metal lib
-  MTL::Library* mtl_lib;
   if (auto it = library_map_.find(lib_name); it != library_map_.end()) {
-    mtl_lib = it->second;
-  } else { // Look for metallib alongside library
-    register_library(lib_name);
-    mtl_lib = library_map_[lib_name];
+    return it->second;
   }
 
+  // Load a registered library or look for it alongside this binary
+  register_library(lib_name);
+  auto mtl_lib =
+      load_library(device_, lib_name, library_paths_[lib_name].c_str());
+  library_map_.insert({lib_name, mtl_lib});
   return mtl_lib;
 }
 
@@ -378,25 +830,7 @@ MTL::Function* Device::get_function_(
 MTL::ComputePipelineState* Device::get_kernel_(
     const std::string& name,
     const MTL::Function* mtl_function) {
-  // Compile kernel to compute pipeline
-  NS::Error* error = nullptr;
-  MTL::ComputePipelineState* kernel;
-
-  if (mtl_function) {
-    kernel = device_->newComputePipelineState(mtl_function, &error);
-  }
-
-  // Throw error if unable to compile metal function
-  if (!mtl_function || !kernel) {
-    std::ostringstream msg;
-    msg << "[metal::Device] Unable to load kernel " << name << "\n";
-    if (error) {
-      msg << error->localizedDescription()->utf8String() << "\n";
-    }
-    throw std::runtime_error(msg.str());
-  }
-
-  return kernel;
+  return get_kernel_(name, mtl_function, nullptr);
 }
 
 MTL::ComputePipelineState* Device::get_kernel_(
@@ -404,10 +838,6 @@ MTL::ComputePipelineState* Device::get_kernel_(
     const MTL::Function* mtl_function,
     const MTL::LinkedFunctions* linked_functions) {
   // Check inputs
-  if (!linked_functions) {
-    return get_kernel_(name, mtl_function);
-  }
-
   if (!mtl_function) {
     std::ostringstream msg;
     msg << "[metal::Device] Unable to load kernel " << name << "\n";
@@ -417,12 +847,14 @@ MTL::ComputePipelineState* Device::get_kernel_(
   // Prepare compute pipeline state descriptor
   auto desc = MTL::ComputePipelineDescriptor::alloc()->init();
   desc->setComputeFunction(mtl_function);
-  desc->setLinkedFunctions(linked_functions);
+  if (linked_functions) {
+    desc->setLinkedFunctions(linked_functions);
+  }
 
   // Compile kernel to compute pipeline
   NS::Error* error = nullptr;
-  auto kernel = device_->newComputePipelineState(
-      desc, MTL::PipelineOptionNone, nullptr, &error);
+  auto kernel = new_pipeline_state_(desc, &error);
+  desc->release();
 
   // Throw error if unable to compile metal function
   if (!kernel) {
@@ -439,7 +871,15 @@ MTL::ComputePipelineState* Device::get_kernel_(
 
 MTL::Library* Device::get_library(const std::string& name) {
   auto it = library_map_.find(name);
-  return (it != library_map_.end()) ? it->second : nullptr;
+  if (it != library_map_.end()) {
+    return it->second;
+  }
+  // The kernels of libraries precompiled into the metallib are found there
+  if (precompiled_libraries().count(name) > 0) {
+    return get_library_cache_(
+        "mlx_jit_" + std::to_string(std::hash<std::string>{}(name)));
+  }
+  return nullptr;
 }
 
 MTL::Library* Device::get_library(
@@ -447,12 +887,13 @@ MTL::Library* Device::get_library(
     const std::string& source,
     bool cache /* = true */) {
   if (cache) {
-    if (auto it = library_map_.find(name); it != library_map_.end()) {
-      return it->second;
+    if (auto lib = get_library(name); lib != nullptr) {
+      return lib;
     }
   }
 
   auto mtl_lib = get_library_(source);
+  dump_jit_source(name, source);
 
   if (cache) {
     library_map_.insert({name, mtl_lib});
@@ -494,7 +935,8 @@ MTL::Function* Device::get_function(
     const std::string& specialized_name /*  = "" */,
     const MTLFCList& func_consts /* = {} */) {
   // Search for cached metal lib
-  MTL::Library* mtl_lib = get_library_cache_(lib_name);
+  MTL::Library* mtl_lib = (lib_name == "mlx") ? get_kernel_library_(base_name)
+                                              : get_library_cache_(lib_name);
 
   return get_function(base_name, mtl_lib, specialized_name, func_consts);
 }
@@ -562,7 +1004,8 @@ MTL::ComputePipelineState* Device::get_kernel(
   }
 
   // Search for cached metal lib
-  MTL::Library* mtl_lib = get_library_cache_(lib_name);
+  MTL::Library* mtl_lib = (lib_name == "mlx") ? get_kernel_library_(base_name)
+                                              : get_library_cache_(lib_name);
 
   return get_kernel(base_name, mtl_lib, kname, func_consts, linked_functions);
 }
@@ -580,9 +1023,9 @@ std::unique_ptr<void, std::function<void(void*)>> new_scoped_memory_pool() {
       NS::AutoreleasePool::alloc()->init(), dtor);
 }
 
-void new_stream(Stream stream) {
+void new_stream(Stream stream, StreamPriority priority) {
   if (stream.device == mlx::core::Device::gpu) {
-    device(stream.device).new_queue(stream.index);
+    device(stream.device).new_queue(stream.index, priority);
   }
 }
 
@@ -5,15 +5,18 @@
 #include <Metal/Metal.hpp>
 #include <functional>
 #include <mutex>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <dlfcn.h>
 #include <filesystem>
 
 #include "mlx/array.h"
 #include "mlx/device.h"
+#include "mlx/stream.h"
 
 namespace fs = std::filesystem;
 
@@ -36,22 +39,35 @@ inline std::string get_colocated_mtllib_path(const std::string& lib_name) {
 using MTLFCList =
     std::vector<std::tuple<const void*, MTL::DataType, NS::UInteger>>;
 
+struct CaptureRecorder;
+
 struct CommandEncoder {
   CommandEncoder(MTL::CommandBuffer* cbuf) : cbuf(cbuf) {
     enc = cbuf->computeCommandEncoder(MTL::DispatchTypeConcurrent);
     enc->retain();
   };
+  CommandEncoder(MTL::CommandBuffer* cbuf, MTL::ComputePassDescriptor* desc)
+      : cbuf(cbuf) {
+    desc->setDispatchType(MTL::DispatchTypeConcurrent);
+    enc = cbuf->computeCommandEncoder(desc);
+    enc->retain();
+  };
   CommandEncoder(const CommandEncoder&) = delete;
   CommandEncoder& operator=(const CommandEncoder&) = delete;
 
+  // Byte ranges [begin, end) of a buffer
+  using Ranges = std::vector<std::pair<int64_t, int64_t>>;
+
   struct ConcurrentContext {
     ConcurrentContext(CommandEncoder& enc) : enc(enc) {
       enc.concurrent = true;
     }
     ~ConcurrentContext() {
       enc.concurrent = false;
-      enc.outputs.insert(
-          enc.concurrent_outputs.begin(), enc.concurrent_outputs.end());
+      for (auto& [r, ranges] : enc.concurrent_outputs) {
+        auto& out = enc.outputs[r];
+        out.insert(out.end(), ranges.begin(), ranges.end());
+      }
       enc.concurrent_outputs.clear();
     }
 
@@ -59,37 +75,30 @@ struct CommandEncoder {
     CommandEncoder& enc;
   };
 
-  MTL::ComputeCommandEncoder* operator->() {
-    return enc;
-  }
-
-  void set_input_array(const array& a, int idx, int64_t offset = 0) {
-    auto r_buf =
-        static_cast<MTL::Resource*>(const_cast<void*>(a.buffer().ptr()));
-    if (auto it = outputs.find(r_buf); it != outputs.end()) {
-      // Insert a barrier
-      enc->memoryBarrier(&r_buf, 1);
-
-      // Remove the output
-      outputs.erase(it);
-    }
-    auto a_buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
-    auto base_offset = a.data<char>() -
-        static_cast<char*>(const_cast<MTL::Buffer*>(a_buf)->contents());
-    base_offset += offset;
-    enc->setBuffer(a_buf, base_offset, idx);
+  // Calls through -> go to the encoder methods below so that they can be
+  // recorded while a capture is in progress.
+  CommandEncoder* operator->() {
+    return this;
   }
 
-  void set_output_array(array& a, int idx, int64_t offset = 0) {
-    // Add barriers before adding the output to the output set
-    set_input_array(a, idx, offset);
-    auto buf = static_cast<MTL::Resource*>(a.buffer().ptr());
-    if (concurrent) {
-      concurrent_outputs.insert(buf);
-    } else {
-      outputs.insert(buf);
-    }
-  }
+  void setComputePipelineState(MTL::ComputePipelineState* kernel);
+  void setBytes(const void* bytes, NS::UInteger length, NS::UInteger index);
+  void setThreadgroupMemoryLength(NS::UInteger length, NS::UInteger index);
+  void memoryBarrier(
+      const MTL::Resource* const resources[],
+      NS::UInteger count);
+
+  void set_input_array(const array& a, int idx, int64_t offset = 0);
+  void set_output_array(array& a, int idx, int64_t offset = 0);
+
+  // Binds buf at offset bytes where range is the part of buf, in bytes from
+  // its start, that the kernel may access.
+  void set_buffer(
+      const MTL::Buffer* buf,
+      int64_t offset,
+      int idx,
+      const std::pair<int64_t, int64_t>& range,
+      bool is_output);
 
   void dispatchThreadgroups(MTL::Size grid_dims, MTL::Size group_dims);
   void dispatchThreads(MTL::Size grid_dims, MTL::Size group_dims);
@@ -104,14 +113,30 @@ struct CommandEncoder {
   }
 
  private:
-  void maybe_split();
+  // Inserts a barrier on r if range overlaps any of the ranges of r
+  // accessed by previously encoded dispatches that it conflicts with.
+  void maybe_barrier(
+      MTL::Resource* r,
+      const std::pair<int64_t, int64_t>& range,
+      bool is_output);
+  void record_accesses();
+
+  friend class Device;
 
-  int num_dispatches{0};
   MTL::CommandBuffer* cbuf;
   MTL::ComputeCommandEncoder* enc;
   bool concurrent{false};
-  std::unordered_set<MTL::Resource*> outputs;
-  std::unordered_set<MTL::Resource*> concurrent_outputs;
+  CaptureRecorder* recorder{nullptr};
+
+  // Ranges written and read by the dispatches encoded since the last barrier
+  // on each buffer. Dispatches that touch disjoint ranges run concurrently.
+  std::unordered_map<MTL::Resource*, Ranges> outputs;
+  std::unordered_map<MTL::Resource*, Ranges> inputs;
+  std::unordered_map<MTL::Resource*, Ranges> concurrent_outputs;
+
+  // Ranges accessed by the dispatch being encoded
+  std::vector<std::tuple<MTL::Resource*, int64_t, int64_t>> next_inputs;
+  std::vector<std::tuple<MTL::Resource*, int64_t, int64_t>> next_outputs;
 };
 
 class Device {
@@ -125,14 +150,51 @@ class Device {
     return device_;
   };
 
-  void new_queue(int index);
+  // The device class, the last letter of the architecture name (e.g.
+  // applegpu_g15s): 'p' for phones and tablets, 'g' for base and pro, 's' for
+  // max and 'd' for ultra chips
+  char get_architecture_class() const {
+    return arch_class_;
+  }
+
+  void new_queue(
+      int index,
+      StreamPriority priority = StreamPriority::normal);
+  StreamPriority get_queue_priority(int index);
   MTL::CommandBuffer* get_command_buffer(int index);
   int get_command_buffer_ops(int index);
   void increment_command_buffer_ops(int index);
   void commit_command_buffer(int index);
+  // Drops the stream's command buffer and what was encoded into it
+  void discard_command_buffer(int index);
   CommandEncoder& get_command_encoder(int index);
+  // Ends the stream's encoder and starts one from a compute pass descriptor,
+  // e.g. to sample GPU counters at its start and end
+  CommandEncoder& new_command_encoder(
+      int index,
+      MTL::ComputePassDescriptor* desc);
   void end_encoding(int index);
 
+  // Copies the data of in to out, which must be contiguous and have the same
+  // type, on the stream's copy queue so it overlaps with the compute work.
+  // The copy first waits for wait_event at wait_value if it is given. Work
+  // encoded for the stream after this call waits for the copy.
+  void copy_async(
+      int index,
+      const array& in,
+      array& out,
+      MTL::Event* wait_event = nullptr,
+      uint64_t wait_value = 0);
+
+  // Records the commands encoded for the stream until it is called again
+  // with nullptr. Ending the encoder in between invalidates the recording.
+  void set_recorder(int index, CaptureRecorder* recorder);
+
+  // Adds the residency set to the current and future command queues so its
+  // allocations are kept resident while they run
+  void set_residency_set(const MTL::ResidencySet* residency_set);
+
+  // Libraries are loaded the first time one of their kernels is used
   void register_library(
       const std::string& lib_name,
       const std::string& lib_path);
@@ -141,6 +203,8 @@ class Device {
       const std::function<std::string(const std::string&)>& lib_path_func =
           get_colocated_mtllib_path);
 
+  // Returns the library compiled from source under the given name, or the
+  // metallib if it was precompiled into it, or nullptr
   MTL::Library* get_library(const std::string& name);
 
   MTL::Library* get_library(
@@ -182,9 +246,23 @@ class Device {
   MTL::ArgumentEncoder* argument_encoder(
       const std::vector<MTL::ArgumentDescriptor*>& arg_descs) const;
 
+  // Writes the pipelines compiled since the last call to the on-disk kernel
+  // cache. Also done when the device is destroyed.
+  void save_kernel_cache();
+
  private:
   MTL::Library* get_library_cache_(const std::string& name);
 
+  // Registers the kernel families built as mlx_<family>.metallib and reads
+  // the kernels of each from the on-disk cache
+  void register_kernel_families_();
+
+  // The library of a kernel of MLX, loading families until one has it if
+  // the kernel is not in the index
+  MTL::Library* get_kernel_library_(const std::string& kernel);
+
+  void save_kernel_index_();
+
   MTL::Library* get_library_(const std::string& source_string);
   MTL::Library* get_library_(const MTL::StitchedLibraryDescriptor* desc);
 
@@ -208,15 +286,50 @@ class Device {
       const MTL::Function* mtl_function,
       const MTL::LinkedFunctions* linked_functions);
 
+  void load_binary_archive_();
+  MTL::ComputePipelineState* new_pipeline_state_(
+      MTL::ComputePipelineDescriptor* desc,
+      NS::Error** error);
+
   MTL::Device* device_;
   std::unordered_map<int32_t, MTL::CommandQueue*> queue_map_;
+  std::unordered_map<int32_t, StreamPriority> queue_priority_map_;
+  // Queues for copies of each stream with the event they signal when done
+  struct CopyQueue {
+    MTL::CommandQueue* queue;
+    MTL::SharedEvent* event;
+    uint64_t value{0};
+  };
+  std::unordered_map<int32_t, CopyQueue> copy_queue_map_;
   std::unordered_map<int32_t, std::pair<int, MTL::CommandBuffer*>> buffer_map_;
   std::unordered_map<int32_t, std::unique_ptr<CommandEncoder>> encoder_map_;
   std::unordered_map<std::string, MTL::ComputePipelineState*> kernel_map_;
   std::unordered_map<std::string, MTL::Library*> library_map_;
+  std::unordered_map<std::string, std::string> library_paths_;
+  std::set<std::string> families_;
+  std::unordered_set<std::string> indexed_families_;
+  std::unordered_map<std::string, std::string> kernel_families_;
+  std::string index_path_;
+  std::string index_signature_;
+  bool index_dirty_{false};
+  std::mutex library_mtx_;
+  char arch_class_{'g'};
+  MTL::BinaryArchive* archive_{nullptr};
+  std::string archive_path_;
+  bool archive_dirty_{false};
+  const MTL::ResidencySet* residency_set_{nullptr};
   std::mutex mtx_;
 };
 
 Device& device(mlx::core::Device);
 
+// The names of the run time compiled libraries whose sources were dumped
+// with MLX_METAL_JIT_DUMP and built into the metallib with
+// MLX_METAL_JIT_PRECOMPILE. Generated by the build.
+const std::unordered_set<std::string>& precompiled_libraries();
+
+// The path of a file in the on-disk kernel cache for the device with the
+// extension ext, or an empty string if the cache is disabled
+std::string cache_file_path(MTL::Device* device, const std::string& ext);
+
 } // namespace mlx::core::metal
@@ -0,0 +1,114 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/allocator.h"
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/distributed/primitives.h"
+#include "mlx/event.h"
+#include "mlx/scheduler.h"
+
+namespace mlx::core::distributed {
+
+namespace {
+
+array ensure_row_contiguous(const array& x, const Stream& s) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy_gpu(x, x_copy, CopyType::General, s);
+  return x_copy;
+}
+
+// Run the communication on the communication thread once the GPU work that
+// produces its inputs is done. The GPU stream keeps encoding and only waits
+// for the communication at the work that is encoded after it, so
+// communication overlaps the GPU work already in flight and the work of the
+// other streams. The arrays captured by f are kept alive until it is done.
+void communicate_async(const Stream& s, std::function<void()> f) {
+  auto& d = metal::device(s.device);
+  Event event(s);
+  auto mtl_event = static_cast<MTL::Event*>(event.raw_event().get());
+
+  // Commit the inputs so the communication can start as soon as possible
+  d.end_encoding(s.index);
+  d.get_command_buffer(s.index)->encodeSignalEvent(mtl_event, 1);
+  d.commit_command_buffer(s.index);
+
+  scheduler::enqueue(
+      detail::communication_stream(), [event, f = std::move(f)]() mutable {
+        event.set_value(1);
+        event.wait();
+        f();
+        event.set_value(2);
+        event.signal();
+      });
+
+  d.get_command_buffer(s.index)->encodeWait(mtl_event, 2);
+}
+
+} // namespace
+
+void AllReduce::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  if (reduce_type_ != Sum) {
+    throw std::runtime_error("Only all reduce sum is supported for now");
+  }
+  auto& s = stream();
+  auto in = ensure_row_contiguous(inputs[0], s);
+  auto& out = outputs[0];
+  if (in.is_donatable()) {
+    out.copy_shared_buffer(in);
+  } else {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+  communicate_async(s, [group = group(), in, out]() mutable {
+    detail::all_sum(group, in, out);
+  });
+}
+
+void AllGather::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto in = ensure_row_contiguous(inputs[0], s);
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  communicate_async(s, [group = group(), in, out]() mutable {
+    detail::all_gather(group, in, out);
+  });
+}
+
+void ReduceScatter::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto in = ensure_row_contiguous(inputs[0], s);
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  communicate_async(s, [group = group(), in, out]() mutable {
+    detail::reduce_scatter(group, in, out);
+  });
+}
+
+void BroadcastRoot::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto& in = inputs[0];
+  auto& out = outputs[0];
+  auto g = group();
+  if (g.rank() != root_) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  } else if (in.flags().row_contiguous && in.is_donatable()) {
+    out.copy_shared_buffer(in);
+  } else {
+    copy_gpu(in, out, CopyType::General, s);
+  }
+  communicate_async(s, [g, root = root_, out]() mutable {
+    detail::broadcast(g, out, root);
+  });
+}
+
+} // namespace mlx::core::distributed
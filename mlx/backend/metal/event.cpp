@@ -3,10 +3,15 @@
 #include "mlx/event.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/metal_impl.h"
+#include "mlx/event_impl.h"
 
 namespace mlx::core {
 
 Event::Event(const Stream& stream) : stream_(stream) {
+  if (stream.device == Device::cpu) {
+    event_ = detail::new_cpu_event();
+    return;
+  }
   auto dtor = [](void* ptr) {
     auto p = metal::new_scoped_memory_pool();
     static_cast<MTL::SharedEvent*>(ptr)->release();
@@ -17,6 +22,10 @@ Event::Event(const Stream& stream) : stream_(stream) {
 }
 
 void Event::wait() {
+  if (stream().device == Device::cpu) {
+    detail::cpu_event_wait(raw_event().get(), value());
+    return;
+  }
   if (!static_cast<MTL::SharedEvent*>(raw_event().get())
            ->waitUntilSignaledValue(value(), -1)) {
     throw std::runtime_error("[Event::wait] Timed out");
@@ -24,7 +33,19 @@ void Event::wait() {
 }
 
 void Event::signal() {
+  if (stream().device == Device::cpu) {
+    detail::cpu_event_signal(raw_event().get(), value());
+    return;
+  }
   static_cast<MTL::SharedEvent*>(raw_event().get())->setSignaledValue(value());
 }
 
+bool Event::is_signaled() const {
+  if (stream().device == Device::cpu) {
+    return detail::cpu_event_signaled(raw_event().get(), value());
+  }
+  return static_cast<MTL::SharedEvent*>(raw_event().get())->signaledValue() >=
+      value();
+}
+
 } // namespace mlx::core
@@ -2,8 +2,10 @@
 #include <cassert>
 #include <complex>
 #include <map>
+#include <mutex>
 #include <numeric>
 #include <set>
+#include <unordered_map>
 
 #include "mlx/3rdparty/pocketfft.h"
 #include "mlx/backend/metal/binary.h"
@@ -82,6 +84,9 @@ struct FFTPlan {
   int n2 = 0;
 };
 
+// Forward Declaration
+int compute_elems_per_thread(FFTPlan plan);
+
 int next_fast_n(int n) {
   return next_power_of_2(n);
 }
@@ -110,7 +115,42 @@ std::vector<int> plan_stockham_fft(int n) {
   throw std::runtime_error("Unplannable");
 }
 
-FFTPlan plan_fft(int n) {
+bool plan_four_step_split(int n, FFTPlan& plan) {
+  // Split n = n1 * n2 for the no transpose four step FFT. Each step runs
+  // MIN_COALESCE_WIDTH strided FFTs per threadgroup, so both factors must be
+  // multiples of it, fit in shared memory together and be Stockham
+  // decomposable with every thread handling a full set of elements.
+  auto radices = supported_radices();
+  std::set<int> radices_set(radices.begin(), radices.end());
+  int max_n = MAX_STOCKHAM_FFT_SIZE / MIN_COALESCE_WIDTH;
+  int min_n = MIN_THREADGROUP_MEM_SIZE / MIN_COALESCE_WIDTH;
+  auto valid_step = [&](int m) {
+    if (m < min_n || m > max_n || m % MIN_COALESCE_WIDTH != 0) {
+      return false;
+    }
+    for (int factor : prime_factors(m)) {
+      if (radices_set.find(factor) == radices_set.end()) {
+        return false;
+      }
+    }
+    FFTPlan step_plan;
+    step_plan.n = m;
+    step_plan.stockham = plan_stockham_fft(m);
+    step_plan.rader = std::vector<int>(radices.size(), 0);
+    return m % compute_elems_per_thread(step_plan) == 0;
+  };
+  // Prefer large n2 as in the power of 2 heuristic
+  for (int n2 = max_n; n2 >= min_n; n2--) {
+    if (n % n2 == 0 && valid_step(n2) && valid_step(n / n2)) {
+      plan.n1 = n / n2;
+      plan.n2 = n2;
+      return true;
+    }
+  }
+  return false;
+}
+
+FFTPlan build_fft_plan(int n) {
   auto radices = supported_radices();
   std::set<int> radices_set(radices.begin(), radices.end());
 
@@ -128,6 +168,10 @@ FFTPlan plan_fft(int n) {
     plan.n2 = n > 65536 ? 1024 : 64;
     plan.n1 = n / plan.n2;
     return plan;
+  } else if (n > MAX_STOCKHAM_FFT_SIZE && plan_four_step_split(n, plan)) {
+    // Composite sizes with small prime factors use the same implementation
+    plan.four_step = true;
+    return plan;
   } else if (n > MAX_STOCKHAM_FFT_SIZE) {
     // Otherwise we use a multi-upload Bluestein's
     plan.four_step = true;
@@ -172,6 +216,19 @@ FFTPlan plan_fft(int n) {
   return plan;
 }
 
+FFTPlan plan_fft(int n) {
+  // Planning factorizes n and searches for four step splits so reuse the
+  // plans across calls with the same size.
+  static std::unordered_map<int, FFTPlan> plans;
+  static std::mutex plans_mutex;
+  std::lock_guard<std::mutex> lock(plans_mutex);
+  auto it = plans.find(n);
+  if (it == plans.end()) {
+    it = plans.emplace(n, build_fft_plan(n)).first;
+  }
+  return it->second;
+}
+
 int compute_elems_per_thread(FFTPlan plan) {
   // Heuristics for selecting an efficient number
   // of threads to use for a particular mixed-radix FFT.
@@ -259,32 +316,32 @@ int primitive_root(int n) {
   return -1;
 }
 
-std::tuple<array, array, array> compute_raders_constants(
-    int rader_n,
-    const Stream& s) {
+struct RaderConstants {
+  std::vector<std::complex<float>> b_q_fft;
+  std::vector<short> g_q;
+  std::vector<short> g_minus_q;
+};
+
+RaderConstants compute_raders_host_constants(int rader_n) {
   int proot = primitive_root(rader_n);
   // Fermat's little theorem
   int inv = mod_exp(proot, rader_n - 2, rader_n);
-  std::vector<short> g_q(rader_n - 1);
-  std::vector<short> g_minus_q(rader_n - 1);
+  RaderConstants c;
+  c.g_q.resize(rader_n - 1);
+  c.g_minus_q.resize(rader_n - 1);
   for (int i = 0; i < rader_n - 1; i++) {
-    g_q[i] = mod_exp(proot, i, rader_n);
-    g_minus_q[i] = mod_exp(inv, i, rader_n);
+    c.g_q[i] = mod_exp(proot, i, rader_n);
+    c.g_minus_q[i] = mod_exp(inv, i, rader_n);
   }
-  array g_q_arr(g_q.begin(), {rader_n - 1});
-  array g_minus_q_arr(g_minus_q.begin(), {rader_n - 1});
 
   std::vector<std::complex<float>> b_q(rader_n - 1);
   for (int i = 0; i < rader_n - 1; i++) {
-    float pi_i = (float)g_minus_q[i] * -2.0 * M_PI / rader_n;
+    float pi_i = (float)c.g_minus_q[i] * -2.0 * M_PI / rader_n;
     b_q[i] = std::exp(std::complex<float>(0, pi_i));
   }
 
-  array b_q_fft({rader_n - 1}, complex64, nullptr, {});
-  b_q_fft.set_data(allocator::malloc_or_wait(b_q_fft.nbytes()));
-  auto b_q_fft_ptr =
-      reinterpret_cast<std::complex<float>*>(b_q_fft.data<complex64_t>());
-  std::ptrdiff_t item_size = b_q_fft.itemsize();
+  c.b_q_fft.resize(rader_n - 1);
+  std::ptrdiff_t item_size = sizeof(std::complex<float>);
   size_t fft_size = rader_n - 1;
   // This FFT is always small (<4096, batch 1) so save some overhead
   // and do it on the CPU
@@ -295,13 +352,38 @@ std::tuple<array, array, array> compute_raders_constants(
       /* axes= */ {0},
       /* forward= */ true,
       /* data_in= */ b_q.data(),
-      /* data_out= */ b_q_fft_ptr,
+      /* data_out= */ c.b_q_fft.data(),
       /* scale= */ 1.0f);
+  return c;
+}
+
+std::tuple<array, array, array> compute_raders_constants(
+    int rader_n,
+    const Stream& s) {
+  // The constants only depend on rader_n so compute them once on the CPU
+  static std::unordered_map<int, RaderConstants> cache;
+  static std::mutex cache_mutex;
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  auto it = cache.find(rader_n);
+  if (it == cache.end()) {
+    it = cache.emplace(rader_n, compute_raders_host_constants(rader_n)).first;
+  }
+  const auto& c = it->second;
+
+  array g_q_arr(c.g_q.begin(), {rader_n - 1});
+  array g_minus_q_arr(c.g_minus_q.begin(), {rader_n - 1});
+
+  array b_q_fft({rader_n - 1}, complex64, nullptr, {});
+  b_q_fft.set_data(allocator::malloc_or_wait(b_q_fft.nbytes()));
+  auto b_q_fft_ptr =
+      reinterpret_cast<std::complex<float>*>(b_q_fft.data<complex64_t>());
+  std::copy(c.b_q_fft.begin(), c.b_q_fft.end(), b_q_fft_ptr);
   return std::make_tuple(b_q_fft, g_q_arr, g_minus_q_arr);
 }
 
 // Bluestein
-std::pair<array, array> compute_bluestein_constants(int n, int bluestein_n) {
+std::pair<std::vector<std::complex<float>>, std::vector<std::complex<float>>>
+compute_bluestein_host_constants(int n, int bluestein_n) {
   // We need to calculate the Bluestein twiddle factors
   // in double precision for the overall numerical stability
   // of Bluestein's FFT algorithm to be acceptable.
@@ -313,8 +395,6 @@ std::pair<array, array> compute_bluestein_constants(int n, int bluestein_n) {
   // w_k = np.exp(-1j * np.pi / N * (np.arange(-N + 1, N) ** 2))
   // w_q = np.fft.fft(1/w_k)
   // return w_k, w_q
-  int length = 2 * n - 1;
-
   std::vector<std::complex<float>> w_k_vec(n);
   std::vector<std::complex<float>> w_q_vec(bluestein_n, 0);
 
@@ -326,16 +406,8 @@ std::pair<array, array> compute_bluestein_constants(int n, int bluestein_n) {
     }
   }
 
-  array w_k({n}, complex64, nullptr, {});
-  w_k.set_data(allocator::malloc_or_wait(w_k.nbytes()));
-  std::copy(w_k_vec.begin(), w_k_vec.end(), w_k.data<complex64_t>());
-
-  array w_q({bluestein_n}, complex64, nullptr, {});
-  w_q.set_data(allocator::malloc_or_wait(w_q.nbytes()));
-  auto w_q_ptr =
-      reinterpret_cast<std::complex<float>*>(w_q.data<complex64_t>());
-
-  std::ptrdiff_t item_size = w_q.itemsize();
+  std::vector<std::complex<float>> w_q_fft(bluestein_n);
+  std::ptrdiff_t item_size = sizeof(std::complex<float>);
   size_t fft_size = bluestein_n;
   pocketfft::c2c(
       /* shape= */ {fft_size},
@@ -344,8 +416,43 @@ std::pair<array, array> compute_bluestein_constants(int n, int bluestein_n) {
       /* axes= */ {0},
       /* forward= */ true,
       /* data_in= */ w_q_vec.data(),
-      /* data_out= */ w_q_ptr,
+      /* data_out= */ w_q_fft.data(),
       /* scale= */ 1.0f);
+  return std::make_pair(std::move(w_k_vec), std::move(w_q_fft));
+}
+
+std::pair<array, array> compute_bluestein_constants(int n, int bluestein_n) {
+  // The multi upload path needs a bluestein_n sized CPU FFT per call which
+  // dominates for large n, so keep the host constants around.
+  static std::map<
+      std::pair<int, int>,
+      std::pair<
+          std::vector<std::complex<float>>,
+          std::vector<std::complex<float>>>>
+      cache;
+  static std::mutex cache_mutex;
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  auto key = std::make_pair(n, bluestein_n);
+  auto it = cache.find(key);
+  if (it == cache.end()) {
+    it = cache.emplace(key, compute_bluestein_host_constants(n, bluestein_n))
+             .first;
+  }
+  const auto& [w_k_vec, w_q_vec] = it->second;
+
+  array w_k({n}, complex64, nullptr, {});
+  w_k.set_data(allocator::malloc_or_wait(w_k.nbytes()));
+  std::copy(
+      w_k_vec.begin(),
+      w_k_vec.end(),
+      reinterpret_cast<std::complex<float>*>(w_k.data<complex64_t>()));
+
+  array w_q({bluestein_n}, complex64, nullptr, {});
+  w_q.set_data(allocator::malloc_or_wait(w_q.nbytes()));
+  std::copy(
+      w_q_vec.begin(),
+      w_q_vec.end(),
+      reinterpret_cast<std::complex<float>*>(w_q.data<complex64_t>()));
   return std::make_tuple(w_k, w_q);
 }
 
@@ -482,8 +589,13 @@ void four_step_fft(
     const Stream& s) {
   auto& d = metal::device(s.device);
 
+  if (plan.bluestein_n == -1 && real && !is_power_of_2(plan.n)) {
+    // The strided real read/writers assume power of 2 sizes
+    plan.bluestein_n = next_fast_n(2 * plan.n - 1);
+  }
+
   if (plan.bluestein_n == -1) {
-    // Fast no transpose implementation for powers of 2.
+    // Fast no transpose implementation.
     FourStepParams four_step_params = {
         /* required= */ true, /* first_step= */ true, plan.n1, plan.n2};
     auto temp_shape = (real && inverse) ? out.shape() : in.shape();
@@ -547,8 +659,8 @@ void fft_op(
       auto [data_size, is_row_contiguous, is_col_contiguous] =
           check_contiguity(x.shape(), strides);
 
-      flags.col_contiguous = is_row_contiguous;
-      flags.row_contiguous = is_col_contiguous;
+      flags.row_contiguous = is_row_contiguous;
+      flags.col_contiguous = is_col_contiguous;
       flags.contiguous = data_size == x_copy.size();
 
       x_copy.set_data(
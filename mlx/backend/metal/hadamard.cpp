@@ -0,0 +1,96 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Rows up to this size are transformed in threadgroup memory at once
+constexpr int max_hadamard_size = 8192;
+// Small rows are batched so a threadgroup transforms at least this many
+// elements
+constexpr int min_threadgroup_mem_size = 256;
+
+// Transform rows of n elements which are stride apart, see the hadamard
+// kernel for the layout
+void hadamard_pass(
+    const array& in,
+    array& out,
+    int n,
+    int stride,
+    float scale,
+    metal::Device& d,
+    const Stream& s) {
+  int tg_mem_size = std::max(n, min_threadgroup_mem_size);
+  int threads_per_row = std::max(n / 8, 1);
+  int rows_per_group = tg_mem_size / n;
+  size_t rows = in.size() / n;
+
+  std::ostringstream kname;
+  kname << "hadamard_" << type_to_name(out) << "_" << tg_mem_size;
+  auto kernel = d.get_kernel(kname.str());
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(in, 0);
+  compute_encoder.set_output_array(out, 1);
+  compute_encoder->setBytes(&n, sizeof(int), 2);
+  compute_encoder->setBytes(&stride, sizeof(int), 3);
+  compute_encoder->setBytes(&scale, sizeof(float), 4);
+  compute_encoder.dispatchThreads(
+      MTL::Size(threads_per_row, rows, 1),
+      MTL::Size(threads_per_row, rows_per_group, 1));
+}
+
+} // namespace
+
+void Hadamard::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+  auto& in = inputs[0];
+
+  // The kernel reads a row to threadgroup memory before writing it so it can
+  // transform in place
+  if (in.flags().row_contiguous) {
+    if (in.is_donatable()) {
+      out.move_shared_buffer(in);
+    } else {
+      out.set_data(allocator::malloc_or_wait(out.nbytes()));
+    }
+  } else {
+    copy_gpu(in, out, CopyType::General, s);
+  }
+  const array& src = in.flags().row_contiguous ? in : out;
+  if (out.size() == 0) {
+    return;
+  }
+
+  // Larger sizes are split as n = n1 * n2 with H_n = H_n1 (x) H_n2, i.e. the
+  // rows and then the columns of (n1, n2) matrices are transformed
+  int n = in.shape(-1);
+  if (n <= max_hadamard_size) {
+    hadamard_pass(src, out, n, 1, scale_, d, s);
+  } else {
+    int n2 = max_hadamard_size;
+    int n1 = n / n2;
+    if (n1 > max_hadamard_size) {
+      std::ostringstream msg;
+      msg << "[Hadamard::eval_gpu] Sizes up to "
+          << max_hadamard_size * max_hadamard_size
+          << " are supported but got " << n << ".";
+      throw std::runtime_error(msg.str());
+    }
+    hadamard_pass(src, out, n2, 1, 1.0f, d, s);
+    hadamard_pass(out, out, n1, n2, scale_, d, s);
+  }
+}
+
+} // namespace mlx::core
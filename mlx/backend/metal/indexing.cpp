@@ -6,6 +6,7 @@
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/jit/includes.h"
 #include "mlx/backend/metal/jit/indexing.h"
+#include "mlx/backend/metal/kernels.h"
 #include "mlx/backend/metal/utils.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
@@ -53,6 +54,51 @@ void Gather::eval_gpu(const std::vector<array>& inputs, array& out) {
   int idx_ndim = nidx ? inputs[1].ndim() : 0;
   size_t ndim = src.ndim();
 
+  // Whole rows of a row contiguous source gathered along the first axis, as
+  // in an embedding lookup, are copied without computing every location
+  bool gather_rows = nidx == 1 && idx_ndim > 0 && axes_[0] == 0 &&
+      src.flags().row_contiguous && slice_sizes_[0] == 1;
+  for (int i = 1; i < ndim && gather_rows; i++) {
+    gather_rows &= slice_sizes_[i] == src.shape(i);
+  }
+  if (gather_rows) {
+    auto& idx = inputs[1];
+    std::string kernel_name =
+        "gather_rows" + type_to_name(out) + type_to_name(idx);
+    auto lib = d.get_library(kernel_name);
+    if (lib == nullptr) {
+      std::ostringstream kernel_source;
+      kernel_source << metal::utils() << metal::gather()
+                    << get_template_definition(
+                           kernel_name,
+                           "gather_rows",
+                           get_type_string(out.dtype()),
+                           get_type_string(idx.dtype()));
+      lib = d.get_library(kernel_name, kernel_source.str());
+    }
+    auto kernel = d.get_kernel(kernel_name, lib);
+
+    int n_src_rows = src.shape(0);
+    size_t row_size = src.size() / std::max(n_src_rows, 1);
+    size_t n_rows = idx.size();
+    size_t n_reads = 4;
+    size_t dim0 = (row_size + n_reads - 1) / n_reads;
+    auto group_dims = get_block_dims(dim0, n_rows, 1);
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(src, 0);
+    compute_encoder.set_output_array(out, 1);
+    compute_encoder.set_input_array(idx, 2);
+    compute_encoder->setBytes(&n_src_rows, sizeof(int), 3);
+    compute_encoder->setBytes(&row_size, sizeof(size_t), 4);
+    compute_encoder->setBytes(idx.shape().data(), idx_ndim * sizeof(int), 5);
+    compute_encoder->setBytes(
+        idx.strides().data(), idx_ndim * sizeof(size_t), 6);
+    compute_encoder->setBytes(&idx_ndim, sizeof(int), 7);
+    compute_encoder.dispatchThreads(MTL::Size(dim0, n_rows, 1), group_dims);
+    return;
+  }
+
   std::string lib_name;
   std::string kernel_name;
   std::string idx_type_name = nidx ? type_to_name(inputs[1]) : "";
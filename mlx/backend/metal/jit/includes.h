@@ -22,15 +22,20 @@ const char* quantized();
 const char* ternary();
 const char* scan();
 const char* softmax();
+const char* logsumexp();
 const char* sort();
 const char* reduce();
 
 const char* gemm();
 const char* steel_gemm_fused();
 const char* steel_gemm_masked();
+const char* steel_gemm_gather();
+const char* steel_gemm_sparse();
+const char* steel_gemm_fp8();
 const char* steel_gemm_splitk();
 const char* conv();
 const char* steel_conv();
 const char* steel_conv_general();
+const char* steel_conv_wgrad();
 
 } // namespace mlx::core::metal
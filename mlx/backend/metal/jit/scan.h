@@ -13,6 +13,35 @@ contiguous_scan<{1}, {2}, {3}<{2}>, 4, {4}, {5}>(
     uint simd_lane_id [[thread_index_in_simdgroup]],
     uint simd_group_id [[simdgroup_index_in_threadgroup]]);
 
+template [[host_name("partial_{0}")]] [[kernel]] void
+contiguous_scan_partial<{1}, {2}, {3}<{2}>, 4, {4}, {5}>(
+    const device {1}* in [[buffer(0)]],
+    device {2}* partials [[buffer(1)]],
+    const constant size_t& axis_size [[buffer(2)]],
+    const constant size_t& split_size [[buffer(3)]],
+    uint2 gid [[threadgroup_position_in_grid]],
+    uint2 n_groups [[threadgroups_per_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+
+template [[host_name("split_{0}")]] [[kernel]] void
+contiguous_scan_split<{1}, {2}, {3}<{2}>, 4, {4}, {5}>(
+    const device {1}* in [[buffer(0)]],
+    const device {2}* partials [[buffer(1)]],
+    device {2}* out [[buffer(2)]],
+    const constant size_t& axis_size [[buffer(3)]],
+    const constant size_t& split_size [[buffer(4)]],
+    uint2 gid [[threadgroup_position_in_grid]],
+    uint2 n_groups [[threadgroups_per_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+
 template [[host_name("strided_{0}")]] [[kernel]] void
 strided_scan<{1}, {2}, {3}<{2}>, 4, {4}, {5}>(
     const device {1}* in [[buffer(0)]],
@@ -20,4 +20,8 @@ softmax_looped<{1}, {2}>(
     uint lsize [[threads_per_threadgroup]],
     uint simd_lane_id [[thread_index_in_simdgroup]],
     uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+template [[host_name("partial_{0}")]] [[kernel]]
+decltype(softmax_partial<{1}, {2}>) softmax_partial<{1}, {2}>;
+template [[host_name("normalize_{0}")]] [[kernel]]
+decltype(softmax_normalize<{1}, {2}>) softmax_normalize<{1}, {2}>;
 )";
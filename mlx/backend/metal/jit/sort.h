@@ -79,3 +79,71 @@ mb_block_merge<{1}, {2}, true, {3}, {4}>(
     uint3 tid [[threadgroup_position_in_grid]],
     uint3 lid [[thread_position_in_threadgroup]]);
 )";
+
+constexpr std::string_view radix_select_kernels = R"(
+template [[host_name("{0}")]] [[kernel]] void
+radix_select_partition<{1}, {2}, {3}, {4}>(
+    const device {1}* inp [[buffer(0)]],
+    device {2}* out [[buffer(1)]],
+    const constant int& size_sorted_axis [[buffer(2)]],
+    const constant int& kth [[buffer(3)]],
+    const constant int& in_stride_sorted_axis [[buffer(4)]],
+    const constant int& out_stride_sorted_axis [[buffer(5)]],
+    const constant int& nc_dim [[buffer(6)]],
+    const constant int* nc_shape [[buffer(7)]],
+    const constant size_t* in_nc_strides [[buffer(8)]],
+    const constant size_t* out_nc_strides [[buffer(9)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]]);
+)";
+
+constexpr std::string_view radix_sort_kernels = R"(
+template [[host_name("radix_sort_count_{0}")]] [[kernel]] void
+radix_sort_count<{1}, 256, 4>(
+    const device {1}* keys [[buffer(0)]],
+    device uint* counts [[buffer(1)]],
+    const constant int& size_sorted_axis [[buffer(2)]],
+    const constant int& shift [[buffer(3)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint3 tgp_grid [[threadgroups_per_grid]]);
+template [[host_name("radix_sort_scan_{0}")]] [[kernel]] void
+radix_sort_scan<1024>(
+    device uint* counts [[buffer(0)]],
+    const constant int& n_counts [[buffer(1)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+template [[host_name("radix_sort_scatter_{0}")]] [[kernel]] void
+radix_sort_scatter<{1}, uint32_t, false, 256, 4>(
+    const device {1}* keys_in [[buffer(0)]],
+    const device uint32_t* idxs_in [[buffer(1)]],
+    device {1}* keys_out [[buffer(2)]],
+    device uint32_t* idxs_out [[buffer(3)]],
+    const device uint* offsets [[buffer(4)]],
+    const constant int& size_sorted_axis [[buffer(5)]],
+    const constant int& shift [[buffer(6)]],
+    const constant bool& first_pass [[buffer(7)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint3 tgp_grid [[threadgroups_per_grid]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+template [[host_name("arg_radix_sort_scatter_{0}")]] [[kernel]] void
+radix_sort_scatter<{1}, uint32_t, true, 256, 4>(
+    const device {1}* keys_in [[buffer(0)]],
+    const device uint32_t* idxs_in [[buffer(1)]],
+    device {1}* keys_out [[buffer(2)]],
+    device uint32_t* idxs_out [[buffer(3)]],
+    const device uint* offsets [[buffer(4)]],
+    const constant int& size_sorted_axis [[buffer(5)]],
+    const constant int& shift [[buffer(6)]],
+    const constant bool& first_pass [[buffer(7)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint3 tgp_grid [[threadgroups_per_grid]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+)";
@@ -8,6 +8,7 @@ implicit_gemm_conv_2d<{itype}, {bm}, {bn}, {bk}, {wm}, {wn}, {n_channels}, {smal
     device {itype}* C [[buffer(2)]],
     const constant MLXConvParams<2>* params [[buffer(3)]],
     const constant ImplicitGemmConv2DParams* gemm_params [[buffer(4)]],
+    const device {itype}* bias [[buffer(5), function_constant(conv_has_bias)]],
     uint3 tid [[threadgroup_position_in_grid]],
     uint3 lid [[thread_position_in_threadgroup]],
     uint simd_gid [[simdgroup_index_in_threadgroup]],
@@ -25,6 +26,21 @@ template [[host_name("{name}")]] [[kernel]] void
         const constant Conv2DGeneralJumpParams* jump_params [[buffer(5)]],
         const constant Conv2DGeneralBaseInfo* base_h [[buffer(6)]],
         const constant Conv2DGeneralBaseInfo* base_w [[buffer(7)]],
+        const device {itype}* bias [[buffer(8), function_constant(conv_has_bias)]],
+        uint3 tid [[threadgroup_position_in_grid]],
+        uint3 lid [[thread_position_in_threadgroup]],
+        uint simd_gid [[simdgroup_index_in_threadgroup]],
+        uint simd_lid [[thread_index_in_simdgroup]]);
+)";
+
+constexpr std::string_view steel_conv_wgrad_kernels = R"(
+template [[host_name("{name}")]] [[kernel]] void
+    implicit_gemm_conv_wgrad<{itype}, {ndim}, {bm}, {bn}, {bk}, {wm}, {wn}>(
+        const device {itype}* A [[buffer(0)]],
+        const device {itype}* B [[buffer(1)]],
+        device float* C [[buffer(2)]],
+        const constant MLXConvParams<{ndim}>* params [[buffer(3)]],
+        const constant ImplicitGemmConvWeightGradParams* gemm_params [[buffer(4)]],
         uint3 tid [[threadgroup_position_in_grid]],
         uint3 lid [[thread_position_in_threadgroup]],
         uint simd_gid [[simdgroup_index_in_threadgroup]],
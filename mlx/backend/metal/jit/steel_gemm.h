@@ -54,6 +54,58 @@ block_masked_gemm<
     uint3 lid [[thread_position_in_threadgroup]]);
 )";
 
+constexpr std::string_view steel_gemm_gather_kernels = R"(
+template [[host_name("{name}")]] [[kernel]] void
+gather_mm_rhs<{itype}, {bm}, {bn}, {bk}, {wm}, {wn}, {trans_b}, float>(
+    const device {itype}* A [[buffer(0)]],
+    const device {itype}* B [[buffer(1)]],
+    const device uint32_t* rhs_indices [[buffer(2)]],
+    device {itype}* D [[buffer(3)]],
+    const constant GEMMParams* params [[buffer(4)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]);
+)";
+
+constexpr std::string_view steel_gemm_sparse_kernels = R"(
+template [[host_name("{name}")]] [[kernel]] void
+sparse_2_4_gemm<{itype}, {bm}, {bn}, {bk}, {wm}, {wn}, float>(
+    const device {itype}* A [[buffer(0)]],
+    const device {itype}* B_values [[buffer(1)]],
+    const device uint32_t* B_meta [[buffer(2)]],
+    device {itype}* D [[buffer(3)]],
+    const constant int& M [[buffer(4)]],
+    const constant int& N [[buffer(5)]],
+    const constant int& K [[buffer(6)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]);
+)";
+
+constexpr std::string_view steel_gemv_sparse_kernels = R"(
+template [[host_name("{name}")]] [[kernel]] decltype(
+    sparse_2_4_gemv<{itype}, {max_rows}>) sparse_2_4_gemv<{itype}, {max_rows}>;
+)";
+
+constexpr std::string_view steel_gemm_fp8_kernels = R"(
+template [[host_name("{name}")]] [[kernel]] void
+fp8_gemm<{itype}, {bm}, {bn}, {bk}, {wm}, {wn}, {e5m2}, float>(
+    const device {itype}* A [[buffer(0)]],
+    const device uint8_t* B [[buffer(1)]],
+    device {itype}* D [[buffer(2)]],
+    const constant int& M [[buffer(3)]],
+    const constant int& N [[buffer(4)]],
+    const constant int& K [[buffer(5)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]);
+)";
+
+constexpr std::string_view steel_gemv_fp8_kernels = R"(
+template [[host_name("{name}")]] [[kernel]] decltype(
+    fp8_gemv<{itype}, {max_rows}, {e5m2}>) fp8_gemv<{itype}, {max_rows}, {e5m2}>;
+)";
+
 constexpr std::string_view steel_gemm_splitk_kernels = R"(
 template [[host_name("{name}")]] [[kernel]] void
 gemm_splitk<
@@ -3,8 +3,8 @@
 
 #include "mlx/backend/common/compiled.h"
 #include "mlx/backend/metal/jit/arange.h"
-#include "mlx/backend/metal/jit/copy.h"
 #include "mlx/backend/metal/jit/includes.h"
+#include "mlx/backend/metal/jit/logsumexp.h"
 #include "mlx/backend/metal/jit/reduce.h"
 #include "mlx/backend/metal/jit/scan.h"
 #include "mlx/backend/metal/jit/softmax.h"
@@ -45,16 +45,20 @@ MTL::ComputePipelineState* get_unary_kernel(
     const std::string& kernel_name,
     Dtype out_type,
     const std::string op) {
-  std::string lib_name = kernel_name.substr(1);
+  std::string lib_name = kernel_name.substr(kernel_name.find(op));
   auto lib = d.get_library(lib_name);
   if (lib == nullptr) {
     std::ostringstream kernel_source;
     auto u_def = get_template_definition(
         "v" + lib_name, "unary_v", get_type_string(out_type), op);
+    auto un_def = get_template_definition(
+        "vn" + lib_name, "unary_vn", get_type_string(out_type), op);
     auto g_def = get_template_definition(
-        "g" + lib_name, "unary_g", get_type_string(out_type), op);
+        "g" + lib_name, "unary_g", get_type_string(out_type), op, "int");
+    auto g_large_def = get_template_definition(
+        "glarge" + lib_name, "unary_g", get_type_string(out_type), op);
     kernel_source << metal::utils() << metal::unary_ops() << metal::unary()
-                  << u_def << g_def;
+                  << u_def << un_def << g_def << g_large_def;
     lib = d.get_library(lib_name, kernel_source.str());
   }
   return d.get_kernel(kernel_name, lib);
@@ -71,6 +75,9 @@ void add_binary_kernels(
       {"vs", "binary_vs"},
       {"sv", "binary_sv"},
       {"vv", "binary_vv"},
+      {"svn", "binary_svn"},
+      {"vsn", "binary_vsn"},
+      {"vvn", "binary_vvn"},
       {"g1", "binary_g_nd1"},
       {"g2", "binary_g_nd2"},
       {"g3", "binary_g_nd3"},
@@ -80,24 +87,41 @@ void add_binary_kernels(
   };
   for (auto [name, func] : kernel_types) {
     std::string template_def;
-    if (name == "g4" || name == "g5") {
-      int dim = std::stoi(name.substr(1));
-      template_def = get_template_definition(
-          name + lib_name,
-          func,
-          get_type_string(in_type),
-          get_type_string(out_type),
-          op,
-          dim);
-    } else {
+    if (name[0] != 'g') {
       template_def = get_template_definition(
           name + lib_name,
           func,
           get_type_string(in_type),
           get_type_string(out_type),
           op);
+      kernel_source << template_def;
+      continue;
+    }
+    // The general kernels index with int or, for large arrays, int64_t
+    for (bool large : {false, true}) {
+      std::string kname = name + (large ? "large" : "") + lib_name;
+      std::string idx_type = large ? "int64_t" : "int";
+      if (name == "g4" || name == "g5") {
+        int dim = std::stoi(name.substr(1));
+        template_def = get_template_definition(
+            kname,
+            func,
+            get_type_string(in_type),
+            get_type_string(out_type),
+            op,
+            dim,
+            idx_type);
+      } else {
+        template_def = get_template_definition(
+            kname,
+            func,
+            get_type_string(in_type),
+            get_type_string(out_type),
+            op,
+            idx_type);
+      }
+      kernel_source << template_def;
     }
-    kernel_source << template_def;
   }
 }
 
@@ -107,7 +131,7 @@ MTL::ComputePipelineState* get_binary_kernel(
     Dtype in_type,
     Dtype out_type,
     const std::string op) {
-  std::string lib_name = kernel_name.substr(2);
+  std::string lib_name = kernel_name.substr(kernel_name.find(op));
   auto lib = d.get_library(lib_name);
   if (lib == nullptr) {
     std::ostringstream kernel_source;
@@ -124,7 +148,7 @@ MTL::ComputePipelineState* get_binary_two_kernel(
     Dtype in_type,
     Dtype out_type,
     const std::string op) {
-  std::string lib_name = kernel_name.substr(2);
+  std::string lib_name = kernel_name.substr(kernel_name.find(op));
   auto lib = d.get_library(lib_name);
   if (lib == nullptr) {
     std::ostringstream kernel_source;
@@ -147,6 +171,7 @@ MTL::ComputePipelineState* get_ternary_kernel(
     std::ostringstream kernel_source;
     const std::map<std::string, std::string> kernel_types = {
         {"v", "ternary_v"},
+        {"vn", "ternary_vn"},
         {"g", "ternary_g"},
         {"g1", "ternary_g_nd1"},
         {"g2", "ternary_g_nd2"},
@@ -156,16 +181,25 @@ MTL::ComputePipelineState* get_ternary_kernel(
     };
     kernel_source << metal::utils() << metal::ternary_ops() << metal::ternary();
     for (auto [name, func] : kernel_types) {
-      std::string template_def;
-      if (name == "g4" || name == "g5") {
-        int dim = std::stoi(name.substr(1));
-        template_def = get_template_definition(
-            name + "_" + lib_name, func, get_type_string(type), op, dim);
-      } else {
-        template_def = get_template_definition(
+      if (name[0] != 'g') {
+        kernel_source << get_template_definition(
             name + "_" + lib_name, func, get_type_string(type), op);
+        continue;
+      }
+      for (bool large : {false, true}) {
+        std::string kname = name + (large ? "large_" : "_") + lib_name;
+        std::string idx_type = large ? "int64_t" : "int";
+        std::string template_def;
+        if (name == "g4" || name == "g5") {
+          int dim = std::stoi(name.substr(1));
+          template_def = get_template_definition(
+              kname, func, get_type_string(type), op, dim, idx_type);
+        } else {
+          template_def = get_template_definition(
+              kname, func, get_type_string(type), op, idx_type);
+        }
+        kernel_source << template_def;
       }
-      kernel_source << template_def;
     }
     lib = d.get_library(lib_name, kernel_source.str());
   }
@@ -181,12 +215,42 @@ MTL::ComputePipelineState* get_copy_kernel(
   auto lib = d.get_library(lib_name);
   if (lib == nullptr) {
     std::ostringstream kernel_source;
+    auto in_type = get_type_string(in.dtype());
+    auto out_type = get_type_string(out.dtype());
     kernel_source << metal::utils() << metal::copy()
-                  << fmt::format(
-                         copy_kernels,
-                         lib_name,
-                         get_type_string(in.dtype()),
-                         get_type_string(out.dtype()));
+                  << get_template_definition(
+                         "s_" + lib_name, "copy_s", in_type, out_type)
+                  << get_template_definition(
+                         "v_" + lib_name, "copy_v", in_type, out_type);
+    const std::map<std::string, std::string> kernel_types = {
+        {"g1", "copy_g_nd1"},
+        {"g2", "copy_g_nd2"},
+        {"g3", "copy_g_nd3"},
+        {"g4", "copy_g_nd"},
+        {"g5", "copy_g_nd"},
+        {"g", "copy_g"},
+        {"gg1", "copy_gg_nd1"},
+        {"gg2", "copy_gg_nd2"},
+        {"gg3", "copy_gg_nd3"},
+        {"gg4", "copy_gg_nd"},
+        {"gg5", "copy_gg_nd"},
+        {"gg", "copy_gg"},
+    };
+    // The general kernels index with int or, for large arrays, int64_t
+    for (auto [name, func] : kernel_types) {
+      for (bool large : {false, true}) {
+        std::string kname = name + (large ? "large_" : "_") + lib_name;
+        std::string idx_type = large ? "int64_t" : "int";
+        char last = name.back();
+        if (last == '4' || last == '5') {
+          kernel_source << get_template_definition(
+              kname, func, in_type, out_type, last - '0', idx_type);
+        } else {
+          kernel_source << get_template_definition(
+              kname, func, in_type, out_type, idx_type);
+        }
+      }
+    }
     lib = d.get_library(lib_name, kernel_source.str());
   }
   return d.get_kernel(kernel_name, lib);
@@ -212,6 +276,24 @@ MTL::ComputePipelineState* get_softmax_kernel(
   return d.get_kernel(kernel_name, lib);
 }
 
+MTL::ComputePipelineState* get_logsumexp_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& out) {
+  std::string lib_name = kernel_name.substr(kernel_name.find("_") + 1);
+  auto lib = d.get_library(lib_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel_source;
+    kernel_source << metal::utils() << metal::logsumexp()
+                  << fmt::format(
+                         logsumexp_kernels,
+                         lib_name,
+                         get_type_string(out.dtype()));
+    lib = d.get_library(lib_name, kernel_source.str());
+  }
+  return d.get_kernel(kernel_name, lib);
+}
+
 MTL::ComputePipelineState* get_scan_kernel(
     metal::Device& d,
     const std::string& kernel_name,
@@ -288,6 +370,48 @@ MTL::ComputePipelineState* get_mb_sort_kernel(
   return d.get_kernel(kernel_name, lib);
 }
 
+MTL::ComputePipelineState* get_radix_sort_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& in) {
+  // The count, scan and scatter kernels for a type share a library
+  std::string lib_name = "radix_sort_" + type_to_name(in);
+  auto lib = d.get_library(lib_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel_source;
+    kernel_source << metal::utils() << metal::sort()
+                  << fmt::format(
+                         radix_sort_kernels,
+                         type_to_name(in),
+                         get_type_string(in.dtype()));
+    lib = d.get_library(lib_name, kernel_source.str());
+  }
+  return d.get_kernel(kernel_name, lib);
+}
+
+MTL::ComputePipelineState* get_radix_select_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& in,
+    const array& out,
+    bool arg_partition,
+    int bn) {
+  auto lib = d.get_library(kernel_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel_source;
+    kernel_source << metal::utils() << metal::sort()
+                  << fmt::format(
+                         radix_select_kernels,
+                         kernel_name,
+                         get_type_string(in.dtype()),
+                         get_type_string(out.dtype()),
+                         arg_partition,
+                         bn);
+    lib = d.get_library(kernel_name, kernel_source.str());
+  }
+  return d.get_kernel(kernel_name, lib);
+}
+
 MTL::ComputePipelineState* get_reduce_init_kernel(
     metal::Device& d,
     const std::string& kernel_name,
@@ -475,9 +599,123 @@ MTL::ComputePipelineState* get_steel_gemm_masked_kernel(
   return d.get_kernel(kernel_name, lib);
 }
 
+MTL::ComputePipelineState* get_steel_gemm_sparse_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& out,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn,
+    int max_rows) {
+  const auto& lib_name = kernel_name;
+  auto lib = d.get_library(lib_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel_source;
+    kernel_source << metal::utils() << metal::gemm()
+                  << metal::steel_gemm_sparse();
+    if (bm == 0) {
+      kernel_source << fmt::format(
+          steel_gemv_sparse_kernels,
+          "name"_a = lib_name,
+          "itype"_a = get_type_string(out.dtype()),
+          "max_rows"_a = max_rows);
+    } else {
+      kernel_source << fmt::format(
+          steel_gemm_sparse_kernels,
+          "name"_a = lib_name,
+          "itype"_a = get_type_string(out.dtype()),
+          "bm"_a = bm,
+          "bn"_a = bn,
+          "bk"_a = bk,
+          "wm"_a = wm,
+          "wn"_a = wn);
+    }
+    lib = d.get_library(lib_name, kernel_source.str());
+  }
+  return d.get_kernel(kernel_name, lib);
+}
+
+MTL::ComputePipelineState* get_steel_gemm_fp8_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& out,
+    bool e5m2,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn,
+    int max_rows) {
+  const auto& lib_name = kernel_name;
+  auto lib = d.get_library(lib_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel_source;
+    kernel_source << metal::utils() << metal::gemm()
+                  << metal::steel_gemm_fp8();
+    if (bm == 0) {
+      kernel_source << fmt::format(
+          steel_gemv_fp8_kernels,
+          "name"_a = lib_name,
+          "itype"_a = get_type_string(out.dtype()),
+          "max_rows"_a = max_rows,
+          "e5m2"_a = e5m2);
+    } else {
+      kernel_source << fmt::format(
+          steel_gemm_fp8_kernels,
+          "name"_a = lib_name,
+          "itype"_a = get_type_string(out.dtype()),
+          "bm"_a = bm,
+          "bn"_a = bn,
+          "bk"_a = bk,
+          "wm"_a = wm,
+          "wn"_a = wn,
+          "e5m2"_a = e5m2);
+    }
+    lib = d.get_library(lib_name, kernel_source.str());
+  }
+  return d.get_kernel(kernel_name, lib);
+}
+
+MTL::ComputePipelineState* get_steel_gemm_gather_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
+    const array& out,
+    bool transpose_b,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn) {
+  const auto& lib_name = kernel_name;
+  auto lib = d.get_library(lib_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel_source;
+    kernel_source << metal::utils() << metal::gemm()
+                  << metal::steel_gemm_gather()
+                  << fmt::format(
+                         steel_gemm_gather_kernels,
+                         "name"_a = lib_name,
+                         "itype"_a = get_type_string(out.dtype()),
+                         "bm"_a = bm,
+                         "bn"_a = bn,
+                         "bk"_a = bk,
+                         "wm"_a = wm,
+                         "wn"_a = wn,
+                         "trans_b"_a = transpose_b);
+    lib = d.get_library(lib_name, kernel_source.str());
+  }
+  return d.get_kernel(kernel_name, lib, hash_name, func_consts);
+}
+
 MTL::ComputePipelineState* get_steel_conv_kernel(
     metal::Device& d,
     const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
     const array& out,
     int bm,
     int bn,
@@ -504,12 +742,14 @@ MTL::ComputePipelineState* get_steel_conv_kernel(
                          "small_filter"_a = small_filter);
     lib = d.get_library(lib_name, kernel_source.str());
   }
-  return d.get_kernel(kernel_name, lib);
+  return d.get_kernel(kernel_name, lib, hash_name, func_consts);
 }
 
 MTL::ComputePipelineState* get_steel_conv_general_kernel(
     metal::Device& d,
     const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
     const array& out,
     int bm,
     int bn,
@@ -533,6 +773,37 @@ MTL::ComputePipelineState* get_steel_conv_general_kernel(
                          "wn"_a = wn);
     lib = d.get_library(lib_name, kernel_source.str());
   }
+  return d.get_kernel(kernel_name, lib, hash_name, func_consts);
+}
+
+MTL::ComputePipelineState* get_steel_conv_wgrad_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& in,
+    int ndim,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn) {
+  const auto& lib_name = kernel_name;
+  auto lib = d.get_library(lib_name);
+  if (lib == nullptr) {
+    std::ostringstream kernel_source;
+    kernel_source << metal::utils() << metal::conv()
+                  << metal::steel_conv_wgrad()
+                  << fmt::format(
+                         steel_conv_wgrad_kernels,
+                         "name"_a = lib_name,
+                         "itype"_a = get_type_string(in.dtype()),
+                         "ndim"_a = ndim,
+                         "bm"_a = bm,
+                         "bn"_a = bn,
+                         "bk"_a = bk,
+                         "wm"_a = wm,
+                         "wn"_a = wn);
+    lib = d.get_library(lib_name, kernel_source.str());
+  }
   return d.get_kernel(kernel_name, lib);
 }
 
@@ -556,7 +827,9 @@ MTL::ComputePipelineState* get_fft_kernel(
 MTL::ComputePipelineState* get_quantized_kernel(
     metal::Device& d,
     const std::string& kernel_name,
-    const std::string& template_def) {
+    const std::string& template_def,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts) {
   const auto& lib_name = kernel_name;
   auto lib = d.get_library(lib_name);
   if (lib == nullptr) {
@@ -565,7 +838,7 @@ MTL::ComputePipelineState* get_quantized_kernel(
                   << template_def;
     lib = d.get_library(lib_name, kernel_source.str());
   }
-  return d.get_kernel(kernel_name, lib);
+  return d.get_kernel(kernel_name, lib, hash_name, func_consts);
 }
 
 } // namespace mlx::core
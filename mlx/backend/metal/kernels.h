@@ -50,6 +50,11 @@ MTL::ComputePipelineState* get_softmax_kernel(
     bool precise,
     const array& out);
 
+MTL::ComputePipelineState* get_logsumexp_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& out);
+
 MTL::ComputePipelineState* get_scan_kernel(
     metal::Device& d,
     const std::string& kernel_name,
@@ -75,6 +80,19 @@ MTL::ComputePipelineState* get_mb_sort_kernel(
     int bn,
     int tn);
 
+MTL::ComputePipelineState* get_radix_sort_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& in);
+
+MTL::ComputePipelineState* get_radix_select_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& in,
+    const array& out,
+    bool arg_partition,
+    int bn);
+
 MTL::ComputePipelineState* get_reduce_init_kernel(
     metal::Device& d,
     const std::string& kernel_name,
@@ -139,9 +157,51 @@ MTL::ComputePipelineState* get_steel_gemm_masked_kernel(
     bool mn_aligned,
     bool k_aligned);
 
+MTL::ComputePipelineState* get_steel_gemm_gather_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
+    const array& out,
+    bool transpose_b,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn);
+
+// The 2:4 sparse kernels, a gemm with tiles bm x bn x bk and wm x wn
+// simdgroups, or a gemv for at most max_rows rows when bm is 0
+MTL::ComputePipelineState* get_steel_gemm_sparse_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& out,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn,
+    int max_rows);
+
+// The fp8 kernels, a gemm with tiles bm x bn x bk and wm x wn simdgroups, or
+// a gemv for at most max_rows rows when bm is 0
+MTL::ComputePipelineState* get_steel_gemm_fp8_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& out,
+    bool e5m2,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn,
+    int max_rows);
+
 MTL::ComputePipelineState* get_steel_conv_kernel(
     metal::Device& d,
     const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
     const array& out,
     int bm,
     int bn,
@@ -154,6 +214,8 @@ MTL::ComputePipelineState* get_steel_conv_kernel(
 MTL::ComputePipelineState* get_steel_conv_general_kernel(
     metal::Device& d,
     const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
     const array& out,
     int bm,
     int bn,
@@ -161,6 +223,17 @@ MTL::ComputePipelineState* get_steel_conv_general_kernel(
     int wm,
     int wn);
 
+MTL::ComputePipelineState* get_steel_conv_wgrad_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array& in,
+    int ndim,
+    int bm,
+    int bn,
+    int bk,
+    int wm,
+    int wn);
+
 MTL::ComputePipelineState* get_fft_kernel(
     metal::Device& d,
     const std::string& kernel_name,
@@ -171,7 +244,9 @@ MTL::ComputePipelineState* get_fft_kernel(
 MTL::ComputePipelineState* get_quantized_kernel(
     metal::Device& d,
     const std::string& kernel_name,
-    const std::string& template_def);
+    const std::string& template_def,
+    const std::string& hash_name = "",
+    const metal::MTLFCList& func_consts = {});
 
 // Create a GPU kernel template definition for JIT compilation
 template <typename... Args>
@@ -9,17 +9,25 @@
 #include "mlx/backend/metal/kernels/binary_ops.h"
 #include "mlx/backend/metal/kernels/binary.h"
 
-#define instantiate_binary_all(op, tname, itype, otype)                 \
-  instantiate_kernel("ss" #op #tname, binary_ss, itype, otype, op)      \
-  instantiate_kernel("sv" #op #tname, binary_sv, itype, otype, op)      \
-  instantiate_kernel("vs" #op #tname, binary_vs, itype, otype, op)      \
-  instantiate_kernel("vv" #op #tname, binary_vv, itype, otype, op)      \
-  instantiate_kernel("gn" #op #tname, binary_g, itype, otype, op)       \
-  instantiate_kernel("g1" #op #tname, binary_g_nd1, itype, otype, op)   \
-  instantiate_kernel("g2" #op #tname, binary_g_nd2, itype, otype, op)   \
-  instantiate_kernel("g3" #op #tname, binary_g_nd3, itype, otype, op)   \
-  instantiate_kernel("g4" #op #tname, binary_g_nd, itype, otype, op, 4) \
-  instantiate_kernel("g5" #op #tname, binary_g_nd,  itype, otype, op, 5)
+// The general kernels index with int or, for large arrays, int64_t
+#define instantiate_binary_general(op, tn, it, ot, lg, idx)             \
+  instantiate_kernel("gn" #lg #op #tn, binary_g, it, ot, op, idx)       \
+  instantiate_kernel("g1" #lg #op #tn, binary_g_nd1, it, ot, op, idx)   \
+  instantiate_kernel("g2" #lg #op #tn, binary_g_nd2, it, ot, op, idx)   \
+  instantiate_kernel("g3" #lg #op #tn, binary_g_nd3, it, ot, op, idx)   \
+  instantiate_kernel("g4" #lg #op #tn, binary_g_nd, it, ot, op, 4, idx) \
+  instantiate_kernel("g5" #lg #op #tn, binary_g_nd, it, ot, op, 5, idx)
+
+#define instantiate_binary_all(op, tname, itype, otype)              \
+  instantiate_kernel("ss" #op #tname, binary_ss, itype, otype, op)   \
+  instantiate_kernel("sv" #op #tname, binary_sv, itype, otype, op)   \
+  instantiate_kernel("vs" #op #tname, binary_vs, itype, otype, op)   \
+  instantiate_kernel("vv" #op #tname, binary_vv, itype, otype, op)   \
+  instantiate_kernel("svn" #op #tname, binary_svn, itype, otype, op) \
+  instantiate_kernel("vsn" #op #tname, binary_vsn, itype, otype, op) \
+  instantiate_kernel("vvn" #op #tname, binary_vvn, itype, otype, op) \
+  instantiate_binary_general(op, tname, itype, otype, , int)         \
+  instantiate_binary_general(op, tname, itype, otype, large, int64_t)
 
 #define instantiate_binary_integer(op)                   \
   instantiate_binary_all(op, uint8, uint8_t, uint8_t)    \
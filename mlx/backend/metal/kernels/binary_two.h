@@ -48,7 +48,82 @@ template <typename T, typename U, typename Op>
   d[index] = out[1];
 }
 
-template <typename T, typename U, typename Op>
+// The n variants write N consecutive elements per thread. Large arrays
+// then need a fraction of the threads and the compiler can vectorize
+// the loads and stores of the unrolled loop.
+template <typename T, typename U, typename Op, int N = ELEMWISE_N_WRITES>
+[[kernel]] void binary_svn(
+    device const T* a,
+    device const T* b,
+    device U* c,
+    device U* d,
+    constant const size_t& size,
+    uint index [[thread_position_in_grid]]) {
+  size_t offset = size_t(index) * N;
+  if (offset + N <= size) {
+    for (int i = 0; i < N; i++) {
+      auto out = Op()(a[0], b[offset + i]);
+      c[offset + i] = out[0];
+      d[offset + i] = out[1];
+    }
+  } else {
+    for (size_t i = offset; i < size; i++) {
+      auto out = Op()(a[0], b[i]);
+      c[i] = out[0];
+      d[i] = out[1];
+    }
+  }
+}
+
+template <typename T, typename U, typename Op, int N = ELEMWISE_N_WRITES>
+[[kernel]] void binary_vsn(
+    device const T* a,
+    device const T* b,
+    device U* c,
+    device U* d,
+    constant const size_t& size,
+    uint index [[thread_position_in_grid]]) {
+  size_t offset = size_t(index) * N;
+  if (offset + N <= size) {
+    for (int i = 0; i < N; i++) {
+      auto out = Op()(a[offset + i], b[0]);
+      c[offset + i] = out[0];
+      d[offset + i] = out[1];
+    }
+  } else {
+    for (size_t i = offset; i < size; i++) {
+      auto out = Op()(a[i], b[0]);
+      c[i] = out[0];
+      d[i] = out[1];
+    }
+  }
+}
+
+template <typename T, typename U, typename Op, int N = ELEMWISE_N_WRITES>
+[[kernel]] void binary_vvn(
+    device const T* a,
+    device const T* b,
+    device U* c,
+    device U* d,
+    constant const size_t& size,
+    uint index [[thread_position_in_grid]]) {
+  size_t offset = size_t(index) * N;
+  if (offset + N <= size) {
+    for (int i = 0; i < N; i++) {
+      auto out = Op()(a[offset + i], b[offset + i]);
+      c[offset + i] = out[0];
+      d[offset + i] = out[1];
+    }
+  } else {
+    for (size_t i = offset; i < size; i++) {
+      auto out = Op()(a[i], b[i]);
+      c[i] = out[0];
+      d[i] = out[1];
+    }
+  }
+}
+
+template <typename T, typename U, typename Op, typename IdxT = int64_t>
 [[kernel]] void binary_g_nd1(
     device const T* a,
     device const T* b,
@@ -57,14 +132,14 @@ template <typename T, typename U, typename Op>
     constant const size_t& a_stride,
     constant const size_t& b_stride,
     uint index [[thread_position_in_grid]]) {
-  auto a_idx = elem_to_loc_1(index, a_stride);
-  auto b_idx = elem_to_loc_1(index, b_stride);
+  auto a_idx = elem_to_loc_1<size_t, IdxT>(index, a_stride);
+  auto b_idx = elem_to_loc_1<size_t, IdxT>(index, b_stride);
   auto out = Op()(a[a_idx], b[b_idx]);
   c[index] = out[0];
   d[index] = out[1];
 }
 
-template <typename T, typename U, typename Op>
+template <typename T, typename U, typename Op, typename IdxT = int64_t>
 [[kernel]] void binary_g_nd2(
     device const T* a,
     device const T* b,
@@ -74,15 +149,15 @@ template <typename T, typename U, typename Op>
     constant const size_t b_strides[2],
     uint2 index [[thread_position_in_grid]],
     uint2 grid_dim [[threads_per_grid]]) {
-  auto a_idx = elem_to_loc_2(index, a_strides);
-  auto b_idx = elem_to_loc_2(index, b_strides);
-  size_t out_idx = index.x + (size_t)grid_dim.x * index.y;
+  auto a_idx = elem_to_loc_2<size_t, IdxT>(index, a_strides);
+  auto b_idx = elem_to_loc_2<size_t, IdxT>(index, b_strides);
+  IdxT out_idx = index.x + IdxT(grid_dim.x) * index.y;
   auto out = Op()(a[a_idx], b[b_idx]);
   c[out_idx] = out[0];
   d[out_idx] = out[1];
 }
 
-template <typename T, typename U, typename Op>
+template <typename T, typename U, typename Op, typename IdxT = int64_t>
 [[kernel]] void binary_g_nd3(
     device const T* a,
     device const T* b,
@@ -92,16 +167,25 @@ template <typename T, typename U, typename Op>
     constant const size_t b_strides[3],
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto a_idx = elem_to_loc_3(index, a_strides);
-  auto b_idx = elem_to_loc_3(index, b_strides);
-  size_t out_idx =
-      index.x + (size_t)grid_dim.x * (index.y + (size_t)grid_dim.y * index.z);
+  auto a_idx = elem_to_loc_3<size_t, IdxT>(index, a_strides);
+  auto b_idx = elem_to_loc_3<size_t, IdxT>(index, b_strides);
+  IdxT out_idx =
+      index.x + IdxT(grid_dim.x) * (index.y + IdxT(grid_dim.y) * index.z);
   auto out = Op()(a[a_idx], b[b_idx]);
   c[out_idx] = out[0];
   d[out_idx] = out[1];
 }
 
-template <typename T, typename U, typename Op, int DIM>
+// With more than 3 dims the location of the outer dims takes divisions so
+// each thread handles N elements of the inner dim for a single location
+// computation.
+template <
+    typename T,
+    typename U,
+    typename Op,
+    int DIM,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void binary_g_nd(
     device const T* a,
     device const T* b,
@@ -112,15 +196,28 @@ template <typename T, typename U, typename Op, int DIM>
     constant const size_t b_strides[DIM],
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto idx = elem_to_loc_2_nd<DIM>(index, shape, a_strides, b_strides);
-  size_t out_idx =
-      index.x + (size_t)grid_dim.x * (index.y + (size_t)grid_dim.y * index.z);
-  auto out = Op()(a[idx.x], b[idx.y]);
-  c[out_idx] = out[0];
-  d[out_idx] = out[1];
+  auto idx = elem_to_loc_2_nd<DIM, IdxT>(
+      uint3(N * index.x, index.y, index.z), shape, a_strides, b_strides);
+  int xshape = shape[DIM - 1];
+  IdxT out_idx = N * index.x +
+      IdxT(xshape) * (index.y + IdxT(grid_dim.y) * index.z);
+  IdxT a_xstride = a_strides[DIM - 1];
+  IdxT b_xstride = b_strides[DIM - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    auto out = Op()(a[idx.x], b[idx.y]);
+    c[out_idx] = out[0];
+    d[out_idx++] = out[1];
+    idx.x += a_xstride;
+    idx.y += b_xstride;
+  }
 }
 
-template <typename T, typename U, typename Op>
+template <
+    typename T,
+    typename U,
+    typename Op,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void binary_g(
     device const T* a,
     device const T* b,
@@ -132,9 +229,18 @@ template <typename T, typename U, typename Op>
     constant const int& ndim,
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto idx = elem_to_loc_2_nd(index, shape, a_strides, b_strides, ndim);
-  size_t out_idx = index.x + grid_dim.x * (index.y + grid_dim.y * index.z);
-  auto out = Op()(a[idx.x], b[idx.y]);
-  c[out_idx] = out[0];
-  d[out_idx] = out[1];
+  auto idx = elem_to_loc_2_nd<IdxT>(
+      uint3(N * index.x, index.y, index.z), shape, a_strides, b_strides, ndim);
+  int xshape = shape[ndim - 1];
+  IdxT out_idx = N * index.x +
+      IdxT(xshape) * (index.y + IdxT(grid_dim.y) * index.z);
+  IdxT a_xstride = a_strides[ndim - 1];
+  IdxT b_xstride = b_strides[ndim - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    auto out = Op()(a[idx.x], b[idx.y]);
+    c[out_idx] = out[0];
+    d[out_idx++] = out[1];
+    idx.x += a_xstride;
+    idx.y += b_xstride;
+  }
 }
@@ -5,11 +5,13 @@
 #include <metal_stdlib>
 
 #include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/steel/conv/epilogue.h"
 #include "mlx/backend/metal/kernels/steel/conv/params.h"
 
 #define MLX_MTL_CONST static constant constexpr const
 
 using namespace metal;
+using namespace mlx::steel;
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Naive unfold with dilation
@@ -166,6 +168,111 @@ instantiate_naive_unfold_nd_dims(float32, float);
 instantiate_naive_unfold_nd_dims(float16, half);
 instantiate_naive_unfold_nd_dims(bfloat16, bfloat16_t);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Depthwise conv2d kernels
+///////////////////////////////////////////////////////////////////////////////
+
+// Each input channel is convolved with its own filter (groups == C == O).
+// One thread computes one output element and threads are laid out along the
+// channels so that reads and writes are contiguous across a simdgroup.
+template <typename T>
+[[kernel]] void depthwise_conv_2d(
+    const device T* in [[buffer(0)]],
+    const device T* wt [[buffer(1)]],
+    device T* out [[buffer(2)]],
+    const constant MLXConvParams<2>& params [[buffer(3)]],
+    const device T* bias [[buffer(4), function_constant(conv_has_bias)]],
+    uint3 gid [[thread_position_in_grid]]) {
+  // gid.z: N oH (Batch and output row)
+  // gid.y: oW (Output column)
+  // gid.x: C (channel)
+  const int n = gid.z / params.oS[0];
+  const int oh = gid.z % params.oS[0];
+  const int ow = gid.y;
+  const int c = gid.x;
+
+  if (c >= params.C || ow >= params.oS[1] || n >= params.N) {
+    return;
+  }
+
+  in += n * params.in_strides[0] + c;
+  wt += c * params.wt_strides[0];
+  out += n * params.out_strides[0] + oh * params.out_strides[1] +
+      ow * params.out_strides[2] + c;
+
+  const int ih_base = oh * params.str[0] - params.pad[0];
+  const int iw_base = ow * params.str[1] - params.pad[1];
+
+  float acc = 0;
+  for (int i = 0; i < params.wS[0]; ++i) {
+    const int ih = ih_base + i * params.kdil[0];
+    if (ih < 0 || ih >= params.iS[0]) {
+      continue;
+    }
+    const int wh = params.flip ? params.wS[0] - i - 1 : i;
+    for (int j = 0; j < params.wS[1]; ++j) {
+      const int iw = iw_base + j * params.kdil[1];
+      if (iw < 0 || iw >= params.iS[1]) {
+        continue;
+      }
+      const int ww = params.flip ? params.wS[1] - j - 1 : j;
+      acc += static_cast<float>(
+                 in[ih * params.in_strides[1] + iw * params.in_strides[2]]) *
+          static_cast<float>(
+                 wt[wh * params.wt_strides[1] + ww * params.wt_strides[2]]);
+    }
+  }
+
+  out[0] = static_cast<T>(ConvEpilogue<T>::apply(acc, bias, c));
+}
+
+// clang-format off
+#define instantiate_depthwise_conv_2d(name, itype)                              \
+  template [[host_name("depthwise_conv_2d_" #name)]] [[kernel]] void            \
+  depthwise_conv_2d<itype>(                                                     \
+      const device itype* in [[buffer(0)]],                                     \
+      const device itype* wt [[buffer(1)]],                                     \
+      device itype* out [[buffer(2)]],                                          \
+      const constant MLXConvParams<2>& params [[buffer(3)]],                    \
+      const device itype* bias [[buffer(4), function_constant(conv_has_bias)]], \
+      uint3 gid [[thread_position_in_grid]]);
+
+instantiate_depthwise_conv_2d(float32, float);
+instantiate_depthwise_conv_2d(float16, half);
+instantiate_depthwise_conv_2d(bfloat16, bfloat16_t); // clang-format on
+
+///////////////////////////////////////////////////////////////////////////////
+/// Conv epilogue
+///////////////////////////////////////////////////////////////////////////////
+
+// Applies the bias and activation in place for the conv paths that do not
+// fuse them in their own epilogue.
+template <typename T>
+[[kernel]] void conv_epilogue(
+    device T* out [[buffer(0)]],
+    const device T* bias [[buffer(1), function_constant(conv_has_bias)]],
+    const constant int& O [[buffer(2)]],
+    uint2 gid [[thread_position_in_grid]]) {
+  // gid.y: N oS (Batch and output position)
+  // gid.x: O (Output channel)
+  size_t offset = gid.y * size_t(O) + gid.x;
+  out[offset] = static_cast<T>(
+      ConvEpilogue<T>::apply(static_cast<float>(out[offset]), bias, gid.x));
+}
+
+// clang-format off
+#define instantiate_conv_epilogue(name, itype)                                  \
+  template [[host_name("conv_epilogue_" #name)]] [[kernel]] void                \
+  conv_epilogue<itype>(                                                         \
+      device itype* out [[buffer(0)]],                                          \
+      const device itype* bias [[buffer(1), function_constant(conv_has_bias)]], \
+      const constant int& O [[buffer(2)]],                                      \
+      uint2 gid [[thread_position_in_grid]]);
+
+instantiate_conv_epilogue(float32, float);
+instantiate_conv_epilogue(float16, half);
+instantiate_conv_epilogue(bfloat16, bfloat16_t); // clang-format on
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Slow and naive conv2d kernels
 ///////////////////////////////////////////////////////////////////////////////
@@ -279,6 +386,10 @@ instantiate_naive_conv_2d_blocks(bfloat16, bfloat16_t);
 /// Winograd kernels
 ///////////////////////////////////////////////////////////////////////////////
 
+// The transforms of Winograd F(M x M, R x R) with tiles of A = M + R - 1
+// inputs, padded with zeros to the 8 x 8 simdgroup matrices. With d an input
+// tile, g a filter and y the output tile, in_transform is B, wt_transform G
+// and out_transform A of y = A^T [(G g G^T) * (B^T d B)] A.
 template <int M, int R, int S>
 struct WinogradTransforms {};
 
@@ -322,11 +433,89 @@ struct WinogradTransforms<6, 3, 8> {
   };
 };
 
+// Smaller tiles with better accuracy in half precision, and less waste on
+// small images
+template <>
+struct WinogradTransforms<4, 3, 8> {
+  MLX_MTL_CONST int OUT_TILE_SIZE = 4;
+  MLX_MTL_CONST int FILTER_SIZE = 3;
+  MLX_MTL_CONST int IN_TILE_SIZE = OUT_TILE_SIZE + FILTER_SIZE - 1;
+  MLX_MTL_CONST int SIMD_MATRIX_SIZE = 8;
+  MLX_MTL_CONST float in_transform[SIMD_MATRIX_SIZE][SIMD_MATRIX_SIZE] = {
+      {4.00f, 0.00f, 0.00f, 0.00f, 0.00f, 0.00f},
+      {0.00f, -4.00f, 4.00f, -2.00f, 2.00f, 4.00f},
+      {-5.00f, -4.00f, -4.00f, -1.00f, -1.00f, 0.00f},
+      {0.00f, 1.00f, -1.00f, 2.00f, -2.00f, -5.00f},
+      {1.00f, 1.00f, 1.00f, 1.00f, 1.00f, 0.00f},
+      {0.00f, 0.00f, 0.00f, 0.00f, 0.00f, 1.00f},
+  };
+
+  MLX_MTL_CONST float out_transform[SIMD_MATRIX_SIZE][SIMD_MATRIX_SIZE] = {
+      {1.00f, 0.00f, 0.00f, 0.00f},
+      {1.00f, 1.00f, 1.00f, 1.00f},
+      {1.00f, -1.00f, 1.00f, -1.00f},
+      {1.00f, 2.00f, 4.00f, 8.00f},
+      {1.00f, -2.00f, 4.00f, -8.00f},
+      {0.00f, 0.00f, 0.00f, 1.00f},
+  };
+
+  MLX_MTL_CONST float wt_transform[SIMD_MATRIX_SIZE][SIMD_MATRIX_SIZE] = {
+      {1.0 / 4.0, 0.00, 0.00},
+      {-1.0 / 6.0, -1.0 / 6.0, -1.0 / 6.0},
+      {-1.0 / 6.0, 1.0 / 6.0, -1.0 / 6.0},
+      {1.0 / 24.0, 1.0 / 12.0, 1.0 / 6.0},
+      {1.0 / 24.0, -1.0 / 12.0, 1.0 / 6.0},
+      {0.00, 0.00, 1.00},
+  };
+};
+
+template <>
+struct WinogradTransforms<2, 5, 8> {
+  MLX_MTL_CONST int OUT_TILE_SIZE = 2;
+  MLX_MTL_CONST int FILTER_SIZE = 5;
+  MLX_MTL_CONST int IN_TILE_SIZE = OUT_TILE_SIZE + FILTER_SIZE - 1;
+  MLX_MTL_CONST int SIMD_MATRIX_SIZE = 8;
+  MLX_MTL_CONST float in_transform[SIMD_MATRIX_SIZE][SIMD_MATRIX_SIZE] = {
+      {4.00f, 0.00f, 0.00f, 0.00f, 0.00f, 0.00f},
+      {0.00f, -4.00f, 4.00f, -2.00f, 2.00f, 4.00f},
+      {-5.00f, -4.00f, -4.00f, -1.00f, -1.00f, 0.00f},
+      {0.00f, 1.00f, -1.00f, 2.00f, -2.00f, -5.00f},
+      {1.00f, 1.00f, 1.00f, 1.00f, 1.00f, 0.00f},
+      {0.00f, 0.00f, 0.00f, 0.00f, 0.00f, 1.00f},
+  };
+
+  MLX_MTL_CONST float out_transform[SIMD_MATRIX_SIZE][SIMD_MATRIX_SIZE] = {
+      {1.00f, 0.00f},
+      {1.00f, 1.00f},
+      {1.00f, -1.00f},
+      {1.00f, 2.00f},
+      {1.00f, -2.00f},
+      {0.00f, 1.00f},
+  };
+
+  MLX_MTL_CONST float wt_transform[SIMD_MATRIX_SIZE][SIMD_MATRIX_SIZE] = {
+      {1.0 / 4.0, 0.00, 0.00, 0.00, 0.00},
+      {-1.0 / 6.0, -1.0 / 6.0, -1.0 / 6.0, -1.0 / 6.0, -1.0 / 6.0},
+      {-1.0 / 6.0, 1.0 / 6.0, -1.0 / 6.0, 1.0 / 6.0, -1.0 / 6.0},
+      {1.0 / 24.0, 1.0 / 12.0, 1.0 / 6.0, 1.0 / 3.0, 2.0 / 3.0},
+      {1.0 / 24.0, -1.0 / 12.0, 1.0 / 6.0, -1.0 / 3.0, 2.0 / 3.0},
+      {0.00, 0.00, 0.00, 0.00, 1.00},
+  };
+};
+
 constant constexpr const float WinogradTransforms<6, 3, 8>::wt_transform[8][8];
 constant constexpr const float WinogradTransforms<6, 3, 8>::in_transform[8][8];
 constant constexpr const float WinogradTransforms<6, 3, 8>::out_transform[8][8];
-
-template <typename T, int BC = 32, int BO = 4, int M = 6, int R = 3>
+constant constexpr const float WinogradTransforms<4, 3, 8>::wt_transform[8][8];
+constant constexpr const float WinogradTransforms<4, 3, 8>::in_transform[8][8];
+constant constexpr const float WinogradTransforms<4, 3, 8>::out_transform[8][8];
+constant constexpr const float WinogradTransforms<2, 5, 8>::wt_transform[8][8];
+constant constexpr const float WinogradTransforms<2, 5, 8>::in_transform[8][8];
+constant constexpr const float WinogradTransforms<2, 5, 8>::out_transform[8][8];
+
+// The transforms run on simdgroup matrices of U, float for bfloat16 which
+// has none. The transformed tiles are stored for the A x A positions only.
+template <typename T, typename U, int BC, int BO, int M, int R>
 [[kernel, max_total_threads_per_threadgroup(BO * 32)]] void
 winograd_conv_2d_weight_transform(
     const device T* wt_in [[buffer(0)]],
@@ -337,6 +526,7 @@ winograd_conv_2d_weight_transform(
     uint simd_group_id [[simdgroup_index_in_threadgroup]],
     uint simd_lane_id [[thread_index_in_simdgroup]]) {
   using WGT = WinogradTransforms<M, R, 8>;
+  constexpr int A = WGT::IN_TILE_SIZE;
 
   // Get lane position in simdgroup
   const short qid = simd_lane_id / 4;
@@ -344,12 +534,12 @@ winograd_conv_2d_weight_transform(
   const short sn = (qid & 2) * 2 + (simd_lane_id % 2) * 2;
 
   // Initialize G matrix
-  simdgroup_matrix<T, 8, 8> G;
+  simdgroup_matrix<U, 8, 8> G;
   G.thread_elements()[0] = WGT::wt_transform[sm][sn];
   G.thread_elements()[1] = WGT::wt_transform[sm][sn + 1];
 
   // Initialize Gt matrix
-  simdgroup_matrix<T, 8, 8> Gt;
+  simdgroup_matrix<U, 8, 8> Gt;
   Gt.thread_elements()[0] = WGT::wt_transform[sn][sm];
   Gt.thread_elements()[1] = WGT::wt_transform[sn + 1][sm];
 
@@ -358,10 +548,10 @@ winograd_conv_2d_weight_transform(
   wt_in += ko * R * R * C;
 
   // wt_out is stored transposed (A x A x C x O)
-  short ohw_0 = sm * 8 + sn;
-  short ohw_1 = sm * 8 + sn + 1;
-  device T* wt_out_0 = wt_out + ohw_0 * C * O + ko;
-  device T* wt_out_1 = wt_out + ohw_1 * C * O + ko;
+  const bool valid_0 = sm < A && sn < A;
+  const bool valid_1 = sm < A && sn + 1 < A;
+  device T* wt_out_0 = wt_out + (sm * A + sn) * C * O + ko;
+  device T* wt_out_1 = wt_out_0 + C * O;
 
   // Prepare shared memory
   threadgroup T Ws[BO][R][R][BC];
@@ -381,15 +571,19 @@ winograd_conv_2d_weight_transform(
     threadgroup_barrier(mem_flags::mem_threadgroup);
     // Do transform and store the result
     for (int c = 0; c < BC; ++c) {
-      simdgroup_matrix<T, 8, 8> g;
+      simdgroup_matrix<U, 8, 8> g;
       g.thread_elements()[0] =
-          sm < R && sn < R ? Ws[simd_group_id][sm][sn][c] : T(0);
+          sm < R && sn < R ? U(Ws[simd_group_id][sm][sn][c]) : U(0);
       g.thread_elements()[1] =
-          sm < R && sn + 1 < R ? Ws[simd_group_id][sm][sn + 1][c] : T(0);
+          sm < R && sn + 1 < R ? U(Ws[simd_group_id][sm][sn + 1][c]) : U(0);
 
-      simdgroup_matrix<T, 8, 8> g_out = (G * g) * Gt;
-      wt_out_0[c * O] = g_out.thread_elements()[0];
-      wt_out_1[c * O] = g_out.thread_elements()[1];
+      simdgroup_matrix<U, 8, 8> g_out = (G * g) * Gt;
+      if (valid_0) {
+        wt_out_0[c * O] = static_cast<T>(g_out.thread_elements()[0]);
+      }
+      if (valid_1) {
+        wt_out_1[c * O] = static_cast<T>(g_out.thread_elements()[1]);
+      }
     }
 
     wt_in += BC;
@@ -398,19 +592,22 @@ winograd_conv_2d_weight_transform(
   }
 }
 
-#define instantiate_winograd_conv_2d_weight_transform_base(name, itype, bc) \
-  template [[host_name("winograd_conv_2d_weight_transform_" #name           \
-                       "_bc" #bc)]] [[kernel]] void                         \
-  winograd_conv_2d_weight_transform<itype, bc>(                             \
-      const device itype* wt_in [[buffer(0)]],                              \
-      device itype* wt_out [[buffer(1)]],                                   \
-      const constant int& C [[buffer(2)]],                                  \
-      const constant int& O [[buffer(3)]],                                  \
-      uint tid [[threadgroup_position_in_grid]],                            \
-      uint simd_group_id [[simdgroup_index_in_threadgroup]],                \
-      uint simd_lane_id [[thread_index_in_simdgroup]]);
-
-template <typename T, int BC, int WM, int WN, int M = 6, int R = 3>
+// clang-format off
+#define instantiate_winograd_conv_2d_weight_transform_base(name, itype, utype, bc, m, r) \
+  template [[host_name("winograd_conv_2d_weight_transform_" #name                       \
+                       "_m" #m "_r" #r "_bc" #bc)]] [[kernel]] void                     \
+  winograd_conv_2d_weight_transform<itype, utype, bc, 4, m, r>(                         \
+      const device itype* wt_in [[buffer(0)]],                                          \
+      device itype* wt_out [[buffer(1)]],                                               \
+      const constant int& C [[buffer(2)]],                                              \
+      const constant int& O [[buffer(3)]],                                              \
+      uint tid [[threadgroup_position_in_grid]],                                        \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],                            \
+      uint simd_lane_id [[thread_index_in_simdgroup]]); // clang-format on
+
+// Transforms the input tiles, reading the padding and the pixels past the
+// edges of the input as zeros so the input isn't padded beforehand
+template <typename T, typename U, int BC, int WM, int WN, int M, int R>
 [[kernel, max_total_threads_per_threadgroup(WM* WN * 32)]] void
 winograd_conv_2d_input_transform(
     const device T* inp_in [[buffer(0)]],
@@ -433,12 +630,12 @@ winograd_conv_2d_input_transform(
   const short sn = (qid & 2) * 2 + (simd_lane_id % 2) * 2;
 
   // Initialize B matrix
-  simdgroup_matrix<T, 8, 8> B;
+  simdgroup_matrix<U, 8, 8> B;
   B.thread_elements()[0] = WGT::in_transform[sm][sn];
   B.thread_elements()[1] = WGT::in_transform[sm][sn + 1];
 
   // Initialize Bt matrix
-  simdgroup_matrix<T, 8, 8> Bt;
+  simdgroup_matrix<U, 8, 8> Bt;
   Bt.thread_elements()[0] = WGT::in_transform[sn][sm];
   Bt.thread_elements()[1] = WGT::in_transform[sn + 1][sm];
 
@@ -447,32 +644,35 @@ winograd_conv_2d_input_transform(
   constexpr int TW = (A / WN);
   int kh = TH * (simd_group_id / WN);
   int kw = TW * (simd_group_id % WN);
-  int bh = M * tid.y + kh;
-  int bw = M * tid.x + kw;
+  int bh = M * tid.y + kh - params.pad[0];
+  int bw = M * tid.x + kw - params.pad[1];
 
-  // Move to the correct input tile
-  inp_in += tid.z * params.in_strides[0] + bh * params.in_strides[1] +
-      bw * params.in_strides[2];
+  // Move to the correct batch element
+  inp_in += tid.z * params.in_strides[0];
 
   // Pre compute strides
   int jump_in[TH][TW];
 
   for (int h = 0; h < TH; h++) {
     for (int w = 0; w < TW; w++) {
-      jump_in[h][w] = h * params.in_strides[1] + w * params.in_strides[2];
+      bool valid = (bh + h) >= 0 && (bh + h) < params.iS[0] &&
+          (bw + w) >= 0 && (bw + w) < params.iS[1];
+      jump_in[h][w] = valid
+          ? (bh + h) * params.in_strides[1] + (bw + w) * params.in_strides[2]
+          : -1;
     }
   }
 
   // inp_out is stored interleaved (A x A x tiles x C)
+  const bool valid_0 = sm < A && sn < A;
+  const bool valid_1 = sm < A && sn + 1 < A;
   size_t N_TILES = tgp_per_grid.x * tgp_per_grid.y * tgp_per_grid.z;
   size_t tile_id =
       tid.z * tgp_per_grid.x * tgp_per_grid.y + tid.y * tgp_per_grid.x + tid.x;
-  size_t ohw_0 = sm * 8 + sn;
-  size_t ohw_1 = sm * 8 + sn + 1;
+  size_t ohw_0 = sm * A + sn;
   device T* inp_out_0 =
       inp_out + ohw_0 * N_TILES * params.C + tile_id * params.C;
-  device T* inp_out_1 =
-      inp_out + ohw_1 * N_TILES * params.C + tile_id * params.C;
+  device T* inp_out_1 = inp_out_0 + N_TILES * params.C;
 
   // Prepare shared memory
   threadgroup T Is[A][A][BC];
@@ -485,7 +685,7 @@ winograd_conv_2d_input_transform(
       for (int w = 0; w < TW; w++) {
         const device T* in_ptr = inp_in + jump_in[h][w];
         for (int c = simd_lane_id; c < BC; c += 32) {
-          Is[kh + h][kw + w][c] = in_ptr[c];
+          Is[kh + h][kw + w][c] = jump_in[h][w] >= 0 ? in_ptr[c] : T(0);
         }
       }
     }
@@ -493,13 +693,17 @@ winograd_conv_2d_input_transform(
     threadgroup_barrier(mem_flags::mem_threadgroup);
     // Do transform and store the result
     for (int c = simd_group_id; c < BC; c += N_SIMD_GROUPS) {
-      simdgroup_matrix<T, 8, 8> I;
-      I.thread_elements()[0] = Is[sm][sn][c];
-      I.thread_elements()[1] = Is[sm][sn + 1][c];
+      simdgroup_matrix<U, 8, 8> I;
+      I.thread_elements()[0] = valid_0 ? U(Is[sm][sn][c]) : U(0);
+      I.thread_elements()[1] = valid_1 ? U(Is[sm][sn + 1][c]) : U(0);
 
-      simdgroup_matrix<T, 8, 8> I_out = (Bt * I) * B;
-      inp_out_0[c] = I_out.thread_elements()[0];
-      inp_out_1[c] = I_out.thread_elements()[1];
+      simdgroup_matrix<U, 8, 8> I_out = (Bt * I) * B;
+      if (valid_0) {
+        inp_out_0[c] = static_cast<T>(I_out.thread_elements()[0]);
+      }
+      if (valid_1) {
+        inp_out_1[c] = static_cast<T>(I_out.thread_elements()[1]);
+      }
     }
 
     inp_in += BC;
@@ -508,25 +712,29 @@ winograd_conv_2d_input_transform(
   }
 }
 
-#define instantiate_winograd_conv_2d_input_transform(name, itype, bc) \
-  template [[host_name("winograd_conv_2d_input_transform_" #name      \
-                       "_bc" #bc)]] [[kernel]] void                   \
-  winograd_conv_2d_input_transform<itype, bc, 2, 2>(                  \
-      const device itype* inp_in [[buffer(0)]],                       \
-      device itype* inp_out [[buffer(1)]],                            \
-      const constant MLXConvParams<2>& params [[buffer(2)]],          \
-      uint3 tid [[threadgroup_position_in_grid]],                     \
-      uint3 lid [[thread_position_in_threadgroup]],                   \
-      uint3 tgp_per_grid [[threadgroups_per_grid]],                   \
-      uint simd_group_id [[simdgroup_index_in_threadgroup]],          \
-      uint simd_lane_id [[thread_index_in_simdgroup]]);
-
-template <typename T, int BO, int WM, int WN, int M = 6, int R = 3>
+// clang-format off
+#define instantiate_winograd_conv_2d_input_transform(name, itype, utype, bc, m, r) \
+  template [[host_name("winograd_conv_2d_input_transform_" #name                  \
+                       "_m" #m "_r" #r "_bc" #bc)]] [[kernel]] void                \
+  winograd_conv_2d_input_transform<itype, utype, bc, 2, 2, m, r>(                  \
+      const device itype* inp_in [[buffer(0)]],                                    \
+      device itype* inp_out [[buffer(1)]],                                         \
+      const constant MLXConvParams<2>& params [[buffer(2)]],                       \
+      uint3 tid [[threadgroup_position_in_grid]],                                  \
+      uint3 lid [[thread_position_in_threadgroup]],                                \
+      uint3 tgp_per_grid [[threadgroups_per_grid]],                                \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],                       \
+      uint simd_lane_id [[thread_index_in_simdgroup]]); // clang-format on
+
+// Transforms the output tiles and applies the conv epilogue before writing
+// them out
+template <typename T, typename U, int BO, int WM, int WN, int M, int R>
 [[kernel, max_total_threads_per_threadgroup(WM* WN * 32)]] void
 winograd_conv_2d_output_transform(
     const device T* out_in [[buffer(0)]],
     device T* out_out [[buffer(1)]],
     const constant MLXConvParams<2>& params [[buffer(2)]],
+    const device T* bias [[buffer(3), function_constant(conv_has_bias)]],
     uint3 tid [[threadgroup_position_in_grid]],
     uint3 lid [[thread_position_in_threadgroup]],
     uint3 tgp_per_grid [[threadgroups_per_grid]],
@@ -535,6 +743,7 @@ winograd_conv_2d_output_transform(
   (void)lid;
 
   using WGT = WinogradTransforms<M, R, 8>;
+  constexpr int A = WGT::IN_TILE_SIZE;
   constexpr int N_SIMD_GROUPS = WM * WN;
 
   // Get lane position in simdgroup
@@ -543,12 +752,12 @@ winograd_conv_2d_output_transform(
   const short sn = (qid & 2) * 2 + (simd_lane_id % 2) * 2;
 
   // Initialize A matrix
-  simdgroup_matrix<T, 8, 8> B;
+  simdgroup_matrix<U, 8, 8> B;
   B.thread_elements()[0] = WGT::out_transform[sm][sn];
   B.thread_elements()[1] = WGT::out_transform[sm][sn + 1];
 
   // Initialize At matrix
-  simdgroup_matrix<T, 8, 8> Bt;
+  simdgroup_matrix<U, 8, 8> Bt;
   Bt.thread_elements()[0] = WGT::out_transform[sn][sm];
   Bt.thread_elements()[1] = WGT::out_transform[sn + 1][sm];
 
@@ -579,15 +788,15 @@ winograd_conv_2d_output_transform(
   }
 
   // out_in is stored interleaved (A x A x tiles x O)
+  const bool valid_0 = sm < A && sn < A;
+  const bool valid_1 = sm < A && sn + 1 < A;
   size_t N_TILES = tgp_per_grid.x * tgp_per_grid.y * tgp_per_grid.z;
   size_t tile_id =
       tid.z * tgp_per_grid.x * tgp_per_grid.y + tid.y * tgp_per_grid.x + tid.x;
-  size_t ohw_0 = sm * 8 + sn;
-  size_t ohw_1 = sm * 8 + sn + 1;
+  size_t ohw_0 = sm * A + sn;
   const device T* out_in_0 =
       out_in + ohw_0 * N_TILES * params.O + tile_id * params.O;
-  const device T* out_in_1 =
-      out_in + ohw_1 * N_TILES * params.O + tile_id * params.O;
+  const device T* out_in_1 = out_in_0 + N_TILES * params.O;
 
   // Prepare shared memory
   threadgroup T Os[M][M][BO];
@@ -597,16 +806,16 @@ winograd_conv_2d_output_transform(
     threadgroup_barrier(mem_flags::mem_threadgroup);
     // Do transform and store the result
     for (int c = simd_group_id; c < BO; c += N_SIMD_GROUPS) {
-      simdgroup_matrix<T, 8, 8> O_mat;
-      O_mat.thread_elements()[0] = out_in_0[c];
-      O_mat.thread_elements()[1] = out_in_1[c];
+      simdgroup_matrix<U, 8, 8> O_mat;
+      O_mat.thread_elements()[0] = valid_0 ? U(out_in_0[c]) : U(0);
+      O_mat.thread_elements()[1] = valid_1 ? U(out_in_1[c]) : U(0);
 
-      simdgroup_matrix<T, 8, 8> O_out = (Bt * (O_mat * B));
+      simdgroup_matrix<U, 8, 8> O_out = (Bt * (O_mat * B));
       if ((sm < M) && (sn < M)) {
-        Os[sm][sn][c] = O_out.thread_elements()[0];
+        Os[sm][sn][c] = static_cast<T>(O_out.thread_elements()[0]);
       }
       if ((sm < M) && ((sn + 1) < M)) {
-        Os[sm][sn + 1][c] = O_out.thread_elements()[1];
+        Os[sm][sn + 1][c] = static_cast<T>(O_out.thread_elements()[1]);
       }
     }
 
@@ -617,7 +826,8 @@ winograd_conv_2d_output_transform(
         if (jump_in[h][w] >= 0) {
           device T* out_ptr = out_out + jump_in[h][w];
           for (int c = simd_lane_id; c < BO; c += 32) {
-            out_ptr[c] = Os[kh + h][kw + w][c];
+            out_ptr[c] = static_cast<T>(ConvEpilogue<T>::apply(
+                static_cast<float>(Os[kh + h][kw + w][c]), bias, bo + c));
           }
         }
       }
@@ -629,25 +839,33 @@ winograd_conv_2d_output_transform(
   }
 }
 
-#define instantiate_winograd_conv_2d_output_transform(name, itype, bo) \
-  template [[host_name("winograd_conv_2d_output_transform_" #name      \
-                       "_bo" #bo)]] [[kernel]] void                    \
-  winograd_conv_2d_output_transform<itype, bo, 2, 2>(                  \
-      const device itype* out_in [[buffer(0)]],                        \
-      device itype* out_out [[buffer(1)]],                             \
-      const constant MLXConvParams<2>& params [[buffer(2)]],           \
-      uint3 tid [[threadgroup_position_in_grid]],                      \
-      uint3 lid [[thread_position_in_threadgroup]],                    \
-      uint3 tgp_per_grid [[threadgroups_per_grid]],                    \
-      uint simd_group_id [[simdgroup_index_in_threadgroup]],           \
-      uint simd_lane_id [[thread_index_in_simdgroup]]);
-
 // clang-format off
-#define instantiate_winograd_conv_2d(name, itype)                     \
-  instantiate_winograd_conv_2d_weight_transform_base(name, itype, 32) \
-  instantiate_winograd_conv_2d_input_transform(name, itype, 32)       \
-  instantiate_winograd_conv_2d_output_transform(name, itype, 32) // clang-format on
+#define instantiate_winograd_conv_2d_output_transform(name, itype, utype, bo, m, r) \
+  template [[host_name("winograd_conv_2d_output_transform_" #name                   \
+                       "_m" #m "_r" #r "_bo" #bo)]] [[kernel]] void                 \
+  winograd_conv_2d_output_transform<itype, utype, bo, 2, 2, m, r>(                  \
+      const device itype* out_in [[buffer(0)]],                                     \
+      device itype* out_out [[buffer(1)]],                                          \
+      const constant MLXConvParams<2>& params [[buffer(2)]],                        \
+      const device itype* bias [[buffer(3), function_constant(conv_has_bias)]],     \
+      uint3 tid [[threadgroup_position_in_grid]],                                   \
+      uint3 lid [[thread_position_in_threadgroup]],                                 \
+      uint3 tgp_per_grid [[threadgroups_per_grid]],                                 \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],                        \
+      uint simd_lane_id [[thread_index_in_simdgroup]]);
 
-// clang-format off
-instantiate_winograd_conv_2d(float32, float);
-instantiate_winograd_conv_2d(float16, half); // clang-format on
+#define instantiate_winograd_conv_2d_tiles(name, itype, utype, m, r)     \
+  instantiate_winograd_conv_2d_weight_transform_base(name, itype, utype, 32, m, r) \
+  instantiate_winograd_conv_2d_input_transform(name, itype, utype, 32, m, r)       \
+  instantiate_winograd_conv_2d_output_transform(name, itype, utype, 32, m, r)
+
+// F(6x6, 3x3) is too inaccurate for bfloat16
+#define instantiate_winograd_conv_2d(name, itype, utype)     \
+  instantiate_winograd_conv_2d_tiles(name, itype, utype, 6, 3) \
+  instantiate_winograd_conv_2d_tiles(name, itype, utype, 4, 3) \
+  instantiate_winograd_conv_2d_tiles(name, itype, utype, 2, 5)
+
+instantiate_winograd_conv_2d(float32, float, float);
+instantiate_winograd_conv_2d(float16, half, half);
+instantiate_winograd_conv_2d_tiles(bfloat16, bfloat16_t, float, 4, 3);
+instantiate_winograd_conv_2d_tiles(bfloat16, bfloat16_t, float, 2, 5); // clang-format on
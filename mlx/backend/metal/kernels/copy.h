@@ -16,42 +16,49 @@ template <typename T, typename U>
   dst[index] = static_cast<U>(src[index]);
 }
 
-template <typename T, typename U>
+template <typename T, typename U, typename IdxT = int64_t>
 [[kernel]] void copy_g_nd1(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
     constant const int64_t& src_stride [[buffer(3)]],
     uint index [[thread_position_in_grid]]) {
-  auto src_idx = elem_to_loc_1(index, src_stride);
+  auto src_idx = elem_to_loc_1<int64_t, IdxT>(index, src_stride);
   dst[index] = static_cast<U>(src[src_idx]);
 }
 
-template <typename T, typename U>
+template <typename T, typename U, typename IdxT = int64_t>
 [[kernel]] void copy_g_nd2(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
     constant const int64_t* src_strides [[buffer(3)]],
     uint2 index [[thread_position_in_grid]],
     uint2 grid_dim [[threads_per_grid]]) {
-  auto src_idx = elem_to_loc_2(index, src_strides);
-  int64_t dst_idx = index.x + (int64_t)grid_dim.x * index.y;
+  auto src_idx = elem_to_loc_2<int64_t, IdxT>(index, src_strides);
+  IdxT dst_idx = index.x + IdxT(grid_dim.x) * index.y;
   dst[dst_idx] = static_cast<U>(src[src_idx]);
 }
 
-template <typename T, typename U>
+template <typename T, typename U, typename IdxT = int64_t>
 [[kernel]] void copy_g_nd3(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
     constant const int64_t* src_strides [[buffer(3)]],
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto src_idx = elem_to_loc_3(index, src_strides);
-  int64_t dst_idx =
-      index.x + (int64_t)grid_dim.x * (index.y + (int64_t)grid_dim.y * index.z);
+  auto src_idx = elem_to_loc_3<int64_t, IdxT>(index, src_strides);
+  IdxT dst_idx =
+      index.x + IdxT(grid_dim.x) * (index.y + IdxT(grid_dim.y) * index.z);
   dst[dst_idx] = static_cast<U>(src[src_idx]);
 }
 
-template <typename T, typename U, int DIM>
+// Each thread copies N elements of the inner dim so the divisions for the
+// location of the outer dims are done once
+template <
+    typename T,
+    typename U,
+    int DIM,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void copy_g_nd(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
@@ -59,13 +66,23 @@ template <typename T, typename U, int DIM>
     constant const int64_t* src_strides [[buffer(3)]],
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto src_idx = elem_to_loc_nd<DIM>(index, src_shape, src_strides);
-  int64_t dst_idx =
-      index.x + (int64_t)grid_dim.x * (index.y + (int64_t)grid_dim.y * index.z);
-  dst[dst_idx] = static_cast<U>(src[src_idx]);
+  auto src_idx = elem_to_loc_nd<DIM, int64_t, IdxT>(
+      uint3(N * index.x, index.y, index.z), src_shape, src_strides);
+  int xshape = src_shape[DIM - 1];
+  IdxT dst_idx = N * index.x +
+      IdxT(xshape) * (index.y + IdxT(grid_dim.y) * index.z);
+  IdxT src_xstride = src_strides[DIM - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    dst[dst_idx++] = static_cast<U>(src[src_idx]);
+    src_idx += src_xstride;
+  }
 }
 
-template <typename T, typename U>
+template <
+    typename T,
+    typename U,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void copy_g(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
@@ -74,49 +91,60 @@ template <typename T, typename U>
     constant const int& ndim [[buffer(5)]],
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto src_idx = elem_to_loc(index, src_shape, src_strides, ndim);
-  int64_t dst_idx =
-      index.x + (int64_t)grid_dim.x * (index.y + (int64_t)grid_dim.y * index.z);
-  dst[dst_idx] = static_cast<U>(src[src_idx]);
+  auto src_idx = elem_to_loc<int64_t, IdxT>(
+      uint3(N * index.x, index.y, index.z), src_shape, src_strides, ndim);
+  int xshape = src_shape[ndim - 1];
+  IdxT dst_idx = N * index.x +
+      IdxT(xshape) * (index.y + IdxT(grid_dim.y) * index.z);
+  IdxT src_xstride = src_strides[ndim - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    dst[dst_idx++] = static_cast<U>(src[src_idx]);
+    src_idx += src_xstride;
+  }
 }
 
-template <typename T, typename U>
+template <typename T, typename U, typename IdxT = int64_t>
 [[kernel]] void copy_gg_nd1(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
     constant const int64_t& src_stride [[buffer(3)]],
     constant const int64_t& dst_stride [[buffer(4)]],
     uint index [[thread_position_in_grid]]) {
-  auto src_idx = elem_to_loc_1(index, src_stride);
-  auto dst_idx = elem_to_loc_1(index, dst_stride);
+  auto src_idx = elem_to_loc_1<int64_t, IdxT>(index, src_stride);
+  auto dst_idx = elem_to_loc_1<int64_t, IdxT>(index, dst_stride);
   dst[dst_idx] = static_cast<U>(src[src_idx]);
 }
 
-template <typename T, typename U>
+template <typename T, typename U, typename IdxT = int64_t>
 [[kernel]] void copy_gg_nd2(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
     constant const int64_t* src_strides [[buffer(3)]],
     constant const int64_t* dst_strides [[buffer(4)]],
     uint2 index [[thread_position_in_grid]]) {
-  auto src_idx = elem_to_loc_2(index, src_strides);
-  auto dst_idx = elem_to_loc_2(index, dst_strides);
+  auto src_idx = elem_to_loc_2<int64_t, IdxT>(index, src_strides);
+  auto dst_idx = elem_to_loc_2<int64_t, IdxT>(index, dst_strides);
   dst[dst_idx] = static_cast<U>(src[src_idx]);
 }
 
-template <typename T, typename U>
+template <typename T, typename U, typename IdxT = int64_t>
 [[kernel]] void copy_gg_nd3(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
     constant const int64_t* src_strides [[buffer(3)]],
     constant const int64_t* dst_strides [[buffer(4)]],
     uint3 index [[thread_position_in_grid]]) {
-  auto src_idx = elem_to_loc_3(index, src_strides);
-  auto dst_idx = elem_to_loc_3(index, dst_strides);
+  auto src_idx = elem_to_loc_3<int64_t, IdxT>(index, src_strides);
+  auto dst_idx = elem_to_loc_3<int64_t, IdxT>(index, dst_strides);
   dst[dst_idx] = static_cast<U>(src[src_idx]);
 }
 
-template <typename T, typename U, int DIM>
+template <
+    typename T,
+    typename U,
+    int DIM,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void copy_gg_nd(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
@@ -124,12 +152,26 @@ template <typename T, typename U, int DIM>
     constant const int64_t* src_strides [[buffer(3)]],
     constant const int64_t* dst_strides [[buffer(4)]],
     uint3 index [[thread_position_in_grid]]) {
-  auto src_idx = elem_to_loc_nd<DIM>(index, src_shape, src_strides);
-  auto dst_idx = elem_to_loc_nd<DIM>(index, src_shape, dst_strides);
-  dst[dst_idx] = static_cast<U>(src[src_idx]);
+  uint3 elem(N * index.x, index.y, index.z);
+  auto src_idx =
+      elem_to_loc_nd<DIM, int64_t, IdxT>(elem, src_shape, src_strides);
+  auto dst_idx =
+      elem_to_loc_nd<DIM, int64_t, IdxT>(elem, src_shape, dst_strides);
+  int xshape = src_shape[DIM - 1];
+  IdxT src_xstride = src_strides[DIM - 1];
+  IdxT dst_xstride = dst_strides[DIM - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    dst[dst_idx] = static_cast<U>(src[src_idx]);
+    src_idx += src_xstride;
+    dst_idx += dst_xstride;
+  }
 }
 
-template <typename T, typename U>
+template <
+    typename T,
+    typename U,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void copy_gg(
     device const T* src [[buffer(0)]],
     device U* dst [[buffer(1)]],
@@ -138,7 +180,17 @@ template <typename T, typename U>
     constant const int64_t* dst_strides [[buffer(4)]],
     constant const int& ndim [[buffer(5)]],
     uint3 index [[thread_position_in_grid]]) {
-  auto src_idx = elem_to_loc(index, src_shape, src_strides, ndim);
-  auto dst_idx = elem_to_loc(index, src_shape, dst_strides, ndim);
-  dst[dst_idx] = static_cast<U>(src[src_idx]);
+  uint3 elem(N * index.x, index.y, index.z);
+  auto src_idx =
+      elem_to_loc<int64_t, IdxT>(elem, src_shape, src_strides, ndim);
+  auto dst_idx =
+      elem_to_loc<int64_t, IdxT>(elem, src_shape, dst_strides, ndim);
+  int xshape = src_shape[ndim - 1];
+  IdxT src_xstride = src_strides[ndim - 1];
+  IdxT dst_xstride = dst_strides[ndim - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    dst[dst_idx] = static_cast<U>(src[src_idx]);
+    src_idx += src_xstride;
+    dst_idx += dst_xstride;
+  }
 }
@@ -0,0 +1,122 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_common>
+#include <metal_simdgroup>
+
+// clang-format off
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/utils.h"
+// clang-format on
+
+using namespace metal;
+
+constant constexpr const int cross_entropy_n_reads = 4;
+
+// A threadgroup per row finds the log-sum-exp of the logits with an online
+// max and normalizer, so the row is read once, and subtracts the logit of
+// the target. The log-sum-exp is kept for the gradient.
+template <typename T, int N_READS = cross_entropy_n_reads>
+[[kernel]] void cross_entropy(
+    const device T* logits [[buffer(0)]],
+    const device int* targets [[buffer(1)]],
+    device T* loss [[buffer(2)]],
+    device float* lse [[buffer(3)]],
+    constant const int& axis_size [[buffer(4)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  constexpr int SIMD_SIZE = 32;
+  threadgroup float local_max[SIMD_SIZE];
+  threadgroup float local_normalizer[SIMD_SIZE];
+
+  logits += gid * size_t(axis_size);
+
+  float prevmax;
+  float maxval = Limits<float>::finite_min;
+  float normalizer = 0;
+  for (int offset = lid * N_READS; offset < axis_size;
+       offset += lsize * N_READS) {
+    float vals[N_READS];
+    for (int i = 0; i < N_READS; i++) {
+      vals[i] = (offset + i < axis_size) ? float(logits[offset + i])
+                                         : Limits<float>::finite_min;
+    }
+    prevmax = maxval;
+    for (int i = 0; i < N_READS; i++) {
+      maxval = (maxval < vals[i]) ? vals[i] : maxval;
+    }
+    normalizer *= fast::exp(prevmax - maxval);
+    for (int i = 0; i < N_READS; i++) {
+      normalizer += fast::exp(vals[i] - maxval);
+    }
+  }
+
+  // Combine within each simdgroup and then across simdgroups, rescaling the
+  // normalizers to the new max
+  prevmax = maxval;
+  maxval = simd_max(maxval);
+  normalizer *= fast::exp(prevmax - maxval);
+  normalizer = simd_sum(normalizer);
+  if (simd_group_id == 0) {
+    local_max[simd_lane_id] = Limits<float>::finite_min;
+    local_normalizer[simd_lane_id] = 0;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  prevmax = maxval;
+  if (simd_lane_id == 0) {
+    local_max[simd_group_id] = maxval;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  maxval = simd_max(local_max[simd_lane_id]);
+  normalizer *= fast::exp(prevmax - maxval);
+  if (simd_lane_id == 0) {
+    local_normalizer[simd_group_id] = normalizer;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  normalizer = simd_sum(local_normalizer[simd_lane_id]);
+
+  if (lid == 0) {
+    float row_lse = isinf(maxval) ? maxval : log(normalizer) + maxval;
+    int t = targets[gid];
+    bool valid = t >= 0 && t < axis_size;
+    loss[gid] = valid ? static_cast<T>(row_lse - float(logits[t])) : T(0);
+    lse[gid] = row_lse;
+  }
+}
+
+// The gradient of the logits, g * (softmax - onehot), with a thread per
+// group of N_READS logits of a row.
+template <typename T, int N_READS = cross_entropy_n_reads>
+[[kernel]] void cross_entropy_vjp(
+    const device T* logits [[buffer(0)]],
+    const device int* targets [[buffer(1)]],
+    const device float* lse [[buffer(2)]],
+    const device T* cotan [[buffer(3)]],
+    device T* dlogits [[buffer(4)]],
+    constant const int& axis_size [[buffer(5)]],
+    uint2 index [[thread_position_in_grid]]) {
+  int row = index.y;
+  int col = index.x * N_READS;
+  size_t base = row * size_t(axis_size);
+  int t = targets[row];
+  bool valid = t >= 0 && t < axis_size;
+  float g = valid ? float(cotan[row]) : 0.0f;
+  float row_lse = lse[row];
+  for (int i = 0; i < N_READS && col + i < axis_size; i++) {
+    float p = fast::exp(float(logits[base + col + i]) - row_lse);
+    float onehot = (col + i == t) ? 1.0f : 0.0f;
+    dlogits[base + col + i] = static_cast<T>(g * (p - onehot));
+  }
+}
+
+#define instantiate_cross_entropy(name, type)                           \
+  instantiate_kernel("cross_entropy_" #name, cross_entropy, type)       \
+  instantiate_kernel("cross_entropy_vjp_" #name, cross_entropy_vjp, type)
+
+// clang-format off
+instantiate_cross_entropy(float32, float)
+instantiate_cross_entropy(float16, half)
+instantiate_cross_entropy(bfloat16, bfloat16_t) // clang-format on
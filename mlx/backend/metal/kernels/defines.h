@@ -13,6 +13,7 @@ static MTL_CONST constexpr int REDUCE_N_READS = 16;
 static MTL_CONST constexpr int SOFTMAX_N_READS = 4;
 static MTL_CONST constexpr int RMS_N_READS = 4;
 static MTL_CONST constexpr int RMS_LOOPED_LIMIT = 4096;
+static MTL_CONST constexpr int ELEMWISE_N_WRITES = 4;
 
 // Instantiate a templated kernel.
 // Extra args are used as template parameters:
@@ -448,7 +448,7 @@ template <
     constant const int& batch_size,
     uint3 elem [[thread_position_in_grid]],
     uint3 grid [[threads_per_grid]]) {
-  // Fast four step FFT implementation for powers of 2.
+  // Fast no transpose four step FFT for n = n1 * n2.
   int overall_n = n1 * n2;
   int n = step == 0 ? n1 : n2;
   int stride = step == 0 ? n2 : n1;
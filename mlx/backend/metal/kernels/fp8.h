@@ -0,0 +1,21 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+///////////////////////////////////////////////////////////////////////////////
+// 8-bit floats stored as uint8_t, see to_fp8 and from_fp8
+///////////////////////////////////////////////////////////////////////////////
+
+// e5m2 is the upper byte of a half. The magnitude bits of e4m3 moved into a
+// half give its value times 2^-8, subnormals included. e4m3 has no
+// infinities and its only NaNs are 0x7F and 0xFF.
+template <bool e5m2>
+METAL_FUNC float fp8_to_float(uint8_t x) {
+  if (e5m2) {
+    return static_cast<float>(as_type<half>(static_cast<ushort>(x << 8)));
+  }
+  ushort mag = x & 0x7F;
+  float v = static_cast<float>(as_type<half>(static_cast<ushort>(mag << 7)));
+  v = (mag == 0x7F) ? metal::numeric_limits<float>::quiet_NaN() : v * 256.0f;
+  return (x & 0x80) ? -v : v;
+}
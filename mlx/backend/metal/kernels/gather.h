@@ -43,3 +43,33 @@ METAL_FUNC void gather_impl(
   size_t out_idx = index.y + static_cast<size_t>(grid_dim.y) * index.x;
   out[out_idx] = src[src_offset + src_idx];
 }
+
+// Copies whole rows of a row contiguous src, as in an embedding lookup, with
+// a thread per N_READS consecutive elements of an output row
+template <typename T, typename IdxT, int N_READS = 4>
+[[kernel]] void gather_rows(
+    const device T* src [[buffer(0)]],
+    device T* out [[buffer(1)]],
+    const device IdxT* indices [[buffer(2)]],
+    const constant int& n_src_rows [[buffer(3)]],
+    const constant size_t& row_size [[buffer(4)]],
+    const constant int* idx_shape [[buffer(5)]],
+    const constant size_t* idx_strides [[buffer(6)]],
+    const constant int& idx_ndim [[buffer(7)]],
+    uint2 index [[thread_position_in_grid]]) {
+  auto idx_loc = elem_to_loc(index.y, idx_shape, idx_strides, idx_ndim);
+  auto row = offset_neg_idx(indices[idx_loc], n_src_rows);
+  src += row * row_size;
+  out += index.y * row_size;
+
+  size_t col = size_t(index.x) * N_READS;
+  if (col + N_READS <= row_size) {
+    for (int i = 0; i < N_READS; i++) {
+      out[col + i] = src[col + i];
+    }
+  } else {
+    for (int i = 0; col + i < row_size; i++) {
+      out[col + i] = src[col + i];
+    }
+  }
+}
@@ -25,8 +25,11 @@ template <
     const int SN, /* Simdgroup cols (in threads) */
     const int TM, /* Thread rows (in elements) */
     const int TN, /* Thread cols (in elements) */
-    const bool kDoAxpby> /* Do out = alpha * out + beta * bias */
+    const bool kDoAxpby, /* Do out = alpha * out + beta * bias */
+    const int NV = 1> /* Vectors multiplied with each matrix read */
 struct GEMVKernel {
+  typedef float AccT;
+
   MLX_MTL_CONST int threadsM = BM * SM;
   MLX_MTL_CONST int threadsN = BN * SN;
 
@@ -59,31 +62,41 @@ struct GEMVKernel {
   //   * The last thread that partially overlaps with the matrix is shifted
   //     inwards such that the thread block fits exactly in the matrix
 
-  MLX_MTL_CONST short tgp_mem_size = BN > 1 ? BN*(blockM + TM) : 0;
+  //
+  // With NV > 1 the threads accumulate the products of every matrix element
+  // they load with NV vectors, so the matrix is read once for all of them.
+  // The vectors and outputs are vec_ld and out_vec_size apart and the ones
+  // past n_vecs read the last vector and are not written.
+
+  MLX_MTL_CONST short tgp_mem_size = BN > 1 ? NV*BN*(blockM + TM) : 0;
   MLX_MTL_CONST bool needs_tgp_reduction = BN > 1;
 
-  static METAL_FUNC void
-  load_unsafe(const device T* src, thread T dst[TN], const int src_offset = 0) {
+  static METAL_FUNC void load_unsafe(
+      const device T* src,
+      thread AccT dst[TN],
+      const int src_offset = 0) {
     MLX_MTL_PRAGMA_UNROLL
     for (int tn = 0; tn < TN; tn++) {
-      dst[tn] = src[src_offset + tn];
+      dst[tn] = static_cast<AccT>(src[src_offset + tn]);
     }
   }
 
   static METAL_FUNC void load_safe(
       const device T* src,
-      thread T dst[TN],
+      thread AccT dst[TN],
       const int src_offset = 0,
       const int src_size = TN) {
     if (src_offset + TN <= src_size) {
       MLX_MTL_PRAGMA_UNROLL
       for (int tn = 0; tn < TN; tn++) {
-        dst[tn] = src[src_offset + tn];
+        dst[tn] = static_cast<AccT>(src[src_offset + tn]);
       }
     } else { // Edgecase
       MLX_MTL_PRAGMA_UNROLL
       for (int tn = 0; tn < TN; tn++) {
-        dst[tn] = src_offset + tn < src_size ? src[src_offset + tn] : 0;
+        dst[tn] = src_offset + tn < src_size
+            ? static_cast<AccT>(src[src_offset + tn])
+            : 0;
       }
     }
   }
@@ -99,18 +112,29 @@ struct GEMVKernel {
       const constant float& alpha [[buffer(7)]],
       const constant float& beta [[buffer(8)]],
       const constant int& bias_stride [[buffer(14)]],
-      threadgroup T* tgp_memory [[threadgroup(0)]],
+      threadgroup AccT* tgp_memory [[threadgroup(0)]],
       uint3 tid [[threadgroup_position_in_grid]],
       uint3 lid [[thread_position_in_threadgroup]],
       uint simd_gid [[simdgroup_index_in_threadgroup]],
-      uint simd_lid [[thread_index_in_simdgroup]]) {
+      uint simd_lid [[thread_index_in_simdgroup]],
+      const int vec_ld = 0,
+      const int n_vecs = 1,
+      const int bias_ld = 0) {
     // Appease compiler
     (void)lid;
 
     // Thread local accumulation results
-    thread T result[TM] = {0};
-    thread T inter[TN];
-    thread T v_coeff[TN];
+    thread AccT result[NV][TM];
+    thread AccT inter[TN];
+    thread AccT v_coeff[NV][TN];
+
+    MLX_MTL_PRAGMA_UNROLL
+    for (int v = 0; v < NV; v++) {
+      MLX_MTL_PRAGMA_UNROLL
+      for (int tm = 0; tm < TM; tm++) {
+        result[v][tm] = 0;
+      }
+    }
 
     const int thrM = SN != 32 ? simd_lid / SN : 0;
     const int thrN = SN != 32 ? simd_lid % SN : int(simd_lid);
@@ -144,7 +168,10 @@ struct GEMVKernel {
 
     // Loop over in_vec in blocks of blockN
     for (int i = 0; i < n_iter; ++i) {
-      load_unsafe(in_vec, v_coeff, bn);
+      MLX_MTL_PRAGMA_UNROLL
+      for (int v = 0; v < NV; v++) {
+        load_unsafe(in_vec + min(v, n_vecs - 1) * vec_ld, v_coeff[v], bn);
+      }
 
       // Per thread work loop
       int mat_offset = 0;
@@ -155,8 +182,11 @@ struct GEMVKernel {
 
         // Accumulate results
         MLX_MTL_PRAGMA_UNROLL
-        for (int tn = 0; tn < TN; tn++) {
-          result[tm] += inter[tn] * v_coeff[tn];
+        for (int v = 0; v < NV; v++) {
+          MLX_MTL_PRAGMA_UNROLL
+          for (int tn = 0; tn < TN; tn++) {
+            result[v][tm] += inter[tn] * v_coeff[v][tn];
+          }
         }
 
         mat_offset += matrix_ld;
@@ -166,7 +196,11 @@ struct GEMVKernel {
     }
 
     if (leftover > 0) {
-      load_safe(in_vec, v_coeff, bn, in_size);
+      MLX_MTL_PRAGMA_UNROLL
+      for (int v = 0; v < NV; v++) {
+        load_safe(
+            in_vec + min(v, n_vecs - 1) * vec_ld, v_coeff[v], bn, in_size);
+      }
 
       // Per thread work loop
       MLX_MTL_PRAGMA_UNROLL
@@ -176,38 +210,51 @@ struct GEMVKernel {
 
         // Accumulate results
         MLX_MTL_PRAGMA_UNROLL
-        for (int tn = 0; tn < TN; tn++) {
-          result[tm] += inter[tn] * v_coeff[tn];
+        for (int v = 0; v < NV; v++) {
+          MLX_MTL_PRAGMA_UNROLL
+          for (int tn = 0; tn < TN; tn++) {
+            result[v][tm] += inter[tn] * v_coeff[v][tn];
+          }
         }
       }
     }
 
     // Simdgroup accumulations
     MLX_MTL_PRAGMA_UNROLL
-    for (int tm = 0; tm < TM; tm++) {
+    for (int v = 0; v < NV; v++) {
       MLX_MTL_PRAGMA_UNROLL
-      for (ushort sn = (SN / 2); sn >= 1; sn >>= 1) {
-        result[tm] += simd_shuffle_down(result[tm], sn);
+      for (int tm = 0; tm < TM; tm++) {
+        MLX_MTL_PRAGMA_UNROLL
+        for (ushort sn = (SN / 2); sn >= 1; sn >>= 1) {
+          result[v][tm] += simd_shuffle_down(result[v][tm], sn);
+        }
       }
     }
 
     // Threadgroup accumulation results
     if (needs_tgp_reduction) {
-      threadgroup T* tgp_results = tgp_memory + sgN * (blockM + TM) + bm;
+      threadgroup AccT* tgp_results = tgp_memory + sgN * (blockM + TM) + bm;
       if (thrN == 0) {
         MLX_MTL_PRAGMA_UNROLL
-        for (int tm = 0; tm < TM; tm++) {
-          tgp_results[tm] = result[tm];
+        for (int v = 0; v < NV; v++) {
+          MLX_MTL_PRAGMA_UNROLL
+          for (int tm = 0; tm < TM; tm++) {
+            tgp_results[v * BN * (blockM + TM) + tm] = result[v][tm];
+          }
         }
 
         threadgroup_barrier(mem_flags::mem_none);
 
         if (sgN == 0) {
           MLX_MTL_PRAGMA_UNROLL
-          for (int sgn = 1; sgn < BN; sgn++) {
+          for (int v = 0; v < NV; v++) {
             MLX_MTL_PRAGMA_UNROLL
-            for (int tm = 0; tm < TM; tm++) {
-              result[tm] += tgp_results[sgn * (blockM + TM) + tm];
+            for (int sgn = 1; sgn < BN; sgn++) {
+              MLX_MTL_PRAGMA_UNROLL
+              for (int tm = 0; tm < TM; tm++) {
+                result[v][tm] += tgp_results
+                    [v * BN * (blockM + TM) + sgn * (blockM + TM) + tm];
+              }
             }
           }
         }
@@ -217,12 +264,22 @@ struct GEMVKernel {
     // Write outputs
     if (simdN == 0 && thrN == 0) {
       MLX_MTL_PRAGMA_UNROLL
-      for (int tm = 0; tm < TM; tm++) {
-        if (kDoAxpby) {
-          out_vec[out_row + tm] = static_cast<T>(alpha) * result[tm] +
-              static_cast<T>(beta) * bias[(out_row + tm) * bias_stride];
-        } else {
-          out_vec[out_row + tm] = result[tm];
+      for (int v = 0; v < NV; v++) {
+        if (v >= n_vecs) {
+          break;
+        }
+        MLX_MTL_PRAGMA_UNROLL
+        for (int tm = 0; tm < TM; tm++) {
+          int out_idx = v * out_vec_size + out_row + tm;
+          if (kDoAxpby) {
+            out_vec[out_idx] = static_cast<T>(
+                alpha * result[v][tm] +
+                beta *
+                    static_cast<AccT>(
+                        bias[v * bias_ld + (out_row + tm) * bias_stride]));
+          } else {
+            out_vec[out_idx] = static_cast<T>(result[v][tm]);
+          }
         }
       }
     }
@@ -241,8 +298,11 @@ template <
     const int SN, /* Simdgroup cols (in threads) */
     const int TM, /* Thread rows (in elements) */
     const int TN, /* Thread cols (in elements) */
-    const bool kDoAxpby> /* Do out = alpha * out + beta * bias */
+    const bool kDoAxpby, /* Do out = alpha * out + beta * bias */
+    const int NV = 1> /* Vectors multiplied with each matrix read */
 struct GEMVTKernel {
+  typedef float AccT;
+
   MLX_MTL_CONST int threadsM = BM * SM;
   MLX_MTL_CONST int threadsN = BN * SN;
 
@@ -270,7 +330,10 @@ struct GEMVTKernel {
   //   * The last thread that partially overlaps with the matrix is shifted
   //     inwards such that the thread block fits exactly in the matrix
 
-  MLX_MTL_CONST short tgp_mem_size = BM > 1 ? BM*(blockN + TN) : 0;
+  //
+  // With NV > 1 the vectors are handled as in GEMVKernel
+
+  MLX_MTL_CONST short tgp_mem_size = BM > 1 ? NV*BM*(blockN + TN) : 0;
   MLX_MTL_CONST bool needs_tgp_reduction = BM > 1;
 
   static METAL_FUNC void run(
@@ -284,18 +347,29 @@ struct GEMVTKernel {
       const constant float& alpha [[buffer(7)]],
       const constant float& beta [[buffer(8)]],
       const constant int& bias_stride [[buffer(14)]],
-      threadgroup T* tgp_memory [[threadgroup(0)]],
+      threadgroup AccT* tgp_memory [[threadgroup(0)]],
       uint3 tid [[threadgroup_position_in_grid]],
       uint3 lid [[thread_position_in_threadgroup]],
       uint simd_gid [[simdgroup_index_in_threadgroup]],
-      uint simd_lid [[thread_index_in_simdgroup]]) {
+      uint simd_lid [[thread_index_in_simdgroup]],
+      const int vec_ld = 0,
+      const int n_vecs = 1,
+      const int bias_ld = 0) {
     // Appease compiler
     (void)lid;
 
     // Thread local accumulation results
-    T result[TN] = {0};
-    T inter[TN];
-    T v_coeff[TM];
+    AccT result[NV][TN];
+    AccT inter[TN];
+    AccT v_coeff[NV][TM];
+
+    MLX_MTL_PRAGMA_UNROLL
+    for (int v = 0; v < NV; v++) {
+      MLX_MTL_PRAGMA_UNROLL
+      for (int tn = 0; tn < TN; tn++) {
+        result[v][tn] = 0;
+      }
+    }
 
     const int thrM = SN != 32 ? simd_lid / SN : 0;
     const int thrN = SN != 32 ? simd_lid % SN : int(simd_lid);
@@ -331,17 +405,25 @@ struct GEMVTKernel {
         threadgroup_barrier(mem_flags::mem_none);
 
         MLX_MTL_PRAGMA_UNROLL
-        for (int tm = 0; tm < TM; tm++) {
-          v_coeff[tm] = in_vec[bm + tm];
+        for (int v = 0; v < NV; v++) {
+          const device T* vec = in_vec + min(v, n_vecs - 1) * vec_ld;
+          MLX_MTL_PRAGMA_UNROLL
+          for (int tm = 0; tm < TM; tm++) {
+            v_coeff[v][tm] = static_cast<AccT>(vec[bm + tm]);
+          }
         }
 
         MLX_MTL_PRAGMA_UNROLL
         for (int tm = 0; tm < TM; tm++) {
           for (int tn = 0; tn < TN; tn++) {
-            inter[tn] = mat[(bm + tm) * marix_ld + out_col + tn];
+            inter[tn] =
+                static_cast<AccT>(mat[(bm + tm) * marix_ld + out_col + tn]);
           }
-          for (int tn = 0; tn < TN; tn++) {
-            result[tn] += v_coeff[tm] * inter[tn];
+          MLX_MTL_PRAGMA_UNROLL
+          for (int v = 0; v < NV; v++) {
+            for (int tn = 0; tn < TN; tn++) {
+              result[v][tn] += v_coeff[v][tm] * inter[tn];
+            }
           }
         }
 
@@ -350,16 +432,24 @@ struct GEMVTKernel {
 
       if (leftover > 0) {
         for (int tm = 0; tm < TM && bm + tm < in_vec_size; tm++) {
-          v_coeff[tm] = in_vec[bm + tm];
+          MLX_MTL_PRAGMA_UNROLL
+          for (int v = 0; v < NV; v++) {
+            v_coeff[v][tm] = static_cast<AccT>(
+                in_vec[min(v, n_vecs - 1) * vec_ld + bm + tm]);
+          }
 
           MLX_MTL_PRAGMA_UNROLL
           for (int tn = 0; tn < TN; tn++) {
-            inter[tn] = mat[(bm + tm) * marix_ld + out_col + tn];
+            inter[tn] =
+                static_cast<AccT>(mat[(bm + tm) * marix_ld + out_col + tn]);
           }
 
           MLX_MTL_PRAGMA_UNROLL
-          for (int tn = 0; tn < TN; tn++) {
-            result[tn] += v_coeff[tm] * inter[tn];
+          for (int v = 0; v < NV; v++) {
+            MLX_MTL_PRAGMA_UNROLL
+            for (int tn = 0; tn < TN; tn++) {
+              result[v][tn] += v_coeff[v][tm] * inter[tn];
+            }
           }
         }
       }
@@ -367,30 +457,40 @@ struct GEMVTKernel {
 
     // Simdgroup accumulations
     MLX_MTL_PRAGMA_UNROLL
-    for (int tn = 0; tn < TN; tn++) {
+    for (int v = 0; v < NV; v++) {
       MLX_MTL_PRAGMA_UNROLL
-      for (ushort sm = (SM / 2); sm >= 1; sm >>= 1) {
-        result[tn] += simd_shuffle_down(result[tn], SN * sm);
+      for (int tn = 0; tn < TN; tn++) {
+        MLX_MTL_PRAGMA_UNROLL
+        for (ushort sm = (SM / 2); sm >= 1; sm >>= 1) {
+          result[v][tn] += simd_shuffle_down(result[v][tn], SN * sm);
+        }
       }
     }
 
     // Threadgroup accumulation results
     if (needs_tgp_reduction) {
-      threadgroup T* tgp_results = tgp_memory + sgM * (blockN + TN) + bn;
+      threadgroup AccT* tgp_results = tgp_memory + sgM * (blockN + TN) + bn;
       if (thrM == 0) {
         MLX_MTL_PRAGMA_UNROLL
-        for (int tn = 0; tn < TN; tn++) {
-          tgp_results[tn] = result[tn];
+        for (int v = 0; v < NV; v++) {
+          MLX_MTL_PRAGMA_UNROLL
+          for (int tn = 0; tn < TN; tn++) {
+            tgp_results[v * BM * (blockN + TN) + tn] = result[v][tn];
+          }
         }
 
         threadgroup_barrier(mem_flags::mem_none);
 
         if (sgM == 0) {
           MLX_MTL_PRAGMA_UNROLL
-          for (int sgm = 1; sgm < BM; sgm++) {
+          for (int v = 0; v < NV; v++) {
             MLX_MTL_PRAGMA_UNROLL
-            for (int tn = 0; tn < TN; tn++) {
-              result[tn] += tgp_results[sgm * (blockN + TN) + tn];
+            for (int sgm = 1; sgm < BM; sgm++) {
+              MLX_MTL_PRAGMA_UNROLL
+              for (int tn = 0; tn < TN; tn++) {
+                result[v][tn] += tgp_results
+                    [v * BM * (blockN + TN) + sgm * (blockN + TN) + tn];
+              }
             }
           }
         }
@@ -400,12 +500,22 @@ struct GEMVTKernel {
     // Threadgroup accumulation and writing out results
     if (cm == 0 && out_col < out_vec_size) {
       MLX_MTL_PRAGMA_UNROLL
-      for (int j = 0; j < TN; j++) {
-        if (kDoAxpby) {
-          out_vec[out_col + j] = static_cast<T>(alpha) * result[j] +
-              static_cast<T>(beta) * bias[(out_col + j) * bias_stride];
-        } else {
-          out_vec[out_col + j] = result[j];
+      for (int v = 0; v < NV; v++) {
+        if (v >= n_vecs) {
+          break;
+        }
+        MLX_MTL_PRAGMA_UNROLL
+        for (int j = 0; j < TN; j++) {
+          int out_idx = v * out_vec_size + out_col + j;
+          if (kDoAxpby) {
+            out_vec[out_idx] = static_cast<T>(
+                alpha * result[v][j] +
+                beta *
+                    static_cast<AccT>(
+                        bias[v * bias_ld + (out_col + j) * bias_stride]));
+          } else {
+            out_vec[out_idx] = static_cast<T>(result[v][j]);
+          }
         }
       }
     }
@@ -447,7 +557,7 @@ template <
     uint simd_gid [[simdgroup_index_in_threadgroup]],
     uint simd_lid [[thread_index_in_simdgroup]]) {
   using gemv_kernel = GEMVKernel<T, BM, BN, SM, SN, TM, TN, kDoAxpby>;
-  threadgroup T tgp_memory
+  threadgroup typename gemv_kernel::AccT tgp_memory
       [gemv_kernel::tgp_mem_size == 0 ? 1 : gemv_kernel::tgp_mem_size];
 
   // Update batch offsets
@@ -531,6 +641,104 @@ instantiate_gemv_blocks(float32, float);
 instantiate_gemv_blocks(float16, half);
 instantiate_gemv_blocks(bfloat16, bfloat16_t);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Matrix vector multiplication with a few vectors
+///////////////////////////////////////////////////////////////////////////////
+
+template <
+    typename T,
+    const int BM, /* Threadgroup rows (in simdgroups) */
+    const int BN, /* Threadgroup cols (in simdgroups) */
+    const int SM, /* Simdgroup rows (in threads) */
+    const int SN, /* Simdgroup cols (in threads) */
+    const int TM, /* Thread rows (in elements) */
+    const int TN, /* Thread cols (in elements) */
+    const int NV, /* Max number of vectors */
+    const bool kDoAxpby> /* Do out = alpha * out + beta * bias */
+[[kernel, max_total_threads_per_threadgroup(BM* BN * 32)]] void gemv_rows(
+    const device T* mat [[buffer(0)]],
+    const device T* in_vec [[buffer(1)]],
+    const device T* bias [[buffer(2)]],
+    device T* out_vec [[buffer(3)]],
+    const constant int& in_vec_size [[buffer(4)]],
+    const constant int& out_vec_size [[buffer(5)]],
+    const constant int& marix_ld [[buffer(6)]],
+    const constant float& alpha [[buffer(7)]],
+    const constant float& beta [[buffer(8)]],
+    const constant int& vec_ld [[buffer(9)]],
+    const constant int& n_vecs [[buffer(10)]],
+    const constant int& bias_ld [[buffer(11)]],
+    const constant int& bias_stride [[buffer(14)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]]) {
+  using gemv_kernel = GEMVKernel<T, BM, BN, SM, SN, TM, TN, kDoAxpby, NV>;
+  threadgroup typename gemv_kernel::AccT tgp_memory
+      [gemv_kernel::tgp_mem_size == 0 ? 1 : gemv_kernel::tgp_mem_size];
+
+  gemv_kernel::run(
+      mat,
+      in_vec,
+      bias,
+      out_vec,
+      in_vec_size,
+      out_vec_size,
+      marix_ld,
+      alpha,
+      beta,
+      bias_stride,
+      gemv_kernel::tgp_mem_size == 0 ? nullptr : tgp_memory,
+      tid,
+      lid,
+      simd_gid,
+      simd_lid,
+      vec_ld,
+      n_vecs,
+      bias_ld);
+}
+
+#define instantiate_gemv_rows_helper(                                         \
+    name, itype, bm, bn, sm, sn, tm, tn, nv, axpby)                           \
+  template [[host_name("gemv_rows_" #name "_bm" #bm "_bn" #bn "_sm" #sm       \
+                       "_sn" #sn "_tm" #tm "_tn" #tn "_nv" #nv                \
+                       "_axpby" #axpby)]] [[kernel]] void                     \
+  gemv_rows<itype, bm, bn, sm, sn, tm, tn, nv, axpby>(                        \
+      const device itype* mat [[buffer(0)]],                                  \
+      const device itype* in_vec [[buffer(1)]],                               \
+      const device itype* bias [[buffer(2)]],                                 \
+      device itype* out_vec [[buffer(3)]],                                    \
+      const constant int& in_vec_size [[buffer(4)]],                          \
+      const constant int& out_vec_size [[buffer(5)]],                         \
+      const constant int& marix_ld [[buffer(6)]],                             \
+      const constant float& alpha [[buffer(7)]],                              \
+      const constant float& beta [[buffer(8)]],                               \
+      const constant int& vec_ld [[buffer(9)]],                               \
+      const constant int& n_vecs [[buffer(10)]],                              \
+      const constant int& bias_ld [[buffer(11)]],                             \
+      const constant int& bias_stride [[buffer(14)]],                         \
+      uint3 tid [[threadgroup_position_in_grid]],                             \
+      uint3 lid [[thread_position_in_threadgroup]],                           \
+      uint simd_gid [[simdgroup_index_in_threadgroup]],                       \
+      uint simd_lid [[thread_index_in_simdgroup]]);
+
+// clang-format off
+#define instantiate_gemv_rows(name, itype, bm, bn, tm, tn)              \
+  instantiate_gemv_rows_helper(name, itype, bm, 1, 1, bn, tm, tn, 4, 0) \
+  instantiate_gemv_rows_helper(name, itype, bm, 1, 1, bn, tm, tn, 4, 1) \
+  instantiate_gemv_rows_helper(name, itype, bm, 1, 1, bn, tm, tn, 8, 0) \
+  instantiate_gemv_rows_helper(name, itype, bm, 1, 1, bn, tm, tn, 8, 1) // clang-format on
+
+// clang-format off
+#define instantiate_gemv_rows_blocks(name, itype) \
+  instantiate_gemv_rows(name, itype, 4, 32, 1, 4) \
+  instantiate_gemv_rows(name, itype, 4, 32, 4, 4) \
+  instantiate_gemv_rows(name, itype, 8, 32, 4, 4) // clang-format on
+
+instantiate_gemv_rows_blocks(float32, float);
+instantiate_gemv_rows_blocks(float16, half);
+instantiate_gemv_rows_blocks(bfloat16, bfloat16_t);
+
 template <
     typename T,
     const int BM, /* Threadgroup rows (in simdgroups) */
@@ -565,7 +773,7 @@ template <
     uint simd_gid [[simdgroup_index_in_threadgroup]],
     uint simd_lid [[thread_index_in_simdgroup]]) {
   using gemv_kernel = GEMVKernel<T, BM, BN, SM, SN, TM, TN, false>;
-  threadgroup T tgp_memory
+  threadgroup typename gemv_kernel::AccT tgp_memory
       [gemv_kernel::tgp_mem_size == 0 ? 1 : gemv_kernel::tgp_mem_size];
 
   uint32_t indx_vec;
@@ -695,7 +903,7 @@ template <
     uint simd_gid [[simdgroup_index_in_threadgroup]],
     uint simd_lid [[thread_index_in_simdgroup]]) {
   using gemv_kernel = GEMVTKernel<T, BM, BN, SM, SN, TM, TN, kDoAxpby>;
-  threadgroup T tgp_memory
+  threadgroup typename gemv_kernel::AccT tgp_memory
       [gemv_kernel::tgp_mem_size == 0 ? 1 : gemv_kernel::tgp_mem_size];
 
   // Update batch offsets
@@ -782,6 +990,107 @@ instantiate_gemv_t_blocks(float32, float);
 instantiate_gemv_t_blocks(float16, half);
 instantiate_gemv_t_blocks(bfloat16, bfloat16_t); // clang-format on
 
+///////////////////////////////////////////////////////////////////////////////
+/// Vector matrix multiplication with a few vectors
+///////////////////////////////////////////////////////////////////////////////
+
+template <
+    typename T,
+    const int BM, /* Threadgroup rows (in simdgroups) */
+    const int BN, /* Threadgroup cols (in simdgroups) */
+    const int SM, /* Simdgroup rows (in threads) */
+    const int SN, /* Simdgroup cols (in threads) */
+    const int TM, /* Thread rows (in elements) */
+    const int TN, /* Thread cols (in elements) */
+    const int NV, /* Max number of vectors */
+    const bool kDoAxpby> /* Do out = alpha * out + beta * bias */
+[[kernel, max_total_threads_per_threadgroup(BM* BN * 32)]] void gemv_t_rows(
+    const device T* mat [[buffer(0)]],
+    const device T* in_vec [[buffer(1)]],
+    const device T* bias [[buffer(2)]],
+    device T* out_vec [[buffer(3)]],
+    const constant int& in_vec_size [[buffer(4)]],
+    const constant int& out_vec_size [[buffer(5)]],
+    const constant int& marix_ld [[buffer(6)]],
+    const constant float& alpha [[buffer(7)]],
+    const constant float& beta [[buffer(8)]],
+    const constant int& vec_ld [[buffer(9)]],
+    const constant int& n_vecs [[buffer(10)]],
+    const constant int& bias_ld [[buffer(11)]],
+    const constant int& bias_stride [[buffer(14)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]]) {
+  using gemv_kernel = GEMVTKernel<T, BM, BN, SM, SN, TM, TN, kDoAxpby, NV>;
+  threadgroup typename gemv_kernel::AccT tgp_memory
+      [gemv_kernel::tgp_mem_size == 0 ? 1 : gemv_kernel::tgp_mem_size];
+
+  gemv_kernel::run(
+      mat,
+      in_vec,
+      bias,
+      out_vec,
+      in_vec_size,
+      out_vec_size,
+      marix_ld,
+      alpha,
+      beta,
+      bias_stride,
+      gemv_kernel::tgp_mem_size == 0 ? nullptr : tgp_memory,
+      tid,
+      lid,
+      simd_gid,
+      simd_lid,
+      vec_ld,
+      n_vecs,
+      bias_ld);
+}
+
+#define instantiate_gemv_t_rows_helper(                                       \
+    name, itype, bm, bn, sm, sn, tm, tn, nv, axpby)                           \
+  template [[host_name("gemv_t_rows_" #name "_bm" #bm "_bn" #bn "_sm" #sm     \
+                       "_sn" #sn "_tm" #tm "_tn" #tn "_nv" #nv                \
+                       "_axpby" #axpby)]] [[kernel]] void                     \
+  gemv_t_rows<itype, bm, bn, sm, sn, tm, tn, nv, axpby>(                      \
+      const device itype* mat [[buffer(0)]],                                  \
+      const device itype* in_vec [[buffer(1)]],                               \
+      const device itype* bias [[buffer(2)]],                                 \
+      device itype* out_vec [[buffer(3)]],                                    \
+      const constant int& in_vec_size [[buffer(4)]],                          \
+      const constant int& out_vec_size [[buffer(5)]],                         \
+      const constant int& marix_ld [[buffer(6)]],                             \
+      const constant float& alpha [[buffer(7)]],                              \
+      const constant float& beta [[buffer(8)]],                               \
+      const constant int& vec_ld [[buffer(9)]],                               \
+      const constant int& n_vecs [[buffer(10)]],                              \
+      const constant int& bias_ld [[buffer(11)]],                             \
+      const constant int& bias_stride [[buffer(14)]],                         \
+      uint3 tid [[threadgroup_position_in_grid]],                             \
+      uint3 lid [[thread_position_in_threadgroup]],                           \
+      uint simd_gid [[simdgroup_index_in_threadgroup]],                       \
+      uint simd_lid [[thread_index_in_simdgroup]]);
+
+// clang-format off
+#define instantiate_gemv_t_rows(name, itype, bm, bn, sm, sn, tm, tn)        \
+  instantiate_gemv_t_rows_helper(name, itype, bm, bn, sm, sn, tm, tn, 4, 0) \
+  instantiate_gemv_t_rows_helper(name, itype, bm, bn, sm, sn, tm, tn, 4, 1) \
+  instantiate_gemv_t_rows_helper(name, itype, bm, bn, sm, sn, tm, tn, 8, 0) \
+  instantiate_gemv_t_rows_helper(name, itype, bm, bn, sm, sn, tm, tn, 8, 1) // clang-format on
+
+// clang-format off
+#define instantiate_gemv_t_rows_blocks(name, itype) \
+  instantiate_gemv_t_rows(name, itype, 1, 2,  8, 4, 4, 1) \
+  instantiate_gemv_t_rows(name, itype, 1, 2,  8, 4, 4, 4) \
+  instantiate_gemv_t_rows(name, itype, 1, 4,  8, 4, 4, 4) \
+  instantiate_gemv_t_rows(name, itype, 1, 16, 8, 4, 4, 4) \
+  instantiate_gemv_t_rows(name, itype, 1, 16, 4, 8, 4, 4) // clang-format on
+
+// clang-format off
+instantiate_gemv_t_rows_blocks(float32, float);
+instantiate_gemv_t_rows_blocks(float16, half);
+instantiate_gemv_t_rows_blocks(bfloat16, bfloat16_t); // clang-format on
+
 template <
     typename T,
     const int BM, /* Threadgroup rows (in simdgroups) */
@@ -816,7 +1125,7 @@ template <
     uint simd_gid [[simdgroup_index_in_threadgroup]],
     uint simd_lid [[thread_index_in_simdgroup]]) {
   using gemv_kernel = GEMVTKernel<T, BM, BN, SM, SN, TM, TN, false>;
-  threadgroup T tgp_memory
+  threadgroup typename gemv_kernel::AccT tgp_memory
       [gemv_kernel::tgp_mem_size == 0 ? 1 : gemv_kernel::tgp_mem_size];
 
   uint32_t indx_vec;
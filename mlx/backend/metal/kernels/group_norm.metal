@@ -0,0 +1,213 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_common>
+#include <metal_simdgroup>
+
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/utils.h"
+#include "mlx/backend/metal/kernels/welford.h"
+
+using namespace metal;
+
+// The input is a contiguous (batch, positions, axis_size) array whose
+// channels are split into n_groups groups of group_channels channels. The
+// k-th channel of group g is k * channel_stride + g * group_offset so both
+// contiguous and interleaved groups are supported. One threadgroup
+// normalizes one (batch, group) pair over its group_size elements.
+struct GroupNormIndexer {
+  uint axis_size;
+  uint group_channels;
+  uint channel_stride;
+  uint group_offset;
+  uint g;
+
+  METAL_FUNC uint channel(uint j) const {
+    return (j % group_channels) * channel_stride + g * group_offset;
+  }
+
+  METAL_FUNC uint loc(uint j) const {
+    return (j / group_channels) * axis_size + channel(j);
+  }
+};
+
+template <typename T>
+[[kernel]] void group_norm(
+    const device T* x [[buffer(0)]],
+    const device T* w [[buffer(1)]],
+    const device T* b [[buffer(2)]],
+    device T* out [[buffer(3)]],
+    constant float& eps [[buffer(4)]],
+    constant uint& axis_size [[buffer(5)]],
+    constant uint& group_channels [[buffer(6)]],
+    constant uint& group_size [[buffer(7)]],
+    constant uint& n_groups [[buffer(8)]],
+    constant uint& channel_stride [[buffer(9)]],
+    constant uint& group_offset [[buffer(10)]],
+    constant uint& w_stride [[buffer(11)]],
+    constant uint& b_stride [[buffer(12)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  constexpr int SIMD_SIZE = 32;
+
+  threadgroup float local_n[SIMD_SIZE];
+  threadgroup float local_mean[SIMD_SIZE];
+  threadgroup float local_m2[SIMD_SIZE];
+
+  GroupNormIndexer idx{
+      axis_size, group_channels, channel_stride, group_offset, gid % n_groups};
+  size_t offset = static_cast<size_t>(gid / n_groups) * group_size * n_groups;
+  x += offset;
+  out += offset;
+
+  Welford stats;
+  for (uint j = lid; j < group_size; j += lsize) {
+    stats.update(x[idx.loc(j)]);
+  }
+  stats.threadgroup_combine(
+      local_n, local_mean, local_m2, simd_lane_id, simd_group_id);
+  float mean = stats.mean;
+  float normalizer = metal::precise::rsqrt(stats.m2 / stats.n + eps);
+
+  for (uint j = lid; j < group_size; j += lsize) {
+    uint c = idx.channel(j);
+    uint loc = idx.loc(j);
+    float xhat = (static_cast<float>(x[loc]) - mean) * normalizer;
+    out[loc] = static_cast<T>(
+        xhat * static_cast<float>(w[c * w_stride]) +
+        static_cast<float>(b[c * b_stride]));
+  }
+}
+
+// Computes gx for the group and writes g * xhat to gw so that the weight
+// gradient can be reduced over the rows afterwards.
+template <typename T>
+[[kernel]] void vjp_group_norm(
+    const device T* x [[buffer(0)]],
+    const device T* w [[buffer(1)]],
+    const device T* g [[buffer(2)]],
+    device T* gx [[buffer(3)]],
+    device T* gw [[buffer(4)]],
+    constant float& eps [[buffer(5)]],
+    constant uint& axis_size [[buffer(6)]],
+    constant uint& group_channels [[buffer(7)]],
+    constant uint& group_size [[buffer(8)]],
+    constant uint& n_groups [[buffer(9)]],
+    constant uint& channel_stride [[buffer(10)]],
+    constant uint& group_offset [[buffer(11)]],
+    constant uint& w_stride [[buffer(12)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  constexpr int SIMD_SIZE = 32;
+
+  threadgroup float local_n[SIMD_SIZE];
+  threadgroup float local_mean[SIMD_SIZE];
+  threadgroup float local_m2[SIMD_SIZE];
+  threadgroup float local_sumwg[SIMD_SIZE];
+  threadgroup float local_sumwgxhat[SIMD_SIZE];
+
+  GroupNormIndexer idx{
+      axis_size, group_channels, channel_stride, group_offset, gid % n_groups};
+  size_t offset = static_cast<size_t>(gid / n_groups) * group_size * n_groups;
+  x += offset;
+  g += offset;
+  gx += offset;
+  gw += offset;
+
+  Welford stats;
+  for (uint j = lid; j < group_size; j += lsize) {
+    stats.update(x[idx.loc(j)]);
+  }
+  stats.threadgroup_combine(
+      local_n, local_mean, local_m2, simd_lane_id, simd_group_id);
+  float mean = stats.mean;
+  float normalizer = metal::precise::rsqrt(stats.m2 / stats.n + eps);
+
+  // Accumulate sum(w * g) and sum(w * g * xhat) over the group
+  float sumwg = 0;
+  float sumwgxhat = 0;
+  for (uint j = lid; j < group_size; j += lsize) {
+    uint loc = idx.loc(j);
+    float xhat = (static_cast<float>(x[loc]) - mean) * normalizer;
+    float wg = static_cast<float>(w[idx.channel(j) * w_stride]) *
+        static_cast<float>(g[loc]);
+    sumwg += wg;
+    sumwgxhat += wg * xhat;
+  }
+  sumwg = simd_sum(sumwg);
+  sumwgxhat = simd_sum(sumwgxhat);
+  if (simd_group_id == 0) {
+    local_sumwg[simd_lane_id] = 0;
+    local_sumwgxhat[simd_lane_id] = 0;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  if (simd_lane_id == 0) {
+    local_sumwg[simd_group_id] = sumwg;
+    local_sumwgxhat[simd_group_id] = sumwgxhat;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  float meanwg = simd_sum(local_sumwg[simd_lane_id]) / stats.n;
+  float meanwgxhat = simd_sum(local_sumwgxhat[simd_lane_id]) / stats.n;
+
+  for (uint j = lid; j < group_size; j += lsize) {
+    uint loc = idx.loc(j);
+    float xhat = (static_cast<float>(x[loc]) - mean) * normalizer;
+    float gi = static_cast<float>(g[loc]);
+    float wg = static_cast<float>(w[idx.channel(j) * w_stride]) * gi;
+    gx[loc] = static_cast<T>(normalizer * (wg - meanwg - xhat * meanwgxhat));
+    gw[loc] = static_cast<T>(gi * xhat);
+  }
+}
+
+// clang-format off
+#define instantiate_group_norm(name, itype)                      \
+  template [[host_name("group_norm" #name)]] [[kernel]] void     \
+  group_norm<itype>(                                             \
+      const device itype* x [[buffer(0)]],                       \
+      const device itype* w [[buffer(1)]],                       \
+      const device itype* b [[buffer(2)]],                       \
+      device itype* out [[buffer(3)]],                           \
+      constant float& eps [[buffer(4)]],                         \
+      constant uint& axis_size [[buffer(5)]],                    \
+      constant uint& group_channels [[buffer(6)]],               \
+      constant uint& group_size [[buffer(7)]],                   \
+      constant uint& n_groups [[buffer(8)]],                     \
+      constant uint& channel_stride [[buffer(9)]],               \
+      constant uint& group_offset [[buffer(10)]],                \
+      constant uint& w_stride [[buffer(11)]],                    \
+      constant uint& b_stride [[buffer(12)]],                    \
+      uint gid [[threadgroup_position_in_grid]],                 \
+      uint lid [[thread_position_in_threadgroup]],               \
+      uint lsize [[threads_per_threadgroup]],                    \
+      uint simd_lane_id [[thread_index_in_simdgroup]],           \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);    \
+  template [[host_name("vjp_group_norm" #name)]] [[kernel]] void \
+  vjp_group_norm<itype>(                                         \
+      const device itype* x [[buffer(0)]],                       \
+      const device itype* w [[buffer(1)]],                       \
+      const device itype* g [[buffer(2)]],                       \
+      device itype* gx [[buffer(3)]],                            \
+      device itype* gw [[buffer(4)]],                            \
+      constant float& eps [[buffer(5)]],                         \
+      constant uint& axis_size [[buffer(6)]],                    \
+      constant uint& group_channels [[buffer(7)]],               \
+      constant uint& group_size [[buffer(8)]],                   \
+      constant uint& n_groups [[buffer(9)]],                     \
+      constant uint& channel_stride [[buffer(10)]],              \
+      constant uint& group_offset [[buffer(11)]],                \
+      constant uint& w_stride [[buffer(12)]],                    \
+      uint gid [[threadgroup_position_in_grid]],                 \
+      uint lid [[thread_position_in_threadgroup]],               \
+      uint lsize [[threads_per_threadgroup]],                    \
+      uint simd_lane_id [[thread_index_in_simdgroup]],           \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+
+instantiate_group_norm(float32, float)
+instantiate_group_norm(float16, half)
+instantiate_group_norm(bfloat16, bfloat16_t) // clang-format on
@@ -0,0 +1,102 @@
+// Copyright © 2024 Apple Inc.
+
+/* Fast Walsh-Hadamard transform
+
+Each row of length n is transformed in threadgroup memory with in-place
+butterflies. Every step combines radix 8, or what is left of log2(n), of
+the stages and each thread owns whole butterflies of a step, as in the
+Stockham FFT. The values are kept in float32 in between the steps. */
+
+#pragma once
+
+#include <metal_common>
+#include <metal_stdlib>
+
+using namespace metal;
+
+// The largest butterfly computed by a single thread
+constant constexpr int hadamard_max_radix = 8;
+
+template <short R>
+METAL_FUNC void hadamard_radix(thread float* x) {
+  constexpr short log_r = __builtin_ctz(R);
+  short h = 1;
+#pragma clang loop unroll(full)
+  for (short s = 0; s < log_r; s++) {
+#pragma clang loop unroll(full)
+    for (short i = 0; i < R / 2; i++) {
+      short k = i & (h - 1);
+      short j = ((i - k) << 1) + k;
+      float a = x[j];
+      float b = x[j + h];
+      x[j] = a + b;
+      x[j + h] = a - b;
+    }
+    h <<= 1;
+  }
+}
+
+// Transforms rows of n elements that are stride apart. Row r starts at
+// (r / stride) * n * stride + r % stride so a stride of m transforms the
+// columns of (n, m) matrices. Rows are laid out along y and the threads of a
+// row along x, and a threadgroup holds as many rows as fit in tg_mem_size.
+template <typename T, int tg_mem_size>
+[[kernel]] void hadamard(
+    const device T* in [[buffer(0)]],
+    device T* out [[buffer(1)]],
+    constant const int& n [[buffer(2)]],
+    constant const int& stride [[buffer(3)]],
+    constant const float& scale [[buffer(4)]],
+    uint3 elem [[thread_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint3 grid [[threads_per_grid]]) {
+  threadgroup float shared[tg_mem_size];
+  threadgroup float* buf = shared + lid.y * n;
+
+  const int i = elem.x;
+  const int num_threads = grid.x;
+  const size_t row = elem.y;
+  const size_t base = (row / stride) * n * stride + row % stride;
+  in += base;
+  out += base;
+
+  for (int p = i; p < n; p += num_threads) {
+    buf[p] = static_cast<float>(in[size_t(p) * stride]);
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  const int log_n = __builtin_ctz(n);
+  float x[hadamard_max_radix];
+  for (int h = 1, log_h = 0; log_h < log_n;) {
+    const int log_r = min(3, log_n - log_h);
+    const int r = 1 << log_r;
+    for (int g = i; g < (n >> log_r); g += num_threads) {
+      int k = g & (h - 1);
+      int j = ((g - k) << log_r) + k;
+      for (int q = 0; q < r; q++) {
+        x[q] = buf[j + h * q];
+      }
+      switch (r) {
+        case 8:
+          hadamard_radix<8>(x);
+          break;
+        case 4:
+          hadamard_radix<4>(x);
+          break;
+        default:
+          hadamard_radix<2>(x);
+          break;
+      }
+      for (int q = 0; q < r; q++) {
+        buf[j + h * q] = x[q];
+      }
+    }
+    h <<= log_r;
+    log_h += log_r;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+  }
+
+  for (int p = i; p < n; p += num_threads) {
+    out[size_t(p) * stride] = static_cast<T>(buf[p] * scale);
+  }
+}
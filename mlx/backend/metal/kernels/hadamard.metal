@@ -0,0 +1,27 @@
+// Copyright © 2024 Apple Inc.
+
+// clang-format off
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/hadamard.h"
+
+#define instantiate_hadamard(tg_mem_size, tname, type) \
+  instantiate_kernel(                                   \
+      "hadamard_" #tname "_" #tg_mem_size,              \
+      hadamard,                                         \
+      type,                                             \
+      tg_mem_size)
+
+#define instantiate_hadamard_types(tg_mem_size)         \
+  instantiate_hadamard(tg_mem_size, float32, float)     \
+  instantiate_hadamard(tg_mem_size, float16, half)      \
+  instantiate_hadamard(tg_mem_size, bfloat16, bfloat16_t)
+
+// Small rows are batched into 256 elements of threadgroup memory.
+instantiate_hadamard_types(256)
+instantiate_hadamard_types(512)
+instantiate_hadamard_types(1024)
+instantiate_hadamard_types(2048)
+instantiate_hadamard_types(4096)
+// 8192 floats fill the 32KB of threadgroup memory.
+instantiate_hadamard_types(8192) // clang-format on
@@ -0,0 +1,656 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_math>
+#include <metal_simdgroup>
+
+// Each threadgroup factors one row-major N x N matrix with its threads
+// splitting the rows or columns of every step. The matrices are kept in
+// device memory so N is only limited by the size of the buffers.
+
+// Gauss-Jordan elimination with partial pivoting of a against the N x K
+// right hand side x. a is reduced to the identity while x becomes the
+// solution. Singular matrices produce infs and nans.
+void gauss_jordan(
+    device float* a,
+    device float* x,
+    threadgroup int& pivot_row,
+    threadgroup float& pivot,
+    int N,
+    int K,
+    uint tid,
+    uint tsize) {
+  for (int k = 0; k < N; k++) {
+    if (tid == 0) {
+      int p = k;
+      float best = metal::abs(a[k * N + k]);
+      for (int i = k + 1; i < N; i++) {
+        float v = metal::abs(a[i * N + k]);
+        if (v > best) {
+          best = v;
+          p = i;
+        }
+      }
+      pivot_row = p;
+      pivot = a[p * N + k];
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    // Swap the pivot row into place and normalize it
+    int p = pivot_row;
+    float scale = 1.0f / pivot;
+    for (int j = tid; j < N; j += tsize) {
+      float ak = a[k * N + j];
+      float ap = a[p * N + j];
+      a[p * N + j] = ak;
+      a[k * N + j] = ap * scale;
+    }
+    for (int j = tid; j < K; j += tsize) {
+      float xk = x[k * K + j];
+      float xp = x[p * K + j];
+      x[p * K + j] = xk;
+      x[k * K + j] = xp * scale;
+    }
+    threadgroup_barrier(mem_flags::mem_device);
+
+    // Eliminate column k from every other row
+    for (int i = tid; i < N; i += tsize) {
+      if (i == k) {
+        continue;
+      }
+      float f = a[i * N + k];
+      for (int j = 0; j < N; j++) {
+        a[i * N + j] -= f * a[k * N + j];
+      }
+      for (int j = 0; j < K; j++) {
+        x[i * K + j] -= f * x[k * K + j];
+      }
+    }
+    threadgroup_barrier(mem_flags::mem_device | mem_flags::mem_threadgroup);
+  }
+}
+
+// a holds a copy of the input and is destroyed.
+[[kernel]] void inverse(
+    device float* a [[buffer(0)]],
+    device float* inv [[buffer(1)]],
+    constant const int& N [[buffer(2)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint tid [[thread_position_in_threadgroup]],
+    uint tsize [[threads_per_threadgroup]]) {
+  a += size_t(gid) * N * N;
+  inv += size_t(gid) * N * N;
+
+  threadgroup int pivot_row;
+  threadgroup float pivot;
+
+  for (int idx = tid; idx < N * N; idx += tsize) {
+    inv[idx] = (idx / N == idx % N) ? 1.0f : 0.0f;
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+  gauss_jordan(a, inv, pivot_row, pivot, N, N, tid, tsize);
+}
+
+// Solve a x = b with b an N x K matrix. a holds a copy of the input and is
+// destroyed, and x holds a copy of b.
+[[kernel]] void solve(
+    device float* a [[buffer(0)]],
+    device float* x [[buffer(1)]],
+    constant const int& N [[buffer(2)]],
+    constant const int& K [[buffer(3)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint tid [[thread_position_in_threadgroup]],
+    uint tsize [[threads_per_threadgroup]]) {
+  a += size_t(gid) * N * N;
+  x += size_t(gid) * N * K;
+
+  threadgroup int pivot_row;
+  threadgroup float pivot;
+
+  gauss_jordan(a, x, pivot_row, pivot, N, K, tid, tsize);
+}
+
+// Right looking Cholesky factorization. Only the lower triangle of the input
+// is read, or the upper one when computing the upper factor.
+[[kernel]] void cholesky(
+    const device float* in [[buffer(0)]],
+    device float* out [[buffer(1)]],
+    constant const int& N [[buffer(2)]],
+    constant const bool& upper [[buffer(3)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint tid [[thread_position_in_threadgroup]],
+    uint tsize [[threads_per_threadgroup]]) {
+  in += size_t(gid) * N * N;
+  out += size_t(gid) * N * N;
+
+  threadgroup float diag;
+
+  for (int idx = tid; idx < N * N; idx += tsize) {
+    int i = idx / N;
+    int j = idx % N;
+    out[idx] = (j <= i) ? (upper ? in[j * N + i] : in[idx]) : 0.0f;
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+
+  for (int k = 0; k < N; k++) {
+    if (tid == 0) {
+      diag = metal::precise::sqrt(out[k * N + k]);
+      out[k * N + k] = diag;
+    }
+    threadgroup_barrier(mem_flags::mem_device | mem_flags::mem_threadgroup);
+
+    for (int i = k + 1 + tid; i < N; i += tsize) {
+      out[i * N + k] /= diag;
+    }
+    threadgroup_barrier(mem_flags::mem_device);
+
+    for (int i = k + 1 + tid; i < N; i += tsize) {
+      float lik = out[i * N + k];
+      for (int j = k + 1; j <= i; j++) {
+        out[i * N + j] -= lik * out[j * N + k];
+      }
+    }
+    threadgroup_barrier(mem_flags::mem_device);
+  }
+
+  if (upper) {
+    for (int idx = tid; idx < N * N; idx += tsize) {
+      int i = idx / N;
+      int j = idx % N;
+      if (j < i) {
+        out[j * N + i] = out[idx];
+        out[idx] = 0.0f;
+      }
+    }
+  }
+}
+
+// Sweeps after which the Jacobi iterations stop even if some pairs are still
+// above the tolerance
+constant constexpr const int max_jacobi_sweeps = 30;
+
+// The column paired with position k in round r of a round robin over n_pad
+// columns. Position 0 stays fixed and the others rotate so that every pair
+// of columns meets exactly once in n_pad - 1 rounds.
+int round_robin(int k, int r, int n_pad) {
+  return k == 0 ? 0 : (k - 1 + r) % (n_pad - 1) + 1;
+}
+
+// Householder QR of the row-major M x N matrix a which is overwritten by R,
+// while q accumulates the full M x M orthogonal factor. Thread 0 forms each
+// reflector in v and the threads then apply it to the columns of a and the
+// rows of q.
+void householder_qr(
+    device float* a,
+    device float* q,
+    device float* v,
+    threadgroup float& beta,
+    int M,
+    int N,
+    uint tid,
+    uint tsize) {
+  for (int idx = tid; idx < M * M; idx += tsize) {
+    q[idx] = (idx / M == idx % M) ? 1.0f : 0.0f;
+  }
+
+  int K = metal::min(M - 1, N);
+  for (int k = 0; k < K; k++) {
+    threadgroup_barrier(mem_flags::mem_device);
+    if (tid == 0) {
+      float norm = 0.0f;
+      for (int i = k; i < M; i++) {
+        norm += a[i * N + k] * a[i * N + k];
+      }
+      norm = metal::precise::sqrt(norm);
+      float alpha = a[k * N + k] >= 0.0f ? -norm : norm;
+      float v_norm = 0.0f;
+      for (int i = k; i < M; i++) {
+        v[i] = a[i * N + k] - (i == k ? alpha : 0.0f);
+        v_norm += v[i] * v[i];
+      }
+      beta = v_norm > 0.0f ? 2.0f / v_norm : 0.0f;
+    }
+    threadgroup_barrier(mem_flags::mem_device | mem_flags::mem_threadgroup);
+
+    // a <- (I - beta v v^T) a
+    float b = beta;
+    for (int j = k + tid; j < N; j += tsize) {
+      float dot = 0.0f;
+      for (int i = k; i < M; i++) {
+        dot += v[i] * a[i * N + j];
+      }
+      dot *= b;
+      for (int i = k; i < M; i++) {
+        a[i * N + j] -= dot * v[i];
+      }
+    }
+
+    // q <- q (I - beta v v^T)
+    for (int r = tid; r < M; r += tsize) {
+      float dot = 0.0f;
+      for (int i = k; i < M; i++) {
+        dot += q[r * M + i] * v[i];
+      }
+      dot *= b;
+      for (int i = k; i < M; i++) {
+        q[r * M + i] -= dot * v[i];
+      }
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+
+  for (int idx = tid; idx < M * N; idx += tsize) {
+    if (idx / N > idx % N) {
+      a[idx] = 0.0f;
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+}
+
+// QR factorization of a square N x N matrix. v holds N floats of scratch
+// per matrix.
+[[kernel]] void qr(
+    const device float* in [[buffer(0)]],
+    device float* q [[buffer(1)]],
+    device float* r [[buffer(2)]],
+    device float* v [[buffer(3)]],
+    constant const int& N [[buffer(4)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint tid [[thread_position_in_threadgroup]],
+    uint tsize [[threads_per_threadgroup]]) {
+  in += size_t(gid) * N * N;
+  q += size_t(gid) * N * N;
+  r += size_t(gid) * N * N;
+  v += size_t(gid) * N;
+
+  threadgroup float beta;
+
+  for (int idx = tid; idx < N * N; idx += tsize) {
+    r[idx] = in[idx];
+  }
+  householder_qr(r, q, v, beta, N, N, tid, tsize);
+}
+
+// Full SVD of an M x N matrix. The tall matrix B (the input or its transpose
+// when it is wide) is reduced to the n x n triangle R by Householder QR and
+// the columns of R are then orthogonalized by one-sided Jacobi rotations,
+// R V = U1 S, where the pairs of each round are disjoint and rotated in
+// parallel. The scratch of every matrix holds B (m x n), its Q (m x m), V
+// (n x n) and a reflector (m) with m = max(M, N) and n = min(M, N).
+[[kernel]] void svd(
+    const device float* in [[buffer(0)]],
+    device float* u [[buffer(1)]],
+    device float* s [[buffer(2)]],
+    device float* vt [[buffer(3)]],
+    device float* scratch [[buffer(4)]],
+    constant const int& M [[buffer(5)]],
+    constant const int& N [[buffer(6)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint tid [[thread_position_in_threadgroup]],
+    uint tsize [[threads_per_threadgroup]]) {
+  bool wide = N > M;
+  int m = wide ? N : M;
+  int n = wide ? M : N;
+  in += size_t(gid) * M * N;
+  u += size_t(gid) * M * M;
+  s += size_t(gid) * n;
+  vt += size_t(gid) * N * N;
+  device float* a = scratch + size_t(gid) * (m * n + m * m + n * n + m);
+  device float* q = a + m * n;
+  device float* v = q + m * m;
+  device float* h = v + n * n;
+
+  threadgroup float beta;
+  threadgroup bool rotated;
+
+  for (int idx = tid; idx < m * n; idx += tsize) {
+    int i = idx / n;
+    int j = idx % n;
+    a[idx] = wide ? in[j * N + i] : in[idx];
+  }
+  for (int idx = tid; idx < n * n; idx += tsize) {
+    v[idx] = (idx / n == idx % n) ? 1.0f : 0.0f;
+  }
+  householder_qr(a, q, h, beta, m, n, tid, tsize);
+
+  // One-sided Jacobi on the first n rows of a, i.e. W = R V
+  int n_pad = n + (n & 1);
+  float tol = float(n) * FLT_EPSILON;
+  for (int sweep = 0; sweep < max_jacobi_sweeps; sweep++) {
+    if (tid == 0) {
+      rotated = false;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    for (int round = 0; round < n_pad - 1; round++) {
+      for (int k = tid; k < n_pad / 2; k += tsize) {
+        int p = round_robin(k, round, n_pad);
+        int r = round_robin(n_pad - 1 - k, round, n_pad);
+        if (p >= n || r >= n) {
+          continue;
+        }
+        float alpha = 0.0f;
+        float gamma = 0.0f;
+        float delta = 0.0f;
+        for (int i = 0; i < n; i++) {
+          float wp = a[i * n + p];
+          float wr = a[i * n + r];
+          alpha += wp * wp;
+          delta += wr * wr;
+          gamma += wp * wr;
+        }
+        if (metal::abs(gamma) <= tol * metal::precise::sqrt(alpha * delta)) {
+          continue;
+        }
+        rotated = true;
+        float zeta = (delta - alpha) / (2.0f * gamma);
+        float t = metal::sign(zeta) /
+            (metal::abs(zeta) + metal::precise::sqrt(1.0f + zeta * zeta));
+        t = zeta == 0.0f ? 1.0f : t;
+        float c = metal::precise::rsqrt(1.0f + t * t);
+        float sn = c * t;
+        for (int i = 0; i < n; i++) {
+          float wp = a[i * n + p];
+          float wr = a[i * n + r];
+          a[i * n + p] = c * wp - sn * wr;
+          a[i * n + r] = sn * wp + c * wr;
+          float vp = v[i * n + p];
+          float vr = v[i * n + r];
+          v[i * n + p] = c * vp - sn * vr;
+          v[i * n + r] = sn * vp + c * vr;
+        }
+      }
+      threadgroup_barrier(mem_flags::mem_device | mem_flags::mem_threadgroup);
+    }
+    bool done = !rotated;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (done) {
+      break;
+    }
+  }
+
+  // The singular values are the column norms of W, sorted in descending
+  // order together with the columns of W and V
+  for (int j = tid; j < n; j += tsize) {
+    float norm = 0.0f;
+    for (int i = 0; i < n; i++) {
+      norm += a[i * n + j] * a[i * n + j];
+    }
+    s[j] = metal::precise::sqrt(norm);
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+  if (tid == 0) {
+    for (int j = 0; j < n; j++) {
+      int best = j;
+      for (int k = j + 1; k < n; k++) {
+        best = s[k] > s[best] ? k : best;
+      }
+      if (best != j) {
+        float tmp = s[j];
+        s[j] = s[best];
+        s[best] = tmp;
+        for (int i = 0; i < n; i++) {
+          tmp = a[i * n + j];
+          a[i * n + j] = a[i * n + best];
+          a[i * n + best] = tmp;
+          tmp = v[i * n + j];
+          v[i * n + j] = v[i * n + best];
+          v[i * n + best] = tmp;
+        }
+      }
+    }
+
+    // Normalize the columns of W into U1 and complete the ones with a
+    // negligible singular value to an orthonormal basis
+    float cutoff = s[0] * tol;
+    for (int j = 0; j < n; j++) {
+      if (s[j] > cutoff && s[j] > 0.0f) {
+        float scale = 1.0f / s[j];
+        for (int i = 0; i < n; i++) {
+          a[i * n + j] *= scale;
+        }
+        continue;
+      }
+      for (int e = 0; e < n; e++) {
+        for (int i = 0; i < n; i++) {
+          a[i * n + j] = (i == e) ? 1.0f : 0.0f;
+        }
+        for (int pass = 0; pass < 2; pass++) {
+          for (int k = 0; k < j; k++) {
+            float dot = 0.0f;
+            for (int i = 0; i < n; i++) {
+              dot += a[i * n + k] * a[i * n + j];
+            }
+            for (int i = 0; i < n; i++) {
+              a[i * n + j] -= dot * a[i * n + k];
+            }
+          }
+        }
+        float norm = 0.0f;
+        for (int i = 0; i < n; i++) {
+          norm += a[i * n + j] * a[i * n + j];
+        }
+        if (norm > 0.25f) {
+          float scale = metal::precise::rsqrt(norm);
+          for (int i = 0; i < n; i++) {
+            a[i * n + j] *= scale;
+          }
+          break;
+        }
+      }
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+
+  // B = [Q[:, :n] U1, Q[:, n:]] S V^T and A is B or its transpose
+  for (int idx = tid; idx < m * m; idx += tsize) {
+    int i = idx / m;
+    int j = idx % m;
+    float ub = 0.0f;
+    if (j < n) {
+      for (int k = 0; k < n; k++) {
+        ub += q[i * m + k] * a[k * n + j];
+      }
+    } else {
+      ub = q[idx];
+    }
+    if (wide) {
+      vt[j * m + i] = ub;
+    } else {
+      u[idx] = ub;
+    }
+  }
+  for (int idx = tid; idx < n * n; idx += tsize) {
+    int i = idx / n;
+    int j = idx % n;
+    if (wide) {
+      u[idx] = v[idx];
+    } else {
+      vt[j * n + i] = v[idx];
+    }
+  }
+}
+
+// Eigendecomposition of a symmetric N x N matrix by two-sided Jacobi
+// rotations. The pairs of each round are disjoint so their rotations are
+// found together and then applied to the rows and to the columns in two
+// parallel passes. Only the lower triangle of the input is read, or the
+// upper one when uplo is 'U'. The scratch of every matrix holds the working
+// copy (N x N) and a rotation per pair (N + 1).
+[[kernel]] void eigh(
+    const device float* in [[buffer(0)]],
+    device float* w [[buffer(1)]],
+    device float* v [[buffer(2)]],
+    device float* scratch [[buffer(3)]],
+    constant const int& N [[buffer(4)]],
+    constant const bool& upper [[buffer(5)]],
+    constant const bool& compute_eigenvectors [[buffer(6)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint tid [[thread_position_in_threadgroup]],
+    uint tsize [[threads_per_threadgroup]]) {
+  in += size_t(gid) * N * N;
+  w += size_t(gid) * N;
+  v += compute_eigenvectors ? size_t(gid) * N * N : 0;
+  device float* a = scratch + size_t(gid) * (N * N + N + 1);
+  device float* rot = a + N * N;
+
+  threadgroup bool rotated;
+
+  for (int idx = tid; idx < N * N; idx += tsize) {
+    int i = idx / N;
+    int j = idx % N;
+    bool stored = upper ? j >= i : j <= i;
+    a[idx] = stored ? in[idx] : in[j * N + i];
+    if (compute_eigenvectors) {
+      v[idx] = (i == j) ? 1.0f : 0.0f;
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+
+  int n_pad = N + (N & 1);
+  int n_pairs = n_pad / 2;
+  for (int sweep = 0; sweep < max_jacobi_sweeps; sweep++) {
+    if (tid == 0) {
+      rotated = false;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    for (int round = 0; round < n_pad - 1; round++) {
+      // The rotation zeroing a_pq of every pair
+      for (int k = tid; k < n_pairs; k += tsize) {
+        int p = round_robin(k, round, n_pad);
+        int q = round_robin(n_pad - 1 - k, round, n_pad);
+        float c = 1.0f;
+        float sn = 0.0f;
+        if (p < N && q < N) {
+          float app = a[p * N + p];
+          float aqq = a[q * N + q];
+          float apq = a[p * N + q];
+          if (metal::abs(apq) >
+              FLT_EPSILON * metal::precise::sqrt(metal::abs(app * aqq))) {
+            rotated = true;
+            float tau = (aqq - app) / (2.0f * apq);
+            float t = metal::sign(tau) /
+                (metal::abs(tau) + metal::precise::sqrt(1.0f + tau * tau));
+            t = tau == 0.0f ? 1.0f : t;
+            c = metal::precise::rsqrt(1.0f + t * t);
+            sn = c * t;
+          }
+        }
+        rot[2 * k] = c;
+        rot[2 * k + 1] = sn;
+      }
+      threadgroup_barrier(mem_flags::mem_device | mem_flags::mem_threadgroup);
+
+      // a <- J^T a
+      for (int idx = tid; idx < n_pairs * N; idx += tsize) {
+        int k = idx / N;
+        int col = idx % N;
+        float sn = rot[2 * k + 1];
+        if (sn == 0.0f) {
+          continue;
+        }
+        float c = rot[2 * k];
+        int p = round_robin(k, round, n_pad);
+        int q = round_robin(n_pad - 1 - k, round, n_pad);
+        float ap = a[p * N + col];
+        float aq = a[q * N + col];
+        a[p * N + col] = c * ap - sn * aq;
+        a[q * N + col] = sn * ap + c * aq;
+      }
+      threadgroup_barrier(mem_flags::mem_device);
+
+      // a <- a J and v <- v J
+      for (int idx = tid; idx < n_pairs * N; idx += tsize) {
+        int k = idx / N;
+        int row = idx % N;
+        float sn = rot[2 * k + 1];
+        if (sn == 0.0f) {
+          continue;
+        }
+        float c = rot[2 * k];
+        int p = round_robin(k, round, n_pad);
+        int q = round_robin(n_pad - 1 - k, round, n_pad);
+        float ap = a[row * N + p];
+        float aq = a[row * N + q];
+        a[row * N + p] = c * ap - sn * aq;
+        a[row * N + q] = sn * ap + c * aq;
+        if (compute_eigenvectors) {
+          float vp = v[row * N + p];
+          float vq = v[row * N + q];
+          v[row * N + p] = c * vp - sn * vq;
+          v[row * N + q] = sn * vp + c * vq;
+        }
+      }
+      threadgroup_barrier(mem_flags::mem_device);
+    }
+    bool done = !rotated;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (done) {
+      break;
+    }
+  }
+
+  // Sort the eigenvalues in ascending order together with the eigenvectors
+  for (int i = tid; i < N; i += tsize) {
+    w[i] = a[i * N + i];
+  }
+  threadgroup_barrier(mem_flags::mem_device);
+  if (tid == 0) {
+    for (int j = 0; j < N; j++) {
+      int best = j;
+      for (int k = j + 1; k < N; k++) {
+        best = w[k] < w[best] ? k : best;
+      }
+      if (best == j) {
+        continue;
+      }
+      float tmp = w[j];
+      w[j] = w[best];
+      w[best] = tmp;
+      if (compute_eigenvectors) {
+        for (int i = 0; i < N; i++) {
+          tmp = v[i * N + j];
+          v[i * N + j] = v[i * N + best];
+          v[i * N + best] = tmp;
+        }
+      }
+    }
+  }
+}
+
+// Triangular solve a x = b with b an N x K matrix. Every simdgroup finds one
+// column of x by substitution, reducing each row of a against the entries
+// of x found so far with a simd sum. Only the requested triangle of a is
+// read.
+[[kernel]] void solve_triangular(
+    const device float* a [[buffer(0)]],
+    const device float* b [[buffer(1)]],
+    device float* x [[buffer(2)]],
+    constant const int& N [[buffer(3)]],
+    constant const int& K [[buffer(4)]],
+    constant const bool& upper [[buffer(5)]],
+    uint2 gid [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]],
+    uint2 lsize [[threads_per_threadgroup]],
+    uint simd_lane [[thread_index_in_simdgroup]]) {
+  int col = gid.x * lsize.y + lid.y;
+  if (col >= K) {
+    return;
+  }
+  a += size_t(gid.y) * N * N;
+  b += size_t(gid.y) * N * K;
+  x += size_t(gid.y) * N * K;
+
+  for (int n = 0; n < N; n++) {
+    int i = upper ? N - 1 - n : n;
+    int j0 = upper ? i + 1 : 0;
+    int j1 = upper ? N : i;
+    float partial = 0.0f;
+    for (int j = j0 + simd_lane; j < j1; j += 32) {
+      partial += a[i * N + j] * x[j * K + col];
+    }
+    float total = metal::simd_sum(partial);
+    if (simd_lane == 0) {
+      x[i * K + col] = (b[i * K + col] - total) / a[i * N + i];
+    }
+    simdgroup_barrier(mem_flags::mem_device);
+  }
+}
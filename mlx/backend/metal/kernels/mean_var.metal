@@ -0,0 +1,78 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_common>
+#include <metal_simdgroup>
+
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/utils.h"
+#include "mlx/backend/metal/kernels/welford.h"
+
+using namespace metal;
+
+// One threadgroup per output. The reduced elements are located with their
+// own shape and strides and the output with the strides of the kept axes so
+// the input is read in place whatever its layout.
+template <typename T>
+[[kernel]] void mean_var(
+    const device T* x [[buffer(0)]],
+    device T* mean [[buffer(1)]],
+    device T* var [[buffer(2)]],
+    const constant size_t& reduction_size [[buffer(3)]],
+    const constant int* reduce_shape [[buffer(4)]],
+    const constant size_t* reduce_strides [[buffer(5)]],
+    const constant int& reduce_ndim [[buffer(6)]],
+    const constant int* out_shape [[buffer(7)]],
+    const constant size_t* out_strides [[buffer(8)]],
+    const constant int& out_ndim [[buffer(9)]],
+    const constant int& ddof [[buffer(10)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  constexpr int SIMD_SIZE = 32;
+
+  threadgroup float local_n[SIMD_SIZE];
+  threadgroup float local_mean[SIMD_SIZE];
+  threadgroup float local_m2[SIMD_SIZE];
+
+  x += elem_to_loc(gid, out_shape, out_strides, out_ndim);
+
+  Welford w;
+  for (size_t i = lid; i < reduction_size; i += lsize) {
+    w.update(x[elem_to_loc(i, reduce_shape, reduce_strides, reduce_ndim)]);
+  }
+  w.threadgroup_combine(
+      local_n, local_mean, local_m2, simd_lane_id, simd_group_id);
+
+  if (lid == 0) {
+    mean[gid] = static_cast<T>(w.mean);
+    var[gid] = static_cast<T>(w.m2 / metal::max(w.n - ddof, 0.0f));
+  }
+}
+
+// clang-format off
+#define instantiate_mean_var(name, itype)                    \
+  template [[host_name("mean_var" #name)]] [[kernel]] void   \
+  mean_var<itype>(                                           \
+      const device itype* x [[buffer(0)]],                   \
+      device itype* mean [[buffer(1)]],                      \
+      device itype* var [[buffer(2)]],                       \
+      const constant size_t& reduction_size [[buffer(3)]],   \
+      const constant int* reduce_shape [[buffer(4)]],        \
+      const constant size_t* reduce_strides [[buffer(5)]],   \
+      const constant int& reduce_ndim [[buffer(6)]],         \
+      const constant int* out_shape [[buffer(7)]],           \
+      const constant size_t* out_strides [[buffer(8)]],      \
+      const constant int& out_ndim [[buffer(9)]],            \
+      const constant int& ddof [[buffer(10)]],               \
+      uint gid [[threadgroup_position_in_grid]],             \
+      uint lid [[thread_position_in_threadgroup]],           \
+      uint lsize [[threads_per_threadgroup]],                \
+      uint simd_lane_id [[thread_index_in_simdgroup]],       \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+
+instantiate_mean_var(float32, float)
+instantiate_mean_var(float16, half)
+instantiate_mean_var(bfloat16, bfloat16_t) // clang-format on
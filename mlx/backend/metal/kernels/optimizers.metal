@@ -0,0 +1,69 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_common>
+#include <metal_math>
+
+// clang-format off
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/utils.h"
+// clang-format on
+
+using namespace metal;
+
+// Each thread updates one element of a parameter and its states in float32.
+// The outputs may share the buffers of the inputs when they were donated.
+template <typename T>
+[[kernel]] void adam_update(
+    const device T* p [[buffer(0)]],
+    const device T* g [[buffer(1)]],
+    const device T* m [[buffer(2)]],
+    const device T* v [[buffer(3)]],
+    const device float* lr [[buffer(4)]],
+    device T* p_out [[buffer(5)]],
+    device T* m_out [[buffer(6)]],
+    device T* v_out [[buffer(7)]],
+    constant const float& beta1 [[buffer(8)]],
+    constant const float& beta2 [[buffer(9)]],
+    constant const float& eps [[buffer(10)]],
+    constant const float& weight_decay [[buffer(11)]],
+    uint index [[thread_position_in_grid]]) {
+  float step = lr[0];
+  float gi = g[index];
+  float mi = beta1 * float(m[index]) + (1.0f - beta1) * gi;
+  float vi = beta2 * float(v[index]) + (1.0f - beta2) * gi * gi;
+  float pi = float(p[index]) * (1.0f - step * weight_decay);
+  p_out[index] = static_cast<T>(pi - step * mi / (metal::sqrt(vi) + eps));
+  m_out[index] = static_cast<T>(mi);
+  v_out[index] = static_cast<T>(vi);
+}
+
+template <typename T>
+[[kernel]] void lion_update(
+    const device T* p [[buffer(0)]],
+    const device T* g [[buffer(1)]],
+    const device T* m [[buffer(2)]],
+    const device float* lr [[buffer(3)]],
+    device T* p_out [[buffer(4)]],
+    device T* m_out [[buffer(5)]],
+    constant const float& beta1 [[buffer(6)]],
+    constant const float& beta2 [[buffer(7)]],
+    constant const float& weight_decay [[buffer(8)]],
+    uint index [[thread_position_in_grid]]) {
+  float step = lr[0];
+  float gi = g[index];
+  float mi = m[index];
+  float c = beta1 * mi + (1.0f - beta1) * gi;
+  float pi = float(p[index]) * (1.0f - step * weight_decay);
+  p_out[index] = static_cast<T>(pi - step * metal::sign(c));
+  m_out[index] = static_cast<T>(beta2 * mi + (1.0f - beta2) * gi);
+}
+
+#define instantiate_optimizers(name, type)                    \
+  instantiate_kernel("adam_update_" #name, adam_update, type) \
+  instantiate_kernel("lion_update_" #name, lion_update, type)
+
+// clang-format off
+instantiate_optimizers(float32, float)
+instantiate_optimizers(float16, half)
+instantiate_optimizers(bfloat16, bfloat16_t) // clang-format on
@@ -9,11 +9,118 @@ using namespace metal;
 
 MLX_MTL_CONST int SIMD_SIZE = 32;
 
+// Function constants selecting the terms of the epilogue of the *_epilogue
+// kernels
+constant bool qmm_has_bias [[function_constant(400)]];
+constant bool qmm_has_gate [[function_constant(401)]];
+constant bool qmm_has_residual [[function_constant(402)]];
+constant bool qmm_has_lora [[function_constant(403)]];
+constant bool qmm_has_adapter_ids [[function_constant(404)]];
+
+// Computes silu(gate) * (y + bias) + residual for the element of the output
+// at (row, col), the missing terms are null
+template <typename T>
+struct QuantizedEpilogue {
+  const device T* bias = nullptr;
+  const device T* gate = nullptr;
+  const device T* residual = nullptr;
+
+  METAL_FUNC bool empty() const {
+    return bias == nullptr && gate == nullptr && residual == nullptr;
+  }
+
+  METAL_FUNC float apply(float y, int row, int col, int ld) const {
+    if (bias != nullptr) {
+      y += static_cast<float>(bias[col]);
+    }
+    if (gate != nullptr) {
+      float g = static_cast<float>(gate[row * ld + col]);
+      y *= g / (1.0f + metal::exp(-g));
+    }
+    if (residual != nullptr) {
+      y += static_cast<float>(residual[row * ld + col]);
+    }
+    return y;
+  }
+};
+
+// The low-rank update of a LoRA adapter added to the product. x_a holds the
+// rows of x times the scaled first adapter matrix, (M, rank), and b is the
+// second adapter matrix, (N, rank), or the stack of those of all adapters
+// when adapter_ids selects one per row.
+template <typename T>
+struct LoRAUpdate {
+  const device T* x_a = nullptr;
+  const device T* b = nullptr;
+  const device uint32_t* adapter_ids = nullptr;
+  int rank = 0;
+
+  METAL_FUNC bool empty() const {
+    return x_a == nullptr;
+  }
+
+  // The adapter id of row, 0 without adapter_ids
+  METAL_FUNC uint32_t adapter(int row) const {
+    return adapter_ids == nullptr ? 0 : adapter_ids[row];
+  }
+
+  // The second matrix of the adapter of row, which has N rows
+  METAL_FUNC const device T* adapter_b(int row, int N) const {
+    return b + size_t(adapter(row)) * N * rank;
+  }
+};
+
+// Binary epilogues of BlockMMA::apply_epilogue
+struct EpilogueAdd {
+  template <typename U>
+  METAL_FUNC float apply(float y, U c) const {
+    return y + static_cast<float>(c);
+  }
+};
+
+struct EpilogueSiluMul {
+  template <typename U>
+  METAL_FUNC float apply(float y, U c) const {
+    float g = static_cast<float>(c);
+    return y * g / (1.0f + metal::exp(-g));
+  }
+};
+
+// Combines the tile of results of mma_op with the matching tile of c whose
+// rows are ldc apart
+template <typename T, typename MMA, typename Op>
+METAL_FUNC void apply_mma_epilogue(
+    thread MMA& mma_op,
+    const device T* c,
+    int ldc,
+    short2 tile_dims,
+    bool safe,
+    thread const Op& op) {
+  if (safe) {
+    mma_op.apply_epilogue_safe(c, ldc, 1, tile_dims, op);
+  } else {
+    mma_op.apply_epilogue(c, ldc, 1, op);
+  }
+}
+
+// 3 and 6 bit values don't fit evenly in a uint32 so they are stored in
+// packs of 3 bytes holding 8 and 4 values respectively. The other widths are
+// packed in uint32s.
+template <int bits>
+constexpr int get_pack_factor() {
+  return bits == 3 ? 8 : bits == 6 ? 4 : 32 / bits;
+}
+
+template <int bits>
+constexpr int get_bytes_per_pack() {
+  return (bits & (bits - 1)) == 0 ? 4 : 3;
+}
+
 template <typename T, typename U, int values_per_thread, int bits>
 inline U load_vector(const device T* x, thread U* x_thread) {
   static_assert(
-      bits == 2 || bits == 4 || bits == 8,
-      "Template undefined for bits not in {2, 4, 8}");
+      bits == 2 || bits == 3 || bits == 4 || bits == 6 || bits == 8,
+      "Template undefined for bits not in {2, 3, 4, 6, 8}");
 
   U sum = 0;
 
@@ -27,6 +134,21 @@ inline U load_vector(const device T* x, thread U* x_thread) {
     }
   }
 
+  else if (bits == 3) {
+    for (int i = 0; i < values_per_thread; i += 8) {
+      sum += x[i] + x[i + 1] + x[i + 2] + x[i + 3] + x[i + 4] + x[i + 5] +
+          x[i + 6] + x[i + 7];
+      x_thread[i] = x[i];
+      x_thread[i + 1] = x[i + 1] / 8.0f;
+      x_thread[i + 2] = x[i + 2] / 64.0f;
+      x_thread[i + 3] = x[i + 3] / 2.0f;
+      x_thread[i + 4] = x[i + 4] / 16.0f;
+      x_thread[i + 5] = x[i + 5] / 128.0f;
+      x_thread[i + 6] = x[i + 6] / 4.0f;
+      x_thread[i + 7] = x[i + 7] / 32.0f;
+    }
+  }
+
   else if (bits == 4) {
     for (int i = 0; i < values_per_thread; i += 4) {
       sum += x[i] + x[i + 1] + x[i + 2] + x[i + 3];
@@ -37,6 +159,16 @@ inline U load_vector(const device T* x, thread U* x_thread) {
     }
   }
 
+  else if (bits == 6) {
+    for (int i = 0; i < values_per_thread; i += 4) {
+      sum += x[i] + x[i + 1] + x[i + 2] + x[i + 3];
+      x_thread[i] = x[i];
+      x_thread[i + 1] = x[i + 1] / 64.0f;
+      x_thread[i + 2] = x[i + 2] / 16.0f;
+      x_thread[i + 3] = x[i + 3] / 4.0f;
+    }
+  }
+
   else if (bits == 8) {
     for (int i = 0; i < values_per_thread; i++) {
       sum += x[i];
@@ -50,8 +182,8 @@ inline U load_vector(const device T* x, thread U* x_thread) {
 template <typename T, typename U, int values_per_thread, int bits>
 inline U load_vector_safe(const device T* x, thread U* x_thread, int N) {
   static_assert(
-      bits == 2 || bits == 4 || bits == 8,
-      "Template undefined for bits not in {2, 4, 8}");
+      bits == 2 || bits == 3 || bits == 4 || bits == 6 || bits == 8,
+      "Template undefined for bits not in {2, 3, 4, 6, 8}");
 
   U sum = 0;
 
@@ -63,8 +195,20 @@ inline U load_vector_safe(const device T* x, thread U* x_thread, int N) {
       x_thread[i + 2] = x[i + 2] / 16.0f;
       x_thread[i + 3] = x[i + 3] / 64.0f;
     }
-    for (int i = N; i < values_per_thread; i++) {
-      x_thread[i] = 0;
+  }
+
+  else if (bits == 3) {
+    for (int i = 0; i < N; i += 8) {
+      sum += x[i] + x[i + 1] + x[i + 2] + x[i + 3] + x[i + 4] + x[i + 5] +
+          x[i + 6] + x[i + 7];
+      x_thread[i] = x[i];
+      x_thread[i + 1] = x[i + 1] / 8.0f;
+      x_thread[i + 2] = x[i + 2] / 64.0f;
+      x_thread[i + 3] = x[i + 3] / 2.0f;
+      x_thread[i + 4] = x[i + 4] / 16.0f;
+      x_thread[i + 5] = x[i + 5] / 128.0f;
+      x_thread[i + 6] = x[i + 6] / 4.0f;
+      x_thread[i + 7] = x[i + 7] / 32.0f;
     }
   }
 
@@ -76,8 +220,15 @@ inline U load_vector_safe(const device T* x, thread U* x_thread, int N) {
       x_thread[i + 2] = x[i + 2] / 256.0f;
       x_thread[i + 3] = x[i + 3] / 4096.0f;
     }
-    for (int i = N; i < values_per_thread; i++) {
-      x_thread[i] = 0;
+  }
+
+  else if (bits == 6) {
+    for (int i = 0; i < N; i += 4) {
+      sum += x[i] + x[i + 1] + x[i + 2] + x[i + 3];
+      x_thread[i] = x[i];
+      x_thread[i + 1] = x[i + 1] / 64.0f;
+      x_thread[i + 2] = x[i + 2] / 16.0f;
+      x_thread[i + 3] = x[i + 3] / 4.0f;
     }
   }
 
@@ -86,14 +237,35 @@ inline U load_vector_safe(const device T* x, thread U* x_thread, int N) {
       sum += x[i];
       x_thread[i] = x[i];
     }
-    for (int i = N; i < values_per_thread; i++) {
-      x_thread[i] = 0;
-    }
+  }
+
+  for (int i = N; i < values_per_thread; i++) {
+    x_thread[i] = 0;
   }
 
   return sum;
 }
 
+// Dot product of the x_thread prepared by load_vector with the 3 bit pack
+// in w. The values are masked in place and load_vector has divided x by
+// the power of 2 that leaves them at.
+template <typename U>
+inline U qdot_pack_3bit(const device uint8_t* w, const thread U* x_thread) {
+  return x_thread[0] * (w[0] & 0x07) + x_thread[1] * (w[0] & 0x38) +
+      x_thread[2] * ((w[0] & 0xc0) + ((w[1] & 0x01) << 8)) +
+      x_thread[3] * (w[1] & 0x0e) + x_thread[4] * (w[1] & 0x70) +
+      x_thread[5] * ((w[1] & 0x80) + ((w[2] & 0x03) << 8)) +
+      x_thread[6] * (w[2] & 0x1c) + x_thread[7] * (w[2] & 0xe0);
+}
+
+template <typename U>
+inline U qdot_pack_6bit(const device uint8_t* w, const thread U* x_thread) {
+  return x_thread[0] * (w[0] & 0x3f) +
+      x_thread[1] * ((w[0] & 0xc0) + ((w[1] & 0x0f) << 8)) +
+      x_thread[2] * ((w[1] & 0xf0) + ((w[2] & 0x03) << 8)) +
+      x_thread[3] * (w[2] & 0xfc);
+}
+
 template <typename U, int values_per_thread, int bits>
 inline U qdot(
     const device uint8_t* w,
@@ -102,8 +274,8 @@ inline U qdot(
     U bias,
     U sum) {
   static_assert(
-      bits == 2 || bits == 4 || bits == 8,
-      "Template undefined for bits not in {2, 4, 8}");
+      bits == 2 || bits == 3 || bits == 4 || bits == 6 || bits == 8,
+      "Template undefined for bits not in {2, 3, 4, 6, 8}");
 
   U accum = 0;
 
@@ -117,6 +289,12 @@ inline U qdot(
     }
   }
 
+  else if (bits == 3) {
+    for (int i = 0; i < (values_per_thread / 8); i++) {
+      accum += qdot_pack_3bit(w + 3 * i, x_thread + 8 * i);
+    }
+  }
+
   else if (bits == 4) {
     const device uint16_t* ws = (const device uint16_t*)w;
     for (int i = 0; i < (values_per_thread / 4); i++) {
@@ -128,6 +306,12 @@ inline U qdot(
     }
   }
 
+  else if (bits == 6) {
+    for (int i = 0; i < (values_per_thread / 4); i++) {
+      accum += qdot_pack_6bit(w + 3 * i, x_thread + 4 * i);
+    }
+  }
+
   else if (bits == 8) {
     for (int i = 0; i < values_per_thread; i++) {
       accum += x_thread[i] * w[i];
@@ -146,8 +330,8 @@ inline U qdot_safe(
     U sum,
     int N) {
   static_assert(
-      bits == 2 || bits == 4 || bits == 8,
-      "Template undefined for bits not in {2, 4, 8}");
+      bits == 2 || bits == 3 || bits == 4 || bits == 6 || bits == 8,
+      "Template undefined for bits not in {2, 3, 4, 6, 8}");
 
   U accum = 0;
 
@@ -161,6 +345,12 @@ inline U qdot_safe(
     }
   }
 
+  else if (bits == 3) {
+    for (int i = 0; i < (N / 8); i++) {
+      accum += qdot_pack_3bit(w + 3 * i, x_thread + 8 * i);
+    }
+  }
+
   else if (bits == 4) {
     const device uint16_t* ws = (const device uint16_t*)w;
     for (int i = 0; i < (N / 4); i++) {
@@ -172,6 +362,12 @@ inline U qdot_safe(
     }
   }
 
+  else if (bits == 6) {
+    for (int i = 0; i < (N / 4); i++) {
+      accum += qdot_pack_6bit(w + 3 * i, x_thread + 4 * i);
+    }
+  }
+
   else if (bits == 8) {
     for (int i = 0; i < N; i++) {
       accum += x_thread[i] * w[i];
@@ -185,8 +381,8 @@ template <typename U, int values_per_thread, int bits>
 inline void
 qouter(const thread uint8_t* w, U x, U scale, U bias, thread U* result) {
   static_assert(
-      bits == 2 || bits == 4 || bits == 8,
-      "Template undefined for bits not in {2, 4, 8}");
+      bits == 2 || bits == 3 || bits == 4 || bits == 6 || bits == 8,
+      "Template undefined for bits not in {2, 3, 4, 6, 8}");
 
   if (bits == 2) {
     U s[4] = {scale, scale / 4.0f, scale / 16.0f, scale / 64.0f};
@@ -198,6 +394,23 @@ qouter(const thread uint8_t* w, U x, U scale, U bias, thread U* result) {
     }
   }
 
+  else if (bits == 3) {
+    for (int i = 0; i < (values_per_thread / 8); i++) {
+      const thread uint8_t* wi = w + 3 * i;
+      thread U* r = result + 8 * i;
+      r[0] += x * (scale * (wi[0] & 0x07) + bias);
+      r[1] += x * (scale * ((wi[0] & 0x38) >> 3) + bias);
+      r[2] +=
+          x * (scale * (((wi[0] & 0xc0) >> 6) + ((wi[1] & 0x01) << 2)) + bias);
+      r[3] += x * (scale * ((wi[1] & 0x0e) >> 1) + bias);
+      r[4] += x * (scale * ((wi[1] & 0x70) >> 4) + bias);
+      r[5] +=
+          x * (scale * (((wi[1] & 0x80) >> 7) + ((wi[2] & 0x03) << 1)) + bias);
+      r[6] += x * (scale * ((wi[2] & 0x1c) >> 2) + bias);
+      r[7] += x * (scale * ((wi[2] & 0xe0) >> 5) + bias);
+    }
+  }
+
   else if (bits == 4) {
     U s[2] = {scale, scale / 16.0f};
     for (int i = 0; i < (values_per_thread / 2); i++) {
@@ -206,6 +419,19 @@ qouter(const thread uint8_t* w, U x, U scale, U bias, thread U* result) {
     }
   }
 
+  else if (bits == 6) {
+    for (int i = 0; i < (values_per_thread / 4); i++) {
+      const thread uint8_t* wi = w + 3 * i;
+      thread U* r = result + 4 * i;
+      r[0] += x * (scale * (wi[0] & 0x3f) + bias);
+      r[1] +=
+          x * (scale * (((wi[0] & 0xc0) >> 6) + ((wi[1] & 0x0f) << 2)) + bias);
+      r[2] +=
+          x * (scale * (((wi[1] & 0xf0) >> 4) + ((wi[2] & 0x03) << 4)) + bias);
+      r[3] += x * (scale * ((wi[2] & 0xfc) >> 2) + bias);
+    }
+  }
+
   else if (bits == 8) {
     for (int i = 0; i < values_per_thread; i++) {
       result[i] += x * (scale * w[i] + bias);
@@ -217,8 +443,8 @@ template <typename U, int N, int bits>
 inline void
 dequantize(const device uint8_t* w, U scale, U bias, threadgroup U* w_local) {
   static_assert(
-      bits == 2 || bits == 4 || bits == 8,
-      "Template undefined for bits not in {2, 4, 8}");
+      bits == 2 || bits == 3 || bits == 4 || bits == 6 || bits == 8,
+      "Template undefined for bits not in {2, 3, 4, 6, 8}");
 
   if (bits == 2) {
     U s[4] = {
@@ -234,6 +460,21 @@ dequantize(const device uint8_t* w, U scale, U bias, threadgroup U* w_local) {
     }
   }
 
+  else if (bits == 3) {
+    for (int i = 0; i < (N / 8); i++) {
+      const device uint8_t* wi = w + 3 * i;
+      threadgroup U* wl = w_local + 8 * i;
+      wl[0] = scale * (wi[0] & 0x07) + bias;
+      wl[1] = scale * ((wi[0] & 0x38) >> 3) + bias;
+      wl[2] = scale * (((wi[0] & 0xc0) >> 6) + ((wi[1] & 0x01) << 2)) + bias;
+      wl[3] = scale * ((wi[1] & 0x0e) >> 1) + bias;
+      wl[4] = scale * ((wi[1] & 0x70) >> 4) + bias;
+      wl[5] = scale * (((wi[1] & 0x80) >> 7) + ((wi[2] & 0x03) << 1)) + bias;
+      wl[6] = scale * ((wi[2] & 0x1c) >> 2) + bias;
+      wl[7] = scale * ((wi[2] & 0xe0) >> 5) + bias;
+    }
+  }
+
   else if (bits == 4) {
     U s[2] = {scale, scale / static_cast<U>(16.0f)};
     for (int i = 0; i < (N / 2); i++) {
@@ -242,6 +483,17 @@ dequantize(const device uint8_t* w, U scale, U bias, threadgroup U* w_local) {
     }
   }
 
+  else if (bits == 6) {
+    for (int i = 0; i < (N / 4); i++) {
+      const device uint8_t* wi = w + 3 * i;
+      threadgroup U* wl = w_local + 4 * i;
+      wl[0] = scale * (wi[0] & 0x3f) + bias;
+      wl[1] = scale * (((wi[0] & 0xc0) >> 6) + ((wi[1] & 0x0f) << 2)) + bias;
+      wl[2] = scale * (((wi[1] & 0xf0) >> 4) + ((wi[2] & 0x03) << 4)) + bias;
+      wl[3] = scale * ((wi[2] & 0xfc) >> 2) + bias;
+    }
+  }
+
   else if (bits == 8) {
     for (int i = 0; i < N; i++) {
       w_local[i] = scale * w[i] + bias;
@@ -266,10 +518,11 @@ struct QuantizedBlockLoader {
       group_size % BCOLS == 0,
       "The group size should be divisible by the columns");
   static_assert(
-      bits == 2 || bits == 4 || bits == 8,
-      "Template undefined for bits not in {2, 4, 8}");
+      bits == 2 || bits == 3 || bits == 4 || bits == 6 || bits == 8,
+      "Template undefined for bits not in {2, 3, 4, 6, 8}");
 
-  MLX_MTL_CONST short pack_factor = 32 / bits;
+  MLX_MTL_CONST short pack_factor = get_pack_factor<bits>();
+  MLX_MTL_CONST short bytes_per_pack = get_bytes_per_pack<bits>();
   MLX_MTL_CONST short BCOLS_PACKED = BCOLS / pack_factor;
   MLX_MTL_CONST short n_reads =
       (BCOLS_PACKED * BROWS < tgp_size) ? 1 : (BCOLS_PACKED * BROWS) / tgp_size;
@@ -285,12 +538,12 @@ struct QuantizedBlockLoader {
   const short bj;
 
   threadgroup T* dst;
-  const device uint32_t* src;
+  const device uint8_t* src;
   const device T* scales;
   const device T* biases;
 
   QuantizedBlockLoader(
-      const device uint32_t* src_,
+      const device uint8_t* src_,
       const device T* scales_,
       const device T* biases_,
       const int src_ld_,
@@ -299,14 +552,16 @@ struct QuantizedBlockLoader {
       ushort simd_lane_id [[thread_index_in_simdgroup]])
       : src_ld(src_ld_),
         tile_stride(
-            reduction_dim ? BCOLS_PACKED : BROWS * src_ld / pack_factor),
+            reduction_dim ? BCOLS_PACKED * bytes_per_pack
+                          : BROWS * src_ld * bytes_per_pack / pack_factor),
         group_step_cnt(0),
         group_stride(BROWS * src_ld / group_size),
         thread_idx(simd_group_id * 32 + simd_lane_id),
         bi(n_reads * thread_idx / BCOLS_PACKED),
         bj((n_reads * thread_idx) % BCOLS_PACKED),
         dst(dst_ + bi * dst_ld + bj * pack_factor),
-        src(src_ + bi * src_ld / pack_factor + bj),
+        src(src_ + bi * src_ld * bytes_per_pack / pack_factor +
+            bj * bytes_per_pack),
         scales(scales_ + bi * src_ld / group_size),
         biases(biases_ + bi * src_ld / group_size) {}
 
@@ -319,7 +574,7 @@ struct QuantizedBlockLoader {
     T bias = *biases;
     for (int i = 0; i < n_reads; i++) {
       dequantize<T, pack_factor, bits>(
-          (device uint8_t*)(src + i), scale, bias, dst + i * pack_factor);
+          src + i * bytes_per_pack, scale, bias, dst + i * pack_factor);
     }
   }
 
@@ -346,7 +601,7 @@ struct QuantizedBlockLoader {
     T bias = *biases;
     for (int i = 0; i < n_reads; i++) {
       dequantize<T, pack_factor, bits>(
-          (device uint8_t*)(src + i), scale, bias, dst + i * pack_factor);
+          src + i * bytes_per_pack, scale, bias, dst + i * pack_factor);
     }
   }
 
@@ -382,26 +637,31 @@ METAL_FUNC void qmv_fast_impl(
     const constant int& out_vec_size,
     uint3 tid [[threadgroup_position_in_grid]],
     uint simd_gid [[simdgroup_index_in_threadgroup]],
-    uint simd_lid [[thread_index_in_simdgroup]]) {
-  constexpr int packs_per_thread = bits > 2 ? 2 : 1;
+    uint simd_lid [[thread_index_in_simdgroup]],
+    const QuantizedEpilogue<T> epilogue = QuantizedEpilogue<T>(),
+    const LoRAUpdate<T> lora = LoRAUpdate<T>()) {
+  constexpr int packs_per_thread = bits == 2 ? 1 : 2;
   constexpr int num_simdgroups = 2;
   constexpr int results_per_simdgroup = 4;
-  constexpr int pack_factor = 32 / bits;
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
   constexpr int values_per_thread = pack_factor * packs_per_thread;
   constexpr int block_size = values_per_thread * SIMD_SIZE;
   constexpr int scale_step_per_thread = group_size / values_per_thread;
 
   typedef float U;
 
+  const device uint8_t* ws = (const device uint8_t*)w;
+
   thread U x_thread[values_per_thread];
   thread U result[results_per_simdgroup] = {0};
 
   // Adjust positions
-  const int in_vec_size_w = in_vec_size / pack_factor;
+  const int in_vec_size_w = in_vec_size * bytes_per_pack / pack_factor;
   const int in_vec_size_g = in_vec_size / group_size;
   const int out_row = tid.x * (num_simdgroups * results_per_simdgroup) +
       simd_gid * results_per_simdgroup;
-  w += out_row * in_vec_size_w + simd_lid * packs_per_thread;
+  ws += out_row * in_vec_size_w + simd_lid * packs_per_thread * bytes_per_pack;
   scales += out_row * in_vec_size_g + simd_lid / scale_step_per_thread;
   biases += out_row * in_vec_size_g + simd_lid / scale_step_per_thread;
   x += tid.y * in_vec_size + simd_lid * values_per_thread;
@@ -411,8 +671,7 @@ METAL_FUNC void qmv_fast_impl(
     U sum = load_vector<T, U, values_per_thread, bits>(x, x_thread);
 
     for (int row = 0; row < results_per_simdgroup; row++) {
-      const device uint8_t* wl =
-          (const device uint8_t*)(w + row * in_vec_size_w);
+      const device uint8_t* wl = ws + row * in_vec_size_w;
       const device T* sl = scales + row * in_vec_size_g;
       const device T* bl = biases + row * in_vec_size_g;
 
@@ -421,15 +680,32 @@ METAL_FUNC void qmv_fast_impl(
       result[row] += qdot<U, values_per_thread, bits>(wl, x_thread, s, b, sum);
     }
 
-    w += block_size / pack_factor;
+    ws += block_size * bytes_per_pack / pack_factor;
     scales += block_size / group_size;
     biases += block_size / group_size;
     x += block_size;
   }
 
+  // Add the low-rank update, split over the simdgroup like the product
+  if (!lora.empty()) {
+    const device T* x_a = lora.x_a + tid.y * lora.rank;
+    const device T* b =
+        lora.adapter_b(tid.y, out_vec_size) + out_row * lora.rank;
+    for (int k = simd_lid; k < lora.rank; k += SIMD_SIZE) {
+      U x_k = static_cast<U>(x_a[k]);
+      for (int row = 0; row < results_per_simdgroup; row++) {
+        result[row] += x_k * static_cast<U>(b[row * lora.rank + k]);
+      }
+    }
+  }
+
   for (int row = 0; row < results_per_simdgroup; row++) {
     result[row] = simd_sum(result[row]);
     if (simd_lid == 0) {
+      if (!epilogue.empty()) {
+        result[row] =
+            epilogue.apply(result[row], tid.y, out_row + row, out_vec_size);
+      }
       y[row] = static_cast<T>(result[row]);
     }
   }
@@ -450,18 +726,21 @@ METAL_FUNC void qmv_impl(
   constexpr int num_simdgroups = 2;
   constexpr int results_per_simdgroup = 4;
   constexpr int packs_per_thread = 1;
-  constexpr int pack_factor = 32 / bits;
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
   constexpr int values_per_thread = pack_factor * packs_per_thread;
   constexpr int block_size = values_per_thread * SIMD_SIZE;
   constexpr int scale_step_per_thread = group_size / values_per_thread;
 
   typedef float U;
 
+  const device uint8_t* ws = (const device uint8_t*)w;
+
   thread U x_thread[values_per_thread];
   thread U result[results_per_simdgroup] = {0};
 
   // Adjust positions
-  const int in_vec_size_w = in_vec_size / pack_factor;
+  const int in_vec_size_w = in_vec_size * bytes_per_pack / pack_factor;
   const int in_vec_size_g = in_vec_size / group_size;
   const int out_row = tid.x * (num_simdgroups * results_per_simdgroup) +
       simd_gid * results_per_simdgroup;
@@ -474,7 +753,8 @@ METAL_FUNC void qmv_impl(
   // In this case we need to properly guard all our reads because there isn't
   // even 1 tile in the matrix
   if (out_vec_size < (num_simdgroups * results_per_simdgroup)) {
-    w += out_row * in_vec_size_w + simd_lid * packs_per_thread;
+    ws += out_row * in_vec_size_w +
+        simd_lid * packs_per_thread * bytes_per_pack;
     scales += out_row * in_vec_size_g + simd_lid / scale_step_per_thread;
     biases += out_row * in_vec_size_g + simd_lid / scale_step_per_thread;
     x += tid.y * in_vec_size + simd_lid * values_per_thread;
@@ -485,8 +765,7 @@ METAL_FUNC void qmv_impl(
       U sum = load_vector<T, U, values_per_thread, bits>(x, x_thread);
 
       for (int row = 0; out_row + row < out_vec_size; row++) {
-        const device uint8_t* wl =
-            (const device uint8_t*)(w + row * in_vec_size_w);
+        const device uint8_t* wl = ws + row * in_vec_size_w;
         const device T* sl = scales + row * in_vec_size_g;
         const device T* bl = biases + row * in_vec_size_g;
 
@@ -496,7 +775,7 @@ METAL_FUNC void qmv_impl(
             qdot<U, values_per_thread, bits>(wl, x_thread, s, b, sum);
       }
 
-      w += block_size / pack_factor;
+      ws += block_size * bytes_per_pack / pack_factor;
       scales += block_size / group_size;
       biases += block_size / group_size;
       x += block_size;
@@ -509,8 +788,7 @@ METAL_FUNC void qmv_impl(
         load_vector_safe<T, U, values_per_thread, bits>(x, x_thread, remaining);
 
     for (int row = 0; out_row + row < out_vec_size; row++) {
-      const device uint8_t* wl =
-          (const device uint8_t*)(w + row * in_vec_size_w);
+      const device uint8_t* wl = ws + row * in_vec_size_w;
       const device T* sl = scales + row * in_vec_size_g;
       const device T* bl = biases + row * in_vec_size_g;
 
@@ -529,7 +807,8 @@ METAL_FUNC void qmv_impl(
 
   // In this case the last tile is moved back to redo some output values
   else {
-    w += used_out_row * in_vec_size_w + simd_lid * packs_per_thread;
+    ws += used_out_row * in_vec_size_w +
+        simd_lid * packs_per_thread * bytes_per_pack;
     scales += used_out_row * in_vec_size_g + simd_lid / scale_step_per_thread;
     biases += used_out_row * in_vec_size_g + simd_lid / scale_step_per_thread;
     x += tid.y * in_vec_size + simd_lid * values_per_thread;
@@ -540,8 +819,7 @@ METAL_FUNC void qmv_impl(
       U sum = load_vector<T, U, values_per_thread, bits>(x, x_thread);
 
       for (int row = 0; row < results_per_simdgroup; row++) {
-        const device uint8_t* wl =
-            (const device uint8_t*)(w + row * in_vec_size_w);
+        const device uint8_t* wl = ws + row * in_vec_size_w;
         const device T* sl = scales + row * in_vec_size_g;
         const device T* bl = biases + row * in_vec_size_g;
 
@@ -551,7 +829,7 @@ METAL_FUNC void qmv_impl(
             qdot<U, values_per_thread, bits>(wl, x_thread, s, b, sum);
       }
 
-      w += block_size / pack_factor;
+      ws += block_size * bytes_per_pack / pack_factor;
       scales += block_size / group_size;
       biases += block_size / group_size;
       x += block_size;
@@ -564,8 +842,7 @@ METAL_FUNC void qmv_impl(
         load_vector_safe<T, U, values_per_thread, bits>(x, x_thread, remaining);
 
     for (int row = 0; row < results_per_simdgroup; row++) {
-      const device uint8_t* wl =
-          (const device uint8_t*)(w + row * in_vec_size_w);
+      const device uint8_t* wl = ws + row * in_vec_size_w;
       const device T* sl = scales + row * in_vec_size_g;
       const device T* bl = biases + row * in_vec_size_g;
 
@@ -597,14 +874,22 @@ METAL_FUNC void qvm_impl(
     uint simd_gid [[simdgroup_index_in_threadgroup]],
     uint simd_lid [[thread_index_in_simdgroup]]) {
   constexpr int num_simdgroups = 2;
-  constexpr int pack_factor = 32 / bits;
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
   constexpr int tn = 32 / pack_factor;
   constexpr int blocksize = SIMD_SIZE;
 
   typedef float U;
   typedef struct {
     uint32_t wi[tn];
-  } vec_w;
+  } vec_w_words;
+  typedef struct {
+    uint8_t wi[tn * bytes_per_pack];
+  } vec_w_bytes;
+  using vec_w = metal::
+      conditional_t<bytes_per_pack == 4, vec_w_words, vec_w_bytes>;
+
+  const device uint8_t* ws = (const device uint8_t*)w;
 
   thread vec_w w_local;
   thread U result[tn * pack_factor] = {0};
@@ -613,11 +898,11 @@ METAL_FUNC void qvm_impl(
   thread U x_local = 0;
 
   // Adjust positions
-  const int out_vec_size_w = out_vec_size / pack_factor;
+  const int out_vec_size_w = out_vec_size * bytes_per_pack / pack_factor;
   const int out_vec_size_g = out_vec_size / group_size;
   int out_col =
       tid.x * (num_simdgroups * pack_factor * tn) + simd_gid * pack_factor * tn;
-  w += out_col / pack_factor + simd_lid * out_vec_size_w;
+  ws += out_col * bytes_per_pack / pack_factor + simd_lid * out_vec_size_w;
   scales += out_col / group_size + simd_lid * out_vec_size_g;
   biases += out_col / group_size + simd_lid * out_vec_size_g;
   x += tid.y * in_vec_size + simd_lid;
@@ -634,7 +919,7 @@ METAL_FUNC void qvm_impl(
       x_local = *x;
       scale = *scales;
       bias = *biases;
-      w_local = *((device vec_w*)w);
+      w_local = *((device vec_w*)ws);
 
       qouter<U, tn * pack_factor, bits>(
           (thread uint8_t*)&w_local, x_local, scale, bias, result);
@@ -642,14 +927,14 @@ METAL_FUNC void qvm_impl(
       x += blocksize;
       scales += blocksize * out_vec_size_g;
       biases += blocksize * out_vec_size_g;
-      w += blocksize * out_vec_size_w;
+      ws += blocksize * out_vec_size_w;
     }
   } else {
     for (int i = blocksize; i < in_vec_size; i += blocksize) {
       x_local = *x;
       scale = *scales;
       bias = *biases;
-      w_local = *((device vec_w*)w);
+      w_local = *((device vec_w*)ws);
 
       qouter<U, tn * pack_factor, bits>(
           (thread uint8_t*)&w_local, x_local, scale, bias, result);
@@ -657,13 +942,13 @@ METAL_FUNC void qvm_impl(
       x += blocksize;
       scales += blocksize * out_vec_size_g;
       biases += blocksize * out_vec_size_g;
-      w += blocksize * out_vec_size_w;
+      ws += blocksize * out_vec_size_w;
     }
     if (static_cast<int>(simd_lid) < remaining) {
       x_local = *x;
       scale = *scales;
       bias = *biases;
-      w_local = *((device vec_w*)w);
+      w_local = *((device vec_w*)ws);
     } else {
       x_local = 0;
       scale = 0;
@@ -710,15 +995,16 @@ METAL_FUNC void qmm_t_impl(
     uint3 tid [[threadgroup_position_in_grid]],
     uint lid [[thread_index_in_threadgroup]],
     uint simd_gid [[simdgroup_index_in_threadgroup]],
-    uint simd_lid [[thread_index_in_simdgroup]]) {
+    uint simd_lid [[thread_index_in_simdgroup]],
+    const QuantizedEpilogue<T> epilogue = QuantizedEpilogue<T>(),
+    const LoRAUpdate<T> lora = LoRAUpdate<T>()) {
   static_assert(BK >= SIMD_SIZE, "BK should be larger than SIMD_SIZE");
   static_assert(BK % SIMD_SIZE == 0, "BK should be divisible by SIMD_SIZE");
 
-  (void)lid;
-
   constexpr int WM = 2;
   constexpr int WN = 2;
-  constexpr int pack_factor = 32 / bits;
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
   constexpr int BK_padded = (BK + 16 / sizeof(T));
 
   // Instantiate the appropriate BlockMMA and Loader
@@ -737,13 +1023,14 @@ METAL_FUNC void qmm_t_impl(
       bits>;
 
   // Set the block
-  const int K_w = K / pack_factor;
+  const device uint8_t* ws = (const device uint8_t*)w;
+  const int K_w = K * bytes_per_pack / pack_factor;
   const int K_g = K / group_size;
   const int y_row = tid.y * BM;
   const int y_col = tid.x * BN;
 
   x += y_row * K;
-  w += y_col * K_w;
+  ws += y_col * K_w;
   scales += y_col * K_g;
   biases += y_col * K_g;
   y += y_row * N + y_col;
@@ -752,7 +1039,7 @@ METAL_FUNC void qmm_t_impl(
   const short num_els = min(BM, M - y_row);
   const short num_outs = min(BN, N - y_col);
   loader_x_t loader_x(x, K, Xs, simd_gid, simd_lid);
-  loader_w_t loader_w(w, scales, biases, K, Ws, simd_gid, simd_lid);
+  loader_w_t loader_w(ws, scales, biases, K, Ws, simd_gid, simd_lid);
   mma_t mma_op(simd_gid, simd_lid);
 
   if (num_els < BM) {
@@ -801,6 +1088,72 @@ METAL_FUNC void qmm_t_impl(
     }
   }
 
+  // Accumulate the low-rank update once per adapter used by the rows of the
+  // block, with the rows of the other adapters zeroed. Rows sorted by
+  // adapter make it a single pass for most blocks.
+  if (!lora.empty()) {
+    using loader_b_t =
+        mlx::steel::BlockLoader<T, BN, BK, BK_padded, 1, WM * WN * SIMD_SIZE>;
+    for (int i = 0; i < num_els; i++) {
+      uint32_t a = lora.adapter(y_row + i);
+      bool seen = false;
+      for (int j = 0; j < i && !seen; j++) {
+        seen = lora.adapter(y_row + j) == a;
+      }
+      if (seen) {
+        continue;
+      }
+
+      const device T* b = lora.adapter_b(y_row + i, N) + y_col * lora.rank;
+      loader_b_t loader_b(b, lora.rank, Ws, simd_gid, simd_lid);
+      for (int k = 0; k < lora.rank; k += BK) {
+        const short num_k = min(BK, lora.rank - k);
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+        for (int idx = lid; idx < BM * BK; idx += WM * WN * SIMD_SIZE) {
+          int r = idx / BK;
+          int c = idx % BK;
+          bool valid = r < num_els && c < num_k && lora.adapter(y_row + r) == a;
+          Xs[r * BK_padded + c] = valid
+              ? lora.x_a[size_t(y_row + r) * lora.rank + k + c]
+              : T(0);
+        }
+        loader_b.load_safe(short2(num_k, num_outs));
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+        mma_op.mma(Xs, Ws);
+        loader_b.next();
+      }
+    }
+  }
+
+  // Apply the epilogue to the accumulated results
+  if (!epilogue.empty()) {
+    const short2 tile_dims(num_outs, num_els);
+    const bool safe = num_els < BM || num_outs < BN;
+    const size_t offset = size_t(y_row) * N + y_col;
+    if (epilogue.bias != nullptr) {
+      apply_mma_epilogue(
+          mma_op, epilogue.bias + y_col, 0, tile_dims, safe, EpilogueAdd());
+    }
+    if (epilogue.gate != nullptr) {
+      apply_mma_epilogue(
+          mma_op,
+          epilogue.gate + offset,
+          N,
+          tile_dims,
+          safe,
+          EpilogueSiluMul());
+    }
+    if (epilogue.residual != nullptr) {
+      apply_mma_epilogue(
+          mma_op,
+          epilogue.residual + offset,
+          N,
+          tile_dims,
+          safe,
+          EpilogueAdd());
+    }
+  }
+
   // Store results to device memory
   threadgroup_barrier(mem_flags::mem_threadgroup);
   if (num_els < BM || num_outs < BN) {
@@ -839,7 +1192,8 @@ METAL_FUNC void qmm_n_impl(
 
   constexpr int WM = 2;
   constexpr int WN = 2;
-  constexpr int pack_factor = 32 / bits;
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
   constexpr int BK_padded = (BK + 16 / sizeof(T));
   constexpr int BN_padded = (BN + 16 / sizeof(T));
 
@@ -859,10 +1213,11 @@ METAL_FUNC void qmm_n_impl(
       bits>;
 
   // Set the block
+  const device uint8_t* ws = (const device uint8_t*)w;
   const int y_row = tid.y * BM;
   const int y_col = tid.x * BN;
   x += y_row * K;
-  w += y_col / pack_factor;
+  ws += y_col * bytes_per_pack / pack_factor;
   scales += y_col / group_size;
   biases += y_col / group_size;
   y += y_row * N + y_col;
@@ -870,7 +1225,7 @@ METAL_FUNC void qmm_n_impl(
   // Make the x loader and mma operation
   const short num_els = min(BM, M - y_row);
   loader_x_t loader_x(x, K, Xs, simd_gid, simd_lid);
-  loader_w_t loader_w(w, scales, biases, N, Ws, simd_gid, simd_lid);
+  loader_w_t loader_w(ws, scales, biases, N, Ws, simd_gid, simd_lid);
   mma_t mma_op(simd_gid, simd_lid);
 
   if (num_els < BM) {
@@ -1103,6 +1458,138 @@ template <
       x, w, scales, biases, y, Xs, Ws, M, N, K, tid, lid, simd_gid, simd_lid);
 }
 
+template <typename T, int group_size, int bits>
+[[kernel]] void qmv_fast_epilogue(
+    const device uint32_t* w [[buffer(0)]],
+    const device T* scales [[buffer(1)]],
+    const device T* biases [[buffer(2)]],
+    const device T* x [[buffer(3)]],
+    device T* y [[buffer(4)]],
+    const constant int& in_vec_size [[buffer(5)]],
+    const constant int& out_vec_size [[buffer(6)]],
+    const device T* bias [[buffer(7), function_constant(qmm_has_bias)]],
+    const device T* gate [[buffer(8), function_constant(qmm_has_gate)]],
+    const device T* residual
+    [[buffer(9), function_constant(qmm_has_residual)]],
+    const device T* lora_x_a [[buffer(10), function_constant(qmm_has_lora)]],
+    const device T* lora_b [[buffer(11), function_constant(qmm_has_lora)]],
+    const device uint32_t* adapter_ids
+    [[buffer(12), function_constant(qmm_has_adapter_ids)]],
+    const constant int& lora_rank
+    [[buffer(13), function_constant(qmm_has_lora)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]]) {
+  QuantizedEpilogue<T> epilogue;
+  if (qmm_has_bias) {
+    epilogue.bias = bias;
+  }
+  if (qmm_has_gate) {
+    epilogue.gate = gate;
+  }
+  if (qmm_has_residual) {
+    epilogue.residual = residual;
+  }
+  LoRAUpdate<T> lora;
+  if (qmm_has_lora) {
+    lora.x_a = lora_x_a;
+    lora.b = lora_b;
+    lora.rank = lora_rank;
+  }
+  if (qmm_has_adapter_ids) {
+    lora.adapter_ids = adapter_ids;
+  }
+  qmv_fast_impl<T, group_size, bits>(
+      w,
+      scales,
+      biases,
+      x,
+      y,
+      in_vec_size,
+      out_vec_size,
+      tid,
+      simd_gid,
+      simd_lid,
+      epilogue,
+      lora);
+}
+
+template <
+    typename T,
+    const int group_size,
+    const int bits,
+    const bool aligned_N,
+    const int BM = 32,
+    const int BK = 32,
+    const int BN = 32>
+[[kernel]] void qmm_t_epilogue(
+    const device T* x [[buffer(0)]],
+    const device uint32_t* w [[buffer(1)]],
+    const device T* scales [[buffer(2)]],
+    const device T* biases [[buffer(3)]],
+    device T* y [[buffer(4)]],
+    const constant int& M [[buffer(5)]],
+    const constant int& N [[buffer(6)]],
+    const constant int& K [[buffer(7)]],
+    const device T* bias [[buffer(8), function_constant(qmm_has_bias)]],
+    const device T* gate [[buffer(9), function_constant(qmm_has_gate)]],
+    const device T* residual
+    [[buffer(10), function_constant(qmm_has_residual)]],
+    const device T* lora_x_a [[buffer(11), function_constant(qmm_has_lora)]],
+    const device T* lora_b [[buffer(12), function_constant(qmm_has_lora)]],
+    const device uint32_t* adapter_ids
+    [[buffer(13), function_constant(qmm_has_adapter_ids)]],
+    const constant int& lora_rank
+    [[buffer(14), function_constant(qmm_has_lora)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint lid [[thread_index_in_threadgroup]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]]) {
+  (void)lid;
+
+  constexpr int BK_padded = (BK + 16 / sizeof(T));
+
+  threadgroup T Xs[BM * BK_padded];
+  threadgroup T Ws[BN * BK_padded];
+
+  QuantizedEpilogue<T> epilogue;
+  if (qmm_has_bias) {
+    epilogue.bias = bias;
+  }
+  if (qmm_has_gate) {
+    epilogue.gate = gate;
+  }
+  if (qmm_has_residual) {
+    epilogue.residual = residual;
+  }
+  LoRAUpdate<T> lora;
+  if (qmm_has_lora) {
+    lora.x_a = lora_x_a;
+    lora.b = lora_b;
+    lora.rank = lora_rank;
+  }
+  if (qmm_has_adapter_ids) {
+    lora.adapter_ids = adapter_ids;
+  }
+  qmm_t_impl<T, BM, BK, BN, group_size, bits, aligned_N>(
+      x,
+      w,
+      scales,
+      biases,
+      y,
+      Xs,
+      Ws,
+      M,
+      N,
+      K,
+      tid,
+      lid,
+      simd_gid,
+      simd_lid,
+      epilogue,
+      lora);
+}
+
 template <
     typename T,
     const int group_size,
@@ -1453,3 +1940,324 @@ template <
   qmm_n_impl<T, BM, BK, BN, group_size, bits>(
       x, w, scales, biases, y, Xs, Ws, M, N, K, tid, lid, simd_gid, simd_lid);
 }
+
+// Computes y[i] = x[i] @ w[indices[i]] where x has one row per index.
+//
+// The rows of a tile of x that use the same matrix of w are multiplied with
+// it together and only their results are stored. When the indices are sorted
+// most tiles need a single pass so every matrix of w is dequantized once per
+// tile of rows instead of once per row.
+template <
+    typename T,
+    const int group_size,
+    const int bits,
+    const bool transpose,
+    const bool aligned_N,
+    const int BM = 16,
+    const int BK = 32,
+    const int BN = 32,
+    const int WM = 1,
+    const int WN = 2>
+[[kernel]] void bs_qmm_rhs(
+    const device T* x [[buffer(0)]],
+    const device uint32_t* w [[buffer(1)]],
+    const device T* scales [[buffer(2)]],
+    const device T* biases [[buffer(3)]],
+    const device uint32_t* indices [[buffer(4)]],
+    device T* y [[buffer(5)]],
+    const constant int& M [[buffer(6)]],
+    const constant int& N [[buffer(7)]],
+    const constant int& K [[buffer(8)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]]) {
+  static_assert(BK >= SIMD_SIZE, "BK should be larger than SIMD_SIZE");
+  static_assert(BK % SIMD_SIZE == 0, "BK should be divisible by SIMD_SIZE");
+
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+  constexpr int BK_padded = (BK + 16 / sizeof(T));
+  constexpr int BN_padded = (BN + 16 / sizeof(T));
+  constexpr int W_ld = transpose ? BK_padded : BN_padded;
+
+  // Instantiate the appropriate BlockMMA and Loader
+  using mma_t = mlx::steel::
+      BlockMMA<T, T, BM, BN, BK, WM, WN, false, transpose, BK_padded, W_ld>;
+  using loader_x_t =
+      mlx::steel::BlockLoader<T, BM, BK, BK_padded, 1, WM * WN * SIMD_SIZE>;
+  using loader_w_t = QuantizedBlockLoader<
+      T,
+      transpose ? BN : BK,
+      transpose ? BK : BN,
+      W_ld,
+      transpose,
+      WM * WN * SIMD_SIZE,
+      group_size,
+      bits>;
+
+  threadgroup T Xs[BM * BK_padded];
+  threadgroup T Ws[transpose ? BN * BK_padded : BK * BN_padded];
+
+  // Set the block. Every matrix of w has N * K values, wherever the
+  // quantization groups run.
+  const int y_row = tid.y * BM;
+  const int y_col = tid.x * BN;
+  const short num_els = min(BM, M - y_row);
+  const short num_outs = min(BN, N - y_col);
+  const size_t w_stride = size_t(N) * K * bytes_per_pack / pack_factor;
+  const size_t s_stride = size_t(N) * K / group_size;
+
+  const device uint8_t* ws = (const device uint8_t*)w;
+  if (transpose) {
+    ws += size_t(y_col) * K * bytes_per_pack / pack_factor;
+    scales += size_t(y_col) * K / group_size;
+    biases += size_t(y_col) * K / group_size;
+  } else {
+    ws += y_col * bytes_per_pack / pack_factor;
+    scales += y_col / group_size;
+    biases += y_col / group_size;
+  }
+  x += size_t(y_row) * K;
+  y += size_t(y_row) * N + y_col;
+  indices += y_row;
+
+  // Find the runs of rows using the same matrix of w and multiply them
+  uint32_t index_next = indices[0];
+  short offset_next = 0;
+  short n = 0;
+  while (n < num_els) {
+    n++;
+    const short offset = offset_next;
+    const uint32_t index = index_next;
+    offset_next = num_els;
+    for (; n < num_els; n++) {
+      if (indices[n] != index) {
+        offset_next = n;
+        index_next = indices[n];
+        break;
+      }
+    }
+
+    loader_x_t loader_x(x, K, Xs, simd_gid, simd_lid);
+    loader_w_t loader_w(
+        ws + index * w_stride,
+        scales + index * s_stride,
+        biases + index * s_stride,
+        transpose ? K : N,
+        Ws,
+        simd_gid,
+        simd_lid);
+    mma_t mma_op(simd_gid, simd_lid);
+
+    // K is a multiple of the group size so there are no partial blocks of K
+    for (int k = 0; k < K; k += BK) {
+      threadgroup_barrier(mem_flags::mem_threadgroup);
+      if (num_els < BM) {
+        loader_x.load_safe(short2(BK, num_els));
+      } else {
+        loader_x.load_unsafe();
+      }
+      if (transpose && !aligned_N && num_outs < BN) {
+        loader_w.load_safe(short2(BK, num_outs));
+      } else {
+        loader_w.load_unsafe();
+      }
+      threadgroup_barrier(mem_flags::mem_threadgroup);
+      mma_op.mma(Xs, Ws);
+      loader_x.next();
+      loader_w.next();
+    }
+
+    // Store the rows of the run
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    mma_op.store_result_slice(
+        y, N, short2(0, offset), short2(num_outs, offset_next));
+  }
+}
+
+// Quantizes w with a thread per pack of values, which fills whole bytes. The
+// packs of a group are held by consecutive lanes of a simdgroup, at most 32
+// of them, which share the minimum and maximum of the group with shuffles.
+// The results match the quantize op on the CPU: the scale and bias map the
+// largest magnitude edge of the group exactly to a quantized value and are
+// rounded to T before quantizing the values.
+template <typename T, const int group_size, const int bits>
+[[kernel]] void affine_quantize(
+    const device T* w [[buffer(0)]],
+    device uint8_t* out [[buffer(1)]],
+    device T* scales [[buffer(2)]],
+    device T* biases [[buffer(3)]],
+    uint index [[thread_position_in_grid]]) {
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+  constexpr int packs_per_group = group_size / pack_factor;
+  constexpr float n_bins = (1 << bits) - 1;
+  constexpr float eps = 1e-7;
+  static_assert(
+      packs_per_group <= SIMD_SIZE,
+      "The packs of a group must fit in a simdgroup");
+
+  w += size_t(index) * pack_factor;
+  float vals[pack_factor];
+  float w_min = Limits<float>::max;
+  float w_max = Limits<float>::min;
+  for (int i = 0; i < pack_factor; i++) {
+    vals[i] = static_cast<float>(w[i]);
+    w_min = metal::min(w_min, vals[i]);
+    w_max = metal::max(w_max, vals[i]);
+  }
+  for (int delta = packs_per_group / 2; delta > 0; delta /= 2) {
+    w_min = metal::min(w_min, simd_shuffle_xor(w_min, ushort(delta)));
+    w_max = metal::max(w_max, simd_shuffle_xor(w_max, ushort(delta)));
+  }
+
+  bool side = metal::abs(w_min) > metal::abs(w_max);
+  float scale = metal::max((w_max - w_min) / n_bins, eps);
+  scale = side ? scale : -scale;
+  float edge = side ? w_min : w_max;
+  float q0 = metal::rint(edge / scale);
+  scale = (q0 != 0) ? edge / q0 : scale;
+  float bias = (q0 != 0) ? edge : 0;
+  T scale_t = static_cast<T>(scale);
+  T bias_t = static_cast<T>(bias);
+  if (index % packs_per_group == 0) {
+    scales[index / packs_per_group] = scale_t;
+    biases[index / packs_per_group] = bias_t;
+  }
+  scale = static_cast<float>(scale_t);
+  bias = static_cast<float>(bias_t);
+
+  uint32_t pack = 0;
+  for (int i = 0; i < pack_factor; i++) {
+    float q = metal::rint((vals[i] - bias) / scale);
+    pack |= uint32_t(metal::clamp(q, 0.0f, n_bins)) << (i * bits);
+  }
+  if (bytes_per_pack == 4) {
+    ((device uint32_t*)out)[index] = pack;
+  } else {
+    out += size_t(index) * bytes_per_pack;
+    for (int i = 0; i < bytes_per_pack; i++) {
+      out[i] = (pack >> (8 * i)) & 0xff;
+    }
+  }
+}
+
+// Dequantizes w with a thread per pack of values
+template <typename T, const int group_size, const int bits>
+[[kernel]] void affine_dequantize(
+    const device uint8_t* w [[buffer(0)]],
+    const device T* scales [[buffer(1)]],
+    const device T* biases [[buffer(2)]],
+    device T* out [[buffer(3)]],
+    uint index [[thread_position_in_grid]]) {
+  constexpr int pack_factor = get_pack_factor<bits>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+  constexpr int packs_per_group = group_size / pack_factor;
+  constexpr uint32_t bitmask = (1 << bits) - 1;
+
+  float scale = static_cast<float>(scales[index / packs_per_group]);
+  float bias = static_cast<float>(biases[index / packs_per_group]);
+  uint32_t pack;
+  if (bytes_per_pack == 4) {
+    pack = ((const device uint32_t*)w)[index];
+  } else {
+    w += size_t(index) * bytes_per_pack;
+    pack = w[0] | (w[1] << 8) | (w[2] << 16);
+  }
+  out += size_t(index) * pack_factor;
+  for (int i = 0; i < pack_factor; i++) {
+    out[i] = static_cast<T>(scale * ((pack >> (i * bits)) & bitmask) + bias);
+  }
+}
+
+// Matmul of int8 activations quantized per row, x = x_scales * x_q, with 8
+// bit affine quantized weights. The products of a group are accumulated in
+// int32 and the scale and bias of the group are applied once per group:
+//   x_q . w = sum_g scale_g * (x_q . q)_g + bias_g * sum(x_q)_g
+// Each thread computes TN consecutive outputs of a row of the block.
+template <
+    typename T,
+    const int group_size,
+    const int BM = 32,
+    const int BN = 32>
+[[kernel]] void qmm_w8a8_t(
+    const device int8_t* x [[buffer(0)]],
+    const device float* x_scales [[buffer(1)]],
+    const device uint32_t* w [[buffer(2)]],
+    const device T* scales [[buffer(3)]],
+    const device T* biases [[buffer(4)]],
+    device T* y [[buffer(5)]],
+    const constant int& M [[buffer(6)]],
+    const constant int& N [[buffer(7)]],
+    const constant int& K [[buffer(8)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint lid [[thread_index_in_threadgroup]]) {
+  constexpr int BK = 32;
+  constexpr int BK_packs = BK / 4;
+  constexpr int TN = 4;
+  static_assert(BM == BN && BN / TN == BK_packs, "One pack per thread");
+
+  threadgroup char4 Xs[BM * BK_packs];
+  threadgroup uchar4 Ws[BN * BK_packs];
+
+  const int row0 = tid.y * BM;
+  const int col0 = tid.x * BN;
+  const int groups = K / group_size;
+
+  // Each thread loads 4 activations and a pack of 4 weights per block
+  const int load_row = lid / BK_packs;
+  const int load_pack = lid % BK_packs;
+  const bool x_valid = row0 + load_row < M;
+  const bool w_valid = col0 + load_row < N;
+  x += size_t(min(row0 + load_row, M - 1)) * K + load_pack * 4;
+  w += (size_t(min(col0 + load_row, N - 1)) * K) / 4 + load_pack;
+
+  // And computes TN outputs of a row
+  const int r = lid / (BN / TN);
+  const int c = (lid % (BN / TN)) * TN;
+
+  float acc[TN] = {0.f};
+  int group_acc[TN] = {0};
+  int x_sum = 0;
+
+  for (int k = 0; k < K; k += BK) {
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    Xs[lid] = x_valid ? *((const device char4*)(x + k)) : char4(0);
+    Ws[lid] = w_valid ? as_type<uchar4>(w[k / 4]) : uchar4(0);
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    for (int i = 0; i < BK_packs; i++) {
+      int4 xv = int4(Xs[r * BK_packs + i]);
+      x_sum += xv.x + xv.y + xv.z + xv.w;
+#pragma clang loop unroll(full)
+      for (int j = 0; j < TN; j++) {
+        int4 p = xv * int4(Ws[(c + j) * BK_packs + i]);
+        group_acc[j] += p.x + p.y + p.z + p.w;
+      }
+    }
+
+    // Apply the scale and bias of the group once all its blocks are summed
+    if ((k + BK) % group_size == 0) {
+      int g = k / group_size;
+#pragma clang loop unroll(full)
+      for (int j = 0; j < TN; j++) {
+        size_t sb = size_t(min(col0 + c + j, N - 1)) * groups + g;
+        acc[j] += float(scales[sb]) * float(group_acc[j]) +
+            float(biases[sb]) * float(x_sum);
+        group_acc[j] = 0;
+      }
+      x_sum = 0;
+    }
+  }
+
+  if (row0 + r < M) {
+    float x_scale = x_scales[row0 + r];
+    y += size_t(row0 + r) * N + col0 + c;
+#pragma clang loop unroll(full)
+    for (int j = 0; j < TN; j++) {
+      if (col0 + c + j < N) {
+        y[j] = static_cast<T>(x_scale * acc[j]);
+      }
+    }
+  }
+}
@@ -20,13 +20,19 @@
   instantiate_qmv_fast(bfloat16_t, group_size, bits)
 
 instantiate_qmv_fast_types(128, 2)
+instantiate_qmv_fast_types(128, 3)
 instantiate_qmv_fast_types(128, 4)
+instantiate_qmv_fast_types(128, 6)
 instantiate_qmv_fast_types(128, 8)
 instantiate_qmv_fast_types( 64, 2)
+instantiate_qmv_fast_types( 64, 3)
 instantiate_qmv_fast_types( 64, 4)
+instantiate_qmv_fast_types( 64, 6)
 instantiate_qmv_fast_types( 64, 8)
 instantiate_qmv_fast_types( 32, 2)
+instantiate_qmv_fast_types( 32, 3)
 instantiate_qmv_fast_types( 32, 4)
+instantiate_qmv_fast_types( 32, 6)
 instantiate_qmv_fast_types( 32, 8)
 
 #define instantiate_qmv(itype, group_size, bits)    \
@@ -43,13 +49,19 @@ instantiate_qmv_fast_types( 32, 8)
   instantiate_qmv(bfloat16_t, group_size, bits)
 
 instantiate_qmv_types(128, 2)
+instantiate_qmv_types(128, 3)
 instantiate_qmv_types(128, 4)
+instantiate_qmv_types(128, 6)
 instantiate_qmv_types(128, 8)
 instantiate_qmv_types( 64, 2)
+instantiate_qmv_types( 64, 3)
 instantiate_qmv_types( 64, 4)
+instantiate_qmv_types( 64, 6)
 instantiate_qmv_types( 64, 8)
 instantiate_qmv_types( 32, 2)
+instantiate_qmv_types( 32, 3)
 instantiate_qmv_types( 32, 4)
+instantiate_qmv_types( 32, 6)
 instantiate_qmv_types( 32, 8)
 
 #define instantiate_qvm(itype, group_size, bits)    \
@@ -66,13 +78,19 @@ instantiate_qmv_types( 32, 8)
   instantiate_qvm(bfloat16_t, group_size, bits)
 
 instantiate_qvm_types(128, 2)
+instantiate_qvm_types(128, 3)
 instantiate_qvm_types(128, 4)
+instantiate_qvm_types(128, 6)
 instantiate_qvm_types(128, 8)
 instantiate_qvm_types( 64, 2)
+instantiate_qvm_types( 64, 3)
 instantiate_qvm_types( 64, 4)
+instantiate_qvm_types( 64, 6)
 instantiate_qvm_types( 64, 8)
 instantiate_qvm_types( 32, 2)
+instantiate_qvm_types( 32, 3)
 instantiate_qvm_types( 32, 4)
+instantiate_qvm_types( 32, 6)
 instantiate_qvm_types( 32, 8)
 
 #define instantiate_qmm_t(itype, group_size, bits, aligned_N)            \
@@ -93,13 +111,19 @@ instantiate_qvm_types( 32, 8)
   instantiate_qmm_t(bfloat16_t, group_size, bits, true)
 
 instantiate_qmm_t_types(128, 2)
+instantiate_qmm_t_types(128, 3)
 instantiate_qmm_t_types(128, 4)
+instantiate_qmm_t_types(128, 6)
 instantiate_qmm_t_types(128, 8)
 instantiate_qmm_t_types( 64, 2)
+instantiate_qmm_t_types( 64, 3)
 instantiate_qmm_t_types( 64, 4)
+instantiate_qmm_t_types( 64, 6)
 instantiate_qmm_t_types( 64, 8)
 instantiate_qmm_t_types( 32, 2)
+instantiate_qmm_t_types( 32, 3)
 instantiate_qmm_t_types( 32, 4)
+instantiate_qmm_t_types( 32, 6)
 instantiate_qmm_t_types( 32, 8)
 
 #define instantiate_qmm_n(itype, group_size, bits)    \
@@ -116,15 +140,100 @@ instantiate_qmm_t_types( 32, 8)
   instantiate_qmm_n(bfloat16_t, group_size, bits)
 
 instantiate_qmm_n_types(128, 2)
+instantiate_qmm_n_types(128, 3)
 instantiate_qmm_n_types(128, 4)
+instantiate_qmm_n_types(128, 6)
 instantiate_qmm_n_types(128, 8)
 instantiate_qmm_n_types( 64, 2)
+instantiate_qmm_n_types( 64, 3)
 instantiate_qmm_n_types( 64, 4)
+instantiate_qmm_n_types( 64, 6)
 instantiate_qmm_n_types( 64, 8)
 instantiate_qmm_n_types( 32, 2)
+instantiate_qmm_n_types( 32, 3)
 instantiate_qmm_n_types( 32, 4)
+instantiate_qmm_n_types( 32, 6)
 instantiate_qmm_n_types( 32, 8)
 
+#define instantiate_qmv_fast_epilogue(itype, group_size, bits)       \
+  instantiate_kernel(                                                \
+      "qmv_" #itype "_gs_" #group_size "_b_" #bits "_fast_epilogue", \
+      qmv_fast_epilogue,                                             \
+      itype,                                                         \
+      group_size,                                                    \
+      bits)
+
+#define instantiate_qmv_fast_epilogue_types(group_size, bits)     \
+  instantiate_qmv_fast_epilogue(float, group_size, bits) \
+  instantiate_qmv_fast_epilogue(float16_t, group_size, bits)  \
+  instantiate_qmv_fast_epilogue(bfloat16_t, group_size, bits)
+
+instantiate_qmv_fast_epilogue_types(128, 2)
+instantiate_qmv_fast_epilogue_types(128, 3)
+instantiate_qmv_fast_epilogue_types(128, 4)
+instantiate_qmv_fast_epilogue_types(128, 6)
+instantiate_qmv_fast_epilogue_types(128, 8)
+instantiate_qmv_fast_epilogue_types( 64, 2)
+instantiate_qmv_fast_epilogue_types( 64, 3)
+instantiate_qmv_fast_epilogue_types( 64, 4)
+instantiate_qmv_fast_epilogue_types( 64, 6)
+instantiate_qmv_fast_epilogue_types( 64, 8)
+instantiate_qmv_fast_epilogue_types( 32, 2)
+instantiate_qmv_fast_epilogue_types( 32, 3)
+instantiate_qmv_fast_epilogue_types( 32, 4)
+instantiate_qmv_fast_epilogue_types( 32, 6)
+instantiate_qmv_fast_epilogue_types( 32, 8)
+
+#define instantiate_qmm_t_epilogue(itype, group_size, bits, aligned_N) \
+  instantiate_kernel(                                                  \
+      "qmm_t_" #itype "_gs_" #group_size "_b_" #bits "_alN_"           \
+      #aligned_N "_epilogue",                                          \
+      qmm_t_epilogue,                                                  \
+      itype,                                                           \
+      group_size,                                                      \
+      bits,                                                            \
+      aligned_N)
+
+#define instantiate_qmm_t_epilogue_types(group_size, bits)                  \
+  instantiate_qmm_t_epilogue(float, group_size, bits, false)       \
+  instantiate_qmm_t_epilogue(float16_t, group_size, bits, false)        \
+  instantiate_qmm_t_epilogue(bfloat16_t, group_size, bits, false) \
+  instantiate_qmm_t_epilogue(float, group_size, bits, true)        \
+  instantiate_qmm_t_epilogue(float16_t, group_size, bits, true)         \
+  instantiate_qmm_t_epilogue(bfloat16_t, group_size, bits, true)
+
+instantiate_qmm_t_epilogue_types(128, 2)
+instantiate_qmm_t_epilogue_types(128, 3)
+instantiate_qmm_t_epilogue_types(128, 4)
+instantiate_qmm_t_epilogue_types(128, 6)
+instantiate_qmm_t_epilogue_types(128, 8)
+instantiate_qmm_t_epilogue_types( 64, 2)
+instantiate_qmm_t_epilogue_types( 64, 3)
+instantiate_qmm_t_epilogue_types( 64, 4)
+instantiate_qmm_t_epilogue_types( 64, 6)
+instantiate_qmm_t_epilogue_types( 64, 8)
+instantiate_qmm_t_epilogue_types( 32, 2)
+instantiate_qmm_t_epilogue_types( 32, 3)
+instantiate_qmm_t_epilogue_types( 32, 4)
+instantiate_qmm_t_epilogue_types( 32, 6)
+instantiate_qmm_t_epilogue_types( 32, 8)
+
+#define instantiate_qmm_w8a8_t(itype, group_size)     \
+  instantiate_kernel(                                  \
+      "qmm_w8a8_t_" #itype "_gs_" #group_size,         \
+      qmm_w8a8_t,                                      \
+      itype,                                           \
+      group_size)
+
+#define instantiate_qmm_w8a8_t_types(group_size)     \
+  instantiate_qmm_w8a8_t(float, group_size)          \
+  instantiate_qmm_w8a8_t(float16_t, group_size)      \
+  instantiate_qmm_w8a8_t(bfloat16_t, group_size)
+
+instantiate_qmm_w8a8_t_types(128)
+instantiate_qmm_w8a8_t_types(64)
+instantiate_qmm_w8a8_t_types(32)
+
 #define instantiate_bs_qmv_fast(itype, group_size, bits)       \
   instantiate_kernel(                                          \
       "bs_qmv_" #itype "_gs_" #group_size "_b_" #bits "_fast", \
@@ -139,13 +248,19 @@ instantiate_qmm_n_types( 32, 8)
   instantiate_bs_qmv_fast(bfloat16_t, group_size, bits)
 
 instantiate_bs_qmv_fast_types(128, 2)
+instantiate_bs_qmv_fast_types(128, 3)
 instantiate_bs_qmv_fast_types(128, 4)
+instantiate_bs_qmv_fast_types(128, 6)
 instantiate_bs_qmv_fast_types(128, 8)
 instantiate_bs_qmv_fast_types( 64, 2)
+instantiate_bs_qmv_fast_types( 64, 3)
 instantiate_bs_qmv_fast_types( 64, 4)
+instantiate_bs_qmv_fast_types( 64, 6)
 instantiate_bs_qmv_fast_types( 64, 8)
 instantiate_bs_qmv_fast_types( 32, 2)
+instantiate_bs_qmv_fast_types( 32, 3)
 instantiate_bs_qmv_fast_types( 32, 4)
+instantiate_bs_qmv_fast_types( 32, 6)
 instantiate_bs_qmv_fast_types( 32, 8)
 
 #define instantiate_bs_qmv(itype, group_size, bits)    \
@@ -162,13 +277,19 @@ instantiate_bs_qmv_fast_types( 32, 8)
   instantiate_bs_qmv(bfloat16_t, group_size, bits)
 
 instantiate_bs_qmv_types(128, 2)
+instantiate_bs_qmv_types(128, 3)
 instantiate_bs_qmv_types(128, 4)
+instantiate_bs_qmv_types(128, 6)
 instantiate_bs_qmv_types(128, 8)
 instantiate_bs_qmv_types( 64, 2)
+instantiate_bs_qmv_types( 64, 3)
 instantiate_bs_qmv_types( 64, 4)
+instantiate_bs_qmv_types( 64, 6)
 instantiate_bs_qmv_types( 64, 8)
 instantiate_bs_qmv_types( 32, 2)
+instantiate_bs_qmv_types( 32, 3)
 instantiate_bs_qmv_types( 32, 4)
+instantiate_bs_qmv_types( 32, 6)
 instantiate_bs_qmv_types( 32, 8)
 
 #define instantiate_bs_qvm(itype, group_size, bits)    \
@@ -185,13 +306,19 @@ instantiate_bs_qmv_types( 32, 8)
   instantiate_bs_qvm(bfloat16_t, group_size, bits)
 
 instantiate_bs_qvm_types(128, 2)
+instantiate_bs_qvm_types(128, 3)
 instantiate_bs_qvm_types(128, 4)
+instantiate_bs_qvm_types(128, 6)
 instantiate_bs_qvm_types(128, 8)
 instantiate_bs_qvm_types( 64, 2)
+instantiate_bs_qvm_types( 64, 3)
 instantiate_bs_qvm_types( 64, 4)
+instantiate_bs_qvm_types( 64, 6)
 instantiate_bs_qvm_types( 64, 8)
 instantiate_bs_qvm_types( 32, 2)
+instantiate_bs_qvm_types( 32, 3)
 instantiate_bs_qvm_types( 32, 4)
+instantiate_bs_qvm_types( 32, 6)
 instantiate_bs_qvm_types( 32, 8)
 
 #define instantiate_bs_qmm_t(itype, group_size, bits, aligned_N)            \
@@ -212,13 +339,19 @@ instantiate_bs_qvm_types( 32, 8)
   instantiate_bs_qmm_t(bfloat16_t, group_size, bits, true)
 
 instantiate_bs_qmm_t_types(128, 2)
+instantiate_bs_qmm_t_types(128, 3)
 instantiate_bs_qmm_t_types(128, 4)
+instantiate_bs_qmm_t_types(128, 6)
 instantiate_bs_qmm_t_types(128, 8)
 instantiate_bs_qmm_t_types( 64, 2)
+instantiate_bs_qmm_t_types( 64, 3)
 instantiate_bs_qmm_t_types( 64, 4)
+instantiate_bs_qmm_t_types( 64, 6)
 instantiate_bs_qmm_t_types( 64, 8)
 instantiate_bs_qmm_t_types( 32, 2)
+instantiate_bs_qmm_t_types( 32, 3)
 instantiate_bs_qmm_t_types( 32, 4)
+instantiate_bs_qmm_t_types( 32, 6)
 instantiate_bs_qmm_t_types( 32, 8)
 
 #define instantiate_bs_qmm_n(itype, group_size, bits)    \
@@ -235,11 +368,90 @@ instantiate_bs_qmm_t_types( 32, 8)
   instantiate_bs_qmm_n(bfloat16_t, group_size, bits)
 
 instantiate_bs_qmm_n_types(128, 2)
+instantiate_bs_qmm_n_types(128, 3)
 instantiate_bs_qmm_n_types(128, 4)
+instantiate_bs_qmm_n_types(128, 6)
 instantiate_bs_qmm_n_types(128, 8)
 instantiate_bs_qmm_n_types( 64, 2)
+instantiate_bs_qmm_n_types( 64, 3)
 instantiate_bs_qmm_n_types( 64, 4)
+instantiate_bs_qmm_n_types( 64, 6)
 instantiate_bs_qmm_n_types( 64, 8)
 instantiate_bs_qmm_n_types( 32, 2)
+instantiate_bs_qmm_n_types( 32, 3)
 instantiate_bs_qmm_n_types( 32, 4)
-instantiate_bs_qmm_n_types( 32, 8) // clang-format on
+instantiate_bs_qmm_n_types( 32, 6)
+instantiate_bs_qmm_n_types( 32, 8)
+
+#define instantiate_bs_qmm_rhs(itype, group_size, bits, transpose, t, aligned_N) \
+  instantiate_kernel(                                                        \
+      "bs_qmm_rhs_" #t "_" #itype "_gs_" #group_size "_b_" #bits             \
+      "_alN_" #aligned_N,                                                    \
+      bs_qmm_rhs,                                                            \
+      itype,                                                                 \
+      group_size,                                                            \
+      bits,                                                                  \
+      transpose,                                                             \
+      aligned_N)
+
+#define instantiate_bs_qmm_rhs_types(group_size, bits)                \
+  instantiate_bs_qmm_rhs(float, group_size, bits, true, t, false)      \
+  instantiate_bs_qmm_rhs(float16_t, group_size, bits, true, t, false)  \
+  instantiate_bs_qmm_rhs(bfloat16_t, group_size, bits, true, t, false) \
+  instantiate_bs_qmm_rhs(float, group_size, bits, true, t, true)       \
+  instantiate_bs_qmm_rhs(float16_t, group_size, bits, true, t, true)   \
+  instantiate_bs_qmm_rhs(bfloat16_t, group_size, bits, true, t, true)  \
+  instantiate_bs_qmm_rhs(float, group_size, bits, false, n, true)      \
+  instantiate_bs_qmm_rhs(float16_t, group_size, bits, false, n, true)  \
+  instantiate_bs_qmm_rhs(bfloat16_t, group_size, bits, false, n, true)
+
+instantiate_bs_qmm_rhs_types(128, 2)
+instantiate_bs_qmm_rhs_types(128, 3)
+instantiate_bs_qmm_rhs_types(128, 4)
+instantiate_bs_qmm_rhs_types(128, 6)
+instantiate_bs_qmm_rhs_types(128, 8)
+instantiate_bs_qmm_rhs_types( 64, 2)
+instantiate_bs_qmm_rhs_types( 64, 3)
+instantiate_bs_qmm_rhs_types( 64, 4)
+instantiate_bs_qmm_rhs_types( 64, 6)
+instantiate_bs_qmm_rhs_types( 64, 8)
+instantiate_bs_qmm_rhs_types( 32, 2)
+instantiate_bs_qmm_rhs_types( 32, 3)
+instantiate_bs_qmm_rhs_types( 32, 4)
+instantiate_bs_qmm_rhs_types( 32, 6)
+instantiate_bs_qmm_rhs_types( 32, 8)
+
+#define instantiate_affine_quantize(itype, group_size, bits)       \
+  instantiate_kernel(                                             \
+      "affine_quantize_" #itype "_gs_" #group_size "_b_" #bits,   \
+      affine_quantize,                                            \
+      itype,                                                      \
+      group_size,                                                 \
+      bits)                                                       \
+  instantiate_kernel(                                             \
+      "affine_dequantize_" #itype "_gs_" #group_size "_b_" #bits, \
+      affine_dequantize,                                          \
+      itype,                                                      \
+      group_size,                                                 \
+      bits)
+
+#define instantiate_affine_quantize_types(group_size, bits)     \
+  instantiate_affine_quantize(float, group_size, bits) \
+  instantiate_affine_quantize(float16_t, group_size, bits)  \
+  instantiate_affine_quantize(bfloat16_t, group_size, bits)
+
+instantiate_affine_quantize_types(128, 2)
+instantiate_affine_quantize_types(128, 3)
+instantiate_affine_quantize_types(128, 4)
+instantiate_affine_quantize_types(128, 6)
+instantiate_affine_quantize_types(128, 8)
+instantiate_affine_quantize_types( 64, 2)
+instantiate_affine_quantize_types( 64, 3)
+instantiate_affine_quantize_types( 64, 4)
+instantiate_affine_quantize_types( 64, 6)
+instantiate_affine_quantize_types( 64, 8)
+instantiate_affine_quantize_types( 32, 2)
+instantiate_affine_quantize_types( 32, 3)
+instantiate_affine_quantize_types( 32, 4)
+instantiate_affine_quantize_types( 32, 6)
+instantiate_affine_quantize_types( 32, 8) // clang-format on
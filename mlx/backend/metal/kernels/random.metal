@@ -1,5 +1,8 @@
 // Copyright © 2023 Apple Inc.
 
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/erf.h"
 #include "mlx/backend/metal/kernels/utils.h"
 
 static constexpr constant uint32_t rotations[2][4] = {
@@ -97,3 +100,94 @@ rbits threefry2x32_hash(const thread uint2& key, uint2 count) {
     }
   }
 }
+
+// Maps uniform bits to normal samples with the same steps as the composed
+// uniform and erfinv ops
+template <typename T>
+T normal_from_bits(
+    uint b,
+    constant const float* params,
+    constant const float& loc,
+    constant const float& scale) {
+  T lo = static_cast<T>(params[1]);
+  T upper = static_cast<T>(params[2]);
+  T x = static_cast<T>(static_cast<float>(b) / params[0]);
+  x = x < upper ? x : upper;
+  x = static_cast<T>(static_cast<T>(static_cast<T>(1.0f) - lo) * x);
+  x = static_cast<T>(x + lo);
+  x = static_cast<T>(erfinv(static_cast<float>(x)));
+  x = static_cast<T>(static_cast<T>(params[3]) * x);
+  if (scale != 1.0f) {
+    x = static_cast<T>(static_cast<T>(scale) * x);
+  }
+  if (loc != 0.0f) {
+    x = static_cast<T>(static_cast<T>(loc) + x);
+  }
+  return x;
+}
+
+template <typename T>
+[[kernel]] void rnormal(
+    device const uint32_t* keys,
+    device T* out,
+    constant const bool& odd,
+    constant const uint& bytes_per_key,
+    constant const int& ndim,
+    constant const int* key_shape,
+    constant const size_t* key_strides,
+    constant const float* params,
+    constant const float& loc,
+    constant const float& scale,
+    uint2 grid_dim [[threads_per_grid]],
+    uint2 index [[thread_position_in_grid]]) {
+  constexpr int per_word = 4 / sizeof(T);
+  auto kidx = 2 * index.x;
+  auto k1_elem = elem_to_loc(kidx, key_shape, key_strides, ndim);
+  auto k2_elem = elem_to_loc(kidx + 1, key_shape, key_strides, ndim);
+  auto key = uint2(keys[k1_elem], keys[k2_elem]);
+  auto half_size = grid_dim.y - odd;
+  uint elems_per_key = bytes_per_key / sizeof(T);
+  out += index.x * elems_per_key;
+  bool drop_last = odd && (index.y == half_size);
+  auto count = uint2(index.y, drop_last ? 0 : index.y + grid_dim.y);
+  auto bits = threefry2x32_hash(key, count);
+  for (int w = 0; w < (drop_last ? 1 : 2); ++w) {
+    for (int i = 0; i < per_word; ++i) {
+      uint e = count[w] * per_word + i;
+      if (e < elems_per_key) {
+        uint b = per_word == 1 ? bits.val[w]
+                               : (bits.val[w] >> (16 * i)) & 0xffff;
+        out[e] = normal_from_bits<T>(b, params, loc, scale);
+      }
+    }
+  }
+}
+
+// Keeps the element i when the i-th word of the bits is below the threshold.
+// A thread hashes the counter (j, j) for the pair of elements 2j and 2j + 1
+// of the row contiguous input.
+template <typename T>
+[[kernel]] void rdropout(
+    device const uint32_t* keys,
+    device const T* in,
+    device T* out,
+    constant const uint& threshold,
+    constant const float& scale,
+    constant const size_t& size,
+    uint index [[thread_position_in_grid]]) {
+  auto key = uint2(keys[0], keys[1]);
+  auto bits = threefry2x32_hash(key, uint2(index, index));
+  size_t offset = 2 * size_t(index);
+  for (int w = 0; w < 2 && offset + w < size; ++w) {
+    out[offset + w] = bits.val[w] < threshold
+        ? static_cast<T>(static_cast<float>(in[offset + w]) * scale)
+        : static_cast<T>(0);
+  }
+}
+
+instantiate_kernel("rnormal_float32", rnormal, float)
+instantiate_kernel("rnormal_float16", rnormal, half)
+instantiate_kernel("rnormal_bfloat16", rnormal, bfloat16_t)
+instantiate_kernel("rdropout_float32", rdropout, float)
+instantiate_kernel("rdropout_float16", rdropout, half)
+instantiate_kernel("rdropout_bfloat16", rdropout, bfloat16_t)
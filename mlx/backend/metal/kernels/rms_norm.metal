@@ -150,6 +150,136 @@ template <typename T, int N_READS = RMS_N_READS>
   }
 }
 
+// The residual variants add r to x, write the sum to h and normalize it. The
+// sums stay in registers or are read back by the thread that wrote them so x
+// and r are read once.
+template <typename T, int N_READS = RMS_N_READS>
+[[kernel]] void rms_residual_single_row(
+    const device T* x,
+    const device T* r,
+    const device T* w,
+    device T* out,
+    device T* h,
+    constant float& eps,
+    constant uint& axis_size,
+    constant uint& w_stride,
+    threadgroup float* local_inv_mean [[threadgroup(0)]],
+    threadgroup float* local_sums [[threadgroup(1)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  float acc = 0;
+  x += gid * axis_size + lid * N_READS;
+  r += gid * axis_size + lid * N_READS;
+  h += gid * axis_size + lid * N_READS;
+  w += w_stride * lid * N_READS;
+  T thread_h[N_READS];
+  for (int i = 0; i < N_READS; i++) {
+    if ((lid * N_READS + i) < axis_size) {
+      thread_h[i] = x[i] + r[i];
+      h[i] = thread_h[i];
+      float hi = thread_h[i];
+      acc += hi * hi;
+    }
+  }
+  acc = simd_sum(acc);
+  //  Initialize shared memory
+  if (simd_group_id == 0) {
+    local_sums[simd_lane_id] = 0;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Write simd accumulations into shared memory
+  if (simd_lane_id == 0) {
+    local_sums[simd_group_id] = acc;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Accumulate over simd groups
+  if (simd_group_id == 0) {
+    acc = simd_sum(local_sums[simd_lane_id]);
+    if (simd_lane_id == 0) {
+      local_inv_mean[0] = metal::precise::rsqrt(acc / axis_size + eps);
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Write the outputs
+  out += gid * axis_size + lid * N_READS;
+  for (int i = 0; i < N_READS; i++) {
+    if ((lid * N_READS + i) < axis_size) {
+      out[i] =
+          w[w_stride * i] * static_cast<T>(thread_h[i] * local_inv_mean[0]);
+    }
+  }
+}
+
+template <typename T, int N_READS = RMS_N_READS>
+[[kernel]] void rms_residual_looped(
+    const device T* x,
+    const device T* r,
+    const device T* w,
+    device T* out,
+    device T* h,
+    constant float& eps,
+    constant uint& axis_size,
+    constant uint& w_stride,
+    threadgroup float* local_inv_mean [[threadgroup(0)]],
+    threadgroup float* local_sums [[threadgroup(1)]],
+    uint gid [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  float acc = 0;
+  x += gid * axis_size + lid * N_READS;
+  r += gid * axis_size + lid * N_READS;
+  h += gid * axis_size + lid * N_READS;
+  w += w_stride * lid * N_READS;
+  for (uint j = 0; j < axis_size; j += lsize * N_READS) {
+    for (int i = 0; i < N_READS; i++) {
+      if ((j + lid * N_READS + i) < axis_size) {
+        T hi = x[i + j] + r[i + j];
+        h[i + j] = hi;
+        acc += static_cast<float>(hi) * static_cast<float>(hi);
+      }
+    }
+  }
+  acc = simd_sum(acc);
+  //  Initialize shared memory
+  if (simd_group_id == 0) {
+    local_sums[simd_lane_id] = 0;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Write simd accumulations into shared memory
+  if (simd_lane_id == 0) {
+    local_sums[simd_group_id] = acc;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Accumulate over simd groups
+  if (simd_group_id == 0) {
+    acc = simd_sum(local_sums[simd_lane_id]);
+    if (simd_lane_id == 0) {
+      local_inv_mean[0] = metal::precise::rsqrt(acc / axis_size + eps);
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Write the outputs reading back the sums written by this thread
+  out += gid * axis_size + lid * N_READS;
+  for (uint j = 0; j < axis_size; j += lsize * N_READS) {
+    for (int i = 0; i < N_READS; i++) {
+      if ((j + lid * N_READS + i) < axis_size) {
+        out[j + i] = w[w_stride * (i + j)] *
+            static_cast<T>(h[j + i] * local_inv_mean[0]);
+      }
+    }
+  }
+}
+
 template <typename T, int N_READS = RMS_N_READS>
 [[kernel]] void vjp_rms_single_row(
     const device T* x,
@@ -367,68 +497,101 @@ template <typename T, int N_READS = RMS_N_READS>
 }
 
 // clang-format off
-#define instantiate_rms_single_row(name, itype)               \
-  template [[host_name("rms" #name)]] [[kernel]] void         \
-  rms_single_row<itype>(                                      \
-      const device itype* x,                                  \
-      const device itype* w,                                  \
-      device itype* out,                                      \
-      constant float& eps,                                    \
-      constant uint& axis_size,                               \
-      constant uint& w_stride,                                \
-      threadgroup float* local_inv_mean [[threadgroup(0)]],   \
-      threadgroup float* local_sums [[threadgroup(1)]],       \
-      uint gid [[thread_position_in_grid]],                   \
-      uint lid [[thread_position_in_threadgroup]],            \
-      uint simd_lane_id [[thread_index_in_simdgroup]],        \
-      uint simd_group_id [[simdgroup_index_in_threadgroup]]); \
-                                                              \
-  template [[host_name("vjp_rms" #name)]] [[kernel]] void     \
-  vjp_rms_single_row<itype>(                                  \
-      const device itype* x,                                  \
-      const device itype* w,                                  \
-      const device itype* g,                                  \
-      device itype* gx,                                       \
-      device itype* gw,                                       \
-      constant float& eps,                                    \
-      constant uint& axis_size,                               \
-      constant uint& w_stride,                                \
-      uint gid [[thread_position_in_grid]],                   \
-      uint lid [[thread_position_in_threadgroup]],            \
-      uint simd_lane_id [[thread_index_in_simdgroup]],        \
+#define instantiate_rms_single_row(name, itype)                \
+  template [[host_name("rms" #name)]] [[kernel]] void          \
+  rms_single_row<itype>(                                       \
+      const device itype* x,                                   \
+      const device itype* w,                                   \
+      device itype* out,                                       \
+      constant float& eps,                                     \
+      constant uint& axis_size,                                \
+      constant uint& w_stride,                                 \
+      threadgroup float* local_inv_mean [[threadgroup(0)]],    \
+      threadgroup float* local_sums [[threadgroup(1)]],        \
+      uint gid [[thread_position_in_grid]],                    \
+      uint lid [[thread_position_in_threadgroup]],             \
+      uint simd_lane_id [[thread_index_in_simdgroup]],         \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);  \
+                                                               \
+  template [[host_name("rms_residual" #name)]] [[kernel]] void \
+  rms_residual_single_row<itype>(                              \
+      const device itype* x,                                   \
+      const device itype* r,                                   \
+      const device itype* w,                                   \
+      device itype* out,                                       \
+      device itype* h,                                         \
+      constant float& eps,                                     \
+      constant uint& axis_size,                                \
+      constant uint& w_stride,                                 \
+      threadgroup float* local_inv_mean [[threadgroup(0)]],    \
+      threadgroup float* local_sums [[threadgroup(1)]],        \
+      uint gid [[thread_position_in_grid]],                    \
+      uint lid [[thread_position_in_threadgroup]],             \
+      uint simd_lane_id [[thread_index_in_simdgroup]],         \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);  \
+  template [[host_name("vjp_rms" #name)]] [[kernel]] void      \
+  vjp_rms_single_row<itype>(                                   \
+      const device itype* x,                                   \
+      const device itype* w,                                   \
+      const device itype* g,                                   \
+      device itype* gx,                                        \
+      device itype* gw,                                        \
+      constant float& eps,                                     \
+      constant uint& axis_size,                                \
+      constant uint& w_stride,                                 \
+      uint gid [[thread_position_in_grid]],                    \
+      uint lid [[thread_position_in_threadgroup]],             \
+      uint simd_lane_id [[thread_index_in_simdgroup]],         \
       uint simd_group_id [[simdgroup_index_in_threadgroup]]);
 
-#define instantiate_rms_looped(name, itype)                      \
-  template [[host_name("rms_looped" #name)]] [[kernel]] void     \
-  rms_looped<itype>(                                             \
-      const device itype* x,                                     \
-      const device itype* w,                                     \
-      device itype* out,                                         \
-      constant float& eps,                                       \
-      constant uint& axis_size,                                  \
-      constant uint& w_stride,                                   \
-      threadgroup float* local_inv_mean [[threadgroup(0)]],      \
-      threadgroup float* local_sums [[threadgroup(1)]],          \
-      uint gid [[thread_position_in_grid]],                      \
-      uint lid [[thread_position_in_threadgroup]],               \
-      uint lsize [[threads_per_threadgroup]],                    \
-      uint simd_lane_id [[thread_index_in_simdgroup]],           \
-      uint simd_group_id [[simdgroup_index_in_threadgroup]]);    \
-                                                                 \
-  template [[host_name("vjp_rms_looped" #name)]] [[kernel]] void \
-  vjp_rms_looped<itype>(                                         \
-      const device itype* x,                                     \
-      const device itype* w,                                     \
-      const device itype* g,                                     \
-      device itype* gx,                                          \
-      device itype* gw,                                          \
-      constant float& eps,                                       \
-      constant uint& axis_size,                                  \
-      constant uint& w_stride,                                   \
-      uint gid [[thread_position_in_grid]],                      \
-      uint lid [[thread_position_in_threadgroup]],               \
-      uint lsize [[threads_per_threadgroup]],                    \
-      uint simd_lane_id [[thread_index_in_simdgroup]],           \
+#define instantiate_rms_looped(name, itype)                           \
+  template [[host_name("rms_looped" #name)]] [[kernel]] void          \
+  rms_looped<itype>(                                                  \
+      const device itype* x,                                          \
+      const device itype* w,                                          \
+      device itype* out,                                              \
+      constant float& eps,                                            \
+      constant uint& axis_size,                                       \
+      constant uint& w_stride,                                        \
+      threadgroup float* local_inv_mean [[threadgroup(0)]],           \
+      threadgroup float* local_sums [[threadgroup(1)]],               \
+      uint gid [[thread_position_in_grid]],                           \
+      uint lid [[thread_position_in_threadgroup]],                    \
+      uint lsize [[threads_per_threadgroup]],                         \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);         \
+                                                                      \
+  template [[host_name("rms_residual_looped" #name)]] [[kernel]] void \
+  rms_residual_looped<itype>(                                         \
+      const device itype* x,                                          \
+      const device itype* r,                                          \
+      const device itype* w,                                          \
+      device itype* out,                                              \
+      device itype* h,                                                \
+      constant float& eps,                                            \
+      constant uint& axis_size,                                       \
+      constant uint& w_stride,                                        \
+      threadgroup float* local_inv_mean [[threadgroup(0)]],           \
+      threadgroup float* local_sums [[threadgroup(1)]],               \
+      uint gid [[thread_position_in_grid]],                           \
+      uint lid [[thread_position_in_threadgroup]],                    \
+      uint lsize [[threads_per_threadgroup]],                         \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);         \
+  template [[host_name("vjp_rms_looped" #name)]] [[kernel]] void      \
+  vjp_rms_looped<itype>(                                              \
+      const device itype* x,                                          \
+      const device itype* w,                                          \
+      const device itype* g,                                          \
+      device itype* gx,                                               \
+      device itype* gw,                                               \
+      constant float& eps,                                            \
+      constant uint& axis_size,                                       \
+      constant uint& w_stride,                                        \
+      uint gid [[thread_position_in_grid]],                           \
+      uint lid [[thread_position_in_threadgroup]],                    \
+      uint lsize [[threads_per_threadgroup]],                         \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                \
       uint simd_group_id [[simdgroup_index_in_threadgroup]]);
 
 #define instantiate_rms(name, itype)      \
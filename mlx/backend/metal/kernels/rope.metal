@@ -6,16 +6,17 @@
 #include "mlx/backend/metal/kernels/utils.h"
 
 template <typename T, bool traditional, bool forward>
-[[kernel]] void rope(
-    const device T* in [[buffer(0)]],
-    device T* out [[buffer(1)]],
+void rope_impl(
+    const device T* in,
+    device T* out,
+    const device int* offset,
+    float inv_freq,
     constant const size_t strides[3],
     constant const size_t out_strides[3],
-    constant const int& offset,
-    constant const float& base,
+    constant const size_t& offset_stride,
     constant const float& scale,
-    uint3 pos [[thread_position_in_grid]],
-    uint3 grid [[threads_per_grid]]) {
+    uint3 pos,
+    uint3 grid) {
   // Compute the input and output indices
   uint in_index_1, in_index_2;
   uint out_index_1, out_index_2;
@@ -34,12 +35,11 @@ template <typename T, bool traditional, bool forward>
     in_index_2 = in_index_1 + grid.x * strides[2];
   }
 
-  // Figure out L and d.
-  float L = scale * static_cast<float>(pos.y + offset);
-  float d = static_cast<float>(pos.x) / static_cast<float>(grid.x);
+  // Figure out L, each sequence in the batch has its own offset
+  float L = scale * static_cast<float>(pos.y + offset[pos.z / offset_stride]);
 
   // Compute costheta, sintheta
-  float theta = L * metal::exp2(-d * base);
+  float theta = L * inv_freq;
   float costheta = metal::fast::cos(theta);
   float sintheta = metal::fast::sin(theta);
 
@@ -59,17 +59,87 @@ template <typename T, bool traditional, bool forward>
   out[out_index_2] = static_cast<T>(rx2);
 }
 
-#define instantiate_rope(name, type, traditional, forward) \
-  template [[host_name("rope_" #name)]] [[kernel]] void    \
-  rope<type, traditional, forward>(                        \
-      const device type* in [[buffer(0)]],                 \
-      device type* out [[buffer(1)]],                      \
-      constant const size_t strides[3],                    \
-      constant const size_t out_strides[3],                \
-      constant const int& offset,                          \
-      constant const float& base,                          \
-      constant const float& scale,                         \
-      uint3 pos [[thread_position_in_grid]],               \
+template <typename T, bool traditional, bool forward>
+[[kernel]] void rope(
+    const device T* in [[buffer(0)]],
+    device T* out [[buffer(1)]],
+    const device int* offset [[buffer(2)]],
+    constant const size_t strides[3] [[buffer(3)]],
+    constant const size_t out_strides[3] [[buffer(4)]],
+    constant const size_t& offset_stride [[buffer(5)]],
+    constant const float& base [[buffer(6)]],
+    constant const float& scale [[buffer(7)]],
+    uint3 pos [[thread_position_in_grid]],
+    uint3 grid [[threads_per_grid]]) {
+  float d = static_cast<float>(pos.x) / static_cast<float>(grid.x);
+  float inv_freq = metal::exp2(-d * base);
+  rope_impl<T, traditional, forward>(
+      in,
+      out,
+      offset,
+      inv_freq,
+      strides,
+      out_strides,
+      offset_stride,
+      scale,
+      pos,
+      grid);
+}
+
+template <typename T, bool traditional, bool forward>
+[[kernel]] void rope_freqs(
+    const device T* in [[buffer(0)]],
+    device T* out [[buffer(1)]],
+    const device int* offset [[buffer(2)]],
+    constant const size_t strides[3] [[buffer(3)]],
+    constant const size_t out_strides[3] [[buffer(4)]],
+    constant const size_t& offset_stride [[buffer(5)]],
+    constant const float& base [[buffer(6)]],
+    constant const float& scale [[buffer(7)]],
+    const device float* freqs [[buffer(8)]],
+    constant const size_t& freq_stride [[buffer(9)]],
+    uint3 pos [[thread_position_in_grid]],
+    uint3 grid [[threads_per_grid]]) {
+  float inv_freq = 1.0 / freqs[pos.x * freq_stride];
+  rope_impl<T, traditional, forward>(
+      in,
+      out,
+      offset,
+      inv_freq,
+      strides,
+      out_strides,
+      offset_stride,
+      scale,
+      pos,
+      grid);
+}
+
+#define instantiate_rope(name, type, traditional, forward)    \
+  template [[host_name("rope_" #name)]] [[kernel]] void       \
+  rope<type, traditional, forward>(                           \
+      const device type* in [[buffer(0)]],                    \
+      device type* out [[buffer(1)]],                         \
+      const device int* offset [[buffer(2)]],                 \
+      constant const size_t strides[3] [[buffer(3)]],         \
+      constant const size_t out_strides[3] [[buffer(4)]],     \
+      constant const size_t& offset_stride [[buffer(5)]],     \
+      constant const float& base [[buffer(6)]],               \
+      constant const float& scale [[buffer(7)]],              \
+      uint3 pos [[thread_position_in_grid]],                  \
+      uint3 grid [[threads_per_grid]]);                       \
+  template [[host_name("rope_freqs_" #name)]] [[kernel]] void \
+  rope_freqs<type, traditional, forward>(                     \
+      const device type* in [[buffer(0)]],                    \
+      device type* out [[buffer(1)]],                         \
+      const device int* offset [[buffer(2)]],                 \
+      constant const size_t strides[3] [[buffer(3)]],         \
+      constant const size_t out_strides[3] [[buffer(4)]],     \
+      constant const size_t& offset_stride [[buffer(5)]],     \
+      constant const float& base [[buffer(6)]],               \
+      constant const float& scale [[buffer(7)]],              \
+      const device float* freqs [[buffer(8)]],                \
+      constant const size_t& freq_stride [[buffer(9)]],       \
+      uint3 pos [[thread_position_in_grid]],                  \
       uint3 grid [[threads_per_grid]]);
 
 // clang-format off
@@ -84,4 +154,4 @@ instantiate_rope(vjp_traditional_bfloat16, bfloat16_t, true, false)
 instantiate_rope(vjp_traditional_float32, float, true, false)
 instantiate_rope(vjp_float16, half, false, false)
 instantiate_rope(vjp_bfloat16, bfloat16_t, false, false)
-instantiate_rope(vjp_float32, float, false, false) // clang-format on
\ No newline at end of file
+instantiate_rope(vjp_float32, float, false, false) // clang-format on
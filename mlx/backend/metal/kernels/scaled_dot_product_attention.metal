@@ -1,6 +1,7 @@
 #include <metal_simdgroup>
 #include <metal_stdlib>
 
+#include "mlx/backend/metal/kernels/bf16.h"
 #include "mlx/backend/metal/kernels/steel/defines.h"
 #include "mlx/backend/metal/kernels/steel/gemm/transforms.h"
 #include "mlx/backend/metal/kernels/steel/utils.h"
@@ -10,6 +11,61 @@ using namespace metal;
 
 using namespace mlx::steel;
 
+// Masking of the attention scores. A mask array is either added to the
+// scaled scores or, for a boolean mask, selects the scores which are kept.
+constant bool has_mask [[function_constant(300)]];
+constant bool bool_mask [[function_constant(301)]];
+constant bool do_causal [[function_constant(302)]];
+constant bool has_float_mask = has_mask && !bool_mask;
+constant bool has_bool_mask = has_mask && bool_mask;
+
+template <typename T>
+METAL_FUNC float apply_mask(
+    float score,
+    const device T* mask,
+    const device bool* bmask,
+    int64_t loc) {
+  if (has_bool_mask) {
+    return bmask[loc] ? score : -INFINITY;
+  } else if (has_float_mask) {
+    return score + float(mask[loc]);
+  }
+  return score;
+}
+
+// Positional masking computed from the query and key positions. A window
+// keeps the keys less than window_size positions before the query and ALiBi
+// adds a per head linear bias of the distance between them.
+constant bool has_window [[function_constant(303)]];
+constant bool has_alibi [[function_constant(304)]];
+
+METAL_FUNC float apply_position_bias(
+    float score,
+    int q_pos,
+    int k_pos,
+    int window_size,
+    float slope) {
+  if (has_window && q_pos - k_pos >= window_size) {
+    return -INFINITY;
+  }
+  if (has_alibi) {
+    score += slope * float(k_pos - q_pos);
+  }
+  return score;
+}
+
+// Masks the score of key k out of n_keys, the keys past the end have no mask
+template <typename T>
+METAL_FUNC float apply_key_mask(
+    float score,
+    const device T* mask,
+    const device bool* bmask,
+    int k,
+    int n_keys,
+    int64_t key_stride) {
+  return k < n_keys ? apply_mask(score, mask, bmask, k * key_stride) : score;
+}
+
 template <
     typename T,
     short BROWS,
@@ -597,7 +653,12 @@ struct FastAttentionKernel {
       uint simd_group_id,
       uint simd_lane_id,
       short2 local_blocks,
-      float alpha) {
+      int row,
+      int col,
+      const device T* mask,
+      const device bool* bmask,
+      float slope,
+      const constant MLXFastAttentionParams* params) {
     if (simd_group_id == 0) {
       short row_offset = BM + float_padding;
       threadgroup float* maxes = Corrections;
@@ -609,37 +670,53 @@ struct FastAttentionKernel {
         float m_i_old = maxes[simd_lane_id];
         float l_i_old = sums[simd_lane_id];
 
-        float m_i_new = m_i_old;
-        float l_i_new = l_i_old;
-
         short offset = simd_lane_id * (BN + tgp_padding);
+        row += simd_lane_id;
 
+        // Scale and mask the scores, keeping them for the second pass
         float m_ij = -INFINITY;
-
         for (short j = 0; j < local_blocks.x; j++) {
-          float val = alpha * float(Ss[offset + j]);
+          float val = params->alpha * float(Ss[offset + j]);
+          if (do_causal && col + j > row + params->causal_offset) {
+            val = -INFINITY;
+          }
+          if (has_window || has_alibi) {
+            val = apply_position_bias(
+                val,
+                row + params->causal_offset,
+                col + j,
+                params->window_size,
+                slope);
+          }
+          if (has_mask) {
+            val = apply_mask(
+                val,
+                mask,
+                bmask,
+                row * params->mask_strides[2] +
+                    (col + j) * params->mask_strides[3]);
+          }
+          Ss[offset + j] = T(val);
           m_ij = max(m_ij, val);
         }
 
-        m_i_new = max(m_ij, m_i_new);
+        float m_i_new = max(m_ij, m_i_old);
+        // Rows with every score masked so far have nothing to rescale
+        float m_shift = m_i_new == -INFINITY ? 0.f : m_i_new;
 
         float rowsum = 0.f; // lij
-
         for (short j = 0; j < local_blocks.x; j++) {
-          float val = alpha * float(Ss[offset + j]);
-          float P_i_j = exp(val - m_ij);
+          float P_i_j = exp(float(Ss[offset + j]) - m_shift);
           rowsum += P_i_j;
-          P_i_j = P_i_j * exp(m_ij - m_i_new);
           Ss[offset + j] = T(P_i_j);
         }
 
-        l_i_new =
-            exp(m_i_old - m_i_new) * l_i_old + exp(m_ij - m_i_new) * rowsum;
+        float rescale = l_i_old * exp(m_i_old - m_shift);
+        float l_i_new = rescale + rowsum;
         maxes[simd_lane_id] = m_i_new;
         sums[simd_lane_id] = l_i_new;
-        float rescale = l_i_old * exp(m_i_old - m_i_new);
         o_rescale[simd_lane_id] = rescale;
-        output_scales[simd_lane_id] = 1.0 / l_i_new;
+        output_scales[simd_lane_id] = l_i_new > 0.f ? 1.0 / l_i_new : 0.f;
       }
     }
   }
@@ -651,6 +728,9 @@ struct FastAttentionKernel {
       const device T* V [[buffer(2)]],
       device U* O [[buffer(3)]],
       const constant MLXFastAttentionParams* params [[buffer(4)]],
+      const device T* mask,
+      const device bool* bmask,
+      float slope,
       threadgroup T* Qs [[threadgroup(0)]],
       threadgroup T* Ks [[threadgroup(1)]],
       threadgroup T* Ss [[threadgroup(2)]],
@@ -694,8 +774,27 @@ struct FastAttentionKernel {
     thread loader_k_t loader_k(K, params->ldk, Ks, simd_group_id, simd_lane_id);
     thread loader_v_t loader_v(V, params->ldv, Vs, simd_group_id, simd_lane_id);
 
-    for (short n_block = 0; n_block < params->gemm_n_iterations_aligned;
-         n_block++) {
+    // With a causal mask the blocks of keys after the last query of the tile
+    // are skipped
+    int n_blocks = params->gemm_n_iterations_aligned;
+    if (do_causal) {
+      n_blocks = min(
+          n_blocks, (c_row + tgp_bm - 1 + params->causal_offset) / BN + 1);
+    }
+
+    // With a window the blocks of keys before the window of the first query
+    // of the tile are skipped
+    int first_block = 0;
+    if (has_window) {
+      int first_key = c_row + params->causal_offset - params->window_size + 1;
+      first_block = max(first_key, 0) / BN;
+      for (int n_block = 0; n_block < first_block; n_block++) {
+        loader_v.next();
+        loader_k.next(BN);
+      }
+    }
+
+    for (int n_block = first_block; n_block < n_blocks; n_block++) {
       short c_col = BN;
 
       // Prepare threadgroup loading operations
@@ -758,7 +857,12 @@ struct FastAttentionKernel {
           simd_group_id,
           simd_lane_id,
           short2(tgp_bn_qk, tgp_bm),
-          params->alpha);
+          c_row,
+          n_block * BN,
+          mask,
+          bmask,
+          slope,
+          params);
 
       loader_v.load_safe(short2(BK, tgp_bn_qk));
 
@@ -805,6 +909,10 @@ template <
     const constant MLXFastAttentionParams* params [[buffer(4)]],
     const constant int* batch_shape [[buffer(6)]],
     const constant size_t* batch_strides [[buffer(7)]],
+    const device T* mask [[buffer(8), function_constant(has_float_mask)]],
+    const device bool* bmask [[buffer(9), function_constant(has_bool_mask)]],
+    const device float* alibi_slopes
+    [[buffer(10), function_constant(has_alibi)]],
     uint simd_lane_id [[thread_index_in_simdgroup]],
     uint simd_group_id [[simdgroup_index_in_threadgroup]],
     uint3 tid [[threadgroup_position_in_grid]],
@@ -837,12 +945,25 @@ template <
 
   } else {
     Q += params->batch_stride_q * tid.z;
-    K += params->batch_stride_k * tid.z;
-    V += params->batch_stride_v * tid.z;
+    K += params->batch_stride_k * (tid.z / params->gqa_factor);
+    V += params->batch_stride_v * (tid.z / params->gqa_factor);
   }
 
   // same shape as input
   O += params->batch_stride_o * tid.z;
+
+  // The mask buffers only exist when their function constant is set
+  const device T* mask_ = nullptr;
+  const device bool* bmask_ = nullptr;
+  int64_t mask_offset = (tid.z / params->n_heads) * params->mask_strides[0] +
+      (tid.z % params->n_heads) * params->mask_strides[1];
+  if (has_float_mask) {
+    mask_ = mask + mask_offset;
+  }
+  if (has_bool_mask) {
+    bmask_ = bmask + mask_offset;
+  }
+  float slope = has_alibi ? alibi_slopes[tid.z % params->n_heads] : 0.f;
   threadgroup T Qs[attention_kernel::tgp_mem_size_q];
   threadgroup T Ss[attention_kernel::tgp_mem_size_s];
   threadgroup float Corrections[attention_kernel::tgp_mem_size_corrections];
@@ -856,6 +977,9 @@ template <
         V,
         O,
         params,
+        mask_,
+        bmask_,
+        slope,
         Qs,
         Ks,
         Ss,
@@ -874,6 +998,9 @@ template <
         V,
         O,
         params,
+        mask_,
+        bmask_,
+        slope,
         Qs,
         Ks,
         Ss,
@@ -887,9 +1014,9 @@ template <
 }
 
 #define instantiate_fast_inference_self_attention_kernel(                   \
-    itype, otype, bm, bn, bk, wm, wn)                                       \
+    tname, itype, otype, bm, bn, bk, wm, wn)                                \
   template [[host_name("steel_gemm_attention_bm_" #bm "_bn_" #bn "_bk_" #bk \
-                       "_itype_" #itype)]] [[kernel]] void                  \
+                       "_itype_" #tname)]] [[kernel]] void                  \
   attention<itype, bm, bn, bk, wm, wn, false, true, false, false, true>(    \
       const device itype* Q [[buffer(0)]],                                  \
       const device itype* K [[buffer(1)]],                                  \
@@ -898,29 +1025,28 @@ template <
       const constant MLXFastAttentionParams* params [[buffer(4)]],          \
       const constant int* batch_shape [[buffer(6)]],                        \
       const constant size_t* batch_strides [[buffer(7)]],                   \
+      const device itype* mask                                              \
+      [[buffer(8), function_constant(has_float_mask)]],                     \
+      const device bool* bmask                                              \
+      [[buffer(9), function_constant(has_bool_mask)]],                      \
+      const device float* alibi_slopes                                      \
+      [[buffer(10), function_constant(has_alibi)]],                         \
       uint simd_lane_id [[thread_index_in_simdgroup]],                      \
       uint simd_group_id [[simdgroup_index_in_threadgroup]],                \
       uint3 tid [[threadgroup_position_in_grid]],                           \
       uint3 lid [[thread_position_in_threadgroup]]);
 
-instantiate_fast_inference_self_attention_kernel(
-    float,
-    float,
-    16,
-    16,
-    64,
-    2,
-    2);
-instantiate_fast_inference_self_attention_kernel(
-    float,
-    float,
-    16,
-    16,
-    128,
-    2,
-    2);
-instantiate_fast_inference_self_attention_kernel(half, half, 16, 16, 64, 2, 2);
-instantiate_fast_inference_self_attention_kernel(half, half, 16, 16, 128, 2, 2);
+// clang-format off
+#define instantiate_fast_inference_self_attention_shapes_helper(   \
+    tname, itype)                                                  \
+  instantiate_fast_inference_self_attention_kernel(                \
+      tname, itype, itype, 16, 16, 64, 2, 2)                       \
+  instantiate_fast_inference_self_attention_kernel(                \
+      tname, itype, itype, 16, 16, 128, 2, 2) // clang-format on
+
+instantiate_fast_inference_self_attention_shapes_helper(float, float);
+instantiate_fast_inference_self_attention_shapes_helper(half, half);
+instantiate_fast_inference_self_attention_shapes_helper(bfloat16, bfloat16_t);
 
 template <
     typename T,
@@ -937,6 +1063,10 @@ template <
     device float* O_partials [[buffer(5)]],
     device float* p_lse [[buffer(6)]],
     device float* p_maxes [[buffer(7)]],
+    const device T* mask [[buffer(8), function_constant(has_float_mask)]],
+    const device bool* bmask [[buffer(9), function_constant(has_bool_mask)]],
+    const device float* alibi_slopes
+    [[buffer(10), function_constant(has_alibi)]],
     threadgroup T* threadgroup_block [[threadgroup(0)]],
     uint simd_lane_id [[thread_index_in_simdgroup]],
     uint simd_group_id [[simdgroup_index_in_threadgroup]],
@@ -959,6 +1089,31 @@ template <
       SIMDGROUP_MATRIX_LOAD_FACTOR * (MATRIX_LOADS_PER_SIMDGROUP + 1) *
       NSIMDGROUPS;
 
+  // The queries are the last ones of the sequence, a tile of keys entirely
+  // before the window of the query contributes nothing and is skipped
+  const uint q_head = tid.x / params.QUERY_SEQUENCE_LENGTH;
+  const uint q_row = tid.x % params.QUERY_SEQUENCE_LENGTH;
+  const int q_pos = int(L) - int(params.QUERY_SEQUENCE_LENGTH) + int(q_row);
+  const int first_tile_key = tid.y * TILE_SIZE_CONST;
+  const int last_tile_key =
+      min(int(L), first_tile_key + int(TILE_SIZE_CONST)) - 1;
+  if (has_window && q_pos - last_tile_key >= params.WINDOW_SIZE) {
+    if (simd_group_id == 0) {
+      device float* oPartialGmem =
+          O_partials + tid.x * DK * params.KV_TILES + tid.y * DK;
+      ((device float4*)oPartialGmem)[simd_lane_id] = float4(0.f);
+    }
+    if (simd_group_id == 0 && simd_lane_id == 0) {
+      const uint gmem_partial_scalar_offset =
+          tid.z * params.N_Q_HEADS * params.KV_TILES +
+          tid.x * params.KV_TILES + tid.y;
+      p_lse[gmem_partial_scalar_offset] = -INFINITY;
+      p_maxes[gmem_partial_scalar_offset] = -INFINITY;
+    }
+    return;
+  }
+  const float slope = has_alibi ? alibi_slopes[q_head] : 0.f;
+
   threadgroup T4* smemFlush = (threadgroup T4*)threadgroup_block;
 #pragma clang loop unroll(full)
   for (uint i = 0; i < 8; i++) {
@@ -967,13 +1122,16 @@ template <
          i * NSIMDGROUPS * THREADS_PER_SIMDGROUP] = T4(0.f);
   }
   threadgroup_barrier(mem_flags::mem_threadgroup);
-  // TODO: multiple query sequence length for speculative decoding
+  // Several queries of a head, e.g. draft tokens being verified, are laid out
+  // as consecutive heads sharing the keys of the head
   const uint tgroup_query_head_offset =
       tid.x * DK + tid.z * (params.N_Q_HEADS * DK);
 
-  const uint tgroup_k_head_offset = kv_head_offset_factor * DK * L;
+  const uint tgroup_k_head_offset =
+      kv_head_offset_factor * DK * params.K_HEAD_ROWS;
   const uint tgroup_k_tile_offset = tid.y * TILE_SIZE_CONST * DK;
-  const uint tgroup_k_batch_offset = tid.z * L * params.N_KV_HEADS * DK;
+  const uint tgroup_k_batch_offset =
+      tid.z * params.K_HEAD_ROWS * params.N_KV_HEADS * DK;
 
   const device T* baseK =
       K + tgroup_k_batch_offset + tgroup_k_tile_offset + tgroup_k_head_offset;
@@ -1051,6 +1209,22 @@ template <
 
   threadgroup_barrier(mem_flags::mem_threadgroup);
 
+  // The mask of the keys in the tile
+  const device T* mask_ = nullptr;
+  const device bool* bmask_ = nullptr;
+  const int64_t mask_offset = tid.z * params.MASK_STRIDES[0] +
+      q_head * params.MASK_STRIDES[1] + q_row * params.MASK_STRIDES[2] +
+      tid.y * TILE_SIZE_CONST * params.MASK_STRIDES[3];
+  if (has_float_mask) {
+    mask_ = mask + mask_offset;
+  }
+  if (has_bool_mask) {
+    bmask_ = bmask + mask_offset;
+  }
+  const int tile_keys =
+      min(int(TILE_SIZE_CONST), int(L - tid.y * TILE_SIZE_CONST));
+  const int64_t key_stride = params.MASK_STRIDES[3];
+
   float groupMax;
   float lse = 0.f;
 
@@ -1069,17 +1243,34 @@ template <
     threadgroup float2* smemPtrFlt2 = (threadgroup float2*)threadgroup_block;
     float2 vals = smemPtrFlt2[simd_lane_id];
     vals *= params.INV_ALPHA;
+    if (has_mask) {
+      int k = 2 * simd_lane_id;
+      vals.x =
+          apply_key_mask(vals.x, mask_, bmask_, k, tile_keys, key_stride);
+      vals.y =
+          apply_key_mask(vals.y, mask_, bmask_, k + 1, tile_keys, key_stride);
+    }
+    if (has_window || has_alibi) {
+      int k_pos = first_tile_key + 2 * simd_lane_id;
+      vals.x = apply_position_bias(
+          vals.x, q_pos, k_pos, params.WINDOW_SIZE, slope);
+      vals.y = apply_position_bias(
+          vals.y, q_pos, k_pos + 1, params.WINDOW_SIZE, slope);
+    }
     float maxval = max(vals.x, vals.y);
     simdgroup_barrier(mem_flags::mem_none);
     groupMax = simd_max(maxval);
+    // A tile with every key masked contributes nothing
+    float shift = groupMax == -INFINITY ? 0.f : groupMax;
 
-    float2 expf_shifted = exp(vals - groupMax);
+    float2 expf_shifted = exp(vals - shift);
     float sumExpLocal = expf_shifted.x + expf_shifted.y;
     simdgroup_barrier(mem_flags::mem_none);
     float tgroupExpSum = simd_sum(sumExpLocal);
 
     lse = log(tgroupExpSum);
-    float2 local_p_hat = expf_shifted / tgroupExpSum;
+    float2 local_p_hat =
+        tgroupExpSum > 0.f ? expf_shifted / tgroupExpSum : float2(0.f);
     pvals[0].x = local_p_hat.x;
     pvals[0].y = local_p_hat.y;
     smemPtrFlt2[simd_lane_id] = float2(0.f);
@@ -1094,33 +1285,59 @@ template <
     for (int i = 0; i < TILE_SIZE_ITERS_128; i++) {
       float4 vals = smemPtrFlt4[simd_lane_id + i * THREADS_PER_SIMDGROUP];
       vals *= params.INV_ALPHA;
+      if (has_mask) {
+        int k = 4 * (simd_lane_id + i * THREADS_PER_SIMDGROUP);
+        vals.x =
+            apply_key_mask(vals.x, mask_, bmask_, k, tile_keys, key_stride);
+        vals.y = apply_key_mask(
+            vals.y, mask_, bmask_, k + 1, tile_keys, key_stride);
+        vals.z = apply_key_mask(
+            vals.z, mask_, bmask_, k + 2, tile_keys, key_stride);
+        vals.w = apply_key_mask(
+            vals.w, mask_, bmask_, k + 3, tile_keys, key_stride);
+      }
+      if (has_window || has_alibi) {
+        int k_pos =
+            first_tile_key + 4 * (simd_lane_id + i * THREADS_PER_SIMDGROUP);
+        vals.x = apply_position_bias(
+            vals.x, q_pos, k_pos, params.WINDOW_SIZE, slope);
+        vals.y = apply_position_bias(
+            vals.y, q_pos, k_pos + 1, params.WINDOW_SIZE, slope);
+        vals.z = apply_position_bias(
+            vals.z, q_pos, k_pos + 2, params.WINDOW_SIZE, slope);
+        vals.w = apply_position_bias(
+            vals.w, q_pos, k_pos + 3, params.WINDOW_SIZE, slope);
+      }
       pvals[i] = vals;
       maxval = fmax3(vals.x, vals.y, maxval);
       maxval = fmax3(vals.z, vals.w, maxval);
     }
     simdgroup_barrier(mem_flags::mem_none);
     groupMax = simd_max(maxval);
+    float shift = groupMax == -INFINITY ? 0.f : groupMax;
 
     float sumExpLocal = 0.f;
 #pragma clang loop unroll(full)
     for (int i = 0; i < TILE_SIZE_ITERS_128; i++) {
-      pvals[i] = exp(pvals[i] - groupMax);
+      pvals[i] = exp(pvals[i] - shift);
       sumExpLocal += pvals[i].x + pvals[i].y + pvals[i].z + pvals[i].w;
     }
     simdgroup_barrier(mem_flags::mem_none);
     float tgroupExpSum = simd_sum(sumExpLocal);
     lse = log(tgroupExpSum);
+    float inv_sum = tgroupExpSum > 0.f ? 1.f / tgroupExpSum : 0.f;
 #pragma clang loop unroll(full)
     for (int i = 0; i < TILE_SIZE_ITERS_128; i++) {
-      pvals[i] = pvals[i] / tgroupExpSum;
+      pvals[i] = pvals[i] * inv_sum;
       smemPtrFlt4[simd_lane_id + i * THREADS_PER_SIMDGROUP] = float4(0.f);
     }
   }
 
   threadgroup T* smemV = (threadgroup T*)threadgroup_block;
 
-  const size_t v_batch_offset = tid.z * params.N_KV_HEADS * L * DK;
-  const size_t v_head_offset = kv_head_offset_factor * L * DK;
+  const size_t v_batch_offset =
+      tid.z * params.N_KV_HEADS * params.V_HEAD_ROWS * DK;
+  const size_t v_head_offset = kv_head_offset_factor * params.V_HEAD_ROWS * DK;
 
   const size_t v_tile_offset = tid.y * TILE_SIZE_CONST * DK;
   const size_t v_offset = v_batch_offset + v_head_offset + v_tile_offset;
@@ -1323,8 +1540,8 @@ template <
 }
 
 #define instantiate_fast_inference_sdpa_to_partials_kernel(                  \
-    itype, itype2, itype4, tile_size, nsimdgroups)                           \
-  template [[host_name("fast_inference_sdpa_compute_partials_" #itype        \
+    tname, itype, itype2, itype4, tile_size, nsimdgroups)                    \
+  template [[host_name("fast_inference_sdpa_compute_partials_" #tname        \
                        "_" #tile_size "_" #nsimdgroups)]] [[kernel]] void    \
   fast_inference_sdpa_compute_partials_template<                             \
       itype,                                                                 \
@@ -1340,6 +1557,12 @@ template <
       device float* O_partials [[buffer(5)]],                                \
       device float* p_lse [[buffer(6)]],                                     \
       device float* p_maxes [[buffer(7)]],                                   \
+      const device itype* mask                                               \
+      [[buffer(8), function_constant(has_float_mask)]],                      \
+      const device bool* bmask                                               \
+      [[buffer(9), function_constant(has_bool_mask)]],                       \
+      const device float* alibi_slopes                                       \
+      [[buffer(10), function_constant(has_alibi)]],                          \
       threadgroup itype* threadgroup_block [[threadgroup(0)]],               \
       uint simd_lane_id [[thread_index_in_simdgroup]],                       \
       uint simd_group_id [[simdgroup_index_in_threadgroup]],                 \
@@ -1347,54 +1570,90 @@ template <
 
 // clang-format off
 #define instantiate_fast_inference_sdpa_to_partials_shapes_helper( \
-    itype, itype2, itype4, tile_size)                              \
+    tname, itype, itype2, itype4, tile_size)                       \
   instantiate_fast_inference_sdpa_to_partials_kernel(              \
-      itype, itype2, itype4, tile_size, 4)                         \
+      tname, itype, itype2, itype4, tile_size, 4)                  \
   instantiate_fast_inference_sdpa_to_partials_kernel(              \
-      itype, itype2, itype4, tile_size, 8) // clang-format on
+      tname, itype, itype2, itype4, tile_size, 8) // clang-format on
 
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    float,
     float,
     float2,
     float4,
     64);
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    float,
     float,
     float2,
     float4,
     128);
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    float,
     float,
     float2,
     float4,
     256);
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    float,
     float,
     float2,
     float4,
     512);
 
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    half,
     half,
     half2,
     half4,
     64);
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    half,
     half,
     half2,
     half4,
     128);
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    half,
     half,
     half2,
     half4,
     256);
 instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    half,
     half,
     half2,
     half4,
     512);
 
+// The bfloat vectors of the decoding kernel need Metal 3.1
+#if defined METAL_3_1 || defined METAL_3_2
+instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    bfloat16,
+    bfloat16_t,
+    bfloat2,
+    bfloat4,
+    64);
+instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    bfloat16,
+    bfloat16_t,
+    bfloat2,
+    bfloat4,
+    128);
+instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    bfloat16,
+    bfloat16_t,
+    bfloat2,
+    bfloat4,
+    256);
+instantiate_fast_inference_sdpa_to_partials_shapes_helper(
+    bfloat16,
+    bfloat16_t,
+    bfloat2,
+    bfloat4,
+    512);
+#endif
+
 template <typename T>
 void fast_inference_sdpa_reduce_tiles_template(
     const device float* O_partials [[buffer(0)]],
@@ -1467,3 +1726,846 @@ kernel void fast_inference_sdpa_reduce_tiles_half(
   fast_inference_sdpa_reduce_tiles_template<half>(
       O_partials, p_lse, p_maxes, params, O, tid, lid);
 }
+
+kernel void fast_inference_sdpa_reduce_tiles_bfloat16(
+    const device float* O_partials [[buffer(0)]],
+    const device float* p_lse [[buffer(1)]],
+    const device float* p_maxes [[buffer(2)]],
+    const device MLXScaledDotProductAttentionParams& params [[buffer(3)]],
+    device bfloat16_t* O [[buffer(4)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]]) {
+  fast_inference_sdpa_reduce_tiles_template<bfloat16_t>(
+      O_partials, p_lse, p_maxes, params, O, tid, lid);
+}
+
+// Dequantizes N consecutive elements of a row of head dimension DK starting
+// at col. The elements are in the same group as col is a multiple of N.
+template <typename T, int DK, int group_size, int bits, int N>
+METAL_FUNC void dequantize_row_elements(
+    const device uint32_t* w,
+    const device T* scales,
+    const device T* biases,
+    size_t row,
+    int col,
+    thread float (&out)[N]) {
+  constexpr int pack_factor = 32 / bits;
+  constexpr uint8_t bitmask = (1 << bits) - 1;
+  const device uint8_t* w_row =
+      (const device uint8_t*)(w + row * (DK / pack_factor));
+  const size_t g = row * (DK / group_size) + col / group_size;
+  const float scale = float(scales[g]);
+  const float bias = float(biases[g]);
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    int bit = (col + i) * bits;
+    out[i] = scale * float((w_row[bit / 8] >> (bit % 8)) & bitmask) + bias;
+  }
+}
+
+// Computes the partial attention of one query head over a tile of keys and
+// values quantized along the head dimension. The partials are combined by
+// fast_inference_sdpa_reduce_tiles like the ones of the unquantized kernel.
+template <typename T, int group_size, int bits>
+[[kernel]] void fast_inference_sdpa_quantized_compute_partials(
+    const device T* Q [[buffer(0)]],
+    const device uint32_t* K [[buffer(1)]],
+    const device T* K_scales [[buffer(2)]],
+    const device T* K_biases [[buffer(3)]],
+    const device uint32_t* V [[buffer(4)]],
+    const device T* V_scales [[buffer(5)]],
+    const device T* V_biases [[buffer(6)]],
+    const constant uint& L [[buffer(7)]],
+    const constant uint& tile_size [[buffer(8)]],
+    const constant MLXScaledDotProductAttentionParams& params [[buffer(9)]],
+    device float* O_partials [[buffer(10)]],
+    device float* p_lse [[buffer(11)]],
+    device float* p_maxes [[buffer(12)]],
+    const device T* mask [[buffer(13), function_constant(has_float_mask)]],
+    const device bool* bmask [[buffer(14), function_constant(has_bool_mask)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr int DK = 128;
+  constexpr int MAX_TILE_SIZE = 512;
+  constexpr int NSIMDGROUPS = 8;
+  constexpr int N = DK / 32;
+
+  threadgroup float scores[MAX_TILE_SIZE];
+  threadgroup float outs[NSIMDGROUPS * DK];
+
+  // Each lane works on N consecutive elements of the head dimension
+  const int col = simd_lane_id * N;
+  const int kv_head = tid.x / (params.N_Q_HEADS / params.N_KV_HEADS);
+  const int start = tid.y * tile_size;
+  const int n_keys = min(int(tile_size), int(L) - start);
+  const size_t kv_row = (size_t(tid.z) * params.N_KV_HEADS + kv_head) * L +
+      start;
+  const size_t q_row = size_t(tid.z) * params.N_Q_HEADS + tid.x;
+
+  const device T* mask_ = nullptr;
+  const device bool* bmask_ = nullptr;
+  const int64_t mask_offset = tid.z * params.MASK_STRIDES[0] +
+      tid.x * params.MASK_STRIDES[1] + start * params.MASK_STRIDES[3];
+  if (has_float_mask) {
+    mask_ = mask + mask_offset;
+  }
+  if (has_bool_mask) {
+    bmask_ = bmask + mask_offset;
+  }
+
+  float q[N];
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    q[i] = params.INV_ALPHA * float(Q[q_row * DK + col + i]);
+  }
+
+  // Scores of the keys of the tile
+  for (int j = simd_group_id; j < n_keys; j += NSIMDGROUPS) {
+    float k[N];
+    dequantize_row_elements<T, DK, group_size, bits>(
+        K, K_scales, K_biases, kv_row + j, col, k);
+    float score = 0.f;
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      score += q[i] * k[i];
+    }
+    score = simd_sum(score);
+    if (simd_lane_id == 0) {
+      scores[j] = apply_mask(
+          score, mask_, bmask_, int64_t(j) * params.MASK_STRIDES[3]);
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Softmax of the tile, a tile with every key masked contributes nothing
+  if (simd_group_id == 0) {
+    float max_score = -INFINITY;
+    for (int j = simd_lane_id; j < n_keys; j += 32) {
+      max_score = max(max_score, scores[j]);
+    }
+    max_score = simd_max(max_score);
+    float shift = max_score == -INFINITY ? 0.f : max_score;
+    float sum = 0.f;
+    for (int j = simd_lane_id; j < n_keys; j += 32) {
+      sum += exp(scores[j] - shift);
+    }
+    sum = simd_sum(sum);
+    float inv_sum = sum > 0.f ? 1.f / sum : 0.f;
+    for (int j = simd_lane_id; j < n_keys; j += 32) {
+      scores[j] = exp(scores[j] - shift) * inv_sum;
+    }
+    if (simd_lane_id == 0) {
+      const size_t p_offset = q_row * params.KV_TILES + tid.y;
+      p_lse[p_offset] = log(sum);
+      p_maxes[p_offset] = max_score;
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Probabilities times the values of the tile
+  float o[N] = {0.f};
+  for (int j = simd_group_id; j < n_keys; j += NSIMDGROUPS) {
+    float p = scores[j];
+    float v[N];
+    dequantize_row_elements<T, DK, group_size, bits>(
+        V, V_scales, V_biases, kv_row + j, col, v);
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      o[i] += p * v[i];
+    }
+  }
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    outs[simd_group_id * DK + col + i] = o[i];
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  if (simd_group_id == 0) {
+    device float* O_tile =
+        O_partials + (q_row * params.KV_TILES + tid.y) * DK + col;
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      float acc = 0.f;
+      for (int g = 0; g < NSIMDGROUPS; g++) {
+        acc += outs[g * DK + col + i];
+      }
+      O_tile[i] = acc;
+    }
+  }
+}
+
+#define instantiate_fast_inference_sdpa_quantized_kernel(                  \
+    tname, itype, group_size, bits)                                        \
+  template [[host_name(                                                    \
+      "fast_inference_sdpa_quantized_compute_partials_" #tname "_gs_"      \
+      #group_size "_b_" #bits)]] [[kernel]] void                           \
+  fast_inference_sdpa_quantized_compute_partials<itype, group_size, bits>( \
+      const device itype* Q [[buffer(0)]],                                 \
+      const device uint32_t* K [[buffer(1)]],                              \
+      const device itype* K_scales [[buffer(2)]],                          \
+      const device itype* K_biases [[buffer(3)]],                          \
+      const device uint32_t* V [[buffer(4)]],                              \
+      const device itype* V_scales [[buffer(5)]],                          \
+      const device itype* V_biases [[buffer(6)]],                          \
+      const constant uint& L [[buffer(7)]],                                \
+      const constant uint& tile_size [[buffer(8)]],                        \
+      const constant MLXScaledDotProductAttentionParams& params            \
+      [[buffer(9)]],                                                       \
+      device float* O_partials [[buffer(10)]],                             \
+      device float* p_lse [[buffer(11)]],                                  \
+      device float* p_maxes [[buffer(12)]],                                \
+      const device itype* mask                                             \
+      [[buffer(13), function_constant(has_float_mask)]],                   \
+      const device bool* bmask                                             \
+      [[buffer(14), function_constant(has_bool_mask)]],                    \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                     \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],               \
+      uint3 tid [[threadgroup_position_in_grid]]);
+
+// clang-format off
+#define instantiate_fast_inference_sdpa_quantized_groups(tname, itype, bits) \
+  instantiate_fast_inference_sdpa_quantized_kernel(tname, itype, 32, bits)   \
+  instantiate_fast_inference_sdpa_quantized_kernel(tname, itype, 64, bits)   \
+  instantiate_fast_inference_sdpa_quantized_kernel(tname, itype, 128, bits)
+
+#define instantiate_fast_inference_sdpa_quantized_types(tname, itype) \
+  instantiate_fast_inference_sdpa_quantized_groups(tname, itype, 2)   \
+  instantiate_fast_inference_sdpa_quantized_groups(tname, itype, 4)   \
+  instantiate_fast_inference_sdpa_quantized_groups(tname, itype, 8)
+
+instantiate_fast_inference_sdpa_quantized_types(float, float)
+instantiate_fast_inference_sdpa_quantized_types(half, half)
+instantiate_fast_inference_sdpa_quantized_types(bfloat16, bfloat16_t)
+// clang-format on
+
+// Row of the caches holding position pos of the sequence with the pages blocks
+METAL_FUNC size_t paged_row(
+    const device int32_t* blocks,
+    int pos,
+    int kv_head,
+    int n_kv_heads,
+    int block_size) {
+  const size_t block = blocks[pos / block_size];
+  return (block * n_kv_heads + kv_head) * block_size + pos % block_size;
+}
+
+// Computes the partial attention of the query of one head of a sequence over
+// a tile of keys and values stored in pages of the caches. The pages of the
+// sequence are looked up in its row of the block table and the tiles past
+// the length of the sequence contribute nothing.
+template <typename T>
+[[kernel]] void fast_inference_paged_attention_compute_partials(
+    const device T* Q [[buffer(0)]],
+    const device T* K [[buffer(1)]],
+    const device T* V [[buffer(2)]],
+    const device int32_t* block_tables [[buffer(3)]],
+    const device int32_t* context_lengths [[buffer(4)]],
+    const constant MLXPagedAttentionParams& pparams [[buffer(5)]],
+    const constant MLXScaledDotProductAttentionParams& params [[buffer(6)]],
+    device float* O_partials [[buffer(7)]],
+    device float* p_lse [[buffer(8)]],
+    device float* p_maxes [[buffer(9)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr int DK = 128;
+  constexpr int MAX_TILE_SIZE = 512;
+  constexpr int NSIMDGROUPS = 8;
+  constexpr int N = DK / 32;
+
+  threadgroup float scores[MAX_TILE_SIZE];
+  threadgroup float outs[NSIMDGROUPS * DK];
+
+  // Each lane works on N consecutive elements of the head dimension
+  const int col = simd_lane_id * N;
+  const int kv_head = tid.x / (params.N_Q_HEADS / params.N_KV_HEADS);
+  const int start = tid.y * pparams.tile_size;
+  const int n_keys =
+      max(0, min(pparams.tile_size, context_lengths[tid.z] - start));
+  const device int32_t* blocks = block_tables + tid.z * pparams.max_blocks;
+  const size_t q_row = size_t(tid.z) * params.N_Q_HEADS + tid.x;
+
+  float q[N];
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    q[i] = params.INV_ALPHA * float(Q[q_row * DK + col + i]);
+  }
+
+  // Scores of the keys of the tile
+  for (int j = simd_group_id; j < n_keys; j += NSIMDGROUPS) {
+    const size_t row = paged_row(
+        blocks, start + j, kv_head, params.N_KV_HEADS, pparams.block_size);
+    float score = 0.f;
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      score += q[i] * float(K[row * DK + col + i]);
+    }
+    score = simd_sum(score);
+    if (simd_lane_id == 0) {
+      scores[j] = score;
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Softmax of the tile
+  if (simd_group_id == 0) {
+    float max_score = -INFINITY;
+    for (int j = simd_lane_id; j < n_keys; j += 32) {
+      max_score = max(max_score, scores[j]);
+    }
+    max_score = simd_max(max_score);
+    float shift = max_score == -INFINITY ? 0.f : max_score;
+    float sum = 0.f;
+    for (int j = simd_lane_id; j < n_keys; j += 32) {
+      sum += exp(scores[j] - shift);
+    }
+    sum = simd_sum(sum);
+    float inv_sum = sum > 0.f ? 1.f / sum : 0.f;
+    for (int j = simd_lane_id; j < n_keys; j += 32) {
+      scores[j] = exp(scores[j] - shift) * inv_sum;
+    }
+    if (simd_lane_id == 0) {
+      const size_t p_offset = q_row * params.KV_TILES + tid.y;
+      p_lse[p_offset] = log(sum);
+      p_maxes[p_offset] = max_score;
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Probabilities times the values of the tile
+  float o[N] = {0.f};
+  for (int j = simd_group_id; j < n_keys; j += NSIMDGROUPS) {
+    const size_t row = paged_row(
+        blocks, start + j, kv_head, params.N_KV_HEADS, pparams.block_size);
+    float p = scores[j];
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      o[i] += p * float(V[row * DK + col + i]);
+    }
+  }
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    outs[simd_group_id * DK + col + i] = o[i];
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  if (simd_group_id == 0) {
+    device float* O_tile =
+        O_partials + (q_row * params.KV_TILES + tid.y) * DK + col;
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      float acc = 0.f;
+      for (int g = 0; g < NSIMDGROUPS; g++) {
+        acc += outs[g * DK + col + i];
+      }
+      O_tile[i] = acc;
+    }
+  }
+}
+
+#define instantiate_fast_inference_paged_attention_kernel(tname, itype)     \
+  template [[host_name("fast_inference_paged_attention_compute_partials_" \
+                       #tname)]] [[kernel]] void                          \
+  fast_inference_paged_attention_compute_partials<itype>(                 \
+      const device itype* Q [[buffer(0)]],                                \
+      const device itype* K [[buffer(1)]],                                \
+      const device itype* V [[buffer(2)]],                                \
+      const device int32_t* block_tables [[buffer(3)]],                   \
+      const device int32_t* context_lengths [[buffer(4)]],                \
+      const constant MLXPagedAttentionParams& pparams [[buffer(5)]],      \
+      const constant MLXScaledDotProductAttentionParams& params           \
+      [[buffer(6)]],                                                      \
+      device float* O_partials [[buffer(7)]],                             \
+      device float* p_lse [[buffer(8)]],                                  \
+      device float* p_maxes [[buffer(9)]],                                \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                    \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],              \
+      uint3 tid [[threadgroup_position_in_grid]]);
+
+instantiate_fast_inference_paged_attention_kernel(float, float);
+instantiate_fast_inference_paged_attention_kernel(half, half);
+instantiate_fast_inference_paged_attention_kernel(bfloat16, bfloat16_t);
+
+///////////////////////////////////////////////////////////////////////////////
+// Attention gradients
+//
+// The attention probabilities are recomputed from the logsumexp of each row
+// of scores, so the memory used is linear in the sequence lengths. Each
+// simdgroup works on a row of queries or keys with lane l holding elements
+// [l * N, (l + 1) * N) of the head dimension.
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T, int N>
+METAL_FUNC void load_row(const device T* row, int col, thread float (&out)[N]) {
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    out[i] = float(row[col + i]);
+  }
+}
+
+template <typename T, int N>
+METAL_FUNC float
+row_dot(thread const float (&a)[N], const device T* row, int col) {
+  float acc = 0.f;
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    acc += a[i] * float(row[col + i]);
+  }
+  return simd_sum(acc);
+}
+
+// The keys [0, n) attended to by query i
+METAL_FUNC int attended_keys(int i, const constant MLXAttentionVJPParams& p) {
+  return do_causal ? clamp(i + p.causal_offset + 1, 0, p.k_len) : p.k_len;
+}
+
+// The first key attended to by query i
+METAL_FUNC int
+first_attended_key(int i, const constant MLXAttentionVJPParams& p) {
+  return has_window
+      ? clamp(i + p.causal_offset - p.window_size + 1, 0, p.k_len)
+      : 0;
+}
+
+// Computes the logsumexp of the scores of each query and the dot product of
+// the output and its cotangent
+template <typename T, int D>
+[[kernel]] void attention_vjp_row_stats(
+    const device T* Q [[buffer(0)]],
+    const device T* K [[buffer(1)]],
+    const device T* O [[buffer(2)]],
+    const device T* dO [[buffer(3)]],
+    device float* lse [[buffer(4)]],
+    device float* delta [[buffer(5)]],
+    const constant MLXAttentionVJPParams& params [[buffer(6)]],
+    const device T* mask [[buffer(7), function_constant(has_float_mask)]],
+    const device bool* bmask [[buffer(8), function_constant(has_bool_mask)]],
+    const device float* alibi_slopes
+    [[buffer(11), function_constant(has_alibi)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr int N = D / 32;
+  const int i = tid.x * 8 + simd_group_id;
+  if (i >= params.q_len) {
+    return;
+  }
+  const int col = simd_lane_id * N;
+  const size_t q_row =
+      (size_t(tid.z) * params.n_heads + tid.y) * params.q_len + i;
+  const size_t k_row0 =
+      (size_t(tid.z) * (params.n_heads / params.gqa_factor) +
+       tid.y / params.gqa_factor) *
+      params.k_len;
+  const int64_t mask_offset = tid.z * params.mask_strides[0] +
+      tid.y * params.mask_strides[1] + i * params.mask_strides[2];
+  const device T* mask_ = nullptr;
+  const device bool* bmask_ = nullptr;
+  if (has_float_mask) {
+    mask_ = mask + mask_offset;
+  }
+  if (has_bool_mask) {
+    bmask_ = bmask + mask_offset;
+  }
+  const float slope = has_alibi ? alibi_slopes[tid.y] : 0.f;
+
+  float q[N];
+  float o[N];
+  load_row<T, N>(Q + q_row * D, col, q);
+  load_row<T, N>(O + q_row * D, col, o);
+#pragma clang loop unroll(full)
+  for (int n = 0; n < N; n++) {
+    q[n] *= params.scale;
+  }
+  float d = row_dot<T, N>(o, dO + q_row * D, col);
+
+  float max_score = -INFINITY;
+  float sum = 0.f;
+  const int n_keys = attended_keys(i, params);
+  for (int j = first_attended_key(i, params); j < n_keys; j++) {
+    float score = row_dot<T, N>(q, K + (k_row0 + j) * D, col);
+    score = apply_position_bias(
+        score, i + params.causal_offset, j, params.window_size, slope);
+    score = apply_mask(score, mask_, bmask_, j * params.mask_strides[3]);
+    if (score > max_score) {
+      sum = sum * exp(max_score - score) + 1.f;
+      max_score = score;
+    } else if (score > -INFINITY) {
+      sum += exp(score - max_score);
+    }
+  }
+
+  if (simd_lane_id == 0) {
+    // A row with every key masked has zero probabilities
+    lse[q_row] = sum > 0.f ? max_score + log(sum) : INFINITY;
+    delta[q_row] = d;
+  }
+}
+
+template <typename T, int D>
+[[kernel]] void attention_vjp_dq(
+    const device T* Q [[buffer(0)]],
+    const device T* K [[buffer(1)]],
+    const device T* V [[buffer(2)]],
+    const device T* dO [[buffer(3)]],
+    const device float* lse [[buffer(4)]],
+    const device float* delta [[buffer(5)]],
+    const constant MLXAttentionVJPParams& params [[buffer(6)]],
+    const device T* mask [[buffer(7), function_constant(has_float_mask)]],
+    const device bool* bmask [[buffer(8), function_constant(has_bool_mask)]],
+    device T* dQ [[buffer(9)]],
+    const device float* alibi_slopes
+    [[buffer(11), function_constant(has_alibi)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr int N = D / 32;
+  const int i = tid.x * 8 + simd_group_id;
+  if (i >= params.q_len) {
+    return;
+  }
+  const int col = simd_lane_id * N;
+  const size_t q_row =
+      (size_t(tid.z) * params.n_heads + tid.y) * params.q_len + i;
+  const size_t k_row0 =
+      (size_t(tid.z) * (params.n_heads / params.gqa_factor) +
+       tid.y / params.gqa_factor) *
+      params.k_len;
+  const int64_t mask_offset = tid.z * params.mask_strides[0] +
+      tid.y * params.mask_strides[1] + i * params.mask_strides[2];
+  const device T* mask_ = nullptr;
+  const device bool* bmask_ = nullptr;
+  if (has_float_mask) {
+    mask_ = mask + mask_offset;
+  }
+  if (has_bool_mask) {
+    bmask_ = bmask + mask_offset;
+  }
+  const float slope = has_alibi ? alibi_slopes[tid.y] : 0.f;
+
+  float q[N];
+  float g[N];
+  float dq[N] = {0.f};
+  load_row<T, N>(Q + q_row * D, col, q);
+  load_row<T, N>(dO + q_row * D, col, g);
+#pragma clang loop unroll(full)
+  for (int n = 0; n < N; n++) {
+    q[n] *= params.scale;
+  }
+  const float row_lse = lse[q_row];
+  const float row_delta = delta[q_row];
+
+  const int n_keys = attended_keys(i, params);
+  for (int j = first_attended_key(i, params); j < n_keys; j++) {
+    const device T* k = K + (k_row0 + j) * D;
+    float score = row_dot<T, N>(q, k, col);
+    score = apply_position_bias(
+        score, i + params.causal_offset, j, params.window_size, slope);
+    score = apply_mask(score, mask_, bmask_, j * params.mask_strides[3]);
+    float p = exp(score - row_lse);
+    float dp = row_dot<T, N>(g, V + (k_row0 + j) * D, col);
+    float ds = p * (dp - row_delta);
+#pragma clang loop unroll(full)
+    for (int n = 0; n < N; n++) {
+      dq[n] += ds * float(k[col + n]);
+    }
+  }
+
+#pragma clang loop unroll(full)
+  for (int n = 0; n < N; n++) {
+    dQ[q_row * D + col + n] = T(params.scale * dq[n]);
+  }
+}
+
+// Accumulates the gradients of a key and value over the queries of every
+// head sharing them
+template <typename T, int D>
+[[kernel]] void attention_vjp_dkdv(
+    const device T* Q [[buffer(0)]],
+    const device T* K [[buffer(1)]],
+    const device T* V [[buffer(2)]],
+    const device T* dO [[buffer(3)]],
+    const device float* lse [[buffer(4)]],
+    const device float* delta [[buffer(5)]],
+    const constant MLXAttentionVJPParams& params [[buffer(6)]],
+    const device T* mask [[buffer(7), function_constant(has_float_mask)]],
+    const device bool* bmask [[buffer(8), function_constant(has_bool_mask)]],
+    device T* dK [[buffer(9)]],
+    device T* dV [[buffer(10)]],
+    const device float* alibi_slopes
+    [[buffer(11), function_constant(has_alibi)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr int N = D / 32;
+  const int j = tid.x * 8 + simd_group_id;
+  if (j >= params.k_len) {
+    return;
+  }
+  const int col = simd_lane_id * N;
+  const int n_kv_heads = params.n_heads / params.gqa_factor;
+  const size_t k_row = (size_t(tid.z) * n_kv_heads + tid.y) * params.k_len + j;
+
+  float k[N];
+  float v[N];
+  float dk[N] = {0.f};
+  float dv[N] = {0.f};
+  load_row<T, N>(K + k_row * D, col, k);
+  load_row<T, N>(V + k_row * D, col, v);
+#pragma clang loop unroll(full)
+  for (int n = 0; n < N; n++) {
+    k[n] *= params.scale;
+  }
+
+  // The queries attending to key j
+  const int i_start = do_causal ? max(0, j - params.causal_offset) : 0;
+  const int i_end = has_window
+      ? min(params.q_len, j + params.window_size - params.causal_offset)
+      : params.q_len;
+  for (int h = tid.y * params.gqa_factor;
+       h < (int(tid.y) + 1) * params.gqa_factor;
+       h++) {
+    const size_t q_row0 = (size_t(tid.z) * params.n_heads + h) * params.q_len;
+    const int64_t mask_offset = tid.z * params.mask_strides[0] +
+        h * params.mask_strides[1] + j * params.mask_strides[3];
+    const device T* mask_ = nullptr;
+    const device bool* bmask_ = nullptr;
+    if (has_float_mask) {
+      mask_ = mask + mask_offset;
+    }
+    if (has_bool_mask) {
+      bmask_ = bmask + mask_offset;
+    }
+    const float slope = has_alibi ? alibi_slopes[h] : 0.f;
+    for (int i = i_start; i < i_end; i++) {
+      const device T* q = Q + (q_row0 + i) * D;
+      const device T* g = dO + (q_row0 + i) * D;
+      float score = row_dot<T, N>(k, q, col);
+      score = apply_position_bias(
+          score, i + params.causal_offset, j, params.window_size, slope);
+      score = apply_mask(score, mask_, bmask_, i * params.mask_strides[2]);
+      float p = exp(score - lse[q_row0 + i]);
+      float dp = row_dot<T, N>(v, g, col);
+      float ds = p * (dp - delta[q_row0 + i]);
+#pragma clang loop unroll(full)
+      for (int n = 0; n < N; n++) {
+        dv[n] += p * float(g[col + n]);
+        dk[n] += ds * float(q[col + n]);
+      }
+    }
+  }
+
+#pragma clang loop unroll(full)
+  for (int n = 0; n < N; n++) {
+    dK[k_row * D + col + n] = T(params.scale * dk[n]);
+    dV[k_row * D + col + n] = T(dv[n]);
+  }
+}
+
+#define instantiate_attention_vjp_kernels(tname, itype, d)                     \
+  template [[host_name("attention_vjp_row_stats_" #tname "_" #d)]] [[kernel]] \
+  void attention_vjp_row_stats<itype, d>(                                      \
+      const device itype* Q [[buffer(0)]],                                     \
+      const device itype* K [[buffer(1)]],                                     \
+      const device itype* O [[buffer(2)]],                                     \
+      const device itype* dO [[buffer(3)]],                                    \
+      device float* lse [[buffer(4)]],                                         \
+      device float* delta [[buffer(5)]],                                       \
+      const constant MLXAttentionVJPParams& params [[buffer(6)]],              \
+      const device itype* mask                                                 \
+      [[buffer(7), function_constant(has_float_mask)]],                        \
+      const device bool* bmask                                                 \
+      [[buffer(8), function_constant(has_bool_mask)]],                         \
+      const device float* alibi_slopes                                         \
+      [[buffer(11), function_constant(has_alibi)]],                            \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                         \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],                   \
+      uint3 tid [[threadgroup_position_in_grid]]);                             \
+  template [[host_name("attention_vjp_dq_" #tname "_" #d)]] [[kernel]] void    \
+  attention_vjp_dq<itype, d>(                                                  \
+      const device itype* Q [[buffer(0)]],                                     \
+      const device itype* K [[buffer(1)]],                                     \
+      const device itype* V [[buffer(2)]],                                     \
+      const device itype* dO [[buffer(3)]],                                    \
+      const device float* lse [[buffer(4)]],                                   \
+      const device float* delta [[buffer(5)]],                                 \
+      const constant MLXAttentionVJPParams& params [[buffer(6)]],              \
+      const device itype* mask                                                 \
+      [[buffer(7), function_constant(has_float_mask)]],                        \
+      const device bool* bmask                                                 \
+      [[buffer(8), function_constant(has_bool_mask)]],                         \
+      device itype* dQ [[buffer(9)]],                                          \
+      const device float* alibi_slopes                                         \
+      [[buffer(11), function_constant(has_alibi)]],                            \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                         \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],                   \
+      uint3 tid [[threadgroup_position_in_grid]]);                             \
+  template [[host_name("attention_vjp_dkdv_" #tname "_" #d)]] [[kernel]] void  \
+  attention_vjp_dkdv<itype, d>(                                                \
+      const device itype* Q [[buffer(0)]],                                     \
+      const device itype* K [[buffer(1)]],                                     \
+      const device itype* V [[buffer(2)]],                                     \
+      const device itype* dO [[buffer(3)]],                                    \
+      const device float* lse [[buffer(4)]],                                   \
+      const device float* delta [[buffer(5)]],                                 \
+      const constant MLXAttentionVJPParams& params [[buffer(6)]],              \
+      const device itype* mask                                                 \
+      [[buffer(7), function_constant(has_float_mask)]],                        \
+      const device bool* bmask                                                 \
+      [[buffer(8), function_constant(has_bool_mask)]],                         \
+      device itype* dK [[buffer(9)]],                                          \
+      device itype* dV [[buffer(10)]],                                         \
+      const device float* alibi_slopes                                         \
+      [[buffer(11), function_constant(has_alibi)]],                            \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                         \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],                   \
+      uint3 tid [[threadgroup_position_in_grid]]);
+
+// clang-format off
+#define instantiate_attention_vjp_dims(tname, itype) \
+  instantiate_attention_vjp_kernels(tname, itype, 64) \
+  instantiate_attention_vjp_kernels(tname, itype, 128)
+
+instantiate_attention_vjp_dims(float, float)
+instantiate_attention_vjp_dims(half, half)
+instantiate_attention_vjp_dims(bfloat16, bfloat16_t)
+// clang-format on
+
+///////////////////////////////////////////////////////////////////////////////
+// Ragged attention
+//
+// The tokens of sequence b are rows [offsets[b], offsets[b + 1]) of the flat
+// queries, keys and values of shape (tokens, heads, DK) and each query only
+// attends to the keys of its sequence, aligned to the end of the keys when
+// causal. No work is spent on padding.
+///////////////////////////////////////////////////////////////////////////////
+
+// A threadgroup computes one head of one query. Its simdgroups split the keys
+// and keep a running softmax each, which are merged at the end.
+template <typename T, int DK>
+[[kernel]] void ragged_attention(
+    const device T* Q [[buffer(0)]],
+    const device T* K [[buffer(1)]],
+    const device T* V [[buffer(2)]],
+    const device int32_t* q_offsets [[buffer(3)]],
+    const device int32_t* kv_offsets [[buffer(4)]],
+    const constant MLXRaggedAttentionParams& params [[buffer(5)]],
+    device T* O [[buffer(6)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr int NSIMDGROUPS = 8;
+  constexpr int N = DK / 32;
+
+  threadgroup float maxes[NSIMDGROUPS];
+  threadgroup float sums[NSIMDGROUPS];
+  threadgroup float outs[NSIMDGROUPS * DK];
+
+  const int head = tid.x;
+  const int token = tid.y;
+  const int col = simd_lane_id * N;
+
+  // The token belongs to the last sequence starting at or before it, which
+  // skips the empty ones
+  int lo = 0;
+  int hi = params.n_segments - 1;
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (q_offsets[mid] <= token) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  const int q_len = q_offsets[lo + 1] - q_offsets[lo];
+  const int k_start = kv_offsets[lo];
+  const int k_len = kv_offsets[lo + 1] - k_start;
+  const int n_keys = do_causal
+      ? clamp(token - q_offsets[lo] + 1 + k_len - q_len, 0, k_len)
+      : k_len;
+  const int kv_head = head / params.gqa_factor;
+
+  float q[N];
+  load_row(Q + (size_t(token) * params.n_q_heads + head) * DK, col, q);
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    q[i] *= params.scale;
+  }
+
+  float max_score = -INFINITY;
+  float sum = 0.f;
+  float o[N] = {0.f};
+  for (int j = simd_group_id; j < n_keys; j += NSIMDGROUPS) {
+    const size_t row = size_t(k_start + j) * params.n_kv_heads + kv_head;
+    float score = row_dot(q, K + row * DK, col);
+    float new_max = max(max_score, score);
+    float factor = exp(max_score - new_max);
+    float p = exp(score - new_max);
+    sum = sum * factor + p;
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      o[i] = o[i] * factor + p * float(V[row * DK + col + i]);
+    }
+    max_score = new_max;
+  }
+  if (simd_lane_id == 0) {
+    maxes[simd_group_id] = max_score;
+    sums[simd_group_id] = sum;
+  }
+#pragma clang loop unroll(full)
+  for (int i = 0; i < N; i++) {
+    outs[simd_group_id * DK + col + i] = o[i];
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // A query without keys is zero
+  if (simd_group_id == 0) {
+    float true_max = -INFINITY;
+    for (int g = 0; g < NSIMDGROUPS; g++) {
+      true_max = max(true_max, maxes[g]);
+    }
+    float denom = 0.f;
+    float acc[N] = {0.f};
+    if (true_max > -INFINITY) {
+      for (int g = 0; g < NSIMDGROUPS; g++) {
+        float w = exp(maxes[g] - true_max);
+        denom += w * sums[g];
+#pragma clang loop unroll(full)
+        for (int i = 0; i < N; i++) {
+          acc[i] += w * outs[g * DK + col + i];
+        }
+      }
+    }
+    float inv_denom = denom > 0.f ? 1.f / denom : 0.f;
+    device T* out = O + (size_t(token) * params.n_q_heads + head) * DK + col;
+#pragma clang loop unroll(full)
+    for (int i = 0; i < N; i++) {
+      out[i] = static_cast<T>(acc[i] * inv_denom);
+    }
+  }
+}
+
+#define instantiate_ragged_attention(tname, itype, d)                   \
+  template [[host_name("ragged_attention_" #tname "_" #d)]] [[kernel]] \
+  void ragged_attention<itype, d>(                                      \
+      const device itype* Q [[buffer(0)]],                              \
+      const device itype* K [[buffer(1)]],                              \
+      const device itype* V [[buffer(2)]],                              \
+      const device int32_t* q_offsets [[buffer(3)]],                    \
+      const device int32_t* kv_offsets [[buffer(4)]],                   \
+      const constant MLXRaggedAttentionParams& params [[buffer(5)]],    \
+      device itype* O [[buffer(6)]],                                    \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                  \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],            \
+      uint3 tid [[threadgroup_position_in_grid]]);
+
+// clang-format off
+#define instantiate_ragged_attention_dims(tname, itype) \
+  instantiate_ragged_attention(tname, itype, 64) \
+  instantiate_ragged_attention(tname, itype, 128)
+
+instantiate_ragged_attention_dims(float, float)
+instantiate_ragged_attention_dims(half, half)
+instantiate_ragged_attention_dims(bfloat16, bfloat16_t)
+// clang-format on
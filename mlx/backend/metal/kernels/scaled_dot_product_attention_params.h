@@ -30,13 +30,70 @@ struct MLXFastAttentionParams {
 
   const int batch_ndim;
   const float alpha;
+
+  // The grid's z index is batch * n_heads + head and each key/value head is
+  // shared by gqa_factor consecutive query heads
+  const int n_heads;
+  const int gqa_factor;
+  // With a causal mask query i attends to keys up to i + causal_offset
+  const int causal_offset;
+  // Strides of the mask along batch, head, query and key
+  const int64_t mask_strides[4];
+  // With a window query i attends to the keys after
+  // i + causal_offset - window_size
+  const int window_size;
 };
 
 struct MLXScaledDotProductAttentionParams {
   // Associated dimensions & transposition information
   const uint QUERY_SEQUENCE_LENGTH = 1;
+  // Heads times queries per head, the queries of a head share its keys
   const uint N_Q_HEADS = 32;
   const uint N_KV_HEADS = 32;
   const uint KV_TILES = 1;
   const float INV_ALPHA = 0.08838834764831843f;
+  // Strides of the mask along batch, head, query and key
+  const int64_t MASK_STRIDES[4] = {0, 0, 0, 0};
+  // Rows between the heads of the keys and values, more than the sequence
+  // length when they are views of a larger cache
+  const uint K_HEAD_ROWS = 0;
+  const uint V_HEAD_ROWS = 0;
+  // With a window the queries attend to the last WINDOW_SIZE keys up to them
+  const int WINDOW_SIZE = 0;
+};
+
+struct MLXPagedAttentionParams {
+  // Keys per page of the caches
+  const int block_size;
+  // Columns of the block table, the pages of a sequence are
+  // block_tables[seq * max_blocks + position / block_size]
+  const int max_blocks;
+  // Keys per tile of the partials
+  const int tile_size;
+};
+
+struct MLXAttentionVJPParams {
+  const int n_heads;
+  // Each key/value head is shared by gqa_factor consecutive query heads
+  const int gqa_factor;
+  const int q_len;
+  const int k_len;
+  const float scale;
+  // With a causal mask query i attends to keys up to i + causal_offset
+  const int causal_offset;
+  // Strides of the mask along batch, head, query and key
+  const int64_t mask_strides[4];
+  // With a window query i attends to the keys after
+  // i + causal_offset - window_size
+  const int window_size;
+};
+
+struct MLXRaggedAttentionParams {
+  const int n_q_heads;
+  const int n_kv_heads;
+  // Each key/value head is shared by gqa_factor consecutive query heads
+  const int gqa_factor;
+  // Sequences of the batch, delimited by n_segments + 1 offsets
+  const int n_segments;
+  const float scale;
 };
@@ -167,6 +167,8 @@ inline void write_safe(U values[N_READS], device U* out, int start, int total) {
   }
 }
 
+// Scans axis_size elements of in to out with a threadgroup starting from
+// prefix. An exclusive scan writes prefix to the first output.
 template <
     typename T,
     typename U,
@@ -174,29 +176,25 @@ template <
     int N_READS,
     bool inclusive,
     bool reverse>
-[[kernel]] void contiguous_scan(
-    const device T* in [[buffer(0)]],
-    device U* out [[buffer(1)]],
-    const constant size_t& axis_size [[buffer(2)]],
-    uint gid [[thread_position_in_grid]],
-    uint lid [[thread_position_in_threadgroup]],
-    uint lsize [[threads_per_threadgroup]],
-    uint simd_size [[threads_per_simdgroup]],
-    uint simd_lane_id [[thread_index_in_simdgroup]],
-    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+inline void contiguous_scan_impl(
+    const device T* in,
+    device U* out,
+    size_t axis_size,
+    U prefix,
+    threadgroup U* simdgroup_sums,
+    uint lid,
+    uint lsize,
+    uint simd_size,
+    uint simd_lane_id,
+    uint simd_group_id) {
   Op op;
 
-  // Position the pointers
-  in += (gid / lsize) * axis_size;
-  out += (gid / lsize) * axis_size;
-
   // Compute the number of simd_groups
   uint simd_groups = lsize / simd_size;
 
   // Allocate memory
-  U prefix = Op::init;
+  U init = prefix;
   U values[N_READS];
-  threadgroup U simdgroup_sums[32];
 
   // Loop over the reduced axis in blocks of size ceildiv(axis_size,
   // N_READS*lsize)
@@ -276,7 +274,7 @@ template <
         }
       } else {
         if (lid == 0 && offset == 0) {
-          out[axis_size - 1] = Op::init;
+          out[axis_size - 1] = init;
         }
         if ((offset + N_READS + 1) < axis_size) {
           write_unsafe<U, N_READS, reverse>(
@@ -299,7 +297,7 @@ template <
         }
       } else {
         if (lid == 0 && offset == 0) {
-          out[0] = Op::init;
+          out[0] = init;
         }
         if ((offset + N_READS + 1) < axis_size) {
           write_unsafe<U, N_READS, reverse>(values, out + offset + 1);
@@ -320,6 +318,157 @@ template <
   }
 }
 
+
+template <
+    typename T,
+    typename U,
+    typename Op,
+    int N_READS,
+    bool inclusive,
+    bool reverse>
+[[kernel]] void contiguous_scan(
+    const device T* in [[buffer(0)]],
+    device U* out [[buffer(1)]],
+    const constant size_t& axis_size [[buffer(2)]],
+    uint gid [[thread_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  threadgroup U simdgroup_sums[32];
+
+  // Position the pointers
+  in += (gid / lsize) * axis_size;
+  out += (gid / lsize) * axis_size;
+
+  contiguous_scan_impl<T, U, Op, N_READS, inclusive, reverse>(
+      in,
+      out,
+      axis_size,
+      Op::init,
+      simdgroup_sums,
+      lid,
+      lsize,
+      simd_size,
+      simd_lane_id,
+      simd_group_id);
+}
+
+// Reduces x across the threadgroup. Every thread gets the result.
+template <typename U, typename Op>
+inline U threadgroup_scan_total(
+    U x,
+    threadgroup U* simdgroup_sums,
+    uint lsize,
+    uint simd_size,
+    uint simd_lane_id,
+    uint simd_group_id) {
+  Op op;
+  x = simd_shuffle(op.simd_scan(x), simd_size - 1);
+  if (simd_lane_id == 0) {
+    simdgroup_sums[simd_group_id] = x;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  x = (simd_lane_id < lsize / simd_size) ? simdgroup_sums[simd_lane_id]
+                                         : Op::init;
+  x = simd_shuffle(op.simd_scan(x), simd_size - 1);
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  return x;
+}
+
+// Few long rows do not fill the GPU with a threadgroup per row so they are
+// split in parts of split_size elements in the scan order. A threadgroup
+// per part reduces it in contiguous_scan_partial and contiguous_scan_split
+// scans it starting from the reduction of the parts before it.
+template <
+    typename T,
+    typename U,
+    typename Op,
+    int N_READS,
+    bool inclusive,
+    bool reverse>
+[[kernel]] void contiguous_scan_partial(
+    const device T* in [[buffer(0)]],
+    device U* partials [[buffer(1)]],
+    const constant size_t& axis_size [[buffer(2)]],
+    const constant size_t& split_size [[buffer(3)]],
+    uint2 gid [[threadgroup_position_in_grid]],
+    uint2 n_groups [[threadgroups_per_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  Op op;
+  threadgroup U simdgroup_sums[32];
+
+  size_t start = gid.x * split_size;
+  size_t size = min(split_size, axis_size - start);
+  in += gid.y * axis_size + (reverse ? axis_size - start - size : start);
+
+  U total = Op::init;
+  for (size_t i = lid * N_READS; i < size; i += lsize * N_READS) {
+    for (int j = 0; j < N_READS && i + j < size; j++) {
+      total = op(total, in[i + j]);
+    }
+  }
+  total = threadgroup_scan_total<U, Op>(
+      total, simdgroup_sums, lsize, simd_size, simd_lane_id, simd_group_id);
+  if (lid == 0) {
+    partials[gid.y * n_groups.x + gid.x] = total;
+  }
+}
+
+template <
+    typename T,
+    typename U,
+    typename Op,
+    int N_READS,
+    bool inclusive,
+    bool reverse>
+[[kernel]] void contiguous_scan_split(
+    const device T* in [[buffer(0)]],
+    const device U* partials [[buffer(1)]],
+    device U* out [[buffer(2)]],
+    const constant size_t& axis_size [[buffer(3)]],
+    const constant size_t& split_size [[buffer(4)]],
+    uint2 gid [[threadgroup_position_in_grid]],
+    uint2 n_groups [[threadgroups_per_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  Op op;
+  threadgroup U simdgroup_sums[32];
+
+  // The reduction of the parts before this one
+  partials += gid.y * n_groups.x;
+  U prefix = Op::init;
+  for (uint i = lid; i < gid.x; i += lsize) {
+    prefix = op(prefix, partials[i]);
+  }
+  prefix = threadgroup_scan_total<U, Op>(
+      prefix, simdgroup_sums, lsize, simd_size, simd_lane_id, simd_group_id);
+
+  size_t start = gid.x * split_size;
+  size_t size = min(split_size, axis_size - start);
+  size_t offset =
+      gid.y * axis_size + (reverse ? axis_size - start - size : start);
+  contiguous_scan_impl<T, U, Op, N_READS, inclusive, reverse>(
+      in + offset,
+      out + offset,
+      size,
+      prefix,
+      simdgroup_sums,
+      lid,
+      lsize,
+      simd_size,
+      simd_lane_id,
+      simd_group_id);
+}
+
 template <
     typename T,
     typename U,
@@ -25,6 +25,36 @@ using namespace metal;
       uint simd_lane_id [[thread_index_in_simdgroup]],                  \
       uint simd_group_id [[simdgroup_index_in_threadgroup]]);
 
+#define instantiate_split_scan(                                                 \
+    name, itype, otype, op, inclusive, reverse, nreads)                         \
+  template [[host_name("partial_scan_" #name)]] [[kernel]] void                 \
+  contiguous_scan_partial<itype, otype, op<otype>, nreads, inclusive, reverse>( \
+      const device itype* in [[buffer(0)]],                                     \
+      device otype* partials [[buffer(1)]],                                     \
+      const constant size_t& axis_size [[buffer(2)]],                           \
+      const constant size_t& split_size [[buffer(3)]],                          \
+      uint2 gid [[threadgroup_position_in_grid]],                               \
+      uint2 n_groups [[threadgroups_per_grid]],                                 \
+      uint lid [[thread_position_in_threadgroup]],                              \
+      uint lsize [[threads_per_threadgroup]],                                   \
+      uint simd_size [[threads_per_simdgroup]],                                 \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                          \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);                   \
+  template [[host_name("split_scan_" #name)]] [[kernel]] void                   \
+  contiguous_scan_split<itype, otype, op<otype>, nreads, inclusive, reverse>(   \
+      const device itype* in [[buffer(0)]],                                     \
+      const device otype* partials [[buffer(1)]],                               \
+      device otype* out [[buffer(2)]],                                          \
+      const constant size_t& axis_size [[buffer(3)]],                           \
+      const constant size_t& split_size [[buffer(4)]],                          \
+      uint2 gid [[threadgroup_position_in_grid]],                               \
+      uint2 n_groups [[threadgroups_per_grid]],                                 \
+      uint lid [[thread_position_in_threadgroup]],                              \
+      uint lsize [[threads_per_threadgroup]],                                   \
+      uint simd_size [[threads_per_simdgroup]],                                 \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                          \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+
 #define instantiate_strided_scan(                                    \
     name, itype, otype, op, inclusive, reverse, nreads)              \
   template [[host_name("strided_scan_" #name)]] [[kernel]] void      \
@@ -43,6 +73,10 @@ using namespace metal;
   instantiate_contiguous_scan(exclusive_##name, itype, otype, op, false, false, nreads)        \
   instantiate_contiguous_scan(reverse_inclusive_##name, itype, otype, op, true, true, nreads)  \
   instantiate_contiguous_scan(reverse_exclusive_##name, itype, otype, op, false, true, nreads) \
+  instantiate_split_scan(inclusive_##name, itype, otype, op, true, false, nreads)              \
+  instantiate_split_scan(exclusive_##name, itype, otype, op, false, false, nreads)             \
+  instantiate_split_scan(reverse_inclusive_##name, itype, otype, op, true, true, nreads)       \
+  instantiate_split_scan(reverse_exclusive_##name, itype, otype, op, false, true, nreads)      \
   instantiate_strided_scan(inclusive_##name, itype, otype, op, true, false, nreads)            \
   instantiate_strided_scan(exclusive_##name, itype, otype, op, false, false, nreads)           \
   instantiate_strided_scan(reverse_inclusive_##name, itype, otype, op, true, true, nreads)     \
@@ -0,0 +1,145 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_atomic>
+#include <metal_simdgroup>
+
+// clang-format off
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/utils.h"
+#include "mlx/backend/metal/kernels/atomic.h"
+#include "mlx/backend/metal/kernels/reduction/ops.h"
+// clang-format on
+
+using namespace metal;
+
+// Threads per threadgroup, arranged as (columns, rows) with both powers of 2
+constant constexpr const int segmented_group_size = 256;
+
+// A threadgroup reduces a block of columns over the rows of one segment. Its
+// threads stride over the rows and are then combined in threadgroup memory,
+// so every output is written once without atomics. Narrow rows use few
+// columns and many rows per threadgroup.
+template <typename T, typename U, typename Op>
+[[kernel]] void segmented_reduce(
+    const device T* in [[buffer(0)]],
+    const device int* offsets [[buffer(1)]],
+    device T* out [[buffer(2)]],
+    constant const int& n_rows [[buffer(3)]],
+    constant const int& row_size [[buffer(4)]],
+    uint2 tid [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]],
+    uint2 lsize [[threads_per_threadgroup]]) {
+  threadgroup U shared[segmented_group_size];
+  Op op;
+
+  int col = tid.x * lsize.x + lid.x;
+  int start = clamp(offsets[tid.y], 0, n_rows);
+  int end = clamp(offsets[tid.y + 1], start, n_rows);
+
+  U acc = Op::init;
+  if (col < row_size) {
+    for (int r = start + lid.y; r < end; r += lsize.y) {
+      acc = op(acc, static_cast<U>(in[size_t(r) * row_size + col]));
+    }
+  }
+
+  uint idx = lid.y * lsize.x + lid.x;
+  shared[idx] = acc;
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  for (uint s = lsize.y / 2; s > 0; s /= 2) {
+    if (lid.y < s) {
+      shared[idx] = op(shared[idx], shared[idx + s * lsize.x]);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+  }
+
+  if (lid.y == 0 && col < row_size) {
+    out[size_t(tid.y) * row_size + col] = static_cast<T>(shared[lid.x]);
+  }
+}
+
+// A threadgroup scans a block of columns over the rows of one segment, a
+// chunk of lsize.y rows at a time. Each chunk is scanned in threadgroup
+// memory and offset by the total of the previous chunks.
+template <typename T, typename U>
+[[kernel]] void segmented_cumsum(
+    const device T* in [[buffer(0)]],
+    const device int* offsets [[buffer(1)]],
+    device T* out [[buffer(2)]],
+    constant const int& n_rows [[buffer(3)]],
+    constant const int& row_size [[buffer(4)]],
+    constant const bool& reverse [[buffer(5)]],
+    constant const bool& inclusive [[buffer(6)]],
+    uint2 tid [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]],
+    uint2 lsize [[threads_per_threadgroup]]) {
+  threadgroup U shared[segmented_group_size];
+
+  int col = tid.x * lsize.x + lid.x;
+  int start = clamp(offsets[tid.y], 0, n_rows);
+  int end = clamp(offsets[tid.y + 1], start, n_rows);
+  int n = end - start;
+  uint idx = lid.y * lsize.x + lid.x;
+
+  U carry = U(0);
+  for (int base = 0; base < n; base += lsize.y) {
+    int i = base + lid.y;
+    bool valid = col < row_size && i < n;
+    size_t loc = size_t(reverse ? end - 1 - i : start + i) * row_size + col;
+    shared[idx] = valid ? static_cast<U>(in[loc]) : U(0);
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    // Inclusive scan of the chunk along the rows
+    for (uint s = 1; s < lsize.y; s *= 2) {
+      U prev = lid.y >= s ? shared[idx - s * lsize.x] : U(0);
+      threadgroup_barrier(mem_flags::mem_threadgroup);
+      shared[idx] += prev;
+      threadgroup_barrier(mem_flags::mem_threadgroup);
+    }
+
+    U prefix = inclusive ? shared[idx]
+                         : (lid.y > 0 ? shared[idx - lsize.x] : U(0));
+    if (valid) {
+      out[loc] = static_cast<T>(carry + prefix);
+    }
+    carry += shared[(lsize.y - 1) * lsize.x + lid.x];
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+  }
+}
+
+#define instantiate_segmented_reduce(name, type, acc_type)   \
+  instantiate_kernel(                                        \
+      "segmented_reduce_sum_" #name,                         \
+      segmented_reduce,                                      \
+      type,                                                  \
+      acc_type,                                              \
+      Sum<acc_type>)                                         \
+  instantiate_kernel(                                        \
+      "segmented_reduce_max_" #name,                         \
+      segmented_reduce,                                      \
+      type,                                                  \
+      acc_type,                                              \
+      Max<acc_type>)                                         \
+  instantiate_kernel(                                        \
+      "segmented_reduce_min_" #name,                         \
+      segmented_reduce,                                      \
+      type,                                                  \
+      acc_type,                                              \
+      Min<acc_type>)                                         \
+  instantiate_kernel(                                        \
+      "segmented_cumsum_" #name, segmented_cumsum, type, acc_type)
+
+// clang-format off
+instantiate_kernel("segmented_reduce_max_bool_", segmented_reduce, bool, bool, Max<bool>)
+instantiate_kernel("segmented_reduce_min_bool_", segmented_reduce, bool, bool, Min<bool>)
+instantiate_segmented_reduce(uint8, uint8_t, uint8_t)
+instantiate_segmented_reduce(uint16, uint16_t, uint16_t)
+instantiate_segmented_reduce(uint32, uint32_t, uint32_t)
+instantiate_segmented_reduce(uint64, uint64_t, uint64_t)
+instantiate_segmented_reduce(int8, int8_t, int8_t)
+instantiate_segmented_reduce(int16, int16_t, int16_t)
+instantiate_segmented_reduce(int32, int32_t, int32_t)
+instantiate_segmented_reduce(int64, int64_t, int64_t)
+instantiate_segmented_reduce(float16, half, float)
+instantiate_segmented_reduce(float32, float, float)
+instantiate_segmented_reduce(bfloat16, bfloat16_t, float) // clang-format on
@@ -188,3 +188,160 @@ template <typename T, typename AccT = T, int N_READS = SOFTMAX_N_READS>
     }
   }
 }
+
+// Long rows with few of them do not fill the GPU with a threadgroup per row,
+// so the rows are split in parts of split_size. A threadgroup per part finds
+// the max and normalizer of its part and softmax_normalize combines them.
+template <typename T, typename AccT = T, int N_READS = SOFTMAX_N_READS>
+[[kernel]] void softmax_partial(
+    const device T* in,
+    device float* stats,
+    constant int& axis_size,
+    constant int& split_size,
+    uint2 gid [[threadgroup_position_in_grid]],
+    uint2 n_groups [[threadgroups_per_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  constexpr int SIMD_SIZE = 32;
+
+  threadgroup AccT local_max[SIMD_SIZE];
+  threadgroup AccT local_normalizer[SIMD_SIZE];
+
+  in += gid.y * size_t(axis_size);
+  int start = gid.x * split_size;
+  int end = min(start + split_size, axis_size);
+
+  // Online max and normalizer of the part
+  AccT prevmax;
+  AccT maxval = Limits<AccT>::finite_min;
+  AccT normalizer = 0;
+  for (int offset = start + lid * N_READS; offset < end;
+       offset += lsize * N_READS) {
+    AccT vals[N_READS];
+    if (offset + N_READS <= end) {
+      for (int i = 0; i < N_READS; i++) {
+        vals[i] = AccT(in[offset + i]);
+      }
+    } else {
+      for (int i = 0; i < N_READS; i++) {
+        vals[i] = (offset + i < end) ? AccT(in[offset + i])
+                                     : Limits<AccT>::finite_min;
+      }
+    }
+    prevmax = maxval;
+    for (int i = 0; i < N_READS; i++) {
+      maxval = (maxval < vals[i]) ? vals[i] : maxval;
+    }
+    normalizer *= softmax_exp(prevmax - maxval);
+    for (int i = 0; i < N_READS; i++) {
+      normalizer += softmax_exp(vals[i] - maxval);
+    }
+  }
+
+  // Combine across the threadgroup as in softmax_looped
+  if (simd_group_id == 0) {
+    local_max[simd_lane_id] = Limits<AccT>::finite_min;
+    local_normalizer[simd_lane_id] = 0;
+  }
+  prevmax = maxval;
+  maxval = simd_max(maxval);
+  normalizer *= softmax_exp(prevmax - maxval);
+  normalizer = simd_sum(normalizer);
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  prevmax = maxval;
+  if (simd_lane_id == 0) {
+    local_max[simd_group_id] = maxval;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  maxval = simd_max(local_max[simd_lane_id]);
+  normalizer *= softmax_exp(prevmax - maxval);
+  if (simd_lane_id == 0) {
+    local_normalizer[simd_group_id] = normalizer;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  normalizer = simd_sum(local_normalizer[simd_lane_id]);
+
+  if (lid == 0) {
+    stats += 2 * (gid.y * size_t(n_groups.x) + gid.x);
+    stats[0] = maxval;
+    stats[1] = normalizer;
+  }
+}
+
+// Combines the max and normalizer of all the parts of the row and writes the
+// softmax of the part of the threadgroup
+template <typename T, typename AccT = T, int N_READS = SOFTMAX_N_READS>
+[[kernel]] void softmax_normalize(
+    const device T* in,
+    const device float* stats,
+    device T* out,
+    constant int& axis_size,
+    constant int& split_size,
+    uint2 gid [[threadgroup_position_in_grid]],
+    uint2 n_groups [[threadgroups_per_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  constexpr int SIMD_SIZE = 32;
+
+  threadgroup float local_max[SIMD_SIZE];
+  threadgroup float local_normalizer[SIMD_SIZE];
+
+  stats += 2 * gid.y * size_t(n_groups.x);
+  float prevmax;
+  float maxval = Limits<float>::finite_min;
+  float normalizer = 0;
+  for (uint i = lid; i < n_groups.x; i += lsize) {
+    float part_max = stats[2 * i];
+    prevmax = maxval;
+    maxval = max(maxval, part_max);
+    normalizer = normalizer * fast::exp(prevmax - maxval) +
+        stats[2 * i + 1] * fast::exp(part_max - maxval);
+  }
+
+  if (simd_group_id == 0) {
+    local_max[simd_lane_id] = Limits<float>::finite_min;
+    local_normalizer[simd_lane_id] = 0;
+  }
+  prevmax = maxval;
+  maxval = simd_max(maxval);
+  normalizer *= fast::exp(prevmax - maxval);
+  normalizer = simd_sum(normalizer);
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  prevmax = maxval;
+  if (simd_lane_id == 0) {
+    local_max[simd_group_id] = maxval;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  maxval = simd_max(local_max[simd_lane_id]);
+  normalizer *= fast::exp(prevmax - maxval);
+  if (simd_lane_id == 0) {
+    local_normalizer[simd_group_id] = normalizer;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  normalizer = simd_sum(local_normalizer[simd_lane_id]);
+
+  AccT row_max = maxval;
+  AccT inv_normalizer = 1 / normalizer;
+  in += gid.y * size_t(axis_size);
+  out += gid.y * size_t(axis_size);
+  int start = gid.x * split_size;
+  int end = min(start + split_size, axis_size);
+  for (int offset = start + lid * N_READS; offset < end;
+       offset += lsize * N_READS) {
+    if (offset + N_READS <= end) {
+      for (int i = 0; i < N_READS; i++) {
+        out[offset + i] =
+            T(softmax_exp(AccT(in[offset + i]) - row_max) * inv_normalizer);
+      }
+    } else {
+      for (int i = 0; offset + i < end; i++) {
+        out[offset + i] =
+            T(softmax_exp(AccT(in[offset + i]) - row_max) * inv_normalizer);
+      }
+    }
+  }
+}
@@ -30,7 +30,11 @@ using namespace metal;
       uint lid [[thread_position_in_threadgroup]],                \
       uint lsize [[threads_per_threadgroup]],                     \
       uint simd_lane_id [[thread_index_in_simdgroup]],            \
-      uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);     \
+  instantiate_kernel(                                             \
+      "partial_softmax_" #name, softmax_partial, itype)           \
+  instantiate_kernel(                                             \
+      "normalize_softmax_" #name, softmax_normalize, itype)
 
 #define instantiate_softmax_precise(name, itype)                          \
   template [[host_name("block_softmax_precise_" #name)]] [[kernel]] void        \
@@ -51,7 +55,11 @@ using namespace metal;
       uint lid [[thread_position_in_threadgroup]],                        \
       uint lsize [[threads_per_threadgroup]],                             \
       uint simd_lane_id [[thread_index_in_simdgroup]],                    \
-      uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);             \
+  instantiate_kernel(                                                     \
+      "partial_softmax_precise_" #name, softmax_partial, itype, float)    \
+  instantiate_kernel(                                                     \
+      "normalize_softmax_precise_" #name, softmax_normalize, itype, float)
 
 instantiate_softmax(float32, float)
 instantiate_softmax(float16, half)
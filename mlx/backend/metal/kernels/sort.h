@@ -672,3 +672,406 @@ mb_block_merge(
     }
   }
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// Radix select partition
+///////////////////////////////////////////////////////////////////////////////
+
+// Maps values to unsigned keys which order the same way as the values
+template <typename T>
+struct RadixKey {
+  static constexpr constant int bits = 8 * sizeof(T);
+
+  static METAL_FUNC uint32_t to_key(T x) {
+    return static_cast<uint32_t>(x);
+  }
+};
+
+template <>
+struct RadixKey<int8_t> {
+  static constexpr constant int bits = 8;
+
+  static METAL_FUNC uint32_t to_key(int8_t x) {
+    return as_type<uint8_t>(x) ^ 0x80u;
+  }
+};
+
+template <>
+struct RadixKey<int16_t> {
+  static constexpr constant int bits = 16;
+
+  static METAL_FUNC uint32_t to_key(int16_t x) {
+    return as_type<uint16_t>(x) ^ 0x8000u;
+  }
+};
+
+template <>
+struct RadixKey<int32_t> {
+  static constexpr constant int bits = 32;
+
+  static METAL_FUNC uint32_t to_key(int32_t x) {
+    return as_type<uint32_t>(x) ^ 0x80000000u;
+  }
+};
+
+template <>
+struct RadixKey<float> {
+  static constexpr constant int bits = 32;
+
+  static METAL_FUNC uint32_t to_key(float x) {
+    uint32_t b = as_type<uint32_t>(x);
+    return (b & 0x80000000u) ? ~b : (b | 0x80000000u);
+  }
+};
+
+template <>
+struct RadixKey<half> {
+  static constexpr constant int bits = 16;
+
+  static METAL_FUNC uint32_t to_key(half x) {
+    uint32_t b = as_type<uint16_t>(x);
+    return (b & 0x8000u) ? (~b & 0xFFFFu) : (b | 0x8000u);
+  }
+};
+
+template <>
+struct RadixKey<bfloat16_t> {
+  static constexpr constant int bits = 16;
+
+  static METAL_FUNC uint32_t to_key(bfloat16_t x) {
+    // bfloat16 is the upper half of the float with the same value
+    uint32_t b = as_type<uint32_t>(static_cast<float>(x)) >> 16;
+    return (b & 0x8000u) ? (~b & 0xFFFFu) : (b | 0x8000u);
+  }
+};
+
+// Partitions each row around its kth element with one threadgroup per row.
+// The kth key is found a digit at a time from the most significant one by
+// histogramming the keys that match the digits found so far, so long rows
+// take one pass per digit instead of a full multi block merge sort.
+template <
+    typename val_t,
+    typename out_t,
+    bool ARG_PARTITION,
+    short BLOCK_THREADS>
+[[kernel, max_total_threads_per_threadgroup(BLOCK_THREADS)]] void
+radix_select_partition(
+    const device val_t* inp [[buffer(0)]],
+    device out_t* out [[buffer(1)]],
+    const constant int& size_sorted_axis [[buffer(2)]],
+    const constant int& kth [[buffer(3)]],
+    const constant int& in_stride_sorted_axis [[buffer(4)]],
+    const constant int& out_stride_sorted_axis [[buffer(5)]],
+    const constant int& nc_dim [[buffer(6)]],
+    const constant int* nc_shape [[buffer(7)]],
+    const constant size_t* in_nc_strides [[buffer(8)]],
+    const constant size_t* out_nc_strides [[buffer(9)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]]) {
+  using key_t = RadixKey<val_t>;
+  constexpr int RADIX_BITS = 8;
+  constexpr int RADIX_SIZE = 1 << RADIX_BITS;
+
+  inp += elem_to_loc(tid.y, nc_shape, in_nc_strides, nc_dim);
+  out += elem_to_loc(tid.y, nc_shape, out_nc_strides, nc_dim);
+
+  threadgroup atomic_uint hist[RADIX_SIZE];
+  threadgroup int select_state[3];
+
+  // Select the digits of the kth key
+  uint32_t prefix = 0;
+  uint32_t prefix_mask = 0;
+  int k = kth;
+  int n_less = 0;
+  int n_equal = 0;
+  for (int shift = key_t::bits - RADIX_BITS; shift >= 0; shift -= RADIX_BITS) {
+    for (int i = lid.x; i < RADIX_SIZE; i += BLOCK_THREADS) {
+      atomic_store_explicit(&hist[i], 0, memory_order_relaxed);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    for (int i = lid.x; i < size_sorted_axis; i += BLOCK_THREADS) {
+      uint32_t key = key_t::to_key(inp[i * in_stride_sorted_axis]);
+      if ((key & prefix_mask) == prefix) {
+        atomic_fetch_add_explicit(
+            &hist[(key >> shift) & (RADIX_SIZE - 1)], 1, memory_order_relaxed);
+      }
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    if (lid.x == 0) {
+      int count = 0;
+      int bin = 0;
+      int bin_count = 0;
+      for (; bin < RADIX_SIZE; bin++) {
+        bin_count = atomic_load_explicit(&hist[bin], memory_order_relaxed);
+        if (count + bin_count > k) {
+          break;
+        }
+        count += bin_count;
+      }
+      select_state[0] = bin;
+      select_state[1] = count;
+      select_state[2] = bin_count;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    uint32_t bin = select_state[0];
+    k -= select_state[1];
+    n_less += select_state[1];
+    n_equal = select_state[2];
+    prefix |= bin << shift;
+    prefix_mask |= uint32_t(RADIX_SIZE - 1) << shift;
+  }
+
+  // Scatter the keys below, equal to and above the kth key. Each simdgroup
+  // reserves its slots with one atomic per class.
+  threadgroup atomic_uint* offsets = hist;
+  if (lid.x == 0) {
+    atomic_store_explicit(&offsets[0], 0, memory_order_relaxed);
+    atomic_store_explicit(&offsets[1], n_less, memory_order_relaxed);
+    atomic_store_explicit(&offsets[2], n_less + n_equal, memory_order_relaxed);
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  for (int base = 0; base < size_sorted_axis; base += BLOCK_THREADS) {
+    int i = base + lid.x;
+    bool in_range = i < size_sorted_axis;
+    val_t val = in_range ? inp[i * in_stride_sorted_axis] : val_t(0);
+    uint32_t key = key_t::to_key(val);
+    int cls = !in_range ? -1 : (key < prefix ? 0 : (key == prefix ? 1 : 2));
+
+    uint pos = 0;
+    for (int c = 0; c < 3; c++) {
+      uint mine = cls == c;
+      uint offset = simd_prefix_exclusive_sum(mine);
+      uint total = simd_sum(mine);
+      uint start = 0;
+      if (simd_lane_id == 0 && total > 0) {
+        start = atomic_fetch_add_explicit(
+            &offsets[c], total, memory_order_relaxed);
+      }
+      start = simd_broadcast_first(start);
+      if (mine) {
+        pos = start + offset;
+      }
+    }
+
+    if (in_range) {
+      if (ARG_PARTITION) {
+        out[pos * out_stride_sorted_axis] = i;
+      } else {
+        out[pos * out_stride_sorted_axis] = val;
+      }
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LSD radix sort
+///////////////////////////////////////////////////////////////////////////////
+
+// Each pass sorts on one 4 bit digit of the keys in three steps: count the
+// digits of every block, scan the counts into the output offset of each
+// (digit, block) pair and scatter every block into place. Equal digits keep
+// their order so the passes compose into a stable sort.
+MLX_MTL_CONST int RADIX_SORT_BITS = 4;
+MLX_MTL_CONST int RADIX_SORT_BINS = 1 << RADIX_SORT_BITS;
+
+template <typename val_t, short BLOCK_THREADS, short N_PER_THREAD>
+[[kernel, max_total_threads_per_threadgroup(BLOCK_THREADS)]] void
+radix_sort_count(
+    const device val_t* keys [[buffer(0)]],
+    device uint* counts [[buffer(1)]],
+    const constant int& size_sorted_axis [[buffer(2)]],
+    const constant int& shift [[buffer(3)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint3 tgp_grid [[threadgroups_per_grid]]) {
+  MLX_MTL_CONST int N_PER_BLOCK = BLOCK_THREADS * N_PER_THREAD;
+  int n_blocks = tgp_grid.x;
+
+  threadgroup atomic_uint hist[RADIX_SORT_BINS];
+  if (lid.x < RADIX_SORT_BINS) {
+    atomic_store_explicit(&hist[lid.x], 0, memory_order_relaxed);
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  keys += size_t(tid.y) * size_sorted_axis;
+  int base = tid.x * N_PER_BLOCK;
+  for (int i = lid.x; i < N_PER_BLOCK; i += BLOCK_THREADS) {
+    int idx = base + i;
+    if (idx < size_sorted_axis) {
+      uint32_t key = RadixKey<val_t>::to_key(keys[idx]);
+      atomic_fetch_add_explicit(
+          &hist[(key >> shift) & (RADIX_SORT_BINS - 1)],
+          1,
+          memory_order_relaxed);
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Digit major so an exclusive scan gives the output offsets
+  if (lid.x < RADIX_SORT_BINS) {
+    counts[(size_t(tid.y) * RADIX_SORT_BINS + lid.x) * n_blocks + tid.x] =
+        atomic_load_explicit(&hist[lid.x], memory_order_relaxed);
+  }
+}
+
+template <short BLOCK_THREADS>
+[[kernel, max_total_threads_per_threadgroup(BLOCK_THREADS)]] void
+radix_sort_scan(
+    device uint* counts [[buffer(0)]],
+    const constant int& n_counts [[buffer(1)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  MLX_MTL_CONST short n_simdgroups = BLOCK_THREADS / 32;
+  threadgroup uint simd_totals[n_simdgroups];
+  threadgroup uint chunk_total;
+
+  counts += size_t(tid.y) * n_counts;
+  uint carry = 0;
+  for (int base = 0; base < n_counts; base += BLOCK_THREADS) {
+    int i = base + lid.x;
+    uint c = i < n_counts ? counts[i] : 0;
+    uint prefix = simd_prefix_exclusive_sum(c);
+    uint total = simd_sum(c);
+    if (simd_lane_id == 0) {
+      simd_totals[simd_group_id] = total;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    if (simd_group_id == 0) {
+      uint t = simd_lane_id < n_simdgroups ? simd_totals[simd_lane_id] : 0;
+      uint t_prefix = simd_prefix_exclusive_sum(t);
+      uint t_total = simd_sum(t);
+      if (simd_lane_id < n_simdgroups) {
+        simd_totals[simd_lane_id] = t_prefix;
+      }
+      if (simd_lane_id == 0) {
+        chunk_total = t_total;
+      }
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    if (i < n_counts) {
+      counts[i] = carry + simd_totals[simd_group_id] + prefix;
+    }
+    carry += chunk_total;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+  }
+}
+
+template <
+    typename val_t,
+    typename idx_t,
+    bool ARG_SORT,
+    short BLOCK_THREADS,
+    short N_PER_THREAD>
+[[kernel, max_total_threads_per_threadgroup(BLOCK_THREADS)]] void
+radix_sort_scatter(
+    const device val_t* keys_in [[buffer(0)]],
+    const device idx_t* idxs_in [[buffer(1)]],
+    device val_t* keys_out [[buffer(2)]],
+    device idx_t* idxs_out [[buffer(3)]],
+    const device uint* offsets [[buffer(4)]],
+    const constant int& size_sorted_axis [[buffer(5)]],
+    const constant int& shift [[buffer(6)]],
+    const constant bool& first_pass [[buffer(7)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint3 tgp_grid [[threadgroups_per_grid]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]]) {
+  MLX_MTL_CONST int N_PER_BLOCK = BLOCK_THREADS * N_PER_THREAD;
+  MLX_MTL_CONST short n_simdgroups = BLOCK_THREADS / 32;
+  int n_blocks = tgp_grid.x;
+
+  // Digit major counts of every thread which are scanned in place into the
+  // position of the thread's first element of each digit within the block
+  threadgroup uint ranks[RADIX_SORT_BINS * BLOCK_THREADS];
+  threadgroup uint simd_totals[n_simdgroups];
+
+  size_t row = size_t(tid.y) * size_sorted_axis;
+  keys_in += row;
+  idxs_in += row;
+  keys_out += row;
+  idxs_out += row;
+  offsets += size_t(tid.y) * RADIX_SORT_BINS * n_blocks;
+
+  // Each thread owns consecutive elements so the block order is kept
+  val_t vals[N_PER_THREAD];
+  idx_t idxs[N_PER_THREAD];
+  short digits[N_PER_THREAD];
+  int base = tid.x * N_PER_BLOCK + lid.x * N_PER_THREAD;
+  for (short i = 0; i < N_PER_THREAD; i++) {
+    int idx = base + i;
+    if (idx < size_sorted_axis) {
+      vals[i] = keys_in[idx];
+      if (ARG_SORT) {
+        idxs[i] = first_pass ? idx_t(idx) : idxs_in[idx];
+      }
+      uint32_t key = RadixKey<val_t>::to_key(vals[i]);
+      digits[i] = (key >> shift) & (RADIX_SORT_BINS - 1);
+    } else {
+      digits[i] = RADIX_SORT_BINS;
+    }
+  }
+
+  for (short d = 0; d < RADIX_SORT_BINS; d++) {
+    uint c = 0;
+    for (short i = 0; i < N_PER_THREAD; i++) {
+      c += digits[i] == d;
+    }
+    ranks[d * BLOCK_THREADS + lid.x] = c;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Exclusive scan of ranks with each thread owning RADIX_SORT_BINS entries
+  uint sum = 0;
+  for (short j = 0; j < RADIX_SORT_BINS; j++) {
+    int e = lid.x * RADIX_SORT_BINS + j;
+    uint v = ranks[e];
+    ranks[e] = sum;
+    sum += v;
+  }
+  uint prefix = simd_prefix_exclusive_sum(sum);
+  uint total = simd_sum(sum);
+  if (simd_lane_id == 0) {
+    simd_totals[simd_group_id] = total;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  if (simd_group_id == 0) {
+    uint t = simd_lane_id < n_simdgroups ? simd_totals[simd_lane_id] : 0;
+    t = simd_prefix_exclusive_sum(t);
+    if (simd_lane_id < n_simdgroups) {
+      simd_totals[simd_lane_id] = t;
+    }
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+  prefix += simd_totals[simd_group_id];
+  for (short j = 0; j < RADIX_SORT_BINS; j++) {
+    ranks[lid.x * RADIX_SORT_BINS + j] += prefix;
+  }
+  threadgroup_barrier(mem_flags::mem_threadgroup);
+
+  // Scatter
+  for (short i = 0; i < N_PER_THREAD; i++) {
+    short d = digits[i];
+    if (d == RADIX_SORT_BINS) {
+      continue;
+    }
+    uint rank = ranks[d * BLOCK_THREADS + lid.x] - ranks[d * BLOCK_THREADS];
+    for (short j = 0; j < i; j++) {
+      rank += digits[j] == d;
+    }
+    uint pos = offsets[d * n_blocks + tid.x] + rank;
+    keys_out[pos] = vals[i];
+    if (ARG_SORT) {
+      idxs_out[pos] = idxs[i];
+    }
+  }
+}
@@ -124,4 +124,87 @@ instantiate_multi_block_sort_base(bfloat16, bfloat16_t)
   instantiate_multi_block_sort(vtname, vtype, uint32, uint32_t, true, 256, 8)
 
 instantiate_multi_block_sort_long(uint64, uint64_t)
-instantiate_multi_block_sort_long(int64, int64_t) // clang-format on
+instantiate_multi_block_sort_long(int64, int64_t)
+
+#define instantiate_radix_select(                                     \
+    name, itname, itype, otname, otype, arg_partition, bn)            \
+  template [[host_name(#name "_" #itname "_" #otname "_bn" #bn)]]     \
+  [[kernel]] void                                                     \
+  radix_select_partition<itype, otype, arg_partition, bn>(            \
+      const device itype* inp [[buffer(0)]],                          \
+      device otype* out [[buffer(1)]],                                \
+      const constant int& size_sorted_axis [[buffer(2)]],             \
+      const constant int& kth [[buffer(3)]],                          \
+      const constant int& in_stride_sorted_axis [[buffer(4)]],        \
+      const constant int& out_stride_sorted_axis [[buffer(5)]],       \
+      const constant int& nc_dim [[buffer(6)]],                       \
+      const constant int* nc_shape [[buffer(7)]],                     \
+      const constant size_t* in_nc_strides [[buffer(8)]],             \
+      const constant size_t* out_nc_strides [[buffer(9)]],            \
+      uint3 tid [[threadgroup_position_in_grid]],                     \
+      uint3 lid [[thread_position_in_threadgroup]],                   \
+      uint simd_lane_id [[thread_index_in_simdgroup]]);
+
+#define instantiate_radix_select_base(itname, itype)                   \
+  instantiate_radix_select(                                            \
+      radix_select, itname, itype, itname, itype, false, 1024)         \
+  instantiate_radix_select(                                            \
+      arg_radix_select, itname, itype, uint32, uint32_t, true, 1024)
+
+instantiate_radix_select_base(uint8, uint8_t)
+instantiate_radix_select_base(uint16, uint16_t)
+instantiate_radix_select_base(uint32, uint32_t)
+instantiate_radix_select_base(int8, int8_t)
+instantiate_radix_select_base(int16, int16_t)
+instantiate_radix_select_base(int32, int32_t)
+instantiate_radix_select_base(float16, half)
+instantiate_radix_select_base(float32, float)
+instantiate_radix_select_base(bfloat16, bfloat16_t)
+
+#define instantiate_radix_sort_scatter(name, vtname, vtype, arg_sort) \
+  template [[host_name(#name "_" #vtname)]] [[kernel]] void           \
+  radix_sort_scatter<vtype, uint32_t, arg_sort, 256, 4>(              \
+      const device vtype* keys_in [[buffer(0)]],                      \
+      const device uint32_t* idxs_in [[buffer(1)]],                   \
+      device vtype* keys_out [[buffer(2)]],                           \
+      device uint32_t* idxs_out [[buffer(3)]],                        \
+      const device uint* offsets [[buffer(4)]],                       \
+      const constant int& size_sorted_axis [[buffer(5)]],             \
+      const constant int& shift [[buffer(6)]],                        \
+      const constant bool& first_pass [[buffer(7)]],                  \
+      uint3 tid [[threadgroup_position_in_grid]],                     \
+      uint3 lid [[thread_position_in_threadgroup]],                   \
+      uint3 tgp_grid [[threadgroups_per_grid]],                       \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);
+
+#define instantiate_radix_sort(vtname, vtype)                           \
+  template [[host_name("radix_sort_count_" #vtname)]] [[kernel]] void   \
+  radix_sort_count<vtype, 256, 4>(                                      \
+      const device vtype* keys [[buffer(0)]],                           \
+      device uint* counts [[buffer(1)]],                                \
+      const constant int& size_sorted_axis [[buffer(2)]],               \
+      const constant int& shift [[buffer(3)]],                          \
+      uint3 tid [[threadgroup_position_in_grid]],                       \
+      uint3 lid [[thread_position_in_threadgroup]],                     \
+      uint3 tgp_grid [[threadgroups_per_grid]]);                        \
+  template [[host_name("radix_sort_scan_" #vtname)]] [[kernel]] void    \
+  radix_sort_scan<1024>(                                                \
+      device uint* counts [[buffer(0)]],                                \
+      const constant int& n_counts [[buffer(1)]],                       \
+      uint3 tid [[threadgroup_position_in_grid]],                       \
+      uint3 lid [[thread_position_in_threadgroup]],                     \
+      uint simd_lane_id [[thread_index_in_simdgroup]],                  \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]]);           \
+  instantiate_radix_sort_scatter(radix_sort_scatter, vtname, vtype, false) \
+  instantiate_radix_sort_scatter(arg_radix_sort_scatter, vtname, vtype, true)
+
+instantiate_radix_sort(uint8, uint8_t)
+instantiate_radix_sort(uint16, uint16_t)
+instantiate_radix_sort(uint32, uint32_t)
+instantiate_radix_sort(int8, int8_t)
+instantiate_radix_sort(int16, int16_t)
+instantiate_radix_sort(int32, int32_t)
+instantiate_radix_sort(float16, half)
+instantiate_radix_sort(float32, float)
+instantiate_radix_sort(bfloat16, bfloat16_t) // clang-format on
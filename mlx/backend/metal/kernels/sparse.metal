@@ -0,0 +1,84 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_simdgroup>
+
+#include "mlx/backend/metal/kernels/atomic.h"
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/defines.h"
+#include "mlx/backend/metal/kernels/utils.h"
+
+using namespace metal;
+
+// Each thread goes through a run of consecutive nonzeros for one column of b
+// and adds their products to the float32 output. The sum is only flushed with
+// an atomic when the row changes, so nonzeros sorted by row, as in CSR, need
+// one atomic per run of their row.
+template <typename T, int NNZ_PER_THREAD = 8>
+[[kernel]] void sparse_mm(
+    const device int* rows [[buffer(0)]],
+    const device int* cols [[buffer(1)]],
+    const device T* values [[buffer(2)]],
+    const device T* b [[buffer(3)]],
+    device mlx_atomic<float>* out [[buffer(4)]],
+    constant const int& N [[buffer(5)]],
+    constant const int& nnz [[buffer(6)]],
+    uint2 index [[thread_position_in_grid]]) {
+  int j = index.x;
+  int start = index.y * NNZ_PER_THREAD;
+  int end = min(start + NNZ_PER_THREAD, nnz);
+
+  int row = rows[start];
+  float acc = 0.0f;
+  for (int i = start; i < end; i++) {
+    if (rows[i] != row) {
+      mlx_atomic_fetch_add_explicit(out, acc, uint(row * N + j));
+      row = rows[i];
+      acc = 0.0f;
+    }
+    acc += static_cast<float>(values[i]) *
+        static_cast<float>(b[size_t(cols[i]) * N + j]);
+  }
+  mlx_atomic_fetch_add_explicit(out, acc, uint(row * N + j));
+}
+
+// Each simdgroup computes the dot product of the row of a and the row of b
+// selected by one nonzero.
+template <typename T>
+[[kernel]] void sampled_mm(
+    const device int* rows [[buffer(0)]],
+    const device int* cols [[buffer(1)]],
+    const device T* a [[buffer(2)]],
+    const device T* b [[buffer(3)]],
+    device T* out [[buffer(4)]],
+    constant const int& K [[buffer(5)]],
+    constant const int& nnz [[buffer(6)]],
+    uint tid [[threadgroup_position_in_grid]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_groups [[simdgroups_per_threadgroup]]) {
+  int i = tid * simd_groups + simd_gid;
+  if (i >= nnz) {
+    return;
+  }
+  a += size_t(rows[i]) * K;
+  b += size_t(cols[i]) * K;
+
+  float acc = 0.0f;
+  for (int k = simd_lid; k < K; k += simd_size) {
+    acc += static_cast<float>(a[k]) * static_cast<float>(b[k]);
+  }
+  acc = simd_sum(acc);
+  if (simd_lid == 0) {
+    out[i] = static_cast<T>(acc);
+  }
+}
+
+#define instantiate_sparse(name, type)                    \
+  instantiate_kernel("sparse_mm_" #name, sparse_mm, type)   \
+  instantiate_kernel("sampled_mm_" #name, sampled_mm, type)
+
+// clang-format off
+instantiate_sparse(float32, float)
+instantiate_sparse(float16, half)
+instantiate_sparse(bfloat16, bfloat16_t) // clang-format on
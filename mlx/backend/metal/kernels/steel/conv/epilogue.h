@@ -0,0 +1,62 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <metal_math>
+
+#include "mlx/backend/metal/kernels/erf.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Conv epilogue: out = activation(conv + bias)
+///////////////////////////////////////////////////////////////////////////////
+
+constant bool conv_has_bias [[function_constant(500)]];
+constant int conv_activation [[function_constant(501)]];
+
+namespace mlx {
+namespace steel {
+
+// Matches fast::ConvolutionEpilogue::Activation
+enum ConvActivation : int {
+  ConvActivationNone = 0,
+  ConvActivationReLU = 1,
+  ConvActivationSiLU = 2,
+  ConvActivationGELU = 3,
+};
+
+template <typename T>
+struct ConvEpilogue {
+  static METAL_FUNC float activation(float x) {
+    switch (conv_activation) {
+      case ConvActivationReLU:
+        return metal::max(x, 0.0f);
+      case ConvActivationSiLU:
+        return x / (1.0f + metal::exp(-x));
+      case ConvActivationGELU:
+        return 0.5f * x * (1.0f + erf(x * M_SQRT1_2_F));
+      default:
+        return x;
+    }
+  }
+
+  // Applies the bias of output channel o to the accumulated x
+  static METAL_FUNC float apply(float x, const device T* bias, int o) {
+    if (conv_has_bias) {
+      x += static_cast<float>(bias[o]);
+    }
+    return activation(x);
+  }
+
+  // Binary form for BlockMMA::apply_epilogue with the bias as the source
+  METAL_FUNC float apply(float x, T bias) const {
+    return activation(x + static_cast<float>(bias));
+  }
+
+  // Unary form for BlockMMA::apply_epilogue
+  METAL_FUNC float apply(float x) const {
+    return activation(x);
+  }
+};
+
+} // namespace steel
+} // namespace mlx
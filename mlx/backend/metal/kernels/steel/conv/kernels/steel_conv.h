@@ -20,6 +20,7 @@ implicit_gemm_conv_2d(
     device T* C [[buffer(2)]],
     const constant MLXConvParams<2>* params [[buffer(3)]],
     const constant ImplicitGemmConv2DParams* gemm_params [[buffer(4)]],
+    const device T* bias [[buffer(5), function_constant(conv_has_bias)]],
     uint3 tid [[threadgroup_position_in_grid]],
     uint3 lid [[thread_position_in_threadgroup]],
     uint simd_gid [[simdgroup_index_in_threadgroup]],
@@ -172,5 +173,18 @@ implicit_gemm_conv_2d(
   short tgp_bm = min(BM, gemm_params->M - c_row);
   short tgp_bn = min(BN, gemm_params->N - c_col);
   const int ldc = N * params->groups;
+
+  // Apply the bias and activation to the accumulators
+  if (conv_has_bias) {
+    mma_op.apply_epilogue_safe(
+        bias + tid.z * N + c_col,
+        0,
+        1,
+        short2(tgp_bn, tgp_bm),
+        ConvEpilogue<T>{});
+  } else if (conv_activation != ConvActivationNone) {
+    mma_op.apply_epilogue(ConvEpilogue<T>{});
+  }
+
   mma_op.store_result_safe(C, ldc, short2(tgp_bn, tgp_bm));
 }
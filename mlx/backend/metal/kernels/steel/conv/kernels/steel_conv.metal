@@ -31,6 +31,8 @@
       device itype* C [[buffer(2)]],                                           \
       const constant MLXConvParams<2>* params [[buffer(3)]],                   \
       const constant ImplicitGemmConv2DParams* gemm_params [[buffer(4)]],      \
+      const device itype* bias                                                 \
+          [[buffer(5), function_constant(conv_has_bias)]],                     \
       uint3 tid [[threadgroup_position_in_grid]],                              \
       uint3 lid [[thread_position_in_threadgroup]],                            \
       uint simd_gid [[simdgroup_index_in_threadgroup]],                        \
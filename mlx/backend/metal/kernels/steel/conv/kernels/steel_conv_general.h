@@ -21,6 +21,7 @@ implicit_gemm_conv_2d_general(
     const constant Conv2DGeneralJumpParams* jump_params [[buffer(5)]],
     const constant Conv2DGeneralBaseInfo* base_h [[buffer(6)]],
     const constant Conv2DGeneralBaseInfo* base_w [[buffer(7)]],
+    const device T* bias [[buffer(8), function_constant(conv_has_bias)]],
     uint3 tid [[threadgroup_position_in_grid]],
     uint3 lid [[thread_position_in_threadgroup]],
     uint simd_gid [[simdgroup_index_in_threadgroup]],
@@ -173,13 +174,17 @@ implicit_gemm_conv_2d_general(
               mma_op.results[i * mma_t::TN + j].thread_elements();
           int offset = offset_cm + (j * mma_t::TN_stride);
 
+          int o = offset_n + j * mma_t::TN_stride;
+
           // Apply epilogue and output C
           if (j * mma_t::TN_stride < diff) {
-            C[offset] = Epilogue::apply(accum[0]);
+            C[offset] =
+                Epilogue::apply(ConvEpilogue<T>::apply(accum[0], bias, o));
           }
 
           if (j * mma_t::TN_stride + 1 < diff) {
-            C[offset + 1] = Epilogue::apply(accum[1]);
+            C[offset + 1] =
+                Epilogue::apply(ConvEpilogue<T>::apply(accum[1], bias, o + 1));
           }
         }
       }
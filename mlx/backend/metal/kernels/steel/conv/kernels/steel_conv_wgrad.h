@@ -0,0 +1,123 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/backend/metal/kernels/steel/conv/loaders/loader_wgrad.h"
+#include "mlx/backend/metal/kernels/steel/gemm/loader.h"
+
+// The weight gradient of a convolution as an implicit gemm. With the
+// cotangent as a K x O matrix, K being the batch times the output spatial
+// size, the gradient is its transpose times the unfolded input which is
+// gathered block by block. K is usually much larger than the gradient so it
+// is split over tid.z and the partial products are written in float to be
+// summed by the split k accumulation kernel.
+template <typename T, int NDIM, int BM, int BN, int BK, int WM, int WN>
+[[kernel, max_total_threads_per_threadgroup(WM* WN * 32)]] void
+implicit_gemm_conv_wgrad(
+    const device T* A [[buffer(0)]],
+    const device T* B [[buffer(1)]],
+    device float* C [[buffer(2)]],
+    const constant MLXConvParams<NDIM>* params [[buffer(3)]],
+    const constant ImplicitGemmConvWeightGradParams* gemm_params [[buffer(4)]],
+    uint3 tid [[threadgroup_position_in_grid]],
+    uint3 lid [[thread_position_in_threadgroup]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]]) {
+  using namespace mlx::steel;
+
+  (void)lid;
+
+  constexpr bool transpose_a = true;
+  constexpr bool transpose_b = false;
+  constexpr short tgp_padding_a = 16 / sizeof(T);
+  constexpr short tgp_padding_b = 16 / sizeof(T);
+
+  constexpr short shape_a_cols = BM + tgp_padding_a;
+  constexpr short shape_b_cols = BN + tgp_padding_b;
+  constexpr short tgp_mem_size_a = shape_a_cols * BK;
+  constexpr short tgp_mem_size_b = shape_b_cols * BK;
+
+  constexpr short tgp_size = WM * WN * 32;
+
+  // Cotangent loader, the rows are contiguous in the output channels
+  using loader_a_t = BlockLoader<T, BK, BM, shape_a_cols, 0, tgp_size>;
+
+  // Unfolded input loader
+  using loader_b_t = ConvWeightGradInputBlockLoader<
+      T,
+      NDIM,
+      BK,
+      BN,
+      tgp_size,
+      tgp_padding_b>;
+
+  using mma_t = BlockMMA<
+      T,
+      float,
+      BM,
+      BN,
+      BK,
+      WM,
+      WN,
+      transpose_a,
+      transpose_b,
+      shape_a_cols,
+      shape_b_cols>;
+
+  threadgroup T As[tgp_mem_size_a];
+  threadgroup T Bs[tgp_mem_size_b];
+
+  const int tid_x = tid.x;
+  const int tid_y = tid.y;
+  if (gemm_params->tiles_n <= tid_x || gemm_params->tiles_m <= tid_y) {
+    return;
+  }
+
+  const int M = gemm_params->M;
+  const int N = gemm_params->N;
+  const int c_row = tid_y * BM;
+  const int c_col = tid_x * BN;
+  const int k_start = tid.z * gemm_params->split_k_partition_size;
+  const int k_end =
+      min(gemm_params->K, k_start + gemm_params->split_k_partition_size);
+
+  A += size_t(k_start) * M + c_row;
+  C += size_t(tid.z) * M * N + size_t(c_row) * N + c_col;
+
+  const int2 offsets_b(c_col, k_start);
+
+  // Prepare threadgroup loading operations
+  loader_a_t loader_a(A, M, As, simd_gid, simd_lid);
+  loader_b_t loader_b(
+      B, Bs, offsets_b, params, gemm_params, simd_gid, simd_lid);
+
+  // Prepare threadgroup mma operation
+  mma_t mma_op(simd_gid, simd_lid);
+
+  const short tgp_bm = min(BM, M - c_row);
+  const short tgp_bn = min(BN, N - c_col);
+
+  for (int k = k_start; k < k_end; k += BK) {
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    // Load elements into threadgroup
+    const short tgp_bk = min(BK, k_end - k);
+    if (tgp_bm == BM && tgp_bk == BK) {
+      loader_a.load_unsafe();
+    } else {
+      loader_a.load_safe(short2(tgp_bm, tgp_bk));
+    }
+    loader_b.load_safe(k_end);
+
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    // Multiply and accumulate threadgroup elements
+    mma_op.mma(As, Bs);
+
+    // Prepare for next iteration
+    loader_a.next();
+    loader_b.next();
+  }
+
+  threadgroup_barrier(mem_flags::mem_none);
+
+  // Store results to device memory
+  mma_op.store_result_safe(C, N, short2(tgp_bn, tgp_bm));
+}
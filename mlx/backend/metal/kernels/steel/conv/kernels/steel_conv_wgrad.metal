@@ -0,0 +1,43 @@
+// Copyright © 2024 Apple Inc.
+
+#include <metal_stdlib>
+
+// clang-format off
+#include "mlx/backend/metal/kernels/steel/gemm/mma.h"
+
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/steel/conv/conv.h"
+#include "mlx/backend/metal/kernels/steel/conv/params.h"
+#include "mlx/backend/metal/kernels/steel/utils.h"
+#include "mlx/backend/metal/kernels/steel/conv/kernels/steel_conv_wgrad.h"
+
+using namespace metal;
+using namespace mlx::steel;
+
+#define instantiate_conv_wgrad(name, itype, ndim, bm, bn, bk, wm, wn)                \
+  template                                                                          \
+      [[host_name("implicit_gemm_conv_wgrad_" #ndim "d_" #name "_bm" #bm "_bn" #bn  \
+                  "_bk" #bk "_wm" #wm "_wn" #wn)]] [[kernel]] void                  \
+      implicit_gemm_conv_wgrad<itype, ndim, bm, bn, bk, wm, wn>(                    \
+          const device itype* A [[buffer(0)]],                                      \
+          const device itype* B [[buffer(1)]],                                      \
+          device float* C [[buffer(2)]],                                            \
+          const constant MLXConvParams<ndim>* params [[buffer(3)]],                 \
+          const constant ImplicitGemmConvWeightGradParams* gemm_params              \
+              [[buffer(4)]],                                                        \
+          uint3 tid [[threadgroup_position_in_grid]],                               \
+          uint3 lid [[thread_position_in_threadgroup]],                             \
+          uint simd_gid [[simdgroup_index_in_threadgroup]],                         \
+          uint simd_lid [[thread_index_in_simdgroup]]);
+
+#define instantiate_conv_wgrad_blocks(name, itype, ndim)         \
+    instantiate_conv_wgrad(name, itype, ndim, 32, 32, 16, 2, 2) \
+    instantiate_conv_wgrad(name, itype, ndim, 64, 64, 16, 2, 2)
+
+#define instantiate_conv_wgrad_dims(name, itype)  \
+    instantiate_conv_wgrad_blocks(name, itype, 2) \
+    instantiate_conv_wgrad_blocks(name, itype, 3)
+
+instantiate_conv_wgrad_dims(float32, float);
+instantiate_conv_wgrad_dims(float16, half);
+instantiate_conv_wgrad_dims(bfloat16, bfloat16_t); // clang-format on
@@ -51,6 +51,8 @@ struct Conv2DInputBlockLoaderGeneral {
   short weight_h;
   short weight_w;
 
+  int read_c;
+
   const device T* src[n_rows];
 
   int read_n[n_rows];
@@ -77,7 +79,8 @@ struct Conv2DInputBlockLoaderGeneral {
         base_wh(base_wh_),
         base_ww(base_ww_),
         weight_h(base_wh_),
-        weight_w(base_ww_) {
+        weight_w(base_ww_),
+        read_c(bj) {
     STEEL_PRAGMA_UNROLL
     for (short i = 0; i < n_rows; ++i) {
       int offset_nhw = offsets.y + bi + i * TROWS;
@@ -102,6 +105,9 @@ struct Conv2DInputBlockLoaderGeneral {
 
   /* Load from device memory into threadgroup memory - without bound checking */
   METAL_FUNC void load_unsafe() const {
+    // The last channel block is partial when C is not a multiple of BK
+    const bool full_c = read_c + vec_size <= params->C;
+
     STEEL_PRAGMA_UNROLL
     for (short i = 0, is = 0; i < n_rows; ++i, is += TROWS) {
       // Find bounds
@@ -123,7 +129,9 @@ struct Conv2DInputBlockLoaderGeneral {
           (iw_dil >= 0 && iw < params->iS[1])) {
         STEEL_PRAGMA_UNROLL
         for (short j = 0; j < vec_size; ++j) {
-          dst[is * dst_ld + j] = (src[i])[offset + j];
+          dst[is * dst_ld + j] = (full_c || read_c + j < params->C)
+              ? (src[i])[offset + j]
+              : T(0);
         }
       }
 
@@ -157,6 +165,7 @@ struct Conv2DInputBlockLoaderGeneral {
     for (short i = 0; i < n_rows; i++) {
       src[i] += BK;
     }
+    read_c += BK;
   }
 };
 
@@ -207,6 +216,8 @@ struct Conv2DWeightBlockLoaderGeneral {
 
   const int start_row;
 
+  int read_c;
+
   /* Constructor */
   METAL_FUNC Conv2DWeightBlockLoaderGeneral(
       const device T* src_,
@@ -230,14 +241,18 @@ struct Conv2DWeightBlockLoaderGeneral {
         base_ww(base_ww_),
         weight_h(base_wh_),
         weight_w(base_ww_),
-        start_row(offsets.y + bi) {}
+        start_row(offsets.y + bi),
+        read_c(bj) {}
 
   /* Load from device memory into threadgroup memory - without bound checking */
   METAL_FUNC void load_unsafe() const {
     const device T* curr_src = src + weight_h * params->wt_strides[1] +
         weight_w * params->wt_strides[2];
 
-    if ((start_row + BN <= params->O)) {
+    // The last channel block is partial when C is not a multiple of BK
+    const bool full_c = read_c + vec_size <= params->C;
+
+    if ((start_row + BN <= params->O) && full_c) {
       STEEL_PRAGMA_UNROLL
       for (short i = 0; i < BN; i += TROWS) {
         STEEL_PRAGMA_UNROLL
@@ -250,7 +265,9 @@ struct Conv2DWeightBlockLoaderGeneral {
         if ((start_row + i) < params->O) {
           STEEL_PRAGMA_UNROLL
           for (short j = 0; j < vec_size; j++) {
-            dst[i * dst_ld + j] = curr_src[i * src_ld + j];
+            dst[i * dst_ld + j] = (full_c || read_c + j < params->C)
+                ? curr_src[i * src_ld + j]
+                : T(0);
           }
         } else {
           STEEL_PRAGMA_UNROLL
@@ -279,6 +296,7 @@ struct Conv2DWeightBlockLoaderGeneral {
     weight_h = base_wh;
 
     src += BK;
+    read_c += BK;
   }
 };
 
@@ -0,0 +1,130 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/backend/metal/kernels/steel/defines.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Loading helper
+///////////////////////////////////////////////////////////////////////////////
+
+namespace mlx {
+namespace steel {
+
+// Loads blocks of the unfolded input of a convolution. Row k of the unfolded
+// input is the output position k (batch and spatial) and column j is the
+// filter tap and input channel j, so the weight gradient is the product of
+// the transposed cotangent with it.
+template <
+    typename T,
+    int NDIM,
+    short BK,
+    short BN,
+    short tgp_size,
+    short tgp_padding = 0>
+struct ConvWeightGradInputBlockLoader {
+  // Destination dimensions
+  STEEL_CONST short BROWS = BK;
+  STEEL_CONST short BCOLS = BN;
+
+  // Read dimensions
+  STEEL_CONST short dst_ld = BCOLS + tgp_padding;
+  STEEL_CONST short vec_size = (BROWS * BCOLS) / tgp_size;
+
+  // Thread read shape
+  STEEL_CONST short TCOLS = BCOLS / vec_size;
+  STEEL_CONST short TROWS = tgp_size / TCOLS;
+
+  // Rows / strided reads within the block
+  STEEL_CONST short n_rows = BROWS / TROWS;
+
+  // Thread location indices
+  const short thread_idx;
+  const short bi;
+  const short bj;
+
+  // threadgroup and device memory
+  threadgroup T* dst;
+  const device T* src;
+
+  const constant MLXConvParams<NDIM>* params;
+
+  // Output position of the first row read by the thread
+  int read_k;
+
+  // Filter taps and channels of the columns read by the thread, which stay
+  // the same for every block since the reduction runs over the rows
+  int tap[vec_size][NDIM];
+  int read_c[vec_size];
+  bool valid_col[vec_size];
+
+  /* Constructor */
+  METAL_FUNC ConvWeightGradInputBlockLoader(
+      const device T* src_,
+      threadgroup T* dst_,
+      const int2 offsets,
+      const constant MLXConvParams<NDIM>* params_,
+      const constant ImplicitGemmConvWeightGradParams* gemm_params,
+      uint simd_group_id [[simdgroup_index_in_threadgroup]],
+      uint simd_lane_id [[thread_index_in_simdgroup]])
+      : thread_idx(simd_group_id * 32 + simd_lane_id),
+        bi(thread_idx / TCOLS),
+        bj(vec_size * (thread_idx % TCOLS)),
+        dst(dst_ + bi * dst_ld + bj),
+        src(src_),
+        params(params_),
+        read_k(offsets.y + bi) {
+    STEEL_PRAGMA_UNROLL
+    for (short j = 0; j < vec_size; ++j) {
+      int col = offsets.x + bj + j;
+      valid_col[j] = col < gemm_params->N;
+      read_c[j] = col % params->C;
+      int w = col / params->C;
+      STEEL_PRAGMA_UNROLL
+      for (int d = NDIM - 1; d >= 0; --d) {
+        tap[j][d] = (w % params->wS[d]) * params->kdil[d];
+        w /= params->wS[d];
+      }
+    }
+  }
+
+  /* Load from device memory into threadgroup memory, rows from k_end on and
+   * taps landing in the padding are zero */
+  METAL_FUNC void load_safe(const int k_end) const {
+    STEEL_PRAGMA_UNROLL
+    for (short i = 0, is = 0; i < n_rows; ++i, is += TROWS) {
+      // Find the batch and the input position of the first tap
+      int k = read_k + is;
+      int base[NDIM];
+      STEEL_PRAGMA_UNROLL
+      for (int d = NDIM - 1; d >= 0; --d) {
+        base[d] = (k % params->oS[d]) * params->str[d] - params->pad[d];
+        k /= params->oS[d];
+      }
+      bool valid_row = read_k + is < k_end;
+      size_t offset_n = k * params->in_strides[0];
+
+      STEEL_PRAGMA_UNROLL
+      for (short j = 0; j < vec_size; ++j) {
+        bool valid = valid_row && valid_col[j];
+        size_t offset = offset_n + read_c[j];
+        STEEL_PRAGMA_UNROLL
+        for (int d = 0; d < NDIM; ++d) {
+          int idx = base[d] + tap[j][d];
+          valid &= idx >= 0 && idx < params->iS[d];
+          offset += idx * params->in_strides[d + 1];
+        }
+        T val = src[valid ? offset : 0];
+        dst[is * dst_ld + j] = valid ? val : T(0);
+      }
+    }
+  }
+
+  /* Iteration helper */
+  METAL_FUNC void next() {
+    read_k += BK;
+  }
+};
+
+} // namespace steel
+} // namespace mlx
@@ -58,5 +58,17 @@ struct Conv2DGeneralBaseInfo {
   int weight_size;
 };
 
+struct ImplicitGemmConvWeightGradParams {
+  const int M; // Output channels
+  const int N; // Filter taps times input channels
+  const int K; // Batch times output spatial size
+
+  const int tiles_n;
+  const int tiles_m;
+
+  const int split_k_partitions;
+  const int split_k_partition_size;
+};
+
 } // namespace steel
 } // namespace mlx
\ No newline at end of file
@@ -0,0 +1,219 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/backend/metal/kernels/fp8.h"
+#include "mlx/backend/metal/kernels/steel/defines.h"
+
+using namespace mlx::steel;
+
+///////////////////////////////////////////////////////////////////////////////
+// fp8 GEMM kernels
+///////////////////////////////////////////////////////////////////////////////
+
+// The weights are a row-major (N, K) matrix of 8-bit floats stored as uint8,
+// see to_fp8. e5m2 selects the format, e4m3 otherwise.
+
+// Converts tiles of the weights into tiles of T in threadgroup memory. Only
+// the 8-bit codes are read from device memory. Every thread converts n_reads
+// consecutive columns of TROWS apart rows, as BlockLoader copies them.
+template <
+    typename T,
+    short BROWS,
+    short BCOLS,
+    short dst_ld,
+    short tgp_size,
+    bool e5m2,
+    short n_reads = (BCOLS * BROWS) / (tgp_size),
+    short TCOLS = BCOLS / n_reads,
+    short TROWS = tgp_size / TCOLS>
+struct Fp8BlockLoader {
+  const int src_ld;
+  const short bi;
+  const short bj;
+
+  threadgroup T* dst;
+  const device uint8_t* src;
+
+  METAL_FUNC Fp8BlockLoader(
+      const device uint8_t* src_,
+      const int src_ld_,
+      threadgroup T* dst_,
+      ushort simd_group_id [[simdgroup_index_in_threadgroup]],
+      ushort simd_lane_id [[thread_index_in_simdgroup]])
+      : src_ld(src_ld_),
+        bi((simd_group_id * 32 + simd_lane_id) / TCOLS),
+        bj(n_reads * ((simd_group_id * 32 + simd_lane_id) % TCOLS)),
+        dst(dst_ + bi * dst_ld + bj),
+        src(src_ + bi * src_ld + bj) {}
+
+  METAL_FUNC void load_unsafe() const {
+    STEEL_PRAGMA_UNROLL
+    for (short i = 0; i < BROWS; i += TROWS) {
+      STEEL_PRAGMA_UNROLL
+      for (short j = 0; j < n_reads; j++) {
+        dst[i * dst_ld + j] =
+            static_cast<T>(fp8_to_float<e5m2>(src[i * src_ld + j]));
+      }
+    }
+  }
+
+  // The rows and columns past the end of the weights are zeros
+  METAL_FUNC void load_safe(short2 src_tile_dim) const {
+    src_tile_dim = src_tile_dim - short2(bj, bi);
+    STEEL_PRAGMA_UNROLL
+    for (short i = 0; i < BROWS; i += TROWS) {
+      STEEL_PRAGMA_UNROLL
+      for (short j = 0; j < n_reads; j++) {
+        bool valid = i < src_tile_dim.y && j < src_tile_dim.x;
+        dst[i * dst_ld + j] = valid
+            ? static_cast<T>(fp8_to_float<e5m2>(src[i * src_ld + j]))
+            : T(0);
+      }
+    }
+  }
+
+  METAL_FUNC void next() {
+    src += BCOLS;
+  }
+};
+
+// D = A @ B.T with B in fp8. It is the steel GEMM loop with the tiles of B
+// converted by Fp8BlockLoader, so the weights take half the bandwidth of
+// float16 weights. A last partial tile of K is loaded with bound checks.
+template <
+    typename T,
+    int BM,
+    int BN,
+    int BK,
+    int WM,
+    int WN,
+    bool e5m2,
+    typename AccumType = float>
+[[kernel, max_total_threads_per_threadgroup(WM* WN * 32)]] void fp8_gemm(
+    const device T* A [[buffer(0)]],
+    const device uint8_t* B [[buffer(1)]],
+    device T* D [[buffer(2)]],
+    const constant int& M [[buffer(3)]],
+    const constant int& N [[buffer(4)]],
+    const constant int& K [[buffer(5)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr short tgp_size = WM * WN * 32;
+  constexpr short BK_padded = BK + 16 / sizeof(T);
+
+  using mma_t = BlockMMA<
+      T,
+      T,
+      BM,
+      BN,
+      BK,
+      WM,
+      WN,
+      false,
+      true,
+      BK_padded,
+      BK_padded,
+      AccumType>;
+  using loader_a_t = BlockLoader<T, BM, BK, BK_padded, 1, tgp_size>;
+  using loader_b_t = Fp8BlockLoader<T, BN, BK, BK_padded, tgp_size, e5m2>;
+
+  threadgroup T As[BM * BK_padded];
+  threadgroup T Bs[BN * BK_padded];
+
+  const int c_row = tid.y * BM;
+  const int c_col = tid.x * BN;
+  const short tgp_bm = short(min(BM, M - c_row));
+  const short tgp_bn = short(min(BN, N - c_col));
+
+  A += size_t(c_row) * K;
+  B += size_t(c_col) * K;
+  D += size_t(c_row) * N + c_col;
+
+  thread loader_a_t loader_a(A, K, As, simd_group_id, simd_lane_id);
+  thread loader_b_t loader_b(B, K, Bs, simd_group_id, simd_lane_id);
+  thread mma_t mma_op(simd_group_id, simd_lane_id);
+
+  const bool safe = tgp_bm < BM || tgp_bn < BN;
+  for (int k = 0; k < K / BK; k++) {
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (safe) {
+      loader_a.load_safe(short2(BK, tgp_bm));
+      loader_b.load_safe(short2(BK, tgp_bn));
+    } else {
+      loader_a.load_unsafe();
+      loader_b.load_unsafe();
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    mma_op.mma(As, Bs);
+    loader_a.next();
+    loader_b.next();
+  }
+
+  const short k_remain = K % BK;
+  if (k_remain > 0) {
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    loader_a.load_safe(short2(k_remain, tgp_bm));
+    loader_b.load_safe(short2(k_remain, tgp_bn));
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    mma_op.mma(As, Bs);
+  }
+
+  threadgroup_barrier(mem_flags::mem_none);
+  if (safe) {
+    mma_op.store_result_safe(D, N, short2(tgp_bn, tgp_bm));
+  } else {
+    mma_op.store_result(D, N);
+  }
+}
+
+// y = x @ B.T for a few rows of x. Each simdgroup computes rows_per_simd
+// outputs and each of its threads reads 4 consecutive codes of those rows at
+// a time.
+template <typename T, int max_rows, bool e5m2, int rows_per_simd = 4>
+[[kernel]] void fp8_gemv(
+    const device T* x [[buffer(0)]],
+    const device uint8_t* B [[buffer(1)]],
+    device T* y [[buffer(2)]],
+    const constant int& M [[buffer(3)]],
+    const constant int& N [[buffer(4)]],
+    const constant int& K [[buffer(5)]],
+    uint tid [[threadgroup_position_in_grid]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]],
+    uint simd_groups [[simdgroups_per_threadgroup]]) {
+  constexpr int reads = 4;
+  const int n0 = (tid * simd_groups + simd_gid) * rows_per_simd;
+
+  float acc[max_rows][rows_per_simd] = {{0}};
+  for (int k = simd_lid * reads; k < K; k += 32 * reads) {
+    float xk[max_rows][reads];
+    for (int i = 0; i < max_rows; i++) {
+      for (int j = 0; j < reads; j++) {
+        xk[i][j] =
+            (i < M && k + j < K) ? static_cast<float>(x[i * K + k + j]) : 0;
+      }
+    }
+    for (int r = 0; r < rows_per_simd; r++) {
+      int n = n0 + r;
+      if (n >= N) {
+        break;
+      }
+      const device uint8_t* w = B + size_t(n) * K + k;
+      for (int j = 0; j < reads; j++) {
+        float wj = (k + j < K) ? fp8_to_float<e5m2>(w[j]) : 0;
+        for (int i = 0; i < max_rows; i++) {
+          acc[i][r] += wj * xk[i][j];
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < max_rows; i++) {
+    for (int r = 0; r < rows_per_simd; r++) {
+      float sum = simd_sum(acc[i][r]);
+      if (simd_lid == 0 && i < M && n0 + r < N) {
+        y[i * N + n0 + r] = static_cast<T>(sum);
+      }
+    }
+  }
+}
@@ -0,0 +1,40 @@
+// Copyright © 2024 Apple Inc.
+
+// clang-format off
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/utils.h"
+
+#include "mlx/backend/metal/kernels/steel/gemm/gemm.h"
+#include "mlx/backend/metal/kernels/steel/gemm/kernels/steel_gemm_fp8.h"
+
+#define instantiate_fp8_gemm(iname, itype, fname, e5m2, bm, bn, bk, wm, wn) \
+  template [[host_name("steel_fp8_gemm_" #fname "_" #iname "_bm" #bm "_bn" #bn "_bk" #bk "_wm" #wm "_wn" #wn)]] \
+  [[kernel]] void fp8_gemm<itype, bm, bn, bk, wm, wn, e5m2, float>( \
+      const device itype* A [[buffer(0)]], \
+      const device uint8_t* B [[buffer(1)]], \
+      device itype* D [[buffer(2)]], \
+      const constant int& M [[buffer(3)]], \
+      const constant int& N [[buffer(4)]], \
+      const constant int& K [[buffer(5)]], \
+      uint simd_lane_id [[thread_index_in_simdgroup]], \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]], \
+      uint3 tid [[threadgroup_position_in_grid]]);
+
+#define instantiate_fp8_gemv(iname, itype, fname, e5m2, max_rows) \
+  instantiate_kernel( \
+      "fp8_gemv_" #fname "_" #iname "_m" #max_rows, fp8_gemv, itype, max_rows, e5m2)
+
+#define instantiate_fp8_format(iname, itype, fname, e5m2) \
+    instantiate_fp8_gemm(iname, itype, fname, e5m2, 32, 32, 32, 2, 2) \
+    instantiate_fp8_gemm(iname, itype, fname, e5m2, 64, 64, 32, 2, 2) \
+    instantiate_fp8_gemv(iname, itype, fname, e5m2, 1) \
+    instantiate_fp8_gemv(iname, itype, fname, e5m2, 8)
+
+#define instantiate_fp8(iname, itype) \
+    instantiate_fp8_format(iname, itype, e4m3, false) \
+    instantiate_fp8_format(iname, itype, e5m2, true)
+
+instantiate_fp8(float16, half);
+instantiate_fp8(bfloat16, bfloat16_t);
+instantiate_fp8(float32, float);
+// clang-format on
@@ -0,0 +1,166 @@
+// Copyright © 2024 Apple Inc.
+
+using namespace mlx::steel;
+
+///////////////////////////////////////////////////////////////////////////////
+// Gather GEMM kernels
+///////////////////////////////////////////////////////////////////////////////
+
+constant bool align_N [[function_constant(201)]];
+constant bool align_K [[function_constant(202)]];
+
+// Runs the gemm loop over the whole K with the tile of A loaded safely since
+// only some of its rows are stored
+template <typename T, typename gemm_kernel, bool N_aligned>
+METAL_FUNC void gather_gemm_loop(
+    threadgroup T* As,
+    threadgroup T* Bs,
+    const int gemm_k_iterations,
+    thread typename gemm_kernel::loader_a_t& loader_a,
+    thread typename gemm_kernel::loader_b_t& loader_b,
+    thread typename gemm_kernel::mma_t& mma_op,
+    thread const short& tgp_bm,
+    thread const short& tgp_bn,
+    thread const short& lbk) {
+  if (align_K) {
+    gemm_kernel::gemm_loop(
+        As,
+        Bs,
+        gemm_k_iterations,
+        loader_a,
+        loader_b,
+        mma_op,
+        tgp_bm,
+        tgp_bn,
+        lbk,
+        LoopAlignment<false, N_aligned, true>{});
+  } else {
+    gemm_kernel::gemm_loop(
+        As,
+        Bs,
+        gemm_k_iterations,
+        loader_a,
+        loader_b,
+        mma_op,
+        tgp_bm,
+        tgp_bn,
+        lbk,
+        LoopAlignment<false, N_aligned, false>{});
+  }
+}
+
+// Computes D[i] = A[i] @ B[rhs_indices[i]] where A has one row per index.
+//
+// The rows of a tile of A sharing the same matrix of B are multiplied with
+// it together and only their results are stored. When the indices are
+// sorted most tiles need a single pass so every matrix of B is loaded once
+// per tile of rows instead of once per row.
+template <
+    typename T,
+    int BM,
+    int BN,
+    int BK,
+    int WM,
+    int WN,
+    bool transpose_b,
+    typename AccumType = float>
+[[kernel, max_total_threads_per_threadgroup(WM* WN * 32)]] void gather_mm_rhs(
+    const device T* A [[buffer(0)]],
+    const device T* B [[buffer(1)]],
+    const device uint32_t* rhs_indices [[buffer(2)]],
+    device T* D [[buffer(3)]],
+    const constant GEMMParams* params [[buffer(4)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  using gemm_kernel = GEMMKernel<
+      T,
+      T,
+      BM,
+      BN,
+      BK,
+      WM,
+      WN,
+      false,
+      transpose_b,
+      true,
+      true,
+      AccumType>;
+
+  using loader_a_t = typename gemm_kernel::loader_a_t;
+  using loader_b_t = typename gemm_kernel::loader_b_t;
+  using mma_t = typename gemm_kernel::mma_t;
+
+  // Prepare threadgroup memory
+  threadgroup T As[gemm_kernel::tgp_mem_size_a];
+  threadgroup T Bs[gemm_kernel::tgp_mem_size_b];
+
+  // Find block in A, B, D
+  const int c_row = tid.y * BM;
+  const int c_col = tid.x * BN;
+  const short tgp_bm = short(min(BM, params->M - c_row));
+  const short tgp_bn = align_N ? BN : short(min(BN, params->N - c_col));
+  const short lbk = params->K - params->gemm_k_iterations_aligned * BK;
+
+  A += size_t(c_row) * params->lda;
+  B += transpose_b ? size_t(c_col) * params->ldb : size_t(c_col);
+  D += size_t(c_row) * params->ldd + c_col;
+  rhs_indices += c_row;
+
+  // Find the runs of rows using the same matrix of B and multiply them
+  uint32_t index_next = rhs_indices[0];
+  short offset_next = 0;
+  short n = 0;
+  while (n < tgp_bm) {
+    n++;
+    const short offset = offset_next;
+    const uint32_t index = index_next;
+    offset_next = tgp_bm;
+    for (; n < tgp_bm; n++) {
+      if (rhs_indices[n] != index) {
+        offset_next = n;
+        index_next = rhs_indices[n];
+        break;
+      }
+    }
+    threadgroup_barrier(mem_flags::mem_none);
+
+    thread mma_t mma_op(simd_group_id, simd_lane_id);
+    thread loader_a_t loader_a(A, params->lda, As, simd_group_id, simd_lane_id);
+    thread loader_b_t loader_b(
+        B + index * params->batch_stride_b,
+        params->ldb,
+        Bs,
+        simd_group_id,
+        simd_lane_id);
+
+    if (align_N || tgp_bn == BN) {
+      gather_gemm_loop<T, gemm_kernel, true>(
+          As,
+          Bs,
+          params->gemm_k_iterations_aligned,
+          loader_a,
+          loader_b,
+          mma_op,
+          tgp_bm,
+          tgp_bn,
+          lbk);
+    } else {
+      gather_gemm_loop<T, gemm_kernel, false>(
+          As,
+          Bs,
+          params->gemm_k_iterations_aligned,
+          loader_a,
+          loader_b,
+          mma_op,
+          tgp_bm,
+          tgp_bn,
+          lbk);
+    }
+
+    // Store the rows of the run
+    threadgroup_barrier(mem_flags::mem_none);
+    mma_op.store_result_slice(
+        D, params->ldd, short2(0, offset), short2(tgp_bn, offset_next));
+  }
+}
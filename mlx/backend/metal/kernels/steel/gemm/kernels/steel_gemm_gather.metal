@@ -0,0 +1,33 @@
+// Copyright © 2024 Apple Inc.
+
+// clang-format off
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/utils.h"
+
+#include "mlx/backend/metal/kernels/steel/gemm/gemm.h"
+#include "mlx/backend/metal/kernels/steel/gemm/kernels/steel_gemm_gather.h"
+
+#define instantiate_gather_mm_rhs(tname, transpose_b, iname, itype, bm, bn, bk, wm, wn) \
+  template [[host_name("steel_gather_mm_rhs_" #tname "_" #iname "_bm" #bm "_bn" #bn "_bk" #bk "_wm" #wm "_wn" #wn)]] \
+  [[kernel]] void gather_mm_rhs<itype, bm, bn, bk, wm, wn, transpose_b, float>( \
+      const device itype* A [[buffer(0)]], \
+      const device itype* B [[buffer(1)]], \
+      const device uint32_t* rhs_indices [[buffer(2)]], \
+      device itype* D [[buffer(3)]], \
+      const constant GEMMParams* params [[buffer(4)]], \
+      uint simd_lane_id [[thread_index_in_simdgroup]], \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]], \
+      uint3 tid [[threadgroup_position_in_grid]]);
+
+#define instantiate_gather_mm_rhs_transpose_helper(iname, itype, bm, bn, bk, wm, wn) \
+    instantiate_gather_mm_rhs(nn, false, iname, itype, bm, bn, bk, wm, wn) \
+    instantiate_gather_mm_rhs(nt, true, iname, itype, bm, bn, bk, wm, wn)
+
+#define instantiate_gather_mm_rhs_shapes_helper(iname, itype) \
+    instantiate_gather_mm_rhs_transpose_helper(iname, itype, 32, 32, 16, 2, 2) \
+    instantiate_gather_mm_rhs_transpose_helper(iname, itype, 64, 64, 16, 2, 2)
+
+instantiate_gather_mm_rhs_shapes_helper(float16, half);
+instantiate_gather_mm_rhs_shapes_helper(bfloat16, bfloat16_t);
+instantiate_gather_mm_rhs_shapes_helper(float32, float);
+// clang-format on
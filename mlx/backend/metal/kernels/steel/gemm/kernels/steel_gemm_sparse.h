@@ -0,0 +1,229 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/backend/metal/kernels/steel/defines.h"
+
+using namespace mlx::steel;
+
+///////////////////////////////////////////////////////////////////////////////
+// 2:4 sparse GEMM kernels
+///////////////////////////////////////////////////////////////////////////////
+
+// The weights are a row-major (N, K) matrix with two nonzeros in every group
+// of four columns. The kept values are stored in order in a (N, K / 2) array
+// and their positions in four bits per group of a (N, K / 32) uint32 array,
+// the first position in the low two bits.
+
+// Expands tiles of the weights into dense tiles in threadgroup memory. Only
+// the kept values and the metadata are read from device memory. Every thread
+// expands a run of groups of one row.
+template <
+    typename T,
+    short BROWS,
+    short BCOLS,
+    short dst_ld,
+    short tgp_size>
+struct Sparse24BlockLoader {
+  STEEL_CONST short n_cols = (BROWS * BCOLS) / tgp_size;
+  STEEL_CONST short n_groups = n_cols / 4;
+  STEEL_CONST short threads_per_row = BCOLS / n_cols;
+
+  static_assert(BCOLS % 32 == 0, "The tile must cover whole metadata words");
+  static_assert(n_cols % 4 == 0, "Each thread must expand whole groups");
+  static_assert(32 % n_cols == 0, "A thread must not straddle two words");
+
+  const int values_ld;
+  const int meta_ld;
+  const short bi;
+  const short bj;
+  const short shift;
+
+  threadgroup T* dst;
+  const device T* values;
+  const device uint32_t* meta;
+
+  METAL_FUNC Sparse24BlockLoader(
+      const device T* values_,
+      const device uint32_t* meta_,
+      const int K,
+      threadgroup T* dst_,
+      ushort simd_group_id [[simdgroup_index_in_threadgroup]],
+      ushort simd_lane_id [[thread_index_in_simdgroup]])
+      : values_ld(K / 2),
+        meta_ld(K / 32),
+        bi((simd_group_id * 32 + simd_lane_id) / threads_per_row),
+        bj(((simd_group_id * 32 + simd_lane_id) % threads_per_row) * n_cols),
+        shift(bj % 32),
+        dst(dst_ + bi * dst_ld + bj),
+        values(values_ + bi * values_ld + bj / 2),
+        meta(meta_ + bi * meta_ld + bj / 32) {}
+
+  METAL_FUNC void load_unsafe() const {
+    uint32_t m = *meta >> shift;
+    STEEL_PRAGMA_UNROLL
+    for (short g = 0; g < n_groups; g++) {
+      short i0 = (m >> (4 * g)) & 3;
+      short i1 = (m >> (4 * g + 2)) & 3;
+      T v0 = values[2 * g];
+      T v1 = values[2 * g + 1];
+      STEEL_PRAGMA_UNROLL
+      for (short c = 0; c < 4; c++) {
+        dst[4 * g + c] = c == i0 ? v0 : (c == i1 ? v1 : T(0));
+      }
+    }
+  }
+
+  // The rows past the end of the weights are zeros. K is a multiple of the
+  // tile so the columns are always in bounds.
+  METAL_FUNC void load_safe(short2 src_tile_dim) const {
+    if (bi >= src_tile_dim.y) {
+      STEEL_PRAGMA_UNROLL
+      for (short c = 0; c < n_cols; c++) {
+        dst[c] = T(0);
+      }
+      return;
+    }
+    load_unsafe();
+  }
+
+  METAL_FUNC void next() {
+    values += BCOLS / 2;
+    meta += BCOLS / 32;
+  }
+};
+
+// D = A @ B.T with B 2:4 sparse. It is the steel GEMM loop with the tiles of
+// B expanded by Sparse24BlockLoader, so the weights take half the bandwidth
+// of a dense GEMM.
+template <
+    typename T,
+    int BM,
+    int BN,
+    int BK,
+    int WM,
+    int WN,
+    typename AccumType = float>
+[[kernel, max_total_threads_per_threadgroup(WM* WN * 32)]] void
+sparse_2_4_gemm(
+    const device T* A [[buffer(0)]],
+    const device T* B_values [[buffer(1)]],
+    const device uint32_t* B_meta [[buffer(2)]],
+    device T* D [[buffer(3)]],
+    const constant int& M [[buffer(4)]],
+    const constant int& N [[buffer(5)]],
+    const constant int& K [[buffer(6)]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]],
+    uint3 tid [[threadgroup_position_in_grid]]) {
+  constexpr short tgp_size = WM * WN * 32;
+  constexpr short BK_padded = BK + 16 / sizeof(T);
+
+  using mma_t = BlockMMA<
+      T,
+      T,
+      BM,
+      BN,
+      BK,
+      WM,
+      WN,
+      false,
+      true,
+      BK_padded,
+      BK_padded,
+      AccumType>;
+  using loader_a_t = BlockLoader<T, BM, BK, BK_padded, 1, tgp_size>;
+  using loader_b_t = Sparse24BlockLoader<T, BN, BK, BK_padded, tgp_size>;
+
+  threadgroup T As[BM * BK_padded];
+  threadgroup T Bs[BN * BK_padded];
+
+  const int c_row = tid.y * BM;
+  const int c_col = tid.x * BN;
+  const short tgp_bm = short(min(BM, M - c_row));
+  const short tgp_bn = short(min(BN, N - c_col));
+
+  A += size_t(c_row) * K;
+  B_values += size_t(c_col) * (K / 2);
+  B_meta += size_t(c_col) * (K / 32);
+  D += size_t(c_row) * N + c_col;
+
+  thread loader_a_t loader_a(A, K, As, simd_group_id, simd_lane_id);
+  thread loader_b_t loader_b(
+      B_values, B_meta, K, Bs, simd_group_id, simd_lane_id);
+  thread mma_t mma_op(simd_group_id, simd_lane_id);
+
+  const bool safe = tgp_bm < BM || tgp_bn < BN;
+  for (int k = 0; k < K; k += BK) {
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (safe) {
+      loader_a.load_safe(short2(BK, tgp_bm));
+      loader_b.load_safe(short2(BK, tgp_bn));
+    } else {
+      loader_a.load_unsafe();
+      loader_b.load_unsafe();
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    mma_op.mma(As, Bs);
+    loader_a.next();
+    loader_b.next();
+  }
+
+  threadgroup_barrier(mem_flags::mem_none);
+  if (safe) {
+    mma_op.store_result_safe(D, N, short2(tgp_bn, tgp_bm));
+  } else {
+    mma_op.store_result(D, N);
+  }
+}
+
+// y = x @ B.T for a few rows of x. Each simdgroup computes rows_per_simd
+// outputs and each of its threads reads whole metadata words, i.e. 16 kept
+// values, of those rows.
+template <typename T, int max_rows, int rows_per_simd = 4>
+[[kernel]] void sparse_2_4_gemv(
+    const device T* x [[buffer(0)]],
+    const device T* B_values [[buffer(1)]],
+    const device uint32_t* B_meta [[buffer(2)]],
+    device T* y [[buffer(3)]],
+    const constant int& M [[buffer(4)]],
+    const constant int& N [[buffer(5)]],
+    const constant int& K [[buffer(6)]],
+    uint tid [[threadgroup_position_in_grid]],
+    uint simd_gid [[simdgroup_index_in_threadgroup]],
+    uint simd_lid [[thread_index_in_simdgroup]],
+    uint simd_groups [[simdgroups_per_threadgroup]]) {
+  const int n0 = (tid * simd_groups + simd_gid) * rows_per_simd;
+  const int words = K / 32;
+
+  float acc[max_rows][rows_per_simd] = {{0}};
+  for (int w = simd_lid; w < words; w += 32) {
+    for (int r = 0; r < rows_per_simd; r++) {
+      int n = n0 + r;
+      if (n >= N) {
+        break;
+      }
+      uint32_t m = B_meta[size_t(n) * words + w];
+      const device T* v = B_values + size_t(n) * (K / 2) + w * 16;
+      for (int g = 0; g < 8; g++) {
+        int k0 = w * 32 + 4 * g + ((m >> (4 * g)) & 3);
+        int k1 = w * 32 + 4 * g + ((m >> (4 * g + 2)) & 3);
+        float v0 = static_cast<float>(v[2 * g]);
+        float v1 = static_cast<float>(v[2 * g + 1]);
+        for (int i = 0; i < max_rows; i++) {
+          if (i < M) {
+            acc[i][r] += v0 * static_cast<float>(x[i * K + k0]) +
+                v1 * static_cast<float>(x[i * K + k1]);
+          }
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < max_rows; i++) {
+    for (int r = 0; r < rows_per_simd; r++) {
+      float sum = simd_sum(acc[i][r]);
+      if (simd_lid == 0 && i < M && n0 + r < N) {
+        y[i * N + n0 + r] = static_cast<T>(sum);
+      }
+    }
+  }
+}
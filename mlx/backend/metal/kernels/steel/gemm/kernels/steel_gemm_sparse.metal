@@ -0,0 +1,37 @@
+// Copyright © 2024 Apple Inc.
+
+// clang-format off
+#include "mlx/backend/metal/kernels/bf16.h"
+#include "mlx/backend/metal/kernels/utils.h"
+
+#include "mlx/backend/metal/kernels/steel/gemm/gemm.h"
+#include "mlx/backend/metal/kernels/steel/gemm/kernels/steel_gemm_sparse.h"
+
+#define instantiate_sparse_2_4_gemm(iname, itype, bm, bn, bk, wm, wn) \
+  template [[host_name("steel_sparse_2_4_gemm_" #iname "_bm" #bm "_bn" #bn "_bk" #bk "_wm" #wm "_wn" #wn)]] \
+  [[kernel]] void sparse_2_4_gemm<itype, bm, bn, bk, wm, wn, float>( \
+      const device itype* A [[buffer(0)]], \
+      const device itype* B_values [[buffer(1)]], \
+      const device uint32_t* B_meta [[buffer(2)]], \
+      device itype* D [[buffer(3)]], \
+      const constant int& M [[buffer(4)]], \
+      const constant int& N [[buffer(5)]], \
+      const constant int& K [[buffer(6)]], \
+      uint simd_lane_id [[thread_index_in_simdgroup]], \
+      uint simd_group_id [[simdgroup_index_in_threadgroup]], \
+      uint3 tid [[threadgroup_position_in_grid]]);
+
+#define instantiate_sparse_2_4_gemv(iname, itype, max_rows) \
+  instantiate_kernel( \
+      "sparse_2_4_gemv_" #iname "_m" #max_rows, sparse_2_4_gemv, itype, max_rows)
+
+#define instantiate_sparse_2_4(iname, itype) \
+    instantiate_sparse_2_4_gemm(iname, itype, 32, 32, 32, 2, 2) \
+    instantiate_sparse_2_4_gemm(iname, itype, 64, 64, 32, 2, 2) \
+    instantiate_sparse_2_4_gemv(iname, itype, 1) \
+    instantiate_sparse_2_4_gemv(iname, itype, 8)
+
+instantiate_sparse_2_4(float16, half);
+instantiate_sparse_2_4(bfloat16, bfloat16_t);
+instantiate_sparse_2_4(float32, float);
+// clang-format on
@@ -198,6 +198,42 @@ struct BlockMMA {
     }
   }
 
+  /* Store the results in rows and columns [start, stop) of the tile */
+  METAL_FUNC void store_result_slice(
+      device U* D,
+      const int ldd,
+      short2 start,
+      short2 stop) const {
+    // Adjust for simdgroup and thread location
+    D += (sm + tm) * ldd + (tn + sn);
+    start -= short2(tn + sn, sm + tm);
+    stop -= short2(tn + sn, sm + tm);
+
+    if (stop.x <= 0 || stop.y <= 0)
+      return;
+
+    STEEL_PRAGMA_UNROLL
+    for (int i = 0; i < TM; i++) {
+      if (i * TM_stride >= start.y && i * TM_stride < stop.y) {
+        STEEL_PRAGMA_UNROLL
+        for (int j = 0; j < TN; j++) {
+          // Get accumulated result and associated offset in C
+          thread const auto& accum = results[i * TN + j].thread_elements();
+          int offset = (i * TM_stride) * ldd + (j * TN_stride);
+
+          // Apply epilogue and output C
+          if (j * TN_stride >= start.x && j * TN_stride < stop.x) {
+            D[offset] = Epilogue::apply(accum[0]);
+          }
+
+          if (j * TN_stride + 1 >= start.x && j * TN_stride + 1 < stop.x) {
+            D[offset + 1] = Epilogue::apply(accum[1]);
+          }
+        }
+      }
+    }
+  }
+
   /* Apply epilogue */
   template <typename UnaryEpilogue>
   METAL_FUNC void apply_epilogue(thread const UnaryEpilogue& epilogue_op) {
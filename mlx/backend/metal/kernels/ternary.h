@@ -10,7 +10,28 @@ template <typename T, typename Op>
   d[index] = Op()(a[index], b[index], c[index]);
 }
 
-template <typename T, typename Op>
+// Writes N consecutive elements per thread for large contiguous arrays
+template <typename T, typename Op, int N = ELEMWISE_N_WRITES>
+[[kernel]] void ternary_vn(
+    device const bool* a,
+    device const T* b,
+    device const T* c,
+    device T* d,
+    constant const size_t& size,
+    uint index [[thread_position_in_grid]]) {
+  size_t offset = size_t(index) * N;
+  if (offset + N <= size) {
+    for (int i = 0; i < N; i++) {
+      d[offset + i] = Op()(a[offset + i], b[offset + i], c[offset + i]);
+    }
+  } else {
+    for (size_t i = offset; i < size; i++) {
+      d[i] = Op()(a[i], b[i], c[i]);
+    }
+  }
+}
+
+template <typename T, typename Op, typename IdxT = int64_t>
 [[kernel]] void ternary_g_nd1(
     device const bool* a,
     device const T* b,
@@ -20,13 +41,13 @@ template <typename T, typename Op>
     constant const size_t& b_strides,
     constant const size_t& c_strides,
     uint index [[thread_position_in_grid]]) {
-  auto a_idx = elem_to_loc_1(index, a_strides);
-  auto b_idx = elem_to_loc_1(index, b_strides);
-  auto c_idx = elem_to_loc_1(index, c_strides);
+  auto a_idx = elem_to_loc_1<size_t, IdxT>(index, a_strides);
+  auto b_idx = elem_to_loc_1<size_t, IdxT>(index, b_strides);
+  auto c_idx = elem_to_loc_1<size_t, IdxT>(index, c_strides);
   d[index] = Op()(a[a_idx], b[b_idx], c[c_idx]);
 }
 
-template <typename T, typename Op>
+template <typename T, typename Op, typename IdxT = int64_t>
 [[kernel]] void ternary_g_nd2(
     device const bool* a,
     device const T* b,
@@ -37,14 +58,14 @@ template <typename T, typename Op>
     constant const size_t c_strides[2],
     uint2 index [[thread_position_in_grid]],
     uint2 grid_dim [[threads_per_grid]]) {
-  auto a_idx = elem_to_loc_2(index, a_strides);
-  auto b_idx = elem_to_loc_2(index, b_strides);
-  auto c_idx = elem_to_loc_2(index, c_strides);
-  size_t out_idx = index.x + (size_t)grid_dim.x * index.y;
+  auto a_idx = elem_to_loc_2<size_t, IdxT>(index, a_strides);
+  auto b_idx = elem_to_loc_2<size_t, IdxT>(index, b_strides);
+  auto c_idx = elem_to_loc_2<size_t, IdxT>(index, c_strides);
+  IdxT out_idx = index.x + IdxT(grid_dim.x) * index.y;
   d[out_idx] = Op()(a[a_idx], b[b_idx], c[c_idx]);
 }
 
-template <typename T, typename Op>
+template <typename T, typename Op, typename IdxT = int64_t>
 [[kernel]] void ternary_g_nd3(
     device const bool* a,
     device const T* b,
@@ -55,15 +76,22 @@ template <typename T, typename Op>
     constant const size_t c_strides[3],
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto a_idx = elem_to_loc_3(index, a_strides);
-  auto b_idx = elem_to_loc_3(index, b_strides);
-  auto c_idx = elem_to_loc_3(index, c_strides);
-  size_t out_idx =
-      index.x + (size_t)grid_dim.x * (index.y + (size_t)grid_dim.y * index.z);
+  auto a_idx = elem_to_loc_3<size_t, IdxT>(index, a_strides);
+  auto b_idx = elem_to_loc_3<size_t, IdxT>(index, b_strides);
+  auto c_idx = elem_to_loc_3<size_t, IdxT>(index, c_strides);
+  IdxT out_idx =
+      index.x + IdxT(grid_dim.x) * (index.y + IdxT(grid_dim.y) * index.z);
   d[out_idx] = Op()(a[a_idx], b[b_idx], c[c_idx]);
 }
 
-template <typename T, typename Op, int DIM>
+// Each thread handles N elements of the inner dim so the divisions for the
+// location of the outer dims are done once
+template <
+    typename T,
+    typename Op,
+    int DIM,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void ternary_g_nd(
     device const bool* a,
     device const T* b,
@@ -75,14 +103,31 @@ template <typename T, typename Op, int DIM>
     constant const size_t c_strides[DIM],
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto idx =
-      elem_to_loc_3_nd<DIM>(index, shape, a_strides, b_strides, c_strides);
-  size_t out_idx =
-      index.x + (size_t)grid_dim.x * (index.y + (size_t)grid_dim.y * index.z);
-  d[out_idx] = Op()(a[idx.x], b[idx.y], c[idx.z]);
+  auto idx = elem_to_loc_3_nd<DIM, IdxT>(
+      uint3(N * index.x, index.y, index.z),
+      shape,
+      a_strides,
+      b_strides,
+      c_strides);
+  int xshape = shape[DIM - 1];
+  IdxT out_idx = N * index.x +
+      IdxT(xshape) * (index.y + IdxT(grid_dim.y) * index.z);
+  IdxT a_xstride = a_strides[DIM - 1];
+  IdxT b_xstride = b_strides[DIM - 1];
+  IdxT c_xstride = c_strides[DIM - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    d[out_idx++] = Op()(a[idx.x], b[idx.y], c[idx.z]);
+    idx.x += a_xstride;
+    idx.y += b_xstride;
+    idx.z += c_xstride;
+  }
 }
 
-template <typename T, typename Op>
+template <
+    typename T,
+    typename Op,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
 [[kernel]] void ternary_g(
     device const bool* a,
     device const T* b,
@@ -95,8 +140,23 @@ template <typename T, typename Op>
     constant const int& ndim,
     uint3 index [[thread_position_in_grid]],
     uint3 grid_dim [[threads_per_grid]]) {
-  auto idx =
-      elem_to_loc_3_nd(index, shape, a_strides, b_strides, c_strides, ndim);
-  size_t out_idx = index.x + grid_dim.x * (index.y + grid_dim.y * index.z);
-  d[out_idx] = Op()(a[idx.x], b[idx.y], c[idx.z]);
+  auto idx = elem_to_loc_3_nd<IdxT>(
+      uint3(N * index.x, index.y, index.z),
+      shape,
+      a_strides,
+      b_strides,
+      c_strides,
+      ndim);
+  int xshape = shape[ndim - 1];
+  IdxT out_idx = N * index.x +
+      IdxT(xshape) * (index.y + IdxT(grid_dim.y) * index.z);
+  IdxT a_xstride = a_strides[ndim - 1];
+  IdxT b_xstride = b_strides[ndim - 1];
+  IdxT c_xstride = c_strides[ndim - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    d[out_idx++] = Op()(a[idx.x], b[idx.y], c[idx.z]);
+    idx.x += a_xstride;
+    idx.y += b_xstride;
+    idx.z += c_xstride;
+  }
 }
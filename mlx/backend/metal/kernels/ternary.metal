@@ -9,14 +9,20 @@
 #include "mlx/backend/metal/kernels/ternary_ops.h"
 #include "mlx/backend/metal/kernels/ternary.h"
 
-#define instantiate_ternary_all(op, tname, type)                  \
-  instantiate_kernel("v_" #op #tname, ternary_v, type, op)        \
-  instantiate_kernel("g_" #op #tname, ternary_g, type, op)        \
-  instantiate_kernel("g1_" #op #tname, ternary_g_nd1, type, op)   \
-  instantiate_kernel("g2_" #op #tname, ternary_g_nd2, type, op)   \
-  instantiate_kernel("g3_" #op #tname, ternary_g_nd3, type, op)   \
-  instantiate_kernel("g4_" #op #tname, ternary_g_nd, type, op, 4) \
-  instantiate_kernel("g5_" #op #tname, ternary_g_nd, type, op, 5)
+// The general kernels index with int or, for large arrays, int64_t
+#define instantiate_ternary_general(op, tname, type, lg, idx)                 \
+  instantiate_kernel("g" #lg "_" #op #tname, ternary_g, type, op, idx)        \
+  instantiate_kernel("g1" #lg "_" #op #tname, ternary_g_nd1, type, op, idx)   \
+  instantiate_kernel("g2" #lg "_" #op #tname, ternary_g_nd2, type, op, idx)   \
+  instantiate_kernel("g3" #lg "_" #op #tname, ternary_g_nd3, type, op, idx)   \
+  instantiate_kernel("g4" #lg "_" #op #tname, ternary_g_nd, type, op, 4, idx) \
+  instantiate_kernel("g5" #lg "_" #op #tname, ternary_g_nd, type, op, 5, idx)
+
+#define instantiate_ternary_all(op, tname, type)             \
+  instantiate_kernel("v_" #op #tname, ternary_v, type, op)   \
+  instantiate_kernel("vn_" #op #tname, ternary_vn, type, op) \
+  instantiate_ternary_general(op, tname, type, , int)        \
+  instantiate_ternary_general(op, tname, type, large, int64_t)
 
 #define instantiate_ternary_types(op)               \
   instantiate_ternary_all(op, bool_, bool)          \
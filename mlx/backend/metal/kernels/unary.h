@@ -8,14 +8,48 @@ template <typename T, typename Op>
   out[index] = Op()(in[index]);
 }
 
-template <typename T, typename Op>
-[[kernel]] void unary_g(
+// Writes N consecutive elements per thread for large contiguous arrays
+template <typename T, typename Op, int N = ELEMWISE_N_WRITES>
+[[kernel]] void unary_vn(
     device const T* in,
     device T* out,
-    device const int* in_shape,
-    device const size_t* in_strides,
-    device const int& ndim,
+    constant const size_t& size,
     uint index [[thread_position_in_grid]]) {
-  auto idx = elem_to_loc(index, in_shape, in_strides, ndim);
-  out[index] = Op()(in[idx]);
+  size_t offset = size_t(index) * N;
+  if (offset + N <= size) {
+    for (int i = 0; i < N; i++) {
+      out[offset + i] = Op()(in[offset + i]);
+    }
+  } else {
+    for (size_t i = offset; i < size; i++) {
+      out[i] = Op()(in[i]);
+    }
+  }
+}
+
+// The general kernel expects the dims to be collapsed to at least 2 and each
+// thread handles N elements of the inner dim
+template <
+    typename T,
+    typename Op,
+    typename IdxT = int64_t,
+    int N = ELEMWISE_N_WRITES>
+[[kernel]] void unary_g(
+    device const T* in,
+    device T* out,
+    constant const int* in_shape,
+    constant const size_t* in_strides,
+    constant const int& ndim,
+    uint3 index [[thread_position_in_grid]],
+    uint3 grid_dim [[threads_per_grid]]) {
+  auto idx = elem_to_loc<size_t, IdxT>(
+      uint3(N * index.x, index.y, index.z), in_shape, in_strides, ndim);
+  int xshape = in_shape[ndim - 1];
+  IdxT out_idx = N * index.x +
+      IdxT(xshape) * (index.y + IdxT(grid_dim.y) * index.z);
+  IdxT xstride = in_strides[ndim - 1];
+  for (int i = N * index.x; i < min(N * int(index.x + 1), xshape); i++) {
+    out[out_idx++] = Op()(in[idx]);
+    idx += xstride;
+  }
 }
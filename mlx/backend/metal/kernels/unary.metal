@@ -5,9 +5,11 @@
 #include "mlx/backend/metal/kernels/unary_ops.h"
 #include "mlx/backend/metal/kernels/unary.h"
 
-#define instantiate_unary_all(op, tname, type)          \
-  instantiate_kernel("v" #op #tname, unary_v, type, op) \
-  instantiate_kernel("g" #op #tname, unary_g, type, op)
+#define instantiate_unary_all(op, tname, type)               \
+  instantiate_kernel("v" #op #tname, unary_v, type, op)      \
+  instantiate_kernel("vn" #op #tname, unary_vn, type, op)    \
+  instantiate_kernel("g" #op #tname, unary_g, type, op, int) \
+  instantiate_kernel("glarge" #op #tname, unary_g, type, op)
 
 #define instantiate_unary_float(op)               \
   instantiate_unary_all(op, float16, half)        \
@@ -102,15 +102,16 @@ METAL_FUNC stride_t elem_to_loc(
 }
 
 // Non templated version to handle arbitrary dims
-template <typename stride_t>
-METAL_FUNC stride_t elem_to_loc(
+template <typename stride_t, typename IdxT = stride_t>
+METAL_FUNC IdxT elem_to_loc(
     uint3 elem,
     constant const int* shape,
     constant const stride_t* strides,
     int ndim) {
-  stride_t loc = elem.x * strides[ndim - 1] + elem.y * strides[ndim - 2];
+  IdxT loc = IdxT(elem.x) * IdxT(strides[ndim - 1]) +
+      IdxT(elem.y) * IdxT(strides[ndim - 2]);
   for (int d = ndim - 3; d >= 0; --d) {
-    loc += (elem.z % shape[d]) * strides[d];
+    loc += IdxT(elem.z % shape[d]) * IdxT(strides[d]);
     elem.z /= shape[d];
   }
   return loc;
@@ -118,22 +119,24 @@ METAL_FUNC stride_t elem_to_loc(
 
 ///////////////////////////////////////////////////////////////////////////////
 // Single Array with fixed N dims
+//
+// The locations are computed in IdxT, which the kernels set to int when all
+// the arrays fit in 32 bit indices and to int64_t otherwise.
 
-template <typename stride_t>
-METAL_FUNC stride_t elem_to_loc_1(uint elem, constant const stride_t& stride) {
-  return elem * stride;
+template <typename stride_t, typename IdxT = stride_t>
+METAL_FUNC IdxT elem_to_loc_1(uint elem, constant const stride_t& stride) {
+  return IdxT(elem) * IdxT(stride);
 }
 
-template <typename stride_t>
-METAL_FUNC stride_t
-elem_to_loc_2(uint2 elem, constant const stride_t strides[2]) {
-  return elem.x * strides[1] + elem.y * strides[0];
+template <typename stride_t, typename IdxT = stride_t>
+METAL_FUNC IdxT elem_to_loc_2(uint2 elem, constant const stride_t strides[2]) {
+  return IdxT(elem.x) * IdxT(strides[1]) + IdxT(elem.y) * IdxT(strides[0]);
 }
 
-template <typename stride_t>
-METAL_FUNC stride_t
-elem_to_loc_3(uint3 elem, constant const stride_t strides[3]) {
-  return elem.x * strides[2] + elem.y * strides[1] + elem.z * strides[0];
+template <typename stride_t, typename IdxT = stride_t>
+METAL_FUNC IdxT elem_to_loc_3(uint3 elem, constant const stride_t strides[3]) {
+  return IdxT(elem.x) * IdxT(strides[2]) + IdxT(elem.y) * IdxT(strides[1]) +
+      IdxT(elem.z) * IdxT(strides[0]);
 }
 
 template <int NDIM>
@@ -152,19 +155,6 @@ METAL_FUNC size_t elem_to_loc_nd(
   return loc;
 }
 
-template <int NDIM>
-METAL_FUNC size_t elem_to_loc_nd(
-    uint3 elem,
-    constant const int shape[NDIM],
-    constant const size_t strides[NDIM]) {
-  size_t loc = elem.x * strides[NDIM - 1] + elem.y * strides[NDIM - 2];
-  for (int d = NDIM - 3; d >= 0; --d) {
-    loc += (elem.z % shape[d]) * strides[d];
-    elem.z /= shape[d];
-  }
-  return loc;
-}
-
 template <int NDIM>
 METAL_FUNC int64_t elem_to_loc_nd(
     uint elem,
@@ -181,14 +171,15 @@ METAL_FUNC int64_t elem_to_loc_nd(
   return loc;
 }
 
-template <int NDIM>
-METAL_FUNC int64_t elem_to_loc_nd(
+template <int NDIM, typename stride_t, typename IdxT = stride_t>
+METAL_FUNC IdxT elem_to_loc_nd(
     uint3 elem,
     constant const int shape[NDIM],
-    constant const int64_t strides[NDIM]) {
-  int64_t loc = elem.x * strides[NDIM - 1] + elem.y * strides[NDIM - 2];
+    constant const stride_t strides[NDIM]) {
+  IdxT loc = IdxT(elem.x) * IdxT(strides[NDIM - 1]) +
+      IdxT(elem.y) * IdxT(strides[NDIM - 2]);
   for (int d = NDIM - 3; d >= 0; --d) {
-    loc += (elem.z % shape[d]) * strides[d];
+    loc += IdxT(elem.z % shape[d]) * IdxT(strides[d]);
     elem.z /= shape[d];
   }
   return loc;
@@ -197,45 +188,47 @@ METAL_FUNC int64_t elem_to_loc_nd(
 ///////////////////////////////////////////////////////////////////////////////
 // Multiple Arrays with generic dims
 
-METAL_FUNC uint2 elem_to_loc_2_nd(
+template <typename IdxT>
+METAL_FUNC vec<IdxT, 2> elem_to_loc_2_nd(
     uint3 elem,
     constant const int* shape,
     constant const size_t* a_strides,
     constant const size_t* b_strides,
     int ndim) {
-  uint2 loc = {
-      static_cast<uint>(
-          elem.x * a_strides[ndim - 1] + elem.y * a_strides[ndim - 2]),
-      static_cast<uint>(
-          elem.x * b_strides[ndim - 1] + elem.y * b_strides[ndim - 2])};
+  vec<IdxT, 2> loc = {
+      IdxT(elem.x) * IdxT(a_strides[ndim - 1]) +
+          IdxT(elem.y) * IdxT(a_strides[ndim - 2]),
+      IdxT(elem.x) * IdxT(b_strides[ndim - 1]) +
+          IdxT(elem.y) * IdxT(b_strides[ndim - 2])};
   for (int d = ndim - 3; d >= 0; --d) {
-    uint l = elem.z % shape[d];
-    loc.x += l * a_strides[d];
-    loc.y += l * b_strides[d];
+    IdxT l = elem.z % shape[d];
+    loc.x += l * IdxT(a_strides[d]);
+    loc.y += l * IdxT(b_strides[d]);
     elem.z /= shape[d];
   }
   return loc;
 }
 
-METAL_FUNC uint3 elem_to_loc_3_nd(
+template <typename IdxT>
+METAL_FUNC vec<IdxT, 3> elem_to_loc_3_nd(
     uint3 elem,
     constant const int* shape,
     constant const size_t* a_strides,
     constant const size_t* b_strides,
     constant const size_t* c_strides,
     int ndim) {
-  uint3 loc = {
-      static_cast<uint>(
-          elem.x * a_strides[ndim - 1] + elem.y * a_strides[ndim - 2]),
-      static_cast<uint>(
-          elem.x * b_strides[ndim - 1] + elem.y * b_strides[ndim - 2]),
-      static_cast<uint>(
-          elem.x * c_strides[ndim - 1] + elem.y * c_strides[ndim - 2])};
+  vec<IdxT, 3> loc = {
+      IdxT(elem.x) * IdxT(a_strides[ndim - 1]) +
+          IdxT(elem.y) * IdxT(a_strides[ndim - 2]),
+      IdxT(elem.x) * IdxT(b_strides[ndim - 1]) +
+          IdxT(elem.y) * IdxT(b_strides[ndim - 2]),
+      IdxT(elem.x) * IdxT(c_strides[ndim - 1]) +
+          IdxT(elem.y) * IdxT(c_strides[ndim - 2])};
   for (int d = ndim - 3; d >= 0; --d) {
-    uint l = elem.z % shape[d];
-    loc.x += l * a_strides[d];
-    loc.y += l * b_strides[d];
-    loc.z += l * c_strides[d];
+    IdxT l = elem.z % shape[d];
+    loc.x += l * IdxT(a_strides[d]);
+    loc.y += l * IdxT(b_strides[d]);
+    loc.z += l * IdxT(c_strides[d]);
     elem.z /= shape[d];
   }
   return loc;
@@ -244,45 +237,45 @@ METAL_FUNC uint3 elem_to_loc_3_nd(
 ///////////////////////////////////////////////////////////////////////////////
 // Multiple Arrays with fixed N dims
 
-template <int NDIM>
-METAL_FUNC uint2 elem_to_loc_2_nd(
+template <int NDIM, typename IdxT>
+METAL_FUNC vec<IdxT, 2> elem_to_loc_2_nd(
     uint3 elem,
     constant const int shape[NDIM],
     constant const size_t a_strides[NDIM],
     constant const size_t b_strides[NDIM]) {
-  uint2 loc = {
-      static_cast<uint>(
-          elem.x * a_strides[NDIM - 1] + elem.y * a_strides[NDIM - 2]),
-      static_cast<uint>(
-          elem.x * b_strides[NDIM - 1] + elem.y * b_strides[NDIM - 2])};
+  vec<IdxT, 2> loc = {
+      IdxT(elem.x) * IdxT(a_strides[NDIM - 1]) +
+          IdxT(elem.y) * IdxT(a_strides[NDIM - 2]),
+      IdxT(elem.x) * IdxT(b_strides[NDIM - 1]) +
+          IdxT(elem.y) * IdxT(b_strides[NDIM - 2])};
   for (int d = NDIM - 3; d >= 0; --d) {
-    uint l = elem.z % shape[d];
-    loc.x += l * a_strides[d];
-    loc.y += l * b_strides[d];
+    IdxT l = elem.z % shape[d];
+    loc.x += l * IdxT(a_strides[d]);
+    loc.y += l * IdxT(b_strides[d]);
     elem.z /= shape[d];
   }
   return loc;
 }
 
-template <int NDIM>
-METAL_FUNC uint3 elem_to_loc_3_nd(
+template <int NDIM, typename IdxT>
+METAL_FUNC vec<IdxT, 3> elem_to_loc_3_nd(
     uint3 elem,
     constant const int shape[NDIM],
     constant const size_t a_strides[NDIM],
     constant const size_t b_strides[NDIM],
     constant const size_t c_strides[NDIM]) {
-  uint3 loc = {
-      static_cast<uint>(
-          elem.x * a_strides[NDIM - 1] + elem.y * a_strides[NDIM - 2]),
-      static_cast<uint>(
-          elem.x * b_strides[NDIM - 1] + elem.y * b_strides[NDIM - 2]),
-      static_cast<uint>(
-          elem.x * c_strides[NDIM - 1] + elem.y * c_strides[NDIM - 2])};
+  vec<IdxT, 3> loc = {
+      IdxT(elem.x) * IdxT(a_strides[NDIM - 1]) +
+          IdxT(elem.y) * IdxT(a_strides[NDIM - 2]),
+      IdxT(elem.x) * IdxT(b_strides[NDIM - 1]) +
+          IdxT(elem.y) * IdxT(b_strides[NDIM - 2]),
+      IdxT(elem.x) * IdxT(c_strides[NDIM - 1]) +
+          IdxT(elem.y) * IdxT(c_strides[NDIM - 2])};
   for (int d = NDIM - 3; d >= 0; --d) {
-    uint l = elem.z % shape[d];
-    loc.x += l * a_strides[d];
-    loc.y += l * b_strides[d];
-    loc.z += l * c_strides[d];
+    IdxT l = elem.z % shape[d];
+    loc.x += l * IdxT(a_strides[d]);
+    loc.y += l * IdxT(b_strides[d]);
+    loc.z += l * IdxT(c_strides[d]);
     elem.z /= shape[d];
   }
   return loc;
@@ -0,0 +1,78 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <metal_simdgroup>
+
+// Running count, mean and sum of squared deviations from the mean
+struct Welford {
+  float n = 0;
+  float mean = 0;
+  float m2 = 0;
+
+  METAL_FUNC void update(float x) {
+    n += 1;
+    float delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+  }
+
+  // Chan et al. parallel combination
+  METAL_FUNC void combine(float n_b, float mean_b, float m2_b) {
+    float n_ab = n + n_b;
+    if (n_ab == 0) {
+      return;
+    }
+    float delta = mean_b - mean;
+    mean += delta * n_b / n_ab;
+    m2 += m2_b + delta * delta * n * n_b / n_ab;
+    n = n_ab;
+  }
+
+  METAL_FUNC void simd_combine() {
+    for (ushort offset = 16; offset > 0; offset /= 2) {
+      float n_b = metal::simd_shuffle_down(n, offset);
+      float mean_b = metal::simd_shuffle_down(mean, offset);
+      float m2_b = metal::simd_shuffle_down(m2, offset);
+      combine(n_b, mean_b, m2_b);
+    }
+  }
+
+  // Combines the accumulators of the whole threadgroup and broadcasts the
+  // result to every thread. The scratch arrays hold one float per simdgroup.
+  METAL_FUNC void threadgroup_combine(
+      threadgroup float* local_n,
+      threadgroup float* local_mean,
+      threadgroup float* local_m2,
+      uint simd_lane_id,
+      uint simd_group_id) {
+    simd_combine();
+    if (simd_group_id == 0) {
+      local_n[simd_lane_id] = 0;
+      local_mean[simd_lane_id] = 0;
+      local_m2[simd_lane_id] = 0;
+    }
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+    if (simd_lane_id == 0) {
+      local_n[simd_group_id] = n;
+      local_mean[simd_group_id] = mean;
+      local_m2[simd_group_id] = m2;
+    }
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+    if (simd_group_id == 0) {
+      n = local_n[simd_lane_id];
+      mean = local_mean[simd_lane_id];
+      m2 = local_m2[simd_lane_id];
+      simd_combine();
+      if (simd_lane_id == 0) {
+        local_n[0] = n;
+        local_mean[0] = mean;
+        local_m2[0] = m2;
+      }
+    }
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+    n = local_n[0];
+    mean = local_mean[0];
+    m2 = local_m2[0];
+  }
+};
@@ -0,0 +1,308 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// One threadgroup per matrix with a thread per row, rounded up to the simd
+// size.
+MTL::Size linalg_group_dims(int N, MTL::ComputePipelineState* kernel) {
+  size_t simd_size = 32;
+  size_t n_threads = (N + simd_size - 1) / simd_size * simd_size;
+  return MTL::Size(
+      std::min<size_t>(n_threads, kernel->maxTotalThreadsPerThreadgroup()),
+      1,
+      1);
+}
+
+// Make sure that the matrices are contiguous
+const array& ensure_row_contiguous(
+    const array& x,
+    std::vector<array>& copies,
+    const Stream& s) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+  copy_gpu(x, copies.back(), CopyType::General, s);
+  return copies.back();
+}
+
+// Device memory used by the kernels in place of threadgroup memory so that
+// the size of the matrices is not limited
+array linalg_scratch(size_t size) {
+  array scratch({static_cast<int>(size)}, float32, nullptr, {});
+  scratch.set_data(allocator::malloc_or_wait(scratch.nbytes()));
+  return scratch;
+}
+
+} // namespace
+
+void Inverse::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+  auto& in = inputs[0];
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  // The elimination happens in a contiguous copy of the input
+  std::vector<array> copies = {array(in.shape(), in.dtype(), nullptr, {})};
+  array& a = copies.back();
+  copy_gpu(
+      in,
+      a,
+      in.flags().row_contiguous ? CopyType::Vector : CopyType::General,
+      s);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  int N = in.shape(-1);
+  size_t num_matrices = in.size() / (N * N);
+  if (num_matrices > 0) {
+    auto kernel = d.get_kernel("inverse");
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_output_array(a, 0);
+    compute_encoder.set_output_array(out, 1);
+    compute_encoder->setBytes(&N, sizeof(int), 2);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(num_matrices, 1, 1), linalg_group_dims(N, kernel));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void Solve::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto& a_in = inputs[0];
+  auto& b = inputs[1];
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  // The elimination happens in a contiguous copy of a and in the output
+  std::vector<array> copies = {array(a_in.shape(), a_in.dtype(), nullptr, {})};
+  array& a = copies.back();
+  copy_gpu(
+      a_in,
+      a,
+      a_in.flags().row_contiguous ? CopyType::Vector : CopyType::General,
+      s);
+  copy_gpu(
+      b,
+      out,
+      b.flags().row_contiguous ? CopyType::Vector : CopyType::General,
+      s);
+
+  int N = a.shape(-1);
+  int K = out.shape(-1);
+  size_t num_matrices = (N > 0 && K > 0) ? out.size() / (N * K) : 0;
+  if (num_matrices > 0) {
+    auto kernel = d.get_kernel("solve");
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_output_array(a, 0);
+    compute_encoder.set_output_array(out, 1);
+    compute_encoder->setBytes(&N, sizeof(int), 2);
+    compute_encoder->setBytes(&K, sizeof(int), 3);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(num_matrices, 1, 1),
+        linalg_group_dims(std::max(N, K), kernel));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void Cholesky::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  // Make sure that the matrices are contiguous
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  const array& in = check_input(inputs[0]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  int N = in.shape(-1);
+  size_t num_matrices = in.size() / (N * N);
+  if (num_matrices > 0) {
+    auto kernel = d.get_kernel("cholesky");
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(in, 0);
+    compute_encoder.set_output_array(out, 1);
+    compute_encoder->setBytes(&N, sizeof(int), 2);
+    compute_encoder->setBytes(&upper_, sizeof(bool), 3);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(num_matrices, 1, 1), linalg_group_dims(N, kernel));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace mlx::core
+
+void QRF::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  copies.reserve(2);
+  const array& in = ensure_row_contiguous(inputs[0], copies, s);
+  auto& q = outputs[0];
+  auto& r = outputs[1];
+  q.set_data(allocator::malloc_or_wait(q.nbytes()));
+  r.set_data(allocator::malloc_or_wait(r.nbytes()));
+
+  int N = in.shape(-1);
+  size_t num_matrices = N > 0 ? in.size() / (N * N) : 0;
+  if (num_matrices > 0) {
+    copies.push_back(linalg_scratch(num_matrices * N));
+    auto kernel = d.get_kernel("qr");
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(in, 0);
+    compute_encoder.set_output_array(q, 1);
+    compute_encoder.set_output_array(r, 2);
+    compute_encoder.set_output_array(copies.back(), 3);
+    compute_encoder->setBytes(&N, sizeof(int), 4);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(num_matrices, 1, 1), linalg_group_dims(N, kernel));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void SVD::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  copies.reserve(2);
+  const array& in = ensure_row_contiguous(inputs[0], copies, s);
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+
+  int M = in.shape(-2);
+  int N = in.shape(-1);
+  size_t m = std::max(M, N);
+  size_t n = std::min(M, N);
+  size_t num_matrices = n > 0 ? in.size() / (M * N) : 0;
+  if (num_matrices > 0) {
+    size_t scratch_size = m * n + m * m + n * n + m;
+    copies.push_back(linalg_scratch(num_matrices * scratch_size));
+    auto kernel = d.get_kernel("svd");
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(in, 0);
+    compute_encoder.set_output_array(outputs[0], 1);
+    compute_encoder.set_output_array(outputs[1], 2);
+    compute_encoder.set_output_array(outputs[2], 3);
+    compute_encoder.set_output_array(copies.back(), 4);
+    compute_encoder->setBytes(&M, sizeof(int), 5);
+    compute_encoder->setBytes(&N, sizeof(int), 6);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(num_matrices, 1, 1), linalg_group_dims(m, kernel));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void Eigh::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  copies.reserve(2);
+  const array& in = ensure_row_contiguous(inputs[0], copies, s);
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+
+  int N = in.shape(-1);
+  size_t num_matrices = N > 0 ? in.size() / (N * N) : 0;
+  if (num_matrices > 0) {
+    copies.push_back(linalg_scratch(num_matrices * (N * N + N + 1)));
+    bool upper = uplo_ == 'U';
+    auto kernel = d.get_kernel("eigh");
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(in, 0);
+    compute_encoder.set_output_array(outputs[0], 1);
+    // Without eigenvectors the kernel never touches buffer 2
+    compute_encoder.set_output_array(
+        compute_eigenvectors_ ? outputs[1] : outputs[0], 2);
+    compute_encoder.set_output_array(copies.back(), 3);
+    compute_encoder->setBytes(&N, sizeof(int), 4);
+    compute_encoder->setBytes(&upper, sizeof(bool), 5);
+    compute_encoder->setBytes(&compute_eigenvectors_, sizeof(bool), 6);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(num_matrices, 1, 1), linalg_group_dims(N, kernel));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void SolveTriangular::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  copies.reserve(2);
+  const array& a = ensure_row_contiguous(inputs[0], copies, s);
+  const array& b = ensure_row_contiguous(inputs[1], copies, s);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  // A simdgroup per column of b with a few columns per threadgroup
+  int N = a.shape(-1);
+  int K = out.shape(-1);
+  size_t num_matrices = (N > 0 && K > 0) ? out.size() / (N * K) : 0;
+  if (num_matrices > 0) {
+    int n_cols = std::min(K, 4);
+    auto kernel = d.get_kernel("solve_triangular");
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(a, 0);
+    compute_encoder.set_input_array(b, 1);
+    compute_encoder.set_output_array(out, 2);
+    compute_encoder->setBytes(&N, sizeof(int), 3);
+    compute_encoder->setBytes(&K, sizeof(int), 4);
+    compute_encoder->setBytes(&upper_, sizeof(bool), 5);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size((K + n_cols - 1) / n_cols, num_matrices, 1),
+        MTL::Size(32, n_cols, 1));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
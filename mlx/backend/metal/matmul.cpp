@@ -3,8 +3,10 @@
 #include <algorithm>
 #include <cassert>
 #include <numeric>
+#include <optional>
 #include <sstream>
 
+#include "mlx/backend/metal/autotune.h"
 #include "mlx/backend/metal/copy.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
@@ -24,26 +26,40 @@ namespace mlx::core {
 
 namespace {
 
-bool use_mps() {
-  auto get_val = []() {
+// MLX_USE_MPS=OFF runs every gemm with steel and any other value with MPS.
+// When it isn't set each class of shapes picks the faster of the two.
+std::optional<bool> use_mps() {
+  auto get_val = []() -> std::optional<bool> {
     if (const char* buff_str = std::getenv("MLX_USE_MPS")) {
       return std::string(buff_str) != "OFF";
     } else {
-      return false;
+      return std::nullopt;
     }
   };
-  static bool use_mps_ = get_val();
+  static std::optional<bool> use_mps_ = get_val();
   return use_mps_;
 }
 
 #define MAX_OPS_PER_BUFFER max_ops_per_buffer()
 
-inline void mps_matmul(
-    const Stream& s,
-    metal::Device& d,
+// Offset in bytes of the data of a in its buffer
+size_t buffer_offset(const array& a) {
+  auto buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
+  return a.data<char>() -
+      static_cast<char*>(const_cast<MTL::Buffer*>(buf)->contents());
+}
+
+// Encodes a @ b with MPSMatrixMultiplication into out_buf, which holds an
+// array like out starting at out_offset. The MPS objects are released once
+// the command buffer completes.
+void encode_mps_matmul(
+    MTL::Device* device,
+    MTL::CommandBuffer* command_buffer,
     const array& a,
     const array& b,
-    array& out,
+    const array& out,
+    MTL::Buffer* out_buf,
+    size_t out_offset,
     int M,
     int N,
     int K,
@@ -52,9 +68,8 @@ inline void mps_matmul(
     int ldb,
     bool transpose_a,
     bool transpose_b,
-    std::vector<array>& copies,
-    float alpha = 1.0f,
-    float beta = 0.0f) {
+    float alpha,
+    float beta) {
   MPS::DataType mps_dtype = MPS::DataTypeFloat32;
 
   if (out.dtype() == float16) {
@@ -63,6 +78,9 @@ inline void mps_matmul(
     mps_dtype = MPS::DataTypeBFloat16;
   }
 
+  auto a_buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
+  auto b_buf = static_cast<const MTL::Buffer*>(b.buffer().ptr());
+
   // Used batched MPSMatrixMultiplication if batch_size_out > 1
   // We only accept the following cases:
   //  1. Both a, b have batch_size_out matrices worth of data
@@ -119,30 +137,25 @@ inline void mps_matmul(
             matrix_stride_out * out.itemsize(),
             mps_dtype);
 
-        auto a_buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
-        auto a_mat = MPS::Matrix::alloc()->init(a_buf, a_desc);
-
-        auto b_buf = static_cast<const MTL::Buffer*>(b.buffer().ptr());
-        auto b_mat = MPS::Matrix::alloc()->init(b_buf, b_desc);
-
-        auto out_buf = static_cast<MTL::Buffer*>(out.buffer().ptr());
-        auto out_mat = MPS::Matrix::alloc()->init(out_buf, out_desc);
+        auto a_mat =
+            MPS::Matrix::alloc()->init(a_buf, buffer_offset(a), a_desc);
+        auto b_mat =
+            MPS::Matrix::alloc()->init(b_buf, buffer_offset(b), b_desc);
+        auto out_mat =
+            MPS::Matrix::alloc()->init(out_buf, out_offset, out_desc);
 
         auto kernel = MPS::MatrixMultiplication::alloc()->init(
-            d.mtl_device(), transpose_a, transpose_b, M, N, K, alpha, beta);
+            device, transpose_a, transpose_b, M, N, K, alpha, beta);
 
-        auto command_buffer = d.get_command_buffer(s.index);
         kernel->setBatchSize(batch_size_out);
         kernel->setBatchStart(0);
         kernel->encodeToCommandBuffer(command_buffer, a_mat, b_mat, out_mat);
         command_buffer->addCompletedHandler(
-            [a_mat, b_mat, out_mat, kernel, copies](
-                MTL::CommandBuffer*) mutable {
+            [a_mat, b_mat, out_mat, kernel](MTL::CommandBuffer*) {
               a_mat->release();
               b_mat->release();
               out_mat->release();
               kernel->release();
-              copies.clear();
             });
 
         return;
@@ -160,19 +173,13 @@ inline void mps_matmul(
   auto out_desc = MPS::MatrixDescriptor::matrixDescriptor(
       batch_size_out * M, N, N * out.itemsize(), mps_dtype);
 
-  auto a_buf = static_cast<const MTL::Buffer*>(a.buffer().ptr());
-  auto a_mat = MPS::Matrix::alloc()->init(a_buf, a_desc);
-
-  auto b_buf = static_cast<const MTL::Buffer*>(b.buffer().ptr());
-  auto b_mat = MPS::Matrix::alloc()->init(b_buf, b_desc);
-
-  auto out_buf = static_cast<MTL::Buffer*>(out.buffer().ptr());
-  auto out_mat = MPS::Matrix::alloc()->init(out_buf, out_desc);
+  auto a_mat = MPS::Matrix::alloc()->init(a_buf, buffer_offset(a), a_desc);
+  auto b_mat = MPS::Matrix::alloc()->init(b_buf, buffer_offset(b), b_desc);
+  auto out_mat = MPS::Matrix::alloc()->init(out_buf, out_offset, out_desc);
 
   auto kernel = MPS::MatrixMultiplication::alloc()->init(
-      d.mtl_device(), transpose_a, transpose_b, M, N, K, alpha, beta);
+      device, transpose_a, transpose_b, M, N, K, alpha, beta);
 
-  auto command_buffer = d.get_command_buffer(s.index);
   for (int i = 0; i < batch_size_out; ++i) {
     auto a_row = elem_to_loc(M * K * i, a.shape(), a.strides()) / lda;
     auto b_row = elem_to_loc(K * N * i, b.shape(), b.strides()) / ldb;
@@ -183,15 +190,54 @@ inline void mps_matmul(
   }
 
   command_buffer->addCompletedHandler(
-      [a_mat, b_mat, out_mat, kernel, copies](MTL::CommandBuffer*) mutable {
+      [a_mat, b_mat, out_mat, kernel](MTL::CommandBuffer*) {
         a_mat->release();
         b_mat->release();
         out_mat->release();
         kernel->release();
-        copies.clear();
       });
 }
 
+inline void mps_matmul(
+    const Stream& s,
+    metal::Device& d,
+    const array& a,
+    const array& b,
+    array& out,
+    int M,
+    int N,
+    int K,
+    int batch_size_out,
+    int lda,
+    int ldb,
+    bool transpose_a,
+    bool transpose_b,
+    std::vector<array>& copies,
+    float alpha = 1.0f,
+    float beta = 0.0f) {
+  auto command_buffer = d.get_command_buffer(s.index);
+  encode_mps_matmul(
+      d.mtl_device(),
+      command_buffer,
+      a,
+      b,
+      out,
+      static_cast<MTL::Buffer*>(out.buffer().ptr()),
+      buffer_offset(out),
+      M,
+      N,
+      K,
+      batch_size_out,
+      lda,
+      ldb,
+      transpose_a,
+      transpose_b,
+      alpha,
+      beta);
+  command_buffer->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
 inline auto collapse_batches(const array& a, const array& b) {
   // Get and check the shape for the batched dims
   std::vector<int> A_bshape{a.shape().begin(), a.shape().end() - 2};
@@ -257,10 +303,88 @@ inline auto collapse_batches(const array& a, const array& b, const array& c) {
 
 } // namespace
 
+int steel_gemm_target_threadgroups(metal::Device& d) {
+  switch (d.get_architecture_class()) {
+    case 'p': // phone and tablet
+      return 128;
+    case 's': // max
+      return 640;
+    case 'd': // ultra
+      return 1280;
+    case 'g': // base and pro
+    default:
+      return 320;
+  }
+}
+
+namespace {
+
+// Number of partitions of K for the split K gemm, 1 if it should not be
+// used. Outputs with fewer tiles than the device runs at once get enough
+// partitions to fill it, as long as every partition still has at least
+// min_k_iterations blocks of K to amortize the extra accumulation pass.
+int steel_gemm_splitk_partitions(metal::Device& d, int M, int N, int K) {
+  constexpr int bk = 16;
+  constexpr int min_k_iterations = 4;
+  constexpr int max_partitions = 32;
+
+  int bm = M < 40 ? 16 : 32;
+  int bn = N < 40 ? 16 : 32;
+  int n_tiles = ((M + bm - 1) / bm) * ((N + bn - 1) / bn);
+  int target = steel_gemm_target_threadgroups(d);
+  if (n_tiles >= target) {
+    return 1;
+  }
+
+  int partitions = (target + n_tiles - 1) / n_tiles;
+  partitions = std::min(partitions, max_partitions);
+  partitions = std::min(partitions, (K / bk) / min_k_iterations);
+  return partitions < 2 ? 1 : partitions;
+}
+
+} // namespace
+
 ///////////////////////////////////////////////////////////////////////////////
 // Steel matmul fallback
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+struct GemmTiles {
+  int bm;
+  int bn;
+  int bk;
+  int wm;
+  int wn;
+};
+
+// The tile configurations the fused steel GEMM is instantiated with
+constexpr GemmTiles gemm_tile_candidates[] = {
+    {32, 32, 16, 2, 2},
+    {64, 64, 16, 2, 2},
+    {64, 32, 32, 2, 2},
+    {64, 32, 16, 2, 2},
+    {32, 64, 16, 2, 2},
+};
+
+std::string gemm_tiles_name(const GemmTiles& t) {
+  std::ostringstream name;
+  name << "bm" << t.bm << "_bn" << t.bn << "_bk" << t.bk << "_wm" << t.wm
+       << "_wn" << t.wn;
+  return name.str();
+}
+
+// Problems are tuned by the power of two their sizes round up to
+int size_class(size_t n) {
+  int c = 0;
+  while ((size_t(1) << c) < n) {
+    c++;
+  }
+  return c;
+}
+
+} // namespace
+
 void steel_matmul_conv_groups(
     const Stream& s,
     metal::Device& d,
@@ -422,7 +546,8 @@ void steel_matmul(
     std::vector<array>& copies,
     std::vector<int> batch_shape /* = {} */,
     std::vector<size_t> A_batch_stride /* = {} */,
-    std::vector<size_t> B_batch_stride /* = {} */) {
+    std::vector<size_t> B_batch_stride /* = {} */,
+    bool allow_mps /* = false */) {
   using namespace mlx::steel;
 
   if (batch_shape.empty()) {
@@ -451,18 +576,15 @@ void steel_matmul(
   /////////////////////////////////////////////////////////////////////////////
   // Split K specialization
 
-  int _tm = M / 16;
-  int _tn = N / 16;
-  int _tk = K / 16;
+  int split_k_partitions =
+      batch_size_out == 1 ? steel_gemm_splitk_partitions(d, M, N, K) : 1;
 
-  if (batch_size_out == 1 && (_tm * _tn) <= 32 && _tk >= 8) {
+  if (split_k_partitions > 1) {
     int bm = M < 40 ? 16 : 32;
     int bn = N < 40 ? 16 : 32;
     int bk = 16;
     int wm = 2, wn = 2;
 
-    int split_k_partitions =
-        _tk < 16 ? 2 : (_tk < 32 ? 4 : (_tk < 64 ? 8 : 16));
     int split_k_partition_stride = M * N;
     int gemm_k_iterations = (K / bk) / split_k_partitions;
     int split_k_partition_size = gemm_k_iterations * bk;
@@ -561,123 +683,230 @@ void steel_matmul(
   // Regular kernel dispatch
 
   // Determine dispatch kernel
-  int bm = 32, bn = 32, bk = 16;
-  int wm = 2, wn = 2;
-
+  int default_tiles = 0;
   if ((size_t)batch_size_out * M * N >= 1ul << 20) {
     if (!transpose_a && transpose_b) {
-      bm = 64;
-      bn = (out.dtype() == float32) ? 64 : 32;
-      bk = (out.dtype() == float32) ? 16 : 32;
+      default_tiles = (out.dtype() == float32) ? 1 : 2;
     } else {
-      bm = 64;
-      bn = 64;
+      default_tiles = 1;
     }
   }
 
-  // Prepare kernel name
-  std::ostringstream kname;
-  kname << "steel_gemm_fused_" << (transpose_a ? 't' : 'n')
-        << (transpose_b ? 't' : 'n') << "_" << type_to_name(a) << "_"
-        << type_to_name(out) << "_bm" << bm << "_bn" << bn << "_bk" << bk
-        << "_wm" << wm << "_wn" << wn;
-
-  std::string base_name = kname.str();
-
   const bool has_batch = (batch_shape.size() > 1);
-  const bool use_out_source = false;
-  const bool do_axpby = false;
-  const bool align_M = (M % bm) == 0;
-  const bool align_N = (N % bn) == 0;
-  const bool align_K = (K % bk) == 0;
-  const bool do_gather = false;
+  std::vector<size_t> batch_strides = A_batch_stride;
+  batch_strides.insert(
+      batch_strides.end(), B_batch_stride.begin(), B_batch_stride.end());
 
-  metal::MTLFCList func_consts = {
-      {&has_batch, MTL::DataType::DataTypeBool, 10},
-      {&use_out_source, MTL::DataType::DataTypeBool, 100},
-      {&do_axpby, MTL::DataType::DataTypeBool, 110},
-      {&align_M, MTL::DataType::DataTypeBool, 200},
-      {&align_N, MTL::DataType::DataTypeBool, 201},
-      {&align_K, MTL::DataType::DataTypeBool, 202},
-      {&do_gather, MTL::DataType::DataTypeBool, 300},
+  // The pipeline, parameters and launch grid of the kernel with the tiles
+  struct GemmDispatch {
+    MTL::ComputePipelineState* kernel;
+    GEMMParams params;
+    MTL::Size grid_dims;
+    MTL::Size group_dims;
   };
+  auto prepare = [&](const GemmTiles& t) {
+    auto [bm, bn, bk, wm, wn] = t;
+    std::ostringstream kname;
+    kname << "steel_gemm_fused_" << (transpose_a ? 't' : 'n')
+          << (transpose_b ? 't' : 'n') << "_" << type_to_name(a) << "_"
+          << type_to_name(out) << "_bm" << bm << "_bn" << bn << "_bk" << bk
+          << "_wm" << wm << "_wn" << wn;
+
+    std::string base_name = kname.str();
+
+    const bool use_out_source = false;
+    const bool do_axpby = false;
+    const bool align_M = (M % bm) == 0;
+    const bool align_N = (N % bn) == 0;
+    const bool align_K = (K % bk) == 0;
+    const bool do_gather = false;
+
+    metal::MTLFCList func_consts = {
+        {&has_batch, MTL::DataType::DataTypeBool, 10},
+        {&use_out_source, MTL::DataType::DataTypeBool, 100},
+        {&do_axpby, MTL::DataType::DataTypeBool, 110},
+        {&align_M, MTL::DataType::DataTypeBool, 200},
+        {&align_N, MTL::DataType::DataTypeBool, 201},
+        {&align_K, MTL::DataType::DataTypeBool, 202},
+        {&do_gather, MTL::DataType::DataTypeBool, 300},
+    };
+
+    // clang-format off
+    kname << "_has_batch_" << (has_batch ? 't' : 'n')
+          << "_use_out_source_" << (use_out_source ? 't' : 'n')
+          << "_do_axpby_" << (do_axpby ? 't' : 'n')
+          << "_align_M_" << (align_M ? 't' : 'n')
+          << "_align_N_" << (align_N ? 't' : 'n')
+          << "_align_K_" << (align_K ? 't' : 'n')
+          << "_do_gather_" << (do_gather ? 't' : 'n'); // clang-format on
+
+    std::string hash_name = kname.str();
+
+    auto kernel = get_steel_gemm_fused_kernel(
+        d,
+        base_name,
+        hash_name,
+        func_consts,
+        out,
+        transpose_a,
+        transpose_b,
+        bm,
+        bn,
+        bk,
+        wm,
+        wn);
 
-  // clang-format off
-  kname << "_has_batch_" << (has_batch ? 't' : 'n')
-        << "_use_out_source_" << (use_out_source ? 't' : 'n')
-        << "_do_axpby_" << (do_axpby ? 't' : 'n')
-        << "_align_M_" << (align_M ? 't' : 'n')
-        << "_align_N_" << (align_N ? 't' : 'n')
-        << "_align_K_" << (align_K ? 't' : 'n')
-        << "_do_gather_" << (do_gather ? 't' : 'n'); // clang-format on
-
-  std::string hash_name = kname.str();
-
-  // Encode and dispatch kernel
-  auto& compute_encoder = d.get_command_encoder(s.index);
-  auto kernel = get_steel_gemm_fused_kernel(
-      d,
-      base_name,
-      hash_name,
-      func_consts,
-      out,
-      transpose_a,
-      transpose_b,
-      bm,
-      bn,
-      bk,
-      wm,
-      wn);
-
-  compute_encoder->setComputePipelineState(kernel);
-
-  // Use problem size to determine threadblock swizzle
-  int tn = (N + bn - 1) / bn;
-  int tm = (M + bm - 1) / bm;
-
-  // TODO: Explore device-based tuning for swizzle
-  int swizzle_log = 0; // tm >= 6 ? 3 : (tm <= 3 ? 0 : 2);
+    // Use problem size to determine threadblock swizzle
+    int tn = (N + bn - 1) / bn;
+    int tm = (M + bm - 1) / bm;
 
-  // Prepare steel matmul params
-  GEMMParams params{
-      /* const int M = */ M,
-      /* const int N = */ N,
-      /* const int K = */ K,
-      /* const int lda = */ lda,
-      /* const int ldb = */ ldb,
-      /* const int ldd = */ N,
-      /* const int tiles_n = */ tn,
-      /* const int tiles_m = */ tm,
-      /* const size_t batch_stride_a = */ A_batch_stride.back(),
-      /* const size_t batch_stride_b = */ B_batch_stride.back(),
-      /* const size_t batch_stride_d = */ matrix_stride_out,
-      /* const int swizzle_log = */ swizzle_log,
-      /* const int gemm_k_iterations_aligned = */ (K / bk),
-      /* const int batch_ndim = */ int(batch_shape.size())};
+    // TODO: Explore device-based tuning for swizzle
+    int swizzle_log = 0; // tm >= 6 ? 3 : (tm <= 3 ? 0 : 2);
 
-  // Prepare launch grid params
-  int tile = 1 << swizzle_log;
-  tm = (tm + tile - 1) / tile;
-  tn = tn * tile;
+    // Prepare steel matmul params
+    GEMMParams params{
+        /* const int M = */ M,
+        /* const int N = */ N,
+        /* const int K = */ K,
+        /* const int lda = */ lda,
+        /* const int ldb = */ ldb,
+        /* const int ldd = */ N,
+        /* const int tiles_n = */ tn,
+        /* const int tiles_m = */ tm,
+        /* const size_t batch_stride_a = */ A_batch_stride.back(),
+        /* const size_t batch_stride_b = */ B_batch_stride.back(),
+        /* const size_t batch_stride_d = */ matrix_stride_out,
+        /* const int swizzle_log = */ swizzle_log,
+        /* const int gemm_k_iterations_aligned = */ (K / bk),
+        /* const int batch_ndim = */ int(batch_shape.size())};
+
+    // Prepare launch grid params
+    int tile = 1 << swizzle_log;
+    tm = (tm + tile - 1) / tile;
+    tn = tn * tile;
+
+    return GemmDispatch{
+        kernel,
+        params,
+        MTL::Size(tn, tm, batch_size_out),
+        MTL::Size(32, wn, wm)};
+  };
 
-  MTL::Size group_dims = MTL::Size(32, wn, wm);
-  MTL::Size grid_dims = MTL::Size(tn, tm, batch_size_out);
+  // Pick the tiles of the shape class with the autotuner
+  std::ostringstream key;
+  key << "steel_gemm_fused_" << (transpose_a ? 't' : 'n')
+      << (transpose_b ? 't' : 'n') << "_" << type_to_name(out) << "_M"
+      << size_class(M) << "_N" << size_class(N) << "_K" << size_class(K)
+      << "_B" << size_class(batch_size_out);
+  std::vector<std::string> candidates;
+  for (auto& t : gemm_tile_candidates) {
+    candidates.push_back(gemm_tiles_name(t));
+  }
+  auto encode_tuning = [&](MTL::ComputeCommandEncoder* enc,
+                           MTL::Buffer* scratch,
+                           const GemmDispatch& g) {
+    enc->setComputePipelineState(g.kernel);
+    metal::set_tuning_array(enc, a, 0);
+    metal::set_tuning_array(enc, b, 1);
+    enc->setBuffer(scratch, 0, 3);
+    enc->setBytes(&g.params, sizeof(GEMMParams), 4);
+    enc->setBytes(batch_shape.data(), batch_shape.size() * sizeof(int), 6);
+    enc->setBytes(
+        batch_strides.data(), batch_strides.size() * sizeof(size_t), 7);
+    enc->dispatchThreadgroups(g.grid_dims, g.group_dims);
+  };
+  int best = metal::autotune(
+      d,
+      key.str(),
+      candidates,
+      default_tiles,
+      out.nbytes(),
+      [&](MTL::ComputeCommandEncoder* enc, MTL::Buffer* scratch, int i) {
+        encode_tuning(enc, scratch, prepare(gemm_tile_candidates[i]));
+      });
+  auto g = prepare(gemm_tile_candidates[best]);
+
+  // Neither steel nor MPS is faster for every shape, so the class of the
+  // problem picks one when MLX_USE_MPS doesn't
+  if (allow_mps && !use_mps().has_value() &&
+      (out.dtype() == float32 || out.dtype() == float16)) {
+    key.str("");
+    key << "gemm_backend_" << (transpose_a ? 't' : 'n')
+        << (transpose_b ? 't' : 'n') << "_" << type_to_name(out) << "_M"
+        << size_class(M) << "_N" << size_class(N) << "_K" << size_class(K)
+        << "_B" << size_class(batch_size_out);
+    // Shipped default: MPS for large float32 problems without a batch
+    // except on phones and tablets
+    bool default_mps = out.dtype() == float32 && batch_size_out == 1 &&
+        M >= 2048 && N >= 2048 && K >= 2048 &&
+        d.get_architecture_class() != 'p';
+    int backend = metal::autotune_commands(
+        d,
+        key.str(),
+        {"steel", "mps"},
+        default_mps ? 1 : 0,
+        out.nbytes(),
+        [&](MTL::CommandBuffer* cbuf, MTL::Buffer* scratch, int i) {
+          if (i == 0) {
+            auto enc = cbuf->computeCommandEncoder();
+            encode_tuning(enc, scratch, g);
+            enc->endEncoding();
+          } else {
+            encode_mps_matmul(
+                d.mtl_device(),
+                cbuf,
+                a,
+                b,
+                out,
+                scratch,
+                0,
+                M,
+                N,
+                K,
+                batch_size_out,
+                lda,
+                ldb,
+                transpose_a,
+                transpose_b,
+                1.0f,
+                0.0f);
+          }
+        });
+    if (backend == 1) {
+      d.end_encoding(s.index);
+      return mps_matmul(
+          s,
+          d,
+          a,
+          b,
+          out,
+          M,
+          N,
+          K,
+          batch_size_out,
+          lda,
+          ldb,
+          transpose_a,
+          transpose_b,
+          copies);
+    }
+  }
 
-  std::vector<size_t> batch_strides = A_batch_stride;
-  batch_strides.insert(
-      batch_strides.end(), B_batch_stride.begin(), B_batch_stride.end());
+  // Encode and dispatch kernel
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(g.kernel);
 
   // Launch kernel
   compute_encoder.set_input_array(a, 0);
   compute_encoder.set_input_array(b, 1);
   compute_encoder.set_output_array(out, 3);
 
-  compute_encoder->setBytes(&params, sizeof(GEMMParams), 4);
+  compute_encoder->setBytes(&g.params, sizeof(GEMMParams), 4);
 
   set_vector_bytes(compute_encoder, batch_shape, 6);
   set_vector_bytes(compute_encoder, batch_strides, 7);
 
-  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+  compute_encoder.dispatchThreadgroups(g.grid_dims, g.group_dims);
 
   // Clear copies
   d.get_command_buffer(s.index)->addCompletedHandler(
@@ -685,6 +914,96 @@ void steel_matmul(
   return;
 }
 
+namespace {
+
+// Rows of a up to which a matmul with a single matrix b uses a gemv which
+// reads b once for all of them, e.g. when decoding a few sequences
+constexpr int gemv_max_rows = 8;
+
+// out = alpha * (a @ b) + beta * c for the M <= gemv_max_rows rows of a,
+// which are lda apart. The bias c is used when given, with rows ldc apart
+// and columns fdc apart.
+void gemv_rows(
+    const Stream& s,
+    metal::Device& d,
+    const array& a,
+    const array& b,
+    array& out,
+    int M,
+    int N,
+    int K,
+    int lda,
+    int ldb,
+    bool transpose_b,
+    const std::optional<array>& c = std::nullopt,
+    int ldc = 0,
+    int fdc = 0,
+    float alpha = 1.0f,
+    float beta = 0.0f) {
+  // Same blocks as the single vector gemv
+  int tm = 4, tn = 4;
+  int sm = 1, sn = 32;
+  int bm = 1, bn = 1;
+  int n_out_per_tgp;
+  std::ostringstream kname;
+  if (!transpose_b) {
+    if (K >= 8192 && N >= 2048) {
+      sm = 4;
+      sn = 8;
+    } else {
+      sm = 8;
+      sn = 4;
+    }
+    if (N >= 2048) {
+      bn = 16;
+    } else if (N >= 512) {
+      bn = 4;
+    } else {
+      bn = 2;
+    }
+    tn = N < tn ? 1 : tn;
+    n_out_per_tgp = bn * sn * tn;
+    kname << "gemv_t_rows_" << type_to_name(out);
+  } else {
+    bm = N >= 4096 ? 8 : 4;
+    tm = N < tm ? 1 : tm;
+    n_out_per_tgp = bm * sm * tm;
+    kname << "gemv_rows_" << type_to_name(out);
+  }
+  int nv = M <= 4 ? 4 : 8;
+  kname << "_bm" << bm << "_bn" << bn << "_sm" << sm << "_sn" << sn << "_tm"
+        << tm << "_tn" << tn << "_nv" << nv << "_axpby" << c.has_value();
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel = d.get_kernel(kname.str());
+  compute_encoder->setComputePipelineState(kernel);
+
+  int n_tgp = (N + n_out_per_tgp - 1) / n_out_per_tgp;
+  MTL::Size group_dims = MTL::Size(32, bn, bm);
+  MTL::Size grid_dims = MTL::Size(n_tgp, 1, 1);
+
+  compute_encoder.set_input_array(b, 0);
+  compute_encoder.set_input_array(a, 1);
+  if (c) {
+    compute_encoder.set_input_array(*c, 2);
+  }
+  compute_encoder.set_output_array(out, 3);
+
+  compute_encoder->setBytes(&K, sizeof(int), 4);
+  compute_encoder->setBytes(&N, sizeof(int), 5);
+  compute_encoder->setBytes(&ldb, sizeof(int), 6);
+  compute_encoder->setBytes(&alpha, sizeof(float), 7);
+  compute_encoder->setBytes(&beta, sizeof(float), 8);
+  compute_encoder->setBytes(&lda, sizeof(int), 9);
+  compute_encoder->setBytes(&M, sizeof(int), 10);
+  compute_encoder->setBytes(&ldc, sizeof(int), 11);
+  compute_encoder->setBytes(&fdc, sizeof(int), 14);
+
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+}
+
+} // namespace
+
 void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 2);
   if (!issubdtype(out.dtype(), floating)) {
@@ -758,6 +1077,14 @@ void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
   /////////////////////////////////////////////////////////////////////////////
   // Gemv specialization
 
+  if (M > 1 && M <= gemv_max_rows && N > 1 && batch_size_out == 1 &&
+      !a_transposed) {
+    gemv_rows(s, d, a, b, out, M, N, K, a_cols, b_cols, b_transposed);
+    d.get_command_buffer(s.index)->addCompletedHandler(
+        [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+    return;
+  }
+
   // Route to gemv if needed
   if (std::min(M, N) == 1) {
     // Collect problem info
@@ -860,7 +1187,7 @@ void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
   /////////////////////////////////////////////////////////////////////////////
   // Gemm specialization
 
-  if (use_mps()) {
+  if (use_mps().value_or(false)) {
     d.end_encoding(s.index);
 
     return mps_matmul(
@@ -897,7 +1224,19 @@ void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
       /* std::vector<array>& = */ copies,
       /* std::vector<int> batch_shape = */ batch_shape,
       /* std::vector<size_t> A_batch_stride = */ A_batch_stride,
-      /* std::vector<size_t> B_batch_stride = */ B_batch_stride);
+      /* std::vector<size_t> B_batch_stride = */ B_batch_stride,
+      /* bool allow_mps = */ true);
+}
+
+void MatmulVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  // Encoded back to back, the two products write different buffers so the
+  // command encoder runs them concurrently. A concurrent context would not
+  // be safe here, the split k kernels read the partial results written by
+  // the previous dispatch.
+  Matmul(stream()).eval_gpu({inputs[0], inputs[1]}, outputs[0]);
+  Matmul(stream()).eval_gpu({inputs[2], inputs[0]}, outputs[1]);
 }
 
 void AddMM::eval_gpu(const std::vector<array>& inputs, array& out) {
@@ -976,6 +1315,30 @@ void AddMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   /////////////////////////////////////////////////////////////////////////////
   // Gemv specialization
 
+  if (M > 1 && M <= gemv_max_rows && N > 1 && batch_size_out == 1 &&
+      !transpose_a) {
+    gemv_rows(
+        s,
+        d,
+        a,
+        b,
+        out,
+        M,
+        N,
+        K,
+        a_cols,
+        b_cols,
+        transpose_b,
+        c,
+        ldc,
+        fdc,
+        alpha_,
+        beta_);
+    d.get_command_buffer(s.index)->addCompletedHandler(
+        [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+    return;
+  }
+
   // Route to gemv if needed
   if (std::min(M, N) == 1) {
     // Collect problem info
@@ -1089,18 +1452,15 @@ void AddMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   /////////////////////////////////////////////////////////////////////////////
   // Split K specialization
 
-  int _tm = M / 16;
-  int _tn = N / 16;
-  int _tk = K / 16;
+  int split_k_partitions =
+      batch_size_out == 1 ? steel_gemm_splitk_partitions(d, M, N, K) : 1;
 
-  if (batch_size_out == 1 && (_tm * _tn) <= 32 && _tk >= 8) {
+  if (split_k_partitions > 1) {
     int bm = M < 40 ? 16 : 32;
     int bn = N < 40 ? 16 : 32;
     int bk = 16;
     int wm = 2, wn = 2;
 
-    int split_k_partitions =
-        _tk < 16 ? 2 : (_tk < 32 ? 4 : (_tk < 64 ? 8 : 16));
     int split_k_partition_stride = M * N;
     int gemm_k_iterations = (K / bk) / split_k_partitions;
     int split_k_partition_size = gemm_k_iterations * bk;
@@ -1729,6 +2089,146 @@ void BlockMaskedMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   return;
 }
 
+namespace {
+
+void gather_mm_rhs(
+    const array& a_,
+    const array& b_,
+    const array& indices_,
+    array& out,
+    metal::Device& d,
+    const Stream& s) {
+  using namespace mlx::steel;
+
+  std::vector<array> copies;
+  auto ensure_row_contiguous = [&copies, &s](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      copies.push_back(arr_copy);
+      return arr_copy;
+    }
+  };
+
+  // a is multiplied as a single matrix with a row per index
+  auto a = ensure_row_contiguous(a_);
+  auto indices = ensure_row_contiguous(indices_);
+  int K = a.shape(-1);
+  int M = a.size() / K;
+  int N = out.shape(-1);
+
+  // The matrices of b are used in place if they are contiguous, transposed
+  // or not, and evenly spaced
+  auto evenly_spaced = [K, N](const array& arr) {
+    size_t stride = size_t(K) * N;
+    for (int i = arr.ndim() - 3; i >= 0; i--) {
+      if (arr.shape(i) > 1 && arr.strides()[i] != stride) {
+        return false;
+      }
+      stride *= arr.shape(i);
+    }
+    return true;
+  };
+  auto b_str_k = b_.strides()[b_.ndim() - 2];
+  auto b_str_n = b_.strides()[b_.ndim() - 1];
+  bool transpose_b = false;
+  array b = b_;
+  if (b_str_n == 1 && b_str_k == N && evenly_spaced(b_)) {
+    transpose_b = false;
+  } else if (b_str_k == 1 && b_str_n == K && evenly_spaced(b_)) {
+    transpose_b = true;
+  } else {
+    b = array(b_.shape(), b_.dtype(), nullptr, {});
+    copy_gpu(b_, b, CopyType::General, s);
+    copies.push_back(b);
+  }
+
+  // Determine dispatch kernel
+  int bm = 32, bn = 32, bk = 16;
+  int wm = 2, wn = 2;
+  if ((size_t)M * N >= 1ul << 20) {
+    bm = 64;
+    bn = 64;
+  }
+
+  std::ostringstream kname;
+  kname << "steel_gather_mm_rhs_n" << (transpose_b ? 't' : 'n') << "_"
+        << type_to_name(out) << "_bm" << bm << "_bn" << bn << "_bk" << bk
+        << "_wm" << wm << "_wn" << wn;
+
+  std::string base_name = kname.str();
+
+  const bool align_N = (N % bn) == 0;
+  const bool align_K = (K % bk) == 0;
+
+  metal::MTLFCList func_consts = {
+      {&align_N, MTL::DataType::DataTypeBool, 201},
+      {&align_K, MTL::DataType::DataTypeBool, 202},
+  };
+
+  // clang-format off
+  kname << "_align_N_" << (align_N ? 't' : 'n')
+        << "_align_K_" << (align_K ? 't' : 'n'); // clang-format on
+
+  std::string hash_name = kname.str();
+
+  // Encode and dispatch kernel
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel = get_steel_gemm_gather_kernel(
+      d,
+      base_name,
+      hash_name,
+      func_consts,
+      out,
+      transpose_b,
+      bm,
+      bn,
+      bk,
+      wm,
+      wn);
+
+  compute_encoder->setComputePipelineState(kernel);
+
+  int tn = (N + bn - 1) / bn;
+  int tm = (M + bm - 1) / bm;
+
+  // Prepare steel matmul params
+  GEMMParams params{
+      /* const int M = */ M,
+      /* const int N = */ N,
+      /* const int K = */ K,
+      /* const int lda = */ K,
+      /* const int ldb = */ transpose_b ? K : N,
+      /* const int ldd = */ N,
+      /* const int tiles_n = */ tn,
+      /* const int tiles_m = */ tm,
+      /* const size_t batch_stride_a = */ 0,
+      /* const size_t batch_stride_b = */ size_t(K) * N,
+      /* const size_t batch_stride_d = */ 0,
+      /* const int swizzle_log = */ 0,
+      /* const int gemm_k_iterations_aligned = */ (K / bk),
+      /* const int batch_ndim = */ 0};
+
+  MTL::Size group_dims = MTL::Size(32, wn, wm);
+  MTL::Size grid_dims = MTL::Size(tn, tm, 1);
+
+  // Launch kernel
+  compute_encoder.set_input_array(a, 0);
+  compute_encoder.set_input_array(b, 1);
+  compute_encoder.set_input_array(indices, 2);
+  compute_encoder.set_output_array(out, 3);
+  compute_encoder->setBytes(&params, sizeof(GEMMParams), 4);
+
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace
+
 void GatherMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   using namespace mlx::steel;
   // assert(inputs.size() == 2);
@@ -1752,6 +2252,15 @@ void GatherMM::eval_gpu(const std::vector<array>& inputs, array& out) {
 
   out.set_data(allocator::malloc_or_wait(out.nbytes()));
 
+  // Multiply the rows of a that use the same matrix of b together when the
+  // indices are sorted and every row of a is its own batch element
+  int n_rows = a_pre.size() / a_pre.shape(-1);
+  if (right_sorted_ && a_pre.shape(-2) == 1 && n_rows >= 16 &&
+      n_rows == inputs[3].size()) {
+    gather_mm_rhs(a_pre, b_pre, inputs[3], out, d, s);
+    return;
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // Init checks and prep
 
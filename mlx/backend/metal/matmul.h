@@ -12,6 +12,10 @@
 
 namespace mlx::core {
 
+// Threadgroups of the steel gemm kernels to launch to keep every core busy,
+// about eight per core, looked up by device class
+int steel_gemm_target_threadgroups(metal::Device& d);
+
 void steel_matmul_conv_groups(
     const Stream& s,
     metal::Device& d,
@@ -46,6 +50,7 @@ void steel_matmul(
     std::vector<array>& copies,
     std::vector<int> batch_shape = {},
     std::vector<size_t> A_batch_stride = {},
-    std::vector<size_t> B_batch_stride = {});
+    std::vector<size_t> B_batch_stride = {},
+    bool allow_mps = false);
 
 } // namespace mlx::core
\ No newline at end of file
@@ -1,9 +1,18 @@
 // Copyright © 2023-2024 Apple Inc.
+#include <atomic>
 #include <cstdlib>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
+#include "mlx/allocator.h"
+#include "mlx/backend/metal/capture.h"
 #include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/profiler.h"
 #include "mlx/backend/metal/utils.h"
+#include "mlx/cancellation.h"
 #include "mlx/primitives.h"
 #include "mlx/scheduler.h"
 
@@ -18,14 +27,66 @@ int max_ops_per_buffer() {
     if (const char* buff_str = std::getenv("MLX_MAX_OPS_PER_BUFFER")) {
       return atoi(buff_str);
     } else {
-      return 10;
+      return 40;
     }
   };
   static int max_ops_per_buffer_ = get_val();
   return max_ops_per_buffer_;
 }
 
+size_t max_bytes_per_buffer() {
+  auto get_val = []() -> size_t {
+    if (const char* buff_str = std::getenv("MLX_MAX_MB_PER_BUFFER")) {
+      return size_t(atoi(buff_str)) << 20;
+    } else {
+      return size_t(64) << 20;
+    }
+  };
+  static size_t max_bytes_per_buffer_ = get_val();
+  return max_bytes_per_buffer_;
+}
+
 #define MAX_OPS_PER_BUFFER max_ops_per_buffer()
+#define MAX_BYTES_PER_BUFFER max_bytes_per_buffer()
+
+namespace {
+
+// Work encoded in a stream's open command buffer and the number of its
+// buffers the GPU has not finished yet. Only the stream's task thread
+// touches bytes while in_flight is also updated by completion handlers.
+struct BufferStats {
+  size_t bytes{0};
+  std::atomic<int> in_flight{0};
+};
+
+BufferStats& buffer_stats(int index) {
+  static std::mutex mtx;
+  static std::unordered_map<int, std::unique_ptr<BufferStats>> stats;
+  std::lock_guard<std::mutex> lk(mtx);
+  auto& st = stats[index];
+  if (!st) {
+    st = std::make_unique<BufferStats>();
+  }
+  return *st;
+}
+
+// Low priority streams commit buffers this many times smaller so the GPU
+// can run the buffers of other streams in between
+constexpr int low_priority_buffer_divisor = 4;
+
+// The open command buffer is committed as soon as the GPU runs out of work
+// for the stream so it is never starved. Otherwise ops keep being added to
+// it, amortizing the per buffer overhead, until it holds roughly
+// MAX_BYTES_PER_BUFFER of memory traffic or MAX_OPS_PER_BUFFER ops.
+bool should_commit(metal::Device& d, int index, const BufferStats& stats) {
+  int div = d.get_queue_priority(index) == StreamPriority::low
+      ? low_priority_buffer_divisor
+      : 1;
+  return stats.in_flight == 0 || stats.bytes * div >= MAX_BYTES_PER_BUFFER ||
+      d.get_command_buffer_ops(index) * div >= MAX_OPS_PER_BUFFER;
+}
+
+} // namespace
 
 inline void check_error(MTL::CommandBuffer* cbuf) {
   if (cbuf->status() == MTL::CommandBufferStatusError) {
@@ -36,8 +97,13 @@ inline void check_error(MTL::CommandBuffer* cbuf) {
   }
 }
 
-std::function<void()> make_task(array arr, bool signal) {
-  auto task = [arr = std::move(arr), signal]() mutable {
+std::function<void()> make_task(
+    array arr,
+    bool signal,
+    std::optional<CancellationToken> token) {
+  auto task = [arr = std::move(arr),
+               signal,
+               token = std::move(token)]() mutable {
     auto pool = new_scoped_memory_pool();
     auto s = arr.primitive().stream();
     auto& d = metal::device(s.device);
@@ -47,14 +113,32 @@ std::function<void()> make_task(array arr, bool signal) {
     for (auto& input : arr.inputs()) {
       if (input.event().valid() &&
           input.event().stream() != arr.primitive().stream()) {
-        // TODO, consider committing the buffer and encoding a wait in the new
-        // buffer rather than on the task thread
-        input.event().wait();
+        if (input.event().stream().device == Device::cpu) {
+          // The events of CPU streams are not Metal events so wait for the
+          // CPU work on this thread, after submitting the work encoded so
+          // far for the GPU to run meanwhile
+          if (!input.event().is_signaled()) {
+            buffer_stats(s.index).bytes = 0;
+            d.end_encoding(s.index);
+            d.commit_command_buffer(s.index);
+            command_buffer = d.get_command_buffer(s.index);
+            input.event().wait();
+          }
+          continue;
+        }
+        // Have the GPU wait for the other stream so this thread can keep
+        // encoding. Waits can only be encoded between compute encoders.
+        d.end_encoding(s.index);
+        command_buffer->encodeWait(
+            static_cast<MTL::Event*>(input.event().raw_event().get()),
+            input.event().value());
       }
     }
 
+    // A skipped array still signals its event and commits the buffer
+    bool skip = detail::skip_cancelled(arr, token);
     auto outputs = arr.outputs();
-    {
+    if (!skip) {
       // If the array is a tracer hold a reference
       // to its inputs so they don't get donated
       std::vector<array> inputs;
@@ -63,7 +147,14 @@ std::function<void()> make_task(array arr, bool signal) {
       }
 
       debug_set_primitive_buffer_label(command_buffer, arr.primitive());
-      arr.primitive().eval_gpu(arr.inputs(), outputs);
+      int profile_slot = is_profiling() ? profile_begin(d, s.index) : -1;
+      metal::eval_gpu(arr, outputs);
+      // The primitive may have committed the command buffer, e.g. to start
+      // communicating its inputs, so continue with the current one
+      command_buffer = d.get_command_buffer(s.index);
+      if (profile_slot >= 0) {
+        profile_end(d, s.index, profile_slot, command_buffer, arr.primitive());
+      }
     }
     std::vector<std::shared_ptr<array::Data>> buffers;
     for (auto& in : arr.inputs()) {
@@ -72,11 +163,23 @@ std::function<void()> make_task(array arr, bool signal) {
     for (auto& s : arr.siblings()) {
       buffers.push_back(s.data_shared_ptr());
     }
-    if (!arr.is_tracer()) {
-      arr.detach();
+    // Estimate the work of the op by the memory it reads and writes
+    auto& stats = buffer_stats(s.index);
+    if (!skip) {
+      for (auto& in : arr.inputs()) {
+        stats.bytes += in.nbytes();
+      }
+      for (auto& out : outputs) {
+        stats.bytes += out.nbytes();
+      }
+      if (!arr.is_tracer()) {
+        arr.detach();
+      }
     }
 
-    if (signal || d.get_command_buffer_ops(s.index) >= MAX_OPS_PER_BUFFER) {
+    if (signal || should_commit(d, s.index, stats)) {
+      stats.bytes = 0;
+      stats.in_flight++;
       d.end_encoding(s.index);
       if (signal) {
         command_buffer->encodeSignalEvent(
@@ -85,8 +188,9 @@ std::function<void()> make_task(array arr, bool signal) {
       }
       scheduler::notify_new_task(s);
       command_buffer->addCompletedHandler(
-          [s, buffers = std::move(buffers), event = arr.event()](
+          [s, &stats, buffers = std::move(buffers), event = arr.event()](
               MTL::CommandBuffer* cbuf) {
+            stats.in_flight--;
             scheduler::notify_task_completion(s);
             check_error(cbuf);
           });
@@ -109,6 +213,7 @@ std::function<void()> make_synchronize_task(
     auto& d = metal::device(s.device);
     auto cb = d.get_command_buffer(s.index);
     cb->retain();
+    buffer_stats(s.index).bytes = 0;
     d.end_encoding(s.index);
     d.commit_command_buffer(s.index);
     cb->waitUntilCompleted();
@@ -118,6 +223,73 @@ std::function<void()> make_synchronize_task(
   };
 }
 
+void precompile(const std::vector<array>& outputs) {
+  // Evaluate a copy of the unevaluated part of the graph so the arrays
+  // given are left as they are
+  std::unordered_map<std::uintptr_t, array> mirrors;
+  std::vector<array> tape;
+  std::function<void(const array&)> recurse = [&](const array& a) {
+    if (mirrors.find(a.id()) != mirrors.end()) {
+      return;
+    }
+    if (a.status() != array::Status::unscheduled) {
+      mirrors.insert({a.id(), a});
+      return;
+    }
+    std::vector<array> inputs;
+    for (auto& in : a.inputs()) {
+      recurse(in);
+      inputs.push_back(mirrors.at(in.id()));
+    }
+    std::vector<std::vector<int>> shapes;
+    std::vector<Dtype> dtypes;
+    auto outs = a.outputs();
+    for (auto& o : outs) {
+      shapes.push_back(o.shape());
+      dtypes.push_back(o.dtype());
+    }
+    auto mirrored = array::make_arrays(
+        std::move(shapes), dtypes, a.primitive_ptr(), std::move(inputs));
+    for (int i = 0; i < outs.size(); i++) {
+      mirrors.insert({outs[i].id(), mirrored[i]});
+    }
+    tape.push_back(mirrored[0]);
+  };
+  for (auto& out : outputs) {
+    recurse(out);
+  }
+
+  // Encode on the calling thread into command buffers which are never
+  // committed, so nothing else may run on the streams in the meantime
+  std::unordered_map<int, Stream> streams;
+  for (auto& a : tape) {
+    auto s = a.primitive().stream();
+    if (s.device == mlx::core::Device::gpu &&
+        streams.find(s.index) == streams.end()) {
+      synchronize(s);
+      streams.insert({s.index, s});
+    }
+  }
+
+  auto& d = metal::device(mlx::core::Device::gpu);
+  for (auto& a : tape) {
+    auto pool = new_scoped_memory_pool();
+    auto outs = a.outputs();
+    if (a.primitive().device() == mlx::core::Device::gpu) {
+      a.primitive().eval_gpu(a.inputs(), outs);
+    } else {
+      // Only the GPU kernels are compiled, CPU outputs just need memory
+      for (auto& o : outs) {
+        o.set_data(allocator::malloc_or_wait(o.nbytes()));
+      }
+    }
+  }
+  for (auto& [index, s] : streams) {
+    d.discard_command_buffer(index);
+  }
+  d.save_kernel_cache();
+}
+
 void start_capture(std::string path, id object) {
   auto pool = new_scoped_memory_pool();
 
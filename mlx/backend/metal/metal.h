@@ -11,6 +11,11 @@ namespace mlx::core::metal {
 /* Check if the Metal backend is available. */
 bool is_available();
 
+/* The memory functions below report on the CPU allocator when the Metal
+ * backend is not available. Setting a memory limit is only supported with
+ * Metal.
+ * */
+
 /* Get the actively used memory in bytes.
  *
  * Note, this will not always match memory use reported by the system because
@@ -42,6 +47,11 @@ size_t get_cache_memory();
  * is false or memory will be allocated (including the potential for
  * swap) if relaxed is true.
  *
+ * Graphs whose outputs could exceed the memory left under the limit are
+ * evaluated in an order which frees intermediates early and wait for the
+ * GPU to catch up when too much work is in flight, so even async_eval can
+ * block on them.
+ *
  * The memory limit defaults to 1.5 times the maximum recommended working set
  * size reported by the device.
  *
@@ -49,6 +59,10 @@ size_t get_cache_memory();
  * */
 size_t set_memory_limit(size_t limit, bool relaxed = true);
 
+/* Get the memory limit in bytes, 0 if there is no limit.
+ * */
+size_t get_memory_limit();
+
 /* Set the free cache limit.
  * If using more than the given limit, free memory will be reclaimed
  * from the cache on the next allocation. To disable the cache,
@@ -63,6 +77,85 @@ size_t set_cache_limit(size_t limit);
 /* Clear the memory cache. */
 void clear_cache();
 
+/* Get statistics about the memory cache since the program started or the
+ * last call to reset_cache_stats.
+ *
+ * Returns the number of allocations served from the cache ("hits") and
+ * from new memory ("misses"), the bytes by which reused buffers were larger
+ * than requested ("wasted_bytes") and the number of cached buffers released
+ * to stay under the memory or cache limit ("evictions").
+ * */
+std::unordered_map<std::string, size_t> get_cache_stats();
+
+/* Reset the memory cache statistics to zero. */
+void reset_cache_stats();
+
+/* Set the wired size limit.
+ * Arrays made resident with make_resident are wired, i.e. kept in memory
+ * and not paged out or compressed by the OS, as long as their total size is
+ * within the limit. If it is exceeded none of them are wired until arrays
+ * are freed or the limit is raised.
+ *
+ * The limit defaults to 0 and may not be larger than the maximum
+ * recommended working set size reported by the device. Wiring memory needs
+ * macOS 15 or newer and is a no-op otherwise.
+ *
+ * Returns the previous wired limit.
+ * */
+size_t set_wired_limit(size_t limit);
+
+/* Get the wired memory in bytes. */
+size_t get_wired_memory();
+
+/* Make the memory of the arrays resident, evaluating them if needed. It
+ * stays resident, subject to the wired limit, until it is freed. Useful for
+ * large weights which would otherwise be paged out when the GPU is idle.
+ * */
+void make_resident(const std::vector<array>& arrays);
+
+/* Prepack the weights, evaluating them if needed. The layouts the GPU
+ * kernels compute from a prepacked weight, e.g. the Winograd transform or
+ * the contiguous copy of a convolution filter, are kept and reused instead
+ * of being recomputed on every call. They take extra memory and are released
+ * with the weight once it is not used anywhere else. Useful for inference.
+ * */
+void prepack(const std::vector<array>& weights);
+
+/* Release every prepacked weight and its layouts. */
+void clear_prepacked();
+
+/* Compile the GPU kernels needed to evaluate the given arrays without
+ * evaluating them.
+ *
+ * The pipelines are added to the in-memory and on-disk kernel caches so the
+ * first evaluation of a similar graph, e.g. a compiled function called with
+ * inputs of the same shapes and types, does not pay for compiling them. The
+ * kernels are encoded but never run. No other work may be submitted to the
+ * GPU streams of the graph while this runs.
+ * */
+void precompile(const std::vector<array>& outputs);
+
+/* Start recording the GPU time of every primitive evaluated on the GPU.
+ * Records from an earlier profile are cleared.
+ *
+ * Each primitive is encoded on its own with timestamps at its start and end,
+ * so kernels of different primitives don't overlap while profiling.
+ * */
+void start_profiling();
+
+/* Stop recording and wait for the profiled work to finish. */
+void stop_profiling();
+
+/* Get the number of evaluations and total GPU time in milliseconds of each
+ * primitive type since profiling started.
+ * */
+std::unordered_map<std::string, std::pair<size_t, double>> get_profile();
+
+/* Save the recorded primitives as a Chrome trace (JSON) to `path`. It can be
+ * viewed in chrome://tracing or Perfetto.
+ * */
+void save_profile_trace(const std::string& path);
+
 /** Capture a GPU trace, saving it to an absolute file `path` */
 void start_capture(std::string path = "");
 void stop_capture();
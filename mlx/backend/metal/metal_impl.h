@@ -4,20 +4,31 @@
 
 #include <future>
 #include <memory>
+#include <optional>
 
 #include "mlx/array.h"
+#include "mlx/cancellation.h"
 #include "mlx/stream.h"
 
 namespace mlx::core::metal {
 
-void new_stream(Stream stream);
+void new_stream(Stream stream, StreamPriority priority);
 
 std::unique_ptr<void, std::function<void(void*)>> new_scoped_memory_pool();
 
-std::function<void()> make_task(array arr, bool signal);
+// The task skips the primitive if its evaluation was cancelled with token
+// or an input was skipped
+std::function<void()> make_task(
+    array arr,
+    bool signal,
+    std::optional<CancellationToken> token = std::nullopt);
 
 std::function<void()> make_synchronize_task(
     Stream s,
     std::shared_ptr<std::promise<void>> p);
 
+/* Record the GPU work of the primitive the first time it is evaluated for a
+ * given input layout and replay it on later evaluations. */
+void capture_primitive(std::shared_ptr<Primitive> p);
+
 } // namespace mlx::core::metal
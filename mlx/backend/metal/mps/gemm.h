@@ -26,6 +26,9 @@ _MTL_PRIVATE_DEF_SEL(
     "matrixDescriptorWithRows:columns:matrices:rowBytes:matrixBytes:dataType:");
 _MTL_PRIVATE_DEF_SEL(rows, "rows");
 _MTL_PRIVATE_DEF_SEL(initWithBuffer_descriptor, "initWithBuffer:descriptor:");
+_MTL_PRIVATE_DEF_SEL(
+    initWithBuffer_offset_descriptor,
+    "initWithBuffer:offset:descriptor:");
 _MTL_PRIVATE_DEF_SEL(
     initWithDevice_,
     "initWithDevice:transposeLeft:transposeRight:"
@@ -84,6 +87,10 @@ class Matrix : public NS::Referencing<Matrix> {
   static class Matrix* alloc();
   Matrix* init(MTL::Buffer* buffer, MatrixDescriptor* descriptor);
   Matrix* init(const MTL::Buffer* buffer, MatrixDescriptor* descriptor);
+  Matrix* init(
+      const MTL::Buffer* buffer,
+      NS::UInteger offset,
+      MatrixDescriptor* descriptor);
 };
 
 class Kernel : public NS::Referencing<Kernel> {
@@ -213,6 +220,18 @@ _MTL_INLINE Matrix* Matrix::init(
   return init(const_cast<MTL::Buffer*>(buffer), descriptor);
 }
 
+_MTL_INLINE Matrix* Matrix::init(
+    const MTL::Buffer* buffer,
+    NS::UInteger offset,
+    MatrixDescriptor* descriptor) {
+  return Object::sendMessage<Matrix*>(
+      this,
+      _MPS_PRIVATE_SEL(initWithBuffer_offset_descriptor),
+      const_cast<MTL::Buffer*>(buffer),
+      offset,
+      descriptor);
+}
+
 _MTL_INLINE NS::String* Kernel::label() const {
   return Object::sendMessage<NS::String*>(this, _MPS_PRIVATE_SEL(label));
 }
@@ -62,6 +62,13 @@ MTL::ComputePipelineState* get_softmax_kernel(
   return d.get_kernel(kernel_name);
 }
 
+MTL::ComputePipelineState* get_logsumexp_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array&) {
+  return d.get_kernel(kernel_name);
+}
+
 MTL::ComputePipelineState* get_scan_kernel(
     metal::Device& d,
     const std::string& kernel_name,
@@ -93,6 +100,23 @@ MTL::ComputePipelineState* get_mb_sort_kernel(
   return d.get_kernel(kernel_name);
 }
 
+MTL::ComputePipelineState* get_radix_sort_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array&) {
+  return d.get_kernel(kernel_name);
+}
+
+MTL::ComputePipelineState* get_radix_select_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array&,
+    const array&,
+    bool,
+    int) {
+  return d.get_kernel(kernel_name);
+}
+
 MTL::ComputePipelineState* get_reduce_init_kernel(
     metal::Device& d,
     const std::string& kernel_name,
@@ -169,9 +193,53 @@ MTL::ComputePipelineState* get_steel_gemm_masked_kernel(
   return d.get_kernel(kernel_name);
 }
 
+MTL::ComputePipelineState* get_steel_gemm_sparse_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array&,
+    int,
+    int,
+    int,
+    int,
+    int,
+    int) {
+  return d.get_kernel(kernel_name);
+}
+
+MTL::ComputePipelineState* get_steel_gemm_fp8_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const array&,
+    bool,
+    int,
+    int,
+    int,
+    int,
+    int,
+    int) {
+  return d.get_kernel(kernel_name);
+}
+
+MTL::ComputePipelineState* get_steel_gemm_gather_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
+    const array&,
+    bool,
+    int,
+    int,
+    int,
+    int,
+    int) {
+  return d.get_kernel(kernel_name, "mlx", hash_name, func_consts);
+}
+
 MTL::ComputePipelineState* get_steel_conv_kernel(
     metal::Device& d,
     const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
     const array&,
     int,
     int,
@@ -180,10 +248,24 @@ MTL::ComputePipelineState* get_steel_conv_kernel(
     int,
     int,
     bool) {
-  return d.get_kernel(kernel_name);
+  return d.get_kernel(kernel_name, "mlx", hash_name, func_consts);
 }
 
 MTL::ComputePipelineState* get_steel_conv_general_kernel(
+    metal::Device& d,
+    const std::string& kernel_name,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts,
+    const array&,
+    int,
+    int,
+    int,
+    int,
+    int) {
+  return d.get_kernel(kernel_name, "mlx", hash_name, func_consts);
+}
+
+MTL::ComputePipelineState* get_steel_conv_wgrad_kernel(
     metal::Device& d,
     const std::string& kernel_name,
     const array&,
@@ -191,6 +273,7 @@ MTL::ComputePipelineState* get_steel_conv_general_kernel(
     int,
     int,
     int,
+    int,
     int) {
   return d.get_kernel(kernel_name);
 }
@@ -207,8 +290,10 @@ MTL::ComputePipelineState* get_fft_kernel(
 MTL::ComputePipelineState* get_quantized_kernel(
     metal::Device& d,
     const std::string& kernel_name,
-    const std::string&) {
-  return d.get_kernel(kernel_name);
+    const std::string&,
+    const std::string& hash_name,
+    const metal::MTLFCList& func_consts) {
+  return d.get_kernel(kernel_name, "mlx", hash_name, func_consts);
 }
 
 } // namespace mlx::core
@@ -95,6 +95,93 @@ void RMSNorm::eval_gpu(
       [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
 }
 
+void RMSNormResidual::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+  auto& out = outputs[0];
+  auto& h = outputs[1];
+
+  // The kernel reads x and the residual with the same row layout
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+    copy_gpu(x, copies.back(), CopyType::General, s);
+    return copies.back();
+  };
+  const array& x = check_input(inputs[0]);
+  const array& r = check_input(inputs[1]);
+  const array& w = inputs[2];
+
+  // Every element of x and r is read before the thread that read it writes
+  // the same position so the sum and the output can take their buffers
+  if (x.is_donatable()) {
+    h.move_shared_buffer(x);
+  } else {
+    h.set_data(allocator::malloc_or_wait(h.nbytes()));
+  }
+  if (r.is_donatable()) {
+    out.move_shared_buffer(r);
+  } else {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+
+  auto axis_size = static_cast<uint32_t>(x.shape().back());
+  int n_rows = x.size() / axis_size;
+
+  const int simd_size = 32;
+  const int n_reads = RMS_N_READS;
+  const int looped_limit = RMS_LOOPED_LIMIT;
+  std::string op_name = "rms_residual";
+  if (axis_size > looped_limit) {
+    op_name += "_looped";
+  }
+  op_name += type_to_name(out);
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  {
+    auto kernel = d.get_kernel(op_name);
+
+    MTL::Size grid_dims, group_dims;
+    if (axis_size <= looped_limit) {
+      size_t threadgroup_needed = (axis_size + n_reads - 1) / n_reads;
+      size_t simds_needed = (threadgroup_needed + simd_size - 1) / simd_size;
+      size_t threadgroup_size = simd_size * simds_needed;
+      assert(threadgroup_size <= kernel->maxTotalThreadsPerThreadgroup());
+      size_t n_threads = n_rows * threadgroup_size;
+      grid_dims = MTL::Size(n_threads, 1, 1);
+      group_dims = MTL::Size(threadgroup_size, 1, 1);
+    } else {
+      size_t threadgroup_size = kernel->maxTotalThreadsPerThreadgroup();
+      size_t n_threads = n_rows * threadgroup_size;
+      grid_dims = MTL::Size(n_threads, 1, 1);
+      group_dims = MTL::Size(threadgroup_size, 1, 1);
+    }
+
+    uint32_t w_stride = w.strides()[0];
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(
+        x.data_shared_ptr() == nullptr ? h : x, 0);
+    compute_encoder.set_input_array(
+        r.data_shared_ptr() == nullptr ? out : r, 1);
+    compute_encoder.set_input_array(w, 2);
+    compute_encoder.set_output_array(out, 3);
+    compute_encoder.set_output_array(h, 4);
+    compute_encoder->setBytes(&eps_, sizeof(float), 5);
+    compute_encoder->setBytes(&axis_size, sizeof(int), 6);
+    compute_encoder->setBytes(&w_stride, sizeof(uint32_t), 7);
+    compute_encoder->setThreadgroupMemoryLength(
+        16 * 8, 0); // minimum of 16 bytes
+    compute_encoder->setThreadgroupMemoryLength(simd_size * sizeof(float), 1);
+    compute_encoder.dispatchThreads(grid_dims, group_dims);
+  }
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
 void RMSNormVJP::eval_gpu(
     const std::vector<array>& inputs,
     std::vector<array>& outputs) {
@@ -415,4 +502,248 @@ void LayerNormVJP::eval_gpu(
       [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
 }
 
+namespace {
+
+// Threads per threadgroup for a kernel normalizing one group per threadgroup
+size_t group_norm_threadgroup_size(MTL::ComputePipelineState* kernel, int n) {
+  size_t simds_needed = (n + 31) / 32;
+  return std::min(
+      32 * simds_needed,
+      static_cast<size_t>(kernel->maxTotalThreadsPerThreadgroup()));
+}
+
+} // namespace
+
+void GroupNorm::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+  auto& out = outputs[0];
+
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+    copy_gpu(x, copies.back(), CopyType::General, s);
+    return copies.back();
+  };
+  const array& x = check_input(inputs[0]);
+  const array& w = inputs[1];
+  const array& b = inputs[2];
+
+  if (x.is_donatable()) {
+    out.move_shared_buffer(x);
+  } else {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+
+  uint32_t axis_size = x.shape().back();
+  uint32_t n_groups = num_groups_;
+  uint32_t group_channels = axis_size / n_groups;
+  uint32_t group_size = x.size() / x.shape(0) / n_groups;
+  uint32_t channel_stride = pytorch_compatible_ ? 1 : n_groups;
+  uint32_t group_offset = pytorch_compatible_ ? group_channels : 1;
+  uint32_t w_stride = (w.ndim() == 1) ? w.strides()[0] : 0;
+  uint32_t b_stride = (b.ndim() == 1) ? b.strides()[0] : 0;
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel = d.get_kernel("group_norm" + type_to_name(out));
+  size_t threadgroup_size = group_norm_threadgroup_size(kernel, group_size);
+  size_t n_threads = x.shape(0) * n_groups * threadgroup_size;
+  MTL::Size grid_dims(n_threads, 1, 1);
+  MTL::Size group_dims(threadgroup_size, 1, 1);
+
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(x.data_shared_ptr() == nullptr ? out : x, 0);
+  compute_encoder.set_input_array(w, 1);
+  compute_encoder.set_input_array(b, 2);
+  compute_encoder.set_output_array(out, 3);
+  compute_encoder->setBytes(&eps_, sizeof(float), 4);
+  compute_encoder->setBytes(&axis_size, sizeof(uint32_t), 5);
+  compute_encoder->setBytes(&group_channels, sizeof(uint32_t), 6);
+  compute_encoder->setBytes(&group_size, sizeof(uint32_t), 7);
+  compute_encoder->setBytes(&n_groups, sizeof(uint32_t), 8);
+  compute_encoder->setBytes(&channel_stride, sizeof(uint32_t), 9);
+  compute_encoder->setBytes(&group_offset, sizeof(uint32_t), 10);
+  compute_encoder->setBytes(&w_stride, sizeof(uint32_t), 11);
+  compute_encoder->setBytes(&b_stride, sizeof(uint32_t), 12);
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void GroupNormVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+    copy_gpu(x, copies.back(), CopyType::General, s);
+    return copies.back();
+  };
+  const array& x = check_input(inputs[0]);
+  const array& w = inputs[1];
+  const array& b = inputs[2];
+  const array& g = check_input(inputs[3]);
+  array& gx = outputs[0];
+  array& gw = outputs[1];
+  array& gb = outputs[2];
+
+  // Every element is read and written by the same thread so x and g can be
+  // donated to the outputs
+  bool x_in_gx = false;
+  bool g_in_gx = false;
+  if (x.is_donatable()) {
+    gx.move_shared_buffer(x);
+    x_in_gx = true;
+  } else if (g.is_donatable()) {
+    gx.move_shared_buffer(g);
+    g_in_gx = true;
+  } else {
+    gx.set_data(allocator::malloc_or_wait(gx.nbytes()));
+  }
+
+  uint32_t axis_size = x.shape().back();
+  int n_rows = x.size() / axis_size;
+
+  // Temporary for g * xhat which is reduced over the rows to give gw
+  array gw_temp({n_rows, x.shape().back()}, gw.dtype(), nullptr, {});
+  bool g_in_gw = false;
+  if (!g_in_gx && g.is_donatable()) {
+    gw_temp.move_shared_buffer(g);
+    g_in_gw = true;
+  } else {
+    gw_temp.set_data(allocator::malloc_or_wait(gw_temp.nbytes()));
+  }
+  copies.push_back(gw_temp);
+  {
+    array zero(0, gw.dtype());
+    copy_gpu(zero, gw, CopyType::Scalar, s);
+    copy_gpu(zero, gb, CopyType::Scalar, s);
+    copies.push_back(std::move(zero));
+  }
+
+  // Reduce g for the bias before the kernel overwrites it
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  if (gb.ndim() == 1 && gb.size() == axis_size) {
+    ReductionPlan plan(
+        ReductionOpType::ContiguousStridedReduce, {n_rows}, {axis_size});
+    strided_reduce_general_dispatch(
+        g_in_gx ? gx : (g_in_gw ? gw_temp : g),
+        gb,
+        "sum",
+        plan,
+        {0},
+        compute_encoder,
+        d,
+        s);
+  }
+
+  uint32_t n_groups = num_groups_;
+  uint32_t group_channels = axis_size / n_groups;
+  uint32_t group_size = x.size() / x.shape(0) / n_groups;
+  uint32_t channel_stride = pytorch_compatible_ ? 1 : n_groups;
+  uint32_t group_offset = pytorch_compatible_ ? group_channels : 1;
+  uint32_t w_stride = (w.ndim() == 1) ? w.strides()[0] : 0;
+
+  auto kernel = d.get_kernel("vjp_group_norm" + type_to_name(gx));
+  size_t threadgroup_size = group_norm_threadgroup_size(kernel, group_size);
+  size_t n_threads = x.shape(0) * n_groups * threadgroup_size;
+  MTL::Size grid_dims(n_threads, 1, 1);
+  MTL::Size group_dims(threadgroup_size, 1, 1);
+
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(x_in_gx ? gx : x, 0);
+  compute_encoder.set_input_array(w, 1);
+  compute_encoder.set_input_array(g_in_gx ? gx : (g_in_gw ? gw_temp : g), 2);
+  compute_encoder.set_output_array(gx, 3);
+  compute_encoder.set_output_array(gw_temp, 4);
+  compute_encoder->setBytes(&eps_, sizeof(float), 5);
+  compute_encoder->setBytes(&axis_size, sizeof(uint32_t), 6);
+  compute_encoder->setBytes(&group_channels, sizeof(uint32_t), 7);
+  compute_encoder->setBytes(&group_size, sizeof(uint32_t), 8);
+  compute_encoder->setBytes(&n_groups, sizeof(uint32_t), 9);
+  compute_encoder->setBytes(&channel_stride, sizeof(uint32_t), 10);
+  compute_encoder->setBytes(&group_offset, sizeof(uint32_t), 11);
+  compute_encoder->setBytes(&w_stride, sizeof(uint32_t), 12);
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+
+  if (gw.ndim() == 1 && gw.size() == axis_size) {
+    ReductionPlan plan(
+        ReductionOpType::ContiguousStridedReduce, {n_rows}, {axis_size});
+    strided_reduce_general_dispatch(
+        gw_temp, gw, "sum", plan, {0}, compute_encoder, d, s);
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void MeanVar::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+  const array& x = inputs[0];
+  auto& mean = outputs[0];
+  auto& var = outputs[1];
+  mean.set_data(allocator::malloc_or_wait(mean.nbytes()));
+  var.set_data(allocator::malloc_or_wait(var.nbytes()));
+
+  // The input is read in place with its own strides so broadcast, transposed
+  // or sliced inputs need no copy
+  std::vector<int> reduce_shape;
+  std::vector<size_t> reduce_strides;
+  size_t reduction_size = 1;
+  for (auto ax : axes_) {
+    reduce_shape.push_back(x.shape(ax));
+    reduce_strides.push_back(x.strides()[ax]);
+    reduction_size *= x.shape(ax);
+  }
+  auto [out_shape, out_strides] = shapes_without_reduction_axes(x, axes_);
+  if (reduce_shape.empty()) {
+    reduce_shape.push_back(1);
+    reduce_strides.push_back(0);
+  }
+  if (out_shape.empty()) {
+    out_shape.push_back(1);
+    out_strides.push_back(0);
+  }
+  int reduce_ndim = reduce_shape.size();
+  int out_ndim = out_shape.size();
+
+  auto kernel = d.get_kernel("mean_var" + type_to_name(x));
+  size_t simds_needed = (reduction_size + 31) / 32;
+  size_t threadgroup_size = std::min(
+      32 * simds_needed,
+      static_cast<size_t>(kernel->maxTotalThreadsPerThreadgroup()));
+  MTL::Size grid_dims(mean.size() * threadgroup_size, 1, 1);
+  MTL::Size group_dims(threadgroup_size, 1, 1);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(x, 0);
+  compute_encoder.set_output_array(mean, 1);
+  compute_encoder.set_output_array(var, 2);
+  compute_encoder->setBytes(&reduction_size, sizeof(size_t), 3);
+  set_vector_bytes(compute_encoder, reduce_shape, 4);
+  set_vector_bytes(compute_encoder, reduce_strides, 5);
+  compute_encoder->setBytes(&reduce_ndim, sizeof(int), 6);
+  set_vector_bytes(compute_encoder, out_shape, 7);
+  set_vector_bytes(compute_encoder, out_strides, 8);
+  compute_encoder->setBytes(&out_ndim, sizeof(int), 9);
+  compute_encoder->setBytes(&ddof_, sizeof(int), 10);
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+}
+
 } // namespace mlx::core::fast
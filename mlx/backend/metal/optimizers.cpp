@@ -0,0 +1,119 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
+
+namespace mlx::core::fast {
+
+namespace {
+
+// Encodes the update of every parameter with its own dispatch of the same
+// kernel. The tensors are independent so the dispatches are encoded as
+// concurrent and the whole update costs about as much as its largest
+// tensor. The inputs are the learning rate followed by the lists of
+// parameters, gradients and states, and the outputs are the lists of
+// updated parameters and states.
+void optimizer_update_gpu(
+    const std::string& name,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    int n_states,
+    const std::vector<float>& hyperparameters,
+    const Stream& s) {
+  auto& d = metal::device(s.device);
+  int n_lists = n_states + 2;
+  int n_outputs = n_states + 1;
+  int n = outputs.size() / n_outputs;
+
+  std::vector<array> copies;
+  copies.reserve(inputs.size());
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  const array& lr = check_input(inputs[0]);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto concurrent_ctx = compute_encoder.start_concurrent();
+  for (int i = 0; i < n; i++) {
+    std::vector<const array*> in;
+    for (int j = 0; j < n_lists; j++) {
+      in.push_back(&check_input(inputs[1 + j * n + i]));
+    }
+
+    // Each output takes the buffer of its input when it can be donated and
+    // the kernel then reads the input through the output
+    for (int j = 0; j < n_outputs; j++) {
+      int src = (j == 0) ? 0 : j + 1;
+      auto& out = outputs[j * n + i];
+      if (in[src]->is_donatable()) {
+        out.move_shared_buffer(*in[src]);
+        in[src] = &out;
+      } else {
+        out.set_data(allocator::malloc_or_wait(out.nbytes()));
+      }
+    }
+
+    size_t size = outputs[i].size();
+    if (size == 0) {
+      continue;
+    }
+    auto kernel = d.get_kernel(name + "_" + type_to_name(outputs[i]));
+    compute_encoder->setComputePipelineState(kernel);
+    int idx = 0;
+    for (auto x : in) {
+      compute_encoder.set_input_array(*x, idx++);
+    }
+    compute_encoder.set_input_array(lr, idx++);
+    for (int j = 0; j < n_outputs; j++) {
+      compute_encoder.set_output_array(outputs[j * n + i], idx++);
+    }
+    for (auto& h : hyperparameters) {
+      compute_encoder->setBytes(&h, sizeof(float), idx++);
+    }
+    NS::UInteger group_size =
+        std::min<size_t>(size, kernel->maxTotalThreadsPerThreadgroup());
+    compute_encoder.dispatchThreads(
+        MTL::Size(size, 1, 1), MTL::Size(group_size, 1, 1));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace
+
+void AdamUpdate::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  optimizer_update_gpu(
+      "adam_update",
+      inputs,
+      outputs,
+      /* n_states = */ 2,
+      {beta1_, beta2_, eps_, weight_decay_},
+      stream());
+}
+
+void LionUpdate::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  optimizer_update_gpu(
+      "lion_update",
+      inputs,
+      outputs,
+      /* n_states = */ 1,
+      {beta1_, beta2_, weight_decay_},
+      stream());
+}
+
+} // namespace mlx::core::fast
@@ -0,0 +1,77 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/backend/metal/prepack.h"
+#include "mlx/backend/metal/metal.h"
+#include "mlx/transforms.h"
+
+namespace mlx::core::metal {
+
+void PrepackCache::insert(const std::vector<array>& weights) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  prune_();
+  for (auto& w : weights) {
+    entries_.insert({w.id(), Entry{w, {}}});
+  }
+}
+
+array PrepackCache::get(
+    const array& weight,
+    const std::string& tag,
+    const Stream& s,
+    const std::function<array()>& pack) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  prune_();
+  auto it = entries_.find(weight.id());
+  if (it == entries_.end()) {
+    return pack();
+  }
+
+  // A layout computed on another stream may still be in flight
+  auto key = tag + "_" + std::to_string(s.index);
+  auto& layouts = it->second.layouts;
+  if (auto l = layouts.find(key); l != layouts.end()) {
+    return l->second;
+  }
+  auto packed = pack();
+  layouts.insert({key, packed});
+  entries_.insert({packed.id(), Entry{packed, {}}});
+  return packed;
+}
+
+void PrepackCache::clear() {
+  std::lock_guard<std::mutex> lk(mtx_);
+  entries_.clear();
+}
+
+void PrepackCache::prune_() {
+  // Dropping a weight releases its layouts which may in turn only be held
+  // by their own entries
+  bool pruned = true;
+  while (pruned) {
+    pruned = false;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.weight.use_count() == 1) {
+        it = entries_.erase(it);
+        pruned = true;
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+PrepackCache& prepack_cache() {
+  static PrepackCache cache_;
+  return cache_;
+}
+
+void prepack(const std::vector<array>& weights) {
+  eval(weights);
+  prepack_cache().insert(weights);
+}
+
+void clear_prepacked() {
+  prepack_cache().clear();
+}
+
+} // namespace mlx::core::metal
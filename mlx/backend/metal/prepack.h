@@ -0,0 +1,57 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "mlx/array.h"
+#include "mlx/stream.h"
+
+namespace mlx::core::metal {
+
+// Weights registered with metal::prepack and the layouts the kernels
+// computed from them, e.g. the Winograd transform of a convolution filter.
+// A layout is computed on first use and reused until the weight is not used
+// anywhere else, at which point the weight and its layouts are dropped.
+class PrepackCache {
+ public:
+  PrepackCache() = default;
+
+  PrepackCache(const PrepackCache&) = delete;
+  PrepackCache& operator=(const PrepackCache&) = delete;
+
+  // Registers the weights. They must be evaluated.
+  void insert(const std::vector<array>& weights);
+
+  // Returns the layout of the weight named by tag. It is computed with pack
+  // on every call unless the weight is registered, in which case it is only
+  // computed once per stream and the result is registered as well so the
+  // layouts derived from it are kept too.
+  array get(
+      const array& weight,
+      const std::string& tag,
+      const Stream& s,
+      const std::function<array()>& pack);
+
+  // Drops every weight and layout
+  void clear();
+
+ private:
+  struct Entry {
+    array weight;
+    std::unordered_map<std::string, array> layouts;
+  };
+
+  // Drops the weights which are only held by the cache
+  void prune_();
+
+  std::unordered_map<std::uintptr_t, Entry> entries_;
+  std::mutex mtx_;
+};
+
+PrepackCache& prepack_cache();
+
+} // namespace mlx::core::metal
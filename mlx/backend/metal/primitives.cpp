@@ -1,6 +1,8 @@
 // Copyright © 2023-2024 Apple Inc.
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <numeric>
 #include <sstream>
 
@@ -266,6 +268,135 @@ void RandomBits::eval_gpu(const std::vector<array>& inputs, array& out) {
   compute_encoder.dispatchThreads(grid_dims, group_dims);
 }
 
+// The representable value next to x in the direction of zero
+template <typename T>
+float toward_zero(float x) {
+  using U = std::conditional_t<sizeof(T) == 2, uint16_t, uint32_t>;
+  T t = static_cast<T>(x);
+  U bits;
+  std::memcpy(&bits, &t, sizeof(T));
+  bits -= 1;
+  std::memcpy(&t, &bits, sizeof(T));
+  return static_cast<float>(t);
+}
+
+void RandomNormal::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 1);
+
+  auto& keys = inputs[0];
+  size_t num_keys = keys.size() / 2;
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  uint bytes_per_key = out.nbytes() / num_keys;
+  size_t out_per_key = (bytes_per_key + 4 - 1) / 4;
+  size_t half_size = out_per_key / 2;
+  bool odd = out_per_key % 2;
+
+  // The scale of the bits, the limits of the uniform samples and sqrt(2)
+  float params[4];
+  switch (out.dtype()) {
+    case float32:
+      params[0] = std::numeric_limits<uint32_t>::max();
+      params[1] = toward_zero<float>(-1.0f);
+      params[2] = toward_zero<float>(1.0f);
+      break;
+    case float16:
+      params[0] = std::numeric_limits<uint16_t>::max();
+      params[1] = toward_zero<float16_t>(-1.0f);
+      params[2] = toward_zero<float16_t>(1.0f);
+      break;
+    case bfloat16:
+      params[0] = std::numeric_limits<uint16_t>::max();
+      params[1] = toward_zero<bfloat16_t>(-1.0f);
+      params[2] = toward_zero<bfloat16_t>(1.0f);
+      break;
+    default:
+      throw std::runtime_error(
+          "[RandomNormal::eval_gpu] Only floating point types are supported.");
+  }
+  params[3] = std::sqrt(2.0);
+
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+  auto kernel = d.get_kernel("rnormal_" + type_to_name(out));
+
+  MTL::Size grid_dims = MTL::Size(num_keys, half_size + odd, 1);
+  NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
+  MTL::Size group_dims = MTL::Size(thread_group_size, 1, 1);
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(keys, 0);
+  compute_encoder.set_output_array(out, 1);
+  compute_encoder->setBytes(&odd, sizeof(bool), 2);
+  compute_encoder->setBytes(&bytes_per_key, sizeof(uint), 3);
+  int ndim = keys.ndim();
+  compute_encoder->setBytes(&ndim, sizeof(int), 4);
+  compute_encoder->setBytes(keys.shape().data(), keys.ndim() * sizeof(int), 5);
+  compute_encoder->setBytes(
+      keys.strides().data(), keys.ndim() * sizeof(size_t), 6);
+  compute_encoder->setBytes(params, sizeof(params), 7);
+  compute_encoder->setBytes(&loc_, sizeof(float), 8);
+  compute_encoder->setBytes(&scale_, sizeof(float), 9);
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+}
+
+void RandomDropout::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  copies.reserve(inputs.size());
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  const array& in = check_input(inputs[0]);
+  const array& keys = check_input(inputs[1]);
+
+  // Every element is read once before its output is written
+  if (in.is_donatable()) {
+    out.move_shared_buffer(in);
+  } else {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+
+  size_t size = out.size();
+  if (size > 0) {
+    double keep = 1.0 - p_;
+    uint threshold = std::min(
+        keep * 4294967296.0, double(std::numeric_limits<uint32_t>::max()));
+    float scale = 1.0 / keep;
+
+    auto kernel = d.get_kernel("rdropout_" + type_to_name(out));
+    size_t n_pairs = (size + 1) / 2;
+    NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
+    thread_group_size = std::min<size_t>(thread_group_size, n_pairs);
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(keys, 0);
+    compute_encoder.set_input_array(
+        in.data_shared_ptr() == nullptr ? out : in, 1);
+    compute_encoder.set_output_array(out, 2);
+    compute_encoder->setBytes(&threshold, sizeof(uint), 3);
+    compute_encoder->setBytes(&scale, sizeof(float), 4);
+    compute_encoder->setBytes(&size, sizeof(size_t), 5);
+    compute_encoder.dispatchThreads(
+        MTL::Size(n_pairs, 1, 1), MTL::Size(thread_group_size, 1, 1));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
 void Reshape::eval_gpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   const auto& in = inputs[0];
@@ -296,6 +427,59 @@ void Slice::eval_gpu(const std::vector<array>& inputs, array& out) {
   slice_gpu(in, out, start_indices_, strides_, stream());
 }
 
+void CacheAppend::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 2);
+  auto& s = stream();
+  auto& cache = inputs[0];
+  auto& upd = inputs[1];
+  auto& out = outputs[0];
+
+  if (!reuse_cache(cache, out)) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+    // Only the filled part of the cache is copied
+    if (offset_ > 0 && cache.size() > 0) {
+      auto shape = cache.shape();
+      shape[axis_] = offset_;
+      std::vector<int64_t> i_strides{
+          cache.strides().begin(), cache.strides().end()};
+      std::vector<int64_t> o_strides{
+          out.strides().begin(), out.strides().end()};
+      copy_gpu_inplace<int64_t>(
+          cache,
+          out,
+          shape,
+          i_strides,
+          o_strides,
+          0,
+          0,
+          CopyType::GeneralGeneral,
+          s);
+    }
+  }
+
+  if (upd.size() > 0) {
+    std::vector<int64_t> upd_strides{
+        upd.strides().begin(), upd.strides().end()};
+    std::vector<int64_t> out_strides{
+        out.strides().begin(), out.strides().end()};
+    copy_gpu_inplace<int64_t>(
+        upd,
+        out,
+        upd.shape(),
+        upd_strides,
+        out_strides,
+        0,
+        offset_ * out.strides()[axis_],
+        CopyType::GeneralGeneral,
+        s);
+  }
+
+  set_filled_view(out, outputs[1]);
+}
+
 void SliceUpdate::eval_gpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 2);
   if (out.size() == 0) {
@@ -342,27 +526,6 @@ void Transpose::eval_gpu(const std::vector<array>& inputs, array& out) {
   eval(inputs, out);
 }
 
-void QRF::eval_gpu(
-    const std::vector<array>& inputs,
-    std::vector<array>& outputs) {
-  throw std::runtime_error("[QRF::eval_gpu] Metal QR factorization NYI.");
-}
-
-void SVD::eval_gpu(
-    const std::vector<array>& inputs,
-    std::vector<array>& outputs) {
-  throw std::runtime_error("[SVD::eval_gpu] Metal SVD NYI.");
-}
-
-void Inverse::eval_gpu(const std::vector<array>& inputs, array& output) {
-  throw std::runtime_error("[Inverse::eval_gpu] Metal inversion NYI.");
-}
-
-void Cholesky::eval_gpu(const std::vector<array>& inputs, array& out) {
-  throw std::runtime_error(
-      "[Cholesky::eval_gpu] Metal Cholesky decomposition NYI.");
-}
-
 void View::eval_gpu(const std::vector<array>& inputs, array& out) {
   auto& in = inputs[0];
   auto ibytes = size_of(in.dtype());
@@ -0,0 +1,202 @@
+// Copyright © 2024 Apple Inc.
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include "mlx/backend/metal/metal.h"
+#include "mlx/backend/metal/metal_impl.h"
+#include "mlx/backend/metal/profiler.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/stream.h"
+
+namespace mlx::core::metal {
+
+namespace {
+
+// Pairs of timestamps in the sample buffer. Slots are reused round robin so
+// this bounds the number of primitives which can be in flight.
+constexpr int profile_slots = 4096;
+
+struct ProfileEvent {
+  std::string name;
+  int stream;
+  uint64_t begin;
+  uint64_t end;
+};
+
+struct Profiler {
+  std::atomic<bool> enabled{false};
+  std::mutex mtx;
+  MTL::CounterSampleBuffer* samples{nullptr};
+  int next_slot{0};
+
+  // CPU and GPU timestamps taken together to convert GPU timestamps to
+  // nanoseconds
+  MTL::Timestamp cpu_start;
+  MTL::Timestamp gpu_start;
+  std::vector<ProfileEvent> events;
+};
+
+Profiler& profiler() {
+  static Profiler profiler_;
+  return profiler_;
+}
+
+MTL::CounterSampleBuffer* new_sample_buffer(MTL::Device* device) {
+  if (!device->supportsCounterSampling(
+          MTL::CounterSamplingPointAtStageBoundary)) {
+    return nullptr;
+  }
+  MTL::CounterSet* timestamps = nullptr;
+  auto sets = device->counterSets();
+  for (int i = 0; sets && i < sets->count(); i++) {
+    auto set = static_cast<MTL::CounterSet*>(sets->object(i));
+    if (set->name()->isEqualToString(MTL::CommonCounterSetTimestamp)) {
+      timestamps = set;
+    }
+  }
+  if (!timestamps) {
+    return nullptr;
+  }
+
+  auto desc = MTL::CounterSampleBufferDescriptor::alloc()->init();
+  desc->setCounterSet(timestamps);
+  desc->setStorageMode(MTL::StorageModeShared);
+  desc->setSampleCount(2 * profile_slots);
+  NS::Error* error = nullptr;
+  auto samples = device->newCounterSampleBuffer(desc, &error);
+  desc->release();
+  return samples;
+}
+
+// Converts GPU timestamps to nanoseconds since profiling started
+double gpu_to_ns(MTL::Device* device, const Profiler& p) {
+  MTL::Timestamp cpu_now;
+  MTL::Timestamp gpu_now;
+  device->sampleTimestamps(&cpu_now, &gpu_now);
+  if (gpu_now <= p.gpu_start) {
+    return 1.0;
+  }
+  return static_cast<double>(cpu_now - p.cpu_start) /
+      static_cast<double>(gpu_now - p.gpu_start);
+}
+
+} // namespace
+
+bool is_profiling() {
+  return profiler().enabled;
+}
+
+int profile_begin(Device& d, int index) {
+  auto& p = profiler();
+  int slot;
+  {
+    std::lock_guard<std::mutex> lk(p.mtx);
+    slot = p.next_slot;
+    p.next_slot = (p.next_slot + 1) % profile_slots;
+  }
+  auto pass = MTL::ComputePassDescriptor::computePassDescriptor();
+  auto attachment = pass->sampleBufferAttachments()->object(0);
+  attachment->setSampleBuffer(p.samples);
+  attachment->setStartOfEncoderSampleIndex(2 * slot);
+  attachment->setEndOfEncoderSampleIndex(2 * slot + 1);
+  d.new_command_encoder(index, pass);
+  return slot;
+}
+
+void profile_end(
+    Device& d,
+    int index,
+    int slot,
+    MTL::CommandBuffer* command_buffer,
+    Primitive& primitive) {
+  d.end_encoding(index);
+  command_buffer->addCompletedHandler(
+      [slot, index, name = get_primitive_string(&primitive)](
+          MTL::CommandBuffer*) mutable {
+        auto pool = new_scoped_memory_pool();
+        auto& p = profiler();
+        auto data = p.samples->resolveCounterRange(NS::Range(2 * slot, 2));
+        if (!data) {
+          return;
+        }
+        auto ts = static_cast<const MTL::CounterResultTimestamp*>(
+            data->mutableBytes());
+        if (ts[0].timestamp == MTL::CounterErrorValue ||
+            ts[1].timestamp == MTL::CounterErrorValue ||
+            ts[1].timestamp < ts[0].timestamp) {
+          return;
+        }
+        std::lock_guard<std::mutex> lk(p.mtx);
+        p.events.push_back(
+            {std::move(name), index, ts[0].timestamp, ts[1].timestamp});
+      });
+}
+
+void start_profiling() {
+  auto pool = new_scoped_memory_pool();
+  auto& p = profiler();
+  auto device = metal::device(mlx::core::Device::gpu).mtl_device();
+  std::lock_guard<std::mutex> lk(p.mtx);
+  if (!p.samples) {
+    p.samples = new_sample_buffer(device);
+    if (!p.samples) {
+      throw std::runtime_error(
+          "[metal::start_profiling] GPU timestamps are not supported on this "
+          "device.");
+    }
+  }
+  p.events.clear();
+  device->sampleTimestamps(&p.cpu_start, &p.gpu_start);
+  p.enabled = true;
+}
+
+void stop_profiling() {
+  profiler().enabled = false;
+  synchronize();
+}
+
+std::unordered_map<std::string, std::pair<size_t, double>> get_profile() {
+  auto& p = profiler();
+  auto& d = metal::device(mlx::core::Device::gpu);
+  auto scale = gpu_to_ns(d.mtl_device(), p);
+  std::unordered_map<std::string, std::pair<size_t, double>> stats;
+  std::lock_guard<std::mutex> lk(p.mtx);
+  for (auto& e : p.events) {
+    auto& [count, msec] = stats[e.name];
+    count++;
+    msec += (e.end - e.begin) * scale * 1e-6;
+  }
+  return stats;
+}
+
+void save_profile_trace(const std::string& path) {
+  auto& p = profiler();
+  auto& d = metal::device(mlx::core::Device::gpu);
+  auto scale = gpu_to_ns(d.mtl_device(), p);
+  std::ofstream os(path);
+  if (!os) {
+    throw std::runtime_error(
+        "[metal::save_profile_trace] Cannot open " + path + " for writing.");
+  }
+
+  // Chrome trace event format with times in microseconds
+  auto to_us = [&](uint64_t t) {
+    return (static_cast<double>(t) - static_cast<double>(p.gpu_start)) *
+        scale * 1e-3;
+  };
+  std::lock_guard<std::mutex> lk(p.mtx);
+  os << "{\"traceEvents\": [";
+  for (int i = 0; i < p.events.size(); i++) {
+    auto& e = p.events[i];
+    os << (i > 0 ? ",\n" : "\n") << "{\"name\": \"" << e.name
+       << "\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+       << e.stream << ", \"ts\": " << to_us(e.begin)
+       << ", \"dur\": " << to_us(e.end) - to_us(e.begin) << "}";
+  }
+  os << "\n]}\n";
+}
+
+} // namespace mlx::core::metal
@@ -0,0 +1,25 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/backend/metal/device.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core::metal {
+
+bool is_profiling();
+
+// Starts a new encoder for the stream whose start and end are timestamped.
+// Returns the slot of the timestamps to pass to profile_end.
+int profile_begin(Device& d, int index);
+
+// Ends the encoder and, once the command buffer completes, records the time
+// between the timestamps in slot for the primitive.
+void profile_end(
+    Device& d,
+    int index,
+    int slot,
+    MTL::CommandBuffer* command_buffer,
+    Primitive& primitive);
+
+} // namespace mlx::core::metal
@@ -1,12 +1,15 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
+#include <sstream>
 
 #include "mlx/backend/common/compiled.h"
 #include "mlx/backend/metal/copy.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
 #include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
@@ -212,6 +215,86 @@ void QuantizedMatmul::eval_gpu(const std::vector<array>& inputs, array& out) {
       [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
 }
 
+namespace {
+
+void gather_qmm_rhs(
+    const array& x_,
+    const array& w_,
+    const array& scales_,
+    const array& biases_,
+    const array& indices_,
+    array& out,
+    bool transpose,
+    int group_size,
+    int bits,
+    metal::Device& d,
+    const Stream& s) {
+  std::vector<array> copies;
+  auto ensure_row_contiguous = [&copies, &s](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      copies.push_back(arr_copy);
+      return arr_copy;
+    }
+  };
+  auto x = ensure_row_contiguous(x_);
+  auto w = ensure_row_contiguous(w_);
+  auto scales = ensure_row_contiguous(scales_);
+  auto biases = ensure_row_contiguous(biases_);
+  auto indices = ensure_row_contiguous(indices_);
+
+  // x is multiplied as a single matrix with a row per index
+  int K = x.shape(-1);
+  int M = x.size() / K;
+  int N = out.shape(-1);
+
+  int wm = 1;
+  int wn = 2;
+  int bm = 16;
+  int bn = 32;
+  std::ostringstream kname;
+  std::string aligned_n = (N % bn) == 0 ? "true" : "false";
+  auto type_string = get_type_string(out.dtype());
+  kname << "bs_qmm_rhs_" << (transpose ? 't' : 'n') << "_" << type_string
+        << "_gs_" << group_size << "_b_" << bits << "_alN_" << aligned_n;
+
+  // Encode and dispatch kernel
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto template_def = get_template_definition(
+      kname.str(),
+      "bs_qmm_rhs",
+      type_string,
+      group_size,
+      bits,
+      transpose ? "true" : "false",
+      aligned_n);
+  auto kernel = get_quantized_kernel(d, kname.str(), template_def);
+  compute_encoder->setComputePipelineState(kernel);
+
+  MTL::Size group_dims = MTL::Size(32, wn, wm);
+  MTL::Size grid_dims = MTL::Size((N + bn - 1) / bn, (M + bm - 1) / bm, 1);
+
+  compute_encoder.set_input_array(x, 0);
+  compute_encoder.set_input_array(w, 1);
+  compute_encoder.set_input_array(scales, 2);
+  compute_encoder.set_input_array(biases, 3);
+  compute_encoder.set_input_array(indices, 4);
+  compute_encoder.set_output_array(out, 5);
+  compute_encoder->setBytes(&M, sizeof(int), 6);
+  compute_encoder->setBytes(&N, sizeof(int), 7);
+  compute_encoder->setBytes(&K, sizeof(int), 8);
+
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace
+
 void GatherQMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 6);
 
@@ -226,6 +309,26 @@ void GatherQMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   auto& lhs_indices = inputs[4];
   auto& rhs_indices = inputs[5];
 
+  // Multiply the rows of x that use the same matrix of w together when the
+  // indices are sorted and every row of x is its own batch element
+  int n_rows = x_pre.size() / x_pre.shape(-1);
+  if (right_sorted_ && x_pre.shape(-2) == 1 && n_rows >= 16 &&
+      n_rows == rhs_indices.size()) {
+    gather_qmm_rhs(
+        x_pre,
+        w_pre,
+        scales_pre,
+        biases_pre,
+        rhs_indices,
+        out,
+        transpose_,
+        group_size_,
+        bits_,
+        d,
+        s);
+    return;
+  }
+
   // TODO: collapse batch dims
   auto& batch_shape = lhs_indices.shape();
   int batch_ndims = batch_shape.size();
@@ -513,4 +616,386 @@ void GatherQMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   }
 }
 
+namespace {
+
+// Dispatches a thread per pack of quantized values, a uint32 or 3 bytes for
+// 3 and 6 bits
+void dispatch_affine_quantize(
+    metal::Device& d,
+    const Stream& s,
+    const std::string& name,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    Dtype dtype,
+    size_t size,
+    int group_size,
+    int bits) {
+  size_t pack_factor = (32 % bits == 0) ? 32 / bits : 24 / bits;
+  size_t n_packs = size / pack_factor;
+  if (n_packs == 0) {
+    return;
+  }
+
+  std::ostringstream kname;
+  auto type_string = get_type_string(dtype);
+  kname << name << "_" << type_string << "_gs_" << group_size << "_b_"
+        << bits;
+  auto template_def = get_template_definition(
+      kname.str(), name, type_string, group_size, bits);
+  auto kernel = get_quantized_kernel(d, kname.str(), template_def);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  int idx = 0;
+  for (auto& in : inputs) {
+    compute_encoder.set_input_array(in, idx++);
+  }
+  for (auto& out : outputs) {
+    compute_encoder.set_output_array(out, idx++);
+  }
+
+  // The threadgroups start at multiples of the simd size so the packs of a
+  // group share a simdgroup
+  NS::UInteger n_threads =
+      std::min<size_t>(n_packs, kernel->maxTotalThreadsPerThreadgroup());
+  compute_encoder.dispatchThreads(
+      MTL::Size(n_packs, 1, 1), MTL::Size(n_threads, 1, 1));
+}
+
+} // namespace
+
+void Quantize::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto w = inputs[0];
+  if (!w.flags().row_contiguous) {
+    array w_copy(w.shape(), w.dtype(), nullptr, {});
+    copy_gpu(w, w_copy, CopyType::General, s);
+    copies.push_back(w_copy);
+    w = w_copy;
+  }
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+
+  dispatch_affine_quantize(
+      d,
+      s,
+      "affine_quantize",
+      {w},
+      outputs,
+      w.dtype(),
+      w.size(),
+      group_size_,
+      bits_);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void Dequantize::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 3);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto ensure_row_contiguous = [&copies, &s](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      copies.push_back(arr_copy);
+      return arr_copy;
+    }
+  };
+  std::vector<array> ins = {
+      ensure_row_contiguous(inputs[0]),
+      ensure_row_contiguous(inputs[1]),
+      ensure_row_contiguous(inputs[2])};
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  std::vector<array> outs = {out};
+  dispatch_affine_quantize(
+      d,
+      s,
+      "affine_dequantize",
+      ins,
+      outs,
+      out.dtype(),
+      out.size(),
+      group_size_,
+      bits_);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void Fp8Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto ensure_row_contiguous = [&copies, &s](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      copies.push_back(arr_copy);
+      return arr_copy;
+    }
+  };
+  auto x = ensure_row_contiguous(inputs[0]);
+  auto w = ensure_row_contiguous(inputs[1]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  int N = w.shape(0);
+  int K = w.shape(1);
+  if (out.size() == 0) {
+    return;
+  }
+  int M = out.size() / N;
+
+  // Few rows read each weight once in a gemv, more use the tiled gemm
+  bool e5m2 = format_ == "e5m2";
+  int bm = 0, bn = 0, bk = 32, wm = 2, wn = 2, max_rows = 0;
+  std::ostringstream kname;
+  if (M <= 8) {
+    max_rows = M == 1 ? 1 : 8;
+    kname << "fp8_gemv_" << format_ << "_" << type_to_name(out) << "_m"
+          << max_rows;
+  } else {
+    bm = bn = (size_t(M) * N >= (1ul << 20)) ? 64 : 32;
+    kname << "steel_fp8_gemm_" << format_ << "_" << type_to_name(out) << "_bm"
+          << bm << "_bn" << bn << "_bk" << bk << "_wm" << wm << "_wn" << wn;
+  }
+  auto kernel = get_steel_gemm_fp8_kernel(
+      d, kname.str(), out, e5m2, bm, bn, bk, wm, wn, max_rows);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(x, 0);
+  compute_encoder.set_input_array(w, 1);
+  compute_encoder.set_output_array(out, 2);
+  compute_encoder->setBytes(&M, sizeof(int), 3);
+  compute_encoder->setBytes(&N, sizeof(int), 4);
+  compute_encoder->setBytes(&K, sizeof(int), 5);
+  if (bm == 0) {
+    // Two simdgroups of four rows each per threadgroup
+    constexpr int rows_per_group = 8;
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size((N + rows_per_group - 1) / rows_per_group, 1, 1),
+        MTL::Size(64, 1, 1));
+  } else {
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size((N + bn - 1) / bn, (M + bm - 1) / bm, 1),
+        MTL::Size(32, wn, wm));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+namespace fast {
+
+void QuantizedMatmulEpilogue::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  assert(
+      inputs.size() ==
+      4 + has_bias_ + has_gate_ + has_residual_ + 2 * has_lora_ +
+          has_adapter_ids_);
+
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  std::vector<array> ins;
+  for (auto& arr : inputs) {
+    if (arr.flags().row_contiguous) {
+      ins.push_back(arr);
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      copies.push_back(arr_copy);
+      ins.push_back(arr_copy);
+    }
+  }
+  auto& x = ins[0];
+  auto& w = ins[1];
+  auto& scales = ins[2];
+  auto& biases = ins[3];
+
+  int D = x.shape(-1);
+  int B = x.size() / D;
+  int O = out.shape(-1);
+
+  // The epilogue terms and the low-rank update are bound after the arguments
+  // of the matmul kernels and selected with function constants
+  std::string hash_name = std::string("_bias_") + (has_bias_ ? 't' : 'n') +
+      "_gate_" + (has_gate_ ? 't' : 'n') + "_residual_" +
+      (has_residual_ ? 't' : 'n') + "_lora_" + (has_lora_ ? 't' : 'n') +
+      "_ids_" + (has_adapter_ids_ ? 't' : 'n');
+  metal::MTLFCList func_consts = {
+      {&has_bias_, MTL::DataType::DataTypeBool, 400},
+      {&has_gate_, MTL::DataType::DataTypeBool, 401},
+      {&has_residual_, MTL::DataType::DataTypeBool, 402},
+      {&has_lora_, MTL::DataType::DataTypeBool, 403},
+      {&has_adapter_ids_, MTL::DataType::DataTypeBool, 404},
+  };
+  int rank = has_lora_ ? ins[ins.size() - 1 - has_adapter_ids_].shape(-1) : 0;
+  auto set_epilogue = [&](metal::CommandEncoder& compute_encoder, int index) {
+    int i = 4;
+    for (bool has_term : {has_bias_, has_gate_, has_residual_}) {
+      if (has_term) {
+        compute_encoder.set_input_array(ins[i++], index);
+      }
+      index++;
+    }
+    if (has_lora_) {
+      compute_encoder.set_input_array(ins[i++], index);
+      compute_encoder.set_input_array(ins[i++], index + 1);
+      if (has_adapter_ids_) {
+        compute_encoder.set_input_array(ins[i++], index + 2);
+      }
+      compute_encoder->setBytes(&rank, sizeof(int), index + 3);
+    }
+  };
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto type_string = get_type_string(x.dtype());
+
+  // Route to the fast qmv kernel
+  if (B < 6) {
+    std::ostringstream kname;
+    kname << "qmv_" << type_string << "_gs_" << group_size_ << "_b_" << bits_
+          << "_fast_epilogue";
+    auto template_def = get_template_definition(
+        kname.str(), "qmv_fast_epilogue", type_string, group_size_, bits_);
+    auto kernel = get_quantized_kernel(
+        d, kname.str(), template_def, kname.str() + hash_name, func_consts);
+    compute_encoder->setComputePipelineState(kernel);
+
+    int bo = 8;
+    int bd = 32;
+    MTL::Size group_dims = MTL::Size(bd, 2, 1);
+    MTL::Size grid_dims = MTL::Size(O / bo, B, 1);
+
+    compute_encoder.set_input_array(w, 0);
+    compute_encoder.set_input_array(scales, 1);
+    compute_encoder.set_input_array(biases, 2);
+    compute_encoder.set_input_array(x, 3);
+    compute_encoder.set_output_array(out, 4);
+    compute_encoder->setBytes(&D, sizeof(int), 5);
+    compute_encoder->setBytes(&O, sizeof(int), 6);
+    set_epilogue(compute_encoder, 7);
+
+    compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+  }
+
+  // Route to the qmm_t kernel
+  else {
+    std::ostringstream kname;
+    std::string aligned_n = (O % 32) == 0 ? "true" : "false";
+    kname << "qmm_t_" << type_string << "_gs_" << group_size_ << "_b_"
+          << bits_ << "_alN_" << aligned_n << "_epilogue";
+    auto template_def = get_template_definition(
+        kname.str(),
+        "qmm_t_epilogue",
+        type_string,
+        group_size_,
+        bits_,
+        aligned_n);
+    auto kernel = get_quantized_kernel(
+        d, kname.str(), template_def, kname.str() + hash_name, func_consts);
+    compute_encoder->setComputePipelineState(kernel);
+
+    int wn = 2;
+    int wm = 2;
+    int bm = 32;
+    int bn = 32;
+    MTL::Size group_dims = MTL::Size(32, wn, wm);
+    MTL::Size grid_dims = MTL::Size((O + bn - 1) / bn, (B + bm - 1) / bm, 1);
+
+    compute_encoder.set_input_array(x, 0);
+    compute_encoder.set_input_array(w, 1);
+    compute_encoder.set_input_array(scales, 2);
+    compute_encoder.set_input_array(biases, 3);
+    compute_encoder.set_output_array(out, 4);
+    compute_encoder->setBytes(&B, sizeof(int), 5);
+    compute_encoder->setBytes(&O, sizeof(int), 6);
+    compute_encoder->setBytes(&D, sizeof(int), 7);
+    set_epilogue(compute_encoder, 8);
+
+    compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void QuantizedMatmulW8A8::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  assert(inputs.size() == 5);
+
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  std::vector<array> ins;
+  for (auto& arr : inputs) {
+    if (arr.flags().row_contiguous) {
+      ins.push_back(arr);
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      copies.push_back(arr_copy);
+      ins.push_back(arr_copy);
+    }
+  }
+  auto& x_q = ins[0];
+
+  int D = x_q.shape(-1);
+  int B = x_q.size() / D;
+  int O = out.shape(-1);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto type_string = get_type_string(out.dtype());
+  std::ostringstream kname;
+  kname << "qmm_w8a8_t_" << type_string << "_gs_" << group_size_;
+  auto template_def = get_template_definition(
+      kname.str(), "qmm_w8a8_t", type_string, group_size_);
+  auto kernel = get_quantized_kernel(d, kname.str(), template_def);
+  compute_encoder->setComputePipelineState(kernel);
+
+  int bm = 32;
+  int bn = 32;
+  MTL::Size group_dims = MTL::Size(256, 1, 1);
+  MTL::Size grid_dims = MTL::Size((O + bn - 1) / bn, (B + bm - 1) / bm, 1);
+
+  for (int i = 0; i < 5; i++) {
+    compute_encoder.set_input_array(ins[i], i);
+  }
+  compute_encoder.set_output_array(out, 5);
+  compute_encoder->setBytes(&B, sizeof(int), 6);
+  compute_encoder->setBytes(&O, sizeof(int), 7);
+  compute_encoder->setBytes(&D, sizeof(int), 8);
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace fast
+
 } // namespace mlx::core
@@ -301,7 +301,9 @@ void row_reduce_general_dispatch(
   }
 }
 
-void strided_reduce_general_dispatch(
+// One thread per output looping over every reduced element. The input is
+// indexed with the plan and the non reduced strides so any layout works.
+void strided_reduce_small_dispatch(
     const array& in,
     array& out,
     const std::string& op_name,
@@ -310,8 +312,6 @@ void strided_reduce_general_dispatch(
     CommandEncoder& compute_encoder,
     metal::Device& d,
     const Stream& s) {
-  Dtype out_dtype = out.dtype();
-
   // Prepare the arguments for the kernel
   size_t reduction_size = plan.shape.back();
   size_t reduction_stride = plan.strides.back();
@@ -338,42 +338,77 @@ void strided_reduce_general_dispatch(
   }
   int ndim = shape.size();
 
-  // Specialize for small dims
-  if (reduction_size * non_col_reductions < 16) {
-    // Select kernel
-    auto kernel = get_reduce_kernel(
-        d, "colSmall_reduce_" + op_name + type_to_name(in), op_name, in, out);
-    compute_encoder->setComputePipelineState(kernel);
+  // Select kernel
+  auto kernel = get_reduce_kernel(
+      d, "colSmall_reduce_" + op_name + type_to_name(in), op_name, in, out);
+  compute_encoder->setComputePipelineState(kernel);
 
-    // Select block dims
-    MTL::Size grid_dims = MTL::Size(out_size, 1, 1);
-    MTL::Size group_dims = MTL::Size(256ul, 1, 1);
+  // Select block dims
+  MTL::Size grid_dims = MTL::Size(out_size, 1, 1);
+  MTL::Size group_dims = MTL::Size(256ul, 1, 1);
 
-    if (non_col_ndim == 0) {
-      non_col_shapes = {1};
-      non_col_strides = {1};
-    }
+  if (non_col_ndim == 0) {
+    non_col_shapes = {1};
+    non_col_strides = {1};
+  }
 
-    // Encode arrays
-    compute_encoder.set_input_array(in, 0);
-    compute_encoder.set_output_array(out, 1);
-    compute_encoder->setBytes(&reduction_size, sizeof(size_t), 2);
-    compute_encoder->setBytes(&reduction_stride, sizeof(size_t), 3);
-    compute_encoder->setBytes(&out_size, sizeof(size_t), 4);
-    compute_encoder->setBytes(shape.data(), shape.size() * sizeof(int), 5);
-    compute_encoder->setBytes(
-        strides.data(), strides.size() * sizeof(size_t), 6);
-    compute_encoder->setBytes(&ndim, sizeof(int), 7);
-    compute_encoder->setBytes(&non_col_reductions, sizeof(size_t), 8);
-    compute_encoder->setBytes(
-        non_col_shapes.data(), non_col_shapes.size() * sizeof(int), 9);
-    compute_encoder->setBytes(
-        non_col_strides.data(), non_col_shapes.size() * sizeof(size_t), 10);
-    compute_encoder->setBytes(&non_col_ndim, sizeof(int), 11);
+  // Encode arrays
+  compute_encoder.set_input_array(in, 0);
+  compute_encoder.set_output_array(out, 1);
+  compute_encoder->setBytes(&reduction_size, sizeof(size_t), 2);
+  compute_encoder->setBytes(&reduction_stride, sizeof(size_t), 3);
+  compute_encoder->setBytes(&out_size, sizeof(size_t), 4);
+  compute_encoder->setBytes(shape.data(), shape.size() * sizeof(int), 5);
+  compute_encoder->setBytes(strides.data(), strides.size() * sizeof(size_t), 6);
+  compute_encoder->setBytes(&ndim, sizeof(int), 7);
+  compute_encoder->setBytes(&non_col_reductions, sizeof(size_t), 8);
+  compute_encoder->setBytes(
+      non_col_shapes.data(), non_col_shapes.size() * sizeof(int), 9);
+  compute_encoder->setBytes(
+      non_col_strides.data(), non_col_shapes.size() * sizeof(size_t), 10);
+  compute_encoder->setBytes(&non_col_ndim, sizeof(int), 11);
+
+  // Dispatch threads
+  compute_encoder.dispatchThreads(grid_dims, group_dims);
+}
 
-    // Dispatch threads
-    compute_encoder.dispatchThreads(grid_dims, group_dims);
+void strided_reduce_general_dispatch(
+    const array& in,
+    array& out,
+    const std::string& op_name,
+    const ReductionPlan& plan,
+    const std::vector<int>& axes,
+    CommandEncoder& compute_encoder,
+    metal::Device& d,
+    const Stream& s) {
+  Dtype out_dtype = out.dtype();
+
+  // Prepare the arguments for the kernel
+  size_t reduction_size = plan.shape.back();
+  size_t reduction_stride = plan.strides.back();
+  size_t out_size = out.size();
+  auto shape = plan.shape;
+  auto strides = plan.strides;
+  shape.pop_back();
+  strides.pop_back();
+  size_t non_col_reductions = 1;
+  for (auto s : shape) {
+    non_col_reductions *= static_cast<size_t>(s);
+  }
 
+  auto [rem_shape, rem_strides] = shapes_without_reduction_axes(in, axes);
+  for (auto s : rem_shape) {
+    shape.push_back(s);
+  }
+  for (auto s : rem_strides) {
+    strides.push_back(s);
+  }
+  int ndim = shape.size();
+
+  // Specialize for small dims
+  if (reduction_size * non_col_reductions < 16) {
+    strided_reduce_small_dispatch(
+        in, out, op_name, plan, axes, compute_encoder, d, s);
     return;
   }
 
@@ -604,8 +639,19 @@ void Reduce::eval_gpu(const std::vector<array>& inputs, array& out) {
     std::vector<array> copies;
     ReductionPlan plan = get_reduction_plan(in, axes_);
 
-    // If it is a general reduce then copy the input to a contiguous array and
-    // recompute the plan.
+    // A general reduce with enough short outputs to fill the GPU reads the
+    // input in place with one thread per output.
+    if (plan.type == GeneralReduce) {
+      size_t reduction_size = in.size() / std::max<size_t>(out.size(), 1);
+      if (out.size() >= 4096 && reduction_size <= 1024) {
+        strided_reduce_small_dispatch(
+            in, out, op_name, plan, axes_, compute_encoder, d, s);
+        return;
+      }
+    }
+
+    // Otherwise if it is a general reduce then copy the input to a contiguous
+    // array and recompute the plan.
     if (plan.type == GeneralReduce) {
       array in_copy(in.shape(), in.dtype(), nullptr, {});
       copy_gpu(in, in_copy, CopyType::General, s);
@@ -0,0 +1,115 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/backend/metal/resident.h"
+#include "mlx/backend/metal/metal_impl.h"
+
+#include <sstream>
+
+namespace mlx::core::metal {
+
+ResidencySet::ResidencySet(MTL::Device* d) {
+  if (__builtin_available(macOS 15, iOS 18, *)) {
+    auto pool = new_scoped_memory_pool();
+    auto desc = MTL::ResidencySetDescriptor::alloc()->init();
+    NS::Error* error = nullptr;
+    wired_set_ = d->newResidencySet(desc, &error);
+    desc->release();
+    if (!wired_set_) {
+      std::ostringstream msg;
+      msg << "[metal::ResidencySet] Failed to create residency set";
+      if (error) {
+        msg << ": " << error->localizedDescription()->utf8String();
+      }
+      throw std::runtime_error(msg.str());
+    }
+  }
+}
+
+ResidencySet::~ResidencySet() {
+  if (wired_set_) {
+    auto pool = new_scoped_memory_pool();
+    wired_set_->release();
+  }
+}
+
+void ResidencySet::insert(const std::vector<MTL::Buffer*>& buffers) {
+  if (!wired_set_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto pool = new_scoped_memory_pool();
+  std::vector<MTL::Buffer*> added;
+  for (auto buf : buffers) {
+    if (buf && buffers_.insert(buf).second) {
+      size_ += buf->length();
+      added.push_back(buf);
+    }
+  }
+  if (resident_ && size_ <= capacity_) {
+    for (auto buf : added) {
+      wired_set_->addAllocation(buf);
+    }
+    wired_set_->commit();
+    wired_set_->requestResidency();
+  } else {
+    update_residency_();
+  }
+}
+
+void ResidencySet::erase(MTL::Buffer* buffer) {
+  // Called for every freed buffer so skip the lock when the set is empty
+  if (!wired_set_ || size_ == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (buffers_.erase(buffer) == 0) {
+    return;
+  }
+  auto pool = new_scoped_memory_pool();
+  size_ -= buffer->length();
+  if (resident_) {
+    wired_set_->removeAllocation(buffer);
+    wired_set_->commit();
+  } else {
+    update_residency_();
+  }
+}
+
+size_t ResidencySet::resize(size_t capacity) {
+  std::lock_guard<std::mutex> lk(mtx_);
+  std::swap(capacity, capacity_);
+  if (wired_set_) {
+    auto pool = new_scoped_memory_pool();
+    update_residency_();
+  }
+  return capacity;
+}
+
+size_t ResidencySet::wired_size() {
+  std::lock_guard<std::mutex> lk(mtx_);
+  return resident_ ? size_ : 0;
+}
+
+void ResidencySet::update_residency_() {
+  // The set is attached to the command queues, so the buffers are only kept
+  // in it while they fit in the capacity
+  bool fits = size_ > 0 && size_ <= capacity_;
+  if (fits == resident_) {
+    return;
+  }
+  if (fits) {
+    for (auto buf : buffers_) {
+      wired_set_->addAllocation(buf);
+    }
+    wired_set_->commit();
+    // Wire the buffers now rather than on the next command buffer
+    wired_set_->requestResidency();
+  } else {
+    wired_set_->removeAllAllocations();
+    wired_set_->commit();
+    wired_set_->endResidency();
+  }
+  resident_ = fits;
+}
+
+} // namespace mlx::core::metal
@@ -0,0 +1,56 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+#include "mlx/backend/metal/device.h"
+
+namespace mlx::core::metal {
+
+// Buffers which are kept resident, i.e. wired in memory so the OS does not
+// page out or compress them, with an MTLResidencySet. The buffers are only
+// wired while their total size is within the capacity. Without residency set
+// support (before macOS 15) it does nothing.
+class ResidencySet {
+ public:
+  ResidencySet(MTL::Device* d);
+  ~ResidencySet();
+
+  ResidencySet(const ResidencySet&) = delete;
+  ResidencySet& operator=(const ResidencySet&) = delete;
+
+  const MTL::ResidencySet* mtl_residency_set() {
+    return wired_set_;
+  }
+
+  // Adds the buffers to the set. Buffers already in it are skipped.
+  void insert(const std::vector<MTL::Buffer*>& buffers);
+
+  // Removes the buffer, if it is in the set, before it is released or
+  // recycled for other allocations.
+  void erase(MTL::Buffer* buffer);
+
+  // Returns the previous capacity
+  size_t resize(size_t capacity);
+
+  // Bytes currently wired
+  size_t wired_size();
+
+ private:
+  // Moves the buffers in or out of the MTLResidencySet when whether they
+  // fit in the capacity changes
+  void update_residency_();
+
+  MTL::ResidencySet* wired_set_{nullptr};
+  std::unordered_set<MTL::Buffer*> buffers_;
+  std::atomic<size_t> size_{0};
+  size_t capacity_{0};
+  // Whether the buffers are in the MTLResidencySet
+  bool resident_{false};
+  std::mutex mtx_;
+};
+
+} // namespace mlx::core::metal
@@ -8,10 +8,11 @@ namespace mlx::core::fast {
 void RoPE::eval_gpu(
     const std::vector<array>& inputs,
     std::vector<array>& outputs) {
-  assert(inputs.size() == 1);
+  assert(inputs.size() == 2 || inputs.size() == 3);
   assert(outputs.size() == 1);
   auto& in = inputs[0];
   auto& out = outputs[0];
+  bool with_freqs = inputs.size() == 3;
 
   if (in.ndim() < 3) {
     throw std::runtime_error("[RoPE] Input must have at least 3 dimensions");
@@ -20,6 +21,15 @@ void RoPE::eval_gpu(
   auto& s = out.primitive().stream();
   auto& d = metal::device(s.device);
 
+  // The kernel indexes the offsets contiguously
+  std::vector<array> copies;
+  auto offset = inputs[1];
+  if (!offset.flags().row_contiguous) {
+    copies.push_back(array(offset.shape(), offset.dtype(), nullptr, {}));
+    copy_gpu(offset, copies.back(), CopyType::General, s);
+    offset = copies.back();
+  }
+
   size_t strides[3];
   size_t out_strides[3];
   bool donated = false;
@@ -63,27 +73,39 @@ void RoPE::eval_gpu(
   out_strides[2] = out.strides()[ndim - 1];
 
   std::ostringstream kname;
-  kname << "rope_" << (forward_ ? "" : "vjp_")
+  kname << "rope_" << (with_freqs ? "freqs_" : "") << (forward_ ? "" : "vjp_")
         << (traditional_ ? "traditional_" : "") << type_to_name(in);
   auto kernel = d.get_kernel(kname.str());
   auto& compute_encoder = d.get_command_encoder(s.index);
 
+  int dim0 = dims_ / 2;
+  int dim1 = in.shape(-2);
+  int dim2 = in.size() / mat_size;
+
+  // Every offset covers a contiguous block of the flattened batch
+  size_t offset_stride = dim2 / offset.size();
   float base = std::log2(base_);
   compute_encoder->setComputePipelineState(kernel);
   compute_encoder.set_input_array(donated ? out : in, 0);
   compute_encoder.set_output_array(out, 1);
-  compute_encoder->setBytes(&strides, 3 * sizeof(size_t), 2);
-  compute_encoder->setBytes(&out_strides, 3 * sizeof(size_t), 3);
-  compute_encoder->setBytes(&offset_, sizeof(int), 4);
-  compute_encoder->setBytes(&base, sizeof(float), 5);
-  compute_encoder->setBytes(&scale_, sizeof(float), 6);
+  compute_encoder.set_input_array(offset, 2);
+  compute_encoder->setBytes(&strides, 3 * sizeof(size_t), 3);
+  compute_encoder->setBytes(&out_strides, 3 * sizeof(size_t), 4);
+  compute_encoder->setBytes(&offset_stride, sizeof(size_t), 5);
+  compute_encoder->setBytes(&base, sizeof(float), 6);
+  compute_encoder->setBytes(&scale_, sizeof(float), 7);
+  if (with_freqs) {
+    auto& freqs = inputs[2];
+    size_t freq_stride = freqs.strides()[0];
+    compute_encoder.set_input_array(freqs, 8);
+    compute_encoder->setBytes(&freq_stride, sizeof(size_t), 9);
+  }
 
-  int dim0 = dims_ / 2;
-  int dim1 = in.shape(-2);
-  int dim2 = in.size() / mat_size;
   auto group_dims = get_block_dims(dim0, dim1, dim2);
   auto grid_dims = MTL::Size(dim0, dim1, dim2);
   compute_encoder.dispatchThreads(grid_dims, group_dims);
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
 }
 
 } // namespace mlx::core::fast
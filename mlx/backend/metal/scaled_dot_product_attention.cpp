@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <numeric>
 #include <sstream>
 
@@ -19,12 +20,119 @@
 namespace mlx::core::fast {
 
 namespace {
+
+// Strides of the mask broadcast to (batch, heads, query, key)
+std::array<int64_t, 4> mask_strides(const std::optional<array>& mask) {
+  std::array<int64_t, 4> strides = {0, 0, 0, 0};
+  if (mask) {
+    int offset = 4 - mask->ndim();
+    for (int i = 0; i < mask->ndim(); i++) {
+      if (mask->shape(i) != 1) {
+        strides[offset + i] = mask->strides()[i];
+      }
+    }
+  }
+  return strides;
+}
+
+// The kernels without a window or ALiBi point their function constants here
+const bool no_position_bias = false;
+
+// Sets the function constants selecting the masking of the scores and
+// appends them to the kernel's hash name
+metal::MTLFCList mask_func_consts(
+    const bool& has_mask,
+    const bool& bool_mask,
+    const bool& do_causal,
+    std::string& hash_name,
+    const bool& has_window = no_position_bias,
+    const bool& has_alibi = no_position_bias) {
+  hash_name += std::string("_mask_") + (has_mask ? 't' : 'n') +
+      (bool_mask ? "_bool" : "") + "_causal_" + (do_causal ? 't' : 'n');
+  if (has_window || has_alibi) {
+    hash_name += std::string("_window_") + (has_window ? 't' : 'n') +
+        "_alibi_" + (has_alibi ? 't' : 'n');
+  }
+  return {
+      {&has_mask, MTL::DataType::DataTypeBool, 300},
+      {&bool_mask, MTL::DataType::DataTypeBool, 301},
+      {&do_causal, MTL::DataType::DataTypeBool, 302},
+      {&has_window, MTL::DataType::DataTypeBool, 303},
+      {&has_alibi, MTL::DataType::DataTypeBool, 304},
+  };
+}
+
+void set_mask(
+    metal::CommandEncoder& compute_encoder,
+    const std::optional<array>& mask) {
+  if (mask) {
+    compute_encoder.set_input_array(*mask, mask->dtype() == bool_ ? 9 : 8);
+  }
+}
+
+// Threadgroups the decoding kernels should launch to fill the GPU. It is
+// looked up by device class and was tuned with
+// benchmarks/python/sdpa_vector_tune.py.
+int sdpa_vector_target_threadgroups(metal::Device& d) {
+  switch (d.get_architecture_class()) {
+    case 'p': // phone and tablet
+      return 32;
+    case 's': // max
+      return 256;
+    case 'd': // ultra
+      return 512;
+    case 'g': // base and pro
+    default:
+      return 96;
+  }
+}
+
+// Picks the number of keys per threadgroup of the decoding kernels. The keys
+// are split in as few tiles as keep n_groups * n_tiles threadgroups at the
+// device's target, so that short batches of long sequences still fill every
+// core. The reduction combines at most 128 tiles. MLX_SDPA_TILE_SIZE
+// overrides the choice for tuning.
+int sdpa_vector_tile_size(metal::Device& d, int n_keys, int n_groups) {
+  constexpr int max_tiles = 128;
+  constexpr int tile_sizes[] = {512, 256, 128, 64};
+  auto n_tiles = [n_keys](int tile_size) {
+    return (n_keys + tile_size - 1) / tile_size;
+  };
+  if (const char* buff_str = std::getenv("MLX_SDPA_TILE_SIZE")) {
+    int tile_size = atoi(buff_str);
+    for (int t : tile_sizes) {
+      if (t == tile_size && n_tiles(t) <= max_tiles) {
+        return t;
+      }
+    }
+  }
+  int target = sdpa_vector_target_threadgroups(d);
+  for (int t : tile_sizes) {
+    if (n_tiles(t) <= max_tiles && n_groups * n_tiles(t) >= target) {
+      return t;
+    }
+  }
+  // Too few threadgroups at any size, use the most tiles the reduction
+  // supports
+  int tile_size = tile_sizes[0];
+  for (int t : tile_sizes) {
+    if (n_tiles(t) <= max_tiles) {
+      tile_size = t;
+    }
+  }
+  return tile_size;
+}
+
 void sdpa_full_self_attention_metal(
     const Stream& s,
     metal::Device& d,
     const array& q,
     const array& k,
     const array& v,
+    const std::optional<array>& mask,
+    const bool do_causal,
+    const int window_size,
+    const std::optional<array>& alibi_slopes,
     const float alpha,
     array& out,
     std::vector<array>& temporaries) {
@@ -60,26 +168,36 @@ void sdpa_full_self_attention_metal(
     kname_self_attention << "itype" + delimiter + "float";
   } else if (q.dtype() == float16) {
     kname_self_attention << "itype" + delimiter + "half";
+  } else if (q.dtype() == bfloat16) {
+    kname_self_attention << "itype" + delimiter + "bfloat16";
   } else {
     throw std::runtime_error(
-        "[ScaledDotProductAttention::eval_gpu]: unexpected dtype found for queries: expected either float32 or float16.");
+        "[ScaledDotProductAttention::eval_gpu]: unexpected dtype found for queries: expected either float32, float16 or bfloat16.");
   }
 
+  const bool has_mask = mask.has_value();
+  const bool bool_mask = has_mask && mask->dtype() == bool_;
+  const bool has_window = window_size > 0;
+  const bool has_alibi = alibi_slopes.has_value();
+  std::string base_name = kname_self_attention.str();
+  std::string hash_name = base_name;
+  auto func_consts = mask_func_consts(
+      has_mask, bool_mask, do_causal, hash_name, has_window, has_alibi);
+
   auto& compute_encoder = d.get_command_encoder(s.index);
-  auto kernel = d.get_kernel(kname_self_attention.str());
+  auto kernel = d.get_kernel(base_name, "mlx", hash_name, func_consts);
   compute_encoder->setComputePipelineState(kernel);
 
   uint hidden_dim = q.shape(-1);
   uint qseq = q.shape(-2);
   uint qheads = q.shape(-3);
 
-  const uint64_t KV_sequence_length = k.shape(-2);
   const uint query_sequence_length = q.shape(-2);
   const uint n_q_heads = q.shape(1);
   const uint n_kv_heads = k.shape(1);
 
   const int M = q.shape(-2);
-  const int N = M;
+  const int N = k.shape(-2);
   const int K = q.shape(-1);
   const size_t batch_size_out = q.shape(0) * q.shape(1);
 
@@ -95,14 +213,15 @@ void sdpa_full_self_attention_metal(
   int tm = (M + bm - 1) / bm;
 
   const int batch_stride_q = dk * query_sequence_length;
-  const int batch_stride_k = dk * query_sequence_length;
-  const int batch_stride_v = dk * query_sequence_length;
+  const int batch_stride_k = k.strides()[1];
+  const int batch_stride_v = v.strides()[1];
   const int batch_stride_o = dk * query_sequence_length;
   const int swizzle_log = 0;
   const int gemm_n_iterations_aligned = (N + bn - 1) / bn;
   const int gemm_k_iterations_aligned = (K + bk - 1) / bk;
   const int gemm_sv_m_block_iterations = (M + bm - 1) / bm;
   const int batch_ndim = int(batch_shape.size());
+  auto ms = mask_strides(mask);
 
   MLXFastAttentionParams params{
       (int)M,
@@ -124,7 +243,12 @@ void sdpa_full_self_attention_metal(
       gemm_k_iterations_aligned,
       gemm_sv_m_block_iterations,
       batch_ndim,
-      alpha};
+      alpha,
+      int(n_q_heads),
+      int(n_q_heads / n_kv_heads),
+      N - M,
+      {ms[0], ms[1], ms[2], ms[3]},
+      window_size};
 
   const std::vector<size_t> batch_strides = {
       (size_t)batch_stride_q,
@@ -143,6 +267,10 @@ void sdpa_full_self_attention_metal(
 
   compute_encoder->setBytes(
       batch_strides.data(), sizeof(size_t) * batch_strides.size(), 7);
+  set_mask(compute_encoder, mask);
+  if (alibi_slopes) {
+    compute_encoder.set_input_array(*alibi_slopes, 10);
+  }
 
   MTL::Size grid_dims = MTL::Size(1, tm, batch_size_out);
   MTL::Size group_dims = MTL::Size(32, wm, wn);
@@ -160,10 +288,13 @@ void sdpa_metal(
     const array& q,
     const array& k,
     const array& v,
+    const std::optional<array>& mask,
+    const int window_size,
+    const std::optional<array>& alibi_slopes,
     const array& p_lse,
     const array& p_rowmaxes,
     const array& o_partial,
-    const uint heads,
+    const uint rows,
     const uint tile_size,
     const uint n_tiles,
     const float alpha,
@@ -190,9 +321,14 @@ void sdpa_metal(
   } else if (q.dtype() == float16) {
     kname_partials << "half" + delimiter;
     kname_reduce << "half";
+#if defined METAL_3_1 || defined METAL_3_2
+  } else if (q.dtype() == bfloat16) {
+    kname_partials << "bfloat16" + delimiter;
+    kname_reduce << "bfloat16";
+#endif
   } else {
     throw std::runtime_error(
-        "[ScaledDotProductAttention::eval_gpu]: unexpected dtype found for queries: expected either float32 or float16.");
+        "[ScaledDotProductAttention::eval_gpu]: unexpected dtype found for queries: expected either float32, float16 or bfloat16.");
   }
 
   std::string kname_suffix_tile_size = std::to_string(tile_size) + delimiter;
@@ -205,21 +341,45 @@ void sdpa_metal(
 
   std::string kname_suffix = kname_suffix_tile_size + kname_suffix_nsimdgroups;
   kname_partials << kname_suffix;
+
+  // A single query attends to every key with a causal mask
+  const bool has_mask = mask.has_value();
+  const bool bool_mask = has_mask && mask->dtype() == bool_;
+  const bool do_causal = false;
+  const bool has_window = window_size > 0;
+  const bool has_alibi = alibi_slopes.has_value();
+  std::string base_name = kname_partials.str();
+  std::string hash_name = base_name;
+  auto func_consts = mask_func_consts(
+      has_mask, bool_mask, do_causal, hash_name, has_window, has_alibi);
+
   auto& compute_encoder = d.get_command_encoder(s.index);
-  auto kernel = d.get_kernel(kname_partials.str());
+  auto kernel = d.get_kernel(base_name, "mlx", hash_name, func_consts);
   compute_encoder->setComputePipelineState(kernel);
 
   constexpr const uint batch = 1;
-  MTL::Size grid_dims = MTL::Size(heads, n_tiles, batch);
+  MTL::Size grid_dims = MTL::Size(rows, n_tiles, batch);
   MTL::Size group_dims = MTL::Size(32, nsimd, 1);
 
   const uint64_t KV_sequence_length = k.shape(-2);
   const uint query_sequence_length = q.shape(-2);
-  const uint n_q_heads = q.shape(1);
   const uint n_kv_heads = k.shape(1);
 
+  // Each query of a head, e.g. a draft token being verified, is treated as a
+  // head of its own sharing the keys of the head
+  const uint n_q_rows = q.shape(1) * query_sequence_length;
+
+  auto ms = mask_strides(mask);
   MLXScaledDotProductAttentionParams params{
-      query_sequence_length, n_q_heads, n_kv_heads, n_tiles, alpha};
+      query_sequence_length,
+      n_q_rows,
+      n_kv_heads,
+      n_tiles,
+      alpha,
+      {ms[0], ms[1], ms[2], ms[3]},
+      uint(k.strides()[1] / k.shape(-1)),
+      uint(v.strides()[1] / v.shape(-1)),
+      window_size};
 
   compute_encoder.set_input_array(q, 0);
   compute_encoder.set_input_array(k, 1);
@@ -230,6 +390,10 @@ void sdpa_metal(
   compute_encoder.set_input_array(o_partial, 5);
   compute_encoder.set_input_array(p_lse, 6);
   compute_encoder.set_input_array(p_rowmaxes, 7);
+  set_mask(compute_encoder, mask);
+  if (alibi_slopes) {
+    compute_encoder.set_input_array(*alibi_slopes, 10);
+  }
 
   constexpr const uint tgroupMemorySize = 32768;
   compute_encoder->setThreadgroupMemoryLength(tgroupMemorySize, 0);
@@ -245,7 +409,7 @@ void sdpa_metal(
         &params, sizeof(MLXScaledDotProductAttentionParams), 3);
     compute_encoder.set_output_array(out, 4);
 
-    MTL::Size grid_dims_reduce = MTL::Size(heads, 1, batch);
+    MTL::Size grid_dims_reduce = MTL::Size(rows, 1, batch);
     MTL::Size group_dims_reduce = MTL::Size(128, 1, 1);
 
     compute_encoder.dispatchThreadgroups(grid_dims_reduce, group_dims_reduce);
@@ -266,11 +430,6 @@ void ScaledDotProductAttention::eval_gpu(
         "[ScaledDotProductAttention] Does not yet support non-floating point types.");
   }
 
-  if (inputs.size() == 4) {
-    out = fallback_(inputs)[0];
-    return;
-  }
-
   out.set_data(allocator::malloc_or_wait(out.nbytes()));
   auto& s = stream();
   auto& d = metal::device(s.device);
@@ -285,42 +444,66 @@ void ScaledDotProductAttention::eval_gpu(
   // Keep a vector with copies to be cleared in the completed buffer to release
   // the arrays
   std::vector<array> temporaries;
+  // The kernels index q, k and v as row contiguous, otherwise they are copied
   auto check_transpose = [&temporaries, &s](const array& arr) {
-    auto stx = arr.strides()[arr.ndim() - 2];
-    auto sty = arr.strides()[arr.ndim() - 1];
-    if (stx == arr.shape(-1) && sty == 1) {
+    if (arr.flags().row_contiguous) {
       return arr;
     } else {
       array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
       copy_gpu(arr, arr_copy, CopyType::General, s);
       temporaries.push_back(arr_copy);
-      size_t stx = arr.shape(-1);
       return arr_copy;
     }
   };
 
+  // Keys and values may also be views of the filled part of a larger cache,
+  // e.g. from cache_append, as long as each head is row contiguous and the
+  // heads are evenly spaced
+  auto check_kv = [&check_transpose](const array& arr) {
+    auto& st = arr.strides();
+    bool heads_contiguous = arr.ndim() == 4 && st[3] == 1 &&
+        st[2] == arr.shape(3) && st[1] >= arr.shape(2) * st[2] &&
+        (arr.shape(0) == 1 || st[0] == arr.shape(1) * st[1]);
+    if (heads_contiguous) {
+      return arr;
+    }
+    return check_transpose(arr);
+  };
+
   auto q = check_transpose(q_pre);
-  auto k = check_transpose(k_pre);
-  auto v = check_transpose(v_pre);
+  auto k = check_kv(k_pre);
+  auto v = check_kv(v_pre);
+
+  std::optional<array> mask;
+  if (needs_mask_) {
+    mask = inputs[3];
+  }
+  std::optional<array> alibi_slopes;
+  if (has_alibi_) {
+    alibi_slopes = inputs[3 + needs_mask_];
+  }
 
   const int heads = q.shape(-3);
 
   uint query_sequence_length = q.shape(-2);
   if (query_sequence_length >= 16) {
     return sdpa_full_self_attention_metal(
-        s, d, q, k, v, scale_, out, temporaries);
+        s,
+        d,
+        q,
+        k,
+        v,
+        mask,
+        do_causal_,
+        window_size_,
+        alibi_slopes,
+        scale_,
+        out,
+        temporaries);
   }
-  int tile_size = 64;
   const int kv_seq_len = k.shape(-2);
-  if (kv_seq_len > 8000) {
-    tile_size = 128;
-  }
-  if (kv_seq_len > 16000) {
-    tile_size = 256;
-  }
-  if (kv_seq_len > 32000) {
-    tile_size = 512;
-  }
+  const int rows = heads * query_sequence_length;
+  const int tile_size = sdpa_vector_tile_size(d, kv_seq_len, q.shape(0) * rows);
 
   const int n_tiles = (kv_seq_len + tile_size - 1) / tile_size;
 
@@ -348,10 +531,13 @@ void ScaledDotProductAttention::eval_gpu(
       q,
       k,
       v,
+      mask,
+      window_size_,
+      alibi_slopes,
       p_lse,
       p_rowmaxes,
       o_partials,
-      heads,
+      rows,
       tile_size,
       n_tiles,
       scale_,
@@ -359,4 +545,429 @@ void ScaledDotProductAttention::eval_gpu(
       temporaries);
 }
 
+void QuantizedScaledDotProductAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  assert(inputs.size() >= 7);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  // The kernel indexes the queries, keys, values and their quantization
+  // parameters as row contiguous
+  std::vector<array> temporaries;
+  std::vector<array> ins;
+  for (int i = 0; i < 7; i++) {
+    auto& arr = inputs[i];
+    if (arr.flags().row_contiguous) {
+      ins.push_back(arr);
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      temporaries.push_back(arr_copy);
+      ins.push_back(arr_copy);
+    }
+  }
+  std::optional<array> mask;
+  if (inputs.size() == 8) {
+    mask = inputs[7];
+  }
+  auto& q = ins[0];
+  auto& k = ins[1];
+
+  const int batch = q.shape(0);
+  const int n_q_heads = q.shape(1);
+  const int n_kv_heads = k.shape(1);
+  const uint L = k.shape(2);
+  const uint tile_size = sdpa_vector_tile_size(d, L, batch * n_q_heads);
+  const uint n_tiles = (L + tile_size - 1) / tile_size;
+  const int head_dim = out.shape(-1);
+
+  array o_partials(
+      {batch, n_q_heads, 1, int(n_tiles) * head_dim}, float32, nullptr, {});
+  array p_lse({batch, n_q_heads, 1, int(n_tiles)}, float32, nullptr, {});
+  array p_rowmaxes({batch, n_q_heads, 1, int(n_tiles)}, float32, nullptr, {});
+  o_partials.set_data(allocator::malloc_or_wait(o_partials.nbytes()));
+  p_lse.set_data(allocator::malloc_or_wait(p_lse.nbytes()));
+  p_rowmaxes.set_data(allocator::malloc_or_wait(p_rowmaxes.nbytes()));
+  temporaries.push_back(o_partials);
+  temporaries.push_back(p_lse);
+  temporaries.push_back(p_rowmaxes);
+
+  std::string tname;
+  if (q.dtype() == float32) {
+    tname = "float";
+  } else if (q.dtype() == float16) {
+    tname = "half";
+  } else if (q.dtype() == bfloat16) {
+    tname = "bfloat16";
+  } else {
+    throw std::runtime_error(
+        "[QuantizedScaledDotProductAttention::eval_gpu] Unexpected dtype for "
+        "the queries, expected float32, float16 or bfloat16.");
+  }
+  std::ostringstream kname;
+  kname << "fast_inference_sdpa_quantized_compute_partials_" << tname
+        << "_gs_" << group_size_ << "_b_" << bits_;
+
+  const bool has_mask = mask.has_value();
+  const bool bool_mask = has_mask && mask->dtype() == bool_;
+  const bool do_causal = false;
+  std::string base_name = kname.str();
+  std::string hash_name = base_name;
+  auto func_consts =
+      mask_func_consts(has_mask, bool_mask, do_causal, hash_name);
+
+  auto ms = mask_strides(mask);
+  MLXScaledDotProductAttentionParams params{
+      1,
+      uint(n_q_heads),
+      uint(n_kv_heads),
+      n_tiles,
+      scale_,
+      {ms[0], ms[1], ms[2], ms[3]}};
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel = d.get_kernel(base_name, "mlx", hash_name, func_consts);
+  compute_encoder->setComputePipelineState(kernel);
+  for (int i = 0; i < 7; i++) {
+    compute_encoder.set_input_array(ins[i], i);
+  }
+  compute_encoder->setBytes(&L, sizeof(L), 7);
+  compute_encoder->setBytes(&tile_size, sizeof(tile_size), 8);
+  compute_encoder->setBytes(
+      &params, sizeof(MLXScaledDotProductAttentionParams), 9);
+  compute_encoder.set_output_array(o_partials, 10);
+  compute_encoder.set_output_array(p_lse, 11);
+  compute_encoder.set_output_array(p_rowmaxes, 12);
+  if (mask) {
+    compute_encoder.set_input_array(*mask, bool_mask ? 14 : 13);
+  }
+  compute_encoder.dispatchThreadgroups(
+      MTL::Size(n_q_heads, n_tiles, batch), MTL::Size(32, 8, 1));
+
+  // Combine the tiles like the unquantized decoding kernel
+  auto kernel_reduce =
+      d.get_kernel("fast_inference_sdpa_reduce_tiles_" + tname);
+  compute_encoder->setComputePipelineState(kernel_reduce);
+  compute_encoder.set_input_array(o_partials, 0);
+  compute_encoder.set_input_array(p_lse, 1);
+  compute_encoder.set_input_array(p_rowmaxes, 2);
+  compute_encoder->setBytes(
+      &params, sizeof(MLXScaledDotProductAttentionParams), 3);
+  compute_encoder.set_output_array(out, 4);
+  compute_encoder.dispatchThreadgroups(
+      MTL::Size(n_q_heads, 1, batch), MTL::Size(head_dim, 1, 1));
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [temporaries](MTL::CommandBuffer*) mutable { temporaries.clear(); });
+}
+
+void RaggedAttention::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 5);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> temporaries;
+  std::vector<array> ins;
+  for (auto& arr : inputs) {
+    if (arr.flags().row_contiguous) {
+      ins.push_back(arr);
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      temporaries.push_back(arr_copy);
+      ins.push_back(arr_copy);
+    }
+  }
+  auto& q = ins[0];
+  auto& k = ins[1];
+  const int n_tokens = q.shape(0);
+  const int n_q_heads = q.shape(1);
+  const int n_kv_heads = k.shape(1);
+  const int head_dim = q.shape(2);
+  const int n_segments = ins[3].size() - 1;
+  if (n_tokens == 0) {
+    return;
+  }
+
+  std::string tname;
+  if (q.dtype() == float32) {
+    tname = "float";
+  } else if (q.dtype() == float16) {
+    tname = "half";
+  } else if (q.dtype() == bfloat16) {
+    tname = "bfloat16";
+  } else {
+    throw std::runtime_error(
+        "[RaggedAttention::eval_gpu] Unexpected dtype for the queries, "
+        "expected float32, float16 or bfloat16.");
+  }
+
+  std::string base_name =
+      "ragged_attention_" + tname + "_" + std::to_string(head_dim);
+  std::string hash_name = base_name;
+  const bool has_mask = false;
+  const bool bool_mask = false;
+  const bool do_causal = do_causal_;
+  auto func_consts =
+      mask_func_consts(has_mask, bool_mask, do_causal, hash_name);
+  auto kernel = d.get_kernel(base_name, "mlx", hash_name, func_consts);
+
+  MLXRaggedAttentionParams params{
+      n_q_heads, n_kv_heads, n_q_heads / n_kv_heads, n_segments, scale_};
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  for (int i = 0; i < 5; i++) {
+    compute_encoder.set_input_array(ins[i], i);
+  }
+  compute_encoder->setBytes(&params, sizeof(MLXRaggedAttentionParams), 5);
+  compute_encoder.set_output_array(out, 6);
+  compute_encoder.dispatchThreadgroups(
+      MTL::Size(n_q_heads, n_tokens, 1), MTL::Size(32, 8, 1));
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [temporaries](MTL::CommandBuffer*) mutable { temporaries.clear(); });
+}
+
+void PagedAttention::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 5);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> temporaries;
+  std::vector<array> ins;
+  for (auto& arr : inputs) {
+    if (arr.flags().row_contiguous) {
+      ins.push_back(arr);
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      temporaries.push_back(arr_copy);
+      ins.push_back(arr_copy);
+    }
+  }
+  auto& q = ins[0];
+  auto& k = ins[1];
+  auto& block_tables = ins[3];
+
+  const int batch = q.shape(0);
+  const int n_q_heads = q.shape(1);
+  const int n_kv_heads = k.shape(1);
+  const int block_size = k.shape(2);
+  const int max_blocks = block_tables.shape(1);
+  const int head_dim = q.shape(-1);
+
+  // Tiles are sized for the longest sequence the block tables can hold
+  const int max_length = max_blocks * block_size;
+  const int tile_size =
+      sdpa_vector_tile_size(d, max_length, batch * n_q_heads);
+  const int n_tiles = std::max(1, (max_length + tile_size - 1) / tile_size);
+
+  array o_partials(
+      {batch, n_q_heads, 1, n_tiles * head_dim}, float32, nullptr, {});
+  array p_lse({batch, n_q_heads, 1, n_tiles}, float32, nullptr, {});
+  array p_rowmaxes({batch, n_q_heads, 1, n_tiles}, float32, nullptr, {});
+  o_partials.set_data(allocator::malloc_or_wait(o_partials.nbytes()));
+  p_lse.set_data(allocator::malloc_or_wait(p_lse.nbytes()));
+  p_rowmaxes.set_data(allocator::malloc_or_wait(p_rowmaxes.nbytes()));
+  temporaries.push_back(o_partials);
+  temporaries.push_back(p_lse);
+  temporaries.push_back(p_rowmaxes);
+
+  std::string tname;
+  if (q.dtype() == float32) {
+    tname = "float";
+  } else if (q.dtype() == float16) {
+    tname = "half";
+  } else if (q.dtype() == bfloat16) {
+    tname = "bfloat16";
+  } else {
+    throw std::runtime_error(
+        "[PagedAttention::eval_gpu] Unexpected dtype for the queries, "
+        "expected float32, float16 or bfloat16.");
+  }
+
+  MLXPagedAttentionParams pparams{block_size, max_blocks, tile_size};
+  MLXScaledDotProductAttentionParams params{
+      1, uint(n_q_heads), uint(n_kv_heads), uint(n_tiles), scale_};
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto kernel =
+      d.get_kernel("fast_inference_paged_attention_compute_partials_" + tname);
+  compute_encoder->setComputePipelineState(kernel);
+  for (int i = 0; i < 5; i++) {
+    compute_encoder.set_input_array(ins[i], i);
+  }
+  compute_encoder->setBytes(&pparams, sizeof(MLXPagedAttentionParams), 5);
+  compute_encoder->setBytes(
+      &params, sizeof(MLXScaledDotProductAttentionParams), 6);
+  compute_encoder.set_output_array(o_partials, 7);
+  compute_encoder.set_output_array(p_lse, 8);
+  compute_encoder.set_output_array(p_rowmaxes, 9);
+  compute_encoder.dispatchThreadgroups(
+      MTL::Size(n_q_heads, n_tiles, batch), MTL::Size(32, 8, 1));
+
+  // Combine the tiles like the decoding kernel
+  auto kernel_reduce =
+      d.get_kernel("fast_inference_sdpa_reduce_tiles_" + tname);
+  compute_encoder->setComputePipelineState(kernel_reduce);
+  compute_encoder.set_input_array(o_partials, 0);
+  compute_encoder.set_input_array(p_lse, 1);
+  compute_encoder.set_input_array(p_rowmaxes, 2);
+  compute_encoder->setBytes(
+      &params, sizeof(MLXScaledDotProductAttentionParams), 3);
+  compute_encoder.set_output_array(out, 4);
+  compute_encoder.dispatchThreadgroups(
+      MTL::Size(n_q_heads, 1, batch), MTL::Size(head_dim, 1, 1));
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [temporaries](MTL::CommandBuffer*) mutable { temporaries.clear(); });
+}
+
+void ScaledDotProductAttentionVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 5 + needs_mask_ + has_alibi_);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> temporaries;
+  std::vector<array> ins;
+  for (int i = 0; i < 5; i++) {
+    auto& arr = inputs[i];
+    if (arr.flags().row_contiguous) {
+      ins.push_back(arr);
+    } else {
+      array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+      copy_gpu(arr, arr_copy, CopyType::General, s);
+      temporaries.push_back(arr_copy);
+      ins.push_back(arr_copy);
+    }
+  }
+  std::optional<array> mask;
+  if (needs_mask_) {
+    mask = inputs[5];
+  }
+  std::optional<array> alibi_slopes;
+  if (has_alibi_) {
+    alibi_slopes = inputs[5 + needs_mask_];
+  }
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  }
+  auto& q = ins[0];
+  auto& k = ins[1];
+  auto& d_q = outputs[0];
+  auto& d_k = outputs[1];
+  auto& d_v = outputs[2];
+
+  const int batch = q.shape(0);
+  const int n_q_heads = q.shape(1);
+  const int n_kv_heads = k.shape(1);
+  const int q_len = q.shape(2);
+  const int k_len = k.shape(2);
+  const int head_dim = q.shape(-1);
+
+  // The logsumexp of the scores and the dot product of the output with its
+  // cotangent for every query
+  array lse({batch, n_q_heads, q_len}, float32, nullptr, {});
+  array delta({batch, n_q_heads, q_len}, float32, nullptr, {});
+  lse.set_data(allocator::malloc_or_wait(lse.nbytes()));
+  delta.set_data(allocator::malloc_or_wait(delta.nbytes()));
+  temporaries.push_back(lse);
+  temporaries.push_back(delta);
+
+  std::string tname;
+  if (q.dtype() == float32) {
+    tname = "float";
+  } else if (q.dtype() == float16) {
+    tname = "half";
+  } else if (q.dtype() == bfloat16) {
+    tname = "bfloat16";
+  } else {
+    throw std::runtime_error(
+        "[ScaledDotProductAttentionVJP::eval_gpu] Unexpected dtype for the "
+        "queries, expected float32, float16 or bfloat16.");
+  }
+  auto strides = mask_strides(mask);
+  MLXAttentionVJPParams params{
+      n_q_heads,
+      n_q_heads / n_kv_heads,
+      q_len,
+      k_len,
+      scale_,
+      k_len - q_len,
+      {strides[0], strides[1], strides[2], strides[3]},
+      window_size_};
+
+  const bool has_mask = mask.has_value();
+  const bool bool_mask = has_mask && mask->dtype() == bool_;
+  const bool do_causal = do_causal_;
+  const bool has_window = window_size_ > 0;
+  const bool has_alibi = has_alibi_;
+  auto suffix = "_" + tname + "_" + std::to_string(head_dim);
+  auto get_kernel = [&](const std::string& base) {
+    std::string hash_name = base;
+    auto func_consts = mask_func_consts(
+        has_mask, bool_mask, do_causal, hash_name, has_window, has_alibi);
+    return d.get_kernel(base, "mlx", hash_name, func_consts);
+  };
+  auto set_vjp_mask = [&](metal::CommandEncoder& compute_encoder) {
+    if (mask) {
+      compute_encoder.set_input_array(*mask, bool_mask ? 8 : 7);
+    }
+    if (alibi_slopes) {
+      compute_encoder.set_input_array(*alibi_slopes, 11);
+    }
+  };
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  MTL::Size group_dims(32, 8, 1);
+  MTL::Size q_grid((q_len + 7) / 8, n_q_heads, batch);
+
+  compute_encoder->setComputePipelineState(
+      get_kernel("attention_vjp_row_stats" + suffix));
+  compute_encoder.set_input_array(q, 0);
+  compute_encoder.set_input_array(k, 1);
+  compute_encoder.set_input_array(ins[3], 2);
+  compute_encoder.set_input_array(ins[4], 3);
+  compute_encoder.set_output_array(lse, 4);
+  compute_encoder.set_output_array(delta, 5);
+  compute_encoder->setBytes(&params, sizeof(MLXAttentionVJPParams), 6);
+  set_vjp_mask(compute_encoder);
+  compute_encoder.dispatchThreadgroups(q_grid, group_dims);
+
+  auto set_common = [&]() {
+    for (int i = 0; i < 3; i++) {
+      compute_encoder.set_input_array(ins[i], i);
+    }
+    compute_encoder.set_input_array(ins[4], 3);
+    compute_encoder.set_input_array(lse, 4);
+    compute_encoder.set_input_array(delta, 5);
+    compute_encoder->setBytes(&params, sizeof(MLXAttentionVJPParams), 6);
+    set_vjp_mask(compute_encoder);
+  };
+
+  compute_encoder->setComputePipelineState(
+      get_kernel("attention_vjp_dq" + suffix));
+  set_common();
+  compute_encoder.set_output_array(d_q, 9);
+  compute_encoder.dispatchThreadgroups(q_grid, group_dims);
+
+  compute_encoder->setComputePipelineState(
+      get_kernel("attention_vjp_dkdv" + suffix));
+  set_common();
+  compute_encoder.set_output_array(d_k, 9);
+  compute_encoder.set_output_array(d_v, 10);
+  compute_encoder.dispatchThreadgroups(
+      MTL::Size((k_len + 7) / 8, n_kv_heads, batch), group_dims);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [temporaries](MTL::CommandBuffer*) mutable { temporaries.clear(); });
+}
+
 } // namespace mlx::core::fast
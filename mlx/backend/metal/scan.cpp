@@ -11,6 +11,13 @@
 
 namespace mlx::core {
 
+// Up to this many rows of at least SCAN_SPLIT_MIN_SIZE elements are split
+// across threadgroups, e.g. the cumsum of the sorted probabilities in top-p
+// sampling
+constexpr int SCAN_SPLIT_MAX_ROWS = 16;
+constexpr size_t SCAN_SPLIT_MIN_SIZE = 16384;
+constexpr size_t SCAN_MAX_SPLITS = 1024;
+
 void Scan::eval_gpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
 
@@ -57,13 +64,54 @@ void Scan::eval_gpu(const std::vector<array>& inputs, array& out) {
   kname << reduce_type << "_" << type_to_name(in) << "_" << type_to_name(out);
   auto kernel = get_scan_kernel(
       d, kname.str(), reverse_, inclusive_, reduce_type, in, out);
+  size_t size = in.shape(axis_);
+  size_t n_rows = size > 0 ? in.size() / size : 0;
+
+  if (contiguous && size >= SCAN_SPLIT_MIN_SIZE &&
+      n_rows <= SCAN_SPLIT_MAX_ROWS) {
+    // Reduce every part of the rows and then scan each part starting from
+    // the reduction of the parts before it
+    std::string name = kname.str().substr(kname.str().find("_") + 1);
+    auto partial_kernel = get_scan_kernel(
+        d, "partial_" + name, reverse_, inclusive_, reduce_type, in, out);
+    auto split_kernel = get_scan_kernel(
+        d, "split_" + name, reverse_, inclusive_, reduce_type, in, out);
+
+    size_t n_reads = (in.itemsize() <= 4) ? 4 : 2;
+    size_t thread_group_size = split_kernel->maxTotalThreadsPerThreadgroup();
+    size_t min_split = thread_group_size * n_reads;
+    size_t n_splits =
+        std::min((size + min_split - 1) / min_split, SCAN_MAX_SPLITS);
+    size_t split_size = (size + n_splits - 1) / n_splits;
+    split_size = (split_size + n_reads - 1) / n_reads * n_reads;
+    n_splits = (size + split_size - 1) / split_size;
+
+    array partials({int(n_rows), int(n_splits)}, out.dtype(), nullptr, {});
+    partials.set_data(allocator::malloc_or_wait(partials.nbytes()));
+    copies.push_back(partials);
+
+    MTL::Size grid_dims = MTL::Size(n_splits, n_rows, 1);
+    MTL::Size group_dims = MTL::Size(thread_group_size, 1, 1);
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(partial_kernel);
+    compute_encoder.set_input_array(in, 0);
+    compute_encoder.set_output_array(partials, 1);
+    compute_encoder->setBytes(&size, sizeof(size_t), 2);
+    compute_encoder->setBytes(&split_size, sizeof(size_t), 3);
+    compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
 
-  if (contiguous) {
+    compute_encoder->setComputePipelineState(split_kernel);
+    compute_encoder.set_input_array(in, 0);
+    compute_encoder.set_input_array(partials, 1);
+    compute_encoder.set_output_array(out, 2);
+    compute_encoder->setBytes(&size, sizeof(size_t), 3);
+    compute_encoder->setBytes(&split_size, sizeof(size_t), 4);
+    compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+  } else if (contiguous) {
     auto& compute_encoder = d.get_command_encoder(s.index);
     compute_encoder->setComputePipelineState(kernel);
     compute_encoder.set_input_array(in, 0);
     compute_encoder.set_output_array(out, 1);
-    size_t size = in.shape(axis_);
     compute_encoder->setBytes(&size, sizeof(size_t), 2);
 
     // Compute the thread grid
@@ -90,7 +138,6 @@ void Scan::eval_gpu(const std::vector<array>& inputs, array& out) {
     compute_encoder->setComputePipelineState(kernel);
     compute_encoder.set_input_array(in, 0);
     compute_encoder.set_output_array(out, 1);
-    size_t size = in.shape(axis_);
     size_t stride = in.strides()[axis_];
     compute_encoder->setBytes(&size, sizeof(size_t), 2);
     compute_encoder->setBytes(&stride, sizeof(size_t), 3);
@@ -0,0 +1,147 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <cassert>
+
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Must match segmented_group_size in the kernels
+constexpr int segmented_group_size = 256;
+
+// Launch a threadgroup per block of columns and segment. Narrow rows use
+// fewer columns and more rows per threadgroup.
+void segmented_dispatch(
+    const array& in,
+    const array& offsets,
+    array& out,
+    const std::string& kname,
+    bool scan,
+    bool reverse,
+    bool inclusive,
+    metal::Device& d,
+    const Stream& s) {
+  int n_rows = in.shape(0);
+  int n_segments = offsets.size() - 1;
+  int row_size = 1;
+  for (int i = 1; i < in.ndim(); i++) {
+    row_size *= in.shape(i);
+  }
+  if (n_segments == 0 || row_size == 0) {
+    return;
+  }
+
+  int n_cols = std::min(next_power_of_2(row_size), 32);
+  int n_group_rows = segmented_group_size / n_cols;
+  auto kernel = d.get_kernel(kname);
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(in, 0);
+  compute_encoder.set_input_array(offsets, 1);
+  compute_encoder.set_output_array(out, 2);
+  compute_encoder->setBytes(&n_rows, sizeof(int), 3);
+  compute_encoder->setBytes(&row_size, sizeof(int), 4);
+  if (scan) {
+    compute_encoder->setBytes(&reverse, sizeof(bool), 5);
+    compute_encoder->setBytes(&inclusive, sizeof(bool), 6);
+  }
+  compute_encoder.dispatchThreadgroups(
+      MTL::Size((row_size + n_cols - 1) / n_cols, n_segments, 1),
+      MTL::Size(n_cols, n_group_rows, 1));
+}
+
+} // namespace
+
+void SegmentedReduce::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  copies.reserve(inputs.size());
+  const array& in = check_input(inputs[0]);
+  const array& offsets = check_input(inputs[1]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  std::string op_name;
+  switch (reduce_type_) {
+    case SegmentedReduce::Sum:
+      op_name = "sum";
+      break;
+    case SegmentedReduce::Max:
+      op_name = "max";
+      break;
+    case SegmentedReduce::Min:
+      op_name = "min";
+      break;
+  }
+  segmented_dispatch(
+      in,
+      offsets,
+      out,
+      "segmented_reduce_" + op_name + "_" + type_to_name(out),
+      false,
+      false,
+      false,
+      d,
+      s);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void SegmentedScan::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 2);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  copies.reserve(inputs.size() + 1);
+  const array& in = check_input(inputs[0]);
+  const array& offsets = check_input(inputs[1]);
+
+  // Rows outside of every segment are zero
+  array zero(0, out.dtype());
+  copy_gpu(zero, out, CopyType::Scalar, s);
+  copies.push_back(zero);
+
+  segmented_dispatch(
+      in,
+      offsets,
+      out,
+      "segmented_cumsum_" + type_to_name(out),
+      true,
+      reverse_,
+      inclusive_,
+      d,
+      s);
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace mlx::core
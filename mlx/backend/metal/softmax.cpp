@@ -13,6 +13,68 @@ namespace mlx::core {
 
 constexpr int SOFTMAX_LOOPED_LIMIT = 4096;
 
+// Up to this many rows of at least SOFTMAX_SPLIT_MIN_SIZE elements are split
+// across threadgroups to use the whole GPU, e.g. for the logits of a decoded
+// token
+constexpr int SOFTMAX_SPLIT_MAX_ROWS = 16;
+constexpr int SOFTMAX_SPLIT_MIN_SIZE = 16384;
+constexpr int SOFTMAX_MAX_SPLITS = 1024;
+
+namespace {
+
+void softmax_split(
+    const array& in,
+    array& out,
+    const std::string& type_name,
+    bool precise,
+    int axis_size,
+    int n_rows,
+    std::vector<array>& copies,
+    const Stream& s) {
+  auto& d = metal::device(s.device);
+  auto partial_kernel =
+      get_softmax_kernel(d, "partial_softmax_" + type_name, precise, out);
+  auto normalize_kernel =
+      get_softmax_kernel(d, "normalize_softmax_" + type_name, precise, out);
+  size_t threadgroup_size = partial_kernel->maxTotalThreadsPerThreadgroup();
+
+  // Each threadgroup reads its part of the row once per kernel
+  int n_reads = SOFTMAX_N_READS;
+  int min_split = threadgroup_size * n_reads;
+  int n_splits =
+      std::min((axis_size + min_split - 1) / min_split, SOFTMAX_MAX_SPLITS);
+  int split_size = (axis_size + n_splits - 1) / n_splits;
+  split_size = (split_size + n_reads - 1) / n_reads * n_reads;
+  n_splits = (axis_size + split_size - 1) / split_size;
+
+  // The max and normalizer of every part
+  array stats({n_rows, n_splits, 2}, float32, nullptr, {});
+  stats.set_data(allocator::malloc_or_wait(stats.nbytes()));
+  copies.push_back(stats);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  MTL::Size grid_dims = MTL::Size(n_splits, n_rows, 1);
+  MTL::Size group_dims = MTL::Size(threadgroup_size, 1, 1);
+  const array& x = in.data_shared_ptr() == nullptr ? out : in;
+
+  compute_encoder->setComputePipelineState(partial_kernel);
+  compute_encoder.set_input_array(x, 0);
+  compute_encoder.set_output_array(stats, 1);
+  compute_encoder->setBytes(&axis_size, sizeof(int), 2);
+  compute_encoder->setBytes(&split_size, sizeof(int), 3);
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+
+  compute_encoder->setComputePipelineState(normalize_kernel);
+  compute_encoder.set_input_array(x, 0);
+  compute_encoder.set_input_array(stats, 1);
+  compute_encoder.set_output_array(out, 2);
+  compute_encoder->setBytes(&axis_size, sizeof(int), 3);
+  compute_encoder->setBytes(&split_size, sizeof(int), 4);
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+}
+
+} // namespace
+
 void Softmax::eval_gpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 1);
   if (!issubdtype(out.dtype(), floating)) {
@@ -56,12 +118,21 @@ void Softmax::eval_gpu(const std::vector<array>& inputs, array& out) {
   const int n_reads = SOFTMAX_N_READS;
   const int looped_limit = SOFTMAX_LOOPED_LIMIT;
 
-  std::string kernel_name = (axis_size > looped_limit) ? "looped_" : "block_";
-  kernel_name += "softmax_";
+  std::string type_name;
   if (in.dtype() != float32 && precise_) {
-    kernel_name += "precise_";
+    type_name += "precise_";
   }
-  kernel_name += type_to_name(out);
+  type_name += type_to_name(out);
+
+  if (axis_size >= SOFTMAX_SPLIT_MIN_SIZE && n_rows <= SOFTMAX_SPLIT_MAX_ROWS) {
+    softmax_split(in, out, type_name, precise_, axis_size, n_rows, copies, s);
+    d.get_command_buffer(s.index)->addCompletedHandler(
+        [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+    return;
+  }
+
+  std::string kernel_name = (axis_size > looped_limit) ? "looped_" : "block_";
+  kernel_name += "softmax_" + type_name;
 
   auto kernel = get_softmax_kernel(d, kernel_name, precise_, out);
   auto& compute_encoder = d.get_command_encoder(s.index);
@@ -12,6 +12,46 @@ namespace mlx::core {
 
 namespace {
 
+// Rows at least this long are radix sorted
+constexpr int radix_sort_min_size = 1 << 18;
+constexpr int radix_sort_bins = 16;
+
+// Copies rows sorted contiguously along the last axis into out which is
+// sorted along axis
+void copy_sorted_rows(
+    const Stream& s,
+    const array& sorted_rows,
+    array& out,
+    int axis) {
+  if (axis == out.ndim() - 1) {
+    copy_gpu_inplace(sorted_rows, out, CopyType::Vector, s);
+  } else {
+    std::vector<int> strided_out_shape = out.shape();
+    int out_axis_shape = strided_out_shape[axis];
+
+    strided_out_shape.erase(strided_out_shape.begin() + axis);
+    strided_out_shape.push_back(out_axis_shape);
+
+    std::vector<size_t> strided_out_str(out.ndim(), 1);
+    for (int i = out.ndim() - 2; i >= 0; --i) {
+      strided_out_str[i] = strided_out_str[i + 1] * strided_out_shape[i + 1];
+    }
+
+    strided_out_str.erase(strided_out_str.end() - 1);
+    strided_out_str.insert(strided_out_str.begin() + axis, 1);
+
+    array strided_out_slice(out.shape(), out.dtype(), nullptr, {});
+    strided_out_slice.copy_shared_buffer(
+        sorted_rows,
+        strided_out_str,
+        sorted_rows.flags(),
+        sorted_rows.size(),
+        0);
+
+    copy_gpu_inplace(strided_out_slice, out, CopyType::General, s);
+  }
+}
+
 void single_block_sort(
     const Stream& s,
     metal::Device& d,
@@ -221,36 +261,122 @@ void multi_block_sort(
 
   // Copy outputs with appropriate strides
   array strided_out_arr = argsort ? dev_idxs_out : dev_vals_out;
+  copy_sorted_rows(s, strided_out_arr, out, axis);
 
-  if (axis == in.ndim() - 1) {
-    copy_gpu_inplace(strided_out_arr, out, CopyType::Vector, s);
-  } else {
-    std::vector<int> strided_out_shape = in.shape();
-    int out_axis_shape = strided_out_shape[axis];
+  // Clear copies
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
 
-    strided_out_shape.erase(strided_out_shape.begin() + axis);
-    strided_out_shape.push_back(out_axis_shape);
+void radix_sort(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    array& out,
+    int axis,
+    bool argsort) {
+  int bn = 256;
+  int tn = 4;
+  int n_rows = in.size() / in.shape(axis);
+  int size_sorted_axis = in.shape(axis);
+  int n_per_block = bn * tn;
+  int n_blocks = (size_sorted_axis + n_per_block - 1) / n_per_block;
+  int n_counts = n_blocks * radix_sort_bins;
+
+  array dev_vals_0({n_rows, size_sorted_axis}, in.dtype(), nullptr, {});
+  array dev_vals_1({n_rows, size_sorted_axis}, in.dtype(), nullptr, {});
+  array counts({n_rows, n_counts}, uint32, nullptr, {});
+  dev_vals_0.set_data(allocator::malloc_or_wait(dev_vals_0.nbytes()));
+  dev_vals_1.set_data(allocator::malloc_or_wait(dev_vals_1.nbytes()));
+  counts.set_data(allocator::malloc_or_wait(counts.nbytes()));
+  std::vector<array> copies = {dev_vals_0, dev_vals_1, counts};
 
-    std::vector<size_t> strided_out_str(in.ndim(), 1);
+  // Indices are only carried along for argsort
+  array dev_idxs_0 = dev_vals_0;
+  array dev_idxs_1 = dev_vals_1;
+  if (argsort) {
+    dev_idxs_0 = array({n_rows, size_sorted_axis}, uint32, nullptr, {});
+    dev_idxs_1 = array({n_rows, size_sorted_axis}, uint32, nullptr, {});
+    dev_idxs_0.set_data(allocator::malloc_or_wait(dev_idxs_0.nbytes()));
+    dev_idxs_1.set_data(allocator::malloc_or_wait(dev_idxs_1.nbytes()));
+    copies.push_back(dev_idxs_0);
+    copies.push_back(dev_idxs_1);
+  }
+
+  // Gather the rows contiguously with the sorted axis last
+  {
+    std::vector<int> rows_shape = in.shape();
+    std::vector<size_t> rows_str = in.strides();
+    rows_shape.erase(rows_shape.begin() + axis);
+    rows_str.erase(rows_str.begin() + axis);
+    rows_shape.push_back(size_sorted_axis);
+    rows_str.push_back(in.strides()[axis]);
+
+    std::vector<size_t> rows_out_str(in.ndim(), 1);
     for (int i = in.ndim() - 2; i >= 0; --i) {
-      strided_out_str[i] = strided_out_str[i + 1] * strided_out_shape[i + 1];
+      rows_out_str[i] = rows_out_str[i + 1] * rows_shape[i + 1];
     }
 
-    strided_out_str.erase(strided_out_str.end() - 1);
-    strided_out_str.insert(strided_out_str.begin() + axis, 1);
+    array rows(rows_shape, in.dtype(), nullptr, {});
+    rows.copy_shared_buffer(in, rows_str, in.flags(), in.data_size());
+    array rows_out(rows_shape, in.dtype(), nullptr, {});
+    rows_out.copy_shared_buffer(
+        dev_vals_0, rows_out_str, dev_vals_0.flags(), dev_vals_0.size());
+    copy_gpu_inplace(rows, rows_out, CopyType::General, s);
+  }
 
-    array strided_out_slice(in.shape(), out.dtype(), nullptr, {});
-    strided_out_slice.copy_shared_buffer(
-        strided_out_arr,
-        strided_out_str,
-        strided_out_arr.flags(),
-        strided_out_arr.size(),
-        0);
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  auto tname = type_to_name(in);
+  auto count_kernel = get_radix_sort_kernel(d, "radix_sort_count_" + tname, in);
+  auto scan_kernel = get_radix_sort_kernel(d, "radix_sort_scan_" + tname, in);
+  std::string scatter_name =
+      (argsort ? "arg_radix_sort_scatter_" : "radix_sort_scatter_") + tname;
+  auto scatter_kernel = get_radix_sort_kernel(d, scatter_name, in);
+
+  int key_bits = 8 * size_of(in.dtype());
+  bool ping = false;
+  for (int shift = 0; shift < key_bits; shift += 4) {
+    array& vals_in = ping ? dev_vals_1 : dev_vals_0;
+    array& idxs_in = ping ? dev_idxs_1 : dev_idxs_0;
+    array& vals_out = ping ? dev_vals_0 : dev_vals_1;
+    array& idxs_out = ping ? dev_idxs_0 : dev_idxs_1;
+    ping = !ping;
 
-    copy_gpu_inplace(strided_out_slice, out, CopyType::General, s);
+    // Count the digits of each block
+    compute_encoder->setComputePipelineState(count_kernel);
+    compute_encoder.set_input_array(vals_in, 0);
+    compute_encoder.set_output_array(counts, 1);
+    compute_encoder->setBytes(&size_sorted_axis, sizeof(int), 2);
+    compute_encoder->setBytes(&shift, sizeof(int), 3);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(n_blocks, n_rows, 1), MTL::Size(bn, 1, 1));
+
+    // Scan the counts into output offsets
+    compute_encoder->setComputePipelineState(scan_kernel);
+    compute_encoder.set_output_array(counts, 0);
+    compute_encoder->setBytes(&n_counts, sizeof(int), 1);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(1, n_rows, 1), MTL::Size(1024, 1, 1));
+
+    // Scatter each block into place
+    bool first_pass = shift == 0;
+    compute_encoder->setComputePipelineState(scatter_kernel);
+    compute_encoder.set_input_array(vals_in, 0);
+    compute_encoder.set_input_array(idxs_in, 1);
+    compute_encoder.set_output_array(vals_out, 2);
+    compute_encoder.set_output_array(idxs_out, 3);
+    compute_encoder.set_input_array(counts, 4);
+    compute_encoder->setBytes(&size_sorted_axis, sizeof(int), 5);
+    compute_encoder->setBytes(&shift, sizeof(int), 6);
+    compute_encoder->setBytes(&first_pass, sizeof(bool), 7);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size(n_blocks, n_rows, 1), MTL::Size(bn, 1, 1));
   }
 
-  // Clear copies
+  array& sorted_vals = ping ? dev_vals_1 : dev_vals_0;
+  array& sorted_idxs = ping ? dev_idxs_1 : dev_idxs_0;
+  copy_sorted_rows(s, argsort ? sorted_idxs : sorted_vals, out, axis);
+
   d.get_command_buffer(s.index)->addCompletedHandler(
       [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
 }
@@ -286,6 +412,13 @@ void gpu_merge_sort(
   int n_per_block = bn * tn;
   int n_blocks = (size_sorted_axis + n_per_block - 1) / n_per_block;
 
+  // Large rows of at most 32 bit keys take a fixed number of passes with
+  // the radix sort instead of one merge pass per doubling of the row.
+  if (size_sorted_axis >= radix_sort_min_size && size_of(in.dtype()) <= 4 &&
+      in.dtype() != bool_) {
+    return radix_sort(s, d, in, out, axis, argsort);
+  }
+
   if (n_blocks > 1) {
     return multi_block_sort(s, d, in, out, axis, bn, tn, n_blocks, argsort);
   } else {
@@ -293,6 +426,89 @@ void gpu_merge_sort(
   }
 }
 
+void radix_select_partition(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    array& out,
+    int axis,
+    int kth,
+    bool arg_partition) {
+  int bn = 1024;
+  int n_rows = in.size() / in.shape(axis);
+
+  std::vector<int> nc_shape = in.shape();
+  nc_shape.erase(nc_shape.begin() + axis);
+
+  std::vector<size_t> in_nc_str = in.strides();
+  in_nc_str.erase(in_nc_str.begin() + axis);
+
+  std::vector<size_t> out_nc_str = out.strides();
+  out_nc_str.erase(out_nc_str.begin() + axis);
+
+  int nc_dim = nc_shape.size();
+
+  if (nc_dim == 0) {
+    nc_shape = {0};
+    in_nc_str = {1};
+    out_nc_str = {1};
+  }
+
+  int size_sorted_axis = in.shape(axis);
+  int in_stride_sorted_axis = in.strides()[axis];
+  int out_stride_sorted_axis = out.strides()[axis];
+
+  std::ostringstream kname;
+  if (arg_partition) {
+    kname << "arg";
+  }
+  kname << "radix_select_" << type_to_name(in) << "_" << type_to_name(out)
+        << "_bn" << bn;
+  auto kernel =
+      get_radix_select_kernel(d, kname.str(), in, out, arg_partition, bn);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+
+  compute_encoder.set_input_array(in, 0);
+  compute_encoder.set_output_array(out, 1);
+  compute_encoder->setBytes(&size_sorted_axis, sizeof(int), 2);
+  compute_encoder->setBytes(&kth, sizeof(int), 3);
+  compute_encoder->setBytes(&in_stride_sorted_axis, sizeof(int), 4);
+  compute_encoder->setBytes(&out_stride_sorted_axis, sizeof(int), 5);
+  compute_encoder->setBytes(&nc_dim, sizeof(int), 6);
+  compute_encoder->setBytes(nc_shape.data(), nc_shape.size() * sizeof(int), 7);
+  compute_encoder->setBytes(
+      in_nc_str.data(), in_nc_str.size() * sizeof(size_t), 8);
+  compute_encoder->setBytes(
+      out_nc_str.data(), out_nc_str.size() * sizeof(size_t), 9);
+
+  MTL::Size group_dims = MTL::Size(bn, 1, 1);
+  MTL::Size grid_dims = MTL::Size(1, n_rows, 1);
+
+  compute_encoder.dispatchThreadgroups(grid_dims, group_dims);
+}
+
+void gpu_partition(
+    const Stream& s,
+    metal::Device& d,
+    const array& in,
+    array& out,
+    int axis,
+    int kth,
+    bool arg_partition) {
+  // Rows which fit in a single block are sorted in threadgroup memory.
+  // Longer rows would need a multi block merge sort, so select the kth
+  // element with a radix select instead when the keys are at most 32 bits.
+  constexpr int max_single_block_size = 512 * 8;
+  if (in.shape(axis) > max_single_block_size && size_of(in.dtype()) <= 4 &&
+      in.dtype() != bool_) {
+    radix_select_partition(s, d, in, out, axis, kth, arg_partition);
+  } else {
+    gpu_merge_sort(s, d, in, out, axis, arg_partition);
+  }
+}
+
 } // namespace
 
 void ArgSort::eval_gpu(const std::vector<array>& inputs, array& out) {
@@ -320,7 +536,6 @@ void Sort::eval_gpu(const std::vector<array>& inputs, array& out) {
 }
 
 void ArgPartition::eval_gpu(const std::vector<array>& inputs, array& out) {
-  // We direct arg partition to sort for now
   assert(inputs.size() == 1);
 
   out.set_data(allocator::malloc_or_wait(out.nbytes()));
@@ -329,11 +544,10 @@ void ArgPartition::eval_gpu(const std::vector<array>& inputs, array& out) {
   auto& d = metal::device(s.device);
   auto& in = inputs[0];
 
-  gpu_merge_sort(s, d, in, out, axis_, true);
+  gpu_partition(s, d, in, out, axis_, kth_, true);
 }
 
 void Partition::eval_gpu(const std::vector<array>& inputs, array& out) {
-  // We direct partition to sort for now
   assert(inputs.size() == 1);
 
   out.set_data(allocator::malloc_or_wait(out.nbytes()));
@@ -342,7 +556,7 @@ void Partition::eval_gpu(const std::vector<array>& inputs, array& out) {
   auto& d = metal::device(s.device);
   auto& in = inputs[0];
 
-  gpu_merge_sort(s, d, in, out, axis_, false);
+  gpu_partition(s, d, in, out, axis_, kth_, false);
 }
 
 } // namespace mlx::core
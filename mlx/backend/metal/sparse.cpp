@@ -0,0 +1,199 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <sstream>
+
+#include "mlx/backend/metal/copy.h"
+#include "mlx/backend/metal/device.h"
+#include "mlx/backend/metal/kernels.h"
+#include "mlx/backend/metal/utils.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Must match the default of the sparse_mm kernel
+constexpr int nnz_per_thread = 8;
+
+// Rows of x up to which the 2:4 matmul uses the gemv kernel
+constexpr int sparse_gemv_max_rows = 8;
+
+} // namespace
+
+void SparseMM::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 4);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  // The kernels index the inputs as row contiguous
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  copies.reserve(inputs.size() + 2);
+  const array& rows = check_input(inputs[0]);
+  const array& cols = check_input(inputs[1]);
+  const array& values = check_input(inputs[2]);
+  const array& b = check_input(inputs[3]);
+
+  // The sums are accumulated with float32 atomics and converted after
+  bool accumulate_in_out = out.dtype() == float32;
+  if (!accumulate_in_out) {
+    copies.push_back(array(out.shape(), float32, nullptr, {}));
+  }
+  array& acc = accumulate_in_out ? out : copies.back();
+  copies.push_back(array(0, float32));
+  copy_gpu(copies.back(), acc, CopyType::Scalar, s);
+
+  int N = out.shape(1);
+  int nnz = values.size();
+  if (nnz > 0 && N > 0) {
+    auto kernel = d.get_kernel("sparse_mm_" + type_to_name(values));
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(rows, 0);
+    compute_encoder.set_input_array(cols, 1);
+    compute_encoder.set_input_array(values, 2);
+    compute_encoder.set_input_array(b, 3);
+    compute_encoder.set_output_array(acc, 4);
+    compute_encoder->setBytes(&N, sizeof(int), 5);
+    compute_encoder->setBytes(&nnz, sizeof(int), 6);
+
+    // The threads of a group read consecutive columns of b
+    size_t n_runs = (nnz + nnz_per_thread - 1) / nnz_per_thread;
+    size_t group_x = std::min<size_t>(N, 32);
+    size_t group_y = std::min<size_t>(
+        n_runs, kernel->maxTotalThreadsPerThreadgroup() / group_x);
+    compute_encoder.dispatchThreads(
+        MTL::Size(N, n_runs, 1), MTL::Size(group_x, group_y, 1));
+  }
+
+  if (!accumulate_in_out) {
+    copy_gpu(acc, out, CopyType::Vector, s);
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void SampledMM::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 4);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  copies.reserve(inputs.size());
+  const array& rows = check_input(inputs[0]);
+  const array& cols = check_input(inputs[1]);
+  const array& a = check_input(inputs[2]);
+  const array& b = check_input(inputs[3]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  int K = a.shape(1);
+  int nnz = out.size();
+  if (nnz > 0) {
+    // A simdgroup per nonzero
+    constexpr int simd_groups = 8;
+    auto kernel = d.get_kernel("sampled_mm_" + type_to_name(out));
+    auto& compute_encoder = d.get_command_encoder(s.index);
+    compute_encoder->setComputePipelineState(kernel);
+    compute_encoder.set_input_array(rows, 0);
+    compute_encoder.set_input_array(cols, 1);
+    compute_encoder.set_input_array(a, 2);
+    compute_encoder.set_input_array(b, 3);
+    compute_encoder.set_output_array(out, 4);
+    compute_encoder->setBytes(&K, sizeof(int), 5);
+    compute_encoder->setBytes(&nnz, sizeof(int), 6);
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size((nnz + simd_groups - 1) / simd_groups, 1, 1),
+        MTL::Size(32 * simd_groups, 1, 1));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+void Sparse24Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  assert(inputs.size() == 3);
+  auto& s = stream();
+  auto& d = metal::device(s.device);
+
+  std::vector<array> copies;
+  auto check_input = [&copies, &s](const array& x) -> const array& {
+    if (x.flags().row_contiguous) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  copies.reserve(inputs.size());
+  const array& x = check_input(inputs[0]);
+  const array& values = check_input(inputs[1]);
+  const array& metadata = check_input(inputs[2]);
+  out.set_data(allocator::malloc_or_wait(out.nbytes()));
+
+  int N = values.shape(0);
+  int K = values.shape(1) * 2;
+  int M = x.size() / K;
+  if (M == 0 || N == 0) {
+    return;
+  }
+
+  // Few rows read each weight once in a gemv, more use the tiled gemm
+  int bm = 0, bn = 0, bk = 32, wm = 2, wn = 2, max_rows = 0;
+  std::ostringstream kname;
+  if (M <= sparse_gemv_max_rows) {
+    max_rows = M == 1 ? 1 : sparse_gemv_max_rows;
+    kname << "sparse_2_4_gemv_" << type_to_name(out) << "_m" << max_rows;
+  } else {
+    bm = bn = (size_t(M) * N >= (1ul << 20)) ? 64 : 32;
+    kname << "steel_sparse_2_4_gemm_" << type_to_name(out) << "_bm" << bm
+          << "_bn" << bn << "_bk" << bk << "_wm" << wm << "_wn" << wn;
+  }
+  auto kernel = get_steel_gemm_sparse_kernel(
+      d, kname.str(), out, bm, bn, bk, wm, wn, max_rows);
+
+  auto& compute_encoder = d.get_command_encoder(s.index);
+  compute_encoder->setComputePipelineState(kernel);
+  compute_encoder.set_input_array(x, 0);
+  compute_encoder.set_input_array(values, 1);
+  compute_encoder.set_input_array(metadata, 2);
+  compute_encoder.set_output_array(out, 3);
+  compute_encoder->setBytes(&M, sizeof(int), 4);
+  compute_encoder->setBytes(&N, sizeof(int), 5);
+  compute_encoder->setBytes(&K, sizeof(int), 6);
+  if (bm == 0) {
+    // Two simdgroups of four rows each per threadgroup
+    constexpr int rows_per_group = 8;
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size((N + rows_per_group - 1) / rows_per_group, 1, 1),
+        MTL::Size(64, 1, 1));
+  } else {
+    compute_encoder.dispatchThreadgroups(
+        MTL::Size((N + bn - 1) / bn, (M + bm - 1) / bm, 1),
+        MTL::Size(32, wn, wm));
+  }
+
+  d.get_command_buffer(s.index)->addCompletedHandler(
+      [copies](MTL::CommandBuffer*) mutable { copies.clear(); });
+}
+
+} // namespace mlx::core
@@ -3,6 +3,7 @@
 #include "mlx/backend/common/ternary.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
+#include "mlx/backend/metal/kernels/defines.h"
 #include "mlx/backend/metal/utils.h"
 #include "mlx/primitives.h"
 
@@ -31,6 +32,10 @@ void ternary_op_gpu_inplace(
   auto& strides_b = strides[1];
   auto& strides_c = strides[2];
   auto& strides_out = strides[3];
+  bool n_writes = topt != TernaryOpType::General &&
+      out.data_size() >= ELEMWISE_N_WRITES_MIN_SIZE;
+  bool large = out.data_size() > INT32_MAX || a.data_size() > INT32_MAX ||
+      b.data_size() > INT32_MAX || c.data_size() > INT32_MAX;
 
   std::string kernel_name;
   {
@@ -40,8 +45,11 @@ void ternary_op_gpu_inplace(
       if (shape.size() <= MAX_TERNARY_SPECIALIZED_DIMS) {
         kname << shape.size();
       }
+      if (large) {
+        kname << "large";
+      }
     } else {
-      kname << "v";
+      kname << (n_writes ? "vn" : "v");
     }
     kname << "_" << op << type_to_name(b);
     kernel_name = kname.str();
@@ -80,6 +88,10 @@ void ternary_op_gpu_inplace(
     size_t dim0 = ndim > 0 ? shape[ndim - 1] : 1;
     size_t dim1 = ndim > 1 ? shape[ndim - 2] : 1;
     size_t rest = out.size() / (dim0 * dim1);
+    if (ndim > 3) {
+      // A thread per ELEMWISE_N_WRITES elements of the inner dim
+      dim0 = (dim0 + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
     NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
     if (thread_group_size != 1024) {
       throw std::runtime_error("[Metal::binary] Must use 1024 sized block");
@@ -90,6 +102,10 @@ void ternary_op_gpu_inplace(
   } else {
     // Launch a 1D grid of threads
     size_t nthreads = out.data_size();
+    if (n_writes) {
+      compute_encoder->setBytes(&nthreads, sizeof(size_t), 4);
+      nthreads = (nthreads + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
     MTL::Size grid_dims = MTL::Size(nthreads, 1, 1);
     NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
     if (thread_group_size > nthreads) {
@@ -1,7 +1,9 @@
 // Copyright © 2024 Apple Inc.
 
+#include "mlx/backend/common/utils.h"
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
+#include "mlx/backend/metal/kernels/defines.h"
 #include "mlx/backend/metal/utils.h"
 #include "mlx/primitives.h"
 
@@ -25,30 +27,54 @@ void unary_op_gpu_inplace(
 
   auto& d = metal::device(s.device);
 
-  std::string kernel_name = (contig ? "v" : "g") + op + type_to_name(out);
-  auto kernel = get_unary_kernel(d, kernel_name, out.dtype(), op);
-
   size_t nthreads = contig ? in.data_size() : in.size();
-  MTL::Size grid_dims = MTL::Size(nthreads, 1, 1);
-  NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
-  if (thread_group_size > nthreads) {
-    thread_group_size = nthreads;
-  }
-  MTL::Size group_dims = MTL::Size(thread_group_size, 1, 1);
+  bool n_writes = contig && nthreads >= ELEMWISE_N_WRITES_MIN_SIZE;
+  bool large = in.data_size() > INT32_MAX || out.data_size() > INT32_MAX;
+  std::string kernel_name = contig ? (n_writes ? "vn" : "v")
+                                   : (large ? "glarge" : "g");
+  kernel_name += op + type_to_name(out);
+  auto kernel = get_unary_kernel(d, kernel_name, out.dtype(), op);
 
   auto& compute_encoder = d.get_command_encoder(s.index);
   compute_encoder->setComputePipelineState(kernel);
   compute_encoder.set_input_array(
       in.data_shared_ptr() == nullptr ? out : in, 0);
   compute_encoder.set_output_array(out, 1);
-  if (!contig) {
-    compute_encoder->setBytes(in.shape().data(), in.ndim() * sizeof(int), 2);
-    compute_encoder->setBytes(
-        in.strides().data(), in.ndim() * sizeof(size_t), 3);
-    int ndim = in.ndim();
+  if (contig) {
+    size_t size = nthreads;
+    if (n_writes) {
+      compute_encoder->setBytes(&size, sizeof(size_t), 2);
+      nthreads = (nthreads + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    }
+    MTL::Size grid_dims = MTL::Size(nthreads, 1, 1);
+    NS::UInteger thread_group_size = kernel->maxTotalThreadsPerThreadgroup();
+    if (thread_group_size > nthreads) {
+      thread_group_size = nthreads;
+    }
+    MTL::Size group_dims = MTL::Size(thread_group_size, 1, 1);
+    compute_encoder.dispatchThreads(grid_dims, group_dims);
+  } else {
+    // Collapse the contiguous dims, the kernel expects at least 2
+    auto [shape, strides] = collapse_contiguous_dims(in);
+    auto& in_strides = strides[0];
+    if (shape.size() < 2) {
+      shape.insert(shape.begin(), 1);
+      in_strides.insert(in_strides.begin(), 0);
+    }
+    int ndim = shape.size();
+    compute_encoder->setBytes(shape.data(), ndim * sizeof(int), 2);
+    compute_encoder->setBytes(in_strides.data(), ndim * sizeof(size_t), 3);
     compute_encoder->setBytes(&ndim, sizeof(int), 4);
+
+    // A thread per ELEMWISE_N_WRITES elements of the inner dim
+    size_t dim0 = shape[ndim - 1];
+    size_t dim1 = shape[ndim - 2];
+    size_t rest = in.size() / (dim0 * dim1);
+    dim0 = (dim0 + ELEMWISE_N_WRITES - 1) / ELEMWISE_N_WRITES;
+    auto group_dims = get_block_dims(dim0, dim1, rest);
+    MTL::Size grid_dims = MTL::Size(dim0, dim1, rest);
+    compute_encoder.dispatchThreads(grid_dims, group_dims);
   }
-  compute_encoder.dispatchThreads(grid_dims, group_dims);
 }
 
 void unary_op_gpu(
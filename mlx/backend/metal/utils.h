@@ -73,6 +73,10 @@ std::string type_to_name(const array& a) {
   return tname;
 }
 
+// Contiguous elementwise ops of at least this many elements use the kernels
+// which write ELEMWISE_N_WRITES elements per thread
+constexpr size_t ELEMWISE_N_WRITES_MIN_SIZE = 1 << 16;
+
 MTL::Size get_block_dims(int dim0, int dim1, int dim2) {
   int pows[3] = {0, 0, 0};
   int sum = 0;
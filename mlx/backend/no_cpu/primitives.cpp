@@ -34,6 +34,7 @@ NO_CPU(AsStrided)
 NO_CPU(BitwiseBinary)
 NO_CPU(BlockMaskedMM)
 NO_CPU(Broadcast)
+NO_CPU_MULTI(CacheAppend)
 NO_CPU(Ceil)
 NO_CPU(Cholesky)
 NO_CPU(Concatenate)
@@ -44,6 +45,7 @@ NO_CPU(Cos)
 NO_CPU(Cosh)
 NO_CPU_MULTI(CustomVJP)
 NO_CPU_MULTI(Depends)
+NO_CPU(Dequantize)
 NO_CPU(Divide)
 NO_CPU_MULTI(DivMod)
 NO_CPU(NumberOfElements)
@@ -58,9 +60,14 @@ NO_CPU(Floor)
 NO_CPU(Full)
 NO_CPU(Gather)
 NO_CPU(GatherMM)
+NO_CPU(SampledMM)
+NO_CPU(SparseMM)
+NO_CPU(Sparse24Matmul)
+NO_CPU(Fp8Matmul)
 NO_CPU(GatherQMM)
 NO_CPU(Greater)
 NO_CPU(GreaterEqual)
+NO_CPU(Hadamard)
 NO_CPU(Less)
 NO_CPU(LessEqual)
 NO_CPU(Load)
@@ -70,7 +77,9 @@ NO_CPU(LogicalNot)
 NO_CPU(LogicalAnd)
 NO_CPU(LogicalOr)
 NO_CPU(LogAddExp)
+NO_CPU(LogSumExp)
 NO_CPU(Matmul)
+NO_CPU_MULTI(MatmulVJP)
 NO_CPU(Maximum)
 NO_CPU(Minimum)
 NO_CPU(Multiply)
@@ -80,13 +89,18 @@ NO_CPU(Pad)
 NO_CPU(Partition)
 NO_CPU(Power)
 NO_CPU_MULTI(QRF)
+NO_CPU_MULTI(Quantize)
 NO_CPU(QuantizedMatmul)
 NO_CPU(RandomBits)
+NO_CPU(RandomNormal)
+NO_CPU(RandomDropout)
 NO_CPU(Reduce)
 NO_CPU(Reshape)
 NO_CPU(Round)
 NO_CPU(Scan)
 NO_CPU(Scatter)
+NO_CPU(SegmentedReduce)
+NO_CPU(SegmentedScan)
 NO_CPU(Select)
 NO_CPU(Sigmoid)
 NO_CPU(Sign)
@@ -106,6 +120,9 @@ NO_CPU(Tan)
 NO_CPU(Tanh)
 NO_CPU(Transpose)
 NO_CPU(Inverse)
+NO_CPU_MULTI(Eigh)
+NO_CPU(Solve)
+NO_CPU(SolveTriangular)
 NO_CPU(View)
 
 } // namespace mlx::core
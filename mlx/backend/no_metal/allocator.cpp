@@ -5,12 +5,17 @@
 namespace mlx::core::allocator {
 
 Allocator& allocator() {
-  static CommonAllocator allocator_;
-  return allocator_;
+  return common_allocator();
 }
 
 void* Buffer::raw_ptr() {
   return ptr_;
 }
 
+Buffer make_external(void* ptr, size_t) {
+  return Buffer{ptr};
+}
+
+void release_external(Buffer) {}
+
 } // namespace mlx::core::allocator
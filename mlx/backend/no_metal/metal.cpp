@@ -2,21 +2,26 @@
 
 #include <stdexcept>
 
+#include "mlx/allocator.h"
 #include "mlx/backend/metal/metal.h"
 #include "mlx/backend/metal/metal_impl.h"
+
 namespace mlx::core::metal {
 
 bool is_available() {
   return false;
 }
 
-void new_stream(Stream) {}
+void new_stream(Stream, StreamPriority) {}
 
 std::unique_ptr<void, std::function<void(void*)>> new_scoped_memory_pool() {
   return nullptr;
 }
 
-std::function<void()> make_task(array arr, bool signal) {
+std::function<void()> make_task(
+    array arr,
+    bool signal,
+    std::optional<CancellationToken> token) {
   throw std::runtime_error(
       "[metal::make_task] Cannot make GPU task without metal backend");
 }
@@ -29,26 +34,61 @@ std::function<void()> make_synchronize_task(
       " without metal backend");
 }
 
-// No-ops when Metal is not available.
+void capture_primitive(std::shared_ptr<Primitive>) {}
+
+// Memory stats and cache controls report the CPU allocator when Metal is not
+// available.
 size_t get_active_memory() {
-  return 0;
+  return allocator::common_allocator().get_active_memory();
 }
 size_t get_peak_memory() {
-  return 0;
+  return allocator::common_allocator().get_peak_memory();
+}
+void reset_peak_memory() {
+  allocator::common_allocator().reset_peak_memory();
 }
-void reset_peak_memory() {}
 size_t get_cache_memory() {
-  return 0;
+  return allocator::common_allocator().get_cache_memory();
 }
 size_t set_memory_limit(size_t, bool) {
   return 0;
 }
-size_t set_cache_limit(size_t) {
+size_t get_memory_limit() {
+  return 0;
+}
+size_t set_cache_limit(size_t limit) {
+  return allocator::common_allocator().set_cache_limit(limit);
+}
+size_t set_wired_limit(size_t) {
   return 0;
 }
+size_t get_wired_memory() {
+  return 0;
+}
+void make_resident(const std::vector<array>&) {}
+void prepack(const std::vector<array>&) {}
+void clear_prepacked() {}
+void precompile(const std::vector<array>&) {}
+void start_profiling() {}
+void stop_profiling() {}
+std::unordered_map<std::string, std::pair<size_t, double>> get_profile() {
+  return {};
+}
+void save_profile_trace(const std::string&) {
+  throw std::runtime_error(
+      "[metal::save_profile_trace] Cannot profile without metal backend");
+}
 void start_capture(std::string path) {}
 void stop_capture() {}
-void clear_cache() {}
+void clear_cache() {
+  allocator::common_allocator().clear_cache();
+}
+std::unordered_map<std::string, size_t> get_cache_stats() {
+  return allocator::common_allocator().get_cache_stats();
+}
+void reset_cache_stats() {
+  allocator::common_allocator().reset_cache_stats();
+}
 
 std::unordered_map<std::string, std::variant<std::string, size_t>>
 device_info() {
@@ -1,6 +1,7 @@
 // Copyright © 2023-2024 Apple Inc.
 
 #include "mlx/primitives.h"
+#include "mlx/distributed/primitives.h"
 #include "mlx/fast_primitives.h"
 
 #define NO_GPU_MULTI(func)                                             \
@@ -35,6 +36,7 @@ NO_GPU(AsStrided)
 NO_GPU(BitwiseBinary)
 NO_GPU(BlockMaskedMM)
 NO_GPU(Broadcast)
+NO_GPU_MULTI(CacheAppend)
 NO_GPU(Ceil)
 NO_GPU_MULTI(Compiled)
 NO_GPU(Concatenate)
@@ -45,6 +47,7 @@ NO_GPU(Cos)
 NO_GPU(Cosh)
 NO_GPU_MULTI(CustomVJP)
 NO_GPU_MULTI(Depends)
+NO_GPU(Dequantize)
 NO_GPU(Divide)
 NO_GPU_MULTI(DivMod)
 NO_GPU(NumberOfElements)
@@ -59,9 +62,14 @@ NO_GPU(Floor)
 NO_GPU(Full)
 NO_GPU(Gather)
 NO_GPU(GatherMM)
+NO_GPU(SampledMM)
+NO_GPU(SparseMM)
+NO_GPU(Sparse24Matmul)
+NO_GPU(Fp8Matmul)
 NO_GPU(GatherQMM)
 NO_GPU(Greater)
 NO_GPU(GreaterEqual)
+NO_GPU(Hadamard)
 NO_GPU(Less)
 NO_GPU(LessEqual)
 NO_GPU(Load)
@@ -71,7 +79,9 @@ NO_GPU(LogicalNot)
 NO_GPU(LogicalAnd)
 NO_GPU(LogicalOr)
 NO_GPU(LogAddExp)
+NO_GPU(LogSumExp)
 NO_GPU(Matmul)
+NO_GPU_MULTI(MatmulVJP)
 NO_GPU(Maximum)
 NO_GPU(Minimum)
 NO_GPU(Multiply)
@@ -81,13 +91,18 @@ NO_GPU(Pad)
 NO_GPU(Partition)
 NO_GPU(Power)
 NO_GPU_MULTI(QRF)
+NO_GPU_MULTI(Quantize)
 NO_GPU(QuantizedMatmul)
 NO_GPU(RandomBits)
+NO_GPU(RandomNormal)
+NO_GPU(RandomDropout)
 NO_GPU(Reduce)
 NO_GPU(Reshape)
 NO_GPU(Round)
 NO_GPU(Scan)
 NO_GPU(Scatter)
+NO_GPU(SegmentedReduce)
+NO_GPU(SegmentedScan)
 NO_GPU(Select)
 NO_GPU(Sigmoid)
 NO_GPU(Sign)
@@ -108,15 +123,42 @@ NO_GPU(Tanh)
 NO_GPU(Transpose)
 NO_GPU(Inverse)
 NO_GPU(Cholesky)
+NO_GPU_MULTI(Eigh)
+NO_GPU(Solve)
+NO_GPU(SolveTriangular)
 NO_GPU(View)
 
 namespace fast {
+NO_GPU_MULTI(AdamUpdate)
+NO_GPU_MULTI(CrossEntropy)
+NO_GPU_MULTI(CrossEntropyVJP)
+NO_GPU_MULTI(GroupNorm)
+NO_GPU_MULTI(GroupNormVJP)
 NO_GPU_MULTI(LayerNorm)
 NO_GPU_MULTI(LayerNormVJP)
+NO_GPU_MULTI(LionUpdate)
+NO_GPU_MULTI(MeanVar)
 NO_GPU_MULTI(RMSNorm)
+NO_GPU_MULTI(RMSNormResidual)
 NO_GPU_MULTI(RMSNormVJP)
 NO_GPU_MULTI(RoPE)
 NO_GPU(ScaledDotProductAttention)
+NO_GPU_MULTI(ScaledDotProductAttentionVJP)
+NO_GPU(QuantizedScaledDotProductAttention)
+NO_GPU(PagedAttention)
+NO_GPU(RaggedAttention)
+NO_GPU(QuantizedMatmulEpilogue)
+NO_GPU(QuantizedMatmulW8A8)
+NO_GPU(ConvolutionEpilogue)
+NO_GPU(ConvolutionWeightGrad)
+NO_GPU_MULTI(CustomKernel)
 } // namespace fast
 
+namespace distributed {
+NO_GPU_MULTI(AllReduce)
+NO_GPU_MULTI(AllGather)
+NO_GPU_MULTI(ReduceScatter)
+NO_GPU_MULTI(BroadcastRoot)
+} // namespace distributed
+
 } // namespace mlx::core
@@ -0,0 +1,120 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+
+#include "mlx/backend/metal/metal.h"
+#include "mlx/batch_split.h"
+#include "mlx/ops.h"
+#include "mlx/transforms.h"
+#include "mlx/utils.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Both devices keep a small share of the batch so that their throughput
+// keeps being measured
+constexpr float min_fraction = 0.01;
+constexpr float max_fraction = 0.99;
+
+} // namespace
+
+BatchSplit::BatchSplit(
+    Function fun,
+    float cpu_fraction /* = 0.1 */,
+    bool adaptive /* = true */)
+    : fun_(std::move(fun)), adaptive_(adaptive) {
+  if (cpu_fraction < 0 || cpu_fraction > 1) {
+    throw std::invalid_argument(
+        "[BatchSplit] The CPU fraction must be between 0 and 1.");
+  }
+  cpu_fraction_ = cpu_fraction;
+}
+
+std::vector<array> BatchSplit::operator()(const std::vector<array>& inputs) {
+  if (inputs.empty()) {
+    throw std::invalid_argument("[BatchSplit] Expected at least one input.");
+  }
+  int n = inputs[0].ndim() > 0 ? inputs[0].shape(0) : 0;
+  for (auto& in : inputs) {
+    if (in.ndim() == 0 || in.shape(0) != n) {
+      throw std::invalid_argument(
+          "[BatchSplit] The inputs must have the same size in their first "
+          "axis.");
+    }
+  }
+  float cpu_fraction = cpu_fraction_.load();
+  int n_cpu = std::lround(cpu_fraction * n);
+  if (!metal::is_available() || n_cpu == 0 || n_cpu == n) {
+    return fun_(inputs);
+  }
+  int n_gpu = n - n_cpu;
+
+  auto gpu = default_stream(Device::gpu);
+  auto cpu = default_stream(Device::cpu);
+  std::vector<array> gpu_inputs;
+  std::vector<array> cpu_inputs;
+  // Each part is sliced on the stream which reads it
+  for (auto& in : inputs) {
+    std::vector<int> start(in.ndim(), 0);
+    auto stop = in.shape();
+    stop[0] = n_gpu;
+    gpu_inputs.push_back(slice(in, start, stop, gpu));
+    start[0] = n_gpu;
+    stop[0] = n;
+    cpu_inputs.push_back(slice(in, start, stop, cpu));
+  }
+  std::vector<array> gpu_outputs;
+  {
+    StreamContext ctx(gpu);
+    gpu_outputs = fun_(gpu_inputs);
+  }
+  std::vector<array> cpu_outputs;
+  {
+    StreamContext ctx(cpu);
+    cpu_outputs = fun_(cpu_inputs);
+  }
+  if (gpu_outputs.size() != cpu_outputs.size()) {
+    throw std::runtime_error(
+        "[BatchSplit] The function returned a different number of outputs "
+        "for the two parts.");
+  }
+
+  // Submit both parts at once and note when each one finishes, the CPU part
+  // is waited for on a helper thread
+  auto start = std::chrono::steady_clock::now();
+  auto events = async_eval_batch({gpu_outputs, cpu_outputs});
+  auto elapsed = [start]() {
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+  auto cpu_done = std::async(std::launch::async, [&events, &elapsed]() {
+    events[1].wait();
+    return elapsed();
+  });
+  events[0].wait();
+  double gpu_time = elapsed();
+  double cpu_time = cpu_done.get();
+
+  if (adaptive_) {
+    double gpu_rate = n_gpu / std::max(gpu_time, 1e-6);
+    double cpu_rate = n_cpu / std::max(cpu_time, 1e-6);
+    float measured = cpu_rate / (cpu_rate + gpu_rate);
+    cpu_fraction_.store(std::clamp(
+        0.5f * (cpu_fraction + measured), min_fraction, max_fraction));
+  }
+
+  std::vector<array> outputs;
+  outputs.reserve(gpu_outputs.size());
+  for (int i = 0; i < gpu_outputs.size(); i++) {
+    outputs.push_back(concatenate({gpu_outputs[i], cpu_outputs[i]}, 0, cpu));
+  }
+  return outputs;
+}
+
+} // namespace mlx::core
@@ -0,0 +1,51 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+/* Runs a function over a batch on the GPU and the CPU at the same time.
+ *
+ * The inputs are split along their first axis, the leading part of the
+ * batch is computed on the default GPU stream and the rest on the default
+ * CPU stream, and the outputs of the two parts are concatenated along their
+ * first axis. The function must treat the elements of the batch
+ * independently, for instance a matmul, a convolution or elementwise ops
+ * over the batch. The parts of the inputs are views and with unified memory
+ * the CPU reads them in place.
+ *
+ * Each call evaluates the two parts and, when adaptive, moves the share of
+ * the CPU towards the ratio of the throughputs measured on the two devices
+ * so that both finish at the same time. Without Metal the function simply
+ * runs on the whole batch.
+ * */
+class BatchSplit {
+ public:
+  using Function = std::function<std::vector<array>(const std::vector<array>&)>;
+
+  explicit BatchSplit(
+      Function fun,
+      float cpu_fraction = 0.1,
+      bool adaptive = true);
+
+  std::vector<array> operator()(const std::vector<array>& inputs);
+
+  /* The share of the batch currently computed on the CPU. */
+  float cpu_fraction() const {
+    return cpu_fraction_.load();
+  }
+
+ private:
+  Function fun_;
+  // Calls from several threads read and update the share concurrently
+  std::atomic<float> cpu_fraction_;
+  bool adaptive_;
+};
+
+} // namespace mlx::core
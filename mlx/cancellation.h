@@ -0,0 +1,48 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+/** A token to cancel the evaluations it is given to.
+ *
+ * Copies of a token share its state. Once it is cancelled the primitives
+ * of the evaluations which have not started yet are skipped, their outputs
+ * are left unevaluated with their graph so they can be evaluated again,
+ * and the buffers they would have needed are never allocated. Primitives
+ * already running, or already encoded on the GPU, finish. */
+class CancellationToken {
+ public:
+  CancellationToken()
+      : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  void cancel() {
+    cancelled_->store(true);
+  }
+
+  bool cancelled() const {
+    return cancelled_->load();
+  }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+namespace detail {
+
+/* Whether the task evaluating arr should be skipped, since the token was
+ * cancelled or one of its inputs was skipped. Skipped arrays and their
+ * siblings are marked unscheduled. */
+bool skip_cancelled(
+    const array& arr,
+    const std::optional<CancellationToken>& token);
+
+} // namespace detail
+
+} // namespace mlx::core
@@ -1,16 +1,25 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
+#include <list>
+#include <cstring>
 #include <map>
+#include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "mlx/allocator.h"
+#include "mlx/backend/metal/metal_impl.h"
 #include "mlx/compile.h"
 #include "mlx/compile_impl.h"
 #include "mlx/primitives.h"
 #include "mlx/transforms.h"
 #include "mlx/transforms_impl.h"
+#include "mlx/utils.h"
 
 namespace mlx::core {
 
@@ -66,17 +75,49 @@ bool is_reduction(const Primitive& p) {
   return typeid(p) == typeid(Reduce) || typeid(p) == typeid(ArgReduce);
 }
 
+// Elementwise primitives defined outside of MLX which provide their source
+bool is_custom_elementwise(const Primitive& p) {
+  return !p.elementwise_source().empty();
+}
+
 bool is_fusable(const Primitive& p) {
   return is_unary(p) || is_binary(p) || is_ternary(p) || is_broadcast(p) ||
-      is_noop(p);
+      is_noop(p) || is_custom_elementwise(p);
+}
+
+// Reductions over trailing axes can end a fused section so that their
+// elementwise input is computed row by row and never materialized
+bool is_fusable_reduction(const array& a) {
+  if (!a.has_primitive() || typeid(a.primitive()) != typeid(Reduce)) {
+    return false;
+  }
+  auto& r = static_cast<const Reduce&>(a.primitive());
+  if (r.reduce_type() == Reduce::And || r.reduce_type() == Reduce::Or) {
+    return false;
+  }
+  auto t = a.dtype();
+  if (t != float32 && t != float16 && t != bfloat16 && t != int32 &&
+      t != uint32) {
+    return false;
+  }
+  auto axes = r.axes();
+  std::sort(axes.begin(), axes.end());
+  int first = a.ndim() - axes.size();
+  for (int i = 0; i < axes.size(); ++i) {
+    if (axes[i] != first + i) {
+      return false;
+    }
+  }
+  return !axes.empty();
 }
 
 bool allows_shapeless(const Primitive& p) {
   return typeid(p) == typeid(Compiled) || is_unary(p) || is_binary(p) ||
       is_noop(p) || is_reduction(p) || typeid(p) == typeid(Softmax) ||
-      typeid(p) == typeid(Sort) || typeid(p) == typeid(ArgSort) ||
-      typeid(p) == typeid(ArgPartition) || typeid(p) == typeid(Partition) ||
-      typeid(p) == typeid(Select) || typeid(p) == typeid(NumberOfElements);
+      typeid(p) == typeid(LogSumExp) || typeid(p) == typeid(Sort) ||
+      typeid(p) == typeid(ArgSort) || typeid(p) == typeid(ArgPartition) ||
+      typeid(p) == typeid(Partition) || typeid(p) == typeid(Select) ||
+      typeid(p) == typeid(NumberOfElements);
 }
 
 Compiled::Compiled(
@@ -146,6 +187,13 @@ std::vector<std::vector<int>> Compiled::output_shapes(
       out_shape[i] = std::max(out_shape[i], in.shape()[i - dd]);
     }
   }
+  // A fused reduction keeps the reduced axes as singletons
+  if (typeid(tape_.back().primitive()) == typeid(Reduce)) {
+    auto& r = static_cast<const Reduce&>(tape_.back().primitive());
+    for (auto ax : r.axes()) {
+      out_shape[ax] = 1;
+    }
+  }
   // All outputs have the same shape
   return std::vector<std::vector<int>>(outputs_.size(), out_shape);
 }
@@ -156,6 +204,8 @@ CompileMode& compile_mode() {
   auto get_val = []() {
     if (const char* buff_str = std::getenv("MLX_DISABLE_COMPILE")) {
       return CompileMode::disabled;
+    } else if (std::getenv("MLX_COMPILE_CAPTURE")) {
+      return CompileMode::capture;
     } else {
       return CompileMode::enabled;
     }
@@ -164,9 +214,6 @@ CompileMode& compile_mode() {
   return compile_mode_;
 }
 
-using ParentsMap =
-    std::unordered_map<std::uintptr_t, std::vector<std::pair<array, int>>>;
-
 // Helper like below but only merges the two provided arrays. If the src has
 // siblings then these won't be merged to the dst.
 void merge_one(array& dst, array& src, ParentsMap& parents_map) {
@@ -207,6 +254,10 @@ std::uintptr_t get_function_address(const std::function<T(U...)>& fun) {
   return reinterpret_cast<std::uintptr_t>(*fun_ptr);
 }
 
+inline void hash_combine(uint64_t& h, uint64_t v) {
+  h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+}
+
 class CompilerCache {
  public:
   struct CacheEntry {
@@ -215,6 +266,8 @@ class CompilerCache {
     std::vector<array> tape;
     bool empty{true};
     std::vector<uint64_t> constants;
+    // Intermediates and inputs whose buffer their last user can reuse
+    std::unordered_set<uintptr_t> donations;
   };
 
   // Returns a reference to a CacheEntry which can be updated
@@ -225,7 +278,7 @@ class CompilerCache {
       bool shapeless,
       const std::vector<uint64_t>& constants) {
     // Find the cache entries for |fun_id|.
-    std::vector<CacheEntry>& entries = cache_[fun_id];
+    FunctionCache& fun_cache = cache_[fun_id];
     // Compare if 2 arrays have same shape and dtype.
     auto has_same_shape_and_dtype = [shapeless](
                                         const std::vector<array>& in1,
@@ -246,35 +299,110 @@ class CompilerCache {
       }
       return true;
     };
-    // Loop over entries and check inputs match i.e. shapes and types must be
-    // equal. Note this could get really slow if one compiles the same
-    // function with many different shapes. May want to store entries in a
-    // more easily searchable structure.
-    for (CacheEntry& entry : entries) {
-      // Check the inputs match and return if so
-      if (has_same_shape_and_dtype(inputs, entry.inputs) &&
-          constants == entry.constants) {
-        return entry;
+    // Only the entries with the same hash are compared and the matching one
+    // is moved to the front of the recently used list
+    auto key = hash(inputs, shapeless, constants);
+    auto [first, last] = fun_cache.index.equal_range(key);
+    for (auto it = first; it != last; ++it) {
+      auto entry = it->second;
+      if (has_same_shape_and_dtype(inputs, entry->inputs) &&
+          constants == entry->constants) {
+        stats_.hits++;
+        fun_cache.entries.splice(
+            fun_cache.entries.begin(), fun_cache.entries, entry);
+        return *entry;
       }
     }
-    // Otherwise append a new cache entry
-    entries.push_back(CacheEntry{});
-    return entries.back();
+    // Otherwise add a new cache entry and evict the least recently used one
+    // when the function has too many
+    stats_.misses++;
+    fun_cache.entries.emplace_front();
+    fun_cache.index.emplace(key, fun_cache.entries.begin());
+    if (capacity_ > 0 && fun_cache.entries.size() > capacity_) {
+      auto lru = std::prev(fun_cache.entries.end());
+      auto [first, last] = fun_cache.index.equal_range(lru->key);
+      for (auto it = first; it != last; ++it) {
+        if (it->second == lru) {
+          fun_cache.index.erase(it);
+          break;
+        }
+      }
+      fun_cache.entries.erase(lru);
+      stats_.evictions++;
+    }
+    auto& entry = fun_cache.entries.front();
+    entry.key = key;
+    return entry;
   }
 
   void erase(std::uintptr_t fun_id) {
     cache_.erase(fun_id);
   }
 
+  void set_capacity(size_t capacity) {
+    capacity_ = capacity;
+  }
+
+  CompileCacheStats& stats() {
+    return stats_;
+  }
+
+  size_t size() const {
+    size_t n = 0;
+    for (auto& [fun_id, fun_cache] : cache_) {
+      n += fun_cache.entries.size();
+    }
+    return n;
+  }
+
  private:
+  struct Entry : CacheEntry {
+    uint64_t key;
+  };
+
+  struct FunctionCache {
+    // Most recently used first
+    std::list<Entry> entries;
+    std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+  };
+
+  // Hashes what a cache hit has to match: the number of dimensions, the
+  // shapes unless shapeless, the types and the constants
+  static uint64_t hash(
+      const std::vector<array>& inputs,
+      bool shapeless,
+      const std::vector<uint64_t>& constants) {
+    uint64_t h = 14695981039346656037ull;
+    auto combine = [&h](uint64_t v) { hash_combine(h, v); };
+    combine(inputs.size());
+    for (auto& in : inputs) {
+      combine(in.ndim());
+      combine(static_cast<uint64_t>(in.dtype().val));
+      if (!shapeless) {
+        for (auto s : in.shape()) {
+          combine(s);
+        }
+      }
+    }
+    for (auto c : constants) {
+      combine(c);
+    }
+    return h;
+  }
+
   CompilerCache() {
     // Make sure the allocator is fully
     // initialized before the compiler cache
     allocator::allocator();
+    if (const char* capacity = std::getenv("MLX_COMPILE_CACHE_CAPACITY")) {
+      capacity_ = std::strtoul(capacity, nullptr, 10);
+    }
   }
 
   friend CompilerCache& compiler_cache();
-  std::unordered_map<std::uintptr_t, std::vector<CacheEntry>> cache_;
+  std::unordered_map<std::uintptr_t, FunctionCache> cache_;
+  size_t capacity_{128};
+  CompileCacheStats stats_;
 };
 
 CompilerCache& compiler_cache() {
@@ -344,153 +472,371 @@ std::pair<std::vector<array>, ParentsMap> compile_dfs(
   return {tape, parents_map};
 }
 
+// Casting to the destination type and back gives the source value
+bool is_lossless_cast(Dtype from, Dtype to) {
+  auto from_kind = kindof(from);
+  auto to_kind = kindof(to);
+  if (from == to || from_kind == Dtype::Kind::b) {
+    return true;
+  }
+  switch (to_kind) {
+    case Dtype::Kind::u:
+      return from_kind == Dtype::Kind::u && to.size > from.size;
+    case Dtype::Kind::i:
+      return (from_kind == Dtype::Kind::i || from_kind == Dtype::Kind::u) &&
+          to.size > from.size;
+    case Dtype::Kind::f:
+    case Dtype::Kind::V:
+      if (from_kind == Dtype::Kind::f || from_kind == Dtype::Kind::V) {
+        return to == float32 && from.size == 2;
+      }
+      // Integers up to the number of bits of the mantissa are exact
+      return from.size == 1 || (from.size == 2 && to == float32);
+    case Dtype::Kind::c:
+      return from_kind == Dtype::Kind::f && from.size <= 4;
+    default:
+      return false;
+  }
+}
+
+// Returns an array the given one can be replaced with when its primitive
+// has no effect, e.g. multiplying by one or undoing the previous transpose
+std::optional<array> simplify_array(const array& a, bool shapeless) {
+  auto& p = a.primitive();
+  if (typeid(p) == typeid(Transpose)) {
+    auto& in = a.inputs()[0];
+    if (!in.has_primitive() || typeid(in.primitive()) != typeid(Transpose)) {
+      return std::nullopt;
+    }
+    auto& outer = static_cast<const Transpose&>(p).axes();
+    auto& inner = static_cast<const Transpose&>(in.primitive()).axes();
+    for (int i = 0; i < outer.size(); ++i) {
+      if (inner[outer[i]] != i) {
+        return std::nullopt;
+      }
+    }
+    return in.inputs()[0];
+  }
+  if (typeid(p) == typeid(Reshape)) {
+    auto& in = a.inputs()[0];
+    if (!shapeless && in.shape() == a.shape()) {
+      return in;
+    }
+    return std::nullopt;
+  }
+  if (typeid(p) == typeid(AsType)) {
+    auto& in = a.inputs()[0];
+    if (in.has_primitive() && typeid(in.primitive()) == typeid(AsType) &&
+        in.inputs()[0].dtype() == a.dtype() &&
+        is_lossless_cast(a.dtype(), in.dtype())) {
+      return in.inputs()[0];
+    }
+    return std::nullopt;
+  }
+  if (typeid(p) == typeid(Multiply)) {
+    auto is_one = [](array x) {
+      // Scalars are broadcast to the shape of the other operand
+      if (x.has_primitive() && typeid(x.primitive()) == typeid(Broadcast)) {
+        x = x.inputs()[0];
+      }
+      if (!x.is_available() || x.ndim() != 0) {
+        return false;
+      }
+      switch (x.dtype()) {
+        case bool_:
+          return *x.data<bool>();
+        case float16:
+          return *x.data<float16_t>() == 1;
+        case bfloat16:
+          return *x.data<bfloat16_t>() == 1;
+        case float32:
+          return *x.data<float>() == 1;
+        case int32:
+          return *x.data<int32_t>() == 1;
+        case uint32:
+          return *x.data<uint32_t>() == 1;
+        default:
+          return false;
+      }
+    };
+    for (int i = 0; i < 2; ++i) {
+      auto& x = a.inputs()[i];
+      auto& other = a.inputs()[1 - i];
+      if (is_one(x) && other.dtype() == a.dtype() &&
+          other.shape() == a.shape()) {
+        return other;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
 // Simplify the tape. Note, this function modifies in-place both the tape and
-// the parents map to remove orphaned arrays
+// the parents map to remove orphaned arrays.
+//
+// Arrays are visited once in topological order. Identical constants are
+// merged, primitives with no effect are replaced by their input and an array
+// whose primitive and inputs match an earlier one is merged with it. Since
+// the inputs are merged first, whole equivalent subgraphs collapse in the
+// single pass.
 void compile_simplify(
     std::vector<array>& tape,
     ParentsMap& parents_map,
     const std::vector<array>& outputs,
-    int passes) {
-  // Helpers to identify identical scalars
-  std::map<std::pair<uint64_t, Dtype::Val>, array> scalars;
-  auto is_scalar = [](const array& a) {
-    // Condition for when it's safe to read an array
-    return a.is_available() && a.ndim() == 0;
-  };
-  auto get_scalar_rep = [](const array& a) {
-    uint64_t v = 0;
-    int dtype;
-    switch (a.dtype().size) {
-      case 1:
-        v = *a.data<uint8_t>();
-        break;
-      case 2:
-        v = *a.data<uint16_t>();
-        break;
-      case 4:
-        v = *a.data<uint32_t>();
-        break;
-      case 8:
-        v = *a.data<uint64_t>();
-        break;
+    bool shapeless) {
+  std::unordered_set<uintptr_t> output_set;
+  for (auto& o : outputs) {
+    output_set.insert(o.id());
+  }
+  auto is_output = [&output_set](const array& a) {
+    if (output_set.find(a.id()) != output_set.end()) {
+      return true;
     }
-    return std::make_pair(v, a.dtype().val);
+    for (auto& s : a.siblings()) {
+      if (output_set.find(s.id()) != output_set.end()) {
+        return true;
+      }
+    }
+    return false;
   };
 
-  for (auto& a : tape) {
-    if (is_scalar(a)) {
-      scalars.insert({get_scalar_rep(a), a});
+  // Constants are compared by value when small enough and otherwise by
+  // buffer
+  constexpr size_t max_hashed_constant_bytes = 1 << 14;
+  auto is_constant = [](const array& a) {
+    return !a.has_primitive() && a.is_available();
+  };
+  auto by_value = [](const array& a) {
+    return a.flags().row_contiguous && a.data_size() == a.size() &&
+        a.nbytes() <= max_hashed_constant_bytes;
+  };
+  auto constant_key = [&by_value](const array& a) {
+    uint64_t h = static_cast<uint64_t>(a.dtype().val);
+    for (auto s : a.shape()) {
+      hash_combine(h, s);
     }
-  }
-
-  // Depth-1 array equivalence check.
-  auto array_equivalent = [](const array& a, const array& b) {
-    if (!a.has_primitive() || !b.has_primitive()) {
-      return false;
+    if (by_value(a)) {
+      auto data = static_cast<const char*>(a.data<void>());
+      hash_combine(h, std::hash<std::string_view>{}({data, a.nbytes()}));
+    } else {
+      hash_combine(h, reinterpret_cast<uintptr_t>(a.data<void>()));
+      for (auto s : a.strides()) {
+        hash_combine(h, s);
+      }
     }
-    if (a.primitive_id() == b.primitive_id()) {
+    return h;
+  };
+  auto constant_equivalent = [&by_value](const array& a, const array& b) {
+    if (a.dtype() != b.dtype() || a.shape() != b.shape()) {
       return false;
     }
-    const auto& pa = a.primitive();
-    const auto& pb = b.primitive();
-    if (typeid(pa) != typeid(pb)) {
-      return false;
+    if (by_value(a) && by_value(b)) {
+      return std::memcmp(a.data<void>(), b.data<void>(), a.nbytes()) == 0;
     }
+    return a.data<void>() == b.data<void>() && a.strides() == b.strides();
+  };
 
-    if (a.inputs().size() != b.inputs().size()) {
+  // Primitives are compared with the ids of their inputs
+  auto array_key = [](const array& a) {
+    uint64_t h = typeid(a.primitive()).hash_code();
+    for (auto& in : a.inputs()) {
+      hash_combine(h, in.id());
+    }
+    return h;
+  };
+  auto array_equivalent = [](const array& a, const array& b) {
+    const auto& pa = a.primitive();
+    const auto& pb = b.primitive();
+    if (typeid(pa) != typeid(pb) ||
+        a.inputs().size() != b.inputs().size() ||
+        a.siblings().size() != b.siblings().size()) {
       return false;
     }
-
     for (int i = 0; i < a.inputs().size(); i++) {
       if (a.inputs()[i].id() != b.inputs()[i].id()) {
         return false;
       }
     }
-
     return pa.is_equivalent(pb);
   };
 
-  // Merge scalars
+  // Point the reshape at the input of the reshape it reads
+  auto skip_reshape = [&parents_map](array& a) {
+    auto in = a.inputs()[0];
+    if (!in.has_primitive() || typeid(in.primitive()) != typeid(Reshape)) {
+      return;
+    }
+    auto& in_parents = parents_map[in.id()];
+    for (auto it = in_parents.begin(); it != in_parents.end(); ++it) {
+      if (it->first.id() == a.id()) {
+        in_parents.erase(it);
+        break;
+      }
+    }
+    a.inputs()[0] = in.inputs()[0];
+    parents_map[a.inputs()[0].id()].push_back({a, 0});
+  };
+
+  // Absorb a symmetric zero padding of the spatial axes into the padding of
+  // the convolution reading it, whose loaders already return zeros outside
+  // of the input, to save the padded copy
+  auto fold_pad = [&parents_map](array& a) {
+    auto in = a.inputs()[0];
+    if (!in.has_primitive() || typeid(in.primitive()) != typeid(Pad)) {
+      return;
+    }
+    auto [padding, strides, kernel_dilation, input_dilation, groups, flip] =
+        static_cast<const Convolution&>(a.primitive()).state();
+    for (auto d : input_dilation) {
+      if (d != 1) {
+        return;
+      }
+    }
+    auto pad_value = in.inputs()[1];
+    if (pad_value.has_primitive() &&
+        typeid(pad_value.primitive()) == typeid(AsType)) {
+      pad_value = pad_value.inputs()[0];
+    }
+    if (!pad_value.is_available() || pad_value.ndim() != 0) {
+      return;
+    }
+    switch (pad_value.dtype()) {
+      case float16:
+        if (*pad_value.data<float16_t>() != 0) {
+          return;
+        }
+        break;
+      case bfloat16:
+        if (*pad_value.data<bfloat16_t>() != 0) {
+          return;
+        }
+        break;
+      case float32:
+        if (*pad_value.data<float>() != 0) {
+          return;
+        }
+        break;
+      case int32:
+        if (*pad_value.data<int32_t>() != 0) {
+          return;
+        }
+        break;
+      default:
+        return;
+    }
+    auto [axes, low, high] = static_cast<const Pad&>(in.primitive()).state();
+    int ndim = in.ndim();
+    for (int i = 0; i < axes.size(); i++) {
+      int ax = axes[i] < 0 ? axes[i] + ndim : axes[i];
+      bool spatial = ax > 0 && ax < ndim - 1;
+      if (low[i] != high[i] || (!spatial && low[i] != 0)) {
+        return;
+      }
+      if (spatial) {
+        padding[ax - 1] += low[i];
+      }
+    }
+
+    auto& in_parents = parents_map[in.id()];
+    for (auto it = in_parents.begin(); it != in_parents.end(); ++it) {
+      if (it->first.id() == a.id()) {
+        in_parents.erase(it);
+        break;
+      }
+    }
+    a.inputs()[0] = in.inputs()[0];
+    parents_map[a.inputs()[0].id()].push_back({a, 0});
+    a.primitive_ptr() = std::make_shared<Convolution>(
+        a.primitive().stream(),
+        strides,
+        padding,
+        kernel_dilation,
+        input_dilation,
+        groups,
+        flip);
+  };
+
+  // Remove an array which is merged away or dead from the parents of its
+  // inputs
+  auto remove_parent = [&parents_map](const array& arr) {
+    for (auto& in : arr.inputs()) {
+      auto parents = parents_map.find(in.id());
+      if (parents == parents_map.end()) {
+        continue;
+      }
+      auto& ps = parents->second;
+      ps.erase(
+          std::remove_if(
+              ps.begin(),
+              ps.end(),
+              [&arr](auto& p) {
+                return p.first.primitive_id() == arr.primitive_id();
+              }),
+          ps.end());
+    }
+  };
+
+  std::unordered_map<uint64_t, std::vector<array>> seen;
   std::vector<array> new_tape;
   for (auto& arr : tape) {
-    // Check if we can merge scalars
-    if (is_scalar(arr)) {
-      auto scalar = scalars.find(get_scalar_rep(arr));
-      if (scalar->second.id() != arr.id()) {
-        merge(scalar->second, arr, parents_map);
-        // Don't keep orphaned scalars in the tape
+    if (!arr.has_primitive() && !is_constant(arr)) {
+      new_tape.push_back(std::move(arr));
+      continue;
+    }
+    bool constant = is_constant(arr);
+    if (!constant && typeid(arr.primitive()) == typeid(Convolution)) {
+      fold_pad(arr);
+    }
+    if (!constant && !is_output(arr) && arr.siblings().empty()) {
+      if (typeid(arr.primitive()) == typeid(Reshape)) {
+        skip_reshape(arr);
+      }
+      if (auto replacement = simplify_array(arr, shapeless); replacement) {
+        merge_one(*replacement, arr, parents_map);
+        remove_parent(arr);
         continue;
       }
     }
-    new_tape.push_back(std::move(arr));
-  }
-  tape = std::move(new_tape);
-
-  std::unordered_map<std::uintptr_t, uint32_t> tape_order;
-  for (uint32_t i = 0; i < tape.size(); ++i) {
-    tape_order.insert({tape[i].id(), i});
-  }
 
-  std::unordered_set<uintptr_t> output_set;
-  for (auto& o : outputs) {
-    output_set.insert(o.id());
-  }
-  // Multi-pass merge only keeping non-orphaned arrays in the tape
-  for (int pass = 0; pass < passes; ++pass) {
-    for (auto& arr : tape) {
-      // Helper to check if we can merge the parents of the
-      // given array
-      auto maybe_merge_parents = [&](auto& a) {
-        auto parents = parents_map.find(a.id());
-        if (parents != parents_map.end()) {
-          auto N = parents->second.size();
-          std::vector<bool> mask(N, false);
-          for (int i = 0; i < N; i++) {
-            if (mask[i]) {
-              continue;
-            }
-            for (int j = i + 1; j < N; j++) {
-              if (mask[j]) {
-                continue;
-              }
-              auto src_idx = j;
-              auto dst_idx = i;
-              if (tape_order[parents->second[src_idx].first.id()] <
-                  tape_order[parents->second[dst_idx].first.id()]) {
-                std::swap(src_idx, dst_idx);
-              }
-              auto& src = parents->second[src_idx].first;
-              auto& dst = parents->second[dst_idx].first;
-              if (src.id() != dst.id() && array_equivalent(src, dst) &&
-                  output_set.find(src.id()) == output_set.end()) {
-                merge(dst, src, parents_map);
-                mask[src_idx] = true;
-              }
-            }
-          }
-          // Erase orphaned parents so we don't keep fusing with them
-          for (int i = N - 1; i >= 0; --i) {
-            if (mask[i]) {
-              parents->second.erase(parents->second.begin() + i);
-            }
-          }
-          return false;
-        } else {
-          return output_set.find(a.id()) == output_set.end();
+    auto key = constant ? constant_key(arr) : array_key(arr);
+    auto& candidates = seen[key];
+    bool merged = false;
+    if (!is_output(arr)) {
+      for (auto& c : candidates) {
+        if (constant ? constant_equivalent(c, arr)
+                     : array_equivalent(c, arr)) {
+          merge(c, arr, parents_map);
+          remove_parent(arr);
+          merged = true;
+          break;
         }
-      };
-      bool discard = maybe_merge_parents(arr);
-      for (auto& s : arr.siblings()) {
-        discard &= maybe_merge_parents(s);
       }
-      // If an array and its siblings have no parents, and none of them are
-      // outputs, it is safe to remove it from the tape
-      if (!discard) {
-        new_tape.push_back(std::move(arr));
+    }
+    if (!merged) {
+      candidates.push_back(arr);
+      new_tape.push_back(std::move(arr));
+    }
+  }
+
+  // Remove the arrays which no output depends on anymore
+  std::unordered_set<uintptr_t> live = output_set;
+  tape.clear();
+  for (auto it = new_tape.rbegin(); it != new_tape.rend(); ++it) {
+    auto& arr = *it;
+    bool is_live = live.find(arr.id()) != live.end();
+    for (auto& s : arr.siblings()) {
+      is_live |= live.find(s.id()) != live.end();
+    }
+    if (is_live || !arr.has_primitive()) {
+      for (auto& in : arr.inputs()) {
+        live.insert(in.id());
       }
+      tape.push_back(std::move(arr));
+      continue;
     }
-    tape = std::move(new_tape);
+    remove_parent(arr);
   }
+  std::reverse(tape.begin(), tape.end());
 }
 
 // Extract sub-graphs of the graph that can be compiled
@@ -538,6 +884,7 @@ void compile_fuse(
         const array&, int, const Stream&, const std::vector<int>&)>
         recurse;
     std::unordered_set<uintptr_t> cache;
+    bool reduction = is_fusable_reduction(arr);
     recurse = [&](const array& a,
                   int depth,
                   const Stream& s,
@@ -551,10 +898,13 @@ void compile_fuse(
       // - Constant input
       // - Stream mismatch
       // - Non fusable primitive
-      // - Is global output but has a different shape
+      // - Custom elementwise primitive with several outputs
+      // - Is global output but has a different shape or feeds a reduction
       if (depth >= max_compile_depth || !a.has_primitive() ||
           a.primitive().stream() != s || !is_fusable(a.primitive()) ||
-          (output_map.find(a.id()) != output_map.end() && a.shape() != shape)) {
+          (is_custom_elementwise(a.primitive()) && !a.siblings().empty()) ||
+          (output_map.find(a.id()) != output_map.end() &&
+           (a.shape() != shape || reduction))) {
         return;
       }
 
@@ -585,7 +935,13 @@ void compile_fuse(
       }
     };
 
-    if (arr.has_primitive()) {
+    if (reduction) {
+      // The reduction ends the section and is fused with the elementwise
+      // graph that computes its input
+      auto& in = arr.inputs()[0];
+      cache.insert(arr.id());
+      recurse(in, 1, arr.primitive().stream(), in.shape());
+    } else if (arr.has_primitive()) {
       Stream s = arr.primitive().stream();
       recurse(arr, 0, s, arr.shape());
     }
@@ -622,6 +978,19 @@ void compile_fuse(
     };
     recurse_tape(arr);
 
+    // The fused reduction reads its inputs broadcast to the shape of the
+    // reduced array so every axis of that shape must come from an input
+    if (reduction) {
+      std::vector<int> in_shape;
+      for (auto& in : inputs) {
+        in_shape = broadcast_shapes(in_shape, in.shape());
+      }
+      if (in_shape != arr.inputs()[0].shape()) {
+        new_tape.push_back(arr);
+        continue;
+      }
+    }
+
     std::vector<array> old_outputs;
     // Add to global cache and add any global outputs to outputs
     // of new primitive
@@ -714,17 +1083,133 @@ void compile_fuse(
   }
 }
 
+// Primitives whose outputs never share the buffer of an input which is
+// still used afterwards. Views like reshapes or slices can share it, as can
+// the unary ops which are no-ops for integers.
+bool allocates_outputs(const Primitive& p) {
+  if (typeid(p) == typeid(Abs) || typeid(p) == typeid(Ceil) ||
+      typeid(p) == typeid(Floor) || typeid(p) == typeid(Round) ||
+      typeid(p) == typeid(Sign)) {
+    return false;
+  }
+  return is_unary(p) || is_binary(p) || is_ternary(p) ||
+      typeid(p) == typeid(Compiled) || is_reduction(p) ||
+      typeid(p) == typeid(Softmax) || typeid(p) == typeid(LogSumExp) ||
+      typeid(p) == typeid(Matmul) || typeid(p) == typeid(MatmulVJP) ||
+      typeid(p) == typeid(AddMM);
+}
+
+// Plans the reuse of the buffers of intermediates. With the lifetime of each
+// intermediate known from the tape, the primitive that reads it last can
+// write its output in place even when the buffer is still referenced by
+// earlier readers, which on the GPU keep it alive until their command buffer
+// completes. An intermediate is reused only if neither it nor any of its
+// readers can be a view sharing a buffer and all of them run on the same
+// stream so they are ordered.
+std::unordered_set<uintptr_t> compile_plan_donations(
+    const std::vector<array>& tape,
+    const std::vector<array>& inputs,
+    const std::vector<array>& outputs) {
+  std::unordered_set<uintptr_t> output_set;
+  for (auto& o : outputs) {
+    output_set.insert(o.id());
+  }
+
+  // Intermediates with a reader that rules out reusing them. Inputs have no
+  // stream so their readers must all share one.
+  std::unordered_set<uintptr_t> excluded;
+  std::unordered_set<uintptr_t> read;
+  std::unordered_map<uintptr_t, std::optional<Stream>> input_streams;
+  for (auto& in : inputs) {
+    input_streams.emplace(in.id(), std::nullopt);
+  }
+  for (auto& a : tape) {
+    if (!a.has_primitive()) {
+      continue;
+    }
+    bool allocates = allocates_outputs(a.primitive());
+    auto stream = a.primitive().stream();
+    for (auto& in : a.inputs()) {
+      read.insert(in.id());
+      if (auto it = input_streams.find(in.id()); it != input_streams.end()) {
+        if (!it->second) {
+          it->second = stream;
+        }
+        if (!allocates || *it->second != stream) {
+          excluded.insert(in.id());
+        }
+      } else if (
+          !allocates || !in.has_primitive() ||
+          in.primitive().stream() != stream) {
+        excluded.insert(in.id());
+      }
+    }
+  }
+
+  std::unordered_set<uintptr_t> donations;
+  for (auto& a : tape) {
+    if (a.has_primitive() && a.siblings().empty() &&
+        allocates_outputs(a.primitive()) &&
+        output_set.find(a.id()) == output_set.end() &&
+        read.find(a.id()) != read.end() &&
+        excluded.find(a.id()) == excluded.end()) {
+      donations.insert(a.id());
+    }
+  }
+  // Inputs are only reused when the caller donates them
+  for (auto& in : inputs) {
+    if (output_set.find(in.id()) == output_set.end() &&
+        read.find(in.id()) != read.end() &&
+        excluded.find(in.id()) == excluded.end()) {
+      donations.insert(in.id());
+    }
+  }
+  return donations;
+}
+
 std::vector<array> compile_replace(
     const std::vector<array>& tape,
     const std::vector<array>& trace_inputs,
     const std::vector<array>& trace_outputs,
     const std::vector<array>& inputs,
-    bool shapeless) {
+    bool shapeless,
+    const std::unordered_set<uintptr_t>& donations,
+    const std::vector<int>& donate_argnums) {
   std::unordered_map<uintptr_t, array> trace_to_real;
   for (int i = 0; i < inputs.size(); ++i) {
     trace_to_real.insert({trace_inputs[i].id(), inputs[i]});
   }
 
+  // A donated input is replaced by an array sharing its buffer that only the
+  // graph references so that its last reader can write to it. The input
+  // must be evaluated and not share its buffer with another input.
+  for (auto i : donate_argnums) {
+    if (i < 0 || i >= inputs.size()) {
+      std::ostringstream msg;
+      msg << "[compile] Cannot donate argument " << i << " of a function "
+          << "called with " << inputs.size() << " arrays.";
+      throw std::invalid_argument(msg.str());
+    }
+    auto& in = inputs[i];
+    if (donations.find(trace_inputs[i].id()) == donations.end() ||
+        !in.is_available()) {
+      continue;
+    }
+    bool aliased = false;
+    for (int j = 0; j < inputs.size() && !aliased; ++j) {
+      aliased = j != i && inputs[j].is_available() &&
+          inputs[j].buffer().ptr() == in.buffer().ptr();
+    }
+    if (aliased) {
+      continue;
+    }
+    array donated(in.shape(), in.dtype(), nullptr, {});
+    donated.copy_shared_buffer(in);
+    donated.set_status(array::Status::available);
+    donated.set_planned_donation(true);
+    trace_to_real.insert_or_assign(trace_inputs[i].id(), std::move(donated));
+  }
+
   for (auto& a : tape) {
     // Arrays in the tape without primitives are constants
     // and can be used directly
@@ -744,6 +1229,9 @@ std::vector<array> compile_replace(
             a.dtype(),
             a.primitive_ptr(),
             std::move(real_inputs));
+        if (donations.find(a.id()) != donations.end()) {
+          real_a.set_planned_donation(true);
+        }
         trace_to_real.insert({a.id(), std::move(real_a)});
       } else {
         // Ensure the order is correct for multi-output primitives
@@ -798,12 +1286,17 @@ std::function<std::vector<array>(const std::vector<array>&)> compile(
     const std::function<std::vector<array>(const std::vector<array>&)>& fun,
     std::uintptr_t fun_id,
     bool shapeless /* = false */,
-    std::vector<uint64_t> constants /* = {} */) {
+    std::vector<uint64_t> constants /* = {} */,
+    std::vector<int> donate_argnums /* = {} */) {
   if (compile_mode() == CompileMode::disabled ||
       !(compile_available_for_device(default_device()))) {
     return fun;
   }
-  return [fun, fun_id, shapeless, constants = std::move(constants)](
+  return [fun,
+          fun_id,
+          shapeless,
+          constants = std::move(constants),
+          donate_argnums = std::move(donate_argnums)](
              const std::vector<array>& inputs) {
     // If the inputs are tracers, trace the original graph
     if (std::any_of(inputs.begin(), inputs.end(), [](auto& in) {
@@ -821,6 +1314,7 @@ std::function<std::vector<array>(const std::vector<array>&)> compile(
       entry.empty = false;
       // Set the constants
       entry.constants = std::move(constants);
+      auto start = std::chrono::steady_clock::now();
       // Trace to build the graph
       std::tie(entry.inputs, entry.outputs) = compile_trace(fun, inputs);
 
@@ -833,8 +1327,7 @@ std::function<std::vector<array>(const std::vector<array>&)> compile(
 
       // Simplify the tape
       if (compile_mode() != CompileMode::no_simplify) {
-        compile_simplify(
-            entry.tape, parents_map, entry.outputs, /* passes */ 3);
+        compile_simplify(entry.tape, parents_map, entry.outputs, shapeless);
       }
 
       // Kernel fusion to generate Compiled primitives. The tape and
@@ -846,12 +1339,34 @@ std::function<std::vector<array>(const std::vector<array>&)> compile(
       if (shapeless) {
         compile_validate_shapeless(entry.tape);
       }
+
+      // Record the GPU work of the graph to replay it on later calls
+      if (compile_mode() == CompileMode::capture) {
+        for (auto& a : entry.tape) {
+          if (a.has_primitive() && a.primitive().device() == Device::gpu) {
+            metal::capture_primitive(a.primitive_ptr());
+          }
+        }
+      }
+
+      entry.donations =
+          compile_plan_donations(entry.tape, entry.inputs, entry.outputs);
+
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      compiler_cache().stats().trace_time += elapsed.count();
     }
 
     // At this point we must have a tape, now replace the placeholders
     // with real arrays that can be evaluated
     return compile_replace(
-        entry.tape, entry.inputs, entry.outputs, inputs, shapeless);
+        entry.tape,
+        entry.inputs,
+        entry.outputs,
+        inputs,
+        shapeless,
+        entry.donations,
+        donate_argnums);
   };
 }
 
@@ -859,8 +1374,35 @@ void compile_erase(std::uintptr_t fun_id) {
   detail::compiler_cache().erase(fun_id);
 }
 
+// Kernels are built on the stream threads so they are counted apart from the
+// other statistics
+std::atomic<size_t>& generated_kernels() {
+  static std::atomic<size_t> n{0};
+  return n;
+}
+
+void count_generated_kernel() {
+  generated_kernels()++;
+}
+
 } // namespace detail
 
+CompileCacheStats compile_cache_stats() {
+  auto stats = detail::compiler_cache().stats();
+  stats.entries = detail::compiler_cache().size();
+  stats.kernels = detail::generated_kernels();
+  return stats;
+}
+
+void reset_compile_cache_stats() {
+  detail::compiler_cache().stats() = CompileCacheStats{};
+  detail::generated_kernels() = 0;
+}
+
+void set_compile_cache_capacity(size_t capacity) {
+  detail::compiler_cache().set_capacity(capacity);
+}
+
 std::function<std::vector<array>(const std::vector<array>&)> compile(
     const std::function<std::vector<array>(const std::vector<array>&)>& fun,
     bool shapeless /* false */) {
@@ -871,6 +1413,18 @@ std::function<std::vector<array>(const std::vector<array>&)> compile(
   return detail::compile(fun, fun_id, shapeless);
 }
 
+std::function<std::vector<array>(const std::vector<array>&)> compile(
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    bool shapeless,
+    std::vector<int> donate_argnums) {
+  if (detail::compile_mode() == CompileMode::disabled) {
+    return fun;
+  }
+  auto fun_id = detail::get_function_address(fun);
+  return detail::compile(
+      fun, fun_id, shapeless, {}, std::move(donate_argnums));
+}
+
 void disable_compile() {
   detail::compile_mode() = CompileMode::disabled;
 }
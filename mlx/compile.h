@@ -6,13 +6,29 @@
 
 namespace mlx::core {
 
-enum class CompileMode { disabled, no_simplify, no_fuse, enabled };
+/** With ``capture`` compiled functions are compiled as with ``enabled`` and
+ * in addition the GPU work of each primitive in the compiled graph is
+ * recorded the first time it is evaluated and replayed on later calls,
+ * skipping the host side encoding. Setting the environment variable
+ * ``MLX_COMPILE_CAPTURE`` selects it by default.
+ */
+enum class CompileMode { disabled, no_simplify, no_fuse, enabled, capture };
 
 /** Compile takes a function and returns a compiled function. */
 std::function<std::vector<array>(const std::vector<array>&)> compile(
     const std::function<std::vector<array>(const std::vector<array>&)>& fun,
     bool shapeless = false);
 
+/** Compile a function whose inputs at ``donate_argnums`` are donated.
+ * The buffers of donated inputs can be reused for the outputs of the
+ * compiled graph, e.g. to update parameters in place, so the donated arrays
+ * must not be used after the call.
+ */
+std::function<std::vector<array>(const std::vector<array>&)> compile(
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    bool shapeless,
+    std::vector<int> donate_argnums);
+
 /** Globally disable compilation.
  * Setting the environment variable ``MLX_DISABLE_COMPILE`` can also
  * be used to disable compilation.
@@ -26,4 +42,42 @@ void enable_compile();
 
 /** Set the compiler mode to the given value. */
 void set_compile_mode(CompileMode mode);
+
+/** Statistics of the cache of compiled graphs. */
+struct CompileCacheStats {
+  // Calls that found a graph compiled for their inputs
+  size_t hits{0};
+  // Calls that had to trace and compile a new graph
+  size_t misses{0};
+  // Graphs dropped because their function had too many
+  size_t evictions{0};
+  // Graphs currently cached
+  size_t entries{0};
+  // Total seconds spent tracing and compiling graphs
+  double trace_time{0};
+  // Fused kernels generated and built by the backends
+  size_t kernels{0};
+};
+
+/** Get the statistics of the compile cache. */
+CompileCacheStats compile_cache_stats();
+
+/** Reset the counters of the compile cache. */
+void reset_compile_cache_stats();
+
+/** Set the number of graphs cached for each compiled function.
+ * When a function is called with more distinct input shapes, types or
+ * constants the least recently used graph is dropped. The default is 128
+ * and the environment variable ``MLX_COMPILE_CACHE_CAPACITY`` can be used to
+ * change it. A capacity of 0 keeps every graph.
+ */
+void set_compile_cache_capacity(size_t capacity);
+
+/** Load the CPU kernels cached on disk by earlier processes.
+ * Compiled CPU kernels are kept in the directory given by the environment
+ * variable ``MLX_CPU_KERNEL_CACHE`` (by default ``~/.cache/mlx/cpu_kernels``)
+ * and reused across processes. Preloading them moves the cost of opening
+ * them from the first call of each compiled function to startup.
+ */
+void preload_cpu_kernels();
 } // namespace mlx::core
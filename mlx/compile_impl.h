@@ -2,10 +2,43 @@
 
 #pragma once
 
+#include <unordered_map>
+
+#include "mlx/array.h"
 #include "mlx/device.h"
 
+namespace mlx::core {
+
+// Elementwise and broadcast primitives that compile can fuse
+bool is_fusable(const Primitive& p);
+
+} // namespace mlx::core
+
 namespace mlx::core::detail {
 
 bool compile_available_for_device(const Device& device);
 
-}
+// Called by the backends whenever they generate and build a fused kernel
+void count_generated_kernel();
+
+using ParentsMap =
+    std::unordered_map<std::uintptr_t, std::vector<std::pair<array, int>>>;
+
+// Run the function on placeholder inputs and return them with the outputs
+std::pair<std::vector<array>, std::vector<array>> compile_trace(
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    const std::vector<array>& inputs);
+
+// Traverses the graph to build a tape and a map of array ids to their parents
+std::pair<std::vector<array>, ParentsMap> compile_dfs(
+    const std::vector<array>& inputs,
+    const std::vector<array>& outputs);
+
+// Simplify the tape in place
+void compile_simplify(
+    std::vector<array>& tape,
+    ParentsMap& parents_map,
+    const std::vector<array>& outputs,
+    bool shapeless);
+
+} // namespace mlx::core::detail
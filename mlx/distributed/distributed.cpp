@@ -0,0 +1,167 @@
+// Copyright © 2024 Apple Inc.
+
+#include <sstream>
+#include <unordered_map>
+
+#include "mlx/distributed/distributed.h"
+#include "mlx/distributed/distributed_impl.h"
+#include "mlx/distributed/mpi/mpi.h"
+#include "mlx/distributed/ring/ring.h"
+#include "mlx/distributed/shm/shm.h"
+#include "mlx/scheduler.h"
+
+namespace mlx::core::distributed {
+
+namespace detail {
+
+Stream communication_stream() {
+  static Stream comm_stream = new_stream(Device::cpu);
+  return comm_stream;
+}
+
+void all_sum(Group group, const array& input, array& output) {
+  group.raw_group()->all_sum(input, output);
+}
+
+void all_gather(Group group, const array& input, array& output) {
+  group.raw_group()->all_gather(input, output);
+}
+
+void reduce_scatter(Group group, const array& input, array& output) {
+  group.raw_group()->reduce_scatter(input, output);
+}
+
+void all_to_all(
+    Group group,
+    const array& input,
+    array& output,
+    const std::vector<int>& send_sizes,
+    const std::vector<int>& recv_sizes) {
+  group.raw_group()->all_to_all(input, output, send_sizes, recv_sizes);
+}
+
+void broadcast(Group group, array& inout, int root) {
+  group.raw_group()->broadcast(inout, root);
+}
+
+void send(Group group, const array& input, int dst) {
+  group.raw_group()->send(input, dst);
+}
+
+void recv(Group group, array& out, int src) {
+  group.raw_group()->recv(out, src);
+}
+
+} // namespace detail
+
+namespace {
+
+// The group of a single process used when no backend is available. The ops
+// return early for singleton groups so it never communicates.
+class EmptyGroup : public detail::GroupImpl {
+ public:
+  int rank() override {
+    return 0;
+  }
+
+  int size() override {
+    return 1;
+  }
+
+  std::shared_ptr<GroupImpl> split(int color, int key = -1) override {
+    throw std::runtime_error("Cannot split the distributed group further");
+  }
+
+  void all_sum(const array& input, array& output) override {
+    no_communication();
+  }
+  void all_gather(const array& input, array& output) override {
+    no_communication();
+  }
+  void reduce_scatter(const array& input, array& output) override {
+    no_communication();
+  }
+  void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<int>& send_sizes,
+      const std::vector<int>& recv_sizes) override {
+    no_communication();
+  }
+  void broadcast(array& inout, int root) override {
+    no_communication();
+  }
+  void send(const array& input, int dst) override {
+    no_communication();
+  }
+  void recv(array& out, int src) override {
+    no_communication();
+  }
+
+ private:
+  void no_communication() {
+    throw std::runtime_error(
+        "Communication not implemented in an empty distributed group.");
+  }
+};
+
+} // namespace
+
+int Group::rank() {
+  return group_->rank();
+}
+
+int Group::size() {
+  return group_->size();
+}
+
+Group Group::split(int color, int key /* = -1 */) {
+  return Group(group_->split(color, key));
+}
+
+bool is_available() {
+  return mpi::is_available() || ring::is_available() || shm::is_available();
+}
+
+Group init(bool strict /* = false */, const std::string& bk /* = "any" */) {
+  static std::unordered_map<std::string, std::shared_ptr<detail::GroupImpl>>
+      backends;
+
+  if (auto it = backends.find(bk); it != backends.end()) {
+    return Group(it->second);
+  }
+
+  std::shared_ptr<detail::GroupImpl> group;
+  if (bk == "mpi") {
+    group = mpi::init(strict);
+  } else if (bk == "ring") {
+    group = ring::init(strict);
+  } else if (bk == "shm") {
+    group = shm::init(strict);
+  } else if (bk == "any") {
+    // The ring and shm backends are only picked when they are configured
+    group = ring::init(false);
+    if (group == nullptr) {
+      group = shm::init(false);
+    }
+    if (group == nullptr) {
+      group = mpi::init(false);
+    }
+    if (group == nullptr && strict) {
+      throw std::runtime_error("[distributed] Couldn't initialize any backend");
+    }
+  } else {
+    std::ostringstream msg;
+    msg << "[distributed] The backend must be one of any, mpi, ring or shm "
+        << "but got " << bk << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  if (group == nullptr) {
+    group = std::make_shared<EmptyGroup>();
+  }
+  backends[bk] = group;
+  return Group(group);
+}
+
+} // namespace mlx::core::distributed
@@ -3,11 +3,16 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include "mlx/array.h"
 
 namespace mlx::core::distributed {
 
+namespace detail {
+class GroupImpl;
+} // namespace detail
+
 /* Check if a communication backend is available */
 bool is_available();
 
@@ -17,7 +22,7 @@ bool is_available();
  * order to define more granular communication.
  */
 struct Group {
-  Group(std::shared_ptr<void> group) : group_(group) {}
+  Group(std::shared_ptr<detail::GroupImpl> group) : group_(std::move(group)) {}
 
   int rank();
   int size();
@@ -32,23 +37,30 @@ struct Group {
    */
   Group split(int color, int key = -1);
 
-  const std::shared_ptr<void>& raw_group() {
+  const std::shared_ptr<detail::GroupImpl>& raw_group() {
     return group_;
   }
 
  private:
-  std::shared_ptr<void> group_{nullptr};
+  std::shared_ptr<detail::GroupImpl> group_{nullptr};
 };
 
 /**
  * Initialize the distributed backend and return the group containing all
  * discoverable processes.
  *
+ * The backend is one of "mpi", "ring", "shm" or "any". The ring backend
+ * connects the processes with TCP sockets, it is configured with the
+ * MLX_HOSTFILE and MLX_RANK environment variables. The shm backend connects
+ * the processes of one machine through shared memory, it is configured with
+ * MLX_RANK and MLX_WORLD_SIZE and optionally MLX_SHM_NAME. With "any" the
+ * first configured backend out of ring, shm and MPI is used.
+ *
  * If strict is true then throw an error if we couldn't initialize the
  * distributed subsystem. Otherwise simply return a singleton group which will
  * render communication operations as no-op.
  */
-Group init(bool strict = false);
+Group init(bool strict = false, const std::string& bk = "any");
 
 namespace detail {
 
@@ -61,6 +73,29 @@ void all_sum(Group group, const array& input, array& output);
 /* Perform an all reduce sum operation */
 void all_gather(Group group, const array& input, array& output);
 
+/* Sum the inputs and scatter equal blocks of the first axis to the ranks */
+void reduce_scatter(Group group, const array& input, array& output);
+
+/**
+ * Send send_sizes[i] rows of the input to rank i and receive recv_sizes[i]
+ * rows of the output from rank i.
+ */
+void all_to_all(
+    Group group,
+    const array& input,
+    array& output,
+    const std::vector<int>& send_sizes,
+    const std::vector<int>& recv_sizes);
+
+/* Broadcast the array of the root process in place */
+void broadcast(Group group, array& inout, int root);
+
+/* Send an array to the process with rank dst */
+void send(Group group, const array& input, int dst);
+
+/* Receive an array from the process with rank src */
+void recv(Group group, array& out, int src);
+
 } // namespace detail
 
 } // namespace mlx::core::distributed
@@ -0,0 +1,35 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/distributed/distributed.h"
+
+namespace mlx::core::distributed::detail {
+
+/**
+ * Abstract base class of the groups of a communication backend. The
+ * communication is performed synchronously by the primitives on the
+ * communication stream.
+ */
+class GroupImpl {
+ public:
+  virtual ~GroupImpl() {}
+
+  virtual int rank() = 0;
+  virtual int size() = 0;
+  virtual std::shared_ptr<GroupImpl> split(int color, int key = -1) = 0;
+
+  virtual void all_sum(const array& input, array& output) = 0;
+  virtual void all_gather(const array& input, array& output) = 0;
+  virtual void reduce_scatter(const array& input, array& output) = 0;
+  virtual void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<int>& send_sizes,
+      const std::vector<int>& recv_sizes) = 0;
+  virtual void broadcast(array& inout, int root) = 0;
+  virtual void send(const array& input, int dst) = 0;
+  virtual void recv(array& out, int src) = 0;
+};
+
+} // namespace mlx::core::distributed::detail
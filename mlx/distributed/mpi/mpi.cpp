@@ -3,9 +3,9 @@
 #include <dlfcn.h>
 #include <mpi.h>
 
-#include "mlx/backend/common/copy.h"
-#include "mlx/distributed/distributed.h"
-#include "mlx/scheduler.h"
+#include "mlx/distributed/distributed_impl.h"
+#include "mlx/distributed/mpi/mpi.h"
+#include "mlx/distributed/utils.h"
 
 #define LOAD_SYMBOL(symbol, variable)                              \
   {                                                                \
@@ -17,19 +17,11 @@
     }                                                              \
   }
 
-namespace mlx::core::distributed {
+namespace mlx::core::distributed::mpi {
 
-namespace {
+using detail::ensure_row_contiguous;
 
-array ensure_row_contiguous(const array& arr) {
-  if (arr.flags().row_contiguous) {
-    return arr;
-  } else {
-    array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
-    copy(arr, arr_copy, CopyType::General);
-    return arr_copy;
-  }
-}
+namespace {
 
 struct MPIWrapper {
   MPIWrapper() {
@@ -47,6 +39,11 @@ struct MPIWrapper {
     LOAD_SYMBOL(MPI_Comm_free, comm_free);
     LOAD_SYMBOL(MPI_Allreduce, all_reduce);
     LOAD_SYMBOL(MPI_Allgather, all_gather);
+    LOAD_SYMBOL(MPI_Reduce_scatter_block, reduce_scatter);
+    LOAD_SYMBOL(MPI_Alltoallv, all_to_all);
+    LOAD_SYMBOL(MPI_Bcast, broadcast);
+    LOAD_SYMBOL(MPI_Send, send);
+    LOAD_SYMBOL(MPI_Recv, recv);
 
     // Objects
     LOAD_SYMBOL(ompi_mpi_comm_world, comm_world_);
@@ -115,7 +112,8 @@ struct MPIWrapper {
         return mpi_complex_;
       case float16:
       case bfloat16:
-        throw std::runtime_error("MPI doesn't support 16-bit floats");
+        // Moving the data is fine, the reductions check for them
+        return mpi_uint16_;
     }
   }
 
@@ -139,6 +137,26 @@ struct MPIWrapper {
       int,
       MPI_Datatype,
       MPI_Comm);
+  int (*reduce_scatter)(
+      const void*,
+      void*,
+      int,
+      MPI_Datatype,
+      MPI_Op,
+      MPI_Comm);
+  int (*all_to_all)(
+      const void*,
+      const int*,
+      const int*,
+      MPI_Datatype,
+      void*,
+      const int*,
+      const int*,
+      MPI_Datatype,
+      MPI_Comm);
+  int (*broadcast)(void*, int, MPI_Datatype, int, MPI_Comm);
+  int (*send)(const void*, int, MPI_Datatype, int, int, MPI_Comm);
+  int (*recv)(void*, int, MPI_Datatype, int, int, MPI_Comm, MPI_Status*);
   int (*comm_split)(MPI_Comm, int, int, MPI_Comm*);
   int (*comm_free)(MPI_Comm*);
 
@@ -167,11 +185,12 @@ MPIWrapper& mpi() {
   return wrapper;
 }
 
-struct MPIGroupImpl {
-  MPIGroupImpl() : comm_(nullptr), global_(true), rank_(0), size_(1) {}
-  MPIGroupImpl(MPI_Comm comm, bool global)
+class MPIGroup : public GroupImpl {
+ public:
+  MPIGroup(MPI_Comm comm, bool global)
       : comm_(comm), global_(global), rank_(-1), size_(-1) {}
-  ~MPIGroupImpl() {
+
+  ~MPIGroup() {
     if (global_) {
       mpi().finalize_safe();
     } else {
@@ -179,111 +198,167 @@ struct MPIGroupImpl {
     }
   }
 
-  MPI_Comm comm() {
-    return comm_;
-  }
-
-  int rank() {
+  int rank() override {
     if (rank_ < 0) {
       mpi().rank(comm_, &rank_);
     }
     return rank_;
   }
 
-  int size() {
+  int size() override {
     if (size_ < 0) {
       mpi().size(comm_, &size_);
     }
     return size_;
   }
 
- private:
-  MPI_Comm comm_;
-  bool global_;
-  int rank_;
-  int size_;
-};
+  std::shared_ptr<GroupImpl> split(int color, int key = -1) override {
+    key = (key < 0) ? rank() : key;
 
-MPI_Comm to_comm(Group& group) {
-  return std::static_pointer_cast<MPIGroupImpl>(group.raw_group())->comm();
-}
+    MPI_Comm new_comm;
+    int result = mpi().comm_split(comm_, color, key, &new_comm);
+    if (result != MPI_SUCCESS) {
+      throw std::runtime_error("MPI could not split this group");
+    }
 
-} // namespace
+    return std::make_shared<MPIGroup>(new_comm, false);
+  }
 
-int Group::rank() {
-  return std::static_pointer_cast<MPIGroupImpl>(group_)->rank();
-}
+  void all_sum(const array& input_, array& output) override {
+    check_reduction_type(input_);
+    array input = ensure_row_contiguous(input_);
+    mpi().all_reduce(
+        (input.data<void>() == output.data<void>()) ? MPI_IN_PLACE
+                                                    : input.data<void>(),
+        output.data<void>(),
+        input.size(),
+        mpi().datatype(input),
+        mpi().op_sum(),
+        comm_);
+  }
 
-int Group::size() {
-  return std::static_pointer_cast<MPIGroupImpl>(group_)->size();
-}
+  void all_gather(const array& input_, array& output) override {
+    array input = ensure_row_contiguous(input_);
+    mpi().all_gather(
+        input.data<void>(),
+        input.size(),
+        mpi().datatype(input),
+        output.data<void>(),
+        input.size(),
+        mpi().datatype(output),
+        comm_);
+  }
+
+  void reduce_scatter(const array& input_, array& output) override {
+    check_reduction_type(input_);
+    array input = ensure_row_contiguous(input_);
+    mpi().reduce_scatter(
+        input.data<void>(),
+        output.data<void>(),
+        output.size(),
+        mpi().datatype(input),
+        mpi().op_sum(),
+        comm_);
+  }
 
-Group Group::split(int color, int key) {
-  auto mpi_group = std::static_pointer_cast<MPIGroupImpl>(group_);
+  void all_to_all(
+      const array& input_,
+      array& output,
+      const std::vector<int>& send_sizes,
+      const std::vector<int>& recv_sizes) override {
+    array input = ensure_row_contiguous(input_);
+
+    // Convert the rows to element counts and displacements
+    int row_size = 1;
+    for (int i = 1; i < input.ndim(); ++i) {
+      row_size *= input.shape(i);
+    }
+    auto counts_and_displs = [row_size](const std::vector<int>& sizes) {
+      std::vector<int> counts(sizes.size());
+      std::vector<int> displs(sizes.size());
+      int offset = 0;
+      for (int i = 0; i < sizes.size(); ++i) {
+        counts[i] = sizes[i] * row_size;
+        displs[i] = offset;
+        offset += counts[i];
+      }
+      return std::make_pair(counts, displs);
+    };
+    auto [send_counts, send_displs] = counts_and_displs(send_sizes);
+    auto [recv_counts, recv_displs] = counts_and_displs(recv_sizes);
+
+    mpi().all_to_all(
+        input.data<void>(),
+        send_counts.data(),
+        send_displs.data(),
+        mpi().datatype(input),
+        output.data<void>(),
+        recv_counts.data(),
+        recv_displs.data(),
+        mpi().datatype(output),
+        comm_);
+  }
 
-  key = (key < 0) ? rank() : key;
+  void broadcast(array& inout, int root) override {
+    mpi().broadcast(
+        inout.data<void>(), inout.size(), mpi().datatype(inout), root, comm_);
+  }
 
-  MPI_Comm new_comm;
-  int result = mpi().comm_split(mpi_group->comm(), color, key, &new_comm);
-  if (result != MPI_SUCCESS) {
-    throw std::runtime_error("MPI could not split this group");
+  void send(const array& input_, int dst) override {
+    array input = ensure_row_contiguous(input_);
+    mpi().send(
+        input.data<void>(),
+        input.size(),
+        mpi().datatype(input),
+        dst,
+        0,
+        comm_);
   }
 
-  return Group(std::make_shared<MPIGroupImpl>(new_comm, false));
-}
+  void recv(array& out, int src) override {
+    mpi().recv(
+        out.data<void>(),
+        out.size(),
+        mpi().datatype(out),
+        src,
+        0,
+        comm_,
+        MPI_STATUS_IGNORE);
+  }
+
+ private:
+  void check_reduction_type(const array& arr) {
+    if (arr.dtype() == float16 || arr.dtype() == bfloat16) {
+      throw std::runtime_error("MPI doesn't support 16-bit floats");
+    }
+  }
+
+  MPI_Comm comm_;
+  bool global_;
+  int rank_;
+  int size_;
+};
+
+} // namespace
 
 bool is_available() {
   return mpi().is_available();
 }
 
-Group init(bool strict /* = false */) {
-  static std::shared_ptr<MPIGroupImpl> global_group = nullptr;
+std::shared_ptr<GroupImpl> init(bool strict /* = false */) {
+  static std::shared_ptr<GroupImpl> global_group = nullptr;
 
   if (global_group == nullptr) {
     if (!mpi().init_safe()) {
       if (strict) {
         throw std::runtime_error("Cannot initialize MPI");
       }
-      global_group = std::make_shared<MPIGroupImpl>();
-    } else {
-      global_group = std::make_shared<MPIGroupImpl>(mpi().world(), true);
+      return nullptr;
     }
+    global_group = std::make_shared<MPIGroup>(mpi().world(), true);
   }
 
-  return Group(global_group);
+  return global_group;
 }
 
-namespace detail {
-
-Stream communication_stream() {
-  static Stream comm_stream = new_stream(Device::cpu);
-  return comm_stream;
-}
-
-void all_sum(Group group, const array& input_, array& output) {
-  array input = ensure_row_contiguous(input_);
-  mpi().all_reduce(
-      (input.data<void>() == output.data<void>()) ? MPI_IN_PLACE
-                                                  : input.data<void>(),
-      output.data<void>(),
-      input.size(),
-      mpi().datatype(input),
-      mpi().op_sum(),
-      to_comm(group));
-}
-
-void all_gather(Group group, const array& input_, array& output) {
-  array input = ensure_row_contiguous(input_);
-  mpi().all_gather(
-      input.data<void>(),
-      input.size(),
-      mpi().datatype(input),
-      output.data<void>(),
-      input.size(),
-      mpi().datatype(output),
-      to_comm(group));
-}
-
-} // namespace detail
-
-} // namespace mlx::core::distributed
+} // namespace mlx::core::distributed::mpi
@@ -1,7 +1,15 @@
 // Copyright © 2024 Apple Inc.
 
+#include <unistd.h>
+
+#include <functional>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
 #include "mlx/distributed/ops.h"
 #include "mlx/distributed/primitives.h"
+#include "mlx/ops.h"
 
 namespace mlx::core::distributed {
 
@@ -15,9 +23,112 @@ Group to_group(std::optional<Group> group) {
   }
 }
 
+Stream to_comm_stream(StreamOrDevice s) {
+  if (std::holds_alternative<std::monostate>(s)) {
+    return detail::communication_stream();
+  }
+  return to_stream(s);
+}
+
+// Compute the output features of a linear layer in chunks and apply the
+// collective to each chunk so that it starts while the next ones are
+// computed. compute(start, stop) returns the features [start, stop).
+array chunked_collective(
+    int out_features,
+    int n_chunks,
+    const std::function<array(int, int)>& compute,
+    const std::function<array(const array&)>& collective,
+    int axis) {
+  if (n_chunks <= 0) {
+    std::ostringstream msg;
+    msg << "[distributed] The number of chunks must be positive but got "
+        << n_chunks << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  n_chunks = std::min(n_chunks, out_features);
+  int chunk_size = (out_features + n_chunks - 1) / n_chunks;
+  std::vector<array> chunks;
+  for (int start = 0; start < out_features; start += chunk_size) {
+    int stop = std::min(start + chunk_size, out_features);
+    chunks.push_back(collective(compute(start, stop)));
+  }
+  return concatenate(chunks, axis);
+}
+
+// The gathered chunks are (group size, chunk features, ...) so that the
+// features of every rank end up contiguous once they are concatenated.
+array gather_features(const array& y, Group group, StreamOrDevice s) {
+  auto y_t = moveaxis(y, -1, 0, s);
+  auto shape = y_t.shape();
+  shape.insert(shape.begin(), group.size());
+  return reshape(all_gather(y_t, group), shape, s);
+}
+
+array ungather_features(const array& y, StreamOrDevice s) {
+  auto shape = y.shape();
+  shape[1] *= shape[0];
+  shape.erase(shape.begin());
+  return moveaxis(reshape(y, shape, s), 0, -1, s);
+}
+
+void check_linear(const char* tag, const array& x, const array& w) {
+  if (w.ndim() != 2 || x.ndim() == 0) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The weight must be a matrix and the input at "
+        << "least 1D but got shapes " << w.shape() << " and " << x.shape()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+struct Hierarchy {
+  Group local;
+  Group cross;
+};
+
+// Split the group into the processes of each node and the processes with
+// the same local rank across the nodes. Empty if that doesn't help.
+std::optional<Hierarchy> detect_hierarchy(Group group) {
+  char hostname[256] = {0};
+  gethostname(hostname, sizeof(hostname) - 1);
+
+  // FNV-1a so that every process computes the same color for a host
+  uint32_t color = 2166136261u;
+  for (char* c = hostname; *c; c++) {
+    color = (color ^ static_cast<uint8_t>(*c)) * 16777619u;
+  }
+  auto local = group.split(color & 0x7fffffff, group.rank());
+
+  auto sizes = all_gather(array(local.size()), group);
+  int n_local = local.size();
+  if (n_local == 1 || n_local == group.size() ||
+      !all(equal(sizes, array(n_local))).item<bool>()) {
+    return std::nullopt;
+  }
+  return Hierarchy{local, group.split(local.rank(), group.rank())};
+}
+
+std::optional<Hierarchy> hierarchy(Group group) {
+  // Keep the groups alive so that their addresses are not reused
+  static std::unordered_map<
+      detail::GroupImpl*,
+      std::pair<Group, std::optional<Hierarchy>>>
+      cache;
+  auto key = group.raw_group().get();
+  if (auto it = cache.find(key); it != cache.end()) {
+    return it->second.second;
+  }
+  auto h = detect_hierarchy(group);
+  cache.emplace(key, std::make_pair(group, h));
+  return h;
+}
+
 } // namespace
 
-array all_sum(const array& x, std::optional<Group> group_) {
+array all_sum(
+    const array& x,
+    std::optional<Group> group_,
+    StreamOrDevice s /* = {} */) {
   auto group = to_group(group_);
 
   if (group.size() == 1) {
@@ -27,11 +138,14 @@ array all_sum(const array& x, std::optional<Group> group_) {
   return array(
       x.shape(),
       x.dtype(),
-      std::make_shared<AllReduce>(group, AllReduce::Sum),
+      std::make_shared<AllReduce>(to_comm_stream(s), group, AllReduce::Sum),
       {x});
 }
 
-array all_gather(const array& x, std::optional<Group> group_) {
+array all_gather(
+    const array& x,
+    std::optional<Group> group_,
+    StreamOrDevice s /* = {} */) {
   auto group = to_group(group_);
 
   if (group.size() == 1) {
@@ -47,8 +161,421 @@ array all_gather(const array& x, std::optional<Group> group_) {
   return array(
       std::move(result_shape),
       x.dtype(),
-      std::make_shared<AllGather>(group),
+      std::make_shared<AllGather>(to_comm_stream(s), group),
+      {x});
+}
+
+array reduce_scatter(
+    const array& x,
+    std::optional<Group> group_,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    return x;
+  }
+  if (x.ndim() == 0 || x.shape(0) % group.size() != 0) {
+    std::ostringstream msg;
+    msg << "[reduce_scatter] The first axis of the input with shape "
+        << x.shape() << " must be divisible by the group size "
+        << group.size() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto result_shape = x.shape();
+  result_shape[0] /= group.size();
+  return array(
+      std::move(result_shape),
+      x.dtype(),
+      std::make_shared<ReduceScatter>(to_comm_stream(s), group),
       {x});
 }
 
+array all_to_all(
+    const array& x,
+    std::optional<std::vector<int>> send_sizes,
+    std::optional<std::vector<int>> recv_sizes,
+    std::optional<Group> group_) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    return x;
+  }
+  if (x.ndim() == 0) {
+    throw std::invalid_argument(
+        "[all_to_all] The input must have at least 1 dimension.");
+  }
+  if (send_sizes.has_value() != recv_sizes.has_value()) {
+    throw std::invalid_argument(
+        "[all_to_all] Either both or none of the send and receive sizes "
+        "must be given.");
+  }
+  if (!send_sizes) {
+    if (x.shape(0) % group.size() != 0) {
+      std::ostringstream msg;
+      msg << "[all_to_all] The first axis of the input with shape "
+          << x.shape() << " must be divisible by the group size "
+          << group.size() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    send_sizes = std::vector<int>(group.size(), x.shape(0) / group.size());
+    recv_sizes = send_sizes;
+  }
+  if (send_sizes->size() != group.size() ||
+      recv_sizes->size() != group.size()) {
+    std::ostringstream msg;
+    msg << "[all_to_all] Expected one send and receive size per rank for a "
+        << "group of size " << group.size() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int n_send = 0;
+  int n_recv = 0;
+  for (int i = 0; i < group.size(); ++i) {
+    n_send += (*send_sizes)[i];
+    n_recv += (*recv_sizes)[i];
+  }
+  if (n_send != x.shape(0)) {
+    std::ostringstream msg;
+    msg << "[all_to_all] The send sizes add up to " << n_send
+        << " but the first axis of the input has size " << x.shape(0) << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto result_shape = x.shape();
+  result_shape[0] = n_recv;
+  return array(
+      std::move(result_shape),
+      x.dtype(),
+      std::make_shared<AllToAll>(
+          group, std::move(*send_sizes), std::move(*recv_sizes)),
+      {x});
+}
+
+array broadcast(
+    const array& x,
+    int root,
+    std::optional<Group> group_,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+
+  if (root < 0 || root >= group.size()) {
+    std::ostringstream msg;
+    msg << "[broadcast] Invalid root rank " << root << " for a group of "
+        << "size " << group.size() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (group.size() == 1) {
+    return x;
+  }
+
+  return array(
+      x.shape(),
+      x.dtype(),
+      std::make_shared<BroadcastRoot>(to_comm_stream(s), group, root),
+      {x});
+}
+
+array send(const array& x, int dst, std::optional<Group> group_) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    throw std::invalid_argument("[send] Cannot send in a singleton group.");
+  }
+  if (dst < 0 || dst >= group.size() || dst == group.rank()) {
+    std::ostringstream msg;
+    msg << "[send] Invalid destination rank " << dst << " for a group of "
+        << "size " << group.size() << " from rank " << group.rank() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  return array(x.shape(), x.dtype(), std::make_shared<Send>(group, dst), {x});
+}
+
+array recv(
+    std::vector<int> shape,
+    Dtype dtype,
+    int src,
+    std::optional<Group> group_) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    throw std::invalid_argument("[recv] Cannot receive in a singleton group.");
+  }
+  if (src < 0 || src >= group.size() || src == group.rank()) {
+    std::ostringstream msg;
+    msg << "[recv] Invalid source rank " << src << " for a group of size "
+        << group.size() << " from rank " << group.rank() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  return array(
+      std::move(shape),
+      dtype,
+      std::make_shared<Recv>(group, src),
+      std::vector<array>{});
+}
+
+array recv_like(const array& x, int src, std::optional<Group> group) {
+  return recv(x.shape(), x.dtype(), src, group);
+}
+
+std::vector<array> all_sum_bucketed(
+    const std::vector<array>& xs,
+    size_t bucket_size,
+    std::optional<Group> group_,
+    std::optional<Dtype> comm_type /* = std::nullopt */) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    return xs;
+  }
+
+  // Only the floating point buckets are compressed
+  auto reduce = [&](const array& x) {
+    if (comm_type && issubdtype(x.dtype(), floating)) {
+      return all_sum_cast(x, *comm_type, group);
+    }
+    return all_sum(x, group);
+  };
+
+  std::vector<array> outputs = xs;
+  auto reduce_bucket = [&](const std::vector<int>& bucket) {
+    if (bucket.size() == 1) {
+      outputs[bucket[0]] = reduce(xs[bucket[0]]);
+      return;
+    }
+    std::vector<array> flat;
+    std::vector<int> indices;
+    int offset = 0;
+    for (auto i : bucket) {
+      flat.push_back(flatten(xs[i]));
+      offset += xs[i].size();
+      indices.push_back(offset);
+    }
+    indices.pop_back();
+    auto parts = split(reduce(concatenate(flat, 0)), indices, 0);
+    for (int j = 0; j < bucket.size(); ++j) {
+      outputs[bucket[j]] = reshape(parts[j], xs[bucket[j]].shape());
+    }
+  };
+
+  // A bucket only depends on its own arrays so it is reduced while the
+  // arrays of the following buckets are still being computed
+  std::map<Dtype::Val, std::pair<std::vector<int>, size_t>> open;
+  for (int i = 0; i < xs.size(); ++i) {
+    auto& x = xs[i];
+    if (x.nbytes() >= bucket_size) {
+      reduce_bucket({i});
+      continue;
+    }
+    auto& [bucket, nbytes] = open[x.dtype().val];
+    if (nbytes + x.nbytes() > bucket_size) {
+      reduce_bucket(bucket);
+      bucket.clear();
+      nbytes = 0;
+    }
+    bucket.push_back(i);
+    nbytes += x.nbytes();
+  }
+  for (auto& [_, bucket] : open) {
+    if (!bucket.first.empty()) {
+      reduce_bucket(bucket.first);
+    }
+  }
+
+  return outputs;
+}
+
+array all_sum_hierarchical(const array& x, std::optional<Group> group_) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    return x;
+  }
+  auto h = hierarchy(group);
+  if (!h) {
+    return all_sum(x, group);
+  }
+
+  int n_local = h->local.size();
+  int part = (x.size() + n_local - 1) / n_local;
+  auto flat = flatten(x);
+  if (part * n_local != x.size()) {
+    flat = pad(flat, {0}, {0}, {part * n_local - static_cast<int>(x.size())});
+  }
+  auto y = reduce_scatter(reshape(flat, {n_local, part}), h->local);
+  y = all_sum(y, h->cross);
+  y = all_gather(y, h->local);
+  y = slice(flatten(y), {0}, {static_cast<int>(x.size())});
+  return reshape(y, x.shape());
+}
+
+array matmul_all_sum(
+    const array& x,
+    const array& w,
+    int n_chunks /* = 4 */,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+  check_linear("matmul_all_sum", x, w);
+  return chunked_collective(
+      w.shape(0),
+      n_chunks,
+      [&](int start, int stop) {
+        auto w_chunk = slice(w, {start, 0}, {stop, w.shape(1)}, s);
+        return matmul(x, transpose(w_chunk, s), s);
+      },
+      [&](const array& y) { return all_sum(y, group); },
+      -1);
+}
+
+array matmul_all_gather(
+    const array& x,
+    const array& w,
+    int n_chunks /* = 4 */,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+  check_linear("matmul_all_gather", x, w);
+  auto y = chunked_collective(
+      w.shape(0),
+      n_chunks,
+      [&](int start, int stop) {
+        auto w_chunk = slice(w, {start, 0}, {stop, w.shape(1)}, s);
+        return matmul(x, transpose(w_chunk, s), s);
+      },
+      [&](const array& y) { return gather_features(y, group, s); },
+      1);
+  return ungather_features(y, s);
+}
+
+array quantized_matmul_all_sum(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size /* = 64 */,
+    int bits /* = 4 */,
+    int n_chunks /* = 4 */,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+  check_linear("quantized_matmul_all_sum", x, w);
+  return chunked_collective(
+      w.shape(0),
+      n_chunks,
+      [&](int start, int stop) {
+        auto rows = [&](const array& a) {
+          return slice(a, {start, 0}, {stop, a.shape(1)}, s);
+        };
+        return quantized_matmul(
+            x, rows(w), rows(scales), rows(biases), true, group_size, bits, s);
+      },
+      [&](const array& y) { return all_sum(y, group); },
+      -1);
+}
+
+array quantized_matmul_all_gather(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size /* = 64 */,
+    int bits /* = 4 */,
+    int n_chunks /* = 4 */,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+  check_linear("quantized_matmul_all_gather", x, w);
+  auto y = chunked_collective(
+      w.shape(0),
+      n_chunks,
+      [&](int start, int stop) {
+        auto rows = [&](const array& a) {
+          return slice(a, {start, 0}, {stop, a.shape(1)}, s);
+        };
+        return quantized_matmul(
+            x, rows(w), rows(scales), rows(biases), true, group_size, bits, s);
+      },
+      [&](const array& y) { return gather_features(y, group, s); },
+      1);
+  return ungather_features(y, s);
+}
+
+array all_sum_cast(
+    const array& x,
+    Dtype comm_type,
+    std::optional<Group> group_) {
+  auto group = to_group(group_);
+
+  if (comm_type != float16 && comm_type != bfloat16) {
+    std::ostringstream msg;
+    msg << "[all_sum_cast] The communication type must be float16 or "
+        << "bfloat16 but got " << comm_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(x.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[all_sum_cast] Only floating point arrays can be sent as "
+        << comm_type << " but got " << x.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (group.size() == 1) {
+    return x;
+  }
+
+  // Every rank receives one block of all the arrays, sums it in float32 and
+  // sends the sum back. This is a reduce scatter followed by an all gather
+  // that communicates the same amount of data as a ring all reduce.
+  int n = group.size();
+  int block = (x.size() + n - 1) / n;
+  auto flat = astype(flatten(x), comm_type);
+  if (block * n != x.size()) {
+    flat = pad(flat, {0}, {0}, {block * n - static_cast<int>(x.size())});
+  }
+  auto blocks = all_to_all(
+      reshape(flat, {n, block}), std::nullopt, std::nullopt, group);
+  auto block_sum = astype(sum(astype(blocks, float32), 0), comm_type);
+  auto result = slice(
+      all_gather(block_sum, group), {0}, {static_cast<int>(x.size())});
+  return astype(reshape(result, x.shape()), x.dtype());
+}
+
+std::pair<array, array> all_sum_topk(
+    const array& x,
+    const array& error,
+    int k,
+    std::optional<Group> group_) {
+  auto group = to_group(group_);
+
+  if (error.shape() != x.shape()) {
+    std::ostringstream msg;
+    msg << "[all_sum_topk] The error with shape " << error.shape()
+        << " must have the shape of the input " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (k <= 0 || k > x.size()) {
+    std::ostringstream msg;
+    msg << "[all_sum_topk] Invalid k " << k << " for an input with "
+        << x.size() << " elements.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto flat = flatten(add(x, error));
+  if (group.size() == 1) {
+    return {reshape(flat, x.shape()), zeros_like(x)};
+  }
+
+  // Send the k largest entries and keep the rest as the error
+  auto idx = slice(argpartition(negative(abs(flat)), k - 1), {0}, {k});
+  auto vals = take(flat, idx);
+  auto new_error = scatter(flat, idx, zeros({k, 1}, flat.dtype()), 0);
+
+  auto all_idx = all_gather(idx, group);
+  auto all_vals = all_gather(vals, group);
+  auto total = scatter_add(
+      zeros_like(flat), all_idx, expand_dims(all_vals, 1), 0);
+  return {reshape(total, x.shape()), reshape(new_error, x.shape())};
+}
+
 } // namespace mlx::core::distributed
@@ -5,10 +5,164 @@
 #include <optional>
 
 #include "mlx/distributed/distributed.h"
+#include "mlx/utils.h"
 
 namespace mlx::core::distributed {
 
-array all_sum(const array& x, std::optional<Group> group = std::nullopt);
-array all_gather(const array& x, std::optional<Group> group = std::nullopt);
+/**
+ * The collectives below run on the communication stream unless a stream is
+ * given. On a GPU stream they wait for the GPU work that produces x without
+ * blocking the stream so communication overlaps the GPU work in flight.
+ */
+array all_sum(
+    const array& x,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+array all_gather(
+    const array& x,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Sum x across the group and return the block of the first axis that belongs
+ * to this rank. The first axis must be divisible by the group size.
+ */
+array reduce_scatter(
+    const array& x,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Send send_sizes[i] rows of x to rank i and concatenate the recv_sizes[i]
+ * rows received from every rank i. Without sizes the first axis is split
+ * evenly.
+ */
+array all_to_all(
+    const array& x,
+    std::optional<std::vector<int>> send_sizes = std::nullopt,
+    std::optional<std::vector<int>> recv_sizes = std::nullopt,
+    std::optional<Group> group = std::nullopt);
+
+/** Return the x of the process with rank root on every process. */
+array broadcast(
+    const array& x,
+    int root,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Send x to the process with rank dst in the group. The send happens when the
+ * returned array, which holds the same data as x, is evaluated.
+ */
+array send(const array& x, int dst, std::optional<Group> group = std::nullopt);
+
+/** Receive an array with the given shape and dtype from rank src. */
+array recv(
+    std::vector<int> shape,
+    Dtype dtype,
+    int src,
+    std::optional<Group> group = std::nullopt);
+
+/** Receive an array with the shape and dtype of x from rank src. */
+array recv_like(
+    const array& x,
+    int src,
+    std::optional<Group> group = std::nullopt);
+
+/**
+ * Sum each of the arrays across the group with one collective per bucket
+ * instead of one per array. The arrays are packed in order into buckets of a
+ * single dtype holding at most bucket_size bytes. Arrays larger than a bucket
+ * are reduced on their own.
+ */
+std::vector<array> all_sum_bucketed(
+    const std::vector<array>& xs,
+    size_t bucket_size,
+    std::optional<Group> group = std::nullopt,
+    std::optional<Dtype> comm_type = std::nullopt);
+
+/**
+ * Sum x across the group in two levels. The processes of a node reduce
+ * scatter x, the processes with the same local rank sum their part across
+ * the nodes and the node gathers the parts. Every process only sends
+ * 1 / (processes per node) of x across nodes. The nodes are detected from
+ * the host names the first time a group is used, which communicates. If the
+ * nodes have different numbers of processes it is a plain all_sum.
+ */
+array all_sum_hierarchical(
+    const array& x,
+    std::optional<Group> group = std::nullopt);
+
+/**
+ * Row parallel linear layer. Compute x @ w.T, where x and w hold this rank's
+ * shard of the input features, and sum it across the group. The output
+ * features are computed in n_chunks chunks and the sum of a chunk starts as
+ * soon as it is computed so it overlaps the computation of the next chunks.
+ */
+array matmul_all_sum(
+    const array& x,
+    const array& w,
+    int n_chunks = 4,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Column parallel linear layer. Compute x @ w.T, where w holds this rank's
+ * shard of the output features, and gather the output features of all the
+ * ranks in rank order. The chunks are gathered as in matmul_all_sum.
+ */
+array matmul_all_gather(
+    const array& x,
+    const array& w,
+    int n_chunks = 4,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/** The quantized_matmul equivalent of matmul_all_sum. */
+array quantized_matmul_all_sum(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size = 64,
+    int bits = 4,
+    int n_chunks = 4,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/** The quantized_matmul equivalent of matmul_all_gather. */
+array quantized_matmul_all_gather(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size = 64,
+    int bits = 4,
+    int n_chunks = 4,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Sum x across the group sending it as comm_type (float16 or bfloat16) to
+ * halve the communication of float32 arrays. The partial sums are
+ * accumulated in float32 and the result is cast back to the type of x.
+ * It needs a backend that implements all_to_all.
+ */
+array all_sum_cast(
+    const array& x,
+    Dtype comm_type,
+    std::optional<Group> group = std::nullopt);
+
+/**
+ * Sum x across the group sending only the k entries of x + error with the
+ * largest magnitude. Returns the (sparse) sum and the new error, the entries
+ * that were not sent, which should be passed to the next call so that they
+ * are eventually communicated.
+ */
+std::pair<array, array> all_sum_topk(
+    const array& x,
+    const array& error,
+    int k,
+    std::optional<Group> group = std::nullopt);
 
 } // namespace mlx::core::distributed
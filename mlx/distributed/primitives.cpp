@@ -36,7 +36,7 @@ std::pair<std::vector<array>, std::vector<int>> AllReduce::vmap(
     const std::vector<int>& axes) {
   switch (reduce_type_) {
     case Sum:
-      return {{all_sum(inputs[0], group())}, axes};
+      return {{all_sum(inputs[0], group(), stream())}, axes};
     default:
       throw std::runtime_error("Only all reduce sum is supported for now");
   }
@@ -48,7 +48,7 @@ std::vector<array> AllReduce::jvp(
     const std::vector<int>& argnums) {
   switch (reduce_type_) {
     case Sum:
-      return {all_sum(tangents[0], group())};
+      return {all_sum(tangents[0], group(), stream())};
     default:
       throw std::runtime_error("Only all reduce sum is supported for now");
   }
@@ -76,14 +76,14 @@ void AllGather::eval_cpu(
 std::pair<std::vector<array>, std::vector<int>> AllGather::vmap(
     const std::vector<array>& inputs,
     const std::vector<int>& axes) {
-  return {{all_gather(inputs[0], group())}, axes};
+  return {{all_gather(inputs[0], group(), stream())}, axes};
 }
 
 std::vector<array> AllGather::jvp(
     const std::vector<array>& primals,
     const std::vector<array>& tangents,
     const std::vector<int>& argnums) {
-  return {all_gather(tangents[0], group())};
+  return {all_gather(tangents[0], group(), stream())};
 }
 
 std::vector<array> AllGather::vjp(
@@ -99,4 +99,156 @@ std::vector<array> AllGather::vjp(
   return {slice(cotangents[0], starts, stops)};
 }
 
+void ReduceScatter::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  outputs[0].set_data(allocator::malloc_or_wait(outputs[0].nbytes()));
+  distributed::detail::reduce_scatter(group(), inputs[0], outputs[0]);
+}
+
+std::pair<std::vector<array>, std::vector<int>> ReduceScatter::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // Keep the scattered axis first
+  auto x = inputs[0];
+  int ax = axes[0];
+  if (ax == 0) {
+    x = moveaxis(x, 0, 1);
+    ax = 1;
+  }
+  return {{reduce_scatter(x, group(), stream())}, {ax}};
+}
+
+std::vector<array> ReduceScatter::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  return {reduce_scatter(tangents[0], group(), stream())};
+}
+
+std::vector<array> ReduceScatter::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // Every block of the input contributes to the output of its rank
+  return {all_gather(cotangents[0], group(), stream())};
+}
+
+void AllToAll::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  outputs[0].set_data(allocator::malloc_or_wait(outputs[0].nbytes()));
+  distributed::detail::all_to_all(
+      group(), inputs[0], outputs[0], send_sizes_, recv_sizes_);
+}
+
+std::pair<std::vector<array>, std::vector<int>> AllToAll::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // Keep the exchanged axis first
+  auto x = inputs[0];
+  int ax = axes[0];
+  if (ax == 0) {
+    x = moveaxis(x, 0, 1);
+    ax = 1;
+  }
+  return {{all_to_all(x, send_sizes_, recv_sizes_, group())}, {ax}};
+}
+
+std::vector<array> AllToAll::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  return {all_to_all(tangents[0], send_sizes_, recv_sizes_, group())};
+}
+
+std::vector<array> AllToAll::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // The exchange in the other direction routes every row back
+  return {all_to_all(cotangents[0], recv_sizes_, send_sizes_, group())};
+}
+
+void BroadcastRoot::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  auto& in = inputs[0];
+  auto& out = outputs[0];
+  auto g = group();
+  if (g.rank() != root_) {
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+  } else if (in.flags().row_contiguous && in.is_donatable()) {
+    out.copy_shared_buffer(in);
+  } else {
+    copy(in, out, CopyType::General);
+  }
+  distributed::detail::broadcast(g, out, root_);
+}
+
+std::pair<std::vector<array>, std::vector<int>> BroadcastRoot::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  return {{broadcast(inputs[0], root_, group(), stream())}, axes};
+}
+
+std::vector<array> BroadcastRoot::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  return {broadcast(tangents[0], root_, group(), stream())};
+}
+
+std::vector<array> BroadcastRoot::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // Only the root input reaches the outputs. Every rank takes part in the
+  // sum and the others scale it to zero so that none of them skips it.
+  auto g = group();
+  auto sum = all_sum(cotangents[0], g, stream());
+  if (g.rank() != root_) {
+    sum = multiply(sum, array(0, sum.dtype()));
+  }
+  return {sum};
+}
+
+void Send::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  distributed::detail::send(group(), inputs[0], dst_);
+  outputs[0].copy_shared_buffer(inputs[0]);
+}
+
+std::pair<std::vector<array>, std::vector<int>> Send::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  return {{send(inputs[0], dst_, group())}, axes};
+}
+
+void Recv::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 0);
+  assert(outputs.size() == 1);
+
+  outputs[0].set_data(allocator::malloc_or_wait(outputs[0].nbytes()));
+  distributed::detail::recv(group(), outputs[0], src_);
+}
+
 } // namespace mlx::core::distributed
@@ -0,0 +1,18 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/distributed/ring/ring.h"
+
+namespace mlx::core::distributed::ring {
+
+bool is_available() {
+  return false;
+}
+
+std::shared_ptr<GroupImpl> init(bool strict /* = false */) {
+  if (strict) {
+    throw std::runtime_error("[ring] The ring backend is not built");
+  }
+  return nullptr;
+}
+
+} // namespace mlx::core::distributed::ring
@@ -0,0 +1,426 @@
+// Copyright © 2024 Apple Inc.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include "mlx/backend/common/copy.h"
+#include "mlx/distributed/distributed_impl.h"
+#include "mlx/distributed/ring/ring.h"
+#include "mlx/distributed/utils.h"
+
+namespace mlx::core::distributed::ring {
+
+using detail::ensure_row_contiguous;
+using detail::sum_inplace;
+
+namespace {
+
+constexpr size_t CHUNK_SIZE = 1 << 20;
+constexpr int CONNECT_RETRIES = 600;
+constexpr auto CONNECT_WAIT = std::chrono::milliseconds(100);
+
+[[noreturn]] void throw_error(const std::string& msg) {
+  std::ostringstream error;
+  error << "[ring] " << msg << " (" << std::strerror(errno) << ")";
+  throw std::runtime_error(error.str());
+}
+
+sockaddr_in parse_address(const std::string& address) {
+  auto colon = address.rfind(':');
+  if (colon == std::string::npos) {
+    throw std::invalid_argument(
+        "[ring] Addresses must be of the form ip:port but got " + address);
+  }
+
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(std::stoi(address.substr(colon + 1)));
+  if (inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr) !=
+      1) {
+    throw std::invalid_argument("[ring] Invalid IPv4 address " + address);
+  }
+  return addr;
+}
+
+/**
+ * Read the hostfile which has one line per rank. Each line holds the
+ * whitespace separated ip:port addresses that the rank listens on, one per
+ * connection to its left neighbour. Everything after a # is ignored.
+ */
+std::vector<std::vector<sockaddr_in>> parse_hostfile(const char* path) {
+  std::ifstream f(path);
+  if (!f.good()) {
+    std::ostringstream msg;
+    msg << "[ring] Could not open the hostfile " << path << ".";
+    throw std::runtime_error(msg.str());
+  }
+
+  std::vector<std::vector<sockaddr_in>> hosts;
+  std::string line;
+  while (std::getline(f, line)) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream addresses(line);
+    std::vector<sockaddr_in> host;
+    std::string address;
+    while (addresses >> address) {
+      host.push_back(parse_address(address));
+    }
+    if (!host.empty()) {
+      hosts.push_back(std::move(host));
+    }
+  }
+
+  if (hosts.empty()) {
+    throw std::runtime_error("[ring] The hostfile contains no hosts.");
+  }
+  for (auto& host : hosts) {
+    if (host.size() != hosts[0].size()) {
+      throw std::runtime_error(
+          "[ring] All hosts need the same number of addresses.");
+    }
+  }
+  return hosts;
+}
+
+int listen_on(const sockaddr_in& addr) {
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0) {
+    throw_error("Couldn't create a socket");
+  }
+  int enable = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  if (bind(sock, (const sockaddr*)&addr, sizeof(addr)) < 0) {
+    throw_error("Couldn't bind the listening socket");
+  }
+  if (listen(sock, 1) < 0) {
+    throw_error("Couldn't listen");
+  }
+  return sock;
+}
+
+void set_nodelay(int sock) {
+  int enable = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+
+int connect_to(const sockaddr_in& addr) {
+  // The neighbour may not be listening yet so retry for a while
+  for (int attempt = 0; attempt < CONNECT_RETRIES; attempt++) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+      throw_error("Couldn't create a socket");
+    }
+    if (connect(sock, (const sockaddr*)&addr, sizeof(addr)) == 0) {
+      set_nodelay(sock);
+      return sock;
+    }
+    close(sock);
+    std::this_thread::sleep_for(CONNECT_WAIT);
+  }
+  throw_error("Couldn't connect to the right neighbour");
+}
+
+int accept_from(int listening) {
+  int sock = accept(listening, nullptr, nullptr);
+  if (sock < 0) {
+    throw_error("Couldn't accept the left neighbour");
+  }
+  set_nodelay(sock);
+  return sock;
+}
+
+void send_all(int sock, const char* data, size_t nbytes) {
+  while (nbytes > 0) {
+    ssize_t n = ::send(sock, data, nbytes, 0);
+    if (n <= 0) {
+      throw_error("Send failed");
+    }
+    data += n;
+    nbytes -= n;
+  }
+}
+
+void recv_all(int sock, char* data, size_t nbytes) {
+  while (nbytes > 0) {
+    ssize_t n = ::recv(sock, data, nbytes, 0);
+    if (n <= 0) {
+      throw_error("Receive failed");
+    }
+    data += n;
+    nbytes -= n;
+  }
+}
+
+class RingGroup : public GroupImpl {
+ public:
+  RingGroup(int rank, const std::vector<std::vector<sockaddr_in>>& hosts)
+      : rank_(rank), size_(hosts.size()) {
+    if (size_ == 1) {
+      return;
+    }
+
+    // Listen first so that the left neighbour can connect while we connect
+    // to the right one.
+    std::vector<int> listening;
+    for (auto& addr : hosts[rank_]) {
+      listening.push_back(listen_on(addr));
+    }
+    for (auto& addr : hosts[(rank_ + 1) % size_]) {
+      right_.push_back(connect_to(addr));
+    }
+    for (int sock : listening) {
+      left_.push_back(accept_from(sock));
+      close(sock);
+    }
+  }
+
+  ~RingGroup() {
+    for (int sock : left_) {
+      close(sock);
+    }
+    for (int sock : right_) {
+      close(sock);
+    }
+  }
+
+  int rank() override {
+    return rank_;
+  }
+
+  int size() override {
+    return size_;
+  }
+
+  std::shared_ptr<GroupImpl> split(int color, int key = -1) override {
+    throw std::runtime_error("[ring] Group split is not supported.");
+  }
+
+  void all_sum(const array& input_, array& output) override {
+    array input = ensure_row_contiguous(input_);
+    if (input.data<void>() != output.data<void>()) {
+      std::memcpy(output.data<char>(), input.data<char>(), input.nbytes());
+    }
+    auto segment = segments(output.size(), output.itemsize());
+    reduce_scatter_inplace(output.data<char>(), segment, output.dtype());
+    all_gather_inplace(output.data<char>(), segment);
+  }
+
+  void all_gather(const array& input_, array& output) override {
+    array input = ensure_row_contiguous(input_);
+    std::memcpy(
+        output.data<char>() + rank_ * input.nbytes(),
+        input.data<char>(),
+        input.nbytes());
+    all_gather_inplace(output.data<char>(), uniform_segments(input.nbytes()));
+  }
+
+  void reduce_scatter(const array& input_, array& output) override {
+    // Reduce in a copy of the input so that it is left untouched
+    array input(input_.shape(), input_.dtype(), nullptr, {});
+    copy(input_, input, CopyType::General);
+    reduce_scatter_inplace(
+        input.data<char>(), uniform_segments(output.nbytes()), input.dtype());
+    std::memcpy(
+        output.data<char>(),
+        input.data<char>() + rank_ * output.nbytes(),
+        output.nbytes());
+  }
+
+  void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<int>& send_sizes,
+      const std::vector<int>& recv_sizes) override {
+    throw std::runtime_error("[ring] all_to_all is not supported.");
+  }
+
+  void broadcast(array& inout, int root) override {
+    // Pipeline the chunks along the ring starting from the root
+    bool forward = (rank_ + 1) % size_ != root;
+    char* data = inout.data<char>();
+    size_t nbytes = inout.nbytes();
+    size_t chunk = CHUNK_SIZE - CHUNK_SIZE % inout.itemsize();
+    for (size_t start = 0; start < nbytes; start += chunk) {
+      size_t n = std::min(chunk, nbytes - start);
+      if (rank_ != root) {
+        send_recv(nullptr, 0, data + start, n, inout.itemsize());
+      }
+      if (forward) {
+        send_recv(data + start, n, nullptr, 0, inout.itemsize());
+      }
+    }
+  }
+
+  void send(const array& input_, int dst) override {
+    if (dst != (rank_ + 1) % size_) {
+      throw std::runtime_error(
+          "[ring] Can only send to the right neighbour in the ring.");
+    }
+    array input = ensure_row_contiguous(input_);
+    send_recv(
+        input.data<char>(), input.nbytes(), nullptr, 0, input.itemsize());
+  }
+
+  void recv(array& out, int src) override {
+    if (src != (rank_ + size_ - 1) % size_) {
+      throw std::runtime_error(
+          "[ring] Can only receive from the left neighbour in the ring.");
+    }
+    send_recv(nullptr, 0, out.data<char>(), out.nbytes(), out.itemsize());
+  }
+
+ private:
+  // The byte offsets of the size_ segments of a buffer, split at element
+  // boundaries. Segment i is [offsets[i], offsets[i + 1]).
+  std::vector<size_t> segments(size_t n, size_t itemsize) {
+    size_t per_segment = (n + size_ - 1) / size_;
+    std::vector<size_t> offsets(size_ + 1);
+    for (int i = 0; i <= size_; i++) {
+      offsets[i] = std::min(i * per_segment, n) * itemsize;
+    }
+    return offsets;
+  }
+
+  std::vector<size_t> uniform_segments(size_t nbytes) {
+    std::vector<size_t> offsets(size_ + 1);
+    for (int i = 0; i <= size_; i++) {
+      offsets[i] = i * nbytes;
+    }
+    return offsets;
+  }
+
+  // After this rank r holds the sum of segment r of all the ranks
+  void reduce_scatter_inplace(
+      char* data,
+      const std::vector<size_t>& offsets,
+      Dtype dtype) {
+    for (int step = 0; step < size_ - 1; step++) {
+      int s = (rank_ - step - 1 + 2 * size_) % size_;
+      int r = (rank_ - step - 2 + 2 * size_) % size_;
+      send_recv(
+          data + offsets[s],
+          offsets[s + 1] - offsets[s],
+          data + offsets[r],
+          offsets[r + 1] - offsets[r],
+          size_of(dtype),
+          dtype);
+    }
+  }
+
+  // Assumes rank r holds segment r and distributes it to all the ranks
+  void all_gather_inplace(char* data, const std::vector<size_t>& offsets) {
+    for (int step = 0; step < size_ - 1; step++) {
+      int s = (rank_ - step + size_) % size_;
+      int r = (rank_ - step - 1 + size_) % size_;
+      send_recv(
+          data + offsets[s],
+          offsets[s + 1] - offsets[s],
+          data + offsets[r],
+          offsets[r + 1] - offsets[r],
+          1);
+    }
+  }
+
+  /**
+   * Send to the right neighbour and receive from the left one concurrently.
+   * The buffers are split at element boundaries over the connections. When
+   * sum_type is given the received data is added to rbuf chunk by chunk
+   * instead of overwriting it.
+   */
+  void send_recv(
+      const char* sbuf,
+      size_t sbytes,
+      char* rbuf,
+      size_t rbytes,
+      size_t itemsize,
+      std::optional<Dtype> sum_type = std::nullopt) {
+    auto split = [&](size_t nbytes, int i) {
+      size_t n = nbytes / itemsize;
+      size_t per_connection = (n + right_.size() - 1) / right_.size();
+      size_t start = std::min(i * per_connection, n) * itemsize;
+      size_t end = std::min((i + 1) * per_connection, n) * itemsize;
+      return std::make_pair(start, end - start);
+    };
+
+    std::vector<std::future<void>> tasks;
+    for (int i = 0; i < right_.size(); i++) {
+      if (auto [start, n] = split(sbytes, i); n > 0) {
+        tasks.push_back(std::async(
+            std::launch::async, send_all, right_[i], sbuf + start, n));
+      }
+      if (auto [start, n] = split(rbytes, i); n > 0) {
+        int sock = left_[i];
+        char* dst = rbuf + start;
+        tasks.push_back(std::async(std::launch::async, [=]() {
+          if (!sum_type) {
+            recv_all(sock, dst, n);
+            return;
+          }
+          size_t chunk = CHUNK_SIZE - CHUNK_SIZE % itemsize;
+          std::vector<char> buffer(std::min(chunk, n));
+          for (size_t offset = 0; offset < n; offset += chunk) {
+            size_t m = std::min(chunk, n - offset);
+            recv_all(sock, buffer.data(), m);
+            sum_inplace(*sum_type, buffer.data(), dst + offset, m);
+          }
+        }));
+      }
+    }
+    for (auto& task : tasks) {
+      task.get();
+    }
+  }
+
+  int rank_;
+  int size_;
+  std::vector<int> left_;
+  std::vector<int> right_;
+};
+
+} // namespace
+
+bool is_available() {
+  return std::getenv("MLX_HOSTFILE") != nullptr &&
+      std::getenv("MLX_RANK") != nullptr;
+}
+
+std::shared_ptr<GroupImpl> init(bool strict /* = false */) {
+  static std::shared_ptr<GroupImpl> global_group = nullptr;
+
+  if (global_group == nullptr) {
+    if (!is_available()) {
+      if (strict) {
+        throw std::runtime_error(
+            "[ring] MLX_HOSTFILE and MLX_RANK need to be set.");
+      }
+      return nullptr;
+    }
+
+    auto hosts = parse_hostfile(std::getenv("MLX_HOSTFILE"));
+    int rank = std::atoi(std::getenv("MLX_RANK"));
+    if (rank < 0 || rank >= hosts.size()) {
+      std::ostringstream msg;
+      msg << "[ring] MLX_RANK is " << rank << " but the hostfile has "
+          << hosts.size() << " hosts.";
+      throw std::runtime_error(msg.str());
+    }
+    global_group = std::make_shared<RingGroup>(rank, hosts);
+  }
+
+  return global_group;
+}
+
+} // namespace mlx::core::distributed::ring
@@ -0,0 +1,18 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/distributed/shm/shm.h"
+
+namespace mlx::core::distributed::shm {
+
+bool is_available() {
+  return false;
+}
+
+std::shared_ptr<GroupImpl> init(bool strict /* = false */) {
+  if (strict) {
+    throw std::runtime_error("[shm] The shared memory backend is not built");
+  }
+  return nullptr;
+}
+
+} // namespace mlx::core::distributed::shm
@@ -0,0 +1,315 @@
+// Copyright © 2024 Apple Inc.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#include "mlx/distributed/distributed_impl.h"
+#include "mlx/distributed/shm/shm.h"
+#include "mlx/distributed/utils.h"
+
+namespace mlx::core::distributed::shm {
+
+using detail::ensure_row_contiguous;
+using detail::sum_inplace;
+
+namespace {
+
+// The bytes of the shared region that each rank writes to
+constexpr size_t SLOT_SIZE = 1 << 22;
+constexpr int ATTACH_RETRIES = 600;
+constexpr auto ATTACH_WAIT = std::chrono::milliseconds(100);
+
+[[noreturn]] void throw_error(const std::string& msg) {
+  std::ostringstream error;
+  error << "[shm] " << msg << " (" << std::strerror(errno) << ")";
+  throw std::runtime_error(error.str());
+}
+
+struct Header {
+  std::atomic<uint64_t> arrived;
+  std::atomic<uint64_t> generation;
+};
+
+// Used by send and recv, the destination + 1 when the slot holds data
+struct alignas(64) Mailbox {
+  std::atomic<int> dst;
+  std::atomic<size_t> nbytes;
+};
+
+/**
+ * The ranks share one mapped region with a slot per rank followed by a
+ * result slot. The collectives are performed in chunks of a slot: every
+ * rank copies its chunk in its slot, reduces its segment of the chunk from
+ * all the slots directly in the shared region and copies the result out.
+ */
+class SharedMemoryGroup : public GroupImpl {
+ public:
+  SharedMemoryGroup(int rank, int size, const std::string& name)
+      : rank_(rank), size_(size) {
+    size_t header_size = 64 + size_ * sizeof(Mailbox);
+    size_t total = header_size + (size_ + 1) * SLOT_SIZE;
+
+    int fd = -1;
+    if (rank_ == 0) {
+      shm_unlink(name.c_str());
+      fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+      if (fd < 0 || ftruncate(fd, total) < 0) {
+        throw_error("Couldn't create the shared memory " + name);
+      }
+    } else {
+      // Wait for rank 0 to create the region with the right size
+      struct stat st;
+      for (int attempt = 0; attempt < ATTACH_RETRIES; attempt++) {
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd >= 0 && fstat(fd, &st) == 0 &&
+            static_cast<size_t>(st.st_size) == total) {
+          break;
+        }
+        if (fd >= 0) {
+          close(fd);
+          fd = -1;
+        }
+        std::this_thread::sleep_for(ATTACH_WAIT);
+      }
+      if (fd < 0) {
+        throw_error("Couldn't open the shared memory " + name);
+      }
+    }
+
+    void* region =
+        mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+      throw_error("Couldn't map the shared memory");
+    }
+    region_ = static_cast<char*>(region);
+    region_size_ = total;
+    header_ = reinterpret_cast<Header*>(region_);
+    mailboxes_ = reinterpret_cast<Mailbox*>(region_ + 64);
+    slots_ = region_ + header_size;
+
+    // The name is not needed once everyone is attached
+    barrier();
+    if (rank_ == 0) {
+      shm_unlink(name.c_str());
+    }
+  }
+
+  ~SharedMemoryGroup() {
+    munmap(region_, region_size_);
+  }
+
+  int rank() override {
+    return rank_;
+  }
+
+  int size() override {
+    return size_;
+  }
+
+  std::shared_ptr<GroupImpl> split(int color, int key = -1) override {
+    throw std::runtime_error("[shm] Group split is not supported.");
+  }
+
+  void all_sum(const array& input_, array& output) override {
+    array input = ensure_row_contiguous(input_);
+    const char* in = input.data<char>();
+    char* out = output.data<char>();
+    size_t itemsize = input.itemsize();
+    size_t chunk = SLOT_SIZE - SLOT_SIZE % itemsize;
+    for (size_t start = 0; start < input.nbytes(); start += chunk) {
+      size_t n = std::min(chunk, input.nbytes() - start);
+      std::memcpy(slot(rank_), in + start, n);
+      barrier();
+
+      // Sum this rank's segment of the chunk into the result slot
+      auto [seg_start, seg_n] = segment(n, itemsize, rank_);
+      char* result = slot(size_) + seg_start;
+      std::memcpy(result, slot(0) + seg_start, seg_n);
+      for (int i = 1; i < size_; i++) {
+        sum_inplace(input.dtype(), slot(i) + seg_start, result, seg_n);
+      }
+      barrier();
+
+      std::memcpy(out + start, slot(size_), n);
+      barrier();
+    }
+  }
+
+  void all_gather(const array& input_, array& output) override {
+    array input = ensure_row_contiguous(input_);
+    const char* in = input.data<char>();
+    char* out = output.data<char>();
+    size_t nbytes = input.nbytes();
+    for (size_t start = 0; start < nbytes; start += SLOT_SIZE) {
+      size_t n = std::min(SLOT_SIZE, nbytes - start);
+      std::memcpy(slot(rank_), in + start, n);
+      barrier();
+      for (int i = 0; i < size_; i++) {
+        std::memcpy(out + i * nbytes + start, slot(i), n);
+      }
+      barrier();
+    }
+  }
+
+  void reduce_scatter(const array& input_, array& output) override {
+    // Every rank puts the same chunk of all the blocks in its slot and then
+    // sums the chunk of its own block from all the slots
+    array input = ensure_row_contiguous(input_);
+    const char* in = input.data<char>();
+    char* out = output.data<char>();
+    size_t itemsize = input.itemsize();
+    size_t nbytes = output.nbytes();
+    size_t chunk = SLOT_SIZE / size_;
+    chunk -= chunk % itemsize;
+    if (chunk == 0) {
+      throw std::runtime_error("[shm] The group is too large.");
+    }
+    for (size_t start = 0; start < nbytes; start += chunk) {
+      size_t n = std::min(chunk, nbytes - start);
+      for (int i = 0; i < size_; i++) {
+        std::memcpy(slot(rank_) + i * chunk, in + i * nbytes + start, n);
+      }
+      barrier();
+      std::memcpy(out + start, slot(0) + rank_ * chunk, n);
+      for (int i = 1; i < size_; i++) {
+        sum_inplace(input.dtype(), slot(i) + rank_ * chunk, out + start, n);
+      }
+      barrier();
+    }
+  }
+
+  void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<int>& send_sizes,
+      const std::vector<int>& recv_sizes) override {
+    throw std::runtime_error("[shm] all_to_all is not supported.");
+  }
+
+  void broadcast(array& inout, int root) override {
+    char* data = inout.data<char>();
+    size_t nbytes = inout.nbytes();
+    for (size_t start = 0; start < nbytes; start += SLOT_SIZE) {
+      size_t n = std::min(SLOT_SIZE, nbytes - start);
+      if (rank_ == root) {
+        std::memcpy(slot(root), data + start, n);
+      }
+      barrier();
+      if (rank_ != root) {
+        std::memcpy(data + start, slot(root), n);
+      }
+      barrier();
+    }
+  }
+
+  void send(const array& input_, int dst) override {
+    // The slot is handed to dst chunk by chunk through the mailbox
+    array input = ensure_row_contiguous(input_);
+    const char* in = input.data<char>();
+    auto& mailbox = mailboxes_[rank_];
+    for (size_t start = 0; start < input.nbytes(); start += SLOT_SIZE) {
+      size_t n = std::min(SLOT_SIZE, input.nbytes() - start);
+      std::memcpy(slot(rank_), in + start, n);
+      mailbox.nbytes.store(n, std::memory_order_relaxed);
+      mailbox.dst.store(dst + 1, std::memory_order_release);
+      wait_until([&] { return mailbox.dst.load() == 0; });
+    }
+  }
+
+  void recv(array& out, int src) override {
+    char* data = out.data<char>();
+    auto& mailbox = mailboxes_[src];
+    for (size_t start = 0; start < out.nbytes(); start += SLOT_SIZE) {
+      wait_until([&] { return mailbox.dst.load() == rank_ + 1; });
+      size_t n = mailbox.nbytes.load(std::memory_order_relaxed);
+      std::memcpy(data + start, slot(src), n);
+      mailbox.dst.store(0, std::memory_order_release);
+    }
+  }
+
+ private:
+  char* slot(int i) {
+    return slots_ + i * SLOT_SIZE;
+  }
+
+  // The part of a chunk of nbytes that rank i reduces
+  std::pair<size_t, size_t> segment(size_t nbytes, size_t itemsize, int i) {
+    size_t n = nbytes / itemsize;
+    size_t per_rank = (n + size_ - 1) / size_;
+    size_t start = std::min(i * per_rank, n);
+    size_t end = std::min(start + per_rank, n);
+    return {start * itemsize, (end - start) * itemsize};
+  }
+
+  template <typename F>
+  void wait_until(F&& done) {
+    while (!done()) {
+      std::this_thread::yield();
+    }
+  }
+
+  void barrier() {
+    uint64_t generation = header_->generation.load();
+    if (header_->arrived.fetch_add(1) + 1 == size_) {
+      header_->arrived.store(0);
+      header_->generation.fetch_add(1);
+    } else {
+      wait_until([&] { return header_->generation.load() != generation; });
+    }
+  }
+
+  int rank_;
+  int size_;
+  char* region_;
+  size_t region_size_;
+  Header* header_;
+  Mailbox* mailboxes_;
+  char* slots_;
+};
+
+} // namespace
+
+bool is_available() {
+  return std::getenv("MLX_RANK") != nullptr &&
+      std::getenv("MLX_WORLD_SIZE") != nullptr;
+}
+
+std::shared_ptr<GroupImpl> init(bool strict /* = false */) {
+  static std::shared_ptr<GroupImpl> global_group = nullptr;
+
+  if (global_group == nullptr) {
+    if (!is_available()) {
+      if (strict) {
+        throw std::runtime_error(
+            "[shm] MLX_RANK and MLX_WORLD_SIZE need to be set.");
+      }
+      return nullptr;
+    }
+
+    int rank = std::atoi(std::getenv("MLX_RANK"));
+    int size = std::atoi(std::getenv("MLX_WORLD_SIZE"));
+    if (size <= 0 || rank < 0 || rank >= size) {
+      std::ostringstream msg;
+      msg << "[shm] Invalid MLX_RANK " << rank << " for MLX_WORLD_SIZE "
+          << size << ".";
+      throw std::runtime_error(msg.str());
+    }
+    const char* name = std::getenv("MLX_SHM_NAME");
+    global_group = std::make_shared<SharedMemoryGroup>(
+        rank, size, name ? name : "/mlx_shm");
+  }
+
+  return global_group;
+}
+
+} // namespace mlx::core::distributed::shm
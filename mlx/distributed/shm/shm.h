@@ -0,0 +1,17 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/distributed/distributed.h"
+
+namespace mlx::core::distributed::shm {
+
+using GroupImpl = mlx::core::distributed::detail::GroupImpl;
+
+/* Check if the shared memory backend is configured */
+bool is_available();
+
+/* Map the shared memory and return the world group or nullptr on failure */
+std::shared_ptr<GroupImpl> init(bool strict = false);
+
+} // namespace mlx::core::distributed::shm
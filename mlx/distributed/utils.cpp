@@ -0,0 +1,67 @@
+// Copyright © 2024 Apple Inc.
+
+#include "mlx/distributed/utils.h"
+#include "mlx/backend/common/copy.h"
+
+namespace mlx::core::distributed::detail {
+
+namespace {
+
+template <typename T>
+void sum_inplace(const char* in_, char* out_, size_t nbytes) {
+  auto in = reinterpret_cast<const T*>(in_);
+  auto out = reinterpret_cast<T*>(out_);
+  size_t n = nbytes / sizeof(T);
+  for (size_t i = 0; i < n; i++) {
+    if constexpr (std::is_same_v<T, bool>) {
+      out[i] = out[i] || in[i];
+    } else {
+      out[i] = out[i] + in[i];
+    }
+  }
+}
+
+} // namespace
+
+array ensure_row_contiguous(const array& arr) {
+  if (arr.flags().row_contiguous) {
+    return arr;
+  } else {
+    array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+    copy(arr, arr_copy, CopyType::General);
+    return arr_copy;
+  }
+}
+
+void sum_inplace(Dtype dtype, const char* in, char* out, size_t nbytes) {
+  switch (dtype) {
+    case bool_:
+      return sum_inplace<bool>(in, out, nbytes);
+    case uint8:
+      return sum_inplace<uint8_t>(in, out, nbytes);
+    case uint16:
+      return sum_inplace<uint16_t>(in, out, nbytes);
+    case uint32:
+      return sum_inplace<uint32_t>(in, out, nbytes);
+    case uint64:
+      return sum_inplace<uint64_t>(in, out, nbytes);
+    case int8:
+      return sum_inplace<int8_t>(in, out, nbytes);
+    case int16:
+      return sum_inplace<int16_t>(in, out, nbytes);
+    case int32:
+      return sum_inplace<int32_t>(in, out, nbytes);
+    case int64:
+      return sum_inplace<int64_t>(in, out, nbytes);
+    case float16:
+      return sum_inplace<float16_t>(in, out, nbytes);
+    case bfloat16:
+      return sum_inplace<bfloat16_t>(in, out, nbytes);
+    case float32:
+      return sum_inplace<float>(in, out, nbytes);
+    case complex64:
+      return sum_inplace<complex64_t>(in, out, nbytes);
+  }
+}
+
+} // namespace mlx::core::distributed::detail
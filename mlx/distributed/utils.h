@@ -0,0 +1,15 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core::distributed::detail {
+
+/* Return arr or a row contiguous copy of it evaluated on the CPU */
+array ensure_row_contiguous(const array& arr);
+
+/* Add the nbytes of in to out element-wise, bools are or-ed */
+void sum_inplace(Dtype dtype, const char* in, char* out, size_t nbytes);
+
+} // namespace mlx::core::distributed::detail
@@ -0,0 +1,681 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "mlx/einsum.h"
+#include "mlx/ops.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Labels are the letters a-z, then A-Z, then the broadcast axes of "..."
+// aligned to the right. A set of labels is a bit mask.
+constexpr int n_letters = 52;
+constexpr int max_labels = 64;
+using LabelSet = uint64_t;
+
+int letter_label(char c) {
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a';
+  }
+  if (c >= 'A' && c <= 'Z') {
+    return 26 + c - 'A';
+  }
+  return -1;
+}
+
+char label_char(int l) {
+  if (l < 26) {
+    return 'a' + l;
+  }
+  if (l < n_letters) {
+    return 'A' + l - 26;
+  }
+  // Broadcast axes are only shown in descriptions
+  return '0' + (l - n_letters) % 10;
+}
+
+LabelSet label_set(const std::vector<int>& labels) {
+  LabelSet set = 0;
+  for (auto l : labels) {
+    set |= LabelSet(1) << l;
+  }
+  return set;
+}
+
+std::string labels_string(const std::vector<int>& labels) {
+  std::string s;
+  for (auto l : labels) {
+    s += label_char(l);
+  }
+  return s;
+}
+
+struct Plan {
+  std::vector<std::vector<int>> inputs;
+  std::vector<int> output;
+  // The size of each label, the largest of the sizes it has
+  std::vector<double> sizes;
+  std::vector<std::vector<int>> path;
+  std::string description;
+};
+
+// Parse the subscripts, one vector of labels per operand
+void parse(
+    const std::string& subscripts,
+    const std::vector<array>& operands,
+    Plan& plan) {
+  std::string str;
+  for (auto c : subscripts) {
+    if (c != ' ') {
+      str += c;
+    }
+  }
+  auto arrow = str.find("->");
+  std::string lhs = str.substr(0, arrow);
+
+  std::vector<std::string> terms;
+  std::istringstream is(lhs);
+  for (std::string term; std::getline(is, term, ',');) {
+    terms.push_back(term);
+  }
+  if (!lhs.empty() && lhs.back() == ',') {
+    terms.push_back("");
+  }
+  if (terms.size() != operands.size()) {
+    std::ostringstream msg;
+    msg << "[einsum] The subscripts have " << terms.size()
+        << " operands but " << operands.size() << " were given.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Split each term into the labels before and after the ellipsis
+  auto split_term = [](const std::string& term) {
+    std::vector<int> before, after;
+    bool ellipsis = false;
+    for (int i = 0; i < term.size(); i++) {
+      if (term.compare(i, 3, "...") == 0) {
+        if (ellipsis) {
+          throw std::invalid_argument(
+              "[einsum] Only one ellipsis is allowed per operand.");
+        }
+        ellipsis = true;
+        i += 2;
+        continue;
+      }
+      int l = letter_label(term[i]);
+      if (l < 0) {
+        std::ostringstream msg;
+        msg << "[einsum] Invalid subscript character '" << term[i] << "'.";
+        throw std::invalid_argument(msg.str());
+      }
+      (ellipsis ? after : before).push_back(l);
+    }
+    return std::make_tuple(std::move(before), std::move(after), ellipsis);
+  };
+
+  std::vector<std::tuple<std::vector<int>, std::vector<int>, bool>> parts;
+  int n_broadcast = 0;
+  for (int i = 0; i < terms.size(); i++) {
+    parts.push_back(split_term(terms[i]));
+    auto& [before, after, ellipsis] = parts.back();
+    int n_explicit = before.size() + after.size();
+    int ndim = operands[i].ndim();
+    if (ellipsis ? n_explicit > ndim : n_explicit != ndim) {
+      std::ostringstream msg;
+      msg << "[einsum] Operand " << i << " has " << ndim
+          << " dimensions but the subscripts \"" << terms[i]
+          << "\" label " << n_explicit << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    if (ellipsis) {
+      n_broadcast = std::max(n_broadcast, ndim - n_explicit);
+    }
+  }
+  if (n_letters + n_broadcast > max_labels) {
+    throw std::invalid_argument(
+        "[einsum] Too many dimensions in the ellipsis.");
+  }
+
+  plan.sizes.assign(max_labels, 1.0);
+  std::vector<int> counts(max_labels, 0);
+  for (int i = 0; i < terms.size(); i++) {
+    auto& [before, after, ellipsis] = parts[i];
+    auto& labels = plan.inputs.emplace_back(before);
+    int n = operands[i].ndim() - before.size() - after.size();
+    for (int j = n_broadcast - n; j < n_broadcast; j++) {
+      labels.push_back(n_letters + j);
+    }
+    labels.insert(labels.end(), after.begin(), after.end());
+    for (int ax = 0; ax < labels.size(); ax++) {
+      int l = labels[ax];
+      int size = operands[i].shape(ax);
+      auto& global = plan.sizes[l];
+      if (global != 1 && size != 1 && size != global) {
+        std::ostringstream msg;
+        msg << "[einsum] Subscript '" << label_char(l) << "' has size "
+            << size << " in operand " << i << " which does not match "
+            << "the size " << global << " it has elsewhere.";
+        throw std::invalid_argument(msg.str());
+      }
+      global = std::max<double>(global, size);
+      counts[l]++;
+    }
+  }
+
+  if (arrow == std::string::npos) {
+    // The broadcast axes and then the labels used once in alphabetical order
+    for (int j = 0; j < n_broadcast; j++) {
+      plan.output.push_back(n_letters + j);
+    }
+    std::vector<int> once;
+    for (int l = 0; l < n_letters; l++) {
+      if (counts[l] == 1) {
+        once.push_back(l);
+      }
+    }
+    std::sort(once.begin(), once.end(), [](int a, int b) {
+      return label_char(a) < label_char(b);
+    });
+    plan.output.insert(plan.output.end(), once.begin(), once.end());
+    return;
+  }
+
+  auto [before, after, ellipsis] = split_term(str.substr(arrow + 2));
+  plan.output = before;
+  if (ellipsis) {
+    for (int j = 0; j < n_broadcast; j++) {
+      plan.output.push_back(n_letters + j);
+    }
+  }
+  plan.output.insert(plan.output.end(), after.begin(), after.end());
+  LabelSet seen = 0;
+  for (auto l : plan.output) {
+    LabelSet bit = LabelSet(1) << l;
+    if (seen & bit) {
+      std::ostringstream msg;
+      msg << "[einsum] Output subscript '" << label_char(l)
+          << "' appears more than once.";
+      throw std::invalid_argument(msg.str());
+    }
+    if (counts[l] == 0) {
+      std::ostringstream msg;
+      msg << "[einsum] Output subscript '" << label_char(l)
+          << "' does not appear in the operands.";
+      throw std::invalid_argument(msg.str());
+    }
+    seen |= bit;
+  }
+}
+
+double set_size(LabelSet set, const std::vector<double>& sizes) {
+  double size = 1;
+  for (int l = 0; set; l++, set >>= 1) {
+    if (set & 1) {
+      size *= sizes[l];
+    }
+  }
+  return size;
+}
+
+std::vector<int> set_labels(LabelSet set) {
+  std::vector<int> labels;
+  for (int l = 0; set; l++, set >>= 1) {
+    if (set & 1) {
+      labels.push_back(l);
+    }
+  }
+  return labels;
+}
+
+// A contraction of two operands, given by their positions in the list of
+// remaining operands, and the labels of the result
+struct Step {
+  int i;
+  int j;
+  LabelSet result;
+  double flops;
+};
+
+// The order with the fewest operations over every binary tree of
+// contractions, found by dynamic programming over the subsets of operands
+std::vector<Step> optimal_order(
+    const std::vector<LabelSet>& inputs,
+    LabelSet output,
+    const std::vector<double>& sizes) {
+  int n = inputs.size();
+  int full = (1 << n) - 1;
+  std::vector<LabelSet> labels(full + 1, 0);
+  for (int set = 1; set <= full; set++) {
+    labels[set] = labels[set & (set - 1)] | inputs[__builtin_ctz(set)];
+  }
+  // The labels of the result of contracting a subset
+  auto kept = [&](int set) {
+    return labels[set] & (output | labels[full ^ set]);
+  };
+
+  std::vector<double> cost(full + 1, std::numeric_limits<double>::infinity());
+  std::vector<int> split(full + 1, 0);
+  for (int set = 1; set <= full; set++) {
+    if ((set & (set - 1)) == 0) {
+      cost[set] = 0;
+      continue;
+    }
+    for (int sub = (set - 1) & set; sub > 0; sub = (sub - 1) & set) {
+      int other = set ^ sub;
+      if (sub < other) {
+        continue;
+      }
+      double c = cost[sub] + cost[other] +
+          set_size(kept(sub) | kept(other), sizes);
+      if (c < cost[set]) {
+        cost[set] = c;
+        split[set] = sub;
+      }
+    }
+  }
+
+  // Replay the tree of contractions on the list of remaining operands
+  std::vector<int> remaining;
+  for (int i = 0; i < n; i++) {
+    remaining.push_back(1 << i);
+  }
+  std::vector<Step> steps;
+  std::function<void(int)> emit = [&](int set) {
+    if ((set & (set - 1)) == 0) {
+      return;
+    }
+    int a = split[set];
+    int b = set ^ a;
+    emit(a);
+    emit(b);
+    auto position = [&](int subset) {
+      return std::find(remaining.begin(), remaining.end(), subset) -
+          remaining.begin();
+    };
+    int i = position(a);
+    int j = position(b);
+    if (i > j) {
+      std::swap(i, j);
+    }
+    remaining.erase(remaining.begin() + j);
+    remaining.erase(remaining.begin() + i);
+    remaining.push_back(set);
+    steps.push_back({i, j, kept(set), set_size(kept(a) | kept(b), sizes)});
+  };
+  emit(full);
+  return steps;
+}
+
+// Contract the pair which shrinks the operands the most until one is left.
+// Pairs which share a label come before outer products.
+std::vector<Step> greedy_order(
+    std::vector<LabelSet> inputs,
+    LabelSet output,
+    const std::vector<double>& sizes) {
+  std::vector<Step> steps;
+  while (inputs.size() > 1) {
+    int n = inputs.size();
+    Step best{-1, -1, 0, 0};
+    bool best_shared = false;
+    double best_score = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < n; i++) {
+      for (int j = i + 1; j < n; j++) {
+        LabelSet others = output;
+        for (int k = 0; k < n; k++) {
+          if (k != i && k != j) {
+            others |= inputs[k];
+          }
+        }
+        LabelSet all = inputs[i] | inputs[j];
+        LabelSet result = all & others;
+        bool shared = (inputs[i] & inputs[j]) != 0;
+        double score = set_size(all, sizes);
+        if (shared) {
+          score = set_size(result, sizes) - set_size(inputs[i], sizes) -
+              set_size(inputs[j], sizes);
+        }
+        if ((shared && !best_shared) ||
+            (shared == best_shared && score < best_score)) {
+          best = {i, j, result, set_size(all, sizes)};
+          best_shared = shared;
+          best_score = score;
+        }
+      }
+    }
+    inputs.erase(inputs.begin() + best.j);
+    inputs.erase(inputs.begin() + best.i);
+    inputs.push_back(best.result);
+    steps.push_back(best);
+  }
+  return steps;
+}
+
+Plan make_plan(
+    const std::string& subscripts,
+    const std::vector<array>& operands) {
+  Plan plan;
+  parse(subscripts, operands, plan);
+
+  std::vector<LabelSet> inputs;
+  LabelSet all = 0;
+  for (auto& labels : plan.inputs) {
+    inputs.push_back(label_set(labels));
+    all |= inputs.back();
+  }
+  LabelSet output = label_set(plan.output);
+  std::vector<Step> steps;
+  if (inputs.size() <= 8) {
+    steps = optimal_order(inputs, output, plan.sizes);
+  } else {
+    steps = greedy_order(inputs, output, plan.sizes);
+  }
+
+  std::ostringstream desc;
+  std::ostringstream terms;
+  for (int i = 0; i < plan.inputs.size(); i++) {
+    terms << (i > 0 ? "," : "") << labels_string(plan.inputs[i]);
+  }
+  double naive = set_size(all, plan.sizes) *
+      std::max<int>(1, static_cast<int>(inputs.size()) - 1);
+  double optimized = 0;
+  for (auto& step : steps) {
+    optimized += step.flops;
+  }
+  desc << "Complete contraction: " << terms.str() << "->"
+       << labels_string(plan.output) << "\n"
+       << "Naive FLOP count: " << naive << "\n"
+       << "Optimized FLOP count: " << optimized << "\n"
+       << "Contractions:\n";
+
+  // The labels of the remaining operands, to describe each step
+  std::vector<std::vector<int>> remaining = plan.inputs;
+  for (auto& step : steps) {
+    plan.path.push_back({step.i, step.j});
+    auto result = set_labels(step.result);
+    desc << "  (" << step.i << ", " << step.j << ") "
+         << labels_string(remaining[step.i]) << ","
+         << labels_string(remaining[step.j]) << "->"
+         << labels_string(result) << "  " << step.flops << " FLOPs\n";
+    remaining.erase(remaining.begin() + step.j);
+    remaining.erase(remaining.begin() + step.i);
+    remaining.push_back(std::move(result));
+  }
+  plan.description = desc.str();
+  return plan;
+}
+
+Plan get_plan(
+    const std::string& subscripts,
+    const std::vector<array>& operands) {
+  static std::mutex mtx;
+  static std::unordered_map<std::string, Plan> cache;
+
+  std::ostringstream key;
+  key << subscripts;
+  for (auto& a : operands) {
+    key << ";" << a.shape();
+  }
+  std::lock_guard<std::mutex> lk(mtx);
+  if (auto it = cache.find(key.str()); it != cache.end()) {
+    return it->second;
+  }
+  // Plans are cheap to remake, keep the cache bounded
+  if (cache.size() >= 1024) {
+    cache.clear();
+  }
+  return cache.emplace(key.str(), make_plan(subscripts, operands))
+      .first->second;
+}
+
+// An intermediate operand and the label of each of its axes
+struct Operand {
+  array a;
+  std::vector<int> labels;
+};
+
+int axis_of(const Operand& x, int label) {
+  return std::find(x.labels.begin(), x.labels.end(), label) - x.labels.begin();
+}
+
+// Sum the axes whose labels are not in keep
+void sum_labels(Operand& x, LabelSet keep, StreamOrDevice s) {
+  std::vector<int> axes;
+  std::vector<int> labels;
+  for (int ax = 0; ax < x.labels.size(); ax++) {
+    if (keep & (LabelSet(1) << x.labels[ax])) {
+      labels.push_back(x.labels[ax]);
+    } else {
+      axes.push_back(ax);
+    }
+  }
+  if (!axes.empty()) {
+    x.a = sum(x.a, axes, false, s);
+    x.labels = std::move(labels);
+  }
+}
+
+// Take the diagonal of the axes with the same label
+void take_diagonals(Operand& x, StreamOrDevice s) {
+  for (int p = 0; p < x.labels.size(); p++) {
+    for (int q = p + 1; q < x.labels.size(); q++) {
+      if (x.labels[p] != x.labels[q]) {
+        continue;
+      }
+      if (x.a.shape(p) != x.a.shape(q)) {
+        std::ostringstream msg;
+        msg << "[einsum] Repeated subscript '" << label_char(x.labels[p])
+            << "' labels axes of different sizes.";
+        throw std::invalid_argument(msg.str());
+      }
+      // The diagonal is the last axis
+      int label = x.labels[p];
+      x.a = diagonal(x.a, 0, p, q, s);
+      x.labels.erase(x.labels.begin() + q);
+      x.labels.erase(x.labels.begin() + p);
+      x.labels.push_back(label);
+      p = -1;
+      break;
+    }
+  }
+}
+
+array transpose_to(
+    const Operand& x,
+    const std::vector<int>& labels,
+    StreamOrDevice s) {
+  std::vector<int> axes;
+  for (auto l : labels) {
+    axes.push_back(axis_of(x, l));
+  }
+  bool identity = true;
+  for (int i = 0; i < axes.size(); i++) {
+    identity &= axes[i] == i;
+  }
+  return identity ? x.a : transpose(x.a, axes, s);
+}
+
+array reshape_to(
+    const array& a,
+    const std::vector<int>& shape,
+    StreamOrDevice s) {
+  return a.shape() == shape ? a : reshape(a, shape, s);
+}
+
+// Contract two operands keeping the labels in keep
+Operand contract(Operand x, Operand y, LabelSet keep, StreamOrDevice s) {
+  LabelSet in_x = label_set(x.labels);
+  LabelSet in_y = label_set(y.labels);
+
+  // Labels of one operand which are not kept are summed right away. So are
+  // shared ones broadcast in one of the operands, since the sum of their
+  // products is then the product of their sums.
+  LabelSet broadcast = 0;
+  for (auto l : set_labels(in_x & in_y & ~keep)) {
+    if (x.a.shape(axis_of(x, l)) != y.a.shape(axis_of(y, l))) {
+      broadcast |= LabelSet(1) << l;
+    }
+  }
+  sum_labels(x, (in_y | keep) & ~broadcast, s);
+  sum_labels(y, (in_x | keep) & ~broadcast, s);
+  in_x = label_set(x.labels);
+  in_y = label_set(y.labels);
+
+  // Group the labels, keeping the order they have in the operands so the
+  // transposes are views matmul can use without copying
+  std::vector<int> batch, contracted, x_only, y_only;
+  for (auto l : x.labels) {
+    LabelSet bit = LabelSet(1) << l;
+    if (!(in_y & bit)) {
+      x_only.push_back(l);
+    } else if (keep & bit) {
+      batch.push_back(l);
+    } else {
+      contracted.push_back(l);
+    }
+  }
+  for (auto l : y.labels) {
+    if (!(in_x & (LabelSet(1) << l))) {
+      y_only.push_back(l);
+    }
+  }
+
+  // Matmul only supports floating point types
+  if (contracted.empty() ||
+      !issubdtype(result_type(x.a, y.a), floating)) {
+    // A broadcast multiply in the order of x followed by the rest of y
+    auto labels = x.labels;
+    labels.insert(labels.end(), y_only.begin(), y_only.end());
+    std::vector<int> y_order;
+    std::vector<int> y_shape;
+    for (auto l : labels) {
+      if (in_y & (LabelSet(1) << l)) {
+        y_order.push_back(l);
+        y_shape.push_back(y.a.shape(axis_of(y, l)));
+      } else {
+        y_shape.push_back(1);
+      }
+    }
+    std::vector<int> x_shape = x.a.shape();
+    x_shape.resize(labels.size(), 1);
+    auto out = multiply(
+        reshape_to(x.a, x_shape, s),
+        reshape_to(transpose_to(y, y_order, s), y_shape, s),
+        s);
+    Operand product{std::move(out), std::move(labels)};
+    sum_labels(product, ~label_set(contracted), s);
+    return product;
+  }
+
+  auto shape_of = [](const Operand& x, const std::vector<int>& labels) {
+    std::vector<int> shape;
+    for (auto l : labels) {
+      shape.push_back(x.a.shape(axis_of(x, l)));
+    }
+    return shape;
+  };
+  auto prod = [](const std::vector<int>& shape) {
+    int size = 1;
+    for (auto d : shape) {
+      size *= d;
+    }
+    return size;
+  };
+  auto x_batch = shape_of(x, batch);
+  auto y_batch = shape_of(y, batch);
+  auto m_shape = shape_of(x, x_only);
+  auto n_shape = shape_of(y, y_only);
+  int k = prod(shape_of(x, contracted));
+
+  std::vector<int> x_order = batch;
+  x_order.insert(x_order.end(), x_only.begin(), x_only.end());
+  x_order.insert(x_order.end(), contracted.begin(), contracted.end());
+  std::vector<int> y_order = batch;
+  y_order.insert(y_order.end(), contracted.begin(), contracted.end());
+  y_order.insert(y_order.end(), y_only.begin(), y_only.end());
+
+  auto x_shape = x_batch;
+  x_shape.push_back(prod(m_shape));
+  x_shape.push_back(k);
+  auto y_shape = y_batch;
+  y_shape.push_back(k);
+  y_shape.push_back(prod(n_shape));
+  auto result = matmul(
+      reshape_to(transpose_to(x, x_order, s), x_shape, s),
+      reshape_to(transpose_to(y, y_order, s), y_shape, s),
+      s);
+
+  std::vector<int> out_shape;
+  for (int i = 0; i < batch.size(); i++) {
+    out_shape.push_back(std::max(x_batch[i], y_batch[i]));
+  }
+  out_shape.insert(out_shape.end(), m_shape.begin(), m_shape.end());
+  out_shape.insert(out_shape.end(), n_shape.begin(), n_shape.end());
+  auto labels = batch;
+  labels.insert(labels.end(), x_only.begin(), x_only.end());
+  labels.insert(labels.end(), y_only.begin(), y_only.end());
+  return {reshape_to(result, out_shape, s), std::move(labels)};
+}
+
+} // namespace
+
+std::pair<std::vector<std::vector<int>>, std::string> einsum_path(
+    const std::string& subscripts,
+    const std::vector<array>& operands) {
+  auto plan = get_plan(subscripts, operands);
+  return {plan.path, plan.description};
+}
+
+array einsum(
+    const std::string& subscripts,
+    const std::vector<array>& operands,
+    StreamOrDevice s /* = {} */) {
+  if (operands.empty()) {
+    throw std::invalid_argument("[einsum] At least one operand is required.");
+  }
+  auto plan = get_plan(subscripts, operands);
+
+  std::vector<Operand> remaining;
+  for (int i = 0; i < operands.size(); i++) {
+    remaining.push_back({operands[i], plan.inputs[i]});
+    take_diagonals(remaining.back(), s);
+  }
+
+  // The labels needed by the output and the operands other than i and j
+  LabelSet output = label_set(plan.output);
+  auto needed = [&](int i, int j) {
+    LabelSet set = output;
+    for (int k = 0; k < remaining.size(); k++) {
+      if (k != i && k != j) {
+        set |= label_set(remaining[k].labels);
+      }
+    }
+    return set;
+  };
+
+  // Sum the labels only one operand has before contracting
+  for (int i = 0; i < remaining.size(); i++) {
+    sum_labels(remaining[i], needed(i, i), s);
+  }
+
+  for (auto& step : plan.path) {
+    int i = step[0];
+    int j = step[1];
+    auto keep = needed(i, j);
+    auto x = std::move(remaining[i]);
+    auto y = std::move(remaining[j]);
+    remaining.erase(remaining.begin() + j);
+    remaining.erase(remaining.begin() + i);
+    remaining.push_back(contract(std::move(x), std::move(y), keep, s));
+  }
+  auto& result = remaining[0];
+  return transpose_to(result, plan.output, s);
+}
+
+} // namespace mlx::core
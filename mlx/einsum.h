@@ -0,0 +1,47 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mlx/array.h"
+#include "mlx/device.h"
+#include "mlx/stream.h"
+#include "mlx/utils.h"
+
+namespace mlx::core {
+
+/**
+ * Compute the order in which einsum contracts the operands.
+ *
+ * Returns the path and a human readable description of it with the cost of
+ * each contraction. Each step of the path has the positions of the two
+ * operands contracted in the list of remaining operands. They are removed
+ * from the list and the result is appended to it.
+ */
+std::pair<std::vector<std::vector<int>>, std::string> einsum_path(
+    const std::string& subscripts,
+    const std::vector<array>& operands);
+
+/**
+ * Perform the Einstein summation convention on the operands.
+ *
+ * The subscripts label the axes of each operand with letters, e.g.
+ * "ij,jk->ik" for a matrix product. Repeated labels in one operand take a
+ * diagonal, "..." stands for broadcast axes and the output labels default to
+ * those which appear once, in alphabetical order.
+ *
+ * The operands are contracted two at a time in the order which needs the
+ * fewest operations, found exhaustively for up to eight operands and
+ * greedily for more. Each contraction is a (batched) matmul, or a broadcast
+ * multiply when nothing is summed. The order is cached per subscripts and
+ * operand shapes.
+ */
+array einsum(
+    const std::string& subscripts,
+    const std::vector<array>& operands,
+    StreamOrDevice s = {});
+
+} // namespace mlx::core
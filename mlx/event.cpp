@@ -0,0 +1,56 @@
+// Copyright © 2024 Apple Inc.
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "mlx/event_impl.h"
+
+namespace mlx::core::detail {
+
+namespace {
+
+struct EventCounter {
+  std::atomic<uint64_t> value{0};
+  // Signaling only takes the lock when a thread is waiting
+  std::atomic<int> waiters{0};
+  std::mutex mtx;
+  std::condition_variable cv;
+};
+
+} // namespace
+
+std::shared_ptr<void> new_cpu_event() {
+  auto dtor = [](void* ptr) { delete static_cast<EventCounter*>(ptr); };
+  return std::shared_ptr<void>(new EventCounter{}, dtor);
+}
+
+void cpu_event_wait(void* event, uint64_t value) {
+  auto ec = static_cast<EventCounter*>(event);
+  if (ec->value.load() >= value) {
+    return;
+  }
+  std::unique_lock<std::mutex> lk(ec->mtx);
+  ec->waiters++;
+  ec->cv.wait(lk, [ec, value] { return ec->value.load() >= value; });
+  ec->waiters--;
+}
+
+void cpu_event_signal(void* event, uint64_t value) {
+  auto ec = static_cast<EventCounter*>(event);
+  ec->value.store(value);
+  if (ec->waiters.load() > 0) {
+    // Taking the lock makes sure a waiter which saw the old value is
+    // already waiting on the condition variable
+    {
+      std::lock_guard<std::mutex> lk(ec->mtx);
+    }
+    ec->cv.notify_all();
+  }
+}
+
+bool cpu_event_signaled(void* event, uint64_t value) {
+  return static_cast<EventCounter*>(event)->value.load() >= value;
+}
+
+} // namespace mlx::core::detail
@@ -8,6 +8,8 @@
 
 namespace mlx::core {
 
+// Events of CPU streams are atomic counters which only block when the value
+// is not reached yet. Events of GPU streams are Metal shared events.
 class Event {
  public:
   Event() = default;
@@ -20,6 +22,9 @@ class Event {
   // Signal the event at its current value
   void signal();
 
+  // Check if the event was signaled at its current value without waiting
+  bool is_signaled() const;
+
   // Check if the event is valid
   bool valid() const {
     return event_ != nullptr;
@@ -0,0 +1,20 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <memory>
+
+namespace mlx::core::detail {
+
+// A counter for the events of CPU streams, shared by every backend
+std::shared_ptr<void> new_cpu_event();
+
+// Block until the counter reaches value. Only locks if it has not yet.
+void cpu_event_wait(void* event, uint64_t value);
+
+// Set the counter to value, waking the threads waiting for it if any
+void cpu_event_signal(void* event, uint64_t value);
+
+bool cpu_event_signaled(void* event, uint64_t value);
+
+} // namespace mlx::core::detail
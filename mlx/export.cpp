@@ -0,0 +1,569 @@
+// Copyright © 2024 Apple Inc.
+
+#include <sstream>
+#include <typeindex>
+#include <unordered_map>
+
+#include "mlx/allocator.h"
+#include "mlx/backend/metal/metal.h"
+#include "mlx/compile_impl.h"
+#include "mlx/export.h"
+#include "mlx/io/load.h"
+#include "mlx/ops.h"
+#include "mlx/primitives.h"
+#include "mlx/transforms_impl.h"
+
+namespace mlx::core {
+
+namespace {
+
+constexpr char magic[] = "MLXGRAPH";
+constexpr uint32_t version = 1;
+
+constexpr Dtype dtypes[] = {
+    bool_,
+    uint8,
+    uint16,
+    uint32,
+    uint64,
+    int8,
+    int16,
+    int32,
+    int64,
+    float16,
+    float32,
+    bfloat16,
+    complex64};
+
+///////////////////////////////////////////////////////////////////////////////
+// Reading and writing values
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void write(io::Writer& os, T v) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+void write(io::Writer& os, Dtype t) {
+  write(os, static_cast<uint8_t>(t.val));
+}
+
+void write(io::Writer& os, const std::vector<int>& v) {
+  write(os, static_cast<uint64_t>(v.size()));
+  os.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(int));
+}
+
+void write(io::Writer& os, const std::string& s) {
+  write(os, static_cast<uint64_t>(s.size()));
+  os.write(s.data(), s.size());
+}
+
+template <typename T>
+T read(io::Reader& is) {
+  T v;
+  is.read(reinterpret_cast<char*>(&v), sizeof(T));
+  if (!is.good()) {
+    throw std::runtime_error(
+        "[import_function] Unexpected end of " + is.label() + ".");
+  }
+  return v;
+}
+
+Dtype read_dtype(io::Reader& is) {
+  auto val = read<uint8_t>(is);
+  if (val >= std::size(dtypes)) {
+    throw std::runtime_error(
+        "[import_function] Invalid type in " + is.label() + ".");
+  }
+  return dtypes[val];
+}
+
+std::vector<int> read_shape(io::Reader& is) {
+  std::vector<int> v(read<uint64_t>(is));
+  is.read(reinterpret_cast<char*>(v.data()), v.size() * sizeof(int));
+  return v;
+}
+
+std::string read_string(io::Reader& is) {
+  std::string s(read<uint64_t>(is), '\0');
+  is.read(s.data(), s.size());
+  return s;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Primitives
+///////////////////////////////////////////////////////////////////////////////
+
+// The outputs of the primitive being read, some primitives are rebuilt
+// from them rather than from saved parameters
+struct NodeOutputs {
+  std::vector<Dtype> dtypes;
+  std::vector<std::vector<int>> shapes;
+};
+
+struct PrimitiveSerializer {
+  std::string name;
+  std::function<void(io::Writer&, const Primitive&)> write;
+  std::function<std::shared_ptr<Primitive>(
+      io::Reader&,
+      Stream,
+      const NodeOutputs&)>
+      read;
+};
+
+template <typename P>
+PrimitiveSerializer simple(std::string name) {
+  return {
+      std::move(name),
+      [](io::Writer&, const Primitive&) {},
+      [](io::Reader&, Stream s, const NodeOutputs&) {
+        return std::make_shared<P>(s);
+      }};
+}
+
+// Primitives rebuilt from the type or shape of their output
+template <typename P>
+PrimitiveSerializer from_dtype(std::string name) {
+  return {
+      std::move(name),
+      [](io::Writer&, const Primitive&) {},
+      [](io::Reader&, Stream s, const NodeOutputs& out) {
+        return std::make_shared<P>(s, out.dtypes[0]);
+      }};
+}
+
+template <typename P>
+PrimitiveSerializer from_shape(std::string name) {
+  return {
+      std::move(name),
+      [](io::Writer&, const Primitive&) {},
+      [](io::Reader&, Stream s, const NodeOutputs& out) {
+        return std::make_shared<P>(s, out.shapes[0]);
+      }};
+}
+
+// Primitives with a single int parameter, e.g. an axis
+template <typename P>
+PrimitiveSerializer int_state(std::string name) {
+  return {
+      std::move(name),
+      [](io::Writer& os, const Primitive& p) {
+        write(os, static_cast<int>(static_cast<const P&>(p).state()));
+      },
+      [](io::Reader& is, Stream s, const NodeOutputs&) {
+        auto v = read<int>(is);
+        using State = decltype(std::declval<P>().state());
+        return std::make_shared<P>(s, static_cast<State>(v));
+      }};
+}
+
+template <typename P>
+PrimitiveSerializer pair_state(std::string name) {
+  return {
+      std::move(name),
+      [](io::Writer& os, const Primitive& p) {
+        auto [a, b] = static_cast<const P&>(p).state();
+        write(os, static_cast<int>(a));
+        write(os, static_cast<int>(b));
+      },
+      [](io::Reader& is, Stream s, const NodeOutputs&) {
+        using State = decltype(std::declval<P>().state());
+        auto a = read<int>(is);
+        auto b = read<int>(is);
+        return std::make_shared<P>(
+            s,
+            static_cast<typename State::first_type>(a),
+            static_cast<typename State::second_type>(b));
+      }};
+}
+
+std::unordered_map<std::type_index, PrimitiveSerializer> make_serializers() {
+  std::vector<std::pair<std::type_index, PrimitiveSerializer>> entries = {
+      {typeid(Abs), simple<Abs>("Abs")},
+      {typeid(Add), simple<Add>("Add")},
+      {typeid(ArcCos), simple<ArcCos>("ArcCos")},
+      {typeid(ArcCosh), simple<ArcCosh>("ArcCosh")},
+      {typeid(ArcSin), simple<ArcSin>("ArcSin")},
+      {typeid(ArcSinh), simple<ArcSinh>("ArcSinh")},
+      {typeid(ArcTan), simple<ArcTan>("ArcTan")},
+      {typeid(ArcTan2), simple<ArcTan2>("ArcTan2")},
+      {typeid(ArcTanh), simple<ArcTanh>("ArcTanh")},
+      {typeid(Ceil), simple<Ceil>("Ceil")},
+      {typeid(Conjugate), simple<Conjugate>("Conjugate")},
+      {typeid(Copy), simple<Copy>("Copy")},
+      {typeid(Cos), simple<Cos>("Cos")},
+      {typeid(Cosh), simple<Cosh>("Cosh")},
+      {typeid(Divide), simple<Divide>("Divide")},
+      {typeid(DivMod), simple<DivMod>("DivMod")},
+      {typeid(Erf), simple<Erf>("Erf")},
+      {typeid(ErfInv), simple<ErfInv>("ErfInv")},
+      {typeid(Exp), simple<Exp>("Exp")},
+      {typeid(Expm1), simple<Expm1>("Expm1")},
+      {typeid(Floor), simple<Floor>("Floor")},
+      {typeid(Greater), simple<Greater>("Greater")},
+      {typeid(GreaterEqual), simple<GreaterEqual>("GreaterEqual")},
+      {typeid(Less), simple<Less>("Less")},
+      {typeid(LessEqual), simple<LessEqual>("LessEqual")},
+      {typeid(Log1p), simple<Log1p>("Log1p")},
+      {typeid(LogAddExp), simple<LogAddExp>("LogAddExp")},
+      {typeid(LogicalAnd), simple<LogicalAnd>("LogicalAnd")},
+      {typeid(LogicalNot), simple<LogicalNot>("LogicalNot")},
+      {typeid(LogicalOr), simple<LogicalOr>("LogicalOr")},
+      {typeid(LogSumExp), simple<LogSumExp>("LogSumExp")},
+      {typeid(Matmul), simple<Matmul>("Matmul")},
+      {typeid(MatmulVJP), simple<MatmulVJP>("MatmulVJP")},
+      {typeid(Maximum), simple<Maximum>("Maximum")},
+      {typeid(Minimum), simple<Minimum>("Minimum")},
+      {typeid(Multiply), simple<Multiply>("Multiply")},
+      {typeid(Negative), simple<Negative>("Negative")},
+      {typeid(NotEqual), simple<NotEqual>("NotEqual")},
+      {typeid(Power), simple<Power>("Power")},
+      {typeid(Remainder), simple<Remainder>("Remainder")},
+      {typeid(Round), simple<Round>("Round")},
+      {typeid(Select), simple<Select>("Select")},
+      {typeid(Sigmoid), simple<Sigmoid>("Sigmoid")},
+      {typeid(Sign), simple<Sign>("Sign")},
+      {typeid(Sin), simple<Sin>("Sin")},
+      {typeid(Sinh), simple<Sinh>("Sinh")},
+      {typeid(Square), simple<Square>("Square")},
+      {typeid(StopGradient), simple<StopGradient>("StopGradient")},
+      {typeid(Subtract), simple<Subtract>("Subtract")},
+      {typeid(Tan), simple<Tan>("Tan")},
+      {typeid(Tanh), simple<Tanh>("Tanh")},
+      {typeid(AsType), from_dtype<AsType>("AsType")},
+      {typeid(View), from_dtype<View>("View")},
+      {typeid(Broadcast), from_shape<Broadcast>("Broadcast")},
+      {typeid(Reshape), from_shape<Reshape>("Reshape")},
+      {typeid(ArgSort), int_state<ArgSort>("ArgSort")},
+      {typeid(BitwiseBinary), int_state<BitwiseBinary>("BitwiseBinary")},
+      {typeid(Concatenate), int_state<Concatenate>("Concatenate")},
+      {typeid(Equal), int_state<Equal>("Equal")},
+      {typeid(Log), int_state<Log>("Log")},
+      {typeid(Softmax), int_state<Softmax>("Softmax")},
+      {typeid(Sort), int_state<Sort>("Sort")},
+      {typeid(Sqrt), int_state<Sqrt>("Sqrt")},
+      {typeid(ArgPartition), pair_state<ArgPartition>("ArgPartition")},
+      {typeid(ArgReduce), pair_state<ArgReduce>("ArgReduce")},
+      {typeid(CacheAppend), pair_state<CacheAppend>("CacheAppend")},
+      {typeid(Partition), pair_state<Partition>("Partition")},
+      {typeid(AddMM),
+       {"AddMM",
+        [](io::Writer& os, const Primitive& p) {
+          auto [alpha, beta] = static_cast<const AddMM&>(p).state();
+          write(os, alpha);
+          write(os, beta);
+        },
+        [](io::Reader& is, Stream s, const NodeOutputs&) {
+          auto alpha = read<float>(is);
+          auto beta = read<float>(is);
+          return std::make_shared<AddMM>(s, alpha, beta);
+        }}},
+      {typeid(Reduce),
+       {"Reduce",
+        [](io::Writer& os, const Primitive& p) {
+          auto& r = static_cast<const Reduce&>(p);
+          write(os, static_cast<int>(r.reduce_type()));
+          write(os, r.axes());
+        },
+        [](io::Reader& is, Stream s, const NodeOutputs&) {
+          auto type = static_cast<Reduce::ReduceType>(read<int>(is));
+          return std::make_shared<Reduce>(s, type, read_shape(is));
+        }}},
+      {typeid(Slice),
+       {"Slice",
+        [](io::Writer& os, const Primitive& p) {
+          auto [start, end, strides] = static_cast<const Slice&>(p).state();
+          write(os, start);
+          write(os, end);
+          write(os, strides);
+        },
+        [](io::Reader& is, Stream s, const NodeOutputs&) {
+          auto start = read_shape(is);
+          auto end = read_shape(is);
+          auto strides = read_shape(is);
+          return std::make_shared<Slice>(s, start, end, strides);
+        }}},
+      {typeid(Split),
+       {"Split",
+        [](io::Writer& os, const Primitive& p) {
+          auto [indices, axis] = static_cast<const Split&>(p).state();
+          write(os, indices);
+          write(os, axis);
+        },
+        [](io::Reader& is, Stream s, const NodeOutputs&) {
+          auto indices = read_shape(is);
+          return std::make_shared<Split>(s, indices, read<int>(is));
+        }}},
+      {typeid(Transpose),
+       {"Transpose",
+        [](io::Writer& os, const Primitive& p) {
+          write(os, static_cast<const Transpose&>(p).axes());
+        },
+        [](io::Reader& is, Stream s, const NodeOutputs&) {
+          return std::make_shared<Transpose>(s, read_shape(is));
+        }}},
+  };
+  return {entries.begin(), entries.end()};
+}
+
+const std::unordered_map<std::type_index, PrimitiveSerializer>&
+serializers() {
+  static auto serializers_ = make_serializers();
+  return serializers_;
+}
+
+const PrimitiveSerializer& serializer(const std::string& name) {
+  static auto by_name = []() {
+    std::unordered_map<std::string, const PrimitiveSerializer*> by_name;
+    for (auto& [_, s] : serializers()) {
+      by_name.emplace(s.name, &s);
+    }
+    return by_name;
+  }();
+  auto it = by_name.find(name);
+  if (it == by_name.end()) {
+    throw std::runtime_error(
+        "[import_function] Unknown primitive " + name + " in the graph.");
+  }
+  return *it->second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Graphs
+///////////////////////////////////////////////////////////////////////////////
+
+// Values are numbered in order: the inputs, then the constants and then the
+// outputs of each node
+enum class NodeType : uint8_t { input, constant, primitive };
+
+struct ImportedNode {
+  std::shared_ptr<Primitive> primitive;
+  std::vector<int> inputs;
+  NodeOutputs outputs;
+};
+
+struct ImportedGraph {
+  std::vector<std::pair<Dtype, std::vector<int>>> inputs;
+  std::vector<array> constants;
+  std::vector<ImportedNode> nodes;
+  std::vector<int> outputs;
+  bool shapeless;
+
+  ~ImportedGraph() {
+    detail::compile_erase(reinterpret_cast<std::uintptr_t>(this));
+  }
+
+  std::vector<array> operator()(const std::vector<array>& args) const {
+    if (args.size() != inputs.size()) {
+      std::ostringstream msg;
+      msg << "[import_function] Expected " << inputs.size()
+          << " inputs but received " << args.size() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    std::vector<array> values;
+    for (int i = 0; i < args.size(); ++i) {
+      auto& [dtype, shape] = inputs[i];
+      bool shape_matches = shapeless ? args[i].ndim() == shape.size()
+                                     : args[i].shape() == shape;
+      if (args[i].dtype() != dtype || !shape_matches) {
+        std::ostringstream msg;
+        msg << "[import_function] Input " << i << " with shape "
+            << args[i].shape() << " and type " << args[i].dtype()
+            << " does not match the exported shape " << shape << " and type "
+            << dtype << ".";
+        throw std::invalid_argument(msg.str());
+      }
+      values.push_back(args[i]);
+    }
+    values.insert(values.end(), constants.begin(), constants.end());
+    for (auto& node : nodes) {
+      std::vector<array> node_inputs;
+      for (auto i : node.inputs) {
+        node_inputs.push_back(values[i]);
+      }
+      auto shapes = shapeless ? node.primitive->output_shapes(node_inputs)
+                              : node.outputs.shapes;
+      if (shapes.size() == 1) {
+        values.emplace_back(
+            std::move(shapes[0]),
+            node.outputs.dtypes[0],
+            node.primitive,
+            std::move(node_inputs));
+      } else {
+        auto outs = array::make_arrays(
+            std::move(shapes),
+            node.outputs.dtypes,
+            node.primitive,
+            node_inputs);
+        values.insert(values.end(), outs.begin(), outs.end());
+      }
+    }
+    std::vector<array> outs;
+    for (auto i : outputs) {
+      outs.push_back(values[i]);
+    }
+    return outs;
+  }
+};
+
+} // namespace
+
+void export_function(
+    const std::string& file,
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    const std::vector<array>& example_inputs,
+    bool shapeless /* = false */) {
+  auto [inputs, outputs] = detail::compile_trace(fun, example_inputs);
+  auto [tape, parents_map] = detail::compile_dfs(inputs, outputs);
+  detail::compile_simplify(tape, parents_map, outputs, shapeless);
+
+  // Number the values
+  std::unordered_map<std::uintptr_t, int> index;
+  for (auto& in : inputs) {
+    index.emplace(in.id(), index.size());
+  }
+  std::vector<array> constants;
+  for (auto& a : tape) {
+    if (!a.has_primitive() && index.find(a.id()) == index.end()) {
+      index.emplace(a.id(), index.size());
+      constants.push_back(a);
+    }
+  }
+  std::vector<array> nodes;
+  for (auto& a : tape) {
+    if (!a.has_primitive()) {
+      continue;
+    }
+    if (serializers().find(typeid(a.primitive())) == serializers().end()) {
+      std::ostringstream msg;
+      msg << "[export_function] Cannot export primitive ";
+      a.primitive().print(msg);
+      msg << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    for (auto& o : a.outputs()) {
+      index.emplace(o.id(), index.size());
+    }
+    nodes.push_back(a);
+  }
+
+  auto os = io::FileWriter(file);
+  if (!os.is_open()) {
+    throw std::runtime_error("[export_function] Failed to open " + file);
+  }
+  os.write(magic, sizeof(magic) - 1);
+  write(os, version);
+  write(os, static_cast<uint8_t>(shapeless));
+
+  write(os, static_cast<uint64_t>(inputs.size()));
+  for (auto& in : inputs) {
+    write(os, in.dtype());
+    write(os, in.shape());
+  }
+
+  write(os, static_cast<uint64_t>(constants.size()));
+  for (auto c : constants) {
+    if (!c.flags().row_contiguous) {
+      c = reshape(flatten(c), c.shape());
+    }
+    c.eval();
+    write(os, c.dtype());
+    write(os, c.shape());
+    os.write(c.data<char>(), c.nbytes());
+  }
+
+  write(os, static_cast<uint64_t>(nodes.size()));
+  for (auto& a : nodes) {
+    auto& p = a.primitive();
+    auto& s = serializers().at(typeid(p));
+    write(os, s.name);
+    write(os, static_cast<uint8_t>(p.device().type));
+    auto node_outputs = a.outputs();
+    write(os, static_cast<uint64_t>(node_outputs.size()));
+    for (auto& o : node_outputs) {
+      write(os, o.dtype());
+      write(os, o.shape());
+    }
+    std::vector<int> node_inputs;
+    for (auto& in : a.inputs()) {
+      node_inputs.push_back(index.at(in.id()));
+    }
+    write(os, node_inputs);
+    s.write(os, p);
+  }
+
+  std::vector<int> output_ids;
+  for (auto& o : outputs) {
+    output_ids.push_back(index.at(o.id()));
+  }
+  write(os, output_ids);
+}
+
+std::function<std::vector<array>(const std::vector<array>&)> import_function(
+    const std::string& file) {
+  auto is = io::FileReader(file);
+  if (!is.is_open()) {
+    throw std::runtime_error("[import_function] Failed to open " + file);
+  }
+  char header[sizeof(magic) - 1];
+  is.read(header, sizeof(header));
+  if (!is.good() || std::string(header, sizeof(header)) != magic ||
+      read<uint32_t>(is) != version) {
+    throw std::runtime_error(
+        "[import_function] " + file + " is not an exported function.");
+  }
+
+  auto graph = std::make_shared<ImportedGraph>();
+  graph->shapeless = read<uint8_t>(is);
+
+  auto n_inputs = read<uint64_t>(is);
+  for (int i = 0; i < n_inputs; ++i) {
+    auto dtype = read_dtype(is);
+    graph->inputs.emplace_back(dtype, read_shape(is));
+  }
+
+  auto n_constants = read<uint64_t>(is);
+  for (int i = 0; i < n_constants; ++i) {
+    auto dtype = read_dtype(is);
+    auto shape = read_shape(is);
+    size_t nbytes = size_of(dtype);
+    for (auto s : shape) {
+      nbytes *= s;
+    }
+    array c(allocator::malloc_or_wait(nbytes), std::move(shape), dtype);
+    is.read(c.data<char>(), c.nbytes());
+    graph->constants.push_back(std::move(c));
+  }
+
+  auto n_nodes = read<uint64_t>(is);
+  for (int i = 0; i < n_nodes; ++i) {
+    auto& s = serializer(read_string(is));
+    auto device_type = static_cast<Device::DeviceType>(read<uint8_t>(is));
+    Device device(device_type);
+    if (device_type == Device::gpu && !metal::is_available()) {
+      device = Device::cpu;
+    }
+    ImportedNode node;
+    auto n_outputs = read<uint64_t>(is);
+    for (int j = 0; j < n_outputs; ++j) {
+      node.outputs.dtypes.push_back(read_dtype(is));
+      node.outputs.shapes.push_back(read_shape(is));
+    }
+    node.inputs = read_shape(is);
+    node.primitive = s.read(is, default_stream(device), node.outputs);
+    graph->nodes.push_back(std::move(node));
+  }
+  graph->outputs = read_shape(is);
+
+  auto fun_id = reinterpret_cast<std::uintptr_t>(graph.get());
+  auto shapeless = graph->shapeless;
+  return detail::compile(
+      [graph = std::move(graph)](const std::vector<array>& inputs) {
+        return (*graph)(inputs);
+      },
+      fun_id,
+      shapeless);
+}
+
+} // namespace mlx::core
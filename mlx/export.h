@@ -0,0 +1,33 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+/** Export the graph of a function to a file.
+ *
+ * The function is traced on the example inputs and its simplified graph,
+ * including the values of the constants it captures, is written to the file.
+ * Only graphs made of the common elementwise, reduction, shape, sort and
+ * matmul primitives can be exported, others throw. With ``shapeless`` the
+ * imported function accepts inputs of any shape with the same number of
+ * dimensions, see compile.
+ */
+void export_function(
+    const std::string& file,
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    const std::vector<array>& example_inputs,
+    bool shapeless = false);
+
+/** Import a function exported with export_function.
+ *
+ * The returned function rebuilds the saved graph on its inputs without
+ * tracing the original function again and is compiled, so its kernels are
+ * fused and found in the kernel caches of earlier processes.
+ */
+std::function<std::vector<array>(const std::vector<array>&)> import_function(
+    const std::string& file);
+
+} // namespace mlx::core
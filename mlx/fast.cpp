@@ -1,8 +1,15 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
 #include <numeric>
+#include <regex>
+#include <sstream>
 
+#include "mlx/backend/common/compiled.h"
 #include "mlx/fast.h"
 #include "mlx/fast_primitives.h"
 #include "mlx/ops.h"
@@ -97,6 +104,45 @@ array rms_norm(
   return fallback({x, weight})[0];
 }
 
+std::pair<std::vector<array>, std::vector<int>> RMSNorm::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  if (axes[1] >= 0) {
+    return Custom::vmap(inputs, axes);
+  }
+  // Any axis but the normalized one is a batch axis of the kernel
+  auto x = inputs[0];
+  int ax = axes[0];
+  if (ax == x.ndim() - 1) {
+    x = moveaxis(x, ax, 0, stream());
+    ax = 0;
+  }
+  return {{rms_norm(x, inputs[1], eps_, stream())}, {ax}};
+}
+
+std::vector<array> RMSNorm::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  // The Jacobian wrt x is symmetric up to the scaling by the weight so the
+  // fused vjp with a unit weight applies it
+  auto s = stream();
+  auto& x = primals[0];
+  auto& w = primals[1];
+  auto ones = full(w.shape(), array(1, w.dtype()), s);
+  std::optional<array> out;
+  for (int i = 0; i < argnums.size(); ++i) {
+    auto t = astype(tangents[i], x.dtype(), s);
+    if (argnums[i] == 0) {
+      t = multiply(w, vjp({x, ones}, {t}, {0}, {})[0], s);
+    } else {
+      t = multiply(t, rms_norm(x, ones, eps_, s), s);
+    }
+    out = out ? add(*out, t, s) : t;
+  }
+  return {*out};
+}
+
 std::vector<array> RMSNorm::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
@@ -160,6 +206,87 @@ bool RMSNormVJP::is_equivalent(const Primitive& other) const {
   return eps_ == a_other.eps_;
 }
 
+std::pair<array, array> rms_norm_residual(
+    const array& x,
+    const array& residual,
+    const array& weight,
+    float eps,
+    StreamOrDevice s_ /* = {} */) {
+  if (x.ndim() == 0) {
+    std::ostringstream msg;
+    msg << "[rms_norm_residual] Input must have at least 1 dimension but got "
+        << "input with 0 dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (x.shape() != residual.shape()) {
+    std::ostringstream msg;
+    msg << "[rms_norm_residual] The input and the residual must have the "
+        << "same shape but got " << x.shape() << " and " << residual.shape()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (weight.ndim() != 1) {
+    std::ostringstream msg;
+    msg << "[rms_norm_residual] weight must have 1 dimension but has "
+        << weight.ndim() << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  auto out_type = result_type(x, residual, weight);
+  if (!issubdtype(out_type, floating)) {
+    std::ostringstream msg;
+    msg << "[rms_norm_residual] Received unsupported type " << out_type
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto fallback = [eps, s](const std::vector<array>& inputs) {
+    auto h = add(inputs[0], inputs[1], s);
+    return std::vector<array>{rms_norm(h, inputs[2], eps, s), h};
+  };
+  std::vector<array> inputs = {
+      astype(x, out_type, s),
+      astype(residual, out_type, s),
+      astype(weight, out_type, s)};
+  if (s.device == Device::gpu) {
+    auto outs = array::make_arrays(
+        {x.shape(), x.shape()},
+        {out_type, out_type},
+        std::make_shared<RMSNormResidual>(s, fallback, eps),
+        inputs);
+    return {outs[0], outs[1]};
+  }
+  auto outs = fallback(inputs);
+  return {outs[0], outs[1]};
+}
+
+std::vector<array> RMSNormResidual::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // Differentiate the normalization of the sum, which x and the residual
+  // share, with the fused rms_norm vjp
+  auto s = stream();
+  auto norm = [eps = eps_, s](const std::vector<array>& inputs) {
+    return std::vector<array>{rms_norm(inputs[0], inputs[1], eps, s)};
+  };
+  auto [_, vjps] =
+      mlx::core::vjp(norm, {outputs[1], primals[2]}, {cotangents[0]});
+  auto gh = add(vjps[0], cotangents[1], s);
+
+  std::vector<array> returned_vjps;
+  for (auto arg : argnums) {
+    returned_vjps.push_back(arg == 2 ? vjps[1] : gh);
+  }
+  return returned_vjps;
+}
+
+bool RMSNormResidual::is_equivalent(const Primitive& other) const {
+  const RMSNormResidual& a_other = static_cast<const RMSNormResidual&>(other);
+  return eps_ == a_other.eps_;
+}
+
 array layer_norm(
     const array& x,
     const std::optional<array>& weight,
@@ -208,7 +335,8 @@ array layer_norm(
     auto x2 = mean(square(x, s), /* axis= */ -1, /* keepdims= */ true, s);
     auto v = subtract(x2, mu2, s);
 
-    x = multiply(subtract(x, mu, s), rsqrt(add(v, array(eps, float32), s), s));
+    x = multiply(
+        subtract(x, mu, s), rsqrt(add(v, array(eps, float32), s), s), s);
     x = astype(x, out_type, s);
 
     // If the LN is affine then transform x according to the weight and bias
@@ -237,6 +365,53 @@ array layer_norm(
   return fallback({x, passed_weight, passed_bias})[0];
 }
 
+std::pair<std::vector<array>, std::vector<int>> LayerNorm::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  if (axes[1] >= 0 || axes[2] >= 0) {
+    return Custom::vmap(inputs, axes);
+  }
+  auto x = inputs[0];
+  int ax = axes[0];
+  if (ax == x.ndim() - 1) {
+    x = moveaxis(x, ax, 0, stream());
+    ax = 0;
+  }
+  // A missing weight or bias is passed as a scalar
+  auto optional = [](const array& a) {
+    return a.ndim() == 0 ? std::nullopt : std::optional<array>(a);
+  };
+  return {
+      {layer_norm(x, optional(inputs[1]), optional(inputs[2]), eps_, stream())},
+      {ax}};
+}
+
+std::vector<array> LayerNorm::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  // As for RMSNorm the fused vjp with a unit weight applies the Jacobian wrt
+  // x before the scaling by the weight
+  auto s = stream();
+  auto& x = primals[0];
+  auto& w = primals[1];
+  std::optional<array> out;
+  for (int i = 0; i < argnums.size(); ++i) {
+    auto t = astype(tangents[i], x.dtype(), s);
+    if (argnums[i] == 0) {
+      auto ones = full({x.shape(-1)}, array(1, x.dtype()), s);
+      t = vjp({x, ones, primals[2]}, {t}, {0}, {})[0];
+      t = multiply(w, t, s);
+    } else if (argnums[i] == 1) {
+      t = multiply(t, layer_norm(x, std::nullopt, std::nullopt, eps_, s), s);
+    } else {
+      t = broadcast_to(t, x.shape(), s);
+    }
+    out = out ? add(*out, t, s) : t;
+  }
+  return {*out};
+}
+
 std::vector<array> LayerNorm::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
@@ -321,36 +496,289 @@ bool LayerNormVJP::is_equivalent(const Primitive& other) const {
   return eps_ == a_other.eps_;
 }
 
+namespace {
+
+std::function<std::vector<array>(std::vector<array>)> group_norm_fallback(
+    int num_groups,
+    float eps,
+    bool pytorch_compatible,
+    Dtype out_type,
+    Stream s) {
+  return [num_groups, eps, pytorch_compatible, out_type, s](
+             const std::vector<array>& inputs) {
+    auto x = astype(inputs[0], float32, s);
+    auto& w = inputs[1];
+    auto& b = inputs[2];
+    auto shape = x.shape();
+    int batch = shape[0];
+    int dims = shape.back();
+
+    // Split into groups. The PyTorch grouping puts consecutive channels in
+    // the same group while the default one interleaves them.
+    std::vector<int> axes;
+    if (pytorch_compatible) {
+      x = reshape(x, {batch, -1, num_groups, dims / num_groups}, s);
+      axes = {1, 3};
+    } else {
+      x = reshape(x, {batch, -1, num_groups}, s);
+      axes = {1};
+    }
+    auto mu = mean(x, axes, /* keepdims= */ true, s);
+    auto v = var(x, axes, /* keepdims= */ true, /* ddof= */ 0, s);
+    x = multiply(
+        subtract(x, mu, s), rsqrt(add(v, array(eps, float32), s), s), s);
+    x = astype(reshape(x, shape, s), out_type, s);
+
+    if (w.ndim() != 0) {
+      x = multiply(x, w, s);
+    }
+    if (b.ndim() != 0) {
+      x = add(x, b, s);
+    }
+    return std::vector<array>{x};
+  };
+}
+
+} // namespace
+
+array group_norm(
+    const array& x,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    int num_groups,
+    float eps,
+    bool pytorch_compatible /* = false */,
+    StreamOrDevice s_ /* = {} */) {
+  if (x.ndim() < 2) {
+    std::ostringstream msg;
+    msg << "[group_norm] Input must have at least 2 dimensions but got input "
+        << "with " << x.ndim() << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (num_groups <= 0 || x.shape().back() % num_groups != 0) {
+    std::ostringstream msg;
+    msg << "[group_norm] The number of groups " << num_groups
+        << " must divide the last dimension " << x.shape().back() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (weight.has_value() && (*weight).ndim() != 1) {
+    std::ostringstream msg;
+    msg << "[group_norm] weight must have 1 dimension but has "
+        << (*weight).ndim() << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (bias.has_value() && (*bias).ndim() != 1) {
+    std::ostringstream msg;
+    msg << "[group_norm] bias must have 1 dimension but has " << (*bias).ndim()
+        << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto out_type = (weight.has_value())
+      ? ((bias.has_value()) ? result_type(x, *weight, *bias)
+                            : result_type(x, *weight))
+      : x.dtype();
+  if (!issubdtype(out_type, floating)) {
+    std::ostringstream msg;
+    msg << "[group_norm] Received unsupported type " << out_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto fallback =
+      group_norm_fallback(num_groups, eps, pytorch_compatible, out_type, s);
+
+  auto passed_weight =
+      astype((weight.has_value()) ? *weight : array(1, out_type), out_type);
+  auto passed_bias =
+      astype((bias.has_value()) ? *bias : array(0, out_type), out_type);
+
+  if (s.device == Device::gpu && x.size() > 0) {
+    return array(
+        x.shape(),
+        out_type,
+        std::make_shared<GroupNorm>(
+            s, fallback, num_groups, eps, pytorch_compatible),
+        {astype(x, out_type, s), passed_weight, passed_bias});
+  }
+  return fallback({x, passed_weight, passed_bias})[0];
+}
+
+array batch_norm(
+    const array& x,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    float eps,
+    StreamOrDevice s /* = {} */) {
+  if (x.ndim() < 2) {
+    std::ostringstream msg;
+    msg << "[batch_norm] Input must have at least 2 dimensions but got input "
+        << "with " << x.ndim() << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Batch norm is a group norm of a single sample with one channel per group
+  int dims = x.shape().back();
+  auto out = group_norm(
+      reshape(x, {1, -1, dims}, s),
+      weight,
+      bias,
+      dims,
+      eps,
+      /* pytorch_compatible= */ true,
+      s);
+  return reshape(out, x.shape(), s);
+}
+
+std::vector<array> GroupNorm::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  assert(primals.size() == 3);
+  assert(outputs.size() == 1);
+  assert(cotangents.size() == 1);
+
+  auto s = stream();
+  auto forward = group_norm_fallback(
+      num_groups_, eps_, pytorch_compatible_, primals[0].dtype(), s);
+  auto fallback = [forward](const std::vector<array>& inputs) {
+    auto [_, vjps] = mlx::core::vjp(
+        forward, {inputs[0], inputs[1], inputs[2]}, {inputs[3]});
+    return vjps;
+  };
+
+  auto vjps = array::make_arrays(
+      {primals[0].shape(), primals[1].shape(), primals[2].shape()},
+      {primals[0].dtype(), primals[1].dtype(), primals[2].dtype()},
+      std::make_shared<GroupNormVJP>(
+          s, fallback, num_groups_, eps_, pytorch_compatible_),
+      {primals[0], primals[1], primals[2], cotangents[0]});
+
+  std::vector<array> returned_vjps;
+  for (auto& arg : argnums) {
+    returned_vjps.push_back(std::move(vjps[arg]));
+  }
+
+  return returned_vjps;
+}
+
+bool GroupNorm::is_equivalent(const Primitive& other) const {
+  const GroupNorm& a_other = static_cast<const GroupNorm&>(other);
+  return num_groups_ == a_other.num_groups_ && eps_ == a_other.eps_ &&
+      pytorch_compatible_ == a_other.pytorch_compatible_;
+}
+
+bool GroupNormVJP::is_equivalent(const Primitive& other) const {
+  const GroupNormVJP& a_other = static_cast<const GroupNormVJP&>(other);
+  return num_groups_ == a_other.num_groups_ && eps_ == a_other.eps_ &&
+      pytorch_compatible_ == a_other.pytorch_compatible_;
+}
+
+std::pair<array, array> mean_var(
+    const array& x,
+    const std::vector<int>& axes,
+    bool keepdims /* = false */,
+    int ddof /* = 0 */,
+    StreamOrDevice s_ /* = {} */) {
+  std::vector<int> sorted_axes;
+  for (auto ax : axes) {
+    int ax_ = ax < 0 ? ax + x.ndim() : ax;
+    if (ax_ < 0 || ax_ >= x.ndim()) {
+      std::ostringstream msg;
+      msg << "[mean_var] Invalid axis " << ax << " for array with "
+          << x.ndim() << " dimensions.";
+      throw std::invalid_argument(msg.str());
+    }
+    sorted_axes.push_back(ax_);
+  }
+  std::sort(sorted_axes.begin(), sorted_axes.end());
+  if (std::adjacent_find(sorted_axes.begin(), sorted_axes.end()) !=
+      sorted_axes.end()) {
+    throw std::invalid_argument("[mean_var] Received duplicate axes.");
+  }
+
+  auto s = to_stream(s_);
+  auto fallback = [sorted_axes, keepdims, ddof, s](
+                      const std::vector<array>& inputs) {
+    return std::vector<array>{
+        mean(inputs[0], sorted_axes, keepdims, s),
+        var(inputs[0], sorted_axes, keepdims, ddof, s)};
+  };
+
+  if (s.device != Device::gpu || issubdtype(x.dtype(), complexfloating) ||
+      x.size() == 0) {
+    auto out = fallback({x});
+    return {out[0], out[1]};
+  }
+
+  auto out_type = issubdtype(x.dtype(), floating) ? x.dtype() : float32;
+  std::vector<int> out_shape;
+  for (int i = 0, j = 0; i < x.ndim(); i++) {
+    if (j < sorted_axes.size() && sorted_axes[j] == i) {
+      j++;
+      if (keepdims) {
+        out_shape.push_back(1);
+      }
+    } else {
+      out_shape.push_back(x.shape(i));
+    }
+  }
+  auto out = array::make_arrays(
+      {out_shape, out_shape},
+      {out_type, out_type},
+      std::make_shared<MeanVar>(s, fallback, sorted_axes, keepdims, ddof),
+      {astype(x, out_type, s)});
+  return {out[0], out[1]};
+}
+
+bool MeanVar::is_equivalent(const Primitive& other) const {
+  const MeanVar& a_other = static_cast<const MeanVar&>(other);
+  return axes_ == a_other.axes_ && keepdims_ == a_other.keepdims_ &&
+      ddof_ == a_other.ddof_;
+}
+
 array rope(
     const array& x,
     int dims,
     bool traditional,
     float base,
     float scale,
-    int offset,
+    const array& offset,
+    const std::optional<array>& freqs,
     bool forward,
     StreamOrDevice s) {
-  if (x.ndim() < 3) {
-    std::ostringstream msg;
-    msg << "[rope] Input must have at least 3 dimensions but got input with "
-        << x.ndim() << " dimensions.";
-    throw std::invalid_argument(msg.str());
-  }
-
-  auto fallback = [dims, traditional, base, scale, offset, forward, s](
+  auto fallback = [dims, traditional, base, scale, forward, s](
                       const std::vector<array>& inputs) {
     auto& shape = inputs[0].shape();
     int ndim = shape.size();
     auto x = reshape(inputs[0], {-1, shape[ndim - 2], shape[ndim - 1]}, s);
     auto t = x.dtype();
-    auto N = x.shape(1) + offset;
-    // Compute sines and cosines
+    // Compute sines and cosines with a row of positions per offset
     auto half_dims = dims / 2;
-    auto positions = multiply(arange(offset, N, t, s), array(scale, t), s);
-    auto freqs = negative(arange(0, half_dims, t, s), s);
-    freqs = exp(multiply(freqs, array(std::log(base) / half_dims, t), s), s);
-    auto theta =
-        multiply(expand_dims(positions, 1, s), expand_dims(freqs, 0, s), s);
+    auto positions = add(
+        reshape(astype(inputs[1], t, s), {-1, 1}, s),
+        arange(0, x.shape(1), t, s),
+        s);
+    positions = multiply(positions, array(scale, t), s);
+    auto inv_freqs = (inputs.size() == 3)
+        ? reciprocal(astype(inputs[2], t, s), s)
+        : exp(multiply(
+                  arange(0, half_dims, t, s),
+                  array(-std::log(base) / half_dims, t),
+                  s),
+              s);
+    auto theta = multiply(
+        expand_dims(positions, 2, s), reshape(inv_freqs, {1, 1, -1}, s), s);
+    // Each offset applies to a contiguous block of the flattened batch
+    int n_offsets = theta.shape(0);
+    if (n_offsets > 1) {
+      theta = broadcast_to(
+          expand_dims(theta, 1, s),
+          {n_offsets, x.shape(0) / n_offsets, x.shape(1), half_dims},
+          s);
+      theta = reshape(theta, {-1, x.shape(1), half_dims}, s);
+    }
     auto coss = cos(theta, s);
     auto sins = sin(theta, s);
 
@@ -402,68 +830,549 @@ array rope(
     }
   };
   auto stream = to_stream(s);
+  std::vector<array> inputs = {x, offset};
+  if (freqs) {
+    inputs.push_back(*freqs);
+  }
   if (stream.device == Device::gpu) {
     return array(
         x.shape(),
         x.dtype(),
         std::make_shared<RoPE>(
-            stream, fallback, dims, traditional, base, scale, offset, forward),
-        {x});
+            stream, fallback, dims, traditional, base, scale, forward),
+        std::move(inputs));
   }
-  return fallback({x})[0];
+  return fallback(inputs)[0];
 }
 
 array rope(
     const array& x,
     int dims,
     bool traditional,
-    float base,
+    std::optional<float> base,
     float scale,
-    int offset,
+    const array& offset,
+    const std::optional<array>& freqs /* = std::nullopt */,
     StreamOrDevice s /* = {} */) {
-  return rope(x, dims, traditional, base, scale, offset, true, s);
+  if (x.ndim() < 3) {
+    std::ostringstream msg;
+    msg << "[rope] Input must have at least 3 dimensions but got input with "
+        << x.ndim() << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(offset.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[rope] The offset must be an integer array but got "
+        << offset.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (offset.ndim() > 1 ||
+      (offset.ndim() == 1 && offset.size() != x.shape(0))) {
+    std::ostringstream msg;
+    msg << "[rope] The offset must be a scalar or have one entry per element "
+        << "of the first axis " << x.shape(0) << " but got shape "
+        << offset.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (base.has_value() == freqs.has_value()) {
+    throw std::invalid_argument(
+        "[rope] Exactly one of the base or the frequencies must be given.");
+  }
+  if (freqs && (freqs->ndim() != 1 || freqs->size() != dims / 2)) {
+    std::ostringstream msg;
+    msg << "[rope] The frequencies must have shape (" << dims / 2
+        << ",) but got shape " << freqs->shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  std::optional<array> passed_freqs;
+  if (freqs) {
+    passed_freqs = astype(*freqs, float32, s);
+  }
+  return rope(
+      x,
+      dims,
+      traditional,
+      base.value_or(0),
+      scale,
+      astype(offset, int32, s),
+      passed_freqs,
+      true,
+      s);
 }
 
-std::vector<array> RoPE::vjp(
+array cross_entropy(
+    const array& logits,
+    const array& targets,
+    StreamOrDevice s_ /* = {} */) {
+  if (logits.ndim() == 0) {
+    throw std::invalid_argument(
+        "[cross_entropy] The logits must have at least 1 dimension.");
+  }
+  if (!issubdtype(logits.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[cross_entropy] Received unsupported logits type "
+        << logits.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(targets.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[cross_entropy] The targets must be integers but got type "
+        << targets.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto& shape = logits.shape();
+  if (targets.shape() != std::vector<int>(shape.begin(), shape.end() - 1)) {
+    std::ostringstream msg;
+    msg << "[cross_entropy] The targets must have the shape of the logits "
+        << "without the last axis but got " << targets.shape() << " and "
+        << logits.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Returns the loss and the log-sum-exp in float32 which is kept for the
+  // gradient
+  auto s = to_stream(s_);
+  auto out_type = logits.dtype();
+  auto fallback = [out_type, s](const std::vector<array>& inputs) {
+    auto x = astype(inputs[0], float32, s);
+    auto& t = inputs[1];
+    int V = x.shape(-1);
+    auto valid = logical_and(
+        greater_equal(t, array(0), s), less(t, array(V), s), s);
+    auto t_safe = where(valid, t, array(0), s);
+    auto lse = logsumexp(x, -1, /* keepdims = */ false, s);
+    auto picked = take_along_axis(x, expand_dims(t_safe, -1, s), -1, s);
+    auto loss =
+        where(valid, subtract(lse, squeeze(picked, -1, s), s), array(0.0f), s);
+    return std::vector<array>{astype(loss, out_type, s), lse};
+  };
+
+  std::vector<array> inputs = {logits, astype(targets, int32, s)};
+  if (s.device == Device::gpu && shape.back() > 0) {
+    return array::make_arrays(
+        {targets.shape(), targets.shape()},
+        {out_type, float32},
+        std::make_shared<CrossEntropy>(s, fallback),
+        inputs)[0];
+  }
+  return fallback(inputs)[0];
+}
+
+std::vector<array> CrossEntropy::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
     const std::vector<int>& argnums,
     const std::vector<array>& outputs) {
+  // Only the loss is returned by cross_entropy so the cotangent of the
+  // log-sum-exp is ignored
   auto s = stream();
-  auto fallback = [dims = dims_,
-                   traditional = traditional_,
-                   base = base_,
-                   scale = scale_,
-                   offset = offset_,
-                   forward = forward_,
-                   s](std::vector<array> inputs) {
-    return std::vector<array>{
-        rope(inputs[0], dims, traditional, base, scale, offset, !forward, s)};
+  auto fallback = [s](const std::vector<array>& inputs) {
+    auto& x = inputs[0];
+    auto& t = inputs[1];
+    auto& lse = inputs[2];
+    auto& g = inputs[3];
+    int V = x.shape(-1);
+    auto valid = logical_and(
+        greater_equal(t, array(0), s), less(t, array(V), s), s);
+    auto x32 = astype(x, float32, s);
+    auto p = exp(subtract(x32, expand_dims(lse, -1, s), s), s);
+    auto onehot = equal(expand_dims(t, -1, s), arange(V, int32, s), s);
+    auto scale = where(valid, astype(g, float32, s), array(0.0f), s);
+    auto dx = multiply(
+        subtract(p, astype(onehot, float32, s), s),
+        expand_dims(scale, -1, s),
+        s);
+    return std::vector<array>{astype(dx, x.dtype(), s)};
   };
 
-  return {array(
-      cotangents[0].shape(),
-      cotangents[0].dtype(),
-      std::make_shared<RoPE>(
-          s, fallback, dims_, traditional_, base_, scale_, offset_, !forward_),
-      cotangents)};
-}
+  std::vector<array> vjps;
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      vjps.push_back(array(
+          primals[0].shape(),
+          primals[0].dtype(),
+          std::make_shared<CrossEntropyVJP>(s, fallback),
+          {primals[0], primals[1], outputs[1], cotangents[0]}));
+    } else {
+      vjps.push_back(zeros_like(primals[1], s));
+    }
+  }
+  return vjps;
+}
+
+namespace {
+
+// Validates the flattened inputs of a multi-tensor optimizer update,
+// {learning_rate, parameters..., gradients..., states...}, and returns
+// whether the fused kernel can be used. It needs every gradient and state to
+// have the type of its parameter.
+bool check_optimizer_inputs(
+    const std::string& tag,
+    const std::vector<array>& inputs,
+    int n) {
+  bool fusable = n > 0;
+  for (int i = 0; i < n; i++) {
+    auto& p = inputs[1 + i];
+    if (!issubdtype(p.dtype(), floating)) {
+      std::ostringstream msg;
+      msg << "[" << tag << "] Received unsupported parameter type "
+          << p.dtype() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    for (int j = 1 + n + i; j < inputs.size(); j += n) {
+      if (inputs[j].shape() != p.shape()) {
+        std::ostringstream msg;
+        msg << "[" << tag << "] The gradients and states must have the "
+            << "shapes of the parameters but got " << inputs[j].shape()
+            << " and " << p.shape() << ".";
+        throw std::invalid_argument(msg.str());
+      }
+      fusable &= inputs[j].dtype() == p.dtype();
+    }
+  }
+  return fusable;
+}
+
+// The learning rate followed by the lists of the update
+std::vector<array> optimizer_inputs(
+    const std::string& tag,
+    const array& learning_rate,
+    std::initializer_list<const std::vector<array>*> lists,
+    const Stream& s) {
+  if (learning_rate.size() != 1) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The learning rate must be a scalar but got shape "
+        << learning_rate.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  size_t n = (*lists.begin())->size();
+  std::vector<array> inputs = {
+      astype(reshape(learning_rate, {}, s), float32, s)};
+  for (auto l : lists) {
+    if (l->size() != n) {
+      std::ostringstream msg;
+      msg << "[" << tag << "] Expected as many gradients and states as "
+          << "parameters but got " << l->size() << " and " << n << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    inputs.insert(inputs.end(), l->begin(), l->end());
+  }
+  return inputs;
+}
+
+// Runs the update with one primitive producing every output or with the
+// fallback and splits the outputs in k lists
+std::vector<std::vector<array>> optimizer_outputs(
+    const std::vector<array>& inputs,
+    int n,
+    int k,
+    bool fusable,
+    std::shared_ptr<Primitive> primitive,
+    const std::function<std::vector<array>(std::vector<array>)>& fallback) {
+  std::vector<array> outputs;
+  if (primitive->stream().device == Device::gpu && fusable) {
+    std::vector<std::vector<int>> shapes;
+    std::vector<Dtype> dtypes;
+    for (int j = 0; j < k; j++) {
+      for (int i = 0; i < n; i++) {
+        shapes.push_back(inputs[1 + i].shape());
+        dtypes.push_back(inputs[1 + i].dtype());
+      }
+    }
+    outputs = array::make_arrays(
+        std::move(shapes), dtypes, std::move(primitive), inputs);
+  } else {
+    outputs = fallback(inputs);
+  }
+  std::vector<std::vector<array>> lists;
+  for (int j = 0; j < k; j++) {
+    lists.emplace_back(
+        outputs.begin() + j * n, outputs.begin() + (j + 1) * n);
+  }
+  return lists;
+}
+
+} // namespace
+
+std::tuple<std::vector<array>, std::vector<array>, std::vector<array>>
+adam_update(
+    const std::vector<array>& parameters,
+    const std::vector<array>& gradients,
+    const std::vector<array>& m,
+    const std::vector<array>& v,
+    const array& learning_rate,
+    float beta1,
+    float beta2,
+    float eps,
+    float weight_decay /* = 0.0f */,
+    StreamOrDevice s_ /* = {} */) {
+  auto s = to_stream(s_);
+  auto inputs = optimizer_inputs(
+      "adam_update", learning_rate, {&parameters, &gradients, &m, &v}, s);
+  int n = parameters.size();
+  bool fusable = check_optimizer_inputs("adam_update", inputs, n);
+
+  auto fallback = [beta1, beta2, eps, weight_decay, n, s](
+                      const std::vector<array>& inputs) {
+    std::vector<array> ps;
+    std::vector<array> ms;
+    std::vector<array> vs;
+    for (int i = 0; i < n; i++) {
+      auto& p = inputs[1 + i];
+      auto& g = inputs[1 + n + i];
+      // Computed in the type of the gradient like the Python optimizers
+      auto dt = g.dtype();
+      auto lr = astype(inputs[0], dt, s);
+      auto m = add(
+          multiply(array(beta1, dt), inputs[1 + 2 * n + i], s),
+          multiply(array(1.0f - beta1, dt), g, s),
+          s);
+      auto v = add(
+          multiply(array(beta2, dt), inputs[1 + 3 * n + i], s),
+          multiply(array(1.0f - beta2, dt), square(g, s), s),
+          s);
+      auto decayed = p;
+      if (weight_decay != 0) {
+        auto decay = multiply(lr, array(weight_decay, dt), s);
+        decayed = multiply(p, subtract(array(1.0f, dt), decay, s), s);
+      }
+      auto step = divide(
+          multiply(lr, m, s), add(sqrt(v, s), array(eps, dt), s), s);
+      ps.push_back(subtract(decayed, step, s));
+      ms.push_back(std::move(m));
+      vs.push_back(std::move(v));
+    }
+    ps.insert(ps.end(), ms.begin(), ms.end());
+    ps.insert(ps.end(), vs.begin(), vs.end());
+    return ps;
+  };
+
+  auto outputs = optimizer_outputs(
+      inputs,
+      n,
+      3,
+      fusable,
+      std::make_shared<AdamUpdate>(
+          s, fallback, beta1, beta2, eps, weight_decay),
+      fallback);
+  return {
+      std::move(outputs[0]), std::move(outputs[1]), std::move(outputs[2])};
+}
+
+bool AdamUpdate::is_equivalent(const Primitive& other) const {
+  const AdamUpdate& a_other = static_cast<const AdamUpdate&>(other);
+  return beta1_ == a_other.beta1_ && beta2_ == a_other.beta2_ &&
+      eps_ == a_other.eps_ && weight_decay_ == a_other.weight_decay_;
+}
+
+std::pair<std::vector<array>, std::vector<array>> lion_update(
+    const std::vector<array>& parameters,
+    const std::vector<array>& gradients,
+    const std::vector<array>& m,
+    const array& learning_rate,
+    float beta1,
+    float beta2,
+    float weight_decay /* = 0.0f */,
+    StreamOrDevice s_ /* = {} */) {
+  auto s = to_stream(s_);
+  auto inputs = optimizer_inputs(
+      "lion_update", learning_rate, {&parameters, &gradients, &m}, s);
+  int n = parameters.size();
+  bool fusable = check_optimizer_inputs("lion_update", inputs, n);
+
+  auto fallback = [beta1, beta2, weight_decay, n, s](
+                      const std::vector<array>& inputs) {
+    std::vector<array> ps;
+    std::vector<array> ms;
+    for (int i = 0; i < n; i++) {
+      auto& p = inputs[1 + i];
+      auto& g = inputs[1 + n + i];
+      auto& m = inputs[1 + 2 * n + i];
+      auto dt = g.dtype();
+      auto lr = astype(inputs[0], dt, s);
+      auto c = add(
+          multiply(array(beta1, dt), m, s),
+          multiply(array(1.0f - beta1, dt), g, s),
+          s);
+      auto decayed = p;
+      if (weight_decay != 0) {
+        auto decay = multiply(lr, array(weight_decay, dt), s);
+        decayed = multiply(subtract(array(1.0f, dt), decay, s), p, s);
+      }
+      ps.push_back(subtract(decayed, multiply(lr, sign(c, s), s), s));
+      ms.push_back(add(
+          multiply(array(beta2, dt), m, s),
+          multiply(array(1.0f - beta2, dt), g, s),
+          s));
+    }
+    ps.insert(ps.end(), ms.begin(), ms.end());
+    return ps;
+  };
+
+  auto outputs = optimizer_outputs(
+      inputs,
+      n,
+      2,
+      fusable,
+      std::make_shared<LionUpdate>(s, fallback, beta1, beta2, weight_decay),
+      fallback);
+  return {std::move(outputs[0]), std::move(outputs[1])};
+}
+
+bool LionUpdate::is_equivalent(const Primitive& other) const {
+  const LionUpdate& a_other = static_cast<const LionUpdate&>(other);
+  return beta1_ == a_other.beta1_ && beta2_ == a_other.beta2_ &&
+      weight_decay_ == a_other.weight_decay_;
+}
+
+array rope(
+    const array& x,
+    int dims,
+    bool traditional,
+    std::optional<float> base,
+    float scale,
+    int offset,
+    const std::optional<array>& freqs /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  return rope(x, dims, traditional, base, scale, array(offset), freqs, s);
+}
+
+std::vector<array> RoPE::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  if (argnums.size() > 1 || argnums[0] != 0) {
+    throw std::invalid_argument(
+        "[RoPE] Cannot differentiate wrt the offset or the frequencies.");
+  }
+  // The rotation is linear in x
+  std::optional<array> freqs;
+  if (primals.size() == 3) {
+    freqs = primals[2];
+  }
+  return {rope(
+      astype(tangents[0], primals[0].dtype(), stream()),
+      dims_,
+      traditional_,
+      base_,
+      scale_,
+      primals[1],
+      freqs,
+      forward_,
+      stream())};
+}
+
+std::vector<array> RoPE::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  if (argnums.size() > 1 || argnums[0] != 0) {
+    throw std::invalid_argument(
+        "[RoPE] Cannot differentiate wrt the offset or the frequencies.");
+  }
+  std::optional<array> freqs;
+  if (primals.size() == 3) {
+    freqs = primals[2];
+  }
+  return {rope(
+      cotangents[0],
+      dims_,
+      traditional_,
+      base_,
+      scale_,
+      primals[1],
+      freqs,
+      !forward_,
+      stream())};
+}
+
+std::pair<std::vector<array>, std::vector<int>> RoPE::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // Vmapped offsets or frequencies change the angles per batch element
+  if (axes[1] >= 0 || (axes.size() == 3 && axes[2] >= 0)) {
+    return Custom::vmap(inputs, axes);
+  }
+
+  // The kernel rotates the last axis along the positions of the second to
+  // last and treats the others as batch axes. Offsets per sequence index
+  // the first axis so it stays in place.
+  auto x = inputs[0];
+  int ax = axes[0];
+  int first = (inputs[1].ndim() > 0) ? 1 : 0;
+  if (ax >= x.ndim() - 2 || ax < first) {
+    x = moveaxis(x, ax, first, stream());
+    ax = first;
+  }
+  std::optional<array> freqs;
+  if (inputs.size() == 3) {
+    freqs = inputs[2];
+  }
+  return {
+      {rope(
+          x,
+          dims_,
+          traditional_,
+          base_,
+          scale_,
+          inputs[1],
+          freqs,
+          forward_,
+          stream())},
+      {ax}};
+}
 
 bool RoPE::is_equivalent(const Primitive& other) const {
   const RoPE& a_other = static_cast<const RoPE&>(other);
   return (
       dims_ == a_other.dims_ && base_ == a_other.base_ &&
       scale_ == a_other.scale_ && traditional_ == a_other.traditional_ &&
-      offset_ == a_other.offset_ && forward_ == a_other.forward_);
+      forward_ == a_other.forward_);
 }
 
-/** Computes: O = softmax(Q @ K.T) @ V **/
-array scaled_dot_product_attention(
+
+namespace {
+
+// The Metal decoding kernel works on bfloat vectors which need Metal 3.1
+#if defined METAL_3_1 || defined METAL_3_2
+constexpr bool sdpa_vector_supports_bfloat16 = true;
+#else
+constexpr bool sdpa_vector_supports_bfloat16 = false;
+#endif
+
+// The most queries per head, i.e. draft tokens, verified with the decoding
+// shader
+constexpr int max_verification_queries = 8;
+
+// Checks that the mask broadcasts to the scores. Boolean masks select the
+// scores to keep, any other mask is cast to the type of the scores and
+// added to them.
+array check_attention_mask(
+    const std::string& tag,
+    const array& mask,
+    const std::vector<int>& scores_shape,
+    Dtype scores_type,
+    StreamOrDevice s) {
+  if (mask.ndim() > 4 ||
+      broadcast_shapes(mask.shape(), scores_shape) != scores_shape) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] mask with shape " << mask.shape()
+        << " cannot be broadcast to the scores shape " << scores_shape << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  return mask.dtype() == bool_ ? mask : astype(mask, scores_type, s);
+}
+
+array scaled_dot_product_attention_impl(
     const array& queries,
     const array& keys,
     const array& values,
     const float scale,
-    const std::optional<array>& mask,
+    std::optional<array> mask,
+    const bool do_causal,
+    const int window_size,
+    std::optional<array> alibi_slopes,
     StreamOrDevice s) {
   for (const auto& tensor : {queries, keys, values}) {
     if (tensor.ndim() != 4) {
@@ -524,19 +1433,54 @@ array scaled_dot_product_attention(
   auto k = astype(keys, final_type, s);
   auto v = astype(values, final_type, s);
 
+  const int query_sequence_length = q.shape(2);
+  const int key_sequence_length = k.shape(2);
+  if (mask) {
+    mask = check_attention_mask(
+        "scaled_dot_product_attention",
+        *mask,
+        {q.shape(0), n_q_heads, query_sequence_length, key_sequence_length},
+        final_type,
+        s);
+  }
+  if (window_size < 0) {
+    std::ostringstream msg;
+    msg << "[scaled_dot_product_attention] The window size should be "
+        << "positive, or 0 for no window, but got " << window_size << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (alibi_slopes) {
+    if (alibi_slopes->ndim() != 1 || alibi_slopes->shape(0) != n_q_heads) {
+      std::ostringstream msg;
+      msg << "[scaled_dot_product_attention] The ALiBi slopes should have "
+          << "one slope per query head, shape (" << n_q_heads << ",), but "
+          << "got shape " << alibi_slopes->shape() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    alibi_slopes = astype(*alibi_slopes, float32, s);
+  }
+
   /* generic implementation for use cases that Metal implementation does not
    * support. For non-supported cases listed below, use MLX primitives:
    * * CPU implementation
-   * * batch size > 1 for decoding or causal attention
-   * * query sequence length > 1 for decoding
-   * * query sequence length > 16 && non-null mask (causal attention)
-   * * non-null mask
-   * * dtype is not fp32 or fp16
+   * * batch size > 1 for decoding
+   * * query sequence length between 2 and 15 unless verifying draft tokens
+   * * causal attention with more queries than keys
+   * * head dimensions other than 64 and 128, or 128 for decoding
+   * * value head dimension different from the query head dimension
+   * * bfloat16 for decoding before Metal 3.1
    */
 
   bool needs_mask = mask.has_value();
-  auto fallback = [scale, needs_mask, final_type, n_q_heads, n_kv_heads, &s](
-                      const std::vector<array>& inputs) {
+  bool has_alibi = alibi_slopes.has_value();
+  auto fallback = [scale,
+                   needs_mask,
+                   do_causal,
+                   window_size,
+                   has_alibi,
+                   n_q_heads,
+                   n_kv_heads,
+                   &s](const std::vector<array>& inputs) {
     auto q = multiply(array(scale, inputs[0].dtype()), inputs[0], s);
     int n_repeats = n_q_heads / n_kv_heads;
     int B = q.shape(0);
@@ -549,8 +1493,55 @@ array scaled_dot_product_attention(
       v = expand_dims(v, 2, s);
     }
     auto scores = matmul(q, swapaxes(k, -1, -2, s), s);
+    int kL = k.shape(-2);
+    int offset = kL - L;
+    auto q_idx = expand_dims(arange(offset, offset + L, s), 1, s);
+    auto k_idx = expand_dims(arange(0, kL, s), 0, s);
+    if (do_causal) {
+      scores = where(
+          greater_equal(q_idx, k_idx, s),
+          scores,
+          array(-std::numeric_limits<float>::infinity(), scores.dtype()),
+          s);
+    }
+    if (window_size > 0) {
+      scores = where(
+          less(subtract(q_idx, k_idx, s), array(window_size), s),
+          scores,
+          array(-std::numeric_limits<float>::infinity(), scores.dtype()),
+          s);
+    }
+    if (has_alibi) {
+      // One slope per query head, split like the heads of the queries
+      auto slopes = inputs[3 + needs_mask];
+      slopes = n_repeats > 1 ? reshape(slopes, {n_kv_heads, n_repeats, 1, 1}, s)
+                             : reshape(slopes, {-1, 1, 1}, s);
+      auto bias = multiply(
+          slopes, astype(subtract(k_idx, q_idx, s), float32, s), s);
+      scores = add(scores, astype(bias, scores.dtype(), s), s);
+    }
     if (needs_mask) {
-      scores = add(scores, inputs[3], s);
+      auto mask = inputs[3];
+      // Split the heads of the mask like the heads of the queries
+      if (n_repeats > 1 && mask.ndim() >= 3) {
+        if (mask.shape(-3) == 1) {
+          mask = expand_dims(mask, -3, s);
+        } else {
+          auto mask_shape = mask.shape();
+          mask_shape.insert(mask_shape.end() - 2, n_repeats);
+          mask_shape[mask_shape.size() - 4] = n_kv_heads;
+          mask = reshape(mask, std::move(mask_shape), s);
+        }
+      }
+      if (mask.dtype() == bool_) {
+        scores = where(
+            mask,
+            scores,
+            array(-std::numeric_limits<float>::infinity(), scores.dtype()),
+            s);
+      } else {
+        scores = add(scores, mask, s);
+      }
     }
     scores = softmax(scores, std::vector<int>{-1}, true, s);
     auto out = matmul(scores, v, s);
@@ -561,29 +1552,43 @@ array scaled_dot_product_attention(
   };
 
   auto stream = to_stream(s);
-  const size_t query_head_dim = q.shape(-1);
-  const bool supported_head_dim =
-      query_head_dim == 64 || query_head_dim == 80 || query_head_dim == 128;
+  const int query_head_dim = q.shape(-1);
+  // The kernels read the values with the head dimension of the queries
+  const bool matching_head_dims = v.shape(-1) == query_head_dim;
 
-  const bool supported_head_dim_self_attn =
-      query_head_dim == 64 || query_head_dim == 128;
-  const size_t query_sequence_length = q.shape(2);
+  // Prefill, the full attention kernel handles any mask, a batch and grouped
+  // query heads. Causal attention needs at least as many keys as queries.
   const bool supports_full_self_attention = query_sequence_length >= 16 &&
-      !mask.has_value() && supported_head_dim_self_attn &&
-      n_q_heads == n_kv_heads && final_type != bfloat16 &&
+      (!do_causal || key_sequence_length >= query_sequence_length) &&
+      (query_head_dim == 64 || query_head_dim == 128) && matching_head_dims &&
       stream.device == Device::gpu;
 
-  // fast decoding gpu shader
-  bool supports_sdpa = batch_dim == 1 && query_sequence_length == 1 &&
-      !mask.has_value() && supported_head_dim && final_type != bfloat16 &&
+  // fast decoding gpu shader, a single query sees every key when causal. The
+  // keys are split in at most 128 tiles of at most 512 keys.
+  const bool supports_sdpa = batch_dim == 1 && query_sequence_length == 1 &&
+      key_sequence_length <= 128 * 512 && query_head_dim == 128 &&
+      matching_head_dims &&
+      (final_type != bfloat16 || sdpa_vector_supports_bfloat16) &&
       stream.device == Device::gpu;
-  bool implementation_supports_use_case =
-      supports_sdpa || supports_full_self_attention;
-
-  // disabling full self attention until perf is tuned;
-  // likewise for sdpa
-  implementation_supports_use_case &= false;
+  // Verifying a few draft tokens of speculative decoding with the decoding
+  // shader, each query is masked on its own, e.g. with a tree mask
+  const bool supports_verification = batch_dim == 1 &&
+      query_sequence_length > 1 &&
+      query_sequence_length <= max_verification_queries && !do_causal &&
+      key_sequence_length <= 128 * 512 && query_head_dim == 128 &&
+      matching_head_dims &&
+      (final_type != bfloat16 || sdpa_vector_supports_bfloat16) &&
+      stream.device == Device::gpu;
+  const bool implementation_supports_use_case =
+      supports_sdpa || supports_full_self_attention || supports_verification;
 
+  std::vector<array> inputs = {q, k, v};
+  if (mask) {
+    inputs.push_back(*mask);
+  }
+  if (alibi_slopes) {
+    inputs.push_back(*alibi_slopes);
+  }
   if (implementation_supports_use_case) {
     auto out_shape =
         std::vector<int>({q.shape(0), q.shape(1), q.shape(2), v.shape(-1)});
@@ -591,22 +1596,1119 @@ array scaled_dot_product_attention(
         std::move(out_shape),
         final_type,
         std::make_shared<ScaledDotProductAttention>(
-            stream, fallback, scale, false),
-        {q, k, v});
+            stream,
+            fallback,
+            scale,
+            needs_mask,
+            do_causal,
+            window_size,
+            has_alibi),
+        std::move(inputs));
     return out;
   }
 
-  if (mask.has_value()) {
-    return fallback({q, k, v, mask.value()})[0];
-  } else {
-    return fallback({q, k, v})[0];
+  return fallback(inputs)[0];
+}
+
+} // namespace
+
+/** Computes: O = softmax(Q @ K.T) @ V **/
+array scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& values,
+    const float scale,
+    const std::optional<array>& mask,
+    StreamOrDevice s) {
+  return scaled_dot_product_attention_impl(
+      queries, keys, values, scale, mask, false, 0, std::nullopt, s);
+}
+
+array scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& values,
+    const float scale,
+    const std::string& mask_mode,
+    const std::optional<array>& mask,
+    StreamOrDevice s) {
+  if (mask_mode != "causal") {
+    std::ostringstream msg;
+    msg << "[scaled_dot_product_attention] Invalid mask_mode " << mask_mode
+        << ". Only \"causal\" is supported.";
+    throw std::invalid_argument(msg.str());
   }
+  return scaled_dot_product_attention_impl(
+      queries, keys, values, scale, mask, true, 0, std::nullopt, s);
+}
+
+array scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& values,
+    const float scale,
+    const std::string& mask_mode,
+    int window_size,
+    const std::optional<array>& alibi_slopes,
+    const std::optional<array>& mask,
+    StreamOrDevice s) {
+  if (mask_mode != "causal" && !mask_mode.empty()) {
+    std::ostringstream msg;
+    msg << "[scaled_dot_product_attention] Invalid mask_mode " << mask_mode
+        << ". Only \"causal\" or no mode is supported.";
+    throw std::invalid_argument(msg.str());
+  }
+  return scaled_dot_product_attention_impl(
+      queries,
+      keys,
+      values,
+      scale,
+      mask,
+      mask_mode == "causal",
+      window_size,
+      alibi_slopes,
+      s);
 }
 
 bool ScaledDotProductAttention::is_equivalent(const Primitive& other) const {
   const ScaledDotProductAttention& a_other =
       static_cast<const ScaledDotProductAttention&>(other);
-  return needs_mask_ == a_other.needs_mask_ && scale_ == a_other.scale_;
+  return needs_mask_ == a_other.needs_mask_ && scale_ == a_other.scale_ &&
+      do_causal_ == a_other.do_causal_ &&
+      window_size_ == a_other.window_size_ && has_alibi_ == a_other.has_alibi_;
+}
+
+std::pair<std::vector<array>, std::vector<int>>
+ScaledDotProductAttention::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // Fold the vmapped axis into the batch of the queries, keys and values
+  // unless the mask or the slopes would have to be tiled along the new batch
+  if (needs_mask_) {
+    auto& mask = inputs[3];
+    if (axes[3] >= 0 || (mask.ndim() == 4 && mask.shape(0) > 1)) {
+      return Custom::vmap(inputs, axes);
+    }
+  }
+  if (has_alibi_ && axes[3 + needs_mask_] >= 0) {
+    return Custom::vmap(inputs, axes);
+  }
+  int n_vmap = 0;
+  for (int i = 0; i < 3; ++i) {
+    if (axes[i] >= 0) {
+      n_vmap = inputs[i].shape(axes[i]);
+    }
+  }
+  auto s = stream();
+  std::vector<array> qkv;
+  for (int i = 0; i < 3; ++i) {
+    auto a = inputs[i];
+    if (axes[i] >= 0) {
+      a = moveaxis(a, axes[i], 0, s);
+    } else {
+      auto shape = a.shape();
+      shape.insert(shape.begin(), n_vmap);
+      a = broadcast_to(expand_dims(a, 0, s), shape, s);
+    }
+    qkv.push_back(flatten(a, 0, 1, s));
+  }
+  std::optional<array> mask;
+  if (needs_mask_) {
+    mask = inputs[3];
+  }
+  std::optional<array> alibi_slopes;
+  if (has_alibi_) {
+    alibi_slopes = inputs[3 + needs_mask_];
+  }
+  auto out = scaled_dot_product_attention_impl(
+      qkv[0],
+      qkv[1],
+      qkv[2],
+      scale_,
+      mask,
+      do_causal_,
+      window_size_,
+      alibi_slopes,
+      s);
+  auto shape = out.shape();
+  shape[0] /= n_vmap;
+  shape.insert(shape.begin(), n_vmap);
+  return {{reshape(out, std::move(shape), s)}, {0}};
+}
+
+std::vector<array> ScaledDotProductAttention::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  // The output is linear in the values so their tangent goes through the
+  // fused kernel. The tangents of the queries, keys and mask go through the
+  // fallback.
+  auto s = stream();
+  std::optional<array> mask;
+  if (needs_mask_) {
+    mask = primals[3];
+  }
+  std::optional<array> alibi_slopes;
+  if (has_alibi_) {
+    alibi_slopes = primals[3 + needs_mask_];
+  }
+  std::optional<array> out;
+  std::vector<array> fallback_tangents;
+  for (auto& p : primals) {
+    fallback_tangents.push_back(zeros_like(p, s));
+  }
+  bool needs_fallback = false;
+  for (int i = 0; i < argnums.size(); ++i) {
+    auto t = astype(tangents[i], primals[argnums[i]].dtype(), s);
+    if (argnums[i] == 2) {
+      out = scaled_dot_product_attention_impl(
+          primals[0],
+          primals[1],
+          t,
+          scale_,
+          mask,
+          do_causal_,
+          window_size_,
+          alibi_slopes,
+          s);
+    } else {
+      fallback_tangents[argnums[i]] = t;
+      needs_fallback = true;
+    }
+  }
+  if (needs_fallback) {
+    auto t = mlx::core::jvp(fallback_, primals, fallback_tangents).second[0];
+    out = out ? add(*out, t, s) : t;
+  }
+  return {*out};
+}
+
+std::vector<array> ScaledDotProductAttention::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  assert(outputs.size() == 1);
+  assert(cotangents.size() == 1);
+
+  // The fused gradients cover the queries, keys and values for the head
+  // dimensions of the kernels
+  auto& q = primals[0];
+  int head_dim = q.shape(-1);
+  bool mask_grad = std::any_of(
+      argnums.begin(), argnums.end(), [](int arg) { return arg >= 3; });
+  if (mask_grad || (head_dim != 64 && head_dim != 128)) {
+    return Custom::vjp(primals, cotangents, argnums, outputs);
+  }
+
+  auto s = stream();
+  auto fallback = [forward = fallback_](const std::vector<array>& inputs) {
+    // The mask and the slopes follow the output and its cotangent
+    std::vector<array> extra(inputs.begin() + 5, inputs.end());
+    auto fun = [&forward, &extra](std::vector<array> primals) {
+      primals.insert(primals.end(), extra.begin(), extra.end());
+      return forward(std::move(primals));
+    };
+    auto [_, vjps] = mlx::core::vjp(
+        fun, {inputs[0], inputs[1], inputs[2]}, {inputs[4]});
+    return vjps;
+  };
+
+  std::vector<array> inputs = {
+      primals[0], primals[1], primals[2], outputs[0], cotangents[0]};
+  inputs.insert(inputs.end(), primals.begin() + 3, primals.end());
+  auto vjps = array::make_arrays(
+      {primals[0].shape(), primals[1].shape(), primals[2].shape()},
+      {primals[0].dtype(), primals[1].dtype(), primals[2].dtype()},
+      std::make_shared<ScaledDotProductAttentionVJP>(
+          s,
+          fallback,
+          scale_,
+          needs_mask_,
+          do_causal_,
+          window_size_,
+          has_alibi_),
+      std::move(inputs));
+
+  std::vector<array> returned_vjps;
+  for (auto& arg : argnums) {
+    returned_vjps.push_back(std::move(vjps[arg]));
+  }
+  return returned_vjps;
+}
+
+bool ScaledDotProductAttentionVJP::is_equivalent(
+    const Primitive& other) const {
+  const ScaledDotProductAttentionVJP& a_other =
+      static_cast<const ScaledDotProductAttentionVJP&>(other);
+  return needs_mask_ == a_other.needs_mask_ && scale_ == a_other.scale_ &&
+      do_causal_ == a_other.do_causal_ &&
+      window_size_ == a_other.window_size_ && has_alibi_ == a_other.has_alibi_;
+}
+
+array quantized_scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& key_scales,
+    const array& key_biases,
+    const array& values,
+    const array& value_scales,
+    const array& value_biases,
+    const float scale,
+    const std::optional<array>& mask,
+    int group_size,
+    int bits,
+    StreamOrDevice s) {
+  for (const auto& tensor : {queries, keys, values}) {
+    if (tensor.ndim() != 4) {
+      std::ostringstream msg;
+      msg << "[quantized_scaled_dot_product_attention] input with shape "
+          << tensor.shape() << " expected to be rank 4";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+  if (keys.dtype() != uint32 || values.dtype() != uint32) {
+    throw std::invalid_argument(
+        "[quantized_scaled_dot_product_attention] keys and values are "
+        "expected to be quantized with quantize.");
+  }
+
+  auto final_type = result_type(queries, key_scales, value_scales);
+  if (!issubdtype(final_type, floating)) {
+    std::ostringstream msg;
+    msg << "[quantized_scaled_dot_product_attention] Received unsupported "
+        << "type " << final_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Keys and values are dequantized for the use cases the Metal kernel does
+  // not support, which also validates their shapes
+  bool needs_mask = mask.has_value();
+  auto fallback = [scale, needs_mask, group_size, bits, s](
+                      const std::vector<array>& inputs) {
+    auto k = dequantize(inputs[1], inputs[2], inputs[3], group_size, bits, s);
+    auto v = dequantize(inputs[4], inputs[5], inputs[6], group_size, bits, s);
+    std::optional<array> mask;
+    if (needs_mask) {
+      mask = inputs[7];
+    }
+    return std::vector<array>{
+        scaled_dot_product_attention(inputs[0], k, v, scale, mask, s)};
+  };
+
+  std::vector<array> inputs = {
+      astype(queries, final_type, s),
+      keys,
+      astype(key_scales, final_type, s),
+      astype(key_biases, final_type, s),
+      values,
+      astype(value_scales, final_type, s),
+      astype(value_biases, final_type, s)};
+
+  auto stream = to_stream(s);
+  const int head_dim = keys.shape(-1) * 32 / bits;
+  const int n_q_heads = queries.shape(1);
+  const int n_kv_heads = keys.shape(1);
+  const int key_sequence_length = keys.shape(2);
+  if (mask) {
+    inputs.push_back(check_attention_mask(
+        "quantized_scaled_dot_product_attention",
+        *mask,
+        {queries.shape(0), n_q_heads, queries.shape(2), key_sequence_length},
+        final_type,
+        s));
+  }
+
+  // The kernel splits the keys in at most 128 tiles of at most 512 keys
+  bool supported = stream.device == Device::gpu && queries.shape(2) == 1 &&
+      queries.shape(-1) == 128 && head_dim == 128 &&
+      (group_size == 32 || group_size == 64 || group_size == 128) &&
+      (bits == 2 || bits == 4 || bits == 8) &&
+      key_scales.shape() == key_biases.shape() &&
+      key_scales.shape() == value_scales.shape() &&
+      value_scales.shape() == value_biases.shape() &&
+      key_scales.shape(-1) == head_dim / group_size &&
+      keys.shape() == values.shape() && n_kv_heads > 0 &&
+      n_q_heads % n_kv_heads == 0 && key_sequence_length <= 128 * 512 &&
+      keys.shape(0) == queries.shape(0);
+
+  if (supported) {
+    return array(
+        {queries.shape(0), n_q_heads, 1, head_dim},
+        final_type,
+        std::make_shared<QuantizedScaledDotProductAttention>(
+            stream, fallback, scale, needs_mask, group_size, bits),
+        std::move(inputs));
+  }
+  return fallback(inputs)[0];
+}
+
+bool QuantizedScaledDotProductAttention::is_equivalent(
+    const Primitive& other) const {
+  const QuantizedScaledDotProductAttention& a_other =
+      static_cast<const QuantizedScaledDotProductAttention&>(other);
+  return needs_mask_ == a_other.needs_mask_ && scale_ == a_other.scale_ &&
+      group_size_ == a_other.group_size_ && bits_ == a_other.bits_;
+}
+
+array paged_attention(
+    const array& queries,
+    const array& key_cache,
+    const array& value_cache,
+    const array& block_tables,
+    const array& context_lengths,
+    const float scale,
+    StreamOrDevice s) {
+  if (queries.ndim() != 4 || queries.shape(2) != 1) {
+    std::ostringstream msg;
+    msg << "[paged_attention] Expected queries of shape "
+        << "(batch, n_heads, 1, head_dim) but received " << queries.shape()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (key_cache.ndim() != 4 || key_cache.shape() != value_cache.shape() ||
+      key_cache.shape(-1) != queries.shape(-1)) {
+    std::ostringstream msg;
+    msg << "[paged_attention] Expected key and value caches of shape "
+        << "(num_blocks, n_kv_heads, block_size, head_dim) but received "
+        << key_cache.shape() << " and " << value_cache.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  const int batch = queries.shape(0);
+  const int n_q_heads = queries.shape(1);
+  const int n_kv_heads = key_cache.shape(1);
+  if (n_q_heads % n_kv_heads != 0) {
+    std::ostringstream msg;
+    msg << "[paged_attention] n_heads must be a multiple of n_kv_heads, "
+        << "found n_heads " << n_q_heads << " for n_kv_heads " << n_kv_heads
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (block_tables.ndim() != 2 || block_tables.shape(0) != batch ||
+      context_lengths.ndim() != 1 || context_lengths.size() != batch ||
+      !issubdtype(block_tables.dtype(), integer) ||
+      !issubdtype(context_lengths.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[paged_attention] Expected integer block tables of shape "
+        << "(batch, max_blocks) and context lengths of shape (batch,) but "
+        << "received " << block_tables.shape() << " and "
+        << context_lengths.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto final_type = result_type(queries, key_cache, value_cache);
+  if (!issubdtype(final_type, floating)) {
+    std::ostringstream msg;
+    msg << "[paged_attention] Received unsupported type " << final_type
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Gathers the pages of each sequence and masks the keys past its length
+  auto fallback = [scale, s](const std::vector<array>& inputs) {
+    auto& q = inputs[0];
+    auto& tables = inputs[3];
+    int B = q.shape(0);
+    int num_blocks = inputs[1].shape(0);
+    int block_size = inputs[1].shape(2);
+    int L = tables.shape(1) * block_size;
+    // Unused entries of the block tables can hold any index
+    auto pages = clip(tables, array(0), array(num_blocks - 1), s);
+    auto gather = [&](const array& cache) {
+      auto kv = take(cache, pages, 0, s);
+      kv = transpose(kv, {0, 2, 1, 3, 4}, s);
+      return reshape(kv, {B, cache.shape(1), L, cache.shape(-1)}, s);
+    };
+    auto mask = less(arange(L, s), reshape(inputs[4], {B, 1, 1, 1}, s), s);
+    return std::vector<array>{scaled_dot_product_attention(
+        q, gather(inputs[1]), gather(inputs[2]), scale, mask, s)};
+  };
+
+  std::vector<array> inputs = {
+      astype(queries, final_type, s),
+      astype(key_cache, final_type, s),
+      astype(value_cache, final_type, s),
+      astype(block_tables, int32, s),
+      astype(context_lengths, int32, s)};
+
+  // The kernel splits the sequences in at most 128 tiles of at most 512 keys
+  auto stream = to_stream(s);
+  bool supported = stream.device == Device::gpu &&
+      queries.shape(-1) == 128 &&
+      block_tables.shape(1) * key_cache.shape(2) <= 128 * 512;
+  if (supported) {
+    return array(
+        queries.shape(),
+        final_type,
+        std::make_shared<PagedAttention>(stream, fallback, scale),
+        std::move(inputs));
+  }
+  return fallback(inputs)[0];
+}
+
+bool PagedAttention::is_equivalent(const Primitive& other) const {
+  const PagedAttention& a_other = static_cast<const PagedAttention&>(other);
+  return scale_ == a_other.scale_;
+}
+
+bool RaggedAttention::is_equivalent(const Primitive& other) const {
+  const RaggedAttention& a_other = static_cast<const RaggedAttention&>(other);
+  return scale_ == a_other.scale_ && do_causal_ == a_other.do_causal_;
+}
+
+array quantized_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    bool transpose,
+    int group_size,
+    int bits,
+    const std::optional<array>& bias,
+    const std::optional<array>& gate,
+    const std::optional<array>& residual,
+    StreamOrDevice s) {
+  // Checks the shapes and types of the matmul
+  auto out = mlx::core::quantized_matmul(
+      x, w, scales, biases, transpose, group_size, bits, s);
+  auto out_type = out.dtype();
+  int O = out.shape(-1);
+  if (bias && (bias->ndim() != 1 || bias->shape(0) != O)) {
+    std::ostringstream msg;
+    msg << "[quantized_matmul] The bias with shape " << bias->shape()
+        << " should have shape (" << O << ",).";
+    throw std::invalid_argument(msg.str());
+  }
+  for (auto& arr : {gate, residual}) {
+    if (arr && arr->shape() != out.shape()) {
+      std::ostringstream msg;
+      msg << "[quantized_matmul] The gate and residual with shape "
+          << arr->shape() << " should have the shape of the output "
+          << out.shape() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+  if (!bias && !gate && !residual) {
+    return out;
+  }
+
+  std::vector<array> inputs = {
+      astype(x, out_type, s),
+      w,
+      astype(scales, out_type, s),
+      astype(biases, out_type, s)};
+  for (auto& arr : {bias, gate, residual}) {
+    if (arr) {
+      inputs.push_back(astype(*arr, out_type, s));
+    }
+  }
+  bool has_bias = bias.has_value();
+  bool has_gate = gate.has_value();
+  bool has_residual = residual.has_value();
+  auto fallback = [transpose,
+                   group_size,
+                   bits,
+                   has_bias,
+                   has_gate,
+                   has_residual,
+                   s](const std::vector<array>& inputs) {
+    auto out = mlx::core::quantized_matmul(
+        inputs[0],
+        inputs[1],
+        inputs[2],
+        inputs[3],
+        transpose,
+        group_size,
+        bits,
+        s);
+    int i = 4;
+    if (has_bias) {
+      out = add(out, inputs[i++], s);
+    }
+    if (has_gate) {
+      auto& g = inputs[i++];
+      out = multiply(multiply(g, sigmoid(g, s), s), out, s);
+    }
+    if (has_residual) {
+      out = add(out, inputs[i++], s);
+    }
+    return std::vector<array>{out};
+  };
+
+  // The epilogue is fused in the matrix-vector kernel for inputs aligned to
+  // its blocks and in the matrix-matrix kernel otherwise
+  auto stream = to_stream(s);
+  int D = x.shape(-1);
+  int B = x.size() / D;
+  bool supported = stream.device == Device::gpu && transpose &&
+      (B >= 6 || (O % 8 == 0 && D % 512 == 0));
+  if (supported) {
+    return array(
+        out.shape(),
+        out_type,
+        std::make_shared<QuantizedMatmulEpilogue>(
+            stream,
+            fallback,
+            group_size,
+            bits,
+            has_bias,
+            has_gate,
+            has_residual),
+        std::move(inputs));
+  }
+  return fallback(inputs)[0];
+}
+
+bool QuantizedMatmulEpilogue::is_equivalent(const Primitive& other) const {
+  const QuantizedMatmulEpilogue& q_other =
+      static_cast<const QuantizedMatmulEpilogue&>(other);
+  return group_size_ == q_other.group_size_ && bits_ == q_other.bits_ &&
+      has_bias_ == q_other.has_bias_ && has_gate_ == q_other.has_gate_ &&
+      has_residual_ == q_other.has_residual_ &&
+      has_lora_ == q_other.has_lora_ &&
+      has_adapter_ids_ == q_other.has_adapter_ids_;
+}
+
+array quantized_matmul_w8a8(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size,
+    StreamOrDevice s) {
+  // Checks the shapes and types of the matmul
+  auto out = mlx::core::quantized_matmul(
+      x, w, scales, biases, true, group_size, 8, s);
+  auto out_type = out.dtype();
+
+  // Quantize the activations symmetrically with a scale per row
+  auto xf = astype(x, float32, s);
+  auto x_scales = maximum(
+      divide(max(abs(xf, s), -1, true, s), array(127.0f), s),
+      array(1e-12f),
+      s);
+  auto x_q = astype(round(divide(xf, x_scales, s), s), int8, s);
+
+  std::vector<array> inputs = {
+      x_q,
+      x_scales,
+      w,
+      astype(scales, out_type, s),
+      astype(biases, out_type, s)};
+  auto fallback = [group_size, s](const std::vector<array>& inputs) {
+    auto& x_q = inputs[0];
+    auto& scales = inputs[3];
+    auto out_type = scales.dtype();
+    int D = x_q.shape(-1);
+    int O = scales.shape(0);
+    int G = D / group_size;
+
+    // The integer weights and the sums of their products per group are
+    // exact in float32 so this matches the int32 accumulation
+    auto unit = ones({O, G}, float32, s);
+    auto q = dequantize(
+        inputs[2], unit, zeros_like(unit, s), group_size, 8, s);
+    auto x_g = transpose(
+        reshape(astype(x_q, float32, s), {-1, G, group_size}, s),
+        {1, 0, 2},
+        s);
+    auto q_g = transpose(reshape(q, {O, G, group_size}, s), {1, 2, 0}, s);
+    auto group_dots = matmul(x_g, q_g, s);
+    auto scales_g = expand_dims(transpose(astype(scales, float32, s), s), 1, s);
+    auto y = sum(multiply(group_dots, scales_g, s), 0, false, s);
+    auto x_sums = transpose(sum(x_g, -1, false, s), s);
+    auto biases_t = transpose(astype(inputs[4], float32, s), s);
+    y = add(y, matmul(x_sums, biases_t, s), s);
+    y = multiply(y, reshape(inputs[1], {-1, 1}, s), s);
+    auto out_shape = x_q.shape();
+    out_shape.back() = O;
+    return std::vector<array>{astype(reshape(y, out_shape, s), out_type, s)};
+  };
+
+  auto stream = to_stream(s);
+  if (stream.device == Device::gpu) {
+    return array(
+        out.shape(),
+        out_type,
+        std::make_shared<QuantizedMatmulW8A8>(stream, fallback, group_size),
+        std::move(inputs));
+  }
+  return fallback(inputs)[0];
+}
+
+bool QuantizedMatmulW8A8::is_equivalent(const Primitive& other) const {
+  const QuantizedMatmulW8A8& q_other =
+      static_cast<const QuantizedMatmulW8A8&>(other);
+  return group_size_ == q_other.group_size_;
+}
+
+array quantized_lora_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& lora_a,
+    const array& lora_b,
+    float scale,
+    const std::optional<array>& adapter_ids,
+    int group_size,
+    int bits,
+    StreamOrDevice s) {
+  // Checks the shapes and types of the base matmul
+  auto out = mlx::core::quantized_matmul(
+      x, w, scales, biases, true, group_size, bits, s);
+  auto out_type = out.dtype();
+  int D = x.shape(-1);
+  int O = out.shape(-1);
+  int adapter_ndim = adapter_ids ? 3 : 2;
+  if (lora_a.ndim() != adapter_ndim || lora_b.ndim() != adapter_ndim ||
+      lora_a.shape(-1) != D || lora_b.shape(-2) != O ||
+      lora_a.shape(-2) != lora_b.shape(-1) ||
+      (adapter_ids && lora_a.shape(0) != lora_b.shape(0))) {
+    std::ostringstream msg;
+    msg << "[quantized_lora_matmul] The adapter matrices should have shapes "
+        << "(r, " << D << ") and (" << O << ", r)"
+        << (adapter_ids ? " stacked over the adapters" : "")
+        << " but got " << lora_a.shape() << " and " << lora_b.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  std::vector<int> rows_shape(x.shape().begin(), x.shape().end() - 1);
+  if (adapter_ids &&
+      (!issubdtype(adapter_ids->dtype(), integer) ||
+       adapter_ids->shape() != rows_shape)) {
+    std::ostringstream msg;
+    msg << "[quantized_lora_matmul] The adapter ids should be integers with "
+        << "one per row of x, shape " << rows_shape << ", but got "
+        << adapter_ids->dtype() << " with shape " << adapter_ids->shape()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // The input times the first adapter matrix is small and computed up front,
+  // the second matrix is applied in the quantized matmul
+  auto xc = astype(x, out_type, s);
+  auto a_t = swapaxes(astype(lora_a, out_type, s), -1, -2, s);
+  array x_a = adapter_ids
+      ? squeeze(
+            gather_mm(
+                expand_dims(xc, -2, s),
+                a_t,
+                std::nullopt,
+                adapter_ids,
+                false,
+                s),
+            -2,
+            s)
+      : matmul(xc, a_t, s);
+  x_a = multiply(x_a, array(scale, out_type), s);
+
+  std::vector<array> inputs = {
+      xc,
+      w,
+      astype(scales, out_type, s),
+      astype(biases, out_type, s),
+      x_a,
+      astype(lora_b, out_type, s)};
+  if (adapter_ids) {
+    inputs.push_back(astype(*adapter_ids, uint32, s));
+  }
+  bool has_adapter_ids = adapter_ids.has_value();
+  auto fallback = [group_size, bits, has_adapter_ids, s](
+                      const std::vector<array>& inputs) {
+    auto out = mlx::core::quantized_matmul(
+        inputs[0], inputs[1], inputs[2], inputs[3], true, group_size, bits, s);
+    auto b_t = swapaxes(inputs[5], -1, -2, s);
+    auto update = has_adapter_ids
+        ? squeeze(
+              gather_mm(
+                  expand_dims(inputs[4], -2, s),
+                  b_t,
+                  std::nullopt,
+                  inputs[6],
+                  false,
+                  s),
+              -2,
+              s)
+        : matmul(inputs[4], b_t, s);
+    return std::vector<array>{add(out, update, s)};
+  };
+
+  // The same kernels as the epilogue of quantized_matmul
+  auto stream = to_stream(s);
+  int B = x.size() / D;
+  bool supported = stream.device == Device::gpu &&
+      (B >= 6 || (O % 8 == 0 && D % 512 == 0));
+  if (supported) {
+    return array(
+        out.shape(),
+        out_type,
+        std::make_shared<QuantizedMatmulEpilogue>(
+            stream,
+            fallback,
+            group_size,
+            bits,
+            false,
+            false,
+            false,
+            true,
+            has_adapter_ids),
+        std::move(inputs));
+  }
+  return fallback(inputs)[0];
+}
+
+array conv_general(
+    const array& input,
+    const array& weight,
+    std::vector<int> stride /* = {} */,
+    std::vector<int> padding_lo /* = {} */,
+    std::vector<int> padding_hi /* = {} */,
+    std::vector<int> kernel_dilation /* = {} */,
+    std::vector<int> input_dilation /* = {} */,
+    int groups /* = 1 */,
+    bool flip /* = false */,
+    const std::optional<array>& bias /* = std::nullopt */,
+    const std::string& activation /* = "" */,
+    StreamOrDevice s /* = {} */) {
+  using Activation = ConvolutionEpilogue::Activation;
+  Activation act;
+  if (activation.empty() || activation == "none") {
+    act = Activation::None;
+  } else if (activation == "relu") {
+    act = Activation::ReLU;
+  } else if (activation == "silu") {
+    act = Activation::SiLU;
+  } else if (activation == "gelu") {
+    act = Activation::GELU;
+  } else {
+    std::ostringstream msg;
+    msg << "[conv_general] Unsupported activation '" << activation
+        << "', expected one of 'relu', 'silu' or 'gelu'.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Checks the inputs and builds the convolution
+  auto conv = mlx::core::conv_general(
+      input,
+      weight,
+      std::move(stride),
+      std::move(padding_lo),
+      std::move(padding_hi),
+      std::move(kernel_dilation),
+      std::move(input_dilation),
+      groups,
+      flip,
+      s);
+  auto out_type = conv.dtype();
+  int O = conv.shape(-1);
+  if (bias && (bias->ndim() != 1 || bias->shape(0) != O)) {
+    std::ostringstream msg;
+    msg << "[conv_general] The bias with shape " << bias->shape()
+        << " should have shape (" << O << ",).";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!bias && act == Activation::None) {
+    return conv;
+  }
+
+  // The epilogue wraps the convolution and reuses its (possibly padded and
+  // cast) inputs
+  auto conv_primitive = conv.primitive_ptr();
+  std::vector<array> inputs = conv.inputs();
+  if (bias) {
+    inputs.push_back(astype(*bias, out_type, s));
+  }
+  bool has_bias = bias.has_value();
+  auto out_shape = conv.shape();
+  auto fallback = [conv_primitive, out_shape, out_type, has_bias, act, s](
+                      const std::vector<array>& inputs) {
+    auto out =
+        array(out_shape, out_type, conv_primitive, {inputs[0], inputs[1]});
+    if (has_bias) {
+      out = add(out, inputs[2], s);
+    }
+    switch (act) {
+      case Activation::ReLU:
+        out = maximum(out, array(0, out_type), s);
+        break;
+      case Activation::SiLU:
+        out = multiply(out, sigmoid(out, s), s);
+        break;
+      case Activation::GELU:
+        out = multiply(
+            multiply(out, array(0.5, out_type), s),
+            add(array(1, out_type),
+                erf(divide(out, array(std::sqrt(2.0f), out_type), s), s),
+                s),
+            s);
+        break;
+      default:
+        break;
+    }
+    return std::vector<array>{out};
+  };
+
+  auto stream = to_stream(s);
+  if (stream.device == Device::gpu) {
+    return array(
+        out_shape,
+        out_type,
+        std::make_shared<ConvolutionEpilogue>(
+            stream, fallback, conv_primitive, has_bias, act),
+        std::move(inputs));
+  }
+  return fallback(inputs)[0];
+}
+
+bool ConvolutionEpilogue::is_equivalent(const Primitive& other) const {
+  const ConvolutionEpilogue& c_other =
+      static_cast<const ConvolutionEpilogue&>(other);
+  return conv_->is_equivalent(*c_other.conv_) &&
+      has_bias_ == c_other.has_bias_ && activation_ == c_other.activation_;
+}
+
+bool ConvolutionWeightGrad::is_equivalent(const Primitive& other) const {
+  const ConvolutionWeightGrad& c_other =
+      static_cast<const ConvolutionWeightGrad&>(other);
+  return kernel_strides_ == c_other.kernel_strides_ &&
+      padding_ == c_other.padding_ &&
+      kernel_dilation_ == c_other.kernel_dilation_;
+}
+
+namespace {
+
+// The Metal attributes which are kernel arguments when the source uses them
+const std::vector<std::pair<std::string, std::string>> metal_attributes = {
+    {"dispatch_quadgroups_per_threadgroup", "uint"},
+    {"dispatch_simdgroups_per_threadgroup", "uint"},
+    {"dispatch_threads_per_threadgroup", "uint3"},
+    {"grid_origin", "uint3"},
+    {"grid_size", "uint3"},
+    {"quadgroup_index_in_threadgroup", "uint"},
+    {"quadgroups_per_threadgroup", "uint"},
+    {"simdgroup_index_in_threadgroup", "uint"},
+    {"simdgroups_per_threadgroup", "uint"},
+    {"thread_execution_width", "uint"},
+    {"thread_index_in_quadgroup", "uint"},
+    {"thread_index_in_simdgroup", "uint"},
+    {"thread_index_in_threadgroup", "uint"},
+    {"thread_position_in_grid", "uint3"},
+    {"thread_position_in_threadgroup", "uint3"},
+    {"threadgroup_position_in_grid", "uint3"},
+    {"threadgroups_per_grid", "uint3"},
+    {"threads_per_grid", "uint3"},
+    {"threads_per_simdgroup", "uint"},
+    {"threads_per_threadgroup", "uint3"},
+};
+
+bool uses_name(const std::string& source, const std::string& name) {
+  return std::regex_search(source, std::regex("\\b" + name + "\\b"));
+}
+
+std::string template_value(const TemplateArg& arg) {
+  if (auto v = std::get_if<int>(&arg)) {
+    return std::to_string(*v);
+  } else if (auto v = std::get_if<bool>(&arg)) {
+    return *v ? "true" : "false";
+  }
+  return get_type_string(std::get<Dtype>(arg));
+}
+
+std::string write_signature(
+    const std::string& func_name,
+    const std::vector<std::string>& input_names,
+    const std::vector<array>& inputs,
+    const std::vector<std::tuple<bool, bool, bool>>& shape_infos,
+    const std::vector<std::string>& output_names,
+    const std::vector<Dtype>& output_dtypes,
+    const std::vector<std::pair<std::string, TemplateArg>>& template_args,
+    const std::vector<std::pair<std::string, std::string>>& attributes,
+    bool atomic_outputs) {
+  // Small inputs are read from the constant address space
+  constexpr int max_constant_array_size = 8;
+
+  std::ostringstream sig;
+  if (!template_args.empty()) {
+    sig << "template <";
+    for (int i = 0; i < template_args.size(); i++) {
+      auto& [name, arg] = template_args[i];
+      if (std::holds_alternative<int>(arg)) {
+        sig << "int ";
+      } else if (std::holds_alternative<bool>(arg)) {
+        sig << "bool ";
+      } else {
+        sig << "typename ";
+      }
+      sig << name << (i + 1 < template_args.size() ? ", " : ">\n");
+    }
+  }
+
+  std::vector<std::string> args;
+  int index = 0;
+  auto buffer = [&index]() {
+    return " [[buffer(" + std::to_string(index++) + ")]]";
+  };
+  for (int i = 0; i < inputs.size(); i++) {
+    auto& name = input_names[i];
+    auto& in = inputs[i];
+    std::string location =
+        in.size() < max_constant_array_size ? "constant" : "device";
+    std::string ref = in.ndim() == 0 ? "&" : "*";
+    args.push_back(
+        "const " + location + " " + get_type_string(in.dtype()) + ref + " " +
+        name + buffer());
+    if (in.ndim() > 0) {
+      auto [shape, strides, ndim] = shape_infos[i];
+      if (shape) {
+        args.push_back("const constant int* " + name + "_shape" + buffer());
+      }
+      if (strides) {
+        args.push_back(
+            "const constant size_t* " + name + "_strides" + buffer());
+      }
+      if (ndim) {
+        args.push_back("const constant int& " + name + "_ndim" + buffer());
+      }
+    }
+  }
+  for (int i = 0; i < output_names.size(); i++) {
+    auto type = get_type_string(output_dtypes[i]);
+    if (atomic_outputs) {
+      type = "atomic<" + type + ">";
+    }
+    args.push_back("device " + type + "* " + output_names[i] + buffer());
+  }
+  for (auto& [attr, type] : attributes) {
+    args.push_back(type + " " + attr + " [[" + attr + "]]");
+  }
+
+  sig << "[[kernel]] void " << func_name << "(\n";
+  for (int i = 0; i < args.size(); i++) {
+    sig << "    " << args[i] << (i + 1 < args.size() ? ",\n" : ") {\n");
+  }
+  return sig.str();
+}
+
+} // namespace
+
+MetalKernelFunction metal_kernel(
+    const std::string& name,
+    const std::vector<std::string>& input_names,
+    const std::vector<std::string>& output_names,
+    const std::string& source,
+    const std::string& header /* = "" */,
+    bool ensure_row_contiguous /* = true */,
+    bool atomic_outputs /* = false */) {
+  if (output_names.empty()) {
+    throw std::invalid_argument(
+        "[metal_kernel] Must specify at least one output.");
+  }
+
+  // Find what the source uses once rather than on every call
+  std::vector<std::tuple<bool, bool, bool>> shape_infos;
+  for (auto& n : input_names) {
+    shape_infos.emplace_back(
+        uses_name(source, n + "_shape"),
+        uses_name(source, n + "_strides"),
+        uses_name(source, n + "_ndim"));
+  }
+  std::vector<std::pair<std::string, std::string>> attributes;
+  for (auto& attr : metal_attributes) {
+    if (uses_name(source, attr.first)) {
+      attributes.push_back(attr);
+    }
+  }
+
+  return [=](const std::vector<array>& inputs,
+             const std::vector<std::vector<int>>& output_shapes,
+             const std::vector<Dtype>& output_dtypes,
+             std::tuple<int, int, int> grid,
+             std::tuple<int, int, int> threadgroup,
+             const std::vector<std::pair<std::string, TemplateArg>>&
+                 template_args,
+             std::optional<float> init_value,
+             bool verbose,
+             StreamOrDevice s_) {
+    if (inputs.size() != input_names.size()) {
+      std::ostringstream msg;
+      msg << "[metal_kernel] Expected " << input_names.size()
+          << " inputs but got " << inputs.size() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    if (output_shapes.size() != output_names.size() ||
+        output_dtypes.size() != output_names.size()) {
+      std::ostringstream msg;
+      msg << "[metal_kernel] Expected " << output_names.size()
+          << " output shapes and dtypes but got " << output_shapes.size()
+          << " and " << output_dtypes.size() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    auto s = to_stream(s_);
+    if (s.device != Device::gpu) {
+      throw std::invalid_argument("[metal_kernel] Only supports the GPU.");
+    }
+
+    // Specializations are told apart by their template arguments in the
+    // kernel name and by a hash of their source in the library name
+    std::string func_name = "custom_kernel_" + name;
+    std::string kernel_name = func_name;
+    std::string template_def;
+    if (!template_args.empty()) {
+      std::ostringstream def;
+      def << "<";
+      for (int i = 0; i < template_args.size(); i++) {
+        def << (i > 0 ? ", " : "") << template_value(template_args[i].second);
+      }
+      def << ">";
+      template_def = def.str();
+      kernel_name += std::regex_replace(
+          template_def.substr(0, template_def.size() - 1),
+          std::regex("[^a-zA-Z0-9_]+"),
+          "_");
+    }
+
+    std::string kernel_source = header;
+    kernel_source += write_signature(
+        func_name,
+        input_names,
+        inputs,
+        shape_infos,
+        output_names,
+        output_dtypes,
+        template_args,
+        attributes,
+        atomic_outputs);
+    kernel_source += source + "\n}\n";
+    if (!template_args.empty()) {
+      kernel_source += "\ntemplate [[host_name(\"" + kernel_name +
+          "\")]] [[kernel]] decltype(" + func_name + template_def + ") " +
+          func_name + template_def + ";\n";
+    }
+    if (verbose) {
+      std::cout << "Generated source code for `" << kernel_name << "`:"
+                << std::endl
+                << "```" << std::endl
+                << kernel_source << std::endl
+                << "```" << std::endl;
+    }
+    std::string lib_name = kernel_name + "_" +
+        std::to_string(std::hash<std::string>{}(kernel_source));
+
+    return array::make_arrays(
+        output_shapes,
+        output_dtypes,
+        std::make_shared<CustomKernel>(
+            s,
+            kernel_name,
+            lib_name,
+            kernel_source,
+            grid,
+            threadgroup,
+            shape_infos,
+            ensure_row_contiguous,
+            init_value),
+        inputs);
+  };
 }
 
 } // namespace mlx::core::fast
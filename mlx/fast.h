@@ -2,7 +2,12 @@
 
 #pragma once
 
+#include <list>
 #include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 
 #include "mlx/utils.h"
 
@@ -14,6 +19,17 @@ array rms_norm(
     float eps,
     StreamOrDevice s = {});
 
+/**
+ * Adds the residual to x and RMS normalizes the sum in one pass. Returns the
+ * normalized sum and the sum itself, which is the residual of the next layer.
+ **/
+std::pair<array, array> rms_norm_residual(
+    const array& x,
+    const array& residual,
+    const array& weight,
+    float eps,
+    StreamOrDevice s = {});
+
 array layer_norm(
     const array& x,
     const std::optional<array>& weight,
@@ -21,13 +37,102 @@ array layer_norm(
     float eps,
     StreamOrDevice s = {});
 
+/** Normalizes each group of channels over the positions of every sample. */
+array group_norm(
+    const array& x,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    int num_groups,
+    float eps,
+    bool pytorch_compatible = false,
+    StreamOrDevice s = {});
+
+/** Normalizes each channel with the statistics of the whole batch. */
+array batch_norm(
+    const array& x,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    float eps,
+    StreamOrDevice s = {});
+
+/** Computes the mean and variance over the given axes in a single pass. */
+std::pair<array, array> mean_var(
+    const array& x,
+    const std::vector<int>& axes,
+    bool keepdims = false,
+    int ddof = 0,
+    StreamOrDevice s = {});
+
+/**
+ * Cross entropy between the logits, normalized over their last axis, and the
+ * integer targets, which have the shape of the logits without the last axis.
+ * The log-sum-exp and the target logit are found in one pass and the
+ * gradient is written as softmax - onehot directly. Targets outside of
+ * [0, vocabulary size) are ignored and give a zero loss.
+ **/
+array cross_entropy(
+    const array& logits,
+    const array& targets,
+    StreamOrDevice s = {});
+
+/**
+ * Adam updates of lists of parameters with their gradients and first and
+ * second moments. All the tensors are updated by one fused kernel, encoded
+ * as concurrent dispatches, instead of a dozen elementwise ops each. The
+ * parameters are first decayed by (1 - learning_rate * weight_decay) which
+ * gives AdamW. Returns the new parameters and moments.
+ **/
+std::tuple<std::vector<array>, std::vector<array>, std::vector<array>>
+adam_update(
+    const std::vector<array>& parameters,
+    const std::vector<array>& gradients,
+    const std::vector<array>& m,
+    const std::vector<array>& v,
+    const array& learning_rate,
+    float beta1,
+    float beta2,
+    float eps,
+    float weight_decay = 0.0f,
+    StreamOrDevice s = {});
+
+/**
+ * Lion updates of lists of parameters with their gradients and momenta in
+ * one fused kernel. Returns the new parameters and momenta.
+ **/
+std::pair<std::vector<array>, std::vector<array>> lion_update(
+    const std::vector<array>& parameters,
+    const std::vector<array>& gradients,
+    const std::vector<array>& m,
+    const array& learning_rate,
+    float beta1,
+    float beta2,
+    float weight_decay = 0.0f,
+    StreamOrDevice s = {});
+
 array rope(
     const array& x,
     int dims,
     bool traditional,
-    float base,
+    std::optional<float> base,
     float scale,
     int offset,
+    const std::optional<array>& freqs = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Applies rotary positional encoding with an offset per sequence. The offset
+ * is a scalar or has one entry per element of the first axis of x. The
+ * frequencies, if given, replace ``base ** (2 * i / dims)`` for the i-th
+ * rotated pair, in which case the base must not be given.
+ **/
+array rope(
+    const array& x,
+    int dims,
+    bool traditional,
+    std::optional<float> base,
+    float scale,
+    const array& offset,
+    const std::optional<array>& freqs = std::nullopt,
     StreamOrDevice s = {});
 
 /** Computes: O = softmax(Q @ K.T) @ V **/
@@ -39,4 +144,281 @@ array scaled_dot_product_attention(
     const std::optional<array>& mask = std::nullopt,
     StreamOrDevice s = {});
 
+/**
+ * Computes: O = softmax(Q @ K.T) @ V with a mask mode. The mode "causal"
+ * lets query i attend to the keys up to i + kL - qL, aligning the last query
+ * with the last key. An optional mask is applied on top of it.
+ **/
+array scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& values,
+    const float scale,
+    const std::string& mask_mode,
+    const std::optional<array>& mask = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Computes: O = softmax(Q @ K.T) @ V with positional masking. With a
+ * window_size w > 0 query i only attends to the keys j with
+ * i + kL - qL - j < w, and ALiBi slopes of shape (n_q_heads,) add
+ * slope * (j - i - kL + qL) to the scores of each head. The mask mode is
+ * "causal" or empty.
+ **/
+array scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& values,
+    const float scale,
+    const std::string& mask_mode,
+    int window_size,
+    const std::optional<array>& alibi_slopes = std::nullopt,
+    const std::optional<array>& mask = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Computes: O = softmax(Q @ K.T) @ V with the keys and values quantized
+ * along their last axis as returned by quantize.
+ **/
+array quantized_scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& key_scales,
+    const array& key_biases,
+    const array& values,
+    const array& value_scales,
+    const array& value_biases,
+    const float scale,
+    const std::optional<array>& mask = std::nullopt,
+    int group_size = 64,
+    int bits = 4,
+    StreamOrDevice s = {});
+
+/**
+ * Computes: O = softmax(Q @ K.T) @ V for one query per sequence with the
+ * keys and values of the sequences stored in pages of the caches of shape
+ * (num_blocks, n_kv_heads, block_size, head_dim). Row i of block_tables
+ * lists the pages of sequence i which attends to its first
+ * context_lengths[i] keys.
+ **/
+array paged_attention(
+    const array& queries,
+    const array& key_cache,
+    const array& value_cache,
+    const array& block_tables,
+    const array& context_lengths,
+    const float scale,
+    StreamOrDevice s = {});
+
+/**
+ * A pool of key and value pages for paged_attention in which the sequences
+ * starting with the same tokens, e.g. the same system prompt, share the
+ * pages of their common prefix.
+ *
+ * Full pages are indexed by a hash of their tokens and of all the tokens
+ * before them once their keys and values are written. A new sequence reuses
+ * the pages of the longest indexed prefix of its tokens, leaving at least
+ * its last token to compute. Indexed pages no sequence uses are kept until
+ * a page is needed and the pool can't grow, least recently used first. The
+ * pool starts small and doubles up to max_blocks pages while the active
+ * memory stays under the memory limit, see metal::set_memory_limit.
+ **/
+class PrefixCache {
+ public:
+  PrefixCache(
+      int max_blocks,
+      int n_kv_heads,
+      int block_size,
+      int head_dim,
+      Dtype dtype = float16,
+      StreamOrDevice s = {});
+
+  /** The key pages of shape (num_blocks, n_kv_heads, block_size, head_dim).
+   */
+  const array& keys() const {
+    return keys_;
+  }
+
+  /** The value pages with the same shape as the keys. */
+  const array& values() const {
+    return values_;
+  }
+
+  int block_size() const {
+    return block_size_;
+  }
+
+  /** Starts a sequence with the given tokens. Returns its id and the number
+   * of its leading tokens whose keys and values are already in its pages.
+   */
+  std::pair<int, int> acquire(const std::vector<int>& tokens);
+
+  /** Appends tokens to a sequence, e.g. the generated ones. */
+  void extend(int seq, const std::vector<int>& tokens);
+
+  /** Writes the keys and values of shape (n_kv_heads, n, head_dim) of the
+   * sequence's tokens [start, start + n). The tokens before start must have
+   * been written already. */
+  void write(int seq, int start, const array& keys, const array& values);
+
+  /** The pages of the sequence in order, a row of the block table. */
+  const std::vector<int>& block_table(int seq) const;
+
+  /** Ends the sequence. Its indexed pages stay in the pool for reuse. */
+  void release(int seq);
+
+ private:
+  struct Block {
+    int refs{0};
+    bool indexed{false};
+    uint64_t hash;
+    // The hash of the blocks before and the tokens of the block, checked on
+    // a hit so a collision is never reused
+    uint64_t parent;
+    std::vector<int> tokens;
+    std::list<int>::iterator lru;
+  };
+
+  struct Sequence {
+    std::vector<int> tokens;
+    std::vector<int> blocks;
+    // The hashes of the leading indexed or shared blocks
+    std::vector<uint64_t> hashes;
+    int written{0};
+  };
+
+  Sequence& sequence_(int seq);
+
+  // Returns a block with no tokens, growing the pool or evicting the least
+  // recently used unused indexed block if there is no free block
+  int allocate_();
+
+  // Adds the blocks to cover the tokens of the sequence
+  void reserve_(Sequence& s);
+
+  // Indexes the full written blocks of the sequence
+  void index_(Sequence& s);
+
+  int max_blocks_;
+  int block_size_;
+  Dtype dtype_;
+  Stream stream_;
+  array keys_;
+  array values_;
+  std::vector<Block> blocks_;
+  std::vector<int> free_;
+  std::list<int> lru_;
+  std::unordered_map<uint64_t, int> index_map_;
+  std::unordered_map<int, Sequence> sequences_;
+  int next_seq_{0};
+};
+
+/**
+ * Computes: silu(gate) * (x @ w.T + bias) + residual with w quantized as
+ * returned by quantize, or x @ w without the transpose. Each of bias, gate
+ * and residual is optional and applied in the epilogue of the matmul.
+ **/
+array quantized_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    bool transpose = true,
+    int group_size = 64,
+    int bits = 4,
+    const std::optional<array>& bias = std::nullopt,
+    const std::optional<array>& gate = std::nullopt,
+    const std::optional<array>& residual = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Computes x @ w.T with w quantized to 8 bits as returned by quantize and x
+ * quantized dynamically to int8 with a scale per row. The products are
+ * accumulated in int32 within the groups of w, which trades the precision
+ * of the activations for integer throughput in prefill.
+ **/
+array quantized_matmul_w8a8(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    int group_size = 64,
+    StreamOrDevice s = {});
+
+/**
+ * Computes x @ w.T + scale * (x @ lora_a.T) @ lora_b.T with w quantized as
+ * returned by quantize, the low-rank update of a LoRA adapter being added in
+ * the quantized matmul. With adapter_ids, lora_a and lora_b stack the
+ * matrices of several adapters, (n, r, D) and (n, O, r), and each row of x
+ * uses the adapter of its id.
+ **/
+array quantized_lora_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& lora_a,
+    const array& lora_b,
+    float scale = 1.0f,
+    const std::optional<array>& adapter_ids = std::nullopt,
+    int group_size = 64,
+    int bits = 4,
+    StreamOrDevice s = {});
+
+/**
+ * Computes activation(conv_general(input, weight, ...) + bias) with the bias
+ * and activation applied in the epilogue of the convolution. The activation
+ * is one of "relu", "silu" or "gelu", or empty for none.
+ **/
+array conv_general(
+    const array& input,
+    const array& weight,
+    std::vector<int> stride = {},
+    std::vector<int> padding_lo = {},
+    std::vector<int> padding_hi = {},
+    std::vector<int> kernel_dilation = {},
+    std::vector<int> input_dilation = {},
+    int groups = 1,
+    bool flip = false,
+    const std::optional<array>& bias = std::nullopt,
+    const std::string& activation = "",
+    StreamOrDevice s = {});
+
+using TemplateArg = std::variant<int, bool, Dtype>;
+
+/**
+ * A kernel made by metal_kernel. Called with the inputs, the shapes and
+ * dtypes of the outputs, the grid and threadgroup sizes, the template
+ * arguments, an optional value the outputs are filled with before the kernel
+ * runs and whether to print the generated source.
+ **/
+using MetalKernelFunction = std::function<std::vector<array>(
+    const std::vector<array>& inputs,
+    const std::vector<std::vector<int>>& output_shapes,
+    const std::vector<Dtype>& output_dtypes,
+    std::tuple<int, int, int> grid,
+    std::tuple<int, int, int> threadgroup,
+    const std::vector<std::pair<std::string, TemplateArg>>& template_args,
+    std::optional<float> init_value,
+    bool verbose,
+    StreamOrDevice s)>;
+
+/**
+ * Makes a custom Metal kernel from the body of its function. The signature
+ * is generated from the names, dtypes and shapes of the inputs and outputs
+ * and the template arguments of each call. The body can use
+ * ``<name>_shape``, ``<name>_strides`` and ``<name>_ndim`` of an input and
+ * Metal attributes such as ``thread_position_in_grid``, which are added to
+ * the signature when they appear in the source. Libraries and pipelines are
+ * compiled once per specialization and cached.
+ **/
+MetalKernelFunction metal_kernel(
+    const std::string& name,
+    const std::vector<std::string>& input_names,
+    const std::vector<std::string>& output_names,
+    const std::string& source,
+    const std::string& header = "",
+    bool ensure_row_contiguous = true,
+    bool atomic_outputs = false);
+
 } // namespace mlx::core::fast
@@ -48,6 +48,13 @@ class RMSNorm : public Custom {
   void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
       override;
 
+  DEFINE_VMAP()
+
+  std::vector<array> jvp(
+      const std::vector<array>& primals,
+      const std::vector<array>& tangents,
+      const std::vector<int>& argnums) override;
+
   std::vector<array> vjp(
       const std::vector<array>& primals,
       const std::vector<array>& cotangents,
@@ -62,6 +69,35 @@ class RMSNorm : public Custom {
   float eps_;
 };
 
+class RMSNormResidual : public Custom {
+ public:
+  RMSNormResidual(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float eps)
+      : Custom(stream, fallback), eps_(eps) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_PRINT(RMSNormResidual)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  std::function<std::vector<array>(std::vector<array>)> fallback_;
+  float eps_;
+};
+
 class RMSNormVJP : public Custom {
  public:
   RMSNormVJP(
@@ -100,6 +136,13 @@ class LayerNorm : public Custom {
   void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
       override;
 
+  DEFINE_VMAP()
+
+  std::vector<array> jvp(
+      const std::vector<array>& primals,
+      const std::vector<array>& tangents,
+      const std::vector<int>& argnums) override;
+
   std::vector<array> vjp(
       const std::vector<array>& primals,
       const std::vector<array>& cotangents,
@@ -137,6 +180,204 @@ class LayerNormVJP : public Custom {
   float eps_;
 };
 
+class GroupNorm : public Custom {
+ public:
+  GroupNorm(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int num_groups,
+      float eps,
+      bool pytorch_compatible)
+      : Custom(stream, fallback),
+        num_groups_(num_groups),
+        eps_(eps),
+        pytorch_compatible_(pytorch_compatible) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_PRINT(GroupNorm)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  std::function<std::vector<array>(std::vector<array>)> fallback_;
+  int num_groups_;
+  float eps_;
+  bool pytorch_compatible_;
+};
+
+class GroupNormVJP : public Custom {
+ public:
+  GroupNormVJP(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int num_groups,
+      float eps,
+      bool pytorch_compatible)
+      : Custom(stream, fallback),
+        num_groups_(num_groups),
+        eps_(eps),
+        pytorch_compatible_(pytorch_compatible) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(GroupNormVJP)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  std::function<std::vector<array>(std::vector<array>)> fallback_;
+  int num_groups_;
+  float eps_;
+  bool pytorch_compatible_;
+};
+
+class MeanVar : public Custom {
+ public:
+  MeanVar(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      std::vector<int> axes,
+      bool keepdims,
+      int ddof)
+      : Custom(stream, fallback),
+        axes_(std::move(axes)),
+        keepdims_(keepdims),
+        ddof_(ddof) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(MeanVar)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  std::vector<int> axes_;
+  bool keepdims_;
+  int ddof_;
+};
+
+class CrossEntropy : public Custom {
+ public:
+  CrossEntropy(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_PRINT(CrossEntropy)
+  DEFINE_DEFAULT_IS_EQUIVALENT()
+};
+
+class CrossEntropyVJP : public Custom {
+ public:
+  CrossEntropyVJP(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(CrossEntropyVJP)
+  DEFINE_DEFAULT_IS_EQUIVALENT()
+};
+
+class AdamUpdate : public Custom {
+ public:
+  AdamUpdate(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float beta1,
+      float beta2,
+      float eps,
+      float weight_decay)
+      : Custom(stream, fallback),
+        beta1_(beta1),
+        beta2_(beta2),
+        eps_(eps),
+        weight_decay_(weight_decay) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(AdamUpdate)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  float beta1_;
+  float beta2_;
+  float eps_;
+  float weight_decay_;
+};
+
+class LionUpdate : public Custom {
+ public:
+  LionUpdate(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float beta1,
+      float beta2,
+      float weight_decay)
+      : Custom(stream, fallback),
+        beta1_(beta1),
+        beta2_(beta2),
+        weight_decay_(weight_decay) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(LionUpdate)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  float beta1_;
+  float beta2_;
+  float weight_decay_;
+};
+
 class RoPE : public Custom {
  public:
   RoPE(
@@ -146,14 +387,12 @@ class RoPE : public Custom {
       bool traditional,
       float base,
       float scale,
-      int offset,
       bool forward)
       : Custom(stream, fallback),
         dims_(dims),
         traditional_(traditional),
         base_(base),
         scale_(scale),
-        offset_(offset),
         forward_(forward) {}
 
   void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
@@ -163,6 +402,13 @@ class RoPE : public Custom {
   void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
       override;
 
+  DEFINE_VMAP()
+
+  std::vector<array> jvp(
+      const std::vector<array>& primals,
+      const std::vector<array>& tangents,
+      const std::vector<int>& argnums) override;
+
   std::vector<array> vjp(
       const std::vector<array>& primals,
       const std::vector<array>& cotangents,
@@ -178,7 +424,6 @@ class RoPE : public Custom {
   bool traditional_;
   float base_;
   float scale_;
-  int offset_;
   bool forward_;
 };
 
@@ -188,8 +433,17 @@ class ScaledDotProductAttention : public Custom {
       Stream stream,
       std::function<std::vector<array>(std::vector<array>)> fallback,
       const float scale,
-      const bool needs_mask)
-      : Custom(stream, fallback), scale_(scale), needs_mask_(needs_mask) {}
+      const bool needs_mask,
+      const bool do_causal = false,
+      const int window_size = 0,
+      const bool has_alibi = false)
+      : Custom(stream, fallback),
+        fallback_(fallback),
+        scale_(scale),
+        needs_mask_(needs_mask),
+        do_causal_(do_causal),
+        window_size_(window_size),
+        has_alibi_(has_alibi) {}
 
   void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
       override {
@@ -202,6 +456,20 @@ class ScaledDotProductAttention : public Custom {
   }
 
   void eval_gpu(const std::vector<array>& inputs, array& out);
+
+  DEFINE_VMAP()
+
+  std::vector<array> jvp(
+      const std::vector<array>& primals,
+      const std::vector<array>& tangents,
+      const std::vector<int>& argnums) override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
   bool is_equivalent(const Primitive& other) const override;
 
   DEFINE_PRINT(ScaledDotProductAttention);
@@ -210,6 +478,336 @@ class ScaledDotProductAttention : public Custom {
   std::function<std::vector<array>(std::vector<array>)> fallback_;
   float scale_;
   bool needs_mask_;
+  bool do_causal_;
+  int window_size_;
+  bool has_alibi_;
+};
+
+// Computes the gradients of the queries, keys and values of the attention
+// from its inputs, output and output cotangent recomputing the attention
+// probabilities instead of storing them
+class ScaledDotProductAttentionVJP : public Custom {
+ public:
+  ScaledDotProductAttentionVJP(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      const float scale,
+      const bool needs_mask,
+      const bool do_causal,
+      const int window_size = 0,
+      const bool has_alibi = false)
+      : Custom(stream, fallback),
+        scale_(scale),
+        needs_mask_(needs_mask),
+        do_causal_(do_causal),
+        window_size_(window_size),
+        has_alibi_(has_alibi) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(ScaledDotProductAttentionVJP)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  std::function<std::vector<array>(std::vector<array>)> fallback_;
+  float scale_;
+  bool needs_mask_;
+  bool do_causal_;
+  int window_size_;
+  bool has_alibi_;
+};
+
+class QuantizedScaledDotProductAttention : public Custom {
+ public:
+  explicit QuantizedScaledDotProductAttention(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      const float scale,
+      const bool needs_mask,
+      const int group_size,
+      const int bits)
+      : Custom(stream, fallback),
+        scale_(scale),
+        needs_mask_(needs_mask),
+        group_size_(group_size),
+        bits_(bits) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override;
+
+  DEFINE_PRINT(QuantizedScaledDotProductAttention);
+
+ private:
+  std::function<std::vector<array>(std::vector<array>)> fallback_;
+  float scale_;
+  bool needs_mask_;
+  int group_size_;
+  int bits_;
+};
+
+class PagedAttention : public Custom {
+ public:
+  explicit PagedAttention(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      const float scale)
+      : Custom(stream, fallback), scale_(scale) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override;
+
+  DEFINE_PRINT(PagedAttention);
+
+ private:
+  std::function<std::vector<array>(std::vector<array>)> fallback_;
+  float scale_;
+};
+
+class RaggedAttention : public Custom {
+ public:
+  explicit RaggedAttention(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      const float scale,
+      const bool do_causal)
+      : Custom(stream, fallback), scale_(scale), do_causal_(do_causal) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override;
+
+  DEFINE_PRINT(RaggedAttention);
+
+ private:
+  float scale_;
+  bool do_causal_;
+};
+
+class QuantizedMatmulEpilogue : public Custom {
+ public:
+  explicit QuantizedMatmulEpilogue(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int group_size,
+      int bits,
+      bool has_bias,
+      bool has_gate,
+      bool has_residual,
+      bool has_lora = false,
+      bool has_adapter_ids = false)
+      : Custom(stream, fallback),
+        group_size_(group_size),
+        bits_(bits),
+        has_bias_(has_bias),
+        has_gate_(has_gate),
+        has_residual_(has_residual),
+        has_lora_(has_lora),
+        has_adapter_ids_(has_adapter_ids) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override;
+
+  DEFINE_PRINT(QuantizedMatmulEpilogue);
+
+ private:
+  int group_size_;
+  int bits_;
+  bool has_bias_;
+  bool has_gate_;
+  bool has_residual_;
+  bool has_lora_;
+  bool has_adapter_ids_;
+};
+
+// The matmul of int8 activations quantized per row with their scales and of
+// 8 bit quantized weights, accumulated in int32 per group of the weights
+class QuantizedMatmulW8A8 : public Custom {
+ public:
+  explicit QuantizedMatmulW8A8(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int group_size)
+      : Custom(stream, fallback), group_size_(group_size) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override;
+
+  DEFINE_PRINT(QuantizedMatmulW8A8);
+
+ private:
+  int group_size_;
+};
+
+class ConvolutionEpilogue : public Custom {
+ public:
+  // Must match the activations of the Metal conv epilogue
+  enum Activation { None = 0, ReLU = 1, SiLU = 2, GELU = 3 };
+
+  explicit ConvolutionEpilogue(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      std::shared_ptr<Primitive> conv,
+      bool has_bias,
+      Activation activation)
+      : Custom(stream, fallback),
+        conv_(std::move(conv)),
+        has_bias_(has_bias),
+        activation_(activation) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override;
+
+  DEFINE_PRINT(ConvolutionEpilogue);
+
+ private:
+  // The Convolution primitive that computes the output before the epilogue
+  std::shared_ptr<Primitive> conv_;
+  bool has_bias_;
+  Activation activation_;
+};
+
+// The gradient of a convolution without input dilation with respect to its
+// weight. The inputs are the input of the convolution and the cotangent.
+class ConvolutionWeightGrad : public Custom {
+ public:
+  explicit ConvolutionWeightGrad(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      std::vector<int> kernel_strides,
+      std::vector<int> padding,
+      std::vector<int> kernel_dilation)
+      : Custom(stream, fallback),
+        kernel_strides_(std::move(kernel_strides)),
+        padding_(std::move(padding)),
+        kernel_dilation_(std::move(kernel_dilation)) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override;
+
+  DEFINE_PRINT(ConvolutionWeightGrad);
+
+ private:
+  std::vector<int> kernel_strides_;
+  std::vector<int> padding_;
+  std::vector<int> kernel_dilation_;
+};
+
+class CustomKernel : public Primitive {
+ public:
+  CustomKernel(
+      Stream stream,
+      std::string name,
+      std::string lib_name,
+      std::string source,
+      std::tuple<int, int, int> grid,
+      std::tuple<int, int, int> threadgroup,
+      std::vector<std::tuple<bool, bool, bool>> shape_infos,
+      bool ensure_row_contiguous,
+      std::optional<float> init_value)
+      : Primitive(stream),
+        name_(std::move(name)),
+        lib_name_(std::move(lib_name)),
+        source_(std::move(source)),
+        grid_(grid),
+        threadgroup_(threadgroup),
+        shape_infos_(std::move(shape_infos)),
+        ensure_row_contiguous_(ensure_row_contiguous),
+        init_value_(init_value) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("Custom Metal kernels only run on the GPU.");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(CustomKernel);
+
+ private:
+  std::string name_;
+  std::string lib_name_;
+  std::string source_;
+  std::tuple<int, int, int> grid_;
+  std::tuple<int, int, int> threadgroup_;
+  // Whether the shape, strides and ndim of each input are kernel arguments
+  std::vector<std::tuple<bool, bool, bool>> shape_infos_;
+  bool ensure_row_contiguous_;
+  std::optional<float> init_value_;
 };
 
 } // namespace mlx::core::fast
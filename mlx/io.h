@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <functional>
 #include <variant>
 
 #include "mlx/array.h"
@@ -31,6 +32,37 @@ array load(std::shared_ptr<io::Reader> in_stream, StreamOrDevice s = {});
 /** Load array from file in .npy format */
 array load(std::string file, StreamOrDevice s = {});
 
+/* Load array map from reader in .npz format.
+ *
+ * Stored members are loaded lazily like .npy files. Deflated members are read
+ * and decompressed concurrently on the I/O thread pool, which needs MLX to be
+ * built with zlib.
+ * */
+std::unordered_map<std::string, array> load_npz(
+    std::shared_ptr<io::Reader> in_stream,
+    StreamOrDevice s = {});
+
+/** Load array map from file in .npz format */
+std::unordered_map<std::string, array> load_npz(
+    const std::string& file,
+    StreamOrDevice s = {});
+
+/* Save array map to out stream in .npz format.
+ *
+ * The stream must be seekable. Members are deflated if compressed is true,
+ * which needs MLX to be built with zlib.
+ * */
+void savez(
+    std::shared_ptr<io::Writer> out_stream,
+    const std::unordered_map<std::string, array>& arrays,
+    bool compressed = false);
+
+/** Save array map to file in .npz format */
+void savez(
+    std::string file,
+    const std::unordered_map<std::string, array>& arrays,
+    bool compressed = false);
+
 /** Load array map from .safetensors file format */
 SafetensorsLoad load_safetensors(
     std::shared_ptr<io::Reader> in_stream,
@@ -39,6 +71,33 @@ SafetensorsLoad load_safetensors(
     const std::string& file,
     StreamOrDevice s = {});
 
+/* Selects the tensors of a sharded checkpoint a process loads.
+ *
+ * Tensors for which filter returns false are skipped. Tensors for which
+ * split_axis returns an axis are split into world_size equal parts along that
+ * axis and only part rank is loaded. Pass a distributed::Group's rank() and
+ * size() to shard a checkpoint for tensor parallelism.
+ * */
+struct SafetensorsShardSpec {
+  std::function<bool(const std::string& name)> filter;
+  std::function<int(const std::string& name, const std::vector<int>& shape)>
+      split_axis;
+  int rank{0};
+  int world_size{1};
+};
+
+/* Load array map from a checkpoint split across several .safetensors files
+ * listed in a model.safetensors.index.json style index.
+ *
+ * Only the headers of the files are read eagerly. Splits along the first
+ * non-singleton axis read just the bytes of the part that is loaded, other
+ * splits read the whole tensor.
+ * */
+SafetensorsLoad load_safetensors_sharded(
+    const std::string& index_file,
+    const SafetensorsShardSpec& spec = {},
+    StreamOrDevice s = {});
+
 void save_safetensors(
     std::shared_ptr<io::Writer> in_stream,
     std::unordered_map<std::string, array>,
@@ -48,6 +107,58 @@ void save_safetensors(
     std::unordered_map<std::string, array>,
     std::unordered_map<std::string, std::string> metadata = {});
 
+/* Streams the weights of a model which does not fit in memory from the
+ * files they were loaded from, one layer at a time.
+ *
+ * The layers are unevaluated weights returned by the load functions, in the
+ * order the model uses them. Getting a layer starts reading the next
+ * lookahead layers in the background, through the OS for memory mapped
+ * files and on the load stream for other files. Each use of a layer reads
+ * its weights again, so they are freed once the caller drops them. The
+ * pages of mapped layers outside of the lookahead are released when they
+ * and the active memory exceed the memory limit.
+ * */
+class WeightStreamer {
+ public:
+  using Layer = std::unordered_map<std::string, array>;
+
+  explicit WeightStreamer(std::vector<Layer> layers, int lookahead = 1);
+
+  /** The number of layers. */
+  size_t size() const {
+    return layers_.size();
+  }
+
+  /** The weights of layer i for one use. */
+  Layer layer(int i);
+
+ private:
+  // The bytes of a weight in a memory mapped file
+  struct MappedRange {
+    std::shared_ptr<io::MappedFile> file;
+    size_t offset;
+    size_t size;
+  };
+
+  // Unevaluated copies of the weights of layer i
+  Layer read_(int i) const;
+
+  // Marks layer i as the most recently used resident layer
+  void touch_(int i);
+
+  // Releases the least recently used layers outside of the window starting
+  // at layer i while over the memory limit
+  void evict_(int i);
+
+  std::vector<Layer> layers_;
+  std::vector<std::vector<MappedRange>> ranges_;
+  std::vector<size_t> mapped_bytes_;
+  int lookahead_;
+  std::unordered_map<int, Layer> prefetched_;
+  std::vector<int> resident_;
+  size_t resident_bytes_{0};
+};
+
 /** Load array map and metadata from .gguf file format */
 
 GGUFLoad load_gguf(const std::string& file, StreamOrDevice s = {});
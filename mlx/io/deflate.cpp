@@ -0,0 +1,122 @@
+// Copyright © 2024 Apple Inc.
+
+#include <zlib.h>
+
+#include <limits>
+#include <stdexcept>
+
+#include "mlx/io/deflate.h"
+
+namespace mlx::core::io::detail {
+
+namespace {
+
+// zlib counts bytes with 32 bit integers
+constexpr size_t max_chunk = std::numeric_limits<uInt>::max();
+
+// The size of the compressed output passed to the callback at once
+constexpr size_t output_size = 1 << 18;
+
+} // namespace
+
+bool deflate_available() {
+  return true;
+}
+
+uint32_t crc32(uint32_t crc, const char* data, size_t n) {
+  while (n > 0) {
+    auto chunk = std::min(n, max_chunk);
+    crc = ::crc32(crc, reinterpret_cast<const Bytef*>(data), chunk);
+    data += chunk;
+    n -= chunk;
+  }
+  return crc;
+}
+
+std::vector<char> inflate(const char* data, size_t n, size_t size) {
+  std::vector<char> out(size);
+  z_stream stream{};
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+    throw std::runtime_error("[inflate] Failed to initialize zlib.");
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream.next_out = reinterpret_cast<Bytef*>(out.data());
+  size_t in_left = n;
+  size_t out_left = size;
+  int ret = Z_OK;
+  while (ret == Z_OK) {
+    if (stream.avail_in == 0) {
+      stream.avail_in = std::min(in_left, max_chunk);
+      in_left -= stream.avail_in;
+    }
+    if (stream.avail_out == 0) {
+      stream.avail_out = std::min(out_left, max_chunk);
+      out_left -= stream.avail_out;
+    }
+    ret = ::inflate(&stream, Z_NO_FLUSH);
+    if (ret == Z_BUF_ERROR && (in_left > 0 || out_left > 0)) {
+      ret = Z_OK;
+    }
+  }
+  bool complete = ret == Z_STREAM_END && stream.avail_out == 0 && out_left == 0;
+  inflateEnd(&stream);
+  if (!complete) {
+    throw std::runtime_error("[inflate] Invalid or truncated deflate data.");
+  }
+  return out;
+}
+
+Deflater::Deflater(Output out) : out_(std::move(out)), buffer_(output_size) {
+  auto stream = new z_stream{};
+  if (deflateInit2(
+          stream,
+          Z_DEFAULT_COMPRESSION,
+          Z_DEFLATED,
+          -MAX_WBITS,
+          8,
+          Z_DEFAULT_STRATEGY) != Z_OK) {
+    delete stream;
+    throw std::runtime_error("[Deflater] Failed to initialize zlib.");
+  }
+  stream_ = stream;
+}
+
+Deflater::~Deflater() {
+  auto stream = static_cast<z_stream*>(stream_);
+  deflateEnd(stream);
+  delete stream;
+}
+
+void Deflater::write(const char* data, size_t n) {
+  auto stream = static_cast<z_stream*>(stream_);
+  while (n > 0) {
+    auto chunk = std::min(n, max_chunk);
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream->avail_in = chunk;
+    do {
+      stream->next_out = reinterpret_cast<Bytef*>(buffer_.data());
+      stream->avail_out = buffer_.size();
+      ::deflate(stream, Z_NO_FLUSH);
+      out_(buffer_.data(), buffer_.size() - stream->avail_out);
+    } while (stream->avail_out == 0);
+    data += chunk;
+    n -= chunk;
+  }
+}
+
+void Deflater::finish() {
+  auto stream = static_cast<z_stream*>(stream_);
+  stream->avail_in = 0;
+  int ret;
+  do {
+    stream->next_out = reinterpret_cast<Bytef*>(buffer_.data());
+    stream->avail_out = buffer_.size();
+    ret = ::deflate(stream, Z_FINISH);
+    out_(buffer_.data(), buffer_.size() - stream->avail_out);
+  } while (ret == Z_OK);
+  if (ret != Z_STREAM_END) {
+    throw std::runtime_error("[Deflater] Failed to compress.");
+  }
+}
+
+} // namespace mlx::core::io::detail
@@ -0,0 +1,46 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace mlx::core::io::detail {
+
+/** Whether MLX was built with zlib and can read and write deflated data. */
+bool deflate_available();
+
+/** Update a CRC-32 checksum, as used in zip archives, with n bytes. */
+uint32_t crc32(uint32_t crc, const char* data, size_t n);
+
+/** Decompress raw deflate data that is known to decompress to size bytes. */
+std::vector<char> inflate(const char* data, size_t n, size_t size);
+
+/* Compresses a stream of bytes with raw deflate as used in zip archives.
+ *
+ * The compressed bytes are passed to the output callback as they are
+ * produced.
+ * */
+class Deflater {
+ public:
+  using Output = std::function<void(const char*, size_t)>;
+
+  explicit Deflater(Output out);
+  ~Deflater();
+
+  Deflater(const Deflater&) = delete;
+  Deflater& operator=(const Deflater&) = delete;
+
+  void write(const char* data, size_t n);
+
+  /** Flush the remaining compressed bytes, no more data can be written. */
+  void finish();
+
+ private:
+  void* stream_{nullptr};
+  Output out_;
+  std::vector<char> buffer_;
+};
+
+} // namespace mlx::core::io::detail
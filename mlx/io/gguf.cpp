@@ -5,6 +5,7 @@
 #include <numeric>
 
 #include "mlx/io/gguf.h"
+#include "mlx/io/load.h"
 #include "mlx/ops.h"
 
 namespace mlx::core {
@@ -203,7 +204,53 @@ std::unordered_map<std::string, GGUFMetaData> load_metadata(gguf_ctx* ctx) {
   return metadata;
 }
 
-std::unordered_map<std::string, array> load_arrays(gguf_ctx* ctx) {
+namespace {
+
+// Unpacks a tensor from an open gguf file when evaluated. Outputs either the
+// tensor or the weights, scales and biases of a quantized tensor.
+class LoadGGUFTensor : public Primitive {
+ public:
+  LoadGGUFTensor(
+      Stream stream,
+      std::shared_ptr<gguf_ctx> ctx,
+      const gguf_tensor& tensor)
+      : Primitive(stream), ctx_(std::move(ctx)), tensor_(tensor) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval(outputs);
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval(outputs);
+  }
+
+  DEFINE_PRINT(LoadGGUFTensor)
+
+ private:
+  void eval(std::vector<array>& outputs) {
+    if (outputs.size() == 3) {
+      for (auto& out : outputs) {
+        out.set_data(allocator::malloc_or_wait(out.nbytes()));
+      }
+      extract_quantized_data(tensor_, outputs[0], outputs[1], outputs[2]);
+    } else {
+      auto [data, dtype] = extract_tensor_data(&tensor_);
+      outputs[0].set_data(data);
+    }
+  }
+
+  // Keeps the file mapped while the tensor may still be loaded
+  std::shared_ptr<gguf_ctx> ctx_;
+  gguf_tensor tensor_;
+};
+
+} // namespace
+
+std::unordered_map<std::string, array> load_arrays(
+    std::shared_ptr<gguf_ctx> ctx,
+    const std::string& file,
+    Stream s) {
   std::unordered_map<std::string, array> array_map;
   gguf_tensor tensor;
 
@@ -216,17 +263,48 @@ std::unordered_map<std::string, array> load_arrays(gguf_ctx* ctx) {
     }
   };
 
-  while (gguf_get_tensor(ctx, &tensor)) {
+  // Tensors stored in a type MLX supports are loaded straight from the file
+  std::shared_ptr<io::Reader> reader;
+  auto file_offset = [&ctx](const gguf_tensor& t) -> size_t {
+    return static_cast<char*>(static_cast<void*>(t.weights_data)) -
+        static_cast<char*>(static_cast<void*>(ctx->data));
+  };
+
+  // Nothing is read until the arrays are evaluated
+  while (gguf_get_tensor(ctx.get(), &tensor)) {
     std::string name(tensor.name, tensor.namelen);
-    if (tensor.type == GGUF_TYPE_Q4_0 || tensor.type == GGUF_TYPE_Q4_1 ||
-        tensor.type == GGUF_TYPE_Q8_0) {
-      gguf_load_quantized(array_map, tensor);
-    } else {
-      std::string name = std::string(tensor.name, tensor.namelen);
+    if (is_gguf_quantized(tensor)) {
+      auto [weights_shape, sb_shape] = get_quantized_shapes(tensor);
+      auto outputs = array::make_arrays(
+          {std::move(weights_shape), sb_shape, sb_shape},
+          {uint32, float16, float16},
+          std::make_shared<LoadGGUFTensor>(s, ctx, tensor),
+          {});
 
-      const auto& [data, dtype] = extract_tensor_data(&tensor);
-      array loaded_array = array(data, get_shape(tensor), dtype);
-      check_insert(array_map.insert({name, loaded_array}));
+      constexpr std::string_view weight_suffix = ".weight";
+      const std::string name_prefix =
+          name.substr(0, name.length() - weight_suffix.length());
+      check_insert(array_map.emplace(name, outputs[0]));
+      check_insert(array_map.emplace(name_prefix + ".scales", outputs[1]));
+      check_insert(array_map.emplace(name_prefix + ".biases", outputs[2]));
+    } else if (auto dtype = gguf_type_to_dtype(tensor.type)) {
+      if (!reader) {
+        reader = io::open_file_reader(file);
+      }
+      array loaded_array(
+          get_shape(tensor),
+          *dtype,
+          std::make_shared<Load>(s, reader, file_offset(tensor)),
+          std::vector<array>{});
+      check_insert(array_map.emplace(name, loaded_array));
+    } else {
+      // Converted to float16
+      array loaded_array(
+          get_shape(tensor),
+          float16,
+          std::make_shared<LoadGGUFTensor>(s, ctx, tensor),
+          std::vector<array>{});
+      check_insert(array_map.emplace(name, loaded_array));
     }
   }
   return array_map;
@@ -237,9 +315,11 @@ GGUFLoad load_gguf(const std::string& file, StreamOrDevice s) {
   if (!ctx) {
     throw std::runtime_error("[load_gguf] gguf_init failed");
   }
+  // The file stays open until every array loaded from it has been evaluated
+  // or freed
+  auto shared_ctx = std::shared_ptr<gguf_ctx>(ctx, gguf_close);
   auto metadata = load_metadata(ctx);
-  auto arrays = load_arrays(ctx);
-  gguf_close(ctx);
+  auto arrays = load_arrays(shared_ctx, file, to_stream(s));
   return {arrays, metadata};
 }
 
@@ -285,6 +365,7 @@ void save_gguf(
     file += ".gguf";
   }
 
+  io::unlink_before_write(file);
   gguf_ctx* ctx = gguf_create(file.c_str(), GGUF_OVERWRITE);
   if (!ctx) {
     throw std::runtime_error("[save_gguf] gguf_create failed");
@@ -394,27 +475,66 @@ void save_gguf(
     }
   }
 
-  // Tensor offsets are relative to data section, so we start at offset 0.
-  uint64_t tensor_offset = 0;
-
-  // First, append the tensor info
+  // MLX quantized weights are saved with their scales and biases as one
+  // GGUF quantized tensor
+  struct Tensor {
+    std::string name;
+    std::vector<uint64_t> dim;
+    uint32_t type;
+    uint64_t nbytes;
+    uint64_t offset;
+    std::vector<array> arrays;
+  };
+  std::vector<Tensor> tensors;
+  constexpr std::string_view weight_suffix = ".weight";
   for (auto& [key, arr] : array_map) {
-    arr.eval();
-
-    // Try to make it row contiguous
-    if (!arr.flags().row_contiguous) {
-      arr = reshape(flatten(arr), arr.shape());
-      arr.eval();
+    if (key.length() < weight_suffix.length() ||
+        key.substr(key.length() - weight_suffix.length()) != weight_suffix ||
+        arr.dtype() != uint32) {
+      continue;
     }
-
-    // Has to be row-major now but, check one more time in case
-    // any of the above change in the future
-    if (!arr.flags().row_contiguous) {
-      throw std::invalid_argument(
-          "[save_gguf] can only serialize row-major arrays");
+    auto prefix = key.substr(0, key.length() - weight_suffix.length());
+    auto scales = array_map.find(prefix + ".scales");
+    auto biases = array_map.find(prefix + ".biases");
+    if (scales == array_map.end() || biases == array_map.end()) {
+      continue;
     }
-
-    tensor_offset += gguf_get_alignment_padding(ctx->alignment, tensor_offset);
+    auto s = astype(scales->second, float16);
+    auto b = astype(biases->second, float16);
+    eval(s, b);
+    if (!s.flags().row_contiguous || !b.flags().row_contiguous) {
+      s = reshape(flatten(s), s.shape());
+      b = reshape(flatten(b), b.shape());
+      eval(s, b);
+    }
+    auto type = get_gguf_quantized_type(arr, s, b);
+    if (!type) {
+      std::ostringstream msg;
+      msg << "[save_gguf] Quantized tensor " << key << " can't be saved, only"
+          << " 4 bit and symmetric 8 bit quantization with a group size of"
+          << " 32 is supported";
+      throw std::invalid_argument(msg.str());
+    }
+    std::vector<uint64_t> dim(arr.ndim());
+    dim[0] = uint64_t(s.shape(-1)) * 32;
+    for (int i = 1; i < arr.ndim(); i++) {
+      dim[i] = arr.shape(arr.ndim() - 1 - i);
+    }
+    tensors.push_back(
+        {key,
+         std::move(dim),
+         *type,
+         get_quantized_nbytes(*type, s),
+         0,
+         {arr, std::move(s), std::move(b)}});
+  }
+  for (auto& t : tensors) {
+    auto prefix = t.name.substr(0, t.name.length() - weight_suffix.length());
+    array_map.erase(t.name);
+    array_map.erase(prefix + ".scales");
+    array_map.erase(prefix + ".biases");
+  }
+  for (auto& [key, arr] : array_map) {
     const std::optional<uint32_t> gguf_type =
         dtype_to_gguf_tensor_type(arr.dtype());
     if (!gguf_type.has_value()) {
@@ -422,33 +542,75 @@ void save_gguf(
       msg << "[save_gguf] dtype " << arr.dtype() << " is not supported";
       throw std::runtime_error(msg.str());
     }
-    const char* tensorname = key.c_str();
-    const uint64_t namelen = key.length();
-    const uint32_t num_dim = arr.ndim();
-    uint64_t dim[num_dim];
-    for (int i = 0; i < num_dim; i++) {
-      dim[i] = arr.shape()[num_dim - 1 - i];
-    }
+    // The dimension order in GGML is the reverse of the order used in MLX.
+    std::vector<uint64_t> dim(arr.shape().rbegin(), arr.shape().rend());
+    tensors.push_back(
+        {key, std::move(dim), gguf_type.value(), arr.nbytes(), 0, {arr}});
+  }
+  array_map.clear();
+
+  // Tensor offsets are relative to data section, so we start at offset 0.
+  uint64_t tensor_offset = 0;
+
+  // First, append the tensor info
+  for (auto& t : tensors) {
+    tensor_offset += gguf_get_alignment_padding(ctx->alignment, tensor_offset);
+    t.offset = tensor_offset;
     if (!gguf_append_tensor_info(
             ctx,
-            tensorname,
-            namelen,
-            num_dim,
-            dim,
-            gguf_type.value(),
+            t.name.c_str(),
+            t.name.length(),
+            t.dim.size(),
+            t.dim.data(),
+            t.type,
             tensor_offset)) {
       throw std::runtime_error("[save_gguf] gguf_append_tensor_info failed");
     }
-    tensor_offset += arr.nbytes();
+    tensor_offset += t.nbytes;
   }
+  uint64_t data_start =
+      ctx->size + gguf_get_alignment_padding(ctx->alignment, ctx->size);
+  gguf_close(ctx);
 
-  // Then, append the tensor weights
-  for (const auto& [key, arr] : array_map) {
-    if (!gguf_append_tensor_data(ctx, (void*)arr.data<void>(), arr.nbytes())) {
-      throw std::runtime_error("[save_gguf] gguf_append_tensor_data failed");
+  // Then, write the tensor weights at their offsets, evaluating them one at a
+  // time and writing each one in chunks concurrently. Gaps are left as holes
+  // which read as zeros.
+  io::FileWriter writer(file, /* truncate = */ false);
+  if (!writer.is_open()) {
+    throw std::runtime_error("[save_gguf] Failed to open " + writer.label());
+  }
+  auto make_row_contiguous = [](array& arr) {
+    arr.eval();
+    // Try to make it row contiguous
+    if (!arr.flags().row_contiguous) {
+      arr = reshape(flatten(arr), arr.shape());
+      arr.eval();
+    }
+
+    // Has to be row-major now but, check one more time in case
+    // any of the above change in the future
+    if (!arr.flags().row_contiguous) {
+      throw std::invalid_argument(
+          "[save_gguf] can only serialize row-major arrays");
+    }
+  };
+  for (auto& t : tensors) {
+    auto arrays = std::move(t.arrays);
+    auto& arr = arrays[0];
+    make_row_contiguous(arr);
+    if (arrays.size() == 1) {
+      io::parallel_write(
+          writer, arr.data<char>(), t.nbytes, data_start + t.offset);
+    } else {
+      std::vector<uint8_t> packed(t.nbytes);
+      pack_quantized_data(t.type, arr, arrays[1], arrays[2], packed.data());
+      io::parallel_write(
+          writer,
+          reinterpret_cast<const char*>(packed.data()),
+          t.nbytes,
+          data_start + t.offset);
     }
   }
-  gguf_close(ctx);
 }
 
 } // namespace mlx::core
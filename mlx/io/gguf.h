@@ -13,8 +13,39 @@ extern "C" {
 namespace mlx::core {
 
 std::vector<int> get_shape(const gguf_tensor& tensor);
-void gguf_load_quantized(
-    std::unordered_map<std::string, array>& a,
+
+// Whether the tensor is loaded as MLX quantized weights, scales and biases
+bool is_gguf_quantized(const gguf_tensor& tensor);
+
+// The shapes of the weights and of the scales and biases a quantized tensor
+// is loaded into
+std::pair<std::vector<int>, std::vector<int>> get_quantized_shapes(
     const gguf_tensor& tensor);
 
+// Unpack a quantized tensor into allocated weights, scales and biases
+void extract_quantized_data(
+    const gguf_tensor& tensor,
+    array& weights,
+    array& scales,
+    array& biases);
+
+// The GGUF type MLX quantized weights are saved as without changing their
+// values, if any. Scales and biases must be evaluated float16 arrays.
+std::optional<uint32_t> get_gguf_quantized_type(
+    const array& weights,
+    const array& scales,
+    const array& biases);
+
+// The size in bytes of the GGUF blocks holding the quantized weights
+size_t get_quantized_nbytes(uint32_t type, const array& scales);
+
+// Pack row contiguous quantized weights, scales and biases into the blocks of
+// a GGUF tensor of the given type
+void pack_quantized_data(
+    uint32_t type,
+    const array& weights,
+    const array& scales,
+    const array& biases,
+    uint8_t* dst);
+
 } // namespace mlx::core
@@ -4,28 +4,40 @@
 #include <cstring>
 #include <numeric>
 
+#include "mlx/backend/common/threading.h"
 #include "mlx/io/gguf.h"
 
 namespace mlx::core {
 
-void unpack_32_4(uint8_t* data, int8_t* dst) {
-  for (int64_t j = 0; j < 16; ++j) {
-    uint8_t x = (data[j + 2] & 0x0F); // j+2 to skip scale bytes.
-    if (j % 2 != 0) {
-      x <<= 4;
-    }
-    dst[j / 2] += x;
+// Unpack the 32 4-bit weights of a block into MLX's layout where weight i is
+// in nibble i. GGUF stores weights i and i + 16 in the low and high nibbles
+// of byte i. Branch free so the compiler can vectorize it.
+inline void unpack_32_4(const uint8_t* qs, uint8_t* dst) {
+  for (int j = 0; j < 8; ++j) {
+    dst[j] = (qs[2 * j] & 0x0F) | (qs[2 * j + 1] << 4);
+    dst[8 + j] = (qs[2 * j] >> 4) | (qs[2 * j + 1] & 0xF0);
   }
-  // Last 16 weights are in the higher bits
-  for (int64_t j = 0; j < 16; ++j) {
-    uint8_t x = (data[j + 2] >> 4);
-    if (j % 2 != 0) {
-      x <<= 4;
-    }
-    dst[8 + j / 2] += x;
+}
+
+// Pack 32 4-bit weights from MLX's layout into GGUF's, the inverse of
+// unpack_32_4.
+inline void pack_32_4(const uint8_t* src, uint8_t* qs) {
+  for (int j = 0; j < 8; ++j) {
+    qs[2 * j] = (src[j] & 0x0F) | (src[8 + j] << 4);
+    qs[2 * j + 1] = (src[j] >> 4) | (src[8 + j] & 0xF0);
   }
 }
 
+inline float16_t read_float16(const uint8_t* data) {
+  float16_t x;
+  std::memcpy(&x, data, sizeof(x));
+  return x;
+}
+
+inline void write_float16(uint8_t* data, float16_t x) {
+  std::memcpy(data, &x, sizeof(x));
+}
+
 // Extracts (weight, scales, biases) from Q4_0 tensors.
 // Data layout is: |16 bit scale|32 x 4bit weights|.
 void extract_q4_0_data(
@@ -34,17 +46,18 @@ void extract_q4_0_data(
     array& scales_arr,
     array& biases_arr) {
   const uint64_t bytes_per_block = 18; // 2 bytes scale, 32x0.5 byte weights
-  auto data = static_cast<uint8_t*>(tensor.weights_data);
-  auto weights = weights_arr.data<int8_t>();
+  auto data = static_cast<const uint8_t*>(tensor.weights_data);
+  auto weights = weights_arr.data<uint8_t>();
   auto scales = scales_arr.data<float16_t>();
   auto biases = biases_arr.data<float16_t>();
-  for (int64_t i = 0; i < scales_arr.size(); i++) {
-    scales[i] = *((float16_t*)data);
-    biases[i] = -8 * scales[i];
-    unpack_32_4(data, weights);
-    weights += 16;
-    data += bytes_per_block;
-  }
+  parallel_for(scales_arr.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto block = data + i * bytes_per_block;
+      scales[i] = read_float16(block);
+      biases[i] = -8 * scales[i];
+      unpack_32_4(block + 2, weights + i * 16);
+    }
+  });
 }
 
 // Extracts (weight, scales, biases) from Q4_1 tensors.
@@ -56,17 +69,18 @@ void extract_q4_1_data(
     array& biases_arr) {
   const uint64_t bytes_per_block =
       20; // 2 bytes scale, 2 bytes bias, 32x0.5 byte weights
-  auto data = static_cast<uint8_t*>(tensor.weights_data);
-  auto weights = weights_arr.data<int8_t>();
+  auto data = static_cast<const uint8_t*>(tensor.weights_data);
+  auto weights = weights_arr.data<uint8_t>();
   auto scales = scales_arr.data<float16_t>();
   auto biases = biases_arr.data<float16_t>();
-  for (int64_t i = 0; i < scales_arr.size(); i++) {
-    scales[i] = *((float16_t*)data);
-    biases[i] = *((float16_t*)(data) + 1);
-    unpack_32_4(data, weights);
-    weights += 16;
-    data += bytes_per_block;
-  }
+  parallel_for(scales_arr.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto block = data + i * bytes_per_block;
+      scales[i] = read_float16(block);
+      biases[i] = read_float16(block + 2);
+      unpack_32_4(block + 4, weights + i * 16);
+    }
+  });
 }
 
 // Extracts (weight, scales, biases) from Q8_0 tensors.
@@ -78,87 +92,267 @@ void extract_q8_0_data(
     array& biases_arr) {
   const uint64_t weights_per_block = 32;
   const uint64_t bytes_per_block = 34; // 2 bytes scale, 32x1 byte weights
-  auto data = static_cast<uint8_t*>(tensor.weights_data);
-  auto weights = weights_arr.data<int8_t>();
+  auto data = static_cast<const uint8_t*>(tensor.weights_data);
+  auto weights = weights_arr.data<uint8_t>();
   auto scales = scales_arr.data<float16_t>();
   auto biases = biases_arr.data<float16_t>();
-  for (int64_t i = 0; i < scales_arr.size(); i++) {
-    uint8_t* block_data = data + i * bytes_per_block;
-    scales[i] = *((float16_t*)block_data);
-    biases[i] = -128 * scales[i];
-    for (int64_t j = 0; j < weights_per_block; ++j) {
-      uint8_t x = block_data[j + 2]; // j+2 to skip the scale bytes.
+  parallel_for(scales_arr.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto block = data + i * bytes_per_block;
+      scales[i] = read_float16(block);
+      biases[i] = -128 * scales[i];
       // Original data is in int8_t, so we add a bias of -128 and invert the
       // first bit.
-      x ^= 1 << 7;
-      weights[i * weights_per_block + j] = x;
+      auto w = weights + i * weights_per_block;
+      for (int j = 0; j < weights_per_block; ++j) {
+        w[j] = block[j + 2] ^ 0x80;
+      }
     }
+  });
+}
+
+// Unpacks the 6 bit scale and min of sub-block j from the 12 bytes of packed
+// K-quant scales.
+inline void get_scale_min_k4(int j, const uint8_t* q, int& scale, int& min) {
+  if (j < 4) {
+    scale = q[j] & 63;
+    min = q[j + 4] & 63;
+  } else {
+    scale = (q[j + 4] & 0xF) | ((q[j - 4] >> 6) << 4);
+    min = (q[j + 4] >> 4) | ((q[j] >> 6) << 4);
   }
 }
 
-void gguf_load_quantized(
-    std::unordered_map<std::string, array>& a,
+// Computes the scales and biases of the 8 sub-blocks of 32 weights of a
+// Q4_K or Q5_K super-block.
+inline void extract_k_scales_biases(
+    const uint8_t* block,
+    float16_t* scales,
+    float16_t* biases) {
+  float d = read_float16(block);
+  float dmin = read_float16(block + 2);
+  for (int j = 0; j < 8; ++j) {
+    int scale, min;
+    get_scale_min_k4(j, block + 4, scale, min);
+    scales[j] = d * scale;
+    biases[j] = -dmin * min;
+  }
+}
+
+// Extracts (weight, scales, biases) from Q4_K tensors.
+// Data layout is: |16 bit scale|16 bit min|12 bytes of 6 bit sub-block scales
+// and mins|256 x 4bit weights|. Every sub-block of 32 weights maps to one
+// group of 4 bit MLX quantization.
+void extract_q4_k_data(
+    const gguf_tensor& tensor,
+    array& weights_arr,
+    array& scales_arr,
+    array& biases_arr) {
+  const uint64_t bytes_per_block = 144; // 4 + 12 bytes scales, 256x0.5 byte
+  auto data = static_cast<const uint8_t*>(tensor.weights_data);
+  auto weights = weights_arr.data<uint8_t>();
+  auto scales = scales_arr.data<float16_t>();
+  auto biases = biases_arr.data<float16_t>();
+  parallel_for(scales_arr.size() / 8, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto block = data + i * bytes_per_block;
+      extract_k_scales_biases(block, scales + i * 8, biases + i * 8);
+      // Each 32 bytes of weights hold two sub-blocks, the first in the low
+      // nibbles and the second in the high nibbles.
+      auto qs = block + 16;
+      auto w = weights + i * 128;
+      for (int c = 0; c < 4; ++c, qs += 32, w += 32) {
+        for (int j = 0; j < 16; ++j) {
+          w[j] = (qs[2 * j] & 0x0F) | (qs[2 * j + 1] << 4);
+          w[16 + j] = (qs[2 * j] >> 4) | (qs[2 * j + 1] & 0xF0);
+        }
+      }
+    }
+  });
+}
+
+// Extracts (weight, scales, biases) from Q5_K tensors.
+// Data layout is: |16 bit scale|16 bit min|12 bytes of 6 bit sub-block scales
+// and mins|256 x 1 bit high bits|256 x 4bit low bits|. MLX has no 5 bit
+// quantization so the weights are stored with 8 bits and groups of 32.
+void extract_q5_k_data(
+    const gguf_tensor& tensor,
+    array& weights_arr,
+    array& scales_arr,
+    array& biases_arr) {
+  const uint64_t bytes_per_block = 176; // 4 + 12 + 32 bytes, 256x0.5 byte
+  auto data = static_cast<const uint8_t*>(tensor.weights_data);
+  auto weights = weights_arr.data<uint8_t>();
+  auto scales = scales_arr.data<float16_t>();
+  auto biases = biases_arr.data<float16_t>();
+  parallel_for(scales_arr.size() / 8, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto block = data + i * bytes_per_block;
+      extract_k_scales_biases(block, scales + i * 8, biases + i * 8);
+      // Bit 2c of qh[j] is the high bit of weight j of sub-block 2c and bit
+      // 2c + 1 the high bit of weight j of sub-block 2c + 1
+      auto qh = block + 16;
+      auto qs = block + 48;
+      auto w = weights + i * 256;
+      for (int c = 0; c < 4; ++c, qs += 32, w += 64) {
+        for (int j = 0; j < 32; ++j) {
+          w[j] = (qs[j] & 0x0F) | (((qh[j] >> (2 * c)) & 1) << 4);
+          w[32 + j] = (qs[j] >> 4) | (((qh[j] >> (2 * c + 1)) & 1) << 4);
+        }
+      }
+    }
+  });
+}
+
+bool is_gguf_quantized(const gguf_tensor& tensor) {
+  return tensor.type == GGUF_TYPE_Q4_0 || tensor.type == GGUF_TYPE_Q4_1 ||
+      tensor.type == GGUF_TYPE_Q8_0 || tensor.type == GGUF_TYPE_Q4_K ||
+      tensor.type == GGUF_TYPE_Q5_K;
+}
+
+std::pair<std::vector<int>, std::vector<int>> get_quantized_shapes(
     const gguf_tensor& tensor) {
   uint64_t weights_per_byte;
-  if (tensor.type == GGUF_TYPE_Q4_0 || tensor.type == GGUF_TYPE_Q4_1) {
+  if (tensor.type == GGUF_TYPE_Q4_0 || tensor.type == GGUF_TYPE_Q4_1 ||
+      tensor.type == GGUF_TYPE_Q4_K) {
     weights_per_byte = 2;
-  } else { // tensor.type == GGUF_TYPE_Q8_0
+  } else { // tensor.type == GGUF_TYPE_Q8_0 || tensor.type == GGUF_TYPE_Q5_K
     weights_per_byte = 1;
   }
 
-  std::string name(tensor.name, tensor.namelen);
-
   std::vector<int> shape = get_shape(tensor);
+  // K-quants store super-blocks of 8 groups of 32 weights
   const uint64_t weights_per_block = 32;
-  if (shape[shape.size() - 1] % weights_per_block != 0) {
+  const uint64_t weights_per_super_block =
+      (tensor.type == GGUF_TYPE_Q4_K || tensor.type == GGUF_TYPE_Q5_K)
+      ? 256
+      : weights_per_block;
+  if (shape[shape.size() - 1] % weights_per_super_block != 0) {
     std::ostringstream msg;
-    msg << "[load_gguf] tensor " << name
+    msg << "[load_gguf] tensor " << std::string(tensor.name, tensor.namelen)
         << "has incompatible last dim shape: " << shape[shape.size() - 1];
     throw std::runtime_error(msg.str());
   }
 
   std::vector<int> weights_shape = shape;
   weights_shape.back() /= (weights_per_byte * 4);
-  auto w_nbytes = uint32.size *
-      std::accumulate(weights_shape.begin(),
-                      weights_shape.end(),
-                      1,
-                      std::multiplies<size_t>());
-
-  array weights(allocator::malloc(w_nbytes), std::move(weights_shape), uint32);
 
   // For scales and bias
   shape[shape.size() - 1] = shape[shape.size() - 1] / weights_per_block;
-  auto sb_nbytes = float16.size *
-      std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<size_t>());
+  return {weights_shape, shape};
+}
 
-  array scales(allocator::malloc(sb_nbytes), shape, float16);
-  array biases(allocator::malloc(sb_nbytes), std::move(shape), float16);
+std::optional<uint32_t> get_gguf_quantized_type(
+    const array& weights,
+    const array& scales,
+    const array& biases) {
+  // GGUF blocks hold 32 weights
+  const int weights_per_block = 32;
+  if (weights.dtype() != uint32 || weights.ndim() == 0 ||
+      scales.shape() != biases.shape() ||
+      scales.ndim() != weights.ndim()) {
+    return {};
+  }
+  for (int i = 0; i < weights.ndim() - 1; ++i) {
+    if (weights.shape(i) != scales.shape(i)) {
+      return {};
+    }
+  }
+  int64_t n = int64_t(scales.shape(-1)) * weights_per_block;
+  int64_t bits_n = int64_t(weights.shape(-1)) * 32;
+  if (n == 0 || bits_n % n != 0) {
+    return {};
+  }
+  int bits = bits_n / n;
+  if (bits != 4 && bits != 8) {
+    return {};
+  }
 
+  // Symmetric blocks have biases of minus the scales times the middle of the
+  // range and are stored without them
+  float zero_point = bits == 4 ? -8.0f : -128.0f;
+  auto s = scales.data<float16_t>();
+  auto b = biases.data<float16_t>();
+  bool symmetric = true;
+  for (size_t i = 0; i < scales.size() && symmetric; ++i) {
+    symmetric = static_cast<float>(b[i]) == zero_point * s[i];
+  }
+  if (bits == 4) {
+    return symmetric ? GGUF_TYPE_Q4_0 : GGUF_TYPE_Q4_1;
+  } else if (symmetric) {
+    return GGUF_TYPE_Q8_0;
+  }
+  return {};
+}
+
+size_t get_quantized_nbytes(uint32_t type, const array& scales) {
+  size_t bytes_per_block;
+  if (type == GGUF_TYPE_Q4_0) {
+    bytes_per_block = 18;
+  } else if (type == GGUF_TYPE_Q4_1) {
+    bytes_per_block = 20;
+  } else { // type == GGUF_TYPE_Q8_0
+    bytes_per_block = 34;
+  }
+  return scales.size() * bytes_per_block;
+}
+
+void pack_quantized_data(
+    uint32_t type,
+    const array& weights_arr,
+    const array& scales_arr,
+    const array& biases_arr,
+    uint8_t* dst) {
+  auto weights = weights_arr.data<uint8_t>();
+  auto scales = scales_arr.data<float16_t>();
+  auto biases = biases_arr.data<float16_t>();
+  if (type == GGUF_TYPE_Q4_0) {
+    parallel_for(scales_arr.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        auto block = dst + i * 18;
+        write_float16(block, scales[i]);
+        pack_32_4(weights + i * 16, block + 2);
+      }
+    });
+  } else if (type == GGUF_TYPE_Q4_1) {
+    parallel_for(scales_arr.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        auto block = dst + i * 20;
+        write_float16(block, scales[i]);
+        write_float16(block + 2, biases[i]);
+        pack_32_4(weights + i * 16, block + 4);
+      }
+    });
+  } else if (type == GGUF_TYPE_Q8_0) {
+    parallel_for(scales_arr.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        auto block = dst + i * 34;
+        write_float16(block, scales[i]);
+        auto w = weights + i * 32;
+        for (int j = 0; j < 32; ++j) {
+          block[j + 2] = w[j] ^ 0x80;
+        }
+      }
+    });
+  }
+}
+
+void extract_quantized_data(
+    const gguf_tensor& tensor,
+    array& weights,
+    array& scales,
+    array& biases) {
   if (tensor.type == GGUF_TYPE_Q4_0) {
     extract_q4_0_data(tensor, weights, scales, biases);
   } else if (tensor.type == GGUF_TYPE_Q4_1) {
     extract_q4_1_data(tensor, weights, scales, biases);
   } else if (tensor.type == GGUF_TYPE_Q8_0) {
     extract_q8_0_data(tensor, weights, scales, biases);
+  } else if (tensor.type == GGUF_TYPE_Q4_K) {
+    extract_q4_k_data(tensor, weights, scales, biases);
+  } else if (tensor.type == GGUF_TYPE_Q5_K) {
+    extract_q5_k_data(tensor, weights, scales, biases);
   }
-
-  a.emplace(name, std::move(weights));
-
-  auto check_insert = [](const auto& inserted) {
-    if (!inserted.second) {
-      std::ostringstream msg;
-      msg << "[load_gguf] Duplicate parameter name " << inserted.first->second
-          << " this can happend when loading quantized tensors.";
-      throw std::runtime_error(msg.str());
-    }
-  };
-
-  constexpr std::string_view weight_suffix = ".weight";
-  const std::string name_prefix =
-      name.substr(0, name.length() - weight_suffix.length());
-  check_insert(a.emplace(name_prefix + ".scales", std::move(scales)));
-  check_insert(a.emplace(name_prefix + ".biases", std::move(biases)));
 }
 
 } // namespace mlx::core
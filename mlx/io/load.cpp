@@ -1,5 +1,11 @@
 // Copyright © 2023-2024 Apple Inc.
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <limits>
@@ -8,6 +14,7 @@
 #include "mlx/io/load.h"
 #include "mlx/ops.h"
 #include "mlx/primitives.h"
+#include "mlx/threadpool.h"
 #include "mlx/utils.h"
 
 // Adapted from
@@ -133,6 +140,9 @@ array load(std::shared_ptr<io::Reader> in_stream, StreamOrDevice s) {
   ////////////////////////////////////////////////////////
   // Read header and prepare array details
 
+  // The array may not start at the beginning of the stream, e.g. in .npz
+  size_t start = in_stream->tell();
+
   // Read and check magic
   char read_magic_and_ver[8];
   in_stream->read(read_magic_and_ver, 8);
@@ -204,7 +214,7 @@ array load(std::shared_ptr<io::Reader> in_stream, StreamOrDevice s) {
   ////////////////////////////////////////////////////////
   // Build primitive
 
-  size_t offset = 8 + header_len_size + header.length();
+  size_t offset = start + 8 + header_len_size + header.length();
   bool swap_endianness = read_is_big_endian != is_big_endian();
 
   if (col_contiguous) {
@@ -224,7 +234,231 @@ array load(std::shared_ptr<io::Reader> in_stream, StreamOrDevice s) {
 
 /** Load array from file in .npy format */
 array load(std::string file, StreamOrDevice s) {
-  return load(std::make_shared<io::FileReader>(std::move(file)), s);
+  return load(io::open_file_reader(file), s);
+}
+
+namespace io {
+
+namespace {
+
+// Large reads and writes are split in chunks of this size
+constexpr size_t read_chunk_size = 1 << 22;
+
+// Small writes are gathered in a buffer of this size before reaching the
+// file, files are made of many of them when exporting functions
+constexpr size_t write_buffer_size = 1 << 20;
+
+int default_io_threads() {
+  if (const char* buff_str = std::getenv("MLX_IO_THREADS")) {
+    return std::max(std::atoi(buff_str), 1);
+  }
+  return 8;
+}
+
+} // namespace
+
+ThreadPool& io_thread_pool() {
+  static ThreadPool pool(default_io_threads());
+  return pool;
+}
+
+void Reader::read_at(char* data, size_t n, size_t offset) {
+  std::lock_guard<std::mutex> lk(read_mtx_);
+  seek(offset, std::ios_base::beg);
+  read(data, n);
+}
+
+FileReader::FileReader(std::string file_path)
+    : is_(std::ifstream(file_path, std::ios::binary)),
+      label_(std::move(file_path)),
+      fd_(::open(label_.c_str(), O_RDONLY)) {}
+
+FileReader::~FileReader() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+void FileReader::read_at(char* data, size_t n, size_t offset) {
+  if (fd_ < 0) {
+    Reader::read_at(data, n, offset);
+    return;
+  }
+  while (n > 0) {
+    auto n_read = ::pread(fd_, data, n, offset);
+    if (n_read < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n_read <= 0) {
+      throw std::runtime_error("[read_at] Failed to read from " + label());
+    }
+    data += n_read;
+    n -= n_read;
+    offset += n_read;
+  }
+}
+
+void Writer::write_at(const char* data, size_t n, size_t offset) {
+  std::lock_guard<std::mutex> lk(write_mtx_);
+  size_t pos = tell();
+  seek(offset, std::ios_base::beg);
+  write(data, n);
+  seek(pos, std::ios_base::beg);
+}
+
+FileWriter::FileWriter(std::string file_path, bool truncate /* = true */)
+    : buffer_(new char[write_buffer_size]), label_(std::move(file_path)) {
+  os_.rdbuf()->pubsetbuf(buffer_.get(), write_buffer_size);
+  if (truncate) {
+    unlink_before_write(label_);
+    os_.open(label_, std::ios::binary);
+  } else {
+    os_.open(label_, std::ios::binary | std::ios::in | std::ios::out);
+    os_.seekp(0, std::ios_base::end);
+  }
+  fd_ = ::open(label_.c_str(), O_WRONLY);
+}
+
+FileWriter::~FileWriter() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+void FileWriter::write_at(const char* data, size_t n, size_t offset) {
+  if (fd_ < 0) {
+    Writer::write_at(data, n, offset);
+    return;
+  }
+  while (n > 0) {
+    auto n_written = ::pwrite(fd_, data, n, offset);
+    if (n_written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n_written <= 0) {
+      throw std::runtime_error("[write_at] Failed to write to " + label());
+    }
+    data += n_written;
+    n -= n_written;
+    offset += n_written;
+  }
+}
+
+void unlink_before_write(const std::string& file_path) {
+  ::unlink(file_path.c_str());
 }
 
+void parallel_read(
+    Reader& reader,
+    char* data,
+    size_t n,
+    size_t offset,
+    const std::function<void(char*, size_t)>& on_chunk /* = nullptr */) {
+  size_t n_chunks = (n + read_chunk_size - 1) / read_chunk_size;
+  auto read_chunk = [&](size_t start, size_t size) {
+    reader.read_at(data + start, size, offset + start);
+    if (on_chunk) {
+      on_chunk(data + start, size);
+    }
+  };
+  if (n_chunks <= 1) {
+    read_chunk(0, n);
+    return;
+  }
+  io_thread_pool().parallel_for(n_chunks, [&](int i) {
+    size_t start = i * read_chunk_size;
+    read_chunk(start, std::min(read_chunk_size, n - start));
+  });
+}
+
+void parallel_write(
+    Writer& writer,
+    const char* data,
+    size_t n,
+    size_t offset) {
+  writer.flush();
+  size_t n_chunks = (n + read_chunk_size - 1) / read_chunk_size;
+  if (n_chunks <= 1) {
+    writer.write_at(data, n, offset);
+    return;
+  }
+  io_thread_pool().parallel_for(n_chunks, [&](int i) {
+    size_t start = i * read_chunk_size;
+    size_t size = std::min(read_chunk_size, n - start);
+    writer.write_at(data + start, size, offset + start);
+  });
+}
+
+namespace {
+
+// Advise the OS about the pages holding [offset, offset + size) of a mapping
+void advise(
+    void* addr,
+    size_t mapped_size,
+    size_t offset,
+    size_t size,
+    int advice) {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t start = (offset / page_size) * page_size;
+  size_t end = std::min(offset + size, mapped_size);
+  if (start < end) {
+    madvise(static_cast<char*>(addr) + start, end - start, advice);
+  }
+}
+
+} // namespace
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& file_path) {
+  int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  size_t size = st.st_size;
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t mapped_size = page_size * ((size + page_size - 1) / page_size);
+  void* addr = mmap(
+      nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  return std::shared_ptr<MappedFile>(new MappedFile(addr, size, mapped_size));
+}
+
+MappedFile::~MappedFile() {
+  if (buffer_.ptr()) {
+    allocator::release_external(buffer_);
+  }
+  munmap(addr_, mapped_size_);
+}
+
+allocator::Buffer MappedFile::buffer() {
+  std::call_once(buffer_flag_, [this]() {
+    buffer_ = allocator::make_external(addr_, mapped_size_);
+  });
+  return buffer_;
+}
+
+void MappedFile::will_need(size_t offset, size_t size) const {
+  advise(addr_, mapped_size_, offset, size, MADV_WILLNEED);
+}
+
+void MappedFile::dont_need(size_t offset, size_t size) const {
+  advise(addr_, mapped_size_, offset, size, MADV_DONTNEED);
+}
+
+std::shared_ptr<Reader> open_file_reader(const std::string& file_path) {
+  if (auto file = MappedFile::open(file_path)) {
+    return std::make_shared<MmapReader>(std::move(file), file_path);
+  }
+  return std::make_shared<FileReader>(file_path);
+}
+
+} // namespace io
+
 } // namespace mlx::core
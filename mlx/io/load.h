@@ -2,14 +2,69 @@
 
 #pragma once
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <istream>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "mlx/allocator.h"
 
 namespace mlx::core {
 
+class ThreadPool;
+
 namespace io {
 
+/* A read-only memory mapping of a whole file.
+ *
+ * Pages are mapped copy-on-write so arrays backed by the mapping can be
+ * written to without modifying the file.
+ * */
+class MappedFile {
+ public:
+  /** Map a file, returns a null pointer if it can't be mapped. */
+  static std::shared_ptr<MappedFile> open(const std::string& file_path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const {
+    return static_cast<const char*>(addr_);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  /** A buffer over the whole mapping or a null buffer if the backend can't
+   * use the mapped memory directly. Made on first use. */
+  allocator::Buffer buffer();
+
+  /** Advise the OS that the bytes in [offset, offset + size) will be read
+   * soon so it reads them in the background. */
+  void will_need(size_t offset, size_t size) const;
+
+  /** Let the OS drop the pages of the bytes in [offset, offset + size) from
+   * memory. They are read from the file again on their next use, pages
+   * which were written lose their changes. */
+  void dont_need(size_t offset, size_t size) const;
+
+ private:
+  MappedFile(void* addr, size_t size, size_t mapped_size)
+      : addr_(addr), size_(size), mapped_size_(mapped_size) {}
+
+  void* addr_;
+  size_t size_;
+  size_t mapped_size_;
+  std::once_flag buffer_flag_;
+  allocator::Buffer buffer_{nullptr};
+};
+
 class Reader {
  public:
   virtual bool is_open() const = 0;
@@ -20,6 +75,21 @@ class Reader {
       std::ios_base::seekdir way = std::ios_base::beg) = 0;
   virtual void read(char* data, size_t n) = 0;
   virtual std::string label() const = 0;
+
+  // Read n bytes starting at offset without changing the read position. Safe
+  // to call from multiple threads at once. Readers which can't read at an
+  // offset directly fall back to a seek and read under a lock.
+  virtual void read_at(char* data, size_t n, size_t offset);
+
+  // The mapping behind the reader if its contents are memory mapped
+  virtual std::shared_ptr<MappedFile> mapped_file() const {
+    return nullptr;
+  }
+
+  virtual ~Reader() = default;
+
+ private:
+  std::mutex read_mtx_;
 };
 
 class Writer {
@@ -32,15 +102,28 @@ class Writer {
       std::ios_base::seekdir way = std::ios_base::beg) = 0;
   virtual void write(const char* data, size_t n) = 0;
   virtual std::string label() const = 0;
+
+  // Write n bytes starting at offset without changing the write position.
+  // Safe to call from multiple threads at once. Writers which can't write at
+  // an offset directly fall back to a seek and write under a lock.
+  virtual void write_at(const char* data, size_t n, size_t offset);
+
+  // Push buffered writes to the destination so they are ordered before
+  // following calls to write_at
+  virtual void flush() {}
+
+  virtual ~Writer() = default;
+
+ private:
+  std::mutex write_mtx_;
 };
 
 class FileReader : public Reader {
  public:
   explicit FileReader(std::ifstream is)
       : is_(std::move(is)), label_("stream") {}
-  explicit FileReader(std::string file_path)
-      : is_(std::ifstream(file_path, std::ios::binary)),
-        label_(std::move(file_path)) {}
+  explicit FileReader(std::string file_path);
+  ~FileReader();
 
   bool is_open() const override {
     return is_.is_open();
@@ -63,6 +146,8 @@ class FileReader : public Reader {
     is_.read(data, n);
   }
 
+  void read_at(char* data, size_t n, size_t offset) override;
+
   std::string label() const override {
     return "file " + label_;
   }
@@ -70,15 +155,110 @@ class FileReader : public Reader {
  private:
   std::ifstream is_;
   std::string label_;
+  // Separate descriptor for positional reads when opened from a path
+  int fd_{-1};
+};
+
+class MmapReader : public Reader {
+ public:
+  MmapReader(std::shared_ptr<MappedFile> file, std::string file_path)
+      : file_(std::move(file)), label_(std::move(file_path)) {}
+
+  bool is_open() const override {
+    return file_ != nullptr;
+  }
+
+  bool good() const override {
+    return good_;
+  }
+
+  size_t tell() override {
+    return pos_;
+  }
+
+  void seek(int64_t off, std::ios_base::seekdir way = std::ios_base::beg)
+      override {
+    if (way == std::ios_base::cur) {
+      off += pos_;
+    } else if (way == std::ios_base::end) {
+      off += file_->size();
+    }
+    good_ = off >= 0 && static_cast<size_t>(off) <= file_->size();
+    pos_ = good_ ? off : pos_;
+  }
+
+  void read(char* data, size_t n) override {
+    size_t available = file_->size() - pos_;
+    if (n > available) {
+      n = available;
+      good_ = false;
+    }
+    std::copy(file_->data() + pos_, file_->data() + pos_ + n, data);
+    pos_ += n;
+  }
+
+  void read_at(char* data, size_t n, size_t offset) override {
+    if (offset + n > file_->size()) {
+      throw std::runtime_error("[read_at] Reading past the end of " + label());
+    }
+    std::copy(file_->data() + offset, file_->data() + offset + n, data);
+  }
+
+  std::string label() const override {
+    return "file " + label_;
+  }
+
+  std::shared_ptr<MappedFile> mapped_file() const override {
+    return file_;
+  }
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+  std::string label_;
+  size_t pos_{0};
+  bool good_{true};
 };
 
+/* Remove an existing file before it is written again.
+ *
+ * Arrays loaded from the file may still be backed by a mapping of it, so the
+ * new contents go to a new file instead of truncating the mapped one.
+ * */
+void unlink_before_write(const std::string& file_path);
+
+/** Open a file for reading, memory mapped when possible. */
+std::shared_ptr<Reader> open_file_reader(const std::string& file_path);
+
+/* Read n bytes at offset with read_at, split in chunks which are read
+ * concurrently on the I/O thread pool.
+ *
+ * If given, on_chunk is called with each chunk on the thread that read it
+ * right after it is read. Chunks are a multiple of 8 bytes apart from the
+ * last one. The pool has MLX_IO_THREADS threads, 8 by default.
+ * */
+void parallel_read(
+    Reader& reader,
+    char* data,
+    size_t n,
+    size_t offset,
+    const std::function<void(char*, size_t)>& on_chunk = nullptr);
+
+/* Write n bytes at offset with write_at, split in chunks which are written
+ * concurrently on the I/O thread pool. Buffered writes are flushed first.
+ * */
+void parallel_write(Writer& writer, const char* data, size_t n, size_t offset);
+
+/** The thread pool used for concurrent reads and writes, see parallel_read. */
+ThreadPool& io_thread_pool();
+
 class FileWriter : public Writer {
  public:
   explicit FileWriter(std::ofstream os)
       : os_(std::move(os)), label_("stream") {}
-  explicit FileWriter(std::string file_path)
-      : os_(std::ofstream(file_path, std::ios::binary)),
-        label_(std::move(file_path)) {}
+
+  // Writes start at the end of the file when it isn't truncated
+  explicit FileWriter(std::string file_path, bool truncate = true);
+  ~FileWriter();
 
   bool is_open() const override {
     return os_.is_open();
@@ -101,13 +281,23 @@ class FileWriter : public Writer {
     os_.write(data, n);
   }
 
+  void write_at(const char* data, size_t n, size_t offset) override;
+
+  void flush() override {
+    os_.flush();
+  }
+
   std::string label() const override {
     return "file " + label_;
   }
 
  private:
+  // Declared before the stream which uses it
+  std::unique_ptr<char[]> buffer_;
   std::ofstream os_;
   std::string label_;
+  // Separate descriptor for positional writes when opened from a path
+  int fd_{-1};
 };
 
 } // namespace io
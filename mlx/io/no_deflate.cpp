@@ -0,0 +1,49 @@
+// Copyright © 2024 Apple Inc.
+
+#include <array>
+#include <stdexcept>
+
+#include "mlx/io/deflate.h"
+
+namespace mlx::core::io::detail {
+
+bool deflate_available() {
+  return false;
+}
+
+uint32_t crc32(uint32_t crc, const char* data, size_t n) {
+  static const auto table = []() {
+    std::array<uint32_t, 256> t;
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      }
+      t[i] = c;
+    }
+    return t;
+  }();
+  crc = ~crc;
+  for (size_t i = 0; i < n; i++) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+std::vector<char> inflate(const char*, size_t, size_t) {
+  throw std::runtime_error(
+      "[inflate] MLX was built without zlib, deflate is not supported.");
+}
+
+Deflater::Deflater(Output) {
+  throw std::runtime_error(
+      "[Deflater] MLX was built without zlib, deflate is not supported.");
+}
+
+Deflater::~Deflater() {}
+
+void Deflater::write(const char*, size_t) {}
+
+void Deflater::finish() {}
+
+} // namespace mlx::core::io::detail
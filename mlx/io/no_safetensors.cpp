@@ -16,6 +16,15 @@ SafetensorsLoad load_safetensors(const std::string&, StreamOrDevice) {
       "to enable safetensors support.");
 }
 
+SafetensorsLoad load_safetensors_sharded(
+    const std::string&,
+    const SafetensorsShardSpec&,
+    StreamOrDevice) {
+  throw std::runtime_error(
+      "[load_safetensors_sharded] Compile with MLX_BUILD_SAFETENSORS=ON "
+      "to enable safetensors support.");
+}
+
 void save_safetensors(
     std::shared_ptr<io::Writer>,
     std::unordered_map<std::string, array>,
@@ -0,0 +1,490 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <sstream>
+
+#include "mlx/io.h"
+#include "mlx/io/deflate.h"
+#include "mlx/threadpool.h"
+
+namespace mlx::core {
+
+namespace {
+
+template <typename T>
+T read_le(const char* data) {
+  T v;
+  std::memcpy(&v, data, sizeof(T));
+  return v;
+}
+
+template <typename T>
+void append_le(std::string& out, T v) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &v, sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+constexpr uint32_t zip_eocd_signature = 0x06054b50;
+constexpr uint32_t zip64_eocd_signature = 0x06064b50;
+constexpr uint32_t zip64_eocd_locator_signature = 0x07064b50;
+constexpr uint32_t zip_central_signature = 0x02014b50;
+constexpr uint32_t zip_local_signature = 0x04034b50;
+constexpr uint16_t zip64_extra_id = 0x0001;
+constexpr uint32_t zip32_max = 0xFFFFFFFF;
+constexpr uint16_t zip16_max = 0xFFFF;
+
+constexpr uint16_t method_stored = 0;
+constexpr uint16_t method_deflated = 8;
+
+// The DOS date of 1980-01-01 at midnight
+constexpr uint16_t zip_date = 0x21;
+
+struct ZipMember {
+  std::string name;
+  uint16_t method;
+  uint64_t local_offset;
+  uint64_t compressed_size;
+  uint64_t size;
+};
+
+std::vector<ZipMember> read_central_directory(io::Reader& in_stream) {
+  in_stream.seek(0, std::ios_base::end);
+  size_t file_size = in_stream.tell();
+  in_stream.seek(0);
+  auto invalid = [&in_stream]() {
+    return std::runtime_error(
+        "[load_npz] Invalid zip archive " + in_stream.label());
+  };
+
+  // The end of central directory record is at most 64KB from the end
+  constexpr size_t eocd_size = 22;
+  if (file_size < eocd_size) {
+    throw invalid();
+  }
+  size_t tail_size = std::min<size_t>(file_size, eocd_size + (1 << 16));
+  std::vector<char> tail(tail_size);
+  in_stream.read_at(tail.data(), tail_size, file_size - tail_size);
+  int64_t eocd = tail_size - eocd_size;
+  while (eocd >= 0 && read_le<uint32_t>(&tail[eocd]) != zip_eocd_signature) {
+    eocd--;
+  }
+  if (eocd < 0) {
+    throw invalid();
+  }
+  uint64_t n_entries = read_le<uint16_t>(&tail[eocd + 10]);
+  uint64_t cd_size = read_le<uint32_t>(&tail[eocd + 12]);
+  uint64_t cd_offset = read_le<uint32_t>(&tail[eocd + 16]);
+  if (eocd >= 20 &&
+      read_le<uint32_t>(&tail[eocd - 20]) == zip64_eocd_locator_signature) {
+    char zip64_eocd[56];
+    in_stream.read_at(zip64_eocd, 56, read_le<uint64_t>(&tail[eocd - 20 + 8]));
+    n_entries = read_le<uint64_t>(zip64_eocd + 32);
+    cd_size = read_le<uint64_t>(zip64_eocd + 40);
+    cd_offset = read_le<uint64_t>(zip64_eocd + 48);
+  }
+  if (cd_offset + cd_size > file_size) {
+    throw invalid();
+  }
+
+  std::vector<char> cd(cd_size);
+  in_stream.read_at(cd.data(), cd_size, cd_offset);
+  std::vector<ZipMember> members;
+  size_t pos = 0;
+  for (uint64_t i = 0; i < n_entries; i++) {
+    if (pos + 46 > cd_size ||
+        read_le<uint32_t>(&cd[pos]) != zip_central_signature) {
+      throw invalid();
+    }
+    auto name_len = read_le<uint16_t>(&cd[pos + 28]);
+    auto extra_len = read_le<uint16_t>(&cd[pos + 30]);
+    auto comment_len = read_le<uint16_t>(&cd[pos + 32]);
+    if (pos + 46 + name_len + extra_len > cd_size) {
+      throw invalid();
+    }
+    ZipMember member{
+        std::string(&cd[pos + 46], name_len),
+        read_le<uint16_t>(&cd[pos + 10]),
+        read_le<uint32_t>(&cd[pos + 42]),
+        read_le<uint32_t>(&cd[pos + 20]),
+        read_le<uint32_t>(&cd[pos + 24])};
+
+    // Entries which don't fit in 32 bits are in the zip64 extra field in the
+    // order uncompressed size, compressed size then local header offset
+    size_t extra = pos + 46 + name_len;
+    size_t extra_end = extra + extra_len;
+    while (extra + 4 <= extra_end) {
+      auto id = read_le<uint16_t>(&cd[extra]);
+      auto size = read_le<uint16_t>(&cd[extra + 2]);
+      if (id == zip64_extra_id) {
+        size_t field = extra + 4;
+        size_t field_end = std::min(field + size, extra_end);
+        for (auto v : {&member.size,
+                       &member.compressed_size,
+                       &member.local_offset}) {
+          if (*v == zip32_max && field + 8 <= field_end) {
+            *v = read_le<uint64_t>(&cd[field]);
+            field += 8;
+          }
+        }
+        break;
+      }
+      extra += 4 + size;
+    }
+    pos += 46 + name_len + extra_len + comment_len;
+
+    char local[30];
+    in_stream.read_at(local, 30, member.local_offset);
+    if (read_le<uint32_t>(local) != zip_local_signature) {
+      throw invalid();
+    }
+    member.local_offset += 30 + read_le<uint16_t>(local + 26) +
+        read_le<uint16_t>(local + 28);
+    if (member.local_offset + member.compressed_size > file_size) {
+      throw invalid();
+    }
+    members.push_back(std::move(member));
+  }
+  return members;
+}
+
+// A reader over the decompressed bytes of an archive member
+class MemoryReader : public io::Reader {
+ public:
+  MemoryReader(std::vector<char> data, std::string label)
+      : data_(std::move(data)), label_(std::move(label)) {}
+
+  bool is_open() const override {
+    return true;
+  }
+
+  bool good() const override {
+    return good_;
+  }
+
+  size_t tell() override {
+    return pos_;
+  }
+
+  void seek(int64_t off, std::ios_base::seekdir way = std::ios_base::beg)
+      override {
+    if (way == std::ios_base::cur) {
+      off += pos_;
+    } else if (way == std::ios_base::end) {
+      off += data_.size();
+    }
+    good_ = off >= 0 && static_cast<size_t>(off) <= data_.size();
+    pos_ = good_ ? off : pos_;
+  }
+
+  void read(char* data, size_t n) override {
+    size_t available = data_.size() - pos_;
+    if (n > available) {
+      n = available;
+      good_ = false;
+    }
+    std::copy(data_.data() + pos_, data_.data() + pos_ + n, data);
+    pos_ += n;
+  }
+
+  void read_at(char* data, size_t n, size_t offset) override {
+    if (offset + n > data_.size()) {
+      throw std::runtime_error("[read_at] Reading past the end of " + label());
+    }
+    std::copy(data_.data() + offset, data_.data() + offset + n, data);
+  }
+
+  std::string label() const override {
+    return label_;
+  }
+
+ private:
+  std::vector<char> data_;
+  std::string label_;
+  size_t pos_{0};
+  bool good_{true};
+};
+
+// Writes one member of the archive, keeping track of its checksum and sizes
+class MemberWriter : public io::Writer {
+ public:
+  MemberWriter(std::shared_ptr<io::Writer> out, bool compressed)
+      : out_(std::move(out)) {
+    if (compressed) {
+      deflater_ = std::make_unique<io::detail::Deflater>(
+          [this](const char* data, size_t n) {
+            out_->write(data, n);
+            compressed_size_ += n;
+          });
+    }
+  }
+
+  bool is_open() const override {
+    return out_->is_open();
+  }
+
+  bool good() const override {
+    return out_->good();
+  }
+
+  size_t tell() override {
+    return size_;
+  }
+
+  void seek(int64_t, std::ios_base::seekdir = std::ios_base::beg) override {
+    throw std::runtime_error("[savez] Archive members can't be seeked.");
+  }
+
+  void write(const char* data, size_t n) override {
+    crc_ = io::detail::crc32(crc_, data, n);
+    size_ += n;
+    if (deflater_) {
+      deflater_->write(data, n);
+    } else {
+      out_->write(data, n);
+      compressed_size_ += n;
+    }
+  }
+
+  void finish() {
+    if (deflater_) {
+      deflater_->finish();
+    }
+  }
+
+  std::string label() const override {
+    return out_->label();
+  }
+
+  uint32_t crc() const {
+    return crc_;
+  }
+
+  uint64_t size() const {
+    return size_;
+  }
+
+  uint64_t compressed_size() const {
+    return compressed_size_;
+  }
+
+ private:
+  std::shared_ptr<io::Writer> out_;
+  std::unique_ptr<io::detail::Deflater> deflater_;
+  uint32_t crc_{0};
+  uint64_t size_{0};
+  uint64_t compressed_size_{0};
+};
+
+} // namespace
+
+/** Load array map from reader in .npz format */
+std::unordered_map<std::string, array> load_npz(
+    std::shared_ptr<io::Reader> in_stream,
+    StreamOrDevice s) {
+  if (!in_stream->good() || !in_stream->is_open()) {
+    throw std::runtime_error("[load_npz] Failed to open " + in_stream->label());
+  }
+  auto members = read_central_directory(*in_stream);
+
+  for (auto& member : members) {
+    if (member.method != method_stored && member.method != method_deflated) {
+      throw std::invalid_argument(
+          "[load_npz] Member " + member.name + " in " + in_stream->label() +
+          " uses an unsupported compression method.");
+    }
+  }
+
+  // Deflated members are read and decompressed concurrently, stored members
+  // are loaded lazily straight from the archive
+  std::vector<std::shared_ptr<io::Reader>> readers(members.size(), in_stream);
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < members.size(); i++) {
+    auto& member = members[i];
+    if (member.method != method_deflated) {
+      continue;
+    }
+    futures.push_back(io::io_thread_pool().enqueue([&, i]() {
+      std::vector<char> data(member.compressed_size);
+      in_stream->read_at(data.data(), data.size(), member.local_offset);
+      readers[i] = std::make_shared<MemoryReader>(
+          io::detail::inflate(data.data(), data.size(), member.size),
+          member.name + " in " + in_stream->label());
+    }));
+  }
+  for (auto& f : futures) {
+    f.wait();
+  }
+  for (auto& f : futures) {
+    f.get();
+  }
+
+  std::unordered_map<std::string, array> res;
+  for (int i = 0; i < members.size(); i++) {
+    auto& member = members[i];
+    auto& reader = readers[i];
+    reader->seek(member.method == method_deflated ? 0 : member.local_offset);
+
+    // Remove .npy from the member name if it is there
+    auto key = member.name;
+    if (key.length() > 4 && key.substr(key.length() - 4, 4) == ".npy") {
+      key = key.substr(0, key.length() - 4);
+    }
+    res.insert({key, load(reader, s)});
+  }
+  return res;
+}
+
+/** Load array map from file in .npz format */
+std::unordered_map<std::string, array> load_npz(
+    const std::string& file,
+    StreamOrDevice s) {
+  return load_npz(io::open_file_reader(file), s);
+}
+
+/** Save array map to out stream in .npz format */
+void savez(
+    std::shared_ptr<io::Writer> out_stream,
+    const std::unordered_map<std::string, array>& arrays,
+    bool compressed /* = false */) {
+  if (!out_stream->good() || !out_stream->is_open()) {
+    throw std::runtime_error("[savez] Failed to open " + out_stream->label());
+  }
+  if (compressed && !io::detail::deflate_available()) {
+    throw std::invalid_argument(
+        "[savez] MLX was built without zlib, compression is not supported.");
+  }
+  uint16_t method = compressed ? method_deflated : method_stored;
+
+  std::vector<std::string> keys;
+  for (auto& [key, _] : arrays) {
+    keys.push_back(key);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  // Like numpy, the local headers always have a zip64 extra field since the
+  // sizes are only known once the member is written
+  size_t start = out_stream->tell();
+  std::string central;
+  for (auto& key : keys) {
+    auto name = key + ".npy";
+    uint64_t local_offset = out_stream->tell() - start;
+    std::string local;
+    append_le<uint32_t>(local, zip_local_signature);
+    append_le<uint16_t>(local, 45); // version needed
+    append_le<uint16_t>(local, 0); // flags
+    append_le<uint16_t>(local, method);
+    append_le<uint16_t>(local, 0); // time
+    append_le<uint16_t>(local, zip_date);
+    append_le<uint32_t>(local, 0); // crc
+    append_le<uint32_t>(local, zip32_max);
+    append_le<uint32_t>(local, zip32_max);
+    append_le<uint16_t>(local, name.size());
+    append_le<uint16_t>(local, 20); // extra
+    local += name;
+    append_le<uint16_t>(local, zip64_extra_id);
+    append_le<uint16_t>(local, 16);
+    append_le<uint64_t>(local, 0);
+    append_le<uint64_t>(local, 0);
+    out_stream->write(local.data(), local.size());
+
+    auto member = std::make_shared<MemberWriter>(out_stream, compressed);
+    save(member, arrays.at(key));
+    member->finish();
+
+    // Fill in the checksum and sizes now that they are known
+    size_t end = out_stream->tell();
+    std::string crc;
+    append_le<uint32_t>(crc, member->crc());
+    std::string sizes;
+    append_le<uint64_t>(sizes, member->size());
+    append_le<uint64_t>(sizes, member->compressed_size());
+    out_stream->seek(start + local_offset + 14);
+    out_stream->write(crc.data(), crc.size());
+    out_stream->seek(start + local_offset + 30 + name.size() + 4);
+    out_stream->write(sizes.data(), sizes.size());
+    out_stream->seek(end);
+
+    std::string extra;
+    bool zip64 = member->size() >= zip32_max ||
+        member->compressed_size() >= zip32_max || local_offset >= zip32_max;
+    if (zip64) {
+      append_le<uint16_t>(extra, zip64_extra_id);
+      append_le<uint16_t>(extra, 24);
+      append_le<uint64_t>(extra, member->size());
+      append_le<uint64_t>(extra, member->compressed_size());
+      append_le<uint64_t>(extra, local_offset);
+    }
+    append_le<uint32_t>(central, zip_central_signature);
+    append_le<uint16_t>(central, zip64 ? 45 : 20); // version made by
+    append_le<uint16_t>(central, zip64 ? 45 : 20); // version needed
+    append_le<uint16_t>(central, 0); // flags
+    append_le<uint16_t>(central, method);
+    append_le<uint16_t>(central, 0); // time
+    append_le<uint16_t>(central, zip_date);
+    append_le<uint32_t>(central, member->crc());
+    append_le<uint32_t>(
+        central, zip64 ? zip32_max : member->compressed_size());
+    append_le<uint32_t>(central, zip64 ? zip32_max : member->size());
+    append_le<uint16_t>(central, name.size());
+    append_le<uint16_t>(central, extra.size());
+    append_le<uint16_t>(central, 0); // comment
+    append_le<uint16_t>(central, 0); // disk
+    append_le<uint16_t>(central, 0); // internal attributes
+    append_le<uint32_t>(central, 0600 << 16); // external attributes
+    append_le<uint32_t>(central, zip64 ? zip32_max : local_offset);
+    central += name + extra;
+  }
+
+  uint64_t cd_offset = out_stream->tell() - start;
+  uint64_t n_entries = keys.size();
+  std::string tail;
+  bool zip64 = n_entries >= zip16_max || cd_offset >= zip32_max ||
+      central.size() >= zip32_max;
+  if (zip64) {
+    append_le<uint32_t>(tail, zip64_eocd_signature);
+    append_le<uint64_t>(tail, 44); // size of the rest of the record
+    append_le<uint16_t>(tail, 45); // version made by
+    append_le<uint16_t>(tail, 45); // version needed
+    append_le<uint32_t>(tail, 0); // disk
+    append_le<uint32_t>(tail, 0); // disk with the central directory
+    append_le<uint64_t>(tail, n_entries);
+    append_le<uint64_t>(tail, n_entries);
+    append_le<uint64_t>(tail, central.size());
+    append_le<uint64_t>(tail, cd_offset);
+
+    append_le<uint32_t>(tail, zip64_eocd_locator_signature);
+    append_le<uint32_t>(tail, 0); // disk with the zip64 record
+    append_le<uint64_t>(tail, cd_offset + central.size());
+    append_le<uint32_t>(tail, 1); // number of disks
+  }
+  append_le<uint32_t>(tail, zip_eocd_signature);
+  append_le<uint32_t>(tail, 0); // disks
+  append_le<uint16_t>(tail, zip64 ? zip16_max : n_entries);
+  append_le<uint16_t>(tail, zip64 ? zip16_max : n_entries);
+  append_le<uint32_t>(tail, zip64 ? zip32_max : central.size());
+  append_le<uint32_t>(tail, zip64 ? zip32_max : cd_offset);
+  append_le<uint16_t>(tail, 0); // comment
+  out_stream->write(central.data(), central.size());
+  out_stream->write(tail.data(), tail.size());
+  if (!out_stream->good()) {
+    throw std::runtime_error(
+        "[savez] Failed to write to " + out_stream->label());
+  }
+}
+
+/** Save array map to file in .npz format */
+void savez(
+    std::string file,
+    const std::unordered_map<std::string, array>& arrays,
+    bool compressed /* = false */) {
+  // Add .npz to file name if it is not there
+  if (file.length() < 4 || file.substr(file.length() - 4, 4) != ".npz") {
+    file += ".npz";
+  }
+  savez(std::make_shared<io::FileWriter>(std::move(file)), arrays, compressed);
+}
+
+} // namespace mlx::core
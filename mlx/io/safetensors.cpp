@@ -1,12 +1,16 @@
 // Copyright © 2023 Apple Inc.
 //
 #include <json.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <stack>
 
 #include "mlx/io.h"
 #include "mlx/io/load.h"
 #include "mlx/ops.h"
 #include "mlx/primitives.h"
+#include "mlx/transforms.h"
 
 using json = nlohmann::json;
 
@@ -94,6 +98,32 @@ Dtype dtype_from_safetensor_str(std::string_view str) {
   }
 }
 
+namespace {
+
+// Reads the json header and sets offset to where the tensor data starts
+json read_header(io::Reader& in_stream, size_t& offset, const char* tag) {
+  uint64_t jsonHeaderLength = 0;
+  in_stream.read(reinterpret_cast<char*>(&jsonHeaderLength), 8);
+  if (jsonHeaderLength <= 0) {
+    throw std::runtime_error(
+        std::string(tag) + " Invalid json header length " + in_stream.label());
+  }
+  // Load the json metadata
+  std::vector<char> rawJson(jsonHeaderLength);
+  in_stream.read(rawJson.data(), jsonHeaderLength);
+  auto metadata =
+      json::parse(rawJson.data(), rawJson.data() + jsonHeaderLength);
+  // Should always be an object on the top-level
+  if (!metadata.is_object()) {
+    throw std::runtime_error(
+        std::string(tag) + " Invalid json metadata " + in_stream.label());
+  }
+  offset = jsonHeaderLength + 8;
+  return metadata;
+}
+
+} // namespace
+
 /** Load array from reader in safetensor format */
 SafetensorsLoad load_safetensors(
     std::shared_ptr<io::Reader> in_stream,
@@ -105,22 +135,8 @@ SafetensorsLoad load_safetensors(
         "[load_safetensors] Failed to open " + in_stream->label());
   }
 
-  uint64_t jsonHeaderLength = 0;
-  in_stream->read(reinterpret_cast<char*>(&jsonHeaderLength), 8);
-  if (jsonHeaderLength <= 0) {
-    throw std::runtime_error(
-        "[load_safetensors] Invalid json header length " + in_stream->label());
-  }
-  // Load the json metadata
-  char rawJson[jsonHeaderLength];
-  in_stream->read(rawJson, jsonHeaderLength);
-  auto metadata = json::parse(rawJson, rawJson + jsonHeaderLength);
-  // Should always be an object on the top-level
-  if (!metadata.is_object()) {
-    throw std::runtime_error(
-        "[load_safetensors] Invalid json metadata " + in_stream->label());
-  }
-  size_t offset = jsonHeaderLength + 8;
+  size_t offset;
+  auto metadata = read_header(*in_stream, offset, "[load_safetensors]");
   // Load the arrays using metadata
   std::unordered_map<std::string, array> res;
   std::unordered_map<std::string, std::string> metadata_map;
@@ -147,7 +163,132 @@ SafetensorsLoad load_safetensors(
 }
 
 SafetensorsLoad load_safetensors(const std::string& file, StreamOrDevice s) {
-  return load_safetensors(std::make_shared<io::FileReader>(file), s);
+  return load_safetensors(io::open_file_reader(file), s);
+}
+
+SafetensorsLoad load_safetensors_sharded(
+    const std::string& index_file,
+    const SafetensorsShardSpec& spec /* = {} */,
+    StreamOrDevice s /* = {} */) {
+  if (spec.world_size < 1 || spec.rank < 0 || spec.rank >= spec.world_size) {
+    std::ostringstream msg;
+    msg << "[load_safetensors_sharded] Invalid rank " << spec.rank
+        << " for world size " << spec.world_size << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  std::ifstream index_stream(index_file);
+  if (!index_stream.is_open()) {
+    throw std::runtime_error(
+        "[load_safetensors_sharded] Failed to open " + index_file);
+  }
+  auto index = json::parse(index_stream);
+  if (!index.is_object() || !index.contains("weight_map") ||
+      !index.at("weight_map").is_object()) {
+    throw std::runtime_error(
+        "[load_safetensors_sharded] Invalid index file " + index_file);
+  }
+
+  std::unordered_map<std::string, std::string> metadata_map;
+  if (index.contains("metadata")) {
+    for (const auto& item : index.at("metadata").items()) {
+      metadata_map.insert(
+          {item.key(),
+           item.value().is_string() ? item.value().get<std::string>()
+                                    : item.value().dump()});
+    }
+  }
+
+  // Group the tensors to load by the file they are in so that each file is
+  // opened and its header parsed once
+  std::unordered_map<std::string, std::vector<std::string>> files;
+  for (const auto& item : index.at("weight_map").items()) {
+    if (!spec.filter || spec.filter(item.key())) {
+      files[item.value().get<std::string>()].push_back(item.key());
+    }
+  }
+
+  auto directory = std::filesystem::path(index_file).parent_path();
+  auto stream = to_stream(s);
+  std::unordered_map<std::string, array> res;
+  for (auto& [file, names] : files) {
+    auto in_stream = io::open_file_reader((directory / file).string());
+    if (!in_stream->good() || !in_stream->is_open()) {
+      throw std::runtime_error(
+          "[load_safetensors_sharded] Failed to open " + in_stream->label());
+    }
+    size_t offset;
+    auto header =
+        read_header(*in_stream, offset, "[load_safetensors_sharded]");
+    for (auto& name : names) {
+      if (!header.contains(name)) {
+        throw std::runtime_error(
+            "[load_safetensors_sharded] Tensor " + name + " not found in " +
+            in_stream->label());
+      }
+      const auto& info = header.at(name);
+      const std::string& dtype = info.at("dtype");
+      std::vector<int> shape = info.at("shape");
+      const std::vector<size_t>& data_offsets = info.at("data_offsets");
+      Dtype type = dtype_from_safetensor_str(dtype);
+      size_t data_offset = offset + data_offsets.at(0);
+
+      int axis = (spec.split_axis && spec.world_size > 1)
+          ? spec.split_axis(name, shape)
+          : -1;
+      if (axis < 0) {
+        res.insert(
+            {name,
+             array(
+                 shape,
+                 type,
+                 std::make_shared<Load>(stream, in_stream, data_offset, false),
+                 std::vector<array>{})});
+        continue;
+      }
+      if (axis >= shape.size() || shape[axis] % spec.world_size != 0) {
+        std::ostringstream msg;
+        msg << "[load_safetensors_sharded] Cannot split tensor " << name
+            << " with shape " << shape << " into " << spec.world_size
+            << " parts along axis " << axis << ".";
+        throw std::invalid_argument(msg.str());
+      }
+
+      // When every axis before the split is a singleton each part is a
+      // contiguous range of bytes and only that range is read
+      int part_size = shape[axis] / spec.world_size;
+      bool contiguous = std::all_of(
+          shape.begin(), shape.begin() + axis, [](int d) { return d == 1; });
+      if (contiguous) {
+        auto part_shape = shape;
+        part_shape[axis] = part_size;
+        size_t part_bytes = (data_offsets.at(1) - data_offsets.at(0)) /
+            spec.world_size;
+        res.insert(
+            {name,
+             array(
+                 part_shape,
+                 type,
+                 std::make_shared<Load>(
+                     stream,
+                     in_stream,
+                     data_offset + spec.rank * part_bytes,
+                     false),
+                 std::vector<array>{})});
+      } else {
+        auto full = array(
+            shape,
+            type,
+            std::make_shared<Load>(stream, in_stream, data_offset, false),
+            std::vector<array>{});
+        std::vector<int> start(shape.size(), 0);
+        auto stop = shape;
+        start[axis] = spec.rank * part_size;
+        stop[axis] = start[axis] + part_size;
+        res.insert({name, slice(full, start, stop, stream)});
+      }
+    }
+  }
+  return {res, metadata_map};
 }
 
 void save_safetensors(
@@ -162,21 +303,44 @@ void save_safetensors(
   }
 
   ////////////////////////////////////////////////////////
-  // Check array map
+  // Build the header from the shapes and types so that the arrays can be
+  // evaluated and written one at a time
   json parent;
   json _metadata;
   for (auto& [key, value] : metadata) {
     _metadata[key] = value;
   }
   parent["__metadata__"] = _metadata;
+  std::vector<std::pair<std::string, array>> arrays(
+      std::make_move_iterator(a.begin()), std::make_move_iterator(a.end()));
+  a.clear();
   size_t offset = 0;
-  for (auto& [key, arr] : a) {
-    arr.eval();
+  for (auto& [key, arr] : arrays) {
     if (arr.nbytes() == 0) {
       throw std::invalid_argument(
           "[save_safetensors] cannot serialize an empty array key: " + key);
     }
+    json child;
+    child["dtype"] = dtype_to_safetensor_str(arr.dtype());
+    child["shape"] = arr.shape();
+    child["data_offsets"] = std::vector<size_t>{offset, offset + arr.nbytes()};
+    parent[key] = child;
+    offset += arr.nbytes();
+  }
 
+  // The header is written last so that a failure while evaluating or
+  // writing the arrays doesn't leave a file which looks valid
+  auto header = parent.dump();
+  uint64_t header_len = header.length();
+  size_t header_offset = out_stream->tell();
+
+  ////////////////////////////////////////////////////////
+  // Write the arrays, computing the next one while the current one is
+  // written. Each one is released once it's written, so unless the caller
+  // still references them only two are in memory at a time. The offsets are
+  // known from the header so each array is written in chunks concurrently.
+  auto make_row_contiguous = [](array& arr) {
+    arr.eval();
     // Try to make it row contiguous
     if (!arr.flags().row_contiguous) {
       arr = reshape(flatten(arr), arr.shape());
@@ -189,22 +353,25 @@ void save_safetensors(
       throw std::invalid_argument(
           "[save_safetensors] can only serialize row-major arrays");
     }
-
-    json child;
-    child["dtype"] = dtype_to_safetensor_str(arr.dtype());
-    child["shape"] = arr.shape();
-    child["data_offsets"] = std::vector<size_t>{offset, offset + arr.nbytes()};
-    parent[key] = child;
-    offset += arr.nbytes();
+  };
+  if (!arrays.empty()) {
+    async_eval({arrays[0].second});
   }
-
-  auto header = parent.dump();
-  uint64_t header_len = header.length();
-  out_stream->write(reinterpret_cast<char*>(&header_len), 8);
-  out_stream->write(header.c_str(), header_len);
-  for (auto& [key, arr] : a) {
-    out_stream->write(arr.data<char>(), arr.nbytes());
+  offset = header_offset + 8 + header_len;
+  for (size_t i = 0; i < arrays.size(); i++) {
+    auto arr = std::move(arrays[i].second);
+    make_row_contiguous(arr);
+    if (i + 1 < arrays.size()) {
+      async_eval({arrays[i + 1].second});
+    }
+    io::parallel_write(*out_stream, arr.data<char>(), arr.nbytes(), offset);
+    offset += arr.nbytes();
   }
+  out_stream->flush();
+  out_stream->write_at(
+      reinterpret_cast<char*>(&header_len), 8, header_offset);
+  out_stream->write_at(header.c_str(), header_len, header_offset + 8);
+  out_stream->seek(offset);
 }
 
 void save_safetensors(
@@ -216,9 +383,19 @@ void save_safetensors(
       file.substr(file.length() - 12, 12) != ".safetensors")
     file += ".safetensors";
 
-  // Serialize array
-  save_safetensors(
-      std::make_shared<io::FileWriter>(std::move(file)), a, metadata);
+  // Serialize to a temporary file which replaces the file once complete so
+  // that a failure doesn't leave a truncated file behind
+  auto tmp_file = file + ".tmp";
+  try {
+    save_safetensors(std::make_shared<io::FileWriter>(tmp_file), a, metadata);
+  } catch (...) {
+    std::remove(tmp_file.c_str());
+    throw;
+  }
+  if (std::rename(tmp_file.c_str(), file.c_str()) != 0) {
+    std::remove(tmp_file.c_str());
+    throw std::runtime_error("[save_safetensors] Failed to write " + file);
+  }
 }
 
 } // namespace mlx::core
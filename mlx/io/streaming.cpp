@@ -0,0 +1,136 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <sstream>
+
+#include "mlx/backend/metal/metal.h"
+#include "mlx/io.h"
+#include "mlx/primitives.h"
+#include "mlx/transforms.h"
+
+namespace mlx::core {
+
+namespace {
+
+// The Load primitive of a weight which was not evaluated yet
+const Load* as_load(const array& w) {
+  if (!w.has_primitive() || typeid(w.primitive()) != typeid(Load)) {
+    return nullptr;
+  }
+  return static_cast<const Load*>(&w.primitive());
+}
+
+} // namespace
+
+WeightStreamer::WeightStreamer(std::vector<Layer> layers, int lookahead)
+    : layers_(std::move(layers)), lookahead_(lookahead) {
+  if (lookahead < 0) {
+    throw std::invalid_argument(
+        "[WeightStreamer] The lookahead must be non-negative.");
+  }
+  for (auto& layer : layers_) {
+    std::vector<MappedRange> ranges;
+    size_t bytes = 0;
+    for (auto& [_, w] : layer) {
+      auto load = as_load(w);
+      if (!load) {
+        continue;
+      }
+      auto [reader, offset, swap_endianness] = load->state();
+      if (auto file = reader->mapped_file(); file && !swap_endianness) {
+        ranges.push_back({file, offset, w.nbytes()});
+        bytes += w.nbytes();
+      }
+    }
+    ranges_.push_back(std::move(ranges));
+    mapped_bytes_.push_back(bytes);
+  }
+}
+
+WeightStreamer::Layer WeightStreamer::read_(int i) const {
+  Layer out;
+  for (auto& [name, w] : layers_[i]) {
+    if (as_load(w)) {
+      out.insert({name, array(w.shape(), w.dtype(), w.primitive_ptr(), {})});
+    } else {
+      out.insert({name, w});
+    }
+  }
+  for (auto& r : ranges_[i]) {
+    r.file->will_need(r.offset, r.size);
+  }
+  return out;
+}
+
+void WeightStreamer::touch_(int i) {
+  if (auto it = std::find(resident_.begin(), resident_.end(), i);
+      it != resident_.end()) {
+    resident_.erase(it);
+  } else {
+    resident_bytes_ += mapped_bytes_[i];
+  }
+  resident_.push_back(i);
+}
+
+void WeightStreamer::evict_(int i) {
+  auto limit = metal::get_memory_limit();
+  if (limit == 0) {
+    return;
+  }
+  int n = layers_.size();
+  auto in_window = [&](int j) { return (j - i + n) % n <= lookahead_; };
+  auto it = resident_.begin();
+  while (it != resident_.end() &&
+         resident_bytes_ + metal::get_active_memory() > limit) {
+    if (in_window(*it)) {
+      ++it;
+      continue;
+    }
+    for (auto& r : ranges_[*it]) {
+      r.file->dont_need(r.offset, r.size);
+    }
+    resident_bytes_ -= mapped_bytes_[*it];
+    it = resident_.erase(it);
+  }
+}
+
+WeightStreamer::Layer WeightStreamer::layer(int i) {
+  int n = layers_.size();
+  if (i < 0 || i >= n) {
+    std::ostringstream msg;
+    msg << "[WeightStreamer::layer] Layer " << i << " is out of range for "
+        << n << " layers.";
+    throw std::out_of_range(msg.str());
+  }
+
+  Layer out;
+  if (auto it = prefetched_.find(i); it != prefetched_.end()) {
+    out = std::move(it->second);
+    prefetched_.erase(it);
+  } else {
+    out = read_(i);
+  }
+  touch_(i);
+
+  // Start reading the next layers, wrapping around to the first layers for
+  // the next pass over the model
+  for (int k = 1; k <= lookahead_ && k < n; k++) {
+    int j = (i + k) % n;
+    if (prefetched_.find(j) != prefetched_.end()) {
+      continue;
+    }
+    auto next = read_(j);
+    std::vector<array> arrays;
+    for (auto& [_, w] : next) {
+      arrays.push_back(w);
+    }
+    async_eval(std::move(arrays));
+    prefetched_.insert({j, std::move(next)});
+    touch_(j);
+  }
+
+  evict_(i);
+  return out;
+}
+
+} // namespace mlx::core
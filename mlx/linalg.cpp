@@ -292,4 +292,144 @@ array cholesky(
       {a});
 }
 
+namespace {
+
+// Check a system a x = b and broadcast the batch dimensions of a and b. A
+// vector b is solved as a matrix of one column.
+std::vector<array> solve_inputs(
+    const array& a,
+    const array& b,
+    const char* tag,
+    StreamOrDevice s) {
+  if (a.dtype() != float32 || b.dtype() != float32) {
+    std::ostringstream msg;
+    msg << "[linalg::" << tag << "] Arrays must type float32. Received "
+        << "arrays with types " << a.dtype() << " and " << b.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (a.ndim() < 2 || a.shape(-1) != a.shape(-2)) {
+    std::ostringstream msg;
+    msg << "[linalg::" << tag << "] The first input must be a square "
+        << "matrix but has shape " << a.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto b_mat = b.ndim() == 1 ? expand_dims(b, 1, s) : b;
+  if (b_mat.ndim() < 2 || b_mat.shape(-2) != a.shape(-1)) {
+    std::ostringstream msg;
+    msg << "[linalg::" << tag << "] Incompatible shapes " << a.shape()
+        << " and " << b.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  std::vector<int> a_batch(a.shape().begin(), a.shape().end() - 2);
+  std::vector<int> b_batch(b_mat.shape().begin(), b_mat.shape().end() - 2);
+  auto batch = broadcast_shapes(a_batch, b_batch);
+  auto a_shape = batch;
+  a_shape.insert(a_shape.end(), a.shape().end() - 2, a.shape().end());
+  auto b_shape = batch;
+  b_shape.insert(b_shape.end(), b_mat.shape().end() - 2, b_mat.shape().end());
+  return {broadcast_to(a, a_shape, s), broadcast_to(b_mat, b_shape, s)};
+}
+
+} // namespace
+
+array solve(const array& a, const array& b, StreamOrDevice s /* = {} */) {
+  auto inputs = solve_inputs(a, b, "solve", s);
+  auto out_shape = inputs[1].shape();
+  auto out = array(
+      std::move(out_shape),
+      float32,
+      std::make_shared<Solve>(to_stream(s)),
+      std::move(inputs));
+  return b.ndim() == 1 ? squeeze(out, -1, s) : out;
+}
+
+array solve_triangular(
+    const array& a,
+    const array& b,
+    bool upper /* = false */,
+    StreamOrDevice s /* = {} */) {
+  auto inputs = solve_inputs(a, b, "solve_triangular", s);
+  auto out_shape = inputs[1].shape();
+  auto out = array(
+      std::move(out_shape),
+      float32,
+      std::make_shared<SolveTriangular>(to_stream(s), upper),
+      std::move(inputs));
+  return b.ndim() == 1 ? squeeze(out, -1, s) : out;
+}
+
+array cho_solve(
+    const array& L,
+    const array& b,
+    bool upper /* = false */,
+    StreamOrDevice s /* = {} */) {
+  // a = L L^T so a x = b is solved with the two triangular systems
+  // L y = b and L^T x = y. With the upper factor a = U^T U so L is U^T.
+  auto lower = upper ? swapaxes(L, -1, -2, s) : L;
+  // A vector stays a column between the two solves so that it keeps being
+  // broadcast against a batch of factors
+  auto rhs = b.ndim() == 1 ? expand_dims(b, -1, s) : b;
+  auto y = solve_triangular(lower, rhs, false, s);
+  auto x = solve_triangular(swapaxes(lower, -1, -2, s), y, true, s);
+  return b.ndim() == 1 ? squeeze(x, -1, s) : x;
+}
+
+namespace {
+
+std::vector<array> eigh_impl(
+    const array& a,
+    const std::string& UPLO,
+    bool compute_eigenvectors,
+    const char* tag,
+    StreamOrDevice s) {
+  if (a.dtype() != float32) {
+    std::ostringstream msg;
+    msg << "[linalg::" << tag << "] Arrays must type float32. Received array "
+        << "with type " << a.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (a.ndim() < 2 || a.shape(-1) != a.shape(-2)) {
+    std::ostringstream msg;
+    msg << "[linalg::" << tag << "] Eigenvalues are only defined for square "
+        << "matrices but received an array of shape " << a.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (UPLO != "L" && UPLO != "U") {
+    std::ostringstream msg;
+    msg << "[linalg::" << tag << "] UPLO must be 'L' or 'U' but got '" << UPLO
+        << "'.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  std::vector<int> w_shape(a.shape().begin(), a.shape().end() - 1);
+  std::vector<std::vector<int>> shapes = {w_shape};
+  if (compute_eigenvectors) {
+    shapes.push_back(a.shape());
+  }
+  std::vector<Dtype> dtypes(shapes.size(), float32);
+  return array::make_arrays(
+      std::move(shapes),
+      std::move(dtypes),
+      std::make_shared<Eigh>(to_stream(s), UPLO[0], compute_eigenvectors),
+      {a});
+}
+
+} // namespace
+
+std::pair<array, array> eigh(
+    const array& a,
+    std::string UPLO /* = "L" */,
+    StreamOrDevice s /* = {} */) {
+  auto out = eigh_impl(a, UPLO, true, "eigh", s);
+  return {out[0], out[1]};
+}
+
+array eigvalsh(
+    const array& a,
+    std::string UPLO /* = "L" */,
+    StreamOrDevice s /* = {} */) {
+  return eigh_impl(a, UPLO, false, "eigvalsh", s)[0];
+}
+
 } // namespace mlx::core::linalg
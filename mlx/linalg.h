@@ -68,4 +68,43 @@ array inv(const array& a, StreamOrDevice s = {});
 
 array cholesky(const array& a, bool upper = false, StreamOrDevice s = {});
 
+/**
+ * Solve a x = b for x with a general square matrix a, without forming its
+ * inverse. b is a matrix or a vector and both are batched over their leading
+ * dimensions.
+ */
+array solve(const array& a, const array& b, StreamOrDevice s = {});
+
+/**
+ * Solve a x = b for x where a is lower triangular, or upper triangular when
+ * upper is true. Only that triangle of a is read. b is a matrix or, like in
+ * matmul, a vector, and both are batched over their leading dimensions.
+ */
+array solve_triangular(
+    const array& a,
+    const array& b,
+    bool upper = false,
+    StreamOrDevice s = {});
+
+/**
+ * Solve a x = b for x given the Cholesky factor L of a, lower triangular or
+ * upper triangular when upper is true, as returned by cholesky.
+ */
+array cho_solve(
+    const array& L,
+    const array& b,
+    bool upper = false,
+    StreamOrDevice s = {});
+
+/**
+ * Eigenvalues in ascending order and eigenvectors, as the columns of the
+ * second output, of real symmetric matrices. Only the lower triangle is read,
+ * or the upper one when UPLO is "U".
+ */
+std::pair<array, array>
+eigh(const array& a, std::string UPLO = "L", StreamOrDevice s = {});
+
+/** Eigenvalues of real symmetric matrices in ascending order, see eigh. */
+array eigvalsh(const array& a, std::string UPLO = "L", StreamOrDevice s = {});
+
 } // namespace mlx::core::linalg
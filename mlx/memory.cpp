@@ -0,0 +1,232 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "mlx/backend/metal/metal.h"
+#include "mlx/memory.h"
+#include "mlx/memory_impl.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core::memory {
+
+namespace {
+
+constexpr size_t max_samples = 1 << 20;
+
+struct Tracker {
+  std::atomic<bool> enabled{false};
+  std::mutex mtx;
+  std::chrono::steady_clock::time_point origin;
+  std::unordered_map<const void*, Allocation> live;
+  std::vector<Sample> timeline;
+};
+
+Tracker& tracker() {
+  static Tracker tracker_;
+  return tracker_;
+}
+
+uint64_t now(const Tracker& t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - t.origin)
+      .count();
+}
+
+// Must be called with the lock held
+void sample(Tracker& t, uint64_t time) {
+  if (t.timeline.size() < max_samples) {
+    t.timeline.push_back({time, metal::get_active_memory()});
+  }
+}
+
+// The tags of the Tag objects alive on this thread joined with "/"
+thread_local std::string thread_tags;
+
+// The primitive and tags of the task running on this thread, if any
+struct Owner {
+  const std::string* primitive;
+  const std::string* tags;
+};
+thread_local Owner task_owner{nullptr, nullptr};
+
+std::string format_bytes(double bytes) {
+  const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+  int i = 0;
+  while (bytes >= 1024 && i < 4) {
+    bytes /= 1024;
+    i++;
+  }
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(i > 0 ? 2 : 0) << bytes << " "
+     << units[i];
+  return os.str();
+}
+
+std::string owner_name(const Allocation& a) {
+  std::string name = a.primitive.empty() ? "(no primitive)" : a.primitive;
+  if (!a.tag.empty()) {
+    name += " [" + a.tag + "]";
+  }
+  return name;
+}
+
+} // namespace
+
+namespace detail {
+
+void on_malloc(const allocator::Buffer& buffer, size_t size) {
+  auto& t = tracker();
+  if (!t.enabled.load(std::memory_order_relaxed) || !buffer.ptr()) {
+    return;
+  }
+  Allocation a{size, "", thread_tags, 0};
+  if (task_owner.primitive) {
+    a.primitive = *task_owner.primitive;
+    a.tag = *task_owner.tags;
+  }
+  std::lock_guard<std::mutex> lk(t.mtx);
+  a.time = now(t);
+  sample(t, a.time);
+  t.live[buffer.ptr()] = std::move(a);
+}
+
+void tracked_free(allocator::Buffer buffer) {
+  // The lock is held while freeing so the buffer can't be handed out and
+  // recorded again before its record is erased
+  auto& t = tracker();
+  std::lock_guard<std::mutex> lk(t.mtx);
+  if (buffer.ptr()) {
+    t.live.erase(buffer.ptr());
+  }
+  allocator::allocator().free(buffer);
+  if (t.enabled) {
+    sample(t, now(t));
+  }
+}
+
+scheduler::Task tag(const array& arr, scheduler::Task task) {
+  // The array is detached by the task so its primitive is named now
+  std::ostringstream name;
+  arr.primitive().print(name);
+  return [task = std::move(task),
+          primitive = name.str(),
+          tags = thread_tags]() mutable {
+    struct Scope {
+      Owner prev;
+      Scope(const std::string* primitive, const std::string* tags)
+          : prev(task_owner) {
+        task_owner = {primitive, tags};
+      }
+      ~Scope() {
+        task_owner = prev;
+      }
+    } scope(&primitive, &tags);
+    task();
+  };
+}
+
+} // namespace detail
+
+void start_tracking() {
+  auto& t = tracker();
+  std::lock_guard<std::mutex> lk(t.mtx);
+  t.live.clear();
+  t.timeline.clear();
+  t.origin = std::chrono::steady_clock::now();
+  t.enabled = true;
+}
+
+void stop_tracking() {
+  tracker().enabled = false;
+  synchronize(default_stream(Device::cpu));
+  if (metal::is_available()) {
+    synchronize(default_stream(Device::gpu));
+  }
+}
+
+bool is_tracking() {
+  return tracker().enabled.load(std::memory_order_relaxed);
+}
+
+std::vector<Allocation> live_allocations() {
+  std::vector<Allocation> out;
+  {
+    auto& t = tracker();
+    std::lock_guard<std::mutex> lk(t.mtx);
+    out.reserve(t.live.size());
+    for (auto& [ptr, a] : t.live) {
+      out.push_back(a);
+    }
+  }
+  std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+    return a.size > b.size;
+  });
+  return out;
+}
+
+std::vector<Sample> timeline() {
+  auto& t = tracker();
+  std::lock_guard<std::mutex> lk(t.mtx);
+  return t.timeline;
+}
+
+std::string report(int top /* = 10 */) {
+  std::ostringstream os;
+  os << "Active memory " << format_bytes(metal::get_active_memory())
+     << ", peak " << format_bytes(metal::get_peak_memory()) << ", cache "
+     << format_bytes(metal::get_cache_memory()) << "\n";
+  if (!is_tracking()) {
+    os << "Allocations are not tracked, see memory::start_tracking.\n";
+    return os.str();
+  }
+
+  auto live = live_allocations();
+  size_t total = 0;
+  std::map<std::string, std::pair<size_t, size_t>> owners;
+  for (auto& a : live) {
+    total += a.size;
+    auto& [n, bytes] = owners[owner_name(a)];
+    n++;
+    bytes += a.size;
+  }
+  std::vector<std::pair<std::string, std::pair<size_t, size_t>>> by_owner(
+      owners.begin(), owners.end());
+  std::sort(by_owner.begin(), by_owner.end(), [](auto& a, auto& b) {
+    return a.second.second > b.second.second;
+  });
+
+  os << live.size() << " live tracked buffers of " << format_bytes(total)
+     << "\nBy owner:\n";
+  for (auto& [name, stats] : by_owner) {
+    os << "  " << std::setw(12) << format_bytes(stats.second) << " in "
+       << stats.first << " buffers  " << name << "\n";
+  }
+  os << "Largest buffers:\n";
+  for (int i = 0; i < top && i < live.size(); i++) {
+    auto& a = live[i];
+    os << "  " << std::setw(12) << format_bytes(a.size) << "  "
+       << owner_name(a) << " at " << std::fixed << std::setprecision(3)
+       << a.time * 1e-6 << " ms\n";
+  }
+  return os.str();
+}
+
+Tag::Tag(std::string name) : prev_size_(thread_tags.size()) {
+  if (!thread_tags.empty()) {
+    thread_tags += "/";
+  }
+  thread_tags += name;
+}
+
+Tag::~Tag() {
+  thread_tags.resize(prev_size_);
+}
+
+} // namespace mlx::core::memory
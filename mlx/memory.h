@@ -0,0 +1,115 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mlx::core::memory {
+
+/* A buffer allocated while tracking which has not been freed. */
+struct Allocation {
+  size_t size;
+  // The primitive whose evaluation allocated the buffer, empty for buffers
+  // allocated outside of an evaluation, e.g. when making an array from data
+  std::string primitive;
+  // The owner tags active when the buffer was allocated, outermost first and
+  // separated by "/"
+  std::string tag;
+  // Nanoseconds since tracking started
+  uint64_t time;
+};
+
+/* The active memory right after an allocation or free. */
+struct Sample {
+  // Nanoseconds since tracking started
+  uint64_t time;
+  size_t active;
+};
+
+/* Start tracking the buffers allocated on every device. Records from an
+ * earlier tracking are cleared and buffers allocated before are not tracked.
+ *
+ * Each allocation and free takes a lock while tracking. When not tracking
+ * they only check a flag. At most one million timeline samples are kept.
+ * */
+void start_tracking();
+
+/* Stop tracking and wait for the running work to finish. The records are
+ * kept until tracking starts again. */
+void stop_tracking();
+
+/* Whether allocations are being tracked. */
+bool is_tracking();
+
+/* The tracked buffers which are still live, largest first. */
+std::vector<Allocation> live_allocations();
+
+/* The active memory after each allocation and free since tracking started,
+ * in order. */
+std::vector<Sample> timeline();
+
+/* A human readable summary of the memory use: the active and peak memory,
+ * the live tracked bytes per primitive and tag and the `top` largest live
+ * buffers. When tracking, it is added to the error raised by a failed
+ * allocation. */
+std::string report(int top = 10);
+
+/* Tag the buffers allocated while the tag is alive, including the outputs
+ * of arrays evaluated on any stream. Tags nest. For example:
+ *
+ *   {
+ *     memory::Tag tag("kv_cache");
+ *     eval(cache);
+ *   }
+ * */
+class Tag {
+ public:
+  explicit Tag(std::string name);
+  ~Tag();
+
+  Tag(const Tag&) = delete;
+  Tag& operator=(const Tag&) = delete;
+
+ private:
+  size_t prev_size_;
+};
+
+/* The memory pressure reported by the OS. Only macOS reports when the
+ * pressure goes back to normal. */
+enum class Pressure { normal, warning, critical };
+
+/* Start reacting to the memory pressure notifications of the OS, a dispatch
+ * source on macOS and a pressure stall (PSI) trigger on /proc/pressure/memory
+ * on Linux. On every notification handle_pressure is called from a
+ * background thread.
+ *
+ * Returns false if the OS does not send notifications, e.g. a Linux kernel
+ * without PSI, in which case handle_pressure can still be called directly.
+ * */
+bool start_pressure_monitor();
+
+/* Stop reacting to the memory pressure notifications of the OS. It must not
+ * be called from a pressure callback. */
+void stop_pressure_monitor();
+
+/* Whether the memory pressure notifications of the OS are handled. */
+bool is_monitoring_pressure();
+
+/* Trim the memory held by MLX for the given pressure level and call the
+ * pressure callbacks. On a warning the buffer cache is cleared, on a
+ * critical pressure the prepacked weights are released as well. */
+void handle_pressure(Pressure level);
+
+/* Register a callback called with the level on every memory pressure
+ * notification, after the caches are trimmed, e.g. to drop application
+ * caches. It may be called from a background thread.
+ *
+ * Returns an id to remove the callback with. */
+int add_pressure_callback(std::function<void(Pressure)> callback);
+
+/* Remove the callback with the given id. */
+void remove_pressure_callback(int id);
+
+} // namespace mlx::core::memory
@@ -0,0 +1,21 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/allocator.h"
+#include "mlx/array.h"
+#include "mlx/task_queue.h"
+
+namespace mlx::core::memory::detail {
+
+// Record a buffer returned by the allocator
+void on_malloc(const allocator::Buffer& buffer, size_t size);
+
+// Give a buffer back to the allocator and erase its record
+void tracked_free(allocator::Buffer buffer);
+
+// Wrap the task evaluating arr so the buffers it allocates are attributed to
+// its primitive and the tags of the calling thread
+scheduler::Task tag(const array& arr, scheduler::Task task);
+
+} // namespace mlx::core::memory::detail
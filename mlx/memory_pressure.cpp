@@ -0,0 +1,220 @@
+// Copyright © 2024 Apple Inc.
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#endif
+
+#include "mlx/backend/metal/metal.h"
+#include "mlx/memory.h"
+
+namespace mlx::core::memory {
+
+namespace {
+
+#if defined(__linux__)
+// A stall of 150ms in a 2s window. Unprivileged processes may only create
+// triggers whose window is a multiple of 2s.
+constexpr const char* warning_trigger = "some 150000 2000000";
+constexpr const char* critical_trigger = "full 150000 2000000";
+
+// Returns a file descriptor which is ready with POLLPRI when the trigger
+// fires, -1 if PSI is not available
+int open_trigger(const char* trigger) {
+  int fd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  if (write(fd, trigger, std::strlen(trigger) + 1) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+#endif
+
+struct Monitor {
+  // Guards starting and stopping
+  std::mutex mtx;
+  bool running{false};
+
+  std::mutex callbacks_mtx;
+  std::map<int, std::function<void(Pressure)>> callbacks;
+  int next_id{0};
+
+#if defined(__APPLE__)
+  dispatch_source_t source{nullptr};
+#elif defined(__linux__)
+  std::thread thread;
+  int fds[3]{-1, -1, -1};
+
+  ~Monitor() {
+    stop();
+  }
+
+  void run() {
+    pollfd pfds[3] = {
+        {fds[0], POLLPRI, 0}, {fds[1], POLLPRI, 0}, {fds[2], POLLIN, 0}};
+    while (true) {
+      if (poll(pfds, 3, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (pfds[2].revents != 0 || ((pfds[0].revents | pfds[1].revents) &
+                                   (POLLERR | POLLHUP | POLLNVAL))) {
+        return;
+      }
+      if (pfds[1].revents & POLLPRI) {
+        handle_pressure(Pressure::critical);
+      } else if (pfds[0].revents & POLLPRI) {
+        handle_pressure(Pressure::warning);
+      }
+    }
+  }
+#endif
+
+  bool start() {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (running) {
+      return true;
+    }
+#if defined(__APPLE__)
+    source = dispatch_source_create(
+        DISPATCH_SOURCE_TYPE_MEMORYPRESSURE,
+        0,
+        DISPATCH_MEMORYPRESSURE_NORMAL | DISPATCH_MEMORYPRESSURE_WARN |
+            DISPATCH_MEMORYPRESSURE_CRITICAL,
+        dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+    if (source == nullptr) {
+      return false;
+    }
+    dispatch_set_context(source, source);
+    dispatch_source_set_event_handler_f(source, [](void* ctx) {
+      auto flags =
+          dispatch_source_get_data(static_cast<dispatch_source_t>(ctx));
+      if (flags & DISPATCH_MEMORYPRESSURE_CRITICAL) {
+        handle_pressure(Pressure::critical);
+      } else if (flags & DISPATCH_MEMORYPRESSURE_WARN) {
+        handle_pressure(Pressure::warning);
+      } else {
+        handle_pressure(Pressure::normal);
+      }
+    });
+    dispatch_resume(source);
+    running = true;
+#elif defined(__linux__)
+    fds[0] = open_trigger(warning_trigger);
+    fds[1] = open_trigger(critical_trigger);
+    fds[2] = eventfd(0, EFD_CLOEXEC);
+    if (fds[0] < 0 || fds[1] < 0 || fds[2] < 0) {
+      close_fds();
+      return false;
+    }
+    thread = std::thread([this]() { run(); });
+    running = true;
+#endif
+    return running;
+  }
+
+  void stop() {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (!running) {
+      return;
+    }
+#if defined(__APPLE__)
+    dispatch_source_cancel(source);
+    dispatch_release(source);
+    source = nullptr;
+#elif defined(__linux__)
+    uint64_t one = 1;
+    [[maybe_unused]] auto n = write(fds[2], &one, sizeof(one));
+    thread.join();
+    close_fds();
+#endif
+    running = false;
+  }
+
+#if defined(__linux__)
+  void close_fds() {
+    for (auto& fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+        fd = -1;
+      }
+    }
+  }
+#endif
+};
+
+Monitor& monitor() {
+  static Monitor monitor_;
+  return monitor_;
+}
+
+} // namespace
+
+bool start_pressure_monitor() {
+  return monitor().start();
+}
+
+void stop_pressure_monitor() {
+  monitor().stop();
+}
+
+bool is_monitoring_pressure() {
+  auto& m = monitor();
+  std::lock_guard<std::mutex> lk(m.mtx);
+  return m.running;
+}
+
+void handle_pressure(Pressure level) {
+  if (level != Pressure::normal) {
+    metal::clear_cache();
+  }
+  if (level == Pressure::critical) {
+    metal::clear_prepacked();
+  }
+
+  // Call the callbacks without the lock so they may add or remove callbacks
+  std::vector<std::function<void(Pressure)>> callbacks;
+  {
+    auto& m = monitor();
+    std::lock_guard<std::mutex> lk(m.callbacks_mtx);
+    for (auto& [id, cb] : m.callbacks) {
+      callbacks.push_back(cb);
+    }
+  }
+  for (auto& cb : callbacks) {
+    cb(level);
+  }
+}
+
+int add_pressure_callback(std::function<void(Pressure)> callback) {
+  auto& m = monitor();
+  std::lock_guard<std::mutex> lk(m.callbacks_mtx);
+  int id = m.next_id++;
+  m.callbacks.insert({id, std::move(callback)});
+  return id;
+}
+
+void remove_pressure_callback(int id) {
+  auto& m = monitor();
+  std::lock_guard<std::mutex> lk(m.callbacks_mtx);
+  m.callbacks.erase(id);
+}
+
+} // namespace mlx::core::memory
@@ -4,16 +4,26 @@
 
 #include "mlx/array.h"
 #include "mlx/backend/metal/metal.h"
+#include "mlx/batch_split.h"
+#include "mlx/cancellation.h"
 #include "mlx/compile.h"
 #include "mlx/device.h"
 #include "mlx/distributed/distributed.h"
 #include "mlx/distributed/ops.h"
+#include "mlx/einsum.h"
+#include "mlx/export.h"
 #include "mlx/fast.h"
 #include "mlx/fft.h"
 #include "mlx/io.h"
 #include "mlx/linalg.h"
+#include "mlx/memory.h"
 #include "mlx/ops.h"
+#include "mlx/prefetch.h"
+#include "mlx/profiler.h"
 #include "mlx/random.h"
+#include "mlx/ragged.h"
+#include "mlx/sparse.h"
 #include "mlx/stream.h"
+#include "mlx/threadpool.h"
 #include "mlx/transforms.h"
 #include "mlx/utils.h"
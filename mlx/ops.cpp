@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <climits>
 #include <cmath>
+#include <limits>
 #include <numeric>
 #include <set>
 #include <sstream>
@@ -688,6 +689,60 @@ array slice_update(
       src, update, std::move(start), std::move(stop), std::move(strides), s);
 }
 
+std::vector<array> cache_append(
+    const array& cache,
+    const array& update,
+    int offset,
+    int axis,
+    int step /* = 256 */,
+    StreamOrDevice s /* = {} */) {
+  if (cache.ndim() != update.ndim()) {
+    std::ostringstream msg;
+    msg << "[cache_append] The update must have as many dimensions as the "
+        << "cache but got " << update.ndim() << " and " << cache.ndim()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto ax = axis < 0 ? axis + cache.ndim() : axis;
+  if (ax < 0 || ax >= cache.ndim()) {
+    std::ostringstream msg;
+    msg << "[cache_append] Invalid axis " << axis << " for a cache with "
+        << cache.ndim() << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (offset < 0 || offset > cache.shape(ax)) {
+    std::ostringstream msg;
+    msg << "[cache_append] Invalid offset " << offset << " for a cache with "
+        << cache.shape(ax) << " entries.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (step <= 0) {
+    throw std::invalid_argument("[cache_append] The step must be positive.");
+  }
+  for (int i = 0; i < cache.ndim(); i++) {
+    if (i != ax && cache.shape(i) != update.shape(i)) {
+      std::ostringstream msg;
+      msg << "[cache_append] The update of shape " << update.shape()
+          << " does not match the cache of shape " << cache.shape()
+          << " outside of axis " << ax << ".";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+
+  auto filled = offset + update.shape(ax);
+  auto shape = cache.shape();
+  if (filled > shape[ax]) {
+    shape[ax] = ((filled + step - 1) / step) * step;
+  }
+  auto view_shape = shape;
+  view_shape[ax] = filled;
+  return array::make_arrays(
+      {std::move(shape), std::move(view_shape)},
+      {cache.dtype(), cache.dtype()},
+      std::make_shared<CacheAppend>(to_stream(s), offset, ax),
+      {cache, astype(update, cache.dtype(), s)});
+}
+
 std::vector<array> split(
     const array& a,
     const std::vector<int>& indices,
@@ -1942,6 +1997,28 @@ array logsumexp(
     const std::vector<int>& axes,
     bool keepdims /* = false */,
     StreamOrDevice s /* = {}*/) {
+  // Reductions over trailing axes are computed in a single pass by the
+  // LogSumExp primitive once they are folded into the last axis
+  auto [out_shape, sorted_axes] = compute_reduce_shape(axes, a.shape());
+  bool trailing = !sorted_axes.empty() && a.size() > 0 &&
+      a.dtype() != complex64 && sorted_axes.front() + axes.size() == a.ndim();
+  if (trailing) {
+    auto dtype = at_least_float(a.dtype());
+    std::vector<int> shape(a.shape().begin(), a.shape().end() - axes.size());
+    shape.push_back(-1);
+    auto in = astype(reshape(a, shape, s), dtype, s);
+    shape.back() = 1;
+    auto out = array(
+        std::move(shape),
+        dtype,
+        std::make_shared<LogSumExp>(to_stream(s)),
+        {std::move(in)});
+    if (!keepdims) {
+      out_shape.resize(a.ndim() - axes.size());
+    }
+    return reshape(out, std::move(out_shape), s);
+  }
+
   auto maxval = stop_gradient(max(a, axes, true, s), s);
   auto out = log(sum(exp(subtract(a, maxval, s), s), axes, keepdims, s), s);
   out = add(out, reshape(maxval, out.shape(), s), s);
@@ -2640,6 +2717,84 @@ array take_along_axis(
   return reshape(out, out_shape, s);
 }
 
+namespace {
+
+// Scatters with at least this many updated elements may be sorted and
+// reduced per segment instead of using atomics
+constexpr size_t segmented_scatter_min_size = 1 << 14;
+
+// Whether to reduce whole rows scattered along the first axis of a by sorting
+// the indices. Emulated float16 and bfloat16 atomics and rows with more
+// updates than there are rows of a, which must collide, are slow on the GPU.
+bool use_segmented_scatter(
+    const array& a,
+    const std::vector<array>& indices,
+    const array& updates,
+    const std::vector<int>& axes,
+    Scatter::ReduceType mode,
+    const Stream& s) {
+  if (s.device != Device::gpu || indices.size() != 1 || axes[0] != 0 ||
+      !issubdtype(a.dtype(), floating) || a.ndim() == 0) {
+    return false;
+  }
+  if (mode != Scatter::Sum && mode != Scatter::Max && mode != Scatter::Min) {
+    return false;
+  }
+  auto& idx = indices[0];
+  if (updates.shape(idx.ndim()) != 1) {
+    return false;
+  }
+  for (int i = 1; i < a.ndim(); i++) {
+    if (updates.shape(idx.ndim() + i) != a.shape(i)) {
+      return false;
+    }
+  }
+  if (updates.size() < segmented_scatter_min_size) {
+    return false;
+  }
+  return a.dtype() != float32 || idx.size() > a.shape(0);
+}
+
+// Sorts the updated rows by index and reduces each run of equal indices
+// without atomics. The result does not depend on the order of the updates.
+array segmented_scatter(
+    const array& a,
+    const array& indices,
+    const array& updates,
+    Scatter::ReduceType mode,
+    const Stream& s) {
+  int n_rows = a.shape(0);
+  int n_updates = indices.size();
+  auto idx = astype(flatten(indices, s), int32, s);
+  idx = where(less(idx, array(0), s), add(idx, array(n_rows), s), idx, s);
+  auto order = argsort(idx, s);
+
+  auto row_shape = a.shape();
+  row_shape[0] = n_updates;
+  auto rows = take(reshape(updates, row_shape, s), order, 0, s);
+
+  // The sorted rows with index r start at the number of indices below r
+  auto counts = scatter_add(
+      zeros({n_rows}, int32, s),
+      {idx},
+      ones({n_updates, 1}, int32, s),
+      std::vector<int>{0},
+      s);
+  auto offsets = concatenate(
+      {zeros({1}, int32, s), cumsum(counts, 0, false, true, s)}, 0, s);
+
+  switch (mode) {
+    case Scatter::Sum:
+      return add(a, segment_sum(rows, offsets, s), s);
+    case Scatter::Max:
+      return maximum(a, segment_max(rows, offsets, s), s);
+    default:
+      return minimum(a, segment_min(rows, offsets, s), s);
+  }
+}
+
+} // namespace
+
 /** Scatter updates to given indices */
 array scatter(
     const array& a,
@@ -2726,6 +2881,12 @@ array scatter(
     throw std::invalid_argument(msg.str());
   }
 
+  auto stream = to_stream(s);
+  if (use_segmented_scatter(a, inputs, updates, axes, mode, stream)) {
+    return segmented_scatter(
+        a, inputs[0], astype(updates, a.dtype(), s), mode, stream);
+  }
+
   inputs.insert(inputs.begin(), a);
   // TODO promote or cast?
   inputs.push_back(astype(updates, a.dtype(), s));
@@ -2931,6 +3092,113 @@ array cummin(
       {a});
 }
 
+namespace {
+
+array check_segments(
+    const array& a,
+    const array& offsets,
+    const char* tag,
+    StreamOrDevice s) {
+  if (a.ndim() == 0) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The input must have at least one dimension.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (offsets.ndim() != 1 || offsets.size() == 0 ||
+      !issubdtype(offsets.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The offsets must be a non empty integer vector "
+        << "but got shape " << offsets.shape() << " and type "
+        << offsets.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (issubdtype(a.dtype(), complexfloating)) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Complex types are not supported.";
+    throw std::invalid_argument(msg.str());
+  }
+  return astype(offsets, int32, s);
+}
+
+array segment_reduce(
+    const array& a,
+    const array& offsets,
+    SegmentedReduce::ReduceType reduce_type,
+    const char* tag,
+    StreamOrDevice s) {
+  auto segs = check_segments(a, offsets, tag, s);
+  auto shape = a.shape();
+  shape[0] = segs.size() - 1;
+  auto in = a;
+  if (a.dtype() == bool_ && reduce_type == SegmentedReduce::Sum) {
+    in = astype(a, int32, s);
+  }
+  auto out_type = in.dtype();
+  return array(
+      std::move(shape),
+      out_type,
+      std::make_shared<SegmentedReduce>(to_stream(s), reduce_type),
+      {in, segs});
+}
+
+} // namespace
+
+array segment_sum(
+    const array& a,
+    const array& offsets,
+    StreamOrDevice s /* = {} */) {
+  return segment_reduce(a, offsets, SegmentedReduce::Sum, "segment_sum", s);
+}
+
+array segment_mean(
+    const array& a,
+    const array& offsets,
+    StreamOrDevice s /* = {} */) {
+  auto segs = check_segments(a, offsets, "segment_mean", s);
+  auto dtype = at_least_float(a.dtype());
+  auto sums = segment_sum(astype(a, dtype, s), segs, s);
+
+  // Empty segments are divided by one
+  int n = segs.size();
+  auto counts = subtract(
+      slice(segs, {1}, {n}, s), slice(segs, {0}, {n - 1}, s), s);
+  counts = maximum(counts, array(1), s);
+  auto shape = sums.shape();
+  std::fill(shape.begin() + 1, shape.end(), 1);
+  counts = reshape(astype(counts, dtype, s), std::move(shape), s);
+  return divide(sums, counts, s);
+}
+
+array segment_max(
+    const array& a,
+    const array& offsets,
+    StreamOrDevice s /* = {} */) {
+  return segment_reduce(a, offsets, SegmentedReduce::Max, "segment_max", s);
+}
+
+array segment_min(
+    const array& a,
+    const array& offsets,
+    StreamOrDevice s /* = {} */) {
+  return segment_reduce(a, offsets, SegmentedReduce::Min, "segment_min", s);
+}
+
+array segment_cumsum(
+    const array& a,
+    const array& offsets,
+    bool reverse /* = false */,
+    bool inclusive /* = true */,
+    StreamOrDevice s /* = {} */) {
+  auto segs = check_segments(a, offsets, "segment_cumsum", s);
+  auto in = a.dtype() == bool_ ? astype(a, int32, s) : a;
+  auto out_type = in.dtype();
+  return array(
+      in.shape(),
+      out_type,
+      std::make_shared<SegmentedScan>(to_stream(s), reverse, inclusive),
+      {in, segs});
+}
+
 /** Convolution operations */
 
 namespace {
@@ -3334,10 +3602,10 @@ std::tuple<array, array, array> quantize(
     throw std::invalid_argument(msg.str());
   }
 
-  if (bits != 2 && bits != 4 && bits != 8) {
+  if (bits != 2 && bits != 3 && bits != 4 && bits != 6 && bits != 8) {
     std::ostringstream msg;
     msg << "[quantize] The requested number of bits " << bits
-        << " is not supported. The supported bits are 2, 4 and 8.";
+        << " is not supported. The supported bits are 2, 3, 4, 6 and 8.";
     throw std::invalid_argument(msg.str());
   }
 
@@ -3356,60 +3624,37 @@ std::tuple<array, array, array> quantize(
     throw std::invalid_argument(msg.str());
   }
 
-  // Compute some constants used for the quantization
-  array n_bins((1 << bits) - 1, w.dtype()); // 2**bits - 1
-  array eps(1e-7, w.dtype());
-  array zero(0, w.dtype());
-  int el_per_int = 32 / bits;
-  array shifts = power(array(2, uint32), arange(0, 32, bits, uint32, s), s);
-  shifts = reshape(shifts, {1, 1, -1}, s);
-
   // Check that the w matrix will fill up a whole SIMD.
   // This is an implementation detail which should be removed in the future but
   // at least we bail out early which will result in a nice readable error.
   //
   // Hopefully nobody is quantizing matrices that small anyway.
+  bool power_of_2_bits = (bits & (bits - 1)) == 0;
+  int el_per_int = power_of_2_bits ? 32 / bits : 24 / bits;
   if (w.shape(-1) < 32 * el_per_int) {
     std::ostringstream msg;
     msg << "[quantize] The feature dimension (2nd dimension of the matrix) is "
         << "too small for quantization. We support >=512 for 2 bits, "
-        << ">= 256 for 4 bits and >= 128 for 8 bits. The provided matrix has "
-        << "shape " << w.shape() << ".";
+        << ">= 256 for 3 and 4 bits and >= 128 for 6 and 8 bits. The provided "
+        << "matrix has shape " << w.shape() << ".";
     throw std::invalid_argument(msg.str());
   }
 
-  // Prepare the shape for the outputs.
-  auto wshape = w.shape();
-  wshape.back() = -1;
-
-  // Compute scales and biases
-  array packed_w = reshape(w, {-1, w.shape(-1) / group_size, group_size}, s);
-  array w_max = max(packed_w, /* axis= */ -1, /* keepdims= */ true, s);
-  array w_min = min(packed_w, /* axis= */ -1, /* keepdims= */ true, s);
-
-  array mask = greater(abs(w_min, s), abs(w_max, s), s);
-  array scales = maximum(divide(subtract(w_max, w_min, s), n_bins, s), eps, s);
-  scales = where(mask, scales, negative(scales), s);
-  array edge = where(mask, w_min, w_max, s);
-  array q0 = round(divide(edge, scales, s), s);
-  scales = where(not_equal(q0, zero, s), divide(edge, q0, s), scales);
-  array biases = where(equal(q0, zero, s), zero, edge);
-
-  // Quantize and pack w
-  packed_w = astype(
-      clip(
-          round(divide(subtract(packed_w, biases, s), scales, s), s),
-          zero,
-          n_bins),
-      uint32);
-  packed_w = reshape(packed_w, {packed_w.shape(0), -1, el_per_int}, s);
-  packed_w = sum(
-      multiply(packed_w, shifts, s), /* axis= */ 2, /* keepdims= */ false, s);
-
-  return std::make_tuple(
-      reshape(packed_w, wshape, s),
-      reshape(scales, wshape, s),
-      reshape(biases, wshape, s));
+  // The scales, biases and packed values of every group are computed by one
+  // kernel which reads w once. 3 and 6 bit values don't fit evenly in a
+  // uint32 so they are packed in groups of 3 bytes (8 and 4 values
+  // respectively) laid out back to back.
+  auto dtype = issubdtype(w.dtype(), floating) ? w.dtype() : float32;
+  auto wq_shape = w.shape();
+  wq_shape.back() = w.shape(-1) * bits / 32;
+  auto s_shape = w.shape();
+  s_shape.back() = w.shape(-1) / group_size;
+  auto outputs = array::make_arrays(
+      {std::move(wq_shape), s_shape, s_shape},
+      {uint32, dtype, dtype},
+      std::make_shared<Quantize>(to_stream(s), group_size, bits),
+      {astype(w, dtype, s)});
+  return std::make_tuple(outputs[0], outputs[1], outputs[2]);
 }
 
 array dequantize(
@@ -3443,7 +3688,8 @@ array dequantize(
   sshape.back() = -1;
   bshape.back() = -1;
 
-  if (wshape != sshape || wshape != bshape) {
+  if (wshape != sshape || wshape != bshape ||
+      scales.shape(-1) != biases.shape(-1)) {
     throw std::invalid_argument(
         "[dequantize] Shape of scales and biases does not match the matrix");
   }
@@ -3453,10 +3699,7 @@ array dequantize(
         "[dequantize] The matrix should be given as a uint32");
   }
 
-  // Compute some constants for the dequantization
-  int el_per_int = 32 / bits;
-
-  if (w.shape(-1) * el_per_int != scales.shape(-1) * group_size) {
+  if (w.shape(-1) * 32 != scales.shape(-1) * group_size * bits) {
     std::ostringstream msg;
     msg << "[dequantize] Shape of scales and biases does not match the matrix "
         << "given the quantization parameters. Provided matrix of shape "
@@ -3465,16 +3708,54 @@ array dequantize(
     throw std::invalid_argument(msg.str());
   }
 
+  // The supported bit widths and group sizes are dequantized by one kernel
+  // and the others by the ops below
+  auto out_type = promote_types(scales.dtype(), biases.dtype());
+  bool supported_bits = bits == 2 || bits == 3 || bits == 4 || bits == 6 ||
+      bits == 8;
+  bool supported_group_size =
+      group_size == 32 || group_size == 64 || group_size == 128;
+  if (supported_bits && supported_group_size &&
+      issubdtype(out_type, floating)) {
+    auto out_shape = w.shape();
+    out_shape.back() = scales.shape(-1) * group_size;
+    return array(
+        std::move(out_shape),
+        out_type,
+        std::make_shared<Dequantize>(to_stream(s), group_size, bits),
+        {w, astype(scales, out_type, s), astype(biases, out_type, s)});
+  }
+
   // Extract the pieces from the passed quantized matrix
+  bool power_of_2_bits = (bits & (bits - 1)) == 0;
+  array packs = w;
+  int pack_bits = 32;
+  if (!power_of_2_bits) {
+    // Regroup the bytes of w in the 3 byte packs written by quantize
+    if ((w.shape(-1) * 4) % 3 != 0) {
+      throw std::invalid_argument(
+          "[dequantize] The last dimension of the matrix is not a whole number "
+          "of 3 byte packs.");
+    }
+    array shifts = arange(0, 32, 8, uint32, s);
+    array bytes = bitwise_and(
+        right_shift(expand_dims(w, -1, s), shifts, s),
+        array(0xff, uint32),
+        s);
+    auto bytes_shape = w.shape();
+    bytes_shape.back() = -1;
+    bytes_shape.push_back(3);
+    bytes = reshape(bytes, bytes_shape, s);
+    shifts = arange(0, 24, 8, uint32, s);
+    packs = sum(left_shift(bytes, shifts, s), -1, false, s);
+    pack_bits = 24;
+  }
   std::vector<array> parts;
-  for (int start = 0; start < 32; start += bits) {
-    int shift_left = 32 - (start + bits);
-    int shift_right = shift_left + start;
-
+  for (int start = 0; start + bits <= pack_bits; start += bits) {
     parts.push_back(expand_dims(
-        right_shift(
-            left_shift(w, array(32 - (start + bits), uint32), s),
-            array(32 - bits, uint32),
+        bitwise_and(
+            right_shift(packs, array(start, uint32), s),
+            array((1u << bits) - 1, uint32),
             s),
         -1,
         s));
@@ -3491,6 +3772,193 @@ array dequantize(
   return w_full;
 }
 
+namespace {
+
+// The fp8 formats given by their exponent and mantissa bits and exponent bias
+std::tuple<int, int, int> fp8_format(
+    const std::string& format,
+    std::string_view tag) {
+  if (format == "e4m3") {
+    return {4, 3, 7};
+  } else if (format == "e5m2") {
+    return {5, 2, 15};
+  }
+  std::ostringstream msg;
+  msg << "[" << tag << "] Unsupported fp8 format " << format
+      << ", the supported formats are e4m3 and e5m2.";
+  throw std::invalid_argument(msg.str());
+}
+
+} // namespace
+
+array to_fp8(
+    const array& x,
+    const std::string& format /* = "e4m3" */,
+    StreamOrDevice s /* = {} */) {
+  auto [exp_bits, mant_bits, bias] = fp8_format(format, "to_fp8");
+  if (!issubdtype(x.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[to_fp8] Only real floating point types are supported but "
+        << x.dtype() << " was provided.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto x32 = astype(x, float32, s);
+  auto sign = right_shift(view(x32, uint32, s), array(31, uint32), s);
+  auto a = abs(x32, s);
+
+  // Values past the largest finite one saturate. e4m3 has no infinities.
+  float max_val = exp_bits == 4 ? 448.0f : 57344.0f;
+  auto clipped = minimum(a, array(max_val), s);
+
+  // Normal values round the float32 mantissa to mant_bits, half to even, and
+  // rebias the exponent
+  int shift = 23 - mant_bits;
+  auto bits = view(clipped, uint32, s);
+  auto odd = bitwise_and(
+      right_shift(bits, array(shift, uint32), s), array(1, uint32), s);
+  bits = add(bits, array((1 << (shift - 1)) - 1, uint32), s);
+  bits = add(bits, odd, s);
+  auto normal = subtract(
+      right_shift(bits, array(shift, uint32), s),
+      array((127 - bias) << mant_bits, uint32),
+      s);
+
+  // Subnormal values are multiples of the smallest one. Rounding up to the
+  // smallest normal value gives its encoding as well.
+  auto subnormal = multiply(
+      clipped, array(std::ldexp(1.0f, bias - 1 + mant_bits)), s);
+  subnormal = astype(round(subnormal, s), uint32, s);
+
+  auto out = where(
+      less(clipped, array(std::ldexp(1.0f, 1 - bias)), s),
+      subnormal,
+      normal,
+      s);
+  if (exp_bits == 5) {
+    out = where(isinf(a, s), array(0x7C, uint32), out, s);
+  }
+  out = where(
+      isnan(a, s), array(exp_bits == 4 ? 0x7F : 0x7E, uint32), out, s);
+  out = bitwise_or(out, left_shift(sign, array(7, uint32), s), s);
+  return astype(out, uint8, s);
+}
+
+array from_fp8(
+    const array& x,
+    const std::string& format /* = "e4m3" */,
+    Dtype dtype /* = bfloat16 */,
+    StreamOrDevice s /* = {} */) {
+  auto [exp_bits, mant_bits, bias] = fp8_format(format, "from_fp8");
+  if (x.dtype() != uint8) {
+    std::ostringstream msg;
+    msg << "[from_fp8] Expected fp8 values stored as uint8 but got "
+        << x.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(dtype, floating)) {
+    std::ostringstream msg;
+    msg << "[from_fp8] Only real floating point types are supported but "
+        << dtype << " was provided.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto v = astype(x, uint32, s);
+
+  // e5m2 is the upper byte of a float16
+  if (exp_bits == 5) {
+    auto h = astype(left_shift(v, array(8, uint32), s), uint16, s);
+    return astype(view(h, float16, s), dtype, s);
+  }
+
+  // Normal values move their exponent and mantissa into a float32 and
+  // rebias the exponent. Subnormal values are multiples of the smallest one.
+  auto mag = bitwise_and(v, array(0x7F, uint32), s);
+  auto normal = view(
+      add(left_shift(mag, array(23 - mant_bits, uint32), s),
+          array((127 - bias) << 23, uint32),
+          s),
+      float32,
+      s);
+  auto subnormal = multiply(
+      astype(mag, float32, s),
+      array(std::ldexp(1.0f, 1 - bias - mant_bits)),
+      s);
+  auto out = where(
+      less(mag, array(1 << mant_bits, uint32), s), subnormal, normal, s);
+  out = where(
+      equal(mag, array(0x7F, uint32), s),
+      array(std::numeric_limits<float>::quiet_NaN()),
+      out,
+      s);
+  out = where(
+      greater_equal(v, array(0x80, uint32), s), negative(out, s), out, s);
+  return astype(out, dtype, s);
+}
+
+array fp8_matmul(
+    const array& x,
+    const array& w,
+    const std::string& format /* = "e4m3" */,
+    StreamOrDevice s /* = {} */) {
+  fp8_format(format, "fp8_matmul");
+  if (w.ndim() != 2 || w.dtype() != uint8) {
+    std::ostringstream msg;
+    msg << "[fp8_matmul] Expected uint8 weights of shape (N, K) but got "
+        << w.dtype() << " weights of shape " << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int N = w.shape(0);
+  int K = w.shape(1);
+  if (x.ndim() == 0 || x.shape(-1) != K) {
+    std::ostringstream msg;
+    msg << "[fp8_matmul] The last dimension of x must be " << K
+        << " to match the weights but got shape " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(x.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[fp8_matmul] Only real floating point types are supported but "
+        << x.dtype() << " was provided.";
+    throw std::invalid_argument(msg.str());
+  }
+  auto out_shape = x.shape();
+  out_shape.back() = N;
+  return array(
+      std::move(out_shape),
+      x.dtype(),
+      std::make_shared<Fp8Matmul>(to_stream(s), format),
+      {x, w});
+}
+
+array hadamard_transform(
+    const array& a,
+    std::optional<float> scale_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  if (a.ndim() == 0) {
+    throw std::invalid_argument(
+        "[hadamard_transform] Requires an array with at least one dimension.");
+  }
+  int n = a.shape(-1);
+  if (n <= 0 || (n & (n - 1)) != 0) {
+    std::ostringstream msg;
+    msg << "[hadamard_transform] The last dimension must be a power of two "
+        << "but got shape " << a.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (issubdtype(a.dtype(), complexfloating)) {
+    throw std::invalid_argument(
+        "[hadamard_transform] Complex types are not supported.");
+  }
+  auto dtype = issubdtype(a.dtype(), floating) ? a.dtype() : float32;
+  float scale = scale_.has_value() ? *scale_ : 1.0f / std::sqrt(n);
+  return array(
+      a.shape(),
+      dtype,
+      std::make_shared<Hadamard>(to_stream(s), scale),
+      {astype(a, dtype, s)});
+}
+
 array gather_qmm(
     const array& x,
     const array& w,
@@ -3501,6 +3969,7 @@ array gather_qmm(
     bool transpose /* = true */,
     int group_size /* = 64 */,
     int bits /* = 4 */,
+    bool sorted_indices /* = false */,
     StreamOrDevice s /* = {} */) {
   if (!lhs_indices_ && !rhs_indices_) {
     return quantized_matmul(
@@ -3529,7 +3998,12 @@ array gather_qmm(
   auto out = array(
       std::move(out_shape),
       out_type,
-      std::make_shared<GatherQMM>(to_stream(s), group_size, bits, transpose),
+      std::make_shared<GatherQMM>(
+          to_stream(s),
+          group_size,
+          bits,
+          transpose,
+          sorted_indices && !lhs_indices_),
       {astype(x, out_type, s),
        w,
        astype(scales, out_type, s),
@@ -3953,6 +4427,7 @@ array gather_mm(
     array b,
     std::optional<array> lhs_indices_ /* = std::nullopt */,
     std::optional<array> rhs_indices_ /* = std::nullopt */,
+    bool sorted_indices /* = false */,
     StreamOrDevice s /* = {} */) {
   // If no indices, fall back to full matmul
   if (!lhs_indices_ && !rhs_indices_) {
@@ -4035,7 +4510,8 @@ array gather_mm(
   auto out = array(
       out_shape,
       out_type,
-      std::make_shared<GatherMM>(to_stream(s)),
+      std::make_shared<GatherMM>(
+          to_stream(s), sorted_indices && !lhs_indices_),
       {a, b, lhs_indices, rhs_indices});
 
   // Remove the possibly inserted singleton dimensions
@@ -4049,6 +4525,79 @@ array gather_mm(
   return out;
 }
 
+std::pair<array, array> prune_2_4(
+    const array& w,
+    StreamOrDevice s /* = {} */) {
+  if (w.ndim() != 2 || w.shape(1) % 32 != 0) {
+    std::ostringstream msg;
+    msg << "[prune_2_4] Expected a matrix with a multiple of 32 columns but "
+        << "got shape " << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(w.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[prune_2_4] Only floating point types are supported but got "
+        << w.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int N = w.shape(0);
+  int K = w.shape(1);
+
+  // The positions of the two largest magnitudes of each group in order
+  auto groups = reshape(w, {N, K / 4, 4}, s);
+  auto order = argsort(negative(abs(groups, s), s), -1, s);
+  auto top = slice(order, {0, 0, 0}, {N, K / 4, 2}, s);
+  top = astype(sort(top, -1, s), uint32, s);
+  auto values = reshape(take_along_axis(groups, top, -1, s), {N, K / 2}, s);
+
+  // Four bits per group, the first position in the low two bits
+  auto i0 = slice(top, {0, 0, 0}, {N, K / 4, 1}, s);
+  auto i1 = slice(top, {0, 0, 1}, {N, K / 4, 2}, s);
+  auto nibbles = bitwise_or(i0, left_shift(i1, array(2, uint32), s), s);
+  nibbles = reshape(nibbles, {N, K / 32, 8}, s);
+  auto shifts = multiply(arange(8, uint32, s), array(4, uint32), s);
+  auto metadata = sum(left_shift(nibbles, shifts, s), -1, false, s);
+  return {values, astype(metadata, uint32, s)};
+}
+
+array sparse_2_4_matmul(
+    const array& x,
+    const array& values,
+    const array& metadata,
+    StreamOrDevice s /* = {} */) {
+  if (values.ndim() != 2 || metadata.ndim() != 2 ||
+      metadata.dtype() != uint32 || values.shape(0) != metadata.shape(0) ||
+      values.shape(1) != metadata.shape(1) * 16) {
+    std::ostringstream msg;
+    msg << "[sparse_2_4_matmul] Expected values of shape (N, K / 2) and "
+        << "uint32 metadata of shape (N, K / 32) but got " << values.shape()
+        << " and " << metadata.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int N = values.shape(0);
+  int K = values.shape(1) * 2;
+  if (x.ndim() == 0 || x.shape(-1) != K) {
+    std::ostringstream msg;
+    msg << "[sparse_2_4_matmul] The last dimension of x must be " << K
+        << " to match the weights but got shape " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto dtype = promote_types(x.dtype(), values.dtype());
+  if (!issubdtype(dtype, floating)) {
+    std::ostringstream msg;
+    msg << "[sparse_2_4_matmul] Only floating point types are supported but "
+        << "got " << dtype << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto out_shape = x.shape();
+  out_shape.back() = N;
+  return array(
+      std::move(out_shape),
+      dtype,
+      std::make_shared<Sparse24Matmul>(to_stream(s)),
+      {astype(x, dtype, s), astype(values, dtype, s), metadata});
+}
+
 array diagonal(
     const array& a,
     int offset /* = 0 */,
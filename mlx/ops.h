@@ -186,6 +186,27 @@ array slice_update(
     std::vector<int> stop,
     StreamOrDevice s = {});
 
+/**
+ * Append an update, e.g. the keys or values of a new step, to a cache at
+ * position offset along the axis. The cache has room for cache.shape(axis)
+ * entries and grows to the next multiple of step when the update does not
+ * fit, so it is reallocated every step / update.shape(axis) appends only.
+ *
+ * Returns the cache, written in place when it is not used elsewhere, and a
+ * view of its first offset + update.shape(axis) entries along the axis
+ * which shares its buffer.
+ *
+ * Appending at an offset before the end of the filled part rolls the cache
+ * back without a copy, e.g. to drop rejected draft tokens.
+ **/
+std::vector<array> cache_append(
+    const array& cache,
+    const array& update,
+    int offset,
+    int axis,
+    int step = 256,
+    StreamOrDevice s = {});
+
 /** Split an array into sub-arrays along a given axis. */
 std::vector<array>
 split(const array& a, int num_splits, int axis, StreamOrDevice s = {});
@@ -1160,6 +1181,39 @@ array cummin(
     bool inclusive = true,
     StreamOrDevice s = {});
 
+/**
+ * Sum the rows of a in each segment. Segment b is rows [offsets[b],
+ * offsets[b + 1]) of the first axis and the offsets must be non
+ * decreasing. Empty segments sum to zero.
+ */
+array segment_sum(const array& a, const array& offsets, StreamOrDevice s = {});
+
+/** Mean of the rows of a in each segment. Empty segments give zero. */
+array segment_mean(
+    const array& a,
+    const array& offsets,
+    StreamOrDevice s = {});
+
+/**
+ * Maximum of the rows of a in each segment. Empty segments give the lowest
+ * value of the type.
+ */
+array segment_max(const array& a, const array& offsets, StreamOrDevice s = {});
+
+/**
+ * Minimum of the rows of a in each segment. Empty segments give the highest
+ * value of the type.
+ */
+array segment_min(const array& a, const array& offsets, StreamOrDevice s = {});
+
+/** Cumulative sum of the rows of a which restarts at every segment. */
+array segment_cumsum(
+    const array& a,
+    const array& offsets,
+    bool reverse = false,
+    bool inclusive = true,
+    StreamOrDevice s = {});
+
 /** General convolution with a filter */
 array conv_general(
     array input,
@@ -1254,7 +1308,54 @@ array dequantize(
     int bits = 4,
     StreamOrDevice s = {});
 
-/** Compute matrix products with matrix-level gather. */
+/**
+ * Convert to 8-bit floats stored as uint8. The format is e4m3 or e5m2.
+ * Finite values past the largest fp8 value saturate to it.
+ */
+array to_fp8(
+    const array& x,
+    const std::string& format = "e4m3",
+    StreamOrDevice s = {});
+
+/**
+ * Convert 8-bit floats stored as uint8 to dtype. To multiply by fp8 weights
+ * use fp8_matmul which does not materialize them.
+ */
+array from_fp8(
+    const array& x,
+    const std::string& format = "e4m3",
+    Dtype dtype = bfloat16,
+    StreamOrDevice s = {});
+
+/**
+ * Compute x @ w.T for an (N, K) matrix w of 8-bit floats stored as uint8.
+ * The weights are read in 8 bits and converted on the fly so they take half
+ * the bandwidth of float16 weights. The result has the type of x.
+ */
+array fp8_matmul(
+    const array& x,
+    const array& w,
+    const std::string& format = "e4m3",
+    StreamOrDevice s = {});
+
+/**
+ * Walsh-Hadamard transform along the last axis, whose size must be a power
+ * of two. The result is multiplied by scale, 1 / sqrt(n) by default which
+ * makes the transform orthonormal.
+ */
+array hadamard_transform(
+    const array& a,
+    std::optional<float> scale = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Compute matrix products with matrix-level gather.
+ *
+ * When sorted_indices is true the rhs_indices must be sorted, e.g. tokens
+ * grouped by the expert they are routed to. If lhs_indices are not given
+ * either, rows of x which use the same matrix of w are multiplied together
+ * instead of reloading it for each of them.
+ */
 array gather_qmm(
     const array& x,
     const array& w,
@@ -1265,6 +1366,7 @@ array gather_qmm(
     bool transpose = true,
     int group_size = 64,
     int bits = 4,
+    bool sorted_indices = false,
     StreamOrDevice s = {});
 
 /** Returns a contraction of a and b over multiple dimensions. */
@@ -1306,12 +1408,34 @@ array block_masked_mm(
     std::optional<array> mask_rhs = std::nullopt,
     StreamOrDevice s = {});
 
-/** Compute matrix product with matrix-level gather */
+/**
+ * Compute matrix product with matrix-level gather. See gather_qmm for
+ * sorted_indices.
+ */
 array gather_mm(
     array a,
     array b,
     std::optional<array> lhs_indices = std::nullopt,
     std::optional<array> rhs_indices = std::nullopt,
+    bool sorted_indices = false,
+    StreamOrDevice s = {});
+
+/**
+ * Prune the rows of w to the two largest magnitudes in every four
+ * consecutive elements. Returns the kept values of shape (N, K / 2) and the
+ * uint32 metadata of shape (N, K / 32) with their positions, four bits per
+ * group. K must be a multiple of 32.
+ */
+std::pair<array, array> prune_2_4(const array& w, StreamOrDevice s = {});
+
+/**
+ * Compute x @ w.T for w in the 2:4 sparse format of prune_2_4. Only the
+ * kept values are read so the weights take half the bandwidth.
+ */
+array sparse_2_4_matmul(
+    const array& x,
+    const array& values,
+    const array& metadata,
     StreamOrDevice s = {});
 
 /** Extract a diagonal or construct a diagonal array */
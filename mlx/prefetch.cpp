@@ -0,0 +1,83 @@
+// Copyright © 2024 Apple Inc.
+
+#include <stdexcept>
+#include <utility>
+
+#include "mlx/prefetch.h"
+#include "mlx/transforms.h"
+
+namespace mlx::core {
+
+Prefetcher::Prefetcher(Producer producer, int size /* = 2 */)
+    : producer_(std::move(producer)) {
+  if (size < 1) {
+    throw std::invalid_argument(
+        "[Prefetcher] At least one batch must be prefetched.");
+  }
+  size_ = size;
+  worker_ = std::thread(&Prefetcher::produce, this);
+}
+
+Prefetcher::~Prefetcher() {
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+}
+
+void Prefetcher::produce() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lk(mtx_);
+      cv_.wait(lk, [this] { return stop_ || ready_.size() < size_; });
+      if (stop_) {
+        return;
+      }
+    }
+
+    std::optional<Batch> batch;
+    std::exception_ptr error;
+    try {
+      batch = producer_();
+      if (batch) {
+        eval(*batch);
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      if (batch && !error) {
+        ready_.push_back(std::move(*batch));
+      } else {
+        error_ = error;
+        done_ = true;
+      }
+    }
+    cv_.notify_all();
+    if (!batch || error) {
+      return;
+    }
+  }
+}
+
+std::optional<Prefetcher::Batch> Prefetcher::next() {
+  std::unique_lock<std::mutex> lk(mtx_);
+  cv_.wait(lk, [this] { return !ready_.empty() || done_; });
+  if (!ready_.empty()) {
+    auto batch = std::move(ready_.front());
+    ready_.pop_front();
+    lk.unlock();
+    cv_.notify_all();
+    return batch;
+  }
+  if (auto error = std::exchange(error_, nullptr)) {
+    std::rethrow_exception(error);
+  }
+  return std::nullopt;
+}
+
+} // namespace mlx::core
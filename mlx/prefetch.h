@@ -0,0 +1,59 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+/* Prepares batches of arrays ahead of their use on a worker thread.
+ *
+ * The producer is called on the worker thread and returns the next batch or
+ * std::nullopt once there are none left. Each batch is evaluated on the
+ * worker thread before it is handed out, and up to size batches are kept
+ * ready. Ops the producer uses should run on a stream of their own, for
+ * instance new_stream(default_device()), so they overlap the consumer's
+ * computation.
+ * */
+class Prefetcher {
+ public:
+  using Batch = std::vector<array>;
+  using Producer = std::function<std::optional<Batch>()>;
+
+  explicit Prefetcher(Producer producer, int size = 2);
+  ~Prefetcher();
+
+  // Not copyable or moveable
+  Prefetcher(const Prefetcher&) = delete;
+  Prefetcher(Prefetcher&&) = delete;
+  Prefetcher& operator=(const Prefetcher&) = delete;
+  Prefetcher& operator=(Prefetcher&&) = delete;
+
+  /* Wait for the next batch. Returns std::nullopt once the producer is
+   * exhausted and rethrows the exception if the producer failed. */
+  std::optional<Batch> next();
+
+ private:
+  void produce();
+
+  Producer producer_;
+  size_t size_;
+  std::deque<Batch> ready_;
+  bool done_{false};
+  bool stop_{false};
+  std::exception_ptr error_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::thread worker_;
+};
+
+} // namespace mlx::core
@@ -0,0 +1,270 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <sstream>
+
+#include "mlx/backend/metal/metal.h"
+#include "mlx/fast.h"
+#include "mlx/ops.h"
+
+namespace mlx::core::fast {
+
+namespace {
+
+constexpr uint64_t hash_seed = 0xcbf29ce484222325ull;
+
+// FNV-1a over the tokens, chained from the hash of the blocks before
+uint64_t hash_block(uint64_t h, const int* tokens, int n) {
+  for (int i = 0; i < n; i++) {
+    h ^= static_cast<uint32_t>(tokens[i]);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+array empty_pages(
+    int max_blocks,
+    int n_kv_heads,
+    int block_size,
+    int head_dim,
+    Dtype dtype,
+    const Stream& s) {
+  if (max_blocks <= 0 || n_kv_heads <= 0 || block_size <= 0 ||
+      head_dim <= 0) {
+    throw std::invalid_argument(
+        "[PrefixCache] The number of blocks, heads, block size and head "
+        "dimension must be positive.");
+  }
+  int n = std::min(max_blocks, 16);
+  return zeros({n, n_kv_heads, block_size, head_dim}, dtype, s);
+}
+
+} // namespace
+
+PrefixCache::PrefixCache(
+    int max_blocks,
+    int n_kv_heads,
+    int block_size,
+    int head_dim,
+    Dtype dtype /* = float16 */,
+    StreamOrDevice s /* = {} */)
+    : max_blocks_(max_blocks),
+      block_size_(block_size),
+      dtype_(dtype),
+      stream_(to_stream(s)),
+      keys_(empty_pages(
+          max_blocks,
+          n_kv_heads,
+          block_size,
+          head_dim,
+          dtype,
+          stream_)),
+      values_(zeros(keys_.shape(), dtype, stream_)) {
+  int n = keys_.shape(0);
+  blocks_.resize(n);
+  for (int b = n - 1; b >= 0; b--) {
+    free_.push_back(b);
+  }
+}
+
+PrefixCache::Sequence& PrefixCache::sequence_(int seq) {
+  auto it = sequences_.find(seq);
+  if (it == sequences_.end()) {
+    std::ostringstream msg;
+    msg << "[PrefixCache] No sequence with id " << seq << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  return it->second;
+}
+
+const std::vector<int>& PrefixCache::block_table(int seq) const {
+  return const_cast<PrefixCache&>(*this).sequence_(seq).blocks;
+}
+
+int PrefixCache::allocate_() {
+  int size = blocks_.size();
+  if (free_.empty() && size < max_blocks_) {
+    int n = std::min(size, max_blocks_ - size);
+    // The pages are copied so the new pool is allocated while the old one
+    // is alive. Without unused indexed blocks to evict it grows regardless.
+    size_t page_bytes = 2 * keys_.nbytes() / size;
+    size_t limit = metal::get_memory_limit();
+    if (limit == 0 || lru_.empty() ||
+        metal::get_active_memory() + page_bytes * (size + n) <= limit) {
+      auto grow = [&](const array& pages) {
+        auto shape = pages.shape();
+        shape[0] = n;
+        return concatenate(
+            {pages, zeros(shape, dtype_, stream_)}, 0, stream_);
+      };
+      keys_ = grow(keys_);
+      values_ = grow(values_);
+      blocks_.resize(size + n);
+      for (int b = size + n - 1; b >= size; b--) {
+        free_.push_back(b);
+      }
+    }
+  }
+  if (!free_.empty()) {
+    int b = free_.back();
+    free_.pop_back();
+    return b;
+  }
+  if (!lru_.empty()) {
+    int b = lru_.front();
+    lru_.pop_front();
+    auto& block = blocks_[b];
+    index_map_.erase(block.hash);
+    block.indexed = false;
+    block.tokens.clear();
+    return b;
+  }
+  throw std::runtime_error(
+      "[PrefixCache] All the pages are used by the sequences.");
+}
+
+void PrefixCache::reserve_(Sequence& s) {
+  while (s.blocks.size() * block_size_ < s.tokens.size()) {
+    int b = allocate_();
+    blocks_[b].refs = 1;
+    s.blocks.push_back(b);
+  }
+}
+
+void PrefixCache::index_(Sequence& s) {
+  int full = s.written / block_size_;
+  while (s.hashes.size() < full) {
+    int i = s.hashes.size();
+    uint64_t parent = (i == 0) ? hash_seed : s.hashes.back();
+    auto tokens = s.tokens.data() + i * block_size_;
+    uint64_t h = hash_block(parent, tokens, block_size_);
+    s.hashes.push_back(h);
+    if (index_map_.find(h) != index_map_.end()) {
+      // Another sequence indexed the same prefix first
+      continue;
+    }
+    auto& block = blocks_[s.blocks[i]];
+    block.indexed = true;
+    block.hash = h;
+    block.parent = parent;
+    block.tokens.assign(tokens, tokens + block_size_);
+    index_map_.insert({h, s.blocks[i]});
+  }
+}
+
+std::pair<int, int> PrefixCache::acquire(const std::vector<int>& tokens) {
+  int seq = next_seq_++;
+  auto& s = sequences_[seq];
+  s.tokens = tokens;
+
+  // Leave at least the last token to compute
+  int shareable = tokens.empty() ? 0 : (tokens.size() - 1) / block_size_;
+  uint64_t parent = hash_seed;
+  for (int i = 0; i < shareable; i++) {
+    auto start = tokens.data() + i * block_size_;
+    uint64_t h = hash_block(parent, start, block_size_);
+    auto it = index_map_.find(h);
+    if (it == index_map_.end()) {
+      break;
+    }
+    auto& block = blocks_[it->second];
+    if (block.parent != parent ||
+        !std::equal(start, start + block_size_, block.tokens.begin())) {
+      break;
+    }
+    if (block.refs++ == 0) {
+      lru_.erase(block.lru);
+    }
+    s.blocks.push_back(it->second);
+    s.hashes.push_back(h);
+    parent = h;
+  }
+  s.written = s.blocks.size() * block_size_;
+
+  try {
+    reserve_(s);
+  } catch (...) {
+    release(seq);
+    throw;
+  }
+  return {seq, s.written};
+}
+
+void PrefixCache::extend(int seq, const std::vector<int>& tokens) {
+  auto& s = sequence_(seq);
+  auto size = s.tokens.size();
+  s.tokens.insert(s.tokens.end(), tokens.begin(), tokens.end());
+  try {
+    reserve_(s);
+  } catch (...) {
+    s.tokens.resize(size);
+    throw;
+  }
+}
+
+void PrefixCache::write(
+    int seq,
+    int start,
+    const array& keys,
+    const array& values) {
+  auto& s = sequence_(seq);
+  auto& shape = keys_.shape();
+  if (keys.ndim() != 3 || keys.shape(0) != shape[1] ||
+      keys.shape(2) != shape[3] || values.shape() != keys.shape()) {
+    std::ostringstream msg;
+    msg << "[PrefixCache] Expected keys and values of shape (" << shape[1]
+        << ", n, " << shape[3] << ") but got " << keys.shape() << " and "
+        << values.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int n = keys.shape(1);
+  int indexed = s.hashes.size() * block_size_;
+  if (start < indexed || start > s.written ||
+      start + n > static_cast<int>(s.tokens.size())) {
+    std::ostringstream msg;
+    msg << "[PrefixCache] Cannot write tokens [" << start << ", "
+        << start + n << ") of a sequence of " << s.tokens.size()
+        << " tokens with " << s.written << " written, " << indexed
+        << " of which are indexed.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  std::vector<int32_t> pages(n);
+  std::vector<int32_t> offsets(n);
+  for (int i = 0; i < n; i++) {
+    pages[i] = s.blocks[(start + i) / block_size_];
+    offsets[i] = (start + i) % block_size_;
+  }
+  std::vector<array> indices = {
+      array(pages.begin(), {n}, int32), array(offsets.begin(), {n}, int32)};
+  auto scatter_pages = [&](const array& pool, const array& x) {
+    auto updates = transpose(astype(x, dtype_, stream_), {1, 0, 2}, stream_);
+    updates = reshape(updates, {n, 1, shape[1], 1, shape[3]}, stream_);
+    return scatter(pool, indices, updates, {0, 2}, stream_);
+  };
+  keys_ = scatter_pages(keys_, keys);
+  values_ = scatter_pages(values_, values);
+
+  s.written = std::max(s.written, start + n);
+  index_(s);
+}
+
+void PrefixCache::release(int seq) {
+  auto& s = sequence_(seq);
+  // The last blocks become the least recently used since they are only
+  // reachable through the ones before
+  for (auto b = s.blocks.rbegin(); b != s.blocks.rend(); ++b) {
+    auto& block = blocks_[*b];
+    if (--block.refs > 0) {
+      continue;
+    }
+    if (block.indexed) {
+      block.lru = lru_.insert(lru_.end(), *b);
+    } else {
+      free_.push_back(*b);
+    }
+  }
+  sequences_.erase(seq);
+}
+
+} // namespace mlx::core::fast
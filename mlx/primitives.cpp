@@ -7,6 +7,7 @@
 #include <stdexcept>
 
 #include "mlx/backend/common/utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/fft.h"
 #include "mlx/linalg.h"
 #include "mlx/ops.h"
@@ -683,6 +684,11 @@ bool Broadcast::is_equivalent(const Primitive& other) const {
   return shape_ == b_other.shape_;
 }
 
+bool CacheAppend::is_equivalent(const Primitive& other) const {
+  const CacheAppend& c_other = static_cast<const CacheAppend&>(other);
+  return offset_ == c_other.offset_ && axis_ == c_other.axis_;
+}
+
 std::vector<array> Ceil::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
@@ -808,7 +814,7 @@ std::pair<std::vector<array>, std::vector<int>> Conjugate::vmap(
 
 array conv_weight_backward_patches(
     const array& in,
-    const array& wt,
+    const std::vector<int>& wt_shape,
     const array& cotan,
     const std::vector<int>& kernel_strides,
     const std::vector<int>& padding,
@@ -844,7 +850,7 @@ array conv_weight_backward_patches(
   std::vector<int> patches_shape{
       cotan.shape().begin(), cotan.shape().end() - 1};
   patches_shape.insert(
-      patches_shape.end(), wt.shape().begin() + 1, wt.shape().end());
+      patches_shape.end(), wt_shape.begin() + 1, wt_shape.end());
 
   // Resolve patch strides
   int n_spatial_dim = in.ndim() - 2;
@@ -861,12 +867,12 @@ array conv_weight_backward_patches(
   auto in_patches = as_strided(in_padded, patches_shape, patches_strides, 0, s);
 
   // Prepare for matmul
-  int O = wt.shape(0);
+  int O = wt_shape[0];
   auto cotan_mat = reshape(cotan, {-1, O}, s);
   in_patches = reshape(in_patches, {cotan_mat.shape(0), -1}, s);
 
   auto grad = matmul(transpose(cotan_mat, {1, 0}, s), in_patches, s);
-  grad = reshape(grad, wt.shape(), s);
+  grad = reshape(grad, wt_shape, s);
   return grad;
 }
 
@@ -964,41 +970,71 @@ std::vector<array> Convolution::vjp(
     // Grads for weight
     else if (a == 1) {
       bool no_dilation = true;
+      bool no_input_dilation = true;
 
       for (int i = 0; i < input_dilation_.size(); i++) {
         no_dilation &= (input_dilation_[i] == 1) && (kernel_dilation_[i] == 1);
+        no_input_dilation &= input_dilation_[i] == 1;
       }
 
-      if (no_dilation) {
-        auto grad = conv_weight_backward_patches(
-            in, wt, cotan, kernel_strides_, padding_, stream());
-        grads.push_back(grad);
-      } else {
-        std::vector<int> padding_lo = padding_;
-        std::vector<int> padding_hi = padding_;
+      // Captured by value since the gradient may outlive this primitive
+      auto weight_grad = [wt_shape = wt.shape(),
+                          no_dilation,
+                          padding = padding_,
+                          kernel_strides = kernel_strides_,
+                          kernel_dilation = kernel_dilation_,
+                          input_dilation = input_dilation_,
+                          flip = flip_,
+                          s = stream()](const std::vector<array>& inputs) {
+        auto& in = inputs[0];
+        auto& cotan = inputs[1];
+        if (no_dilation) {
+          return std::vector<array>{conv_weight_backward_patches(
+              in, wt_shape, cotan, kernel_strides, padding, s)};
+        }
+
+        std::vector<int> padding_lo = padding;
+        std::vector<int> padding_hi = padding;
 
         for (int i = 0; i < padding_hi.size(); ++i) {
-          int in_size = 1 + input_dilation_[i] * (in.shape(1 + i) - 1);
-          int out_size = 1 + kernel_strides_[i] * (cotan.shape(1 + i) - 1);
-          int wt_size = 1 + kernel_dilation_[i] * (wt.shape(1 + i) - 1);
-          padding_hi[i] = out_size - in_size + wt_size - padding_[i] - 1;
+          int in_size = 1 + input_dilation[i] * (in.shape(1 + i) - 1);
+          int out_size = 1 + kernel_strides[i] * (cotan.shape(1 + i) - 1);
+          int wt_size = 1 + kernel_dilation[i] * (wt_shape[1 + i] - 1);
+          padding_hi[i] = out_size - in_size + wt_size - padding[i] - 1;
         }
 
-        auto in_trans = swapaxes(in, 0, -1, stream());
-        auto cotan_trans = swapaxes(cotan, 0, -1, stream());
+        auto in_trans = swapaxes(in, 0, -1, s);
+        auto cotan_trans = swapaxes(cotan, 0, -1, s);
         auto grad_trans = conv_general(
             /* const array& input = */ in_trans,
             /* const array& weight = */ cotan_trans,
-            /* std::vector<int> stride = */ kernel_dilation_,
+            /* std::vector<int> stride = */ kernel_dilation,
             /* std::vector<int> padding_lo = */ padding_lo,
             /* std::vector<int> padding_hi = */ padding_hi,
-            /* std::vector<int> kernel_dilation = */ kernel_strides_,
-            /* std::vector<int> input_dilation = */ input_dilation_,
+            /* std::vector<int> kernel_dilation = */ kernel_strides,
+            /* std::vector<int> input_dilation = */ input_dilation,
             /* int groups = */ 1,
-            /* bool flip = */ flip_,
-            stream());
-        auto grad = swapaxes(grad_trans, 0, -1, stream());
-        grads.push_back(grad);
+            /* bool flip = */ flip,
+            s);
+        return std::vector<array>{swapaxes(grad_trans, 0, -1, s)};
+      };
+
+      // On the GPU the gradient is an implicit gemm of the cotangent with
+      // the unfolded input, which is never materialized
+      if (stream().device == Device::gpu && no_input_dilation && !flip_ &&
+          cotan.dtype() == in.dtype()) {
+        grads.push_back(array(
+            wt.shape(),
+            wt.dtype(),
+            std::make_shared<fast::ConvolutionWeightGrad>(
+                stream(),
+                weight_grad,
+                kernel_strides_,
+                padding_,
+                kernel_dilation_),
+            {in, cotan}));
+      } else {
+        grads.push_back(weight_grad({in, cotan})[0]);
       }
     }
   }
@@ -1006,6 +1042,65 @@ std::vector<array> Convolution::vjp(
   return grads;
 }
 
+std::pair<std::vector<array>, std::vector<int>> Convolution::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  auto conv = [&](const array& in, const array& wt, int groups) {
+    return conv_general(
+        in,
+        wt,
+        kernel_strides_,
+        padding_,
+        padding_,
+        kernel_dilation_,
+        input_dilation_,
+        groups,
+        flip_,
+        stream());
+  };
+  bool in_vmapped = axes[0] >= 0;
+  bool wt_vmapped = axes[1] >= 0;
+  auto in = inputs[0];
+  auto wt = inputs[1];
+
+  // Fold the vmapped axis of the input into its batch
+  if (!wt_vmapped) {
+    in = moveaxis(in, axes[0], 0, stream());
+    auto n_vmap = in.shape(0);
+    auto out = conv(flatten(in, 0, 1, stream()), wt, groups_);
+    auto shape = out.shape();
+    shape[0] = in.shape(1);
+    shape.insert(shape.begin(), n_vmap);
+    return {{reshape(out, std::move(shape), stream())}, {0}};
+  }
+
+  // Fold the vmapped axis of the weights into the output channels and, if
+  // the input is vmapped too or the convolution is grouped, the input
+  // channels so that each vmapped slice is a group
+  wt = moveaxis(wt, axes[1], 0, stream());
+  auto n_vmap = wt.shape(0);
+  auto out_channels = wt.shape(1);
+  wt = flatten(wt, 0, 1, stream());
+  int groups = groups_;
+  if (in_vmapped || groups_ > 1) {
+    if (in_vmapped) {
+      in = moveaxis(in, axes[0], -2, stream());
+    } else {
+      auto shape = in.shape();
+      shape.insert(shape.end() - 1, n_vmap);
+      in = broadcast_to(expand_dims(in, -2, stream()), shape, stream());
+    }
+    in = flatten(in, -2, -1, stream());
+    groups *= n_vmap;
+  }
+  auto out = conv(in, wt, groups);
+  auto shape = out.shape();
+  shape.back() = out_channels;
+  shape.insert(shape.end() - 1, n_vmap);
+  int out_ax = out.ndim() - 1;
+  return {{reshape(out, std::move(shape), stream())}, {out_ax}};
+}
+
 bool Convolution::is_equivalent(const Primitive& other) const {
   const Convolution& c_other = static_cast<const Convolution&>(other);
   return padding_ == c_other.padding_ &&
@@ -1678,6 +1773,41 @@ std::vector<array> GreaterEqual::jvp(
   return {zeros(shape, bool_, stream())};
 }
 
+std::pair<std::vector<array>, std::vector<int>> Hadamard::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // The transform is along the last axis so the vmapped one cannot be it
+  auto a = inputs[0];
+  int ax = axes[0];
+  if (ax == a.ndim() - 1) {
+    a = moveaxis(a, ax, 0, stream());
+    ax = 0;
+  }
+  return {{hadamard_transform(a, scale_, stream())}, {ax}};
+}
+
+std::vector<array> Hadamard::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  return jvp(primals, cotangents, argnums);
+}
+
+std::vector<array> Hadamard::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  // The Hadamard matrix is symmetric
+  assert(argnums.size() == 1);
+  return {hadamard_transform(tangents[0], scale_, stream())};
+}
+
+bool Hadamard::is_equivalent(const Primitive& other) const {
+  const Hadamard& h_other = static_cast<const Hadamard&>(other);
+  return scale_ == h_other.scale_;
+}
+
 std::pair<std::vector<array>, std::vector<int>> Less::vmap(
     const std::vector<array>& inputs,
     const std::vector<int>& axes) {
@@ -1932,6 +2062,55 @@ std::pair<std::vector<array>, std::vector<int>> LogAddExp::vmap(
   return {{logaddexp(a, b, stream())}, {to_ax}};
 }
 
+std::pair<std::vector<array>, std::vector<int>> LogSumExp::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  auto ax = axes[0];
+  auto in = inputs[0];
+  // Keep the vectorized axis out of the reduced last axis
+  if (ax == in.ndim() - 1) {
+    in = swapaxes(in, -1, -2, stream());
+    ax = in.ndim() - 2;
+  }
+  return {{logsumexp(in, -1, true, stream())}, {ax}};
+}
+
+std::vector<array> LogSumExp::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  assert(primals.size() == 1);
+  assert(cotangents.size() == 1);
+  return {multiply(
+      cotangents[0],
+      softmax(primals[0], std::vector<int>{-1}, true, stream()),
+      stream())};
+}
+
+std::vector<array> LogSumExp::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  assert(primals.size() == 1);
+  assert(tangents.size() == 1);
+  return {sum(
+      multiply(
+          tangents[0],
+          softmax(primals[0], std::vector<int>{-1}, true, stream()),
+          stream()),
+      std::vector<int>{-1},
+      true,
+      stream())};
+}
+
+std::vector<std::vector<int>> LogSumExp::output_shapes(
+    const std::vector<array>& inputs) {
+  auto out_shape = inputs[0].shape();
+  out_shape.back() = 1;
+  return {out_shape};
+}
+
 std::vector<array> Matmul::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
@@ -1942,6 +2121,20 @@ std::vector<array> Matmul::vjp(
   std::vector<int> reorder(cotan.ndim());
   std::iota(reorder.begin(), reorder.end(), 0);
   std::iter_swap(reorder.end() - 1, reorder.end() - 2);
+  if (argnums.size() == 2 && cotan.dtype() == primals[0].dtype()) {
+    // Compute both with one primitive so they are dispatched together
+    vjps = array::make_arrays(
+        {primals[0].shape(), primals[1].shape()},
+        {cotan.dtype(), cotan.dtype()},
+        std::make_shared<MatmulVJP>(stream()),
+        {cotan,
+         transpose(primals[1], reorder, stream()),
+         transpose(primals[0], reorder, stream())});
+    if (argnums[0] == 1) {
+      std::swap(vjps[0], vjps[1]);
+    }
+    return vjps;
+  }
   for (auto arg : argnums) {
     if (arg == 0) {
       // M X N * (K X N).T -> M X K
@@ -1967,6 +2160,76 @@ std::pair<std::vector<array>, std::vector<int>> Matmul::vmap(
   return {{matmul(a, b, stream())}, {0}};
 }
 
+std::vector<array> MatmulVJP::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  auto& cotan = primals[0];
+  std::vector<int> reorder(cotan.ndim());
+  std::iota(reorder.begin(), reorder.end(), 0);
+  std::iter_swap(reorder.end() - 1, reorder.end() - 2);
+  auto t = [&](const array& x) { return transpose(x, reorder, stream()); };
+  std::vector<array> vjps;
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      vjps.push_back(add(
+          matmul(cotangents[0], t(primals[1]), stream()),
+          matmul(t(primals[2]), cotangents[1], stream()),
+          stream()));
+    } else if (arg == 1) {
+      vjps.push_back(matmul(t(cotan), cotangents[0], stream()));
+    } else {
+      vjps.push_back(matmul(cotangents[1], t(cotan), stream()));
+    }
+  }
+  return vjps;
+}
+
+std::vector<array> MatmulVJP::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  auto& cotan = primals[0];
+  auto shapes = output_shapes(primals);
+  auto grad_a = zeros(shapes[0], cotan.dtype(), stream());
+  auto grad_b = zeros(shapes[1], cotan.dtype(), stream());
+  for (int i = 0; i < argnums.size(); i++) {
+    auto& tan = tangents[i];
+    if (argnums[i] == 0) {
+      grad_a = add(grad_a, matmul(tan, primals[1], stream()), stream());
+      grad_b = add(grad_b, matmul(primals[2], tan, stream()), stream());
+    } else if (argnums[i] == 1) {
+      grad_a = add(grad_a, matmul(cotan, tan, stream()), stream());
+    } else {
+      grad_b = add(grad_b, matmul(tan, cotan, stream()), stream());
+    }
+  }
+  return {grad_a, grad_b};
+}
+
+std::pair<std::vector<array>, std::vector<int>> MatmulVJP::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  auto maybe_move_ax = [this](auto& arr, auto ax) {
+    return ax > 0 ? moveaxis(arr, ax, 0, stream()) : arr;
+  };
+  auto cotan = maybe_move_ax(inputs[0], axes[0]);
+  auto b_t = maybe_move_ax(inputs[1], axes[1]);
+  auto a_t = maybe_move_ax(inputs[2], axes[2]);
+  return {
+      {matmul(cotan, b_t, stream()), matmul(a_t, cotan, stream())}, {0, 0}};
+}
+
+std::vector<std::vector<int>> MatmulVJP::output_shapes(
+    const std::vector<array>& inputs) {
+  auto a_shape = inputs[0].shape();
+  auto b_shape = inputs[0].shape();
+  a_shape.back() = inputs[1].shape(-1);
+  *(b_shape.end() - 2) = inputs[2].shape(-2);
+  return {a_shape, b_shape};
+}
+
 std::vector<array> Maximum::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
@@ -2337,7 +2600,65 @@ std::pair<std::vector<array>, std::vector<int>> Power::vmap(
 std::pair<std::vector<array>, std::vector<int>> QuantizedMatmul::vmap(
     const std::vector<array>& inputs,
     const std::vector<int>& axes) {
-  throw std::runtime_error("QuantizedMatmul::vmap NYI");
+  auto x = inputs[0];
+  auto& w = inputs[1];
+  auto& scales = inputs[2];
+  auto& biases = inputs[3];
+
+  // Only the input is vmapped so the vmapped axis is one of its batch axes
+  if (axes[1] < 0 && axes[2] < 0 && axes[3] < 0) {
+    int ax = axes[0];
+    if (ax == x.ndim() - 1) {
+      x = moveaxis(x, ax, 0, stream());
+      ax = 0;
+    }
+    return {
+        {quantized_matmul(
+            x, w, scales, biases, transpose_, group_size_, bits_, stream())},
+        {ax}};
+  }
+
+  // Stack the quantized matrices and select one per vmapped slice with a
+  // gathered quantized matmul
+  int n_vmap = 0;
+  for (int i = 1; i < 4; ++i) {
+    if (axes[i] >= 0) {
+      n_vmap = inputs[i].shape(axes[i]);
+    }
+  }
+  auto to_front = [&](const array& a, int ax) {
+    if (ax >= 0) {
+      return moveaxis(a, ax, 0, stream());
+    }
+    auto shape = a.shape();
+    shape.insert(shape.begin(), n_vmap);
+    return broadcast_to(expand_dims(a, 0, stream()), shape, stream());
+  };
+  x = axes[0] >= 0 ? moveaxis(x, axes[0], 0, stream())
+                   : expand_dims(x, 0, stream());
+  bool vector = x.ndim() == 2;
+  if (vector) {
+    x = expand_dims(x, -2, stream());
+  }
+  std::vector<int> idx_shape(x.ndim() - 2, 1);
+  idx_shape[0] = n_vmap;
+  auto idx = reshape(arange(n_vmap, uint32, stream()), idx_shape, stream());
+  auto out = gather_qmm(
+      x,
+      to_front(w, axes[1]),
+      to_front(scales, axes[2]),
+      to_front(biases, axes[3]),
+      std::nullopt,
+      idx,
+      transpose_,
+      group_size_,
+      bits_,
+      false,
+      stream());
+  if (vector) {
+    out = squeeze(out, -2, stream());
+  }
+  return {{out}, {0}};
 }
 
 std::vector<array> QuantizedMatmul::vjp(
@@ -2424,6 +2745,7 @@ std::vector<array> GatherQMM::vjp(
                       !transpose_,
                       group_size_,
                       bits_,
+                      right_sorted_,
                       stream()),
                   -3,
                   stream()),
@@ -2458,7 +2780,119 @@ std::vector<array> GatherQMM::jvp(
 bool GatherQMM::is_equivalent(const Primitive& other) const {
   const GatherQMM& qm_other = static_cast<const GatherQMM&>(other);
   return group_size_ == qm_other.group_size_ && bits_ == qm_other.bits_ &&
-      transpose_ == qm_other.transpose_;
+      transpose_ == qm_other.transpose_ &&
+      right_sorted_ == qm_other.right_sorted_;
+}
+
+std::pair<std::vector<array>, std::vector<int>> Quantize::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // Groups run along the last axis so the vmapped axis goes in front
+  auto [wq, scales, biases] = quantize(
+      moveaxis(inputs[0], axes[0], 0, stream()),
+      group_size_,
+      bits_,
+      stream());
+  return {{wq, scales, biases}, {0, 0, 0}};
+}
+
+bool Quantize::is_equivalent(const Primitive& other) const {
+  const Quantize& q_other = static_cast<const Quantize&>(other);
+  return group_size_ == q_other.group_size_ && bits_ == q_other.bits_;
+}
+
+std::pair<std::vector<array>, std::vector<int>> Dequantize::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  int size = 0;
+  for (int i = 0; i < axes.size(); i++) {
+    if (axes[i] >= 0) {
+      size = inputs[i].shape(axes[i]);
+    }
+  }
+  std::vector<array> in;
+  for (int i = 0; i < axes.size(); i++) {
+    if (axes[i] >= 0) {
+      in.push_back(moveaxis(inputs[i], axes[i], 0, stream()));
+    } else {
+      auto shape = inputs[i].shape();
+      shape.insert(shape.begin(), size);
+      in.push_back(broadcast_to(
+          expand_dims(inputs[i], 0, stream()), std::move(shape), stream()));
+    }
+  }
+  return {
+      {dequantize(in[0], in[1], in[2], group_size_, bits_, stream())}, {0}};
+}
+
+std::vector<array> Dequantize::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  auto& w = primals[0];
+  auto& scales = primals[1];
+  auto& biases = primals[2];
+
+  // The output is scales * q + biases per group so the gradients are the
+  // sums over each group of the cotangent times q and of the cotangent.
+  auto group_shape = scales.shape();
+  group_shape.push_back(group_size_);
+  auto cotan = reshape(cotangents[0], group_shape, stream());
+
+  std::vector<array> vjps;
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      throw std::invalid_argument(
+          "[Dequantize::vjp] Cannot compute the gradient with respect to the "
+          "quantized matrix.");
+    } else if (arg == 1) {
+      auto q = dequantize(
+          w,
+          ones_like(scales, stream()),
+          zeros_like(biases, stream()),
+          group_size_,
+          bits_,
+          stream());
+      q = reshape(q, group_shape, stream());
+      vjps.push_back(sum(multiply(cotan, q, stream()), -1, false, stream()));
+    } else {
+      vjps.push_back(sum(cotan, -1, false, stream()));
+    }
+  }
+  return vjps;
+}
+
+std::vector<array> Dequantize::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  // Linear in the scales and biases
+  auto scales_tangent = zeros_like(primals[1], stream());
+  auto biases_tangent = zeros_like(primals[2], stream());
+  for (int i = 0; i < argnums.size(); i++) {
+    if (argnums[i] == 0) {
+      throw std::invalid_argument(
+          "[Dequantize::jvp] Cannot compute the derivative with respect to "
+          "the quantized matrix.");
+    } else if (argnums[i] == 1) {
+      scales_tangent = tangents[i];
+    } else {
+      biases_tangent = tangents[i];
+    }
+  }
+  return {dequantize(
+      primals[0],
+      scales_tangent,
+      biases_tangent,
+      group_size_,
+      bits_,
+      stream())};
+}
+
+bool Dequantize::is_equivalent(const Primitive& other) const {
+  const Dequantize& d_other = static_cast<const Dequantize&>(other);
+  return group_size_ == d_other.group_size_ && bits_ == d_other.bits_;
 }
 
 std::pair<std::vector<array>, std::vector<int>> RandomBits::vmap(
@@ -2507,6 +2941,74 @@ bool RandomBits::is_equivalent(const Primitive& other) const {
   return shape_ == r_other.shape_;
 }
 
+std::pair<std::vector<array>, std::vector<int>> RandomNormal::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  assert(inputs.size() == 1);
+  assert(axes.size() == 1);
+
+  // The last dimension of the key is always a key pair
+  auto key = inputs[0];
+  auto kax = axes[0];
+  if (kax == key.ndim() - 1) {
+    std::vector<int> reorder(key.ndim());
+    std::iota(reorder.begin(), reorder.end(), 0);
+    std::swap(reorder[kax], reorder[kax - 1]);
+    key = transpose(key, reorder, stream());
+    kax--;
+  }
+
+  auto shape = shape_;
+  if (kax >= 0) {
+    shape.insert(shape.begin() + kax, key.shape()[kax]);
+  }
+
+  auto out = array(
+      shape,
+      dtype_,
+      std::make_shared<RandomNormal>(stream(), shape, dtype_, loc_, scale_),
+      {key});
+  return {{out}, {kax}};
+}
+
+bool RandomNormal::is_equivalent(const Primitive& other) const {
+  const RandomNormal& r_other = static_cast<const RandomNormal&>(other);
+  return shape_ == r_other.shape_ && dtype_ == r_other.dtype_ &&
+      loc_ == r_other.loc_ && scale_ == r_other.scale_;
+}
+
+std::vector<array> RandomDropout::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  return jvp(primals, cotangents, argnums);
+}
+
+std::vector<array> RandomDropout::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  for (auto arg : argnums) {
+    if (arg == 1) {
+      throw std::invalid_argument(
+          "[dropout] Cannot calculate the gradient with respect to the key.");
+    }
+  }
+  // The same key masks the tangent like the input
+  auto& t = tangents[0];
+  return {array(
+      t.shape(),
+      t.dtype(),
+      std::make_shared<RandomDropout>(stream(), p_),
+      {t, primals[1]})};
+}
+
+bool RandomDropout::is_equivalent(const Primitive& other) const {
+  const RandomDropout& r_other = static_cast<const RandomDropout&>(other);
+  return p_ == r_other.p_;
+}
+
 std::pair<std::vector<array>, std::vector<int>> Reshape::vmap(
     const std::vector<array>& inputs,
     const std::vector<int>& axes) {
@@ -2822,6 +3324,79 @@ bool Scan::is_equivalent(const Primitive& other) const {
       reverse_ == s_other.reverse_ && inclusive_ == s_other.inclusive_);
 }
 
+std::pair<std::vector<array>, std::vector<int>> Scatter::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // Scatter into every vmapped slice at once by moving the vmapped axes to
+  // the front and indexing the new leading axis of the destination with
+  // the position of each update in the vmapped axis
+  int n_vmap = 0;
+  for (int i = 0; i < axes.size(); ++i) {
+    if (axes[i] >= 0) {
+      n_vmap = inputs[i].shape(axes[i]);
+    }
+  }
+  auto to_front = [&](const array& a, int ax, bool broadcast) {
+    if (ax >= 0) {
+      return moveaxis(a, ax, 0, stream());
+    }
+    auto out = expand_dims(a, 0, stream());
+    if (broadcast) {
+      auto shape = a.shape();
+      shape.insert(shape.begin(), n_vmap);
+      out = broadcast_to(out, shape, stream());
+    }
+    return out;
+  };
+
+  auto src = to_front(inputs[0], axes[0], true);
+  std::vector<array> indices;
+  int idx_ndim = 0;
+  for (int i = 1; i < inputs.size() - 1; ++i) {
+    indices.push_back(to_front(inputs[i], axes[i], false));
+    idx_ndim = std::max(idx_ndim, static_cast<int>(indices.back().ndim()) - 1);
+  }
+  // Align the other index axes to the right
+  for (auto& idx : indices) {
+    auto shape = idx.shape();
+    shape.insert(shape.begin() + 1, idx_ndim + 1 - idx.ndim(), 1);
+    idx = reshape(idx, std::move(shape), stream());
+  }
+  std::vector<int> vmap_shape(idx_ndim + 1, 1);
+  vmap_shape[0] = n_vmap;
+  auto idx_type = indices.empty() ? uint32 : indices[0].dtype();
+  indices.insert(
+      indices.begin(),
+      reshape(arange(n_vmap, idx_type, stream()), vmap_shape, stream()));
+
+  // The updates get a size one slice of the vmapped axis
+  auto updates = to_front(inputs.back(), axes.back(), true);
+  updates = expand_dims(updates, idx_ndim + 1, stream());
+
+  std::vector<int> scatter_axes = {0};
+  for (auto ax : axes_) {
+    scatter_axes.push_back(ax + 1);
+  }
+  switch (reduce_type_) {
+    case Scatter::None:
+      src = scatter(src, indices, updates, scatter_axes, stream());
+      break;
+    case Scatter::Sum:
+      src = scatter_add(src, indices, updates, scatter_axes, stream());
+      break;
+    case Scatter::Prod:
+      src = scatter_prod(src, indices, updates, scatter_axes, stream());
+      break;
+    case Scatter::Max:
+      src = scatter_max(src, indices, updates, scatter_axes, stream());
+      break;
+    case Scatter::Min:
+      src = scatter_min(src, indices, updates, scatter_axes, stream());
+      break;
+  }
+  return {{src}, {0}};
+}
+
 bool Scatter::is_equivalent(const Primitive& other) const {
   const Scatter& s_other = static_cast<const Scatter&>(other);
   return reduce_type_ == s_other.reduce_type_ && axes_ == s_other.axes_;
@@ -2926,6 +3501,167 @@ std::vector<array> Scatter::jvp(
   throw std::runtime_error("[scatter] JVP not yet implemented");
 }
 
+namespace {
+
+// The segment of each of the n rows delimited by the offsets
+array segment_ids(const array& offsets, int n, const Stream& s) {
+  int n_segments = offsets.size() - 1;
+  if (n_segments <= 1 || n == 0) {
+    return zeros({n}, int32, s);
+  }
+  auto starts = slice(offsets, {1}, {n_segments}, s);
+  auto marks = scatter_add(
+      zeros({n + 1}, int32, s),
+      starts,
+      ones({n_segments - 1, 1}, int32, s),
+      0,
+      s);
+  return slice(cumsum(marks, 0, false, true, s), {0}, {n}, s);
+}
+
+// Vmap the rows of the first input, the offsets are shared
+std::pair<array, int> segment_vmap_input(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes,
+    const Stream& s) {
+  if (axes[1] >= 0) {
+    throw std::invalid_argument(
+        "[segment_reduce] Cannot vmap over the offsets.");
+  }
+  if (axes[0] == 0) {
+    return {moveaxis(inputs[0], 0, 1, s), 1};
+  }
+  return {inputs[0], axes[0]};
+}
+
+} // namespace
+
+std::vector<std::vector<int>> SegmentedReduce::output_shapes(
+    const std::vector<array>& inputs) {
+  auto shape = inputs[0].shape();
+  shape[0] = inputs[1].size() - 1;
+  return {shape};
+}
+
+std::pair<std::vector<array>, std::vector<int>> SegmentedReduce::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  auto [in, ax] = segment_vmap_input(inputs, axes, stream());
+  auto shape = in.shape();
+  shape[0] = inputs[1].size() - 1;
+  return {
+      {array(
+          std::move(shape),
+          in.dtype(),
+          std::make_shared<SegmentedReduce>(stream(), reduce_type_),
+          {in, inputs[1]})},
+      {ax}};
+}
+
+std::vector<array> SegmentedReduce::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  auto& in = primals[0];
+  auto& offsets = primals[1];
+  auto cotan = cotangents[0];
+  std::vector<array> vjps;
+  for (auto num : argnums) {
+    if (num != 0) {
+      throw std::invalid_argument(
+          "[segment_reduce] Cannot calculate VJP with respect to the offsets.");
+    }
+    auto ids = segment_ids(offsets, in.shape(0), stream());
+    if (reduce_type_ == SegmentedReduce::Sum) {
+      vjps.push_back(take(cotan, ids, 0, stream()));
+    } else {
+      // Ties share the gradient like in Reduce
+      auto mask = equal(in, take(outputs[0], ids, 0, stream()), stream());
+      auto normalizer =
+          segment_sum(astype(mask, cotan.dtype(), stream()), offsets, stream());
+      normalizer = maximum(normalizer, array(1, cotan.dtype()), stream());
+      auto scaled = take(divide(cotan, normalizer, stream()), ids, 0, stream());
+      vjps.push_back(multiply(scaled, mask, stream()));
+    }
+  }
+  return vjps;
+}
+
+std::vector<array> SegmentedReduce::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  if (argnums.size() != 1 || argnums[0] != 0) {
+    throw std::invalid_argument(
+        "[segment_reduce] Cannot calculate JVP with respect to the offsets.");
+  }
+  auto& in = primals[0];
+  auto& offsets = primals[1];
+  auto& tan = tangents[0];
+  if (reduce_type_ == SegmentedReduce::Sum) {
+    return {segment_sum(tan, offsets, stream())};
+  }
+  auto out = reduce_type_ == SegmentedReduce::Max
+      ? segment_max(in, offsets, stream())
+      : segment_min(in, offsets, stream());
+  auto ids = segment_ids(offsets, in.shape(0), stream());
+  auto mask = equal(in, take(out, ids, 0, stream()), stream());
+  auto normalizer =
+      segment_sum(astype(mask, tan.dtype(), stream()), offsets, stream());
+  normalizer = maximum(normalizer, array(1, tan.dtype()), stream());
+  auto masked = multiply(tan, mask, stream());
+  return {divide(segment_sum(masked, offsets, stream()), normalizer, stream())};
+}
+
+bool SegmentedReduce::is_equivalent(const Primitive& other) const {
+  const SegmentedReduce& r_other = static_cast<const SegmentedReduce&>(other);
+  return reduce_type_ == r_other.reduce_type_;
+}
+
+std::pair<std::vector<array>, std::vector<int>> SegmentedScan::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  auto [in, ax] = segment_vmap_input(inputs, axes, stream());
+  return {
+      {array(
+          in.shape(),
+          in.dtype(),
+          std::make_shared<SegmentedScan>(stream(), reverse_, inclusive_),
+          {in, inputs[1]})},
+      {ax}};
+}
+
+std::vector<array> SegmentedScan::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  if (argnums.size() != 1 || argnums[0] != 0) {
+    throw std::invalid_argument(
+        "[segment_cumsum] Cannot calculate VJP with respect to the offsets.");
+  }
+  return {segment_cumsum(
+      cotangents[0], primals[1], !reverse_, inclusive_, stream())};
+}
+
+std::vector<array> SegmentedScan::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  if (argnums.size() != 1 || argnums[0] != 0) {
+    throw std::invalid_argument(
+        "[segment_cumsum] Cannot calculate JVP with respect to the offsets.");
+  }
+  return {segment_cumsum(
+      tangents[0], primals[1], reverse_, inclusive_, stream())};
+}
+
+bool SegmentedScan::is_equivalent(const Primitive& other) const {
+  const SegmentedScan& s_other = static_cast<const SegmentedScan&>(other);
+  return reverse_ == s_other.reverse_ && inclusive_ == s_other.inclusive_;
+}
+
 std::vector<array> Sigmoid::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
@@ -3808,7 +4544,8 @@ std::vector<array> GatherMM::vjp(
       base = reshape(base, {-1, M, K}, stream());
 
       // g : (out_batch_shape) + (M, K)
-      auto g = gather_mm(cotan, bt, std::nullopt, rhs_indices, stream());
+      auto g = gather_mm(
+          cotan, bt, std::nullopt, rhs_indices, right_sorted_, stream());
       g = expand_dims(g, -3, stream());
       auto gacc = scatter_add(base, lhs_indices, g, 0, stream());
 
@@ -3823,7 +4560,8 @@ std::vector<array> GatherMM::vjp(
       base = reshape(base, {-1, K, N}, stream());
 
       // g : (out_batch_shape) + (K, N)
-      auto g = gather_mm(at, cotan, lhs_indices, std::nullopt, stream());
+      auto g =
+          gather_mm(at, cotan, lhs_indices, std::nullopt, false, stream());
       g = expand_dims(g, -3, stream());
       auto gacc = scatter_add(base, rhs_indices, g, 0, stream());
 
@@ -3836,6 +4574,178 @@ std::vector<array> GatherMM::vjp(
   return vjps;
 }
 
+bool GatherMM::is_equivalent(const Primitive& other) const {
+  const GatherMM& g_other = static_cast<const GatherMM&>(other);
+  return right_sorted_ == g_other.right_sorted_;
+}
+
+namespace {
+
+// The positions of the two kept values of every group of four, of shape
+// (N, K / 4, 2)
+array positions_2_4(const array& metadata, Stream s) {
+  int N = metadata.shape(0);
+  int K = metadata.shape(1) * 32;
+  auto shifts = multiply(arange(8, uint32, s), array(4, uint32), s);
+  auto nibbles = bitwise_and(
+      right_shift(expand_dims(metadata, -1, s), shifts, s),
+      array(15, uint32),
+      s);
+  nibbles = reshape(nibbles, {N, K / 4, 1}, s);
+  return concatenate(
+      {bitwise_and(nibbles, array(3, uint32), s),
+       right_shift(nibbles, array(2, uint32), s)},
+      -1,
+      s);
+}
+
+} // namespace
+
+std::vector<array> Sparse24Matmul::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  std::vector<array> vjps;
+  auto& cotan = cotangents[0];
+  auto& x = primals[0];
+  auto& values = primals[1];
+  int N = values.shape(0);
+  int K = values.shape(1) * 2;
+  auto positions = positions_2_4(primals[2], stream());
+
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      // The cotangent times the dense weights, with the values put back in
+      // their groups
+      auto slots = equal(
+          expand_dims(positions, -1, stream()),
+          arange(4, uint32, stream()),
+          stream());
+      auto kept = reshape(values, {N, K / 4, 2, 1}, stream());
+      auto w = sum(
+          where(slots, kept, zeros_like(kept, stream()), stream()),
+          2,
+          false,
+          stream());
+      vjps.push_back(
+          matmul(cotan, reshape(w, {N, K}, stream()), stream()));
+    } else if (arg == 1) {
+      // The dense weight gradient at the kept positions
+      auto g = matmul(
+          transpose(reshape(cotan, {-1, N}, stream()), stream()),
+          reshape(x, {-1, K}, stream()),
+          stream());
+      g = take_along_axis(
+          reshape(g, {N, K / 4, 4}, stream()), positions, -1, stream());
+      vjps.push_back(reshape(g, {N, K / 2}, stream()));
+    } else {
+      throw std::invalid_argument(
+          "[Sparse24Matmul] Cannot calculate VJP with respect to metadata.");
+    }
+  }
+  return vjps;
+}
+
+std::vector<array> Fp8Matmul::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  std::vector<array> vjps;
+  auto& cotan = cotangents[0];
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      auto w = from_fp8(primals[1], format_, cotan.dtype(), stream());
+      vjps.push_back(matmul(cotan, w, stream()));
+    } else {
+      throw std::invalid_argument(
+          "[Fp8Matmul] Cannot calculate VJP with respect to the fp8 weights.");
+    }
+  }
+  return vjps;
+}
+
+bool Fp8Matmul::is_equivalent(const Primitive& other) const {
+  const Fp8Matmul& f_other = static_cast<const Fp8Matmul&>(other);
+  return format_ == f_other.format_;
+}
+
+std::vector<array> SparseMM::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  std::vector<array> vjps;
+  auto& cotan = cotangents[0];
+  auto& rows = primals[0];
+  auto& cols = primals[1];
+  auto& values = primals[2];
+  auto& b = primals[3];
+
+  for (auto arg : argnums) {
+    if (arg == 2) {
+      // The rows of the cotangent dotted with the rows of b they came from
+      vjps.push_back(array(
+          values.shape(),
+          values.dtype(),
+          std::make_shared<SampledMM>(stream()),
+          {rows, cols, cotan, b}));
+    } else if (arg == 3) {
+      // The transposed sparse matrix times the cotangent
+      vjps.push_back(array(
+          b.shape(),
+          b.dtype(),
+          std::make_shared<SparseMM>(stream(), b.shape(0)),
+          {cols, rows, values, cotan}));
+    } else {
+      throw std::invalid_argument(
+          "[SparseMM] Cannot calculate VJP with respect to indices.");
+    }
+  }
+  return vjps;
+}
+
+bool SparseMM::is_equivalent(const Primitive& other) const {
+  const SparseMM& s_other = static_cast<const SparseMM&>(other);
+  return num_rows_ == s_other.num_rows_;
+}
+
+std::vector<array> SampledMM::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  std::vector<array> vjps;
+  auto& cotan = cotangents[0];
+  auto& rows = primals[0];
+  auto& cols = primals[1];
+  auto& a = primals[2];
+  auto& b = primals[3];
+
+  // Each output is the dot product of a row of a and a row of b, so the
+  // gradients are sparse matrices with the cotangent as values times b or a
+  for (auto arg : argnums) {
+    if (arg == 2) {
+      vjps.push_back(array(
+          a.shape(),
+          a.dtype(),
+          std::make_shared<SparseMM>(stream(), a.shape(0)),
+          {rows, cols, cotan, b}));
+    } else if (arg == 3) {
+      vjps.push_back(array(
+          b.shape(),
+          b.dtype(),
+          std::make_shared<SparseMM>(stream(), b.shape(0)),
+          {cols, rows, cotan, a}));
+    } else {
+      throw std::invalid_argument(
+          "[SampledMM] Cannot calculate VJP with respect to indices.");
+    }
+  }
+  return vjps;
+}
+
 bool BlockMaskedMM::is_equivalent(const Primitive& other) const {
   const BlockMaskedMM& a_other = static_cast<const BlockMaskedMM&>(other);
   return (block_size_ == a_other.block_size_);
@@ -3933,6 +4843,182 @@ std::pair<std::vector<array>, std::vector<int>> Inverse::vmap(
   return {{linalg::inv(a, stream())}, {ax}};
 }
 
+std::pair<std::vector<array>, std::vector<int>> Solve::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // The batch dimensions are broadcast so only the vmapped ones are moved
+  auto a = axes[0] > 0 ? moveaxis(inputs[0], axes[0], 0, stream()) : inputs[0];
+  auto b = axes[1] > 0 ? moveaxis(inputs[1], axes[1], 0, stream()) : inputs[1];
+  if (axes[0] >= 0 && axes[1] < 0 && b.ndim() < a.ndim()) {
+    b = expand_dims(b, 0, stream());
+  } else if (axes[1] >= 0 && axes[0] < 0 && a.ndim() < b.ndim()) {
+    a = expand_dims(a, 0, stream());
+  }
+  auto ax = (axes[0] >= 0 || axes[1] >= 0) ? 0 : -1;
+  return {{linalg::solve(a, b, stream())}, {ax}};
+}
+
+std::vector<array> Solve::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // With x = a^-1 b the cotangent of b is a^-T g and the one of a is its
+  // outer product with -x
+  auto at = swapaxes(primals[0], -1, -2, stream());
+  auto gb = linalg::solve(at, cotangents[0], stream());
+  std::vector<array> vjps;
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      vjps.push_back(negative(
+          matmul(gb, swapaxes(outputs[0], -1, -2, stream()), stream()),
+          stream()));
+    } else {
+      vjps.push_back(gb);
+    }
+  }
+  return vjps;
+}
+
+std::vector<array> Solve::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  // dx = a^-1 (db - da x)
+  std::optional<array> rhs;
+  for (int i = 0; i < argnums.size(); i++) {
+    if (argnums[i] == 0) {
+      auto x = linalg::solve(primals[0], primals[1], stream());
+      auto t = negative(matmul(tangents[i], x, stream()), stream());
+      rhs = rhs ? add(*rhs, t, stream()) : t;
+    } else {
+      rhs = rhs ? add(*rhs, tangents[i], stream()) : tangents[i];
+    }
+  }
+  return {linalg::solve(primals[0], *rhs, stream())};
+}
+
+std::pair<std::vector<array>, std::vector<int>> SolveTriangular::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  // The batch dimensions are broadcast so only the vmapped ones are moved
+  auto a = axes[0] > 0 ? moveaxis(inputs[0], axes[0], 0, stream()) : inputs[0];
+  auto b = axes[1] > 0 ? moveaxis(inputs[1], axes[1], 0, stream()) : inputs[1];
+  if (axes[0] >= 0 && axes[1] < 0 && b.ndim() < a.ndim()) {
+    b = expand_dims(b, 0, stream());
+  } else if (axes[1] >= 0 && axes[0] < 0 && a.ndim() < b.ndim()) {
+    a = expand_dims(a, 0, stream());
+  }
+  auto ax = (axes[0] >= 0 || axes[1] >= 0) ? 0 : -1;
+  return {{linalg::solve_triangular(a, b, upper_, stream())}, {ax}};
+}
+
+std::vector<array> SolveTriangular::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // With x = a^-1 b the cotangent of b is a^-T g and the one of a is its
+  // outer product with -x restricted to the triangle that is read
+  auto at = swapaxes(primals[0], -1, -2, stream());
+  auto gb = linalg::solve_triangular(at, cotangents[0], !upper_, stream());
+  std::vector<array> vjps;
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      auto ga = negative(
+          matmul(gb, swapaxes(outputs[0], -1, -2, stream()), stream()),
+          stream());
+      vjps.push_back(upper_ ? triu(ga, 0, stream()) : tril(ga, 0, stream()));
+    } else {
+      vjps.push_back(gb);
+    }
+  }
+  return vjps;
+}
+
+std::vector<array> SolveTriangular::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  // dx = a^-1 (db - da x)
+  std::optional<array> rhs;
+  for (int i = 0; i < argnums.size(); i++) {
+    if (argnums[i] == 0) {
+      auto x = linalg::solve_triangular(
+          primals[0], primals[1], upper_, stream());
+      auto da = upper_ ? triu(tangents[i], 0, stream())
+                       : tril(tangents[i], 0, stream());
+      auto t = negative(matmul(da, x, stream()), stream());
+      rhs = rhs ? add(*rhs, t, stream()) : t;
+    } else {
+      rhs = rhs ? add(*rhs, tangents[i], stream()) : tangents[i];
+    }
+  }
+  return {linalg::solve_triangular(primals[0], *rhs, upper_, stream())};
+}
+
+bool SolveTriangular::is_equivalent(const Primitive& other) const {
+  auto& s_other = static_cast<const SolveTriangular&>(other);
+  return upper_ == s_other.upper_;
+}
+
+std::pair<std::vector<array>, std::vector<int>> Eigh::vmap(
+    const std::vector<array>& inputs,
+    const std::vector<int>& axes) {
+  auto ax = axes[0] >= 0 ? 0 : -1;
+  auto a = axes[0] > 0 ? moveaxis(inputs[0], axes[0], 0, stream()) : inputs[0];
+  std::string uplo(1, uplo_);
+  if (compute_eigenvectors_) {
+    auto [w, v] = linalg::eigh(a, uplo, stream());
+    return {{w, v}, {ax, ax}};
+  }
+  return {{linalg::eigvalsh(a, uplo, stream())}, {ax}};
+}
+
+std::vector<array> Eigh::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // With a = V diag(w) V^T the cotangent is
+  //   V (diag(gw) + F * (V^T gV)) V^T
+  // where F_ij = 1 / (w_j - w_i) off the diagonal and 0 on it
+  auto& s = stream();
+  auto& w = outputs[0];
+  auto v = compute_eigenvectors_
+      ? outputs[1]
+      : linalg::eigh(primals[0], std::string(1, uplo_), s).second;
+  auto vt = swapaxes(v, -1, -2, s);
+  auto inner = multiply(
+      eye(w.shape(-1), float32, s), expand_dims(cotangents[0], -1, s), s);
+  if (compute_eigenvectors_) {
+    auto diff =
+        subtract(expand_dims(w, -2, s), expand_dims(w, -1, s), s);
+    auto off_diag = logical_not(eye(w.shape(-1), bool_, s), s);
+    auto f = where(
+        off_diag, divide(array(1.0f), diff, s), array(0.0f), s);
+    inner = add(inner, multiply(f, matmul(vt, cotangents[1], s), s), s);
+  }
+  return {matmul(matmul(v, inner, s), vt, s)};
+}
+
+std::vector<std::vector<int>> Eigh::output_shapes(
+    const std::vector<array>& inputs) {
+  auto& shape = inputs[0].shape();
+  std::vector<std::vector<int>> shapes = {
+      std::vector<int>(shape.begin(), shape.end() - 1)};
+  if (compute_eigenvectors_) {
+    shapes.push_back(shape);
+  }
+  return shapes;
+}
+
+bool Eigh::is_equivalent(const Primitive& other) const {
+  auto& e_other = static_cast<const Eigh&>(other);
+  return uplo_ == e_other.uplo_ &&
+      compute_eigenvectors_ == e_other.compute_eigenvectors_;
+}
+
 std::pair<std::vector<array>, std::vector<int>> View::vmap(
     const std::vector<array>& inputs,
     const std::vector<int>& axes) {
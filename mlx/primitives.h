@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <optional>
 #include <unordered_set>
 
 #include "mlx/array.h"
@@ -59,6 +60,12 @@ class Primitive {
     return stream_;
   }
 
+  /** Move the primitive to another stream. Only meant to be used by eval on
+   * primitives which aren't shared with other graphs. */
+  void set_stream(const Stream& stream) {
+    stream_ = stream;
+  }
+
   /**
    * A primitive must know how to evaluate itself on
    * the CPU/GPU for the given inputs and populate the output arrays.
@@ -113,6 +120,23 @@ class Primitive {
   virtual std::vector<std::vector<int>> output_shapes(
       const std::vector<array>& inputs);
 
+  /**
+   * Elementwise primitives defined outside of MLX, e.g. in extensions, can
+   * be fused with their neighbors by compile by returning the body of a
+   * call operator computing one output element from one element of each
+   * input, for instance
+   *
+   *   template <typename T>
+   *   T operator()(T x, T y) { return 2 * x + y; }
+   *
+   * The source is compiled as Metal for the GPU and as C++ for the CPU. Only
+   * arrays with a single output whose shape is the inputs broadcast together
+   * are fused. The default empty source means the primitive is not fused.
+   */
+  virtual std::string elementwise_source() const {
+    return {};
+  }
+
   virtual ~Primitive() = default;
   Primitive(const Primitive& other) = delete;
   Primitive(Primitive&& other) = delete;
@@ -205,6 +229,10 @@ class AddMM : public UnaryPrimitive {
 
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return std::make_pair(alpha_, beta_);
+  }
+
  private:
   const float alpha_;
   const float beta_;
@@ -361,6 +389,10 @@ class ArgPartition : public UnaryPrimitive {
   DEFINE_INPUT_OUTPUT_SHAPE()
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return std::make_pair(kth_, axis_);
+  }
+
  private:
   int kth_;
   int axis_;
@@ -387,6 +419,10 @@ class ArgReduce : public UnaryPrimitive {
   std::vector<std::vector<int>> output_shapes(
       const std::vector<array>& inputs) override;
 
+  auto state() const {
+    return std::make_pair(reduce_type_, axis_);
+  }
+
  private:
   ReduceType reduce_type_;
   int axis_;
@@ -407,6 +443,10 @@ class ArgSort : public UnaryPrimitive {
   DEFINE_INPUT_OUTPUT_SHAPE()
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return axis_;
+  }
+
  private:
   int axis_;
 
@@ -475,6 +515,10 @@ class BitwiseBinary : public UnaryPrimitive {
   void print(std::ostream& os) override;
   DEFINE_INPUT_OUTPUT_SHAPE()
 
+  auto state() const {
+    return op_;
+  }
+
  private:
   Op op_;
 };
@@ -504,7 +548,8 @@ class BlockMaskedMM : public UnaryPrimitive {
 
 class GatherMM : public UnaryPrimitive {
  public:
-  explicit GatherMM(Stream stream) : UnaryPrimitive(stream) {}
+  explicit GatherMM(Stream stream, bool right_sorted = false)
+      : UnaryPrimitive(stream), right_sorted_(right_sorted) {}
 
   void eval_cpu(const std::vector<array>& inputs, array& out) override;
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
@@ -516,6 +561,103 @@ class GatherMM : public UnaryPrimitive {
       const std::vector<array>& outputs) override;
 
   DEFINE_PRINT(GatherMM)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  // The rhs indices are sorted and the lhs indices select the batch elements
+  // of the lhs in order
+  bool right_sorted_;
+
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
+// Multiply x with the transpose of a 2:4 sparse matrix given by its kept
+// values and their positions
+class Sparse24Matmul : public UnaryPrimitive {
+ public:
+  explicit Sparse24Matmul(Stream stream) : UnaryPrimitive(stream) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_PRINT(Sparse24Matmul)
+  DEFINE_DEFAULT_IS_EQUIVALENT()
+
+ private:
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
+// Multiply x with the transpose of a matrix of 8-bit floats stored as uint8
+class Fp8Matmul : public UnaryPrimitive {
+ public:
+  explicit Fp8Matmul(Stream stream, std::string format)
+      : UnaryPrimitive(stream), format_(std::move(format)) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_PRINT(Fp8Matmul)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  std::string format_;
+
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
+// Multiply a sparse matrix given by the rows, columns and values of its
+// nonzeros with a dense matrix
+class SparseMM : public UnaryPrimitive {
+ public:
+  explicit SparseMM(Stream stream, int num_rows)
+      : UnaryPrimitive(stream), num_rows_(num_rows) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_PRINT(SparseMM)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  int num_rows_;
+
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
+// The dot products of the rows of a and b selected by the rows and columns of
+// the nonzeros of a sparse matrix
+class SampledMM : public UnaryPrimitive {
+ public:
+  explicit SampledMM(Stream stream) : UnaryPrimitive(stream) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_PRINT(SampledMM)
   DEFINE_DEFAULT_IS_EQUIVALENT()
 
  private:
@@ -541,6 +683,37 @@ class Broadcast : public UnaryPrimitive {
   void eval(const std::vector<array>& inputs, array& out);
 };
 
+class CacheAppend : public Primitive {
+ public:
+  explicit CacheAppend(Stream stream, int offset, int axis)
+      : Primitive(stream), offset_(offset), axis_(axis) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_PRINT(CacheAppend)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_pair(offset_, axis_);
+  }
+
+ private:
+  int offset_;
+  int axis_;
+
+  void eval(const std::vector<array>& inputs, std::vector<array>& outputs);
+
+  // Moves the buffer of the cache to the output if it has room for the
+  // update and is not used elsewhere. Otherwise the output is allocated and
+  // the filled part of the cache has to be copied.
+  bool reuse_cache(const array& cache, array& out);
+
+  // Makes the view a slice of the filled part of the output cache
+  void set_filled_view(const array& out, array& view);
+};
+
 class Ceil : public UnaryPrimitive {
  public:
   explicit Ceil(Stream stream) : UnaryPrimitive(stream) {}
@@ -614,6 +787,10 @@ class Concatenate : public UnaryPrimitive {
   DEFINE_PRINT(Concatenate)
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return axis_;
+  }
+
  private:
   int axis_;
 
@@ -657,6 +834,15 @@ class Convolution : public UnaryPrimitive {
   void eval_cpu(const std::vector<array>& inputs, array& out) override;
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
 
+  /** Evaluates the convolution followed by activation(out + bias). */
+  void eval_gpu(
+      const std::vector<array>& inputs,
+      array& out,
+      const std::optional<array>& bias,
+      int activation);
+
+  DEFINE_VMAP()
+
   std::vector<array> vjp(
       const std::vector<array>& primals,
       const std::vector<array>& cotangents,
@@ -666,6 +852,16 @@ class Convolution : public UnaryPrimitive {
   DEFINE_PRINT(Convolution)
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return std::make_tuple(
+        padding_,
+        kernel_strides_,
+        kernel_dilation_,
+        input_dilation_,
+        groups_,
+        flip_);
+  }
+
  private:
   std::vector<int> padding_;
   std::vector<int> kernel_strides_;
@@ -876,6 +1072,10 @@ class Equal : public UnaryPrimitive {
     }
   }
 
+  auto state() const {
+    return equal_nan_;
+  }
+
  private:
   void eval(const std::vector<array>& inputs, array& out);
   bool equal_nan_;
@@ -1063,6 +1263,27 @@ class GreaterEqual : public UnaryPrimitive {
   void eval(const std::vector<array>& inputs, array& out);
 };
 
+class Hadamard : public UnaryPrimitive {
+ public:
+  explicit Hadamard(Stream stream, float scale)
+      : UnaryPrimitive(stream), scale_(scale) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+  DEFINE_PRINT(Hadamard)
+  DEFINE_INPUT_OUTPUT_SHAPE()
+
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  float scale_;
+
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
 class Less : public UnaryPrimitive {
  public:
   explicit Less(Stream stream) : UnaryPrimitive(stream) {}
@@ -1113,6 +1334,9 @@ class Load : public UnaryPrimitive {
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
 
   DEFINE_PRINT(Load)
+  auto state() const {
+    return std::make_tuple(reader_, offset_, swap_endianness_);
+  }
 
  private:
   void eval(const std::vector<array>& inputs, array& out);
@@ -1150,6 +1374,10 @@ class Log : public UnaryPrimitive {
     }
   }
 
+  auto state() const {
+    return base_;
+  }
+
  private:
   Base base_;
   void eval(const std::vector<array>& inputs, array& out);
@@ -1239,6 +1467,25 @@ class LogAddExp : public UnaryPrimitive {
   void eval(const std::vector<array>& inputs, array& out);
 };
 
+class LogSumExp : public UnaryPrimitive {
+ public:
+  explicit LogSumExp(Stream stream) : UnaryPrimitive(stream) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+  DEFINE_PRINT(LogSumExp)
+  DEFINE_DEFAULT_IS_EQUIVALENT()
+
+  std::vector<std::vector<int>> output_shapes(
+      const std::vector<array>& inputs) override;
+
+ private:
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
 class Matmul : public UnaryPrimitive {
  public:
   explicit Matmul(Stream stream) : UnaryPrimitive(stream) {}
@@ -1257,6 +1504,31 @@ class Matmul : public UnaryPrimitive {
   DEFINE_DEFAULT_IS_EQUIVALENT()
 };
 
+// The gradients of a matmul with respect to both of its inputs. The inputs
+// are the cotangent and the transposes of b and a, the outputs are
+// cotan @ b.T and a.T @ cotan. The two products are evaluated back to back
+// so the GPU runs them concurrently.
+class MatmulVJP : public Primitive {
+ public:
+  explicit MatmulVJP(Stream stream) : Primitive(stream) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+  DEFINE_PRINT(MatmulVJP)
+  DEFINE_DEFAULT_IS_EQUIVALENT()
+
+  std::vector<std::vector<int>> output_shapes(
+      const std::vector<array>& inputs) override;
+
+ private:
+  void eval(const std::vector<array>& inputs, std::vector<array>& outputs);
+};
+
 class Maximum : public UnaryPrimitive {
  public:
   explicit Maximum(Stream stream) : UnaryPrimitive(stream) {}
@@ -1393,6 +1665,10 @@ class Pad : public UnaryPrimitive {
   DEFINE_PRINT(Pad)
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return std::make_tuple(axes_, low_pad_size_, high_pad_size_);
+  }
+
  private:
   std::vector<int> axes_;
   std::vector<int> low_pad_size_;
@@ -1415,6 +1691,10 @@ class Partition : public UnaryPrimitive {
   DEFINE_INPUT_OUTPUT_SHAPE()
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return std::make_pair(kth_, axis_);
+  }
+
  private:
   int kth_;
   int axis_;
@@ -1469,11 +1749,17 @@ class QuantizedMatmul : public UnaryPrimitive {
 
 class GatherQMM : public UnaryPrimitive {
  public:
-  explicit GatherQMM(Stream stream, int group_size, int bits, bool transpose)
+  explicit GatherQMM(
+      Stream stream,
+      int group_size,
+      int bits,
+      bool transpose,
+      bool right_sorted = false)
       : UnaryPrimitive(stream),
         group_size_(group_size),
         bits_(bits),
-        transpose_(transpose) {}
+        transpose_(transpose),
+        right_sorted_(right_sorted) {}
 
   void eval_cpu(const std::vector<array>& inputs, array& out) override;
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
@@ -1487,6 +1773,48 @@ class GatherQMM : public UnaryPrimitive {
   int group_size_;
   int bits_;
   bool transpose_;
+  bool right_sorted_;
+
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
+class Quantize : public Primitive {
+ public:
+  explicit Quantize(Stream stream, int group_size, int bits)
+      : Primitive(stream), group_size_(group_size), bits_(bits) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_VMAP()
+  DEFINE_PRINT(Quantize)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  int group_size_;
+  int bits_;
+
+  void eval(const std::vector<array>& inputs, std::vector<array>& outputs);
+};
+
+class Dequantize : public UnaryPrimitive {
+ public:
+  explicit Dequantize(Stream stream, int group_size, int bits)
+      : UnaryPrimitive(stream), group_size_(group_size), bits_(bits) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+  DEFINE_PRINT(Dequantize)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  int group_size_;
+  int bits_;
 
   void eval(const std::vector<array>& inputs, array& out);
 };
@@ -1510,6 +1838,57 @@ class RandomBits : public UnaryPrimitive {
   void eval(const std::vector<array>& inputs, array& out);
 };
 
+class RandomNormal : public UnaryPrimitive {
+ public:
+  explicit RandomNormal(
+      Stream stream,
+      const std::vector<int>& shape,
+      Dtype dtype,
+      float loc,
+      float scale)
+      : UnaryPrimitive(stream),
+        shape_(shape),
+        dtype_(dtype),
+        loc_(loc),
+        scale_(scale) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_PRINT(RandomNormal)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  std::vector<int> shape_;
+  Dtype dtype_;
+  float loc_;
+  float scale_;
+
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
+// Keeps the elements of the first input with probability 1 - p using the key
+// in the second input. The mask only depends on the key and the position of
+// the element so the gradient draws it again instead of storing it.
+class RandomDropout : public UnaryPrimitive {
+ public:
+  explicit RandomDropout(Stream stream, float p)
+      : UnaryPrimitive(stream), p_(p) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_GRADS()
+  DEFINE_PRINT(RandomDropout)
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  float p_;
+
+  void eval(const std::vector<array>& inputs, array& out);
+};
+
 class Reshape : public UnaryPrimitive {
  public:
   explicit Reshape(Stream stream, const std::vector<int>& shape)
@@ -1585,6 +1964,13 @@ class Reduce : public UnaryPrimitive {
   }
   bool is_equivalent(const Primitive& other) const override;
 
+  ReduceType reduce_type() const {
+    return reduce_type_;
+  }
+  const std::vector<int>& axes() const {
+    return axes_;
+  }
+
  private:
   ReduceType reduce_type_;
   std::vector<int> axes_;
@@ -1672,6 +2058,7 @@ class Scatter : public UnaryPrimitive {
   void eval_cpu(const std::vector<array>& inputs, array& out) override;
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
 
+  DEFINE_VMAP();
   DEFINE_GRADS();
   void print(std::ostream& os) override {
     os << "Scatter";
@@ -1700,6 +2087,68 @@ class Scatter : public UnaryPrimitive {
   std::vector<int> axes_;
 };
 
+// Reduces the rows of the first input in each segment delimited by the
+// offsets in the second input.
+class SegmentedReduce : public UnaryPrimitive {
+ public:
+  enum ReduceType { Sum, Min, Max };
+
+  explicit SegmentedReduce(Stream stream, ReduceType reduce_type)
+      : UnaryPrimitive(stream), reduce_type_(reduce_type) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+
+  std::vector<std::vector<int>> output_shapes(
+      const std::vector<array>& inputs) override;
+
+  void print(std::ostream& os) override {
+    os << "Segment";
+    switch (reduce_type_) {
+      case Sum:
+        os << "Sum";
+        break;
+      case Min:
+        os << "Min";
+        break;
+      case Max:
+        os << "Max";
+        break;
+    }
+  }
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  void eval(const std::vector<array>& inputs, array& out);
+  ReduceType reduce_type_;
+};
+
+// Cumulative sum of the rows of the first input restarting at each segment
+// delimited by the offsets in the second input.
+class SegmentedScan : public UnaryPrimitive {
+ public:
+  explicit SegmentedScan(Stream stream, bool reverse, bool inclusive)
+      : UnaryPrimitive(stream), reverse_(reverse), inclusive_(inclusive) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+  DEFINE_PRINT(SegmentCumSum)
+  DEFINE_INPUT_OUTPUT_SHAPE()
+
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  void eval(const std::vector<array>& inputs, array& out);
+  bool reverse_;
+  bool inclusive_;
+};
+
 class Sigmoid : public UnaryPrimitive {
  public:
   explicit Sigmoid(Stream stream) : UnaryPrimitive(stream) {}
@@ -1788,6 +2237,10 @@ class Slice : public UnaryPrimitive {
   DEFINE_PRINT(Slice)
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return std::make_tuple(start_indices_, end_indices_, strides_);
+  }
+
  private:
   std::vector<int> start_indices_;
   std::vector<int> end_indices_;
@@ -1841,6 +2294,10 @@ class Softmax : public UnaryPrimitive {
 
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return precise_;
+  }
+
  private:
   void eval(const std::vector<array>& inputs, array& out);
   bool precise_;
@@ -1860,6 +2317,10 @@ class Sort : public UnaryPrimitive {
   DEFINE_INPUT_OUTPUT_SHAPE()
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return axis_;
+  }
+
  private:
   int axis_;
 
@@ -1881,6 +2342,10 @@ class Split : public Primitive {
   DEFINE_PRINT(Split)
   bool is_equivalent(const Primitive& other) const override;
 
+  auto state() const {
+    return std::make_pair(indices_, axis_);
+  }
+
  private:
   void eval(const std::vector<array>& inputs, std::vector<array>& outputs);
 
@@ -1926,6 +2391,10 @@ class Sqrt : public UnaryPrimitive {
     }
   }
 
+  auto state() const {
+    return recip_;
+  }
+
  private:
   void eval(const std::vector<array>& inputs, array& out);
   bool recip_;
@@ -2042,6 +2511,10 @@ class Transpose : public UnaryPrimitive {
   DEFINE_PRINT(Transpose)
   bool is_equivalent(const Primitive& other) const override;
 
+  const std::vector<int>& axes() const {
+    return axes_;
+  }
+
  private:
   std::vector<int> axes_;
 
@@ -2112,4 +2585,82 @@ class Cholesky : public UnaryPrimitive {
   bool upper_;
 };
 
+class Solve : public UnaryPrimitive {
+ public:
+  explicit Solve(Stream stream) : UnaryPrimitive(stream) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+  DEFINE_PRINT(Solve)
+  DEFINE_DEFAULT_IS_EQUIVALENT()
+
+  std::vector<std::vector<int>> output_shapes(
+      const std::vector<array>& inputs) override {
+    return {inputs[1].shape()};
+  }
+
+ private:
+  void eval(const std::vector<array>& inputs, array& output);
+};
+
+class SolveTriangular : public UnaryPrimitive {
+ public:
+  explicit SolveTriangular(Stream stream, bool upper)
+      : UnaryPrimitive(stream), upper_(upper) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_VMAP()
+  DEFINE_GRADS()
+  DEFINE_PRINT(SolveTriangular)
+
+  std::vector<std::vector<int>> output_shapes(
+      const std::vector<array>& inputs) override {
+    return {inputs[1].shape()};
+  }
+
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  void eval(const std::vector<array>& inputs, array& output);
+  bool upper_;
+};
+
+/* Symmetric eigendecomposition primitive. */
+class Eigh : public Primitive {
+ public:
+  explicit Eigh(Stream stream, char uplo, bool compute_eigenvectors)
+      : Primitive(stream),
+        uplo_(uplo),
+        compute_eigenvectors_(compute_eigenvectors) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_VMAP()
+  DEFINE_PRINT(Eigh)
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  std::vector<std::vector<int>> output_shapes(
+      const std::vector<array>& inputs) override;
+
+  bool is_equivalent(const Primitive& other) const override;
+
+ private:
+  void eval(const std::vector<array>& inputs, std::vector<array>& outputs);
+  char uplo_;
+  bool compute_eigenvectors_;
+};
+
 } // namespace mlx::core
@@ -0,0 +1,150 @@
+// Copyright © 2024 Apple Inc.
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include "mlx/backend/metal/metal.h"
+#include "mlx/primitives.h"
+#include "mlx/profiler.h"
+#include "mlx/profiler_impl.h"
+#include "mlx/utils.h"
+
+namespace mlx::core::profiler {
+
+namespace {
+
+constexpr size_t max_events = 1 << 20;
+
+struct Profiler {
+  std::atomic<bool> enabled{false};
+  std::atomic<int> sample_every{1};
+  std::atomic<uint64_t> evals{0};
+  std::mutex mtx;
+  std::chrono::steady_clock::time_point origin;
+  std::vector<Event> events;
+};
+
+Profiler& profiler() {
+  static Profiler profiler_;
+  return profiler_;
+}
+
+uint64_t now(const Profiler& p) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - p.origin)
+      .count();
+}
+
+} // namespace
+
+namespace detail {
+
+bool sample_eval() {
+  auto& p = profiler();
+  if (!p.enabled) {
+    return false;
+  }
+  return p.evals++ % p.sample_every == 0;
+}
+
+scheduler::Task record(const array& arr, scheduler::Task task) {
+  // The array is detached by the task so its description is taken now
+  std::ostringstream name;
+  arr.primitive().print(name);
+  std::vector<std::vector<int>> shapes;
+  size_t nbytes = 0;
+  for (auto& out : arr.outputs()) {
+    shapes.push_back(out.shape());
+    nbytes += out.nbytes();
+  }
+  return [task = std::move(task),
+          event = Event{
+              name.str(),
+              arr.primitive().stream(),
+              std::move(shapes),
+              0,
+              0,
+              nbytes,
+              0}]() mutable {
+    auto& p = profiler();
+    auto memory = static_cast<int64_t>(metal::get_active_memory());
+    event.start = now(p);
+    task();
+    event.end = now(p);
+    event.memory = static_cast<int64_t>(metal::get_active_memory()) - memory;
+    std::lock_guard<std::mutex> lk(p.mtx);
+    if (p.events.size() < max_events) {
+      p.events.push_back(std::move(event));
+    }
+  };
+}
+
+} // namespace detail
+
+void start(int sample_every /* = 1 */) {
+  if (sample_every < 1) {
+    throw std::invalid_argument(
+        "[profiler::start] sample_every must be at least 1.");
+  }
+  auto& p = profiler();
+  std::lock_guard<std::mutex> lk(p.mtx);
+  p.events.clear();
+  p.origin = std::chrono::steady_clock::now();
+  p.sample_every = sample_every;
+  p.evals = 0;
+  p.enabled = true;
+}
+
+void stop() {
+  profiler().enabled = false;
+  synchronize(default_stream(Device::cpu));
+  if (metal::is_available()) {
+    synchronize(default_stream(Device::gpu));
+  }
+}
+
+bool is_enabled() {
+  return profiler().enabled;
+}
+
+std::vector<Event> events() {
+  auto& p = profiler();
+  std::lock_guard<std::mutex> lk(p.mtx);
+  return p.events;
+}
+
+void save_trace(const std::string& path) {
+  std::ofstream os(path);
+  if (!os) {
+    throw std::runtime_error(
+        "[profiler::save_trace] Cannot open " + path + " for writing.");
+  }
+
+  // Chrome trace event format with times in microseconds. Each device is a
+  // process and each stream a thread.
+  auto& p = profiler();
+  std::lock_guard<std::mutex> lk(p.mtx);
+  os << "{\"traceEvents\": [";
+  for (int i = 0; i < p.events.size(); i++) {
+    auto& e = p.events[i];
+    os << (i > 0 ? ",\n" : "\n") << "{\"name\": \"" << e.name
+       << "\", \"cat\": \""
+       << (e.stream.device == Device::cpu ? "cpu" : "gpu")
+       << "\", \"ph\": \"X\""
+       << ", \"pid\": " << static_cast<int>(e.stream.device.type)
+       << ", \"tid\": " << e.stream.index << ", \"ts\": " << e.start * 1e-3
+       << ", \"dur\": " << (e.end - e.start) * 1e-3 << ", \"args\": {"
+       << "\"shapes\": \"";
+    for (int j = 0; j < e.shapes.size(); j++) {
+      os << (j > 0 ? ", " : "") << e.shapes[j];
+    }
+    os << "\", \"nbytes\": " << e.nbytes << ", \"memory\": " << e.memory
+       << "}}";
+  }
+  os << "\n]}\n";
+}
+
+} // namespace mlx::core::profiler
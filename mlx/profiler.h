@@ -0,0 +1,52 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mlx/stream.h"
+
+namespace mlx::core::profiler {
+
+/* A primitive evaluated while profiling. */
+struct Event {
+  std::string name;
+  Stream stream;
+  // The shapes of the primitive's outputs
+  std::vector<std::vector<int>> shapes;
+  // Nanoseconds since profiling started. For GPU primitives this is the time
+  // taken to encode their kernels, see metal::start_profiling for the time
+  // they take to run.
+  uint64_t start;
+  uint64_t end;
+  // The size of the outputs and the change in active memory while the
+  // primitive ran, which includes the memory other streams allocated
+  size_t nbytes;
+  int64_t memory;
+};
+
+/* Start recording the primitives evaluated on every device. Records from an
+ * earlier profile are cleared.
+ *
+ * Only the primitives of one in `sample_every` calls to eval or async_eval
+ * are recorded so that profiling can be left on with little overhead. At
+ * most one million events are kept.
+ * */
+void start(int sample_every = 1);
+
+/* Stop recording and wait for the profiled work to finish. */
+void stop();
+
+/* Whether primitives are being recorded. */
+bool is_enabled();
+
+/* The primitives recorded since profiling started, in the order they
+ * finished. */
+std::vector<Event> events();
+
+/* Save the recorded primitives as a Chrome trace (JSON) to `path`. It can be
+ * viewed in chrome://tracing or Perfetto. */
+void save_trace(const std::string& path);
+
+} // namespace mlx::core::profiler
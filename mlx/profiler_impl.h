@@ -0,0 +1,16 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+#include "mlx/task_queue.h"
+
+namespace mlx::core::profiler::detail {
+
+// Called once per eval, returns true if its primitives should be recorded
+bool sample_eval();
+
+// Wrap the task evaluating arr so that it is recorded when it runs
+scheduler::Task record(const array& arr, scheduler::Task task);
+
+} // namespace mlx::core::profiler::detail
@@ -0,0 +1,311 @@
+// Copyright © 2024 Apple Inc.
+
+#include <numeric>
+#include <sstream>
+
+#include "mlx/fast.h"
+#include "mlx/fast_primitives.h"
+#include "mlx/ops.h"
+#include "mlx/ragged.h"
+
+namespace mlx::core::ragged {
+
+namespace {
+
+void check(const RaggedArray& x, const char* tag) {
+  if (x.values.ndim() == 0) {
+    std::ostringstream msg;
+    msg << "[ragged::" << tag << "] The values must have a token dimension "
+        << "but got a scalar.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(x.offsets.dtype(), integer) || x.offsets.ndim() != 1 ||
+      x.offsets.size() == 0) {
+    std::ostringstream msg;
+    msg << "[ragged::" << tag << "] The offsets must be a non empty integer "
+        << "vector but got shape " << x.offsets.shape() << " and type "
+        << x.offsets.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+int num_segments(const RaggedArray& x) {
+  return x.offsets.size() - 1;
+}
+
+} // namespace
+
+RaggedArray from_sequences(
+    const std::vector<array>& sequences,
+    StreamOrDevice s /* = {} */) {
+  if (sequences.empty()) {
+    throw std::invalid_argument(
+        "[ragged::from_sequences] At least one sequence is required.");
+  }
+  std::vector<int> offsets = {0};
+  for (auto& seq : sequences) {
+    if (seq.ndim() == 0) {
+      throw std::invalid_argument(
+          "[ragged::from_sequences] The sequences must have a token "
+          "dimension.");
+    }
+    offsets.push_back(offsets.back() + seq.shape(0));
+  }
+  int n = offsets.size();
+  return {concatenate(sequences, 0, s), array(offsets.data(), {n}, int32)};
+}
+
+RaggedArray from_padded(
+    const array& padded,
+    const std::vector<int>& lengths,
+    StreamOrDevice s /* = {} */) {
+  if (padded.ndim() < 2 || padded.shape(0) != lengths.size()) {
+    std::ostringstream msg;
+    msg << "[ragged::from_padded] Expected an array of shape "
+        << "(batch, max_length, ...) with batch " << lengths.size()
+        << " but got shape " << padded.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int max_length = padded.shape(1);
+  std::vector<int> offsets = {0};
+  std::vector<int> rows;
+  for (int b = 0; b < lengths.size(); b++) {
+    if (lengths[b] < 0 || lengths[b] > max_length) {
+      std::ostringstream msg;
+      msg << "[ragged::from_padded] Sequence lengths must be in [0, "
+          << max_length << "] but got " << lengths[b] << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    for (int i = 0; i < lengths[b]; i++) {
+      rows.push_back(b * max_length + i);
+    }
+    offsets.push_back(offsets.back() + lengths[b]);
+  }
+  auto flat = flatten(padded, 0, 1, s);
+  int n_rows = rows.size();
+  int n = offsets.size();
+  return {
+      take(flat, array(rows.data(), {n_rows}, int32), 0, s),
+      array(offsets.data(), {n}, int32)};
+}
+
+array to_padded(
+    const RaggedArray& x,
+    int max_length,
+    float pad_value /* = 0.0f */,
+    StreamOrDevice s /* = {} */) {
+  check(x, "to_padded");
+  if (max_length < 0) {
+    throw std::invalid_argument(
+        "[ragged::to_padded] The maximum length must be non negative.");
+  }
+  auto& v = x.values;
+  int B = num_segments(x);
+  int T = v.shape(0);
+
+  // Tokens past the maximum length are sent to an extra row which is
+  // dropped
+  auto shape = v.shape();
+  shape[0] = B * max_length + 1;
+  auto out = full(shape, array(pad_value, v.dtype()), s);
+  if (T > 0 && B > 0) {
+    auto ids = segment_ids(x.offsets, T, s);
+    auto pos = subtract(
+        arange(T, int32, s), take(astype(x.offsets, int32, s), ids, s), s);
+    auto rows = where(
+        less(pos, array(max_length), s),
+        add(multiply(ids, array(max_length), s), pos, s),
+        array(B * max_length),
+        s);
+    out = scatter(out, rows, expand_dims(v, 1, s), 0, s);
+  }
+  std::vector<int> start(out.ndim(), 0);
+  auto stop = out.shape();
+  stop[0] = B * max_length;
+  out = slice(out, std::move(start), std::move(stop), s);
+  shape = v.shape();
+  shape[0] = max_length;
+  shape.insert(shape.begin(), B);
+  return reshape(out, std::move(shape), s);
+}
+
+array segment_ids(
+    const array& offsets,
+    int num_tokens,
+    StreamOrDevice s /* = {} */) {
+  // The starts of sequences 1 to B - 1 are marked and the marks at or
+  // before each token are counted
+  int B = offsets.size() - 1;
+  if (B <= 1 || num_tokens == 0) {
+    return zeros({num_tokens}, int32, s);
+  }
+  auto starts = astype(slice(offsets, {1}, {B}, s), int32, s);
+  auto marks = scatter_add(
+      zeros({num_tokens + 1}, int32, s),
+      starts,
+      ones({B - 1, 1}, int32, s),
+      0,
+      s);
+  return slice(cumsum(marks, 0, false, true, s), {0}, {num_tokens}, s);
+}
+
+array segment_sum(const RaggedArray& x, StreamOrDevice s /* = {} */) {
+  check(x, "segment_sum");
+  return mlx::core::segment_sum(x.values, x.offsets, s);
+}
+
+array segment_max(const RaggedArray& x, StreamOrDevice s /* = {} */) {
+  check(x, "segment_max");
+  return mlx::core::segment_max(x.values, x.offsets, s);
+}
+
+RaggedArray softmax(const RaggedArray& x, StreamOrDevice s /* = {} */) {
+  check(x, "softmax");
+  if (!issubdtype(x.values.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[ragged::softmax] Only floating point types are supported but "
+        << "got " << x.values.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto ids = segment_ids(x.offsets, x.values.shape(0), s);
+  RaggedArray x32{astype(x.values, float32, s), x.offsets};
+  auto maxes = stop_gradient(segment_max(x32, s), s);
+  auto e = exp(subtract(x32.values, take(maxes, ids, 0, s), s), s);
+  auto sums = segment_sum({e, x.offsets}, s);
+  auto out = divide(e, take(sums, ids, 0, s), s);
+  return {astype(out, x.values.dtype(), s), x.offsets};
+}
+
+RaggedArray rms_norm(
+    const RaggedArray& x,
+    const array& weight,
+    float eps,
+    StreamOrDevice s /* = {} */) {
+  check(x, "rms_norm");
+  return {fast::rms_norm(x.values, weight, eps, s), x.offsets};
+}
+
+RaggedArray layer_norm(
+    const RaggedArray& x,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    float eps,
+    StreamOrDevice s /* = {} */) {
+  check(x, "layer_norm");
+  return {fast::layer_norm(x.values, weight, bias, eps, s), x.offsets};
+}
+
+RaggedArray scaled_dot_product_attention(
+    const RaggedArray& queries,
+    const RaggedArray& keys,
+    const RaggedArray& values,
+    const float scale,
+    bool causal /* = false */,
+    StreamOrDevice s /* = {} */) {
+  for (auto x : {&queries, &keys, &values}) {
+    check(*x, "scaled_dot_product_attention");
+    if (x->values.ndim() != 3) {
+      std::ostringstream msg;
+      msg << "[ragged::scaled_dot_product_attention] Expected values of "
+          << "shape (tokens, heads, head_dim) but got " << x->values.shape()
+          << ".";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+  auto& q = queries.values;
+  auto& k = keys.values;
+  auto& v = values.values;
+  if (queries.offsets.size() != keys.offsets.size() ||
+      keys.offsets.size() != values.offsets.size() ||
+      k.shape(0) != v.shape(0) || k.shape(1) != v.shape(1) ||
+      q.shape(2) != k.shape(2)) {
+    std::ostringstream msg;
+    msg << "[ragged::scaled_dot_product_attention] The queries, keys and "
+        << "values must have the same number of sequences, the keys and "
+        << "values the same tokens and heads and the queries and keys the "
+        << "same head dimension but got " << q.shape() << ", " << k.shape()
+        << " and " << v.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int n_q_heads = q.shape(1);
+  int n_kv_heads = k.shape(1);
+  if (n_q_heads % n_kv_heads != 0) {
+    std::ostringstream msg;
+    msg << "[ragged::scaled_dot_product_attention] The query heads must be "
+        << "a multiple of the key heads but got " << n_q_heads << " and "
+        << n_kv_heads << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto final_type = result_type(q, k, v);
+  if (!issubdtype(final_type, floating)) {
+    std::ostringstream msg;
+    msg << "[ragged::scaled_dot_product_attention] Received unsupported "
+        << "type " << final_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Attention over all the tokens with the pairs from different sequences
+  // masked. It is quadratic in the batch and only used where the kernel is
+  // not, e.g. for the gradients.
+  auto fallback = [scale, causal, s](const std::vector<array>& inputs) {
+    auto& q = inputs[0];
+    auto& k = inputs[1];
+    int Tq = q.shape(0);
+    int Tk = k.shape(0);
+    auto q_ids = segment_ids(inputs[3], Tq, s);
+    auto k_ids = segment_ids(inputs[4], Tk, s);
+    auto mask = equal(expand_dims(q_ids, 1, s), k_ids, s);
+    if (causal) {
+      // Query i of a sequence sees its keys up to i + k_len - q_len
+      auto& q_offsets = inputs[3];
+      auto& k_offsets = inputs[4];
+      auto next_ids = add(q_ids, array(1), s);
+      auto q_start = take(q_offsets, q_ids, s);
+      auto q_len = subtract(take(q_offsets, next_ids, s), q_start, s);
+      auto k_len = subtract(
+          take(k_offsets, next_ids, s), take(k_offsets, q_ids, s), s);
+      auto q_pos = subtract(arange(Tq, int32, s), q_start, s);
+      auto last = add(q_pos, subtract(k_len, q_len, s), s);
+      auto k_pos =
+          subtract(arange(Tk, int32, s), take(k_offsets, k_ids, s), s);
+      mask = logical_and(
+          mask, less_equal(k_pos, expand_dims(last, 1, s), s), s);
+    }
+    auto to_heads = [s](const array& x) {
+      return expand_dims(transpose(x, {1, 0, 2}, s), 0, s);
+    };
+    auto out = fast::scaled_dot_product_attention(
+        to_heads(q), to_heads(k), to_heads(inputs[2]), scale, mask, s);
+    out = transpose(squeeze(out, 0, s), {1, 0, 2}, s);
+    // Queries without keys are zero like in the kernel
+    auto has_keys = expand_dims(any(mask, 1, false, s), {1, 2}, s);
+    return std::vector<array>{where(has_keys, out, array(0, out.dtype()), s)};
+  };
+
+  std::vector<array> inputs = {
+      astype(q, final_type, s),
+      astype(k, final_type, s),
+      astype(v, final_type, s),
+      astype(queries.offsets, int32, s),
+      astype(keys.offsets, int32, s)};
+
+  auto out_shape = q.shape();
+  out_shape[2] = v.shape(2);
+  auto stream = to_stream(s);
+  int head_dim = q.shape(2);
+  bool supported = stream.device == Device::gpu && head_dim == v.shape(2) &&
+      (head_dim == 64 || head_dim == 128);
+  if (supported) {
+    return {
+        array(
+            std::move(out_shape),
+            final_type,
+            std::make_shared<fast::RaggedAttention>(
+                stream, fallback, scale, causal),
+            std::move(inputs)),
+        queries.offsets};
+  }
+  return {fallback(inputs)[0], queries.offsets};
+}
+
+} // namespace mlx::core::ragged
@@ -0,0 +1,93 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "mlx/array.h"
+#include "mlx/device.h"
+#include "mlx/stream.h"
+#include "mlx/utils.h"
+
+namespace mlx::core::ragged {
+
+/**
+ * A batch of sequences of different lengths stored without padding. The
+ * tokens of sequence b are rows [offsets[b], offsets[b + 1]) of values, so
+ * per token operations like matmul apply to values directly.
+ */
+struct RaggedArray {
+  array values;
+  array offsets;
+};
+
+/** Concatenate the sequences, which differ only in their first dimension. */
+RaggedArray from_sequences(
+    const std::vector<array>& sequences,
+    StreamOrDevice s = {});
+
+/**
+ * Take the first lengths[b] rows of sequence b of a padded array of shape
+ * (batch, max_length, ...).
+ */
+RaggedArray from_padded(
+    const array& padded,
+    const std::vector<int>& lengths,
+    StreamOrDevice s = {});
+
+/**
+ * Pad the sequences to max_length with pad_value. Tokens past max_length are
+ * dropped.
+ */
+array to_padded(
+    const RaggedArray& x,
+    int max_length,
+    float pad_value = 0.0f,
+    StreamOrDevice s = {});
+
+/** The sequence of each of the num_tokens tokens delimited by offsets. */
+array segment_ids(const array& offsets, int num_tokens, StreamOrDevice s = {});
+
+/** Sum the tokens of each sequence. Empty sequences sum to zero. */
+array segment_sum(const RaggedArray& x, StreamOrDevice s = {});
+
+/**
+ * The maximum of the tokens of each sequence. Empty sequences give the lowest
+ * value of the type.
+ */
+array segment_max(const RaggedArray& x, StreamOrDevice s = {});
+
+/** Softmax over the tokens of each sequence, computed in float32. */
+RaggedArray softmax(const RaggedArray& x, StreamOrDevice s = {});
+
+/** RMS normalize every token, see fast::rms_norm. */
+RaggedArray rms_norm(
+    const RaggedArray& x,
+    const array& weight,
+    float eps,
+    StreamOrDevice s = {});
+
+/** Layer normalize every token, see fast::layer_norm. */
+RaggedArray layer_norm(
+    const RaggedArray& x,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    float eps,
+    StreamOrDevice s = {});
+
+/**
+ * Attention within each sequence of a batch. The queries, keys and values
+ * have shape (tokens, heads, head_dim) and the same number of sequences, and
+ * a query attends only to the keys of its sequence. With causal the queries
+ * are aligned to the end of the keys of their sequence.
+ */
+RaggedArray scaled_dot_product_attention(
+    const RaggedArray& queries,
+    const RaggedArray& keys,
+    const RaggedArray& values,
+    const float scale,
+    bool causal = false,
+    StreamOrDevice s = {});
+
+} // namespace mlx::core::ragged
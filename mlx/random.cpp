@@ -33,11 +33,10 @@ array key(uint64_t seed) {
   return array({k1, k2});
 }
 
-array bits(
-    const std::vector<int>& shape,
-    int width /* 4 */,
-    const std::optional<array>& key_ /*= nullopt */,
-    StreamOrDevice s /* = {} */) {
+namespace {
+
+// Returns the given key or the next one of the default sequence
+array get_key(const std::optional<array>& key_) {
   auto key = key_ ? *key_ : KeySequence::default_().next();
   if (key.dtype() != uint32) {
     std::ostringstream msg;
@@ -49,6 +48,17 @@ array bits(
     msg << "Expected key shape (2) but received " << key.shape() << ".";
     throw std::invalid_argument(msg.str());
   }
+  return key;
+}
+
+} // namespace
+
+array bits(
+    const std::vector<int>& shape,
+    int width /* 4 */,
+    const std::optional<array>& key_ /*= nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto key = get_key(key_);
 
   auto get_dtype = [width]() {
     switch (width) {
@@ -169,6 +179,14 @@ array normal(
     const std::optional<array>& key /*= nullopt */,
     StreamOrDevice s /* = {} */) {
   auto stream = to_stream(s);
+  // Sample the floating point types in one kernel from the random bits
+  if (dtype == float32 || dtype == float16 || dtype == bfloat16) {
+    return array(
+        shape,
+        dtype,
+        std::make_shared<RandomNormal>(stream, shape, dtype, loc, scale),
+        {get_key(key)});
+  }
   auto get_low = [&dtype]() {
     switch (dtype) {
       case float16:
@@ -307,6 +325,30 @@ array bernoulli(
   return bernoulli(array(0.5f), key, s);
 }
 
+array dropout(
+    const array& x,
+    float p,
+    const std::optional<array>& key /*= nullopt */,
+    StreamOrDevice s /* = {} */) {
+  if (p < 0 || p >= 1) {
+    std::ostringstream msg;
+    msg << "[dropout] The probability must be in [0, 1) but got " << p << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(x.dtype(), floating)) {
+    throw std::invalid_argument(
+        "[dropout] Only floating point inputs are supported.");
+  }
+  if (p == 0) {
+    return x;
+  }
+  return array(
+      x.shape(),
+      x.dtype(),
+      std::make_shared<RandomDropout>(to_stream(s), p),
+      {x, get_key(key)});
+}
+
 array truncated_normal(
     const array& lower,
     const array& upper,
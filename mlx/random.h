@@ -182,6 +182,14 @@ array bernoulli(
     const std::optional<array>& key = std::nullopt,
     StreamOrDevice s = {});
 
+/** Zero each element of x with probability p and scale the others by
+ * 1 / (1 - p). The mask is drawn inside the kernel from the key. */
+array dropout(
+    const array& x,
+    float p,
+    const std::optional<array>& key = std::nullopt,
+    StreamOrDevice s = {});
+
 array truncated_normal(
     const array& lower,
     const array& upper,
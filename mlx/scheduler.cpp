@@ -1,7 +1,21 @@
 // Copyright © 2023 Apple Inc.
 
+#include <algorithm>
+#include <deque>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "mlx/scheduler.h"
 #include "mlx/backend/metal/metal.h"
+#include "mlx/threadpool.h"
+#include "mlx/transforms.h"
 
 namespace mlx::core {
 
@@ -29,6 +43,18 @@ Stream new_stream(Device d) {
   return scheduler::scheduler().new_stream(d);
 }
 
+Stream new_stream(Device d, StreamPriority priority) {
+  if (!metal::is_available() && d == Device::gpu) {
+    throw std::invalid_argument(
+        "[new_stream] Cannot make gpu stream without gpu backend.");
+  }
+  return scheduler::scheduler().new_stream(d, priority);
+}
+
+StreamPriority stream_priority(Stream s) {
+  return scheduler::scheduler().get_priority(s);
+}
+
 Stream new_stream() {
   return scheduler::scheduler().new_stream(default_device());
 }
@@ -56,5 +82,281 @@ Scheduler& scheduler() {
   return scheduler;
 }
 
+void set_thread_priority(StreamPriority priority) {
+  if (priority == StreamPriority::normal) {
+    return;
+  }
+#if defined(__APPLE__)
+  pthread_set_qos_class_self_np(
+      priority == StreamPriority::high ? QOS_CLASS_USER_INTERACTIVE
+                                       : QOS_CLASS_UTILITY,
+      0);
+#elif defined(__linux__)
+  // Raising the priority of a thread needs privileges so only lower it
+  if (priority == StreamPriority::low) {
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), 10);
+  }
+#endif
+}
+
+namespace {
+
+/* A pool where every worker has its own deque of tasks. Tasks pushed from a
+ * worker go to the back of its own deque and are popped from there so
+ * dependent work stays on the same thread, idle workers steal from the front
+ * of the others' deques.
+ * */
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(int num_threads) {
+    for (int i = 0; i < num_threads; i++) {
+      workers_.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < num_threads; i++) {
+      workers_[i]->thread = std::thread(&WorkStealingPool::thread_fn, this, i);
+    }
+  }
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& w : workers_) {
+      w->thread.join();
+    }
+  }
+
+  void push(Task task) {
+    int idx = (worker_index() >= 0) ? worker_index()
+                                    : (next_worker_++ % workers_.size());
+    {
+      std::lock_guard<std::mutex> lk(workers_[idx]->mtx);
+      workers_[idx]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      n_pending_++;
+    }
+    cond_.notify_one();
+  }
+
+ private:
+  struct Worker {
+    std::mutex mtx;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  static int& worker_index() {
+    static thread_local int idx = -1;
+    return idx;
+  }
+
+  bool pop(int idx, Task& task) {
+    {
+      auto& w = *workers_[idx];
+      std::lock_guard<std::mutex> lk(w.mtx);
+      if (!w.tasks.empty()) {
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        return true;
+      }
+    }
+    for (int i = 1; i < workers_.size(); i++) {
+      auto& w = *workers_[(idx + i) % workers_.size()];
+      std::lock_guard<std::mutex> lk(w.mtx);
+      if (!w.tasks.empty()) {
+        task = std::move(w.tasks.front());
+        w.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void thread_fn(int idx) {
+    worker_index() = idx;
+    while (true) {
+      Task task;
+      if (pop(idx, task)) {
+        n_pending_--;
+        // A task running alone splits its kernels on the CPU thread pool
+        ThreadPool::set_serial(n_running_++ > 0 || n_pending_ > 0);
+        task();
+        n_running_--;
+        continue;
+      }
+      std::unique_lock<std::mutex> lk(mtx_);
+      cond_.wait(lk, [this] { return n_pending_ > 0 || stop_; });
+      if (stop_ && n_pending_ == 0) {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<int> n_pending_{0};
+  std::atomic<int> n_running_{0};
+  std::atomic<unsigned int> next_worker_{0};
+  std::mutex mtx_;
+  std::condition_variable cond_;
+  bool stop_{false};
+};
+
+WorkStealingPool& graph_pool() {
+  static WorkStealingPool pool(cpu_threads());
+  return pool;
+}
+
+/* A thread which waits for the events of graph tasks and pushes them to the
+ * pool once they are signaled, so that no worker blocks on an event whose
+ * signaling task could be queued behind it. */
+class EventWaiter {
+ public:
+  EventWaiter() : thread_(&EventWaiter::thread_fn, this) {}
+
+  ~EventWaiter() {
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      stop_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+  }
+
+  void push(std::vector<Event> events, Task task) {
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      queue_.emplace_back(std::move(events), std::move(task));
+    }
+    cond_.notify_one();
+  }
+
+ private:
+  void thread_fn() {
+    while (true) {
+      std::pair<std::vector<Event>, Task> item;
+      {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cond_.wait(lk, [this] { return !queue_.empty() || stop_; });
+        if (queue_.empty()) {
+          return;
+        }
+        item = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      for (auto& e : item.first) {
+        e.wait();
+      }
+      item.second();
+    }
+  }
+
+  std::deque<std::pair<std::vector<Event>, Task>> queue_;
+  std::mutex mtx_;
+  std::condition_variable cond_;
+  bool stop_{false};
+  std::thread thread_;
+};
+
+EventWaiter& event_waiter() {
+  // The pool is made first so that it outlives the waiter
+  graph_pool();
+  static EventWaiter waiter;
+  return waiter;
+}
+
+struct GraphState {
+  std::vector<GraphTask> tasks;
+  std::unique_ptr<std::atomic<int>[]> deps;
+  std::atomic<int> remaining;
+  std::mutex mtx;
+  std::condition_variable cond;
+  std::exception_ptr error;
+};
+
+void run_graph_task(std::shared_ptr<GraphState> state, int idx);
+
+void schedule_graph_task(std::shared_ptr<GraphState> state, int idx) {
+  auto& waits = state->tasks[idx].waits;
+  bool ready = std::all_of(
+      waits.begin(), waits.end(), [](auto& e) { return e.is_signaled(); });
+  if (ready) {
+    graph_pool().push([state, idx]() { run_graph_task(state, idx); });
+  } else {
+    auto events = std::move(waits);
+    event_waiter().push(std::move(events), [state, idx]() {
+      graph_pool().push([state, idx]() { run_graph_task(state, idx); });
+    });
+  }
+}
+
+void run_graph_task(std::shared_ptr<GraphState> state, int idx) {
+  {
+    // Release the task (and the arrays it holds) before its dependents run
+    auto fn = std::move(state->tasks[idx].fn);
+    try {
+      fn();
+    } catch (...) {
+      std::lock_guard<std::mutex> lk(state->mtx);
+      if (!state->error) {
+        state->error = std::current_exception();
+      }
+    }
+  }
+  for (auto s : state->tasks[idx].successors) {
+    if (--state->deps[s] == 0) {
+      schedule_graph_task(state, s);
+    }
+  }
+  if (--state->remaining == 0) {
+    std::lock_guard<std::mutex> lk(state->mtx);
+    state->cond.notify_all();
+  }
+}
+
+} // namespace
+
+void run_graph(std::vector<GraphTask> tasks) {
+  if (tasks.empty()) {
+    return;
+  }
+  auto state = std::make_shared<GraphState>();
+  state->tasks = std::move(tasks);
+  int n = state->tasks.size();
+  state->deps = std::make_unique<std::atomic<int>[]>(n);
+  state->remaining = n;
+  for (int i = 0; i < n; i++) {
+    state->deps[i] = state->tasks[i].n_deps;
+  }
+  for (int i = 0; i < n; i++) {
+    if (state->tasks[i].n_deps == 0) {
+      schedule_graph_task(state, i);
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lk(state->mtx);
+    state->cond.wait(lk, [&state] { return state->remaining == 0; });
+  }
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+bool& graph_scheduling_flag() {
+  static bool enabled = std::getenv("MLX_CPU_GRAPH_SCHEDULING") != nullptr;
+  return enabled;
+}
+
+bool graph_scheduling() {
+  return graph_scheduling_flag();
+}
+
 } // namespace scheduler
+
+void set_cpu_graph_scheduling(bool enabled) {
+  scheduler::graph_scheduling_flag() = enabled;
+}
 } // namespace mlx::core
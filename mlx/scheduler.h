@@ -11,21 +11,34 @@
 #include "mlx/backend/metal/metal.h"
 #include "mlx/backend/metal/metal_impl.h"
 #include "mlx/device.h"
+#include "mlx/event.h"
 #include "mlx/stream.h"
+#include "mlx/task_queue.h"
 
 namespace mlx::core::scheduler {
 
+/* Set the scheduling priority of the calling thread, where the platform
+ * supports it. */
+void set_thread_priority(StreamPriority priority);
+
 struct StreamThread {
   std::mutex mtx;
-  std::queue<std::function<void()>> q;
+  TaskQueue q;
   std::condition_variable cond;
-  bool stop;
+  std::atomic<bool> stop;
+  // Set while the thread sleeps waiting for work
+  std::atomic<bool> waiting;
   Stream stream;
+  StreamPriority priority;
   std::thread thread;
 
-  StreamThread(Stream stream)
-      : stop(false), stream(stream), thread(&StreamThread::thread_fn, this) {
-    metal::new_stream(stream);
+  StreamThread(Stream stream, StreamPriority priority)
+      : stop(false),
+        waiting(false),
+        stream(stream),
+        priority(priority),
+        thread(&StreamThread::thread_fn, this) {
+    metal::new_stream(stream, priority);
   }
 
   ~StreamThread() {
@@ -39,33 +52,56 @@ struct StreamThread {
   }
 
   void thread_fn() {
+    set_thread_priority(priority);
+    Task task;
     while (true) {
-      std::function<void()> task;
-      {
-        std::unique_lock<std::mutex> lk(mtx);
-        cond.wait(lk, [this] { return !this->q.empty() || this->stop; });
-        if (q.empty() && stop) {
-          return;
-        }
-        task = std::move(q.front());
-        q.pop();
+      if (q.try_pop(task)) {
+        task();
+        task.reset();
+        continue;
+      }
+      if (!q.empty()) {
+        // A producer is in the middle of publishing
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lk(mtx);
+      waiting = true;
+      cond.wait(lk, [this] { return !this->q.empty() || this->stop; });
+      waiting = false;
+      if (q.empty() && stop) {
+        return;
       }
-
-      task();
     }
   }
 
   template <typename F>
   void enqueue(F&& f) {
-    {
-      std::lock_guard<std::mutex> lk(mtx);
-      if (stop) {
-        throw std::runtime_error(
-            "Cannot enqueue work after stream is stopped.");
-      }
-      q.emplace(std::forward<F>(f));
+    check_stopped();
+    q.push(Task(std::forward<F>(f)));
+    wake();
+  }
+
+  void enqueue_many(std::vector<Task> tasks) {
+    check_stopped();
+    q.push_many(std::move(tasks));
+    wake();
+  }
+
+ private:
+  void check_stopped() {
+    if (stop) {
+      throw std::runtime_error("Cannot enqueue work after stream is stopped.");
+    }
+  }
+
+  void wake() {
+    // Only take the lock if the thread may be sleeping. Pairs with the
+    // store to waiting before the thread checks the queue is empty.
+    if (waiting) {
+      { std::lock_guard<std::mutex> lk(mtx); }
+      cond.notify_one();
     }
-    cond.notify_one();
   }
 };
 
@@ -84,15 +120,25 @@ class Scheduler {
   Scheduler& operator=(const Scheduler&) = delete;
   Scheduler& operator=(Scheduler&&) = delete;
 
-  Stream new_stream(const Device& d) {
+  Stream new_stream(
+      const Device& d,
+      StreamPriority priority = StreamPriority::normal) {
     auto stream = Stream(streams_.size(), d);
-    streams_.push_back(new StreamThread{stream});
+    streams_.push_back(new StreamThread{stream, priority});
     return stream;
   }
 
+  StreamPriority get_priority(const Stream& stream) const {
+    return streams_[stream.index]->priority;
+  }
+
   template <typename F>
   void enqueue(const Stream& stream, F&& f);
 
+  void enqueue_many(const Stream& stream, std::vector<Task> tasks) {
+    streams_[stream.index]->enqueue_many(std::move(tasks));
+  }
+
   Stream get_default_stream(const Device& d) const {
     return default_streams_.at(d.type);
   }
@@ -145,6 +191,35 @@ class Scheduler {
   std::mutex mtx;
 };
 
+/* A task in a graph of CPU tasks run by run_graph. */
+struct GraphTask {
+  Task fn;
+  // Indices of the tasks which depend on this one
+  std::vector<int> successors;
+  // Number of tasks this one depends on
+  int n_deps{0};
+  // Events of other streams to wait for before the task runs
+  std::vector<Event> waits;
+};
+
+/* Run a graph of tasks on a work-stealing pool and block until all of them
+ * are done. A task becomes runnable once every task it depends on finished
+ * and its events are signaled, independent tasks may run concurrently and in
+ * any order. Tasks waiting for events are held by a separate thread so they
+ * never block the workers.
+ *
+ * The pool has cpu_threads() workers. While several graph tasks run at once
+ * their kernels don't split their work on the CPU thread pool so the two
+ * pools together don't use more threads than there are cores.
+ *
+ * If a task throws the first exception is rethrown once the graph finished.
+ * */
+void run_graph(std::vector<GraphTask> tasks);
+
+/* Whether eval runs independent CPU primitives from the same stream
+ * concurrently instead of one at a time in stream order. */
+bool graph_scheduling();
+
 template <typename F>
 void Scheduler::enqueue(const Stream& stream, F&& f) {
   streams_[stream.index]->enqueue(std::forward<F>(f));
@@ -157,6 +232,12 @@ void enqueue(const Stream& stream, F&& f) {
   scheduler().enqueue(stream, std::forward<F>(f));
 }
 
+/* Enqueue a batch of tasks on a stream at once. The tasks run in order and
+ * are not interleaved with tasks enqueued from other threads. */
+inline void enqueue_many(const Stream& stream, std::vector<Task> tasks) {
+  scheduler().enqueue_many(stream, std::move(tasks));
+}
+
 inline int n_active_tasks() {
   return scheduler().n_active_tasks();
 }
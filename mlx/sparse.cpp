@@ -0,0 +1,204 @@
+// Copyright © 2024 Apple Inc.
+
+#include <sstream>
+
+#include "mlx/ops.h"
+#include "mlx/primitives.h"
+#include "mlx/sparse.h"
+
+namespace mlx::core::sparse {
+
+namespace {
+
+void check_shape(const std::vector<int>& shape, const char* tag) {
+  if (shape.size() != 2 || shape[0] < 0 || shape[1] < 0) {
+    std::ostringstream msg;
+    msg << "[sparse::" << tag << "] The shape of a sparse matrix must have "
+        << "two non negative dimensions but got " << shape << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+void check_indices(const array& indices, const array& values, const char* tag) {
+  if (!issubdtype(indices.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[sparse::" << tag << "] Indices must be integers but got "
+        << indices.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (indices.ndim() != 1 || values.ndim() != 1 ||
+      indices.size() != values.size()) {
+    std::ostringstream msg;
+    msg << "[sparse::" << tag << "] The indices and values must be vectors "
+        << "of the same size but got shapes " << indices.shape() << " and "
+        << values.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+void check(const COO& a, const char* tag) {
+  check_shape(a.shape, tag);
+  check_indices(a.rows, a.values, tag);
+  check_indices(a.cols, a.values, tag);
+}
+
+void check(const CSR& a, const char* tag) {
+  check_shape(a.shape, tag);
+  check_indices(a.indices, a.values, tag);
+  if (!issubdtype(a.indptr.dtype(), integer) || a.indptr.ndim() != 1 ||
+      a.indptr.size() != a.shape[0] + 1) {
+    std::ostringstream msg;
+    msg << "[sparse::" << tag << "] The indptr of a CSR matrix with "
+        << a.shape[0] << " rows must be an integer vector of size "
+        << a.shape[0] + 1 << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+// The products are computed in a floating point type
+Dtype result_type(const array& a, const array& b, const char* tag) {
+  auto dtype = promote_types(a.dtype(), b.dtype());
+  if (issubdtype(dtype, complexfloating)) {
+    std::ostringstream msg;
+    msg << "[sparse::" << tag << "] Complex types are not supported.";
+    throw std::invalid_argument(msg.str());
+  }
+  return issubdtype(dtype, floating) ? dtype : float32;
+}
+
+// The row of every nonzero. The positions where rows 1 to M - 1 start are
+// marked and the marks before each nonzero are counted.
+array csr_rows(const CSR& a, StreamOrDevice s) {
+  int nnz = a.indices.size();
+  int M = a.shape[0];
+  if (M <= 1 || nnz == 0) {
+    return zeros({nnz}, int32, s);
+  }
+  auto starts = astype(slice(a.indptr, {1}, {M}, s), int32, s);
+  auto marks = scatter_add(
+      zeros({nnz + 1}, int32, s),
+      starts,
+      ones({M - 1, 1}, int32, s),
+      0,
+      s);
+  return slice(cumsum(marks, 0, false, true, s), {0}, {nnz}, s);
+}
+
+} // namespace
+
+COO to_coo(const CSR& a, StreamOrDevice s /* = {} */) {
+  check(a, "to_coo");
+  return {csr_rows(a, s), a.indices, a.values, a.shape};
+}
+
+CSR to_csr(const COO& a, StreamOrDevice s /* = {} */) {
+  check(a, "to_csr");
+  int M = a.shape[0];
+  int nnz = a.values.size();
+  auto rows = astype(a.rows, int64, s);
+  auto cols = astype(a.cols, int64, s);
+  auto order =
+      argsort(add(multiply(rows, array(a.shape[1], int64), s), cols, s), s);
+  auto counts = scatter_add(
+      zeros({M}, int32, s),
+      astype(a.rows, int32, s),
+      ones({nnz, 1}, int32, s),
+      0,
+      s);
+  auto indptr = concatenate(
+      {zeros({1}, int32, s), cumsum(counts, 0, false, true, s)}, 0, s);
+  return {
+      indptr, take(a.cols, order, s), take(a.values, order, s), a.shape};
+}
+
+array to_dense(const COO& a, StreamOrDevice s /* = {} */) {
+  check(a, "to_dense");
+  int nnz = a.values.size();
+  return scatter_add(
+      zeros(a.shape, a.values.dtype(), s),
+      {a.rows, a.cols},
+      reshape(a.values, {nnz, 1, 1}, s),
+      {0, 1},
+      s);
+}
+
+array to_dense(const CSR& a, StreamOrDevice s /* = {} */) {
+  return to_dense(to_coo(a, s), s);
+}
+
+array spmm(const COO& a, const array& b, StreamOrDevice s /* = {} */) {
+  check(a, "spmm");
+  if (b.ndim() != 2 || b.shape(0) != a.shape[1]) {
+    std::ostringstream msg;
+    msg << "[sparse::spmm] Cannot multiply a sparse matrix of shape "
+        << a.shape << " with an array of shape " << b.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto dtype = result_type(a.values, b, "spmm");
+  auto stream = to_stream(s);
+  return array(
+      {a.shape[0], b.shape(1)},
+      dtype,
+      std::make_shared<SparseMM>(stream, a.shape[0]),
+      {astype(a.rows, int32, s),
+       astype(a.cols, int32, s),
+       astype(a.values, dtype, s),
+       astype(b, dtype, s)});
+}
+
+array spmm(const CSR& a, const array& b, StreamOrDevice s /* = {} */) {
+  return spmm(to_coo(a, s), b, s);
+}
+
+array spmv(const COO& a, const array& x, StreamOrDevice s /* = {} */) {
+  if (x.ndim() != 1) {
+    std::ostringstream msg;
+    msg << "[sparse::spmv] Expected a vector but got an array of shape "
+        << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  return flatten(spmm(a, expand_dims(x, 1, s), s), s);
+}
+
+array spmv(const CSR& a, const array& x, StreamOrDevice s /* = {} */) {
+  return spmv(to_coo(a, s), x, s);
+}
+
+COO sddmm(
+    const COO& mask,
+    const array& a,
+    const array& b,
+    StreamOrDevice s /* = {} */) {
+  check(mask, "sddmm");
+  if (a.ndim() != 2 || b.ndim() != 2 || a.shape(1) != b.shape(0) ||
+      a.shape(0) != mask.shape[0] || b.shape(1) != mask.shape[1]) {
+    std::ostringstream msg;
+    msg << "[sparse::sddmm] The product of arrays of shapes " << a.shape()
+        << " and " << b.shape() << " cannot be sampled with a mask of shape "
+        << mask.shape << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto dtype = result_type(a, b, "sddmm");
+  auto rows = astype(mask.rows, int32, s);
+  auto cols = astype(mask.cols, int32, s);
+
+  // The kernel reads a row of a and a column of b, i.e. a row of b.T, per
+  // nonzero
+  auto dots = array(
+      {static_cast<int>(mask.values.size())},
+      dtype,
+      std::make_shared<SampledMM>(to_stream(s)),
+      {rows, cols, astype(a, dtype, s), transpose(astype(b, dtype, s), s)});
+  return {rows, cols, multiply(mask.values, dots, s), mask.shape};
+}
+
+CSR sddmm(
+    const CSR& mask,
+    const array& a,
+    const array& b,
+    StreamOrDevice s /* = {} */) {
+  auto out = sddmm(to_coo(mask, s), a, b, s);
+  return {mask.indptr, mask.indices, out.values, mask.shape};
+}
+
+} // namespace mlx::core::sparse
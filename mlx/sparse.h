@@ -0,0 +1,74 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <vector>
+
+#include "mlx/array.h"
+#include "mlx/device.h"
+#include "mlx/stream.h"
+#include "mlx/utils.h"
+
+namespace mlx::core::sparse {
+
+/**
+ * A matrix stored as the coordinates and values of its nonzeros. Repeated
+ * coordinates are summed.
+ */
+struct COO {
+  array rows;
+  array cols;
+  array values;
+  std::vector<int> shape;
+};
+
+/**
+ * A matrix in compressed sparse row format. The columns and values of the
+ * nonzeros of row i are at positions [indptr[i], indptr[i + 1]) of indices
+ * and values.
+ */
+struct CSR {
+  array indptr;
+  array indices;
+  array values;
+  std::vector<int> shape;
+};
+
+/** Convert a CSR matrix to coordinate format with its rows in order. */
+COO to_coo(const CSR& a, StreamOrDevice s = {});
+
+/** Convert a COO matrix to CSR format, sorting its nonzeros by row. */
+CSR to_csr(const COO& a, StreamOrDevice s = {});
+
+/** Scatter the nonzeros into a dense matrix. */
+array to_dense(const COO& a, StreamOrDevice s = {});
+array to_dense(const CSR& a, StreamOrDevice s = {});
+
+/**
+ * Multiply a sparse matrix with a dense matrix. The products are accumulated
+ * in float32 and never materialized per nonzero.
+ */
+array spmm(const COO& a, const array& b, StreamOrDevice s = {});
+array spmm(const CSR& a, const array& b, StreamOrDevice s = {});
+
+/** Multiply a sparse matrix with a dense vector. */
+array spmv(const COO& a, const array& x, StreamOrDevice s = {});
+array spmv(const CSR& a, const array& x, StreamOrDevice s = {});
+
+/**
+ * Sampled dense-dense matrix multiplication. Only the entries of a @ b where
+ * the mask has nonzeros are computed and multiplied by the mask values. The
+ * result has the sparsity of the mask.
+ */
+COO sddmm(
+    const COO& mask,
+    const array& a,
+    const array& b,
+    StreamOrDevice s = {});
+CSR sddmm(
+    const CSR& mask,
+    const array& a,
+    const array& b,
+    StreamOrDevice s = {});
+
+} // namespace mlx::core::sparse
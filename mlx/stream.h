@@ -6,6 +6,9 @@
 
 namespace mlx::core {
 
+/* How eagerly the work of a stream is serviced relative to other streams. */
+enum class StreamPriority { low, normal, high };
+
 struct Stream {
   int index;
   Device device;
@@ -21,6 +24,18 @@ void set_default_stream(Stream s);
 /** Make a new stream on the given device. */
 Stream new_stream(Device d);
 
+/** Make a new stream on the given device with the given priority.
+ *
+ * The thread encoding the work of a high priority stream is scheduled ahead
+ * of the other threads of the process while a low priority one yields to
+ * them. The GPU work of a low priority stream is also committed in smaller
+ * command buffers so the GPU can interleave the work of other streams, for
+ * instance the decoding steps queued while a long prefill runs. */
+Stream new_stream(Device d, StreamPriority priority);
+
+/** Get the priority of the stream. */
+StreamPriority stream_priority(Stream s);
+
 inline bool operator==(const Stream& lhs, const Stream& rhs) {
   return lhs.index == rhs.index;
 }
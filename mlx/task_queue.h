@@ -0,0 +1,228 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mlx::core::scheduler {
+
+/* A move-only callable with inline storage.
+ *
+ * Callables which fit in the buffer and can be moved without throwing are
+ * stored in place so that creating a task does not allocate. Larger ones are
+ * stored on the heap.
+ * */
+class Task {
+ public:
+  static constexpr size_t buffer_size = 64;
+
+  Task() = default;
+
+  template <
+      typename F,
+      typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+  Task(F&& f) {
+    using Fn = std::decay_t<F>;
+    if constexpr (stored_inline<Fn>()) {
+      new (buffer_) Fn(std::forward<F>(f));
+      vtable_ = &inline_vtable<Fn>;
+    } else {
+      *reinterpret_cast<Fn**>(buffer_) = new Fn(std::forward<F>(f));
+      vtable_ = &heap_vtable<Fn>;
+    }
+  }
+
+  Task(Task&& other) noexcept : vtable_(other.vtable_) {
+    if (vtable_) {
+      vtable_->move(buffer_, other.buffer_);
+      other.vtable_ = nullptr;
+    }
+  }
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      vtable_ = other.vtable_;
+      if (vtable_) {
+        vtable_->move(buffer_, other.buffer_);
+        other.vtable_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    reset();
+  }
+
+  void operator()() {
+    vtable_->invoke(buffer_);
+  }
+
+  explicit operator bool() const {
+    return vtable_ != nullptr;
+  }
+
+  /** Destroy the stored callable, releasing anything it captured. */
+  void reset() {
+    if (vtable_) {
+      vtable_->destroy(buffer_);
+      vtable_ = nullptr;
+    }
+  }
+
+ private:
+  struct VTable {
+    void (*invoke)(void*);
+    // Move construct into dst and destroy src
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void*);
+  };
+
+  template <typename Fn>
+  static constexpr bool stored_inline() {
+    return sizeof(Fn) <= buffer_size &&
+        alignof(Fn) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<Fn>;
+  }
+
+  template <typename Fn>
+  static constexpr VTable inline_vtable = {
+      [](void* p) { (*static_cast<Fn*>(p))(); },
+      [](void* dst, void* src) {
+        new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+        static_cast<Fn*>(src)->~Fn();
+      },
+      [](void* p) { static_cast<Fn*>(p)->~Fn(); }};
+
+  template <typename Fn>
+  static constexpr VTable heap_vtable = {
+      [](void* p) { (**static_cast<Fn**>(p))(); },
+      [](void* dst, void* src) {
+        *static_cast<Fn**>(dst) = *static_cast<Fn**>(src);
+      },
+      [](void* p) { delete *static_cast<Fn**>(p); }};
+
+  alignas(std::max_align_t) unsigned char buffer_[buffer_size];
+  const VTable* vtable_{nullptr};
+};
+
+/* An unbounded lock-free queue of tasks with many producers and a single
+ * consumer.
+ *
+ * Producers link their tasks into a chain and publish it with one atomic
+ * exchange, so a batch of tasks pushed with push_many costs the same
+ * synchronization as a single task and is never interleaved with tasks from
+ * other producers. Only one thread may call try_pop and empty.
+ * */
+class TaskQueue {
+ public:
+  TaskQueue() : head_(&stub_), tail_(&stub_) {}
+
+  // Not copyable or moveable
+  TaskQueue(const TaskQueue&) = delete;
+  TaskQueue(TaskQueue&&) = delete;
+  TaskQueue& operator=(const TaskQueue&) = delete;
+  TaskQueue& operator=(TaskQueue&&) = delete;
+
+  ~TaskQueue() {
+    Task task;
+    while (try_pop(task)) {
+    }
+    retire(tail_);
+  }
+
+  void push(Task task) {
+    auto node = new Node;
+    node->task = std::move(task);
+    publish(node, node);
+  }
+
+  void push_many(std::vector<Task> tasks) {
+    if (tasks.empty()) {
+      return;
+    }
+    // The nodes of a batch share one allocation which is freed once the
+    // consumer has moved past all of them.
+    auto block = new NodeBlock(tasks.size());
+    auto& nodes = block->nodes;
+    for (size_t i = 0; i < tasks.size(); i++) {
+      nodes[i].task = std::move(tasks[i]);
+      nodes[i].block = block;
+      if (i > 0) {
+        nodes[i - 1].next.store(&nodes[i], std::memory_order_relaxed);
+      }
+    }
+    publish(&nodes.front(), &nodes.back());
+  }
+
+  /** Pop the oldest task. Returns false if no task is ready. */
+  bool try_pop(Task& task) {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    // The popped node stays in the queue as the new stub
+    tail_ = next;
+    task = std::move(next->task);
+    retire(tail);
+    return true;
+  }
+
+  /* Whether every pushed task has been popped.
+   *
+   * A queue can be non-empty while try_pop fails if a producer is in the
+   * middle of publishing.
+   * */
+  bool empty() const {
+    return head_.load() == tail_;
+  }
+
+ private:
+  struct NodeBlock;
+
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    Task task;
+    NodeBlock* block{nullptr};
+  };
+
+  struct NodeBlock {
+    explicit NodeBlock(size_t n) : nodes(n), remaining(n) {}
+    std::vector<Node> nodes;
+    size_t remaining;
+  };
+
+  void publish(Node* first, Node* last) {
+    Node* prev = head_.exchange(last);
+    prev->next.store(first, std::memory_order_release);
+  }
+
+  void retire(Node* node) {
+    if (node == &stub_) {
+      return;
+    }
+    if (node->block == nullptr) {
+      delete node;
+    } else if (--node->block->remaining == 0) {
+      delete node->block;
+    }
+  }
+
+  Node stub_;
+  std::atomic<Node*> head_;
+  // Only touched by the consumer
+  Node* tail_;
+};
+
+} // namespace mlx::core::scheduler
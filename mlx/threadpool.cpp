@@ -0,0 +1,304 @@
+// Copyright © 2024 Apple Inc.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mlx/scheduler.h"
+#include "mlx/threadpool.h"
+
+namespace mlx::core {
+
+namespace {
+
+thread_local bool is_pool_worker = false;
+thread_local bool is_serial = false;
+
+// The pool of a stream with its own cores, set on the stream's thread
+thread_local std::shared_ptr<ThreadPool> stream_pool;
+
+struct ParallelForState {
+  std::atomic<int> next{0};
+  std::atomic<int> done{0};
+  int n_tasks;
+  const std::function<void(int)>* f;
+  std::mutex mtx;
+  std::condition_variable cond;
+  std::exception_ptr error;
+
+  // Run task first and then claim tasks until there are none left, returns
+  // true if this call finished the last one.
+  bool run(int first) {
+    int n_done = 0;
+    for (int i = first; i < n_tasks; i = next++) {
+      try {
+        (*f)(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      n_done++;
+    }
+    return n_done > 0 && (done += n_done) == n_tasks;
+  }
+};
+
+int default_cpu_threads() {
+  if (const char* buff_str = std::getenv("MLX_CPU_THREADS")) {
+    return std::max(std::atoi(buff_str), 1);
+  }
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+std::vector<int> default_cpu_cores(int num_threads) {
+  std::vector<int> cores;
+  if (const char* buff_str = std::getenv("MLX_CPU_AFFINITY");
+      buff_str && std::atoi(buff_str) != 0) {
+    for (int i = 0; i < num_threads; i++) {
+      cores.push_back(i);
+    }
+  }
+  return cores;
+}
+
+void check_cores(const std::vector<int>& cores, const char* tag) {
+  for (auto c : cores) {
+    if (c < 0) {
+      std::ostringstream msg;
+      msg << "[" << tag << "] Invalid core " << c << ".";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+}
+
+} // namespace
+
+void pin_current_thread(const std::vector<int>& cores) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (cores.empty()) {
+    int n = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    for (int i = 0; i < n && i < CPU_SETSIZE; i++) {
+      CPU_SET(i, &set);
+    }
+  } else {
+    for (auto c : cores) {
+      if (c < CPU_SETSIZE) {
+        CPU_SET(c, &set);
+      }
+    }
+  }
+  // Best effort, a core outside of the process' cpuset is not an error
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cores;
+#endif
+}
+
+ThreadPool::ThreadPool(int num_threads, std::vector<int> cores)
+    : cores_(std::move(cores)) {
+  start(num_threads);
+}
+
+ThreadPool::~ThreadPool() {
+  stop();
+}
+
+void ThreadPool::start(int num_threads) {
+  stop_ = false;
+  // The calling thread is always one of the threads doing the work
+  worker_tasks_.resize(num_threads);
+  for (int i = 1; i < num_threads; i++) {
+    workers_.emplace_back(&ThreadPool::thread_fn, this, i);
+  }
+  size_ = num_threads;
+}
+
+void ThreadPool::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  for (auto& t : workers_) {
+    t.join();
+  }
+  workers_.clear();
+  worker_tasks_.clear();
+}
+
+void ThreadPool::resize(int num_threads) {
+  if (num_threads < 1) {
+    throw std::invalid_argument(
+        "[ThreadPool::resize] The number of threads must be positive.");
+  }
+  std::lock_guard<std::mutex> lk(resize_mtx_);
+  if (num_threads == size()) {
+    return;
+  }
+  stop();
+  start(num_threads);
+}
+
+void ThreadPool::set_cores(std::vector<int> cores) {
+  check_cores(cores, "ThreadPool::set_cores");
+  std::lock_guard<std::mutex> lk(resize_mtx_);
+  int num_threads = size();
+  stop();
+  cores_ = std::move(cores);
+  start(num_threads);
+}
+
+bool ThreadPool::in_worker() {
+  return is_pool_worker;
+}
+
+void ThreadPool::set_serial(bool serial) {
+  is_serial = serial;
+}
+
+void ThreadPool::thread_fn(int index) {
+  is_pool_worker = true;
+  if (!cores_.empty()) {
+    pin_current_thread({cores_[index % cores_.size()]});
+  } else {
+    // Don't inherit the affinity of the thread which started the pool
+    pin_current_thread({});
+  }
+  auto& own_tasks = worker_tasks_[index];
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lk(mtx_);
+      cond_.wait(lk, [this, &own_tasks] {
+        return !own_tasks.empty() || !shared_tasks_.empty() || stop_;
+      });
+      auto& tasks = own_tasks.empty() ? shared_tasks_ : own_tasks;
+      if (tasks.empty() && stop_) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+  }
+}
+
+void ThreadPool::parallel_for(
+    int n_tasks,
+    const std::function<void(int)>& f) {
+  std::unique_lock<std::mutex> resize_lk(resize_mtx_, std::defer_lock);
+  int n_threads = 1;
+  if (n_tasks > 1 && !in_worker() && !is_serial) {
+    resize_lk.lock();
+    n_threads = std::min(n_tasks, size());
+  }
+  if (n_threads <= 1) {
+    if (resize_lk.owns_lock()) {
+      resize_lk.unlock();
+    }
+    for (int i = 0; i < n_tasks; i++) {
+      f(i);
+    }
+    return;
+  }
+
+  auto state = std::make_shared<ParallelForState>();
+  state->n_tasks = n_tasks;
+  state->next = n_threads;
+  state->f = &f;
+
+  // Every helper runs its own task, which the caller waits for, and helpers
+  // exit without touching f once all the others have been claimed, so it's
+  // fine for f to go out of scope once we return.
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (int i = 1; i < n_threads; i++) {
+      worker_tasks_[i].emplace([state, i]() {
+        if (state->run(i)) {
+          std::lock_guard<std::mutex> lk(state->mtx);
+          state->cond.notify_all();
+        }
+      });
+    }
+  }
+  cond_.notify_all();
+  // The queued tasks hold on to the state and a resize drains them first
+  resize_lk.unlock();
+
+  state->run(0);
+  {
+    std::unique_lock<std::mutex> lk(state->mtx);
+    state->cond.wait(lk, [&state] { return state->done == state->n_tasks; });
+  }
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+ThreadPool& cpu_thread_pool() {
+  if (stream_pool) {
+    return *stream_pool;
+  }
+  static ThreadPool pool(
+      default_cpu_threads(), default_cpu_cores(default_cpu_threads()));
+  return pool;
+}
+
+int cpu_threads() {
+  return cpu_thread_pool().size();
+}
+
+void set_cpu_threads(int num_threads) {
+  if (num_threads < 1) {
+    throw std::invalid_argument(
+        "[set_cpu_threads] The number of threads must be positive.");
+  }
+  cpu_thread_pool().resize(num_threads);
+}
+
+void set_cpu_affinity(const std::vector<int>& cores) {
+  check_cores(cores, "set_cpu_affinity");
+  auto& pool = cpu_thread_pool();
+  if (!cores.empty()) {
+    pool.resize(cores.size());
+  }
+  pool.set_cores(cores);
+
+  // The default CPU stream's thread takes the place of worker 0
+  auto s = default_stream(Device::cpu);
+  scheduler::enqueue(s, [core = cores.empty() ? -1 : cores[0]]() {
+    pin_current_thread(core < 0 ? std::vector<int>{} : std::vector<int>{core});
+  });
+}
+
+void set_stream_cpu_cores(const Stream& s, const std::vector<int>& cores) {
+  if (s.device != Device::cpu) {
+    throw std::invalid_argument(
+        "[set_stream_cpu_cores] Only CPU streams can be given cores.");
+  }
+  check_cores(cores, "set_stream_cpu_cores");
+  std::shared_ptr<ThreadPool> pool;
+  if (!cores.empty()) {
+    pool = std::make_shared<ThreadPool>(cores.size(), cores);
+  }
+  // The stream's thread owns the pool from here on, tasks already enqueued
+  // keep running on the previous one
+  scheduler::enqueue(s, [pool = std::move(pool), cores]() mutable {
+    pin_current_thread(cores.empty() ? cores : std::vector<int>{cores[0]});
+    stream_pool = std::move(pool);
+  });
+}
+
+} // namespace mlx::core
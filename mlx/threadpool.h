@@ -0,0 +1,161 @@
+// Copyright © 2024 Apple Inc.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "mlx/stream.h"
+
+namespace mlx::core {
+
+/* A fixed size pool of worker threads.
+ *
+ * Tasks can be enqueued individually or a range of tasks can be run with
+ * parallel_for, in which case the calling thread participates in the work
+ * and returns once every task in the range has completed.
+ *
+ * The workers can be pinned to a list of cores, worker i runs on
+ * cores[i % cores.size()] with the calling thread taking the place of
+ * worker 0.
+ * */
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads, std::vector<int> cores = {});
+  ~ThreadPool();
+
+  // Not copyable or moveable
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+
+  /** The number of threads work can be split across including the caller. */
+  int size() const {
+    return size_;
+  }
+
+  /** Change the number of worker threads. Waits for queued tasks to finish. */
+  void resize(int num_threads);
+
+  /** Pin the workers to cores, an empty list unpins them. Waits for queued
+   * tasks to finish. */
+  void set_cores(std::vector<int> cores);
+
+  /** Whether the workers are pinned to cores. */
+  bool pinned() const {
+    return !cores_.empty();
+  }
+
+  /** Run an arbitrary task on one of the workers. */
+  template <typename F>
+  std::future<void> enqueue(F&& f) {
+    auto task = std::make_shared<std::packaged_task<void()>>(
+        std::forward<F>(f));
+    auto fut = task->get_future();
+    {
+      std::lock_guard<std::mutex> resize_lk(resize_mtx_);
+      if (!workers_.empty()) {
+        {
+          std::lock_guard<std::mutex> lk(mtx_);
+          shared_tasks_.emplace([task]() { (*task)(); });
+        }
+        cond_.notify_one();
+        return fut;
+      }
+    }
+    (*task)();
+    return fut;
+  }
+
+  /** Run f(i) for every i in [0, n_tasks) and block until all are done.
+   *
+   * The first task is run by the caller and task i by worker i for the
+   * first size() tasks, so kernels which split their work into as many
+   * chunks always process a chunk on the same thread. Further tasks are
+   * claimed by whichever thread is free first.
+   *
+   * Calls made from inside a worker run serially on that worker, so kernels
+   * which use the pool can be freely nested.
+   * */
+  void parallel_for(int n_tasks, const std::function<void(int)>& f);
+
+  /** Whether the current thread is one of the pool's workers. */
+  static bool in_worker();
+
+  /** Run the parallel_for calls of the current thread serially, e.g. on
+   * threads which already run work concurrently. */
+  static void set_serial(bool serial);
+
+ private:
+  void start(int num_threads);
+  void stop();
+  void thread_fn(int index);
+
+  std::vector<std::thread> workers_;
+  std::atomic<int> size_{1};
+  std::vector<int> cores_;
+  // Tasks for any worker and tasks for one worker in particular
+  std::queue<std::function<void()>> shared_tasks_;
+  std::vector<std::queue<std::function<void()>>> worker_tasks_;
+  std::mutex mtx_;
+  std::condition_variable cond_;
+  bool stop_{false};
+  // Held while tasks are handed to the workers and while the workers are
+  // replaced, so resizing waits for the queued tasks instead of racing them
+  std::mutex resize_mtx_;
+};
+
+/** Pin the calling thread to a set of cores, an empty set allows every
+ * core. A no-op on platforms without thread affinity. */
+void pin_current_thread(const std::vector<int>& cores);
+
+/* Get the pool used by the CPU backend to split up kernels.
+ *
+ * On the thread of a stream given its own cores with set_stream_cpu_cores
+ * this is the stream's pool.
+ * */
+ThreadPool& cpu_thread_pool();
+
+/* Get the number of threads the CPU backend splits kernels across.
+ *
+ * Defaults to the number of hardware threads and can be overridden with the
+ * MLX_CPU_THREADS environment variable.
+ * */
+int cpu_threads();
+
+/* Set the number of threads the CPU backend splits kernels across.
+ *
+ * A value of 1 runs every kernel on its stream's thread.
+ * */
+void set_cpu_threads(int num_threads);
+
+/* Pin the threads the CPU backend splits kernels across to cores.
+ *
+ * The pool gets one thread per core. Kernels split their work the same way
+ * on every call and large fresh allocations are first touched in the same
+ * chunks, so on NUMA systems the pages of an array end up local to the
+ * threads which process them. An empty list unpins the threads.
+ *
+ * Pinning can also be enabled at startup with MLX_CPU_AFFINITY=1 which pins
+ * the threads to the first cores in order.
+ * */
+void set_cpu_affinity(const std::vector<int>& cores);
+
+/* Run the kernels of a CPU stream on a dedicated set of cores.
+ *
+ * The stream's thread is pinned to cores[0] and splits kernels with its own
+ * pool of threads pinned to the remaining ones, so several CPU streams don't
+ * compete for the same cores and caches. The change applies to tasks
+ * enqueued on the stream afterwards. An empty list returns the stream to
+ * the shared pool.
+ * */
+void set_stream_cpu_cores(const Stream& s, const std::vector<int>& cores);
+
+} // namespace mlx::core
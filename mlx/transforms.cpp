@@ -1,16 +1,27 @@
 // Copyright © 2023-2024 Apple Inc.
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <future>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <stack>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "mlx/backend/metal/metal_impl.h"
+#include "mlx/compile_impl.h"
+#include "mlx/distributed/primitives.h"
+#include "mlx/fast_primitives.h"
+#include "mlx/memory.h"
+#include "mlx/memory_impl.h"
 #include "mlx/ops.h"
 #include "mlx/primitives.h"
+#include "mlx/profiler_impl.h"
 #include "mlx/scheduler.h"
 #include "mlx/transforms.h"
 #include "mlx/transforms_impl.h"
@@ -36,36 +47,234 @@ class Synchronizer : public Primitive {
 // are currently under a function transformation.
 int detail::InTracing::tracing_counter{0};
 
-array eval_impl(std::vector<array> outputs, bool async) {
-  std::queue<array> tape;
+namespace {
 
-  // stream events to use for synchronization
-  std::unordered_map<uint32_t, Event> events;
+// The containers used by eval_impl are kept per thread so that evaluating
+// the small graphs of e.g. decoding one token at a time doesn't allocate
+// them every time. A nested eval on the same thread uses its own.
+struct EvalScratch {
+  std::vector<std::pair<std::reference_wrapper<array>, int>> dfs;
+  std::vector<array> tape;
+  std::unordered_set<uintptr_t> needs_signal;
+  std::vector<std::pair<uint32_t, Event>> events;
+  bool in_use{false};
+
+  void clear() {
+    dfs.clear();
+    tape.clear();
+    needs_signal.clear();
+    events.clear();
+  }
+};
 
-  // Make an effort to choose a good output stream
-  Stream stream = default_stream(default_device());
-  for (auto& o : outputs) {
-    if (o.status() == array::Status::unscheduled && o.has_primitive()) {
-      stream = o.primitive().stream();
-      break;
+class ScratchLease {
+ public:
+  ScratchLease() {
+    thread_local EvalScratch cached;
+    if (cached.in_use) {
+      owned_ = std::make_unique<EvalScratch>();
+      scratch_ = owned_.get();
+    } else {
+      scratch_ = &cached;
     }
+    scratch_->in_use = true;
   }
 
-  std::unordered_set<uintptr_t> needs_signal;
+  ~ScratchLease() {
+    scratch_->clear();
+    scratch_->in_use = false;
+  }
+
+  EvalScratch* operator->() {
+    return scratch_;
+  }
+
+ private:
+  EvalScratch* scratch_;
+  std::unique_ptr<EvalScratch> owned_;
+};
+
+// Each traversal marks the arrays it visits with a new epoch instead of
+// hashing their ids
+uint64_t next_visit_epoch() {
+  static std::atomic<uint64_t> epoch{0};
+  return ++epoch;
+}
+
+size_t output_bytes(const array& a) {
+  size_t nbytes = a.nbytes();
+  for (auto& s : a.siblings()) {
+    nbytes += s.nbytes();
+  }
+  return nbytes;
+}
+
+// Reorder the tape, a topological order ending with the synchronizer, so the
+// inputs of each array which need the most memory to compute come first.
+// This is the Sethi-Ullman order: the intermediates of the larger inputs are
+// freed before the outputs of the smaller ones pile up. The memory an array
+// needs is estimated as if the graph were a tree.
+void order_by_memory(std::vector<array>& tape) {
+  int n = tape.size();
+  std::unordered_map<std::uintptr_t, int> index;
+  for (int i = 0; i < n; i++) {
+    index.emplace(tape[i].id(), i);
+    for (auto& s : tape[i].siblings()) {
+      index.emplace(s.id(), i);
+    }
+  }
+
+  std::vector<size_t> out(n);
+  std::vector<size_t> need(n);
+  std::vector<std::vector<int>> children(n);
+  for (int i = 0; i < n; i++) {
+    out[i] = output_bytes(tape[i]);
+    auto& c = children[i];
+    for (auto& in : tape[i].inputs()) {
+      if (auto it = index.find(in.id()); it != index.end()) {
+        c.push_back(it->second);
+      }
+    }
+    std::sort(c.begin(), c.end());
+    c.erase(std::unique(c.begin(), c.end()), c.end());
+    std::stable_sort(c.begin(), c.end(), [&](int a, int b) {
+      return need[a] - out[a] > need[b] - out[b];
+    });
+    size_t held = 0;
+    for (auto j : c) {
+      need[i] = std::max(need[i], held + need[j]);
+      held += out[j];
+    }
+    need[i] = std::max(need[i], held + out[i]);
+  }
+
+  std::vector<array> ordered;
+  ordered.reserve(n);
+  std::vector<bool> visited(n, false);
+  std::vector<std::pair<int, int>> dfs = {{n - 1, 0}};
+  visited[n - 1] = true;
+  while (!dfs.empty()) {
+    auto& [i, idx] = dfs.back();
+    if (idx < children[i].size()) {
+      int j = children[i][idx++];
+      if (!visited[j]) {
+        visited[j] = true;
+        dfs.emplace_back(j, 0);
+      }
+      continue;
+    }
+    ordered.push_back(std::move(tape[i]));
+    dfs.pop_back();
+  }
+  tape = std::move(ordered);
+}
+
+size_t& cpu_placement_size() {
+  static size_t max_size = []() -> size_t {
+    if (const char* buff_str = std::getenv("MLX_CPU_PLACEMENT_SIZE")) {
+      return std::max(std::atoll(buff_str), 0ll);
+    }
+    return 0;
+  }();
+  return max_size;
+}
+
+// Move the small GPU primitives of the tape whose inputs are already
+// evaluated or computed on the CPU to the default CPU stream. Returns true if
+// any primitive was moved.
+bool place_small_on_cpu(std::vector<array>& tape, size_t max_size) {
+  auto cpu = default_stream(Device::cpu);
+  std::unordered_set<std::uintptr_t> on_gpu;
+  bool moved = false;
+  for (auto& a : tape) {
+    auto& p = a.primitive();
+    bool place = p.device() == Device::gpu && !a.is_tracer();
+
+    // The primitive must not be shared with e.g. a compiled graph and must
+    // have a CPU implementation
+    place &= a.primitive_ptr().use_count() == a.outputs().size();
+    place &= dynamic_cast<fast::Custom*>(&p) == nullptr &&
+        dynamic_cast<distributed::DistPrimitive*>(&p) == nullptr;
+    for (auto& o : a.outputs()) {
+      place &= o.size() <= max_size;
+    }
+    for (auto& in : a.inputs()) {
+      place &= in.size() <= max_size && on_gpu.find(in.id()) == on_gpu.end();
+    }
+    if (place) {
+      p.set_stream(cpu);
+      moved = true;
+    } else if (p.device() == Device::gpu) {
+      for (auto& o : a.outputs()) {
+        on_gpu.insert(o.id());
+      }
+    }
+  }
+  return moved;
+}
+
+} // namespace
+
+namespace detail {
+
+bool skip_cancelled(
+    const array& arr,
+    const std::optional<CancellationToken>& token) {
+  bool skip = token && token->cancelled();
+  for (auto& in : arr.inputs()) {
+    skip |= in.status() == array::Status::unscheduled;
+  }
+  if (skip) {
+    arr.set_status(array::Status::unscheduled);
+    for (auto& s : arr.siblings()) {
+      s.set_status(array::Status::unscheduled);
+    }
+  }
+  return skip;
+}
 
-  auto synchronizer = array(
-      {}, bool_, std::make_shared<Synchronizer>(stream), std::move(outputs));
-  needs_signal.insert(synchronizer.id());
+} // namespace detail
 
-  // Make an event for the synchronizer stream
-  events.emplace(stream.index, Event{stream});
+// Evaluate several independent sets of outputs, the requests, with a single
+// tape and one submission per stream. Each request gets its own synchronizer
+// which comes in the tape right after the part of the graph the request
+// needs and which hasn't been visited for an earlier request, so its event
+// is signaled as soon as that request is done.
+std::vector<array> eval_requests(
+    std::vector<std::vector<array>> requests,
+    bool async,
+    std::optional<CancellationToken> token = std::nullopt) {
+  ScratchLease lease;
+  auto& dfs = lease->dfs;
+  auto& tape = lease->tape;
+  auto& needs_signal = lease->needs_signal;
+  auto& events = lease->events;
+
+  std::vector<array> synchronizers;
+  synchronizers.reserve(requests.size());
+  for (auto& outputs : requests) {
+    // Make an effort to choose a good output stream
+    Stream stream = default_stream(default_device());
+    for (auto& o : outputs) {
+      if (o.status() == array::Status::unscheduled && o.has_primitive()) {
+        stream = o.primitive().stream();
+        break;
+      }
+    }
+    synchronizers.push_back(array(
+        {},
+        bool_,
+        std::make_shared<Synchronizer>(stream),
+        std::move(outputs)));
+    needs_signal.insert(synchronizers.back().id());
+  }
 
-  {
-    std::unordered_set<std::uintptr_t> cache;
-    std::stack<std::pair<std::reference_wrapper<array>, int>> dfs;
-    dfs.emplace(synchronizer, 0);
+  auto epoch = next_visit_epoch();
+  for (auto& synchronizer : synchronizers) {
+    synchronizer.visit(epoch);
+    dfs.emplace_back(synchronizer, 0);
     while (!dfs.empty()) {
-      auto& [a_ref, idx] = dfs.top();
+      auto& [a_ref, idx] = dfs.back();
       auto& a = a_ref.get();
       if (idx < a.inputs().size()) {
         // Add an input, and continue
@@ -101,12 +310,8 @@ array eval_impl(std::vector<array> outputs, bool async) {
           }
         }
 
-        if (cache.find(in.id()) == cache.end()) {
-          dfs.emplace(in, 0);
-          cache.insert(in.id());
-          for (auto& s : in.siblings()) {
-            cache.insert(s.id());
-          }
+        if (in.visit(epoch)) {
+          dfs.emplace_back(in, 0);
         }
         continue;
       }
@@ -116,26 +321,204 @@ array eval_impl(std::vector<array> outputs, bool async) {
         // If the array is evaluated and is no longer a tracer, detach it
         a.detach();
       } else if (a.status() == array::Status::unscheduled) {
-        tape.push(a);
-        // Lookup corresponding event and increment counter
-        auto& stream = a.primitive().stream();
-        auto e = events.find(stream.index);
-        if (e == events.end()) {
-          e = events.emplace(stream.index, Event{stream}).first;
-        }
-        e->second.set_value(e->second.value() + 1);
-        a.attach_event(e->second);
-        for (auto& s : a.siblings()) {
-          s.attach_event(e->second);
+        tape.push_back(a);
+      }
+      dfs.pop_back();
+    }
+  }
+
+  // Move small primitives to the CPU and find the arrays consumed on another
+  // stream again
+  if (size_t max_size = cpu_placement_size();
+      max_size > 0 && place_small_on_cpu(tape, max_size)) {
+    needs_signal.clear();
+    for (auto& synchronizer : synchronizers) {
+      needs_signal.insert(synchronizer.id());
+    }
+    auto find_signals = [&needs_signal](array& a) {
+      auto& stream = a.primitive().stream();
+      for (auto& in : a.inputs()) {
+        if (in.status() == array::Status::unscheduled && in.has_primitive() &&
+            in.primitive().stream() != stream) {
+          needs_signal.insert(in.id());
         }
       }
-      dfs.pop();
+    };
+    for (auto& a : tape) {
+      find_signals(a);
     }
   }
 
-  while (!tape.empty()) {
-    auto arr = std::move(tape.front());
-    tape.pop();
+  // When the outputs of the graph could exceed the memory left under the
+  // limit, order the tape to free intermediates early and bound the GPU
+  // work in flight
+  size_t budget = 0;
+  if (size_t limit = metal::get_memory_limit(); limit > 0) {
+    size_t tape_bytes = 0;
+    for (auto& a : tape) {
+      tape_bytes += output_bytes(a);
+    }
+    size_t active = metal::get_active_memory();
+    size_t available = active < limit ? limit - active : 0;
+    if (tape_bytes > available) {
+      order_by_memory(tape);
+      budget = std::max(available, limit / 4);
+    }
+  }
+
+  // Wraps the tasks of the primitives to record when profiling and to tag
+  // their allocations when tracking memory
+  bool record = profiler::detail::sample_eval();
+  bool track = memory::is_tracking();
+  auto profile = [record, track](const array& arr, scheduler::Task task) {
+    if (record) {
+      task = profiler::detail::record(arr, std::move(task));
+    }
+    if (track) {
+      task = memory::detail::tag(arr, std::move(task));
+    }
+    return task;
+  };
+
+  // Tasks are collected per stream and submitted in one batch per stream once
+  // the whole tape has been visited.
+  std::vector<std::pair<Stream, std::vector<scheduler::Task>>> batches;
+  auto submit = [&batches](const Stream& stream, scheduler::Task task) {
+    auto it = std::find_if(batches.begin(), batches.end(), [&](auto& b) {
+      return b.first == stream;
+    });
+    if (it == batches.end()) {
+      it = batches.emplace(
+          batches.end(), stream, std::vector<scheduler::Task>{});
+    }
+    it->second.push_back(std::move(task));
+  };
+
+  auto make_cpu_task = [&token](array arr, bool signal) {
+    return [arr = std::move(arr), signal, token]() mutable {
+      auto stream = arr.primitive().stream();
+      for (auto& input : arr.inputs()) {
+        if (input.event().valid() && input.event().stream() != stream) {
+          input.event().wait();
+        }
+      }
+      if (detail::skip_cancelled(arr, token)) {
+        if (signal) {
+          arr.event().signal();
+        }
+        return;
+      }
+      scheduler::notify_new_task(stream);
+      auto outputs = arr.outputs();
+      arr.primitive().eval_cpu(arr.inputs(), outputs);
+      if (!arr.is_tracer()) {
+        arr.detach();
+      }
+      if (signal) {
+        arr.event().signal();
+      }
+
+      scheduler::notify_task_completion(stream);
+    };
+  };
+
+  // Runs of consecutive CPU primitives from the same stream are submitted as
+  // a single task which runs them as a graph. Every input from outside the
+  // run comes earlier in the tape so it is either already enqueued on this
+  // stream or on another one.
+  std::vector<array> segment;
+  auto flush_segment = [&segment,
+                        &needs_signal,
+                        &submit,
+                        &make_cpu_task,
+                        &profile]() {
+    if (segment.empty()) {
+      return;
+    }
+    auto stream = segment[0].primitive().stream();
+    if (segment.size() == 1) {
+      bool signal = needs_signal.find(segment[0].id()) != needs_signal.end();
+      submit(stream, profile(segment[0], make_cpu_task(segment[0], signal)));
+      segment.clear();
+      return;
+    }
+    std::unordered_map<std::uintptr_t, int> index;
+    for (int i = 0; i < segment.size(); i++) {
+      for (auto& o : segment[i].outputs()) {
+        index.emplace(o.id(), i);
+      }
+    }
+    std::vector<scheduler::GraphTask> tasks(segment.size());
+    std::vector<Event> signals;
+    for (int i = 0; i < segment.size(); i++) {
+      auto& arr = segment[i];
+      std::unordered_set<int> deps;
+      for (auto& in : arr.inputs()) {
+        if (auto it = index.find(in.id()); it != index.end()) {
+          deps.insert(it->second);
+        }
+      }
+      for (auto d : deps) {
+        tasks[d].successors.push_back(i);
+      }
+      tasks[i].n_deps = deps.size();
+      for (auto& in : arr.inputs()) {
+        if (in.event().valid() && in.event().stream() != stream) {
+          tasks[i].waits.push_back(in.event());
+        }
+      }
+      // Events are signaled in order once the whole segment is done since
+      // signaling sets the event's value
+      if (needs_signal.find(arr.id()) != needs_signal.end()) {
+        signals.push_back(arr.event());
+      }
+      tasks[i].fn = profile(arr, make_cpu_task(arr, false));
+    }
+    segment.clear();
+    submit(
+        stream,
+        [tasks = std::move(tasks), signals = std::move(signals)]() mutable {
+          scheduler::run_graph(std::move(tasks));
+          for (auto& e : signals) {
+            e.signal();
+          }
+        });
+  };
+  bool graph_scheduling = scheduler::graph_scheduling();
+
+  // Enqueue the tasks so far and wait for the GPU streams to finish them,
+  // which releases the buffers their command buffers hold on to
+  size_t gpu_pending_bytes = 0;
+  auto throttle = [&]() {
+    flush_segment();
+    for (auto& [stream, tasks] : batches) {
+      scheduler::enqueue_many(stream, std::move(tasks));
+    }
+    for (auto& [stream, tasks] : batches) {
+      if (stream.device == Device::gpu) {
+        synchronize(stream);
+      }
+    }
+    batches.clear();
+    gpu_pending_bytes = 0;
+  };
+
+  for (auto& arr_ref : tape) {
+    auto arr = std::move(arr_ref);
+
+    // Lookup corresponding event and increment counter
+    auto stream = arr.primitive().stream();
+    auto e = std::find_if(events.begin(), events.end(), [&](auto& e) {
+      return e.first == stream.index;
+    });
+    if (e == events.end()) {
+      e = events.emplace(events.end(), stream.index, Event{stream});
+    }
+    e->second.set_value(e->second.value() + 1);
+    arr.attach_event(e->second);
+    for (auto& s : arr.siblings()) {
+      s.attach_event(e->second);
+    }
 
     // Set the status of the array and siblings.
     auto status = async ? array::Status::scheduled : array::Status::available;
@@ -144,7 +527,6 @@ array eval_impl(std::vector<array> outputs, bool async) {
       s.set_status(status);
     }
 
-    auto stream = arr.primitive().stream();
     std::vector<std::shared_future<void>> arr_deps;
     bool signal = needs_signal.find(arr.id()) != needs_signal.end();
 
@@ -152,39 +534,237 @@ array eval_impl(std::vector<array> outputs, bool async) {
       if (!metal::is_available()) {
         throw std::runtime_error("Metal GPU is not available.");
       }
-      scheduler::enqueue(stream, metal::make_task(std::move(arr), signal));
-    } else {
-      auto task = [arr = std::move(arr), stream, signal]() mutable {
-        for (auto& input : arr.inputs()) {
-          if (input.event().valid() &&
-              input.event().stream() != arr.primitive().stream()) {
-            input.event().wait();
-          }
-        }
-        scheduler::notify_new_task(stream);
-        auto outputs = arr.outputs();
-        arr.primitive().eval_cpu(arr.inputs(), outputs);
-        if (!arr.is_tracer()) {
-          arr.detach();
-        }
-        if (signal) {
-          arr.event().signal();
+      if (budget > 0) {
+        gpu_pending_bytes += output_bytes(arr);
+        if (gpu_pending_bytes > budget) {
+          throttle();
         }
+      }
+      flush_segment();
+      submit(stream, profile(arr, metal::make_task(arr, signal, token)));
+    } else if (graph_scheduling || arr.inputs().empty()) {
+      // Primitives without inputs, e.g. loads, are independent of each other
+      // so they are always grouped
+      if (!segment.empty() && segment.back().primitive().stream() != stream) {
+        flush_segment();
+      }
+      segment.push_back(std::move(arr));
+    } else {
+      flush_segment();
+      submit(stream, profile(arr, make_cpu_task(arr, signal)));
+    }
+  }
+  flush_segment();
+  for (auto& [stream, tasks] : batches) {
+    scheduler::enqueue_many(stream, std::move(tasks));
+  }
+  return synchronizers;
+}
+
+array eval_impl(
+    std::vector<array> outputs,
+    bool async,
+    std::optional<CancellationToken> token = std::nullopt) {
+  std::vector<std::vector<array>> requests;
+  requests.push_back(std::move(outputs));
+  return std::move(
+      eval_requests(std::move(requests), async, std::move(token))[0]);
+}
+
+namespace {
+
+// Detach the outputs which are already evaluated and return true if there is
+// nothing else to do
+bool all_available(std::vector<array>& outputs) {
+  for (auto& o : outputs) {
+    if (o.status() != array::Status::available) {
+      return false;
+    }
+  }
+  for (auto& o : outputs) {
+    if (!o.is_tracer() && o.has_primitive()) {
+      o.detach();
+    }
+  }
+  return true;
+}
 
-        scheduler::notify_task_completion(stream);
-      };
-      scheduler::enqueue(stream, std::move(task));
+// Wait for the synchronizer of an evaluation and throw if it was cancelled,
+// in which case the synchronizer was skipped and kept its inputs
+void wait_for_eval(const array& synchronizer) {
+  synchronizer.event().wait();
+  for (auto& o : synchronizer.inputs()) {
+    if (o.status() == array::Status::unscheduled) {
+      throw std::runtime_error("[eval] The evaluation was cancelled.");
     }
   }
-  return synchronizer;
 }
 
+} // namespace
+
 void async_eval(std::vector<array> outputs) {
+  if (all_available(outputs)) {
+    return;
+  }
   eval_impl(std::move(outputs), true);
 }
 
 void eval(std::vector<array> outputs) {
-  eval_impl(std::move(outputs), false).event().wait();
+  if (all_available(outputs)) {
+    return;
+  }
+  wait_for_eval(eval_impl(std::move(outputs), false));
+}
+
+void set_cpu_placement_size(size_t max_size) {
+  cpu_placement_size() = max_size;
+}
+
+void async_eval(std::vector<array> outputs, CancellationToken token) {
+  if (all_available(outputs)) {
+    return;
+  }
+  eval_impl(std::move(outputs), true, std::move(token));
+}
+
+std::vector<Event> async_eval_batch(std::vector<std::vector<array>> requests) {
+  if (requests.empty()) {
+    return {};
+  }
+  std::vector<Event> events;
+  events.reserve(requests.size());
+  for (auto& s : eval_requests(std::move(requests), true)) {
+    events.push_back(s.event());
+  }
+  return events;
+}
+
+void eval(std::vector<array> outputs, CancellationToken token) {
+  if (all_available(outputs)) {
+    return;
+  }
+  wait_for_eval(eval_impl(std::move(outputs), false, std::move(token)));
+}
+
+void eval(std::vector<array> outputs, std::chrono::milliseconds timeout) {
+  CancellationToken token;
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool done = false;
+  std::thread timer([&]() {
+    std::unique_lock<std::mutex> lk(mtx);
+    if (!cv.wait_for(lk, timeout, [&]() { return done; })) {
+      token.cancel();
+    }
+  });
+  auto stop_timer = [&]() {
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      done = true;
+    }
+    cv.notify_one();
+    timer.join();
+  };
+  try {
+    eval(std::move(outputs), token);
+  } catch (...) {
+    stop_timer();
+    if (token.cancelled()) {
+      throw std::runtime_error("[eval] The evaluation timed out.");
+    }
+    throw;
+  }
+  stop_timer();
+}
+
+size_t& checkpoint_budget() {
+  static size_t checkpoint_budget_ = 0;
+  return checkpoint_budget_;
+}
+
+void set_checkpoint_budget(size_t bytes) {
+  checkpoint_budget() = bytes;
+}
+
+// The relative cost of recomputing the output of a primitive in the backward
+// pass, or -1 if it should never be recomputed
+int recompute_cost(const Primitive& p) {
+  if (is_fusable(p) || typeid(p) == typeid(Reshape) ||
+      typeid(p) == typeid(Transpose) || typeid(p) == typeid(Slice) ||
+      typeid(p) == typeid(Compiled)) {
+    return 0;
+  }
+  if (typeid(p) == typeid(Reduce) || typeid(p) == typeid(ArgReduce) ||
+      typeid(p) == typeid(Softmax) || typeid(p) == typeid(LogSumExp) ||
+      typeid(p) == typeid(Concatenate) || typeid(p) == typeid(Pad) ||
+      typeid(p) == typeid(Gather) || typeid(p) == typeid(fast::RMSNorm) ||
+      typeid(p) == typeid(fast::LayerNorm) || typeid(p) == typeid(fast::RoPE)) {
+    return 1;
+  }
+  if (typeid(p) == typeid(Matmul) || typeid(p) == typeid(AddMM) ||
+      typeid(p) == typeid(BlockMaskedMM) || typeid(p) == typeid(GatherMM) ||
+      typeid(p) == typeid(SparseMM) || typeid(p) == typeid(SampledMM) ||
+      typeid(p) == typeid(Sparse24Matmul) || typeid(p) == typeid(Fp8Matmul) ||
+      typeid(p) == typeid(QuantizedMatmul) ||
+      typeid(p) == typeid(GatherQMM) || typeid(p) == typeid(Convolution) ||
+      typeid(p) == typeid(fast::ScaledDotProductAttention)) {
+    return 2;
+  }
+  return -1;
+}
+
+// Choose the intermediates of the tape to discard after the forward pass so
+// that the ones kept for the backward pass fit in the checkpoint budget.
+// Cheap to recompute intermediates are discarded first and the largest
+// first within the same cost.
+std::unordered_set<std::uintptr_t> plan_checkpoints(
+    const std::vector<array>& tape,
+    const std::unordered_set<std::uintptr_t>& calc_grad,
+    const std::unordered_set<std::uintptr_t>& kept,
+    size_t budget) {
+  std::unordered_set<std::uintptr_t> saved;
+  std::vector<std::pair<int, array>> candidates;
+  size_t saved_bytes = 0;
+  auto add = [&](const array& x) {
+    if (calc_grad.find(x.id()) == calc_grad.end() ||
+        kept.find(x.id()) != kept.end() || !x.has_primitive() ||
+        !saved.insert(x.id()).second) {
+      return;
+    }
+    saved_bytes += x.nbytes();
+    if (int cost = recompute_cost(x.primitive());
+        cost >= 0 && x.siblings().empty()) {
+      candidates.emplace_back(cost, x);
+    }
+  };
+  for (auto& a : tape) {
+    for (auto& in : a.inputs()) {
+      add(in);
+    }
+    for (auto& out : a.outputs()) {
+      add(out);
+    }
+  }
+
+  std::unordered_set<std::uintptr_t> discard;
+  if (saved_bytes <= budget) {
+    return discard;
+  }
+  std::stable_sort(
+      candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        if (a.first != b.first) {
+          return a.first < b.first;
+        }
+        return a.second.nbytes() > b.second.nbytes();
+      });
+  for (auto& [_, x] : candidates) {
+    if (saved_bytes <= budget) {
+      break;
+    }
+    discard.insert(x.id());
+    saved_bytes -= x.nbytes();
+  }
+  return discard;
 }
 
 std::pair<std::vector<array>, std::vector<array>> vjp(
@@ -290,6 +870,45 @@ std::pair<std::vector<array>, std::vector<array>> vjp(
     recurse(out);
   }
 
+  // Over the checkpoint budget, the backward pass uses copies of the
+  // discarded intermediates that are recomputed from the kept ones
+  std::unordered_set<std::uintptr_t> discard;
+  if (auto budget = checkpoint_budget(); budget > 0) {
+    std::unordered_set<std::uintptr_t> kept;
+    for (auto& p : primals_) {
+      kept.insert(p.id());
+    }
+    for (auto& o : outputs) {
+      kept.insert(o.id());
+    }
+    discard = plan_checkpoints(tape, calc_grad, kept, budget);
+  }
+  // The kept arrays a recomputation starts from are chained on the
+  // cotangents of the primitive which first needs it, as in checkpoint, so
+  // that it is computed in the backward pass and not along with the
+  // forward pass
+  std::unordered_map<std::uintptr_t, array> recomputed;
+  std::function<array(const array&, const std::vector<array>&)> recompute;
+  recompute = [&](const array& x, const std::vector<array>& cotans) -> array {
+    if (discard.find(x.id()) == discard.end()) {
+      return x;
+    }
+    if (auto it = recomputed.find(x.id()); it != recomputed.end()) {
+      return it->second;
+    }
+    std::vector<array> inputs;
+    for (auto& in : x.inputs()) {
+      if (discard.find(in.id()) == discard.end()) {
+        inputs.push_back(depends({in}, cotans)[0]);
+      } else {
+        inputs.push_back(recompute(in, cotans));
+      }
+    }
+    auto r = array(x.shape(), x.dtype(), x.primitive_ptr(), std::move(inputs));
+    recomputed.emplace(x.id(), r);
+    return r;
+  };
+
   // Run the tape backwards, computing vector-jacobian
   // products for each primitive
   std::unordered_map<std::uintptr_t, array> cotan_map;
@@ -331,7 +950,14 @@ std::pair<std::vector<array>, std::vector<array>> vjp(
       }
     }
 
-    auto vjps = a.primitive().vjp(a.inputs(), cotangents, argnums, outputs);
+    std::vector<array> inputs;
+    for (auto& in : a.inputs()) {
+      inputs.push_back(recompute(in, cotangents));
+    }
+    for (auto& o : outputs) {
+      o = recompute(o, cotangents);
+    }
+    auto vjps = a.primitive().vjp(inputs, cotangents, argnums, outputs);
     // Accumulate the vector-jacobian products for each input
     for (int i = 0; i < argnums.size(); ++i) {
       auto in_id = a.inputs()[argnums[i]].id();
@@ -543,6 +1169,34 @@ ValueAndGradFn value_and_grad(
   };
 }
 
+ValueAndGradFn cached_value_and_grad(
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    const std::vector<int>& argnums) {
+  // Compile the values and gradients as one flat list under an id which
+  // lives as long as the returned function
+  struct CacheId {
+    ~CacheId() {
+      detail::compile_erase(reinterpret_cast<std::uintptr_t>(this));
+    }
+  };
+  auto id = std::make_shared<CacheId>();
+  auto vg = value_and_grad(fun, argnums);
+  auto compiled = detail::compile(
+      [vg](const std::vector<array>& inputs) {
+        auto [outputs, grads] = vg(inputs);
+        outputs.insert(outputs.end(), grads.begin(), grads.end());
+        return outputs;
+      },
+      reinterpret_cast<std::uintptr_t>(id.get()));
+  int n_grads = argnums.size();
+  return [compiled, id, n_grads](const std::vector<array>& inputs) {
+    auto outputs = compiled(inputs);
+    std::vector<array> grads(outputs.end() - n_grads, outputs.end());
+    outputs.erase(outputs.end() - n_grads, outputs.end());
+    return std::make_pair(std::move(outputs), std::move(grads));
+  };
+}
+
 namespace detail {
 
 std::pair<std::vector<array>, std::vector<array>> vmap_trace(
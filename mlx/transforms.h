@@ -2,7 +2,10 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "mlx/array.h"
+#include "mlx/cancellation.h"
 
 namespace mlx::core {
 
@@ -10,11 +13,54 @@ void async_eval(std::vector<array> outputs);
 
 void eval(std::vector<array> outputs);
 
+/** Evaluate the outputs asynchronously unless the token is cancelled first.
+ * Waiting for an output whose evaluation was cancelled throws. */
+void async_eval(std::vector<array> outputs, CancellationToken token);
+
+/** Evaluate the outputs unless the token is cancelled first, in which case
+ * it throws once the work already started is done. */
+void eval(std::vector<array> outputs, CancellationToken token);
+
+/** Evaluate the outputs, cancelling the evaluation and throwing if it takes
+ * longer than the timeout. */
+void eval(std::vector<array> outputs, std::chrono::milliseconds timeout);
+
+/** Evaluate several independent sets of outputs asynchronously.
+ *
+ * Meant for serving many requests at once, the graphs of all the requests
+ * are evaluated as a single one with one submission per stream instead of
+ * one per request. An event is returned for each request, in order, which is
+ * signaled as soon as the outputs of that request are computed, so that they
+ * can be returned while the later requests are still running. */
+std::vector<Event> async_eval_batch(std::vector<std::vector<array>> requests);
+
 template <typename... Arrays, typename = enable_for_arrays_t<Arrays...>>
 void eval(Arrays&&... outputs) {
   eval(std::vector<array>{std::forward<Arrays>(outputs)...});
 }
 
+/** Run independent CPU primitives of a graph concurrently.
+ *
+ * By default the primitives on a CPU stream run one at a time in stream
+ * order, when enabled primitives which don't depend on each other are
+ * instead run concurrently on a work-stealing pool with cpu_threads()
+ * workers. Setting the environment variable ``MLX_CPU_GRAPH_SCHEDULING``
+ * also enables it.
+ */
+void set_cpu_graph_scheduling(bool enabled);
+
+/** Run small GPU primitives on the CPU instead.
+ *
+ * A primitive is moved to the default CPU stream when it and its inputs have
+ * at most max_size elements and none of its inputs are still to be computed
+ * on the GPU in the same eval. This saves the command encoding of shape
+ * bookkeeping, loss scalars and the like which are then often read on the
+ * host anyway. With unified memory the inputs are read in place. A max_size
+ * of 0, the default, disables the placement. The environment variable
+ * ``MLX_CPU_PLACEMENT_SIZE`` also sets it.
+ */
+void set_cpu_placement_size(size_t max_size);
+
 /**
  *  Computes the output and vector-Jacobian product (VJP) of a function.
  *
@@ -72,6 +118,17 @@ ValueAndGradFn value_and_grad(
     const std::function<std::vector<array>(const std::vector<array>&)>& fun,
     const std::vector<int>& argnums);
 
+/**
+ *  Like value_and_grad but the traced forward and backward graph is kept in
+ *  the compile cache for each set of input shapes and types, so repeated calls
+ *  skip tracing the function and building the VJP graph. As with compile the
+ *  function must be pure, arrays it closes over are captured when it is
+ *  traced. When compilation is disabled this is the same as value_and_grad.
+ **/
+ValueAndGradFn cached_value_and_grad(
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    const std::vector<int>& argnums);
+
 /**
  *  Returns a function which computes the value and gradient of the input
  *  function with respect to a single input array.
@@ -196,4 +253,13 @@ std::function<std::vector<array>(const std::vector<array>&)> custom_vjp(
 std::function<std::vector<array>(const std::vector<array>&)> checkpoint(
     std::function<std::vector<array>(const std::vector<array>&)> fun);
 
+/**
+ * Set the memory budget in bytes for the intermediates kept for the backward
+ * pass of vjp, grad and value_and_grad. When more are needed, the cheapest to
+ * recompute (elementwise and shape operations first, matrix multiplications
+ * last) are discarded after the forward pass and recomputed in the backward
+ * pass. A budget of 0, the default, keeps all of them.
+ */
+void set_checkpoint_budget(size_t bytes);
+
 } // namespace mlx::core
@@ -22,7 +22,8 @@ std::function<std::vector<array>(const std::vector<array>&)> compile(
     const std::function<std::vector<array>(const std::vector<array>&)>& fun,
     std::uintptr_t fun_id,
     bool shapeless = false,
-    std::vector<uint64_t> constants = {});
+    std::vector<uint64_t> constants = {},
+    std::vector<int> donate_argnums = {});
 
 // Erase cached compile functions
 void compile_erase(std::uintptr_t fun_id);
@@ -7,6 +7,10 @@
 #include <cstdint>
 #include <vector>
 
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
 #define __MLX_HALF_NAN__ 0x7D00
 
 namespace mlx::core {
@@ -39,6 +43,9 @@ struct _MLX_Float16 {
 
   // From float32
   _MLX_Float16(const float& x) : bits_(0) {
+#if defined(__F16C__)
+    bits_ = _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT);
+#else
     // Conversion following
     // https://github.com/Maratyszcza/FP16/blob/master/include/fp16/fp16.h
 
@@ -81,10 +88,14 @@ struct _MLX_Float16 {
       // Combine sign, exp and mantissa
       bits_ = (x_sign_16 | uint16_t(x_expo_16 + x_mant_16));
     }
+#endif
   }
 
   // To float32
   operator float() const {
+#if defined(__F16C__)
+    return _cvtsh_ss(bits_);
+#else
     // Conversion following
     // https://github.com/Maratyszcza/FP16/blob/master/include/fp16/fp16.h
 
@@ -112,6 +123,7 @@ struct _MLX_Float16 {
     out.u |= x_sign_32;
 
     return out.f;
+#endif
   }
 };
 
@@ -30,9 +30,7 @@ class Dropout(Module):
         if self._p_1 == 1 or not self.training:
             return x
 
-        mask = mx.random.bernoulli(self._p_1, x.shape)
-
-        return (1 / self._p_1) * mask * x
+        return mx.random.dropout(x, 1 - self._p_1)
 
 
 class Dropout2d(Module):
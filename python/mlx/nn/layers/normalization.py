@@ -58,8 +58,7 @@ class InstanceNorm(Module):
     def __call__(self, x: mx.array) -> mx.array:
         reduction_axes = tuple(range(1, x.ndim - 1))
         # Compute stats
-        mean = mx.mean(x, axis=reduction_axes, keepdims=True)
-        var = mx.var(x, axis=reduction_axes, keepdims=True)
+        mean, var = mx.fast.mean_var(x, axis=reduction_axes, keepdims=True)
         # Normalize
         x = (x - mean) * mx.rsqrt(var + self.eps)
         # Scale and shift if necessary
@@ -196,46 +195,17 @@ class GroupNorm(Module):
             f"affine={'weight' in self}, pytorch_compatible={self.pytorch_compatible}"
         )
 
-    def _pytorch_compatible_group_norm(self, x):
-        num_groups = self.num_groups
-        batch, *rest, dims = x.shape
-
-        # Split into groups
-        x = x.reshape(batch, -1, num_groups, dims // num_groups)
-        x = x.transpose(0, 1, 3, 2).reshape(batch, -1, num_groups)
-
-        # Normalize
-        means = mx.mean(x, axis=1, keepdims=True)
-        var = mx.var(x, axis=1, keepdims=True)
-        x = (x - means) * mx.rsqrt(var + self.eps)
-        x = x.reshape(batch, -1, dims // num_groups, num_groups)
-        x = x.transpose(0, 1, 3, 2).reshape(batch, *rest, dims)
-
-        return x
-
-    def _group_norm(self, x):
-        num_groups = self.num_groups
-        batch, *rest, dims = x.shape
-
-        # Split into groups
-        x = x.reshape(batch, -1, num_groups)
-
-        # Normalize
-        means = mx.mean(x, axis=1, keepdims=True)
-        var = mx.var(x, axis=1, keepdims=True)
-        x = (x - means) * mx.rsqrt(var + self.eps)
-        x = x.reshape(batch, *rest, dims)
-
-        return x
-
     def __call__(self, x):
-        group_norm = (
-            self._pytorch_compatible_group_norm
-            if self.pytorch_compatible
-            else self._group_norm
+        weight = self.weight if "weight" in self else None
+        bias = self.bias if "bias" in self else None
+        return mx.fast.group_norm(
+            x,
+            weight,
+            bias,
+            self.num_groups,
+            self.eps,
+            pytorch_compatible=self.pytorch_compatible,
         )
-        x = group_norm(x)
-        return (self.weight * x + self.bias) if "weight" in self else x
 
 
 class BatchNorm(Module):
@@ -329,8 +299,7 @@ class BatchNorm(Module):
         """
         reduction_axes = tuple(range(0, x.ndim - 1))
 
-        mean = mx.mean(x, axis=reduction_axes)
-        var = mx.var(x, axis=reduction_axes)
+        mean, var = mx.fast.mean_var(x, axis=reduction_axes)
 
         return mean, var
 
@@ -349,16 +318,17 @@ class BatchNorm(Module):
                 f"Expected input tensor to have 2, 3 or 4 dimensions, but got {x.ndim}"
             )
 
-        # Calculate the mean and variance used to normalize the input x. If we
-        # are in training mode update the running stats if needed.
-        mean, var = self._calc_stats(x)
-        if self.training and self.track_running_stats:
-            mu = self.momentum
-            self.running_mean = (1 - mu) * self.running_mean + mu * mean
-            self.running_var = (1 - mu) * self.running_var + mu * var
-        elif self.track_running_stats:
-            mean = self.running_mean
-            var = self.running_var
-
-        x = (x - mean) * mx.rsqrt(var + self.eps)
+        # In training mode normalize with the batch statistics and update the
+        # running stats if needed. Otherwise use the running stats.
+        if self.training or not self.track_running_stats:
+            if self.track_running_stats:
+                mean, var = self._calc_stats(x)
+                mu = self.momentum
+                self.running_mean = (1 - mu) * self.running_mean + mu * mean
+                self.running_var = (1 - mu) * self.running_var + mu * var
+            weight = self.weight if "weight" in self else None
+            bias = self.bias if "bias" in self else None
+            return mx.fast.batch_norm(x, weight, bias, self.eps)
+
+        x = (x - self.running_mean) * mx.rsqrt(self.running_var + self.eps)
         return (self.weight * x + self.bias) if "weight" in self else x
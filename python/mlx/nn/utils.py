@@ -1,9 +1,10 @@
 # Copyright © 2023-2024 Apple Inc.
 
 from functools import wraps
-from typing import Callable
+from typing import Any, Callable, Optional, Sequence, Union
 
 import mlx.core as mx
+from mlx.utils import tree_flatten, tree_unflatten
 
 from .layers.base import Module
 
@@ -68,3 +69,143 @@ def checkpoint(module: Module, fn: Callable = None):
         return checkpointed_fn(module.trainable_parameters(), *args, **kwargs)
 
     return wrapped_checkpointed_fn
+
+
+def compile_bucketed(
+    fn: Callable,
+    in_axes: Sequence[Optional[int]],
+    out_axes: Union[None, int, Sequence[Optional[int]]] = None,
+    buckets: Optional[Sequence[int]] = None,
+    pad_value: float = 0,
+):
+    """Compile ``fn`` for a bounded set of sizes of a dynamic axis.
+
+    The inputs are padded along their dynamic axis to the smallest bucket
+    that fits them so ``fn`` is traced once per bucket rather than once per
+    size. The padded function is called with an extra last argument, a
+    boolean ``mask`` of the bucket size which is ``True`` for the valid
+    positions, and it is responsible for ignoring the padding, for instance
+    in attention or reductions over the dynamic axis.
+
+    Args:
+        fn (Callable): The function to compile. It is called as
+          ``fn(*args, mask)``.
+        in_axes (tuple(int or None)): The dynamic axis of each positional
+          argument or ``None`` if the argument is not padded. All the dynamic
+          axes must have the same size.
+        out_axes (int or tuple(int or None), optional): The dynamic axis of
+          the outputs which are sliced back to the input size. If a single
+          int it applies to every output. Default: ``None`` which returns
+          the padded outputs.
+        buckets (tuple(int), optional): The increasing bucket sizes. Sizes
+          larger than the last bucket are not padded. Default: ``None`` which
+          uses the powers of two.
+        pad_value (float, optional): The value of the padding. Default: ``0``.
+
+    Returns:
+        A callable with the same positional arguments as ``fn`` without the
+        mask.
+    """
+    compiled_fn = mx.compile(fn)
+
+    def bucket_size(n):
+        if buckets is None:
+            return 1 << max(n - 1, 0).bit_length()
+        for b in buckets:
+            if b >= n:
+                return b
+        return n
+
+    def pad(x, axis, size):
+        axis = axis % x.ndim
+        n = x.shape[axis]
+        if n == size:
+            return x
+        widths = [(0, 0)] * x.ndim
+        widths[axis] = (0, size - n)
+        return mx.pad(x, widths, constant_values=pad_value)
+
+    def unpad(x, axis, n):
+        if axis is None:
+            return x
+        axis = axis % x.ndim
+        return x[(slice(None),) * axis + (slice(0, n),)]
+
+    @wraps(fn)
+    def wrapped_fn(*args):
+        if len(args) != len(in_axes):
+            raise ValueError(
+                f"[compile_bucketed] Expected {len(in_axes)} arguments but "
+                f"received {len(args)}."
+            )
+        sizes = {x.shape[ax] for x, ax in zip(args, in_axes) if ax is not None}
+        if len(sizes) != 1:
+            raise ValueError(
+                "[compile_bucketed] The dynamic axes of the inputs must have "
+                f"a single size but got {sorted(sizes)}."
+            )
+        n = sizes.pop()
+        size = bucket_size(n)
+        args = [x if ax is None else pad(x, ax, size) for x, ax in zip(args, in_axes)]
+        mask = mx.arange(size) < n
+        outputs = compiled_fn(*args, mask)
+
+        if out_axes is None:
+            return outputs
+        if isinstance(outputs, mx.array):
+            axis = out_axes if isinstance(out_axes, int) else out_axes[0]
+            return unpad(outputs, axis, n)
+        if isinstance(out_axes, int):
+            axes = [out_axes] * len(outputs)
+        else:
+            axes = out_axes
+        return type(outputs)(unpad(x, ax, n) for x, ax in zip(outputs, axes))
+
+    return wrapped_fn
+
+
+def average_gradients(
+    gradients: Any,
+    group: Optional[mx.distributed.Group] = None,
+    bucket_size: int = 32 * 1024**2,
+    communication_type: Optional[mx.Dtype] = None,
+):
+    """Average the gradients across the distributed processes.
+
+    The gradients are packed into buckets of at most ``bucket_size`` bytes
+    which are summed with one communication each, see
+    :func:`mlx.core.distributed.all_sum_bucketed`.
+
+    Setting ``communication_type`` to ``mx.float16`` or ``mx.bfloat16`` sends
+    the gradients in that type, which halves the communication of ``float32``
+    gradients, while still accumulating them in ``float32``.
+
+    Args:
+        gradients (Any): The Python tree containing the gradients. It should
+            have the same structure across processes.
+        group (Optional[mlx.core.distributed.Group]): The group of processes to
+            average the gradients over. If set to ``None`` the global group is
+            used. Default: ``None``.
+        bucket_size (int): The maximum size in bytes of a bucket. Default:
+            ``32 MiB``.
+        communication_type (Optional[mlx.core.Dtype]): The type to
+            communicate the gradients in. If set to ``None`` they are sent as
+            they are. Default: ``None``.
+
+    Returns:
+        The tree of the averaged gradients.
+    """
+    group = group or mx.distributed.init()
+    N = group.size()
+    if N == 1:
+        return gradients
+
+    flat = tree_flatten(gradients)
+    keys = [k for k, _ in flat]
+    sums = mx.distributed.all_sum_bucketed(
+        [v for _, v in flat],
+        bucket_size=bucket_size,
+        group=group,
+        communication_type=communication_type,
+    )
+    return tree_unflatten([(k, s / N) for k, s in zip(keys, sums)])
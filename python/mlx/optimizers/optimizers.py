@@ -84,8 +84,30 @@ class Optimizer:
         # Increment the step
         self.state["step"] = self.step + 1
 
-        # Apply the update
-        return tree_map(self.apply_single, gradients, parameters, self.state)
+        # Apply the update to all the parameters at once
+        leaves = []
+        tree_map(lambda *x: leaves.append(x), gradients, parameters, self.state)
+        if len(leaves) == 0:
+            return tree_map(lambda g: g, gradients)
+        updated = iter(self.apply_multi(*map(list, zip(*leaves))))
+        return tree_map(lambda _: next(updated), gradients)
+
+    def apply_multi(self, gradients: list, parameters: list, states: list):
+        """Applies the update to lists of gradients, parameters and states.
+
+        By default :meth:`apply_single` is called for each parameter.
+        Optimizers with a fused update of many parameters, like :class:`Adam`,
+        override it.
+
+        Args:
+            gradients (list(mx.array)): The gradients of the parameters.
+            parameters (list(mx.array)): The parameters to update.
+            states (list(dict)): The optimizer's state of each parameter.
+
+        Returns:
+            list(mx.array): The updated parameters.
+        """
+        return list(map(self.apply_single, gradients, parameters, states))
 
     def apply_single(self, gradient: mx.array, parameter: mx.array, state: dict):
         """To be extended by derived classes to implement the optimizer's update.
@@ -429,6 +451,32 @@ class Adam(Optimizer):
 
         return parameter - lr * m / (mx.sqrt(v) + eps)
 
+    def apply_multi(self, gradients: list, parameters: list, states: list):
+        """Performs the Adam update of all the parameters with one fused
+        kernel, see :func:`mlx.core.fast.adam_update`."""
+        # Subclasses with their own update go through apply_single
+        if type(self).apply_single is not Adam.apply_single:
+            return super().apply_multi(gradients, parameters, states)
+        return self._fused_update(gradients, parameters, states, 0.0)
+
+    def _fused_update(self, gradients, parameters, states, weight_decay):
+        b1, b2 = self.betas
+        parameters, m, v = mx.fast.adam_update(
+            parameters,
+            gradients,
+            [s["m"] for s in states],
+            [s["v"] for s in states],
+            self.learning_rate,
+            beta1=b1,
+            beta2=b2,
+            eps=self.eps,
+            weight_decay=weight_decay,
+        )
+        for s, m_i, v_i in zip(states, m, v):
+            s["m"] = m_i
+            s["v"] = v_i
+        return parameters
+
 
 class AdamW(Adam):
     r"""The AdamW optimizer [1].
@@ -477,6 +525,13 @@ class AdamW(Adam):
             gradient, parameter * (1 - lr * self.weight_decay), state
         )
 
+    def apply_multi(self, gradients: list, parameters: list, states: list):
+        """Performs the AdamW update of all the parameters with one fused
+        kernel, see :func:`mlx.core.fast.adam_update`."""
+        if type(self).apply_single is not AdamW.apply_single:
+            return Optimizer.apply_multi(self, gradients, parameters, states)
+        return self._fused_update(gradients, parameters, states, self.weight_decay)
+
 
 class Adamax(Adam):
     r"""The Adamax optimizer, a variant of Adam based on the infinity norm [1].
@@ -594,6 +649,25 @@ class Lion(Optimizer):
             parameter = (1 - lr * weight_decay) * parameter
         return parameter - lr * mx.sign(c)
 
+    def apply_multi(self, gradients: list, parameters: list, states: list):
+        """Performs the Lion update of all the parameters with one fused
+        kernel, see :func:`mlx.core.fast.lion_update`."""
+        if type(self).apply_single is not Lion.apply_single:
+            return super().apply_multi(gradients, parameters, states)
+        b1, b2 = self.betas
+        parameters, m = mx.fast.lion_update(
+            parameters,
+            gradients,
+            [s["m"] for s in states],
+            self.learning_rate,
+            beta1=b1,
+            beta2=b2,
+            weight_decay=self.weight_decay,
+        )
+        for s, m_i in zip(states, m):
+            s["m"] = m_i
+        return parameters
+
 
 class Adafactor(Optimizer):
     r"""The Adafactor optimizer.
@@ -220,13 +220,16 @@ void init_array(nb::module_& m) {
       nb::is_weak_referenceable())
       .def(
           "__init__",
-          [](array* aptr, ArrayInitType v, std::optional<Dtype> t) {
-            new (aptr) array(create_array(v, t));
-          },
+          [](array* aptr,
+             ArrayInitType v,
+             std::optional<Dtype> t,
+             bool copy) { new (aptr) array(create_array(v, t, copy)); },
           "val"_a,
           "dtype"_a = nb::none(),
+          nb::kw_only(),
+          "copy"_a = true,
           nb::sig(
-              "def __init__(self: array, val: Union[scalar, list, tuple, numpy.ndarray, array], dtype: Optional[Dtype] = None)"))
+              "def __init__(self: array, val: Union[scalar, list, tuple, numpy.ndarray, array], dtype: Optional[Dtype] = None, *, copy: bool = True)"))
       .def_prop_ro(
           "size", &array::size, R"pbdoc(Number of elements in the array.)pbdoc")
       .def_prop_ro("ndim", &array::ndim, R"pbdoc(The array's dimension.)pbdoc")
@@ -278,6 +281,12 @@ void init_array(nb::module_& m) {
 
                 The value type of the list corresponding to the last dimension is either
                 ``bool``, ``int`` or ``float`` depending on the ``dtype`` of the array.
+
+            .. note::
+
+                The array also supports the buffer protocol, so ``memoryview(a)``
+                or ``np.array(a, copy=False)`` access its data without creating a
+                Python object per element.
           )pbdoc")
       .def(
           "astype",
@@ -373,104 +382,104 @@ void init_array(nb::module_& m) {
           "memo"_a)
       .def(
           "__add__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("addition", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             return add(a, b);
           },
           "other"_a)
       .def(
           "__iadd__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace addition", v);
             }
-            a.overwrite_descriptor(add(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(add(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
           nb::rv_policy::none)
       .def(
           "__radd__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("addition", v);
             }
-            return add(a, to_array(v, a.dtype()));
+            return add(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__sub__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("subtraction", v);
             }
-            return subtract(a, to_array(v, a.dtype()));
+            return subtract(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__isub__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace subtraction", v);
             }
-            a.overwrite_descriptor(subtract(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(subtract(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
           nb::rv_policy::none)
       .def(
           "__rsub__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("subtraction", v);
             }
-            return subtract(to_array(v, a.dtype()), a);
+            return subtract(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
           "__mul__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("multiplication", v);
             }
-            return multiply(a, to_array(v, a.dtype()));
+            return multiply(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__imul__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace multiplication", v);
             }
-            a.overwrite_descriptor(multiply(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(multiply(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
           nb::rv_policy::none)
       .def(
           "__rmul__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("multiplication", v);
             }
-            return multiply(a, to_array(v, a.dtype()));
+            return multiply(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__truediv__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return divide(a, to_array(v, a.dtype()));
+            return divide(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__itruediv__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace division", v);
             }
@@ -478,95 +487,95 @@ void init_array(nb::module_& m) {
               throw std::invalid_argument(
                   "In place division cannot cast to non-floating point type.");
             }
-            a.overwrite_descriptor(divide(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(divide(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
           nb::rv_policy::none)
       .def(
           "__rtruediv__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return divide(to_array(v, a.dtype()), a);
+            return divide(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
           "__div__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return divide(a, to_array(v, a.dtype()));
+            return divide(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__rdiv__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return divide(to_array(v, a.dtype()), a);
+            return divide(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
           "__floordiv__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("floor division", v);
             }
-            return floor_divide(a, to_array(v, a.dtype()));
+            return floor_divide(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__ifloordiv__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace floor division", v);
             }
-            a.overwrite_descriptor(floor_divide(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(floor_divide(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
           nb::rv_policy::none)
       .def(
           "__rfloordiv__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("floor division", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             return floor_divide(b, a);
           },
           "other"_a)
       .def(
           "__mod__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("modulus", v);
             }
-            return remainder(a, to_array(v, a.dtype()));
+            return remainder(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__imod__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace modulus", v);
             }
-            a.overwrite_descriptor(remainder(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(remainder(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
           nb::rv_policy::none)
       .def(
           "__rmod__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("modulus", v);
             }
-            return remainder(to_array(v, a.dtype()), a);
+            return remainder(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
@@ -576,53 +585,53 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               return false;
             }
-            return equal(a, to_array(v, a.dtype()));
+            return equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__lt__",
-          [](const array& a, const ScalarOrArray v) -> array {
+          [](const array& a, const ScalarOrArray& v) -> array {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("less than", v);
             }
-            return less(a, to_array(v, a.dtype()));
+            return less(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__le__",
-          [](const array& a, const ScalarOrArray v) -> array {
+          [](const array& a, const ScalarOrArray& v) -> array {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("less than or equal", v);
             }
-            return less_equal(a, to_array(v, a.dtype()));
+            return less_equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__gt__",
-          [](const array& a, const ScalarOrArray v) -> array {
+          [](const array& a, const ScalarOrArray& v) -> array {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("greater than", v);
             }
-            return greater(a, to_array(v, a.dtype()));
+            return greater(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__ge__",
-          [](const array& a, const ScalarOrArray v) -> array {
+          [](const array& a, const ScalarOrArray& v) -> array {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("greater than or equal", v);
             }
-            return greater_equal(a, to_array(v, a.dtype()));
+            return greater_equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__ne__",
           [](const array& a,
-             const ScalarOrArray v) -> std::variant<array, bool> {
+             const ScalarOrArray& v) -> std::variant<array, bool> {
             if (!is_comparable_with_array(v)) {
               return true;
             }
-            return not_equal(a, to_array(v, a.dtype()));
+            return not_equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def("__neg__", [](const array& a) { return -a; })
@@ -649,29 +658,29 @@ void init_array(nb::module_& m) {
           nb::rv_policy::none)
       .def(
           "__pow__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("power", v);
             }
-            return power(a, to_array(v, a.dtype()));
+            return power(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
           "__rpow__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("power", v);
             }
-            return power(to_array(v, a.dtype()), a);
+            return power(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
           "__ipow__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace power", v);
             }
-            a.overwrite_descriptor(power(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(power(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -691,11 +700,11 @@ void init_array(nb::module_& m) {
           })
       .def(
           "__and__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("bitwise and", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -706,11 +715,11 @@ void init_array(nb::module_& m) {
           "other"_a)
       .def(
           "__iand__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace bitwise and", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -723,11 +732,11 @@ void init_array(nb::module_& m) {
           nb::rv_policy::none)
       .def(
           "__or__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("bitwise or", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -738,11 +747,11 @@ void init_array(nb::module_& m) {
           "other"_a)
       .def(
           "__ior__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace bitwise or", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -755,11 +764,11 @@ void init_array(nb::module_& m) {
           nb::rv_policy::none)
       .def(
           "__lshift__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("left shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -770,11 +779,11 @@ void init_array(nb::module_& m) {
           "other"_a)
       .def(
           "__ilshift__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace left shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -787,11 +796,11 @@ void init_array(nb::module_& m) {
           nb::rv_policy::none)
       .def(
           "__rshift__",
-          [](const array& a, const ScalarOrArray v) {
+          [](const array& a, const ScalarOrArray& v) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("right shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -802,11 +811,11 @@ void init_array(nb::module_& m) {
           "other"_a)
       .def(
           "__irshift__",
-          [](array& a, const ScalarOrArray v) -> array& {
+          [](array& a, const ScalarOrArray& v) -> array& {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace right shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (issubdtype(a.dtype(), inexact) ||
                 issubdtype(b.dtype(), inexact)) {
               throw std::invalid_argument(
@@ -1286,4 +1295,32 @@ void init_array(nb::module_& m) {
           nb::kw_only(),
           "stream"_a = nb::none(),
           "See :func:`view`.");
+
+  m.def(
+      "from_dlpack",
+      [](nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> x, bool copy) {
+        return nd_array_to_mlx(x, std::nullopt, copy);
+      },
+      nb::arg(),
+      nb::kw_only(),
+      "copy"_a = false,
+      nb::sig("def from_dlpack(x: Any, /, *, copy: bool = False) -> array"),
+      R"pbdoc(
+        Make an array from an object that supports DLPack or the buffer
+        protocol, e.g. a NumPy array.
+
+        By default the array uses the memory of ``x`` without copying it and
+        keeps ``x`` alive for as long as it needs the memory. Changes made to
+        ``x`` are visible in the array so ``x`` should not be modified while
+        the array is in use. The data is copied if ``x`` is not row
+        contiguous, has a type MLX does not support like ``float64``, or if
+        the backend can't use the memory directly.
+
+        Args:
+            x: The object to make the array from. It must be in CPU memory.
+            copy (bool, optional): Always copy the data. Default: ``False``.
+
+        Returns:
+            array: The array with the data of ``x``.
+      )pbdoc");
 }
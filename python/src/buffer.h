@@ -54,34 +54,34 @@ std::string buffer_format(const array& a) {
   }
 }
 
+// Holds the array for as long as the view lives so that its data stays valid
+// even if the Python array is updated in place and points to new data
 struct buffer_info {
+  array a;
   std::string format;
   std::vector<ssize_t> shape;
   std::vector<ssize_t> strides;
 
   buffer_info(
+      array a,
       std::string format,
       std::vector<ssize_t> shape_in,
       std::vector<ssize_t> strides_in)
-      : format(std::move(format)),
+      : a(std::move(a)),
+        format(std::move(format)),
         shape(std::move(shape_in)),
         strides(std::move(strides_in)) {}
 
   buffer_info(const buffer_info&) = delete;
   buffer_info& operator=(const buffer_info&) = delete;
-
-  buffer_info(buffer_info&& other) noexcept {
-    (*this) = std::move(other);
-  }
-
-  buffer_info& operator=(buffer_info&& rhs) noexcept {
-    format = std::move(rhs.format);
-    shape = std::move(rhs.shape);
-    strides = std::move(rhs.strides);
-    return *this;
-  }
 };
 
+inline int buffer_error(Py_buffer* view, const char* msg) {
+  PyErr_SetString(PyExc_BufferError, msg);
+  view->obj = nullptr;
+  return -1;
+}
+
 extern "C" inline int getbuffer(PyObject* obj, Py_buffer* view, int flags) {
   std::memset(view, 0, sizeof(Py_buffer));
   auto a = nb::cast<array>(nb::handle(obj));
@@ -91,13 +91,32 @@ extern "C" inline int getbuffer(PyObject* obj, Py_buffer* view, int flags) {
     a.eval();
   }
 
+  // Consumers that don't ask for strides, like file.write() or socket.send(),
+  // expect the data to be row contiguous
+  auto a_flags = a.flags();
+  if ((flags & PyBUF_STRIDES) != PyBUF_STRIDES && !a_flags.row_contiguous) {
+    return buffer_error(view, "mlx array is not row contiguous");
+  }
+  if ((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS &&
+      !a_flags.row_contiguous) {
+    return buffer_error(view, "mlx array is not C contiguous");
+  }
+  if ((flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS &&
+      !a_flags.col_contiguous) {
+    return buffer_error(view, "mlx array is not Fortran contiguous");
+  }
+  if ((flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS &&
+      !a_flags.row_contiguous && !a_flags.col_contiguous) {
+    return buffer_error(view, "mlx array is not contiguous");
+  }
+
   std::vector<ssize_t> shape(a.shape().begin(), a.shape().end());
   std::vector<ssize_t> strides(a.strides().begin(), a.strides().end());
   for (auto& s : strides) {
     s *= a.itemsize();
   }
-  buffer_info* info =
-      new buffer_info(buffer_format(a), std::move(shape), std::move(strides));
+  buffer_info* info = new buffer_info(
+      a, buffer_format(a), std::move(shape), std::move(strides));
 
   view->obj = obj;
   view->ndim = a.ndim();
@@ -109,9 +128,11 @@ extern "C" inline int getbuffer(PyObject* obj, Py_buffer* view, int flags) {
   if ((flags & PyBUF_FORMAT) == PyBUF_FORMAT) {
     view->format = const_cast<char*>(info->format.c_str());
   }
+  if ((flags & PyBUF_ND) == PyBUF_ND) {
+    view->shape = info->shape.data();
+  }
   if ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) {
     view->strides = info->strides.data();
-    view->shape = info->shape.data();
   }
   Py_INCREF(view->obj);
   return 0;
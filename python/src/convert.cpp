@@ -1,10 +1,13 @@
 // Copyright © 2024 Apple Inc.
 
+#include <unistd.h>
+
 #include <nanobind/stl/complex.h>
 
 #include "python/src/convert.h"
 #include "python/src/utils.h"
 
+#include "mlx/allocator.h"
 #include "mlx/utils.h"
 
 enum PyScalarT {
@@ -36,20 +39,78 @@ struct ndarray_traits<bfloat16_t> {
 static constexpr dlpack::dtype bfloat16{4, 16, 1};
 }; // namespace nanobind
 
+// Wrap the memory of the array without copying it. The deleter holds a
+// reference to the array so the memory stays valid while MLX uses it. Metal
+// can only wrap whole pages so the pages the data lies on are wrapped and
+// the array starts at an offset in them.
+std::optional<array> nd_array_to_mlx_no_copy(
+    nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd_array,
+    const std::vector<int>& shape,
+    Dtype dtype) {
+  size_t nbytes = nd_array.size() * size_of(dtype);
+  if (nbytes == 0) {
+    return std::nullopt;
+  }
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  auto ptr = reinterpret_cast<uintptr_t>(nd_array.data());
+  auto start = ptr - ptr % page_size;
+  auto end = ptr + nbytes;
+  end += (page_size - end % page_size) % page_size;
+  size_t offset = ptr - start;
+  if (offset % size_of(dtype) != 0) {
+    return std::nullopt;
+  }
+  auto buffer = allocator::make_external(
+      reinterpret_cast<void*>(start), end - start);
+  if (!buffer.ptr()) {
+    return std::nullopt;
+  }
+
+  auto owner = new nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu>(
+      std::move(nd_array));
+  array out(buffer, shape, dtype, [owner](allocator::Buffer b) {
+    allocator::release_external(b);
+    // The reference is leaked if the interpreter is already gone
+    if (Py_IsInitialized()) {
+      nb::gil_scoped_acquire gil;
+      delete owner;
+    }
+  });
+  out.copy_shared_buffer(
+      out, out.strides(), out.flags(), out.size(), offset / size_of(dtype));
+
+  // Never write the outputs of operations to memory owned by Python
+  out.data_shared_ptr()->external = true;
+  return out;
+}
+
 template <typename T>
 array nd_array_to_mlx_contiguous(
     nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd_array,
     const std::vector<int>& shape,
-    Dtype dtype) {
+    Dtype dtype,
+    bool copy) {
+  // MLX has no 64-bit floats so those are always converted
+  if constexpr (
+      !std::is_same_v<T, double> && !std::is_same_v<T, complex128_t>) {
+    if (!copy && dtype == Dtype(TypeToDtype<T>())) {
+      if (auto out = nd_array_to_mlx_no_copy(nd_array, shape, dtype)) {
+        return *out;
+      }
+    }
+  }
+
   // Make a copy of the numpy buffer
   // Get buffer ptr pass to array constructor
   auto data_ptr = nd_array.data();
+  nb::gil_scoped_release nogil;
   return array(static_cast<const T*>(data_ptr), shape, dtype);
 }
 
 array nd_array_to_mlx(
     nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd_array,
-    std::optional<Dtype> dtype) {
+    std::optional<Dtype> dtype,
+    bool copy /* = true */) {
   // Compute the shape and size
   std::vector<int> shape;
   for (int i = 0; i < nd_array.ndim(); i++) {
@@ -60,49 +121,49 @@ array nd_array_to_mlx(
   // Copy data and make array
   if (type == nb::dtype<bool>()) {
     return nd_array_to_mlx_contiguous<bool>(
-        nd_array, shape, dtype.value_or(bool_));
+        nd_array, shape, dtype.value_or(bool_), copy);
   } else if (type == nb::dtype<uint8_t>()) {
     return nd_array_to_mlx_contiguous<uint8_t>(
-        nd_array, shape, dtype.value_or(uint8));
+        nd_array, shape, dtype.value_or(uint8), copy);
   } else if (type == nb::dtype<uint16_t>()) {
     return nd_array_to_mlx_contiguous<uint16_t>(
-        nd_array, shape, dtype.value_or(uint16));
+        nd_array, shape, dtype.value_or(uint16), copy);
   } else if (type == nb::dtype<uint32_t>()) {
     return nd_array_to_mlx_contiguous<uint32_t>(
-        nd_array, shape, dtype.value_or(uint32));
+        nd_array, shape, dtype.value_or(uint32), copy);
   } else if (type == nb::dtype<uint64_t>()) {
     return nd_array_to_mlx_contiguous<uint64_t>(
-        nd_array, shape, dtype.value_or(uint64));
+        nd_array, shape, dtype.value_or(uint64), copy);
   } else if (type == nb::dtype<int8_t>()) {
     return nd_array_to_mlx_contiguous<int8_t>(
-        nd_array, shape, dtype.value_or(int8));
+        nd_array, shape, dtype.value_or(int8), copy);
   } else if (type == nb::dtype<int16_t>()) {
     return nd_array_to_mlx_contiguous<int16_t>(
-        nd_array, shape, dtype.value_or(int16));
+        nd_array, shape, dtype.value_or(int16), copy);
   } else if (type == nb::dtype<int32_t>()) {
     return nd_array_to_mlx_contiguous<int32_t>(
-        nd_array, shape, dtype.value_or(int32));
+        nd_array, shape, dtype.value_or(int32), copy);
   } else if (type == nb::dtype<int64_t>()) {
     return nd_array_to_mlx_contiguous<int64_t>(
-        nd_array, shape, dtype.value_or(int64));
+        nd_array, shape, dtype.value_or(int64), copy);
   } else if (type == nb::dtype<float16_t>()) {
     return nd_array_to_mlx_contiguous<float16_t>(
-        nd_array, shape, dtype.value_or(float16));
+        nd_array, shape, dtype.value_or(float16), copy);
   } else if (type == nb::dtype<bfloat16_t>()) {
     return nd_array_to_mlx_contiguous<bfloat16_t>(
-        nd_array, shape, dtype.value_or(bfloat16));
+        nd_array, shape, dtype.value_or(bfloat16), copy);
   } else if (type == nb::dtype<float>()) {
     return nd_array_to_mlx_contiguous<float>(
-        nd_array, shape, dtype.value_or(float32));
+        nd_array, shape, dtype.value_or(float32), copy);
   } else if (type == nb::dtype<double>()) {
     return nd_array_to_mlx_contiguous<double>(
-        nd_array, shape, dtype.value_or(float32));
+        nd_array, shape, dtype.value_or(float32), copy);
   } else if (type == nb::dtype<std::complex<float>>()) {
     return nd_array_to_mlx_contiguous<complex64_t>(
-        nd_array, shape, dtype.value_or(complex64));
+        nd_array, shape, dtype.value_or(complex64), copy);
   } else if (type == nb::dtype<std::complex<double>>()) {
     return nd_array_to_mlx_contiguous<complex128_t>(
-        nd_array, shape, dtype.value_or(complex64));
+        nd_array, shape, dtype.value_or(complex64), copy);
   } else {
     throw std::invalid_argument("Cannot convert numpy array to mlx array.");
   }
@@ -203,17 +264,45 @@ nb::object to_scalar(array& a) {
   }
 }
 
+template <typename T>
+PyObject* to_py_object(T v) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return PyBool_FromLong(v);
+  } else if constexpr (std::is_same_v<T, std::complex<float>>) {
+    return PyComplex_FromDoubles(v.real(), v.imag());
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return PyFloat_FromDouble(v);
+  } else if constexpr (std::is_signed_v<T>) {
+    return PyLong_FromLongLong(v);
+  } else {
+    return PyLong_FromUnsignedLongLong(v);
+  }
+}
+
+// Build the lists with the C API directly since appending elements one at a
+// time with nb::cast dominates the conversion of large arrays
 template <typename T, typename U = T>
 nb::list to_list(array& a, size_t index, int dim) {
-  nb::list pl;
+  auto n = a.shape(dim);
   auto stride = a.strides()[dim];
-  for (int i = 0; i < a.shape(dim); ++i) {
-    if (dim == a.ndim() - 1) {
-      pl.append(static_cast<U>(a.data<T>()[index]));
-    } else {
-      pl.append(to_list<T, U>(a, index, dim + 1));
+  auto pl = nb::steal<nb::list>(PyList_New(n));
+  if (!pl.is_valid()) {
+    throw nb::python_error();
+  }
+  if (dim == a.ndim() - 1) {
+    const T* data = a.data<T>();
+    for (int i = 0; i < n; ++i, index += stride) {
+      PyObject* item = to_py_object(static_cast<U>(data[index]));
+      if (item == nullptr) {
+        throw nb::python_error();
+      }
+      PyList_SetItem(pl.ptr(), i, item);
+    }
+  } else {
+    for (int i = 0; i < n; ++i, index += stride) {
+      PyList_SetItem(
+          pl.ptr(), i, to_list<T, U>(a, index, dim + 1).release().ptr());
     }
-    index += stride;
   }
   return pl;
 }
@@ -448,7 +537,10 @@ array array_from_list(nb::tuple pl, std::optional<Dtype> dtype) {
   return array_from_list_impl(pl, dtype);
 }
 
-array create_array(ArrayInitType v, std::optional<Dtype> t) {
+array create_array(
+    ArrayInitType v,
+    std::optional<Dtype> t,
+    bool copy /* = true */) {
   if (auto pv = std::get_if<nb::bool_>(&v); pv) {
     return array(nb::cast<bool>(*pv), t.value_or(bool_));
   } else if (auto pv = std::get_if<nb::int_>(&v); pv) {
@@ -464,7 +556,7 @@ array create_array(ArrayInitType v, std::optional<Dtype> t) {
   } else if (auto pv = std::get_if<
                  nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu>>(&v);
              pv) {
-    return nd_array_to_mlx(*pv, t);
+    return nd_array_to_mlx(*pv, t, copy);
   } else if (auto pv = std::get_if<array>(&v); pv) {
     return astype(*pv, t.value_or((*pv).dtype()));
   } else {
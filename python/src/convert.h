@@ -27,7 +27,8 @@ using ArrayInitType = std::variant<
 
 array nd_array_to_mlx(
     nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd_array,
-    std::optional<Dtype> dtype);
+    std::optional<Dtype> dtype,
+    bool copy = true);
 
 nb::ndarray<nb::numpy> mlx_to_np_array(const array& a);
 nb::ndarray<> mlx_to_dlpack(const array& a);
@@ -36,6 +37,6 @@ nb::object to_scalar(array& a);
 
 nb::object tolist(array& a);
 
-array create_array(ArrayInitType v, std::optional<Dtype> t);
+array create_array(ArrayInitType v, std::optional<Dtype> t, bool copy = true);
 array array_from_list(nb::list pl, std::optional<Dtype> dtype);
 array array_from_list(nb::tuple pl, std::optional<Dtype> dtype);
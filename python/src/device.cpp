@@ -4,8 +4,10 @@
 
 #include <nanobind/nanobind.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/vector.h>
 
 #include "mlx/device.h"
+#include "mlx/threadpool.h"
 #include "mlx/utils.h"
 
 namespace nb = nanobind;
@@ -55,4 +57,59 @@ void init_device(nb::module_& m) {
       &set_default_device,
       "device"_a,
       R"pbdoc(Set the default device.)pbdoc");
+  m.def(
+      "cpu_threads",
+      &cpu_threads,
+      R"pbdoc(
+      Get the number of threads the CPU back-end splits operations across.
+
+      Defaults to the number of hardware threads and can be overridden with
+      the ``MLX_CPU_THREADS`` environment variable.
+      )pbdoc");
+  m.def(
+      "set_cpu_threads",
+      &set_cpu_threads,
+      "num_threads"_a,
+      R"pbdoc(
+      Set the number of threads the CPU back-end splits operations across.
+
+      Args:
+        num_threads (int): The number of threads. Use ``1`` to run every
+          operation on its stream's thread.
+      )pbdoc");
+  m.def(
+      "set_cpu_affinity",
+      &set_cpu_affinity,
+      "cores"_a,
+      R"pbdoc(
+      Pin the threads the CPU back-end splits operations across to cores.
+
+      The CPU back-end gets one thread per core and on Linux each thread is
+      pinned to its core. Large fresh allocations are first touched by the
+      thread which will process each chunk, so on NUMA systems the memory is
+      placed on the node of the threads using it. Pinning can also be
+      enabled at startup with ``MLX_CPU_AFFINITY=1``.
+
+      Args:
+        cores (list(int)): The cores to use. An empty list unpins the
+          threads.
+      )pbdoc");
+  m.def(
+      "set_stream_cpu_cores",
+      &set_stream_cpu_cores,
+      "stream"_a,
+      "cores"_a,
+      R"pbdoc(
+      Run the operations of a CPU stream on a dedicated set of cores.
+
+      The stream's thread is pinned to the first core and splits operations
+      across its own threads pinned to the others, so several CPU streams
+      don't compete for the same cores and caches. Applies to operations
+      scheduled on the stream afterwards.
+
+      Args:
+        stream (Stream): The CPU stream.
+        cores (list(int)): The cores to use. An empty list returns the stream
+          to the shared threads.
+      )pbdoc");
 }
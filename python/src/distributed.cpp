@@ -2,7 +2,10 @@
 
 #include <nanobind/nanobind.h>
 #include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/shared_ptr.h>
+#include <nanobind/stl/variant.h>
+#include <nanobind/stl/vector.h>
 
 #include "mlx/distributed/distributed.h"
 #include "mlx/distributed/ops.h"
@@ -55,14 +58,31 @@ void init_distributed(nb::module_& parent_module) {
       "init",
       &distributed::init,
       "strict"_a = false,
-      nb::sig("def init(strict: bool = False) -> Group"),
+      "backend"_a = "any",
+      nb::sig("def init(strict: bool = False, backend: str = 'any') -> Group"),
       R"pbdoc(
         Initialize the communication backend and create the global communication group.
 
+        The ``"ring"`` backend connects the processes in a ring over TCP
+        without needing MPI. It is configured with the ``MLX_HOSTFILE`` and
+        ``MLX_RANK`` environment variables. The hostfile has one line per rank
+        with the space separated ``ip:port`` addresses the rank listens on.
+        Using several addresses per rank (for instance one per Thunderbolt
+        interface) opens one connection per address between neighbours.
+
+        The ``"shm"`` backend connects the processes of a single machine
+        through a shared memory region where they reduce directly. It is
+        configured with the ``MLX_RANK`` and ``MLX_WORLD_SIZE`` environment
+        variables and ``MLX_SHM_NAME``, the name of the region, which should
+        be unique for each job. Default: ``"/mlx_shm"``.
+
         Args:
           strict (bool, optional): If set to False it returns a singleton group
             in case ``mx.distributed.is_available()`` returns False otherwise
             it throws a runtime error. Default: ``False``
+          backend (str, optional): Which backend to use. One of ``"any"``,
+            ``"mpi"``, ``"ring"`` or ``"shm"``. ``"any"`` picks the first
+            configured backend out of ring, shm and MPI. Default: ``"any"``
 
         Returns:
           Group: The group representing all the launched processes.
@@ -74,13 +94,81 @@ void init_distributed(nb::module_& parent_module) {
       "x"_a,
       nb::kw_only(),
       "group"_a = nb::none(),
+      "stream"_a = nb::none(),
       nb::sig(
-          "def all_sum(x: array, *, group: Optional[Group] = None) -> array"),
+          "def all_sum(x: array, *, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         All reduce sum.
 
         Sum the ``x`` arrays from all processes in the group.
 
+        Args:
+          x (array): Input array.
+          group (Group): The group of processes that will participate in the
+            reduction. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the communication stream is used. On a GPU stream
+            the communication overlaps the GPU work already in flight.
+
+        Returns:
+          array: The sum of all ``x`` arrays.
+      )pbdoc");
+
+  m.def(
+      "all_sum_bucketed",
+      &distributed::all_sum_bucketed,
+      "xs"_a,
+      nb::kw_only(),
+      "bucket_size"_a = 32 * 1024 * 1024,
+      "group"_a = nb::none(),
+      "communication_type"_a = nb::none(),
+      nb::sig(
+          "def all_sum_bucketed(xs: list[array], *, bucket_size: int = 33554432, group: Optional[Group] = None, communication_type: Optional[Dtype] = None) -> list[array]"),
+      R"pbdoc(
+        All reduce sum of many arrays with few collectives.
+
+        The arrays are packed in order into contiguous buckets of a single
+        dtype and each bucket is summed across the group with one
+        communication. This is much faster than calling :func:`all_sum` on
+        every array when there are many small arrays, for instance the
+        gradients of a model.
+
+        Args:
+          xs (list(array)): The arrays to sum.
+          bucket_size (int): The maximum size in bytes of a bucket. Arrays
+            larger than this are reduced on their own. Default: ``32 MiB``.
+          group (Group): The group of processes that will participate in the
+            reduction. If set to ``None`` the global group is used. Default:
+            ``None``.
+          communication_type (Dtype, optional): If given the floating point
+            buckets are communicated with :func:`all_sum_cast` as this type.
+            Default: ``None``.
+
+        Returns:
+          list(array): The sum of each of the ``xs`` arrays.
+      )pbdoc");
+
+  m.def(
+      "all_sum_hierarchical",
+      &distributed::all_sum_hierarchical,
+      "x"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      nb::sig(
+          "def all_sum_hierarchical(x: array, *, group: Optional[Group] = None) -> array"),
+      R"pbdoc(
+        All reduce sum that is aware of the nodes.
+
+        The processes of each node reduce scatter ``x``, the processes with the
+        same rank in their node sum their part across the nodes and each node
+        gathers the parts. This divides the communication across nodes by the
+        number of processes per node.
+
+        The nodes are detected from the host names the first time a group is
+        used. If the nodes run different numbers of processes, or there is a
+        single node, it is the same as :func:`all_sum`.
+
         Args:
           x (array): Input array.
           group (Group): The group of processes that will participate in the
@@ -91,14 +179,229 @@ void init_distributed(nb::module_& parent_module) {
           array: The sum of all ``x`` arrays.
       )pbdoc");
 
+  m.def(
+      "matmul_all_sum",
+      &distributed::matmul_all_sum,
+      "x"_a,
+      "w"_a,
+      nb::kw_only(),
+      "n_chunks"_a = 4,
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def matmul_all_sum(x: array, w: array, *, n_chunks: int = 4, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Row parallel linear layer.
+
+        Compute ``x @ w.T`` where ``x`` and ``w`` hold this process' shard of
+        the input features and sum the result across the group. The sum of a
+        chunk of the output features starts as soon as it is computed.
+
+        Args:
+          x (array): Input array with shape ``(..., in_features / N)``.
+          w (array): Weight with shape ``(out_features, in_features / N)``.
+          n_chunks (int): The number of chunks of the output features. The
+            collective of a chunk overlaps the computation of the next ones.
+            Default: ``4``.
+          group (Group): The group of processes that will participate in the
+            collective. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device for the matrix
+            multiplications. Defaults to ``None``.
+
+        Returns:
+          array: The output with shape ``(..., out_features)``.
+      )pbdoc");
+
+  m.def(
+      "matmul_all_gather",
+      &distributed::matmul_all_gather,
+      "x"_a,
+      "w"_a,
+      nb::kw_only(),
+      "n_chunks"_a = 4,
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def matmul_all_gather(x: array, w: array, *, n_chunks: int = 4, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Column parallel linear layer with a gathered output.
+
+        Compute ``x @ w.T`` where ``w`` holds this process' shard of the
+        output features and concatenate the outputs of all the processes
+        along the last axis in rank order. The gather of a chunk of the
+        output features starts as soon as it is computed.
+
+        Args:
+          x (array): Input array with shape ``(..., in_features)``.
+          w (array): Weight with shape ``(out_features / N, in_features)``.
+          n_chunks (int): The number of chunks of the output features. The
+            collective of a chunk overlaps the computation of the next ones.
+            Default: ``4``.
+          group (Group): The group of processes that will participate in the
+            collective. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device for the matrix
+            multiplications. Defaults to ``None``.
+
+        Returns:
+          array: The output with shape ``(..., out_features)``.
+      )pbdoc");
+
+  m.def(
+      "quantized_matmul_all_sum",
+      &distributed::quantized_matmul_all_sum,
+      "x"_a,
+      "w"_a,
+      "scales"_a,
+      "biases"_a,
+      "group_size"_a = 64,
+      "bits"_a = 4,
+      nb::kw_only(),
+      "n_chunks"_a = 4,
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_matmul_all_sum(x: array, w: array, scales: array, biases: array, group_size: int = 64, bits: int = 4, *, n_chunks: int = 4, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Row parallel quantized linear layer.
+
+        The same as :func:`matmul_all_sum` with a weight quantized with
+        :func:`mlx.core.quantize`.
+
+        Args:
+          x (array): Input array.
+          w (array): Quantized weight shard.
+          scales (array): The scales of ``w``.
+          biases (array): The biases of ``w``.
+          group_size (int, optional): The quantization group size. Default:
+            ``64``.
+          bits (int, optional): The number of bits per element. Default:
+            ``4``.
+          n_chunks (int): The number of chunks of the output features. The
+            collective of a chunk overlaps the computation of the next ones.
+            Default: ``4``.
+          group (Group): The group of processes that will participate in the
+            collective. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device for the matrix
+            multiplications. Defaults to ``None``.
+
+        Returns:
+          array: The output with shape ``(..., out_features)``.
+      )pbdoc");
+
+  m.def(
+      "quantized_matmul_all_gather",
+      &distributed::quantized_matmul_all_gather,
+      "x"_a,
+      "w"_a,
+      "scales"_a,
+      "biases"_a,
+      "group_size"_a = 64,
+      "bits"_a = 4,
+      nb::kw_only(),
+      "n_chunks"_a = 4,
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_matmul_all_gather(x: array, w: array, scales: array, biases: array, group_size: int = 64, bits: int = 4, *, n_chunks: int = 4, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Column parallel quantized linear layer with a gathered output.
+
+        The same as :func:`matmul_all_gather` with a weight quantized with
+        :func:`mlx.core.quantize`.
+
+        Args:
+          x (array): Input array.
+          w (array): Quantized weight shard.
+          scales (array): The scales of ``w``.
+          biases (array): The biases of ``w``.
+          group_size (int, optional): The quantization group size. Default:
+            ``64``.
+          bits (int, optional): The number of bits per element. Default:
+            ``4``.
+          n_chunks (int): The number of chunks of the output features. The
+            collective of a chunk overlaps the computation of the next ones.
+            Default: ``4``.
+          group (Group): The group of processes that will participate in the
+            collective. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device for the matrix
+            multiplications. Defaults to ``None``.
+
+        Returns:
+          array: The output with shape ``(..., out_features)``.
+      )pbdoc");
+
+  m.def(
+      "all_sum_cast",
+      &distributed::all_sum_cast,
+      "x"_a,
+      "communication_type"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      nb::sig(
+          "def all_sum_cast(x: array, communication_type: Dtype, *, group: Optional[Group] = None) -> array"),
+      R"pbdoc(
+        All reduce sum communicating in a lower precision.
+
+        The ``x`` arrays are sent as ``communication_type`` which halves the
+        communication of ``float32`` arrays. The partial sums are accumulated
+        in ``float32`` and the result has the type of ``x``. The backend needs
+        to support :func:`all_to_all`.
+
+        Args:
+          x (array): Input floating point array.
+          communication_type (Dtype): Either ``float16`` or ``bfloat16``.
+          group (Group): The group of processes that will participate in the
+            reduction. If set to ``None`` the global group is used. Default:
+            ``None``.
+
+        Returns:
+          array: The sum of all ``x`` arrays.
+      )pbdoc");
+
+  m.def(
+      "all_sum_topk",
+      &distributed::all_sum_topk,
+      "x"_a,
+      "error"_a,
+      "k"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      nb::sig(
+          "def all_sum_topk(x: array, error: array, k: int, *, group: Optional[Group] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        Sparse all reduce sum with error feedback.
+
+        Every process sends only the ``k`` entries of ``x + error`` with the
+        largest magnitude and their indices. The entries that were not sent
+        are returned as the new error which should be passed to the next call
+        so that they are eventually communicated.
+
+        Args:
+          x (array): Input array.
+          error (array): The error of the previous call with the shape of
+            ``x``. Use zeros for the first call.
+          k (int): The number of entries each process sends.
+          group (Group): The group of processes that will participate in the
+            reduction. If set to ``None`` the global group is used. Default:
+            ``None``.
+
+        Returns:
+          tuple(array, array): The sum of the sent entries and the new error.
+      )pbdoc");
+
   m.def(
       "all_gather",
       &distributed::all_gather,
       "x"_a,
       nb::kw_only(),
       "group"_a = nb::none(),
+      "stream"_a = nb::none(),
       nb::sig(
-          "def all_gather(x: array, *, group: Optional[Group] = None) -> array"),
+          "def all_gather(x: array, *, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Gather arrays from all processes.
 
@@ -110,8 +413,179 @@ void init_distributed(nb::module_& parent_module) {
           group (Group): The group of processes that will participate in the
             gather. If set to ``None`` the global group is used. Default:
             ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the communication stream is used. On a GPU stream
+            the communication overlaps the GPU work already in flight.
 
         Returns:
           array: The concatenation of all ``x`` arrays.
       )pbdoc");
+
+  m.def(
+      "reduce_scatter",
+      &distributed::reduce_scatter,
+      "x"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def reduce_scatter(x: array, *, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Reduce scatter sum.
+
+        Sum the ``x`` arrays from all processes in the group and return the
+        block of the first axis that belongs to this process. The size of the
+        first axis must be divisible by the size of the group.
+
+        Args:
+          x (array): Input array.
+          group (Group): The group of processes that will participate in the
+            reduction. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the communication stream is used. On a GPU stream
+            the communication overlaps the GPU work already in flight.
+
+        Returns:
+          array: The ``rank``-th block of the sum of all ``x`` arrays.
+      )pbdoc");
+
+  m.def(
+      "all_to_all",
+      &distributed::all_to_all,
+      "x"_a,
+      "send_sizes"_a = nb::none(),
+      "recv_sizes"_a = nb::none(),
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      nb::sig(
+          "def all_to_all(x: array, send_sizes: Optional[Sequence[int]] = None, recv_sizes: Optional[Sequence[int]] = None, *, group: Optional[Group] = None) -> array"),
+      R"pbdoc(
+        Exchange blocks of the first axis between all processes.
+
+        Process ``j`` sends ``send_sizes[i]`` consecutive rows of ``x`` to
+        process ``i`` and the result concatenates the ``recv_sizes[i]`` rows
+        received from each process ``i`` in rank order.
+
+        Args:
+          x (array): Input array.
+          send_sizes (list(int), optional): The number of rows sent to each
+            process. If not given the first axis is split evenly.
+          recv_sizes (list(int), optional): The number of rows received from
+            each process. It must be given along with ``send_sizes``.
+          group (Group): The group of processes that will participate in the
+            exchange. If set to ``None`` the global group is used. Default:
+            ``None``.
+
+        Returns:
+          array: The concatenation of the received rows.
+      )pbdoc");
+
+  m.def(
+      "broadcast",
+      &distributed::broadcast,
+      "x"_a,
+      "root"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def broadcast(x: array, root: int, *, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Broadcast an array from one process to the others.
+
+        Every process receives the ``x`` of the process with rank ``root``.
+        The ``x`` of the other processes only provides the shape and dtype.
+
+        Args:
+          x (array): Input array.
+          root (int): Rank of the process whose array is broadcast.
+          group (Group): The group of processes that will participate in the
+            broadcast. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the communication stream is used. On a GPU stream
+            the communication overlaps the GPU work already in flight.
+
+        Returns:
+          array: The ``x`` array of the ``root`` process.
+      )pbdoc");
+
+  m.def(
+      "send",
+      &distributed::send,
+      "x"_a,
+      "dst"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      nb::sig(
+          "def send(x: array, dst: int, *, group: Optional[Group] = None) -> array"),
+      R"pbdoc(
+        Send an array from the current process to the process that has rank
+        ``dst`` in the group.
+
+        The send happens when the returned array is evaluated. It holds the
+        same data as ``x`` so it can be used as a dependency.
+
+        Args:
+          x (array): Input array.
+          dst (int): Rank of the destination process in the group.
+          group (Group): The group of processes that will participate in the
+            communication. If set to ``None`` the global group is used.
+            Default: ``None``.
+
+        Returns:
+          array: An array identical to ``x`` which when evaluated sends it.
+      )pbdoc");
+
+  m.def(
+      "recv",
+      &distributed::recv,
+      "shape"_a,
+      "dtype"_a,
+      "src"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      nb::sig(
+          "def recv(shape: Sequence[int], dtype: Dtype, src: int, *, group: Optional[Group] = None) -> array"),
+      R"pbdoc(
+        Receive an array with the given shape and dtype from the process that
+        has rank ``src`` in the group.
+
+        Args:
+          shape (Tuple[int]): The shape of the array being received.
+          dtype (Dtype): The data type of the array being received.
+          src (int): Rank of the source process in the group.
+          group (Group): The group of processes that will participate in the
+            communication. If set to ``None`` the global group is used.
+            Default: ``None``.
+
+        Returns:
+          array: The array that was received from ``src``.
+      )pbdoc");
+
+  m.def(
+      "recv_like",
+      &distributed::recv_like,
+      "x"_a,
+      "src"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      nb::sig(
+          "def recv_like(x: array, src: int, *, group: Optional[Group] = None) -> array"),
+      R"pbdoc(
+        Receive an array with the shape and dtype of ``x`` from the process
+        that has rank ``src`` in the group.
+
+        Args:
+          x (array): An array with the shape and dtype of the array being
+            received. Its data is not used.
+          src (int): Rank of the source process in the group.
+          group (Group): The group of processes that will participate in the
+            communication. If set to ``None`` the global group is used.
+            Default: ``None``.
+
+        Returns:
+          array: The array that was received from ``src``.
+      )pbdoc");
 }
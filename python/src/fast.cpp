@@ -2,10 +2,15 @@
 
 #include <nanobind/nanobind.h>
 #include <nanobind/stl/optional.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/pair.h>
+#include <nanobind/stl/tuple.h>
 #include <nanobind/stl/variant.h>
+#include <nanobind/stl/vector.h>
 
 #include "mlx/fast.h"
 #include "mlx/ops.h"
+#include "python/src/utils.h"
 
 namespace nb = nanobind;
 using namespace nb::literals;
@@ -41,6 +46,36 @@ void init_fast(nb::module_& parent_module) {
             array: The output array.
       )pbdoc");
 
+  m.def(
+      "rms_norm_residual",
+      &fast::rms_norm_residual,
+      "x"_a,
+      "residual"_a,
+      "weight"_a,
+      "eps"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def rms_norm_residual(x: array, residual: array, weight: array, eps: float, *, stream: Union[None, Stream, Device] = None) -> Tuple[array, array]"),
+      R"pbdoc(
+        Residual add followed by RMS normalization in a single pass.
+
+        Computes ``h = x + residual`` and ``rms_norm(h, weight, eps)``
+        reading the inputs once, as in the pre-norm blocks of transformers.
+
+        Args:
+            x (array): Input array.
+            residual (array): The residual to add to ``x``. It must have the
+              same shape as ``x``.
+            weight (array): A multiplicative weight to scale the result by.
+              The ``weight`` should be one-dimensional with the same size
+              as the last axis of ``x``.
+            eps (float): A small additive constant for numerical stability.
+
+        Returns:
+            tuple(array, array): The normalized sum and the sum ``h``.
+      )pbdoc");
+
   m.def(
       "layer_norm",
       &fast::layer_norm,
@@ -71,19 +106,314 @@ void init_fast(nb::module_& parent_module) {
             array: The output array.
       )pbdoc");
 
+  m.def(
+      "group_norm",
+      &fast::group_norm,
+      "x"_a,
+      "weight"_a.none(),
+      "bias"_a.none(),
+      "num_groups"_a,
+      "eps"_a,
+      nb::kw_only(),
+      "pytorch_compatible"_a = false,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def group_norm(x: array, weight: Optional[array], bias: Optional[array], num_groups: int, eps: float, *, pytorch_compatible: bool = False, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Group normalization.
+
+        The features are the last axis of ``x`` and the first axis is the
+        batch. The features are split into ``num_groups`` groups and each
+        group is normalized over the features it contains and all the
+        positions of a sample.
+
+        Args:
+            x (array): Input array with at least two dimensions.
+            weight (array, optional): A multiplicative weight to scale the result by.
+              The ``weight`` should be one-dimensional with the same size
+              as the last axis of ``x``. If set to ``None`` then no scaling happens.
+            bias (array, optional): An additive offset to be added to the result.
+              The ``bias`` should be one-dimensional with the same size
+              as the last axis of ``x``. If set to ``None`` then no translation happens.
+            num_groups (int): Number of groups to split the features into. It
+              must divide the last axis of ``x``.
+            eps (float): A small additive constant for numerical stability.
+            pytorch_compatible (bool): If ``True`` each group holds consecutive
+              features as in PyTorch. Otherwise the features of a group are
+              interleaved. Default: ``False``.
+
+        Returns:
+            array: The output array.
+      )pbdoc");
+  m.def(
+      "batch_norm",
+      &fast::batch_norm,
+      "x"_a,
+      "weight"_a.none(),
+      "bias"_a.none(),
+      "eps"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def batch_norm(x: array, weight: Optional[array], bias: Optional[array], eps: float, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Batch normalization with the statistics of the input.
+
+        Every feature in the last axis of ``x`` is normalized over all the
+        other axes.
+
+        Args:
+            x (array): Input array with at least two dimensions.
+            weight (array, optional): A multiplicative weight to scale the result by.
+              The ``weight`` should be one-dimensional with the same size
+              as the last axis of ``x``. If set to ``None`` then no scaling happens.
+            bias (array, optional): An additive offset to be added to the result.
+              The ``bias`` should be one-dimensional with the same size
+              as the last axis of ``x``. If set to ``None`` then no translation happens.
+            eps (float): A small additive constant for numerical stability.
+
+        Returns:
+            array: The output array.
+      )pbdoc");
+
+  m.def(
+      "mean_var",
+      [](const array& x,
+         const IntOrVec& axis,
+         bool keepdims,
+         int ddof,
+         StreamOrDevice s) {
+        return fast::mean_var(
+            x, get_reduce_axes(axis, x.ndim()), keepdims, ddof, s);
+      },
+      "x"_a,
+      "axis"_a = nb::none(),
+      "keepdims"_a = false,
+      "ddof"_a = 0,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def mean_var(x: array, axis: Union[None, int, Sequence[int]] = None, keepdims: bool = False, ddof: int = 0, *, stream: Union[None, Stream, Device] = None) -> Tuple[array, array]"),
+      R"pbdoc(
+        Compute the mean and variance over the given axes in one pass.
+
+        The result matches ``(mx.mean(x, axis, keepdims), mx.var(x, axis,
+        keepdims, ddof))`` but the input is read once and in place.
+
+        Args:
+            x (array): Input array.
+            axis (int or list(int), optional): Optional axis or
+              axes to reduce over. If unspecified this defaults
+              to reducing over the entire array.
+            keepdims (bool, optional): Keep reduced axes as
+              singleton dimensions, defaults to `False`.
+            ddof (int, optional): The divisor to compute the variance
+              is ``N - ddof``, defaults to 0.
+
+        Returns:
+            tuple(array, array): The means and the variances.
+      )pbdoc");
+
+  m.def(
+      "cross_entropy",
+      &fast::cross_entropy,
+      "logits"_a,
+      "targets"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def cross_entropy(logits: array, targets: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Cross entropy between logits and integer class targets.
+
+        The result matches ``mx.logsumexp(logits, -1) -
+        mx.take_along_axis(logits, targets[..., None], -1)[..., 0]`` but the
+        logits are read once and the gradient ``softmax(logits) -
+        one_hot(targets)`` is written directly, so neither the softmax nor the
+        log-sum-exp intermediates of the vocabulary are materialized.
+
+        Args:
+            logits (array): The unnormalized logits with the classes in the
+              last axis.
+            targets (array): The class indices with the shape of ``logits``
+              without the last axis. Targets outside of
+              ``[0, logits.shape[-1])`` are ignored and give a zero loss.
+
+        Returns:
+            array: The loss of each target.
+      )pbdoc");
+
+  m.def(
+      "adam_update",
+      [](const std::vector<array>& parameters,
+         const std::vector<array>& gradients,
+         const std::vector<array>& m,
+         const std::vector<array>& v,
+         const ScalarOrArray& learning_rate,
+         float beta1,
+         float beta2,
+         float eps,
+         float weight_decay,
+         StreamOrDevice s) {
+        return fast::adam_update(
+            parameters,
+            gradients,
+            m,
+            v,
+            to_array(learning_rate, float32),
+            beta1,
+            beta2,
+            eps,
+            weight_decay,
+            s);
+      },
+      "parameters"_a,
+      "gradients"_a,
+      "m"_a,
+      "v"_a,
+      "learning_rate"_a,
+      nb::kw_only(),
+      "beta1"_a = 0.9,
+      "beta2"_a = 0.999,
+      "eps"_a = 1e-8,
+      "weight_decay"_a = 0.0,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def adam_update(parameters: list[array], gradients: list[array], m: list[array], v: list[array], learning_rate: Union[scalar, array], *, beta1: float = 0.9, beta2: float = 0.999, eps: float = 1e-8, weight_decay: float = 0.0, stream: Union[None, Stream, Device] = None) -> tuple[list[array], list[array], list[array]]"),
+      R"pbdoc(
+        Adam update of a list of parameters.
+
+        Every parameter ``p`` with gradient ``g`` and moments ``m`` and ``v``
+        is updated as
+
+        .. code-block:: python
+
+          m = beta1 * m + (1 - beta1) * g
+          v = beta2 * v + (1 - beta2) * mx.square(g)
+          p = p * (1 - learning_rate * weight_decay)
+          p = p - learning_rate * m / (mx.sqrt(v) + eps)
+
+        but all the tensors are updated by one fused kernel instead of a
+        dozen operations each. A non-zero ``weight_decay`` gives AdamW. The
+        parameters and moments are updated in place when they are not used
+        anywhere else.
+
+        Args:
+            parameters (list(array)): The parameters.
+            gradients (list(array)): The gradients of the parameters.
+            m (list(array)): The first moments of the gradients.
+            v (list(array)): The second moments of the gradients.
+            learning_rate (float or array): The learning rate.
+            beta1 (float, optional): The decay of the first moments.
+              Default: ``0.9``.
+            beta2 (float, optional): The decay of the second moments.
+              Default: ``0.999``.
+            eps (float, optional): The term added to the denominator.
+              Default: ``1e-8``.
+            weight_decay (float, optional): The decoupled weight decay.
+              Default: ``0.0``.
+
+        Returns:
+            tuple(list(array), list(array), list(array)): The new parameters,
+            first moments and second moments.
+      )pbdoc");
+
+  m.def(
+      "lion_update",
+      [](const std::vector<array>& parameters,
+         const std::vector<array>& gradients,
+         const std::vector<array>& m,
+         const ScalarOrArray& learning_rate,
+         float beta1,
+         float beta2,
+         float weight_decay,
+         StreamOrDevice s) {
+        return fast::lion_update(
+            parameters,
+            gradients,
+            m,
+            to_array(learning_rate, float32),
+            beta1,
+            beta2,
+            weight_decay,
+            s);
+      },
+      "parameters"_a,
+      "gradients"_a,
+      "m"_a,
+      "learning_rate"_a,
+      nb::kw_only(),
+      "beta1"_a = 0.9,
+      "beta2"_a = 0.99,
+      "weight_decay"_a = 0.0,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def lion_update(parameters: list[array], gradients: list[array], m: list[array], learning_rate: Union[scalar, array], *, beta1: float = 0.9, beta2: float = 0.99, weight_decay: float = 0.0, stream: Union[None, Stream, Device] = None) -> tuple[list[array], list[array]]"),
+      R"pbdoc(
+        Lion update of a list of parameters.
+
+        Every parameter ``p`` with gradient ``g`` and momentum ``m`` is
+        updated as
+
+        .. code-block:: python
+
+          c = beta1 * m + (1 - beta1) * g
+          m = beta2 * m + (1 - beta2) * g
+          p = p * (1 - learning_rate * weight_decay)
+          p = p - learning_rate * mx.sign(c)
+
+        with one fused kernel for all the tensors.
+
+        Args:
+            parameters (list(array)): The parameters.
+            gradients (list(array)): The gradients of the parameters.
+            m (list(array)): The momenta of the gradients.
+            learning_rate (float or array): The learning rate.
+            beta1 (float, optional): The interpolation of the update
+              direction. Default: ``0.9``.
+            beta2 (float, optional): The decay of the momenta.
+              Default: ``0.99``.
+            weight_decay (float, optional): The decoupled weight decay.
+              Default: ``0.0``.
+
+        Returns:
+            tuple(list(array), list(array)): The new parameters and momenta.
+      )pbdoc");
+
   m.def(
       "rope",
-      &fast::rope,
+      [](const array& a,
+         int dims,
+         bool traditional,
+         std::optional<float> base,
+         float scale,
+         const std::variant<int, array>& offset,
+         const std::optional<array>& freqs,
+         StreamOrDevice s) {
+        if (auto pv = std::get_if<int>(&offset); pv) {
+          return fast::rope(a, dims, traditional, base, scale, *pv, freqs, s);
+        }
+        return fast::rope(
+            a,
+            dims,
+            traditional,
+            base,
+            scale,
+            std::get<array>(offset),
+            freqs,
+            s);
+      },
       "a"_a,
       "dims"_a,
       nb::kw_only(),
       "traditional"_a,
-      "base"_a,
+      "base"_a.none(),
       "scale"_a,
       "offset"_a,
+      "freqs"_a = nb::none(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def rope(a: array, dims: int, *, traditinoal: bool, base: float, scale: float, offset: int, stream: Union[None, Stream, Device] = None) -> array"),
+          "def rope(a: array, dims: int, *, traditional: bool, base: Optional[float], scale: float, offset: Union[int, array], freqs: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Apply rotary positional encoding to the input.
 
@@ -93,10 +423,18 @@ void init_fast(nb::module_& parent_module) {
                 is larger than dims then the rest is left unchanged.
             traditional (bool): If set to ``True`` choose the traditional
                 implementation which rotates consecutive dimensions.
-            base (float): The base used to compute angular frequency for
-                each dimension in the positional encodings.
+            base (float, optional): The base used to compute angular frequency
+                for each dimension in the positional encodings. Exactly one of
+                ``base`` and ``freqs`` must be ``None``.
             scale (float): The scale used to scale the positions.
-            offset (int): The position offset to start at.
+            offset (int or array): The position offset to start at. An array
+                offset is either a scalar or has one entry per element of the
+                first axis of ``a``, which lets each sequence of a batch start
+                at its own position.
+            freqs (array, optional): Precomputed frequencies of shape
+                ``(dims // 2,)`` used in place of ``base ** (2 * i / dims)``,
+                for instance to apply scaled rotary encodings.
+                Default: ``None``.
 
         Returns:
             array: The output array.
@@ -104,16 +442,48 @@ void init_fast(nb::module_& parent_module) {
 
   m.def(
       "scaled_dot_product_attention",
-      &fast::scaled_dot_product_attention,
+      [](const array& q,
+         const array& k,
+         const array& v,
+         const float scale,
+         const std::variant<std::monostate, std::string, array>& mask,
+         const std::optional<int> window_size,
+         const std::optional<array>& alibi_slopes,
+         const StreamOrDevice& s) {
+        if (window_size || alibi_slopes) {
+          auto pv = std::get_if<std::string>(&mask);
+          auto pa = std::get_if<array>(&mask);
+          return fast::scaled_dot_product_attention(
+              q,
+              k,
+              v,
+              scale,
+              pv ? *pv : "",
+              window_size.value_or(0),
+              alibi_slopes,
+              pa ? std::optional<array>(*pa) : std::nullopt,
+              s);
+        }
+        if (auto pv = std::get_if<std::string>(&mask); pv) {
+          return fast::scaled_dot_product_attention(
+              q, k, v, scale, *pv, std::nullopt, s);
+        } else if (auto pv = std::get_if<array>(&mask); pv) {
+          return fast::scaled_dot_product_attention(q, k, v, scale, *pv, s);
+        }
+        return fast::scaled_dot_product_attention(
+            q, k, v, scale, std::nullopt, s);
+      },
       "q"_a,
       "k"_a,
       "v"_a,
       nb::kw_only(),
       "scale"_a,
       "mask"_a = nb::none(),
+      "window_size"_a = nb::none(),
+      "alibi_slopes"_a = nb::none(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def scaled_dot_product_attention(q: array, k: array, v: array, *, scale: float,  mask: Union[None, array] = None, stream: Union[None, Stream, Device] = None) -> array"),
+          "def scaled_dot_product_attention(q: array, k: array, v: array, *, scale: float, mask: Union[None, str, array] = None, window_size: Optional[int] = None, alibi_slopes: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         A fast implementation of multi-head attention: ``O = softmax(Q @ K.T, dim=-1) @ V``.
 
@@ -134,8 +504,616 @@ void init_fast(nb::module_& parent_module) {
             k (array): Input keys array.
             v (array): Input values array.
             scale (float): Scale for queries (typically ``1.0 / sqrt(q.shape(-1)``)
-            mask (array, optional): An additive mask to apply to the query-key scores.
+            mask (Union[None, str, array], optional): The mask to apply to the
+              query-key scores. ``"causal"`` lets query ``i`` attend to the
+              keys up to ``i + k.shape[-2] - q.shape[-2]``. A boolean array
+              selects the scores to keep and any other array is added to the
+              scores. Array masks must broadcast to
+              ``(batch, n_heads, q.shape[-2], k.shape[-2])``. Default: ``None``.
+            window_size (int, optional): If given, query ``i`` only attends to
+              the last ``window_size`` keys up to position
+              ``i + k.shape[-2] - q.shape[-2]``, as in sliding window
+              attention. Default: ``None``.
+            alibi_slopes (array, optional): One slope per query head. The
+              distance between the positions of the key and the query times
+              the slope of the head is added to the scores as in
+              `ALiBi <https://arxiv.org/abs/2108.12409>`_. Default: ``None``.
+        Returns:
+            array: The output array.
+      )pbdoc");
+
+  m.def(
+      "quantized_scaled_dot_product_attention",
+      &fast::quantized_scaled_dot_product_attention,
+      "q"_a,
+      "k"_a,
+      "k_scales"_a,
+      "k_biases"_a,
+      "v"_a,
+      "v_scales"_a,
+      "v_biases"_a,
+      nb::kw_only(),
+      "scale"_a,
+      "mask"_a = nb::none(),
+      "group_size"_a = 64,
+      "bits"_a = 4,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_scaled_dot_product_attention(q: array, k: array, k_scales: array, k_biases: array, v: array, v_scales: array, v_biases: array, *, scale: float, mask: Union[None, array] = None, group_size: int = 64, bits: int = 4, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Multi-head attention with quantized keys and values.
+
+        Computes ``O = softmax(Q @ K.T, dim=-1) @ V`` like
+        :func:`scaled_dot_product_attention` where the keys and values, for
+        instance a KV cache, are quantized with :func:`mlx.core.quantize`
+        along their last axis. On the GPU a single query is computed
+        dequantizing the keys and values on the fly.
+
+        Args:
+            q (array): Input query array.
+            k (array): Quantized keys array.
+            k_scales (array): The scales of the keys.
+            k_biases (array): The biases of the keys.
+            v (array): Quantized values array.
+            v_scales (array): The scales of the values.
+            v_biases (array): The biases of the values.
+            scale (float): Scale for queries (typically ``1.0 / sqrt(q.shape(-1)``)
+            mask (array, optional): A boolean or additive mask to apply to
+              the query-key scores. Default: ``None``.
+            group_size (int, optional): The group size used to quantize the
+              keys and values. Default: ``64``.
+            bits (int, optional): The number of bits used to quantize the
+              keys and values. Default: ``4``.
+
+        Returns:
+            array: The output array.
+      )pbdoc");
+
+  m.def(
+      "paged_attention",
+      &fast::paged_attention,
+      "q"_a,
+      "k_cache"_a,
+      "v_cache"_a,
+      "block_tables"_a,
+      "context_lengths"_a,
+      nb::kw_only(),
+      "scale"_a,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def paged_attention(q: array, k_cache: array, v_cache: array, block_tables: array, context_lengths: array, *, scale: float, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Attention of one query per sequence over keys and values stored in
+        pages.
+
+        The caches hold ``num_blocks`` pages of ``block_size`` keys or values
+        shared by all the sequences. Row ``i`` of ``block_tables`` lists the
+        pages of sequence ``i`` in order, so that its key at position ``j``
+        is ``k_cache[block_tables[i, j // block_size], :, j % block_size]``.
+        Sequence ``i`` attends to its first ``context_lengths[i]`` keys and
+        the remaining entries of its row of the block table are ignored.
+
+        Args:
+            q (array): Input query array with shape
+              ``(batch, n_heads, 1, head_dim)``.
+            k_cache (array): Key pages with shape
+              ``(num_blocks, n_kv_heads, block_size, head_dim)``.
+            v_cache (array): Value pages with the same shape as ``k_cache``.
+            block_tables (array): The pages of each sequence with shape
+              ``(batch, max_blocks)``.
+            context_lengths (array): The number of keys of each sequence with
+              shape ``(batch,)``.
+            scale (float): Scale for queries (typically ``1.0 / sqrt(q.shape(-1)``)
+
         Returns:
             array: The output array.
       )pbdoc");
+
+  nb::class_<fast::PrefixCache>(
+      m,
+      "PrefixCache",
+      R"pbdoc(
+        A pool of key and value pages for :func:`paged_attention` in which
+        sequences starting with the same tokens share the pages of their
+        common prefix.
+
+        Once written, full pages are indexed by a hash of their tokens and
+        all the tokens before them. A new sequence reuses the pages of the
+        longest indexed prefix of its tokens, leaving at least its last token
+        to compute. Indexed pages no sequence uses are kept until a page is
+        needed and the pool can't grow, least recently used first. The pool
+        starts small and doubles up to ``max_blocks`` pages while the active
+        memory stays under the memory limit, see
+        :func:`mlx.core.metal.set_memory_limit`.
+
+        Args:
+            max_blocks (int): The maximum number of pages.
+            n_kv_heads (int): The number of key and value heads.
+            block_size (int): The number of tokens per page.
+            head_dim (int): The head dimension.
+            dtype (Dtype, optional): The type of the pages. Default:
+              ``float16``.
+
+        Example:
+            >>> cache = mx.fast.PrefixCache(1024, 8, 16, 128)
+            >>> seq, cached = cache.acquire(prompt)
+            >>> k, v = prefill(prompt[cached:], cache, seq)
+            >>> cache.write(seq, cached, k, v)
+            >>> tables = mx.array([cache.block_table(seq)])
+            >>> out = mx.fast.paged_attention(
+            ...     q, cache.keys, cache.values, tables, lengths, scale=scale)
+            >>> cache.release(seq)
+      )pbdoc")
+      .def(
+          nb::init<int, int, int, int, Dtype, StreamOrDevice>(),
+          "max_blocks"_a,
+          "n_kv_heads"_a,
+          "block_size"_a,
+          "head_dim"_a,
+          "dtype"_a = float16,
+          nb::kw_only(),
+          "stream"_a = nb::none(),
+          nb::sig(
+              "def __init__(self, max_blocks: int, n_kv_heads: int, block_size: int, head_dim: int, dtype: Dtype = float16, *, stream: Union[None, Stream, Device] = None)"))
+      .def_prop_ro(
+          "keys",
+          &fast::PrefixCache::keys,
+          R"pbdoc(
+          The key pages of shape
+          ``(num_blocks, n_kv_heads, block_size, head_dim)``.
+          )pbdoc")
+      .def_prop_ro(
+          "values",
+          &fast::PrefixCache::values,
+          R"pbdoc(
+          The value pages with the same shape as the keys.
+          )pbdoc")
+      .def_prop_ro("block_size", &fast::PrefixCache::block_size)
+      .def(
+          "acquire",
+          &fast::PrefixCache::acquire,
+          "tokens"_a,
+          R"pbdoc(
+          Start a sequence with the given tokens.
+
+          Returns:
+              tuple(int, int): The id of the sequence and the number of its
+              leading tokens whose keys and values are already in its pages.
+          )pbdoc")
+      .def(
+          "extend",
+          &fast::PrefixCache::extend,
+          "seq"_a,
+          "tokens"_a,
+          R"pbdoc(
+          Append tokens to a sequence, e.g. the generated ones.
+          )pbdoc")
+      .def(
+          "write",
+          &fast::PrefixCache::write,
+          "seq"_a,
+          "start"_a,
+          "keys"_a,
+          "values"_a,
+          R"pbdoc(
+          Write the keys and values of the sequence's tokens
+          ``[start, start + n)``.
+
+          The tokens before ``start`` must have been written already.
+
+          Args:
+              seq (int): The id of the sequence.
+              start (int): The position of the first token.
+              keys (array): The keys of shape ``(n_kv_heads, n, head_dim)``.
+              values (array): The values with the same shape as the keys.
+          )pbdoc")
+      .def(
+          "block_table",
+          &fast::PrefixCache::block_table,
+          "seq"_a,
+          R"pbdoc(
+          The pages of the sequence in order, a row of the block table of
+          :func:`paged_attention`.
+          )pbdoc")
+      .def(
+          "release",
+          &fast::PrefixCache::release,
+          "seq"_a,
+          R"pbdoc(
+          End the sequence. Its indexed pages stay in the pool for reuse.
+          )pbdoc");
+
+  m.def(
+      "quantized_matmul",
+      &fast::quantized_matmul,
+      "x"_a,
+      "w"_a,
+      "scales"_a,
+      "biases"_a,
+      "transpose"_a = true,
+      "group_size"_a = 64,
+      "bits"_a = 4,
+      nb::kw_only(),
+      "bias"_a = nb::none(),
+      "gate"_a = nb::none(),
+      "residual"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_matmul(x: array, w: array, scales: array, biases: array, transpose: bool = True, group_size: int = 64, bits: int = 4, *, bias: Optional[array] = None, gate: Optional[array] = None, residual: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Quantized matrix multiplication with a fused epilogue.
+
+        Computes ``silu(gate) * (quantized_matmul(x, w, ...) + bias) +
+        residual`` where each of ``bias``, ``gate`` and ``residual`` can be
+        omitted. On the GPU the epilogue is applied before the product is
+        written to memory, for instance to compute the up projection of a
+        SwiGLU MLP together with its activation or to add the residual
+        connection to the down projection.
+
+        Args:
+            x (array): Input array
+            w (array): Quantized matrix packed in unsigned integers
+            scales (array): The scales to use per ``group_size`` elements of ``w``
+            biases (array): The biases to use per ``group_size`` elements of ``w``
+            transpose (bool, optional): Defines whether to multiply with the
+              transposed ``w`` or not, namely whether we are performing
+              ``x @ w.T`` or ``x @ w``. Default: ``True``.
+            group_size (int, optional): The size of the group in ``w`` that
+              shares a scale and bias. Default: ``64``.
+            bits (int, optional): The number of bits occupied by each element in
+              ``w``. Default: ``4``.
+            bias (array, optional): Added to each row of the product.
+            gate (array, optional): Multiplies the output by ``silu(gate)``,
+              it has the shape of the output.
+            residual (array, optional): Added to the output, it has the shape
+              of the output.
+
+        Returns:
+            array: The result of the multiplication and epilogue.
+      )pbdoc");
+
+  m.def(
+      "quantized_matmul_w8a8",
+      &fast::quantized_matmul_w8a8,
+      "x"_a,
+      "w"_a,
+      "scales"_a,
+      "biases"_a,
+      nb::kw_only(),
+      "group_size"_a = 64,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_matmul_w8a8(x: array, w: array, scales: array, biases: array, *, group_size: int = 64, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Quantized matrix multiplication with 8 bit weights and activations.
+
+        Computes ``x @ w.T`` like :func:`mlx.core.quantized_matmul` with
+        ``bits=8`` but also quantizes ``x`` on the fly to ``int8`` with one
+        scale per row. On the GPU the products of the integers are
+        accumulated in ``int32`` and the scales and biases of ``w`` are
+        applied once per group, which speeds up large batches such as
+        prompt processing at the cost of the precision of ``x``.
+
+        Args:
+            x (array): Input array with shape ``(..., D)``.
+            w (array): Quantized matrix packed in unsigned integers with
+              ``bits=8``.
+            scales (array): The scales to use per ``group_size`` elements of ``w``
+            biases (array): The biases to use per ``group_size`` elements of ``w``
+            group_size (int, optional): The size of the group in ``w`` that
+              shares a scale and bias. Default: ``64``.
+
+        Returns:
+            array: The result of the multiplication.
+      )pbdoc");
+
+  m.def(
+      "quantized_lora_matmul",
+      &fast::quantized_lora_matmul,
+      "x"_a,
+      "w"_a,
+      "scales"_a,
+      "biases"_a,
+      "lora_a"_a,
+      "lora_b"_a,
+      "scale"_a = 1.0,
+      nb::kw_only(),
+      "adapter_ids"_a = nb::none(),
+      "group_size"_a = 64,
+      "bits"_a = 4,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_lora_matmul(x: array, w: array, scales: array, biases: array, lora_a: array, lora_b: array, scale: float = 1.0, *, adapter_ids: Optional[array] = None, group_size: int = 64, bits: int = 4, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Quantized matrix multiplication with a LoRA adapter.
+
+        Computes ``quantized_matmul(x, w, ...) + scale * (x @ lora_a.T) @
+        lora_b.T``. On the GPU the low-rank update is accumulated by the
+        quantized matmul kernel, so the base and adapter products are written
+        to memory once.
+
+        To serve several adapters in a batch, stack their matrices and pass
+        the adapter of each row of ``x`` in ``adapter_ids``. Rows sorted by
+        adapter are the fastest.
+
+        Args:
+            x (array): Input array with shape ``(..., D)``.
+            w (array): Quantized matrix packed in unsigned integers
+            scales (array): The scales to use per ``group_size`` elements of ``w``
+            biases (array): The biases to use per ``group_size`` elements of ``w``
+            lora_a (array): The first adapter matrix with shape ``(r, D)``, or
+              ``(n, r, D)`` with ``adapter_ids``.
+            lora_b (array): The second adapter matrix with shape ``(O, r)``,
+              or ``(n, O, r)`` with ``adapter_ids``.
+            scale (float, optional): Scale of the low-rank update.
+              Default: ``1.0``.
+            adapter_ids (array, optional): Integer adapter ids with shape
+              ``x.shape[:-1]``.
+            group_size (int, optional): The size of the group in ``w`` that
+              shares a scale and bias. Default: ``64``.
+            bits (int, optional): The number of bits occupied by each element in
+              ``w``. Default: ``4``.
+
+        Returns:
+            array: The result of the multiplication.
+      )pbdoc");
+
+  m.def(
+      "conv_general",
+      [](const array& input,
+         const array& weight,
+         const std::variant<int, std::vector<int>>& stride,
+         const std::variant<
+             int,
+             std::vector<int>,
+             std::pair<std::vector<int>, std::vector<int>>>& padding,
+         const std::variant<int, std::vector<int>>& kernel_dilation,
+         const std::variant<int, std::vector<int>>& input_dilation,
+         int groups,
+         bool flip,
+         const std::optional<array>& bias,
+         const std::optional<std::string>& activation,
+         StreamOrDevice s) {
+        auto to_vector = [](const std::variant<int, std::vector<int>>& v) {
+          if (auto pv = std::get_if<int>(&v); pv) {
+            return std::vector<int>{*pv};
+          }
+          return std::get<std::vector<int>>(v);
+        };
+
+        std::vector<int> padding_lo_vec;
+        std::vector<int> padding_hi_vec;
+        if (auto pv = std::get_if<int>(&padding); pv) {
+          padding_lo_vec.push_back(*pv);
+          padding_hi_vec.push_back(*pv);
+        } else if (auto pv = std::get_if<std::vector<int>>(&padding); pv) {
+          padding_lo_vec = *pv;
+          padding_hi_vec = *pv;
+        } else {
+          auto [pl, ph] =
+              std::get<std::pair<std::vector<int>, std::vector<int>>>(padding);
+          padding_lo_vec = pl;
+          padding_hi_vec = ph;
+        }
+
+        return fast::conv_general(
+            input,
+            weight,
+            to_vector(stride),
+            std::move(padding_lo_vec),
+            std::move(padding_hi_vec),
+            to_vector(kernel_dilation),
+            to_vector(input_dilation),
+            groups,
+            flip,
+            bias,
+            activation.value_or(""),
+            s);
+      },
+      nb::arg(),
+      nb::arg(),
+      "stride"_a = 1,
+      "padding"_a = 0,
+      "kernel_dilation"_a = 1,
+      "input_dilation"_a = 1,
+      "groups"_a = 1,
+      "flip"_a = false,
+      nb::kw_only(),
+      "bias"_a = nb::none(),
+      "activation"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def conv_general(input: array, weight: array, /, stride: Union[int, Sequence[int]] = 1, padding: Union[int, Sequence[int], Tuple[Sequence[int], Sequence[int]]] = 0, kernel_dilation: Union[int, Sequence[int]] = 1, input_dilation: Union[int, Sequence[int]] = 1, groups: int = 1, flip: bool = false, *, bias: Optional[array] = None, activation: Optional[str] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        General convolution with a fused bias and activation.
+
+        Computes ``activation(conv_general(input, weight, ...) + bias)``. On
+        the GPU the bias and activation are applied to the accumulators of the
+        convolution before the output is written, for instance for the
+        convolutions of a decoder followed by a bias and nonlinearity.
+
+        Args:
+            input (array): Input array of shape ``(N, ..., C_in)``
+            weight (array): Weight array of shape ``(C_out, ..., C_in)``
+            stride (int or list(int), optional): :obj:`list` with kernel strides.
+                All spatial dimensions get the same stride if
+                only one number is specified. Default: ``1``.
+            padding (int, list(int), or tuple(list(int), list(int)), optional):
+                :obj:`list` with input padding. All spatial dimensions get the same
+                padding if only one number is specified. Default: ``0``.
+            kernel_dilation (int or list(int), optional): :obj:`list` with
+                kernel dilation. All spatial dimensions get the same dilation
+                if only one number is specified. Default: ``1``
+            input_dilation (int or list(int), optional): :obj:`list` with
+                input dilation. All spatial dimensions get the same dilation
+                if only one number is specified. Default: ``1``
+            groups (int, optional): Input feature groups. Default: ``1``.
+            flip (bool, optional): Flip the order in which the spatial dimensions of
+                the weights are processed. Default: ``False``.
+            bias (array, optional): Added to each output channel, it has shape
+                ``(C_out,)``.
+            activation (str, optional): One of ``"relu"``, ``"silu"`` or
+                ``"gelu"`` applied after the bias. Default: ``None``.
+
+        Returns:
+            array: The convolved array.
+      )pbdoc");
+  m.def(
+      "metal_kernel",
+      [](const std::string& name,
+         const std::vector<std::string>& input_names,
+         const std::vector<std::string>& output_names,
+         const std::string& source,
+         const std::string& header,
+         bool ensure_row_contiguous,
+         bool atomic_outputs) {
+        auto kernel = fast::metal_kernel(
+            name,
+            input_names,
+            output_names,
+            source,
+            header,
+            ensure_row_contiguous,
+            atomic_outputs);
+        return nb::cpp_function(
+            [kernel = std::move(kernel)](
+                const std::vector<ScalarOrArray>& inputs_,
+                const std::vector<std::vector<int>>& output_shapes,
+                const std::vector<Dtype>& output_dtypes,
+                std::tuple<int, int, int> grid,
+                std::tuple<int, int, int> threadgroup,
+                const std::optional<
+                    std::vector<std::pair<std::string, nb::object>>>&
+                    template_args_,
+                std::optional<float> init_value,
+                bool verbose,
+                StreamOrDevice s) {
+              std::vector<array> inputs;
+              for (auto& v : inputs_) {
+                inputs.push_back(to_array(v));
+              }
+              std::vector<std::pair<std::string, fast::TemplateArg>>
+                  template_args;
+              for (auto& [name, value] : template_args_.value_or(
+                       std::vector<std::pair<std::string, nb::object>>{})) {
+                // bool is checked first since it is a subclass of int
+                if (nb::isinstance<nb::bool_>(value)) {
+                  template_args.emplace_back(name, nb::cast<bool>(value));
+                } else if (nb::isinstance<nb::int_>(value)) {
+                  template_args.emplace_back(name, nb::cast<int>(value));
+                } else if (nb::isinstance<Dtype>(value)) {
+                  template_args.emplace_back(name, nb::cast<Dtype>(value));
+                } else {
+                  throw std::invalid_argument(
+                      "[metal_kernel] Template arguments must be a bool, an "
+                      "int or a Dtype.");
+                }
+              }
+              return kernel(
+                  inputs,
+                  output_shapes,
+                  output_dtypes,
+                  grid,
+                  threadgroup,
+                  template_args,
+                  init_value,
+                  verbose,
+                  s);
+            },
+            nb::kw_only(),
+            "inputs"_a,
+            "output_shapes"_a,
+            "output_dtypes"_a,
+            "grid"_a,
+            "threadgroup"_a,
+            "template"_a = nb::none(),
+            "init_value"_a = nb::none(),
+            "verbose"_a = false,
+            "stream"_a = nb::none(),
+            R"pbdoc(
+              Run the kernel.
+
+              Args:
+                inputs (List[array]): The inputs passed to the kernel.
+                output_shapes (List[Sequence[int]]): The shape of each output.
+                output_dtypes (List[Dtype]): The dtype of each output.
+                grid (tuple[int, int, int]): The number of threads in each
+                  dimension of the grid.
+                threadgroup (tuple[int, int, int]): The number of threads in
+                  each dimension of a threadgroup.
+                template (List[Tuple[str, Union[bool, int, Dtype]]], optional):
+                  The template parameters of the kernel and their values.
+                init_value (float, optional): The value the outputs are filled
+                  with before the kernel runs. Default: ``None``, the outputs
+                  are not initialized.
+                verbose (bool, optional): Print the generated source of the
+                  kernel. Default: ``False``.
+
+              Returns:
+                List[array]: The outputs.
+            )pbdoc");
+      },
+      "name"_a,
+      "input_names"_a,
+      "output_names"_a,
+      "source"_a,
+      "header"_a = "",
+      "ensure_row_contiguous"_a = true,
+      "atomic_outputs"_a = false,
+      R"pbdoc(
+        Make a custom Metal kernel that can be called like an op.
+
+        The ``source`` is the body of the kernel. Its signature is generated
+        from the inputs, outputs and template arguments of each call. The
+        source can use ``<input>_shape``, ``<input>_strides`` and
+        ``<input>_ndim`` for the inputs with at least one dimension, and
+        Metal attributes such as ``thread_position_in_grid``, which are added
+        to the signature when they are used. Each specialization is compiled
+        once and cached, and the kernel can be used in :func:`mlx.core.compile`.
+
+        Args:
+          name (str): The name of the kernel.
+          input_names (List[str]): The names of the inputs in the source.
+          output_names (List[str]): The names of the outputs in the source.
+          source (str): The body of the kernel.
+          header (str, optional): Source that goes before the kernel, such as
+            includes and helper functions. Default: ``""``.
+          ensure_row_contiguous (bool, optional): Copy the inputs which are not
+            row contiguous before the kernel runs. Default: ``True``.
+          atomic_outputs (bool, optional): Make the outputs
+            ``device atomic<T>*``. Default: ``False``.
+
+        Returns:
+          Callable ``kernel(*, inputs, output_shapes, output_dtypes, grid,
+          threadgroup, template=None, init_value=None, verbose=False,
+          stream=None)`` which returns the list of outputs.
+
+        Example:
+
+          .. code-block:: python
+
+            source = """
+                uint elem = thread_position_in_grid.x;
+                T tmp = inp[elem];
+                out[elem] = metal::exp(tmp);
+            """
+
+            kernel = mx.fast.metal_kernel(
+                name="myexp",
+                input_names=["inp"],
+                output_names=["out"],
+                source=source,
+            )
+
+            a = mx.random.normal(shape=(4, 16))
+            out = kernel(
+                inputs=[a],
+                template=[("T", mx.float32)],
+                grid=(a.size, 1, 1),
+                threadgroup=(256, 1, 1),
+                output_shapes=[a.shape],
+                output_dtypes=[a.dtype],
+            )
+            assert mx.allclose(mx.exp(a), out[0])
+      )pbdoc");
 }
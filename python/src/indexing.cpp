@@ -100,6 +100,19 @@ array mlx_get_item_int(const array& src, const nb::int_& idx) {
         "too many indices for array: array is 0-dimensional");
   }
 
+  // An index in bounds is a slice of the first axis which is cheaper than
+  // a gather and is updated in place by the slice update in __setitem__
+  int i = nb::cast<int>(idx);
+  i = (i < 0) ? i + src.shape(0) : i;
+  if (i >= 0 && i < src.shape(0)) {
+    std::vector<int> starts(src.ndim(), 0);
+    std::vector<int> ends = src.shape();
+    starts[0] = i;
+    ends[0] = i + 1;
+    std::vector<int> out_shape(src.shape().begin() + 1, src.shape().end());
+    return reshape(slice(src, starts, ends), out_shape);
+  }
+
   // If only one input idx is mentioned, we set axis=0 in take
   // for parity with np
   return take(src, get_int_index(idx, src.shape(0)), 0);
@@ -782,8 +795,12 @@ mlx_compute_scatter_args(
 
 auto mlx_slice_update(
     const array& src,
-    const nb::object& obj,
+    const nb::object& obj_,
     const ScalarOrArray& v) {
+  // An integer is the same as a tuple with one integer
+  nb::object obj =
+      nb::isinstance<nb::int_>(obj_) ? nb::make_tuple(obj_) : obj_;
+
   // Can't route to slice update if not slice or tuple
   if (src.ndim() == 0 ||
       (!nb::isinstance<nb::slice>(obj) && !nb::isinstance<nb::tuple>(obj))) {
@@ -290,4 +290,147 @@ void init_linalg(nb::module_& parent_module) {
           that ``dot(L, L.T) = a``.  If ``upper = True``, it returns an upper triangular
           ``U`` matrix such that ``dot(U.T, U) = a``.
       )pbdoc");
+  m.def(
+      "solve",
+      &solve,
+      "a"_a,
+      "b"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def solve(a: array, b: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Solve ``a @ x = b`` for a square matrix ``a``.
+
+        This is faster and more accurate than multiplying with the inverse
+        of ``a``. The batch dimensions of ``a`` and ``b`` are broadcast
+        together.
+
+        Args:
+            a (array): Input array of square matrices.
+            b (array): The right hand side, a vector or an array of matrices.
+            stream (Stream, optional): Stream or device. Defaults to ``None``
+              in which case the default stream of the default device is used.
+
+        Returns:
+            array: The solution ``x`` with the shape of ``b``.
+
+        Example:
+            >>> A = mx.array([[3., 1.], [1., 2.]])
+            >>> b = mx.array([9., 8.])
+            >>> mx.linalg.solve(A, b)
+            array([2, 3], dtype=float32)
+      )pbdoc");
+  m.def(
+      "solve_triangular",
+      &solve_triangular,
+      "a"_a,
+      "b"_a,
+      nb::kw_only(),
+      "upper"_a = false,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def solve_triangular(a: array, b: array, *, upper: bool = False, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Solve ``a @ x = b`` for a triangular matrix ``a``.
+
+        Only the lower triangle of ``a`` is read, or the upper one if
+        ``upper = True``. The batch dimensions of ``a`` and ``b`` are
+        broadcast together.
+
+        Args:
+            a (array): Input array of triangular matrices.
+            b (array): The right hand side, a vector or an array of matrices.
+            upper (bool, optional): Whether ``a`` is upper triangular.
+              Default: ``False``.
+            stream (Stream, optional): Stream or device. Defaults to ``None``
+              in which case the default stream of the default device is used.
+
+        Returns:
+            array: The solution ``x`` with the shape of ``b``.
+      )pbdoc");
+  m.def(
+      "cho_solve",
+      &cho_solve,
+      "L"_a,
+      "b"_a,
+      "upper"_a = false,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def cho_solve(L: array, b: array, upper: bool = False, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Solve ``a @ x = b`` given the Cholesky factor ``L`` of ``a``.
+
+        The system is solved with two triangular solves, which is cheaper
+        than a general :func:`solve` when the factor is reused.
+
+        Args:
+            L (array): The Cholesky factor as returned by :func:`cholesky`.
+            b (array): The right hand side, a vector or an array of matrices.
+            upper (bool, optional): Whether ``L`` is the upper triangular
+              factor. Default: ``False``.
+            stream (Stream, optional): Stream or device. Defaults to ``None``
+              in which case the default stream of the default device is used.
+
+        Returns:
+            array: The solution ``x`` with the shape of ``b``.
+      )pbdoc");
+  m.def(
+      "eigh",
+      &eigh,
+      "a"_a,
+      "UPLO"_a = "L",
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def eigh(a: array, UPLO: str = 'L', *, stream: Union[None, Stream, Device] = None) -> Tuple[array, array]"),
+      R"pbdoc(
+        The eigenvalues and eigenvectors of a real symmetric matrix.
+
+        This function supports arrays with at least 2 dimensions. The
+        matrices are assumed to be in the last two dimensions of the input.
+        Only the lower triangle is read, or the upper one if ``UPLO = "U"``.
+
+        Args:
+            a (array): Input array.
+            UPLO (str, optional): The triangle of ``a`` to use, ``"L"`` or
+              ``"U"``. Default: ``"L"``.
+            stream (Stream, optional): Stream or device. Defaults to ``None``
+              in which case the default stream of the default device is used.
+
+        Returns:
+            tuple(array, array): The eigenvalues in ascending order and the
+            matrix whose columns are the corresponding eigenvectors.
+
+        Example:
+            >>> A = mx.array([[2., 1.], [1., 2.]])
+            >>> w, V = mx.linalg.eigh(A)
+            >>> w
+            array([1, 3], dtype=float32)
+      )pbdoc");
+  m.def(
+      "eigvalsh",
+      &eigvalsh,
+      "a"_a,
+      "UPLO"_a = "L",
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def eigvalsh(a: array, UPLO: str = 'L', *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        The eigenvalues of a real symmetric matrix.
+
+        This is :func:`eigh` without the eigenvectors.
+
+        Args:
+            a (array): Input array.
+            UPLO (str, optional): The triangle of ``a`` to use, ``"L"`` or
+              ``"U"``. Default: ``"L"``.
+            stream (Stream, optional): Stream or device. Defaults to ``None``
+              in which case the default stream of the default device is used.
+
+        Returns:
+            array: The eigenvalues in ascending order.
+      )pbdoc");
 }
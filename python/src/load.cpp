@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "mlx/io/deflate.h"
 #include "mlx/io/load.h"
 #include "mlx/ops.h"
 #include "mlx/utils.h"
@@ -162,7 +163,9 @@ std::pair<
     std::unordered_map<std::string, std::string>>
 mlx_load_safetensor_helper(nb::object file, StreamOrDevice s) {
   if (nb::isinstance<nb::str>(file)) { // Assume .safetensors file path string
-    return load_safetensors(nb::cast<std::string>(file), s);
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    return load_safetensors(path, s);
   } else if (is_istream_object(file)) {
     // If we don't own the stream and it was passed to us, eval immediately
     auto res = load_safetensors(std::make_shared<PyFileReader>(file), s);
@@ -181,7 +184,9 @@ mlx_load_safetensor_helper(nb::object file, StreamOrDevice s) {
 
 GGUFLoad mlx_load_gguf_helper(nb::object file, StreamOrDevice s) {
   if (nb::isinstance<nb::str>(file)) { // Assume .gguf file path string
-    return load_gguf(nb::cast<std::string>(file), s);
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    return load_gguf(path, s);
   }
 
   throw std::invalid_argument("[load_gguf] Input must be a string");
@@ -192,6 +197,32 @@ std::unordered_map<std::string, array> mlx_load_npz_helper(
     StreamOrDevice s) {
   bool own_file = nb::isinstance<nb::str>(file);
 
+  // Archives are read natively when possible, anything else such as members
+  // compressed with other methods goes through zipfile
+  if (own_file) {
+    auto path = nb::cast<std::string>(file);
+    try {
+      nb::gil_scoped_release nogil;
+      return load_npz(path, s);
+    } catch (const std::invalid_argument&) {
+    } catch (const std::runtime_error&) {
+    }
+  } else if (is_istream_object(file)) {
+    // If we don't own the stream and it was passed to us, eval immediately
+    auto reader = std::make_shared<PyFileReader>(file);
+    try {
+      nb::gil_scoped_release nogil;
+      auto res = load_npz(reader, s);
+      for (auto& [key, arr] : res) {
+        arr.eval();
+      }
+      return res;
+    } catch (const std::invalid_argument&) {
+    } catch (const std::runtime_error&) {
+    } catch (const nb::python_error&) {
+    }
+  }
+
   nb::module_ zipfile = nb::module_::import_("zipfile");
   if (!is_zip_file(zipfile, file)) {
     throw std::invalid_argument(
@@ -232,7 +263,9 @@ std::unordered_map<std::string, array> mlx_load_npz_helper(
 
 array mlx_load_npy_helper(nb::object file, StreamOrDevice s) {
   if (nb::isinstance<nb::str>(file)) { // Assume .npy file path string
-    return load(nb::cast<std::string>(file), s);
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    return load(path, s);
   } else if (is_istream_object(file)) {
     // If we don't own the stream and it was passed to us, eval immediately
     auto arr = load(std::make_shared<PyFileReader>(file), s);
@@ -374,7 +407,9 @@ class PyFileWriter : public io::Writer {
 
 void mlx_save_helper(nb::object file, array a) {
   if (nb::isinstance<nb::str>(file)) {
-    save(nb::cast<std::string>(file), a);
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    save(path, a);
     return;
   } else if (is_ostream_object(file)) {
     auto writer = std::make_shared<PyFileWriter>(file);
@@ -423,6 +458,24 @@ void mlx_savez_helper(
     arrays_dict.insert({arr_name, arrays_list[i]});
   }
 
+  // Paths and seekable streams are written natively
+  bool native = !compressed || io::detail::deflate_available();
+  if (native && nb::isinstance<nb::str>(file)) {
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    savez(path, arrays_dict, compressed);
+    return;
+  } else if (
+      native && is_ostream_object(file) && nb::hasattr(file, "seekable") &&
+      nb::cast<bool>(file.attr("seekable")())) {
+    auto writer = std::make_shared<PyFileWriter>(file);
+    {
+      nb::gil_scoped_release nogil;
+      savez(writer, arrays_dict, compressed);
+    }
+    return;
+  }
+
   // Create python ZipFile object depending on compression
   nb::module_ zipfile = nb::module_::import_("zipfile");
   int compression = nb::cast<int>(
@@ -462,9 +515,10 @@ void mlx_save_safetensor_helper(
   }
   auto arrays_map = nb::cast<std::unordered_map<std::string, array>>(d);
   if (nb::isinstance<nb::str>(file)) {
+    auto path = nb::cast<std::string>(file);
     {
       nb::gil_scoped_release nogil;
-      save_safetensors(nb::cast<std::string>(file), arrays_map, metadata_map);
+      save_safetensors(path, arrays_map, metadata_map);
     }
   } else if (is_ostream_object(file)) {
     auto writer = std::make_shared<PyFileWriter>(file);
@@ -484,17 +538,18 @@ void mlx_save_gguf_helper(
     std::optional<nb::dict> m) {
   auto arrays_map = nb::cast<std::unordered_map<std::string, array>>(a);
   if (nb::isinstance<nb::str>(file)) {
+    auto path = nb::cast<std::string>(file);
     if (m) {
       auto metadata_map =
           nb::cast<std::unordered_map<std::string, GGUFMetaData>>(m.value());
       {
         nb::gil_scoped_release nogil;
-        save_gguf(nb::cast<std::string>(file), arrays_map, metadata_map);
+        save_gguf(path, arrays_map, metadata_map);
       }
     } else {
       {
         nb::gil_scoped_release nogil;
-        save_gguf(nb::cast<std::string>(file), arrays_map);
+        save_gguf(path, arrays_map);
       }
     }
   } else {
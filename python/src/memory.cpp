@@ -0,0 +1,254 @@
+// Copyright © 2024 Apple Inc.
+
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/function.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/string.h>
+
+#include <set>
+
+#include "mlx/memory.h"
+
+namespace nb = nanobind;
+using namespace nb::literals;
+
+using namespace mlx::core;
+
+// Create the memory::Tag on enter and delete on exit.
+class PyMemoryTag {
+ public:
+  PyMemoryTag(std::string name) : _name(std::move(name)), _inner(nullptr) {}
+
+  void enter() {
+    _inner = new memory::Tag(_name);
+  }
+
+  void exit() {
+    if (_inner != nullptr) {
+      delete _inner;
+      _inner = nullptr;
+    }
+  }
+
+ private:
+  std::string _name;
+  memory::Tag* _inner;
+};
+
+// The ids of the callbacks added from Python, removed at exit so they are
+// not released after the interpreter
+std::set<int>& py_pressure_callbacks() {
+  static std::set<int> ids;
+  return ids;
+}
+
+void init_memory(nb::module_& parent_module) {
+  auto m = parent_module.def_submodule(
+      "memory", "mlx.core.memory: track the allocated buffers");
+  m.def(
+      "start_tracking",
+      &memory::start_tracking,
+      R"pbdoc(
+      Start tracking the buffers allocated on every device.
+
+      Records from an earlier tracking are cleared and buffers allocated
+      before are not tracked. While tracking, every allocation and free takes
+      a lock. Otherwise they only check a flag.
+      )pbdoc");
+  m.def(
+      "stop_tracking",
+      &memory::stop_tracking,
+      R"pbdoc(
+      Stop tracking and wait for the running work to finish.
+
+      The records are kept until tracking starts again.
+      )pbdoc");
+  m.def(
+      "is_tracking",
+      &memory::is_tracking,
+      R"pbdoc(
+      Check if allocations are being tracked.
+      )pbdoc");
+  m.def(
+      "live_allocations",
+      []() {
+        nb::list out;
+        for (auto& a : memory::live_allocations()) {
+          nb::dict d;
+          d["size"] = a.size;
+          d["primitive"] = a.primitive;
+          d["tag"] = a.tag;
+          d["time"] = a.time;
+          out.append(d);
+        }
+        return out;
+      },
+      R"pbdoc(
+      Get the tracked buffers which have not been freed, largest first.
+
+      Returns:
+          list(dict): A dictionary per buffer with its ``size`` in bytes, the
+          ``primitive`` whose evaluation allocated it (empty if it was
+          allocated outside of an evaluation), the ``tag`` of the enclosing
+          :class:`tag` contexts separated by ``"/"`` and the ``time`` it was
+          allocated in nanoseconds since tracking started.
+      )pbdoc");
+  m.def(
+      "timeline",
+      []() {
+        nb::list out;
+        for (auto& s : memory::timeline()) {
+          out.append(nb::make_tuple(s.time, s.active));
+        }
+        return out;
+      },
+      R"pbdoc(
+      Get the active memory after each allocation and free since tracking
+      started.
+
+      At most one million samples are kept.
+
+      Returns:
+          list(tuple(int, int)): The time in nanoseconds since tracking
+          started and the active memory in bytes of each sample, in order.
+      )pbdoc");
+  m.def(
+      "report",
+      &memory::report,
+      "top"_a = 10,
+      R"pbdoc(
+      Summarize the memory use.
+
+      The summary has the active, peak and cache memory, the live tracked
+      bytes per primitive and tag and the ``top`` largest live buffers. When
+      tracking, it is also added to the error raised by a failed allocation.
+
+      Args:
+          top (int, optional): The number of buffers to list. Default: ``10``.
+
+      Returns:
+          str: The human readable summary.
+      )pbdoc");
+
+  nb::class_<PyMemoryTag>(m, "tag", R"pbdoc(
+        A context manager which tags the buffers allocated inside it.
+
+        The outputs of arrays evaluated inside the context are tagged too,
+        whichever stream they are evaluated on. Tags nest.
+
+        Example:
+
+        .. code-block:: python
+
+          mx.memory.start_tracking()
+          with mx.memory.tag("kv_cache"):
+              mx.eval(cache)
+          print(mx.memory.report())
+
+        Args:
+            name (str): The tag of the buffers.
+  )pbdoc")
+      .def(nb::init<std::string>(), "name"_a)
+      .def("__enter__", [](PyMemoryTag& t) { t.enter(); })
+      .def(
+          "__exit__",
+          [](PyMemoryTag& t,
+             const std::optional<nb::type_object>& exc_type,
+             const std::optional<nb::object>& exc_value,
+             const std::optional<nb::object>& traceback) { t.exit(); },
+          "exc_type"_a = nb::none(),
+          "exc_value"_a = nb::none(),
+          "traceback"_a = nb::none());
+
+  nb::enum_<memory::Pressure>(
+      m,
+      "Pressure",
+      R"pbdoc(
+      The memory pressure reported by the OS.
+      )pbdoc")
+      .value("normal", memory::Pressure::normal)
+      .value("warning", memory::Pressure::warning)
+      .value("critical", memory::Pressure::critical);
+  m.def(
+      "start_pressure_monitor",
+      &memory::start_pressure_monitor,
+      R"pbdoc(
+      Start reacting to the memory pressure notifications of the OS.
+
+      The notifications come from a dispatch source on macOS and a pressure
+      stall (PSI) trigger on ``/proc/pressure/memory`` on Linux. Each calls
+      :func:`handle_pressure` from a background thread.
+
+      Returns:
+          bool: ``False`` if the OS does not send notifications.
+      )pbdoc");
+  m.def(
+      "stop_pressure_monitor",
+      &memory::stop_pressure_monitor,
+      R"pbdoc(
+      Stop reacting to the memory pressure notifications of the OS.
+
+      It must not be called from a pressure callback.
+      )pbdoc");
+  m.def(
+      "is_monitoring_pressure",
+      &memory::is_monitoring_pressure,
+      R"pbdoc(
+      Check if the memory pressure notifications of the OS are handled.
+      )pbdoc");
+  m.def(
+      "handle_pressure",
+      &memory::handle_pressure,
+      nb::call_guard<nb::gil_scoped_release>(),
+      "level"_a,
+      R"pbdoc(
+      Trim the memory held by MLX and call the pressure callbacks.
+
+      On a warning the buffer cache is cleared, on a critical pressure the
+      prepacked weights are released as well.
+
+      Args:
+          level (Pressure): The memory pressure.
+      )pbdoc");
+  m.def(
+      "add_pressure_callback",
+      [](std::function<void(memory::Pressure)> callback) {
+        int id = memory::add_pressure_callback(std::move(callback));
+        py_pressure_callbacks().insert(id);
+        return id;
+      },
+      "callback"_a,
+      R"pbdoc(
+      Register a callback called on every memory pressure notification.
+
+      It is called with the :class:`Pressure` level after the caches are
+      trimmed, e.g. to drop application caches, possibly from a background
+      thread. Only macOS reports when the pressure goes back to normal.
+
+      Args:
+          callback (Callable[[Pressure], None]): The callback.
+
+      Returns:
+          int: An id to remove the callback with.
+      )pbdoc");
+  m.def(
+      "remove_pressure_callback",
+      [](int id) {
+        memory::remove_pressure_callback(id);
+        py_pressure_callbacks().erase(id);
+      },
+      "id"_a,
+      R"pbdoc(
+      Remove the pressure callback with the given id.
+      )pbdoc");
+
+  auto atexit = nb::module_::import_("atexit");
+  atexit.attr("register")(nb::cpp_function([]() {
+    nb::gil_scoped_release nogil;
+    memory::stop_pressure_monitor();
+    for (int id : py_pressure_callbacks()) {
+      memory::remove_pressure_callback(id);
+    }
+    py_pressure_callbacks().clear();
+  }));
+}
@@ -3,10 +3,13 @@
 #include "mlx/backend/metal/metal.h"
 #include <nanobind/nanobind.h>
 #include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/unordered_map.h>
 #include <nanobind/stl/variant.h>
 
+#include "python/src/trees.h"
+
 namespace nb = nanobind;
 using namespace nb::literals;
 
@@ -67,6 +70,11 @@ void init_metal(nb::module_& m) {
       if ``relaxed`` is ``False``. Otherwise memory will be allocated
       (including the potential for swap) if ``relaxed`` is ``True``.
 
+      Graphs whose outputs could exceed the memory left under the limit are
+      evaluated in an order which frees intermediates early and wait for the
+      GPU to catch up when too much work is in flight, so even
+      :func:`mlx.core.async_eval` can block on them.
+
       The memory limit defaults to 1.5 times the maximum recommended working set
       size reported by the device.
 
@@ -78,6 +86,15 @@ void init_metal(nb::module_& m) {
       Returns:
         int: The previous memory limit in bytes.
       )pbdoc");
+  metal.def(
+      "get_memory_limit",
+      &metal::get_memory_limit,
+      R"pbdoc(
+      Get the memory limit.
+
+      Returns:
+        int: The memory limit in bytes, ``0`` if there is no limit.
+      )pbdoc");
   metal.def(
       "set_cache_limit",
       &metal::set_cache_limit,
@@ -106,7 +123,168 @@ void init_metal(nb::module_& m) {
 
       After calling this, :func:`get_cache_memory` should return ``0``.
       )pbdoc");
+  metal.def(
+      "get_cache_stats",
+      &metal::get_cache_stats,
+      R"pbdoc(
+      Get statistics about the memory cache.
+
+      The counts are accumulated since the program started or the last call
+      to :func:`reset_cache_stats`. Currently returns:
 
+      * ``hits``: allocations served from the cache
+      * ``misses``: allocations which needed new memory
+      * ``wasted_bytes``: bytes by which reused buffers were larger than
+        requested
+      * ``evictions``: cached buffers released to stay under the memory or
+        cache limit
+
+      Returns:
+          dict: A dictionary of the statistics.
+      )pbdoc");
+  metal.def(
+      "reset_cache_stats",
+      &metal::reset_cache_stats,
+      R"pbdoc(
+      Reset the memory cache statistics to zero.
+      )pbdoc");
+  metal.def(
+      "set_wired_limit",
+      &metal::set_wired_limit,
+      "limit"_a,
+      R"pbdoc(
+      Set the wired size limit.
+
+      Arrays made resident with :func:`make_resident` are wired, i.e. kept in
+      memory and not paged out or compressed by the OS, as long as their total
+      size is within the limit. If it is exceeded none of them are wired until
+      arrays are freed or the limit is raised.
+
+      The limit defaults to ``0`` and may not be larger than the maximum
+      recommended working set size reported by
+      :func:`device_info`. Wiring memory needs macOS 15 or newer and is a
+      no-op otherwise.
+
+      Args:
+        limit (int): The wired limit in bytes.
+
+      Returns:
+        int: The previous wired limit in bytes.
+      )pbdoc");
+  metal.def(
+      "get_wired_memory",
+      &metal::get_wired_memory,
+      R"pbdoc(
+      Get the wired memory in bytes.
+      )pbdoc");
+  metal.def(
+      "make_resident",
+      [](const nb::object& arrays) {
+        metal::make_resident(tree_flatten(arrays, false));
+      },
+      "arrays"_a,
+      R"pbdoc(
+      Make the memory of arrays resident, evaluating them if needed.
+
+      The memory stays resident, subject to :func:`set_wired_limit`, until it
+      is freed. This avoids latency spikes when large weights which were paged
+      out while the GPU was idle are used again.
+
+      Args:
+          arrays (Any): An array or tree of arrays such as the parameters of a
+            model.
+      )pbdoc");
+  metal.def(
+      "prepack",
+      [](const nb::object& weights) {
+        metal::prepack(tree_flatten(weights, false));
+      },
+      "weights"_a,
+      R"pbdoc(
+      Prepack weights, evaluating them if needed.
+
+      The layouts the GPU kernels compute from a prepacked weight, such as
+      the Winograd transform or the contiguous copy of a convolution filter,
+      are kept and reused instead of being recomputed on every call. They
+      take extra memory and are released with the weight once it is not used
+      anywhere else. Useful for inference.
+
+      Args:
+          weights (Any): An array or tree of arrays such as the parameters of
+            a model.
+      )pbdoc");
+  metal.def(
+      "clear_prepacked",
+      &metal::clear_prepacked,
+      R"pbdoc(
+      Release every prepacked weight and the layouts computed from it.
+      )pbdoc");
+
+  metal.def(
+      "precompile",
+      [](const nb::object& arrays) {
+        metal::precompile(tree_flatten(arrays, false));
+      },
+      "arrays"_a,
+      R"pbdoc(
+      Compile the GPU kernels needed to evaluate ``arrays`` without
+      evaluating them.
+
+      The compiled kernels are kept in memory and in the on-disk kernel
+      cache, so the first evaluation of a similar graph does not have to
+      compile them. This is useful to warm up a server before it receives
+      requests, for example:
+
+      .. code-block:: python
+
+        model = mx.compile(model)
+        mx.metal.precompile(model(mx.zeros((1, 128), mx.int32)))
+
+      No other work should run on the GPU while the kernels are compiled.
+
+      Args:
+        arrays: An array or a tree of arrays (e.g. a list or dict) which
+          are left unevaluated.
+      )pbdoc");
+  metal.def(
+      "start_profiling",
+      &metal::start_profiling,
+      R"pbdoc(
+      Start recording the GPU time of each primitive.
+
+      Records from an earlier profile are cleared. Primitives are timed one
+      at a time, so the kernels of different primitives do not overlap while
+      profiling.
+      )pbdoc");
+  metal.def(
+      "stop_profiling",
+      &metal::stop_profiling,
+      R"pbdoc(
+      Stop recording and wait for the profiled work to finish.
+      )pbdoc");
+  metal.def(
+      "get_profile",
+      &metal::get_profile,
+      R"pbdoc(
+      Get the GPU time of each primitive type recorded since
+      :func:`start_profiling`.
+
+      Returns:
+          dict: A dictionary from primitive name to a tuple of the number of
+          evaluations and the total GPU time in milliseconds.
+      )pbdoc");
+  metal.def(
+      "save_profile_trace",
+      &metal::save_profile_trace,
+      "path"_a,
+      R"pbdoc(
+      Save the recorded primitives as a Chrome trace.
+
+      The trace can be opened in ``chrome://tracing`` or Perfetto.
+
+      Args:
+        path (str): The path of the JSON file to write.
+      )pbdoc");
   metal.def(
       "start_capture",
       &metal::start_capture,
@@ -19,6 +19,10 @@ void init_linalg(nb::module_&);
 void init_constants(nb::module_&);
 void init_fast(nb::module_&);
 void init_distributed(nb::module_&);
+void init_profiler(nb::module_&);
+void init_memory(nb::module_&);
+void init_sparse(nb::module_&);
+void init_ragged(nb::module_&);
 
 NB_MODULE(core, m) {
   m.doc() = "mlx: A framework for machine learning on Apple silicon.";
@@ -39,6 +43,10 @@ NB_MODULE(core, m) {
   init_constants(m);
   init_fast(m);
   init_distributed(m);
+  init_profiler(m);
+  init_memory(m);
+  init_sparse(m);
+  init_ragged(m);
 
   m.attr("__version__") = TOSTRING(_VERSION_);
 }
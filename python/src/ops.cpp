@@ -12,6 +12,7 @@
 #include <nanobind/stl/variant.h>
 #include <nanobind/stl/vector.h>
 
+#include "mlx/einsum.h"
 #include "mlx/ops.h"
 #include "mlx/utils.h"
 #include "python/src/load.h"
@@ -2372,6 +2373,61 @@ void init_ops(nb::module_& m) {
         Returns:
             list(array): A list of split arrays.
       )pbdoc");
+  m.def(
+      "cache_append",
+      [](const array& cache,
+         const array& update,
+         int offset,
+         int axis,
+         int step,
+         StreamOrDevice s) {
+        auto outs = cache_append(cache, update, offset, axis, step, s);
+        return std::make_pair(outs[0], outs[1]);
+      },
+      nb::arg(),
+      nb::arg(),
+      "offset"_a,
+      "axis"_a,
+      "step"_a = 256,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def cache_append(cache: array, update: array, /, offset: int, axis: int, step: int = 256, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        Append to a cache, e.g. of attention keys or values, in place.
+
+        The update is written at position ``offset`` along ``axis``. The
+        cache has room for ``cache.shape[axis]`` entries and grows to the
+        next multiple of ``step`` when the update does not fit. It is written
+        in place when it is not used elsewhere, otherwise its filled part is
+        copied. Appending at an ``offset`` before the end of the filled part
+        rolls the cache back without a copy, e.g. to drop draft tokens
+        rejected in speculative decoding.
+
+        Example:
+
+          >>> cache = mx.zeros((1, 8, 0, 64))
+          >>> for offset in range(4):
+          ...     k = mx.random.normal((1, 8, 1, 64))
+          ...     cache, keys = mx.cache_append(cache, k, offset, axis=2)
+          >>> cache.shape, keys.shape
+          ((1, 8, 256, 64), (1, 8, 4, 64))
+
+        Args:
+            cache (array): The cache.
+            update (array): The entries to append. It must match the shape
+              of the cache outside of ``axis``.
+            offset (int): The number of filled entries of the cache.
+            axis (int): The axis to append along.
+            step (int, optional): The number of entries the cache grows by.
+              Default: ``256``.
+
+        Returns:
+            tuple(array, array): The cache and a view of its first
+            ``offset + update.shape[axis]`` entries along ``axis``, which
+            can be passed to
+            :func:`fast.scaled_dot_product_attention` without a copy.
+      )pbdoc");
   m.def(
       "argmin",
       [](const array& a,
@@ -3036,6 +3092,129 @@ void init_ops(nb::module_& m) {
           inclusive (bool): The i-th element of the output includes the i-th
             element of the input.
       )pbdoc");
+  m.def(
+      "segment_sum",
+      &segment_sum,
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_sum(a: array, offsets: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Sum of the rows of ``a`` in each segment.
+
+        Segment ``b`` is the rows ``offsets[b]`` to ``offsets[b + 1]`` of the
+        first axis. Empty segments sum to zero.
+
+        Each segment is reduced on its own so, unlike adding the rows with
+        ``out.at[segment_ids].add(a)``, no atomics are needed.
+
+        Args:
+          a (array): Input array.
+          offsets (array): The non decreasing start of each segment followed
+            by the end of the last one.
+
+        Returns:
+          array: An array with one row per segment.
+      )pbdoc");
+  m.def(
+      "segment_mean",
+      &segment_mean,
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_mean(a: array, offsets: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Mean of the rows of ``a`` in each segment.
+
+        Segment ``b`` is the rows ``offsets[b]`` to ``offsets[b + 1]`` of the
+        first axis. Empty segments give zero.
+
+        Args:
+          a (array): Input array.
+          offsets (array): The non decreasing start of each segment followed
+            by the end of the last one.
+
+        Returns:
+          array: An array with one row per segment.
+      )pbdoc");
+  m.def(
+      "segment_max",
+      &segment_max,
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_max(a: array, offsets: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Maximum of the rows of ``a`` in each segment.
+
+        Segment ``b`` is the rows ``offsets[b]`` to ``offsets[b + 1]`` of the
+        first axis. Empty segments give the lowest value of the type.
+
+        Args:
+          a (array): Input array.
+          offsets (array): The non decreasing start of each segment followed
+            by the end of the last one.
+
+        Returns:
+          array: An array with one row per segment.
+      )pbdoc");
+  m.def(
+      "segment_min",
+      &segment_min,
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_min(a: array, offsets: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Minimum of the rows of ``a`` in each segment.
+
+        Segment ``b`` is the rows ``offsets[b]`` to ``offsets[b + 1]`` of the
+        first axis. Empty segments give the highest value of the type.
+
+        Args:
+          a (array): Input array.
+          offsets (array): The non decreasing start of each segment followed
+            by the end of the last one.
+
+        Returns:
+          array: An array with one row per segment.
+      )pbdoc");
+  m.def(
+      "segment_cumsum",
+      &segment_cumsum,
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "reverse"_a = false,
+      "inclusive"_a = true,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_cumsum(a: array, offsets: array, /, *, reverse: bool = False, inclusive: bool = True, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Cumulative sum of the rows of ``a`` restarting at every segment.
+
+        Segment ``b`` is the rows ``offsets[b]`` to ``offsets[b + 1]`` of the
+        first axis. Rows outside of every segment are zero.
+
+        Args:
+          a (array): Input array.
+          offsets (array): The non decreasing start of each segment followed
+            by the end of the last one.
+          reverse (bool): Perform the cumulative sum in reverse.
+          inclusive (bool): The i-th row of the output includes the i-th row
+            of the input.
+
+        Returns:
+          array: The cumulative sums with the shape of ``a``.
+      )pbdoc");
   m.def(
       "conj",
       [](const ScalarOrArray& a, StreamOrDevice s) {
@@ -3512,6 +3691,46 @@ void init_ops(nb::module_& m) {
           When loading unsupported quantization formats from GGUF, tensors
           will automatically cast to ``mx.float16``
       )pbdoc");
+  nb::class_<WeightStreamer>(
+      m,
+      "WeightStreamer",
+      R"pbdoc(
+        Stream the weights of a model larger than memory, layer by layer.
+
+        The weights stay in the files they were loaded from. Getting a layer
+        starts reading the next ``lookahead`` layers in the background, and
+        each use of a layer reads its weights again so they are freed once
+        they are no longer used. Pages of memory mapped files outside of the
+        lookahead are released when they and the active memory exceed the
+        memory limit, see :func:`metal.set_memory_limit`.
+
+        The weights must come from :func:`load` and must not be evaluated.
+        Other weights are passed through unchanged.
+
+        Args:
+            layers (list(dict(str, array))): The weights of each layer in
+              the order the model uses them.
+            lookahead (int, optional): The number of layers to read ahead.
+              Default: ``1``.
+
+        Example:
+            >>> weights = mx.load("model.safetensors")
+            >>> layers = [{} for _ in range(num_layers)]
+            >>> for k, v in weights.items():
+            ...     layers[int(k.split(".")[1])][k] = v
+            >>> streamer = mx.WeightStreamer(layers, lookahead=2)
+            >>> for i in range(len(streamer)):
+            ...     x = layer_fn(streamer[i], x)
+            ...     mx.eval(x)
+      )pbdoc")
+      .def(
+          nb::init<std::vector<WeightStreamer::Layer>, int>(),
+          "layers"_a,
+          "lookahead"_a = 1,
+          nb::sig(
+              "def __init__(self, layers: List[Dict[str, array]], lookahead: int = 1)"))
+      .def("__len__", &WeightStreamer::size)
+      .def("__getitem__", &WeightStreamer::layer, "index"_a);
   m.def(
       "save_safetensors",
       &mlx_save_safetensor_helper,
@@ -3691,7 +3910,9 @@ void init_ops(nb::module_& m) {
         and is packed in an unsigned 32-bit integer from the lower to upper
         bits. For instance, for 4-bit quantization we fit 8 elements in an
         unsigned 32 bit integer where the 1st element occupies the 4 least
-        significant bits, the 2nd bits 4-7 etc.
+        significant bits, the 2nd bits 4-7 etc. 3-bit and 6-bit elements are
+        packed the same way in groups of 3 bytes, holding 8 and 4 elements
+        respectively, laid out back to back in the unsigned 32-bit integers.
 
         In order to be able to dequantize the elements of ``w`` we also need to
         save :math:`s` and :math:`\beta` which are the returned ``scales`` and
@@ -3702,7 +3923,8 @@ void init_ops(nb::module_& m) {
           group_size (int, optional): The size of the group in ``w`` that shares a
             scale and bias. (default: ``64``)
           bits (int, optional): The number of bits occupied by each element of
-            ``w`` in the returned quantized matrix. (default: ``4``)
+            ``w`` in the returned quantized matrix. Supported values are ``2``,
+            ``3``, ``4``, ``6`` and ``8``. (default: ``4``)
 
         Returns:
           tuple: A tuple containing
@@ -3748,7 +3970,109 @@ void init_ops(nb::module_& m) {
           array: The dequantized version of ``w``
       )pbdoc");
   m.def(
-      "gater_qmm",
+      "to_fp8",
+      &to_fp8,
+      nb::arg(),
+      "format"_a = "e4m3",
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def to_fp8(x: array, /, format: str = 'e4m3', *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Convert an array to 8-bit floats.
+
+        The 8-bit floats are stored in a ``uint8`` array and can be converted
+        back with :func:`from_fp8`. Values are rounded to the nearest 8-bit
+        float, with ties to even. Finite values beyond the largest 8-bit
+        float saturate to it.
+
+        Args:
+          x (array): Input array with a floating point type.
+          format (str, optional): The 8-bit float format, ``"e4m3"`` with 4
+            exponent and 3 mantissa bits or ``"e5m2"`` with 5 exponent and
+            2 mantissa bits. (default: ``"e4m3"``)
+
+        Returns:
+          array: The 8-bit floats as a ``uint8`` array.
+      )pbdoc");
+  m.def(
+      "from_fp8",
+      &from_fp8,
+      nb::arg(),
+      "format"_a = "e4m3",
+      "dtype"_a = bfloat16,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def from_fp8(x: array, /, format: str = 'e4m3', dtype: Dtype = bfloat16, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Convert 8-bit floats made by :func:`to_fp8` to ``dtype``.
+
+        To multiply by 8-bit float weights use :func:`fp8_matmul` which
+        reads them without converting them first.
+
+        Args:
+          x (array): The 8-bit floats as a ``uint8`` array.
+          format (str, optional): The 8-bit float format, ``"e4m3"`` or
+            ``"e5m2"``. (default: ``"e4m3"``)
+          dtype (Dtype, optional): The type of the output.
+            (default: ``bfloat16``)
+
+        Returns:
+          array: The converted array.
+      )pbdoc");
+  m.def(
+      "fp8_matmul",
+      &fp8_matmul,
+      nb::arg(),
+      nb::arg(),
+      "format"_a = "e4m3",
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def fp8_matmul(x: array, w: array, /, format: str = 'e4m3', *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Perform ``x @ w.T`` with ``w`` in 8-bit floats made by :func:`to_fp8`.
+
+        The weights are read in 8 bits and converted inside the kernel so
+        they take half the memory bandwidth of ``float16`` weights. The
+        gradient is only defined with respect to ``x``.
+
+        Args:
+          x (array): Input array with a floating point type.
+          w (array): The ``(N, K)`` weights as a ``uint8`` array.
+          format (str, optional): The 8-bit float format, ``"e4m3"`` or
+            ``"e5m2"``. (default: ``"e4m3"``)
+
+        Returns:
+          array: The result of ``x @ w.T`` with the type of ``x``.
+      )pbdoc");
+  m.def(
+      "hadamard_transform",
+      &hadamard_transform,
+      nb::arg(),
+      "scale"_a = nb::none(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def hadamard_transform(a: array, /, scale: Optional[float] = None, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Perform the Walsh-Hadamard transform along the last axis.
+
+        The transform takes ``O(n log n)`` operations instead of the
+        ``O(n^2)`` of a product with a dense Hadamard matrix. Its size ``n``
+        must be a power of two. Integer inputs are cast to ``float32``.
+
+        Args:
+          a (array): Input array.
+          scale (float, optional): Scale the output by this factor.
+            (default: ``1 / sqrt(n)`` which makes the transform orthonormal)
+
+        Returns:
+          array: The transformed array.
+      )pbdoc");
+  m.def(
+      "gather_qmm",
       &gather_qmm,
       nb::arg(),
       nb::arg(),
@@ -3759,10 +4083,11 @@ void init_ops(nb::module_& m) {
       "transpose"_a = true,
       "group_size"_a = 64,
       "bits"_a = 4,
+      "sorted_indices"_a = false,
       nb::kw_only(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def gather_qmm(x: array, w: array, /, scales: array, biases: array, lhs_indices: Optional[array] = None, rhs_indices: Optional[array] = None, transpose: bool = True, group_size: int = 64, bits: int = 4, *, stream: Union[None, Stream, Device] = None) -> array"),
+          "def gather_qmm(x: array, w: array, /, scales: array, biases: array, lhs_indices: Optional[array] = None, rhs_indices: Optional[array] = None, transpose: bool = True, group_size: int = 64, bits: int = 4, sorted_indices: bool = False, *, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Perform quantized matrix multiplication with matrix-level gather.
 
@@ -3788,6 +4113,11 @@ void init_ops(nb::module_& m) {
             shares a scale and bias. (default: ``64``)
           bits (int, optional): The number of bits occupied by each element in
             ``w``. (default: ``4``)
+          sorted_indices (bool, optional): Whether ``rhs_indices`` is sorted.
+            When it is and ``lhs_indices`` is not given, the rows of ``x``
+            using the same matrix of ``w`` are multiplied together, which is
+            much faster for mixture of experts layers with many tokens.
+            (default: ``False``)
 
         Returns:
           array: The result of the multiplication of ``x`` with ``w``
@@ -3971,10 +4301,11 @@ void init_ops(nb::module_& m) {
       nb::arg(),
       "lhs_indices"_a = nb::none(),
       "rhs_indices"_a = nb::none(),
+      "sorted_indices"_a = false,
       nb::kw_only(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def gather_mm(a: array, b: array, /, lhs_indices: array, rhs_indices: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+          "def gather_mm(a: array, b: array, /, lhs_indices: array, rhs_indices: array, sorted_indices: bool = False, *, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Matrix multiplication with matrix-level gather.
 
@@ -3998,8 +4329,62 @@ void init_ops(nb::module_& m) {
             b (array): Input array.
             lhs_indices (array, optional): Integer indices for ``a`` (default: ``None``)
             rhs_indices (array, optional): Integer indices for ``b`` (default: ``None``)
+            sorted_indices (bool, optional): Whether ``rhs_indices`` is sorted.
+              When it is and ``lhs_indices`` is not given, the rows of ``a``
+              using the same matrix of ``b`` are multiplied together.
+              (default: ``False``)
 
       )pbdoc");
+  m.def(
+      "prune_2_4",
+      &prune_2_4,
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def prune_2_4(w: array, /, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        Prune a weight matrix to 2:4 structured sparsity.
+
+        The two entries of largest magnitude in every group of four
+        consecutive entries of each row are kept. They are returned in order
+        along with their positions packed in four bits per group, the first
+        position in the low two bits, eight groups per ``uint32``.
+
+        Args:
+            w (array): The ``(N, K)`` weight matrix. ``K`` must be a multiple
+              of ``32``.
+
+        Returns:
+            tuple(array, array): The ``(N, K / 2)`` kept values and the
+            ``(N, K / 32)`` metadata.
+      )pbdoc");
+  m.def(
+      "sparse_2_4_matmul",
+      &sparse_2_4_matmul,
+      nb::arg(),
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def sparse_2_4_matmul(x: array, values: array, metadata: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Multiply ``x`` with the transpose of a 2:4 sparse weight matrix.
+
+        Computes ``x @ w.T`` where ``w`` is given by the output of
+        :func:`prune_2_4`. Only the kept values and the metadata are read,
+        half the memory traffic of the dense weights.
+
+        Args:
+            x (array): Input array with last dimension ``K``.
+            values (array): The ``(N, K / 2)`` kept values.
+            metadata (array): The ``(N, K / 32)`` ``uint32`` positions of
+              the kept values.
+
+        Returns:
+            array: The result with last dimension ``N``.
+      )pbdoc");
   m.def(
       "diagonal",
       &diagonal,
@@ -4375,4 +4760,67 @@ void init_ops(nb::module_& m) {
         Returns:
             array: The array with the new type.
       )pbdoc");
+  m.def(
+      "einsum_path",
+      [](const std::string& subscripts, const nb::args& operands) {
+        auto [path, str] =
+            einsum_path(subscripts, nb::cast<std::vector<array>>(operands));
+        nb::list tuples;
+        for (auto& p : path) {
+          tuples.append(nb::make_tuple(p[0], p[1]));
+        }
+        return nb::make_tuple(tuples, str);
+      },
+      "subscripts"_a,
+      "operands"_a,
+      nb::sig(
+          "def einsum_path(subscripts: str, *operands: array) -> Tuple[List[Tuple[int, int]], str]"),
+      R"pbdoc(
+        Compute the contraction order used by :func:`einsum`.
+
+        Args:
+            subscripts (str): The Einstein summation convention equation.
+            *operands (array): The input arrays.
+
+        Returns:
+            tuple(list(tuple(int, int)), str):
+              The pairs of positions in the list of remaining operands
+              contracted at each step, and a human readable description of
+              the path with the cost of each step. The contracted operands
+              are removed from the list and their result is appended to it.
+      )pbdoc");
+  m.def(
+      "einsum",
+      [](const std::string& subscripts,
+         const nb::args& operands,
+         StreamOrDevice s) {
+        return einsum(subscripts, nb::cast<std::vector<array>>(operands), s);
+      },
+      "subscripts"_a,
+      "operands"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def einsum(subscripts: str, *operands: array, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Perform the Einstein summation convention on the operands.
+
+        The operands are contracted two at a time in the order which needs
+        the fewest operations. Each contraction is a matrix multiplication,
+        batched over the shared axes which are kept in the output.
+
+        Example:
+
+          >>> a = mx.random.normal((2, 3, 4))
+          >>> b = mx.random.normal((2, 4, 5))
+          >>> mx.einsum("bij,bjk->bik", a, b).shape
+          (2, 3, 5)
+
+        Args:
+            subscripts (str): The Einstein summation convention equation.
+            *operands (array): The input arrays.
+
+        Returns:
+            array: The output array.
+      )pbdoc");
 }
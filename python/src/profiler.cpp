@@ -0,0 +1,90 @@
+// Copyright © 2024 Apple Inc.
+
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/vector.h>
+
+#include "mlx/profiler.h"
+
+namespace nb = nanobind;
+using namespace nb::literals;
+
+using namespace mlx::core;
+
+void init_profiler(nb::module_& parent_module) {
+  auto m = parent_module.def_submodule(
+      "profiler", "mlx.core.profiler: record the evaluated primitives");
+  m.def(
+      "start",
+      &profiler::start,
+      "sample_every"_a = 1,
+      R"pbdoc(
+      Start recording the primitives evaluated on every device.
+
+      Records from an earlier profile are cleared. Only the primitives of one
+      in ``sample_every`` calls to :func:`eval` or :func:`async_eval` are
+      recorded, so profiling can be left on with little overhead. At most one
+      million events are kept.
+
+      For GPU primitives the recorded time is the time taken to encode their
+      kernels. Use :func:`mlx.core.metal.start_profiling` for the time they
+      take to run on the GPU.
+
+      Args:
+          sample_every (int, optional): Record one in this many evaluations.
+            Default: ``1``.
+      )pbdoc");
+  m.def(
+      "stop",
+      &profiler::stop,
+      R"pbdoc(
+      Stop recording and wait for the profiled work to finish.
+      )pbdoc");
+  m.def(
+      "is_enabled",
+      &profiler::is_enabled,
+      R"pbdoc(
+      Check if primitives are being recorded.
+      )pbdoc");
+  m.def(
+      "events",
+      []() {
+        nb::list out;
+        for (auto& e : profiler::events()) {
+          nb::dict d;
+          d["name"] = e.name;
+          d["stream"] = e.stream;
+          d["shapes"] = e.shapes;
+          d["start"] = e.start;
+          d["end"] = e.end;
+          d["nbytes"] = e.nbytes;
+          d["memory"] = e.memory;
+          out.append(d);
+        }
+        return out;
+      },
+      R"pbdoc(
+      Get the primitives recorded since :func:`start`.
+
+      Returns:
+          list(dict): A dictionary per primitive, in the order they finished,
+          with its ``name``, ``stream``, the ``shapes`` of its outputs, the
+          ``start`` and ``end`` in nanoseconds since profiling started, the
+          size of its outputs ``nbytes`` and the change in active ``memory``
+          in bytes while it ran.
+      )pbdoc");
+  m.def(
+      "save_trace",
+      &profiler::save_trace,
+      "path"_a,
+      R"pbdoc(
+      Save the recorded primitives as a Chrome trace.
+
+      The trace can be viewed in ``chrome://tracing`` or
+      `Perfetto <https://ui.perfetto.dev>`_. Each device is shown as a
+      process and each stream as a thread.
+
+      Args:
+          path (str): The path of the JSON file to write.
+      )pbdoc");
+}
@@ -0,0 +1,243 @@
+// Copyright © 2024 Apple Inc.
+
+#include <sstream>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/variant.h>
+#include <nanobind/stl/vector.h>
+
+#include "mlx/ragged.h"
+
+namespace nb = nanobind;
+using namespace nb::literals;
+
+using namespace mlx::core;
+using namespace mlx::core::ragged;
+
+void init_ragged(nb::module_& parent_module) {
+  auto m = parent_module.def_submodule(
+      "ragged", "mlx.core.ragged: batches of variable length sequences");
+
+  nb::class_<RaggedArray>(
+      m,
+      "RaggedArray",
+      R"pbdoc(
+      A batch of sequences of different lengths stored without padding.
+
+      The tokens of sequence ``b`` are rows ``offsets[b]`` to
+      ``offsets[b + 1]`` of ``values``, so per token operations like linear
+      layers apply to ``values`` directly.
+
+      Args:
+          values (array): The tokens of all the sequences.
+          offsets (array): The first token of each sequence followed by the
+            number of tokens.
+      )pbdoc")
+      .def(
+          "__init__",
+          [](RaggedArray* t, array values, array offsets) {
+            new (t) RaggedArray{values, offsets};
+          },
+          "values"_a,
+          "offsets"_a)
+      .def_rw("values", &RaggedArray::values)
+      .def_rw("offsets", &RaggedArray::offsets)
+      .def(
+          "to_padded",
+          [](const RaggedArray& x,
+             int max_length,
+             float pad_value,
+             StreamOrDevice s) {
+            return to_padded(x, max_length, pad_value, s);
+          },
+          "max_length"_a,
+          "pad_value"_a = 0.0f,
+          nb::kw_only(),
+          "stream"_a = nb::none(),
+          nb::sig(
+              "def to_padded(self, max_length: int, pad_value: float = 0.0, *, stream: Union[None, Stream, Device] = None) -> array"),
+          R"pbdoc(
+          Pad the sequences to ``max_length``.
+
+          Tokens past ``max_length`` are dropped.
+
+          Returns:
+              array: An array of shape ``(batch, max_length, ...)``.
+          )pbdoc")
+      .def("__repr__", [](const RaggedArray& x) {
+        std::ostringstream os;
+        os << "RaggedArray(batch=" << x.offsets.size() - 1
+           << ", values_shape=" << x.values.shape() << ")";
+        return os.str();
+      });
+
+  m.def(
+      "from_sequences",
+      &from_sequences,
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def from_sequences(sequences: list[array], /, *, stream: Union[None, Stream, Device] = None) -> RaggedArray"),
+      R"pbdoc(
+      Make a ragged batch from a list of sequences.
+
+      Args:
+          sequences (list(array)): The sequences, which differ only in their
+            first dimension.
+
+      Returns:
+          RaggedArray: The concatenated sequences.
+      )pbdoc");
+  m.def(
+      "from_padded",
+      &from_padded,
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def from_padded(padded: array, lengths: list[int], /, *, stream: Union[None, Stream, Device] = None) -> RaggedArray"),
+      R"pbdoc(
+      Drop the padding of a batch of sequences.
+
+      Args:
+          padded (array): The sequences of shape ``(batch, max_length, ...)``.
+          lengths (list(int)): The length of each sequence.
+
+      Returns:
+          RaggedArray: The first ``lengths[b]`` tokens of each sequence.
+      )pbdoc");
+  m.def(
+      "segment_ids",
+      &segment_ids,
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_ids(offsets: array, num_tokens: int, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+      The sequence of each token.
+
+      Args:
+          offsets (array): The offsets of the sequences.
+          num_tokens (int): The number of tokens.
+
+      Returns:
+          array: The ``int32`` sequence index of each token.
+      )pbdoc");
+  m.def(
+      "segment_sum",
+      &segment_sum,
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_sum(x: RaggedArray, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+      Sum the tokens of each sequence.
+
+      Empty sequences sum to zero.
+
+      Returns:
+          array: One row per sequence.
+      )pbdoc");
+  m.def(
+      "segment_max",
+      &segment_max,
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def segment_max(x: RaggedArray, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+      The maximum of the tokens of each sequence.
+
+      Empty sequences give the lowest value of the type.
+
+      Returns:
+          array: One row per sequence.
+      )pbdoc");
+  m.def(
+      "softmax",
+      &softmax,
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def softmax(x: RaggedArray, /, *, stream: Union[None, Stream, Device] = None) -> RaggedArray"),
+      R"pbdoc(
+      Softmax over the tokens of each sequence.
+
+      The softmax is computed in float32, e.g. for attention pooling.
+      )pbdoc");
+  m.def(
+      "rms_norm",
+      &rms_norm,
+      nb::arg(),
+      "weight"_a,
+      "eps"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def rms_norm(x: RaggedArray, /, weight: array, eps: float, *, stream: Union[None, Stream, Device] = None) -> RaggedArray"),
+      R"pbdoc(
+      Root mean square normalize every token.
+
+      See :func:`mlx.core.fast.rms_norm`.
+      )pbdoc");
+  m.def(
+      "layer_norm",
+      &layer_norm,
+      nb::arg(),
+      "weight"_a.none(),
+      "bias"_a.none(),
+      "eps"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def layer_norm(x: RaggedArray, /, weight: Optional[array], bias: Optional[array], eps: float, *, stream: Union[None, Stream, Device] = None) -> RaggedArray"),
+      R"pbdoc(
+      Layer normalize every token.
+
+      See :func:`mlx.core.fast.layer_norm`.
+      )pbdoc");
+  m.def(
+      "scaled_dot_product_attention",
+      &scaled_dot_product_attention,
+      nb::arg(),
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "scale"_a,
+      "causal"_a = false,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def scaled_dot_product_attention(q: RaggedArray, k: RaggedArray, v: RaggedArray, /, *, scale: float, causal: bool = False, stream: Union[None, Stream, Device] = None) -> RaggedArray"),
+      R"pbdoc(
+      Attention within each sequence of a ragged batch.
+
+      A query attends only to the keys of its own sequence so the batch needs
+      no padding. On the GPU head dimensions 64 and 128 use a fused kernel
+      and other cases a masked dense attention over all the tokens.
+
+      Args:
+          q (RaggedArray): Queries with values of shape
+            ``(tokens, heads, head_dim)``.
+          k (RaggedArray): Keys with values of shape
+            ``(tokens, kv_heads, head_dim)``. The number of query heads must
+            be a multiple of ``kv_heads``.
+          v (RaggedArray): Values with the same tokens and heads as ``k``.
+          scale (float): Scale for the queries, typically
+            ``1.0 / sqrt(head_dim)``.
+          causal (bool, optional): Mask the keys after each query, with the
+            queries aligned to the end of the keys of their sequence.
+            Default: ``False``.
+
+      Returns:
+          RaggedArray: The outputs with the offsets of ``q``.
+      )pbdoc");
+}
@@ -294,6 +294,38 @@ void init_random(nb::module_& parent_module) {
         Returns:
             array: The array of random integers.
       )pbdoc");
+  m.def(
+      "dropout",
+      [](const array& x,
+         float p,
+         const std::optional<array>& key_,
+         StreamOrDevice s) {
+        auto key = key_ ? key_.value() : default_key().next();
+        return dropout(x, p, key, s);
+      },
+      "x"_a,
+      "p"_a = 0.5,
+      "key"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def dropout(x: array, p: float = 0.5, key: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Randomly zero elements of an array.
+
+        Each element is zeroed with probability ``p`` and the others are
+        scaled by :math:`\frac{1}{1-p}`. The mask is drawn from the key in
+        the same kernel that applies it, so it is never materialized and
+        the gradient draws it again from the key.
+
+        Args:
+            x (array): Input array. Must be a floating point type.
+            p (float, optional): The probability to zero an element. Must be
+              in ``[0, 1)``. Default is 0.5.
+            key (array, optional): A PRNG key. Default: None.
+
+        Returns:
+            array: The input with the dropped elements set to zero.
+      )pbdoc");
   m.def(
       "truncated_normal",
       [](const ScalarOrArray& lower_,
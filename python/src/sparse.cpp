@@ -0,0 +1,216 @@
+// Copyright © 2024 Apple Inc.
+
+#include <sstream>
+#include <variant>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/variant.h>
+#include <nanobind/stl/vector.h>
+
+#include "mlx/sparse.h"
+
+namespace nb = nanobind;
+using namespace nb::literals;
+
+using namespace mlx::core;
+using namespace mlx::core::sparse;
+
+namespace {
+
+using Sparse = std::variant<COO, CSR>;
+
+nb::object sddmm_helper(
+    const Sparse& mask,
+    const array& a,
+    const array& b,
+    StreamOrDevice s) {
+  if (auto pv = std::get_if<COO>(&mask); pv) {
+    return nb::cast(sddmm(*pv, a, b, s));
+  }
+  return nb::cast(sddmm(std::get<CSR>(mask), a, b, s));
+}
+
+} // namespace
+
+void init_sparse(nb::module_& parent_module) {
+  auto m = parent_module.def_submodule(
+      "sparse", "mlx.core.sparse: sparse matrices and their products");
+
+  nb::class_<COO>(
+      m,
+      "COO",
+      R"pbdoc(
+      A matrix stored as the coordinates and values of its nonzeros.
+
+      Repeated coordinates are summed.
+
+      Args:
+          rows (array): The row of each nonzero.
+          cols (array): The column of each nonzero.
+          values (array): The value of each nonzero.
+          shape (tuple(int, int)): The shape of the matrix.
+      )pbdoc")
+      .def(
+          "__init__",
+          [](COO* t,
+             array rows,
+             array cols,
+             array values,
+             std::vector<int> shape) {
+            new (t) COO{rows, cols, values, shape};
+          },
+          "rows"_a,
+          "cols"_a,
+          "values"_a,
+          "shape"_a)
+      .def_rw("rows", &COO::rows)
+      .def_rw("cols", &COO::cols)
+      .def_rw("values", &COO::values)
+      .def_prop_ro(
+          "shape", [](const COO& a) { return nb::tuple(nb::cast(a.shape)); })
+      .def(
+          "to_dense",
+          [](const COO& a, StreamOrDevice s) { return to_dense(a, s); },
+          nb::kw_only(),
+          "stream"_a = nb::none(),
+          "Scatter the nonzeros into a dense array.")
+      .def(
+          "to_csr",
+          [](const COO& a, StreamOrDevice s) { return to_csr(a, s); },
+          nb::kw_only(),
+          "stream"_a = nb::none(),
+          "Convert to CSR format, sorting the nonzeros by row.")
+      .def("__repr__", [](const COO& a) {
+        std::ostringstream os;
+        os << "COO(shape=" << a.shape << ", nnz=" << a.values.size() << ")";
+        return os.str();
+      });
+
+  nb::class_<CSR>(
+      m,
+      "CSR",
+      R"pbdoc(
+      A matrix in compressed sparse row format.
+
+      The columns and values of the nonzeros of row ``i`` are at positions
+      ``indptr[i]`` to ``indptr[i + 1]`` of ``indices`` and ``values``.
+
+      Args:
+          indptr (array): The position of the first nonzero of each row
+            followed by the number of nonzeros.
+          indices (array): The column of each nonzero.
+          values (array): The value of each nonzero.
+          shape (tuple(int, int)): The shape of the matrix.
+      )pbdoc")
+      .def(
+          "__init__",
+          [](CSR* t,
+             array indptr,
+             array indices,
+             array values,
+             std::vector<int> shape) {
+            new (t) CSR{indptr, indices, values, shape};
+          },
+          "indptr"_a,
+          "indices"_a,
+          "values"_a,
+          "shape"_a)
+      .def_rw("indptr", &CSR::indptr)
+      .def_rw("indices", &CSR::indices)
+      .def_rw("values", &CSR::values)
+      .def_prop_ro(
+          "shape", [](const CSR& a) { return nb::tuple(nb::cast(a.shape)); })
+      .def(
+          "to_dense",
+          [](const CSR& a, StreamOrDevice s) { return to_dense(a, s); },
+          nb::kw_only(),
+          "stream"_a = nb::none(),
+          "Scatter the nonzeros into a dense array.")
+      .def(
+          "to_coo",
+          [](const CSR& a, StreamOrDevice s) { return to_coo(a, s); },
+          nb::kw_only(),
+          "stream"_a = nb::none(),
+          "Convert to coordinate format.")
+      .def("__repr__", [](const CSR& a) {
+        std::ostringstream os;
+        os << "CSR(shape=" << a.shape << ", nnz=" << a.values.size() << ")";
+        return os.str();
+      });
+
+  m.def(
+      "spmm",
+      [](const Sparse& a, const array& b, StreamOrDevice s) {
+        return std::visit([&](auto& x) { return spmm(x, b, s); }, a);
+      },
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def spmm(a: Union[COO, CSR], b: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+      Multiply a sparse matrix with a dense matrix.
+
+      The products are accumulated in float32 without materializing one row
+      of ``b`` per nonzero. Gradients flow to the values of ``a`` and to
+      ``b``.
+
+      Args:
+          a (COO or CSR): The sparse matrix of shape ``(M, K)``.
+          b (array): The dense matrix of shape ``(K, N)``.
+
+      Returns:
+          array: The ``(M, N)`` product.
+      )pbdoc");
+  m.def(
+      "spmv",
+      [](const Sparse& a, const array& x, StreamOrDevice s) {
+        return std::visit([&](auto& y) { return spmv(y, x, s); }, a);
+      },
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def spmv(a: Union[COO, CSR], x: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+      Multiply a sparse matrix with a dense vector.
+
+      Args:
+          a (COO or CSR): The sparse matrix of shape ``(M, K)``.
+          x (array): The vector of size ``K``.
+
+      Returns:
+          array: The product of size ``M``.
+      )pbdoc");
+  m.def(
+      "sddmm",
+      &sddmm_helper,
+      nb::arg(),
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def sddmm(mask: Union[COO, CSR], a: array, b: array, /, *, stream: Union[None, Stream, Device] = None) -> Union[COO, CSR]"),
+      R"pbdoc(
+      Sampled dense-dense matrix multiplication.
+
+      Only the entries of ``a @ b`` where ``mask`` has nonzeros are computed,
+      one dot product each, and they are multiplied by the values of
+      ``mask``. This computes sparse attention scores without the dense
+      ``(M, N)`` matrix.
+
+      Args:
+          mask (COO or CSR): The sparse matrix of shape ``(M, N)`` giving
+            the entries to compute.
+          a (array): The dense matrix of shape ``(M, K)``.
+          b (array): The dense matrix of shape ``(K, N)``.
+
+      Returns:
+          COO or CSR: A sparse matrix in the format of ``mask`` with the same
+          nonzeros.
+      )pbdoc");
+}
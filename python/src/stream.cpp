@@ -41,6 +41,16 @@ class PyStreamContext {
 };
 
 void init_stream(nb::module_& m) {
+  nb::enum_<StreamPriority>(
+      m,
+      "StreamPriority",
+      R"pbdoc(
+      How eagerly the work of a stream is serviced relative to other streams.
+      )pbdoc")
+      .value("low", StreamPriority::low)
+      .value("normal", StreamPriority::normal)
+      .value("high", StreamPriority::high);
+
   nb::class_<Stream>(
       m,
       "Stream",
@@ -82,9 +92,29 @@ void init_stream(nb::module_& m) {
       )pbdoc");
   m.def(
       "new_stream",
-      &new_stream,
+      nb::overload_cast<Device, StreamPriority>(&new_stream),
       "device"_a,
-      R"pbdoc(Make a new stream on the given device.)pbdoc");
+      "priority"_a = StreamPriority::normal,
+      R"pbdoc(
+        Make a new stream on the given device.
+
+        The thread encoding the work of a ``high`` priority stream is
+        scheduled ahead of the other threads of the process while a ``low``
+        priority one yields to them. The GPU work of a ``low`` priority
+        stream is also committed in smaller command buffers so the GPU can
+        interleave the work of other streams, for instance the decoding
+        steps queued while a long prefill runs.
+
+        Args:
+          device (Device): The device of the stream.
+          priority (StreamPriority, optional): The priority of the stream.
+            Default: ``StreamPriority.normal``.
+      )pbdoc");
+  m.def(
+      "stream_priority",
+      &stream_priority,
+      "stream"_a,
+      R"pbdoc(Get the priority of the stream.)pbdoc");
 
   nb::class_<PyStreamContext>(m, "StreamContext", R"pbdoc(
         A context manager for setting the current device and stream.
@@ -132,6 +162,7 @@ void init_stream(nb::module_& m) {
   m.def(
       "synchronize",
       [](const std::optional<Stream>& s) {
+        nb::gil_scoped_release nogil;
         s ? synchronize(s.value()) : synchronize();
       },
       "stream"_a = nb::none(),
@@ -7,16 +7,21 @@
 #include <nanobind/stl/vector.h>
 
 #include <algorithm>
+#include <deque>
 #include <fstream>
 #include <numeric>
 #include <sstream>
 
 #include "mlx/array.h"
+#include "mlx/batch_split.h"
 #include "mlx/compile.h"
+#include "mlx/export.h"
 #include "mlx/graph_utils.h"
+#include "mlx/prefetch.h"
 #include "mlx/transforms.h"
 #include "mlx/transforms_impl.h"
 #include "mlx/utils.h"
+#include "python/src/convert.h"
 #include "python/src/trees.h"
 
 namespace nb = nanobind;
@@ -360,9 +365,9 @@ auto py_vmap(
   };
 }
 
-std::unordered_map<std::uintptr_t, nb::object>& tree_cache() {
+std::unordered_map<std::uintptr_t, TreeDef>& tree_cache() {
   // This map is used to Cache the tree structure of the outputs
-  static std::unordered_map<std::uintptr_t, nb::object> tree_cache_;
+  static std::unordered_map<std::uintptr_t, TreeDef> tree_cache_;
   return tree_cache_;
 }
 
@@ -372,18 +377,21 @@ struct PyCompiledFun {
   nb::object captured_inputs;
   nb::object captured_outputs;
   bool shapeless;
+  bool donate_inputs;
   mutable size_t num_outputs{0};
 
   PyCompiledFun(
       const nb::callable& fun,
       nb::object inputs,
       nb::object outputs,
-      bool shapeless)
+      bool shapeless,
+      bool donate_inputs)
       : fun(fun),
         fun_id(reinterpret_cast<std::uintptr_t>(fun.ptr())),
         captured_inputs(inputs),
         captured_outputs(outputs),
-        shapeless(shapeless) {}
+        shapeless(shapeless),
+        donate_inputs(donate_inputs) {}
 
   PyCompiledFun(const PyCompiledFun&) = delete;
   PyCompiledFun& operator=(const PyCompiledFun&) = delete;
@@ -395,6 +403,7 @@ struct PyCompiledFun {
     captured_inputs = std::move(other.captured_inputs);
     captured_outputs = std::move(other.captured_outputs);
     shapeless = other.shapeless;
+    donate_inputs = other.donate_inputs;
     num_outputs = other.num_outputs;
   };
 
@@ -436,8 +445,8 @@ struct PyCompiledFun {
           constants.push_back(*reinterpret_cast<uint64_t*>(&r));
           recurse(item.second);
         }
-      } else if (nb::isinstance<array>(obj)) {
-        inputs.push_back(nb::cast<array>(obj));
+      } else if (is_array(obj)) {
+        inputs.push_back(as_array(obj));
         constants.push_back(array_identifier);
       } else if (nb::isinstance<nb::str>(obj)) {
         auto r = obj.attr("__hash__");
@@ -477,7 +486,7 @@ struct PyCompiledFun {
       auto [outputs, py_outputs] =
           tree_flatten_with_structure(std::move(tree_outputs), false);
 
-      tree_cache().insert({fun_id, py_outputs});
+      tree_cache().try_emplace(fun_id, std::move(py_outputs));
 
       num_outputs = outputs.size();
       if (!captured_outputs.is_none()) {
@@ -495,8 +504,13 @@ struct PyCompiledFun {
       return outputs;
     };
 
+    std::vector<int> donate_argnums;
     if (!captured_inputs.is_none()) {
       auto flat_in_captures = tree_flatten(captured_inputs, false);
+      if (donate_inputs) {
+        donate_argnums.resize(flat_in_captures.size());
+        std::iota(donate_argnums.begin(), donate_argnums.end(), inputs.size());
+      }
       inputs.insert(
           inputs.end(),
           std::make_move_iterator(flat_in_captures.begin()),
@@ -504,8 +518,9 @@ struct PyCompiledFun {
     }
 
     // Compile and call
-    auto outputs =
-        detail::compile(compile_fun, fun_id, shapeless, constants)(inputs);
+    auto outputs = detail::compile(
+        compile_fun, fun_id, shapeless, constants, std::move(donate_argnums))(
+        inputs);
     if (!captured_outputs.is_none()) {
       std::vector<array> captures(
           std::make_move_iterator(outputs.begin() + num_outputs),
@@ -514,8 +529,7 @@ struct PyCompiledFun {
     }
 
     // Put the outputs back in the container
-    nb::object py_outputs = tree_cache().at(fun_id);
-    return tree_unflatten_from_structure(py_outputs, outputs);
+    return tree_unflatten_from_structure(tree_cache().at(fun_id), outputs);
   }
 
   nb::object operator()(const nb::args& args, const nb::kwargs& kwargs) const {
@@ -545,13 +559,13 @@ class PyCheckpointedFun {
 
   struct InnerFunction {
     nb::object fun_;
-    nb::object args_structure_;
-    std::weak_ptr<nb::object> output_structure_;
+    TreeDef args_structure_;
+    std::weak_ptr<TreeDef> output_structure_;
 
     InnerFunction(
         nb::object fun,
-        nb::object args_structure,
-        std::weak_ptr<nb::object> output_structure)
+        TreeDef args_structure,
+        std::weak_ptr<TreeDef> output_structure)
         : fun_(std::move(fun)),
           args_structure_(std::move(args_structure)),
           output_structure_(output_structure) {}
@@ -559,7 +573,7 @@ class PyCheckpointedFun {
       nb::gil_scoped_acquire gil;
 
       fun_.release().dec_ref();
-      args_structure_.release().dec_ref();
+      args_structure_ = TreeDef();
     }
 
     std::vector<array> operator()(const std::vector<array>& inputs) {
@@ -568,14 +582,14 @@ class PyCheckpointedFun {
       auto [outputs, output_structure] =
           tree_flatten_with_structure(fun_(*args[0], **args[1]), false);
       if (auto s = output_structure_.lock()) {
-        *s = output_structure;
+        *s = std::move(output_structure);
       }
       return outputs;
     }
   };
 
   nb::object call_impl(const nb::args& args, const nb::kwargs& kwargs) {
-    auto output_structure = std::make_shared<nb::object>();
+    auto output_structure = std::make_shared<TreeDef>();
     auto full_args = nb::make_tuple(args, kwargs);
     auto [inputs, args_structure] =
         tree_flatten_with_structure(full_args, false);
@@ -594,18 +608,131 @@ class PyCheckpointedFun {
   nb::callable fun_;
 };
 
+// Iterates a Python iterable on the worker thread of a Prefetcher. Batches
+// are trees whose NumPy (or other DLPack) leaves are converted to arrays.
+class PyPrefetcher {
+ public:
+  PyPrefetcher(const nb::object& iterable, int size)
+      : iterator_(nb::iter(iterable)) {
+    prefetcher_ =
+        std::make_unique<Prefetcher>([this]() { return produce(); }, size);
+  }
+
+  ~PyPrefetcher() {
+    // The worker needs the GIL to finish the batch it is producing
+    nb::gil_scoped_release nogil;
+    prefetcher_.reset();
+  }
+
+  nb::object next() {
+    std::optional<Prefetcher::Batch> batch;
+    {
+      nb::gil_scoped_release nogil;
+      batch = prefetcher_->next();
+    }
+    if (!batch) {
+      throw nb::stop_iteration();
+    }
+    auto structure = std::move(structures_.front());
+    structures_.pop_front();
+    return structure.unflatten(*batch);
+  }
+
+ private:
+  std::optional<Prefetcher::Batch> produce() {
+    nb::gil_scoped_acquire gil;
+    auto batch = nb::steal(PyIter_Next(iterator_.ptr()));
+    if (!batch.is_valid()) {
+      if (PyErr_Occurred()) {
+        throw nb::python_error();
+      }
+      return std::nullopt;
+    }
+    batch = tree_map(batch, [](nb::handle obj) -> nb::object {
+      if (!is_array(obj) && nb::hasattr(obj, "__dlpack__")) {
+        auto nd = nb::cast<nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu>>(
+            obj);
+        return nb::cast(nd_array_to_mlx(nd, std::nullopt));
+      }
+      return nb::borrow(obj);
+    });
+    Prefetcher::Batch flat;
+    structures_.emplace_back(batch, flat, false);
+    return flat;
+  }
+
+  nb::iterator iterator_;
+  // The structures of the batches, only used with the GIL held
+  std::deque<TreeDef> structures_;
+  std::unique_ptr<Prefetcher> prefetcher_;
+};
+
 void init_transforms(nb::module_& m) {
+  nb::class_<CancellationToken>(
+      m,
+      "CancellationToken",
+      R"pbdoc(
+        A token to cancel the evaluations it is given to.
+
+        Once it is cancelled the primitives of the evaluations which have not
+        started yet are skipped and their outputs are left unevaluated, so
+        they can be evaluated again later. Primitives already running, or
+        already encoded on the GPU, finish.
+
+        Example:
+            >>> token = mx.CancellationToken()
+            >>> mx.async_eval(y, token=token)
+            >>> token.cancel()
+      )pbdoc")
+      .def(nb::init<>())
+      .def(
+          "cancel",
+          &CancellationToken::cancel,
+          "Cancel the evaluations given the token.")
+      .def_prop_ro(
+          "cancelled",
+          &CancellationToken::cancelled,
+          "Whether the token was cancelled.");
+  nb::class_<Event>(
+      m,
+      "Event",
+      R"pbdoc(
+        The completion of an evaluation as returned by :func:`async_eval_batch`.
+      )pbdoc")
+      .def(
+          "wait",
+          &Event::wait,
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Wait until the evaluation is done.")
+      .def(
+          "is_signaled",
+          &Event::is_signaled,
+          "Whether the evaluation is done, without waiting.");
   m.def(
       "eval",
-      [](const nb::args& args) {
+      [](const nb::args& args,
+         std::optional<CancellationToken> token,
+         std::optional<double> timeout) {
         std::vector<array> arrays = tree_flatten(args, false);
         {
           nb::gil_scoped_release nogil;
-          eval(arrays);
+          if (timeout) {
+            eval(
+                arrays,
+                std::chrono::milliseconds(
+                    static_cast<int64_t>(*timeout * 1000)));
+          } else if (token) {
+            eval(arrays, *token);
+          } else {
+            eval(arrays);
+          }
         }
       },
       nb::arg(),
-      nb::sig("def eval(*args) -> None"),
+      "token"_a = nb::none(),
+      "timeout"_a = nb::none(),
+      nb::sig(
+          "def eval(*args, token: Optional[CancellationToken] = None, timeout: Optional[float] = None) -> None"),
       R"pbdoc(
         Evaluate an :class:`array` or tree of :class:`array`.
 
@@ -614,18 +741,61 @@ void init_transforms(nb::module_& m) {
               or a tree of arrays. If a tree is given the nodes can be a Python
               :class:`list`, :class:`tuple` or :class:`dict`. Leaves which are not
               arrays are ignored.
+            token (CancellationToken, optional): A token to cancel the
+              evaluation with. If it is cancelled this raises once the work
+              already started is done.
+            timeout (float, optional): Cancel the evaluation and raise if it
+              takes longer than this many seconds.
+      )pbdoc");
+  m.def(
+      "async_eval_batch",
+      [](const nb::list& requests) {
+        std::vector<std::vector<array>> arrays;
+        arrays.reserve(requests.size());
+        for (auto& r : requests) {
+          arrays.push_back(tree_flatten(nb::borrow(r), false));
+        }
+        nb::gil_scoped_release nogil;
+        return async_eval_batch(std::move(arrays));
+      },
+      "requests"_a,
+      nb::sig("def async_eval_batch(requests: list) -> list[Event]"),
+      R"pbdoc(
+        Asynchronously evaluate several independent trees of :class:`array`.
+
+        The graphs of all the requests are evaluated together with a single
+        submission instead of one per request, which is useful to serve many
+        requests at once.
+
+        Args:
+            requests (list): The requests to evaluate, each one an array or a
+              tree of arrays.
+
+        Returns:
+            list(Event): An event per request which is signaled once the
+            arrays of that request are computed.
+
+        Example:
+            >>> events = mx.async_eval_batch([a, (b, c)])
+            >>> events[1].wait()
       )pbdoc");
   m.def(
       "async_eval",
-      [](const nb::args& args) {
+      [](const nb::args& args, std::optional<CancellationToken> token) {
         std::vector<array> arrays = tree_flatten(args, false);
         {
           nb::gil_scoped_release nogil;
-          async_eval(arrays);
+          if (token) {
+            async_eval(arrays, *token);
+          } else {
+            async_eval(arrays);
+          }
         }
       },
       nb::arg(),
-      nb::sig("def async_eval(*args)"),
+      "token"_a = nb::none(),
+      nb::sig(
+          "def async_eval(*args, token: Optional[CancellationToken] = None)"),
       R"pbdoc(
         Asynchronously evaluate an :class:`array` or tree of :class:`array`.
 
@@ -638,6 +808,9 @@ void init_transforms(nb::module_& m) {
               or a tree of arrays. If a tree is given the nodes can be a Python
               :class:`list`, :class:`tuple` or :class:`dict`. Leaves which are not
               arrays are ignored.
+            token (CancellationToken, optional): A token to cancel the
+              evaluation with. Reading an array whose evaluation was
+              cancelled raises.
 
         Example:
             >>> x = mx.array(1.0)
@@ -651,6 +824,126 @@ void init_transforms(nb::module_& m) {
             >>> mx.async_eval(z)
             >>> print(z)
       )pbdoc");
+  m.def(
+      "set_cpu_placement_size",
+      &set_cpu_placement_size,
+      "max_size"_a,
+      R"pbdoc(
+        Run small GPU operations on the CPU instead.
+
+        When evaluating, an operation on the GPU whose output and inputs have
+        at most ``max_size`` elements, and whose inputs are not computed on
+        the GPU in the same evaluation, runs on the default CPU stream. This
+        avoids the dispatch overhead of scalar and shape bookkeeping
+        computations which are often read on the host afterwards. The
+        inputs are read in place thanks to unified memory.
+
+        Can also be set with the ``MLX_CPU_PLACEMENT_SIZE`` environment
+        variable.
+
+        Args:
+            max_size (int): The largest number of elements to run on the
+              CPU. ``0``, the default, disables the placement.
+      )pbdoc");
+  nb::class_<PyPrefetcher>(
+      m,
+      "Prefetcher",
+      R"pbdoc(
+        Prepare batches ahead of their use on a background thread.
+
+        The iterable is iterated on a worker thread which keeps up to
+        ``size`` batches ready, so training steps don't wait for their
+        inputs. Batches can be arrays or trees of arrays, NumPy arrays in
+        them are converted to :class:`array` and every batch is evaluated on
+        the worker thread.
+
+        Args:
+            iterable: An iterable, such as a generator, of batches.
+            size (int, optional): The number of batches to keep ready.
+              Default: ``2``.
+
+        Example:
+            >>> def batches():
+            ...     for i in range(0, len(data), 32):
+            ...         yield {"x": data[i : i + 32], "y": labels[i : i + 32]}
+            >>>
+            >>> for batch in mx.Prefetcher(batches(), size=4):
+            ...     loss = step(batch["x"], batch["y"])
+      )pbdoc")
+      .def(
+          nb::init<const nb::object&, int>(),
+          "iterable"_a,
+          "size"_a = 2,
+          nb::sig("def __init__(self, iterable: Iterable, size: int = 2)"))
+      .def(
+          "__iter__",
+          [](PyPrefetcher& self) -> PyPrefetcher& { return self; },
+          nb::rv_policy::reference)
+      .def("__next__", &PyPrefetcher::next);
+  nb::class_<BatchSplit>(
+      m,
+      "BatchSplit",
+      R"pbdoc(
+        Run a function over a batch on the GPU and the CPU at the same time.
+
+        The inputs are split along their first axis, the leading part of the
+        batch is computed on the GPU and the rest on the CPU, and the outputs
+        are concatenated along their first axis. The function must treat the
+        elements of the batch independently, for instance a matmul, a
+        convolution or elementwise ops over the batch.
+
+        Each call evaluates the two parts and, when ``adaptive``, moves the
+        share of the CPU towards the ratio of the throughputs measured on the
+        two devices.
+
+        Args:
+            fun (Callable): A function which takes arrays and returns an
+              array or a list of arrays.
+            cpu_fraction (float, optional): The initial share of the batch
+              computed on the CPU. Default: ``0.1``.
+            adaptive (bool, optional): Update the share from the measured
+              throughputs. Default: ``True``.
+
+        Example:
+            >>> embed = mx.BatchSplit(lambda x: x @ w)
+            >>> for x in batches:
+            ...     y = embed(x)
+      )pbdoc")
+      .def(
+          "__init__",
+          [](BatchSplit* self,
+             const nb::callable& fun,
+             float cpu_fraction,
+             bool adaptive) {
+            auto vfun = [fun](const std::vector<array>& inputs) {
+              auto out = fun(*nb::cast(inputs));
+              if (nb::isinstance<array>(out)) {
+                return std::vector<array>{nb::cast<array>(out)};
+              } else {
+                return nb::cast<std::vector<array>>(out);
+              }
+            };
+            new (self) BatchSplit(vfun, cpu_fraction, adaptive);
+          },
+          "fun"_a,
+          "cpu_fraction"_a = 0.1,
+          "adaptive"_a = true,
+          nb::sig(
+              "def __init__(self, fun: Callable, cpu_fraction: float = 0.1, adaptive: bool = True)"))
+      .def(
+          "__call__",
+          [](BatchSplit& self, const nb::args& args) -> nb::object {
+            auto outputs = self(nb::cast<std::vector<array>>(args));
+            if (outputs.size() == 1) {
+              return nb::cast(outputs[0]);
+            }
+            return nb::cast(outputs);
+          },
+          nb::sig("def __call__(self, *args: array) -> Union[array, list[array]]"))
+      .def_prop_ro(
+          "cpu_fraction",
+          &BatchSplit::cpu_fraction,
+          "The share of the batch currently computed on the CPU.");
   m.def(
       "jvp",
       [](const nb::callable& fun,
@@ -733,17 +1026,28 @@ void init_transforms(nb::module_& m) {
       "value_and_grad",
       [](const nb::callable& fun,
          const std::optional<IntOrVec>& argnums,
-         const StrOrVec& argnames) {
+         const StrOrVec& argnames,
+         bool cache) {
         auto [argnums_vec, argnames_vec] =
             validate_argnums_argnames(argnums, argnames);
-        return nb::cpp_function(py_value_and_grad(
+        auto fn = nb::cpp_function(py_value_and_grad(
             fun, argnums_vec, argnames_vec, "[value_and_grad]", false));
+        if (cache) {
+          return nb::cpp_function(PyCompiledFun{
+              nb::borrow<nb::callable>(fn),
+              nb::none(),
+              nb::none(),
+              false,
+              false});
+        }
+        return fn;
       },
       "fun"_a,
       "argnums"_a = nb::none(),
       "argnames"_a = std::vector<std::string>{},
+      "cache"_a = false,
       nb::sig(
-          "def value_and_grad(fun: callable, argnums: Optional[Union[int, List[int]]] = None, argnames: Union[str, List[str]] = []) -> callable"),
+          "def value_and_grad(fun: callable, argnums: Optional[Union[int, List[int]]] = None, argnames: Union[str, List[str]] = [], cache: bool = False) -> callable"),
       R"pbdoc(
         Returns a function which computes the value and gradient of ``fun``.
 
@@ -787,6 +1091,11 @@ void init_transforms(nb::module_& m) {
             argnames (str or list(str), optional): Specify keyword arguments of
               ``fun`` to compute gradients with respect to. It defaults to [] so
               no gradients for keyword arguments by default.
+            cache (bool, optional): Keep the traced forward and backward graph
+              for each set of input shapes and types, as :func:`compile` does,
+              so repeated calls skip tracing ``fun`` and building the gradient
+              graph. ``fun`` must then be pure and return arrays or trees of
+              arrays. Default: ``False``.
 
         Returns:
             callable: A function which returns a tuple where the first element
@@ -797,21 +1106,32 @@ void init_transforms(nb::module_& m) {
       "grad",
       [](const nb::callable& fun,
          const std::optional<IntOrVec>& argnums,
-         const StrOrVec& argnames) {
+         const StrOrVec& argnames,
+         bool cache) {
         auto [argnums_vec, argnames_vec] =
             validate_argnums_argnames(argnums, argnames);
         auto fn =
             py_value_and_grad(fun, argnums_vec, argnames_vec, "[grad]", true);
-        return nb::cpp_function(
+        auto gfn = nb::cpp_function(
             [fn](const nb::args& args, const nb::kwargs& kwargs) {
               return fn(args, kwargs).second;
             });
+        if (cache) {
+          return nb::cpp_function(PyCompiledFun{
+              nb::borrow<nb::callable>(gfn),
+              nb::none(),
+              nb::none(),
+              false,
+              false});
+        }
+        return gfn;
       },
       "fun"_a,
       "argnums"_a = nb::none(),
       "argnames"_a = std::vector<std::string>{},
+      "cache"_a = false,
       nb::sig(
-          "def grad(fun: callable, argnums: Optional[Union[int, List[int]]] = None, argnames: Union[str, List[str]] = []) -> callable"),
+          "def grad(fun: callable, argnums: Optional[Union[int, List[int]]] = None, argnames: Union[str, List[str]] = [], cache: bool = False) -> callable"),
       R"pbdoc(
         Returns a function which computes the gradient of ``fun``.
 
@@ -827,6 +1147,9 @@ void init_transforms(nb::module_& m) {
             argnames (str or list(str), optional): Specify keyword arguments of
               ``fun`` to compute gradients with respect to. It defaults to [] so
               no gradients for keyword arguments by default.
+            cache (bool, optional): Keep the traced forward and backward graph
+              for each set of input shapes and types, as :func:`compile` does.
+              See :func:`value_and_grad`. Default: ``False``.
 
         Returns:
             callable: A function which has the same input arguments as ``fun`` and
@@ -887,7 +1210,8 @@ void init_transforms(nb::module_& m) {
       [](const nb::callable& fun,
          const nb::object& inputs,
          const nb::object& outputs,
-         bool shapeless) {
+         bool shapeless,
+         bool donate_inputs) {
         //  Try to get the name
         auto n = fun.attr("__name__");
         auto name = n.is_none() ? "compiled" : nb::cast<std::string>(n);
@@ -910,7 +1234,7 @@ void init_transforms(nb::module_& m) {
 
         auto sig_str = sig.str();
         return nb::cpp_function(
-            PyCompiledFun{fun, inputs, outputs, shapeless},
+            PyCompiledFun{fun, inputs, outputs, shapeless, donate_inputs},
             nb::name(name.c_str()),
             nb::sig(sig_str.c_str()),
             doc.c_str());
@@ -919,6 +1243,7 @@ void init_transforms(nb::module_& m) {
       "inputs"_a = nb::none(),
       "outputs"_a = nb::none(),
       "shapeless"_a = false,
+      "donate_inputs"_a = false,
       R"pbdoc(
         Returns a compiled function which produces the same output as ``fun``.
 
@@ -942,6 +1267,12 @@ void init_transforms(nb::module_& m) {
               such functions with shapeless enabled will throw. Note, changing the number
               of dimensions or type of any input will result in a recompilation even with
               ``shapeless`` set to ``True``. Default: ``False``
+            donate_inputs (bool, optional): Donate the arrays captured with
+              ``inputs`` so that their buffers can be reused for the outputs,
+              e.g. to update parameters and optimizer state in place. The
+              captured arrays must not be used after the call, which is the
+              case when they are also captured in ``outputs`` and replaced.
+              Default: ``False``
 
         Returns:
             callable: A compiled function which has the same input arguments
@@ -961,10 +1292,155 @@ void init_transforms(nb::module_& m) {
         Globally enable compilation. This will override the environment
         variable ``MLX_DISABLE_COMPILE`` if set.
       )pbdoc");
+  m.def(
+      "preload_cpu_kernels",
+      &preload_cpu_kernels,
+      R"pbdoc(
+        Load the compiled CPU kernels cached on disk by earlier processes.
+
+        Kernels compiled for the CPU are kept in the directory given by the
+        environment variable ``MLX_CPU_KERNEL_CACHE`` (by default
+        ``~/.cache/mlx/cpu_kernels``) and reused across processes. Preloading
+        them moves the cost of opening them from the first call of each
+        compiled function to startup.
+      )pbdoc");
+  m.def(
+      "compile_cache_stats",
+      []() {
+        auto stats = compile_cache_stats();
+        nb::dict out;
+        out["hits"] = stats.hits;
+        out["misses"] = stats.misses;
+        out["evictions"] = stats.evictions;
+        out["entries"] = stats.entries;
+        out["trace_time"] = stats.trace_time;
+        out["kernels"] = stats.kernels;
+        return out;
+      },
+      R"pbdoc(
+        Get the statistics of the cache of compiled graphs.
+
+        Returns:
+            dict: The number of calls that reused a compiled graph (``hits``)
+            and that traced a new one (``misses``), the number of graphs
+            dropped from the cache (``evictions``) and currently cached
+            (``entries``), the total seconds spent tracing and compiling
+            (``trace_time``) and the number of fused kernels generated and
+            built by the back-ends (``kernels``).
+      )pbdoc");
+  m.def(
+      "reset_compile_cache_stats",
+      &reset_compile_cache_stats,
+      R"pbdoc(
+        Reset the counters returned by :func:`compile_cache_stats`.
+      )pbdoc");
+  m.def(
+      "set_compile_cache_capacity",
+      &set_compile_cache_capacity,
+      "capacity"_a,
+      R"pbdoc(
+        Set the number of graphs cached for each compiled function.
+
+        When a compiled function is called with more distinct input shapes,
+        types or constants than ``capacity``, the least recently used graph
+        is dropped and recompiled if it is needed again. The default is
+        ``128`` and the environment variable ``MLX_COMPILE_CACHE_CAPACITY``
+        can be used to change it.
+
+        Args:
+            capacity (int): The number of graphs to keep per function. A
+              capacity of ``0`` keeps every graph.
+      )pbdoc");
+  m.def(
+      "export_function",
+      [](const std::string& file,
+         const nb::callable& fun,
+         const nb::args& args,
+         bool shapeless) {
+        auto [inputs, structure] = tree_flatten_with_structure(args);
+        auto wrapped_fun = [&fun, &structure](const std::vector<array>& a) {
+          auto tree = tree_unflatten_from_structure(structure, a);
+          return tree_flatten(fun(*tree));
+        };
+        export_function(file, wrapped_fun, inputs, shapeless);
+      },
+      "file"_a,
+      "fun"_a,
+      "args"_a,
+      nb::kw_only(),
+      "shapeless"_a = false,
+      nb::sig(
+          "def export_function(file: str, fun: Callable, *args, shapeless: bool = False) -> None"),
+      R"pbdoc(
+        Export the graph of a function to a file.
+
+        The function is traced with the given example arguments and its
+        graph, including the arrays it captures, is saved so that it can be
+        loaded with :func:`import_function` in another process without
+        running the Python code again.
+
+        Only graphs made of elementwise, reduction, shape, sorting and
+        matrix multiplication operations can be exported.
+
+        Args:
+            file (str): The file to write the graph to.
+            fun (callable): A function which takes a variable number of
+              :class:`array` or trees of :class:`array` and returns
+              a variable number of :class:`array` or trees of :class:`array`.
+            *args: Example arguments to trace ``fun`` with.
+            shapeless (bool, optional): Whether the imported function
+              accepts inputs with different shapes, see :func:`compile`.
+              Default: ``False``.
+      )pbdoc");
+  m.def(
+      "import_function",
+      [](const std::string& file) {
+        auto fun = import_function(file);
+        return nb::cpp_function([fun](const nb::args& args) -> nb::object {
+          auto outputs = fun(tree_flatten(args));
+          if (outputs.size() == 1) {
+            return nb::cast(outputs[0]);
+          }
+          return nb::tuple(nb::cast(outputs));
+        });
+      },
+      "file"_a,
+      R"pbdoc(
+        Import a function saved with :func:`export_function`.
+
+        The returned function is compiled and takes the flattened array
+        arguments of the exported function. It returns a single
+        :class:`array` or a tuple of the flattened outputs.
+
+        Args:
+            file (str): The file the graph was exported to.
+
+        Returns:
+            callable: The imported function.
+      )pbdoc");
   m.def(
       "checkpoint",
       [](nb::callable fun) { return nb::cpp_function(PyCheckpointedFun{fun}); },
       "fun"_a);
+  m.def(
+      "set_checkpoint_budget",
+      &set_checkpoint_budget,
+      "bytes"_a,
+      R"pbdoc(
+        Set the memory budget for the intermediates kept for the backward pass.
+
+        The gradients computed by :func:`grad`, :func:`value_and_grad` and
+        :func:`vjp` need intermediate results of the forward pass. When they
+        take more than ``bytes``, the cheapest to recompute are discarded
+        after the forward pass and recomputed in the backward pass, starting
+        with elementwise and shape operations and leaving matrix
+        multiplications for last. Unlike wrapping functions with ``checkpoint``
+        this does not require choosing which functions to recompute.
+
+        Args:
+            bytes (int): The budget in bytes. A budget of ``0``, the default,
+              keeps all the intermediates.
+      )pbdoc");
 
   // Register static Python object cleanup before the interpreter exits
   auto atexit = nb::module_::import_("atexit");
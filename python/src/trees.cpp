@@ -2,6 +2,12 @@
 
 #include "python/src/trees.h"
 
+bool is_array(nb::handle obj) {
+  static auto array_type = reinterpret_cast<PyTypeObject*>(
+      nb::type<array>().ptr());
+  return PyObject_TypeCheck(obj.ptr(), array_type);
+}
+
 template <typename T, typename U, typename V>
 void validate_subtrees(const std::vector<nb::object>& subtrees) {
   int len = nb::cast<T>(subtrees[0]).size();
@@ -188,7 +194,7 @@ void tree_visit_update(
         d[item.first] = recurse(item.second);
       }
       return nb::cast<nb::object>(d);
-    } else if (nb::isinstance<array>(subtree)) {
+    } else if (is_array(subtree)) {
       return visitor(subtree);
     } else {
       return nb::cast<nb::object>(subtree);
@@ -228,8 +234,8 @@ std::vector<array> tree_flatten(nb::object tree, bool strict /* = true */) {
   std::vector<array> flat_tree;
 
   tree_visit(tree, [&](nb::handle obj) {
-    if (nb::isinstance<array>(obj)) {
-      flat_tree.push_back(nb::cast<array>(obj));
+    if (is_array(obj)) {
+      flat_tree.push_back(as_array(obj));
     } else if (strict) {
       throw std::invalid_argument(
           "[tree_flatten] The argument should contain only arrays");
@@ -243,60 +249,110 @@ nb::object tree_unflatten(
     nb::object tree,
     const std::vector<array>& values,
     int index /* = 0 */) {
-  return tree_map(tree, [&](nb::handle obj) {
-    if (nb::isinstance<array>(obj)) {
-      return nb::cast(values[index++]);
-    } else {
-      return nb::cast<nb::object>(obj);
-    }
-  });
+  std::vector<array> flat_tree;
+  return TreeDef(tree, flat_tree, false).unflatten(values, index);
 }
 
-nb::object structure_sentinel() {
-  static nb::object sentinel;
+TreeDef::TreeDef(
+    nb::handle tree,
+    std::vector<array>& flat,
+    bool strict /* = true */) {
+  flatten_node(tree, flat, strict);
+}
 
-  if (sentinel.ptr() == nullptr) {
-    sentinel = nb::capsule(&sentinel);
-    // probably not needed but this should make certain that we won't ever
-    // delete the sentinel
-    sentinel.inc_ref();
+void TreeDef::flatten_node(
+    nb::handle obj,
+    std::vector<array>& flat,
+    bool strict) {
+  PyObject* o = obj.ptr();
+  if (PyList_Check(o)) {
+    auto n = PyList_Size(o);
+    nodes_.push_back({NodeType::List, n, {}});
+    for (Py_ssize_t i = 0; i < n; ++i) {
+      flatten_node(PyList_GetItem(o, i), flat, strict);
+    }
+  } else if (PyTuple_Check(o)) {
+    auto n = PyTuple_Size(o);
+    nodes_.push_back({NodeType::Tuple, n, {}});
+    for (Py_ssize_t i = 0; i < n; ++i) {
+      flatten_node(PyTuple_GetItem(o, i), flat, strict);
+    }
+  } else if (PyDict_Check(o)) {
+    auto keys = nb::steal(PyDict_Keys(o));
+    nodes_.push_back({NodeType::Dict, PyDict_Size(o), keys});
+    Py_ssize_t pos = 0;
+    PyObject* key;
+    PyObject* value;
+    while (PyDict_Next(o, &pos, &key, &value)) {
+      flatten_node(value, flat, strict);
+    }
+  } else if (is_array(obj)) {
+    flat.push_back(as_array(obj));
+    nodes_.push_back({NodeType::Array, 0, {}});
+  } else if (!strict) {
+    nodes_.push_back({NodeType::Leaf, 0, nb::borrow(obj)});
+  } else {
+    throw std::invalid_argument(
+        "[tree_flatten] The argument should contain only arrays");
   }
+}
 
-  return sentinel;
+nb::object TreeDef::unflatten(
+    const std::vector<array>& values,
+    int index /* = 0 */) const {
+  size_t node = 0;
+  return unflatten_node(node, values, index);
 }
 
-std::pair<std::vector<array>, nb::object> tree_flatten_with_structure(
-    nb::object tree,
+nb::object TreeDef::unflatten_node(
+    size_t& node,
+    const std::vector<array>& values,
+    int& index) const {
+  auto& n = nodes_[node++];
+  switch (n.type) {
+    case NodeType::List: {
+      auto l = nb::steal(PyList_New(n.size));
+      for (Py_ssize_t i = 0; i < n.size; ++i) {
+        PyList_SetItem(
+            l.ptr(), i, unflatten_node(node, values, index).release().ptr());
+      }
+      return l;
+    }
+    case NodeType::Tuple: {
+      auto t = nb::steal(PyTuple_New(n.size));
+      for (Py_ssize_t i = 0; i < n.size; ++i) {
+        PyTuple_SetItem(
+            t.ptr(), i, unflatten_node(node, values, index).release().ptr());
+      }
+      return t;
+    }
+    case NodeType::Dict: {
+      nb::dict d;
+      for (Py_ssize_t i = 0; i < n.size; ++i) {
+        auto value = unflatten_node(node, values, index);
+        PyDict_SetItem(d.ptr(), PyList_GetItem(n.obj.ptr(), i), value.ptr());
+      }
+      return d;
+    }
+    case NodeType::Array:
+      return nb::cast(values[index++]);
+    case NodeType::Leaf:
+    default:
+      return n.obj;
+  }
+}
+
+std::pair<std::vector<array>, TreeDef> tree_flatten_with_structure(
+    nb::handle tree,
     bool strict /* = true */) {
-  auto sentinel = structure_sentinel();
   std::vector<array> flat_tree;
-  auto structure = tree_map(
-      tree,
-      [&flat_tree, sentinel = std::move(sentinel), strict](nb::handle obj) {
-        if (nb::isinstance<array>(obj)) {
-          flat_tree.push_back(nb::cast<array>(obj));
-          return sentinel;
-        } else if (!strict) {
-          return nb::cast<nb::object>(obj);
-        } else {
-          throw std::invalid_argument(
-              "[tree_flatten] The argument should contain only arrays");
-        }
-      });
-
-  return {flat_tree, structure};
+  TreeDef structure(tree, flat_tree, strict);
+  return {std::move(flat_tree), std::move(structure)};
 }
 
 nb::object tree_unflatten_from_structure(
-    nb::object structure,
+    const TreeDef& structure,
     const std::vector<array>& values,
     int index /* = 0 */) {
-  auto sentinel = structure_sentinel();
-  return tree_map(structure, [&](nb::handle obj) {
-    if (obj.is(sentinel)) {
-      return nb::cast(values[index++]);
-    } else {
-      return nb::cast<nb::object>(obj);
-    }
-  });
+  return structure.unflatten(values, index);
 }
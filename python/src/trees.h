@@ -52,11 +52,59 @@ nb::object tree_unflatten(
     const std::vector<array>& values,
     int index = 0);
 
-std::pair<std::vector<array>, nb::object> tree_flatten_with_structure(
-    nb::object tree,
+/**
+ * The structure of a tree of lists, tuples and dicts. The nodes are stored
+ * in depth first order so that trees can be rebuilt from flat arrays without
+ * walking or copying the original tree. Leaves which are not arrays are kept
+ * as they are.
+ *
+ * Holds Python objects so it must be destroyed with the GIL held.
+ */
+class TreeDef {
+ public:
+  TreeDef() = default;
+
+  /** Get the structure of the tree and append its arrays to flat. */
+  TreeDef(nb::handle tree, std::vector<array>& flat, bool strict = true);
+
+  nb::object unflatten(const std::vector<array>& values, int index = 0) const;
+
+ private:
+  enum class NodeType : uint8_t { List, Tuple, Dict, Array, Leaf };
+
+  struct Node {
+    NodeType type;
+    // The number of children of lists, tuples and dicts
+    Py_ssize_t size;
+    // The keys of a dict or the object of a leaf
+    nb::object obj;
+  };
+
+  void flatten_node(nb::handle obj, std::vector<array>& flat, bool strict);
+  nb::object unflatten_node(
+      size_t& node,
+      const std::vector<array>& values,
+      int& index) const;
+
+  std::vector<Node> nodes_;
+};
+
+std::pair<std::vector<array>, TreeDef> tree_flatten_with_structure(
+    nb::handle tree,
     bool strict = true);
 
 nb::object tree_unflatten_from_structure(
-    nb::object structure,
+    const TreeDef& structure,
     const std::vector<array>& values,
     int index = 0);
+
+/**
+ * True if obj is an mlx array. Faster than nb::isinstance<array> which
+ * looks up the bound type on every call.
+ */
+bool is_array(nb::handle obj);
+
+/** The array of obj, which must be an mlx array. */
+inline array& as_array(nb::handle obj) {
+  return *nb::inst_ptr<array>(obj);
+}
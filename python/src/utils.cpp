@@ -1,9 +1,38 @@
 // Copyright © 2024 Apple Inc.
 
+#include <cstring>
+#include <map>
+
 #include "python/src/utils.h"
 #include "mlx/ops.h"
 #include "python/src/convert.h"
 
+namespace {
+
+// Scalars past this many per Python type are created on every use
+constexpr size_t max_interned_scalars = 256;
+
+// Returns a shared 0-d array for a Python scalar so constants such as the 1
+// in x + 1 don't allocate on every call. Only called with the GIL held.
+template <typename T>
+array interned_scalar(T v, Dtype dtype) {
+  // Leaked so the arrays aren't freed after the allocator at exit
+  static auto& scalars = *new std::map<std::pair<Dtype::Val, uint64_t>, array>;
+  uint64_t bits = 0;
+  std::memcpy(&bits, &v, sizeof(T));
+  std::pair<Dtype::Val, uint64_t> key{dtype.val, bits};
+  if (auto it = scalars.find(key); it != scalars.end()) {
+    return it->second;
+  }
+  array out(v, dtype);
+  if (scalars.size() < max_interned_scalars) {
+    scalars.emplace(key, out);
+  }
+  return out;
+}
+
+} // namespace
+
 array to_array(
     const ScalarOrArray& v,
     std::optional<Dtype> dtype /* = std::nullopt */) {
@@ -30,6 +59,26 @@ array to_array(
   }
 }
 
+array to_operand(
+    const ScalarOrArray& v,
+    std::optional<Dtype> dtype /* = std::nullopt */) {
+  if (auto pv = std::get_if<array>(&v); pv) {
+    return *pv;
+  } else if (auto pv = std::get_if<nb::bool_>(&v); pv) {
+    return interned_scalar(nb::cast<bool>(*pv), dtype.value_or(bool_));
+  } else if (auto pv = std::get_if<nb::int_>(&v); pv) {
+    auto out_t = dtype.value_or(int32);
+    // bool_ is an exception and is always promoted
+    return interned_scalar(
+        nb::cast<int>(*pv), (out_t == bool_) ? int32 : out_t);
+  } else if (auto pv = std::get_if<nb::float_>(&v); pv) {
+    auto out_t = dtype.value_or(float32);
+    return interned_scalar(
+        nb::cast<float>(*pv), issubdtype(out_t, floating) ? out_t : float32);
+  }
+  return to_array(v, dtype);
+}
+
 std::pair<array, array> to_arrays(
     const ScalarOrArray& a,
     const ScalarOrArray& b) {
@@ -57,12 +106,12 @@ std::pair<array, array> to_arrays(
       auto arr_b = get_mlx_array(b);
       return {arr_a, arr_b};
     }
-    return {arr_a, to_array(b, arr_a.dtype())};
+    return {arr_a, to_operand(b, arr_a.dtype())};
   } else if (is_mlx_array(b)) {
     auto arr_b = get_mlx_array(b);
-    return {to_array(a, arr_b.dtype()), arr_b};
+    return {to_operand(a, arr_b.dtype()), arr_b};
   } else {
-    return {to_array(a), to_array(b)};
+    return {to_operand(a), to_operand(b)};
   }
 }
 
@@ -70,6 +70,15 @@ array to_array(
     const ScalarOrArray& v,
     std::optional<Dtype> dtype = std::nullopt);
 
+/* Like to_array but Python scalars are interned. The result must only be used
+ * as an input of an op and never returned to Python, where it could be
+ * updated in place.
+ * */
+array to_operand(
+    const ScalarOrArray& v,
+    std::optional<Dtype> dtype = std::nullopt);
+
+// Arrays for the operands of a binary op, made with to_operand
 std::pair<array, array> to_arrays(
     const ScalarOrArray& a,
     const ScalarOrArray& b);
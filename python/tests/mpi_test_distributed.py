@@ -3,6 +3,7 @@
 import unittest
 
 import mlx.core as mx
+import mlx.nn as nn
 import mlx_tests
 
 
@@ -23,6 +24,21 @@ class TestDistributed(mlx_tests.MLXTestCase):
         sub = world.split(world.rank() // 2)
         self.assertEqual(sub.size(), 2)
 
+    def test_init_backend(self):
+        world = mx.distributed.init()
+        mpi = mx.distributed.init(backend="mpi")
+        self.assertEqual(world.size(), mpi.size())
+        self.assertEqual(world.rank(), mpi.rank())
+
+        # The ring backend is not configured so it falls back to a singleton
+        ring = mx.distributed.init(backend="ring")
+        self.assertEqual(ring.size(), 1)
+        with self.assertRaises(RuntimeError):
+            mx.distributed.init(strict=True, backend="ring")
+
+        with self.assertRaises(ValueError):
+            mx.distributed.init(backend="nccl")
+
     def test_all_reduce(self):
         world = mx.distributed.init()
         dtypes = [
@@ -46,6 +62,105 @@ class TestDistributed(mlx_tests.MLXTestCase):
             y = mx.distributed.all_sum(x, group=sub)
             self.assertTrue(mx.all(y == sub.size()))
 
+    def test_all_reduce_bucketed(self):
+        world = mx.distributed.init()
+        xs = [
+            mx.ones((2, 3)),
+            mx.ones((5,), dtype=mx.int32),
+            mx.ones((4, 4)),
+            mx.ones(()),
+            mx.ones((1000,)),
+        ]
+        for bucket_size in (16, 64, 1 << 20):
+            ys = mx.distributed.all_sum_bucketed(xs, bucket_size=bucket_size)
+            self.assertEqual(len(ys), len(xs))
+            for x, y in zip(xs, ys):
+                self.assertEqual(x.shape, y.shape)
+                self.assertEqual(x.dtype, y.dtype)
+                self.assertTrue(mx.all(y == world.size()))
+
+        grads = {"w": mx.ones((3, 3)) * world.rank(), "b": [mx.ones((3,))]}
+        avg = nn.average_gradients(grads, bucket_size=32)
+        self.assertTrue(mx.allclose(avg["w"], mx.full((3, 3), 3.5)))
+        self.assertTrue(mx.array_equal(avg["b"][0], mx.ones((3,))))
+
+    def test_all_reduce_compressed(self):
+        world = mx.distributed.init()
+        rank, size = world.rank(), world.size()
+
+        # The size is not divisible by the group size on purpose
+        x = mx.arange(21, dtype=mx.float32).reshape(3, 7) * (rank + 1)
+        expected = mx.arange(21, dtype=mx.float32).reshape(3, 7) * 36
+        for dt in (mx.float16, mx.bfloat16):
+            y = mx.distributed.all_sum_cast(x, dt)
+            self.assertEqual(y.dtype, mx.float32)
+            self.assertTrue(mx.allclose(y, expected, rtol=1e-2))
+        with self.assertRaises(ValueError):
+            mx.distributed.all_sum_cast(x, mx.int16)
+
+        grads = {"w": mx.ones((3, 3)) * rank, "b": [mx.ones((3,), mx.int32)]}
+        avg = nn.average_gradients(grads, communication_type=mx.bfloat16)
+        self.assertTrue(mx.allclose(avg["w"], mx.full((3, 3), 3.5)))
+        self.assertTrue(mx.array_equal(avg["b"][0], mx.ones((3,))))
+
+        # Every process sends the entry at its rank and keeps the next one
+        x = mx.eye(size)[rank] * 10
+        error = mx.eye(size)[(rank + 1) % size]
+        total, error = mx.distributed.all_sum_topk(x, error, 1)
+        self.assertTrue(mx.array_equal(total, mx.full((size,), 10.0)))
+        self.assertTrue(mx.array_equal(error, mx.eye(size)[(rank + 1) % size]))
+
+        # The error is sent by the next call
+        total, error = mx.distributed.all_sum_topk(mx.zeros_like(x), error, 1)
+        self.assertTrue(mx.array_equal(total, mx.ones((size,))))
+        self.assertTrue(mx.array_equal(error, mx.zeros_like(x)))
+
+    def test_all_reduce_hierarchical(self):
+        world = mx.distributed.init()
+        for shape in [(), (7,), (4, 5)]:
+            x = mx.ones(shape) * (world.rank() + 1)
+            y = mx.distributed.all_sum_hierarchical(x)
+            self.assertEqual(y.shape, x.shape)
+            self.assertTrue(mx.all(y == 36))
+
+        # Subgroups have their own topology
+        sub = world.split(world.rank() % 2)
+        y = mx.distributed.all_sum_hierarchical(mx.ones((3,)), group=sub)
+        self.assertTrue(mx.all(y == sub.size()))
+
+    def test_sharded_matmul(self):
+        world = mx.distributed.init()
+        rank, size = world.rank(), world.size()
+        mx.random.seed(0)
+        x = mx.random.normal((3, 64 * size))
+        w = mx.random.normal((70, 64 * size))
+        expected = x @ w.T
+
+        # Row parallel, every process has a slice of the input features
+        shard = slice(64 * rank, 64 * (rank + 1))
+        for n_chunks in (1, 3, 100):
+            y = mx.distributed.matmul_all_sum(
+                x[:, shard], w[:, shard], n_chunks=n_chunks
+            )
+            self.assertTrue(mx.allclose(y, expected, atol=1e-3, rtol=1e-3))
+
+        # Column parallel, every process has a slice of the output features
+        w = mx.random.normal((16 * size, 64))
+        expected = x[:, :64] @ w.T
+        shard = slice(16 * rank, 16 * (rank + 1))
+        y = mx.distributed.matmul_all_gather(x[:, :64], w[shard], n_chunks=3)
+        self.assertTrue(mx.allclose(y, expected, atol=1e-4, rtol=1e-4))
+
+        wq = mx.quantize(w[shard])
+        y = mx.distributed.quantized_matmul_all_gather(x[:, :64], *wq)
+        expected = x[:, :64] @ mx.dequantize(*wq).T
+        self.assertTrue(mx.allclose(y[:, shard], expected, atol=1e-4, rtol=1e-4))
+
+        wq = mx.quantize(w[:, :64])
+        y = mx.distributed.quantized_matmul_all_sum(x[:, :64], *wq, n_chunks=2)
+        expected = size * mx.quantized_matmul(x[:, :64], *wq)
+        self.assertTrue(mx.allclose(y, expected, atol=1e-3, rtol=1e-3))
+
     def test_all_gather(self):
         world = mx.distributed.init()
         dtypes = [
@@ -93,6 +208,98 @@ class TestDistributed(mlx_tests.MLXTestCase):
 
         self.assertTrue(mx.all(z == z_target))
 
+    def test_reduce_scatter(self):
+        world = mx.distributed.init()
+        x = mx.arange(16).reshape(8, 2) * (world.rank() + 1)
+        y = mx.distributed.reduce_scatter(x)
+        total = sum(range(1, world.size() + 1))
+        expected = mx.arange(16).reshape(8, 2)[world.rank() : world.rank() + 1]
+        self.assertTrue(mx.array_equal(y, expected * total))
+
+        # The gradient gathers the cotangents of every process
+        def fun(x):
+            return (mx.distributed.reduce_scatter(x) * (world.rank() + 1)).sum()
+
+        dx = mx.grad(fun)(mx.ones((8, 2)))
+        self.assertTrue(mx.array_equal(dx, mx.arange(1, 9)[:, None] * mx.ones((8, 2))))
+
+    def test_all_to_all(self):
+        world = mx.distributed.init()
+        rank, size = world.rank(), world.size()
+
+        # Row i of every process goes to process i
+        x = mx.arange(size)[:, None] + 100 * rank
+        y = mx.distributed.all_to_all(x)
+        self.assertTrue(mx.array_equal(y, rank + 100 * mx.arange(size)[:, None]))
+
+        # Process j sends j + 1 rows to every process
+        send_sizes = [rank + 1] * size
+        recv_sizes = list(range(1, size + 1))
+        x = mx.full((size * (rank + 1), 3), rank)
+        y = mx.distributed.all_to_all(x, send_sizes, recv_sizes)
+        expected = mx.concatenate([mx.full((j + 1, 3), j) for j in range(size)])
+        self.assertTrue(mx.array_equal(y, expected))
+
+        # The gradient sends the cotangents back
+        dx = mx.grad(
+            lambda x: (mx.distributed.all_to_all(x, send_sizes, recv_sizes) ** 2).sum()
+        )(x.astype(mx.float32))
+        self.assertTrue(mx.array_equal(dx, 2 * x))
+
+    def test_broadcast(self):
+        world = mx.distributed.init()
+        x = mx.ones((3, 2)) * world.rank()
+        y = mx.distributed.broadcast(x, 2)
+        self.assertTrue(mx.array_equal(y, mx.full((3, 2), 2.0)))
+
+        # Only the root receives a gradient, summed over the processes
+        dx = mx.grad(lambda x: mx.distributed.broadcast(x, 2).sum())(x)
+        expected = world.size() if world.rank() == 2 else 0
+        self.assertTrue(mx.array_equal(dx, mx.full((3, 2), expected)))
+
+    def test_send_recv(self):
+        world = mx.distributed.init()
+        pairs = world.split(world.rank() // 2)
+        neighbor = (pairs.rank() + 1) % 2
+        send = pairs.rank() == 0
+        x = mx.ones(10)
+        for i in range(10):
+            if send:
+                mx.eval(mx.distributed.send(2 * x, neighbor, group=pairs))
+            else:
+                x = mx.distributed.recv_like(x, neighbor, group=pairs)
+                mx.eval(x)
+            send = not send
+
+        self.assertTrue(mx.all(x == (1024 if pairs.rank() == 0 else 512)))
+
+        # The shape and dtype can also be given explicitly
+        if pairs.rank() == 0:
+            mx.eval(mx.distributed.send(mx.arange(6).reshape(2, 3), 1, group=pairs))
+        else:
+            y = mx.distributed.recv((2, 3), mx.int32, 0, group=pairs)
+            self.assertTrue(mx.array_equal(y, mx.arange(6).reshape(2, 3)))
+
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_collectives_gpu(self):
+        world = mx.distributed.init()
+        rank, size = world.rank(), world.size()
+
+        # The inputs are produced and consumed by GPU work
+        x = mx.exp(mx.zeros((4, size, 8))) * (rank + 1)
+        y = mx.distributed.all_sum(x, stream=mx.gpu) * 2
+        self.assertTrue(mx.array_equal(y, 2 * mx.distributed.all_sum(x)))
+
+        y = mx.distributed.all_gather(x[:, ::2], stream=mx.gpu)
+        self.assertTrue(mx.array_equal(y, mx.distributed.all_gather(x[:, ::2])))
+
+        x = mx.arange(2 * size, dtype=mx.float32) * (rank + 1)
+        y = mx.distributed.reduce_scatter(x, stream=mx.gpu)
+        self.assertTrue(mx.array_equal(y, mx.distributed.reduce_scatter(x)))
+
+        y = mx.distributed.broadcast(x + 1, 1, stream=mx.gpu)
+        self.assertTrue(mx.array_equal(y, mx.distributed.broadcast(x + 1, 1)))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -1,5 +1,6 @@
 # Copyright © 2023-2024 Apple Inc.
 
+import io
 import operator
 import pickle
 import sys
@@ -595,6 +596,22 @@ class TestArray(mlx_tests.MLXTestCase):
         x = mx.array(vals, dtype=mx.bfloat16)
         self.assertEqual(x.tolist(), vals)
 
+        # Element types and extreme values
+        x = mx.array([True, False]).tolist()
+        self.assertTrue(all(type(v) is bool for v in x))
+        x = mx.array([1, 2], mx.uint8).tolist()
+        self.assertTrue(all(type(v) is int for v in x))
+        vals = [np.iinfo(np.int64).min, np.iinfo(np.int64).max]
+        self.assertEqual(mx.array(vals, mx.int64).tolist(), vals)
+        vals = [0, np.iinfo(np.uint64).max]
+        self.assertEqual(mx.array(np.array(vals, np.uint64)).tolist(), vals)
+
+        # Large and strided arrays
+        x = mx.arange(1 << 20).reshape(1024, 1024)
+        self.assertEqual(x.tolist(), np.array(x).tolist())
+        self.assertEqual(x.T.tolist(), np.array(x.T).tolist())
+        self.assertEqual(x[::3, 1::2].tolist(), np.array(x)[::3, 1::2].tolist())
+
     def test_array_np_conversion(self):
         # Shape test
         a = np.array([])
@@ -779,6 +796,29 @@ class TestArray(mlx_tests.MLXTestCase):
             y = f(x, v)
             self.assertEqual(y.dtype, dtype_out)
 
+    def test_python_scalar_operands(self):
+        # Scalars are shared between ops, updating a result in place must
+        # not change them
+        a = mx.array([1.0, 2.0])
+        b = a + 1.0
+        b += 1.0
+        self.assertEqual((a + 1.0).tolist(), [2.0, 3.0])
+        c = mx.add(1, 2)
+        c += 5
+        self.assertEqual(mx.add(1, 2).item(), 3)
+
+        # The same value with different dtypes
+        self.assertEqual((mx.array([1], mx.int8) + 1).dtype, mx.int8)
+        self.assertEqual((mx.array([1.5]) + 1).tolist(), [2.5])
+        self.assertEqual((mx.array([True]) * True).dtype, mx.bool_)
+        self.assertEqual((-0.0 * mx.array([1.0])).tolist(), [-0.0])
+
+        # Many different scalars
+        x = mx.zeros((2,))
+        for i in range(1000):
+            x = x + i
+        self.assertEqual(x.tolist(), [499500.0, 499500.0])
+
     def test_array_comparison(self):
         a = mx.array([0.0, 1.0, 5.0])
         b = mx.array([-1.0, 2.0, 5.0])
@@ -1340,6 +1380,21 @@ class TestArray(mlx_tests.MLXTestCase):
         src = src.at[0:1].add(update)
         self.assertTrue(mx.array_equal(src, mx.array([[2.0, 4.0]])))
 
+        # Many colliding rows, as in the gradient of an embedding
+        idx = mx.random.randint(-8, 32, (4096,))
+        update = mx.random.normal((4096, 64))
+        for t in [mx.float32, mx.float16]:
+            u = update.astype(t)
+            a = mx.zeros((32, 64), t)
+            out = a.at[idx].add(u)
+            with mx.stream(mx.cpu):
+                expected = mx.zeros((32, 64)).at[idx].add(update)
+                expected_max = a.at[idx].maximum(u)
+            self.assertTrue(mx.allclose(out, expected, rtol=1e-2, atol=1e-1))
+            self.assertTrue(mx.array_equal(out, a.at[idx].add(u)))
+            out = a.at[idx].maximum(u)
+            self.assertTrue(mx.array_equal(out, expected_max))
+
     def test_slice_negative_step(self):
         a_np = np.arange(20)
         a_mx = mx.array(a_np)
@@ -1560,6 +1615,23 @@ class TestArray(mlx_tests.MLXTestCase):
         mv = None
         self.assertIsNone(wr())
 
+    def test_buffer_protocol_io(self):
+        a = mx.arange(12, dtype=mx.int32).reshape(3, 4) * 2
+        f = io.BytesIO()
+        f.write(a)
+        self.assertEqual(f.getvalue(), np.array(a).tobytes())
+
+        # Writing needs contiguous data
+        with self.assertRaises(BufferError):
+            f.write(a.T)
+        self.assertEqual(bytes(a.T), np.array(a).T.tobytes())
+
+        # The view keeps the data alive when the array is updated in place
+        mv = memoryview(a)
+        a[0, 0] = 100
+        self.assertEqual(mv[0, 0], 0)
+        self.assertEqual(a[0, 0].item(), 100)
+
     def test_array_view_ref_counting(self):
         a = mx.arange(3)
         wr = weakref.ref(a)
@@ -1753,6 +1825,38 @@ class TestArray(mlx_tests.MLXTestCase):
         y = np.from_dlpack(x)
         self.assertTrue(mx.array_equal(y, x))
 
+    def test_from_dlpack(self):
+        x = np.arange(1 << 16, dtype=np.float32).reshape(256, 256)
+        for y in [mx.from_dlpack(x), mx.array(x, copy=False)]:
+            self.assertEqual(y.dtype, mx.float32)
+            self.assertTrue(np.array_equal(np.array(y), x))
+
+        # The memory is shared
+        y = mx.from_dlpack(x)
+        x[0, 0] = -1
+        self.assertEqual(y[0, 0].item(), -1)
+
+        # The array keeps the memory alive
+        y = mx.from_dlpack(np.ones((128, 128), dtype=np.int32))
+        self.assertEqual(y.sum().item(), 128 * 128)
+
+        # The outputs of ops are never written to the shared memory
+        x = np.ones((256, 256), dtype=np.float32)
+        y = mx.exp(mx.from_dlpack(x))
+        mx.eval(y)
+        self.assertTrue(np.all(x == 1))
+
+        # Copies when the type is converted or the data not contiguous
+        x = np.ones((64, 64), dtype=np.float64)
+        y = mx.from_dlpack(x)
+        self.assertEqual(y.dtype, mx.float32)
+        x = np.arange(64, dtype=np.int32).reshape(8, 8)
+        y = mx.from_dlpack(x[::2, ::2])
+        self.assertTrue(np.array_equal(np.array(y), x[::2, ::2]))
+        y = mx.from_dlpack(x, copy=True)
+        x[0, 0] = -1
+        self.assertEqual(y[0, 0].item(), 0)
+
     def test_getitem_with_list(self):
         a = mx.array([1, 2, 3, 4, 5])
         idx = [0, 2, 4]
@@ -1774,6 +1878,34 @@ class TestArray(mlx_tests.MLXTestCase):
         self.assertTrue(np.array_equal(a[0, idx], anp[0, idx]))
         self.assertTrue(np.array_equal(a[:, idx], anp[:, idx]))
 
+    def test_int_index_slices(self):
+        a = mx.arange(24).reshape(4, 3, 2)
+        anp = np.array(a)
+        for i in [0, 2, -1, -4]:
+            self.assertTrue(np.array_equal(a[i], anp[i]))
+            self.assertEqual(a[i].shape, anp[i].shape)
+
+        ones = mx.ones((2,), mx.int32)
+        for i, v in [(1, 7), (-1, mx.ones((3, 2), mx.int32)), (0, ones)]:
+            a[i] = v
+            anp[i] = np.array(v)
+            self.assertTrue(np.array_equal(a, anp))
+
+        # A KV cache like update
+        cache = mx.zeros((2, 8, 4))
+        cnp = np.zeros((2, 8, 4), np.float32)
+        for t in range(3):
+            kv = mx.full((2, 1, 4), t + 1.0)
+            cache[..., t : t + 1, :] = kv
+            cnp[..., t : t + 1, :] = np.array(kv)
+            mx.eval(cache)
+        self.assertTrue(np.array_equal(cache, cnp))
+
+        # Gradients flow through integer indices
+        x = mx.arange(6, dtype=mx.float32).reshape(3, 2)
+        g = mx.grad(lambda x: x[1].sum())(x)
+        self.assertTrue(np.array_equal(g, [[0, 0], [1, 1], [0, 0]]))
+
     def test_setitem_with_list(self):
         a = mx.array([1, 2, 3, 4, 5])
         anp = np.array(a)
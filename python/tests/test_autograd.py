@@ -211,6 +211,35 @@ class TestAutograd(mlx_tests.MLXTestCase):
         self.assertTrue(isinstance(grads[1], dict))
         self.assertEqual(grads[1]["y"].item(), 0.5)
 
+    def test_cached_value_and_grad(self):
+        def loss(params, x):
+            return ((x @ params["w"] + params["b"]) ** 2).mean(), x.sum()
+
+        params = {"w": mx.ones((4, 2)), "b": mx.zeros((2,))}
+        x = mx.arange(12, dtype=mx.float32).reshape(3, 4)
+        (expected_loss, expected_aux), expected = mx.value_and_grad(loss)(params, x)
+
+        vg = mx.value_and_grad(loss, cache=True)
+        mx.reset_compile_cache_stats()
+        for _ in range(3):
+            (l, aux), grads = vg(params, x)
+            self.assertTrue(mx.allclose(l, expected_loss))
+            self.assertTrue(mx.allclose(aux, expected_aux))
+            self.assertTrue(mx.allclose(grads["w"], expected["w"]))
+            self.assertTrue(mx.allclose(grads["b"], expected["b"]))
+        stats = mx.compile_cache_stats()
+        self.assertEqual(stats["misses"], 1)
+        self.assertEqual(stats["hits"], 2)
+
+        # New shapes are traced again
+        vg(params, mx.ones((5, 4)))
+        self.assertEqual(mx.compile_cache_stats()["misses"], 2)
+
+        g = mx.grad(lambda x, y: (x * y).sum(), argnums=1, cache=True)
+        a, b = mx.array([1.0, 2.0]), mx.array([3.0, 4.0])
+        self.assertTrue(mx.array_equal(g(a, b), a))
+        self.assertTrue(mx.array_equal(g(b, a), b))
+
     def test_captured(self):
         a = mx.array(5.0)
         f = lambda x: a + x
@@ -496,6 +525,29 @@ class TestAutograd(mlx_tests.MLXTestCase):
         expected = mx.array([0.0, 0.0, 0.0, 9.0, 1.0])
         self.assertTrue(mx.allclose(out, expected))
 
+    def test_checkpoint_budget(self):
+        def fun(x, w1, w2):
+            h = mx.maximum(x @ w1, 0.0)
+            h = mx.exp(-h) * mx.sin(h)
+            h = mx.softmax(h @ w2, axis=-1)
+            return (h * mx.cos(h)).sum()
+
+        x = mx.random.uniform(shape=(16, 32))
+        w1 = mx.random.uniform(shape=(32, 32)) / 32
+        w2 = mx.random.uniform(shape=(32, 32)) / 32
+        expected = mx.value_and_grad(fun, argnums=(0, 1, 2))(x, w1, w2)
+
+        try:
+            # Discard some or all of the intermediates
+            for budget in [1, 4 * 16 * 32 * 2]:
+                mx.set_checkpoint_budget(budget)
+                out = mx.value_and_grad(fun, argnums=(0, 1, 2))(x, w1, w2)
+                self.assertTrue(mx.allclose(out[0], expected[0]))
+                for a, b in zip(out[1], expected[1]):
+                    self.assertTrue(mx.allclose(a, b))
+        finally:
+            mx.set_checkpoint_budget(0)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -61,6 +61,30 @@ class TestBlas(mlx_tests.MLXTestCase):
                     shape_b = (dim + p, dim + p)
                     self.__gemm_test(shape_a, shape_b, np_dtype)
 
+    def test_matmul_split_k(self):
+        if not mx.metal.is_available():
+            return
+
+        # Skinny outputs with long reductions are split over K
+        for dtype in self.dtypes:
+            np_dtype = getattr(np, dtype)
+            for M, N, K in [
+                (16, 1024, 4096),
+                (33, 250, 2050),
+                (64, 64, 8192),
+                (200, 130, 1000),
+            ]:
+                self.__gemm_test((M, K), (K, N), np_dtype)
+                self.__gemm_test(
+                    (K, M),
+                    (N, K),
+                    np_dtype,
+                    f_np_a=lambda x: x.T,
+                    f_np_b=lambda x: x.T,
+                    f_mx_a=lambda x: x.T,
+                    f_mx_b=lambda x: x.T,
+                )
+
     def test_matmul_shapes(self):
         if not mx.metal.is_available():
             return
@@ -519,6 +543,29 @@ class TestBlas(mlx_tests.MLXTestCase):
                                     )
                                     self.assertTrue(np.array_equal(c_mlx, c_npy))
 
+    def test_matmul_few_rows(self):
+        np.random.seed(0)
+        for dtype in self.dtypes:
+            np_dtype = getattr(np, dtype)
+            tol = 1e-4 if dtype == "float32" else 1e-2
+            for M, N, K in [(2, 33, 100), (3, 512, 4097), (5, 4096, 64), (8, 7, 8)]:
+                with self.subTest(dtype=dtype, shape=(M, N, K)):
+                    x_npy = np.random.normal(0.0, 1.0 / K, (M, K)).astype(np_dtype)
+                    w_npy = np.random.normal(0.0, 1.0, (N, K)).astype(np_dtype)
+                    c_npy = np.random.normal(0.0, 1.0, (N,)).astype(np_dtype)
+                    x, w, c = map(mx.array, (x_npy, w_npy, c_npy))
+
+                    expected = x_npy @ w_npy.T
+                    self.assertTrue(np.allclose(x @ w.T, expected, atol=tol))
+                    wt = mx.array(np.ascontiguousarray(w_npy.T))
+                    self.assertTrue(np.allclose(x @ wt, expected, atol=tol))
+
+                    expected = 0.5 * expected + 2.0 * c_npy
+                    out = mx.addmm(c, x, w.T, alpha=0.5, beta=2.0)
+                    self.assertTrue(np.allclose(out, expected, atol=tol))
+                    out = mx.addmm(mx.broadcast_to(c, (M, N)), x, wt, 0.5, 2.0)
+                    self.assertTrue(np.allclose(out, expected, atol=tol))
+
     def test_mismatch_stride_mm(self):
         np.random.seed(0)
         a_npy = np.random.normal(0.0, 1.0 / 128, (4, 16, 16)).astype(np.float32)
@@ -1100,6 +1147,28 @@ class TestBlas(mlx_tests.MLXTestCase):
 
         self.assertTrue(np.allclose(out_np, out_mx, atol=1e-5))
 
+    def test_gather_mm_sorted(self):
+        # Tokens routed to experts and grouped by expert like in a MoE layer
+        for L, E, N, K, transpose in (
+            (64, 4, 96, 40, False),
+            (33, 8, 64, 128, True),
+            (7, 3, 32, 16, False),
+        ):
+            with self.subTest(L=L, E=E, N=N, K=K, transpose=transpose):
+                a = mx.random.normal((L, 1, K))
+                b = mx.random.normal((E, K, N))
+                if transpose:
+                    b = mx.random.normal((E, N, K)).swapaxes(-1, -2)
+                indices = mx.sort(mx.random.randint(0, E, shape=(L,)))
+
+                c1 = mx.gather_mm(a, b, rhs_indices=indices)
+                c2 = mx.gather_mm(a, b, rhs_indices=indices, sorted_indices=True)
+                self.assertEqual(c2.shape, (L, 1, N))
+                self.assertTrue(mx.allclose(c1, c2, atol=1e-4))
+
+                c3 = a @ mx.take(b, indices, 0)
+                self.assertTrue(mx.allclose(c3, c2, atol=1e-4))
+
     def test_gather_matmul_grad(self):
         lhs_indices = mx.array([[7, 6], [4, 1], [0, 2]], dtype=mx.uint32)
         rhs_indices = mx.array([[2], [0], [1]], dtype=mx.uint32)
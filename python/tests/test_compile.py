@@ -1,6 +1,8 @@
 # Copyright © 2023-2024 Apple Inc.
 
 import io
+import os
+import tempfile
 import unittest
 from functools import partial
 
@@ -700,6 +702,27 @@ class TestCompile(mlx_tests.MLXTestCase):
         self.assertEqual(y1.item(), y2.item())
         self.assertEqual(y1.item(), 6)
 
+    def test_compile_tree_output(self):
+        def fn(x, params):
+            return {
+                "sum": x + params["w"][0],
+                "pair": (x, [params["w"][1] * 2, "leaf"]),
+                "none": None,
+            }
+
+        x = mx.array(1.0)
+        params = {"w": [mx.array(2.0), mx.array(3.0)]}
+        cfn = mx.compile(fn)
+        for _ in range(2):
+            out = cfn(x, params)
+            self.assertEqual(list(out.keys()), ["sum", "pair", "none"])
+            self.assertEqual(out["sum"].item(), 3.0)
+            self.assertIsInstance(out["pair"], tuple)
+            self.assertEqual(out["pair"][0].item(), 1.0)
+            self.assertEqual(out["pair"][1][0].item(), 6.0)
+            self.assertEqual(out["pair"][1][1], "leaf")
+            self.assertIsNone(out["none"])
+
     def test_inf_constant(self):
         def fn(x):
             return mx.where(mx.isinf(x), 0, 1)
@@ -707,6 +730,239 @@ class TestCompile(mlx_tests.MLXTestCase):
         x = mx.array([0, float("inf"), 1], dtype=mx.bfloat16)
         self.assertTrue(mx.array_equal(mx.compile(fn)(x), fn(x)))
 
+    def test_compile_fused_reduction(self):
+        def fn(x, y):
+            return mx.sum(mx.exp(x - y) * 2, axis=-1)
+
+        x = mx.random.uniform(shape=(8, 33))
+        y = mx.random.uniform(shape=(8, 33))
+        cfn = mx.compile(fn)
+        self.assertTrue(mx.allclose(cfn(x, y), fn(x, y)))
+
+        # Broadcast and transposed inputs
+        y = mx.random.uniform(shape=(33,))
+        self.assertTrue(mx.allclose(cfn(x, y), fn(x, y)))
+        x = mx.random.uniform(shape=(33, 8)).T
+        self.assertTrue(mx.allclose(cfn(x, y), fn(x, y)))
+
+        # Reductions over all axes and over several trailing axes
+        for op in [mx.sum, mx.max, mx.min, mx.prod]:
+
+            def fn(x, y):
+                return op(mx.abs(x) * y + 0.5)
+
+            x = mx.random.uniform(shape=(4, 5, 6))
+            y = mx.random.uniform(shape=(5, 6))
+            self.assertTrue(mx.allclose(mx.compile(fn)(x, y), fn(x, y)))
+
+            def fn(x):
+                return op(mx.abs(x) + 0.5, axis=(1, 2), keepdims=True)
+
+            self.assertTrue(mx.allclose(mx.compile(fn)(x), fn(x)))
+
+        # Low precision and integer inputs
+        def fn(x):
+            return mx.sum(x * 2, axis=-1)
+
+        x = mx.random.uniform(shape=(4, 100)).astype(mx.float16)
+        self.assertTrue(mx.allclose(mx.compile(fn)(x), fn(x), atol=1e-2))
+        x = mx.arange(400, dtype=mx.int32).reshape(4, 100)
+        self.assertTrue(mx.array_equal(mx.compile(fn)(x), fn(x)))
+
+        # An intermediate that is also an output is kept
+        def fn(x):
+            y = mx.exp(x) + 1
+            return y, mx.sum(y * 3, axis=-1)
+
+        x = mx.random.uniform(shape=(3, 7))
+        for a, b in zip(mx.compile(fn)(x), fn(x)):
+            self.assertTrue(mx.allclose(a, b))
+
+    def test_shapeless_fused_reduction(self):
+        def fn(x):
+            return mx.max(mx.exp(x) * 2, axis=-1)
+
+        cfn = mx.compile(fn, shapeless=True)
+        for shape in [(2, 3), (4, 17), (1, 1000)]:
+            x = mx.random.uniform(shape=shape)
+            self.assertTrue(mx.allclose(cfn(x), fn(x)))
+
+    def test_compile_cache_stats(self):
+        def fn(x):
+            return mx.exp(x) + 1
+
+        cfn = mx.compile(fn)
+        mx.reset_compile_cache_stats()
+        cfn(mx.zeros((2,)))
+        cfn(mx.zeros((2,)))
+        cfn(mx.zeros((3,)))
+        stats = mx.compile_cache_stats()
+        self.assertEqual(stats["hits"], 1)
+        self.assertEqual(stats["misses"], 2)
+        self.assertGreater(stats["trace_time"], 0)
+
+        # The least recently used graph is evicted
+        mx.set_compile_cache_capacity(2)
+        try:
+            mx.reset_compile_cache_stats()
+            cfn(mx.zeros((2,)))
+            cfn(mx.zeros((4,)))
+            cfn(mx.zeros((2,)))
+            cfn(mx.zeros((3,)))
+            stats = mx.compile_cache_stats()
+            self.assertEqual(stats["hits"], 2)
+            self.assertEqual(stats["misses"], 2)
+            self.assertEqual(stats["evictions"], 2)
+            out = cfn(mx.zeros((3,)))
+            self.assertTrue(mx.allclose(out, fn(mx.zeros((3,)))))
+        finally:
+            mx.set_compile_cache_capacity(128)
+
+    def test_compile_generated_kernels(self):
+        def fn(x, y):
+            return mx.exp(x) * y + 2
+
+        cfn = mx.compile(fn)
+
+        def run(n):
+            a = mx.random.uniform(shape=(n, 2 * n))
+            b = mx.random.uniform(shape=(2, 3, n, n))
+            inputs = [
+                (a, a),
+                (a, a[0]),
+                (a, mx.broadcast_to(a[:1], a.shape)),
+                (a.T, a.T),
+                (b, b.swapaxes(2, 3)),
+            ]
+            for x, y in inputs:
+                self.assertTrue(mx.allclose(cfn(x, y), fn(x, y)))
+
+        run(4)
+        self.assertIn("kernels", mx.compile_cache_stats())
+
+        # Other sizes with the same stride patterns reuse the kernels
+        mx.reset_compile_cache_stats()
+        run(6)
+        run(9)
+        self.assertEqual(mx.compile_cache_stats()["kernels"], 0)
+
+    def test_compile_reuses_intermediates(self):
+        def fn(x, w):
+            # Intermediates read several times, through views and by
+            # unfusable primitives
+            y = mx.exp(x @ w)
+            z = mx.softmax(y, axis=-1)
+            v = mx.reshape(y, (-1,))
+            a = mx.abs(z) @ w.T
+            b = mx.sum(y * z, axis=-1, keepdims=True)
+            return a - b, v * 2, mx.sin(a)
+
+        x = mx.random.uniform(shape=(8, 16))
+        w = mx.random.uniform(shape=(16, 16)) / 16
+        cfn = mx.compile(fn)
+        for _ in range(2):
+            for a, b in zip(cfn(x, w), fn(x, w)):
+                self.assertTrue(mx.allclose(a, b, atol=1e-5))
+
+    def test_compile_pad_into_conv(self):
+        x = mx.random.uniform(shape=(2, 9, 9, 4))
+        w = mx.random.uniform(shape=(8, 3, 3, 4))
+
+        # Symmetric zero padding is absorbed by the convolution, the rest
+        # keeps the padded copy
+        pads = [
+            ((0, 0), (1, 1), (1, 1), (0, 0)),
+            ((0, 0), (2, 2), (0, 0), (0, 0)),
+            ((0, 0), (0, 1), (0, 1), (0, 0)),
+            ((0, 0), (1, 1), (1, 1), (1, 1)),
+        ]
+        for pad_width in pads:
+            for value in [0.0, 1.0]:
+
+                def fn(x, w):
+                    y = mx.pad(x, pad_width, constant_values=value)
+                    return mx.conv2d(y, w, padding=1, stride=2)
+
+                def loss(x, w):
+                    return fn(x, w).sum()
+
+                if pad_width[-1] != (0, 0):
+                    w_ = mx.random.uniform(shape=(8, 3, 3, 6))
+                else:
+                    w_ = w
+                out = mx.compile(fn)(x, w_)
+                self.assertTrue(mx.allclose(out, fn(x, w_), atol=1e-4))
+                grads = mx.compile(mx.grad(loss, argnums=(0, 1)))(x, w_)
+                expected = mx.grad(loss, argnums=(0, 1))(x, w_)
+                for g, e in zip(grads, expected):
+                    self.assertTrue(mx.allclose(g, e, atol=1e-4))
+
+    def test_export_import_function(self):
+        w = mx.random.uniform(shape=(16, 8))
+        b = mx.array([1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0])
+
+        def fn(x, y):
+            h = mx.maximum(x @ w + b, 0.0)
+            h = mx.softmax(h.T, axis=-1).T
+            return mx.sum(h * y, axis=0), mx.sort(h, axis=-1)[:, ::2]
+
+        x = mx.random.uniform(shape=(4, 16))
+        y = mx.random.uniform(shape=(4, 8))
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "fn.mlxfn")
+            mx.export_function(path, fn, x, y)
+            imported = mx.import_function(path)
+
+        for _ in range(2):
+            for a, b in zip(imported(x, y), fn(x, y)):
+                self.assertTrue(mx.allclose(a, b))
+
+        # The inputs are checked against the exported ones
+        with self.assertRaises(ValueError):
+            imported(x)
+        with self.assertRaises(ValueError):
+            imported(x, mx.zeros((2, 8)))
+
+        def fn(x):
+            return mx.exp(x) * 2 + mx.abs(x)
+
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "fn.mlxfn")
+            mx.export_function(path, fn, mx.zeros((2, 3)), shapeless=True)
+            imported = mx.import_function(path)
+
+        for shape in [(2, 3), (5, 7)]:
+            x = mx.random.uniform(shape=shape)
+            self.assertTrue(mx.allclose(imported(x), fn(x)))
+
+        # Unsupported primitives throw on export
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "fn.mlxfn")
+            with self.assertRaises(ValueError):
+                mx.export_function(path, lambda x: mx.cumsum(x), x)
+
+    def test_compile_donate_inputs(self):
+        state = [mx.random.uniform(shape=(32,)), mx.zeros((32,))]
+
+        def step(g):
+            p, m = state
+            m = 0.9 * m + g
+            state[0] = p - 0.1 * m
+            state[1] = m
+            return mx.sum(state[0])
+
+        p, m = mx.array(state[0]), mx.array(state[1])
+        cstep = mx.compile(step, inputs=state, outputs=state, donate_inputs=True)
+        for _ in range(3):
+            g = mx.random.uniform(shape=(32,))
+            m = 0.9 * m + g
+            p = p - 0.1 * m
+            out = cstep(g)
+            mx.eval(out, state)
+            self.assertTrue(mx.allclose(state[0], p))
+            self.assertTrue(mx.allclose(state[1], m))
+            self.assertTrue(mx.allclose(out, p.sum()))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -856,6 +856,121 @@ class TestConv(mlx_tests.MLXTestCase):
             flip=flip,
         )
 
+    def test_conv_1d_3d_unit_dims(self):
+        # 1D convs and 3D convs with a unit depth filter are computed with
+        # the 2D kernels on the GPU so check them against the CPU
+        np.random.seed(0)
+        for N, L, C, O, K, stride, padding, dilation in (
+            (2, 32, 16, 32, 3, 1, 1, 1),
+            (2, 33, 3, 16, 5, 2, 2, 1),
+            (1, 64, 32, 32, 3, 1, 2, 2),
+            (3, 17, 16, 5, 4, 3, 0, 1),
+        ):
+            with self.subTest(N=N, L=L, C=C, O=O, K=K, stride=stride):
+                x = mx.array(np.random.normal(size=(N, L, C)).astype(np.float32))
+                w = mx.array(np.random.normal(size=(O, K, C)).astype(np.float32))
+                kwargs = dict(stride=stride, padding=padding, dilation=dilation)
+                out = mx.conv1d(x, w, **kwargs)
+                expected = mx.conv1d(x, w, stream=mx.cpu, **kwargs)
+                self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+
+        for N, D, C, O, kdim, stride, padding in (
+            (2, 4, 16, 32, (1, 3, 3), (1, 1, 1), (0, 1, 1)),
+            (1, 3, 3, 16, (1, 2, 2), (1, 2, 2), (0, 0, 0)),
+            (1, 4, 16, 16, (3, 3, 3), (1, 1, 1), (1, 1, 1)),
+        ):
+            with self.subTest(N=N, D=D, C=C, O=O, kdim=kdim, stride=stride):
+                shape = (N, D, 8, 8, C)
+                x = mx.array(np.random.normal(size=shape).astype(np.float32))
+                w = mx.array(np.random.normal(size=(O, *kdim, C)).astype(np.float32))
+                kwargs = dict(stride=stride, padding=padding)
+                out = mx.conv3d(x, w, **kwargs)
+                expected = mx.conv3d(x, w, stream=mx.cpu, **kwargs)
+                self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+
+    def test_conv_weight_grad(self):
+        # The weight gradient has its own kernel on the GPU so check it
+        # against the CPU
+        np.random.seed(0)
+
+        def weight_grad(x, w, ct, stream, **kwargs):
+            def f(w):
+                return (mx.conv_general(x, w, stream=stream, **kwargs) * ct).sum()
+
+            return mx.grad(f)(w)
+
+        for in_shape, wt_shape, stride, padding, dilation in (
+            ((2, 32, 16), (32, 3, 16), 1, 1, 1),
+            ((2, 33, 3), (16, 5, 3), 2, 2, 1),
+            ((1, 64, 32), (8, 3, 32), 1, 2, 2),
+            ((2, 16, 16, 32), (64, 3, 3, 32), 1, 1, 1),
+            ((1, 15, 9, 5), (7, 5, 5, 5), 2, 2, 1),
+            ((2, 12, 12, 16), (32, 3, 3, 16), (2, 1), (0, 1), (2, 1)),
+            ((1, 6, 8, 8, 8), (16, 3, 3, 3, 8), 1, 1, 1),
+            ((1, 7, 7, 7, 4), (8, 2, 3, 2, 4), 2, 1, (1, 2, 1)),
+        ):
+            with self.subTest(in_shape=in_shape, wt_shape=wt_shape):
+                x = mx.array(np.random.normal(size=in_shape).astype(np.float32))
+                w = mx.array(np.random.normal(size=wt_shape).astype(np.float32))
+                kwargs = dict(stride=stride, padding=padding, kernel_dilation=dilation)
+                ct = mx.conv_general(x, w, stream=mx.cpu, **kwargs)
+                ct = mx.array(np.random.normal(size=ct.shape).astype(np.float32))
+                out = weight_grad(x, w, ct, None, **kwargs)
+                expected = weight_grad(x, w, ct, mx.cpu, **kwargs)
+                self.assertTrue(mx.allclose(out, expected, atol=1e-3, rtol=1e-3))
+
+    def test_winograd_conv(self):
+        # Shapes taking the Winograd tiles of the GPU: F(6x6, 3x3) on large
+        # images, F(4x4, 3x3) on small ones and in bfloat16 and F(2x2, 5x5)
+        np.random.seed(0)
+        for dtype, atol in (
+            (mx.float32, 1e-3),
+            (mx.float16, 5e-2),
+            (mx.bfloat16, 2e-1),
+        ):
+            for N, H, W, C, O, K, padding in (
+                (1, 32, 32, 256, 256, 3, 1),
+                (2, 7, 9, 256, 256, 3, 1),
+                (1, 13, 11, 256, 256, 3, 0),
+                (1, 16, 16, 256, 256, 5, 2),
+            ):
+                with self.subTest(dtype=dtype, shape=(N, H, W, C, O, K)):
+                    x = np.random.normal(size=(N, H, W, C)) / np.sqrt(C * K)
+                    w = np.random.normal(size=(O, K, K, C))
+                    x = mx.array(x).astype(dtype)
+                    w = mx.array(w).astype(dtype)
+                    out = mx.conv2d(x, w, padding=padding)
+                    expected = mx.conv2d(x, w, padding=padding, stream=mx.cpu)
+                    self.assertTrue(mx.allclose(out, expected, atol=atol, rtol=atol))
+
+    def test_depthwise_conv(self):
+        np.random.seed(0)
+        for dtype, atol in ((mx.float32, 1e-4), (mx.float16, 1e-2)):
+            for N, L, C, K, stride, padding, dilation in (
+                (2, 32, 16, 3, 1, 1, 1),
+                (1, 33, 7, 5, 2, 2, 2),
+            ):
+                x = mx.array(np.random.normal(size=(N, L, C))).astype(dtype)
+                w = mx.array(np.random.normal(size=(C, K, 1))).astype(dtype)
+                kwargs = dict(
+                    stride=stride, padding=padding, dilation=dilation, groups=C
+                )
+                out = mx.conv1d(x, w, **kwargs)
+                expected = mx.conv1d(x, w, stream=mx.cpu, **kwargs)
+                self.assertTrue(mx.allclose(out, expected, atol=atol))
+
+            for N, H, W, C, K, stride, padding, flip in (
+                (2, 16, 16, 32, 3, 1, 1, False),
+                (1, 15, 9, 5, 5, 2, 2, False),
+                (2, 8, 8, 16, 3, 1, 2, True),
+            ):
+                x = mx.array(np.random.normal(size=(N, H, W, C))).astype(dtype)
+                w = mx.array(np.random.normal(size=(C, K, K, 1))).astype(dtype)
+                kwargs = dict(stride=stride, padding=padding, groups=C, flip=flip)
+                out = mx.conv_general(x, w, **kwargs)
+                expected = mx.conv_general(x, w, stream=mx.cpu, **kwargs)
+                self.assertTrue(mx.allclose(out, expected, atol=atol))
+
 
 if __name__ == "__main__":
     unittest.main()
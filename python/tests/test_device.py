@@ -112,6 +112,27 @@ class TestStream(mlx_tests.MLXTestCase):
         b = mx.add(x, y, stream=s_cpu)
         self.assertEqual(a.item(), b.item())
 
+    def test_stream_priority(self):
+        self.assertEqual(
+            mx.stream_priority(mx.default_stream(mx.cpu)), mx.StreamPriority.normal
+        )
+        devices = [mx.cpu, mx.gpu] if mx.metal.is_available() else [mx.cpu]
+        for d in devices:
+            low = mx.new_stream(d, mx.StreamPriority.low)
+            high = mx.new_stream(d, priority=mx.StreamPriority.high)
+            self.assertEqual(mx.stream_priority(low), mx.StreamPriority.low)
+            self.assertEqual(mx.stream_priority(high), mx.StreamPriority.high)
+
+            # Long work on the low priority stream and short work on the high
+            # priority one both run correctly
+            x = mx.random.normal((256, 256))
+            y = x
+            for _ in range(100):
+                y = mx.add(y, x, stream=low)
+            z = mx.multiply(x, 2, stream=high)
+            self.assertTrue(mx.allclose(z, 2 * x))
+            self.assertTrue(mx.allclose(y, 101 * x, rtol=1e-4))
+
 
 if __name__ == "__main__":
     unittest.main()
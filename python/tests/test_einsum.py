@@ -0,0 +1,72 @@
+# Copyright © 2024 Apple Inc.
+
+import unittest
+
+import mlx.core as mx
+import mlx_tests
+import numpy as np
+
+
+class TestEinsum(mlx_tests.MLXTestCase):
+    def test_against_numpy(self):
+        tests = [
+            ("ij,jk->ik", [(3, 4), (4, 5)]),
+            ("ij,jk", [(3, 4), (4, 5)]),
+            ("ij,jk->ki", [(3, 4), (4, 5)]),
+            ("ij->ji", [(3, 4)]),
+            ("ij->", [(3, 4)]),
+            ("i,j->ij", [(3,), (4,)]),
+            ("i,i->", [(5,), (5,)]),
+            ("ii->i", [(3, 3)]),
+            ("ii", [(3, 3)]),
+            ("iij->j", [(3, 3, 4)]),
+            ("bij,bjk->bik", [(2, 3, 4), (2, 4, 5)]),
+            ("bhqd,bhkd->bhqk", [(2, 3, 4, 8), (2, 3, 6, 8)]),
+            ("bhqk,bhkd->bqhd", [(2, 3, 4, 6), (2, 3, 6, 8)]),
+            ("...ij,...jk->...ik", [(2, 1, 3, 4), (3, 4, 5)]),
+            ("i...->...", [(3, 2, 4)]),
+            ("ij,jk,kl->il", [(2, 8), (8, 8), (8, 3)]),
+            ("ab,bc,cd,da->", [(2, 3), (3, 4), (4, 5), (5, 2)]),
+            ("ijk,jl,kl->il", [(2, 3, 4), (3, 5), (4, 5)]),
+            ("ij,ij->ij", [(3, 4), (1, 4)]),
+        ]
+        for subscripts, shapes in tests:
+            with self.subTest(subscripts=subscripts):
+                operands = [np.random.randn(*s).astype(np.float32) for s in shapes]
+                expected = np.einsum(subscripts, *operands)
+                out = mx.einsum(subscripts, *map(mx.array, operands))
+                self.assertEqual(out.shape, expected.shape)
+                self.assertTrue(np.allclose(out, expected, rtol=1e-4, atol=1e-4))
+
+    def test_integers(self):
+        a = np.arange(12, dtype=np.int32).reshape(3, 4)
+        b = np.arange(20, dtype=np.int32).reshape(4, 5)
+        out = mx.einsum("ij,jk->ik", mx.array(a), mx.array(b))
+        self.assertEqual(out.dtype, mx.int32)
+        self.assertTrue(np.array_equal(out, np.einsum("ij,jk->ik", a, b)))
+
+    def test_path(self):
+        a = mx.ones((2, 100))
+        b = mx.ones((100, 100))
+        c = mx.ones((100, 3))
+        path, desc = mx.einsum_path("ij,jk,kl->il", a, b, c)
+        self.assertEqual(path, [(0, 1), (0, 1)])
+        self.assertTrue(isinstance(desc, str))
+
+        path, _ = mx.einsum_path("ij,jk,kl->il", mx.ones((100, 100)), b, c)
+        self.assertEqual(path[0], (1, 2))
+
+    def test_errors(self):
+        a = mx.ones((3, 4))
+        with self.assertRaises(ValueError):
+            mx.einsum("ij,jk->ik", a)
+        with self.assertRaises(ValueError):
+            mx.einsum("ijk->", a)
+        with self.assertRaises(ValueError):
+            mx.einsum("ij,jk->il", a, a.T)
+        with self.assertRaises(ValueError):
+            mx.einsum("ij,jk->ik", a, a)
+
+
+if __name__ == "__main__":
+    unittest.main()
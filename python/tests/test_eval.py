@@ -1,10 +1,14 @@
 # Copyright © 2023 Apple Inc.
 
+import json
+import os
+import tempfile
 import unittest
 from functools import partial
 
 import mlx.core as mx
 import mlx_tests
+import numpy as np
 
 
 class TestEval(mlx_tests.MLXTestCase):
@@ -57,6 +61,46 @@ class TestEval(mlx_tests.MLXTestCase):
         mx.async_eval(y)
         self.assertEqual(x.item(), 3)
 
+    def test_async_eval_batch(self):
+        self.assertEqual(mx.async_eval_batch([]), [])
+
+        x = mx.array([1.0, 2.0, 3.0])
+        shared = mx.exp(x)
+        a = shared.sum()
+        b = shared + 1
+        events = mx.async_eval_batch([a, {"b": b, "c": [2 * a]}, mx.array(1)])
+        self.assertEqual(len(events), 3)
+        for e in events:
+            e.wait()
+            self.assertTrue(e.is_signaled())
+        self.assertTrue(mx.allclose(a, mx.exp(x).sum()))
+        self.assertTrue(mx.allclose(b, mx.exp(x) + 1))
+
+    def test_eval_cancelled(self):
+        x = mx.array([1.0, 2.0, 3.0])
+        y = mx.exp(x) + 1
+
+        token = mx.CancellationToken()
+        self.assertFalse(token.cancelled)
+        token.cancel()
+        self.assertTrue(token.cancelled)
+        with self.assertRaises(RuntimeError):
+            mx.eval(y, token=token)
+
+        # The array can still be evaluated
+        mx.eval(y)
+        self.assertTrue(mx.allclose(y, mx.exp(x) + 1))
+
+        y = mx.exp(x) * 2
+        mx.async_eval(y, token=token)
+        with self.assertRaises(RuntimeError):
+            mx.eval(y)
+        self.assertTrue(mx.allclose(y, mx.exp(x) * 2))
+
+        y = mx.exp(x) - 1
+        mx.eval(y, timeout=60.0)
+        self.assertTrue(mx.allclose(y, mx.exp(x) - 1))
+
     def test_async_eval_in_trace(self):
         def fun(x):
             y = x + 1.0
@@ -103,6 +147,145 @@ class TestEval(mlx_tests.MLXTestCase):
         z = mx.add(y, x, stream=mx.cpu)
         self.assertTrue(mx.allclose(z, mx.full((8000,), 22.0)))
 
+    def test_batch_split(self):
+        w = mx.arange(12, dtype=mx.float32).reshape(3, 4)
+        fun = mx.BatchSplit(lambda x: x @ w, cpu_fraction=0.25)
+        x = mx.arange(24, dtype=mx.float32).reshape(8, 3)
+        for _ in range(3):
+            self.assertTrue(mx.allclose(fun(x), x @ w))
+            self.assertTrue(0 < fun.cpu_fraction < 1)
+
+        fun = mx.BatchSplit(lambda x, y: [x + 1, y * 2], cpu_fraction=0.5)
+        a, b = fun(mx.zeros((4, 2)), mx.ones((4,)))
+        self.assertTrue(mx.array_equal(a, mx.ones((4, 2))))
+        self.assertTrue(mx.array_equal(b, mx.full((4,), 2.0)))
+
+        with self.assertRaises(ValueError):
+            fun(mx.zeros((4, 2)), mx.ones((3,)))
+
+    def test_prefetcher(self):
+        def batches():
+            for i in range(5):
+                yield {"x": np.full((4,), i, np.float32), "y": (mx.array(i), i)}
+
+        seen = []
+        for batch in mx.Prefetcher(batches(), size=2):
+            self.assertTrue(isinstance(batch["x"], mx.array))
+            self.assertEqual(batch["x"].tolist(), [batch["y"][1]] * 4)
+            self.assertEqual(batch["y"][0].item(), batch["y"][1])
+            seen.append(batch["y"][1])
+        self.assertEqual(seen, list(range(5)))
+
+        # Errors of the iterable are raised after the batches before them
+        def failing():
+            yield mx.array(1)
+            raise ValueError("no more batches")
+
+        prefetcher = mx.Prefetcher(failing())
+        self.assertEqual(next(prefetcher).item(), 1)
+        with self.assertRaises(ValueError):
+            next(prefetcher)
+        with self.assertRaises(StopIteration):
+            next(prefetcher)
+
+        # Not exhausting the iterable is fine
+        it = mx.Prefetcher(iter(mx.arange(10)), size=3)
+        self.assertEqual(next(it).item(), 0)
+        del it
+
+        with self.assertRaises(ValueError):
+            mx.Prefetcher(batches(), size=0)
+
+    def test_profiler(self):
+        x = mx.ones((8, 16))
+        mx.eval(x)
+
+        mx.profiler.start()
+        self.assertTrue(mx.profiler.is_enabled())
+        y = mx.exp(x).sum(axis=0)
+        mx.eval(y)
+        mx.profiler.stop()
+        self.assertFalse(mx.profiler.is_enabled())
+
+        events = mx.profiler.events()
+        names = [e["name"] for e in events]
+        self.assertTrue(any("Exp" in n for n in names))
+        for e in events:
+            self.assertLessEqual(e["start"], e["end"])
+        reduce = next(e for e in events if e["name"] == "Sum")
+        self.assertEqual(reduce["shapes"], [[16]])
+        self.assertEqual(reduce["nbytes"], 64)
+
+        with tempfile.TemporaryDirectory() as dir:
+            path = os.path.join(dir, "trace.json")
+            mx.profiler.save_trace(path)
+            with open(path) as f:
+                trace = json.load(f)
+        self.assertEqual(len(trace["traceEvents"]), len(events))
+
+        # Only one in sample_every evaluations is recorded
+        mx.profiler.start(sample_every=2)
+        for _ in range(4):
+            mx.eval(mx.exp(x))
+        mx.profiler.stop()
+        self.assertEqual(len(mx.profiler.events()), 2)
+
+        # Nothing is recorded after stopping
+        mx.eval(mx.exp(x))
+        self.assertEqual(len(mx.profiler.events()), 2)
+
+        with self.assertRaises(ValueError):
+            mx.profiler.start(sample_every=0)
+
+    def test_memory_tracking(self):
+        mx.memory.start_tracking()
+        self.assertTrue(mx.memory.is_tracking())
+        # The inputs are broadcast so Add can't donate either of their buffers
+        x = mx.ones((256, 1)) + mx.ones((1, 256))
+        with mx.memory.tag("outer"):
+            with mx.memory.tag("inner"):
+                mx.eval(x)
+
+        live = mx.memory.live_allocations()
+        self.assertEqual(live[0]["size"], x.nbytes)
+        self.assertEqual(live[0]["primitive"], "Add")
+        self.assertEqual(live[0]["tag"], "outer/inner")
+        self.assertIn("outer/inner", mx.memory.report())
+
+        # Freed buffers are no longer live
+        del x
+        live = mx.memory.live_allocations()
+        self.assertTrue(all(a["size"] < 256 * 256 * 4 for a in live))
+        timeline = mx.memory.timeline()
+        self.assertGreaterEqual(len(timeline), 2)
+        self.assertEqual(timeline, sorted(timeline, key=lambda s: s[0]))
+
+        mx.memory.stop_tracking()
+        self.assertFalse(mx.memory.is_tracking())
+
+    def test_memory_pressure(self):
+        levels = []
+        cb = mx.memory.add_pressure_callback(levels.append)
+
+        x = mx.zeros((256, 256))
+        mx.eval(x)
+        del x
+        mx.memory.handle_pressure(mx.memory.Pressure.warning)
+        self.assertEqual(mx.metal.get_cache_memory(), 0)
+        mx.memory.handle_pressure(mx.memory.Pressure.critical)
+        self.assertEqual(
+            levels, [mx.memory.Pressure.warning, mx.memory.Pressure.critical]
+        )
+
+        mx.memory.remove_pressure_callback(cb)
+        mx.memory.handle_pressure(mx.memory.Pressure.warning)
+        self.assertEqual(len(levels), 2)
+
+        if mx.memory.start_pressure_monitor():
+            self.assertTrue(mx.memory.is_monitoring_pressure())
+        mx.memory.stop_pressure_monitor()
+        self.assertFalse(mx.memory.is_monitoring_pressure())
+
 
 if __name__ == "__main__":
     unittest.main()
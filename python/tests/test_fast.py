@@ -7,12 +7,15 @@ import mlx.core as mx
 import mlx_tests
 
 
-def rope_orig(x, dims, traditional, base, scale, offset):
+def rope_orig(x, dims, traditional, base, scale, offset, freqs=None):
     N = x.shape[1] + offset
     dtype = x.dtype
     half_D = dims // 2
     positions = mx.arange(offset, N, dtype=dtype) * scale
-    freqs = mx.exp(-mx.arange(0.0, half_D, dtype=dtype) * (math.log(base) / half_D))
+    if freqs is None:
+        freqs = mx.exp(-mx.arange(0.0, half_D, dtype=dtype) * (math.log(base) / half_D))
+    else:
+        freqs = 1.0 / freqs.astype(dtype)
     theta = mx.reshape(positions, (-1, 1)) * mx.reshape(freqs, (1, -1))
     costheta, sintheta = mx.cos(theta), mx.sin(theta)
     if traditional:
@@ -165,6 +168,83 @@ class TestFast(mlx_tests.MLXTestCase):
                 g2 = mx.grad(f2)(x, y)
                 self.assertLess(mx.abs(g1 - g2).max(), 1e-5)
 
+    def test_rope_offset_array(self):
+        dims, base, scale = 8, 10000.0, 1.0
+        x = mx.random.uniform(shape=(3, 2, 5, 16))
+        offsets = [0, 3, 7]
+        for traditional in (True, False):
+            out = mx.fast.rope(
+                x,
+                dims,
+                traditional=traditional,
+                base=base,
+                scale=scale,
+                offset=mx.array(offsets),
+            )
+            expected = mx.stack(
+                [
+                    rope_orig(x[i], dims, traditional, base, scale, o)
+                    for i, o in enumerate(offsets)
+                ]
+            )
+            self.assertLess(mx.abs(out - expected).max(), 1e-5)
+
+        # A scalar array offset matches the integer one
+        out = mx.fast.rope(
+            x, dims, traditional=False, base=base, scale=scale, offset=mx.array(3)
+        )
+        expected = mx.fast.rope(
+            x, dims, traditional=False, base=base, scale=scale, offset=3
+        )
+        self.assertLess(mx.abs(out - expected).max(), 1e-5)
+
+        with self.assertRaises(ValueError):
+            mx.fast.rope(
+                x, dims, traditional=False, base=base, scale=scale, offset=mx.zeros(2)
+            )
+
+    def test_rope_freqs(self):
+        dims, base, scale = 8, 10000.0, 1.0
+        x = mx.random.uniform(shape=(2, 5, 16))
+        freqs = base ** (mx.arange(0, dims, 2) / dims)
+        for traditional in (True, False):
+            out = mx.fast.rope(
+                x,
+                dims,
+                traditional=traditional,
+                base=None,
+                scale=scale,
+                offset=2,
+                freqs=freqs,
+            )
+            expected = rope_orig(x, dims, traditional, base, scale, 2)
+            self.assertLess(mx.abs(out - expected).max(), 1e-4)
+
+            # Frequencies that don't follow the base
+            scaled = freqs * mx.array([1.0, 2.0, 4.0, 8.0])
+            out = mx.fast.rope(
+                x,
+                dims,
+                traditional=traditional,
+                base=None,
+                scale=scale,
+                offset=2,
+                freqs=scaled,
+            )
+            expected = rope_orig(x, dims, traditional, None, scale, 2, scaled)
+            self.assertLess(mx.abs(out - expected).max(), 1e-4)
+
+        with self.assertRaises(ValueError):
+            mx.fast.rope(
+                x,
+                dims,
+                traditional=False,
+                base=base,
+                scale=scale,
+                offset=0,
+                freqs=freqs,
+            )
+
     def test_rms_norm(self):
         # Per dtype absolute tolerance
         tolerances = {mx.float32: 1e-6, mx.float16: 1e-3, mx.bfloat16: 1e-2}
@@ -211,6 +291,41 @@ class TestFast(mlx_tests.MLXTestCase):
         rx_fast = mx.fast.rms_norm(x, weight, eps)
         self.assertLess(mx.abs(rx - rx_fast).max(), 1e-6)
 
+    def test_rms_norm_residual(self):
+        eps = 1e-5
+        for dtype in (mx.float32, mx.float16):
+            for dims in (16, 2048, 4100):
+                x = mx.random.uniform(shape=(2, 3, dims)).astype(dtype)
+                r = mx.random.uniform(shape=(2, 3, dims)).astype(dtype)
+                w = mx.random.uniform(shape=(dims,)).astype(dtype)
+                out, h = mx.fast.rms_norm_residual(x, r, w, eps)
+                self.assertEqual(h.dtype, dtype)
+                self.assertTrue(mx.array_equal(h, x + r))
+                expected = rms_norm(x + r, w, eps)
+                atol = 1e-5 if dtype == mx.float32 else 1e-3
+                self.assertLess(mx.abs(out - expected).max(), atol)
+
+        # Gradients flow through both outputs
+        x = mx.random.uniform(shape=(2, 3, 16))
+        r = mx.random.uniform(shape=(2, 3, 16))
+        w = mx.random.uniform(shape=(16,))
+
+        def loss(x, r, w):
+            out, h = mx.fast.rms_norm_residual(x, r, w, eps)
+            return (out * h).sum()
+
+        def ref_loss(x, r, w):
+            h = x + r
+            return (rms_norm(h, w, eps) * h).sum()
+
+        grads = mx.grad(loss, argnums=(0, 1, 2))(x, r, w)
+        ref_grads = mx.grad(ref_loss, argnums=(0, 1, 2))(x, r, w)
+        for g, ref_g in zip(grads, ref_grads):
+            self.assertLess(mx.abs(g - ref_g).max(), 1e-4)
+
+        with self.assertRaises(ValueError):
+            mx.fast.rms_norm_residual(x, r[0], w, eps)
+
     def test_rms_norm_grad(self):
         D = 32
         eps = 1e-5
@@ -401,6 +516,246 @@ class TestFast(mlx_tests.MLXTestCase):
         self.assertLess(mx.abs(gw1 - gw2).max() / mx.abs(gw1).mean(), 1e-5)
         self.assertLess(mx.abs(gb1 - gb2).max() / mx.abs(gb1).mean(), 1e-5)
 
+    def test_group_norm(self):
+        def group_norm_ref(x, w, b, groups, eps, pytorch_compatible):
+            batch, *rest, dims = x.shape
+            if pytorch_compatible:
+                y = x.reshape(batch, -1, groups, dims // groups)
+                axes = (1, 3)
+            else:
+                y = x.reshape(batch, -1, groups)
+                axes = (1,)
+            mean = mx.mean(y, axis=axes, keepdims=True)
+            var = mx.var(y, axis=axes, keepdims=True)
+            y = ((y - mean) * mx.rsqrt(var + eps)).reshape(x.shape)
+            if w is not None:
+                y = y * w
+            if b is not None:
+                y = y + b
+            return y
+
+        eps = 1e-5
+        for shape, groups in [((2, 8, 8, 32), 8), ((4, 16, 12), 4), ((3, 64), 16)]:
+            dims = shape[-1]
+            x = mx.random.normal(shape=shape)
+            w = mx.random.uniform(shape=(dims,))
+            b = mx.random.uniform(shape=(dims,))
+            for pytorch_compatible in [False, True]:
+                for wi, bi in [(w, b), (w, None), (None, b), (None, None)]:
+                    rx = group_norm_ref(x, wi, bi, groups, eps, pytorch_compatible)
+                    rx_fast = mx.fast.group_norm(
+                        x,
+                        wi,
+                        bi,
+                        groups,
+                        eps,
+                        pytorch_compatible=pytorch_compatible,
+                    )
+                    self.assertLess(mx.abs(rx - rx_fast).max(), 1e-4)
+
+                def f(fn, x, w, b):
+                    return (fn(x, w, b) * mx.cos(x)).sum()
+
+                g1 = mx.grad(
+                    lambda x, w, b: f(
+                        lambda *a: group_norm_ref(*a, groups, eps, pytorch_compatible),
+                        x,
+                        w,
+                        b,
+                    ),
+                    argnums=(0, 1, 2),
+                )(x, w, b)
+                g2 = mx.grad(
+                    lambda x, w, b: f(
+                        lambda *a: mx.fast.group_norm(
+                            *a, groups, eps, pytorch_compatible=pytorch_compatible
+                        ),
+                        x,
+                        w,
+                        b,
+                    ),
+                    argnums=(0, 1, 2),
+                )(x, w, b)
+                for a, b_ in zip(g1, g2):
+                    self.assertLess(mx.abs(a - b_).max() / mx.abs(a).mean(), 1e-4)
+
+        x = mx.random.normal(shape=(2, 16, 32)).astype(mx.float16)
+        rx = group_norm_ref(x.astype(mx.float32), None, None, 4, eps, True)
+        rx_fast = mx.fast.group_norm(x, None, None, 4, eps, pytorch_compatible=True)
+        self.assertEqual(rx_fast.dtype, mx.float16)
+        self.assertLess(mx.abs(rx - rx_fast).max(), 1e-2)
+
+        with self.assertRaises(ValueError):
+            mx.fast.group_norm(mx.zeros((2, 10)), None, None, 3, eps)
+
+    def test_batch_norm(self):
+        def batch_norm_ref(x, w, b, eps):
+            axes = tuple(range(x.ndim - 1))
+            mean = mx.mean(x, axis=axes)
+            var = mx.var(x, axis=axes)
+            return (x - mean) * mx.rsqrt(var + eps) * w + b
+
+        eps = 1e-5
+        for shape in [(16, 32), (4, 8, 8, 16), (2, 100, 3)]:
+            dims = shape[-1]
+            x = mx.random.normal(shape=shape) * 3 + 1
+            w = mx.random.uniform(shape=(dims,))
+            b = mx.random.uniform(shape=(dims,))
+            rx = batch_norm_ref(x, w, b, eps)
+            rx_fast = mx.fast.batch_norm(x, w, b, eps)
+            self.assertLess(mx.abs(rx - rx_fast).max(), 1e-4)
+
+            # Transposed inputs
+            xt = mx.swapaxes(x, 0, -2)
+            rx = batch_norm_ref(xt, w, b, eps)
+            rx_fast = mx.fast.batch_norm(xt, w, b, eps)
+            self.assertLess(mx.abs(rx - rx_fast).max(), 1e-4)
+
+            def f(fn, x, w, b):
+                return (fn(x, w, b, eps) * mx.sin(x)).sum()
+
+            argnums = (0, 1, 2)
+            g1 = mx.grad(lambda *a: f(batch_norm_ref, *a), argnums)(x, w, b)
+            g2 = mx.grad(lambda *a: f(mx.fast.batch_norm, *a), argnums)(x, w, b)
+            for a, b_ in zip(g1, g2):
+                self.assertLess(mx.abs(a - b_).max() / mx.abs(a).mean(), 1e-4)
+
+    def test_cross_entropy(self):
+        def reference(logits, targets):
+            lse = mx.logsumexp(logits.astype(mx.float32), axis=-1)
+            picked = mx.take_along_axis(logits, targets[..., None], -1)
+            return lse - picked.squeeze(-1).astype(mx.float32)
+
+        for V in [10, 1000, 50000]:
+            logits = 4 * mx.random.normal(shape=(3, 5, V))
+            targets = mx.random.randint(0, V, shape=(3, 5))
+            loss = mx.fast.cross_entropy(logits, targets)
+            self.assertEqual(loss.shape, targets.shape)
+            self.assertTrue(mx.allclose(loss, reference(logits, targets), atol=1e-4))
+
+            g = mx.grad(lambda x: mx.fast.cross_entropy(x, targets).sum())(logits)
+            g_ref = mx.grad(lambda x: reference(x, targets).sum())(logits)
+            self.assertTrue(mx.allclose(g, g_ref, atol=1e-5))
+
+        # Half precision
+        logits = mx.random.normal(shape=(8, 300)).astype(mx.float16)
+        targets = mx.random.randint(0, 300, shape=(8,))
+        loss = mx.fast.cross_entropy(logits, targets)
+        self.assertEqual(loss.dtype, mx.float16)
+        self.assertTrue(
+            mx.allclose(loss, reference(logits, targets).astype(mx.float16), atol=1e-2)
+        )
+
+        # Targets out of range are ignored
+        logits = mx.random.normal(shape=(4, 16))
+        targets = mx.array([1, -100, 3, 16])
+        loss = mx.fast.cross_entropy(logits, targets)
+        self.assertTrue(mx.array_equal(loss[mx.array([1, 3])], mx.zeros((2,))))
+        g = mx.grad(lambda x: mx.fast.cross_entropy(x, targets).sum())(logits)
+        self.assertTrue(mx.array_equal(g[1], mx.zeros((16,))))
+
+        with self.assertRaises(ValueError):
+            mx.fast.cross_entropy(logits, targets.astype(mx.float32))
+        with self.assertRaises(ValueError):
+            mx.fast.cross_entropy(logits, targets[:2])
+
+    def test_adam_update(self):
+        shapes = [(10,), (3, 7), (1,), (0,), (64, 33)]
+        ps = [mx.random.normal(shape=s) for s in shapes]
+        gs = [mx.random.normal(shape=s) for s in shapes]
+        ms = [mx.random.normal(shape=s) for s in shapes]
+        vs = [mx.random.uniform(shape=s) for s in shapes]
+        lr, b1, b2, eps, wd = 1e-2, 0.8, 0.95, 1e-6, 0.1
+
+        new_p, new_m, new_v = mx.fast.adam_update(
+            ps, gs, ms, vs, lr, beta1=b1, beta2=b2, eps=eps, weight_decay=wd
+        )
+        for p, g, m, v, p_i, m_i, v_i in zip(ps, gs, ms, vs, new_p, new_m, new_v):
+            m_ref = b1 * m + (1 - b1) * g
+            v_ref = b2 * v + (1 - b2) * mx.square(g)
+            p_ref = p * (1 - lr * wd) - lr * m_ref / (mx.sqrt(v_ref) + eps)
+            self.assertTrue(mx.allclose(m_i, m_ref, atol=1e-6))
+            self.assertTrue(mx.allclose(v_i, v_ref, atol=1e-6))
+            self.assertTrue(mx.allclose(p_i, p_ref, atol=1e-5))
+
+        # Half precision and parameters with gradients of another type
+        ps = [mx.random.normal(shape=(16,)).astype(mx.float16), mx.ones((4,))]
+        gs = [mx.ones((16,), mx.float16), mx.ones((4,), mx.float16)]
+        zs = [mx.zeros_like(p) for p in ps]
+        new_p, _, _ = mx.fast.adam_update(ps, gs, zs, zs, mx.array(0.1))
+        self.assertEqual(new_p[0].dtype, mx.float16)
+        self.assertEqual(new_p[1].dtype, mx.float32)
+        expected = 1 - 0.1 * 0.1 / math.sqrt(0.001)
+        self.assertTrue(mx.allclose(new_p[1], mx.full((4,), expected), atol=1e-2))
+
+        with self.assertRaises(ValueError):
+            mx.fast.adam_update(ps, gs[:1], zs, zs, 0.1)
+        with self.assertRaises(ValueError):
+            mx.fast.adam_update(ps, gs[::-1], zs, zs, 0.1)
+        with self.assertRaises(ValueError):
+            mx.fast.adam_update(ps, gs, zs, zs, mx.ones((2,)))
+
+    def test_lion_update(self):
+        shapes = [(10,), (3, 7), (64, 33)]
+        ps = [mx.random.normal(shape=s) for s in shapes]
+        gs = [mx.random.normal(shape=s) for s in shapes]
+        ms = [mx.random.normal(shape=s) for s in shapes]
+        lr, b1, b2, wd = 1e-3, 0.9, 0.99, 0.5
+
+        new_p, new_m = mx.fast.lion_update(
+            ps, gs, ms, lr, beta1=b1, beta2=b2, weight_decay=wd
+        )
+        for p, g, m, p_i, m_i in zip(ps, gs, ms, new_p, new_m):
+            c = b1 * m + (1 - b1) * g
+            p_ref = (1 - lr * wd) * p - lr * mx.sign(c)
+            m_ref = b2 * m + (1 - b2) * g
+            self.assertTrue(mx.allclose(p_i, p_ref, atol=1e-6))
+            self.assertTrue(mx.allclose(m_i, m_ref, atol=1e-6))
+
+    def test_mean_var(self):
+        x = mx.random.normal(shape=(4, 32, 33, 16))
+        for axes in [(1, 2), (0, 1, 2), (3,), (1, 3), (0, 1, 2, 3)]:
+            for keepdims in [False, True]:
+                m, v = mx.fast.mean_var(x, axis=axes, keepdims=keepdims)
+                m_ref = mx.mean(x, axis=axes, keepdims=keepdims)
+                v_ref = mx.var(x, axis=axes, keepdims=keepdims)
+                self.assertEqual(m.shape, m_ref.shape)
+                self.assertEqual(v.shape, v_ref.shape)
+                self.assertTrue(mx.allclose(m, m_ref, atol=1e-5))
+                self.assertTrue(mx.allclose(v, v_ref, atol=1e-5))
+
+        # Strided and broadcast inputs
+        y = x.transpose(3, 0, 2, 1)
+        m, v = mx.fast.mean_var(y, axis=(1, 3), ddof=1)
+        self.assertTrue(mx.allclose(m, mx.mean(y, axis=(1, 3)), atol=1e-5))
+        self.assertTrue(mx.allclose(v, mx.var(y, axis=(1, 3), ddof=1), atol=1e-5))
+        y = mx.broadcast_to(x[:, :1], x.shape)
+        m, v = mx.fast.mean_var(y, axis=(0, 1))
+        self.assertTrue(mx.allclose(m, mx.mean(y, axis=(0, 1)), atol=1e-5))
+        self.assertTrue(mx.allclose(v, mx.var(y, axis=(0, 1)), atol=1e-5))
+
+        # Large offsets are handled without cancellation
+        x = 1000 + mx.random.normal(shape=(8, 4096))
+        _, v = mx.fast.mean_var(x, axis=1)
+        self.assertTrue(mx.allclose(v, mx.var(x - 1000, axis=1), atol=1e-2))
+
+        # Half precision and integer inputs
+        x = mx.random.normal(shape=(16, 256)).astype(mx.float16)
+        m, v = mx.fast.mean_var(x, axis=1)
+        self.assertEqual(m.dtype, mx.float16)
+        self.assertTrue(mx.allclose(v, mx.var(x, axis=1), atol=1e-2))
+        x = mx.arange(64).reshape(8, 8)
+        m, v = mx.fast.mean_var(x, axis=0)
+        self.assertEqual(m.dtype, mx.float32)
+        self.assertTrue(mx.array_equal(m, mx.mean(x, axis=0)))
+        self.assertTrue(mx.allclose(v, mx.var(x, axis=0)))
+
+        # Gradients go through mean and var
+        x = mx.random.normal(shape=(8, 16))
+        g1 = mx.grad(lambda x: mx.fast.mean_var(x, axis=0)[1].sum())(x)
+        g2 = mx.grad(lambda x: mx.var(x, axis=0).sum())(x)
+        self.assertTrue(mx.allclose(g1, g2, atol=1e-5))
+
     def test_fast_transforms(self):
         x = mx.random.uniform(shape=(2, 2, 8))
 
@@ -439,6 +794,310 @@ class TestFast(mlx_tests.MLXTestCase):
         )(x)
         self.assertTrue(mx.allclose(vmap_out, vmap_fast_out))
 
+    def test_norm_jvp(self):
+        eps = 1e-5
+        x = mx.random.uniform(shape=(2, 3, 16))
+        w = mx.random.uniform(shape=(16,))
+        b = mx.random.uniform(shape=(16,))
+        tx, tw, tb = (mx.random.uniform(shape=a.shape) for a in (x, w, b))
+
+        _, jvp_out = mx.jvp(lambda x, w: rms_norm(x, w, eps), (x, w), (tx, tw))
+        _, jvp_fast_out = mx.jvp(
+            lambda x, w: mx.fast.rms_norm(x, w, eps), (x, w), (tx, tw)
+        )
+        self.assertTrue(mx.allclose(jvp_out[0], jvp_fast_out[0], atol=1e-5))
+
+        _, jvp_out = mx.jvp(
+            lambda x, w, b: layer_norm(x, w, b, eps), (x, w, b), (tx, tw, tb)
+        )
+        _, jvp_fast_out = mx.jvp(
+            lambda x, w, b: mx.fast.layer_norm(x, w, b, eps),
+            (x, w, b),
+            (tx, tw, tb),
+        )
+        self.assertTrue(mx.allclose(jvp_out[0], jvp_fast_out[0], atol=1e-5))
+
+        _, jvp_out = mx.jvp(lambda x: layer_norm(x, None, None, eps), (x,), (tx,))
+        _, jvp_fast_out = mx.jvp(
+            lambda x: mx.fast.layer_norm(x, None, None, eps), (x,), (tx,)
+        )
+        self.assertTrue(mx.allclose(jvp_out[0], jvp_fast_out[0], atol=1e-5))
+
+    def test_sdpa_jvp(self):
+        q, k, v = (mx.random.uniform(shape=(1, 2, 8, 32)) for _ in range(3))
+        tq, tk, tv = (mx.random.uniform(shape=(1, 2, 8, 32)) for _ in range(3))
+        scale = 32**-0.5
+
+        def sdpa_ref(q, k, v):
+            scores = (scale * q) @ k.swapaxes(-1, -2)
+            return mx.softmax(scores, axis=-1) @ v
+
+        def sdpa(q, k, v):
+            return mx.fast.scaled_dot_product_attention(q, k, v, scale=scale)
+
+        _, jvp_out = mx.jvp(sdpa_ref, (q, k, v), (tq, tk, tv))
+        _, jvp_fast_out = mx.jvp(sdpa, (q, k, v), (tq, tk, tv))
+        self.assertTrue(mx.allclose(jvp_out[0], jvp_fast_out[0], atol=1e-4))
+
+        _, jvp_out = mx.jvp(lambda v: sdpa_ref(q, k, v), (v,), (tv,))
+        _, jvp_fast_out = mx.jvp(lambda v: sdpa(q, k, v), (v,), (tv,))
+        self.assertTrue(mx.allclose(jvp_out[0], jvp_fast_out[0], atol=1e-4))
+
+    def test_quantized_matmul_epilogue(self):
+        mx.random.seed(0)
+        O = 256
+        D = 512
+        w = mx.random.normal((O, D)) / D**0.5
+        for bits, group_size in [(4, 64), (8, 32)]:
+            w_q, scales, biases = mx.quantize(w, group_size, bits)
+            for B in [1, 3, 33]:
+                x = mx.random.normal((B, D))
+                bias = mx.random.normal((O,))
+                gate = mx.random.normal((B, O))
+                residual = mx.random.normal((B, O))
+                silu_gate = gate * mx.sigmoid(gate)
+                y = mx.quantized_matmul(x, w_q, scales, biases, True, group_size, bits)
+
+                out = mx.fast.quantized_matmul(
+                    x, w_q, scales, biases, group_size=group_size, bits=bits
+                )
+                self.assertTrue(mx.allclose(out, y, atol=1e-4))
+
+                for kwargs, expected in [
+                    ({"bias": bias}, y + bias),
+                    ({"gate": gate}, silu_gate * y),
+                    ({"residual": residual}, y + residual),
+                    (
+                        {"bias": bias, "gate": gate, "residual": residual},
+                        silu_gate * (y + bias) + residual,
+                    ),
+                ]:
+                    out = mx.fast.quantized_matmul(
+                        x,
+                        w_q,
+                        scales,
+                        biases,
+                        group_size=group_size,
+                        bits=bits,
+                        **kwargs,
+                    )
+                    self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.fast.quantized_matmul(x, w_q, scales, biases, bias=mx.zeros((3,)))
+        with self.assertRaises(ValueError):
+            mx.fast.quantized_matmul(x, w_q, scales, biases, gate=mx.zeros((O,)))
+
+    def test_quantized_lora_matmul(self):
+        mx.random.seed(0)
+        O = 256
+        D = 512
+        r = 16
+        n = 3
+        w = mx.random.normal((O, D)) / D**0.5
+        w_q, scales, biases = mx.quantize(w)
+        lora_a = mx.random.normal((n, r, D)) / D**0.5
+        lora_b = mx.random.normal((n, O, r)) / r**0.5
+        for B in [1, 3, 33]:
+            x = mx.random.normal((B, D))
+            y = mx.quantized_matmul(x, w_q, scales, biases)
+
+            out = mx.fast.quantized_lora_matmul(
+                x, w_q, scales, biases, lora_a[1], lora_b[1], 0.5
+            )
+            expected = y + 0.5 * (x @ lora_a[1].T) @ lora_b[1].T
+            self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+
+            # Unsorted adapters so the blocks of rows mix them
+            ids = mx.random.randint(0, n, (B,))
+            out = mx.fast.quantized_lora_matmul(
+                x, w_q, scales, biases, lora_a, lora_b, 2.0, adapter_ids=ids
+            )
+            x_a = (x[:, None] @ lora_a[ids].swapaxes(-1, -2)).squeeze(1)
+            update = (x_a[:, None] @ lora_b[ids].swapaxes(-1, -2)).squeeze(1)
+            self.assertTrue(mx.allclose(out, y + 2.0 * update, atol=1e-4))
+
+        # The gradient of the adapter flows through the fused update
+        def loss(a, b):
+            out = mx.fast.quantized_lora_matmul(x, w_q, scales, biases, a, b)
+            return out.sum()
+
+        def expected_loss(a, b):
+            return (y + (x @ a.T) @ b.T).sum()
+
+        grads = mx.grad(loss, argnums=(0, 1))(lora_a[0], lora_b[0])
+        expected = mx.grad(expected_loss, argnums=(0, 1))(lora_a[0], lora_b[0])
+        for g, e in zip(grads, expected):
+            self.assertTrue(mx.allclose(g, e, atol=1e-3))
+
+        with self.assertRaises(ValueError):
+            mx.fast.quantized_lora_matmul(
+                x, w_q, scales, biases, lora_a[0], lora_b[0].T
+            )
+        with self.assertRaises(ValueError):
+            mx.fast.quantized_lora_matmul(
+                x, w_q, scales, biases, lora_a, lora_b, adapter_ids=mx.zeros((2,))
+            )
+
+    def test_quantized_matmul_w8a8(self):
+        mx.random.seed(0)
+        O = 96
+        D = 256
+        w = mx.random.normal((O, D)) / D**0.5
+        for group_size in [32, 64, 128]:
+            w_q, scales, biases = mx.quantize(w, group_size=group_size, bits=8)
+            for B in [1, 7, 40]:
+                x = mx.random.normal((2, B, D))
+                out = mx.fast.quantized_matmul_w8a8(
+                    x, w_q, scales, biases, group_size=group_size
+                )
+                self.assertEqual(out.shape, (2, B, O))
+
+                # The activations rounded like the kernel with a scale per row
+                x_scales = mx.abs(x).max(axis=-1, keepdims=True) / 127
+                x_hat = mx.round(x / x_scales) * x_scales
+                expected = mx.quantized_matmul(
+                    x_hat, w_q, scales, biases, group_size=group_size, bits=8
+                )
+                self.assertTrue(mx.allclose(out, expected, atol=1e-4, rtol=1e-4))
+
+                # And close to the float matmul
+                self.assertTrue(mx.allclose(out, x @ w.T, atol=5e-2))
+
+        with self.assertRaises(ValueError):
+            w_q, scales, biases = mx.quantize(w, bits=4)
+            mx.fast.quantized_matmul_w8a8(x, w_q, scales, biases)
+
+    def test_conv_general_epilogue(self):
+        mx.random.seed(0)
+        activations = {
+            "relu": lambda x: mx.maximum(x, 0),
+            "silu": lambda x: x * mx.sigmoid(x),
+            "gelu": lambda x: x * (1 + mx.erf(x / math.sqrt(2))) / 2,
+        }
+        # Covers the implicit gemm, general (transposed), depthwise and
+        # explicit gemm paths
+        for in_shape, wt_shape, kwargs in [
+            ((2, 16, 16, 16), (32, 3, 3, 16), {"padding": 1}),
+            ((2, 8, 8, 3), (8, 3, 3, 3), {"padding": 2, "input_dilation": 2}),
+            ((2, 8, 8, 16), (16, 3, 3, 1), {"padding": 1, "groups": 16}),
+            ((2, 9, 9, 5), (7, 3, 3, 5), {"stride": 2}),
+            ((2, 32, 16), (32, 5, 16), {"padding": 2}),
+        ]:
+            x = mx.random.normal(in_shape)
+            w = mx.random.normal(wt_shape)
+            bias = mx.random.normal((wt_shape[0],))
+            y = mx.conv_general(x, w, **kwargs)
+
+            out = mx.fast.conv_general(x, w, bias=bias, **kwargs)
+            self.assertTrue(mx.allclose(out, y + bias, atol=1e-4))
+
+            for name, act in activations.items():
+                out = mx.fast.conv_general(x, w, activation=name, **kwargs)
+                self.assertTrue(mx.allclose(out, act(y), atol=1e-4))
+                out = mx.fast.conv_general(x, w, bias=bias, activation=name, **kwargs)
+                self.assertTrue(mx.allclose(out, act(y + bias), atol=1e-4))
+
+        # Gradients go through the unfused ops
+        def loss(w, bias):
+            return mx.fast.conv_general(x, w, bias=bias, activation="silu").sum()
+
+        def ref_loss(w, bias):
+            return activations["silu"](mx.conv_general(x, w) + bias).sum()
+
+        x = mx.random.normal((1, 8, 8, 4))
+        w = mx.random.normal((8, 3, 3, 4))
+        bias = mx.random.normal((8,))
+        grads = mx.grad(loss, argnums=(0, 1))(w, bias)
+        ref_grads = mx.grad(ref_loss, argnums=(0, 1))(w, bias)
+        for g, rg in zip(grads, ref_grads):
+            self.assertTrue(mx.allclose(g, rg, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.fast.conv_general(x, w, bias=mx.zeros((3,)))
+        with self.assertRaises(ValueError):
+            mx.fast.conv_general(x, w, activation="tanh")
+
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_custom_kernel(self):
+        mx.random.seed(7)
+        a = mx.random.normal(shape=(2, 2))
+        kernel = mx.fast.metal_kernel(
+            name="basic",
+            input_names=["a"],
+            output_names=["out1"],
+            source="""
+                uint elem = thread_position_in_grid.x;
+                out1[elem] = a[elem];
+            """,
+        )
+        out = kernel(
+            inputs=[a],
+            grid=(4, 1, 1),
+            threadgroup=(2, 1, 1),
+            output_shapes=[(2, 2)],
+            output_dtypes=[mx.float32],
+        )
+        self.assertTrue(mx.array_equal(out[0], a))
+
+        # Template arguments and strided inputs
+        kernel = mx.fast.metal_kernel(
+            name="strided",
+            input_names=["inp"],
+            output_names=["out"],
+            source="""
+                uint elem = thread_position_in_grid.x;
+                uint loc = elem_to_loc(elem, inp_shape, inp_strides, inp_ndim);
+                T tmp = inp[loc];
+                out[elem] = metal::exp(tmp) * threads_per_threadgroup.x * (U ? 2 : 1);
+            """,
+            ensure_row_contiguous=False,
+        )
+        a = mx.random.normal(shape=(3, 6))[::2]
+        for dtype in [mx.float32, mx.float16]:
+            out = kernel(
+                inputs=[a.astype(dtype)],
+                template=[("T", dtype), ("U", True)],
+                grid=(a.size, 1, 1),
+                threadgroup=(2, 1, 1),
+                output_shapes=[a.shape],
+                output_dtypes=[dtype],
+            )
+            expected = mx.exp(a.astype(dtype)) * 4
+            self.assertTrue(mx.allclose(out[0], expected, rtol=1e-2))
+
+        # Outputs can be initialized and written atomically
+        kernel = mx.fast.metal_kernel(
+            name="atomic_sum",
+            input_names=["inp"],
+            output_names=["out"],
+            source="""
+                uint elem = thread_position_in_grid.x;
+                atomic_fetch_add_explicit(out, inp[elem], memory_order_relaxed);
+            """,
+            atomic_outputs=True,
+        )
+        a = mx.ones((64,))
+        out = kernel(
+            inputs=[a],
+            grid=(64, 1, 1),
+            threadgroup=(32, 1, 1),
+            output_shapes=[(1,)],
+            output_dtypes=[mx.float32],
+            init_value=1.0,
+        )
+        self.assertEqual(out[0].item(), 65.0)
+
+        with self.assertRaises(ValueError):
+            kernel(
+                inputs=[a],
+                grid=(64, 1, 1),
+                threadgroup=(32, 1, 1),
+                output_shapes=[(1,)],
+                output_dtypes=[mx.float32],
+                template=[("T", 1.5)],
+            )
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -1,3 +1,4 @@
+import io
 import math
 import unittest
 
@@ -7,14 +8,19 @@ import numpy as np
 
 
 # SDPA for MHA (n_heads == n_kv_heads)
-def mlx_primitives_sdpa(q, k, v, scale):
+def mlx_primitives_sdpa(q, k, v, scale, mask=None):
     p = (q * scale) @ k.transpose(0, 1, 3, 2)
+    if mask is not None:
+        if mask.dtype == mx.bool_:
+            p = mx.where(mask, p, -np.inf)
+        else:
+            p = p + mask
     scores = mx.softmax(p.astype(mx.float32), axis=-1).astype(p.dtype)
     return scores @ v
 
 
 # SDPA for GQA (n_heads > n_kv_heads, n_kv_heads > 1, n_heads % n_kv_heads == 0)
-def mlx_primitives_sdpa_with_gqa(q, k, v, scale):
+def mlx_primitives_sdpa_with_gqa(q, k, v, scale, mask=None):
     n_repeats = q.shape[1] // k.shape[1]
 
     # borrowing kv cache tiling from mlx-examples/llms/mistral/mistral.py
@@ -28,7 +34,14 @@ def mlx_primitives_sdpa_with_gqa(q, k, v, scale):
 
     k, v = map(repeat, (k, v))
 
-    return mlx_primitives_sdpa(q, k, v, scale)
+    return mlx_primitives_sdpa(q, k, v, scale, mask)
+
+
+# Checks that the graph of out goes through the fused Metal kernels
+def uses_fused_sdpa(out, primitive="ScaledDotProductAttention"):
+    buf = io.StringIO()
+    mx.export_to_dot(buf, out)
+    return primitive in buf.getvalue()
 
 
 class TestFastSelfAttentionSDPA(mlx_tests.MLXTestCase):
@@ -101,6 +114,421 @@ class TestFastSelfAttentionSDPA(mlx_tests.MLXTestCase):
 
                 self.assertTrue(mx.allclose(o_mlx, reference, rtol=rtol, atol=atol))
 
+    def test_fast_sdpa_masks(self):
+        np.random.seed(0)
+        B = 2
+        Dk = 64
+        scale = float(1.0 / np.sqrt(Dk))
+        for qL, kL in [(1, 37), (20, 20), (17, 50), (32, 100)]:
+            for n_kv_heads in [4, 2]:
+                shape = (B, 4, qL, Dk)
+                q = mx.array(np.random.normal(0.0, 1.0, shape).astype(np.float32))
+                shape = (B, n_kv_heads, kL, Dk)
+                k = mx.array(np.random.normal(0.0, 1.0, shape).astype(np.float32))
+                v = mx.array(np.random.normal(0.0, 1.0, shape).astype(np.float32))
+
+                # Bottom right aligned causal mask
+                causal = mx.arange(kL - qL, kL)[:, None] >= mx.arange(kL)[None]
+                reference = mlx_primitives_sdpa_with_gqa(q, k, v, scale, causal)
+                out = mx.fast.scaled_dot_product_attention(
+                    q, k, v, scale=scale, mask="causal"
+                )
+                self.assertTrue(mx.allclose(out, reference, atol=1e-4))
+
+                bool_mask = mx.array(np.random.uniform(size=(B, 4, qL, kL)) < 0.7)
+                bool_mask[..., 0] = True
+                reference = mlx_primitives_sdpa_with_gqa(q, k, v, scale, bool_mask)
+                out = mx.fast.scaled_dot_product_attention(
+                    q, k, v, scale=scale, mask=bool_mask
+                )
+                self.assertTrue(mx.allclose(out, reference, atol=1e-4))
+
+                additive = mx.array(np.random.normal(size=(1, 4, 1, kL)))
+                reference = mlx_primitives_sdpa_with_gqa(q, k, v, scale, additive)
+                out = mx.fast.scaled_dot_product_attention(
+                    q, k, v, scale=scale, mask=additive
+                )
+                self.assertTrue(mx.allclose(out, reference, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.fast.scaled_dot_product_attention(q, k, v, scale=scale, mask="full")
+        with self.assertRaises(ValueError):
+            mx.fast.scaled_dot_product_attention(
+                q, k, v, scale=scale, mask=mx.zeros((3, kL))
+            )
+
+    def test_fast_sdpa_fused_masks(self):
+        np.random.seed(0)
+        fused = mx.default_device() == mx.gpu
+        # Decoding a single query and prefill with the full attention kernel
+        for B, qL, kL, Dk in [(1, 1, 300, 128), (2, 16, 16, 64), (2, 40, 100, 128)]:
+            scale = float(1.0 / np.sqrt(Dk))
+            for n_kv_heads in [4, 1]:
+                for dtype in [mx.float32, mx.float16]:
+                    shape = (B, 4, qL, Dk)
+                    q = mx.array(np.random.normal(0.0, 1.0, shape), dtype)
+                    shape = (B, n_kv_heads, kL, Dk)
+                    k = mx.array(np.random.normal(0.0, 1.0, shape), dtype)
+                    v = mx.array(np.random.normal(0.0, 1.0, shape), dtype)
+
+                    causal = mx.arange(kL - qL, kL)[:, None] >= mx.arange(kL)[None]
+                    bool_mask = mx.array(np.random.uniform(size=(B, 1, qL, kL)) < 0.7)
+                    bool_mask[..., -1] = True
+                    additive = mx.array(np.random.normal(size=(4, qL, kL)), dtype)
+
+                    for mask, ref_mask in [
+                        ("causal", causal),
+                        (bool_mask, bool_mask),
+                        (additive, additive),
+                    ]:
+                        out = mx.fast.scaled_dot_product_attention(
+                            q, k, v, scale=scale, mask=mask
+                        )
+                        self.assertEqual(uses_fused_sdpa(out), fused)
+                        reference = mlx_primitives_sdpa_with_gqa(
+                            q.astype(mx.float32),
+                            k.astype(mx.float32),
+                            v.astype(mx.float32),
+                            scale,
+                            ref_mask,
+                        )
+                        atol = 1e-4 if dtype == mx.float32 else 1e-2
+                        self.assertTrue(
+                            mx.allclose(out.astype(mx.float32), reference, atol=atol)
+                        )
+
+        # Causal attention with more queries than keys is left to the fallback
+        q = mx.random.normal((1, 4, 32, 64))
+        k = mx.random.normal((1, 4, 16, 64))
+        out = mx.fast.scaled_dot_product_attention(q, k, k, scale=1.0, mask="causal")
+        self.assertFalse(uses_fused_sdpa(out))
+
+    def test_fast_sdpa_bfloat16_gqa(self):
+        np.random.seed(0)
+        Dk = 64
+        scale = float(1.0 / np.sqrt(Dk))
+        for B, qL, kL in [(1, 1, 100), (2, 32, 32), (1, 20, 70)]:
+            for n_kv_heads in [8, 2, 1]:
+                shape = (B, 8, qL, Dk)
+                q = mx.array(np.random.normal(0.0, 1.0, shape), mx.bfloat16)
+                shape = (B, n_kv_heads, kL, Dk)
+                k = mx.array(np.random.normal(0.0, 1.0, shape), mx.bfloat16)
+                v = mx.array(np.random.normal(0.0, 1.0, shape), mx.bfloat16)
+
+                reference = mlx_primitives_sdpa_with_gqa(
+                    q.astype(mx.float32),
+                    k.astype(mx.float32),
+                    v.astype(mx.float32),
+                    scale,
+                )
+                out = mx.fast.scaled_dot_product_attention(q, k, v, scale=scale)
+                self.assertEqual(out.dtype, mx.bfloat16)
+                self.assertEqual(out.shape, reference.shape)
+                self.assertTrue(
+                    mx.allclose(out.astype(mx.float32), reference, atol=5e-2)
+                )
+
+    def test_fast_sdpa_cache_view(self):
+        np.random.seed(0)
+        Dk = 128
+        scale = float(1.0 / np.sqrt(Dk))
+        for qL, kL in [(1, 100), (20, 70)]:
+            for n_kv_heads in [8, 2]:
+                q = mx.array(np.random.normal(0.0, 1.0, (1, 8, qL, Dk)), mx.float16)
+                shape = (1, n_kv_heads, kL, Dk)
+                k = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+                v = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+
+                # Views of the filled part of caches with room for more keys
+                empty = mx.zeros((1, n_kv_heads, 0, Dk), mx.float16)
+                _, k_view = mx.cache_append(empty, k, 0, axis=2, step=128)
+                _, v_view = mx.cache_append(empty, v, 0, axis=2, step=128)
+
+                reference = mx.fast.scaled_dot_product_attention(q, k, v, scale=scale)
+                out = mx.fast.scaled_dot_product_attention(
+                    q, k_view, v_view, scale=scale
+                )
+                self.assertTrue(mx.allclose(out, reference, atol=1e-4))
+
+    def test_fast_sdpa_tree_mask(self):
+        np.random.seed(0)
+        Dk = 128
+        scale = float(1.0 / np.sqrt(Dk))
+        # Verify draft tokens arranged in a tree after a prefix of keys
+        parents = [-1, 0, 0, 1, 1, 2]
+        n_draft = len(parents)
+        tree = np.zeros((n_draft, n_draft), dtype=bool)
+        for i, p in enumerate(parents):
+            tree[i, i] = True
+            if p >= 0:
+                tree[i] |= tree[p]
+        for kL in [100, 600]:
+            for n_kv_heads in [8, 2]:
+                prefix = np.ones((n_draft, kL - n_draft), dtype=bool)
+                mask = mx.array(np.concatenate([prefix, tree], axis=1))
+                q = mx.array(
+                    np.random.normal(0.0, 1.0, (1, 8, n_draft, Dk)), mx.float16
+                )
+                shape = (1, n_kv_heads, kL, Dk)
+                k = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+                v = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+
+                reference = mlx_primitives_sdpa_with_gqa(
+                    q.astype(mx.float32),
+                    k.astype(mx.float32),
+                    v.astype(mx.float32),
+                    scale,
+                    mask=mask,
+                )
+                out = mx.fast.scaled_dot_product_attention(
+                    q, k, v, scale=scale, mask=mask
+                )
+                self.assertEqual(out.shape, reference.shape)
+                self.assertTrue(
+                    mx.allclose(out.astype(mx.float32), reference, atol=1e-2)
+                )
+
+    def test_quantized_sdpa(self):
+        np.random.seed(0)
+        Dk = 128
+        bits = 8
+        scale = float(1.0 / np.sqrt(Dk))
+        for B, qL, kL in [(1, 1, 100), (2, 1, 300), (1, 20, 70)]:
+            for n_kv_heads in [8, 2]:
+                for group_size in [32, 64, 128]:
+                    shape = (B, 8, qL, Dk)
+                    q = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+                    shape = (B, n_kv_heads, kL, Dk)
+                    k = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+                    v = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+                    k_q = mx.quantize(k, group_size, bits)
+                    v_q = mx.quantize(v, group_size, bits)
+                    mask = mx.array(np.random.uniform(size=(B, 8, qL, kL)) < 0.7)
+
+                    for m in [None, mask]:
+                        reference = mx.fast.scaled_dot_product_attention(
+                            q,
+                            mx.dequantize(*k_q, group_size, bits),
+                            mx.dequantize(*v_q, group_size, bits),
+                            scale=scale,
+                            mask=m,
+                        )
+                        out = mx.fast.quantized_scaled_dot_product_attention(
+                            q,
+                            *k_q,
+                            *v_q,
+                            scale=scale,
+                            mask=m,
+                            group_size=group_size,
+                            bits=bits,
+                        )
+                        self.assertEqual(out.shape, reference.shape)
+                        self.assertTrue(mx.allclose(out, reference, atol=1e-2))
+
+    def test_paged_attention(self):
+        np.random.seed(0)
+        Dk = 128
+        block_size = 16
+        num_blocks = 20
+        scale = float(1.0 / np.sqrt(Dk))
+        lengths = [40, 64, 5]
+        tables = [[3, 7, 1, -1], [0, 2, 5, 9], [4, -1, -1, -1]]
+        for n_kv_heads in [8, 2]:
+            q = mx.array(np.random.normal(0.0, 1.0, (3, 8, 1, Dk)), mx.float16)
+            shape = (num_blocks, n_kv_heads, block_size, Dk)
+            k_cache = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+            v_cache = mx.array(np.random.normal(0.0, 1.0, shape), mx.float16)
+
+            out = mx.fast.paged_attention(
+                q,
+                k_cache,
+                v_cache,
+                mx.array(tables),
+                mx.array(lengths),
+                scale=scale,
+            )
+            self.assertEqual(out.shape, q.shape)
+
+            for i, (length, table) in enumerate(zip(lengths, tables)):
+                pages = table[: (length + block_size - 1) // block_size]
+                k = mx.concatenate([k_cache[p] for p in pages], axis=1)
+                v = mx.concatenate([v_cache[p] for p in pages], axis=1)
+                reference = mx.fast.scaled_dot_product_attention(
+                    q[i : i + 1],
+                    k[None, :, :length],
+                    v[None, :, :length],
+                    scale=scale,
+                )
+                self.assertTrue(mx.allclose(out[i : i + 1], reference, atol=1e-2))
+
+    def test_prefix_cache(self):
+        H, D, block_size = 2, 8, 4
+        cache = mx.fast.PrefixCache(8, H, block_size, D, mx.float32)
+        prompt = list(range(10))
+        seq, cached = cache.acquire(prompt)
+        self.assertEqual(cached, 0)
+        table = cache.block_table(seq)
+        self.assertEqual(len(table), 3)
+
+        k = mx.random.normal((H, 10, D))
+        v = mx.random.normal((H, 10, D))
+        cache.write(seq, 0, k, v)
+        paged = mx.concatenate([cache.keys[p] for p in table], axis=1)
+        self.assertTrue(mx.array_equal(paged[:, :10], k))
+
+        q = mx.random.normal((1, H, 1, D))
+        out = mx.fast.paged_attention(
+            q,
+            cache.keys,
+            cache.values,
+            mx.array([table]),
+            mx.array([10]),
+            scale=1.0,
+        )
+        reference = mx.fast.scaled_dot_product_attention(q, k[None], v[None], scale=1.0)
+        self.assertTrue(mx.allclose(out, reference, atol=1e-5))
+
+        # The full pages of a common prefix are shared
+        seq2, cached = cache.acquire(prompt[:8] + [100, 101])
+        self.assertEqual(cached, 8)
+        self.assertEqual(cache.block_table(seq2)[:2], table[:2])
+        self.assertNotEqual(cache.block_table(seq2)[2], table[2])
+
+        # The last token is always left to compute
+        seq3, cached = cache.acquire(prompt[:8])
+        self.assertEqual(cached, 4)
+
+        # Shared pages can't be written
+        with self.assertRaises(ValueError):
+            cache.write(seq2, 0, k[:, :4], v[:, :4])
+
+        for s in [seq, seq2, seq3]:
+            cache.release(s)
+        seq, cached = cache.acquire(prompt)
+        self.assertEqual(cached, 8)
+        cache.release(seq)
+
+        # Unused indexed pages are evicted when the pool is full
+        cache = mx.fast.PrefixCache(4, H, block_size, D, mx.float32)
+        seq, _ = cache.acquire(prompt)
+        cache.write(seq, 0, k, v)
+        cache.release(seq)
+        seq, cached = cache.acquire(list(range(100, 116)))
+        self.assertEqual(cached, 0)
+        cache.release(seq)
+        seq, cached = cache.acquire(prompt)
+        self.assertEqual(cached, 0)
+        with self.assertRaises(RuntimeError):
+            cache.acquire(list(range(8)))
+
+    def test_fast_sdpa_vjp(self):
+        np.random.seed(0)
+        B = 2
+        scale = 0.5
+        fused = mx.default_device() == mx.gpu
+        for Dk in [64, 128]:
+            for qL, kL in [(1, 17), (16, 16), (9, 33), (32, 64)]:
+                for n_kv_heads in [4, 2]:
+                    shape = (B, 4, qL, Dk)
+                    q = mx.array(np.random.normal(0.0, 0.5, shape).astype(np.float32))
+                    shape = (B, n_kv_heads, kL, Dk)
+                    k = mx.array(np.random.normal(0.0, 0.5, shape).astype(np.float32))
+                    v = mx.array(np.random.normal(0.0, 0.5, shape).astype(np.float32))
+                    causal = mx.arange(kL - qL, kL)[:, None] >= mx.arange(kL)[None]
+                    additive = mx.array(np.random.normal(size=(1, 4, 1, kL)))
+
+                    for mask, ref_mask in [
+                        (None, None),
+                        ("causal", causal),
+                        (causal, causal),
+                        (additive, additive),
+                    ]:
+
+                        def loss(q, k, v):
+                            out = mx.fast.scaled_dot_product_attention(
+                                q, k, v, scale=scale, mask=mask
+                            )
+                            return (out * out).sum()
+
+                        def ref_loss(q, k, v):
+                            out = mlx_primitives_sdpa_with_gqa(q, k, v, scale, ref_mask)
+                            return (out * out).sum()
+
+                        grads = mx.grad(loss, argnums=(0, 1, 2))(q, k, v)
+                        # Prefill goes through the fused backward kernels
+                        self.assertEqual(
+                            uses_fused_sdpa(grads, "ScaledDotProductAttentionVJP"),
+                            fused and qL >= 16,
+                        )
+                        expected = mx.grad(ref_loss, argnums=(0, 1, 2))(q, k, v)
+                        for g, e in zip(grads, expected):
+                            self.assertTrue(mx.allclose(g, e, atol=1e-4))
+
+    def test_fast_sdpa_window_alibi(self):
+        np.random.seed(0)
+        scale = 0.5
+        fused = mx.default_device() == mx.gpu
+        # Drafts being verified, prefill and a single query
+        for B, qL, kL, Dk in [(1, 4, 300, 128), (2, 20, 45, 64), (1, 1, 70, 128)]:
+            for n_kv_heads in [4, 2]:
+                shape = (B, 4, qL, Dk)
+                q = mx.array(np.random.normal(0.0, 0.5, shape).astype(np.float32))
+                shape = (B, n_kv_heads, kL, Dk)
+                k = mx.array(np.random.normal(0.0, 0.5, shape).astype(np.float32))
+                v = mx.array(np.random.normal(0.0, 0.5, shape).astype(np.float32))
+                slopes = mx.array([0.5, 0.25, 0.125, 0.0625])
+
+                q_pos = mx.arange(kL - qL, kL)[:, None]
+                k_pos = mx.arange(kL)[None]
+                alibi = slopes[:, None, None] * (k_pos - q_pos)
+                for window in [8, 64]:
+                    for mode in ["", "causal"]:
+                        ref_mask = q_pos - k_pos < window
+                        if mode == "causal":
+                            ref_mask = ref_mask & (q_pos >= k_pos)
+                        additive = mx.where(ref_mask, alibi, -np.inf)
+
+                        def sdpa(q, k, v):
+                            return mx.fast.scaled_dot_product_attention(
+                                q,
+                                k,
+                                v,
+                                scale=scale,
+                                mask=mode or None,
+                                window_size=window,
+                                alibi_slopes=slopes,
+                            )
+
+                        def ref_sdpa(q, k, v):
+                            return mlx_primitives_sdpa_with_gqa(
+                                q, k, v, scale, additive
+                            )
+
+                        out = sdpa(q, k, v)
+                        # The kernels only verify drafts without the causal mode
+                        causal_drafts = qL == 4 and mode == "causal"
+                        self.assertEqual(
+                            uses_fused_sdpa(out), fused and not causal_drafts
+                        )
+                        reference = ref_sdpa(q, k, v)
+                        self.assertTrue(mx.allclose(out, reference, atol=1e-4))
+
+                        grads = mx.grad(
+                            lambda *a: (sdpa(*a) ** 2).sum(), argnums=(0, 1, 2)
+                        )(q, k, v)
+                        expected = mx.grad(
+                            lambda *a: (ref_sdpa(*a) ** 2).sum(), argnums=(0, 1, 2)
+                        )(q, k, v)
+                        for g, e in zip(grads, expected):
+                            self.assertTrue(mx.allclose(g, e, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.fast.scaled_dot_product_attention(
+                q, k, v, scale=scale, alibi_slopes=mx.ones((3,))
+            )
+        with self.assertRaises(ValueError):
+            mx.fast.scaled_dot_product_attention(q, k, v, scale=scale, window_size=-1)
+
 
 class TestFastSDPA(mlx_tests.MLXTestCase):
     def test_fast_sdpa(self):
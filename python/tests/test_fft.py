@@ -151,6 +151,15 @@ class TestFFT(mlx_tests.MLXTestCase):
         for large_num in numbers:
             self._run_ffts((1, large_num), atol=1e-3)
 
+    def test_fft_large_composite(self):
+        # Sizes above the shared memory limit which split into two Stockham
+        # decomposable factors run as a four step FFT
+        for large_num in [84 * 84, 100 * 120, 64 * 160]:
+            self._run_ffts((3, large_num), atol=1e-3)
+
+        # 11 and 13 radices
+        self._run_ffts((3, 196 * 572), atol=1e-2)
+
     def test_fft_contiguity(self):
         r = np.random.rand(4, 8).astype(np.float32)
         i = np.random.rand(4, 8).astype(np.float32)
@@ -167,6 +167,131 @@ class TestLinalg(mlx_tests.MLXTestCase):
         for M, L in zip(AB, Ls):
             self.assertTrue(mx.allclose(L @ L.T, M, rtol=1e-5, atol=1e-7))
 
+    def test_inverse_cholesky_default_stream(self):
+        A = mx.random.normal((16, 40, 40)) + 80 * mx.eye(40)
+        A_inv = mx.linalg.inv(A)
+        self.assertTrue(mx.allclose(A @ A_inv, mx.eye(40), rtol=0, atol=1e-5))
+
+        S = A @ A.swapaxes(-1, -2)
+        L = mx.linalg.cholesky(S)
+        U = mx.linalg.cholesky(S, upper=True)
+        self.assertTrue(mx.array_equal(L, mx.tril(L)))
+        self.assertTrue(mx.array_equal(U, mx.triu(U)))
+        self.assertTrue(mx.allclose(L @ L.swapaxes(-1, -2), S, rtol=1e-4))
+        self.assertTrue(mx.allclose(U.swapaxes(-1, -2) @ U, S, rtol=1e-4))
+
+    def test_solve_triangular(self):
+        with self.assertRaises(ValueError):
+            mx.linalg.solve_triangular(mx.ones((2, 3)), mx.ones((2,)))
+
+        A = mx.random.normal((3, 6, 6)) + 12 * mx.eye(6)
+        b = mx.random.normal((3, 6, 2))
+        for upper in [False, True]:
+            T = mx.triu(A) if upper else mx.tril(A)
+            for s in [mx.cpu, None]:
+                x = mx.linalg.solve_triangular(A, b, upper=upper, stream=s)
+                self.assertTrue(mx.allclose(T @ x, b, rtol=1e-4, atol=1e-5))
+
+        # Broadcast batch and vector right hand side
+        L = mx.tril(A[0])
+        v = mx.random.normal((6,))
+        x = mx.linalg.solve_triangular(L, v)
+        self.assertEqual(x.shape, (6,))
+        self.assertTrue(mx.allclose(L @ x, v, rtol=1e-4, atol=1e-5))
+        x = mx.linalg.solve_triangular(L, b)
+        self.assertTrue(mx.allclose(L @ x, b, rtol=1e-4, atol=1e-5))
+
+        # Gradients against the explicit inverse
+        def f(a, b):
+            return mx.linalg.solve_triangular(a, b).sum()
+
+        ga, gb = mx.grad(f, argnums=(0, 1))(A[0], b[0])
+        L_inv = mx.linalg.inv(mx.tril(A[0]), stream=mx.cpu)
+        gb_ref = L_inv.T @ mx.ones_like(b[0])
+        ga_ref = -mx.tril(gb_ref @ (L_inv @ b[0]).T)
+        self.assertTrue(mx.allclose(ga, ga_ref, rtol=1e-3, atol=1e-5))
+        self.assertTrue(mx.allclose(gb, gb_ref, rtol=1e-3, atol=1e-5))
+
+    def test_solve(self):
+        with self.assertRaises(ValueError):
+            mx.linalg.solve(mx.ones((2, 3)), mx.ones((2,)))
+
+        A = mx.random.normal((3, 6, 6)) + 12 * mx.eye(6)
+        b = mx.random.normal((3, 6, 2))
+        for s in [mx.cpu, None]:
+            x = mx.linalg.solve(A, b, stream=s)
+            self.assertTrue(mx.allclose(A @ x, b, rtol=1e-4, atol=1e-5))
+            v = mx.random.normal((6,))
+            x = mx.linalg.solve(A[0], v, stream=s)
+            self.assertEqual(x.shape, (6,))
+            self.assertTrue(mx.allclose(A[0] @ x, v, rtol=1e-4, atol=1e-5))
+
+        # Gradients against the explicit inverse
+        def f(a, b):
+            return mx.linalg.solve(a, b).sum()
+
+        ga, gb = mx.grad(f, argnums=(0, 1))(A[0], b[0])
+        A_inv = mx.linalg.inv(A[0], stream=mx.cpu)
+        gb_ref = A_inv.T @ mx.ones_like(b[0])
+        ga_ref = -gb_ref @ (A_inv @ b[0]).T
+        self.assertTrue(mx.allclose(ga, ga_ref, rtol=1e-3, atol=1e-5))
+        self.assertTrue(mx.allclose(gb, gb_ref, rtol=1e-3, atol=1e-5))
+
+    def test_cho_solve(self):
+        B = mx.random.normal((2, 6, 6))
+        S = B @ B.swapaxes(-1, -2) + mx.eye(6)
+        b = mx.random.normal((2, 6, 3))
+        for upper in [False, True]:
+            L = mx.linalg.cholesky(S, upper=upper, stream=mx.cpu)
+            x = mx.linalg.cho_solve(L, b, upper)
+            self.assertTrue(mx.allclose(S @ x, b, rtol=1e-3, atol=1e-4))
+
+    def test_eigh(self):
+        with self.assertRaises(ValueError):
+            mx.linalg.eigh(mx.ones((2, 3)))
+
+        with self.assertRaises(ValueError):
+            mx.linalg.eigh(mx.ones((2, 2)), UPLO="X")
+
+        B = mx.random.normal((4, 8, 8))
+        A = B + B.swapaxes(-1, -2)
+        w_ref, _ = mx.linalg.eigh(A, stream=mx.cpu)
+        for s in [mx.cpu, None]:
+            for uplo in ["L", "U"]:
+                w, V = mx.linalg.eigh(A, UPLO=uplo, stream=s)
+                self.assertTrue(mx.allclose(w, w_ref, rtol=1e-4, atol=1e-4))
+                A_again = (V * w[..., None, :]) @ V.swapaxes(-1, -2)
+                self.assertTrue(mx.allclose(A_again, A, rtol=1e-4, atol=1e-4))
+                w = mx.linalg.eigvalsh(A, UPLO=uplo, stream=s)
+                self.assertTrue(mx.allclose(w, w_ref, rtol=1e-4, atol=1e-4))
+        self.assertTrue(mx.all(w_ref[..., 1:] >= w_ref[..., :-1]))
+
+        # The gradient of the sum of the eigenvalues is the identity
+        g = mx.grad(lambda a: mx.linalg.eigvalsh(a, stream=mx.cpu).sum())(A[0])
+        self.assertTrue(mx.allclose(g, mx.eye(8), atol=1e-4))
+
+    def test_qr_svd_default_stream(self):
+        A = mx.random.normal((8, 16, 16))
+        Q, R = mx.linalg.qr(A)
+        self.assertTrue(mx.allclose(Q @ R, A, rtol=1e-4, atol=1e-4))
+        I = mx.eye(16)
+        self.assertTrue(mx.allclose(Q.swapaxes(-1, -2) @ Q, I, rtol=1e-4, atol=1e-4))
+        self.assertTrue(mx.array_equal(R, mx.triu(R)))
+
+        for shape in [(4, 12, 7), (4, 7, 12)]:
+            A = mx.random.normal(shape)
+            U, S, Vt = mx.linalg.svd(A)
+            S_ref = mx.linalg.svd(A, stream=mx.cpu)[1]
+            self.assertTrue(mx.allclose(S, S_ref, rtol=1e-4, atol=1e-4))
+            k = S.shape[-1]
+            A_again = (U[..., :k] * S[..., None, :]) @ Vt[..., :k, :]
+            self.assertTrue(mx.allclose(A_again, A, rtol=1e-4, atol=1e-4))
+            for X in [U, Vt]:
+                I = mx.eye(X.shape[-1])
+                self.assertTrue(
+                    mx.allclose(X @ X.swapaxes(-1, -2), I, rtol=1e-4, atol=1e-4)
+                )
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -1,8 +1,10 @@
 # Copyright © 2023 Apple Inc.
 
+import io
 import os
 import tempfile
 import unittest
+import zipfile
 
 import mlx.core as mx
 import mlx_tests
@@ -63,6 +65,26 @@ class TestLoad(mlx_tests.MLXTestCase):
                         load_arr_mlx_npy = np.load(save_file_mlx)
                         self.assertTrue(np.array_equal(load_arr_mlx_npy, save_arr_npy))
 
+    def test_update_loaded(self):
+        if not os.path.isdir(self.test_dir):
+            os.mkdir(self.test_dir)
+
+        # Large enough to be copied on the stream's copy queue
+        a_np = np.random.uniform(size=(512, 1024)).astype(np.float32)
+        save_file = os.path.join(self.test_dir, "update_loaded.npy")
+        np.save(save_file, a_np)
+
+        # Keep a reference to the loaded array so the update copies it
+        a = mx.load(save_file)
+        a_t = a.T
+        a[0] = 1.0
+        b = mx.exp(a)
+        a_np_update = a_np.copy()
+        a_np_update[0] = 1.0
+        self.assertTrue(np.array_equal(a_t.T, a_np))
+        self.assertTrue(np.array_equal(a, a_np_update))
+        self.assertTrue(np.allclose(b, np.exp(a_np_update)))
+
     def test_save_and_load_safetensors(self):
         if not os.path.isdir(self.test_dir):
             os.mkdir(self.test_dir)
@@ -103,6 +125,36 @@ class TestLoad(mlx_tests.MLXTestCase):
                             mx.array_equal(load_dict["test"], save_dict["test"])
                         )
 
+    def test_weight_streamer(self):
+        if not os.path.isdir(self.test_dir):
+            os.mkdir(self.test_dir)
+
+        save_file = os.path.join(self.test_dir, "streamed.safetensors")
+        weights = {f"layers.{i}.weight": mx.random.normal((16, 16)) for i in range(4)}
+        weights["layers.0.bias"] = mx.zeros((16,))
+        mx.save_safetensors(save_file, weights)
+
+        loaded = mx.load(save_file)
+        layers = [
+            {k: v for k, v in loaded.items() if k.startswith(f"layers.{i}.")}
+            for i in range(4)
+        ]
+        streamer = mx.WeightStreamer(layers, lookahead=2)
+        self.assertEqual(len(streamer), 4)
+
+        # Two passes over the model read the weights again
+        for _ in range(2):
+            for i in range(len(streamer)):
+                layer = streamer[i]
+                self.assertEqual(set(layer.keys()), set(layers[i].keys()))
+                for k, v in layer.items():
+                    self.assertTrue(mx.array_equal(v, weights[k]))
+
+        with self.assertRaises(IndexError):
+            streamer[4]
+        with self.assertRaises(ValueError):
+            mx.WeightStreamer(layers, lookahead=-1)
+
     def test_save_and_load_gguf(self):
         if not os.path.isdir(self.test_dir):
             os.mkdir(self.test_dir)
@@ -132,6 +184,38 @@ class TestLoad(mlx_tests.MLXTestCase):
                             mx.array_equal(load_dict["test"], save_dict["test"])
                         )
 
+    def test_save_and_load_gguf_quantized(self):
+        if not os.path.isdir(self.test_dir):
+            os.mkdir(self.test_dir)
+
+        save_file = os.path.join(self.test_dir, "mlx_quantized.gguf")
+        w = mx.random.normal(shape=(64, 256))
+        for bits in (4, 8):
+            with self.subTest(bits=bits):
+                wq, scales, biases = mx.quantize(w, group_size=32, bits=bits)
+                scales = scales.astype(mx.float16)
+                if bits == 8:
+                    # Only symmetric 8 bit quantization has a GGUF type
+                    biases = -128 * scales
+                else:
+                    biases = biases.astype(mx.float16)
+                save_dict = {
+                    "layer.weight": wq,
+                    "layer.scales": scales,
+                    "layer.biases": biases,
+                    "other": mx.ones((10,)),
+                }
+                mx.save_gguf(save_file, save_dict)
+                load_dict = mx.load(save_file)
+                self.assertEqual(set(load_dict.keys()), set(save_dict.keys()))
+                for k, v in save_dict.items():
+                    self.assertTrue(mx.array_equal(load_dict[k], v))
+
+        wq, scales, biases = mx.quantize(w, group_size=64, bits=4)
+        save_dict = {"layer.weight": wq, "layer.scales": scales, "layer.biases": biases}
+        with self.assertRaises(ValueError):
+            mx.save_gguf(save_file, save_dict)
+
     def test_save_and_load_gguf_metadata_basic(self):
         if not os.path.isdir(self.test_dir):
             os.mkdir(self.test_dir)
@@ -329,6 +413,36 @@ class TestLoad(mlx_tests.MLXTestCase):
                     for k, v in load_arr_mlx_npy.items():
                         self.assertTrue(np.array_equal(save_arrs_npy[k], v))
 
+    def test_savez_and_loadz_file_object(self):
+        arrays = {
+            "a": mx.arange(12).reshape(3, 4),
+            "b": mx.zeros((1 << 16,), dtype=mx.uint8),
+        }
+        for save_fn, compression in (
+            (mx.savez, zipfile.ZIP_STORED),
+            (mx.savez_compressed, zipfile.ZIP_DEFLATED),
+        ):
+            f = io.BytesIO()
+            save_fn(f, **arrays)
+
+            # The archive is valid and its members are checked by zipfile
+            f.seek(0)
+            with zipfile.ZipFile(f) as z:
+                self.assertIsNone(z.testzip())
+                self.assertEqual(sorted(z.namelist()), ["a.npy", "b.npy"])
+                for info in z.infolist():
+                    self.assertEqual(info.compress_type, compression)
+
+            f.seek(0)
+            loaded = mx.load(f, format="npz")
+            for k, v in arrays.items():
+                self.assertTrue(mx.array_equal(loaded[k], v))
+
+            f.seek(0)
+            loaded = np.load(f)
+            for k, v in arrays.items():
+                self.assertTrue(np.array_equal(loaded[k], v))
+
     def test_non_contiguous(self):
         if not os.path.isdir(self.test_dir):
             os.mkdir(self.test_dir)
@@ -1,5 +1,8 @@
 # Copyright © 2023-2024 Apple Inc.
 
+import json
+import os
+import tempfile
 import unittest
 
 import mlx.core as mx
@@ -47,6 +50,125 @@ class TestMetal(mlx_tests.MLXTestCase):
         mx.metal.reset_peak_memory()
         self.assertEqual(mx.metal.get_peak_memory(), 0)
 
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_small_buffers(self):
+        # Small buffers are sub-allocated from shared heaps
+        mx.metal.clear_cache()
+        active_mem = mx.metal.get_active_memory()
+        xs = [mx.full((i + 1,), i) for i in range(2000)]
+        ys = [x * 2 for x in xs]
+        mx.eval(ys)
+        for i in range(0, 2000, 97):
+            self.assertTrue(mx.array_equal(ys[i], mx.full((i + 1,), 2 * i)))
+        self.assertTrue(mx.metal.get_active_memory() > active_mem)
+        del xs, ys
+        mx.synchronize()
+        self.assertEqual(mx.metal.get_active_memory(), active_mem)
+        mx.metal.clear_cache()
+        self.assertEqual(mx.metal.get_cache_memory(), 0)
+
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_cache_stats(self):
+        mx.metal.clear_cache()
+        mx.metal.reset_cache_stats()
+        for _ in range(2):
+            a = mx.zeros((4096,))
+            mx.eval(a)
+            del a
+            mx.synchronize()
+        stats = mx.metal.get_cache_stats()
+        self.assertTrue(stats["hits"] >= 1)
+        self.assertTrue(stats["misses"] >= 1)
+
+        mx.metal.reset_cache_stats()
+        stats = mx.metal.get_cache_stats()
+        self.assertEqual(stats["hits"], 0)
+        self.assertEqual(stats["misses"], 0)
+
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_wired_memory(self):
+        a = mx.zeros((1024, 1024))
+        mx.metal.make_resident(a)
+        self.assertEqual(mx.metal.get_wired_memory(), 0)
+
+        old_limit = mx.metal.set_wired_limit(1 << 30)
+        self.assertEqual(old_limit, 0)
+        wired = mx.metal.get_wired_memory()
+        self.assertTrue(wired == 0 or wired >= a.nbytes)
+
+        max_size = mx.metal.device_info()["max_recommended_working_set_size"]
+        with self.assertRaises(ValueError):
+            mx.metal.set_wired_limit(max_size + 10)
+
+        del a
+        mx.synchronize()
+        self.assertEqual(mx.metal.get_wired_memory(), 0)
+        mx.metal.set_wired_limit(0)
+
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_prepack(self):
+        x = mx.random.normal((1, 8, 8, 256))
+        # Winograd, grouped and strided weights
+        weights = [
+            mx.random.normal((256, 3, 3, 256)),
+            mx.random.normal((256, 3, 3, 8)),
+            mx.random.normal((256, 256, 3, 3)).transpose(0, 2, 3, 1),
+        ]
+        groups = [1, 32, 1]
+        expected = [
+            mx.conv2d(x, w, padding=1, groups=g) for w, g in zip(weights, groups)
+        ]
+        mx.eval(expected)
+
+        mx.metal.prepack(weights)
+        for _ in range(2):
+            for w, g, e in zip(weights, groups, expected):
+                out = mx.conv2d(x, w, padding=1, groups=g)
+                self.assertTrue(mx.allclose(out, e, rtol=1e-4, atol=1e-4))
+
+        mx.metal.clear_prepacked()
+        for w, g, e in zip(weights, groups, expected):
+            out = mx.conv2d(x, w, padding=1, groups=g)
+            self.assertTrue(mx.allclose(out, e, rtol=1e-4, atol=1e-4))
+
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_precompile(self):
+        @mx.compile
+        def fun(x, w):
+            return mx.softmax(x @ w, axis=-1).sum(axis=0)
+
+        x = mx.random.normal((4, 32))
+        w = mx.random.normal((32, 16))
+        out = fun(x, w)
+        mx.metal.precompile({"out": out})
+
+        # The arrays are left unevaluated and still compute the right value
+        expected = mx.softmax(x @ w, axis=-1).sum(axis=0)
+        self.assertTrue(mx.allclose(out, expected))
+        self.assertTrue(mx.allclose(fun(x, w), expected))
+
+    @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
+    def test_profiling(self):
+        a = mx.random.normal((256, 256))
+        mx.eval(a)
+        mx.metal.start_profiling()
+        mx.eval(mx.exp(a) @ a)
+        mx.metal.stop_profiling()
+
+        profile = mx.metal.get_profile()
+        self.assertIn("Exp", profile)
+        count, msec = profile["Exp"]
+        self.assertEqual(count, 1)
+        self.assertGreaterEqual(msec, 0.0)
+
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "trace.json")
+            mx.metal.save_profile_trace(path)
+            with open(path) as f:
+                trace = json.load(f)
+        names = [e["name"] for e in trace["traceEvents"]]
+        self.assertIn("Exp", names)
+
 
 if __name__ == "__main__":
     unittest.main()
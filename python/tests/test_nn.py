@@ -54,6 +54,36 @@ class TestBase(mlx_tests.MLXTestCase):
 
         m.apply_to_modules(assert_training)
 
+    def test_compile_bucketed(self):
+        def fn(x, w, mask):
+            x = mx.where(mask[:, None], x @ w, 0)
+            return x * 2, mx.sum(x, axis=0)
+
+        w = mx.random.normal((4, 3))
+        bfn = nn.compile_bucketed(fn, in_axes=(0, None), out_axes=(0, None))
+        for n in [1, 3, 5, 8, 9]:
+            x = mx.random.normal((n, 4))
+            y, s = bfn(x, w)
+            expected = x @ w
+            self.assertEqual(y.shape, (n, 3))
+            self.assertTrue(mx.allclose(y, expected * 2, atol=1e-5))
+            self.assertTrue(mx.allclose(s, expected.sum(axis=0), atol=1e-5))
+
+        # Explicit buckets and sizes beyond the last one
+        bfn = nn.compile_bucketed(
+            lambda x, mask: mx.cumsum(x, axis=-1),
+            in_axes=(-1,),
+            out_axes=-1,
+            buckets=(4, 16),
+        )
+        for n in [2, 4, 10, 20]:
+            x = mx.random.normal((2, n))
+            self.assertTrue(mx.allclose(bfn(x), mx.cumsum(x, axis=-1), atol=1e-5))
+
+        with self.assertRaises(ValueError):
+            bfn = nn.compile_bucketed(fn, in_axes=(0, 0))
+            bfn(mx.zeros((3, 4)), mx.zeros((4, 3)))
+
     def test_module_attributes(self):
         class Model(nn.Module):
             def __init__(self):
@@ -676,6 +676,28 @@ class TestOps(mlx_tests.MLXTestCase):
         self.assertListEqual(list(b_npy.shape), list(b_mlx.shape))
         self.assertTrue(np.array_equal(b_npy, b_mlx))
 
+    def test_general_strided_elementwise(self):
+        # Dims which do not collapse with inner sizes that are not a multiple
+        # of the elements handled per thread
+        for shape in [(3, 5), (2, 3, 4, 5), (2, 3, 2, 3, 7), (2, 1, 3, 2, 3, 5)]:
+            perm = list(reversed(range(len(shape))))
+            a_npy = np.random.normal(size=shape).astype(np.float32)
+            b_npy = np.random.normal(size=shape[-1:]).astype(np.float32)
+            a_npy = np.transpose(a_npy, perm)
+            a_mlx = mx.transpose(mx.array(np.transpose(a_npy, perm)), perm)
+            b_mlx = mx.array(b_npy)
+
+            self.assertTrue(np.allclose(a_mlx + 1.0, a_npy + 1.0))
+            self.assertTrue(np.allclose(mx.exp(a_mlx), np.exp(a_npy)))
+            self.assertTrue(np.array_equal(np.array(a_mlx * 1), a_npy))
+            self.assertTrue(np.allclose(a_mlx.T + b_mlx, a_npy.T + b_npy))
+            self.assertTrue(
+                np.allclose(
+                    mx.where(a_mlx > 0, a_mlx, b_mlx[0]),
+                    np.where(a_npy > 0, a_npy, b_npy[0]),
+                )
+            )
+
     def test_logsumexp(self):
         x = mx.array(
             [
@@ -1039,6 +1061,17 @@ class TestOps(mlx_tests.MLXTestCase):
         self.assertEqual(a_npy_taken.shape, a_mlx_taken.shape)
         self.assertListEqual(a_npy_taken.tolist(), a_mlx_taken.tolist())
 
+        # Whole rows as in an embedding lookup
+        w_npy = np.random.randn(100, 67).astype(np.float32)
+        idx_npy = np.random.randint(-100, 100, (5, 7)).astype(np.int32)
+        w_mlx = mx.array(w_npy)
+        for idx in [mx.array(idx_npy), mx.array(idx_npy.T).T]:
+            out = mx.take(w_mlx, idx, axis=0)
+            self.assertTrue(np.array_equal(np.take(w_npy, idx_npy, axis=0), out))
+        out = w_mlx.astype(mx.float16)[mx.array(idx_npy)]
+        expected = np.take(w_npy.astype(np.float16), idx_npy, axis=0)
+        self.assertTrue(np.array_equal(expected, out))
+
     def test_take_along_axis(self):
         a_np = np.arange(8).reshape(2, 2, 2)
         a_mlx = mx.array(a_np)
@@ -1055,6 +1088,47 @@ class TestOps(mlx_tests.MLXTestCase):
             out_mlx = mx.take_along_axis(a_mlx, mx.reshape(idx_mlx, shape), axis=ax)
             self.assertTrue(np.array_equal(out_np, np.array(out_mlx)))
 
+    def test_cache_append(self):
+        cache = mx.zeros((2, 3, 0, 4))
+        updates = []
+        for offset in range(6):
+            update = mx.random.normal((2, 3, 1, 4))
+            updates.append(update)
+            cache, view = mx.cache_append(cache, update, offset, axis=2, step=4)
+            self.assertEqual(cache.shape, (2, 3, 4 if offset < 4 else 8, 4))
+            self.assertEqual(view.shape, (2, 3, offset + 1, 4))
+            self.assertTrue(mx.array_equal(view, mx.concatenate(updates, axis=2)))
+
+        # Several entries at once, cast to the cache type
+        cache = mx.zeros((5, 2), mx.float16)
+        cache, view = mx.cache_append(cache, mx.ones((3, 2)), 0, axis=0)
+        cache, view = mx.cache_append(cache, mx.full((3, 2), 2), 3, axis=-2)
+        self.assertEqual(cache.dtype, mx.float16)
+        self.assertEqual(cache.shape, (256, 2))
+        expected = mx.array([1, 1, 1, 2, 2, 2], mx.float16)[:, None]
+        self.assertTrue(mx.array_equal(view, mx.broadcast_to(expected, (6, 2))))
+
+        # Roll back the last two entries and append in their place
+        cache, view = mx.cache_append(cache, mx.full((1, 2), 3), 4, axis=0)
+        self.assertEqual(cache.shape, (256, 2))
+        expected = mx.array([1, 1, 1, 2, 3], mx.float16)[:, None]
+        self.assertTrue(mx.array_equal(view, mx.broadcast_to(expected, (5, 2))))
+
+        # The cache is still valid if it is used elsewhere
+        cache = mx.zeros((4, 2))
+        mx.eval(cache)
+        new_cache, view = mx.cache_append(cache, mx.ones((1, 2)), 0, axis=0)
+        mx.eval(new_cache, view)
+        self.assertTrue(mx.array_equal(cache, mx.zeros((4, 2))))
+        self.assertTrue(mx.array_equal(view, mx.ones((1, 2))))
+
+        with self.assertRaises(ValueError):
+            mx.cache_append(cache, mx.ones((1, 3)), 0, axis=0)
+        with self.assertRaises(ValueError):
+            mx.cache_append(cache, mx.ones((1, 2)), 5, axis=0)
+        with self.assertRaises(ValueError):
+            mx.cache_append(cache, mx.ones((1, 2)), 0, axis=2)
+
     def test_split(self):
         a = mx.array([1, 2, 3])
         splits = mx.split(a, 3)
@@ -1515,6 +1589,18 @@ class TestOps(mlx_tests.MLXTestCase):
             out = mx.softmax(a, axis=-1, precise=True)
             self.assertTrue(mx.allclose(out_expect, out))
 
+        # Few long rows split across threadgroups
+        for shape in [(1, 151936), (3, 20000)]:
+            a_npy = np.random.randn(*shape).astype(np.float32)
+            b_npy = np_softmax(a_npy, -1)
+            b_mlx = mx.softmax(mx.array(a_npy), axis=-1)
+            self.assertTrue(np.allclose(b_npy, b_mlx, atol=1e-6, rtol=1e-4))
+        a = np.full(151936, -np.inf)
+        a[-1] = 0.0
+        a = mx.softmax(mx.array(a))
+        self.assertFalse(np.any(np.isnan(a)))
+        self.assertEqual(a[-1], 1)
+
     def test_concatenate(self):
         a_npy = np.random.randn(32, 32, 32)
         b_npy = np.random.randn(32, 32, 32)
@@ -1734,6 +1820,97 @@ class TestOps(mlx_tests.MLXTestCase):
             expected = mx.repeat(expected[:, None], 2, axis=1)
             self.assertTrue(mx.array_equal(expected, out))
 
+        # Few long rows split across threadgroups
+        for shape in [(151936,), (3, 40001)]:
+            a = mx.random.randint(-100, 100, shape)
+            a_npy = np.array(a)
+            for inclusive in [True, False]:
+                for reverse in [False, True]:
+                    x = a_npy[..., ::-1] if reverse else a_npy
+                    expected = np.cumsum(x, axis=-1)
+                    if not inclusive:
+                        expected = np.concatenate(
+                            [np.zeros_like(x[..., :1]), expected[..., :-1]], -1
+                        )
+                    if reverse:
+                        expected = expected[..., ::-1]
+                    out = mx.cumsum(a, axis=-1, inclusive=inclusive, reverse=reverse)
+                    self.assertTrue(np.array_equal(expected, out))
+
+            out = mx.cummax(a, axis=-1)
+            self.assertTrue(np.array_equal(np.maximum.accumulate(a_npy, -1), out))
+
+    def test_segment_ops(self):
+        lengths = [3, 0, 700, 1, 50]
+        offsets = np.cumsum([0] + lengths)
+        segments = list(zip(offsets[:-1], offsets[1:]))
+        for shape in [(sum(lengths),), (sum(lengths), 3), (sum(lengths), 40, 2)]:
+            a_npy = np.random.randn(*shape).astype(np.float32)
+            a_mlx = mx.array(a_npy)
+            offs = mx.array(offsets)
+            for op, npop, empty in [
+                ("segment_sum", np.sum, 0.0),
+                ("segment_mean", np.mean, 0.0),
+                ("segment_max", np.max, -np.inf),
+                ("segment_min", np.min, np.inf),
+            ]:
+                out = getattr(mx, op)(a_mlx, offs)
+                self.assertEqual(out.shape, (len(lengths), *shape[1:]))
+                for b, (start, stop) in enumerate(segments):
+                    if start == stop:
+                        expected = np.full(shape[1:], empty)
+                    else:
+                        expected = npop(a_npy[start:stop], axis=0)
+                    self.assertTrue(np.allclose(out[b], expected, atol=1e-4))
+
+            for reverse, inclusive in [(False, True), (True, False)]:
+                out = mx.segment_cumsum(
+                    a_mlx, offs, reverse=reverse, inclusive=inclusive
+                )
+                for start, stop in segments:
+                    seg = a_npy[start:stop]
+                    if reverse:
+                        seg = seg[::-1]
+                    expected = np.cumsum(seg, axis=0)
+                    if not inclusive:
+                        expected = expected - seg
+                    if reverse:
+                        expected = expected[::-1]
+                    self.assertTrue(np.allclose(out[start:stop], expected, atol=1e-3))
+
+        # Integer and half precision inputs
+        a = mx.random.randint(-10, 10, (754, 4))
+        offs = mx.array(offsets)
+        self.assertTrue(
+            mx.array_equal(mx.segment_max(a, offs)[2], a[3:703].max(axis=0))
+        )
+        out = mx.segment_sum(a.astype(mx.float16), offs)
+        self.assertEqual(out.dtype, mx.float16)
+        expected = a[3:703].sum(axis=0).astype(mx.float16)
+        self.assertTrue(mx.array_equal(out[2], expected))
+
+        # Gradients match the scatter based reduction
+        ids = mx.array(np.repeat(np.arange(len(lengths)), lengths))
+        a = mx.random.normal((754, 3))
+
+        def scatter_sum(a):
+            out = mx.zeros((len(lengths), 3)).at[ids].add(a)
+            return (out * out).sum()
+
+        def seg_sum(a):
+            out = mx.segment_sum(a, offs)
+            return (out * out).sum()
+
+        self.assertTrue(
+            mx.allclose(mx.grad(seg_sum)(a), mx.grad(scatter_sum)(a), atol=1e-4)
+        )
+        g = mx.grad(lambda a: mx.segment_cumsum(a, offs).sum())(a)
+        expected = mx.segment_cumsum(mx.ones_like(a), offs, reverse=True)
+        self.assertTrue(mx.allclose(g, expected))
+
+        with self.assertRaises(ValueError):
+            mx.segment_sum(mx.array(1.0), offs)
+
     def test_squeeze_expand(self):
         a = mx.zeros((2, 1, 2, 1))
         self.assertEqual(mx.squeeze(a).shape, (2, 2))
@@ -1806,6 +1983,24 @@ class TestOps(mlx_tests.MLXTestCase):
         self.assertTrue(np.array_equal(b_np, b_mx))
         self.assertEqual(b_mx.dtype, a_mx.dtype)
 
+        # Test radix sort on long rows
+        for dtype in ("float32", "float16", "int32", "int8"):
+            for axis in (0, 1):
+                with self.subTest(dtype=dtype, axis=axis):
+                    shape = (2**18 + 3, 2) if axis == 0 else (2, 2**18 + 3)
+                    a_np = np.random.normal(scale=50, size=shape)
+                    a_np = a_np.astype(getattr(np, dtype))
+                    a_mx = mx.array(a_np)
+
+                    b_np = np.sort(a_np, axis=axis)
+                    b_mx = mx.sort(a_mx, axis=axis)
+                    self.assertTrue(np.array_equal(b_np, b_mx))
+
+                    # The radix sort is stable
+                    c_np = np.argsort(a_np, axis=axis, kind="stable")
+                    c_mx = mx.argsort(a_mx, axis=axis)
+                    self.assertTrue(np.array_equal(c_np, c_mx))
+
     def test_partition(self):
         shape = (3, 4, 5)
         for dtype in ("int32", "float32"):
@@ -1837,6 +2032,36 @@ class TestOps(mlx_tests.MLXTestCase):
                             M = top_k_mx.shape[axis or 0]
                             self.assertEqual(M, (kth + N) % N)
 
+    def test_partition_long_rows(self):
+        # Rows longer than a single sort block
+        def check_partition(a_np, b_np, kth, axis):
+            c_np = np.take(np.partition(a_np, kth, axis=axis), (kth,), axis=axis)
+            c = np.take(b_np, (kth,), axis=axis)
+            self.assertTrue(np.array_equal(c, c_np))
+            self.assertTrue(np.all(np.take(b_np, range(kth), axis) <= c))
+            rest = np.take(b_np, range(kth, b_np.shape[axis]), axis)
+            self.assertTrue(np.all(rest >= c))
+            self.assertTrue(np.array_equal(np.sort(b_np, axis), np.sort(a_np, axis)))
+
+        np.random.seed(0)
+        for dtype in ("float32", "float16", "int32", "uint8"):
+            for axis in (0, 1):
+                with self.subTest(dtype=dtype, axis=axis):
+                    shape = (5000, 3) if axis == 0 else (3, 50000)
+                    a_np = np.random.uniform(-100, 100, size=shape)
+                    if dtype == "uint8":
+                        a_np = np.abs(a_np)
+                    a_np = a_np.astype(getattr(np, dtype))
+                    a_mx = mx.array(a_np)
+                    kth = a_np.shape[axis] - 20
+
+                    b_mx = mx.partition(a_mx, kth, axis=axis)
+                    check_partition(a_np, np.array(b_mx), kth, axis)
+
+                    idx = mx.argpartition(a_mx, kth, axis=axis)
+                    b_np = np.take_along_axis(a_np, np.array(idx), axis)
+                    check_partition(a_np, b_np, kth, axis)
+
     @unittest.skipIf(
         os.getenv("LOW_MEMORY", None) is not None,
         "This test requires a lot of memory",
@@ -2377,6 +2602,56 @@ class TestOps(mlx_tests.MLXTestCase):
             a_out = out.view(mx.int32)
             self.assertTrue(mx.array_equal(a_out, a, equal_nan=True))
 
+    def test_hadamard_transform(self):
+        def hadamard(n):
+            h = np.ones((1, 1), np.float32)
+            while h.shape[0] < n:
+                h = np.block([[h, h], [h, -h]])
+            return h
+
+        rng = np.random.default_rng(0)
+        for n in [1, 2, 8, 64, 256, 1024, 8192, 2**14]:
+            x = rng.standard_normal((3, n)).astype(np.float32)
+            expected = x @ hadamard(n) / math.sqrt(n)
+            out = mx.hadamard_transform(mx.array(x))
+            self.assertTrue(np.allclose(out, expected, rtol=1e-4, atol=1e-3))
+
+        # Scale, batching, non-contiguous and integer inputs
+        x = rng.standard_normal((16, 4, 32)).astype(np.float32)
+        expected = x @ hadamard(32) * 0.5
+        out = mx.hadamard_transform(mx.array(x), scale=0.5)
+        self.assertTrue(np.allclose(out, expected, rtol=1e-4, atol=1e-4))
+        xt = mx.array(x).swapaxes(0, 2)
+        out = mx.hadamard_transform(xt.swapaxes(0, 2), scale=0.5)
+        self.assertTrue(np.allclose(out, expected, rtol=1e-4, atol=1e-4))
+        out = mx.hadamard_transform(mx.arange(8), scale=1.0)
+        self.assertEqual(out.dtype, mx.float32)
+        self.assertEqual(out.tolist(), (np.arange(8) @ hadamard(8)).tolist())
+
+        for dtype in [mx.float16, mx.bfloat16]:
+            out = mx.hadamard_transform(mx.array(x).astype(dtype))
+            self.assertEqual(out.dtype, dtype)
+            expected = x @ hadamard(32) / math.sqrt(32)
+            self.assertTrue(np.allclose(out.astype(mx.float32), expected, atol=5e-2))
+
+        # The orthonormal transform is its own inverse and its own vjp
+        y = mx.array(x)
+        self.assertTrue(
+            mx.allclose(mx.hadamard_transform(mx.hadamard_transform(y)), y, atol=1e-5)
+        )
+        cotan = mx.random.normal(y.shape)
+        _, vjps = mx.vjp(lambda x: mx.hadamard_transform(x, 2.0), [y], [cotan])
+        expected = mx.hadamard_transform(cotan, 2.0)
+        self.assertTrue(mx.allclose(vjps[0], expected, atol=1e-4))
+        out = mx.vmap(mx.hadamard_transform, in_axes=2)(y.swapaxes(1, 2))
+        expected = mx.hadamard_transform(y)
+        self.assertTrue(mx.allclose(out, expected.swapaxes(0, 1), atol=1e-5))
+
+        with self.assertRaises(ValueError):
+            mx.hadamard_transform(mx.ones((4, 12)))
+        with self.assertRaises(ValueError):
+            mx.hadamard_transform(mx.array(1.0))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -204,6 +204,33 @@ class TestOptimizers(mlx_tests.MLXTestCase):
             )
         )
 
+    def test_fused_updates(self):
+        params = {
+            "first": [mx.random.normal((10,)), mx.random.normal((3, 4))],
+            "second": mx.random.normal((1,)),
+        }
+        grads = tree_map(lambda x: mx.random.normal(x.shape), params)
+
+        # The fused updates match the updates of each parameter
+        for optim_class in [opt.Adam, opt.AdamW, opt.Lion]:
+            fused = optim_class(learning_rate=1e-2)
+            single = optim_class(learning_rate=1e-2)
+            single.apply_multi = partial(opt.Optimizer.apply_multi, single)
+            p_fused = p_single = params
+            for _ in range(3):
+                p_fused = fused.apply_gradients(grads, p_fused)
+                p_single = single.apply_gradients(grads, p_single)
+            self.assertTrue(
+                tree_equal(lambda x, y: mx.allclose(x, y, atol=1e-5), p_fused, p_single)
+            )
+            self.assertTrue(
+                tree_equal(
+                    lambda x, y: mx.allclose(x, y, atol=1e-5),
+                    fused.state["first"],
+                    single.state["first"],
+                )
+            )
+
     def test_adafactor(self):
         x = mx.zeros((5, 5))
         grad = mx.ones_like(x)
@@ -11,27 +11,94 @@ class TestQuantized(mlx_tests.MLXTestCase):
     def test_quantize_dequantize(self):
         w = mx.random.normal(shape=(128, 512))
         for gs in [32, 64, 128]:
-            for b in [2, 4, 8]:
+            for b in [2, 3, 4, 6, 8]:
                 w_q, scales, biases = mx.quantize(w, gs, b)
                 w_hat = mx.dequantize(w_q, scales, biases, gs, b)
                 errors = (w - w_hat).abs().reshape(*scales.shape, -1)
                 eps = 1e-6
                 self.assertTrue((errors <= (scales[..., None] + eps).abs()).all())
 
+        # 3 and 6 bit elements are packed in 3 bytes from the lower to upper
+        # bits like the other widths
+        w = mx.broadcast_to(mx.arange(8, dtype=mx.float32), (32, 8))
+        w_q, scales, biases = mx.quantize(w.reshape(1, 256), 32, 3)
+        self.assertEqual(w_q.shape, (1, 24))
+        self.assertTrue(mx.all(scales == -1))
+        self.assertEqual(w_q[0, :3].tolist(), [0x77053977, 0x39770539, 0x05397705])
+
         # test quantize/dequantize 0s
         a = mx.zeros((256, 512))
         for gs in [32, 64, 128]:
-            for b in [2, 4, 8]:
+            for b in [2, 3, 4, 6, 8]:
                 w_q, scales, biases = mx.quantize(a, gs, b)
                 a_hat = mx.dequantize(w_q, scales, biases, gs, b)
                 self.assertTrue(mx.all(a_hat == 0))
 
+    def test_quantize_streams(self):
+        # The quantization kernels of the CPU and the default device agree up
+        # to the rounding of values halfway between two quantized values
+        w = mx.random.normal(shape=(64, 512))
+        for dtype in [mx.float32, mx.float16, mx.bfloat16]:
+            w_t = w.astype(dtype)
+            for gs in [32, 64, 128]:
+                for b in [2, 3, 4, 6, 8]:
+                    w_q, scales, biases = mx.quantize(w_t, gs, b)
+                    self.assertEqual(scales.dtype, dtype)
+                    w_hat = mx.dequantize(w_q, scales, biases, gs, b)
+                    self.assertEqual(w_hat.dtype, dtype)
+
+                    w_q_cpu, scales_cpu, biases_cpu = mx.quantize(
+                        w_t, gs, b, stream=mx.cpu
+                    )
+                    self.assertTrue(mx.allclose(scales, scales_cpu))
+                    self.assertTrue(mx.allclose(biases, biases_cpu))
+                    w_hat_cpu = mx.dequantize(
+                        w_q_cpu, scales_cpu, biases_cpu, gs, b, stream=mx.cpu
+                    )
+                    errors = (w_hat - w_hat_cpu).abs().reshape(*scales.shape, -1)
+                    bound = scales[..., None].abs().astype(mx.float32) * 1.01
+                    self.assertTrue((errors <= bound).all())
+
+        # Non contiguous inputs
+        w_t = mx.random.normal(shape=(512, 64)).T
+        w_q, scales, biases = mx.quantize(w_t, 64, 4)
+        expected = mx.quantize(w_t.reshape(-1).reshape(64, 512), 64, 4)
+        for a, b in zip((w_q, scales, biases), expected):
+            self.assertTrue(mx.array_equal(a, b))
+
+    def test_dequantize_transforms(self):
+        w = mx.random.normal(shape=(3, 32, 256))
+        w_q, scales, biases = mx.quantize(w, 64, 4)
+
+        # vmap over a leading and a quantized axis
+        w_hat = mx.vmap(lambda s, b: mx.dequantize(w_q[0], s, b, 64, 4))(scales, biases)
+        self.assertEqual(w_hat.shape, (3, 32, 256))
+        for i in range(3):
+            expected = mx.dequantize(w_q[0], scales[i], biases[i], 64, 4)
+            self.assertTrue(mx.allclose(w_hat[i], expected))
+        out = mx.vmap(lambda x: mx.quantize(x, 64, 4), in_axes=1)(w)
+        expected = mx.quantize(w.swapaxes(0, 1), 64, 4)
+        for a, b in zip(out, expected):
+            self.assertTrue(mx.array_equal(a, b))
+
+        # Gradients with respect to the scales and biases
+        def loss(s, b):
+            return (mx.dequantize(w_q, s, b, 64, 4) * w).sum()
+
+        d_scales, d_biases = mx.grad(loss, argnums=(0, 1))(scales, biases)
+        q = mx.dequantize(w_q, mx.ones_like(scales), mx.zeros_like(biases), 64, 4)
+        groups = (*scales.shape, 64)
+        expected = (q * w).reshape(groups).sum(-1)
+        self.assertTrue(mx.allclose(d_scales, expected, atol=1e-4))
+        expected = w.reshape(groups).sum(-1)
+        self.assertTrue(mx.allclose(d_biases, expected, atol=1e-4))
+
     def test_qmm(self):
         key = mx.random.key(0)
         k1, k2 = mx.random.split(key)
         tests = product(
             [128, 64, 32],  # group_size
-            [2, 4, 8],  # bits
+            [2, 3, 4, 6, 8],  # bits
             [8, 32, 33, 64],  # M
             [512, 1024],  # N
             [512, 1024],  # K
@@ -115,7 +182,7 @@ class TestQuantized(mlx_tests.MLXTestCase):
         k1, k2 = mx.random.split(key)
         tests = product(
             [128, 64, 32],  # group_size
-            [2, 4, 8],  # bits
+            [2, 3, 4, 6, 8],  # bits
             [512, 1024],  # M
             [512, 1024],  # N
         )
@@ -137,7 +204,7 @@ class TestQuantized(mlx_tests.MLXTestCase):
         k1, k2 = mx.random.split(key)
         tests = product(
             [128, 64, 32],  # group_size
-            [2, 4, 8],  # bits
+            [2, 3, 4, 6, 8],  # bits
             [512, 1024],  # M
             [512, 1024],  # N
         )
@@ -390,6 +457,39 @@ class TestQuantized(mlx_tests.MLXTestCase):
             test_shape(32, 512, 32, transpose=False, **kwargs)
             test_shape(1, 512, 32, transpose=False, **kwargs)
 
+    def test_gather_qmm_sorted(self):
+        def quantize(w, transpose=True, group_size=64, bits=4):
+            qw, s, b = mx.quantize(w, group_size=group_size, bits=bits)
+            w_hat = mx.dequantize(qw, s, b, group_size=group_size, bits=bits)
+            if transpose:
+                w_hat = w_hat.swapaxes(-1, -2)
+            return w_hat, qw, s, b
+
+        # Tokens routed to experts and grouped by expert like in a MoE layer
+        for L, E, N, K, transpose in (
+            (64, 4, 96, 128, True),
+            (32, 8, 128, 64, False),
+            (7, 3, 64, 64, True),
+        ):
+            with self.subTest(L=L, E=E, N=N, K=K, transpose=transpose):
+                x = mx.random.normal((L, 1, K))
+                w = mx.random.normal((E, N, K) if transpose else (E, K, N))
+                w_hat, qw, s, b = quantize(w, transpose)
+                indices = mx.sort(mx.random.randint(0, E, shape=(L,)))
+
+                c1 = mx.gather_mm(x, w_hat, rhs_indices=indices)
+                c2 = mx.gather_qmm(
+                    x,
+                    qw,
+                    s,
+                    b,
+                    rhs_indices=indices,
+                    transpose=transpose,
+                    sorted_indices=True,
+                )
+                self.assertEqual(c2.shape, (L, 1, N))
+                self.assertTrue(mx.allclose(c1, c2, atol=1e-4))
+
     def test_gather_matmul_grad(self):
         def quantize(w, transpose=True, group_size=64, bits=4):
             qw, s, b = mx.quantize(w, group_size=group_size, bits=bits)
@@ -419,6 +519,66 @@ class TestQuantized(mlx_tests.MLXTestCase):
         g2 = mx.grad(f_test)(x, qw, s, b, lhs_indices, rhs_indices)
         self.assertTrue(mx.allclose(g1, g2, atol=1e-4))
 
+    def test_fp8(self):
+        codes = mx.arange(256).astype(mx.uint8)
+        for fmt in ["e4m3", "e5m2"]:
+            with self.subTest(format=fmt):
+                # Every code except the NaNs survives a round trip
+                x = mx.from_fp8(codes, fmt, dtype=mx.float32)
+                keep = mx.logical_not(mx.isnan(x))
+                y = mx.to_fp8(x, fmt)
+                self.assertTrue(mx.all(mx.where(keep, y == codes, True)).item())
+
+                # Rounding to the nearest value
+                x = mx.random.normal((1000,)) * 10
+                y = mx.from_fp8(mx.to_fp8(x, fmt), fmt, dtype=mx.float32)
+                rel = 2.0 ** (-4 if fmt == "e4m3" else -3)
+                err = mx.abs(y - x) <= rel * mx.abs(x) + 1e-3
+                self.assertTrue(mx.all(err).item())
+
+        x = mx.array([1.0, -2.5, 1.0625, 1000.0, 2.0**-9])
+        self.assertEqual(mx.to_fp8(x).tolist(), [0x38, 0xC2, 0x38, 0x7E, 0x01])
+        self.assertEqual(mx.to_fp8(x, "e5m2").tolist(), [0x3C, 0xC1, 0x3C, 0x64, 0x18])
+        self.assertTrue(mx.isnan(mx.from_fp8(mx.array([0x7F], mx.uint8))).item())
+
+        with self.assertRaises(ValueError):
+            mx.to_fp8(x, "e3m4")
+        with self.assertRaises(ValueError):
+            mx.from_fp8(x)
+
+    def test_fp8_matmul(self):
+        # The gemv for few rows and the gemm with a partial last tile of K
+        for M, N, K in [(1, 64, 32), (4, 70, 100), (40, 96, 64), (130, 50, 77)]:
+            for fmt in ["e4m3", "e5m2"]:
+                for dtype in [mx.float32, mx.float16, mx.bfloat16]:
+                    with self.subTest(shape=(M, N, K), format=fmt, dtype=dtype):
+                        w = mx.to_fp8(mx.random.normal((N, K)) / 8, fmt)
+                        x = mx.random.normal((M, K)).astype(dtype)
+                        out = mx.fp8_matmul(x, w, fmt)
+                        ref = x @ mx.from_fp8(w, fmt, dtype=dtype).T
+                        self.assertEqual(out.dtype, dtype)
+                        self.assertEqual(out.shape, (M, N))
+                        tol = 1e-4 if dtype == mx.float32 else 5e-2
+                        self.assertTrue(mx.allclose(out, ref, atol=tol, rtol=tol))
+
+        # Leading dimensions and the gradient with respect to x
+        w = mx.to_fp8(mx.random.normal((32, 48)) / 8)
+        x = mx.random.normal((2, 3, 48))
+        w_ref = mx.from_fp8(w, dtype=mx.float32)
+        out = mx.fp8_matmul(x, w)
+        self.assertEqual(out.shape, (2, 3, 32))
+        self.assertTrue(mx.allclose(out, x @ w_ref.T, atol=1e-4))
+        g = mx.grad(lambda x: mx.fp8_matmul(x, w).sum())(x)
+        g_ref = mx.grad(lambda x: (x @ w_ref.T).sum())(x)
+        self.assertTrue(mx.allclose(g, g_ref, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.fp8_matmul(x, w.astype(mx.float32))
+        with self.assertRaises(ValueError):
+            mx.fp8_matmul(x[..., :40], w)
+        with self.assertRaises(ValueError):
+            mx.fp8_matmul(x, w, "e3m4")
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,128 @@
+# Copyright © 2024 Apple Inc.
+
+import math
+import unittest
+
+import mlx.core as mx
+import mlx_tests
+import numpy as np
+
+
+def attention_ref(q, k, v, scale, causal):
+    # q: (L, H, D), k and v: (S, Hkv, D)
+    n_rep = q.shape[1] // k.shape[1]
+    k = np.repeat(k, n_rep, axis=1)
+    v = np.repeat(v, n_rep, axis=1)
+    scores = np.einsum("lhd,shd->hls", q, k) * scale
+    if causal:
+        L, S = q.shape[0], k.shape[0]
+        mask = np.arange(S)[None] <= np.arange(L)[:, None] + S - L
+        scores = np.where(mask, scores, -np.inf)
+    scores = scores - scores.max(axis=-1, keepdims=True)
+    p = np.exp(scores)
+    p = p / p.sum(axis=-1, keepdims=True)
+    return np.einsum("hls,shd->lhd", p, v)
+
+
+class TestRagged(mlx_tests.MLXTestCase):
+    def test_conversions(self):
+        seqs = [np.random.randn(n, 3).astype(np.float32) for n in [4, 1, 0, 2]]
+        x = mx.ragged.from_sequences([mx.array(s) for s in seqs])
+        self.assertEqual(x.values.shape, (7, 3))
+        self.assertEqual(x.offsets.tolist(), [0, 4, 5, 5, 7])
+        ids = mx.ragged.segment_ids(x.offsets, 7)
+        self.assertEqual(ids.tolist(), [0, 0, 0, 0, 1, 3, 3])
+
+        padded = x.to_padded(4, pad_value=-1.0)
+        self.assertEqual(padded.shape, (4, 4, 3))
+        for b, s in enumerate(seqs):
+            self.assertTrue(np.array_equal(padded[b, : len(s)], s))
+            self.assertTrue(np.all(np.array(padded[b, len(s) :]) == -1.0))
+
+        y = mx.ragged.from_padded(padded, [len(s) for s in seqs])
+        self.assertTrue(mx.array_equal(y.values, x.values))
+        self.assertTrue(mx.array_equal(y.offsets, x.offsets))
+
+    def test_segment_ops(self):
+        lengths = [3, 0, 5, 1]
+        values = np.random.randn(sum(lengths), 4).astype(np.float32)
+        offsets = np.cumsum([0] + lengths)
+        x = mx.ragged.RaggedArray(mx.array(values), mx.array(offsets))
+        sums = mx.ragged.segment_sum(x)
+        maxes = mx.ragged.segment_max(x)
+        probs = mx.ragged.softmax(x).values
+        for b, (start, stop) in enumerate(zip(offsets[:-1], offsets[1:])):
+            seg = values[start:stop]
+            self.assertTrue(np.allclose(sums[b], seg.sum(axis=0), atol=1e-5))
+            if stop == start:
+                continue
+            self.assertTrue(np.allclose(maxes[b], seg.max(axis=0)))
+            e = np.exp(seg - seg.max(axis=0))
+            self.assertTrue(
+                np.allclose(probs[start:stop], e / e.sum(axis=0), atol=1e-5)
+            )
+
+        # Gradients through the segment reductions
+        def fn(v):
+            return mx.ragged.segment_sum(mx.ragged.RaggedArray(v, x.offsets)).sum()
+
+        g = mx.grad(fn)(x.values)
+        self.assertTrue(mx.array_equal(g, mx.ones_like(x.values)))
+
+        weight = mx.random.uniform(shape=(4,))
+        out = mx.ragged.rms_norm(x, weight, 1e-5)
+        self.assertTrue(
+            mx.allclose(out.values, mx.fast.rms_norm(x.values, weight, 1e-5))
+        )
+
+    def test_attention(self):
+        for D, causal, n_kv_heads in [
+            (64, False, 4),
+            (64, True, 2),
+            (128, True, 4),
+            (16, False, 1),
+        ]:
+            q_lengths = [5, 1, 12]
+            k_lengths = [5, 3, 12] if causal else [7, 3, 9]
+            H = 4
+            scale = 1.0 / math.sqrt(D)
+            q = np.random.randn(sum(q_lengths), H, D).astype(np.float32)
+            k = np.random.randn(sum(k_lengths), n_kv_heads, D).astype(np.float32)
+            v = np.random.randn(sum(k_lengths), n_kv_heads, D).astype(np.float32)
+            q_offsets = np.cumsum([0] + q_lengths)
+            k_offsets = np.cumsum([0] + k_lengths)
+            rq = mx.ragged.RaggedArray(mx.array(q), mx.array(q_offsets))
+            rk = mx.ragged.RaggedArray(mx.array(k), mx.array(k_offsets))
+            rv = mx.ragged.RaggedArray(mx.array(v), mx.array(k_offsets))
+            out = mx.ragged.scaled_dot_product_attention(
+                rq, rk, rv, scale=scale, causal=causal
+            )
+            self.assertEqual(out.values.shape, q.shape)
+            for b in range(len(q_lengths)):
+                qs = slice(q_offsets[b], q_offsets[b + 1])
+                ks = slice(k_offsets[b], k_offsets[b + 1])
+                expected = attention_ref(q[qs], k[ks], v[ks], scale, causal)
+                self.assertTrue(
+                    np.allclose(out.values[qs], expected, atol=1e-4, rtol=1e-4)
+                )
+
+        # The gradients come from the masked dense attention
+        def fn(q):
+            rq = mx.ragged.RaggedArray(q, mx.array([0, 2, 5]))
+            return mx.ragged.scaled_dot_product_attention(
+                rq, rq, rq, scale=0.5
+            ).values.sum()
+
+        q = mx.random.normal((5, 2, 64))
+        g = mx.grad(fn)(q)
+        self.assertEqual(g.shape, q.shape)
+        self.assertFalse(mx.isnan(g).any().item())
+
+        with self.assertRaises(ValueError):
+            rq = mx.ragged.RaggedArray(mx.zeros((4, 3, 8)), mx.array([0, 4]))
+            rk = mx.ragged.RaggedArray(mx.zeros((4, 2, 8)), mx.array([0, 4]))
+            mx.ragged.scaled_dot_product_attention(rq, rk, rk, scale=1.0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -250,6 +250,43 @@ class TestRandom(mlx_tests.MLXTestCase):
         with self.assertRaises(ValueError):
             mx.random.bernoulli(0, [2])  # Bad type
 
+    def test_dropout(self):
+        key = mx.random.key(0)
+        x = mx.random.normal((1000, 301))
+        p = 0.3
+        y = mx.random.dropout(x, p, key=key)
+        self.assertEqual(y.shape, x.shape)
+        self.assertEqual(y.dtype, x.dtype)
+
+        kept = y != 0
+        self.assertTrue(mx.allclose(y, mx.where(kept, x / (1 - p), 0)))
+        self.assertLess(abs(kept.astype(mx.float32).mean().item() - 0.7), 0.01)
+
+        # The mask only depends on the key
+        z = mx.random.dropout(mx.ones_like(x), p, key=key)
+        self.assertTrue(mx.array_equal(kept, z != 0))
+
+        # The gradient draws the same mask
+        g = mx.grad(lambda x: mx.random.dropout(x, p, key=key).sum())(x)
+        self.assertTrue(mx.allclose(g, z))
+
+        # Strided inputs are masked by position
+        xt = x.T
+        y = mx.random.dropout(xt, p, key=key)
+        z = mx.random.dropout(mx.flatten(xt), p, key=key)
+        self.assertTrue(mx.array_equal(y, z.reshape(xt.shape)))
+
+        for t in [mx.float16, mx.bfloat16]:
+            y = mx.random.dropout(x.astype(t), p, key=key)
+            self.assertEqual(y.dtype, t)
+            self.assertTrue(mx.array_equal(y != 0, kept))
+
+        self.assertTrue(mx.array_equal(mx.random.dropout(x, 0.0), x))
+        with self.assertRaises(ValueError):
+            mx.random.dropout(x, 1.0)
+        with self.assertRaises(ValueError):
+            mx.random.dropout(mx.array([1, 2]), 0.5)
+
     def test_truncated_normal(self):
         a = mx.random.truncated_normal(-2.0, 2.0)
         self.assertEqual(a.size, 1)
@@ -47,6 +47,22 @@ class TestReduce(mlx_tests.MLXTestCase):
                                     np.allclose(z_npy, np.array(z_mlx), atol=1e-4)
                                 )
 
+    def test_large_strided_sums(self):
+        # Many outputs each reducing few strided elements are reduced in place
+        x_npy = np.random.randn(64, 16, 8, 32).astype(np.float32)
+        x_mlx = mx.array(x_npy)
+        for t, a in [((2, 0, 3, 1), (3,)), ((1, 3, 0, 2), (1, 3))]:
+            with self.subTest(t=t, a=a):
+                z_npy = np.sum(np.transpose(x_npy, t), axis=a)
+                z_mlx = mx.sum(mx.transpose(x_mlx, t), axis=a)
+                self.assertTrue(np.allclose(z_npy, z_mlx, atol=1e-4))
+
+        y_npy = np.broadcast_to(x_npy[:, :1], x_npy.shape)
+        y_mlx = mx.broadcast_to(x_mlx[:, :1], x_mlx.shape)
+        z_npy = np.max(y_npy, axis=1)
+        z_mlx = mx.max(y_mlx, axis=1)
+        self.assertTrue(np.array_equal(z_npy, z_mlx))
+
     def test_dtypes(self):
         int_dtypes = [
             "int8",
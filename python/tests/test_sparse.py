@@ -0,0 +1,153 @@
+# Copyright © 2024 Apple Inc.
+
+import unittest
+
+import mlx.core as mx
+import mlx_tests
+import numpy as np
+
+
+def random_coo(shape, nnz, seed=0):
+    rng = np.random.default_rng(seed)
+    flat = rng.choice(shape[0] * shape[1], size=nnz, replace=False)
+    rows, cols = np.divmod(flat, shape[1])
+    values = rng.standard_normal(nnz).astype(np.float32)
+    dense = np.zeros(shape, np.float32)
+    dense[rows, cols] = values
+    coo = mx.sparse.COO(mx.array(rows), mx.array(cols), mx.array(values), shape)
+    return coo, dense
+
+
+class TestSparse(mlx_tests.MLXTestCase):
+    def test_conversions(self):
+        coo, dense = random_coo((7, 5), 12)
+        self.assertEqual(coo.shape, (7, 5))
+        self.assertTrue(np.allclose(coo.to_dense(), dense))
+
+        csr = coo.to_csr()
+        counts = (dense != 0).sum(axis=1)
+        self.assertEqual(csr.indptr.tolist(), [0] + np.cumsum(counts).tolist())
+        self.assertTrue(np.allclose(csr.to_dense(), dense))
+        self.assertTrue(np.allclose(csr.to_coo().to_dense(), dense))
+
+    def test_products(self):
+        for dtype, tol in [(mx.float32, 1e-5), (mx.float16, 1e-2)]:
+            coo, dense = random_coo((9, 6), 20)
+            b = np.random.randn(6, 4).astype(np.float32)
+            x = np.random.randn(6).astype(np.float32)
+            coo.values = coo.values.astype(dtype)
+            for a in [coo, coo.to_csr()]:
+                out = mx.sparse.spmm(a, mx.array(b).astype(dtype))
+                self.assertEqual(out.dtype, dtype)
+                self.assertTrue(np.allclose(out, dense @ b, rtol=tol, atol=tol))
+                out = mx.sparse.spmv(a, mx.array(x).astype(dtype))
+                self.assertTrue(np.allclose(out, dense @ x, rtol=tol, atol=tol))
+
+        coo, dense = random_coo((9, 6), 20)
+        p = np.random.randn(9, 8).astype(np.float32)
+        q = np.random.randn(8, 6).astype(np.float32)
+        for mask in [coo, coo.to_csr()]:
+            out = mx.sparse.sddmm(mask, mx.array(p), mx.array(q))
+            self.assertEqual(type(out), type(mask))
+            self.assertTrue(
+                np.allclose(out.to_dense(), (p @ q) * dense, rtol=1e-4, atol=1e-4)
+            )
+
+    def test_gradients(self):
+        coo, _ = random_coo((9, 6), 20)
+        b = mx.random.normal((6, 4))
+
+        def sparse_loss(values, b):
+            a = mx.sparse.COO(coo.rows, coo.cols, values, coo.shape)
+            return mx.sparse.spmm(a, b).square().sum()
+
+        def dense_loss(values, b):
+            a = mx.sparse.COO(coo.rows, coo.cols, values, coo.shape)
+            return (a.to_dense() @ b).square().sum()
+
+        expected = mx.grad(dense_loss, argnums=(0, 1))(coo.values, b)
+        grads = mx.grad(sparse_loss, argnums=(0, 1))(coo.values, b)
+        for g, e in zip(grads, expected):
+            self.assertTrue(mx.allclose(g, e, rtol=1e-4, atol=1e-4))
+
+        p = mx.random.normal((9, 8))
+        q = mx.random.normal((8, 6))
+
+        def sampled_loss(p, q):
+            return mx.sparse.sddmm(coo, p, q).values.square().sum()
+
+        def masked_loss(p, q):
+            return ((p @ q) * coo.to_dense()).square().sum()
+
+        expected = mx.grad(masked_loss, argnums=(0, 1))(p, q)
+        grads = mx.grad(sampled_loss, argnums=(0, 1))(p, q)
+        for g, e in zip(grads, expected):
+            self.assertTrue(mx.allclose(g, e, rtol=1e-4, atol=1e-4))
+
+    def test_2_4_matmul(self):
+        rng = np.random.default_rng(0)
+        w = rng.standard_normal((48, 96)).astype(np.float32)
+        values, metadata = mx.prune_2_4(mx.array(w))
+        self.assertEqual(values.shape, (48, 48))
+        self.assertEqual(metadata.shape, (48, 3))
+        self.assertEqual(metadata.dtype, mx.uint32)
+
+        # Rebuild the pruned weights from the format
+        meta = np.array(metadata)
+        groups = np.arange(24)
+        nibbles = (meta[:, groups // 8] >> (4 * (groups % 8))) & 15
+        cols = 4 * groups + np.stack([nibbles & 3, nibbles >> 2], axis=-1)
+        pruned = np.zeros_like(w)
+        np.put_along_axis(pruned, cols.reshape(48, 48), np.array(values), axis=1)
+        top = np.sort(np.abs(w).reshape(48, 24, 4), axis=-1)[..., 2:]
+        kept = np.sort(np.abs(pruned).reshape(48, 24, 4), axis=-1)[..., 2:]
+        self.assertTrue(np.array_equal(top, kept))
+
+        # Both the gemv and the gemm paths
+        for m in [1, 3, 8, 9, 70]:
+            x = rng.standard_normal((m, 96)).astype(np.float32)
+            out = mx.sparse_2_4_matmul(mx.array(x), values, metadata)
+            self.assertTrue(np.allclose(out, x @ pruned.T, rtol=1e-4, atol=1e-4))
+
+        x = mx.random.normal((2, 5, 96))
+        out = mx.sparse_2_4_matmul(x, values, metadata)
+        self.assertEqual(out.shape, (2, 5, 48))
+        for dtype in [mx.float16, mx.bfloat16]:
+            out_low = mx.sparse_2_4_matmul(
+                x.astype(dtype), values.astype(dtype), metadata
+            )
+            self.assertEqual(out_low.dtype, dtype)
+            self.assertTrue(mx.allclose(out_low, out, rtol=1e-1, atol=1e-1))
+
+        def loss(x, values):
+            return mx.sparse_2_4_matmul(x, values, metadata).square().sum()
+
+        def dense_loss(x, w):
+            return (x @ w.T).square().sum()
+
+        x = mx.random.normal((6, 96))
+        gx, gv = mx.grad(loss, argnums=(0, 1))(x, values)
+        ex, ew = mx.grad(dense_loss, argnums=(0, 1))(x, mx.array(pruned))
+        self.assertTrue(mx.allclose(gx, ex, rtol=1e-4, atol=1e-4))
+        ew = np.take_along_axis(np.array(ew), cols.reshape(48, 48), axis=1)
+        self.assertTrue(np.allclose(gv, ew, rtol=1e-4, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.prune_2_4(mx.ones((4, 16)))
+        with self.assertRaises(ValueError):
+            mx.sparse_2_4_matmul(mx.ones((2, 32)), values, metadata)
+
+    def test_errors(self):
+        coo, _ = random_coo((4, 3), 5)
+        with self.assertRaises(ValueError):
+            mx.sparse.spmm(coo, mx.ones((4, 2)))
+        with self.assertRaises(ValueError):
+            mx.sparse.spmv(coo, mx.ones((3, 1)))
+        with self.assertRaises(ValueError):
+            mx.sparse.COO(
+                mx.array([0, 1]), mx.array([0]), mx.array([1.0, 2.0]), (2, 2)
+            ).to_dense()
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -370,6 +370,87 @@ class TestVmap(mlx_tests.MLXTestCase):
                 mx.allclose(a[:, i, :] @ invs[i], mx.eye(a.shape[0]), rtol=0, atol=1e-5)
             )
 
+    def check_vmap(self, fn, in_axes, *args, atol=1e-5):
+        out = mx.vmap(fn, in_axes=in_axes)(*args)
+        n = next(a.shape[ax] for a, ax in zip(args, in_axes) if ax is not None)
+        expected = []
+        for i in range(n):
+            sliced = [
+                a if ax is None else mx.moveaxis(a, ax, 0)[i]
+                for a, ax in zip(args, in_axes)
+            ]
+            expected.append(fn(*sliced))
+        self.assertTrue(mx.allclose(out, mx.stack(expected), atol=atol))
+
+    def test_vmap_conv(self):
+        x = mx.random.uniform(shape=(3, 2, 8, 4))
+        w = mx.random.uniform(shape=(3, 6, 3, 4))
+        conv = lambda x, w: mx.conv1d(x, w, padding=1)
+        self.check_vmap(conv, (0, None), x, w[0])
+        self.check_vmap(conv, (None, 0), x[0], w)
+        self.check_vmap(conv, (0, 0), x, w)
+
+        grouped = lambda x, w: mx.conv1d(x, w, groups=2)
+        self.check_vmap(grouped, (None, 0), x[0], w[..., :2])
+        self.check_vmap(grouped, (0, 0), x, w[..., :2])
+
+        x = mx.random.uniform(shape=(2, 1, 5, 5, 3))
+        w = mx.random.uniform(shape=(2, 4, 3, 3, 3))
+        conv = lambda x, w: mx.conv2d(x, w, stride=2)
+        self.check_vmap(conv, (0, 0), x, w)
+
+    def test_vmap_scatter(self):
+        x = mx.zeros((3, 5, 2))
+        idx = mx.array([[0, 2], [1, 1], [4, 3]])
+        updates = mx.random.uniform(shape=(3, 2, 2))
+
+        def add(x, idx, updates):
+            return x.at[idx].add(updates)
+
+        def assign(x, idx, updates):
+            x[idx] = updates
+            return x
+
+        for fn in [add, assign]:
+            self.check_vmap(fn, (0, 0, 0), x, idx, updates)
+            self.check_vmap(fn, (None, 0, 0), x[0], idx, updates)
+            self.check_vmap(fn, (0, None, 0), x, idx[0], updates)
+            self.check_vmap(fn, (0, 0, None), x, idx, updates[0])
+
+    def test_vmap_quantized_matmul(self):
+        w = mx.random.normal(shape=(3, 32, 64))
+        wq = [mx.quantize(wi, 32, 4) for wi in w]
+        wq, scales, biases = (mx.stack(a) for a in zip(*wq))
+        x = mx.random.normal(shape=(3, 5, 64))
+
+        def qmm(x, wq, scales, biases):
+            return mx.quantized_matmul(x, wq, scales, biases, True, 32, 4)
+
+        self.check_vmap(qmm, (0, None, None, None), x, wq[0], scales[0], biases[0])
+        self.check_vmap(qmm, (0, 0, 0, 0), x, wq, scales, biases, atol=1e-4)
+        self.check_vmap(qmm, (None, 0, 0, 0), x[0], wq, scales, biases, atol=1e-4)
+        self.check_vmap(qmm, (0, 0, 0, 0), x[:, 0], wq, scales, biases, atol=1e-4)
+
+    def test_vmap_fast(self):
+        x = mx.random.uniform(shape=(3, 2, 4, 8))
+        w = mx.random.uniform(shape=(8,))
+        b = mx.random.uniform(shape=(8,))
+        rms_norm = lambda x, w: mx.fast.rms_norm(x, w, 1e-5)
+        self.check_vmap(rms_norm, (0, None), x, w)
+        self.check_vmap(rms_norm, (3, None), x, w[:3])
+        layer_norm = lambda x, w, b: mx.fast.layer_norm(x, w, b, 1e-5)
+        self.check_vmap(layer_norm, (1, None, None), x, w, b)
+        rope = lambda x: mx.fast.rope(x, 8, False, 10000.0, 1.0, 0)
+        self.check_vmap(rope, (0,), x)
+        self.check_vmap(rope, (2,), mx.random.uniform(shape=(2, 4, 3, 8)))
+
+        q = mx.random.uniform(shape=(3, 1, 2, 4, 8))
+        k = mx.random.uniform(shape=(3, 1, 2, 6, 8))
+        v = mx.random.uniform(shape=(3, 1, 2, 6, 8))
+        sdpa = lambda q, k, v: mx.fast.scaled_dot_product_attention(q, k, v, scale=0.5)
+        self.check_vmap(sdpa, (0, 0, 0), q, k, v, atol=1e-4)
+        self.check_vmap(sdpa, (0, None, None), q, k[0], v[0], atol=1e-4)
+
 
 if __name__ == "__main__":
     unittest.main()
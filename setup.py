@@ -104,7 +104,7 @@ class CMakeBuild(build_ext):
             check=True,
         )
 
-    # Make sure to copy mlx.metallib for inplace builds
+    # Make sure to copy the metallibs for inplace builds
     def run(self):
         super().run()
 
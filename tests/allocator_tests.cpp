@@ -5,6 +5,7 @@
 #include "doctest/doctest.h"
 
 #include "mlx/allocator.h"
+#include "mlx/mlx.h"
 
 using namespace mlx::core;
 
@@ -39,3 +40,115 @@ TEST_CASE("test large allocations") {
     allocator::free(buffer);
   }
 }
+
+TEST_CASE("test cpu allocator cache") {
+  auto& alloc = allocator::common_allocator();
+  alloc.clear_cache();
+  auto active_mem = alloc.get_active_memory();
+
+  // Freed buffers are reused for allocations of the same size class
+  auto buffer = alloc.malloc(1000);
+  auto ptr = buffer.ptr();
+  CHECK(alloc.get_active_memory() >= active_mem + 1000);
+  alloc.free(buffer);
+  CHECK_EQ(alloc.get_active_memory(), active_mem);
+  CHECK(alloc.get_cache_memory() >= 1000);
+  buffer = alloc.malloc(990);
+  CHECK_EQ(buffer.ptr(), ptr);
+  CHECK_EQ(alloc.get_cache_memory(), 0);
+  alloc.free(buffer);
+
+  alloc.reset_peak_memory();
+  {
+    auto a = alloc.malloc(4096);
+    auto b = alloc.malloc(4096);
+    alloc.free(a);
+    alloc.free(b);
+  }
+  CHECK(alloc.get_peak_memory() >= active_mem + 8192);
+
+  alloc.clear_cache();
+  CHECK_EQ(alloc.get_cache_memory(), 0);
+
+  // Nothing is cached past the limit
+  auto old_limit = alloc.set_cache_limit(0);
+  alloc.free(alloc.malloc(4096));
+  CHECK_EQ(alloc.get_cache_memory(), 0);
+  CHECK_EQ(alloc.set_cache_limit(old_limit), 0);
+
+  // The least recently freed buffers are released first
+  alloc.set_cache_limit(8192);
+  auto a = alloc.malloc(4096);
+  auto b = alloc.malloc(4096);
+  auto c = alloc.malloc(4096);
+  auto b_ptr = b.ptr();
+  auto c_ptr = c.ptr();
+  alloc.free(a);
+  alloc.free(b);
+  alloc.free(c);
+  CHECK_EQ(alloc.get_cache_memory(), 8192);
+  auto d = alloc.malloc(4096);
+  auto e = alloc.malloc(4096);
+  CHECK_EQ(d.ptr(), c_ptr);
+  CHECK_EQ(e.ptr(), b_ptr);
+  alloc.free(d);
+  alloc.free(e);
+  alloc.set_cache_limit(old_limit);
+  alloc.clear_cache();
+
+  // Cache statistics
+  alloc.reset_cache_stats();
+  alloc.free(alloc.malloc(300));
+  alloc.free(alloc.malloc(300));
+  auto stats = alloc.get_cache_stats();
+  CHECK_EQ(stats["hits"], 1);
+  CHECK_EQ(stats["misses"], 1);
+  CHECK_EQ(stats["wasted_bytes"], 20);
+  alloc.set_cache_limit(0);
+  CHECK_EQ(alloc.get_cache_stats()["evictions"], 1);
+  alloc.set_cache_limit(old_limit);
+  alloc.reset_cache_stats();
+  CHECK_EQ(alloc.get_cache_stats()["hits"], 0);
+}
+
+TEST_CASE("test memory tracking") {
+  memory::start_tracking();
+  CHECK(memory::is_tracking());
+
+  // The inputs are broadcast so Add can't donate either of their buffers
+  auto x = ones({256, 1}) + ones({1, 256});
+  auto y = arange(16);
+  {
+    memory::Tag tag("outer");
+    memory::Tag inner("inner");
+    eval(x);
+  }
+  eval(y);
+
+  // The outputs are attributed to their primitive and the tags of eval
+  auto live = memory::live_allocations();
+  REQUIRE(live.size() >= 2);
+  CHECK_EQ(live[0].size, x.nbytes());
+  CHECK_EQ(live[0].tag, "outer/inner");
+  CHECK_EQ(live[0].primitive, "Add");
+  bool found = false;
+  for (auto& a : live) {
+    found |= (a.size == y.nbytes() && a.tag.empty());
+  }
+  CHECK(found);
+  CHECK(memory::report().find("outer/inner") != std::string::npos);
+
+  // Freed buffers are no longer live and every change is on the timeline
+  auto nbytes = x.nbytes();
+  x = y;
+  CHECK(memory::live_allocations()[0].size < nbytes);
+  auto timeline = memory::timeline();
+  CHECK(timeline.size() >= 3);
+  for (int i = 1; i < timeline.size(); i++) {
+    CHECK(timeline[i].time >= timeline[i - 1].time);
+  }
+
+  memory::stop_tracking();
+  CHECK_FALSE(memory::is_tracking());
+  CHECK(memory::report().find("not tracked") != std::string::npos);
+}
@@ -187,6 +187,31 @@ TEST_CASE("test arg reduce edge cases") {
   CHECK_THROWS(argmax(array({})));
 }
 
+TEST_CASE("test arg reduce contiguous rows") {
+  // Rows reduced with the vectorized path match the strided loop, including
+  // ties, signed zeros and NaNs
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  int rows = 33;
+  int n = 1031;
+  auto vals = floor(random::uniform(-8.0, 8.0, {n, rows}));
+  vals = where(vals == array(7.0f), array(nan), vals);
+  vals = where(vals == array(-8.0f), array(-0.0f), vals);
+  vals = where(vals == array(6.0f), zeros({1}), vals);
+  for (auto t : {float32, float16, bfloat16, int32}) {
+    auto strided = astype(vals, t);
+    eval(strided);
+    auto x = transpose(strided);
+    auto contiguous = copy(x);
+    for (auto r : {ArgReduce::ArgMin, ArgReduce::ArgMax}) {
+      auto s = default_stream(Device::cpu);
+      auto p = std::make_shared<ArgReduce>(s, r, 1);
+      auto y1 = array({rows}, uint32, p, {contiguous});
+      auto y2 = array({rows}, uint32, p, {x});
+      CHECK(array_equal(y1, y2).item<bool>());
+    }
+  }
+}
+
 TEST_CASE("test arg reduce irregular strides") {
   auto x = array(
       {0, 2, 1, 7, 5, -5, 0, 2, 1, 7, 5, -5,
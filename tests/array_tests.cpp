@@ -609,3 +609,28 @@ TEST_CASE("test make empty array") {
   CHECK_EQ(a.size(), 0);
   CHECK_EQ(a.dtype(), bool_);
 }
+
+TEST_CASE("test destroy deep graph") {
+  // Tearing down a long unevaluated chain must not recurse
+  auto x = array({1.0f});
+  for (int n : {1000, 200000}) {
+    auto y = x;
+    for (int i = 0; i < n; ++i) {
+      y = abs(y);
+    }
+  }
+
+  // Nor should a chain with multi-output primitives or a partially
+  // evaluated one
+  auto y = x;
+  for (int i = 0; i < 200000; ++i) {
+    y = abs(y);
+    if (i % 1000 == 0) {
+      y = split(concatenate({y, y}), 2)[0];
+    }
+    if (i % 50000 == 0) {
+      eval(y);
+    }
+  }
+  CHECK_EQ(y.item<float>(), 1.0f);
+}
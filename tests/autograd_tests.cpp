@@ -9,6 +9,7 @@
 
 #include "mlx/graph_utils.h"
 #include "mlx/mlx.h"
+#include "mlx/primitives.h"
 
 using namespace mlx::core;
 
@@ -837,6 +838,24 @@ TEST_CASE("test min and max vjp") {
   }
 }
 
+TEST_CASE("test logsumexp grads") {
+  auto x = reshape(array({1.0f, 2.0f, 3.0f, 0.0f, 0.0f, 0.0f}), {2, 3});
+  auto fun = [](array input) { return logsumexp(input, 1); };
+  auto v = array({2.0f, 3.0f});
+  auto out = vjp(fun, x, v).second;
+  auto expected = multiply(softmax(x, 1), reshape(v, {2, 1}));
+  CHECK(allclose(out, expected).item<bool>());
+
+  auto t = ones({2, 3});
+  out = jvp(fun, x, t).second;
+  CHECK(allclose(out, ones({2})).item<bool>());
+
+  // Reducing over both axes
+  auto all_fun = [](array input) { return logsumexp(input, {0, 1}); };
+  out = vjp(all_fun, x, array(1.0f)).second;
+  CHECK(allclose(out, softmax(x)).item<bool>());
+}
+
 TEST_CASE("test reshape and transpose grads") {
   {
     auto fn = [](array a) { return reshape(a, {3, 4}); };
@@ -894,10 +913,27 @@ TEST_CASE("test matmul vjp") {
   a = array({1.0f, 2.0f, 1.0f, 2.0f}, {2, 2, 1});
   b = array({1.0f, 1.0f, 2.0f, 2.0f}, {2, 1, 2});
   auto vjps = vjp(fun, {a, b}, {ones({2, 2, 2})}).second;
+
+  // Both gradients come from one primitive, checked before the evaluation
+  // detaches them
+  CHECK_EQ(typeid(vjps[0].primitive()), typeid(MatmulVJP));
+  CHECK_EQ(vjps[0].siblings().size(), 1);
+  CHECK_EQ(vjps[0].siblings()[0].id(), vjps[1].id());
+
   auto vjpx = array({2.0f, 2.0f, 4.0f, 4.0f}, {2, 2, 1});
   auto vjpy = array({3.0f, 3.0f, 3.0f, 3.0f}, {2, 1, 2});
   CHECK(array_equal(vjps[0], vjpx).item<bool>());
   CHECK(array_equal(vjps[1], vjpy).item<bool>());
+
+  // The primitive is differentiable
+  auto grad_fun = [&fun](std::vector<array> inputs) {
+    auto g = vjp(fun, inputs, {ones({2, 2, 2})}).second;
+    return std::vector<array>{sum(g[0] * g[0]) + sum(g[1])};
+  };
+  vjps = vjp(grad_fun, {a, b}, {array(1.0f)}).second;
+  CHECK(array_equal(vjps[0], full({2, 2, 1}, 2.0f)).item<bool>());
+  vjpy = array({8.0f, 8.0f, 16.0f, 16.0f}, {2, 1, 2});
+  CHECK(array_equal(vjps[1], vjpy).item<bool>());
 }
 
 TEST_CASE("test concatenate grads") {
@@ -1288,3 +1324,57 @@ TEST_CASE("test grad types") {
     }
   }
 }
+
+TEST_CASE("test cached value and grad") {
+  auto fn = [](const std::vector<array>& inputs) {
+    auto loss = sum(square(matmul(inputs[1], inputs[0])));
+    return std::vector<array>{loss, sum(inputs[1])};
+  };
+  auto w = ones({4, 2});
+  auto x = reshape(arange(12, float32), {3, 4});
+  auto [expected_vals, expected_grads] = value_and_grad(fn, {0})({w, x});
+
+  auto vg = cached_value_and_grad(fn, {0});
+  reset_compile_cache_stats();
+  for (int i = 0; i < 3; i++) {
+    auto [vals, grads] = vg({w, x});
+    CHECK_EQ(vals.size(), 2);
+    CHECK_EQ(grads.size(), 1);
+    CHECK(allclose(vals[0], expected_vals[0]).item<bool>());
+    CHECK(allclose(vals[1], expected_vals[1]).item<bool>());
+    CHECK(allclose(grads[0], expected_grads[0]).item<bool>());
+  }
+  CHECK_EQ(compile_cache_stats().misses, 1);
+  CHECK_EQ(compile_cache_stats().hits, 2);
+}
+
+TEST_CASE("test checkpoint budget lowers peak memory") {
+  // The products are read by the vjps of sin so they are all kept until the
+  // backward pass without a budget
+  auto fun = [](const array& x) {
+    auto out = array(0.0f);
+    for (int k = 1; k <= 8; k++) {
+      out = out + sum(sin(x * static_cast<float>(k)));
+    }
+    return out;
+  };
+  auto x = random::uniform({1 << 18});
+  eval(x);
+  auto expected = value_and_grad(fun)(x);
+  eval(expected.first, expected.second);
+
+  auto peak_memory = [&](size_t budget) {
+    set_checkpoint_budget(budget);
+    auto [value, grad] = value_and_grad(fun)(x);
+    set_checkpoint_budget(0);
+    auto active = metal::get_active_memory();
+    metal::reset_peak_memory();
+    eval(value, grad);
+    CHECK(allclose(value, expected.first).item<bool>());
+    CHECK(allclose(grad, expected.second).item<bool>());
+    return metal::get_peak_memory() - active;
+  };
+  auto full = peak_memory(0);
+  auto budgeted = peak_memory(1);
+  CHECK(budgeted < full * 3 / 4);
+}
@@ -108,3 +108,90 @@ TEST_CASE("test matmul") {
   out = matmul(transpose(a, {0, 2, 1}), transpose(b, {0, 2, 1}));
   CHECK(array_equal(out, full({2, 4, 4}, 2.0f)).item<bool>());
 }
+
+TEST_CASE("test half precision matmul") {
+  // Large enough to be split in several tiles and deeper than one K block
+  auto a = random::normal({2, 131, 300});
+  auto b = random::normal({300, 150});
+  auto expected = matmul(a, b);
+  auto expected_t = matmul(transpose(b), transpose(a, {0, 2, 1}));
+  for (auto t : {float16, bfloat16}) {
+    float tol = t == float16 ? 5e-2 : 3e-1;
+    auto a_t = astype(a, t);
+    auto b_t = astype(b, t);
+    auto out = matmul(a_t, b_t);
+    CHECK_EQ(out.dtype(), t);
+    CHECK(allclose(astype(out, float32), expected, tol, tol).item<bool>());
+
+    // Transposed inputs
+    out = matmul(transpose(b_t), transpose(a_t, {0, 2, 1}));
+    CHECK(allclose(astype(out, float32), expected_t, tol, tol).item<bool>());
+
+    // Accumulation into c
+    auto c = astype(ones({131, 150}), t);
+    out = addmm(c, a_t, b_t, 2.0f, 0.5f);
+    CHECK(allclose(
+              astype(out, float32),
+              add(multiply(expected, array(2.0f)), array(0.5f)),
+              2 * tol,
+              2 * tol)
+              .item<bool>());
+
+    out = gather_mm(a_t, b_t, array({1, 0}, uint32), std::nullopt);
+    CHECK(allclose(
+              astype(out, float32),
+              take(expected, array({1, 0}), 0),
+              tol,
+              tol)
+              .item<bool>());
+
+    auto mask = astype(array({1, 0, 1, 1}, {2, 2}), bool_);
+    auto x = astype(ones({64, 64}), t);
+    out = block_masked_mm(x, x, 32, mask);
+    auto expected_masked = multiply(
+        full({64, 64}, 64.0f), repeat(repeat(mask, 32, 0), 32, 1));
+    CHECK(array_equal(astype(out, float32), expected_masked).item<bool>());
+  }
+}
+
+TEST_CASE("test quantized matmul") {
+  for (int bits : {2, 3, 4, 6, 8}) {
+    for (int group_size : {32, 64, 128}) {
+      // The last axis has to be large enough to quantize with 2 bits
+      auto w = random::normal({384, 512});
+      auto [w_q, scales, biases] = quantize(w, group_size, bits);
+      auto w_hat = dequantize(w_q, scales, biases, group_size, bits);
+
+      // A single row takes the matrix-vector path
+      for (int M : {1, 37}) {
+        auto x = random::normal({M, 512});
+        auto out =
+            quantized_matmul(x, w_q, scales, biases, true, group_size, bits);
+        auto expected = matmul(x, transpose(w_hat));
+        CHECK(allclose(out, expected, 1e-4, 1e-4).item<bool>());
+
+        x = random::normal({M, 384});
+        out = quantized_matmul(x, w_q, scales, biases, false, group_size, bits);
+        expected = matmul(x, w_hat);
+        CHECK(allclose(out, expected, 1e-4, 1e-4).item<bool>());
+      }
+    }
+  }
+
+  auto w = random::normal({128, 256});
+  auto [w_q, scales, biases] = quantize(w);
+  auto x = random::normal({3, 256});
+  for (auto t : {float16, bfloat16}) {
+    auto x_t = astype(x, t);
+    auto scales_t = astype(scales, t);
+    auto biases_t = astype(biases, t);
+    auto out = quantized_matmul(x_t, w_q, scales_t, biases_t);
+    CHECK_EQ(out.dtype(), t);
+
+    // Only the accumulation and the output are rounded differently
+    auto w_hat = dequantize(
+        w_q, astype(scales_t, float32), astype(biases_t, float32));
+    auto expected = matmul(astype(x_t, float32), transpose(w_hat));
+    CHECK(allclose(astype(out, float32), expected, 2e-2, 2e-2).item<bool>());
+  }
+}
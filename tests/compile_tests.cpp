@@ -1,5 +1,7 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <chrono>
+
 #include "doctest/doctest.h"
 
 #include "mlx/mlx.h"
@@ -222,6 +224,42 @@ TEST_CASE("test simplify multi output") {
   set_compile_mode(CompileMode::enabled);
 }
 
+auto identities(const std::vector<array>& inputs) {
+  auto x = inputs[0];
+  auto a = transpose(transpose(x, {1, 0}), {1, 0});
+  auto b = reshape(reshape(x, {4}), {2, 2});
+  auto c = x * array(1.0f);
+  auto d = astype(astype(x, float16), float32);
+  return std::vector<array>{exp(a) + exp(b), exp(c) + exp(d)};
+}
+
+auto cast_round_trip(const std::vector<array>& inputs) {
+  auto x = inputs[0];
+  return std::vector<array>{x + astype(astype(x, int64), int32)};
+}
+
+TEST_CASE("test simplify identities") {
+  set_compile_mode(CompileMode::no_fuse);
+  {
+    auto x = array({1.0f, 2.0f, 3.0f, 4.0f}, {2, 2});
+    auto out = compile(identities)({x});
+    // Each no-op is removed and the exps of x are merged
+    CHECK_EQ(out[0].inputs()[0].id(), out[0].inputs()[1].id());
+    CHECK_EQ(out[0].inputs()[0].inputs()[0].id(), x.id());
+    CHECK_EQ(out[1].inputs()[0].id(), out[0].inputs()[0].id());
+    // The float16 round trip loses precision and is kept
+    CHECK_NE(out[1].inputs()[1].id(), out[0].inputs()[0].id());
+    CHECK(array_equal(out[0], 2 * exp(x)).item<bool>());
+  }
+
+  {
+    auto x = array({1, 2, 3});
+    auto out = compile(cast_round_trip)({x})[0];
+    CHECK_EQ(out.inputs()[0].id(), out.inputs()[1].id());
+  }
+  set_compile_mode(CompileMode::enabled);
+}
+
 // No fusion
 auto unary_fused_0(const std::vector<array>& inputs) {
   return std::vector<array>{exp(inputs[0])};
@@ -282,14 +320,11 @@ TEST_CASE("test compile unary fused") {
     auto out = cfun({x});
     CHECK_EQ(out.size(), 1);
 
+    // The trailing reduction is fused with the elementwise ops
     auto& p = out[0].primitive();
-    // NB: this test is brittle, will need to update
-    // it if we change compile conditions
-    CHECK_EQ(typeid(p), typeid(Reduce));
-    auto cout = out[0].inputs()[0];
-    auto& cp = cout.primitive();
-    CHECK_EQ(typeid(cp), typeid(Compiled));
-    CHECK_EQ(cout.inputs()[0].id(), x.id());
+    CHECK_EQ(typeid(p), typeid(Compiled));
+    CHECK_EQ(out[0].inputs()[0].id(), x.id());
+    CHECK(allclose(out[0], unary_fused_2({x})[0]).item<bool>());
   }
 
   {
@@ -383,13 +418,10 @@ TEST_CASE("test compile binary fused") {
     auto out = cfun({x, y})[0];
 
     auto& p = out.primitive();
-    CHECK_EQ(typeid(p), typeid(Reduce));
-
-    auto cout = out.inputs()[0];
-    auto& cp = cout.primitive();
-    CHECK_EQ(typeid(cp), typeid(Compiled));
-    CHECK_EQ(cout.inputs()[0].id(), x.id());
-    CHECK_EQ(cout.inputs()[1].id(), y.id());
+    CHECK_EQ(typeid(p), typeid(Compiled));
+    CHECK_EQ(out.inputs()[0].id(), x.id());
+    CHECK_EQ(out.inputs()[1].id(), y.id());
+    CHECK(allclose(out, binary_fused_3({x, y})[0]).item<bool>());
   }
 }
 
@@ -621,8 +653,10 @@ TEST_CASE("test transform compiled function") {
   auto& p = outs[0].primitive();
   CHECK_EQ(typeid(p), typeid(Compiled));
   CHECK_EQ(outs[0].siblings()[0].id(), outs[1].id());
-  CHECK(!outs[0].inputs()[0].has_primitive());
-  CHECK(!outs[0].inputs()[1].has_primitive());
+  // Multiplying by the cotangent of ones is simplified away so the only
+  // input left is x
+  CHECK_EQ(outs[0].inputs().size(), 1);
+  CHECK_EQ(outs[0].inputs()[0].id(), x.id());
 }
 
 TEST_CASE("test fusion kernel reuse") {
@@ -669,6 +703,40 @@ TEST_CASE("test fusion types") {
   CHECK(!lib_name_z.empty());
 }
 
+auto fused_reductions(const std::vector<array>& inputs) {
+  auto z = exp(inputs[0]) * inputs[1];
+  return std::vector<array>{
+      sum(z, -1),
+      max(z, -1, true),
+      min(negative(z), -1),
+      prod(abs(inputs[1]) + 1.0f, -1),
+      sum(z)};
+}
+
+TEST_CASE("test compile fused reduction values") {
+  auto cfun = compile(fused_reductions);
+  for (auto dtype : {float32, float16}) {
+    auto x = astype(
+        reshape(divide(arange(3 * 37, float32), array(50.0f)), {3, 37}),
+        dtype);
+    // The second input is broadcast along the reduced rows
+    auto y = astype(array({1.0f, -0.5f, 2.0f}, {3, 1}), dtype);
+    auto out = cfun({x, y});
+    auto expected = fused_reductions({x, y});
+    CHECK_EQ(out.size(), expected.size());
+    for (int i = 0; i < out.size(); i++) {
+      CHECK_EQ(out[i].shape(), expected[i].shape());
+      CHECK_EQ(out[i].dtype(), expected[i].dtype());
+      CHECK(allclose(
+                astype(out[i], float32),
+                astype(expected[i], float32),
+                1e-2,
+                1e-2)
+                .item<bool>());
+    }
+  }
+}
+
 auto compile_shapeless_not_ok(const std::vector<array>& inputs) {
   auto x = reshape(inputs[0], {2, 2});
   return std::vector<array>{x};
@@ -719,3 +787,195 @@ TEST_CASE("test compile strides") {
     CHECK_EQ(out.strides().size(), 3);
   }
 }
+
+auto compile_cached_kernel(const std::vector<array>& inputs) {
+  return std::vector<array>{exp(abs(inputs[0])) * inputs[1]};
+}
+
+TEST_CASE("test compile cpu kernel cache") {
+  auto x = array({-1.0f, 0.0f, 2.0f});
+  auto y = array({2.0f, 3.0f, 0.5f});
+  auto expected = exp(abs(x)) * y;
+  {
+    auto cfun = compile(compile_cached_kernel);
+    CHECK(allclose(cfun({x, y})[0], expected).item<bool>());
+  }
+
+  // Loading the cached libraries again is harmless
+  preload_cpu_kernels();
+  preload_cpu_kernels();
+  {
+    auto cfun = compile(compile_cached_kernel);
+    CHECK(allclose(cfun({x, y})[0], expected).item<bool>());
+  }
+}
+
+// A constant that differs between runs gives a new kernel in every process
+float unfused_constant =
+    1.0f + std::chrono::system_clock::now().time_since_epoch().count() % 997;
+
+auto compile_unfused(const std::vector<array>& inputs) {
+  auto x = inputs[0];
+  auto y = astype(inputs[1], float32);
+  auto z = exp(abs(x)) * array(unfused_constant) + y;
+  return std::vector<array>{z, astype(z, int32), greater(z, x)};
+}
+
+TEST_CASE("test compile runs unfused while building") {
+  auto x = reshape(arange(-6.0f, 6.0f, 1.0f), {3, 4});
+  auto y = array({1, 2, 3, 4}, int16);
+  auto cfun = compile(compile_unfused);
+  for (auto& in : std::vector<array>{x, transpose(reshape(x, {4, 3}))}) {
+    auto expected = compile_unfused({in, y});
+    for (int i = 0; i < 2; i++) {
+      auto out = cfun({in, y});
+      CHECK_EQ(out.size(), 3);
+      for (int j = 0; j < 3; j++) {
+        CHECK_EQ(out[j].dtype(), expected[j].dtype());
+        CHECK(array_equal(out[j], expected[j]).item<bool>());
+      }
+    }
+  }
+}
+
+auto compile_large_kernel(const std::vector<array>& inputs) {
+  return std::vector<array>{
+      maximum(inputs[0] * inputs[1], array(0.0f)) + sqrt(abs(inputs[0]))};
+}
+
+TEST_CASE("test compile large kernels across threads") {
+  int n_threads = cpu_threads();
+  set_cpu_threads(4);
+  auto x = random::normal({256, 1000});
+  auto y = random::normal({256, 1000});
+  auto cfun = compile(compile_large_kernel);
+  for (auto& [a, b] : std::vector<std::pair<array, array>>{
+           {x, y},
+           {transpose(reshape(x, {1000, 256})), y},
+           {x, slice(y, {0, 0}, {1, 1000})},
+           {slice(flatten(x), {1}, {256000}, {2}), array(0.5f)}}) {
+    auto expected = compile_large_kernel({a, b})[0];
+    // Run until the kernel is built to check both paths
+    for (int i = 0; i < 3; i++) {
+      auto out = cfun({a, b})[0];
+      CHECK(allclose(out, expected).item<bool>());
+    }
+  }
+  set_cpu_threads(n_threads);
+}
+
+std::vector<array> capture_fun(const std::vector<array>& inputs) {
+  auto y = matmul(inputs[0], inputs[1]);
+  y = softmax(y + inputs[2], -1);
+  return {sum(exp(y) * 2.0f, -1), transpose(y)};
+}
+
+TEST_CASE("test compile capture") {
+  set_compile_mode(CompileMode::capture);
+  auto cfun = compile(capture_fun);
+  for (int i = 0; i < 4; i++) {
+    auto x = random::normal({8, 16});
+    auto w = random::normal({16, 32});
+    auto b = random::normal({32});
+    auto expected = capture_fun({x, w, b});
+    auto out = cfun({x, w, b});
+    CHECK(allclose(out[0], expected[0], 1e-4, 1e-4).item<bool>());
+    CHECK(allclose(out[1], expected[1], 1e-4, 1e-4).item<bool>());
+  }
+
+  // Inputs with a different layout are recorded separately
+  auto x = transpose(random::normal({16, 8}));
+  auto w = random::normal({16, 32});
+  auto b = random::normal({32});
+  auto expected = capture_fun({x, w, b});
+  auto out = cfun({x, w, b});
+  CHECK(allclose(out[0], expected[0], 1e-4, 1e-4).item<bool>());
+  set_compile_mode(CompileMode::enabled);
+}
+
+std::vector<array> donate_fun(const std::vector<array>& inputs) {
+  // unfused_constant makes the kernel new in every process so that the first
+  // call always runs unfused
+  return {exp(inputs[0]) * array(unfused_constant) + inputs[1]};
+}
+
+TEST_CASE("test compile donated inputs") {
+  auto x = random::normal({64});
+  auto y = random::normal({64});
+  auto expected = donate_fun({x, y})[0];
+  eval(x, y, expected);
+
+  // The donated buffer is reused for the output even though x still refers
+  // to it, whether the fused kernel is ready or not
+  auto cfun = compile(donate_fun, false, {0});
+  auto x_ptr = x.data<float>();
+  for (int i = 0; i < 2; i++) {
+    // copy() would share the buffer of x, so build the copy from the data
+    auto x_copy = array(x.data<float>(), x.shape());
+    auto copy_ptr = x_copy.data<float>();
+    auto out = cfun({x_copy, y})[0];
+    eval(out);
+    CHECK_EQ(out.data<float>(), copy_ptr);
+    CHECK(allclose(out, expected).item<bool>());
+  }
+  auto out = cfun({x, y})[0];
+  eval(out);
+  CHECK_EQ(out.data<float>(), x_ptr);
+  CHECK(allclose(out, expected).item<bool>());
+
+  // An input passed twice is not donated
+  out = cfun({y, y})[0];
+  eval(out);
+  CHECK_NE(out.data<float>(), y.data<float>());
+  CHECK(allclose(out, donate_fun({y, y})[0]).item<bool>());
+
+  CHECK_THROWS(compile(donate_fun, false, {2})({x, y}));
+}
+
+// An elementwise primitive defined outside of MLX computing 2 * x + y
+class TwoXPlusY : public UnaryPrimitive {
+ public:
+  explicit TwoXPlusY(Stream stream) : UnaryPrimitive(stream) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override {
+    auto& x = inputs[0];
+    auto& y = inputs[1];
+    out.set_data(allocator::malloc_or_wait(out.nbytes()));
+    for (size_t i = 0; i < out.size(); i++) {
+      out.data<float>()[i] = 2 * x.data<float>()[i] + y.data<float>()[i];
+    }
+  }
+  void eval_gpu(const std::vector<array>&, array&) override {
+    throw std::runtime_error("TwoXPlusY only runs fused on the GPU.");
+  }
+
+  void print(std::ostream& os) override {
+    os << "TwoXPlusY";
+  }
+
+  std::string elementwise_source() const override {
+    return "template <typename T>\n"
+           "T operator()(T x, T y) { return T(2) * x + y; }";
+  }
+};
+
+std::vector<array> custom_elementwise_fun(const std::vector<array>& inputs) {
+  auto& x = inputs[0];
+  auto& y = inputs[1];
+  auto s = to_stream(default_device());
+  auto z = array(x.shape(), float32, std::make_shared<TwoXPlusY>(s), {x, y});
+  return {exp(z) + 1.0f};
+}
+
+TEST_CASE("test compile custom elementwise primitive") {
+  auto x = random::uniform({16});
+  auto y = random::uniform({16});
+  auto out = compile(custom_elementwise_fun)({x, y})[0];
+
+  // The custom primitive is fused with its neighbors
+  CHECK_EQ(typeid(out.primitive()), typeid(Compiled));
+  CHECK_EQ(out.inputs()[0].id(), x.id());
+  CHECK_EQ(out.inputs()[1].id(), y.id());
+  auto expected = exp(2.0f * x + y) + 1.0f;
+  CHECK(allclose(out, expected).item<bool>());
+}
@@ -1,5 +1,7 @@
 // Copyright © 2023 Apple Inc.
 
+#include <cstring>
+
 #include "doctest/doctest.h"
 
 #include "mlx/mlx.h"
@@ -150,6 +152,44 @@ TEST_CASE("test astype") {
   }
 }
 
+TEST_CASE("test astype half precision") {
+  // Every finite float16 round trips through float32
+  std::vector<float> vals;
+  for (int i = 0; i < (1 << 16); i++) {
+    uint16_t bits = i;
+    float16_t h;
+    std::memcpy(&h, &bits, sizeof(h));
+    if (std::isfinite(static_cast<float>(h))) {
+      vals.push_back(static_cast<float>(h));
+    }
+  }
+  int n = vals.size();
+  auto x = array(vals.begin(), {n}, float32);
+  auto y = astype(x, float16, Device::cpu);
+  CHECK(array_equal(astype(y, float32, Device::cpu), x).item<bool>());
+
+  // Bulk conversions round like the scalar ones
+  auto r = random::normal({1027}, float32, 0.0, 100.0);
+  eval(r);
+  auto r16 = astype(r, float16, Device::cpu);
+  auto rbf16 = astype(r, bfloat16, Device::cpu);
+  eval(r16, rbf16);
+  bool matches = true;
+  for (int i = 0; i < r.size(); i++) {
+    float v = r.data<float>()[i];
+    matches &= static_cast<float>(r16.data<float16_t>()[i]) ==
+        static_cast<float>(static_cast<float16_t>(v));
+    matches &= static_cast<float>(rbf16.data<bfloat16_t>()[i]) ==
+        static_cast<float>(static_cast<bfloat16_t>(v));
+  }
+  CHECK(matches);
+
+  // Half precision ops compute in float and round once
+  auto z = multiply(y, y, Device::cpu);
+  auto expected = astype(multiply(x, x), float16, Device::cpu);
+  CHECK(array_equal(z, expected, true).item<bool>());
+}
+
 TEST_CASE("test full") {
   // Check throws on bad shape
   {
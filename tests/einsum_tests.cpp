@@ -0,0 +1,74 @@
+// Copyright © 2024 Apple Inc.
+
+#include "doctest/doctest.h"
+
+#include "mlx/mlx.h"
+
+using namespace mlx::core;
+
+TEST_CASE("test einsum") {
+  auto x = reshape(arange(12, float32), {3, 4});
+  auto y = reshape(arange(20, float32), {4, 5});
+
+  // Matrix products and transposes
+  CHECK(array_equal(einsum("ij,jk->ik", {x, y}), matmul(x, y)).item<bool>());
+  CHECK(array_equal(einsum("ij,jk", {x, y}), matmul(x, y)).item<bool>());
+  CHECK(array_equal(einsum("ij,jk->ki", {x, y}), transpose(matmul(x, y)))
+            .item<bool>());
+  CHECK(array_equal(einsum("ij->ji", {x}), transpose(x)).item<bool>());
+  CHECK(array_equal(einsum("ij->", {x}), sum(x)).item<bool>());
+  CHECK(array_equal(einsum("ij->j", {x}), sum(x, 0)).item<bool>());
+
+  // Outer product needs no contraction
+  auto a = arange(3, float32);
+  auto b = arange(4, float32);
+  CHECK(array_equal(einsum("i,j->ij", {a, b}), outer(a, b)).item<bool>());
+
+  // Diagonals and traces
+  auto sq = reshape(arange(9, float32), {3, 3});
+  CHECK(array_equal(einsum("ii->i", {sq}), diagonal(sq)).item<bool>());
+  CHECK(array_equal(einsum("ii", {sq}), trace(sq)).item<bool>());
+
+  // Batched products with an ellipsis and broadcasting
+  auto bx = reshape(arange(24, float32), {2, 3, 4});
+  auto by = reshape(arange(20, float32), {1, 4, 5});
+  CHECK(array_equal(einsum("...ij,...jk->...ik", {bx, by}), matmul(bx, by))
+            .item<bool>());
+
+  // Chains give the same result whichever order is picked
+  auto z = reshape(arange(10, float32), {5, 2});
+  CHECK(allclose(einsum("ij,jk,kl->il", {x, y, z}), matmul(matmul(x, y), z))
+            .item<bool>());
+
+  // Integers are contracted exactly
+  auto xi = reshape(arange(12, int32), {3, 4});
+  auto yi = reshape(arange(20, int32), {4, 5});
+  auto out = einsum("ij,jk->ik", {xi, yi});
+  CHECK_EQ(out.dtype(), int32);
+  CHECK(array_equal(out, matmul(astype(xi, float32), astype(yi, float32)))
+            .item<bool>());
+
+  // Errors
+  CHECK_THROWS(einsum("ij,jk->ik", {x}));
+  CHECK_THROWS(einsum("ijk->", {x}));
+  CHECK_THROWS(einsum("ij,jk->il", {x, y}));
+  CHECK_THROWS(einsum("ij,jk->iik", {x, y}));
+  CHECK_THROWS(einsum("ij,jk->ik", {x, x}));
+  CHECK_THROWS(einsum("i1->i", {x}));
+}
+
+TEST_CASE("test einsum path") {
+  auto a = ones({2, 100});
+  auto b = ones({100, 100});
+  auto c = ones({100, 3});
+
+  // Contracting a and b first is cheaper
+  auto [path, desc] = einsum_path("ij,jk,kl->il", {a, b, c});
+  CHECK_EQ(path.size(), 2);
+  CHECK_EQ(path[0], std::vector<int>{0, 1});
+  CHECK_EQ(path[1], std::vector<int>{0, 1});
+  CHECK_FALSE(desc.empty());
+
+  std::tie(path, desc) = einsum_path("ij,jk,kl->il", {ones({100, 100}), b, c});
+  CHECK_EQ(path[0], std::vector<int>{1, 2});
+}
@@ -2,6 +2,8 @@
 
 #include "doctest/doctest.h"
 
+#include <thread>
+
 #include "mlx/mlx.h"
 
 using namespace mlx::core;
@@ -91,3 +93,211 @@ TEST_CASE("test eval graph retention when not tracing") {
   CHECK(!a.has_primitive());
   CHECK(a.is_available());
 }
+
+TEST_CASE("test eval shared subgraphs") {
+  // Arrays reached through several paths or as siblings are scheduled once
+  auto x = array({1.0f, 2.0f, 3.0f, 4.0f});
+  for (int i = 0; i < 3; ++i) {
+    auto parts = split(exp(x), 2);
+    auto a = parts[0] + parts[1];
+    auto b = parts[0] * parts[1];
+    auto c = a + b;
+    eval(c, a);
+    CHECK(allclose(c, array({77.40197f, 465.416f})).item<bool>());
+    CHECK(!parts[0].has_primitive());
+    CHECK(!parts[1].has_primitive());
+
+    // Evaluating arrays that are already available is a no-op
+    eval(c, a);
+    CHECK(c.is_available());
+  }
+}
+
+TEST_CASE("test eval graphs sharing inputs from several threads") {
+  auto w = random::normal({64, 64});
+  eval(w);
+  auto expected = sum(matmul(w, w)).item<float>();
+
+  std::vector<float> results(4);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&w, &results, i]() {
+      for (int j = 0; j < 20; j++) {
+        results[i] = sum(matmul(w, w)).item<float>();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto r : results) {
+    CHECK_EQ(r, doctest::Approx(expected));
+  }
+}
+
+TEST_CASE("test eval wide graph under memory limit") {
+  // The branches need far more memory than is left under the limit so the
+  // tape is reordered and the GPU work throttled
+  auto old_limit =
+      metal::set_memory_limit(metal::get_active_memory() + (1 << 20));
+  std::vector<array> branches;
+  for (int i = 0; i < 64; i++) {
+    auto y = full({256, 1024}, static_cast<float>(i)) + 1.0f;
+    branches.push_back(sum(y));
+  }
+  auto out = stack(branches);
+  eval(out);
+  metal::set_memory_limit(old_limit);
+  auto expected = arange(1, 65, float32) * 262144.0f;
+  CHECK(array_equal(out, expected).item<bool>());
+}
+
+TEST_CASE("test eval with cpu graph scheduling") {
+  set_cpu_graph_scheduling(true);
+  auto s = default_stream(Device::cpu);
+
+  // A wide graph of independent branches joined at the end
+  auto x = random::uniform({64, 64}, float32, {}, s);
+  std::vector<array> branches;
+  for (int i = 0; i < 16; i++) {
+    auto y = exp(multiply(x, array(static_cast<float>(i)), s), s);
+    branches.push_back(sum(y, 1, false, s));
+  }
+  auto out = sum(stack(branches, 0, s), 0, false, s);
+
+  std::vector<array> expected_branches;
+  for (int i = 0; i < 16; i++) {
+    expected_branches.push_back(
+        sum(exp(multiply(x, array(static_cast<float>(i)), s), s), 1, false, s));
+  }
+  eval(out);
+  set_cpu_graph_scheduling(false);
+  auto expected = sum(stack(expected_branches, 0, s), 0, false, s);
+  CHECK(allclose(out, expected, 1e-5, 1e-5, false, s).item<bool>());
+
+  // Async evaluations on the same stream are still ordered
+  set_cpu_graph_scheduling(true);
+  auto a = add(x, x, s);
+  async_eval({a});
+  auto b = multiply(a, a, s);
+  auto c = subtract(b, a, s);
+  eval({c, b});
+  set_cpu_graph_scheduling(false);
+  auto expected_c = subtract(multiply(a, a, s), a, s);
+  CHECK(array_equal(c, expected_c, s).item<bool>());
+}
+
+TEST_CASE("test eval with small ops placed on the cpu") {
+  if (!metal::is_available()) {
+    return;
+  }
+  set_cpu_placement_size(16);
+  auto s = default_stream(Device::gpu);
+
+  // Small ops, small ops on the results of a large one and a large op on
+  // the results of small ones
+  auto x = arange(8, float32, s);
+  auto small = sum(exp(x, s), false, s);
+  auto y = ones({64, 64}, float32, s);
+  auto after_large = add(sum(y, false, s), x, s);
+  auto before_large = multiply(y, small, s);
+  eval(small, after_large, before_large);
+  set_cpu_placement_size(0);
+
+  auto s_cpu = default_stream(Device::cpu);
+  auto x_cpu = arange(8, float32, s_cpu);
+  auto expected = sum(exp(x_cpu, s_cpu), false, s_cpu);
+  CHECK(allclose(small, expected, 1e-5, 1e-5, false, s_cpu).item<bool>());
+  CHECK(array_equal(after_large, x_cpu + 4096.0f, s_cpu).item<bool>());
+  CHECK(allclose(before_large, full({64, 64}, expected, s_cpu), 1e-5, 1e-5)
+            .item<bool>());
+}
+
+TEST_CASE("test async eval batch") {
+  CHECK(async_eval_batch({}).empty());
+
+  // Requests sharing part of their graph, one of them already evaluated
+  auto x = array({1, 2, 3});
+  auto shared = exp(x);
+  auto a = sum(shared);
+  auto b = shared + 1;
+  auto c = array(2.0f);
+  eval(c);
+  auto events = async_eval_batch({{a}, {b, a * 2}, {c}});
+  CHECK_EQ(events.size(), 3);
+  for (auto& e : events) {
+    e.wait();
+    CHECK(e.is_signaled());
+  }
+  CHECK(allclose(a, sum(exp(x))).item<bool>());
+  CHECK(allclose(b, exp(x) + 1).item<bool>());
+  CHECK_EQ(c.item<float>(), 2.0f);
+}
+
+TEST_CASE("test prefetcher") {
+  {
+    int i = 0;
+    Prefetcher prefetcher(
+        [&i]() -> std::optional<Prefetcher::Batch> {
+          if (i == 5) {
+            return std::nullopt;
+          }
+          auto x = full({4}, i++, int32);
+          return Prefetcher::Batch{x, x + 1};
+        },
+        3);
+    for (int j = 0; j < 5; j++) {
+      auto batch = prefetcher.next();
+      CHECK(batch.has_value());
+      CHECK_EQ(batch->size(), 2);
+      CHECK(array_equal((*batch)[0], full({4}, j, int32)).item<bool>());
+      CHECK((*batch)[1].is_available());
+    }
+    CHECK_FALSE(prefetcher.next().has_value());
+    CHECK_FALSE(prefetcher.next().has_value());
+  }
+
+  // Errors are rethrown once the earlier batches are consumed
+  {
+    int i = 0;
+    Prefetcher prefetcher([&i]() -> std::optional<Prefetcher::Batch> {
+      if (i++ > 0) {
+        throw std::runtime_error("no more batches");
+      }
+      return Prefetcher::Batch{array(1)};
+    });
+    CHECK(prefetcher.next().has_value());
+    CHECK_THROWS_AS(prefetcher.next(), std::runtime_error);
+    CHECK_FALSE(prefetcher.next().has_value());
+  }
+
+  // The worker stops when the prefetcher is destroyed
+  {
+    Prefetcher prefetcher([]() { return Prefetcher::Batch{array(1)}; });
+  }
+
+  CHECK_THROWS_AS(
+      Prefetcher([]() { return std::nullopt; }, 0), std::invalid_argument);
+}
+
+TEST_CASE("test batch split") {
+  auto w = reshape(arange(12, float32), {3, 4});
+  BatchSplit fun(
+      [&w](const std::vector<array>& inputs) {
+        return std::vector<array>{matmul(inputs[0], w), exp(inputs[1])};
+      },
+      0.25);
+  auto x = reshape(arange(24, float32), {8, 3});
+  auto y = ones({8, 2});
+  for (int i = 0; i < 3; i++) {
+    auto outputs = fun({x, y});
+    CHECK_EQ(outputs.size(), 2);
+    CHECK(allclose(outputs[0], matmul(x, w)).item<bool>());
+    CHECK(allclose(outputs[1], exp(y)).item<bool>());
+    CHECK(fun.cpu_fraction() > 0.0f);
+    CHECK(fun.cpu_fraction() < 1.0f);
+  }
+
+  CHECK_THROWS_AS(fun({x, ones({4, 2})}), std::invalid_argument);
+  CHECK_THROWS_AS(BatchSplit(nullptr, 2.0f), std::invalid_argument);
+}
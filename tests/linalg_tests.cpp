@@ -347,4 +347,132 @@ TEST_CASE("test matrix cholesky") {
             .item<bool>());
   CHECK(allclose(matmul(transpose(U), U), A, /* rtol = */ 0, /* atol = */ 1e-6)
             .item<bool>());
-}
\ No newline at end of file
+}
+
+TEST_CASE("test batched small matrix linalg") {
+  int n_threads = cpu_threads();
+  set_cpu_threads(4);
+
+  auto prng_key = random::key(1234);
+  for (int N : {1, 2, 3, 4, 8}) {
+    // Diagonally dominant so the matrices are well conditioned
+    auto A = random::normal({3, 700, N, N}, prng_key) + 2 * N * eye(N);
+    auto I = broadcast_to(eye(N), A.shape());
+
+    auto A_inv = linalg::inv(A, Device::cpu);
+    CHECK(allclose(matmul(A, A_inv), I, /* rtol = */ 0, /* atol = */ 1e-5)
+              .item<bool>());
+
+    auto S = matmul(A, swapaxes(A, -1, -2));
+    auto L = linalg::cholesky(S, /* upper = */ false, Device::cpu);
+    auto U = linalg::cholesky(S, /* upper = */ true, Device::cpu);
+    CHECK(array_equal(L, tril(L)).item<bool>());
+    CHECK(array_equal(U, triu(U)).item<bool>());
+    CHECK(allclose(matmul(L, swapaxes(L, -1, -2)), S, 1e-4, 1e-4)
+              .item<bool>());
+    CHECK(allclose(matmul(swapaxes(U, -1, -2), U), S, 1e-4, 1e-4)
+              .item<bool>());
+
+    auto [Q, R] = linalg::qr(A, Device::cpu);
+    CHECK(allclose(matmul(Q, R), A, 1e-4, 1e-4).item<bool>());
+
+    auto usv = linalg::svd(A, Device::cpu);
+    auto A_again = matmul(usv[0] * expand_dims(usv[1], -2), usv[2]);
+    CHECK(allclose(A_again, A, 1e-3, 1e-3).item<bool>());
+  }
+
+  set_cpu_threads(n_threads);
+}
+
+TEST_CASE("test triangular solve") {
+  // Non-square and mismatched shapes throw
+  CHECK_THROWS(linalg::solve_triangular(ones({2, 3}), ones({2})));
+  CHECK_THROWS(linalg::solve_triangular(ones({2, 2}), ones({3})));
+
+  // Unsupported types throw
+  CHECK_THROWS(linalg::solve_triangular(ones({2, 2}, int32), ones({2})));
+
+  auto prng_key = random::key(7);
+  auto A = random::normal({4, 4}, prng_key) + 8 * eye(4);
+  auto L = tril(A);
+  auto U = triu(A);
+  auto b = random::normal({2, 4, 3}, random::key(8));
+
+  // Only the requested triangle is read
+  auto x = linalg::solve_triangular(A, b, /* upper = */ false, Device::cpu);
+  CHECK_EQ(x.shape(), b.shape());
+  CHECK(allclose(matmul(L, x), b, 1e-5, 1e-5).item<bool>());
+  x = linalg::solve_triangular(A, b, /* upper = */ true, Device::cpu);
+  CHECK(allclose(matmul(U, x), b, 1e-5, 1e-5).item<bool>());
+
+  // Vector right hand side
+  auto v = array({1.0f, 2.0f, 3.0f, 4.0f});
+  x = linalg::solve_triangular(L, v, /* upper = */ false, Device::cpu);
+  CHECK_EQ(x.shape(), v.shape());
+  CHECK(allclose(matmul(L, x), v, 1e-5, 1e-5).item<bool>());
+}
+
+TEST_CASE("test linear solve") {
+  // Non-square and mismatched shapes throw
+  CHECK_THROWS(linalg::solve(ones({2, 3}), ones({2})));
+  CHECK_THROWS(linalg::solve(ones({2, 2}), ones({3, 1})));
+
+  auto prng_key = random::key(3);
+  auto A = random::normal({2, 5, 5}, prng_key) + 10 * eye(5);
+  auto b = random::normal({2, 5, 3}, random::key(4));
+  auto x = linalg::solve(A, b, Device::cpu);
+  CHECK_EQ(x.shape(), b.shape());
+  CHECK(allclose(matmul(A, x), b, 1e-5, 1e-5).item<bool>());
+
+  // Broadcast a vector against the batch
+  auto v = array({1.0f, 2.0f, 3.0f, 4.0f, 5.0f});
+  x = linalg::solve(A, v, Device::cpu);
+  CHECK_EQ(x.shape(), std::vector<int>{2, 5});
+  CHECK(allclose(squeeze(matmul(A, expand_dims(x, -1)), -1), v, 1e-5, 1e-5)
+            .item<bool>());
+
+  // Solve with the Cholesky factor
+  auto S = matmul(A, swapaxes(A, -1, -2));
+  auto L = linalg::cholesky(S, /* upper = */ false, Device::cpu);
+  x = linalg::cho_solve(L, b, /* upper = */ false, Device::cpu);
+  CHECK(allclose(matmul(S, x), b, 1e-4, 1e-4).item<bool>());
+  auto U = linalg::cholesky(S, /* upper = */ true, Device::cpu);
+  x = linalg::cho_solve(U, b, /* upper = */ true, Device::cpu);
+  CHECK(allclose(matmul(S, x), b, 1e-4, 1e-4).item<bool>());
+  x = linalg::cho_solve(U, v, /* upper = */ true, Device::cpu);
+  CHECK(allclose(squeeze(matmul(S, expand_dims(x, -1)), -1), v, 1e-4, 1e-4)
+            .item<bool>());
+}
+
+TEST_CASE("test symmetric eigendecomposition") {
+  // 0D and 1D throw
+  CHECK_THROWS(linalg::eigh(array(0.0)));
+  CHECK_THROWS(linalg::eigh(array({0.0, 1.0})));
+
+  // Non-square throws
+  CHECK_THROWS(linalg::eigh(ones({2, 3})));
+
+  // Invalid triangle throws
+  CHECK_THROWS(linalg::eigh(ones({2, 2}), "X"));
+
+  auto prng_key = random::key(42);
+  auto B = random::normal({3, 5, 5}, prng_key);
+  auto A = B + swapaxes(B, -1, -2);
+  auto [w, V] = linalg::eigh(A, "L", Device::cpu);
+  CHECK_EQ(w.shape(), std::vector<int>{3, 5});
+  CHECK_EQ(V.shape(), std::vector<int>{3, 5, 5});
+
+  auto A_again = matmul(V * expand_dims(w, -2), swapaxes(V, -1, -2));
+  CHECK(allclose(A_again, A, 1e-4, 1e-4).item<bool>());
+  CHECK(all(less_equal(
+                slice(w, {0, 0}, {3, 4}), slice(w, {0, 1}, {3, 5})))
+            .item<bool>());
+  auto w_only = linalg::eigvalsh(A, "L", Device::cpu);
+  CHECK(allclose(w_only, w, 1e-5, 1e-5).item<bool>());
+
+  // Only the chosen triangle is read
+  auto w_lower = linalg::eigvalsh(tril(A), "L", Device::cpu);
+  auto w_upper = linalg::eigvalsh(triu(A), "U", Device::cpu);
+  CHECK(allclose(w_lower, w, 1e-5, 1e-5).item<bool>());
+  CHECK(allclose(w_upper, w, 1e-5, 1e-5).item<bool>());
+}
@@ -1,11 +1,15 @@
 // Copyright © 2023 Apple Inc.
 
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <random>
 #include <stdexcept>
 #include <vector>
 
 #include "doctest/doctest.h"
 
+#include "mlx/io/deflate.h"
 #include "mlx/mlx.h"
 
 using namespace mlx::core;
@@ -40,6 +44,150 @@ TEST_CASE("test save_safetensors") {
   CHECK(array_equal(test2, ones({2, 2})).item<bool>());
 }
 
+TEST_CASE("test save_safetensors lazy arrays") {
+  std::string file_path = get_temp_file("test_lazy.safetensors");
+  auto x = reshape(arange(12, float32), {3, 4});
+  std::unordered_map<std::string, array> map;
+  for (int i = 0; i < 8; i++) {
+    // Unevaluated and not row contiguous
+    map.insert({"x_" + std::to_string(i), transpose(multiply(x, array(i)))});
+  }
+  save_safetensors(file_path, map);
+  auto [dict, metadata] = load_safetensors(file_path);
+  CHECK_EQ(dict.size(), 8);
+  for (int i = 0; i < 8; i++) {
+    auto& loaded = dict.at("x_" + std::to_string(i));
+    CHECK_EQ(loaded.shape(), std::vector<int>({4, 3}));
+    CHECK(array_equal(loaded, transpose(multiply(x, array(i)))).item<bool>());
+  }
+}
+
+TEST_CASE("test load_safetensors_sharded") {
+  auto a = reshape(arange(24, float32), {4, 6});
+  auto b = reshape(arange(8, int32), {1, 8});
+  auto c = array({1, 2, 3}, int16);
+  std::string index_path =
+      get_temp_file("test_sharded.safetensors.index.json");
+  save_safetensors(
+      get_temp_file("test_sharded-00001-of-00002.safetensors"), {{"a", a}});
+  save_safetensors(
+      get_temp_file("test_sharded-00002-of-00002.safetensors"),
+      {{"b", b}, {"c", c}, {"unused", ones({2})}});
+  {
+    std::ofstream index(index_path);
+    index << R"({"metadata": {"total_size": 140, "format": "pt"},)"
+          << R"("weight_map": {)"
+          << R"("a": "test_sharded-00001-of-00002.safetensors",)"
+          << R"("b": "test_sharded-00002-of-00002.safetensors",)"
+          << R"("c": "test_sharded-00002-of-00002.safetensors"}})";
+  }
+
+  auto [dict, metadata] = load_safetensors_sharded(index_path);
+  CHECK_EQ(dict.size(), 3);
+  CHECK_EQ(metadata.at("total_size"), "140");
+  CHECK_EQ(metadata.at("format"), "pt");
+  CHECK(array_equal(dict.at("a"), a).item<bool>());
+  CHECK(array_equal(dict.at("b"), b).item<bool>());
+  CHECK(array_equal(dict.at("c"), c).item<bool>());
+
+  // Filter tensors and split across two ranks
+  SafetensorsShardSpec spec;
+  spec.filter = [](const std::string& name) { return name != "c"; };
+  spec.split_axis = [](const std::string& name, const std::vector<int>&) {
+    return name == "a" ? 0 : 1;
+  };
+  spec.rank = 1;
+  spec.world_size = 2;
+  std::tie(dict, metadata) = load_safetensors_sharded(index_path, spec);
+  CHECK_EQ(dict.size(), 2);
+  CHECK(array_equal(dict.at("a"), slice(a, {2, 0}, {4, 6})).item<bool>());
+  CHECK(array_equal(dict.at("b"), slice(b, {0, 4}, {1, 8})).item<bool>());
+
+  // Splits along later axes
+  spec.split_axis = [](const std::string&, const std::vector<int>&) {
+    return 1;
+  };
+  spec.rank = 0;
+  std::tie(dict, metadata) = load_safetensors_sharded(index_path, spec);
+  CHECK(array_equal(dict.at("a"), slice(a, {0, 0}, {4, 3})).item<bool>());
+
+  spec.world_size = 5;
+  CHECK_THROWS_AS(
+      load_safetensors_sharded(index_path, spec), std::invalid_argument);
+}
+
+TEST_CASE("test memory mapped safetensors") {
+  std::string file_path = get_temp_file("test_mmap.safetensors");
+  auto map = std::unordered_map<std::string, array>();
+  map.insert({"a", arange(1000, float32)});
+  map.insert({"b", array({1, 2, 3}, int8)});
+  map.insert({"c", reshape(arange(24, int32), {2, 3, 4})});
+  save_safetensors(file_path, map);
+
+  {
+    auto [dict, metadata] = load_safetensors(file_path);
+    for (auto& [k, v] : map) {
+      CHECK_EQ(dict.at(k).shape(), v.shape());
+      CHECK(array_equal(dict.at(k), v).item<bool>());
+    }
+
+    // Writes to arrays backed by the mapping don't reach the file
+    auto a = dict.at("a");
+    dict.clear();
+    auto b = add(a, array(1.0f));
+    a = array(0.0f);
+    CHECK(array_equal(b, arange(1, 1001, float32)).item<bool>());
+  }
+
+  // Loaded arrays stay valid after the file is unlinked
+  auto [dict, metadata] = load_safetensors(file_path);
+  auto c = dict.at("c");
+  std::filesystem::remove(file_path);
+  CHECK(array_equal(c, reshape(arange(24, int32), {2, 3, 4})).item<bool>());
+  CHECK(array_equal(dict.at("a"), map.at("a")).item<bool>());
+
+  // Arrays backed by a file can be saved back to it
+  save_safetensors(file_path, {{"c", c}, {"d", add(c, array(1))}});
+  auto [reloaded, _] = load_safetensors(file_path);
+  CHECK(array_equal(reloaded.at("c"), c).item<bool>());
+  CHECK(array_equal(reloaded.at("d"), add(c, array(1))).item<bool>());
+}
+
+TEST_CASE("test parallel reads") {
+  std::string file_path = get_temp_file("test_parallel_read.safetensors");
+  auto map = std::unordered_map<std::string, array>();
+  // Large enough to be read in several chunks
+  map.insert({"large", arange(3 << 20, float32)});
+  for (int i = 0; i < 16; i++) {
+    map.insert({"small_" + std::to_string(i), full({10}, i, int32)});
+  }
+  save_safetensors(file_path, map);
+
+  // Positional reads don't depend on or change the read position
+  for (auto reader : std::vector<std::shared_ptr<io::Reader>>{
+           std::make_shared<io::FileReader>(file_path),
+           io::open_file_reader(file_path)}) {
+    uint64_t header_len;
+    reader->read_at(reinterpret_cast<char*>(&header_len), 8, 0);
+    reader->seek(4);
+    uint64_t header_len_again;
+    reader->read_at(reinterpret_cast<char*>(&header_len_again), 8, 0);
+    CHECK_EQ(header_len, header_len_again);
+    CHECK_EQ(reader->tell(), 4);
+  }
+
+  auto [dict, metadata] = load_safetensors(
+      std::make_shared<io::FileReader>(file_path), Device::cpu);
+  std::vector<array> loaded;
+  for (auto& [k, v] : dict) {
+    loaded.push_back(v);
+  }
+  eval(loaded);
+  for (auto& [k, v] : map) {
+    CHECK(array_equal(dict.at(k), v).item<bool>());
+  }
+}
+
 TEST_CASE("test gguf") {
   std::string file_path = get_temp_file("test_arr.gguf");
   using dict = std::unordered_map<std::string, array>;
@@ -53,6 +201,8 @@ TEST_CASE("test gguf") {
     auto [loaded_weights, loaded_metadata] = load_gguf(file_path);
     CHECK_EQ(loaded_metadata.size(), 0);
     CHECK_EQ(loaded_weights.size(), 2);
+    // Tensors are only read when evaluated
+    CHECK_FALSE(loaded_weights.at("test").is_available());
     CHECK_EQ(loaded_weights.count("test"), 1);
     CHECK_EQ(loaded_weights.count("test2"), 1);
     for (auto [k, v] : loaded_weights) {
@@ -201,6 +351,123 @@ TEST_CASE("test gguf metadata") {
   }
 }
 
+TEST_CASE("test gguf k-quants") {
+  // A GGUF file with a Q4_K and a Q5_K tensor of 2 rows of one super-block
+  // of 256 weights each, written by hand as MLX doesn't save K-quants
+  std::string file_path = get_temp_file("test_k_quants.gguf");
+  constexpr uint32_t q4_k = 12;
+  constexpr uint32_t q5_k = 13;
+  constexpr int rows = 2;
+  std::mt19937 gen(42);
+  auto random_bytes = [&gen](size_t n) {
+    std::vector<uint8_t> bytes(n);
+    for (auto& b : bytes) {
+      b = gen() & 0xFF;
+    }
+    return bytes;
+  };
+  // Scales and mins which are exact in float16
+  auto put_d_dmin = [](std::vector<uint8_t>& bytes, size_t offset, int i) {
+    float16_t d = 0.5f * (i + 1);
+    float16_t dmin = 0.25f;
+    std::memcpy(bytes.data() + offset, &d, 2);
+    std::memcpy(bytes.data() + offset + 2, &dmin, 2);
+  };
+  auto q4_data = random_bytes(rows * 144);
+  auto q5_data = random_bytes(rows * 176);
+  for (int i = 0; i < rows; i++) {
+    put_d_dmin(q4_data, i * 144, i);
+    put_d_dmin(q5_data, i * 176, i);
+  }
+
+  // The reference dequantization of GGML
+  auto scale_min = [](int j, const uint8_t* q, float d, float dmin) {
+    int sc = j < 4 ? q[j] & 63 : (q[j + 4] & 0xF) | ((q[j - 4] >> 6) << 4);
+    int m = j < 4 ? q[j + 4] & 63 : (q[j + 4] >> 4) | ((q[j] >> 6) << 4);
+    return std::make_pair(d * sc, dmin * m);
+  };
+  auto dequantize_k = [&scale_min](const uint8_t* x, bool q5) {
+    std::vector<float> y;
+    float d = *reinterpret_cast<const float16_t*>(x);
+    float dmin = *reinterpret_cast<const float16_t*>(x + 2);
+    const uint8_t* scales = x + 4;
+    const uint8_t* qh = x + 16;
+    const uint8_t* ql = q5 ? x + 48 : x + 16;
+    for (int is = 0, u = 1; is < 8; is += 2, ql += 32, u <<= 2) {
+      auto [d1, m1] = scale_min(is, scales, d, dmin);
+      auto [d2, m2] = scale_min(is + 1, scales, d, dmin);
+      for (int l = 0; l < 32; l++) {
+        int h = q5 && (qh[l] & u) ? 16 : 0;
+        y.push_back(d1 * ((ql[l] & 0xF) + h) - m1);
+      }
+      for (int l = 0; l < 32; l++) {
+        int h = q5 && (qh[l] & (u << 1)) ? 16 : 0;
+        y.push_back(d2 * ((ql[l] >> 4) + h) - m2);
+      }
+    }
+    return y;
+  };
+  auto reference = [&dequantize_k](const std::vector<uint8_t>& data, bool q5) {
+    std::vector<float> y;
+    size_t block_size = data.size() / rows;
+    for (int i = 0; i < rows; i++) {
+      auto row = dequantize_k(data.data() + i * block_size, q5);
+      y.insert(y.end(), row.begin(), row.end());
+    }
+    return array(y.begin(), {rows, 256});
+  };
+
+  {
+    std::ofstream f(file_path, std::ios::binary);
+    auto put = [&f](auto x) {
+      f.write(reinterpret_cast<const char*>(&x), sizeof(x));
+    };
+    auto put_tensor_info =
+        [&](const std::string& name, uint32_t type, uint64_t offset) {
+          put(uint64_t(name.size()));
+          f.write(name.data(), name.size());
+          put(uint32_t(2));
+          put(uint64_t(256));
+          put(uint64_t(rows));
+          put(type);
+          put(offset);
+        };
+    f.write("GGUF", 4);
+    put(uint32_t(3));
+    put(uint64_t(2));
+    put(uint64_t(0));
+    put_tensor_info("q4.weight", q4_k, 0);
+    put_tensor_info("q5.weight", q5_k, q4_data.size());
+    // The tensor data starts at the default alignment of 32 bytes
+    while (f.tellp() % 32 != 0) {
+      put(uint8_t(0));
+    }
+    f.write(reinterpret_cast<const char*>(q4_data.data()), q4_data.size());
+    f.write(reinterpret_cast<const char*>(q5_data.data()), q5_data.size());
+  }
+
+  auto [weights, metadata] = load_gguf(file_path);
+  CHECK_EQ(weights.size(), 6);
+
+  // Q4_K loads as 4 bit groups of 32
+  auto& w4 = weights.at("q4.weight");
+  CHECK_EQ(w4.shape(), std::vector<int>{rows, 32});
+  CHECK_EQ(weights.at("q4.scales").shape(), std::vector<int>{rows, 8});
+  auto y4 = dequantize(
+      w4, weights.at("q4.scales"), weights.at("q4.biases"), 32, 4);
+  CHECK(allclose(astype(y4, float32), reference(q4_data, false), 1e-3, 1e-3)
+            .item<bool>());
+
+  // Q5_K loads as 8 bit groups of 32
+  auto& w5 = weights.at("q5.weight");
+  CHECK_EQ(w5.shape(), std::vector<int>{rows, 64});
+  CHECK_EQ(weights.at("q5.biases").shape(), std::vector<int>{rows, 8});
+  auto y5 = dequantize(
+      w5, weights.at("q5.scales"), weights.at("q5.biases"), 32, 8);
+  CHECK(allclose(astype(y5, float32), reference(q5_data, true), 1e-3, 1e-3)
+            .item<bool>());
+}
+
 TEST_CASE("test single array serialization") {
   // Basic test
   {
@@ -268,3 +535,130 @@ TEST_CASE("test single array serialization") {
     CHECK(array_equal(a, b).item<bool>());
   }
 }
+
+TEST_CASE("test load big endian npy") {
+  std::string file_path = get_temp_file("test_big_endian.npy");
+  // Large enough to be read and swapped in several chunks
+  int n = 3 << 20;
+  std::string header =
+      "{'descr': '>i4', 'fortran_order': False, 'shape': (" +
+      std::to_string(n) + ",), }";
+  header.resize(117, ' ');
+  header += '\n';
+  {
+    std::ofstream os(file_path, std::ios::binary);
+    os.write("\x93NUMPY\x01\x00", 8);
+    uint16_t header_len = header.size();
+    os.write(reinterpret_cast<char*>(&header_len), 2);
+    os.write(header.data(), header.size());
+    for (uint32_t i = 0; i < n; i++) {
+      uint32_t v = __builtin_bswap32(i);
+      os.write(reinterpret_cast<char*>(&v), 4);
+    }
+  }
+  auto a = load(file_path);
+  CHECK_EQ(a.dtype(), int32);
+  CHECK(array_equal(a, arange(n, int32)).item<bool>());
+}
+
+TEST_CASE("test load_npz") {
+  std::string file_path = get_temp_file("test_load.npz");
+  std::unordered_map<std::string, array> arrays = {
+      {"a", reshape(arange(12, float32), {3, 4})},
+      {"b", array({1, 2, 3}, int16)}};
+
+  // Write a zip archive of uncompressed .npy members, the CRCs aren't
+  // checked by the reader
+  {
+    auto append_le = [](std::string& out, uint64_t v, int n_bytes) {
+      for (int i = 0; i < n_bytes; i++) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+      }
+    };
+    std::string zip;
+    std::string central;
+    int n_entries = 0;
+    for (auto& [key, arr] : arrays) {
+      std::string npy_path = get_temp_file("test_load_member.npy");
+      save(npy_path, arr);
+      std::ifstream is(npy_path, std::ios::binary);
+      std::string data(
+          (std::istreambuf_iterator<char>(is)),
+          std::istreambuf_iterator<char>());
+      auto name = key + ".npy";
+
+      size_t local_offset = zip.size();
+      append_le(zip, 0x04034b50, 4);
+      append_le(zip, 20, 2); // version
+      append_le(zip, 0, 2); // flags
+      append_le(zip, 0, 2); // stored
+      append_le(zip, 0, 4); // time and date
+      append_le(zip, 0, 4); // crc
+      append_le(zip, data.size(), 4);
+      append_le(zip, data.size(), 4);
+      append_le(zip, name.size(), 2);
+      append_le(zip, 0, 2); // extra
+      zip += name + data;
+
+      append_le(central, 0x02014b50, 4);
+      append_le(central, 20, 2);
+      append_le(central, 20, 2);
+      append_le(central, 0, 2);
+      append_le(central, 0, 2);
+      append_le(central, 0, 4);
+      append_le(central, 0, 4);
+      append_le(central, data.size(), 4);
+      append_le(central, data.size(), 4);
+      append_le(central, name.size(), 2);
+      append_le(central, 0, 2); // extra
+      append_le(central, 0, 2); // comment
+      append_le(central, 0, 2); // disk
+      append_le(central, 0, 2); // internal attributes
+      append_le(central, 0, 4); // external attributes
+      append_le(central, local_offset, 4);
+      central += name;
+      n_entries++;
+    }
+    size_t cd_offset = zip.size();
+    zip += central;
+    append_le(zip, 0x06054b50, 4);
+    append_le(zip, 0, 4); // disks
+    append_le(zip, n_entries, 2);
+    append_le(zip, n_entries, 2);
+    append_le(zip, central.size(), 4);
+    append_le(zip, cd_offset, 4);
+    append_le(zip, 0, 2); // comment
+    std::ofstream os(file_path, std::ios::binary);
+    os.write(zip.data(), zip.size());
+  }
+
+  auto loaded = load_npz(file_path);
+  CHECK_EQ(loaded.size(), 2);
+  for (auto& [key, arr] : arrays) {
+    CHECK_EQ(loaded.at(key).dtype(), arr.dtype());
+    CHECK(array_equal(loaded.at(key), arr).item<bool>());
+  }
+
+  CHECK_THROWS(load_npz(get_temp_file("test_big_endian.npy")));
+}
+
+TEST_CASE("test savez") {
+  std::unordered_map<std::string, array> arrays = {
+      {"a", reshape(arange(12, float32), {3, 4})},
+      {"b", transpose(reshape(arange(6, int16), {2, 3}))},
+      {"c", zeros({1 << 16}, uint8)}};
+
+  for (bool compressed : {false, true}) {
+    if (compressed && !io::detail::deflate_available()) {
+      continue;
+    }
+    std::string file_path = get_temp_file("test_savez");
+    savez(file_path, arrays, compressed);
+    auto loaded = load_npz(file_path + ".npz");
+    CHECK_EQ(loaded.size(), 3);
+    for (auto& [key, arr] : arrays) {
+      CHECK_EQ(loaded.at(key).shape(), arr.shape());
+      CHECK(array_equal(loaded.at(key), arr).item<bool>());
+    }
+  }
+}
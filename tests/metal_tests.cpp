@@ -516,4 +516,35 @@ TEST_CASE("test metal memory info") {
 
   metal::clear_cache();
   CHECK_EQ(metal::get_cache_memory(), 0);
+
+  // Cache statistics
+  {
+    metal::reset_cache_stats();
+    for (int i = 0; i < 2; i++) {
+      auto a = zeros({4096});
+      eval(a);
+      synchronize();
+    }
+    auto stats = metal::get_cache_stats();
+    CHECK(stats["hits"] >= 1);
+    CHECK(stats["misses"] >= 1);
+
+    // A buffer much larger than the request is not reused
+    metal::clear_cache();
+    {
+      auto a = zeros({1 << 20});
+      eval(a);
+      synchronize();
+    }
+    metal::reset_cache_stats();
+    {
+      auto a = zeros({1 << 18});
+      eval(a);
+      synchronize();
+    }
+    CHECK_EQ(metal::get_cache_stats()["hits"], 0);
+
+    metal::reset_cache_stats();
+    CHECK_EQ(metal::get_cache_stats()["misses"], 0);
+  }
 }
@@ -422,6 +422,68 @@ TEST_CASE("test transpose") {
   CHECK(x.flags().row_contiguous);
 }
 
+TEST_CASE("test strided copies") {
+  int n_threads = cpu_threads();
+  set_cpu_threads(4);
+
+  // Large and ragged transposes take the tiled path across several threads
+  for (auto [rows, cols] : std::vector<std::pair<int, int>>{
+           {300, 257}, {33, 2000}, {2000, 33}, {5, 7}}) {
+    auto x = reshape(arange(rows * cols, int32), {rows, cols});
+    std::vector<int> expected(rows * cols);
+    for (int i = 0; i < rows; i++) {
+      for (int j = 0; j < cols; j++) {
+        expected[j * rows + i] = i * cols + j;
+      }
+    }
+    auto y = flatten(transpose(x));
+    CHECK(array_equal(y, array(expected.begin(), {rows * cols})).item<bool>());
+    y = flatten(astype(transpose(x), float32));
+    CHECK(array_equal(y, array(expected.begin(), {rows * cols})).item<bool>());
+  }
+
+  // Batched transposes with size one and strided axes
+  auto x = reshape(arange(4 * 1 * 40 * 50, int32), {4, 1, 40, 50});
+  auto y = flatten(transpose(x, {0, 3, 1, 2}));
+  std::vector<int> expected;
+  for (int b = 0; b < 4; b++) {
+    for (int j = 0; j < 50; j++) {
+      for (int i = 0; i < 40; i++) {
+        expected.push_back(b * 2000 + i * 50 + j);
+      }
+    }
+  }
+  CHECK(array_equal(y, array(expected.begin(), {8000})).item<bool>());
+
+  y = slice(
+      transpose(x, {2, 1, 0, 3}), {0, 0, 0, 1}, {40, 1, 4, 50}, {3, 1, 1, 2});
+  y = flatten(y);
+  expected.clear();
+  for (int i = 0; i < 40; i += 3) {
+    for (int b = 0; b < 4; b++) {
+      for (int j = 1; j < 50; j += 2) {
+        expected.push_back(b * 2000 + i * 50 + j);
+      }
+    }
+  }
+  CHECK(array_equal(y, array(expected.begin(), {int(expected.size())}))
+            .item<bool>());
+
+  // Strided source and destination
+  auto out = zeros({64, 80}, int32);
+  auto upd = transpose(reshape(arange(40 * 32, int32), {40, 32}));
+  y = slice_update(out, upd, {0, 0}, {64, 80}, {2, 2});
+  expected.assign(64 * 80, 0);
+  for (int i = 0; i < 32; i++) {
+    for (int j = 0; j < 40; j++) {
+      expected[2 * i * 80 + 2 * j] = j * 32 + i;
+    }
+  }
+  CHECK(array_equal(y, array(expected.begin(), {64, 80})).item<bool>());
+
+  set_cpu_threads(n_threads);
+}
+
 TEST_CASE("test comparison ops") {
   // Empty array
   {
@@ -887,6 +949,30 @@ TEST_CASE("test reduction ops") {
         {std::log(std::exp(nums[0]) + std::exp(nums[1])),
          std::log(std::exp(nums[2]) + std::exp(nums[3]))});
     CHECK(allclose(logsumexp(x, 1), expected).item<bool>());
+
+    // Long rows, rows starting with masked values and trailing axes
+    x = random::normal({3, 2, 700}, random::key(0));
+    x = concatenate({full({3, 2, 300}, -inf), x}, 2);
+    auto composed = [](const array& x, const std::vector<int>& axes) {
+      auto maxval = max(x, axes, true);
+      auto out = log(sum(exp(x - maxval), axes));
+      maxval = squeeze(maxval, axes);
+      return where(isinf(maxval), maxval, add(maxval, out));
+    };
+    CHECK(allclose(logsumexp(x, -1), composed(x, {2}), 1e-5, 1e-5)
+              .item<bool>());
+    CHECK(allclose(logsumexp(x, {1, 2}), composed(x, {1, 2}), 1e-5, 1e-5)
+              .item<bool>());
+    CHECK(allclose(logsumexp(x, 1), composed(x, {1}), 1e-5, 1e-5)
+              .item<bool>());
+    CHECK_EQ(logsumexp(x, {1, 2}, true).shape(), std::vector<int>{3, 1, 1});
+    auto xt = transpose(x, {2, 0, 1});
+    CHECK(allclose(logsumexp(xt, {1, 2}), composed(xt, {1, 2}), 1e-5, 1e-5)
+              .item<bool>());
+    auto xh = astype(x, float16);
+    CHECK_EQ(logsumexp(xh, -1).dtype(), float16);
+    CHECK(allclose(logsumexp(xh, -1), composed(xh, {2}), 1e-2, 1e-2)
+              .item<bool>());
   }
 
   // Test softmax
@@ -897,6 +983,47 @@ TEST_CASE("test reduction ops") {
     CHECK(array_equal(y, softmax(x, -1)).item<bool>());
     CHECK(array_equal(y, softmax(x, std::vector<int>{-1})).item<bool>());
     CHECK(array_equal(y, softmax(x, std::vector<int>{0})).item<bool>());
+
+    // Rows longer than a chunk with masked and large values
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    x = multiply(random::normal({5, 1000}, random::key(1)), array(20.0f));
+    x = concatenate({full({5, 300}, -inf), x}, 1);
+    auto ex = exp(x - max(x, -1, true));
+    auto expected = ex / sum(ex, -1, true);
+    CHECK(allclose(softmax(x, -1), expected, 1e-5, 1e-7).item<bool>());
+    auto xh = astype(x, bfloat16);
+    ex = exp(astype(xh, float32) - max(xh, -1, true));
+    expected = ex / sum(ex, -1, true);
+    CHECK(allclose(softmax(xh, -1), expected, 1e-2, 1e-3).item<bool>());
+    CHECK(allclose(softmax(xh, -1, true), expected, 1e-2, 1e-3).item<bool>());
+
+    x = array({-inf, -inf, 1.0f, 1.0f}, {2, 2});
+    y = softmax(x, -1);
+    CHECK_EQ(sum(isnan(y)).item<int>(), 2);
+    CHECK(array_equal(take(y, array({2, 3})), array({0.5f, 0.5f}))
+              .item<bool>());
+  }
+
+  // Test large reductions which are split across threads
+  {
+    auto x = ones({1 << 20}, float32);
+    CHECK_EQ(sum(x).item<float>(), 1 << 20);
+    CHECK_EQ(sum(astype(x, int32)).item<int>(), 1 << 20);
+    CHECK_EQ(max(multiply(x, arange(1 << 20))).item<float>(), (1 << 20) - 1);
+
+    x = reshape(x, {1 << 10, 1 << 10});
+    CHECK(array_equal(sum(x, 0), full({1 << 10}, 1024.0f)).item<bool>());
+    CHECK(array_equal(sum(x, 1), full({1 << 10}, 1024.0f)).item<bool>());
+    CHECK(array_equal(sum(transpose(x), 1), full({1 << 10}, 1024.0f))
+              .item<bool>());
+    CHECK(all(x).item<bool>());
+    CHECK_FALSE(any(logical_not(x)).item<bool>());
+
+    // Half precision sums accumulate in float32
+    x = full({1 << 14}, 0.1f, float16);
+    CHECK_EQ(sum(x).item<float16_t>(), doctest::Approx(1638.4).epsilon(1e-3));
+    x = full({1 << 14}, 1.0f, bfloat16);
+    CHECK_EQ(sum(x).item<bfloat16_t>(), 16384.0f);
   }
 }
 
@@ -1420,6 +1547,64 @@ TEST_CASE("test error functions") {
   }
 }
 
+TEST_CASE("test approximate transcendental functions") {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  auto cpu = Device::cpu;
+
+  // Special values
+  auto x = array({-inf, inf, nan, -100.0f, 88.5f, 89.0f});
+  auto y = exp(x, cpu);
+  eval(y);
+  CHECK_EQ(y.data<float>()[0], 0.0f);
+  CHECK_EQ(y.data<float>()[1], inf);
+  CHECK(std::isnan(y.data<float>()[2]));
+  CHECK_EQ(y.data<float>()[3], doctest::Approx(std::exp(-100.0f)));
+  CHECK_EQ(y.data<float>()[4], doctest::Approx(std::exp(88.5f)));
+  CHECK_EQ(y.data<float>()[5], inf);
+
+  x = array({0.0f, -0.0f, -1.0f, inf, nan, 1e-40f});
+  y = log(x, cpu);
+  eval(y);
+  CHECK_EQ(y.data<float>()[0], -inf);
+  CHECK_EQ(y.data<float>()[1], -inf);
+  CHECK(std::isnan(y.data<float>()[2]));
+  CHECK_EQ(y.data<float>()[3], inf);
+  CHECK(std::isnan(y.data<float>()[4]));
+  CHECK_EQ(y.data<float>()[5], doctest::Approx(std::log(1e-40f)));
+
+  x = array({-inf, inf, nan, -0.0f});
+  y = tanh(x, cpu);
+  eval(y);
+  CHECK_EQ(y.data<float>()[0], -1.0f);
+  CHECK_EQ(y.data<float>()[1], 1.0f);
+  CHECK(std::isnan(y.data<float>()[2]));
+  CHECK(std::signbit(y.data<float>()[3]));
+
+  // Within a few ulp of libm over a large contiguous input
+  int n = 100003;
+  x = linspace(-30.0, 30.0, n);
+  auto pos = linspace(1e-6, 1e6, n);
+  eval(x, pos);
+  auto close_to = [n](const array& out, const array& in, auto f) {
+    eval(out);
+    for (int i = 0; i < n; i++) {
+      double expected = f(static_cast<double>(in.data<float>()[i]));
+      double err = std::abs(out.data<float>()[i] - expected);
+      if (err > 4e-7 * std::abs(expected) + 1e-37) {
+        return false;
+      }
+    }
+    return true;
+  };
+  auto sig = [](double v) { return 1.0 / (1.0 + std::exp(-v)); };
+  CHECK(close_to(exp(x, cpu), x, [](double v) { return std::exp(v); }));
+  CHECK(close_to(log(pos, cpu), pos, [](double v) { return std::log(v); }));
+  CHECK(close_to(tanh(x, cpu), x, [](double v) { return std::tanh(v); }));
+  CHECK(close_to(sigmoid(x, cpu), x, sig));
+  CHECK(close_to(erf(x, cpu), x, [](double v) { return std::erf(v); }));
+}
+
 TEST_CASE("test arithmetic binary ops") {
   array x(1.0);
   array y(1.0);
@@ -2144,6 +2329,88 @@ TEST_CASE("test scatter types") {
   }
 }
 
+TEST_CASE("test parallel gather and scatter") {
+  int n_threads = cpu_threads();
+  set_cpu_threads(4);
+
+  // Embedding style lookups with negative indices
+  int vocab = 1000, dim = 64, n = 5000;
+  auto table = reshape(arange(vocab * dim, int32), {vocab, dim});
+  std::vector<int> idx(n);
+  for (int i = 0; i < n; i++) {
+    idx[i] = (i * 7919) % vocab - (i % 3 == 0 ? vocab : 0);
+  }
+  auto ids = array(idx.begin(), {n});
+  std::vector<int> expected(n * dim);
+  for (int i = 0; i < n; i++) {
+    int row = idx[i] < 0 ? idx[i] + vocab : idx[i];
+    for (int j = 0; j < dim; j++) {
+      expected[i * dim + j] = row * dim + j;
+    }
+  }
+  auto out = take(table, ids, 0);
+  CHECK(array_equal(out, array(expected.begin(), {n, dim})).item<bool>());
+
+  // Non contiguous slices
+  out = take(transpose(table), ids, 1);
+  CHECK(array_equal(out, transpose(array(expected.begin(), {n, dim})))
+            .item<bool>());
+
+  // Scatter add with many duplicate indices, unsorted and sorted
+  int size = 100;
+  n = 100000;
+  for (bool sorted : {false, true}) {
+    std::vector<int> sidx(n);
+    std::vector<int> sexp(size, 0);
+    for (int i = 0; i < n; i++) {
+      sidx[i] = sorted ? i * size / n : (i * 7) % size;
+      sexp[sidx[i]] += i;
+      sidx[i] -= (i % 2) * size;
+    }
+    auto inds = array(sidx.begin(), {n});
+    auto updates = reshape(arange(n, int32), {n, 1});
+    out = scatter_add(zeros({size}, int32), inds, updates, 0);
+    CHECK(array_equal(out, array(sexp.begin(), {size})).item<bool>());
+
+    // The last update wins for duplicate indices
+    std::vector<int> last(size);
+    for (int i = 0; i < n; i++) {
+      last[sidx[i] < 0 ? sidx[i] + size : sidx[i]] = i;
+    }
+    out = scatter(zeros({size}, int32), inds, updates, 0);
+    CHECK(array_equal(out, array(last.begin(), {size})).item<bool>());
+
+    out = scatter_max(zeros({size}, int32), inds, updates, 0);
+    CHECK(array_equal(out, array(last.begin(), {size})).item<bool>());
+  }
+
+  // Embedding gradients, with single and multi row slices
+  for (int rows : {1, 64}) {
+    int cols = 16;
+    n = 2000;
+    std::vector<int> gidx(n);
+    std::vector<int> gexp(size * rows * cols, 0);
+    for (int i = 0; i < n; i++) {
+      gidx[i] = (i * 13) % size;
+      for (int j = 0; j < rows * cols; j++) {
+        gexp[gidx[i] * rows * cols + j] += j;
+      }
+    }
+    auto updates = broadcast_to(
+        reshape(arange(rows * cols, int32), {1, 1, rows, cols}),
+        {n, 1, rows, cols});
+    out = scatter_add(
+        zeros({size, rows, cols}, int32),
+        array(gidx.begin(), {n}),
+        updates,
+        0);
+    CHECK(array_equal(out, array(gexp.begin(), {size, rows, cols}))
+              .item<bool>());
+  }
+
+  set_cpu_threads(n_threads);
+}
+
 TEST_CASE("test complex ops") {
   //  Creation ops
   {
@@ -2311,6 +2578,148 @@ TEST_CASE("test scan op") {
   CHECK(array_equal(y, expected).item<bool>());
 }
 
+TEST_CASE("test scan long and batched rows") {
+  // Reference scan of a contiguous [rows, n] buffer along the last axis
+  auto reference = [](const std::vector<int>& x,
+                      int rows,
+                      int n,
+                      bool reverse,
+                      bool inclusive,
+                      auto op,
+                      int init) {
+    std::vector<int> out(x.size());
+    for (int r = 0; r < rows; r++) {
+      int acc = init;
+      for (int i = 0; i < n; i++) {
+        int j = r * n + (reverse ? n - 1 - i : i);
+        if (inclusive) {
+          acc = op(acc, x[j]);
+          out[j] = acc;
+        } else {
+          out[j] = acc;
+          acc = op(acc, x[j]);
+        }
+      }
+    }
+    return out;
+  };
+  auto add = [](int a, int b) { return a + b; };
+  auto mul = [](int a, int b) { return a * b; };
+  auto max = [](int a, int b) { return std::max(a, b); };
+
+  int n_threads = cpu_threads();
+  set_cpu_threads(4);
+  for (auto [rows, n] : std::vector<std::pair<int, int>>{
+           {1, 100003}, {2, 70001}, {37, 5}, {1000, 17}, {9, 1}}) {
+    std::vector<int> data(rows * n);
+    std::vector<int> signs(rows * n);
+    for (int i = 0; i < rows * n; i++) {
+      data[i] = (i * 7919) % 13 - 6;
+      signs[i] = ((i * 31) % 7 == 0) ? -1 : 1;
+    }
+    auto x = array(data.begin(), {rows, n}, int32);
+    auto s = array(signs.begin(), {rows, n}, int32);
+    for (bool reverse : {false, true}) {
+      for (bool inclusive : {false, true}) {
+        auto expected =
+            reference(data, rows, n, reverse, inclusive, add, 0);
+        CHECK(array_equal(
+                  cumsum(x, 1, reverse, inclusive),
+                  array(expected.begin(), {rows, n}))
+                  .item<bool>());
+
+        // The same scans along a strided axis
+        expected = reference(data, rows, n, reverse, inclusive, add, 0);
+        CHECK(array_equal(
+                  cumsum(transpose(x), 0, reverse, inclusive),
+                  transpose(array(expected.begin(), {rows, n})))
+                  .item<bool>());
+
+        expected = reference(signs, rows, n, reverse, inclusive, mul, 1);
+        CHECK(array_equal(
+                  cumprod(s, 1, reverse, inclusive),
+                  array(expected.begin(), {rows, n}))
+                  .item<bool>());
+
+        expected = reference(
+            data,
+            rows,
+            n,
+            reverse,
+            inclusive,
+            max,
+            std::numeric_limits<int>::min());
+        CHECK(array_equal(
+                  cummax(x, 1, reverse, inclusive),
+                  array(expected.begin(), {rows, n}))
+                  .item<bool>());
+      }
+    }
+  }
+  set_cpu_threads(n_threads);
+}
+
+TEST_CASE("test segment reductions and scans") {
+  // Segments of 2, 0, 3 and 1 rows of 2 columns
+  auto x = array(
+      {1.0f, -2.0f, 3.0f, 4.0f, 0.5f, 1.0f,
+       -1.0f, 6.0f, 2.0f, 2.0f, 7.0f, 0.0f},
+      {6, 2});
+  auto offsets = array({0, 2, 2, 5, 6});
+
+  auto out = segment_sum(x, offsets);
+  auto expected =
+      array({4.0f, 2.0f, 0.0f, 0.0f, 1.5f, 9.0f, 7.0f, 0.0f}, {4, 2});
+  CHECK(array_equal(out, expected).item<bool>());
+
+  out = segment_mean(x, offsets);
+  expected = array({2.0f, 1.0f, 0.0f, 0.0f, 0.5f, 3.0f, 7.0f, 0.0f}, {4, 2});
+  CHECK(allclose(out, expected).item<bool>());
+
+  out = take(segment_max(x, offsets), array({0, 2, 3}), 0);
+  expected = array({3.0f, 4.0f, 2.0f, 6.0f, 7.0f, 0.0f}, {3, 2});
+  CHECK(array_equal(out, expected).item<bool>());
+
+  out = take(segment_min(x, offsets), array({0, 2, 3}), 0);
+  expected = array({1.0f, -2.0f, -1.0f, 1.0f, 7.0f, 0.0f}, {3, 2});
+  CHECK(array_equal(out, expected).item<bool>());
+
+  out = segment_cumsum(x, offsets);
+  expected = array(
+      {1.0f, -2.0f, 4.0f, 2.0f, 0.5f, 1.0f,
+       -0.5f, 7.0f, 1.5f, 9.0f, 7.0f, 0.0f},
+      {6, 2});
+  CHECK(array_equal(out, expected).item<bool>());
+
+  out = segment_cumsum(x, offsets, true, false);
+  expected = array(
+      {3.0f, 4.0f, 0.0f, 0.0f, 1.0f, 8.0f, 2.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+      {6, 2});
+  CHECK(array_equal(out, expected).item<bool>());
+
+  // Gradients of the reductions and scans
+  auto g = grad([&](array a) { return sum(segment_sum(a, offsets)); })(x);
+  CHECK(array_equal(g, ones_like(x)).item<bool>());
+  g = grad([&](array a) { return sum(segment_max(a, offsets)); })(x);
+  expected = array(
+      {0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f},
+      {6, 2});
+  CHECK(array_equal(g, expected).item<bool>());
+  g = grad([&](array a) { return sum(segment_cumsum(a, offsets)); })(x);
+  expected = array(
+      {2.0f, 2.0f, 1.0f, 1.0f, 3.0f, 3.0f, 2.0f, 2.0f, 1.0f, 1.0f, 1.0f, 1.0f},
+      {6, 2});
+  CHECK(array_equal(g, expected).item<bool>());
+
+  // Vmap over the columns
+  auto fn = [&](array a) { return segment_sum(a, offsets); };
+  out = vmap(fn, 1, 1)(x);
+  CHECK(array_equal(out, segment_sum(x, offsets)).item<bool>());
+
+  CHECK_THROWS(segment_sum(array(1.0f), offsets));
+  CHECK_THROWS(segment_sum(x, array({0.0f, 6.0f})));
+}
+
 TEST_CASE("test pad") {
   auto x = zeros({1, 2, 3});
   CHECK_EQ(pad(x, 1).shape(), std::vector<int>{3, 4, 5});
@@ -2619,10 +3028,9 @@ TEST_CASE("test quantize dequantize") {
   auto x2 = expand_dims(arange(0, 512, float32), 0);
   auto x = x1 * x2;
 
-  for (int i = 2; i <= 8; i *= 2) {
-    int el_per_int = 32 / i;
+  for (int i : {2, 3, 4, 6, 8}) {
     auto [x_q, scales, biases] = quantize(x, 128, i);
-    CHECK_EQ(x_q.shape(), std::vector<int>{128, 512 / el_per_int});
+    CHECK_EQ(x_q.shape(), std::vector<int>{128, 512 * i / 32});
     CHECK_EQ(scales.shape(), std::vector<int>{128, 4});
     CHECK_EQ(biases.shape(), std::vector<int>{128, 4});
 
@@ -3216,6 +3624,85 @@ TEST_CASE("test topk") {
   }
 }
 
+TEST_CASE("test sort and argsort") {
+  // Checks that idx sorts x along axis 1 and keeps ties in index order
+  auto check_argsort = [](const array& x, const array& idx) {
+    int n = x.shape(1);
+    auto s = take_along_axis(x, idx, 1);
+    auto lo = slice(s, {0, 0}, {x.shape(0), n - 1});
+    auto hi = slice(s, {0, 1}, {x.shape(0), n});
+    auto idx_lo = slice(idx, {0, 0}, {x.shape(0), n - 1});
+    auto idx_hi = slice(idx, {0, 1}, {x.shape(0), n});
+    auto ordered = logical_or(
+        greater(hi, lo), logical_and(equal(hi, lo), greater(idx_hi, idx_lo)));
+    CHECK(all(ordered).item<bool>());
+  };
+
+  // Short rows are sorted with comparisons, long ones with a radix sort
+  for (int n : {50, 1000}) {
+    for (auto t : {int32, uint8, int64, float32, float16, bfloat16}) {
+      auto x = astype(random::randint(-20, 20, {5, n}), t);
+      if (t == uint8) {
+        x = astype(random::randint(0, 40, {5, n}), t);
+      }
+      auto idx = argsort(x, 1);
+      check_argsort(x, idx);
+      CHECK(array_equal(sort(x, 1), take_along_axis(x, idx, 1)).item<bool>());
+
+      // Along a strided axis
+      auto xt = transpose(x);
+      idx = argsort(xt, 0);
+      check_argsort(x, transpose(idx));
+      CHECK(array_equal(sort(xt, 0), take_along_axis(xt, idx, 0))
+                .item<bool>());
+    }
+
+    // Negative zero, infinities and NaN, which goes last
+    float nan = std::numeric_limits<float>::quiet_NaN();
+    float inf = std::numeric_limits<float>::infinity();
+    auto x = concatenate(
+        {array({nan, 1.5f, -inf, -0.0f, inf, -2.0f}),
+         random::normal({n}),
+         array({0.0f, nan})});
+    auto s = sort(x);
+    CHECK(array_equal(s, take(x, argsort(x)), true).item<bool>());
+    CHECK(all(isnan(slice(s, {n + 6}, {n + 8}))).item<bool>());
+    CHECK_EQ(s.data<float>()[0], -inf);
+    CHECK_EQ(s.data<float>()[n + 5], inf);
+
+    // Both zeros are equal so they keep their order and their sign
+    auto z = where(random::bernoulli(0.5, {n}), array(0.0f), array(-0.0f));
+    CHECK(array_equal(argsort(z), arange(n, uint32)).item<bool>());
+    CHECK(array_equal(divide(array(1.0f), sort(z)), divide(array(1.0f), z))
+              .item<bool>());
+  }
+}
+
+TEST_CASE("test partition") {
+  auto x = random::normal({3, 500});
+  auto sorted = sort(x, 1);
+  for (int kth : {0, 5, 250, 480, 499}) {
+    auto p = partition(x, kth, 1);
+    auto pivot = slice(p, {0, kth}, {3, kth + 1});
+    CHECK(array_equal(pivot, slice(sorted, {0, kth}, {3, kth + 1}))
+              .item<bool>());
+    CHECK(all(less_equal(slice(p, {0, 0}, {3, kth}), pivot)).item<bool>());
+    CHECK(all(greater_equal(slice(p, {0, kth}, {3, 500}), pivot))
+              .item<bool>());
+
+    auto p_idx = take_along_axis(x, argpartition(x, kth, 1), 1);
+    CHECK(array_equal(sort(p_idx, 1), sorted).item<bool>());
+    CHECK(array_equal(slice(p_idx, {0, kth}, {3, kth + 1}), pivot)
+              .item<bool>());
+    CHECK(all(less_equal(slice(p_idx, {0, 0}, {3, kth}), pivot)).item<bool>());
+  }
+
+  // Small k selects with a heap
+  auto y = topk(x, 3, 1);
+  CHECK(array_equal(sort(y, 1), slice(sorted, {0, 497}, {3, 500}))
+            .item<bool>());
+}
+
 TEST_CASE("test meshgrid") {
   // Test default
   auto x = array({1, 2, 3}, {3});
@@ -3469,6 +3956,93 @@ TEST_CASE("test conv2d") {
   }
 }
 
+TEST_CASE("test conv strided, dilated and grouped") {
+  // Reference computed as a sum over kernel positions of strided slices of
+  // the padded input multiplied with the weights at that position
+  auto reference = [](const array& in,
+                      const array& wt,
+                      const std::vector<int>& stride,
+                      const std::vector<int>& padding,
+                      const std::vector<int>& dilation,
+                      int groups) {
+    int D = in.ndim() - 2;
+    int C = wt.shape(-1);
+    int O = wt.shape(0) / groups;
+    std::vector<int> axes(D);
+    std::iota(axes.begin(), axes.end(), 1);
+    auto x = pad(in, axes, padding, padding);
+
+    std::vector<int> o_dim(D);
+    int wt_spatial = 1;
+    for (int d = 0; d < D; d++) {
+      o_dim[d] =
+          (x.shape(d + 1) - dilation[d] * (wt.shape(d + 1) - 1) - 1) /
+              stride[d] +
+          1;
+      wt_spatial *= wt.shape(d + 1);
+    }
+
+    std::vector<array> outs;
+    for (int g = 0; g < groups; g++) {
+      auto out = zeros({1});
+      for (int k = 0; k < wt_spatial; k++) {
+        std::vector<int> start(D + 2, 0), stop(x.shape()), strides(D + 2, 1);
+        std::vector<int> w_start(D + 2, 0), w_stop(wt.shape());
+        w_start[0] = g * O;
+        w_stop[0] = (g + 1) * O;
+        start[D + 1] = g * C;
+        stop[D + 1] = (g + 1) * C;
+        for (int d = D - 1, r = k; d >= 0; d--) {
+          int kd = r % wt.shape(d + 1);
+          r /= wt.shape(d + 1);
+          start[d + 1] = kd * dilation[d];
+          stop[d + 1] = start[d + 1] + (o_dim[d] - 1) * stride[d] + 1;
+          strides[d + 1] = stride[d];
+          w_start[d + 1] = kd;
+          w_stop[d + 1] = kd + 1;
+        }
+        auto xs = slice(x, start, stop, strides);
+        auto ws = reshape(slice(wt, w_start, w_stop), {O, C});
+        out = add(out, matmul(xs, transpose(ws)));
+      }
+      outs.push_back(out);
+    }
+    return concatenate(outs, -1);
+  };
+
+  {
+    // Non contiguous input
+    auto in = transpose(random::normal({2, 6, 11, 10}), {0, 3, 2, 1});
+    auto wt = random::normal({8, 3, 2, 3});
+    auto out = conv2d(in, wt, {2, 1}, {1, 2}, {2, 1}, 2);
+    auto expected = reference(in, wt, {2, 1}, {1, 2}, {2, 1}, 2);
+    CHECK_EQ(out.shape(), expected.shape());
+    CHECK(allclose(out, expected, 1e-4, 1e-4).item<bool>());
+
+    out = conv2d(
+        astype(in, float16), astype(wt, float16), {2, 1}, {1, 2}, {2, 1}, 2);
+    CHECK_EQ(out.dtype(), float16);
+    CHECK(allclose(astype(out, float32), expected, 5e-2, 5e-2).item<bool>());
+
+    // Flipping the kernel is the same as reversing its spatial axes
+    auto wt_flipped = take(take(wt, array({2, 1, 0}), 1), array({1, 0}), 2);
+    out = conv_general(
+        in, wt, {2, 1}, {1, 2}, {1, 2}, {2, 1}, {1, 1}, 2, /* flip = */ true);
+    expected = conv2d(in, wt_flipped, {2, 1}, {1, 2}, {2, 1}, 2);
+    CHECK(allclose(out, expected, 1e-4, 1e-4).item<bool>());
+  }
+
+  {
+    // Larger than a single tile
+    auto in = random::normal({2, 9, 10, 11, 5});
+    auto wt = random::normal({7, 3, 2, 3, 5});
+    auto out = conv3d(in, wt, {1, 2, 1}, {1, 0, 2}, {2, 1, 1});
+    auto expected = reference(in, wt, {1, 2, 1}, {1, 0, 2}, {2, 1, 1}, 1);
+    CHECK_EQ(out.shape(), expected.shape());
+    CHECK(allclose(out, expected, 1e-4, 1e-4).item<bool>());
+  }
+}
+
 TEST_CASE("test trace") {
   auto in = eye(3);
   auto out = trace(in).item<float>();
@@ -3497,3 +4071,89 @@ TEST_CASE("test view") {
   auto out = view(in, int32);
   CHECK(array_equal(out, array({1, 0, 2, 0, 3, 0, 4, 0})).item<bool>());
 }
+
+TEST_CASE("test hadamard transform") {
+  auto x = array({1.0f, 2.0f, 3.0f, 4.0f});
+  auto out = hadamard_transform(x, 1.0f);
+  CHECK(array_equal(out, array({10.0f, -2.0f, -4.0f, 0.0f})).item<bool>());
+
+  // Orthonormal by default
+  out = hadamard_transform(x);
+  CHECK(allclose(out, array({5.0f, -1.0f, -2.0f, 0.0f})).item<bool>());
+  CHECK(allclose(hadamard_transform(out), x).item<bool>());
+
+  // Integers are transformed as float32
+  out = hadamard_transform(reshape(arange(8), {2, 4}), 1.0f);
+  CHECK_EQ(out.dtype(), float32);
+  auto expected =
+      array({6.0f, -2.0f, -4.0f, 0.0f, 22.0f, -2.0f, -4.0f, 0.0f}, {2, 4});
+  CHECK(array_equal(out, expected).item<bool>());
+
+  // The vjp is the transform of the cotangent
+  auto fn = [](const array& x) { return hadamard_transform(x, 2.0f); };
+  auto cotan = array({1.0f, 0.0f, -1.0f, 2.0f});
+  auto [_, vjp_out] = vjp(fn, x, cotan);
+  CHECK(allclose(vjp_out, hadamard_transform(cotan, 2.0f)).item<bool>());
+
+  CHECK_THROWS(hadamard_transform(array(1.0f)));
+  CHECK_THROWS(hadamard_transform(ones({2, 6})));
+}
+
+TEST_CASE("test fp8") {
+  auto codes = astype(arange(256), uint8);
+  for (auto format : {"e4m3", "e5m2"}) {
+    // Every code except the NaNs survives a round trip
+    auto x = from_fp8(codes, format, float32);
+    auto keep = logical_not(isnan(x));
+    auto round_trip = equal(to_fp8(x, format), codes);
+    CHECK(all(logical_or(round_trip, logical_not(keep))).item<bool>());
+  }
+
+  auto x = array({1.0f, -2.5f, 1000.0f});
+  CHECK(array_equal(to_fp8(x), array({0x38, 0xC2, 0x7E}, uint8))
+            .item<bool>());
+  CHECK(array_equal(to_fp8(x, "e5m2"), array({0x3C, 0xC1, 0x64}, uint8))
+            .item<bool>());
+  CHECK(isnan(from_fp8(array({0x7F}, uint8))).item<bool>());
+
+  CHECK_THROWS_AS(to_fp8(x, "e3m4"), std::invalid_argument);
+  CHECK_THROWS_AS(from_fp8(x), std::invalid_argument);
+}
+
+TEST_CASE("test fp8 matmul") {
+  // Few rows, a partial last tile of K and several tiles of the output
+  std::vector<std::tuple<int, int, int>> shapes = {
+      {1, 64, 32}, {4, 70, 100}, {40, 96, 64}, {130, 50, 77}};
+  for (auto [M, N, K] : shapes) {
+    for (auto format : {"e4m3", "e5m2"}) {
+      auto w = to_fp8(random::normal({N, K}) / 8, format);
+      auto x = random::normal({M, K});
+      auto out = fp8_matmul(x, w, format);
+      auto expected = matmul(x, transpose(from_fp8(w, format, float32)));
+      CHECK_EQ(out.shape(), std::vector<int>{M, N});
+      CHECK(allclose(out, expected, 1e-4, 1e-4).item<bool>());
+
+      auto out_half = fp8_matmul(astype(x, float16), w, format);
+      CHECK_EQ(out_half.dtype(), float16);
+      CHECK(allclose(astype(out_half, float32), expected, 5e-2, 5e-2)
+                .item<bool>());
+    }
+  }
+
+  // Leading dimensions and the vjp with respect to x
+  auto w = to_fp8(random::normal({32, 48}) / 8);
+  auto w_ref = from_fp8(w, "e4m3", float32);
+  auto x = random::normal({2, 3, 48});
+  auto fn = [&w](const array& x) { return fp8_matmul(x, w); };
+  auto cotan = random::normal({2, 3, 32});
+  auto [out, vjp_out] = vjp(fn, x, cotan);
+  CHECK_EQ(out.shape(), std::vector<int>{2, 3, 32});
+  CHECK(allclose(out, matmul(x, transpose(w_ref)), 1e-4, 1e-4).item<bool>());
+  CHECK(allclose(vjp_out, matmul(cotan, w_ref), 1e-4, 1e-4).item<bool>());
+
+  CHECK_THROWS_AS(fp8_matmul(x, astype(w, float32)), std::invalid_argument);
+  CHECK_THROWS_AS(fp8_matmul(ones({2, 40}), w), std::invalid_argument);
+  CHECK_THROWS_AS(fp8_matmul(x, w, "e3m4"), std::invalid_argument);
+  CHECK_THROWS_AS(
+      fp8_matmul(astype(x, int32), w, "e4m3"), std::invalid_argument);
+}
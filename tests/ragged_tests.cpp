@@ -0,0 +1,87 @@
+// Copyright © 2024 Apple Inc.
+
+#include "doctest/doctest.h"
+
+#include "mlx/mlx.h"
+
+using namespace mlx::core;
+
+TEST_CASE("test ragged conversions") {
+  auto a = reshape(arange(6, float32), {3, 2});
+  auto b = reshape(arange(6, 8, float32), {1, 2});
+  auto x = ragged::from_sequences({a, b});
+  CHECK_EQ(x.values.shape(), std::vector<int>{4, 2});
+  CHECK(array_equal(x.offsets, array({0, 3, 4})).item<bool>());
+  CHECK(array_equal(ragged::segment_ids(x.offsets, 4), array({0, 0, 0, 1}))
+            .item<bool>());
+
+  auto padded = ragged::to_padded(x, 3, -1.0f);
+  auto expected = array(
+      {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f,
+       6.0f, 7.0f, -1.0f, -1.0f, -1.0f, -1.0f},
+      {2, 3, 2});
+  CHECK(array_equal(padded, expected).item<bool>());
+
+  auto y = ragged::from_padded(padded, {3, 1});
+  CHECK(array_equal(y.values, x.values).item<bool>());
+  CHECK(array_equal(y.offsets, x.offsets).item<bool>());
+
+  // Tokens past the maximum length are dropped
+  auto truncated = ragged::to_padded(x, 2);
+  CHECK_EQ(truncated.shape(), std::vector<int>{2, 2, 2});
+
+  CHECK_THROWS(ragged::from_padded(padded, {4, 1}));
+}
+
+TEST_CASE("test ragged segment reductions") {
+  // The middle sequence is empty
+  ragged::RaggedArray x{
+      array({1.0f, 4.0f, 2.0f, -1.0f, 3.0f}), array({0, 3, 3, 5})};
+  CHECK(array_equal(ragged::segment_sum(x), array({7.0f, 0.0f, 2.0f}))
+            .item<bool>());
+  auto m = ragged::segment_max(x);
+  CHECK_EQ(m.shape(), std::vector<int>{3});
+  CHECK(array_equal(take(m, array({0, 2})), array({4.0f, 3.0f})).item<bool>());
+
+  auto p = ragged::softmax(x).values;
+  auto e = exp(x.values);
+  auto expected = concatenate(
+      {divide(slice(e, {0}, {3}), sum(slice(e, {0}, {3}))),
+       divide(slice(e, {3}, {5}), sum(slice(e, {3}, {5})))});
+  CHECK(allclose(p, expected).item<bool>());
+
+  // Gradients flow through the scatters
+  auto fn = [&x](array v) {
+    return sum(ragged::segment_sum({square(v), x.offsets}));
+  };
+  auto g = grad(fn)(x.values);
+  CHECK(allclose(g, multiply(array(2.0f), x.values)).item<bool>());
+}
+
+TEST_CASE("test ragged attention") {
+  int H = 2, D = 8;
+  auto q = random::normal({5, H, D});
+  auto k = random::normal({5, H, D});
+  auto v = random::normal({5, H, D});
+  auto offsets = array({0, 2, 5});
+  float scale = 0.5f;
+  auto out = ragged::scaled_dot_product_attention(
+      {q, offsets}, {k, offsets}, {v, offsets}, scale);
+  CHECK_EQ(out.values.shape(), q.shape());
+
+  // Each sequence on its own
+  auto attend = [&](int start, int stop) {
+    auto to_heads = [&](const array& x) {
+      return transpose(slice(x, {start, 0, 0}, {stop, H, D}), {1, 0, 2});
+    };
+    auto scores = multiply(
+        matmul(to_heads(q), transpose(to_heads(k), {0, 2, 1})), array(scale));
+    auto o = matmul(softmax(scores, -1), to_heads(v));
+    return transpose(o, {1, 0, 2});
+  };
+  auto expected = concatenate({attend(0, 2), attend(2, 5)}, 0);
+  CHECK(allclose(out.values, expected, 1e-4, 1e-4).item<bool>());
+
+  CHECK_THROWS(ragged::scaled_dot_product_attention(
+      {q, offsets}, {k, array({0, 5})}, {v, array({0, 5})}, scale));
+}
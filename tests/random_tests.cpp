@@ -1,5 +1,6 @@
 // Copyright © 2023 Apple Inc.
 
+#include <cmath>
 #include <numeric>
 
 #include "doctest/doctest.h"
@@ -239,6 +240,24 @@ TEST_CASE("test random bits") {
     CHECK(array_equal(take(out, array(0), 0), x1).item<bool>());
     CHECK(array_equal(take(out, array(1), 0), x2).item<bool>());
   }
+
+  // Large and ragged sizes split across threads and keys
+  {
+    int n_threads = cpu_threads();
+    set_cpu_threads(4);
+    auto keys = random::split(random::key(7), 3);
+    for (int width : {1, 2, 4}) {
+      for (int size : {1, 3, 7, 50001, 100000}) {
+        auto fn = [&](array k) { return random::bits({size}, width, k); };
+        auto out = vmap(fn)(keys);
+        for (int i = 0; i < 3; i++) {
+          auto x = random::bits({size}, width, take(keys, array(i), 0));
+          CHECK(array_equal(take(out, array(i), 0), x).item<bool>());
+        }
+      }
+    }
+    set_cpu_threads(n_threads);
+  }
 }
 
 TEST_CASE("test random uniform") {
@@ -418,6 +437,58 @@ TEST_CASE("test random normal") {
     CHECK(all(less(abs(out), array(inf))).item<bool>());
     CHECK(abs(float(mean(out).item<bfloat16_t>())) < 0.1);
   }
+
+  // Samples match the composition of uniform and erfinv
+  {
+    int n_threads = cpu_threads();
+    set_cpu_threads(4);
+    auto key = random::key(42);
+    auto reference = [&key](
+                         std::vector<int> shape,
+                         Dtype dtype,
+                         float low,
+                         float loc,
+                         float scale) {
+      auto samples = random::uniform(
+          array(low, dtype), array(1.0f, dtype), shape, dtype, key);
+      samples = multiply(array(std::sqrt(2.0), dtype), erfinv(samples));
+      if (scale != 1.0) {
+        samples = multiply(array(scale, dtype), samples);
+      }
+      if (loc != 0.0) {
+        samples = add(array(loc, dtype), samples);
+      }
+      return samples;
+    };
+    for (auto [dtype, low] : std::vector<std::pair<Dtype, float>>{
+             {float32, std::nextafter(-1.0f, 0.0f)},
+             {float16, -0.99951171875f},
+             {bfloat16, -0.99609375f}}) {
+      for (auto shape :
+           std::vector<std::vector<int>>{{}, {3}, {7, 3}, {70001}}) {
+        for (auto [loc, scale] :
+             std::vector<std::pair<float, float>>{{0.0f, 1.0f}, {2.0f, 0.5f}}) {
+          auto out = random::normal(shape, dtype, loc, scale, key);
+          auto expected = reference(shape, dtype, low, loc, scale);
+          CHECK_EQ(out.dtype(), dtype);
+          CHECK(array_equal(out, expected).item<bool>());
+        }
+      }
+    }
+    set_cpu_threads(n_threads);
+  }
+
+  // Vmap over keys
+  {
+    auto keys = random::split(random::key(3), 4);
+    auto fn = [](array k) { return random::normal({5, 3}, k); };
+    auto out = vmap(fn)(keys);
+    CHECK_EQ(out.shape(), std::vector<int>{4, 5, 3});
+    for (int i = 0; i < 4; i++) {
+      auto x = random::normal({5, 3}, take(keys, array(i), 0));
+      CHECK(array_equal(take(out, array(i), 0), x).item<bool>());
+    }
+  }
 }
 
 TEST_CASE("test random multivariate_normal") {
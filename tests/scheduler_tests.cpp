@@ -2,6 +2,10 @@
 
 #include "doctest/doctest.h"
 
+#include <algorithm>
+#include <thread>
+
+#include "mlx/event.h"
 #include "mlx/mlx.h"
 #include "mlx/scheduler.h"
 
@@ -107,6 +111,22 @@ TEST_CASE("test stream placement") {
   }
 }
 
+TEST_CASE("test arrays shared across devices") {
+  if (!metal::is_available()) {
+    return;
+  }
+
+  // The CPU and GPU use the same allocations so arrays move between their
+  // streams without copies
+  auto x = add(ones({16}), ones({16}), Device::cpu);
+  auto y = reshape(x, {4, 4}, Device::gpu);
+  auto z = reshape(y, {16}, Device::cpu);
+  eval(z);
+  CHECK_EQ(y.data<float>(), x.data<float>());
+  CHECK_EQ(z.data<float>(), x.data<float>());
+  CHECK(array_equal(z, full({16}, 2.0f)).item<bool>());
+}
+
 TEST_CASE("test scheduler races") {
   auto x = zeros({1});
   auto y = zeros({100});
@@ -119,3 +139,233 @@ TEST_CASE("test scheduler races") {
   }
   eval(a, y);
 }
+
+TEST_CASE("test cpu stream events") {
+  Event e(default_stream(Device::cpu));
+  e.set_value(1);
+  CHECK_FALSE(e.is_signaled());
+
+  std::thread t([e]() mutable { e.signal(); });
+  e.wait();
+  CHECK(e.is_signaled());
+  t.join();
+
+  // Waiting for a value already reached returns immediately
+  e.set_value(1);
+  e.wait();
+  e.set_value(2);
+  CHECK_FALSE(e.is_signaled());
+}
+
+TEST_CASE("test graph tasks waiting for events") {
+  // More tasks wait for the event than there are workers, and the event is
+  // only signaled by a task of the same graph
+  Event e(new_stream(Device::cpu));
+  e.set_value(1);
+  int n = cpu_threads() + 2;
+  std::atomic<int> n_run{0};
+  std::vector<scheduler::GraphTask> tasks(n + 1);
+  for (int i = 0; i < n; i++) {
+    tasks[i].fn = [&n_run]() { n_run++; };
+    tasks[i].waits.push_back(e);
+  }
+  tasks[n].fn = [e]() mutable { e.signal(); };
+  scheduler::run_graph(std::move(tasks));
+  CHECK_EQ(n_run, n);
+}
+
+TEST_CASE("test cpu thread pool") {
+  auto n_threads = cpu_threads();
+  CHECK(n_threads >= 1);
+  CHECK_THROWS_AS(set_cpu_threads(0), std::invalid_argument);
+
+  ThreadPool pool(4);
+  CHECK_EQ(pool.size(), 4);
+  std::vector<int> vals(100, 0);
+  pool.parallel_for(100, [&vals](int i) { vals[i] = i; });
+  for (int i = 0; i < 100; i++) {
+    CHECK_EQ(vals[i], i);
+  }
+
+  // Exceptions are propagated to the caller
+  CHECK_THROWS_AS(
+      pool.parallel_for(
+          10,
+          [](int i) {
+            if (i == 5) {
+              throw std::runtime_error("");
+            }
+          }),
+      std::runtime_error);
+
+  auto fut = pool.enqueue([&vals]() { vals[0] = -1; });
+  fut.wait();
+  CHECK_EQ(vals[0], -1);
+
+  pool.resize(2);
+  CHECK_EQ(pool.size(), 2);
+
+  // Resizing while another thread splits work waits for its tasks
+  bool all_ran = true;
+  std::thread t([&pool, &all_ran]() {
+    for (int j = 0; j < 200; j++) {
+      std::vector<int> ran(64, 0);
+      pool.parallel_for(64, [&ran](int i) { ran[i] = 1; });
+      all_ran &= std::count(ran.begin(), ran.end(), 1) == 64;
+    }
+  });
+  for (int n : {1, 3, 4, 2}) {
+    pool.resize(n);
+  }
+  t.join();
+  CHECK(all_ran);
+  CHECK_EQ(pool.size(), 2);
+
+  // Element-wise kernels give the same result split across threads
+  auto s = default_stream(Device::cpu);
+  auto x = random::uniform({257, 513}, float32, {}, s);
+  auto y = random::uniform({513}, float32, {}, s);
+  auto z = random::uniform({513, 257}, float32, {}, s);
+  set_cpu_threads(1);
+  std::vector<array> expected = {
+      add(x, y, s),
+      exp(x, s),
+      add(x, transpose(z, s), s),
+      where(greater(x, y, s), x, transpose(z, s), s)};
+  eval(expected);
+  set_cpu_threads(4);
+  std::vector<array> out = {
+      add(x, y, s),
+      exp(x, s),
+      add(x, transpose(z, s), s),
+      where(greater(x, y, s), x, transpose(z, s), s)};
+  eval(out);
+  for (auto e = expected.begin(), o = out.begin(); e != expected.end();
+       e++, o++) {
+    CHECK(array_equal(*e, *o, s).item<bool>());
+  }
+  set_cpu_threads(n_threads);
+}
+
+TEST_CASE("test cpu affinity") {
+  // The first tasks always run on the same threads
+  ThreadPool pool(3, {0});
+  CHECK(pool.pinned());
+  std::vector<std::thread::id> ids(3);
+  pool.parallel_for(3, [&ids](int i) { ids[i] = std::this_thread::get_id(); });
+  for (int j = 0; j < 5; j++) {
+    std::vector<std::thread::id> again(3);
+    pool.parallel_for(
+        3, [&again](int i) { again[i] = std::this_thread::get_id(); });
+    CHECK(ids == again);
+  }
+  CHECK_EQ(ids[0], std::this_thread::get_id());
+  // Unpinning waits for the tasks of other threads like resizing
+  std::thread t([&pool]() {
+    for (int j = 0; j < 100; j++) {
+      pool.parallel_for(3, [](int) {});
+    }
+  });
+  pool.set_cores({});
+  t.join();
+  CHECK_FALSE(pool.pinned());
+  CHECK_THROWS_AS(pool.set_cores({-1}), std::invalid_argument);
+
+  // Streams with their own cores give the same results
+  auto n_threads = cpu_threads();
+  auto s = new_stream(Device::cpu);
+  CHECK_THROWS_AS(
+      set_stream_cpu_cores(Stream(0, Device::gpu), {0}), std::invalid_argument);
+  set_stream_cpu_cores(s, {0, 0});
+  auto x = random::uniform({1024, 1024}, float32, {}, s);
+  auto expected = exp(x, default_stream(Device::cpu));
+  auto out = exp(x, s);
+  CHECK(array_equal(expected, out).item<bool>());
+  set_stream_cpu_cores(s, {});
+
+  // Large allocations are first touched by the pinned threads
+  set_cpu_affinity({0, 0});
+  CHECK_EQ(cpu_threads(), 2);
+  out = exp(x);
+  CHECK(array_equal(expected, out).item<bool>());
+  set_cpu_affinity({});
+  set_cpu_threads(n_threads);
+}
+
+TEST_CASE("test task queue") {
+  using scheduler::Task;
+  using scheduler::TaskQueue;
+
+  // Small and large callables are both supported and moveable
+  int count = 0;
+  Task small([&count]() { count++; });
+  std::array<int, 64> big;
+  big.fill(1);
+  Task large([&count, big]() { count += big[63]; });
+  Task moved = std::move(large);
+  CHECK(!large);
+  small();
+  moved();
+  CHECK_EQ(count, 2);
+
+  // Captures are released on reset
+  auto held = std::make_shared<int>(0);
+  Task holder([held]() {});
+  CHECK_EQ(held.use_count(), 2);
+  holder.reset();
+  CHECK_EQ(held.use_count(), 1);
+
+  // Batches from concurrent producers are not interleaved
+  TaskQueue q;
+  std::vector<int> order;
+  int n_producers = 4;
+  int n_batches = 50;
+  int batch_size = 10;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < n_producers; p++) {
+    producers.emplace_back([&, p]() {
+      for (int b = 0; b < n_batches; b++) {
+        std::vector<Task> tasks;
+        for (int i = 0; i < batch_size; i++) {
+          tasks.emplace_back(
+              [&order, p, i]() { order.push_back(p * 100 + i); });
+        }
+        q.push_many(std::move(tasks));
+      }
+    });
+  }
+  int n_popped = 0;
+  Task task;
+  while (n_popped < n_producers * n_batches * batch_size) {
+    if (q.try_pop(task)) {
+      task();
+      n_popped++;
+    }
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  CHECK(q.empty());
+  bool in_order = true;
+  for (int i = 0; i < order.size(); i++) {
+    in_order &= (order[i] % 100) == (i % batch_size);
+    in_order &= (order[i] / 100) == (order[i - i % batch_size] / 100);
+  }
+  CHECK(in_order);
+
+  // Batches enqueued on a stream run in order
+  auto s = new_stream(Device::cpu);
+  std::vector<int> results;
+  std::vector<Task> tasks;
+  for (int i = 0; i < 100; i++) {
+    tasks.emplace_back([&results, i]() { results.push_back(i); });
+  }
+  scheduler::enqueue_many(s, std::move(tasks));
+  synchronize(s);
+  CHECK_EQ(results.size(), 100);
+  bool ordered = true;
+  for (int i = 0; i < results.size(); i++) {
+    ordered &= results[i] == i;
+  }
+  CHECK(ordered);
+}
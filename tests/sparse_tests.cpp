@@ -0,0 +1,161 @@
+// Copyright © 2024 Apple Inc.
+
+#include "doctest/doctest.h"
+
+#include "mlx/mlx.h"
+
+using namespace mlx::core;
+
+namespace {
+
+// A 4 x 3 matrix with an empty row and a repeated coordinate
+sparse::COO test_matrix() {
+  return {
+      array({2, 0, 3, 0, 3}),
+      array({1, 0, 2, 2, 2}),
+      array({1.0f, 2.0f, 3.0f, 4.0f, 5.0f}),
+      {4, 3}};
+}
+
+} // namespace
+
+TEST_CASE("test sparse conversions") {
+  auto a = test_matrix();
+  auto dense = array(
+      {2.0f, 0.0f, 4.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 8.0f},
+      {4, 3});
+  CHECK(array_equal(sparse::to_dense(a), dense).item<bool>());
+
+  auto csr = sparse::to_csr(a);
+  CHECK(array_equal(csr.indptr, array({0, 2, 2, 3, 5})).item<bool>());
+  CHECK(array_equal(csr.indices, array({0, 2, 1, 2, 2})).item<bool>());
+  CHECK(array_equal(sparse::to_dense(csr), dense).item<bool>());
+
+  auto coo = sparse::to_coo(csr);
+  CHECK(array_equal(coo.rows, array({0, 0, 2, 3, 3})).item<bool>());
+
+  CHECK_THROWS(sparse::to_dense(sparse::COO{
+      array({0, 1}), array({0}), array({1.0f, 2.0f}), {2, 2}}));
+  CHECK_THROWS(sparse::to_coo(sparse::CSR{
+      array({0, 1}), array({0}), array({1.0f}), {2, 2}}));
+}
+
+TEST_CASE("test sparse products") {
+  auto a = test_matrix();
+  auto dense = sparse::to_dense(a);
+  auto b = reshape(arange(6, float32), {3, 2});
+  CHECK(allclose(sparse::spmm(a, b), matmul(dense, b)).item<bool>());
+  CHECK(allclose(sparse::spmm(sparse::to_csr(a), b), matmul(dense, b))
+            .item<bool>());
+
+  auto x = array({1.0f, -1.0f, 2.0f});
+  CHECK(allclose(sparse::spmv(a, x), matmul(dense, x)).item<bool>());
+
+  auto p = reshape(arange(8, float32), {4, 2});
+  auto q = reshape(arange(6, float32), {2, 3});
+  auto out = sparse::sddmm(a, p, q);
+  auto expected = multiply(matmul(p, q), dense);
+  CHECK(allclose(sparse::to_dense(out), expected).item<bool>());
+
+  CHECK_THROWS(sparse::spmm(a, ones({2, 2})));
+  CHECK_THROWS(sparse::spmv(a, ones({3, 1})));
+  CHECK_THROWS(sparse::sddmm(a, ones({4, 2}), ones({3, 3})));
+}
+
+TEST_CASE("test sparse gradients") {
+  auto a = test_matrix();
+  auto b = reshape(arange(6, float32), {3, 2});
+  auto cotan = reshape(arange(8, float32), {4, 2});
+
+  // The gradients match the ones of the dense product
+  auto sparse_fn = [&](const std::vector<array>& inputs) {
+    sparse::COO m{a.rows, a.cols, inputs[0], a.shape};
+    return std::vector<array>{sparse::spmm(m, inputs[1])};
+  };
+  auto dense_fn = [&](const std::vector<array>& inputs) {
+    sparse::COO m{a.rows, a.cols, inputs[0], a.shape};
+    return std::vector<array>{matmul(sparse::to_dense(m), inputs[1])};
+  };
+  auto [_, sparse_grads] = vjp(sparse_fn, {a.values, b}, {cotan});
+  auto [__, dense_grads] = vjp(dense_fn, {a.values, b}, {cotan});
+  CHECK(allclose(sparse_grads[0], dense_grads[0]).item<bool>());
+  CHECK(allclose(sparse_grads[1], dense_grads[1]).item<bool>());
+
+  // The mask has no repeated coordinates so the cotangent of each value is
+  // the one of its dense entry
+  sparse::COO mask{
+      array({2, 0, 3, 0}), array({1, 0, 2, 2}), array({1.0f, 2.0f, 3.0f, 4.0f}),
+      {4, 3}};
+  auto p = reshape(arange(8, float32), {4, 2});
+  auto q = reshape(arange(6, float32), {2, 3});
+  auto sampled_fn = [&](const std::vector<array>& inputs) {
+    return std::vector<array>{
+        sparse::sddmm(mask, inputs[0], inputs[1]).values};
+  };
+  auto masked_fn = [&](const std::vector<array>& inputs) {
+    auto dense = sparse::to_dense(mask);
+    return std::vector<array>{multiply(matmul(inputs[0], inputs[1]), dense)};
+  };
+  auto values_cotan = array({1.0f, -1.0f, 2.0f, 0.5f});
+  auto [o1, sampled_grads] = vjp(sampled_fn, {p, q}, {values_cotan});
+  auto [o2, masked_grads] = vjp(
+      masked_fn,
+      {p, q},
+      {sparse::to_dense(
+          sparse::COO{mask.rows, mask.cols, values_cotan, mask.shape})});
+  CHECK(allclose(sampled_grads[0], masked_grads[0]).item<bool>());
+  CHECK(allclose(sampled_grads[1], masked_grads[1]).item<bool>());
+}
+
+TEST_CASE("test 2:4 sparse matmul") {
+  auto w = reshape(
+      multiply(sin(arange(64 * 8, float32)), arange(64 * 8, float32)),
+      {8, 64});
+  auto pruned = prune_2_4(w);
+  auto values = pruned.first;
+  auto metadata = pruned.second;
+  CHECK_EQ(values.shape(), std::vector<int>{8, 32});
+  CHECK_EQ(metadata.shape(), std::vector<int>{8, 2});
+  CHECK_EQ(metadata.dtype(), uint32);
+
+  // The pruned weights keep the two largest entries of every group of four
+  auto groups = reshape(abs(w), {8, 16, 4});
+  auto kept = reshape(abs(values), {8, 16, 2});
+  auto kept_sum = sum(kept, 2);
+  auto top_sum = sum(slice(sort(groups, 2), {0, 0, 2}, {8, 16, 4}), 2);
+  CHECK(allclose(kept_sum, top_sum).item<bool>());
+
+  // The product matches the dense one with the pruned weights
+  auto x = reshape(cos(arange(5 * 64, float32)), {5, 64});
+  auto dense = transpose(sparse_2_4_matmul(eye(64), values, metadata));
+  CHECK(array_equal(sum(not_equal(dense, array(0.0f)), 1), full({8}, 32))
+            .item<bool>());
+  auto out = sparse_2_4_matmul(x, values, metadata);
+  CHECK_EQ(out.shape(), std::vector<int>{5, 8});
+  CHECK(allclose(out, matmul(x, transpose(dense)), 1e-4, 1e-4).item<bool>());
+
+  // Leading dimensions of x are kept
+  auto x3 = reshape(x, {5, 1, 64});
+  CHECK_EQ(
+      sparse_2_4_matmul(x3, values, metadata).shape(),
+      std::vector<int>{5, 1, 8});
+
+  // The gradients match the ones of the dense product
+  auto cotan = reshape(arange(40, float32), {5, 8});
+  auto sparse_fn = [&](const std::vector<array>& inputs) {
+    return std::vector<array>{
+        sparse_2_4_matmul(inputs[0], inputs[1], metadata)};
+  };
+  auto [_, grads] = vjp(sparse_fn, {x, values}, {cotan});
+  CHECK(allclose(grads[0], matmul(cotan, dense), 1e-4, 1e-4).item<bool>());
+  CHECK_EQ(grads[1].shape(), values.shape());
+  auto values_grad = transpose(sparse_2_4_matmul(eye(64), grads[1], metadata));
+  auto expected = multiply(
+      matmul(transpose(cotan), x), not_equal(dense, array(0.0f)));
+  CHECK(allclose(values_grad, expected, 1e-4, 1e-4).item<bool>());
+
+  CHECK_THROWS(prune_2_4(ones({4, 16})));
+  CHECK_THROWS(prune_2_4(ones({4, 32}, int32)));
+  CHECK_THROWS(sparse_2_4_matmul(ones({2, 32}), values, metadata));
+  CHECK_THROWS(sparse_2_4_matmul(x, values, astype(metadata, int32)));
+}
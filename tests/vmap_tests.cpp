@@ -331,6 +331,16 @@ TEST_CASE("test vmap slice") {
   }
 }
 
+TEST_CASE("test vmap logsumexp") {
+  auto fun = [](array in) { return logsumexp(in, -1); };
+  auto x = reshape(arange(24, float32), {2, 3, 4});
+  for (int ax : {0, 1, 2}) {
+    auto out = vmap(fun, ax, 0)(x);
+    auto expected = logsumexp(moveaxis(x, ax, 0), -1);
+    CHECK(allclose(out, expected).item<bool>());
+  }
+}
+
 TEST_CASE("test vmap concatenate") {
   auto fun = [](std::vector<array> inputs) {
     return std::vector<array>{concatenate(inputs, 0)};